@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/FBVector.h>
+#include <folly/portability/GFlags.h>
+#include <sys/uio.h>
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/inodes/FileInode.h"
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+DEFINE_uint64(file_size, 64 * 1024 * 1024, "Size of the file being read");
+DEFINE_uint64(read_size, 128 * 1024, "Number of bytes requested per read");
+
+namespace {
+using namespace facebook::eden;
+
+/**
+ * Returns true if the iovec points into one of the buffers of `buf`.
+ */
+bool pointsInto(const folly::IOBuf& buf, const iovec& vec) {
+  auto* data = static_cast<const uint8_t*>(vec.iov_base);
+  for (const auto& range : buf) {
+    if (data >= range.begin() && data + vec.iov_len <= range.end()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Sequentially read a file whose blob is loaded, the way FUSE read requests
+ * do, and report how many of the bytes handed to the FUSE reply's writev were
+ * copied out of the blob rather than shared with it.
+ */
+void read_loaded_blob(benchmark::State& state) {
+  FakeTreeBuilder builder;
+  std::string contents(FLAGS_file_size, 'x');
+  builder.setFile("file", contents);
+  TestMount mount{builder};
+  auto inode = mount.getFileInode("file");
+  const auto& context = ObjectFetchContext::getNullContext();
+
+  // Load the blob and keep it alive so every read below hits memory.
+  inode->read(1, 0, context).get();
+  auto blob = mount.getBlobCache()->get(inode->getBlobHash().value()).object;
+  if (!blob) {
+    throw std::runtime_error("blob was not cached after the first read");
+  }
+
+  off_t offset = 0;
+  uint64_t bytesRead = 0;
+  uint64_t bytesCopied = 0;
+  uint64_t iovecCount = 0;
+  folly::fbvector<iovec> iov;
+  for (auto _ : state) {
+    auto [buf, eof] = inode->read(FLAGS_read_size, offset, context).get();
+    offset = eof ? 0 : offset + FLAGS_read_size;
+
+    // This is what FuseChannel::sendReply does with the result.
+    iov.clear();
+    buf->appendToIov(&iov);
+    iovecCount += iov.size();
+    for (const auto& vec : iov) {
+      bytesRead += vec.iov_len;
+      if (!pointsInto(blob->getContents(), vec)) {
+        bytesCopied += vec.iov_len;
+      }
+    }
+  }
+
+  state.SetBytesProcessed(bytesRead);
+  state.counters["bytes_copied_per_read"] = benchmark::Counter(
+      bytesCopied, benchmark::Counter::kAvgIterations);
+  state.counters["iovecs_per_read"] =
+      benchmark::Counter(iovecCount, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(read_loaded_blob);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,220 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fmt/format.h>
+#include <folly/portability/GFlags.h>
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/model/git/TopLevelIgnores.h"
+#include "eden/fs/store/DiffContext.h"
+#include "eden/fs/store/ScmStatusDiffCallback.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+DEFINE_uint64(dirs, 100, "Number of directories of the repository");
+DEFINE_uint64(files_per_dir, 100, "Number of files in each directory");
+
+namespace {
+using namespace facebook::eden;
+
+const RootId kSecondCommit{"2"};
+
+std::string filePath(size_t index) {
+  return fmt::format(
+      "dir{:04}/file{:04}.cpp",
+      index / FLAGS_files_per_dir,
+      index % FLAGS_files_per_dir);
+}
+
+/** The n-th of `count` files, spread evenly across the repository. */
+std::string spreadPath(size_t n, size_t count) {
+  return filePath(n * FLAGS_dirs * FLAGS_files_per_dir / count);
+}
+
+FakeTreeBuilder makeRepository() {
+  FakeTreeBuilder builder;
+  for (size_t i = 0; i < FLAGS_dirs * FLAGS_files_per_dir; ++i) {
+    builder.setFile(filePath(i), fmt::format("int f{}() {{ return 0; }}\n", i));
+  }
+  return builder;
+}
+
+/** The repository with `changed` of its files modified. */
+FakeTreeBuilder makeSecondCommit(const FakeTreeBuilder& first, size_t changed) {
+  auto second = first.clone();
+  for (size_t n = 0; n < changed; ++n) {
+    second.replaceFile(spreadPath(n, changed), "// changed\n");
+  }
+  return second;
+}
+
+/**
+ * A mount of `first`, with `second` committed to its backing store as
+ * kSecondCommit. Both builders are left untouched.
+ */
+std::unique_ptr<TestMount> makeMount(
+    const FakeTreeBuilder& first,
+    const FakeTreeBuilder& second) {
+  auto root = first.clone();
+  auto mount = std::make_unique<TestMount>(root);
+  auto commit = second.clone();
+  commit.finalize(mount->getBackingStore(), true);
+  mount->getBackingStore()->putCommit(kSecondCommit, commit)->setReady();
+  return mount;
+}
+
+template <typename T>
+T waitFor(TestMount& mount, folly::SemiFuture<T> future) {
+  auto result = std::move(future).via(mount.getServerExecutor().get());
+  mount.drainServerExecutor();
+  return std::move(result).get();
+}
+
+bool valid(benchmark::State& state, int64_t files) {
+  if (files > static_cast<int64_t>(FLAGS_dirs * FLAGS_files_per_dir)) {
+    state.SkipWithError("more files than the repository has");
+    return false;
+  }
+  return true;
+}
+
+/**
+ * TreeInode::checkout to a commit changing `changed` files, from a mount
+ * whose inodes are unloaded or all loaded.
+ */
+void checkout(benchmark::State& state) {
+  auto changed = state.range(0);
+  auto loaded = state.range(1) != 0;
+  if (!valid(state, changed)) {
+    return;
+  }
+  auto first = makeRepository();
+  auto second = makeSecondCommit(first, changed);
+  std::unique_ptr<TestMount> mount;
+  for (auto _ : state) {
+    state.PauseTiming();
+    mount.reset();
+    mount = makeMount(first, second);
+    if (loaded) {
+      mount->loadAllInodes();
+    }
+    state.ResumeTiming();
+
+    auto result = waitFor(
+        *mount,
+        mount->getEdenMount()
+            ->checkout(kSecondCommit, std::nullopt, __func__)
+            .semi());
+    if (!result.conflicts.empty()) {
+      state.SkipWithError("checkout reported conflicts");
+      break;
+    }
+  }
+}
+BENCHMARK(checkout)
+    ->ArgNames({"changed", "loaded"})
+    ->ArgsProduct({{1, 100, 10000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * TreeInode::diff of a working copy in which `materialized` files were
+ * written to, with the rest of its inodes unloaded or all loaded.
+ */
+void status(benchmark::State& state) {
+  auto materialized = state.range(0);
+  auto loaded = state.range(1) != 0;
+  if (!valid(state, materialized)) {
+    return;
+  }
+  auto first = makeRepository();
+  std::unique_ptr<TestMount> mount;
+  for (auto _ : state) {
+    state.PauseTiming();
+    mount.reset();
+    mount = makeMount(first, first);
+    for (int64_t n = 0; n < materialized; ++n) {
+      mount->overwriteFile(spreadPath(n, materialized), "// modified\n");
+    }
+    if (loaded) {
+      mount->loadAllInodes();
+    }
+    state.ResumeTiming();
+
+    ScmStatusDiffCallback callback;
+    DiffContext diffContext{
+        &callback,
+        folly::CancellationToken{},
+        false,
+        kPathMapDefaultCaseSensitive,
+        mount->getEdenMount()->getObjectStore(),
+        std::make_unique<TopLevelIgnores>("", "")};
+    waitFor(
+        *mount,
+        mount->getEdenMount()
+            ->diff(&diffContext, mount->getEdenMount()->getCheckedOutRootId())
+            .semi());
+    benchmark::DoNotOptimize(callback.extractStatus());
+  }
+}
+BENCHMARK(status)
+    ->ArgNames({"materialized", "loaded"})
+    ->ArgsProduct({{0, 100, 10000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * diffRoots between two commits differing by `changed` files, with the
+ * trees of both in the object store's memory cache or not.
+ */
+void diff_roots(benchmark::State& state) {
+  auto changed = state.range(0);
+  auto cached = state.range(1) != 0;
+  if (!valid(state, changed)) {
+    return;
+  }
+  auto first = makeRepository();
+  auto second = makeSecondCommit(first, changed);
+  std::unique_ptr<TestMount> mount;
+  auto diff = [&] {
+    ScmStatusDiffCallback callback;
+    waitFor(
+        *mount,
+        mount->getEdenMount()
+            ->diffBetweenRoots(
+                mount->getEdenMount()->getCheckedOutRootId(),
+                kSecondCommit,
+                folly::CancellationToken{},
+                &callback)
+            .semi());
+    return callback.extractStatus();
+  };
+  for (auto _ : state) {
+    state.PauseTiming();
+    if (!mount || !cached) {
+      mount.reset();
+      mount = makeMount(first, second);
+      if (cached) {
+        diff();
+      }
+    }
+    state.ResumeTiming();
+
+    auto status = diff();
+    if (status.entries_ref()->size() != static_cast<size_t>(changed)) {
+      state.SkipWithError("diff did not report the changed files");
+      break;
+    }
+  }
+}
+BENCHMARK(diff_roots)
+    ->ArgNames({"changed", "cached"})
+    ->ArgsProduct({{1, 100, 10000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -5,6 +5,10 @@
  * GNU General Public License version 2.
  */
 
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
 #include "eden/common/utils/benchharness/Bench.h"
 #include "eden/fs/utils/ImmediateFuture.h"
 
@@ -12,13 +16,31 @@ namespace {
 
 using namespace facebook::eden;
 
+// Continuations attached to each future before it is fulfilled.
+constexpr size_t kChainLength = 8;
+
+/** Counts the calls to operator new, replaced below. */
+std::atomic<uint64_t> allocationCount{0};
+
+/**
+ * Reports the allocations done since `before`, per iteration, so that the
+ * cost of a chain can be compared across the future types.
+ */
+void reportAllocations(benchmark::State& state, uint64_t before) {
+  state.counters["allocations"] = benchmark::Counter(
+      allocationCount.load(std::memory_order_relaxed) - before,
+      benchmark::Counter::kAvgIterations);
+}
+
 void immediate_future(benchmark::State& state) {
   ImmediateFuture<uint64_t> fut{};
 
+  auto before = allocationCount.load(std::memory_order_relaxed);
   for (auto _ : state) {
     auto newFut = std::move(fut).thenValue([](uint64_t v) { return v + 1; });
     fut = std::move(newFut);
   }
+  reportAllocations(state, before);
   state.SetItemsProcessed(std::move(fut).get());
 }
 
@@ -26,27 +48,116 @@ void immediate_future_exc(benchmark::State& state) {
   ImmediateFuture<uint64_t> fut{folly::Try<uint64_t>{std::logic_error("Foo")}};
 
   uint64_t processed = 0;
+  auto before = allocationCount.load(std::memory_order_relaxed);
   for (auto _ : state) {
     auto newFut = std::move(fut).thenValue([](uint64_t v) { return v + 1; });
     fut = std::move(newFut);
     processed++;
   }
+  reportAllocations(state, before);
   benchmark::DoNotOptimize(fut);
   state.SetItemsProcessed(processed);
 }
 
 void folly_future(benchmark::State& state) {
   folly::Future<int> fut{0};
+  auto before = allocationCount.load(std::memory_order_relaxed);
   for (auto _ : state) {
     auto newFut = std::move(fut).thenValue([](int v) { return v + 1; });
     fut = std::move(newFut);
   }
+  reportAllocations(state, before);
   state.SetItemsProcessed(std::move(fut).get());
 }
 
+/**
+ * A chain of continuations attached before the value is available, as when
+ * waiting on an import.
+ */
+void immediate_future_pending_chain(benchmark::State& state) {
+  auto before = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    folly::Promise<uint64_t> promise;
+    ImmediateFuture<uint64_t> fut{promise.getSemiFuture()};
+    for (size_t i = 0; i < kChainLength; ++i) {
+      fut = std::move(fut).thenValue([](uint64_t v) { return v + 1; });
+    }
+    promise.setValue(0);
+    benchmark::DoNotOptimize(std::move(fut).get());
+  }
+  reportAllocations(state, before);
+  state.SetItemsProcessed(state.iterations() * kChainLength);
+}
+
+void immediate_future_pending_chain_returning_future(benchmark::State& state) {
+  auto before = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    folly::Promise<uint64_t> promise;
+    ImmediateFuture<uint64_t> fut{promise.getSemiFuture()};
+    for (size_t i = 0; i < kChainLength; ++i) {
+      fut = std::move(fut).thenValue(
+          [](uint64_t v) -> ImmediateFuture<uint64_t> { return v + 1; });
+    }
+    promise.setValue(0);
+    benchmark::DoNotOptimize(std::move(fut).get());
+  }
+  reportAllocations(state, before);
+  state.SetItemsProcessed(state.iterations() * kChainLength);
+}
+
+void folly_semi_future_pending_chain(benchmark::State& state) {
+  auto before = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    folly::Promise<uint64_t> promise;
+    auto fut = promise.getSemiFuture();
+    for (size_t i = 0; i < kChainLength; ++i) {
+      fut = std::move(fut).deferValue([](uint64_t v) { return v + 1; });
+    }
+    promise.setValue(0);
+    benchmark::DoNotOptimize(std::move(fut).get());
+  }
+  reportAllocations(state, before);
+  state.SetItemsProcessed(state.iterations() * kChainLength);
+}
+
+void folly_future_pending_chain(benchmark::State& state) {
+  auto before = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    folly::Promise<uint64_t> promise;
+    auto fut = promise.getFuture();
+    for (size_t i = 0; i < kChainLength; ++i) {
+      fut = std::move(fut).thenValue([](uint64_t v) { return v + 1; });
+    }
+    promise.setValue(0);
+    benchmark::DoNotOptimize(std::move(fut).get());
+  }
+  reportAllocations(state, before);
+  state.SetItemsProcessed(state.iterations() * kChainLength);
+}
+
 BENCHMARK(immediate_future);
 BENCHMARK(immediate_future_exc);
 BENCHMARK(folly_future);
+BENCHMARK(immediate_future_pending_chain);
+BENCHMARK(immediate_future_pending_chain_returning_future);
+BENCHMARK(folly_semi_future_pending_chain);
+BENCHMARK(folly_future_pending_chain);
 } // namespace
 
+void* operator new(size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  std::free(ptr);
+}
+
 EDEN_BENCHMARK_MAIN();
@@ -18,7 +18,9 @@
 #include <benchmark/benchmark.h>
 #include <boost/filesystem.hpp>
 
+#include <folly/Exception.h>
 #include <folly/File.h>
+#include <folly/FileUtil.h>
 #include <folly/container/Array.h>
 #include <folly/init/Init.h>
 #include <folly/io/async/AsyncSocket.h>
@@ -41,6 +43,17 @@ DEFINE_string(
     "\"thrift\" (query EdenFS's thrift interface), "
     "\"filesystem\" (getxattr calls through the filesystem), or "
     "\"both\" (try both and display separate results).");
+DEFINE_bool(
+    hot_cache,
+    false,
+    "Query every file once before sampling, so that the samples measure the "
+    "latency of single calls answered from EdenFS's in-memory caches");
+DEFINE_bool(
+    materialized,
+    false,
+    "Rewrite the first byte of the file before each sample, so that the files "
+    "are materialized and their sha1 is computed from the overlay every time "
+    "rather than answered from a cache");
 
 bool shouldRecordThriftSamples(std::string& interface) {
   return interface == "both" || interface == "thrift";
@@ -112,6 +125,23 @@ void recordFilesystemSample(std::string& file, uint64_t& sample) {
   }
 }
 
+/**
+ * Write the first byte of a file back in place, which materializes it and
+ * invalidates the sha1 EdenFS cached for it, without changing its contents.
+ */
+void rewriteFirstByte(const std::string& file) {
+  folly::File handle{file, O_RDWR};
+  char byte;
+  auto read = folly::preadNoInt(handle.fd(), &byte, 1, 0);
+  folly::checkUnixError(read, "failed to read ", file);
+  if (read == 1) {
+    folly::checkUnixError(
+        folly::pwriteNoInt(handle.fd(), &byte, 1, 0),
+        "failed to write ",
+        file);
+  }
+}
+
 /**
  * Calculate some standard statistics for the given samples and display them.
  */
@@ -219,7 +249,9 @@ int main(int argc, char** argv) {
                           &filesystem_samples,
                           &thrift_files,
                           &filesystem_files,
-                          &interface = FLAGS_interface] {
+                          &interface = FLAGS_interface,
+                          hot_cache = FLAGS_hot_cache,
+                          materialized = FLAGS_materialized] {
       // The order of these variables matters, the client MUST be
       // destroyed before the event base because the client
       // destructor is gonna touch the eventbase.
@@ -235,11 +267,26 @@ int main(int argc, char** argv) {
         client = std::make_unique<EdenServiceAsyncClient>(std::move(channel));
       }
 
+      if (hot_cache) {
+        uint64_t unused;
+        for (size_t i = 0; i < thrift_files.size(); ++i) {
+          if (shouldRecordThriftSamples(interface)) {
+            recordThriftSample(thrift_files[i], repo_path, client, unused);
+          }
+          if (shouldRecordFilesystemSamples(interface)) {
+            recordFilesystemSample(filesystem_files[i], unused);
+          }
+        }
+      }
+
       gate.wait();
       for (unsigned j = 0; j < samples_per_thread; ++j) {
         auto files_index = j * thread_number % thrift_files.size();
         auto samples_index = thread_number * samples_per_thread + j;
         if (shouldRecordThriftSamples(interface)) {
+          if (materialized) {
+            rewriteFirstByte((repo_path / thrift_files[files_index]).native());
+          }
           recordThriftSample(
               thrift_files[files_index],
               repo_path,
@@ -248,6 +295,9 @@ int main(int argc, char** argv) {
         }
 
         if (shouldRecordFilesystemSamples(interface)) {
+          if (materialized) {
+            rewriteFirstByte(filesystem_files[files_index]);
+          }
           recordFilesystemSample(
               filesystem_files[files_index], filesystem_samples[samples_index]);
         }
@@ -9,10 +9,20 @@
 #include <folly/File.h>
 #include <folly/portability/GFlags.h>
 #include <sys/xattr.h>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 #include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/testharness/FakeFuseChannel.h"
 
 namespace {
 
+using namespace facebook::eden;
+
+/** Counts the calls to operator new, replaced below. */
+std::atomic<uint64_t> allocationCount{0};
+
 DEFINE_string(
     filename,
     "getxattr.tmp",
@@ -40,6 +50,48 @@ void call_getxattr(benchmark::State& state) {
 }
 BENCHMARK(call_getxattr);
 
+/**
+ * The FUSE_GETXATTR requests of the getxattr calls above, through a
+ * FuseChannel of this process. Reports the heap allocations per request,
+ * including those of FakeFuse.
+ */
+void fuse_getxattr(benchmark::State& state) {
+  struct {
+    fuse_getxattr_in in;
+    char name[sizeof("user.benchmark")];
+  } arg = {};
+  arg.in.size = 1000;
+  std::memcpy(arg.name, "user.benchmark", sizeof(arg.name));
+  FakeFuseChannel channel;
+  auto before = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    channel.call(
+        FUSE_GETXATTR,
+        FUSE_ROOT_ID,
+        folly::ByteRange{reinterpret_cast<const uint8_t*>(&arg), sizeof(arg)});
+  }
+  state.counters["allocations"] = benchmark::Counter(
+      allocationCount.load(std::memory_order_relaxed) - before,
+      benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(fuse_getxattr);
+
 } // namespace
 
+void* operator new(size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  std::free(ptr);
+}
+
 EDEN_BENCHMARK_MAIN();
@@ -5,6 +5,9 @@
  * GNU General Public License version 2.
  */
 
+#include <fmt/format.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
 #include <folly/io/async/EventBaseThread.h>
 #include <thrift/lib/cpp2/async/HeaderClientChannel.h>
 #include "eden/common/utils/benchharness/Bench.h"
@@ -13,6 +16,10 @@
 #include "watchman/cppclient/WatchmanClient.h"
 
 DEFINE_string(query, "", "Query to run");
+DEFINE_string(
+    query_file,
+    "",
+    "File with one glob per line, all evaluated by a single query");
 DEFINE_string(repo, "", "Repository to run the query against");
 DEFINE_string(root, "", "Root of the query");
 DEFINE_string(watchman_socket, "", "Socket to the watchman daemon");
@@ -22,9 +29,36 @@ namespace {
 using namespace facebook::eden;
 using namespace watchman;
 
+/**
+ * The globs of the query: the one passed with --query, followed by those in
+ * --query_file. Build and Watchman queries commonly list hundreds of them.
+ */
+std::vector<std::string> getGlobs() {
+  std::vector<std::string> globs;
+  if (!FLAGS_query.empty()) {
+    globs.push_back(FLAGS_query);
+  }
+  if (!FLAGS_query_file.empty()) {
+    std::string contents;
+    if (!folly::readFile(FLAGS_query_file.c_str(), contents)) {
+      throw std::invalid_argument(
+          fmt::format("Unable to read {}", FLAGS_query_file));
+    }
+    std::vector<folly::StringPiece> lines;
+    folly::split('\n', contents, lines);
+    for (auto line : lines) {
+      if (!line.empty()) {
+        globs.push_back(line.str());
+      }
+    }
+  }
+  return globs;
+}
+
 AbsolutePath validateArguments() {
-  if (FLAGS_query.empty()) {
-    throw std::invalid_argument("A query argument must be passed in");
+  if (FLAGS_query.empty() && FLAGS_query_file.empty()) {
+    throw std::invalid_argument(
+        "A query or query_file argument must be passed in");
   }
 
   if (FLAGS_repo.empty()) {
@@ -50,7 +84,7 @@ void eden_glob(benchmark::State& state) {
 
   GlobParams param;
   param.mountPoint_ref() = path.view();
-  param.globs_ref() = std::vector<std::string>{FLAGS_query};
+  param.globs_ref() = getGlobs();
   param.includeDotfiles_ref() = false;
   param.prefetchFiles_ref() = false;
   param.suppressFileList_ref() = false;
@@ -86,9 +120,12 @@ void watchman_glob(benchmark::State& state) {
   client.connect().get();
   auto watch = client.watch(path.view()).get();
 
-  folly::dynamic query =
-      folly::dynamic::object("glob", folly::dynamic::array(FLAGS_query))(
-          "fields", folly::dynamic::array("name"))("relative_root", FLAGS_root);
+  auto globs = folly::dynamic::array();
+  for (auto& glob : getGlobs()) {
+    globs.push_back(std::move(glob));
+  }
+  folly::dynamic query = folly::dynamic::object("glob", std::move(globs))(
+      "fields", folly::dynamic::array("name"))("relative_root", FLAGS_root);
 
   for (auto _ : state) {
     auto start = std::chrono::high_resolution_clock::now();
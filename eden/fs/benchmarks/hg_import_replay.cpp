@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+/**
+ * Replays the import requests of a trace recorded with
+ * hg:import-trace-file against an HgImportRequestQueue, whose batches are
+ * served by workers that only wait for --batch_latency_us plus
+ * --request_latency_us per request of the batch.
+ *
+ * The requests are enqueued at the pace they were recorded, sped up by
+ * --speedup, so that changes to the batching and the scheduling of the queue
+ * can be evaluated against the request patterns of real workloads. Besides
+ * the time the replay took, the percentiles of the latency of the requests
+ * of every priority are reported.
+ */
+
+#include <fmt/format.h>
+#include <folly/Synchronized.h>
+#include <folly/futures/Future.h>
+#include <folly/portability/GFlags.h>
+#include <algorithm>
+#include <thread>
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/hg/HgImportRequest.h"
+#include "eden/fs/store/hg/HgImportRequestQueue.h"
+#include "eden/fs/store/hg/HgImportTraceFile.h"
+#include "eden/fs/store/hg/HgQueuedBackingStore.h"
+
+DEFINE_string(trace, "", "Trace recorded with hg:import-trace-file to replay");
+DEFINE_double(speedup, 1.0, "How much faster than recorded to replay");
+DEFINE_uint32(workers, 8, "Number of threads serving the batches");
+DEFINE_uint64(batch_latency_us, 2000, "Latency of fetching any batch");
+DEFINE_uint64(request_latency_us, 50, "Added latency per request of a batch");
+DEFINE_uint32(batch_size, 1, "hg:import-batch-size");
+DEFINE_uint32(tree_batch_size, 1, "hg:import-batch-size-tree");
+DEFINE_bool(adaptive_batching, false, "hg:import-batch-adaptive");
+
+namespace {
+using namespace facebook::eden;
+using Clock = std::chrono::steady_clock;
+using Latencies =
+    std::vector<std::pair<ImportPriority::Class, Clock::duration>>;
+
+struct Request {
+  /** When the request was enqueued, relative to the first one. */
+  Clock::duration offset;
+  bool isTree;
+  ObjectId id;
+  HgProxyHash proxyHash;
+  ImportPriority::Class priority;
+  ObjectFetchContext::Cause cause;
+};
+
+/** The QUEUE events of the trace, which are the requests made. */
+const std::vector<Request>& getRequests() {
+  static const auto requests = [] {
+    std::vector<Request> result;
+    auto events = readHgImportTrace(canonicalPath(FLAGS_trace));
+    std::stable_sort(
+        events.begin(), events.end(), [](const auto& a, const auto& b) {
+          return a.monotonicTime < b.monotonicTime;
+        });
+    for (const auto& event : events) {
+      if (event.eventType != HgImportTraceEvent::QUEUE) {
+        continue;
+      }
+      auto offset = event.monotonicTime - events.front().monotonicTime;
+      auto proxyHash = HgProxyHash{
+          RelativePathPiece{event.getPath()}, event.manifestNodeId};
+      auto id = proxyHash.sha1();
+      result.push_back(Request{
+          std::chrono::duration_cast<Clock::duration>(offset / FLAGS_speedup),
+          event.resourceType == HgImportTraceEvent::TREE,
+          std::move(id),
+          std::move(proxyHash),
+          event.importPriority,
+          event.importCause});
+    }
+    return result;
+  }();
+  return requests;
+}
+
+/** What HgQueuedBackingStore's workers do, minus the actual fetching. */
+void serve(HgImportRequestQueue& queue) {
+  for (;;) {
+    auto batch = queue.dequeue();
+    if (batch.empty()) {
+      return;
+    }
+    auto start = Clock::now();
+    std::this_thread::sleep_for(
+        std::chrono::microseconds{FLAGS_batch_latency_us} +
+        std::chrono::microseconds{FLAGS_request_latency_us} * batch.size());
+    queue.recordBatch(batch, start, Clock::now() - start);
+    for (const auto& request : batch) {
+      if (auto* tree = request->getRequest<HgImportRequest::TreeImport>()) {
+        request->getPromise<std::unique_ptr<Tree>>()->setValue(
+            std::make_unique<Tree>(
+                Tree::container{kPathMapDefaultCaseSensitive}, tree->hash));
+      } else {
+        auto* blob = request->getRequest<HgImportRequest::BlobImport>();
+        request->getPromise<std::unique_ptr<Blob>>()->setValue(
+            std::make_unique<Blob>(blob->hash, folly::StringPiece{}));
+      }
+    }
+  }
+}
+
+void reportLatencies(benchmark::State& state, Latencies latencies) {
+  std::sort(latencies.begin(), latencies.end());
+  for (auto [priority, name] :
+       {std::pair{ImportPriority::Class::Low, "low"},
+        std::pair{ImportPriority::Class::Normal, "normal"},
+        std::pair{ImportPriority::Class::High, "high"}}) {
+    auto first = std::lower_bound(
+        latencies.begin(),
+        latencies.end(),
+        std::pair{priority, Clock::duration::min()});
+    auto last = std::upper_bound(
+        first, latencies.end(), std::pair{priority, Clock::duration::max()});
+    auto count = last - first;
+    if (count == 0) {
+      continue;
+    }
+    state.counters[fmt::format("{}_requests", name)] = count;
+    for (auto percentile : {50, 99}) {
+      auto latency = (first + (count - 1) * percentile / 100)->second;
+      state.counters[fmt::format("{}_p{}_ms", name, percentile)] =
+          std::chrono::duration<double, std::milli>(latency).count();
+    }
+  }
+}
+
+void replay(benchmark::State& state) {
+  if (FLAGS_trace.empty()) {
+    state.SkipWithError("--trace is required");
+    return;
+  }
+  const auto& requests = getRequests();
+
+  auto config = EdenConfig::createTestEdenConfig();
+  config->importBatchSize.setValue(
+      FLAGS_batch_size, ConfigSource::CommandLine);
+  config->importBatchSizeTree.setValue(
+      FLAGS_tree_batch_size, ConfigSource::CommandLine);
+  config->importBatchAdaptive.setValue(
+      FLAGS_adaptive_batching, ConfigSource::CommandLine);
+  auto reloadableConfig = std::make_shared<ReloadableConfig>(
+      config, ConfigReloadBehavior::NoReload);
+
+  folly::Synchronized<Latencies> latencies;
+  for (auto _ : state) {
+    HgImportRequestQueue queue{reloadableConfig};
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < FLAGS_workers; ++i) {
+      workers.emplace_back([&] { serve(queue); });
+    }
+
+    std::vector<folly::Future<folly::Unit>> futures;
+    futures.reserve(requests.size());
+    auto start = Clock::now();
+    for (const auto& request : requests) {
+      std::this_thread::sleep_until(start + request.offset);
+      auto enqueued = Clock::now();
+      auto record = [&latencies, &request, enqueued] {
+        latencies.wlock()->emplace_back(
+            request.priority, Clock::now() - enqueued);
+      };
+      auto priority = ImportPriority{request.priority};
+      if (request.isTree) {
+        futures.push_back(
+            queue
+                .enqueueTree(HgImportRequest::makeTreeImportRequest(
+                    request.id, request.proxyHash, priority, request.cause))
+                .thenTry([&queue, &request, record](
+                             folly::Try<std::unique_ptr<Tree>>&& tree) {
+                  queue.markImportAsFinished<Tree>(request.id, tree);
+                  record();
+                }));
+      } else {
+        futures.push_back(
+            queue
+                .enqueueBlob(HgImportRequest::makeBlobImportRequest(
+                    request.id, request.proxyHash, priority, request.cause))
+                .thenTry([&queue, &request, record](
+                             folly::Try<std::unique_ptr<Blob>>&& blob) {
+                  queue.markImportAsFinished<Blob>(request.id, blob);
+                  record();
+                }));
+      }
+    }
+    folly::collectAll(std::move(futures)).wait();
+
+    queue.stop();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * requests.size());
+  reportLatencies(state, std::move(*latencies.wlock()));
+}
+BENCHMARK(replay)->Iterations(1)->UseRealTime()->Unit(benchmark::kSecond);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -5,6 +5,9 @@
  * GNU General Public License version 2.
  */
 
+#include <atomic>
+#include <cstdlib>
+#include <new>
 #include "eden/common/utils/benchharness/Bench.h"
 #include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/store/ImportPriority.h"
@@ -16,6 +19,9 @@ namespace {
 
 using namespace facebook::eden;
 
+/** Counts the calls to operator new, replaced below. */
+std::atomic<uint64_t> allocationCount{0};
+
 Hash20 uniqueHash() {
   std::array<uint8_t, Hash20::RAW_SIZE> bytes = {0};
   auto uid = generateUniqueID();
@@ -68,6 +74,123 @@ void dequeue(benchmark::State& state) {
   }
 }
 
+/**
+ * The lookup of the request tracked for an id, which every import and every
+ * duplicate request does.
+ */
+void is_tracked(benchmark::State& state) {
+  auto edenConfig = std::make_shared<ReloadableConfig>(
+      EdenConfig::createTestEdenConfig(), ConfigReloadBehavior::NoReload);
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  constexpr size_t kRequestCount = 100000;
+  std::vector<ObjectId> ids;
+  ids.reserve(kRequestCount);
+  for (size_t i = 0; i < kRequestCount; i++) {
+    auto request = makeBlobImportRequest(kDefaultImportPriority);
+    ids.push_back(request->getRequest<HgImportRequest::BlobImport>()->hash);
+    queue.enqueueBlob(std::move(request));
+  }
+
+  size_t index = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(queue.isTracked(ids[index]));
+    index = (index + 1) % kRequestCount;
+  }
+}
+
+/**
+ * Unlike enqueue, all the threads enqueue into the same queue, with a mix of
+ * priorities and duplicated requests.
+ */
+void enqueue_contended(benchmark::State& state) {
+  static auto queue = [] {
+    auto edenConfig = std::make_shared<ReloadableConfig>(
+        EdenConfig::createTestEdenConfig(), ConfigReloadBehavior::NoReload);
+    return std::make_unique<HgImportRequestQueue>(edenConfig);
+  }();
+
+  const std::array<ImportPriority, 3> priorities = {
+      ImportPriority{ImportPriority::Class::Low},
+      kDefaultImportPriority,
+      ImportPriority{ImportPriority::Class::High}};
+
+  std::vector<std::shared_ptr<HgImportRequest>> requests;
+  requests.reserve(state.max_iterations);
+  for (size_t i = 0; i < state.max_iterations; i++) {
+    auto priority = priorities[i % priorities.size()];
+    if (i % 8 == 7) {
+      // A duplicate of the previous request, possibly bumping its priority.
+      auto& previous = requests.back();
+      requests.emplace_back(HgImportRequest::makeBlobImportRequest(
+          previous->getRequest<HgImportRequest::BlobImport>()->hash,
+          previous->getRequest<HgImportRequest::BlobImport>()->proxyHash,
+          priority,
+          ObjectFetchContext::Cause::Unknown));
+    } else {
+      requests.emplace_back(makeBlobImportRequest(priority));
+    }
+  }
+
+  auto requestIter = requests.begin();
+  for (auto _ : state) {
+    auto& request = *requestIter++;
+    queue->enqueueBlob(std::move(request));
+  }
+}
+
+/**
+ * The whole life of a blob import through the queue, as HgQueuedBackingStore
+ * and its importer threads do it, with `waiters` callers requesting the blob.
+ * The fetch is a no-op. Reports the heap allocations per import.
+ */
+void import(benchmark::State& state) {
+  auto rawEdenConfig = EdenConfig::createTestEdenConfig();
+  rawEdenConfig->importBatchSize.setValue(1, ConfigSource::CommandLine);
+  auto edenConfig = std::make_shared<ReloadableConfig>(
+      rawEdenConfig, ConfigReloadBehavior::NoReload);
+  auto queue = HgImportRequestQueue{edenConfig};
+  auto waiters = state.range(0);
+
+  constexpr size_t kProxyHashCount = 1024;
+  std::vector<HgProxyHash> proxyHashes;
+  std::vector<ObjectId> ids;
+  for (size_t i = 0; i < kProxyHashCount; i++) {
+    proxyHashes.emplace_back(
+        RelativePath{"fbcode/eden/fs/store/hg/some_blob"}, uniqueHash());
+    ids.push_back(proxyHashes.back().sha1());
+  }
+  auto blob = Blob{ids[0], folly::StringPiece{"contents"}};
+
+  size_t index = 0;
+  auto before = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    const auto& id = ids[index];
+    std::vector<folly::Future<std::unique_ptr<Blob>>> futures;
+    for (int64_t i = 0; i < waiters; i++) {
+      futures.push_back(queue.enqueueBlob(HgImportRequest::makeBlobImportRequest(
+          id,
+          proxyHashes[index],
+          kDefaultImportPriority,
+          ObjectFetchContext::Cause::Unknown)));
+    }
+
+    for (const auto& request : queue.dequeue()) {
+      request->getPromise<std::unique_ptr<Blob>>()->setValue(
+          std::make_unique<Blob>(blob));
+    }
+    for (auto& future : futures) {
+      auto result = std::move(future).getTry();
+      queue.markImportAsFinished<Blob>(id, result);
+      benchmark::DoNotOptimize(result);
+    }
+    index = (index + 1) % kProxyHashCount;
+  }
+  state.counters["allocations"] = benchmark::Counter(
+      allocationCount.load(std::memory_order_relaxed) - before,
+      benchmark::Counter::kAvgIterations);
+}
+
 BENCHMARK(enqueue)
     ->Unit(benchmark::kNanosecond)
     ->Threads(1)
@@ -75,7 +198,8 @@ BENCHMARK(enqueue)
     ->Threads(4)
     ->Threads(8)
     ->Threads(16)
-    ->Threads(32);
+    ->Threads(32)
+    ->Threads(64);
 
 BENCHMARK(dequeue)
     ->Unit(benchmark::kNanosecond)
@@ -84,7 +208,38 @@ BENCHMARK(dequeue)
     ->Threads(4)
     ->Threads(8)
     ->Threads(16)
-    ->Threads(32);
+    ->Threads(32)
+    ->Threads(64);
+
+BENCHMARK(is_tracked)->Unit(benchmark::kNanosecond)->Threads(1)->Threads(8);
+
+BENCHMARK(enqueue_contended)
+    ->Unit(benchmark::kNanosecond)
+    ->Threads(1)
+    ->Threads(2)
+    ->Threads(4)
+    ->Threads(8)
+    ->Threads(16)
+    ->Threads(32)
+    ->Threads(64);
+
+BENCHMARK(import)->ArgName("waiters")->Arg(1)->Arg(2)->Arg(3);
 } // namespace
 
+void* operator new(size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  std::free(ptr);
+}
+
 EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/portability/GFlags.h>
+#include <folly/testing/TestUtil.h>
+#include <random>
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/inodes/InodeTable.h"
+
+DEFINE_string(
+    tablePath,
+    "",
+    "Directory where the benchmark tables are created, defaults to the "
+    "system temporary directory");
+DEFINE_uint64(entries, 10000000, "Number of inodes in the table");
+
+namespace {
+using namespace facebook::eden;
+
+/**
+ * An InodeMetadataTable of --entries inodes, created once and reopened with
+ * the options under test, so that each benchmark maps it like a mount that
+ * starts does.
+ */
+class Table {
+ public:
+  Table() {
+    auto table = InodeMetadataTable::open(path().c_str(), false);
+    for (uint64_t i = 1; i <= FLAGS_entries; ++i) {
+      table->set(InodeNumber{i}, InodeMetadata{S_IFREG | 0644, 0, 0, {}});
+    }
+    table->flush();
+  }
+
+  std::unique_ptr<InodeMetadataTable> open(benchmark::State& state) const {
+    MappedDiskVectorOptions options;
+    options.populate = state.range(0) != 0;
+    options.hugePages = state.range(1) != 0;
+    return InodeMetadataTable::open(path().c_str(), options);
+  }
+
+  static const Table& get() {
+    static Table table;
+    return table;
+  }
+
+ private:
+  std::string path() const {
+    return (dir_.path() / "metadata.table").string();
+  }
+
+  folly::test::TemporaryDirectory dir_{"eden_inode_table", FLAGS_tablePath};
+};
+
+std::uniform_int_distribution<uint64_t> inodes() {
+  return std::uniform_int_distribution<uint64_t>{1, FLAGS_entries};
+}
+
+/** What a stat() of an inode that isn't loaded reads. */
+void random_reads(benchmark::State& state) {
+  auto table = Table::get().open(state);
+  std::default_random_engine gen{std::random_device{}()};
+  auto rng = inodes();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(table->getOptional(InodeNumber{rng(gen)}));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * What touching files does, with the batched msync of the overlay
+ * maintenance every 1000 modifications.
+ */
+void random_writes(benchmark::State& state) {
+  auto table = Table::get().open(state);
+  std::default_random_engine gen{std::random_device{}()};
+  auto rng = inodes();
+  size_t modified = 0;
+  for (auto _ : state) {
+    table->modifyOrThrow(InodeNumber{rng(gen)}, [](InodeMetadata& metadata) {
+      metadata.timestamps.mtime = EdenTimestamp{};
+    });
+    if (++modified % 1000 == 0) {
+      table->flush();
+    }
+  }
+  table->flush();
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(random_reads)
+    ->ArgNames({"populate", "huge_pages"})
+    ->Args({0, 0})
+    ->Args({1, 0})
+    ->Args({1, 1});
+
+BENCHMARK(random_writes)
+    ->ArgNames({"populate", "huge_pages"})
+    ->Args({0, 0})
+    ->Args({1, 0})
+    ->Args({1, 1});
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
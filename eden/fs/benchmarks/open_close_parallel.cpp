@@ -54,7 +54,8 @@ int main(int argc, char** argv) {
     ::close(fd);
   }
 
-  folly::test::Barrier gate{FLAGS_threads};
+  // The main thread also waits on the gate, to time all the threads.
+  folly::test::Barrier gate{static_cast<uint32_t>(FLAGS_threads + 1)};
 
   std::mutex result_mutex;
   StatAccumulator combined_open;
@@ -98,9 +99,12 @@ int main(int argc, char** argv) {
     threads.emplace_back(thread);
   }
 
+  gate.wait();
+  uint64_t start_time = getTime();
   for (auto& thread : threads) {
     thread.join();
   }
+  uint64_t elapsed = getTime() - start_time;
 
   printf(
       "open()\n  minimum: %" PRIu64 " ns\n  average: %" PRIu64 " ns\n",
@@ -110,4 +114,10 @@ int main(int argc, char** argv) {
       "close()\n  minimum: %" PRIu64 " ns\n  average: %" PRIu64 " ns\n",
       combined_close.getMinimum(),
       combined_close.getAverage());
+  // Comparing this across mounts with and without fuse:clone-device shows how
+  // much the FUSE worker threads contend on the FUSE device.
+  printf(
+      "throughput: %.0f open()+close() per second\n",
+      static_cast<double>(FLAGS_threads * FLAGS_iterations) * 1e9 /
+          static_cast<double>(elapsed));
 }
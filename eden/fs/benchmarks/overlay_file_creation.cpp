@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fmt/format.h>
+#include <folly/portability/GFlags.h>
+#include <folly/testing/TestUtil.h>
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/inodes/DirEntry.h"
+#include "eden/fs/inodes/Overlay.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+
+DEFINE_string(
+    overlayPath,
+    "",
+    "Directory where the benchmark overlays are created, defaults to the "
+    "system temporary directory");
+DEFINE_uint64(
+    files_per_directory,
+    1000,
+    "Number of files created in a directory before moving to the next one");
+
+namespace {
+using namespace facebook::eden;
+
+/**
+ * Measures the rate at which files can be created in the buffered SQLite
+ * overlay. Every file creation rewrites its parent directory, as the buffered
+ * catalog does not support semantic operations.
+ */
+void create_files(benchmark::State& state) {
+  auto config = EdenConfig::createTestEdenConfig();
+  config->overlayBufferGroupCommit.setValue(
+      state.range(1) != 0, ConfigSource::CommandLine);
+
+  folly::test::TemporaryDirectory dir{"eden_file_creation", FLAGS_overlayPath};
+  auto overlay = Overlay::create(
+      canonicalPath(dir.path().string()),
+      kPathMapDefaultCaseSensitive,
+      static_cast<Overlay::InodeCatalogType>(state.range(0)),
+      std::make_shared<NullStructuredLogger>(),
+      *config);
+  overlay->initialize(config).get();
+
+  DirContents contents(kPathMapDefaultCaseSensitive);
+  auto dirIno = overlay->allocateInodeNumber();
+  size_t fileIndex = 0;
+  for (auto _ : state) {
+    if (contents.size() == FLAGS_files_per_directory) {
+      contents.clear();
+      dirIno = overlay->allocateInodeNumber();
+    }
+    contents.emplace(
+        PathComponent{fmt::format("file{}", fileIndex++)},
+        S_IFREG | 0644,
+        overlay->allocateInodeNumber());
+    overlay->saveOverlayDir(dirIno, contents);
+  }
+
+  // The writes are only done once they are all flushed to disk.
+  overlay->close();
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(create_files)
+    ->ArgNames({"catalog", "group_commit"})
+    ->Args({static_cast<int64_t>(Overlay::InodeCatalogType::Tree), 0})
+    ->Args({static_cast<int64_t>(Overlay::InodeCatalogType::TreeBuffered), 0})
+    ->Args({static_cast<int64_t>(Overlay::InodeCatalogType::TreeBuffered), 1})
+    ->Unit(benchmark::kMicrosecond);
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <fmt/format.h>
+#include <vector>
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/inodes/FileInode.h"
+#include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+namespace {
+using namespace facebook::eden;
+
+constexpr size_t kMaxThreads = 64;
+
+/**
+ * A mount with a pair of directories per thread, each thread renaming files
+ * in its own directories only.
+ */
+struct RenameMount {
+  RenameMount() {
+    FakeTreeBuilder builder;
+    for (size_t i = 0; i < kMaxThreads; ++i) {
+      builder.setFile(fmt::format("out/{}/a/file", i), "contents\n");
+      builder.setFile(fmt::format("out/{}/b/placeholder", i), "contents\n");
+    }
+    mount = std::make_unique<TestMount>(builder);
+    for (size_t i = 0; i < kMaxThreads; ++i) {
+      // Load the inodes, so that the renames don't have to.
+      mount->getFileInode(fmt::format("out/{}/a/file", i));
+      a.push_back(mount->getTreeInode(fmt::format("out/{}/a", i)));
+      b.push_back(mount->getTreeInode(fmt::format("out/{}/b", i)));
+    }
+  }
+
+  std::unique_ptr<TestMount> mount;
+  std::vector<TreeInodePtr> a;
+  std::vector<TreeInodePtr> b;
+};
+
+RenameMount& getRenameMount() {
+  static auto* mount = new RenameMount;
+  return *mount;
+}
+
+void rename(
+    const TreeInodePtr& srcDir,
+    PathComponentPiece srcName,
+    const TreeInodePtr& destDir,
+    PathComponentPiece destName) {
+  srcDir
+      ->rename(
+          srcName,
+          destDir,
+          destName,
+          InvalidationRequired::No,
+          ObjectFetchContext::getNullContext())
+      .get();
+}
+
+/**
+ * Every thread moves a file back and forth, either within one directory or
+ * between two, which is the build pattern of moving outputs into place. None
+ * of these renames move a directory, so they don't need to exclude each
+ * other.
+ */
+void rename_files(benchmark::State& state) {
+  auto& mount = getRenameMount();
+  auto index = static_cast<size_t>(state.thread_index());
+  const auto& srcDir = mount.a.at(index);
+  const auto& destDir = state.range(0) ? mount.b.at(index) : srcDir;
+  const auto file = PathComponentPiece{"file"};
+  const auto moved = PathComponentPiece{"moved"};
+
+  for (auto _ : state) {
+    rename(srcDir, file, destDir, moved);
+    rename(destDir, moved, srcDir, file);
+  }
+  state.SetItemsProcessed(2 * state.iterations());
+}
+
+BENCHMARK(rename_files)
+    ->ArgName("cross_directory")
+    ->Arg(0)
+    ->Arg(1)
+    ->ThreadRange(1, kMaxThreads)
+    ->UseRealTime();
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -17,6 +17,10 @@
 
 DEFINE_int64(threads, 1, "The number of concurrent Thrift client threads");
 DEFINE_int64(path_levels, 0, "The number of folder level");
+DEFINE_int64(
+    batch_size,
+    1,
+    "The number of paths set by each call, under a shared parent directory");
 DEFINE_string(repo, "", "Path to Eden repository");
 DEFINE_string(
     object_id,
@@ -51,26 +55,39 @@ void call_set_path_object_id(benchmark::State& state) {
       apache::thrift::HeaderClientChannel::newChannel(std::move(socket));
   auto client = std::make_unique<EdenServiceAsyncClient>(std::move(channel));
 
-  SetPathObjectIdParams param;
-  param.mountPoint_ref() = mount.view();
-  param.objectId_ref() = FLAGS_object_id;
+  facebook::eden::ObjectType objectType;
   if ("tree" == FLAGS_object_type) {
-    param.type_ref() = facebook::eden::ObjectType::TREE;
+    objectType = facebook::eden::ObjectType::TREE;
   } else if ("regular_file" == FLAGS_object_type) {
-    param.type_ref() = facebook::eden::ObjectType::REGULAR_FILE;
+    objectType = facebook::eden::ObjectType::REGULAR_FILE;
   } else if ("executable_file" == FLAGS_object_type) {
-    param.type_ref() = facebook::eden::ObjectType::EXECUTABLE_FILE;
+    objectType = facebook::eden::ObjectType::EXECUTABLE_FILE;
   } else {
     throw std::invalid_argument("Unsupported object type");
   }
 
+  SetPathObjectIdParams param;
+  param.mountPoint_ref() = mount.view();
+
   auto uuidGenerator = boost::uuids::random_generator();
 
   std::string path = "benchmark/" + boost::uuids::to_string(uuidGenerator());
   for (long i = 0; i < FLAGS_path_levels; i++) {
     path = path + "/" + boost::uuids::to_string(uuidGenerator());
   }
-  param.path_ref() = path;
+  if (FLAGS_batch_size <= 1) {
+    param.path_ref() = path;
+    param.objectId_ref() = FLAGS_object_id;
+    param.type_ref() = objectType;
+  } else {
+    for (long i = 0; i < FLAGS_batch_size; i++) {
+      SetPathObjectIdObject object;
+      object.path_ref() = path + "/" + boost::uuids::to_string(uuidGenerator());
+      object.objectId_ref() = FLAGS_object_id;
+      object.type_ref() = objectType;
+      param.objects_ref()->push_back(std::move(object));
+    }
+  }
 
   for (auto _ : state) {
     auto start = std::chrono::high_resolution_clock::now();
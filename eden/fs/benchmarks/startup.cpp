@@ -0,0 +1,208 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <chrono>
+#include <fstream>
+
+#include <folly/json.h>
+#include <folly/portability/GFlags.h>
+#include <folly/stop_watch.h>
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/config/CheckoutConfig.h"
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/service/EdenInit.h"
+#include "eden/fs/service/EdenMain.h"
+#include "eden/fs/service/EdenServer.h"
+#include "eden/fs/service/StartupLogger.h"
+#include "eden/fs/telemetry/SessionInfo.h"
+#include "eden/fs/testharness/FakeFuse.h"
+#include "eden/fs/testharness/FakePrivHelper.h"
+#include "eden/fs/utils/UserInfo.h"
+
+DEFINE_string(
+    timings,
+    "",
+    "File where the phase timings of each iteration are appended, one JSON "
+    "object per line");
+
+namespace {
+using namespace facebook::eden;
+using Duration = std::chrono::steady_clock::duration;
+
+/**
+ * Answers the FUSE INIT request as soon as a checkout is mounted, so that
+ * starting its channel doesn't need the kernel nor a privhelper.
+ */
+class InitializedFuseDelegate : public FakePrivHelper::MountDelegate {
+ public:
+  folly::Future<folly::File> fuseMount() override {
+    auto conn = fuse_->start();
+    fuse_->sendInitRequest();
+    return conn;
+  }
+
+  folly::Future<folly::Unit> fuseUnmount() override {
+    fuse_->close();
+    return folly::unit;
+  }
+
+ private:
+  std::shared_ptr<FakeFuse> fuse_{std::make_shared<FakeFuse>()};
+};
+
+class StartupBenchMain : public DefaultEdenMain {
+ public:
+  StartupBenchMain() {
+    registerStandardBackingStores();
+  }
+};
+
+struct Phases {
+  Duration configLoad{};
+  Duration privHelper{};
+  Duration localStoreOpen{};
+  Duration overlayInit{};
+  Duration inodeMapInit{};
+  Duration channelStart{};
+  Duration total{};
+  size_t mounts{0};
+};
+
+double toMs(Duration duration) {
+  return std::chrono::duration<double, std::milli>{duration}.count();
+}
+
+/**
+ * Runs the whole startup of the edenfs daemon against the state directory
+ * given by --edenDir, up to the point where all its checkouts are mounted,
+ * then shuts it down cleanly so the next iteration starts from the same
+ * state.
+ *
+ * The privhelper is faked, so only FUSE checkouts are supported, and no
+ * other edenfs process may be using the state directory.
+ */
+Phases startServer() {
+  Phases phases;
+  folly::stop_watch<> total;
+
+  folly::stop_watch<> watch;
+  auto identity = UserInfo::lookup();
+  std::shared_ptr<EdenConfig> edenConfig = getEdenConfig(identity);
+  phases.configLoad = watch.elapsed();
+
+  // Mirrors the requests EdenMain sends to the privhelper before starting
+  // the server, as well as the registration of its mounts.
+  watch.reset();
+  auto privHelper = std::make_unique<FakePrivHelper>();
+  privHelper->setDaemonTimeoutBlocking(
+      edenConfig->fuseDaemonTimeout.getValue());
+  privHelper->setUseEdenFsBlocking(edenConfig->fuseUseEdenFS.getValue());
+  auto dirs =
+      CheckoutConfig::loadClientDirectoryMap(edenConfig->edenDir.getValue());
+  for (const auto& client : dirs.items()) {
+    privHelper->registerMountDelegate(
+        canonicalPath(client.first.asString()),
+        std::make_shared<InitializedFuseDelegate>());
+  }
+  phases.privHelper = watch.elapsed();
+
+  StartupBenchMain main;
+  SessionInfo sessionInfo;
+  sessionInfo.username = identity.getUsername();
+  sessionInfo.hostname = main.getLocalHostname();
+  sessionInfo.edenVersion = main.getEdenfsVersion();
+  auto hiveLogger = main.getHiveLogger(sessionInfo, edenConfig);
+  EdenServer server{
+      {"edenfs_startup_benchmark"},
+      std::move(identity),
+      std::move(sessionInfo),
+      std::move(privHelper),
+      std::move(edenConfig),
+      main.getActivityRecorderFactory(),
+      main.getBackingStoreFactory(),
+      std::move(hiveLogger),
+      main.getEdenfsVersion()};
+
+  // The mounts are remounted on the main EventBase, which serve() drives
+  // until everything is mounted.
+  folly::Try<folly::Unit> prepared;
+  auto prepareFuture =
+      server.prepare(std::make_shared<ForegroundStartupLogger>())
+          .thenTry([&](folly::Try<folly::Unit>&& result) {
+            phases.total = total.elapsed();
+            phases.localStoreOpen = server.getLocalStoreOpenDuration();
+            for (const auto& mount : server.getMountPoints()) {
+              const auto& timings = mount->getInitializeTimings();
+              phases.overlayInit += timings.overlay;
+              phases.inodeMapInit += timings.inodeMap;
+              phases.channelStart += mount->getChannelStartDuration();
+              ++phases.mounts;
+            }
+            prepared = std::move(result);
+            server.stop();
+          });
+  server.serve();
+  server.performCleanup();
+  // A checkout that failed to remount would skew the other iterations.
+  prepared.throwUnlessValue();
+  return phases;
+}
+
+void appendTimings(const Phases& phases) {
+  if (FLAGS_timings.empty()) {
+    return;
+  }
+  auto entry = folly::dynamic::object("mounts", phases.mounts)(
+      "config_load_ms", toMs(phases.configLoad))(
+      "privhelper_ms", toMs(phases.privHelper))(
+      "local_store_open_ms", toMs(phases.localStoreOpen))(
+      "overlay_init_ms", toMs(phases.overlayInit))(
+      "inode_map_init_ms", toMs(phases.inodeMapInit))(
+      "channel_start_ms", toMs(phases.channelStart))(
+      "total_ms", toMs(phases.total));
+  std::ofstream output{FLAGS_timings, std::ios::app};
+  output << folly::toJson(entry) << "\n";
+}
+
+/**
+ * Reports the time spent in each startup phase, so that a regression of the
+ * total can be attributed. The mount phases are summed over the checkouts,
+ * which are remounted concurrently, so they may add up to more than the
+ * total.
+ */
+void startup(benchmark::State& state) {
+  Phases sum;
+  for (auto _ : state) {
+    auto phases = startServer();
+    appendTimings(phases);
+    sum.configLoad += phases.configLoad;
+    sum.privHelper += phases.privHelper;
+    sum.localStoreOpen += phases.localStoreOpen;
+    sum.overlayInit += phases.overlayInit;
+    sum.inodeMapInit += phases.inodeMapInit;
+    sum.channelStart += phases.channelStart;
+    sum.mounts = phases.mounts;
+  }
+
+  auto counter = [](Duration duration) {
+    return benchmark::Counter(
+        toMs(duration), benchmark::Counter::kAvgIterations);
+  };
+  state.counters["mounts"] = sum.mounts;
+  state.counters["config_load_ms"] = counter(sum.configLoad);
+  state.counters["privhelper_ms"] = counter(sum.privHelper);
+  state.counters["local_store_open_ms"] = counter(sum.localStoreOpen);
+  state.counters["overlay_init_ms"] = counter(sum.overlayInit);
+  state.counters["inode_map_init_ms"] = counter(sum.inodeMapInit);
+  state.counters["channel_start_ms"] = counter(sum.channelStart);
+}
+
+BENCHMARK(startup)->Iterations(5)->Unit(benchmark::kMillisecond);
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -8,10 +8,19 @@
 #include <folly/Exception.h>
 #include <folly/File.h>
 #include <folly/portability/GFlags.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
 #include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/testharness/FakeFuseChannel.h"
 
 namespace {
 
+using namespace facebook::eden;
+
+/** Counts the calls to operator new, replaced below. */
+std::atomic<uint64_t> allocationCount{0};
+
 DEFINE_string(
     filename,
     "stat.tmp",
@@ -25,10 +34,50 @@ void call_fstat(benchmark::State& state) {
     folly::checkUnixError(::fstat(file.fd(), &buf), "fstat failed");
   }
 
-  folly::checkUnixError(::unlink(FLAGS_filename.c_str()));
+  // The other threads keep their file opened.
+  if (state.thread_index() == 0) {
+    folly::checkUnixError(::unlink(FLAGS_filename.c_str()));
+  }
+}
+BENCHMARK(call_fstat)->Threads(1)->Threads(64);
+
+/**
+ * FUSE_GETATTR through a FuseChannel of this process, which the kernel sends
+ * for the fstat calls above once the attributes it cached expired. Reports
+ * the heap allocations per request, including those of FakeFuse.
+ */
+void fuse_getattr(benchmark::State& state) {
+  FakeFuseChannel channel;
+  fuse_getattr_in arg = {};
+  auto before = allocationCount.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    channel.call(
+        FUSE_GETATTR,
+        FUSE_ROOT_ID,
+        folly::ByteRange{reinterpret_cast<const uint8_t*>(&arg), sizeof(arg)});
+  }
+  state.counters["allocations"] = benchmark::Counter(
+      allocationCount.load(std::memory_order_relaxed) - before,
+      benchmark::Counter::kAvgIterations);
 }
-BENCHMARK(call_fstat);
+BENCHMARK(fuse_getattr);
 
 } // namespace
 
+void* operator new(size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+  std::free(ptr);
+}
+
 EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <folly/synchronization/Baton.h>
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
+
+namespace {
+
+using namespace facebook::eden;
+using Scheduling = UnboundedQueueExecutor::Scheduling;
+
+constexpr size_t kThreadCount = 12;
+constexpr size_t kFanOut = 8;
+constexpr size_t kDepth = 4;
+
+constexpr size_t directoryCount() {
+  size_t count = 0;
+  size_t level = 1;
+  for (size_t depth = 0; depth <= kDepth; ++depth) {
+    count += level;
+    level *= kFanOut;
+  }
+  return count;
+}
+
+/**
+ * A checkout of kDepth levels of directories: after a little work on a
+ * directory, a function is queued for each of its children.
+ */
+struct Checkout {
+  explicit Checkout(UnboundedQueueExecutor& executor) : executor{executor} {}
+
+  UnboundedQueueExecutor& executor;
+  std::atomic<size_t> remaining{directoryCount()};
+  folly::Baton<> done;
+
+  void visit(size_t depth) {
+    benchmark::DoNotOptimize(depth * 31 + 7);
+    if (depth < kDepth) {
+      for (size_t i = 0; i < kFanOut; ++i) {
+        executor.add([this, depth] { visit(depth + 1); });
+      }
+    }
+    if (remaining.fetch_sub(1) == 1) {
+      done.post();
+    }
+  }
+};
+
+/**
+ * Many checkouts at once, each one fanning out into short functions, as
+ * when all the repositories of a machine are updated together.
+ */
+void parallel_checkouts(benchmark::State& state) {
+  auto scheduling = static_cast<Scheduling>(state.range(0));
+  auto checkoutCount = static_cast<size_t>(state.range(1));
+  UnboundedQueueExecutor executor{kThreadCount, "BenchThread", scheduling};
+
+  for (auto _ : state) {
+    std::vector<std::unique_ptr<Checkout>> checkouts;
+    for (size_t i = 0; i < checkoutCount; ++i) {
+      checkouts.push_back(std::make_unique<Checkout>(executor));
+    }
+    for (auto& checkout : checkouts) {
+      executor.add([checkout = checkout.get()] { checkout->visit(0); });
+    }
+    for (auto& checkout : checkouts) {
+      checkout->done.wait();
+    }
+  }
+
+  state.SetItemsProcessed(
+      state.iterations() * checkoutCount * directoryCount());
+  state.counters["steals"] = benchmark::Counter(
+      executor.getStealCount(), benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(parallel_checkouts)
+    ->ArgNames({"work_stealing", "checkouts"})
+    ->Args({static_cast<int64_t>(Scheduling::SharedQueue), 1})
+    ->Args({static_cast<int64_t>(Scheduling::WorkStealing), 1})
+    ->Args({static_cast<int64_t>(Scheduling::SharedQueue), 16})
+    ->Args({static_cast<int64_t>(Scheduling::WorkStealing), 16})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+/**
+ * End-to-end workloads against a TestMount of a synthetic repository of
+ * --dirs directories of --files_per_dir files each.
+ *
+ * Besides the time of an iteration, every benchmark reports the percentiles
+ * of the latency of its individual operations, the hit rates of the blob and
+ * tree caches and the number of objects imported from the backing store.
+ * To compare two commits, run the benchmarks of both with
+ * --benchmark_out=<file> --benchmark_out_format=json and diff the results
+ * with compare.py from the benchmark library.
+ */
+
+#include <fmt/format.h>
+#include <folly/portability/GFlags.h>
+#include <folly/stop_watch.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/FileInode.h"
+#include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/model/git/TopLevelIgnores.h"
+#include "eden/fs/store/DiffContext.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/ScmStatusDiffCallback.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+DEFINE_uint64(dirs, 100, "Number of directories of the synthetic repository");
+DEFINE_uint64(files_per_dir, 100, "Number of files in each directory");
+DEFINE_uint64(
+    modifications,
+    100,
+    "Number of files modified before a status, or changed by a checkout");
+
+namespace {
+using namespace facebook::eden;
+
+const RootId kSecondCommit{"2"};
+
+std::string dirName(size_t dir) {
+  return fmt::format("dir{:04}", dir);
+}
+
+std::string fileName(size_t file) {
+  return fmt::format("file{:04}.cpp", file);
+}
+
+std::string filePath(size_t dir, size_t file) {
+  return fmt::format("{}/{}", dirName(dir), fileName(file));
+}
+
+/** The n-th of the --modifications files, spread across the repository. */
+std::string modifiedPath(size_t n) {
+  auto fileCount = FLAGS_dirs * FLAGS_files_per_dir;
+  auto index = n * fileCount / std::max<uint64_t>(FLAGS_modifications, 1);
+  return filePath(index / FLAGS_files_per_dir, index % FLAGS_files_per_dir);
+}
+
+FakeTreeBuilder makeRepository() {
+  FakeTreeBuilder builder;
+  for (size_t dir = 0; dir < FLAGS_dirs; ++dir) {
+    for (size_t file = 0; file < FLAGS_files_per_dir; ++file) {
+      builder.setFile(
+          filePath(dir, file),
+          fmt::format("// {}\nint f{}_{}() {{ return 0; }}\n", dir, dir, file));
+    }
+  }
+  return builder;
+}
+
+/**
+ * A new mount of the commit built by `builder`, which is left untouched so
+ * that it can be mounted again.
+ */
+std::unique_ptr<TestMount> makeMount(const FakeTreeBuilder& builder) {
+  auto root = builder.clone();
+  return std::make_unique<TestMount>(root);
+}
+
+/**
+ * Waits for a future of the mount, running whatever it queued on the server
+ * executor as TestMount::getInode does.
+ */
+template <typename T>
+T waitFor(TestMount& mount, folly::SemiFuture<T> future) {
+  auto result = std::move(future).via(mount.getServerExecutor().get());
+  mount.drainServerExecutor();
+  return std::move(result).get();
+}
+
+template <typename T>
+T waitFor(TestMount& mount, ImmediateFuture<T> future) {
+  return waitFor(mount, std::move(future).semi());
+}
+
+/** The latencies of the operations of a benchmark, across its iterations. */
+class Latencies {
+ public:
+  template <typename Fn>
+  auto time(Fn&& fn) {
+    folly::stop_watch<std::chrono::nanoseconds> watch;
+    auto result = fn();
+    samples_.push_back(watch.elapsed());
+    return result;
+  }
+
+  void report(benchmark::State& state) {
+    if (samples_.empty()) {
+      return;
+    }
+    std::sort(samples_.begin(), samples_.end());
+    for (auto percentile : {50, 90, 99}) {
+      auto index = (samples_.size() - 1) * percentile / 100;
+      state.counters[fmt::format("p{}_us", percentile)] =
+          std::chrono::duration<double, std::micro>(samples_[index]).count();
+    }
+  }
+
+ private:
+  std::vector<std::chrono::nanoseconds> samples_;
+};
+
+/**
+ * Sums what the caches and the backing store of the mounts of a benchmark
+ * did, excluding the setup of the mounts.
+ */
+class StoreCounters {
+ public:
+  /** Call before the workload runs on a new mount. */
+  void start(const TestMount& mount) {
+    start_ = read(mount);
+  }
+
+  /** Call once the workload is done with the mount. */
+  void stop(const TestMount& mount) {
+    auto end = read(mount);
+    blobHits_ += end.blobHits - start_.blobHits;
+    blobMisses_ += end.blobMisses - start_.blobMisses;
+    treeHits_ += end.treeHits - start_.treeHits;
+    treeMisses_ += end.treeMisses - start_.treeMisses;
+    imports_ += end.imports - start_.imports;
+  }
+
+  void report(benchmark::State& state) const {
+    state.counters["blob_cache_hit_rate"] = hitRate(blobHits_, blobMisses_);
+    state.counters["tree_cache_hit_rate"] = hitRate(treeHits_, treeMisses_);
+    state.counters["imports"] =
+        benchmark::Counter(imports_, benchmark::Counter::kAvgIterations);
+  }
+
+ private:
+  struct Snapshot {
+    uint64_t blobHits{0};
+    uint64_t blobMisses{0};
+    uint64_t treeHits{0};
+    uint64_t treeMisses{0};
+    uint64_t imports{0};
+  };
+
+  static Snapshot read(const TestMount& mount) {
+    auto blobs = mount.getBlobCache()->getStats();
+    auto trees = mount.getTreeCache()->getStats();
+    return Snapshot{
+        blobs.hitCount,
+        blobs.missCount,
+        trees.hitCount,
+        trees.missCount,
+        mount.getBackingStore()->getTotalAccessCount()};
+  }
+
+  static double hitRate(uint64_t hits, uint64_t misses) {
+    auto total = hits + misses;
+    return total == 0 ? 0.0 : static_cast<double>(hits) / total;
+  }
+
+  Snapshot start_;
+  uint64_t blobHits_{0};
+  uint64_t blobMisses_{0};
+  uint64_t treeHits_{0};
+  uint64_t treeMisses_{0};
+  uint64_t imports_{0};
+};
+
+/**
+ * What a build does: every source is read, most of them more than once as
+ * the headers they include are, starting from a mount that loaded nothing.
+ */
+void build_read_storm(benchmark::State& state) {
+  const auto& context = ObjectFetchContext::getNullContext();
+  auto builder = makeRepository();
+  Latencies latencies;
+  StoreCounters counters;
+  std::unique_ptr<TestMount> mount;
+  for (auto _ : state) {
+    state.PauseTiming();
+    mount.reset();
+    mount = makeMount(builder);
+    counters.start(*mount);
+    state.ResumeTiming();
+
+    for (int64_t pass = 0; pass < state.range(0); ++pass) {
+      for (size_t dir = 0; dir < FLAGS_dirs; ++dir) {
+        for (size_t file = 0; file < FLAGS_files_per_dir; ++file) {
+          latencies.time([&] {
+            auto inode = mount->getFileInode(filePath(dir, file));
+            return waitFor(*mount, inode->readAll(context));
+          });
+        }
+      }
+    }
+
+    counters.stop(*mount);
+  }
+  state.SetItemsProcessed(
+      state.iterations() * state.range(0) * FLAGS_dirs * FLAGS_files_per_dir);
+  latencies.report(state);
+  counters.report(state);
+}
+BENCHMARK(build_read_storm)
+    ->ArgName("passes")
+    ->Arg(1)
+    ->Arg(3)
+    ->Unit(benchmark::kMillisecond);
+
+/**
+ * Updates the working copy to a commit that changed --modifications files,
+ * starting with the inodes of these files loaded when `loaded` is set.
+ */
+void checkout(benchmark::State& state) {
+  const auto& context = ObjectFetchContext::getNullContext();
+  auto builder = makeRepository();
+  auto second = builder.clone();
+  for (size_t n = 0; n < FLAGS_modifications; ++n) {
+    second.replaceFile(modifiedPath(n), "// changed by the second commit\n");
+  }
+  Latencies latencies;
+  StoreCounters counters;
+  std::unique_ptr<TestMount> mount;
+  for (auto _ : state) {
+    state.PauseTiming();
+    mount.reset();
+    mount = makeMount(builder);
+    {
+      auto commit = second.clone();
+      commit.finalize(mount->getBackingStore(), true);
+      mount->getBackingStore()->putCommit(kSecondCommit, commit)->setReady();
+    }
+    if (state.range(0)) {
+      for (size_t n = 0; n < FLAGS_modifications; ++n) {
+        auto inode = mount->getFileInode(modifiedPath(n));
+        waitFor(*mount, inode->readAll(context));
+      }
+    }
+    counters.start(*mount);
+    state.ResumeTiming();
+
+    auto result = latencies.time([&] {
+      return waitFor(
+          *mount,
+          mount->getEdenMount()
+              ->checkout(kSecondCommit, std::nullopt, __func__)
+              .semi());
+    });
+    if (!result.conflicts.empty()) {
+      state.SkipWithError("checkout reported conflicts");
+      break;
+    }
+
+    counters.stop(*mount);
+  }
+  latencies.report(state);
+  counters.report(state);
+}
+BENCHMARK(checkout)->ArgName("loaded")->Arg(0)->Arg(1)->Unit(
+    benchmark::kMillisecond);
+
+/**
+ * A status after --modifications files of the working copy were written to,
+ * computed by walking the inodes rather than from the cached status.
+ */
+void status_after_modifications(benchmark::State& state) {
+  auto builder = makeRepository();
+  Latencies latencies;
+  StoreCounters counters;
+  std::unique_ptr<TestMount> mount;
+  for (auto _ : state) {
+    state.PauseTiming();
+    mount.reset();
+    mount = makeMount(builder);
+    for (size_t n = 0; n < FLAGS_modifications; ++n) {
+      mount->overwriteFile(modifiedPath(n), "// modified in the working copy");
+    }
+    counters.start(*mount);
+    state.ResumeTiming();
+
+    auto status = latencies.time([&] {
+      ScmStatusDiffCallback callback;
+      DiffContext diffContext{
+          &callback,
+          folly::CancellationToken{},
+          false,
+          kPathMapDefaultCaseSensitive,
+          mount->getEdenMount()->getObjectStore(),
+          std::make_unique<TopLevelIgnores>("", "")};
+      waitFor(
+          *mount,
+          mount->getEdenMount()->diff(
+              &diffContext, mount->getEdenMount()->getCheckedOutRootId()));
+      return callback.extractStatus();
+    });
+    if (status.entries_ref()->size() != FLAGS_modifications) {
+      state.SkipWithError("status did not report the modified files");
+      break;
+    }
+
+    counters.stop(*mount);
+  }
+  latencies.report(state);
+  counters.report(state);
+}
+BENCHMARK(status_after_modifications)->Unit(benchmark::kMillisecond);
+
+/**
+ * What an IDE indexing the repository does: every directory is listed and
+ * every entry of it is looked up and stat()ed, without reading the files.
+ */
+void ide_crawl(benchmark::State& state) {
+  const auto& context = ObjectFetchContext::getNullContext();
+  auto builder = makeRepository();
+  Latencies latencies;
+  StoreCounters counters;
+  std::unique_ptr<TestMount> mount;
+  for (auto _ : state) {
+    state.PauseTiming();
+    mount.reset();
+    mount = makeMount(builder);
+    counters.start(*mount);
+    state.ResumeTiming();
+
+    for (size_t dir = 0; dir < FLAGS_dirs; ++dir) {
+      auto tree = mount->getTreeInode(dirName(dir));
+      for (size_t file = 0; file < FLAGS_files_per_dir; ++file) {
+        latencies.time([&] {
+          auto name = PathComponent{fileName(file)};
+          auto child = waitFor(*mount, tree->getOrLoadChild(name, context));
+          return waitFor(*mount, child->stat(context));
+        });
+      }
+    }
+
+    counters.stop(*mount);
+  }
+  state.SetItemsProcessed(
+      state.iterations() * FLAGS_dirs * FLAGS_files_per_dir);
+  latencies.report(state);
+  counters.report(state);
+}
+BENCHMARK(ide_crawl)->Unit(benchmark::kMillisecond);
+
+} // namespace
+
+EDEN_BENCHMARK_MAIN();
@@ -494,12 +494,36 @@ char thriftRequestEventTypeSymbol(const ThriftRequestEvent& event) {
       return '+';
     case ThriftRequestEventType::FINISH:
       return '-';
+    case ThriftRequestEventType::SPAN:
+      return '~';
     case ThriftRequestEventType::UNKNOWN:
       break;
   }
   return ' ';
 }
 
+std::string formatThriftRequestSpan(const ThriftRequestSpan& span) {
+  std::string_view kind;
+  switch (*span.kind()) {
+    case ThriftRequestSpanKind::DISK_CACHE_FETCH:
+      kind = "disk cache fetch";
+      break;
+    case ThriftRequestSpanKind::NETWORK_FETCH:
+      kind = "network fetch";
+      break;
+    case ThriftRequestSpanKind::BACKING_STORE_REQUEST:
+      kind = "backing store request";
+      break;
+    case ThriftRequestSpanKind::INODE_LOAD:
+      kind = "inode load";
+      break;
+    case ThriftRequestSpanKind::UNKNOWN:
+      kind = "unknown";
+      break;
+  }
+  return fmt::format(" {} for {} μs", kind, *span.durationNs() / 1000);
+}
+
 // Thrift async C++ method name prefixes to omit from output.
 //
 // For p1, p2 in this vector: If p1 is a prefix of p2, it must be located
@@ -508,6 +532,7 @@ const std::string_view kAsyncThriftMethodPrefixes[] = {
     "semifuture_",
     "future_",
     "async_tm_",
+    "async_eb_",
     "async_",
     "co_",
 };
@@ -553,6 +578,11 @@ void print_thrift_event(
         startTimesNs.erase(kv);
       }
     } break;
+    case ThriftRequestEventType::SPAN:
+      if (const auto* span = apache::thrift::get_pointer(event.span())) {
+        latencyString = formatThriftRequestSpan(*span);
+      }
+      break;
     case ThriftRequestEventType::UNKNOWN:
       break;
   }
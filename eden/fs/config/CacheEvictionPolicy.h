@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include "eden/fs/config/FieldConverter.h"
+
+namespace facebook::eden {
+
+/**
+ * Eviction policy used by the in-memory object caches.
+ */
+enum class CacheEvictionPolicy {
+  /**
+   * Plain least-recently-used eviction. Every inserted object is admitted.
+   */
+  LRU,
+
+  /**
+   * LRU eviction guarded by a TinyLFU admission filter: when the cache is
+   * full, a new object is only admitted if it has been accessed more often
+   * than the object it would evict. This keeps one-off scans from flushing the
+   * frequently used working set.
+   */
+  TinyLFU,
+};
+
+template <>
+class FieldConverter<CacheEvictionPolicy> {
+ public:
+  folly::Expected<CacheEvictionPolicy, std::string> fromString(
+      folly::StringPiece value,
+      const std::map<std::string, std::string>& convData) const;
+
+  std::string toDebugString(CacheEvictionPolicy value) const;
+};
+
+} // namespace facebook::eden
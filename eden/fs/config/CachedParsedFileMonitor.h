@@ -59,10 +59,7 @@ class CachedParsedFileMonitor {
    * failed)
    */
   folly::Expected<T, int> getFileContents() {
-    fileChangeMonitor_.invokeIfUpdated(
-        [this](folly::File&& f, int errorNum, AbsolutePathPiece filePath) {
-          processUpdatedFile(std::move(f), errorNum, filePath);
-        });
+    checkForUpdates();
     if (lastErrno_) {
       return folly::makeUnexpected<int>((int)lastErrno_);
     }
@@ -82,6 +79,26 @@ class CachedParsedFileMonitor {
     parseFile(f.fd(), filePath);
   }
 
+  /**
+   * Reload and parse the file if it (or its path) has changed, without
+   * copying the parsed contents out.
+   * @return the update count, which callers deriving values from the
+   * contents can compare with the one they last saw to tell whether these
+   * values are still current.
+   */
+  size_t checkForUpdates(AbsolutePathPiece filePath) {
+    fileChangeMonitor_.setFilePath(filePath);
+    return checkForUpdates();
+  }
+
+  size_t checkForUpdates() {
+    fileChangeMonitor_.invokeIfUpdated(
+        [this](folly::File&& f, int errorNum, AbsolutePathPiece filePath) {
+          processUpdatedFile(std::move(f), errorNum, filePath);
+        });
+    return updateCount_;
+  }
+
   /**
    * Get the number of times the file has been updated (simple counter).
    * Primarily for testing.
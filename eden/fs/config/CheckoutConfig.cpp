@@ -8,12 +8,17 @@
 #include "eden/fs/config/CheckoutConfig.h"
 
 #include <cpptoml.h>
+#include <sstream>
+#include <unordered_map>
 
+#include <folly/FileUtil.h>
 #include <folly/Range.h>
 #include <folly/String.h>
+#include <folly/Synchronized.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/json.h>
+#include "eden/fs/config/CachedParsedFileMonitor.h"
 #include "eden/fs/utils/FileUtils.h"
 #include "eden/fs/utils/PathMap.h"
 #include "eden/fs/utils/SystemError.h"
@@ -89,6 +94,72 @@ enum : uint32_t {
   // RootId most recently reset to.
   kSnapshotFormatWorkingCopyParentAndCheckedOutRevisionVersion = 4,
 };
+
+/**
+ * Parses a checkout's config.toml, for the CachedParsedFileMonitor that avoids
+ * parsing it again while it doesn't change.
+ */
+class CheckoutConfigFileParser {
+ public:
+  using value_type = std::shared_ptr<cpptoml::table>;
+
+  folly::Expected<value_type, int> operator()(
+      int fileDescriptor,
+      AbsolutePathPiece /*filePath*/) const {
+    std::string contents;
+    if (!folly::readFile(fileDescriptor, contents)) {
+      return folly::makeUnexpected((int)errno);
+    }
+    std::istringstream stream{contents};
+    return cpptoml::parser{stream}.parse();
+  }
+};
+
+using CheckoutConfigFileMonitor =
+    CachedParsedFileMonitor<CheckoutConfigFileParser>;
+
+/**
+ * The config.toml of every checkout loaded by this process, by path. Each
+ * monitor is locked separately so that the configs of several checkouts can
+ * be loaded concurrently.
+ */
+folly::Synchronized<std::unordered_map<
+    std::string,
+    std::shared_ptr<folly::Synchronized<CheckoutConfigFileMonitor>>>>&
+getCheckoutConfigFiles() {
+  static auto* files = new folly::Synchronized<std::unordered_map<
+      std::string,
+      std::shared_ptr<folly::Synchronized<CheckoutConfigFileMonitor>>>>();
+  return *files;
+}
+
+/**
+ * Returns the parsed config.toml at configPath, only parsing it again when
+ * its stat() changed since it was last loaded.
+ */
+std::shared_ptr<cpptoml::table> loadCheckoutConfigFile(
+    AbsolutePathPiece configPath) {
+  std::shared_ptr<folly::Synchronized<CheckoutConfigFileMonitor>> monitor;
+  {
+    auto files = getCheckoutConfigFiles().wlock();
+    auto& file = (*files)[configPath.asString()];
+    if (!file) {
+      // No throttling: a change made by the CLI must be seen by the next
+      // load, and a stat() is cheap compared to parsing the file.
+      file = std::make_shared<folly::Synchronized<CheckoutConfigFileMonitor>>(
+          std::in_place, configPath, std::chrono::milliseconds{0});
+    }
+    monitor = file;
+  }
+
+  auto table = monitor->wlock()->getFileContents();
+  if (table.hasValue() && table.value()) {
+    return table.value();
+  }
+  // The monitor only keeps the errno of a failure, parse the file again to
+  // throw a descriptive error.
+  return cpptoml::parse_file(configPath.c_str());
+}
 } // namespace
 
 CheckoutConfig::CheckoutConfig(
@@ -289,7 +360,7 @@ std::unique_ptr<CheckoutConfig> CheckoutConfig::loadFromClientDirectory(
     AbsolutePathPiece clientDirectory) {
   // Extract repository name from the client config file
   auto configPath = clientDirectory + kCheckoutConfig;
-  auto configRoot = cpptoml::parse_file(configPath.c_str());
+  auto configRoot = loadCheckoutConfigFile(configPath);
 
   // Construct CheckoutConfig object
   auto config = std::make_unique<CheckoutConfig>(mountPath, clientDirectory);
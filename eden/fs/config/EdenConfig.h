@@ -8,6 +8,7 @@
 #pragma once
 
 #include <chrono>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <vector>
@@ -19,6 +20,7 @@
 #include <thrift/lib/cpp/concurrency/ThreadManager.h>
 
 #include "common/rust/shed/hostcaps/hostcaps.h"
+#include "eden/fs/config/CacheEvictionPolicy.h"
 #include "eden/fs/config/ConfigSetting.h"
 #include "eden/fs/config/FileChangeMonitor.h"
 #include "eden/fs/config/HgObjectIdFormat.h"
@@ -215,6 +217,15 @@ class EdenConfig : private ConfigSettingManager {
       kUnspecifiedDefault,
       this};
 
+  /**
+   * The number of parsed .gitignore files kept in memory by status, so that
+   * they aren't parsed again by every status. 0 disables the cache.
+   */
+  ConfigSetting<size_t> gitIgnoreCacheSize{
+      "core:gitignore-cache-size",
+      4096,
+      this};
+
   /**
    * How often to check the on-disk lock file to ensure it is still valid.
    * EdenFS will exit if the lock file is no longer valid.
@@ -293,6 +304,59 @@ class EdenConfig : private ConfigSettingManager {
       std::chrono::seconds(30),
       this};
 
+  /**
+   * Maximum number of concurrent globFiles and prefetchFiles requests, the
+   * prefetches only running once no glob waits. 0 means unlimited.
+   */
+  ConfigSetting<size_t> thriftMaxConcurrentGlobs{
+      "thrift:max-concurrent-globs",
+      0,
+      this};
+
+  /**
+   * Maximum number of concurrent getScmStatusV2 and getScmStatus requests.
+   * 0 means unlimited.
+   */
+  ConfigSetting<size_t> thriftMaxConcurrentStatus{
+      "thrift:max-concurrent-status",
+      0,
+      this};
+
+  /**
+   * Maximum number of concurrent checkOutRevision requests. 0 means
+   * unlimited.
+   */
+  ConfigSetting<size_t> thriftMaxConcurrentCheckouts{
+      "thrift:max-concurrent-checkouts",
+      0,
+      this};
+
+  /**
+   * Maximum number of requests waiting on one of the limits above, past
+   * which they fail with EBUSY.
+   */
+  ConfigSetting<size_t> thriftMaxQueuedRequests{
+      "thrift:max-queued-requests",
+      1000,
+      this};
+
+  /**
+   * Number of blobs a streamBlobs request fetches concurrently.
+   */
+  ConfigSetting<size_t> thriftStreamBlobsParallelism{
+      "thrift:stream-blobs-parallelism",
+      32,
+      this};
+
+  /**
+   * Maximum number of bytes of a blob sent in each chunk of a streamBlobs
+   * stream.
+   */
+  ConfigSetting<size_t> thriftStreamBlobsChunkSize{
+      "thrift:stream-blobs-chunk-size",
+      1024 * 1024,
+      this};
+
   // [ssl]
 
   ConfigSetting<AbsolutePath> clientCertificate{
@@ -317,6 +381,222 @@ class EdenConfig : private ConfigSettingManager {
       10,
       this};
 
+  /**
+   * Controls whether EdenFS periodically unloads the least recently accessed
+   * inodes of each mount to keep them within the target count and memory
+   * budget below. Not supported on Windows, where inode access times aren't
+   * tracked.
+   */
+  ConfigSetting<bool> enableInodeUnloadPolicy{
+      "mount:inode-unload-policy",
+      false,
+      this};
+
+  /**
+   * How often the inode unload policy runs.
+   */
+  ConfigSetting<std::chrono::nanoseconds> inodeUnloadPolicyInterval{
+      "mount:inode-unload-policy-interval",
+      std::chrono::minutes(1),
+      this};
+
+  /**
+   * Number of loaded inodes per mount the inode unload policy unloads down
+   * to. 0 means no limit.
+   */
+  ConfigSetting<uint64_t> inodeUnloadTargetCount{
+      "mount:inode-unload-target-count",
+      0,
+      this};
+
+  /**
+   * Estimated memory, in bytes, of the loaded inodes of a mount the inode
+   * unload policy unloads down to. 0 means no limit.
+   */
+  ConfigSetting<size_t> inodeUnloadMemoryBudget{
+      "mount:inode-unload-memory-budget",
+      0,
+      this};
+
+  /**
+   * The inode unload policy first unloads the inodes that weren't accessed
+   * for this long, and then halves that age for as long as needed.
+   */
+  ConfigSetting<std::chrono::nanoseconds> inodeUnloadMaximumAge{
+      "mount:inode-unload-maximum-age",
+      std::chrono::hours(24),
+      this};
+
+  /**
+   * Inodes accessed more recently than this are never unloaded by the inode
+   * unload policy, so that the working set isn't unloaded and reloaded over
+   * and over.
+   */
+  ConfigSetting<std::chrono::nanoseconds> inodeUnloadMinimumAge{
+      "mount:inode-unload-minimum-age",
+      std::chrono::minutes(5),
+      this};
+
+  /**
+   * A pass of the inode unload policy stops once it unloaded this many
+   * inodes, leaving the rest to the next passes. 0 means no limit.
+   */
+  ConfigSetting<uint64_t> inodeUnloadMaxPerPass{
+      "mount:inode-unload-max-per-pass",
+      100000,
+      this};
+
+  /**
+   * Controls whether EdenFS periodically looks for materialized files whose
+   * contents match the checked out commit, and dematerializes them. Not
+   * supported on Windows.
+   */
+  ConfigSetting<bool> enableDematerializeUnchangedFiles{
+      "mount:dematerialize-unchanged-files",
+      false,
+      this};
+
+  /**
+   * How often materialized files are compared with the checked out commit.
+   */
+  ConfigSetting<std::chrono::nanoseconds> dematerializeUnchangedFilesInterval{
+      "mount:dematerialize-unchanged-files-interval",
+      std::chrono::minutes(10),
+      this};
+
+  /**
+   * Files modified more recently than this are not compared with the checked
+   * out commit, since they are likely to be modified again.
+   */
+  ConfigSetting<std::chrono::nanoseconds>
+      dematerializeUnchangedFilesMinimumAge{
+          "mount:dematerialize-unchanged-files-minimum-age",
+          std::chrono::hours(1),
+          this};
+
+  /**
+   * A pass comparing materialized files with the checked out commit stops
+   * once it hashed this many files, leaving the rest to the next passes. 0
+   * means no limit.
+   */
+  ConfigSetting<uint64_t> dematerializeUnchangedFilesMaxPerPass{
+      "mount:dematerialize-unchanged-files-max-per-pass",
+      1000,
+      this};
+
+  /**
+   * A pass comparing materialized files with the checked out commit stops
+   * once it hashed this many bytes. 0 means no limit.
+   */
+  ConfigSetting<uint64_t> dematerializeUnchangedFilesMaxBytesPerPass{
+      "mount:dematerialize-unchanged-files-max-bytes-per-pass",
+      1024 * 1024 * 1024,
+      this};
+
+  /**
+   * Number of paths whose inodes are cached, so that the thrift calls
+   * resolving a deep path again, or the paths of siblings, don't walk every
+   * directory along it. 0 disables the cache. Only read when a mount starts.
+   */
+  ConfigSetting<size_t> pathLookupCacheSize{
+      "mount:path-lookup-cache-size",
+      0,
+      this};
+
+  /**
+   * After a readdir of a directory with at most this many entries, the next
+   * lookup of one of its unloaded children loads all of them at once, as
+   * tools listing a directory usually go on to stat every entry. 0 disables
+   * this.
+   */
+  ConfigSetting<uint64_t> batchLoadAfterReaddirMaxEntries{
+      "mount:batch-load-after-readdir-max-entries",
+      0,
+      this};
+
+  /**
+   * When a listing of a directory with at least this many entries starts,
+   * its entries are sorted once in readdir order and kept until the listing
+   * ends, instead of being sorted again for every page of the listing. 0
+   * disables this.
+   */
+  ConfigSetting<uint64_t> readdirIndexMinEntries{
+      "mount:readdir-index-min-entries",
+      1024,
+      this};
+
+  /**
+   * Maximum number of threads removing the loaded subdirectories of a
+   * directory that is removed recursively, counting the thread of the
+   * request. The others come from the server thread pool. 1 removes them one
+   * after the other.
+   */
+  ConfigSetting<size_t> removeRecursivelyParallelism{
+      "mount:remove-recursively-parallelism",
+      8,
+      this};
+
+  /**
+   * Maximum number of directories a checkout hands to the server thread pool
+   * at any time. The pool threads pick up whichever is queued next, so the
+   * subtrees of a large checkout are spread over the idle threads. Once the
+   * limit is reached, directories are checked out on the thread that reached
+   * them. 0 checks every directory out on the thread that reached it.
+   */
+  ConfigSetting<size_t> checkoutParallelism{
+      "mount:checkout-parallelism",
+      8,
+      this};
+
+  /**
+   * Maximum number of checkouts remounted at the same time when EdenFS
+   * starts, the most recently used ones first. 0 remounts all of them at
+   * once.
+   */
+  ConfigSetting<size_t> startupMountParallelism{
+      "mount:startup-parallelism",
+      4,
+      this};
+
+  /**
+   * Controls whether checkout diffs the source and destination commits
+   * before walking the inodes, to fetch the trees and blob metadata it needs
+   * at once rather than as it discovers them.
+   */
+  ConfigSetting<bool> prefetchCheckoutObjects{
+      "mount:checkout-prefetch-objects",
+      true,
+      this};
+
+  /**
+   * Controls whether the last status computed against the checked out
+   * commit is kept, so that the next status only re-verifies the paths the
+   * journal recorded as changed since, rather than diffing every loaded and
+   * materialized inode.
+   */
+  ConfigSetting<bool> enableScmStatusCache{
+      "mount:scm-status-cache",
+      false,
+      this};
+
+  /**
+   * When more paths than this changed since the cached status, status diffs
+   * the whole working copy instead of re-verifying them one by one.
+   */
+  ConfigSetting<size_t> scmStatusCacheMaxChangedPaths{
+      "mount:scm-status-cache-max-changed-paths",
+      1000,
+      this};
+
+  /**
+   * streamScmStatus publishes the entries and errors of the status once it
+   * has at least this many to publish.
+   */
+  ConfigSetting<size_t> scmStatusStreamChunkSize{
+      "scm-status:stream-chunk-size",
+      1024,
+      this};
+
   // [store]
 
   /**
@@ -356,6 +636,102 @@ class EdenConfig : private ConfigSettingManager {
       20'000'000,
       this};
 
+  /**
+   * Size in bytes of the LRU block cache shared by all of the RocksDB local
+   * store's column families. Only read when the local store is opened.
+   */
+  ConfigSetting<uint64_t> localStoreBlockCacheSize{
+      "store:rocksdb-block-cache-size",
+      72 * 1024 * 1024,
+      this};
+
+  /**
+   * Upper bound, in bytes per second, on how fast the RocksDB local store
+   * writes compaction and flush output. 0 means unlimited.
+   */
+  ConfigSetting<uint64_t> localStoreCompactionRateLimit{
+      "store:compaction-rate-limit",
+      0,
+      this};
+
+  /**
+   * Background local store garbage collection and compaction are deferred
+   * while the oldest outstanding filesystem request has been running for
+   * longer than this. 0 disables the deferral.
+   */
+  ConfigSetting<std::chrono::nanoseconds> localStoreGcDeferLatency{
+      "store:gc-defer-latency",
+      std::chrono::milliseconds(100),
+      this};
+
+  /**
+   * Longest time background local store work is deferred for before it runs
+   * regardless of the filesystem request latency.
+   */
+  ConfigSetting<std::chrono::nanoseconds> localStoreGcMaxDeferral{
+      "store:gc-max-deferral",
+      std::chrono::minutes(10),
+      this};
+
+  /**
+   * Automatic garbage collection of the blob key space deletes and compacts
+   * ranges of roughly this many bytes at a time, rather than clearing the
+   * whole key space at once.
+   */
+  ConfigSetting<uint64_t> localStoreGcEvictionBatchSize{
+      "store:gc-eviction-batch-size",
+      64 * 1024 * 1024,
+      this};
+
+  /**
+   * Trees and blobs imported from the backing store are written to the local
+   * store in batches of up to this many bytes. 0 writes each object as soon
+   * as it is imported.
+   */
+  ConfigSetting<uint64_t> localStoreIngestBatchSize{
+      "store:ingest-batch-size",
+      1024 * 1024,
+      this};
+
+  /**
+   * Longest time an imported object waits in a batch before being written to
+   * the local store.
+   */
+  ConfigSetting<std::chrono::nanoseconds> localStoreIngestFlushInterval{
+      "store:ingest-flush-interval",
+      std::chrono::milliseconds(500),
+      this};
+
+  /**
+   * Size of the data area of each pack file, when the "pack" local store
+   * engine is used. Ephemeral data is garbage collected by dropping whole
+   * packs, so smaller packs make garbage collection finer grained at the cost
+   * of more files.
+   */
+  ConfigSetting<uint64_t> localStorePackSize{
+      "store:pack-size",
+      256 * 1024 * 1024,
+      this};
+
+  /**
+   * Number of read-only connections the "sqlite" local store engine spreads
+   * its reads over. Reads on different connections run concurrently.
+   */
+  ConfigSetting<size_t> localStoreSqliteReadConnections{
+      "store:sqlite-read-connections",
+      4,
+      this};
+
+  /**
+   * Directory of read-only packs, built ahead of time with `eden_store_util
+   * build_pack`, to look objects up in before the local store. Typically
+   * shared by several hosts. Empty to disable.
+   */
+  ConfigSetting<std::string> localStoreSharedPackPath{
+      "store:shared-pack-path",
+      "",
+      this};
+
   /**
    * The minimum duration between logging occurrences of failed HgProxyHash
    * loads.
@@ -383,6 +759,139 @@ class EdenConfig : private ConfigSettingManager {
       5,
       this};
 
+  /**
+   * Whether the readdir prefetches adapt to the processes listing the
+   * directories: a directory is only prefetched if the recent listings of the
+   * process, or its previous listing of that directory, were followed by
+   * lookups. The limit of store:max-tree-prefetches then also scales with the
+   * average duration of the prefetches above
+   * store:tree-prefetch-reference-latency, up to
+   * store:max-tree-prefetches-adaptive.
+   */
+  ConfigSetting<bool> adaptiveTreePrefetch{
+      "store:adaptive-tree-prefetch",
+      false,
+      this};
+
+  ConfigSetting<uint64_t> maxTreePrefetchesAdaptive{
+      "store:max-tree-prefetches-adaptive",
+      32,
+      this};
+
+  ConfigSetting<std::chrono::nanoseconds> treePrefetchReferenceLatency{
+      "store:tree-prefetch-reference-latency",
+      std::chrono::milliseconds{10},
+      this};
+
+  /**
+   * Number of blobs prefetchProfile requests from the backing store at once.
+   */
+  ConfigSetting<size_t> prefetchProfileBlobBatchSize{
+      "prefetch-profile:blob-batch-size",
+      10000,
+      this};
+
+  /**
+   * Number of blob sizes and SHA-1s each ObjectStore keeps in memory. Only
+   * read when a mount is started.
+   */
+  ConfigSetting<size_t> blobMetadataCacheSize{
+      "store:blob-metadata-cache-size",
+      1000000,
+      this};
+
+  /**
+   * Number of symlink targets each ObjectStore keeps in memory. Only read
+   * when a mount is started.
+   */
+  ConfigSetting<size_t> symlinkTargetCacheSize{
+      "store:symlink-target-cache-size",
+      100000,
+      this};
+
+  /**
+   * Whether the sizes and SHA-1s that the backing store imports inline in
+   * trees are added to the blob metadata cache, so that stat() and the
+   * attributes of the files of a freshly fetched tree don't each need a
+   * metadata fetch.
+   */
+  ConfigSetting<bool> blobMetadataFromTrees{
+      "store:blob-metadata-from-trees",
+      true,
+      this};
+
+  /**
+   * How long the ObjectStore remembers that a tree or blob could not be found,
+   * so that repeated lookups for it fail without going back to the LocalStore
+   * and BackingStore. Checkouts forget all remembered misses. Setting this to 0
+   * disables negative caching.
+   */
+  ConfigSetting<std::chrono::nanoseconds> negativeCacheTtl{
+      "store:negative-cache-ttl",
+      std::chrono::seconds{0},
+      this};
+
+  /**
+   * The maximum number of objects remembered by the negative cache.
+   */
+  ConfigSetting<size_t> negativeCacheSize{
+      "store:negative-cache-size",
+      100000,
+      this};
+
+  /**
+   * Reads of unmaterialized files of at least this many bytes fetch only the
+   * chunks of the blob they cover, instead of the whole blob, when the
+   * BackingStore supports ranged reads. Setting this to 0 disables ranged
+   * reads.
+   */
+  ConfigSetting<uint64_t> blobRangeReadMinimumSize{
+      "store:blob-range-read-minimum-size",
+      64 * 1024 * 1024,
+      this};
+
+  /**
+   * The size of the chunks ranged reads fetch and cache. Only read at
+   * startup.
+   */
+  ConfigSetting<uint64_t> blobRangeChunkSize{
+      "store:blob-range-chunk-size",
+      1024 * 1024,
+      this};
+
+  /**
+   * The maximum number of chunks fetched by ranged reads kept in memory.
+   */
+  ConfigSetting<size_t> blobRangeCacheChunks{
+      "store:blob-range-cache-chunks",
+      256,
+      this};
+
+  /**
+   * Whether the reads of unmaterialized files by processes reading in a
+   * predictable order fetch what they will read next ahead of time: the rest
+   * of a file read sequentially with ranged reads, and the next files of a
+   * directory whose files are read one after the other.
+   */
+  ConfigSetting<bool> readAhead{"store:read-ahead", false, this};
+
+  /**
+   * The most bytes a sequential ranged read fetches ahead of the reads. It
+   * should stay well below store:blob-range-chunk-size times
+   * store:blob-range-cache-chunks, or the chunks read ahead are evicted from
+   * the cache before they are read.
+   */
+  ConfigSetting<uint64_t> readAheadMaxBytes{
+      "store:read-ahead-max-bytes",
+      16 * 1024 * 1024,
+      this};
+
+  /**
+   * How many of the next files of a directory are prefetched ahead of a
+   * process reading its files in order. 0 disables it.
+   */
+  ConfigSetting<uint32_t> readAheadFiles{"store:read-ahead-files", 4, this};
+
   // [fuse]
 
   /**
@@ -433,6 +942,108 @@ class EdenConfig : private ConfigSettingManager {
    */
   ConfigSetting<uint32_t> maximumFuseRequests{"fuse:max-requests", 1000, this};
 
+  /**
+   * Whether each FUSE worker thread should read the requests from its own
+   * clone of the FUSE device, rather than all of them contending on the same
+   * one. Only used on Linux, whose kernel must support FUSE_DEV_IOC_CLONE.
+   */
+  ConfigSetting<bool> fuseCloneDevice{"fuse:clone-device", false, this};
+
+  /**
+   * Whether each FUSE worker thread should be pinned to a CPU, so that it
+   * and its read buffer stay on the same CPU and NUMA node. The workers are
+   * spread over the NUMA nodes. Only used on Linux.
+   */
+  ConfigSetting<bool> fusePinWorkerThreads{
+      "fuse:pin-worker-threads",
+      false,
+      this};
+
+  /**
+   * Whether the data of large reads from materialized files should be
+   * spliced from the overlay to the kernel instead of being copied through
+   * EdenFS. Only used on Linux.
+   */
+  ConfigSetting<bool> fuseSpliceReads{"fuse:splice-reads", false, this};
+
+  /**
+   * Whether the kernel may ask for the attributes of the entries along with
+   * directory listings (FUSE_READDIRPLUS), when it sees them being looked up
+   * after a listing. Only used on Linux.
+   */
+  ConfigSetting<bool> fuseReaddirPlus{"fuse:readdirplus", true, this};
+
+  /**
+   * The number of threads sending invalidations to the kernel. The kernel may
+   * block each invalidation until it gets the lock of its inode, so checkouts
+   * invalidating many directories benefit from a few.
+   */
+  ConfigSetting<size_t> fuseInvalidationThreads{
+      "fuse:invalidation-threads",
+      4,
+      this};
+
+  /**
+   * Whether to skip the kernel invalidations of directories whose inode the
+   * kernel holds no reference to, and thus can't have cached anything about.
+   * A lookup racing with a checkout may then leave the kernel with the
+   * attributes of a directory from before the checkout, until they expire.
+   */
+  ConfigSetting<bool> fuseSkipUnreferencedInvalidations{
+      "fuse:skip-unreferenced-invalidations",
+      false,
+      this};
+
+  /**
+   * FUSE requests taking at least this long are counted as slow, and
+   * reported by traceFsEvents along with the time they spent waiting for the
+   * backing store. 0 disables slow request reporting.
+   */
+  ConfigSetting<std::chrono::nanoseconds> fuseSlowRequestThreshold{
+      "fuse:slow-request-threshold",
+      std::chrono::seconds(1),
+      this};
+
+  /**
+   * How long the kernel may cache the attributes of materialized files.
+   * Everything else can only change through checkout, which invalidates them,
+   * so their attributes are cached for as long as the kernel allows. Changes
+   * to materialized files made through the mount are known to the kernel too,
+   * so this only needs to be shortened if something else writes to them.
+   */
+  ConfigSetting<std::chrono::nanoseconds> fuseMaterializedAttrTimeout{
+      "fuse:materialized-attr-timeout",
+      std::chrono::seconds(std::numeric_limits<int32_t>::max()),
+      this};
+
+  /**
+   * The names of the executables whose FUSE requests are served in the
+   * background lane, e.g. crawlers and indexers, so they don't delay the
+   * requests of interactive processes. Empty disables admission control.
+   */
+  ConfigSetting<std::vector<std::string>> fuseBackgroundProcesses{
+      "fuse:background-processes",
+      std::vector<std::string>{},
+      this};
+
+  /**
+   * The maximum number of concurrent FUSE requests of each background
+   * process, 0 for no limit.
+   */
+  ConfigSetting<size_t> fuseMaxRequestsPerBackgroundProcess{
+      "fuse:max-requests-per-background-process",
+      8,
+      this};
+
+  /**
+   * The maximum number of concurrent FUSE requests of all background
+   * processes together, 0 for no limit.
+   */
+  ConfigSetting<size_t> fuseMaxBackgroundRequests{
+      "fuse:max-background-requests",
+      32,
+      this};
+
   // [nfs]
 
   /**
@@ -464,6 +1075,36 @@ class EdenConfig : private ConfigSettingManager {
       1000,
       this};
 
+  /**
+   * Number of IO threads that read the NFS requests from the sockets and write
+   * the replies back, the connections being spread across them. With 0, all
+   * the sockets are served by the main EventBase.
+   *
+   * A mount only benefits from more than one IO thread when the client opens
+   * several connections, see nfs:num-connections.
+   */
+  ConfigSetting<uint64_t> numNfsIoThreads{"nfs:num-io-threads", 0, this};
+
+  /**
+   * Maximum number of requests of a single NFS connection processed at once,
+   * 0 for no limit. Once reached, EdenFS stops reading from the connection
+   * until some of its requests complete, rather than blocking the connection's
+   * EventBase when the nfs:max-inflight-requests limit is reached.
+   */
+  ConfigSetting<uint64_t> maxNfsInflightRequestsPerConnection{
+      "nfs:max-inflight-requests-per-connection",
+      0,
+      this};
+
+  /**
+   * Number of TCP connections the NFS client is asked to open to the nfsd of
+   * each mount, using the nconnect mount option, which is only available on
+   * Linux.
+   *
+   * Only one connection is kept over a graceful restart.
+   */
+  ConfigSetting<uint32_t> nfsNumConnections{"nfs:num-connections", 1, this};
+
   /**
    * Buffer size for read and writes requests. Default to 1 MiB.
    */
@@ -535,6 +1176,37 @@ class EdenConfig : private ConfigSettingManager {
       1,
       this};
 
+  /**
+   * Once a directory with at most this many entries has been listed and
+   * ProjectedFS asks for the placeholder of one of them, EdenFS writes the
+   * placeholders of all of them, saving a callback for each of the others
+   * when they are accessed too, as crawlers and IDE indexers do. 0 disables
+   * this.
+   */
+  ConfigSetting<size_t> prjfsPlaceholderBatchMaxEntries{
+      "prjfs:placeholder-batch-max-entries",
+      0,
+      this};
+
+  /**
+   * Number of threads per mount running the ProjectedFS callbacks, including
+   * the object fetches they wait on.
+   */
+  ConfigSetting<size_t> prjfsNumServicingThreads{
+      "prjfs:num-servicing-threads",
+      8,
+      this};
+
+  /**
+   * Number of ProjectedFS threads invoking the callbacks of a mount, which
+   * only hand them to the servicing threads. 0 lets ProjectedFS pick, twice
+   * the number of cores.
+   */
+  ConfigSetting<uint32_t> prjfsNumCallbackThreads{
+      "prjfs:num-callback-threads",
+      0,
+      this};
+
   /**
    * Not sure if a Windows behavior, or a ProjectedFS one, but symlinks
    * aren't created atomically, they start their life as a directory, and
@@ -606,9 +1278,196 @@ class EdenConfig : private ConfigSettingManager {
   /**
    * Controls the number of tree import requests we batch in HgBackingStore
    */
-  ConfigSetting<uint32_t> importBatchSizeTree{
-      "hg:import-batch-size-tree",
-      1,
+  ConfigSetting<uint32_t> importBatchSizeTree{
+      "hg:import-batch-size-tree",
+      1,
+      this};
+
+  /**
+   * Whether the batch sizes adapt to the import latency, starting from
+   * import-batch-size and import-batch-size-tree. See AdaptiveBatchSize.
+   */
+  ConfigSetting<bool> importBatchAdaptive{
+      "hg:import-batch-adaptive",
+      false,
+      this};
+
+  /**
+   * The p99 latency adaptive batching aims for, for high-priority imports.
+   */
+  ConfigSetting<std::chrono::nanoseconds> importBatchTargetLatency{
+      "hg:import-batch-target-latency",
+      std::chrono::milliseconds(100),
+      this};
+
+  /**
+   * Upper bound of the adaptive batch sizes.
+   */
+  ConfigSetting<uint32_t> importBatchSizeMax{
+      "hg:import-batch-size-max",
+      1024,
+      this};
+
+  /**
+   * Whether the import requests of the client processes are interleaved in
+   * a weighted round-robin, so that one process can't starve the others.
+   * See HgImportRequestQueue.
+   */
+  ConfigSetting<bool> importFairShare{"hg:import-fair-share", false, this};
+
+  /**
+   * With hg:import-fair-share, how many times a deprioritized request, e.g.
+   * one from a fetch-heavy process, counts against its client's share.
+   */
+  ConfigSetting<uint32_t> importFairShareDeprioritizedWeight{
+      "hg:import-fair-share-deprioritized-weight",
+      4,
+      this};
+
+  /**
+   * With hg:import-fair-share, maximum number of dispatched import requests
+   * per client process while other processes have requests queued. 0 means
+   * no limit.
+   */
+  ConfigSetting<uint32_t> importMaxInFlightPerClient{
+      "hg:import-max-in-flight-per-client",
+      0,
+      this};
+
+  /**
+   * How long an import request may wait in the queue before it fails with a
+   * timeout instead of being dispatched. 0 means no deadline.
+   */
+  ConfigSetting<std::chrono::nanoseconds> importRequestDeadline{
+      "hg:import-request-deadline",
+      std::chrono::nanoseconds{0},
+      this};
+
+  /**
+   * Number of queued import requests from which the backing store is
+   * overloaded: the low-priority prefetches are then shed and the requests
+   * of fetch-heavy processes fail fast. See HgImportOverloadController. 0
+   * means no limit.
+   */
+  ConfigSetting<uint64_t> importOverloadQueueDepth{
+      "hg:import-overload-queue-depth",
+      0,
+      this};
+
+  /**
+   * Average import latency, queue wait included, from which the backing store
+   * is overloaded, as with hg:import-overload-queue-depth. 0 means no limit.
+   */
+  ConfigSetting<std::chrono::nanoseconds> importOverloadLatency{
+      "hg:import-overload-latency",
+      std::chrono::nanoseconds{0},
+      this};
+
+  /**
+   * Whether the child trees of the trees imported for non-prefetch requests
+   * are speculatively prefetched at low priority. The depth adapts to how
+   * many of the prefetched trees get requested, up to
+   * hg:speculative-tree-prefetch-max-depth levels.
+   */
+  ConfigSetting<bool> speculativeTreePrefetch{
+      "hg:speculative-tree-prefetch",
+      false,
+      this};
+
+  ConfigSetting<uint32_t> speculativeTreePrefetchMaxDepth{
+      "hg:speculative-tree-prefetch-max-depth",
+      3,
+      this};
+
+  /**
+   * Whether the root manifests that the hg client reports, e.g. after a
+   * commit, are imported in-process through the backing store instead of
+   * through the debugedenimporthelper subprocess.
+   */
+  ConfigSetting<bool> nativeManifestImport{
+      "hg:native-manifest-import",
+      false,
+      this};
+
+  /**
+   * Maximum number of legacy (non-embedded) proxy hashes kept in memory by
+   * each hg backing store, so that their imports don't read LocalStore again.
+   */
+  ConfigSetting<uint64_t> hgProxyHashCacheSize{
+      "hg:proxy-hash-cache-size",
+      1000000,
+      this};
+
+  /**
+   * Whether the legacy ObjectIds of the directories loaded from the overlay
+   * are rewritten to embed their proxy hash, and saved back.
+   */
+  ConfigSetting<bool> migrateLegacyObjectIds{
+      "hg:migrate-legacy-object-ids",
+      false,
+      this};
+
+  /**
+   * Whether the import batches are first looked up in the hg cache, so that
+   * the objects found locally complete without waiting for the remote fetch
+   * of the rest of their batch. This also attributes each import to the hg
+   * cache or a remote fetch in the hg trace events.
+   */
+  ConfigSetting<bool> importBatchLocalFirst{
+      "hg:import-batch-local-first",
+      false,
+      this};
+
+  /**
+   * Whether prefetchBlobs skips the blobs already present in the hg cache,
+   * instead of leaving that check to Mercurial. This costs a local lookup
+   * per blob, but avoids sending them in the import batches.
+   */
+  ConfigSetting<bool> prefetchSkipLocalBlobs{
+      "hg:prefetch-skip-local-blobs",
+      false,
+      this};
+
+  /**
+   * File in which the hg import trace events of every repository mounted are
+   * recorded, for the hg_import_replay benchmark. The file is truncated when
+   * a repository is opened. Empty to disable.
+   */
+  ConfigSetting<std::string> hgImportTraceFile{
+      "hg:import-trace-file",
+      "",
+      this};
+
+  // [git]
+
+  /**
+   * Size of each window of a packfile that libgit2 memory maps, in bytes.
+   * Reading a whole pack of a large repository through few big windows avoids
+   * remapping them. 0 keeps the libgit2 default. These settings are process
+   * wide in libgit2, and only read when a Git checkout is mounted.
+   */
+  ConfigSetting<size_t> gitPackWindowSize{"git:pack-window-size", 0, this};
+
+  /**
+   * Maximum number of bytes of packfiles libgit2 keeps memory mapped. 0 keeps
+   * the libgit2 default.
+   */
+  ConfigSetting<size_t> gitPackMappedLimit{"git:pack-mapped-limit", 0, this};
+
+  /**
+   * Maximum number of bytes of parsed objects, mostly trees and commits, that
+   * libgit2 caches across lookups. 0 keeps the libgit2 default.
+   */
+  ConfigSetting<size_t> gitObjectCacheSize{"git:object-cache-size", 0, this};
+
+  /**
+   * Whether libgit2 verifies the SHA-1 of each object it reads. Disabling it
+   * matches git, which trusts the objects of a local repository, and saves
+   * hashing every imported tree and blob.
+   */
+  ConfigSetting<bool> gitVerifyObjectHashes{
+      "git:verify-object-hashes",
+      true,
       this};
 
   // [backingstore]
@@ -621,6 +1480,36 @@ class EdenConfig : private ConfigSettingManager {
       32,
       this};
 
+  /**
+   * Whether the threads pulling backingstore requests off the queue should
+   * be spread over the NUMA nodes, each restricted to the CPUs of its node,
+   * so that the blobs and trees a thread imports are allocated on its node.
+   * Only used on Linux.
+   */
+  ConfigSetting<bool> backingstoreNumaAffinity{
+      "backingstore:numa-affinity",
+      false,
+      this};
+
+  /**
+   * Whether the backingstore threads hand import batches to Sapling without
+   * waiting for them, so that a few threads can keep many batches in flight.
+   * Read when the backing store is created.
+   */
+  ConfigSetting<bool> asyncBatchFetch{
+      "backingstore:async-batch-fetch",
+      false,
+      this};
+
+  /**
+   * Maximum number of import batches in flight when
+   * backingstore:async-batch-fetch is set.
+   */
+  ConfigSetting<uint32_t> maxInFlightBatches{
+      "backingstore:max-in-flight-batches",
+      64,
+      this};
+
   // [telemetry]
 
   /**
@@ -734,6 +1623,25 @@ class EdenConfig : private ConfigSettingManager {
       100,
       this};
 
+  /**
+   * Sets the maximum number of bytes the encoded events of an ActivityBuffer
+   * can use before evicting old events, whatever their number.
+   */
+  ConfigSetting<uint64_t> ActivityBufferMaxBytes{
+      "telemetry:activitybuffer-max-bytes",
+      1024 * 1024,
+      this};
+
+  /**
+   * Interval at which the filesystem and Thrift requests in flight are
+   * sampled, to be returned as folded stacks by getSampledRequestStacks. 0
+   * disables sampling, and requests are then not tracked at all.
+   */
+  ConfigSetting<std::chrono::nanoseconds> requestSamplingInterval{
+      "telemetry:request-sampling-interval",
+      std::chrono::nanoseconds{0},
+      this};
+
   // [experimental]
 
   /**
@@ -794,6 +1702,164 @@ class EdenConfig : private ConfigSettingManager {
       16,
       this};
 
+  /**
+   * Number of independently locked shards the tree cache is split into. The
+   * size budget and minimum element count are divided evenly between shards.
+   * Only read at startup.
+   */
+  ConfigSetting<size_t> inMemoryTreeCacheShardCount{
+      "treecache:shard-count",
+      1,
+      this};
+
+  /**
+   * Eviction policy of the tree cache, either "LRU" or "TinyLFU". Only read at
+   * startup.
+   */
+  ConfigSetting<CacheEvictionPolicy> inMemoryTreeCacheEvictionPolicy{
+      "treecache:eviction-policy",
+      CacheEvictionPolicy::LRU,
+      this};
+
+  /**
+   * Controls whether EdenFS keeps recently used trees in a memory-mapped file
+   * that survives restarts, checked before the local store. Only read at
+   * startup.
+   */
+  ConfigSetting<bool> enablePersistentTreeCache{
+      "treecache:enable-persistent-cache",
+      false,
+      this};
+
+  /**
+   * Number of bytes of serialized trees the persistent tree cache can hold.
+   * The cache is reset once it is full. Only read at startup.
+   */
+  ConfigSetting<size_t> persistentTreeCacheSize{
+      "treecache:persistent-cache-size",
+      256 * 1024 * 1024,
+      this};
+
+  // [blobcache]
+
+  /**
+   * Number of independently locked shards the blob cache is split into. The
+   * size budget and minimum entry count are divided evenly between shards.
+   * Only read at startup.
+   */
+  ConfigSetting<size_t> blobCacheShardCount{
+      "blobcache:shard-count",
+      1,
+      this};
+
+  /**
+   * Eviction policy of the blob cache, either "LRU" or "TinyLFU". Only read at
+   * startup.
+   */
+  ConfigSetting<CacheEvictionPolicy> blobCacheEvictionPolicy{
+      "blobcache:eviction-policy",
+      CacheEvictionPolicy::LRU,
+      this};
+
+  /**
+   * Size in bytes of the compressed tier holding blobs evicted from the blob
+   * cache. 0 disables the tier. Only read at startup.
+   */
+  ConfigSetting<size_t> blobCacheCompressedTierSize{
+      "blobcache:compressed-tier-size",
+      0,
+      this};
+
+  // [memory-governor]
+
+  /**
+   * Controls whether EdenFS shrinks the blob and tree cache budgets under
+   * memory pressure, and grows them back once the pressure subsides. The
+   * budgets configured at startup are never exceeded.
+   */
+  ConfigSetting<bool> enableMemoryGovernor{
+      "memory-governor:enabled",
+      false,
+      this};
+
+  /**
+   * How often the memory governor checks memory pressure and RSS.
+   */
+  ConfigSetting<std::chrono::nanoseconds> memoryGovernorInterval{
+      "memory-governor:interval",
+      std::chrono::seconds{10},
+      this};
+
+  /**
+   * Cache budgets shrink while the "some" memory pressure averaged over 10
+   * seconds, in percent, is at least this value. Only available on Linux.
+   */
+  ConfigSetting<double> memoryGovernorHighPressure{
+      "memory-governor:high-pressure",
+      10.0,
+      this};
+
+  /**
+   * Cache budgets grow back while the "some" memory pressure averaged over 10
+   * seconds, in percent, is at most this value.
+   */
+  ConfigSetting<double> memoryGovernorLowPressure{
+      "memory-governor:low-pressure",
+      1.0,
+      this};
+
+  /**
+   * Cache budgets shrink while the resident set size of EdenFS is above this
+   * many bytes. 0 means no limit.
+   */
+  ConfigSetting<size_t> memoryGovernorRssLimit{
+      "memory-governor:rss-limit",
+      0,
+      this};
+
+  /**
+   * Fraction of the startup cache budgets the memory governor never shrinks
+   * below.
+   */
+  ConfigSetting<double> memoryGovernorMinimumFraction{
+      "memory-governor:minimum-fraction",
+      0.1,
+      this};
+
+  // [cache-warming]
+
+  /**
+   * Controls whether EdenFS records the ids of the objects in its in-memory
+   * caches, and prefetches them on startup to warm the caches back up.
+   */
+  ConfigSetting<bool> enableCacheWarming{"cache-warming:enabled", false, this};
+
+  /**
+   * How often the ids of the cached objects are recorded, in addition to
+   * being recorded on shutdown. Recording them periodically lets a restart
+   * after a crash warm up too.
+   */
+  ConfigSetting<std::chrono::nanoseconds> cacheWarmingSaveInterval{
+      "cache-warming:save-interval",
+      std::chrono::minutes(5),
+      this};
+
+  /**
+   * Maximum number of blob ids, and of tree ids, recorded.
+   */
+  ConfigSetting<size_t> cacheWarmingMaxObjects{
+      "cache-warming:max-objects",
+      100000,
+      this};
+
+  /**
+   * Maximum number of concurrent fetches issued while warming up.
+   */
+  ConfigSetting<size_t> cacheWarmingMaxInFlight{
+      "cache-warming:max-in-flight",
+      64,
+      this};
+
   // [notifications]
 
   /**
@@ -808,13 +1874,24 @@ class EdenConfig : private ConfigSettingManager {
       this};
 
   /**
-   * Don't show a notification more often than once in the specified interval
+   * Don't show more than notifications:max-per-interval notifications of the
+   * same kind in the specified interval
    */
   ConfigSetting<std::chrono::nanoseconds> notificationInterval{
       "notifications:interval",
       std::chrono::minutes(1),
       this};
 
+  /**
+   * How many notifications of the same kind can be shown per
+   * notifications:interval. The others are suppressed, and counted in the
+   * notifications.suppressed counter.
+   */
+  ConfigSetting<uint64_t> notificationMaxPerInterval{
+      "notifications:max-per-interval",
+      1,
+      this};
+
   /**
    * Whether the E-Menu should be created when the EdenFS daemon is started
    */
@@ -844,6 +1921,68 @@ class EdenConfig : private ConfigSettingManager {
   ConfigSetting<uint64_t> maxLogFileSize{"log:max-file-size", 50000000, this};
   ConfigSetting<uint64_t> maxRotatedLogFiles{"log:num-rotated-logs", 3, this};
 
+  // [monitor]
+
+  /**
+   * How often the monitor samples the resources used by EdenFS to apply its
+   * resource policies. 0 disables them.
+   */
+  ConfigSetting<std::chrono::nanoseconds> monitorGovernorInterval{
+      "monitor:governor-interval",
+      std::chrono::minutes{1},
+      this};
+
+  /**
+   * The monitor asks EdenFS to clear its memory caches, and then to unload
+   * inodes, while its resident set size is above this many bytes. 0 means no
+   * limit.
+   */
+  ConfigSetting<uint64_t> monitorRssLimit{"monitor:rss-limit", 0, this};
+
+  /**
+   * The monitor asks EdenFS to unload inodes while it has more than this many
+   * open files. 0 means no limit.
+   */
+  ConfigSetting<uint64_t> monitorOpenFilesLimit{
+      "monitor:open-files-limit",
+      0,
+      this};
+
+  /**
+   * The monitor asks EdenFS to compact its LocalStore while a filesystem
+   * request has been running for longer than this, unless EdenFS is busy on
+   * the CPU. 0 means no limit.
+   */
+  ConfigSetting<std::chrono::nanoseconds> monitorRequestLatencyLimit{
+      "monitor:request-latency-limit",
+      std::chrono::nanoseconds{0},
+      this};
+
+  /**
+   * EdenFS is busy on the CPU, and its LocalStore isn't compacted, while it
+   * used more than this many cores on average since the previous sample.
+   */
+  ConfigSetting<double> monitorCompactionMaxCpu{
+      "monitor:compaction-max-cpu",
+      0.5,
+      this};
+
+  /**
+   * The monitor doesn't repeat the same action before this much time passed.
+   */
+  ConfigSetting<std::chrono::nanoseconds> monitorActionCooldown{
+      "monitor:action-cooldown",
+      std::chrono::minutes{10},
+      this};
+
+  /**
+   * Inodes unloaded by the monitor are the ones not accessed for this long.
+   */
+  ConfigSetting<std::chrono::nanoseconds> monitorUnloadInodeAge{
+      "monitor:unload-inode-age",
+      std::chrono::minutes{5},
+      this};
+
   // [prefetch-profiles]
 
   /**
@@ -937,6 +2076,168 @@ class EdenConfig : private ConfigSettingManager {
       64 * 1024 * 1024,
       this};
 
+  /**
+   * Whether the BufferedSqliteInodeCatalog's worker thread commits all the
+   * writes it takes from the buffer at once in a single SQLite transaction,
+   * rather than committing every directory write on its own.
+   */
+  /**
+   * Whether new overlays store their directories in memory-mapped segment
+   * files rather than in a file per directory. Overlays created this way keep
+   * doing so regardless of this setting. Only supported on macOS and Linux.
+   */
+  ConfigSetting<bool> overlaySegmentCatalog{
+      "overlay:segment-catalog",
+      false,
+      this};
+
+  /**
+   * Size in bytes of the directory segment files of overlays using the
+   * segment catalog.
+   */
+  ConfigSetting<size_t> overlaySegmentSize{
+      "overlay:segment-size",
+      64 * 1024 * 1024,
+      this};
+
+  /**
+   * Whether large files are materialized by cloning a copy of their blob kept
+   * in the overlay, rather than by writing all their contents, on filesystems
+   * that can clone files (btrfs and XFS on Linux, APFS on macOS). Only read
+   * when a mount starts.
+   */
+  ConfigSetting<bool> overlayCloneMaterialization{
+      "overlay:clone-materialization",
+      false,
+      this};
+
+  /**
+   * Files at least this large are materialized by cloning when
+   * overlay:clone-materialization is set.
+   */
+  ConfigSetting<size_t> overlayCloneMinimumSize{
+      "overlay:clone-minimum-size",
+      64 * 1024 * 1024,
+      this};
+
+  /**
+   * Maximum number of bytes of blobs each overlay keeps to clone files from.
+   * The least recently used are removed first.
+   */
+  ConfigSetting<size_t> overlayCloneCacheSize{
+      "overlay:clone-cache-size",
+      8ull * 1024 * 1024 * 1024,
+      this};
+
+  ConfigSetting<bool> overlayBufferGroupCommit{
+      "overlay:buffer-group-commit",
+      true,
+      this};
+
+  /**
+   * Maximum number of bytes of small sequential writes to a materialized file
+   * coalesced in memory before being written to its overlay file. 0 writes
+   * every write to the overlay file right away. Writes that weren't fsync'ed
+   * are lost if EdenFS crashes before writing them back. Only read when a
+   * mount starts.
+   */
+  /**
+   * Write the directories of the overlay back from a worker thread,
+   * coalescing the repeated saves of a directory into a single write. Only
+   * applies to the overlays without semantic operations, which rewrite a
+   * whole directory on every change to it. Only read when a mount starts.
+   */
+  ConfigSetting<bool> overlayWriteBehind{"overlay:write-behind", false, this};
+
+  /**
+   * How long the overlay write behind waits after a directory is saved before
+   * writing it back, for it to be saved again in the meantime.
+   */
+  ConfigSetting<std::chrono::nanoseconds> overlayWriteBehindDelay{
+      "overlay:write-behind-delay",
+      std::chrono::milliseconds(100),
+      this};
+
+  /**
+   * Maximum number of directories waiting to be written back by the overlay
+   * write behind, after which saving another one blocks.
+   */
+  ConfigSetting<size_t> overlayWriteBehindMaxPending{
+      "overlay:write-behind-max-pending",
+      10000,
+      this};
+
+  /**
+   * Number of threads loading materialized directories from the overlay, so
+   * that channel threads don't wait on the disk while holding locks. 0 loads
+   * them on the calling thread. Only read when a mount starts.
+   */
+  ConfigSetting<size_t> overlayIoThreads{"overlay:io-threads", 0, this};
+
+  /**
+   * Whether the inode metadata table is read in whole when a mount starts,
+   * rather than faulted in as the inodes are accessed.
+   */
+  ConfigSetting<bool> overlayMetadataTablePopulate{
+      "overlay:metadata-table-populate",
+      true,
+      this};
+
+  /**
+   * Whether the inode metadata table is mapped with transparent huge pages,
+   * saving TLB misses on large tables. Only effective on file systems that
+   * support huge pages for file mappings.
+   */
+  ConfigSetting<bool> overlayMetadataTableHugePages{
+      "overlay:metadata-table-huge-pages",
+      false,
+      this};
+
+  /**
+   * Whether the inode metadata table is read ahead in the background when a
+   * mount starts. Unlike overlay:metadata-table-populate, the mount doesn't
+   * wait for it.
+   */
+  ConfigSetting<bool> overlayMetadataTableWillNeed{
+      "overlay:metadata-table-willneed",
+      false,
+      this};
+
+  /**
+   * Whether the overlay maintenance and unmounts msync the records of the
+   * inode metadata table modified since the previous sync, in one batch, so
+   * that they survive a kernel or disk shutdown. Only read when a mount
+   * starts.
+   */
+  ConfigSetting<bool> overlayMetadataTableSync{
+      "overlay:metadata-table-sync",
+      false,
+      this};
+
+  /**
+   * The overlay maintenance shrinks the inode metadata table when more than
+   * this fraction of its file is unused, as after many inodes were freed. 1
+   * disables it. Only read when a mount starts.
+   */
+  ConfigSetting<double> overlayMetadataTableMaxUnusedFraction{
+      "overlay:metadata-table-max-unused-fraction",
+      0.5,
+      this};
+
+  ConfigSetting<size_t> overlayWriteBufferSize{
+      "overlay:write-buffer-size",
+      0,
+      this};
+
+  /**
+   * Maximum time buffered writes to a materialized file are kept in memory
+   * before being written to its overlay file.
+   */
+  ConfigSetting<std::chrono::nanoseconds> overlayWriteBufferMaxDelay{
+      "overlay:write-buffer-max-delay",
+      std::chrono::seconds(1),
+      this};
+
   // [clone]
 
   /**
@@ -961,6 +2262,56 @@ class EdenConfig : private ConfigSettingManager {
    */
   ConfigSetting<uint64_t> fsckLogFrequency{"fsck:log-frequency", 10000, this};
 
+  /**
+   * Number of threads scanning the shard directories of an overlay that was
+   * not shut down cleanly, or on Windows, the working copy at startup.
+   */
+  ConfigSetting<size_t> fsckThreads{"fsck:threads", 4, this};
+
+  /**
+   * Whether the overlay scan records its progress, so that a scan interrupted
+   * by another crash doesn't read the already checked files again.
+   */
+  ConfigSetting<bool> fsckCheckpoint{"fsck:checkpoint", true, this};
+
+  /**
+   * On Windows, whether a clean shutdown records the position of the change
+   * journal of the volume, so that the next startup can skip scanning the
+   * working copy when the journal shows that nothing changed in it since.
+   */
+  ConfigSetting<bool> fsckUseUsnJournal{"fsck:use-usn-journal", false, this};
+
+  // [journal]
+
+  /**
+   * Controls whether each mount appends its journal to a memory-mapped file
+   * in its client directory, restored when EdenFS restarts, so that journal
+   * positions from before the restart stay valid and Watchman doesn't need
+   * to crawl the repository. Not supported on Windows, where the working
+   * copy can change while EdenFS isn't running. Only read when mounting.
+   */
+  ConfigSetting<bool> persistJournal{"journal:persist", false, this};
+
+  /**
+   * Number of bytes of deltas the persisted journal of a mount holds. Once
+   * full it is reset, and positions from before the reset must crawl after a
+   * restart. Only read when mounting.
+   */
+  ConfigSetting<size_t> persistedJournalSize{
+      "journal:persisted-size",
+      64 * 1024 * 1024,
+      this};
+
+  /**
+   * Minimum delay between two notifications of a journal subscriber, such as
+   * a subscribeStreamTemporary stream. Changes recorded in the meantime are
+   * coalesced into a single notification. Only read when subscribing.
+   */
+  ConfigSetting<std::chrono::nanoseconds> journalNotificationInterval{
+      "journal:notification-interval",
+      std::chrono::milliseconds{10},
+      this};
+
   // [glob]
 
   /**
@@ -974,6 +2325,41 @@ class EdenConfig : private ConfigSettingManager {
       true,
       this};
 
+  /**
+   * Maximum number of directories a glob request hands to the server thread
+   * pool at any time. Once the limit is reached, directories are evaluated on
+   * the thread that reached them. 0 evaluates every directory on the thread
+   * that reached it.
+   */
+  ConfigSetting<size_t> globParallelism{"glob:parallelism", 8, this};
+
+  /**
+   * Number of glob results kept to answer the same globs against the same
+   * unmodified tree again. Globs of the working copy only use it while the
+   * directory they search has no local changes. 0 disables the cache.
+   */
+  ConfigSetting<size_t> globResultCacheSize{
+      "glob:result-cache-size",
+      0,
+      this};
+
+  /**
+   * Globs matching more paths than this are not cached.
+   */
+  ConfigSetting<size_t> globResultCacheMaxMatches{
+      "glob:result-cache-max-matches",
+      100000,
+      this};
+
+  /**
+   * streamGlobFiles publishes the matching files once it has at least this
+   * many to publish.
+   */
+  ConfigSetting<size_t> globStreamChunkSize{
+      "glob:stream-chunk-size",
+      1024,
+      this};
+
   // [facebook]
   // Facebook internal
 
@@ -58,7 +58,7 @@ std::shared_ptr<const EdenConfig> ReloadableConfig::getEdenConfig(
   }
 
   if (!shouldReload) {
-    return state_.rlock()->config;
+    return getThreadSnapshot().config;
   }
 
   auto state = state_.wlock();
@@ -83,8 +83,16 @@ std::shared_ptr<const EdenConfig> ReloadableConfig::getEdenConfig(
       newConfig->loadSystemConfig();
     }
     state->config = std::move(newConfig);
+    ++state->version;
+    version_.store(state->version, std::memory_order_release);
   }
   return state->config;
 }
 
+void ReloadableConfig::refreshSnapshot(Snapshot& snapshot) {
+  auto state = state_.rlock();
+  snapshot.config = state->config;
+  snapshot.version = state->version;
+}
+
 } // namespace facebook::eden
@@ -7,10 +7,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <memory>
 
 #include <folly/Synchronized.h>
+#include <folly/ThreadLocal.h>
 
 #include "eden/fs/config/gen-cpp2/eden_config_types.h"
 
@@ -39,14 +41,55 @@ class ReloadableConfig {
   std::shared_ptr<const EdenConfig> getEdenConfig(
       ConfigReloadBehavior reload = ConfigReloadBehavior::AutoReload);
 
+  /**
+   * Get the EdenConfig data without checking the config files for changes,
+   * for hot paths.
+   *
+   * As long as the config wasn't reloaded since the calling thread last read
+   * it, this costs one atomic load: each thread keeps its own reference to
+   * the config it last saw. Changes are picked up once another caller of
+   * getEdenConfig() reloaded the config, such as the periodic reload task of
+   * the EdenServer.
+   *
+   * The returned reference is only valid until the calling thread calls
+   * getSnapshot() or getEdenConfig() again.
+   */
+  const EdenConfig& getSnapshot() {
+    return *getThreadSnapshot().config;
+  }
+
  private:
   struct ConfigState {
     explicit ConfigState(const std::shared_ptr<const EdenConfig>& config)
         : config{config} {}
     std::shared_ptr<const EdenConfig> config;
+    uint64_t version{1};
+  };
+
+  struct Snapshot {
+    /** 0 until the thread first read the config. */
+    uint64_t version{0};
+    std::shared_ptr<const EdenConfig> config;
   };
 
+  /**
+   * The calling thread's snapshot, first refreshed if the config was reloaded
+   * since.
+   */
+  Snapshot& getThreadSnapshot() {
+    auto& snapshot = *snapshots_;
+    if (snapshot.version != version_.load(std::memory_order_acquire)) {
+      refreshSnapshot(snapshot);
+    }
+    return snapshot;
+  }
+
+  void refreshSnapshot(Snapshot& snapshot);
+
   folly::Synchronized<ConfigState> state_;
+  /** Mirrors state_.version, so readers don't need the lock to check it. */
+  std::atomic<uint64_t> version_{1};
+  folly::ThreadLocal<Snapshot> snapshots_;
   std::atomic<std::chrono::steady_clock::time_point::rep> lastCheck_{};
 
   // Reload behavior, when set this overrides reload behavior passed to methods
@@ -137,6 +137,22 @@ TEST_F(CachedParsedFileMonitorTest, baseIsChangedTest) {
   EXPECT_EQ(fcm->getUpdateCount(), 1);
 }
 
+TEST_F(CachedParsedFileMonitorTest, checkForUpdatesTest) {
+  auto fcm =
+      std::make_shared<CachedParsedFileMonitor<TestFileParser>>(pathOne_, 0s);
+
+  // The first check loads the file, the next ones only see it unchanged.
+  EXPECT_EQ(fcm->checkForUpdates(), 1);
+  EXPECT_EQ(fcm->checkForUpdates(), 1);
+  EXPECT_EQ(fcm->getFileContents().value(), dataOne_);
+  EXPECT_EQ(fcm->getUpdateCount(), 1);
+
+  // As with getFileContents(), a different file is loaded immediately.
+  EXPECT_EQ(fcm->checkForUpdates(pathTwo_), 2);
+  EXPECT_EQ(fcm->getFileContents().value(), dataTwo_);
+  EXPECT_EQ(fcm->checkForUpdates(pathTwo_), 2);
+}
+
 TEST_F(CachedParsedFileMonitorTest, updateNameTest) {
   auto fcm =
       std::make_shared<CachedParsedFileMonitor<TestFileParser>>(pathOne_, 0s);
@@ -7,6 +7,7 @@
 
 #include "eden/fs/config/CheckoutConfig.h"
 
+#include <cpptoml.h>
 #include <folly/experimental/TestUtil.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
@@ -184,6 +185,33 @@ TEST_F(CheckoutConfigTest, testMountProtocolDefault) {
   EXPECT_EQ(config->getMountProtocol(), kMountProtocolDefault);
 }
 
+TEST_F(CheckoutConfigTest, testReloadSeesConfigChanges) {
+  auto config =
+      CheckoutConfig::loadFromClientDirectory(mountPoint_, clientDir_);
+  EXPECT_EQ("git", config->getRepoType());
+  config = CheckoutConfig::loadFromClientDirectory(mountPoint_, clientDir_);
+  EXPECT_EQ("git", config->getRepoType());
+
+  auto localData =
+      "[repository]\n"
+      "path = \"/data/users/carenthomas/fbsource\"\n"
+      "type = \"hg\"\n"
+      "protocol = \"nfs\"\n";
+  writeFile(configDotToml_, folly::StringPiece{localData}).value();
+  config = CheckoutConfig::loadFromClientDirectory(mountPoint_, clientDir_);
+  EXPECT_EQ("hg", config->getRepoType());
+  EXPECT_EQ(MountProtocol::NFS, config->getRawMountProtocol());
+}
+
+TEST_F(CheckoutConfigTest, testReloadOfInvalidConfigThrows) {
+  CheckoutConfig::loadFromClientDirectory(mountPoint_, clientDir_);
+
+  writeFile(configDotToml_, folly::StringPiece{"[repository\n"}).value();
+  EXPECT_THROW(
+      CheckoutConfig::loadFromClientDirectory(mountPoint_, clientDir_),
+      cpptoml::parse_exception);
+}
+
 TEST_F(CheckoutConfigTest, testVersion1MultipleParents) {
   auto config =
       CheckoutConfig::loadFromClientDirectory(mountPoint_, clientDir_);
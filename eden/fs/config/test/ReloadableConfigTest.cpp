@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/config/ReloadableConfig.h"
+
+#include <thread>
+
+#include <fmt/format.h>
+#include <folly/experimental/TestUtil.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/utils/FileUtils.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+using folly::test::TemporaryDirectory;
+using namespace facebook::eden;
+using namespace facebook::eden::path_literals;
+
+namespace {
+
+class ReloadableConfigTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    rootDir_ = canonicalPath(tempDir_.path().string());
+    userConfigPath_ = rootDir_ + ".edenrc"_pc;
+    systemConfigPath_ = rootDir_ + "edenfs.rc"_pc;
+    setUserBatchSize(2);
+
+    auto config = std::make_shared<EdenConfig>(
+        "bob", 42, rootDir_, userConfigPath_, rootDir_, systemConfigPath_);
+    config->loadUserConfig();
+    config_ = std::make_unique<ReloadableConfig>(std::move(config));
+  }
+
+  void setUserBatchSize(uint32_t size) {
+    // The trailing comment changes the size of the file, so that the change
+    // is noticed even if the modification time doesn't.
+    writeFileAtomic(
+        userConfigPath_,
+        fmt::format(
+            "[hg]\nimport-batch-size={}\n# {}\n",
+            size,
+            std::string(size, 'x')))
+        .value();
+  }
+
+  TemporaryDirectory tempDir_{"eden_reloadable_config_test"};
+  AbsolutePath rootDir_;
+  AbsolutePath userConfigPath_;
+  AbsolutePath systemConfigPath_;
+  std::unique_ptr<ReloadableConfig> config_;
+};
+
+} // namespace
+
+TEST_F(ReloadableConfigTest, snapshot_reads_the_current_config) {
+  EXPECT_EQ(2, config_->getSnapshot().importBatchSize.getValue());
+  EXPECT_EQ(
+      &config_->getSnapshot(),
+      config_->getEdenConfig(ConfigReloadBehavior::NoReload).get());
+}
+
+TEST_F(ReloadableConfigTest, snapshot_does_not_check_for_changes) {
+  EXPECT_EQ(2, config_->getSnapshot().importBatchSize.getValue());
+  setUserBatchSize(5);
+  EXPECT_EQ(2, config_->getSnapshot().importBatchSize.getValue());
+
+  auto reloaded = config_->getEdenConfig(ConfigReloadBehavior::ForceReload);
+  EXPECT_EQ(5, reloaded->importBatchSize.getValue());
+  EXPECT_EQ(5, config_->getSnapshot().importBatchSize.getValue());
+}
+
+TEST_F(ReloadableConfigTest, reload_is_seen_by_other_threads) {
+  EXPECT_EQ(2, config_->getSnapshot().importBatchSize.getValue());
+
+  std::thread{[&] {
+    setUserBatchSize(7);
+    config_->getEdenConfig(ConfigReloadBehavior::ForceReload);
+  }}.join();
+
+  EXPECT_EQ(7, config_->getSnapshot().importBatchSize.getValue());
+}
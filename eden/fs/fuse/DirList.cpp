@@ -64,6 +64,73 @@ std::vector<FuseDirList::ExtractedEntry> FuseDirList::extract() const {
   return result;
 }
 
+#ifdef __linux__
+FuseDirPlusList::FuseDirPlusList(size_t maxSize)
+    : buf_(new char[maxSize]), end_(buf_.get() + maxSize), cur_(buf_.get()) {}
+
+bool FuseDirPlusList::add(
+    StringPiece name,
+    ino_t inode,
+    dtype_t type,
+    off_t off) {
+  const size_t avail = end_ - cur_;
+  const auto entLength = FUSE_NAME_OFFSET_DIRENTPLUS + name.size();
+  const auto fullSize = FUSE_DIRENT_ALIGN(entLength);
+  if (fullSize > avail) {
+    return false;
+  }
+
+  fuse_direntplus* const direntplus = reinterpret_cast<fuse_direntplus*>(cur_);
+  direntplus->entry_out = {};
+  fuse_dirent* const dirent = &direntplus->dirent;
+  dirent->ino = inode;
+  dirent->off = off;
+  dirent->namelen = name.size();
+  dirent->type = static_cast<decltype(dirent->type)>(type);
+  memcpy(dirent->name, name.data(), name.size());
+  if (fullSize > entLength) {
+    // 0 out any padding
+    memset(cur_ + entLength, 0, fullSize - entLength);
+  }
+
+  entries_.push_back(cur_ - buf_.get());
+  cur_ += fullSize;
+  XDCHECK_LE(cur_, end_);
+  return true;
+}
+
+void FuseDirPlusList::setEntryOut(
+    size_t index,
+    const fuse_entry_out& entryOut) {
+  XDCHECK_LT(index, entries_.size());
+  auto direntplus =
+      reinterpret_cast<fuse_direntplus*>(buf_.get() + entries_[index]);
+  direntplus->entry_out = entryOut;
+}
+
+StringPiece FuseDirPlusList::getBuf() const {
+  return StringPiece(buf_.get(), cur_ - buf_.get());
+}
+
+std::vector<FuseDirPlusList::ExtractedEntry> FuseDirPlusList::extract() const {
+  std::vector<FuseDirPlusList::ExtractedEntry> result;
+  result.reserve(entries_.size());
+
+  for (auto offset : entries_) {
+    auto direntplus =
+        reinterpret_cast<const fuse_direntplus*>(buf_.get() + offset);
+    const auto& entry = direntplus->dirent;
+    result.emplace_back(ExtractedEntry{
+        std::string{entry.name, entry.name + entry.namelen},
+        entry.ino,
+        static_cast<dtype_t>(entry.type),
+        static_cast<off_t>(entry.off),
+        direntplus->entry_out});
+  }
+  return result;
+}
+#endif
+
 } // namespace facebook::eden
 
 #endif
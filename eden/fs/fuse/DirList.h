@@ -9,7 +9,9 @@
 #include <folly/Range.h>
 #include <sys/stat.h>
 #include <memory>
+#include <vector>
 #include "eden/fs/utils/DirType.h"
+#include "eden/fs/utils/FsChannelTypes.h"
 
 namespace facebook::eden {
 
@@ -51,4 +53,65 @@ class FuseDirList {
   std::vector<ExtractedEntry> extract() const;
 };
 
+#ifdef __linux__
+/**
+ * Helper for populating directory listings with the attributes of their
+ * entries, for FUSE_READDIRPLUS.
+ *
+ * Entries are added with empty attributes, which are filled in once they are
+ * known with setEntryOut().
+ */
+class FuseDirPlusList {
+  std::unique_ptr<char[]> buf_;
+  char* end_;
+  char* cur_;
+  // The offset of each entry in buf_.
+  std::vector<size_t> entries_;
+
+ public:
+  struct ExtractedEntry {
+    std::string name;
+    ino_t inode;
+    dtype_t type;
+    off_t offset;
+    fuse_entry_out entryOut;
+  };
+
+  explicit FuseDirPlusList(size_t maxSize);
+
+  FuseDirPlusList(const FuseDirPlusList&) = delete;
+  FuseDirPlusList& operator=(const FuseDirPlusList&) = delete;
+  FuseDirPlusList(FuseDirPlusList&&) = default;
+  FuseDirPlusList& operator=(FuseDirPlusList&&) = default;
+
+  /**
+   * Add a new dirent to the list, with empty attributes.
+   * Returns true on success or false if the list is full.
+   */
+  bool add(folly::StringPiece name, ino_t inode, dtype_t type, off_t off);
+
+  /**
+   * The number of entries added to the list.
+   */
+  size_t size() const {
+    return entries_.size();
+  }
+
+  /**
+   * Set the attributes of the index-th entry. The kernel takes a lookup
+   * reference on the entry's inode unless entryOut.nodeid is 0, in which case
+   * it only lists the entry.
+   */
+  void setEntryOut(size_t index, const fuse_entry_out& entryOut);
+
+  folly::StringPiece getBuf() const;
+
+  /**
+   * Helper function that parses an accumulated buffer back into its constituent
+   * parts.
+   */
+  std::vector<ExtractedEntry> extract() const;
+};
+#endif
+
 } // namespace facebook::eden
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/fuse/FuseAdmissionControl.h"
+
+#include <algorithm>
+#include <string_view>
+
+#include "eden/common/utils/ProcessNameCache.h"
+
+namespace facebook::eden {
+
+namespace {
+
+/**
+ * PIDs get reused, so the lanes of processes are forgotten once that many
+ * were seen.
+ */
+constexpr size_t kMaxCachedLanes = 4096;
+
+size_t laneIndex(PriorityLaneAdmissionControl::Lane lane) {
+  return static_cast<size_t>(lane);
+}
+
+/**
+ * The basename of the executable of a command line, as returned by
+ * ProcessNameCache, whose arguments are separated by NUL characters.
+ */
+std::string_view executableName(std::string_view commandLine) {
+  auto executable = commandLine.substr(0, commandLine.find('\0'));
+  auto slash = executable.rfind('/');
+  return slash == std::string_view::npos ? executable
+                                         : executable.substr(slash + 1);
+}
+
+} // namespace
+
+PriorityLaneAdmissionControl::PriorityLaneAdmissionControl(
+    std::shared_ptr<ProcessNameCache> processNameCache,
+    std::vector<std::string> backgroundProcessNames,
+    Limits limits)
+    : processNameCache_{std::move(processNameCache)},
+      backgroundProcessNames_{std::move(backgroundProcessNames)},
+      limits_{limits} {}
+
+ImmediateFuture<folly::Unit> PriorityLaneAdmissionControl::admit(pid_t pid) {
+  auto state = state_.wlock();
+  auto lane = getLane(*state, pid);
+  auto& process = state->processes[pid];
+  process.lane = lane;
+  if (process.waiting.empty() && underProcessLimit(process) &&
+      underLaneLimit(*state, lane)) {
+    start(*state, process);
+    return folly::unit;
+  }
+
+  auto& promise = process.waiting.emplace_back();
+  ++state->waitingCount;
+  auto future = promise.getSemiFuture();
+  if (underProcessLimit(process)) {
+    markRunnable(*state, pid, process);
+  }
+  return std::move(future);
+}
+
+void PriorityLaneAdmissionControl::release(pid_t pid) {
+  std::vector<folly::Promise<folly::Unit>> admitted;
+  {
+    auto state = state_.wlock();
+    auto it = state->processes.find(pid);
+    if (it == state->processes.end() || it->second.inFlight == 0) {
+      return;
+    }
+    auto& process = it->second;
+    --process.inFlight;
+    if (process.lane == Lane::Background) {
+      --state->backgroundInFlight;
+    }
+    if (!process.waiting.empty()) {
+      markRunnable(*state, pid, process);
+    } else if (process.inFlight == 0) {
+      state->processes.erase(it);
+    }
+    admitted = admitWaiting(*state);
+  }
+
+  // The admitted requests are dispatched inline, so don't hold the lock.
+  for (auto& promise : admitted) {
+    promise.setValue();
+  }
+}
+
+size_t PriorityLaneAdmissionControl::getWaitingCount() const {
+  return state_.rlock()->waitingCount;
+}
+
+std::optional<PriorityLaneAdmissionControl::Lane>
+PriorityLaneAdmissionControl::classify(pid_t pid) {
+  if (pid == 0) {
+    // The requests the kernel makes on its own behalf, like FORGET.
+    return Lane::Interactive;
+  }
+  auto commandLine = processNameCache_->getProcessName(pid);
+  if (!commandLine) {
+    // Let the name be looked up in the background.
+    processNameCache_->add(pid);
+    return std::nullopt;
+  }
+  auto name = executableName(*commandLine);
+  bool background = std::find(
+                        backgroundProcessNames_.begin(),
+                        backgroundProcessNames_.end(),
+                        name) != backgroundProcessNames_.end();
+  return background ? Lane::Background : Lane::Interactive;
+}
+
+PriorityLaneAdmissionControl::Lane PriorityLaneAdmissionControl::getLane(
+    State& state,
+    pid_t pid) {
+  auto processIt = state.processes.find(pid);
+  if (processIt != state.processes.end()) {
+    // Keep the lane of the requests in flight, so they're released from it.
+    return processIt->second.lane;
+  }
+  auto it = state.lanes.find(pid);
+  if (it != state.lanes.end()) {
+    return it->second;
+  }
+  auto lane = classify(pid);
+  if (!lane) {
+    return Lane::Interactive;
+  }
+  if (state.lanes.size() >= kMaxCachedLanes) {
+    state.lanes.clear();
+  }
+  state.lanes.emplace(pid, *lane);
+  return *lane;
+}
+
+bool PriorityLaneAdmissionControl::underProcessLimit(
+    const Process& process) const {
+  return process.lane == Lane::Interactive ||
+      limits_.maxRequestsPerProcess == 0 ||
+      process.inFlight < limits_.maxRequestsPerProcess;
+}
+
+bool PriorityLaneAdmissionControl::underLaneLimit(
+    const State& state,
+    Lane lane) const {
+  return lane == Lane::Interactive || limits_.maxBackgroundRequests == 0 ||
+      state.backgroundInFlight < limits_.maxBackgroundRequests;
+}
+
+void PriorityLaneAdmissionControl::start(State& state, Process& process) {
+  ++process.inFlight;
+  if (process.lane == Lane::Background) {
+    ++state.backgroundInFlight;
+  }
+}
+
+void PriorityLaneAdmissionControl::markRunnable(
+    State& state,
+    pid_t pid,
+    Process& process) {
+  if (!process.runnable && underProcessLimit(process)) {
+    process.runnable = true;
+    state.runnable[laneIndex(process.lane)].push_back(pid);
+  }
+}
+
+std::vector<folly::Promise<folly::Unit>>
+PriorityLaneAdmissionControl::admitWaiting(State& state) {
+  std::vector<folly::Promise<folly::Unit>> admitted;
+  // The interactive lane is drained first.
+  for (auto lane : {Lane::Interactive, Lane::Background}) {
+    auto& runnable = state.runnable[laneIndex(lane)];
+    while (!runnable.empty() && underLaneLimit(state, lane)) {
+      auto pid = runnable.front();
+      runnable.pop_front();
+      auto& process = state.processes.at(pid);
+      process.runnable = false;
+
+      admitted.push_back(std::move(process.waiting.front()));
+      process.waiting.pop_front();
+      --state.waitingCount;
+      start(state, process);
+
+      // Take turns between the processes of the lane.
+      if (!process.waiting.empty()) {
+        markRunnable(state, pid, process);
+      }
+    }
+  }
+  return admitted;
+}
+
+} // namespace facebook::eden
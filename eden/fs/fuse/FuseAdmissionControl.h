@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/futures/Promise.h>
+#include <folly/portability/SysTypes.h>
+#include <array>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "eden/fs/utils/ImmediateFuture.h"
+
+namespace facebook::eden {
+
+class ProcessNameCache;
+
+/**
+ * Decides when FuseChannel may dispatch the requests it read from the kernel,
+ * so that a process issuing many requests doesn't delay everyone else's.
+ *
+ * Implementations must be thread-safe: requests are admitted and released by
+ * the FUSE worker threads and by the threads completing requests.
+ */
+class FuseAdmissionControl {
+ public:
+  virtual ~FuseAdmissionControl() = default;
+
+  /**
+   * Called before dispatching a request from pid. The request is dispatched
+   * once the returned future completes, after which release() must be called
+   * with the same pid when the request completes.
+   *
+   * The future should be ready for most requests: FuseChannel has to copy
+   * the arguments of the requests that wait.
+   */
+  virtual ImmediateFuture<folly::Unit> admit(pid_t pid) = 0;
+
+  virtual void release(pid_t pid) = 0;
+};
+
+/**
+ * Admission control with two priority lanes: the requests of interactive
+ * processes are always admitted right away, while background processes, the
+ * ones named in backgroundProcessNames, may only have maxRequestsPerProcess
+ * requests each, and maxBackgroundRequests requests all together, in flight.
+ * Waiting requests are admitted in turn from each background process.
+ *
+ * A limit of 0 means no limit.
+ */
+class PriorityLaneAdmissionControl : public FuseAdmissionControl {
+ public:
+  enum class Lane : uint8_t {
+    Interactive,
+    Background,
+  };
+
+  struct Limits {
+    size_t maxRequestsPerProcess = 0;
+    size_t maxBackgroundRequests = 0;
+  };
+
+  PriorityLaneAdmissionControl(
+      std::shared_ptr<ProcessNameCache> processNameCache,
+      std::vector<std::string> backgroundProcessNames,
+      Limits limits);
+
+  ImmediateFuture<folly::Unit> admit(pid_t pid) override;
+  void release(pid_t pid) override;
+
+  /**
+   * The number of requests waiting to be admitted.
+   */
+  size_t getWaitingCount() const;
+
+ protected:
+  /**
+   * Return the lane of the requests of pid, or std::nullopt if it isn't known
+   * yet, in which case the requests are treated as interactive and pid is
+   * classified again later.
+   */
+  virtual std::optional<Lane> classify(pid_t pid);
+
+ private:
+  struct Process {
+    Lane lane;
+    size_t inFlight = 0;
+    std::deque<folly::Promise<folly::Unit>> waiting;
+    // Whether pid is in the runnable queue of its lane.
+    bool runnable = false;
+  };
+
+  struct State {
+    folly::F14FastMap<pid_t, Process> processes;
+    // The lanes of the processes seen recently.
+    folly::F14FastMap<pid_t, Lane> lanes;
+    // The processes with waiting requests they are allowed to run, in the
+    // order they will be admitted.
+    std::array<std::deque<pid_t>, 2> runnable;
+    size_t backgroundInFlight = 0;
+    size_t waitingCount = 0;
+  };
+
+  Lane getLane(State& state, pid_t pid);
+  bool underProcessLimit(const Process& process) const;
+  bool underLaneLimit(const State& state, Lane lane) const;
+  void start(State& state, Process& process);
+  void markRunnable(State& state, pid_t pid, Process& process);
+
+  /**
+   * Admit as many waiting requests as the limits allow, returning their
+   * promises to be fulfilled without holding the lock.
+   */
+  std::vector<folly::Promise<folly::Unit>> admitWaiting(State& state);
+
+  const std::shared_ptr<ProcessNameCache> processNameCache_;
+  const std::vector<std::string> backgroundProcessNames_;
+  const Limits limits_;
+  folly::Synchronized<State> state_;
+};
+
+} // namespace facebook::eden
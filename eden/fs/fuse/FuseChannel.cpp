@@ -11,23 +11,34 @@
 
 #include <boost/cast.hpp>
 #include <fmt/core.h>
+#include <folly/container/F14Set.h>
 #include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 #include <folly/system/ThreadName.h>
 #include <signal.h>
 #include <chrono>
+#include <limits>
+#ifdef __linux__
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/ioctl.h>
+#endif
 #include <type_traits>
 #include "eden/common/utils/Synchronized.h"
 #include "eden/fs/fuse/DirList.h"
+#include "eden/fs/fuse/FuseAdmissionControl.h"
 #include "eden/fs/fuse/FuseDispatcher.h"
 #include "eden/fs/fuse/FuseRequestContext.h"
 #include "eden/fs/telemetry/FsEventLogger.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/IDGen.h"
+#include "eden/fs/utils/NumaTopology.h"
+#include "eden/fs/utils/RequestArena.h"
 #include "eden/fs/utils/StaticAssert.h"
 #include "eden/fs/utils/SystemError.h"
 #include "eden/fs/utils/Thread.h"
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
 
 using namespace folly;
 using std::string;
@@ -176,6 +187,9 @@ std::string readdir(FuseArg arg) {
   return fmt::format("offset={}", in.offset);
 }
 
+#ifdef __linux__
+constexpr RenderFn readdirplus = readdir;
+#endif
 constexpr RenderFn releasedir = default_render;
 constexpr RenderFn fsyncdir = default_render;
 
@@ -217,6 +231,20 @@ static_assert(
 // This is the minimum size used by libfuse so we use it too!
 constexpr size_t MIN_BUFSIZE = 0x21000;
 
+// The largest reads and writes negotiated with FUSE_MAX_PAGES. This is also
+// the largest the Linux kernel allows, 256 pages of 4KiB.
+constexpr size_t kMaxRequestDataSize = 1024 * 1024;
+
+#ifdef __linux__
+// Below this size, copying the data of a read costs less than the extra
+// syscalls needed to splice it.
+constexpr size_t kMinSpliceReadSize = 32 * 1024;
+
+// Splicing the data of a file to a pipe takes one pipe buffer per page it
+// spans, and the fuse_out_header takes one more, so leave some slack.
+constexpr size_t kSplicePipeSlackPages = 3;
+#endif
+
 using Handler = ImmediateFuture<folly::Unit> (FuseChannel::*)(
     FuseRequestContext& request,
     const fuse_in_header& header,
@@ -278,7 +306,7 @@ constexpr auto kFuseHandlers = [] {
 
   // Rely on assignment out of bounds to a constexpr array giving a
   // compiler error.
-  std::array<HandlerEntry, 64> handlers;
+  std::array<HandlerEntry, FuseChannel::kNumLatencyHistograms> handlers;
   handlers[FUSE_LOOKUP] = {
       "FUSE_LOOKUP",
       &FuseChannel::fuseLookup,
@@ -479,7 +507,13 @@ constexpr auto kFuseHandlers = [] {
       &FuseStats::fallocate,
       Write};
 #ifdef __linux__
-  handlers[FUSE_READDIRPLUS] = {"FUSE_READDIRPLUS", Read};
+  handlers[FUSE_READDIRPLUS] = {
+      "FUSE_READDIRPLUS",
+      &FuseChannel::fuseReadDirPlus,
+      &argrender::readdirplus,
+      &FuseStats::readdirplus,
+      Read,
+      SamplingGroup::Three};
   handlers[FUSE_RENAME2] = {"FUSE_RENAME2", Write};
   handlers[FUSE_LSEEK] = {"FUSE_LSEEK"};
   handlers[FUSE_COPY_FILE_RANGE] = {"FUSE_COPY_FILE_RANGE", Write};
@@ -610,6 +644,38 @@ SamplingGroup fuseOpcodeSamplingGroup(uint32_t opcode) {
   return entry ? entry->samplingGroup : SamplingGroup::DropAll;
 }
 
+/**
+ * Dispatch the request to handler once admissionControl admits it.
+ */
+ImmediateFuture<folly::Unit> admitAndDispatch(
+    FuseChannel* channel,
+    FuseAdmissionControl& admissionControl,
+    std::shared_ptr<FuseRequestContext> request,
+    Handler handler,
+    ByteRange arg) {
+  auto pid = static_cast<pid_t>(request->getReq().pid);
+  auto admitted = admissionControl.admit(pid);
+  auto dispatch = [channel, &admissionControl, request, handler, pid](
+                      ByteRange requestArg) {
+    // getReq() throws if the request was replied to, e.g. because it timed
+    // out while waiting to be admitted.
+    return makeImmediateFutureWith([&] {
+             return (channel->*handler)(
+                 *request, request->getReq(), requestArg);
+           })
+        .ensure([&admissionControl, pid] { admissionControl.release(pid); });
+  };
+  if (admitted.isReady()) {
+    return dispatch(arg);
+  }
+  // arg points into the buffer the next request will be read into.
+  return std::move(admitted).thenValue(
+      [dispatch = std::move(dispatch),
+       argCopy = std::string{arg.begin(), arg.end()}](folly::Unit) {
+        return dispatch(ByteRange{StringPiece{argCopy}});
+      });
+}
+
 } // namespace
 
 StringPiece fuseOpcodeName(uint32_t opcode) {
@@ -695,14 +761,17 @@ std::ostream& operator<<(
             << ")";
 }
 
-void FuseChannel::replyError(const fuse_in_header& request, int errorCode) {
+void FuseChannel::replyError(
+    int deviceFd,
+    const fuse_in_header& request,
+    int errorCode) {
   fuse_out_header err;
   err.len = sizeof(err);
   err.error = -errorCode;
   err.unique = request.unique;
   XLOG(DBG7) << "replyError unique=" << err.unique << " error=" << errorCode
              << " " << folly::errnoStr(errorCode);
-  auto res = write(fuseDevice_.fd(), &err, sizeof(err));
+  auto res = write(deviceFd, &err, sizeof(err));
   if (res != sizeof(err)) {
     if (res < 0) {
       throwSystemError("replyError: error writing to fuse device");
@@ -713,6 +782,7 @@ void FuseChannel::replyError(const fuse_in_header& request, int errorCode) {
 }
 
 void FuseChannel::sendReply(
+    int deviceFd,
     const fuse_in_header& request,
     folly::fbvector<iovec>&& vec) const {
   fuse_out_header out;
@@ -721,10 +791,11 @@ void FuseChannel::sendReply(
 
   vec.insert(vec.begin(), make_iovec(out));
 
-  sendRawReply(vec.data(), vec.size());
+  sendRawReply(deviceFd, vec.data(), vec.size());
 }
 
 void FuseChannel::sendReply(
+    int deviceFd,
     const fuse_in_header& request,
     const folly::IOBuf& buf) const {
   fuse_out_header out;
@@ -736,10 +807,11 @@ void FuseChannel::sendReply(
   vec.push_back(make_iovec(out));
   buf.appendToIov(&vec);
 
-  sendRawReply(vec.data(), vec.size());
+  sendRawReply(deviceFd, vec.data(), vec.size());
 }
 
 void FuseChannel::sendReply(
+    int deviceFd,
     const fuse_in_header& request,
     folly::ByteRange bytes) const {
   fuse_out_header out;
@@ -752,10 +824,11 @@ void FuseChannel::sendReply(
   iov[1].iov_base = const_cast<uint8_t*>(bytes.data());
   iov[1].iov_len = bytes.size();
 
-  sendRawReply(iov.data(), iov.size());
+  sendRawReply(deviceFd, iov.data(), iov.size());
 }
 
-void FuseChannel::sendRawReply(const iovec iov[], size_t count) const {
+void FuseChannel::sendRawReply(int deviceFd, const iovec iov[], size_t count)
+    const {
   // Ensure that the length is set correctly
   XDCHECK_EQ(iov[0].iov_len, sizeof(fuse_out_header));
   const auto header = reinterpret_cast<fuse_out_header*>(iov[0].iov_base);
@@ -764,7 +837,7 @@ void FuseChannel::sendRawReply(const iovec iov[], size_t count) const {
     header->len += iov[i].iov_len;
   }
 
-  const auto res = writev(fuseDevice_.fd(), iov, count);
+  const auto res = writev(deviceFd, iov, count);
   const int err = errno;
   XLOG(DBG7) << "sendRawReply: unique=" << header->unique
              << " header->len=" << header->len << " wrote=" << res;
@@ -782,6 +855,67 @@ void FuseChannel::sendRawReply(const iovec iov[], size_t count) const {
   }
 }
 
+#ifdef __linux__
+void FuseChannel::sendSplicedReply(
+    int deviceFd,
+    const fuse_in_header& request,
+    const SplicePipes& pipes,
+    size_t size) const {
+  fuse_out_header out;
+  out.unique = request.unique;
+  out.error = 0;
+  out.len = sizeof(out) + size;
+
+  // The kernel expects the whole reply in a single splice, starting with the
+  // header, so the data is moved after it in the reply pipe.  Moving data
+  // between pipes doesn't copy it.
+  auto res = write(pipes.replyWrite.fd(), &out, sizeof(out));
+  if (res != sizeof(out)) {
+    throwSystemError("error writing to splice pipe");
+  }
+  size_t moved = 0;
+  while (moved < size) {
+    res = splice(
+        pipes.dataRead.fd(),
+        nullptr,
+        pipes.replyWrite.fd(),
+        nullptr,
+        size - moved,
+        SPLICE_F_NONBLOCK);
+    if (res <= 0) {
+      throwSystemError("error splicing between pipes");
+    }
+    moved += res;
+  }
+
+  res = splice(
+      pipes.replyRead.fd(),
+      nullptr,
+      deviceFd,
+      nullptr,
+      out.len,
+      SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  const int err = errno;
+  XLOG(DBG7) << "sendSplicedReply: unique=" << out.unique
+             << " out.len=" << out.len << " wrote=" << res;
+
+  if (res < 0) {
+    if (err == ENOENT) {
+      // Interrupted by a signal, like in sendRawReply().
+    } else if (!isFuseDeviceValid(state_.rlock()->stopReason)) {
+      XLOG(INFO) << "error splicing to fuse device: session closed";
+    } else {
+      XLOG(WARNING) << "error splicing to fuse device: "
+                    << folly::errnoStr(err);
+    }
+    throwSystemErrorExplicit(err, "error splicing to fuse device");
+  }
+  if (static_cast<size_t>(res) != out.len) {
+    throw std::runtime_error("unexpected short splice to FUSE device");
+  }
+}
+#endif
+
 FuseChannel::FuseChannel(
     folly::File&& fuseDevice,
     AbsolutePathPiece mountPath,
@@ -795,8 +929,17 @@ FuseChannel::FuseChannel(
     CaseSensitivity caseSensitive,
     bool requireUtf8Path,
     int32_t maximumBackgroundRequests,
-    bool useWriteBackCache)
-    : bufferSize_(std::max(size_t(getpagesize()) + 0x1000, MIN_BUFSIZE)),
+    bool useWriteBackCache,
+    bool cloneDevice,
+    bool pinWorkerThreads,
+    bool spliceReads,
+    bool readdirPlus,
+    size_t numInvalidationThreads,
+    std::chrono::nanoseconds slowRequestThreshold,
+    std::unique_ptr<FuseAdmissionControl> admissionControl)
+    : bufferSize_(std::max(
+          std::max(size_t(getpagesize()), kMaxRequestDataSize) + 0x1000,
+          MIN_BUFSIZE)),
       numThreads_(numThreads),
       dispatcher_(std::move(dispatcher)),
       straceLogger_(straceLogger),
@@ -807,6 +950,13 @@ FuseChannel::FuseChannel(
       requireUtf8Path_{requireUtf8Path},
       maximumBackgroundRequests_{maximumBackgroundRequests},
       useWriteBackCache_{useWriteBackCache},
+      cloneDevice_{cloneDevice},
+      pinWorkerThreads_{pinWorkerThreads},
+      spliceReads_{spliceReads},
+      readdirPlus_{readdirPlus},
+      numInvalidationThreads_{std::max(size_t(1), numInvalidationThreads)},
+      slowRequestThreshold_{slowRequestThreshold},
+      admissionControl_{std::move(admissionControl)},
       fuseDevice_(std::move(fuseDevice)),
       processAccessLog_(std::move(processNameCache)),
       traceDetailedArguments_(std::make_shared<std::atomic<size_t>>(0)),
@@ -850,6 +1000,7 @@ FuseChannel::FuseChannel(
                   durationNs,
                   fuseOpcodeSamplingGroup(opcode),
                   fuseOpcodeName(opcode),
+                  event.getFetchCost(),
               });
             }
             break;
@@ -901,11 +1052,18 @@ void FuseChannel::startWorkerThreads() {
   }
 
   try {
+    cloneWorkerDevices();
     state->workerThreads.reserve(numThreads_);
     while (state->workerThreads.size() < numThreads_) {
-      state->workerThreads.emplace_back([this] { fuseWorkerThread(); });
+      auto index = state->workerThreads.size();
+      state->workerThreads.emplace_back(
+          [this, index] { fuseWorkerThread(index); });
     }
 
+    if (numInvalidationThreads_ > 1) {
+      invalidationExecutor_ = std::make_unique<UnboundedQueueExecutor>(
+          numInvalidationThreads_ - 1, "FuseInval");
+    }
     invalidationThread_ = std::thread([this] { invalidationThread(); });
   } catch (const std::exception& ex) {
     XLOG(ERR) << "Error starting FUSE worker threads: " << exceptionStr(ex);
@@ -916,6 +1074,44 @@ void FuseChannel::startWorkerThreads() {
   }
 }
 
+void FuseChannel::cloneWorkerDevices() {
+  workerDevices_.resize(numThreads_);
+#ifdef __linux__
+  if (!cloneDevice_) {
+    return;
+  }
+  for (size_t i = 1; i < numThreads_; ++i) {
+    folly::File clone;
+    int fd = open("/dev/fuse", O_RDWR | O_CLOEXEC);
+    if (fd >= 0) {
+      clone = folly::File{fd, /* ownsFd */ true};
+      uint32_t sourceFd = fuseDevice_.fd();
+      if (ioctl(fd, FUSE_DEV_IOC_CLONE, &sourceFd) != 0) {
+        fd = -1;
+      }
+    }
+    if (fd < 0) {
+      // The remaining worker threads share fuseDevice_.
+      XLOG(WARN) << "unable to clone the FUSE device of " << mountPath_
+                 << ": " << folly::errnoStr(errno);
+      return;
+    }
+    workerDevices_[i] = std::move(clone);
+  }
+#endif
+}
+
+int FuseChannel::getWorkerDevice(size_t index) const {
+  if (index < workerDevices_.size() && workerDevices_[index]) {
+    return workerDevices_[index].fd();
+  }
+  return fuseDevice_.fd();
+}
+
+void FuseChannel::pinWorkerThread(size_t index) {
+  NumaTopology::get().pinThreadToCpu(index);
+}
+
 void FuseChannel::destroy() {
   std::vector<std::thread> threads;
   {
@@ -999,7 +1195,7 @@ folly::Future<folly::Unit> FuseChannel::flushInvalidations() {
 /**
  * Send an element from the invalidation queue.
  *
- * This method always runs in the invalidation thread.
+ * This method always runs in one of the invalidation threads.
  */
 void FuseChannel::sendInvalidation(InvalidationEntry& entry) {
   // We catch any exceptions that occur and simply log an error message.
@@ -1040,10 +1236,82 @@ void FuseChannel::sendInvalidation(InvalidationEntry& entry) {
 }
 
 /**
- * Send a FUSE_NOTIFY_INVAL_INODE message to the kernel.
+ * Send the batch of invalidations queued before a flush.
  *
  * This method always runs in the invalidation thread.
  */
+void FuseChannel::sendInvalidationBatch(
+    std::vector<InvalidationEntry>& batch) {
+  // Invalidations only drop what the kernel caches, so sending one twice, or
+  // sending them in a different order, makes no difference until the next
+  // flush.  Checkout commonly invalidates the same directories many times.
+  folly::F14FastSet<InodeNumber> fullyInvalidated;
+  for (const auto& entry : batch) {
+    if (entry.type == InvalidationType::INODE && entry.range.offset == 0 &&
+        entry.range.length == 0) {
+      fullyInvalidated.insert(entry.inode);
+    }
+  }
+  folly::F14FastSet<std::tuple<uint64_t, int64_t, int64_t>> inodeRanges;
+  folly::F14FastSet<std::pair<uint64_t, std::string_view>> dirEntries;
+  std::vector<InvalidationEntry*> toSend;
+  toSend.reserve(batch.size());
+  for (auto& entry : batch) {
+    bool send = false;
+    switch (entry.type) {
+      case InvalidationType::INODE:
+        // Invalidating all of the inode subsumes its other invalidations.
+        if (!fullyInvalidated.count(entry.inode) ||
+            (entry.range.offset == 0 && entry.range.length == 0)) {
+          send = inodeRanges
+                     .emplace(
+                         entry.inode.get(),
+                         entry.range.offset,
+                         entry.range.length)
+                     .second;
+        }
+        break;
+      case InvalidationType::DIR_ENTRY:
+        send = dirEntries.emplace(entry.inode.get(), entry.name.view()).second;
+        break;
+      case InvalidationType::FLUSH:
+        send = true;
+        break;
+    }
+    if (send) {
+      toSend.push_back(&entry);
+    }
+  }
+  XLOG_IF(DBG4, toSend.size() != batch.size())
+      << "sending " << toSend.size() << " invalidations out of "
+      << batch.size() << " queued";
+
+  // The kernel may block each invalidation until it gets the lock of its
+  // inode, so send them from several threads.
+  std::atomic<size_t> next{0};
+  auto sendAll = [&] {
+    for (size_t i = next.fetch_add(1); i < toSend.size();
+         i = next.fetch_add(1)) {
+      sendInvalidation(*toSend[i]);
+    }
+  };
+  std::vector<folly::Future<folly::Unit>> helpers;
+  if (invalidationExecutor_ && toSend.size() > 1) {
+    auto numHelpers = std::min(numInvalidationThreads_, toSend.size()) - 1;
+    helpers.reserve(numHelpers);
+    for (size_t i = 0; i < numHelpers; ++i) {
+      helpers.push_back(folly::via(invalidationExecutor_.get(), sendAll));
+    }
+  }
+  sendAll();
+  folly::collectAll(std::move(helpers)).wait();
+}
+
+/**
+ * Send a FUSE_NOTIFY_INVAL_INODE message to the kernel.
+ *
+ * This method always runs in one of the invalidation threads.
+ */
 void FuseChannel::sendInvalidateInode(
     InodeNumber ino,
     int64_t off,
@@ -1068,7 +1336,7 @@ void FuseChannel::sendInvalidateInode(
   iov[1].iov_len = sizeof(notify);
 
   try {
-    sendRawReply(iov.data(), iov.size());
+    sendRawReply(fuseDevice_.fd(), iov.data(), iov.size());
     XLOG(DBG7) << "sendInvalidateInode(ino=" << ino << ", off=" << off
                << ", len=" << len << ") OK!";
   } catch (const std::system_error& exc) {
@@ -1089,7 +1357,7 @@ void FuseChannel::sendInvalidateInode(
 /**
  * Send a FUSE_NOTIFY_INVAL_ENTRY message to the kernel.
  *
- * This method always runs in the invalidation thread.
+ * This method always runs in one of the invalidation threads.
  */
 void FuseChannel::sendInvalidateEntry(
     InodeNumber parent,
@@ -1127,7 +1395,7 @@ void FuseChannel::sendInvalidateEntry(
   iov[3].iov_len = 1;
 
   try {
-    sendRawReply(iov.data(), iov.size());
+    sendRawReply(fuseDevice_.fd(), iov.data(), iov.size());
   } catch (const std::system_error& exc) {
     // Ignore ENOENT.  This can happen for inode numbers that we allocated on
     // our own and haven't actually told the kernel about yet.
@@ -1241,18 +1509,23 @@ void FuseChannel::initWorkerThread() noexcept {
   initPromise_.setValue(sessionCompletePromise_.getSemiFuture());
 
   // Continue to run like a normal FUSE worker thread.
-  fuseWorkerThread();
+  fuseWorkerThread(0);
 }
 
-void FuseChannel::fuseWorkerThread() noexcept {
+void FuseChannel::fuseWorkerThread(size_t index) noexcept {
   disablePthreadCancellation();
   setThreadName(fmt::format("fuse{}", mountPath_.basename()));
   setThreadSigmask();
+  // Pin the thread before processSession() allocates its read buffer, so that
+  // the buffer is allocated on the NUMA node of its CPU when first touched.
+  if (pinWorkerThreads_) {
+    pinWorkerThread(index);
+  }
   *(liveRequestWatches_.get()) =
       std::make_shared<RequestMetricsScope::LockedRequestWatchList>();
 
   try {
-    processSession();
+    processSession(getWorkerDevice(index));
   } catch (const std::exception& ex) {
     XLOG(ERR) << "unexpected error in FUSE worker thread: " << exceptionStr(ex);
     // Request that all other FUSE threads exit.
@@ -1313,10 +1586,19 @@ void FuseChannel::invalidationThread() noexcept {
       lockedQueue->queue.swap(entries);
     }
 
-    // Process all of the entries we found
+    // Process all of the entries we found, each flush once all the
+    // invalidations queued before it were sent.
+    std::vector<InvalidationEntry> batch;
     for (auto& entry : entries) {
-      sendInvalidation(entry);
+      if (entry.type == InvalidationType::FLUSH) {
+        sendInvalidationBatch(batch);
+        batch.clear();
+        sendInvalidation(entry);
+      } else {
+        batch.push_back(std::move(entry));
+      }
     }
+    sendInvalidationBatch(batch);
     entries.clear();
   }
 }
@@ -1331,6 +1613,7 @@ void FuseChannel::stopInvalidationThread() {
   invalidationQueue_.lock()->stop = true;
   invalidationCV_.notify_one();
   invalidationThread_.join();
+  invalidationExecutor_.reset();
 }
 
 void FuseChannel::readInitPacket() {
@@ -1399,7 +1682,7 @@ void FuseChannel::readInitPacket() {
   }
 
   if (init.header.opcode != FUSE_INIT) {
-    replyError(init.header, EPROTO);
+    replyError(fuseDevice_.fd(), init.header, EPROTO);
     throw_<std::runtime_error>(
         "expected to receive FUSE_INIT for \"",
         mountPath_,
@@ -1415,6 +1698,12 @@ void FuseChannel::readInitPacket() {
   connInfo.minor = init.init.minor;
   connInfo.max_write = bufferSize_ - 4096;
   connInfo.max_readahead = init.init.max_readahead;
+#ifdef __linux__
+  // Only used with FUSE_MAX_PAGES, without which reads and writes are at most
+  // 32 pages.
+  connInfo.max_pages = static_cast<uint16_t>(
+      std::max(size_t(1), kMaxRequestDataSize / getpagesize()));
+#endif
 
   int32_t max_background = maximumBackgroundRequests_;
   if (max_background > 65535) {
@@ -1433,10 +1722,6 @@ void FuseChannel::readInitPacket() {
   const auto capable = init.init.flags;
   auto& want = connInfo.flags;
 
-  // TODO: follow up and look at the new flags; particularly
-  // FUSE_DO_READDIRPLUS, FUSE_READDIRPLUS_AUTO. FUSE_SPLICE_XXX are interesting
-  // too, but may not directly benefit eden today.
-  //
   // FUSE_ATOMIC_O_TRUNC is a nice optimization when the kernel supports it
   // and the FUSE daemon requires handling open/release for stateful file
   // handles. But FUSE_NO_OPEN_SUPPORT is superior, so edenfs has no need for
@@ -1459,6 +1744,23 @@ void FuseChannel::readInitPacket() {
   want |= FUSE_CACHE_SYMLINKS;
   // We can handle almost any request in parallel.
   want |= FUSE_PARALLEL_DIROPS;
+  // Our buffers fit reads and writes of up to max_pages pages.
+  want |= FUSE_MAX_PAGES;
+  if (readdirPlus_) {
+    // Reply to readdir with the attributes of the entries, saving a lookup
+    // per entry to the tools that go on to stat them. With
+    // FUSE_READDIRPLUS_AUTO, the kernel only asks for them when it sees such
+    // lookups, since they require loading all the entries' inodes.
+    want |= FUSE_DO_READDIRPLUS | FUSE_READDIRPLUS_AUTO;
+  }
+  if (spliceReads_) {
+    // We may splice the replies to reads into the fuse device, and let the
+    // kernel move the spliced pages instead of copying them when it can.
+    // Requests are not spliced out of the fuse device: writes are buffered
+    // and journaled asynchronously, so their data has to be copied out of the
+    // worker thread's buffer anyway.
+    want |= FUSE_SPLICE_WRITE | FUSE_SPLICE_MOVE;
+  }
 #endif
 
 #ifdef FUSE_WRITEBACK_CACHE
@@ -1500,7 +1802,7 @@ void FuseChannel::readInitPacket() {
              << ", want=" << capsFlagsToLabel(want);
 
   if (init.init.major != FUSE_KERNEL_VERSION) {
-    replyError(init.header, EPROTO);
+    replyError(fuseDevice_.fd(), init.header, EPROTO);
     throw_<std::runtime_error>(
         "Unsupported FUSE kernel version ",
         init.init.major,
@@ -1525,12 +1827,13 @@ void FuseChannel::readInitPacket() {
       FUSE_KERNEL_MINOR_VERSION > 22,
       "Your kernel headers are too old to build Eden.");
   if (init.init.minor > 22) {
-    sendReply(init.header, connInfo);
+    sendReply(fuseDevice_.fd(), init.header, connInfo);
   } else {
     // If the protocol version predates the expansion of fuse_init_out, only
     // send the start of the packet.
     static_assert(FUSE_COMPAT_22_INIT_OUT_SIZE <= sizeof(connInfo));
     sendReply(
+        fuseDevice_.fd(),
         init.header,
         ByteRange{
             reinterpret_cast<const uint8_t*>(&connInfo),
@@ -1541,14 +1844,19 @@ void FuseChannel::readInitPacket() {
       FUSE_KERNEL_MINOR_VERSION == 19,
       "osxfuse: API/ABI likely changed, may need something like the"
       " linux code above to send the correct response to the kernel");
-  sendReply(init.header, connInfo);
+  sendReply(fuseDevice_.fd(), init.header, connInfo);
 #endif
 
   dispatcher_->initConnection(connInfo);
 }
 
-void FuseChannel::processSession() {
-  std::vector<char> buf(bufferSize_);
+void FuseChannel::processSession(int deviceFd) {
+  // The fuse device may have been taken over from a process which negotiated
+  // larger writes.
+  std::vector<char> buf(std::max(
+      bufferSize_, static_cast<size_t>(connInfo_->max_write) + 4096));
+  // The requests read by this thread are allocated from it.
+  RequestArena arena;
   // Save this for the sanity check later in the loop to avoid
   // additional syscalls on each loop iteration.
   auto myPid = getpid();
@@ -1556,7 +1864,7 @@ void FuseChannel::processSession() {
   while (!stop_.load(std::memory_order_relaxed)) {
     // TODO: FUSE_SPLICE_READ allows using splice(2) here if we enable it.
     // We can look at turning this on once the main plumbing is complete.
-    auto res = read(fuseDevice_.fd(), buf.data(), buf.size());
+    auto res = read(deviceFd, buf.data(), buf.size());
     if (UNLIKELY(res < 0)) {
       int error = errno;
       if (stop_.load(std::memory_order_relaxed)) {
@@ -1642,7 +1950,7 @@ void FuseChannel::processSession() {
       bool matched = false;
       for (auto fastTrack : kFastTracks) {
         if (namePiece == fastTrack) {
-          replyError(*header, ENODATA);
+          replyError(deviceFd, *header, ENODATA);
           matched = true;
           break;
         }
@@ -1661,7 +1969,7 @@ void FuseChannel::processSession() {
     // to resolve this deadlock on kernel inode locks without rebooting the
     // system.
     if (UNLIKELY(static_cast<pid_t>(header->pid) == myPid)) {
-      replyError(*header, EIO);
+      replyError(deviceFd, *header, EIO);
       XLOG(CRITICAL) << "Received FUSE request from our own pid: opcode="
                      << header->opcode << " nodeid=" << header->nodeid
                      << " pid=" << header->pid;
@@ -1675,7 +1983,7 @@ void FuseChannel::processSession() {
 
     switch (header->opcode) {
       case FUSE_INIT:
-        replyError(*header, EPROTO);
+        replyError(deviceFd, *header, EPROTO);
         throw std::runtime_error(
             "received FUSE_INIT after we have been initialized!?");
 
@@ -1685,7 +1993,7 @@ void FuseChannel::processSession() {
         // Deliberately not handling locking; this causes
         // the kernel to do it for us
         XLOG(DBG7) << fuseOpcodeName(header->opcode);
-        replyError(*header, ENOSYS);
+        replyError(deviceFd, *header, ENOSYS);
         break;
 
 #ifdef __linux__
@@ -1694,23 +2002,38 @@ void FuseChannel::processSession() {
         // for us.  Returning ENOSYS causes the kernel to implement it for us,
         // and will cause it to stop sending subsequent FUSE_LSEEK requests.
         XLOG(DBG7) << "FUSE_LSEEK";
-        replyError(*header, ENOSYS);
+        replyError(deviceFd, *header, ENOSYS);
         break;
 #endif
 
       case FUSE_POLL:
         // We do not currently implement FUSE_POLL.
         XLOG(DBG7) << "FUSE_POLL";
-        replyError(*header, ENOSYS);
+        replyError(deviceFd, *header, ENOSYS);
         break;
 
       case FUSE_INTERRUPT: {
         // no reply is required
         XLOG(DBG7) << "FUSE_INTERRUPT";
-        // Ignore it: we don't have a reliable way to guarantee
-        // that interrupting functions correctly.
-        // In addition, the kernel (certainly on macOS) may recycle
-        // ids too quickly for us to safely track by `unique` id.
+#ifdef __linux__
+        // The request keeps running, but the imports it is the only one to
+        // wait on are dropped, and it then fails with EINTR.
+        auto unique = FuseArg{arg}.read<fuse_interrupt_in>().unique;
+        std::shared_ptr<FuseRequestContext> interrupted;
+        {
+          auto liveRequests = liveRequests_.rlock();
+          auto it = liveRequests->find(unique);
+          if (it != liveRequests->end()) {
+            interrupted = it->second.lock();
+          }
+        }
+        if (interrupted) {
+          interrupted->interrupt();
+        }
+#else
+        // Ignore it: the kernel on macOS may recycle ids too quickly for us
+        // to safely track by `unique` id.
+#endif
         break;
       }
 
@@ -1722,7 +2045,7 @@ void FuseChannel::processSession() {
         // we have responded, which in turn blocks our attempt to gracefully
         // unmount, so we respond here.  It doesn't hurt Linux to respond
         // so we do it for both platforms.
-        replyError(*header, 0);
+        replyError(deviceFd, *header, 0);
         break;
 
       case FUSE_NOTIFY_REPLY:
@@ -1735,7 +2058,7 @@ void FuseChannel::processSession() {
       case FUSE_IOCTL:
         // Rather than the default ENOSYS, we need to return ENOTTY
         // to indicate that the requested ioctl is not supported
-        replyError(*header, ENOTTY);
+        replyError(deviceFd, *header, ENOTTY);
         break;
 
       default: {
@@ -1752,9 +2075,17 @@ void FuseChannel::processSession() {
           // This is a shared_ptr because, due to timeouts, the internal request
           // lifetime may not match the FUSE request lifetime, so we capture it
           // in both. I'm sure this could be improved with some cleverness.
-          auto request = std::make_shared<FuseRequestContext>(this, *header);
+          auto request = std::allocate_shared<FuseRequestContext>(
+              RequestArena::Allocator<FuseRequestContext>{arena},
+              this,
+              *header,
+              deviceFd,
+              arena);
 
           ++state_.wlock()->pendingRequests;
+#ifdef __linux__
+          liveRequests_.wlock()->insert_or_assign(header->unique, request);
+#endif
 
           auto headerCopy = *header;
 
@@ -1778,16 +2109,36 @@ void FuseChannel::processSession() {
                         dispatcher_->getStats(),
                         handlerEntry->stat,
                         *(liveRequestWatches_.get()));
-                    return (this->*handlerEntry->handler)(
-                               *request, request->getReq(), arg)
+                    if (!admissionControl_) {
+                      return (this->*handlerEntry->handler)(
+                                 *request, request->getReq(), arg)
+                          .semi()
+                          .via(&folly::QueuedImmediateExecutor::instance());
+                    }
+                    return admitAndDispatch(
+                               this,
+                               *admissionControl_,
+                               request,
+                               handlerEntry->handler,
+                               arg)
                         .semi()
                         .via(&folly::QueuedImmediateExecutor::instance());
                   }).ensure([request] {
                     }).within(requestTimeout_),
                   notifier_.get())
               .ensure([this, request, requestId, headerCopy] {
-                traceBus_->publish(FuseTraceEvent::finish(
-                    requestId, headerCopy, request->getResult()));
+#ifdef __linux__
+                {
+                  // The unique may already be reused once replied to.
+                  auto liveRequests = liveRequests_.wlock();
+                  auto it = liveRequests->find(headerCopy.unique);
+                  if (it != liveRequests->end() &&
+                      it->second.lock() == request) {
+                    liveRequests->erase(it);
+                  }
+                }
+#endif
+                recordLatency(*request, requestId, headerCopy);
 
                 // We may be complete; check to see if all requests are
                 // done and whether there are any threads remaining.
@@ -1819,7 +2170,7 @@ void FuseChannel::processSession() {
             });
 
         try {
-          replyError(*header, ENOSYS);
+          replyError(deviceFd, *header, ENOSYS);
         } catch (const std::system_error& exc) {
           XLOG(ERR) << "Failed to write error response to fuse: " << exc.what();
           requestSessionExit(StopReason::FUSE_WRITE_ERROR);
@@ -1843,6 +2194,9 @@ void FuseChannel::sessionComplete(folly::Synchronized<State>::LockedPtr state) {
     data.fuseDevice = std::move(fuseDevice_);
     data.fuseSettings = connInfo_.value();
   }
+  // No worker thread reads the clones anymore, and the requests read from
+  // them were all replied to.
+  workerDevices_.clear();
 
   // Unlock the state before the remaining steps
   state.unlock();
@@ -1870,11 +2224,130 @@ ImmediateFuture<folly::Unit> FuseChannel::fuseRead(
   XLOG(DBG7) << "FUSE_READ";
 
   auto ino = InodeNumber{header.nodeid};
+#ifdef __linux__
+  if (shouldSpliceRead(read->size)) {
+    if (auto pipes = takeSplicePipes(read->size)) {
+      return spliceRead(
+          request, ino, read->size, read->offset, std::move(*pipes));
+    }
+  }
+#endif
   return dispatcher_
       ->read(ino, read->size, read->offset, request.getObjectFetchContext())
-      .thenValue([&request](BufVec&& buf) { request.sendReply(*buf); });
+      .thenValue([&request](BufVec&& buf) {
+        request.setBytesRead(buf->computeChainDataLength());
+        request.sendReply(*buf);
+      });
 }
 
+#ifdef __linux__
+bool FuseChannel::shouldSpliceRead(size_t size) const {
+  // The kernel offers FUSE_SPLICE_WRITE when it accepts replies spliced into
+  // the fuse device.
+  return spliceReads_ && (connInfo_->flags & FUSE_SPLICE_WRITE) &&
+      size >= kMinSpliceReadSize;
+}
+
+std::optional<FuseChannel::SplicePipes> FuseChannel::takeSplicePipes(
+    size_t size) {
+  const size_t pageSize = getpagesize();
+  const size_t needed = size + kSplicePipeSlackPages * pageSize;
+  {
+    auto pool = splicePipes_.lock();
+    if (!pool->empty()) {
+      if (pool->back().capacity < needed) {
+        // The pipes couldn't be grown as large, new ones wouldn't either.
+        return std::nullopt;
+      }
+      auto pipes = std::move(pool->back());
+      pool->pop_back();
+      return pipes;
+    }
+  }
+
+  SplicePipes pipes;
+  size_t capacity = std::numeric_limits<size_t>::max();
+  for (auto [readEnd, writeEnd] :
+       {std::pair{&pipes.dataRead, &pipes.dataWrite},
+        std::pair{&pipes.replyRead, &pipes.replyWrite}}) {
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC | O_NONBLOCK) != 0) {
+      XLOG_EVERY_MS(WARN, 10000)
+          << "unable to create pipe to splice FUSE replies: "
+          << folly::errnoStr(errno);
+      return std::nullopt;
+    }
+    *readEnd = folly::File{fds[0], /* ownsFd */ true};
+    *writeEnd = folly::File{fds[1], /* ownsFd */ true};
+    // The default of 64KiB is too small for the largest reads.  Growing the
+    // pipe fails when over /proc/sys/fs/pipe-max-size, so try smaller sizes
+    // until it succeeds, leaving larger reads to be copied.
+    for (size_t size = 2 * bufferSize_;
+         size > 64 * 1024 &&
+         fcntl(fds[1], F_SETPIPE_SZ, static_cast<int>(size)) < 0;
+         size /= 2) {
+    }
+    int pipeSize = fcntl(fds[1], F_GETPIPE_SZ);
+    if (pipeSize < 0) {
+      return std::nullopt;
+    }
+    capacity = std::min(capacity, static_cast<size_t>(pipeSize));
+  }
+  pipes.capacity = capacity;
+  if (pipes.capacity < needed) {
+    returnSplicePipes(std::move(pipes));
+    return std::nullopt;
+  }
+  return pipes;
+}
+
+void FuseChannel::returnSplicePipes(SplicePipes&& pipes) {
+  auto pool = splicePipes_.lock();
+  if (pool->size() < numThreads_) {
+    pool->push_back(std::move(pipes));
+  }
+}
+
+ImmediateFuture<folly::Unit> FuseChannel::spliceRead(
+    FuseRequestContext& request,
+    InodeNumber ino,
+    size_t size,
+    off_t offset,
+    SplicePipes&& pipes) {
+  auto pipeFd = pipes.dataWrite.fd();
+  return dispatcher_
+      ->spliceRead(ino, size, offset, pipeFd, request.getObjectFetchContext())
+      .thenTry(
+          [this, &request, ino, size, offset, pipes = std::move(pipes)](
+              folly::Try<std::optional<size_t>>&& spliced) mutable
+          -> ImmediateFuture<folly::Unit> {
+            if (spliced.hasValue() && spliced->has_value()) {
+              // If this throws, the pipes may hold part of the reply and
+              // are closed instead of being reused.
+              request.sendSplicedReply(pipes, **spliced);
+              request.setBytesRead(**spliced);
+              returnSplicePipes(std::move(pipes));
+              return folly::unit;
+            }
+            if (spliced.hasException()) {
+              // The pipes may hold part of the data, so they are closed.
+              // read() succeeds if only splicing failed, and reports the
+              // error otherwise.
+              XLOG(DBG3) << "unable to splice read of inode " << ino << ": "
+                         << spliced.exception().what();
+            } else {
+              returnSplicePipes(std::move(pipes));
+            }
+            return dispatcher_
+                ->read(ino, size, offset, request.getObjectFetchContext())
+                .thenValue([&request](BufVec&& buf) {
+                  request.setBytesRead(buf->computeChainDataLength());
+                  request.sendReply(*buf);
+                });
+          });
+}
+#endif
+
 ImmediateFuture<folly::Unit> FuseChannel::fuseWrite(
     FuseRequestContext& request,
     const fuse_in_header& header,
@@ -2160,6 +2633,10 @@ ImmediateFuture<folly::Unit> FuseChannel::fuseOpen(
   auto ino = InodeNumber{header.nodeid};
   return dispatcher_->open(ino, open->flags).thenValue([&request](uint64_t fh) {
     fuse_open_out out = {};
+    // FOPEN_PASSTHROUGH is not an option for materialized files: the kernel
+    // would map the file offsets to the same offsets of the overlay file, whose
+    // contents start after a header, and EdenFS wouldn't see the writes it has
+    // to record in the journal.
     out.open_flags |= FOPEN_KEEP_CACHE;
     out.fh = fh;
     request.sendReply(out);
@@ -2351,6 +2828,28 @@ ImmediateFuture<folly::Unit> FuseChannel::fuseReadDir(
       });
 }
 
+#ifdef __linux__
+ImmediateFuture<folly::Unit> FuseChannel::fuseReadDirPlus(
+    FuseRequestContext& request,
+    const fuse_in_header& header,
+    ByteRange arg) {
+  auto read = reinterpret_cast<const fuse_read_in*>(arg.data());
+  XLOG(DBG7) << "FUSE_READDIRPLUS";
+  auto ino = InodeNumber{header.nodeid};
+  return dispatcher_
+      ->readdirplus(
+          ino,
+          FuseDirPlusList{read->size},
+          read->offset,
+          read->fh,
+          request.getObjectFetchContext())
+      .thenValue([&request](FuseDirPlusList&& list) {
+        const auto buf = list.getBuf();
+        request.sendReply(StringPiece{buf});
+      });
+}
+#endif
+
 ImmediateFuture<folly::Unit> FuseChannel::fuseReleaseDir(
     FuseRequestContext& request,
     const fuse_in_header& header,
@@ -2499,6 +2998,47 @@ size_t FuseChannel::getRequestMetric(
   return RequestMetricsScope::aggregateMetricCounters(metric, counters);
 }
 
+void FuseChannel::recordLatency(
+    const FuseRequestContext& request,
+    uint64_t requestId,
+    const fuse_in_header& header) {
+  auto elapsed = request.getElapsedTime();
+  if (header.opcode < latencyHistograms_.size()) {
+    latencyHistograms_[header.opcode].record(elapsed);
+  }
+
+  auto& fetchContext = request.getFsObjectFetchContext();
+  if (slowRequestThreshold_.count() == 0 || elapsed < slowRequestThreshold_) {
+    traceBus_->publish(FuseTraceEvent::finish(
+        requestId,
+        header,
+        request.getResult(),
+        fetchContext.getFetchCost()));
+    return;
+  }
+  slowRequestCount_.fetch_add(1, std::memory_order_relaxed);
+  auto backingStoreDuration =
+      fetchContext.getEdenTopStats().getBackingStoreDuration();
+  traceBus_->publish(FuseTraceEvent::finishSlow(
+      requestId,
+      header,
+      request.getResult(),
+      FuseTraceEvent::SlowRequest{
+          std::chrono::duration_cast<std::chrono::microseconds>(elapsed),
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              backingStoreDuration)},
+      fetchContext.getFetchCost()));
+}
+
+const LatencyHistogram* FuseChannel::getLatencyHistogram(
+    uint32_t opcode) const {
+  auto* entry = lookupFuseHandlerEntry(opcode);
+  if (!entry || !entry->handler || opcode >= latencyHistograms_.size()) {
+    return nullptr;
+  }
+  return &latencyHistograms_[opcode];
+}
+
 } // namespace facebook::eden
 
 #endif
@@ -14,9 +14,13 @@
 #include <folly/futures/Promise.h>
 #include <folly/synchronization/CallOnce.h>
 #include <stdlib.h>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <iosfwd>
 #include <memory>
+#include <mutex>
 #include <optional>
 #include <stdexcept>
 #include <thread>
@@ -26,10 +30,12 @@
 
 #include "eden/fs/fuse/FuseDispatcher.h"
 #include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/telemetry/FetchCost.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/telemetry/TraceBus.h"
 #include "eden/fs/utils/CaseSensitivity.h"
 #include "eden/fs/utils/FsChannelTypes.h"
+#include "eden/fs/utils/LatencyHistogram.h"
 #include "eden/fs/utils/PathFuncs.h"
 #include "eden/fs/utils/ProcessAccessLog.h"
 
@@ -45,7 +51,9 @@ namespace facebook::eden {
 
 class Notifier;
 class FsEventLogger;
+class FuseAdmissionControl;
 class FuseRequestContext;
+class UnboundedQueueExecutor;
 
 #ifndef _WIN32
 
@@ -75,6 +83,16 @@ struct FuseTraceEvent : TraceEventBase {
     uint32_t pid;
   };
 
+  /**
+   * Where the time of a request that took longer than the slow request
+   * threshold went. The remainder of the duration was spent in the
+   * dispatcher, or waiting for the kernel.
+   */
+  struct SlowRequest {
+    std::chrono::microseconds duration;
+    std::chrono::microseconds backingStoreDuration;
+  };
+
   FuseTraceEvent() = delete;
 
   static FuseTraceEvent start(uint64_t unique, const fuse_in_header& request) {
@@ -93,8 +111,32 @@ struct FuseTraceEvent : TraceEventBase {
   static FuseTraceEvent finish(
       uint64_t unique,
       const fuse_in_header& request,
-      std::optional<int64_t> result) {
-    return FuseTraceEvent{unique, request, FinishDetails{result}};
+      std::optional<int64_t> result,
+      const FetchCost& fetchCost) {
+    return FuseTraceEvent{
+        unique,
+        request,
+        FinishDetails{
+            result,
+            fetchCost.empty()
+                ? nullptr
+                : std::make_unique<const FinishCosts>(
+                      FinishCosts{std::nullopt, fetchCost})}};
+  }
+
+  static FuseTraceEvent finishSlow(
+      uint64_t unique,
+      const fuse_in_header& request,
+      std::optional<int64_t> result,
+      const SlowRequest& slowRequest,
+      const FetchCost& fetchCost) {
+    return FuseTraceEvent{
+        unique,
+        request,
+        FinishDetails{
+            result,
+            std::make_unique<const FinishCosts>(
+                FinishCosts{slowRequest, fetchCost})}};
   }
 
   Type getType() const {
@@ -118,6 +160,23 @@ struct FuseTraceEvent : TraceEventBase {
     return std::get<FinishDetails>(details_).result;
   }
 
+  /**
+   * Set on the FINISH events of the requests that took longer than the slow
+   * request threshold.
+   */
+  std::optional<SlowRequest> getSlowRequest() const {
+    auto& costs = std::get<FinishDetails>(details_).costs;
+    return costs ? costs->slowRequest : std::nullopt;
+  }
+
+  /**
+   * Where the objects fetched by the request of a FINISH event came from.
+   */
+  FetchCost getFetchCost() const {
+    auto& costs = std::get<FinishDetails>(details_).costs;
+    return costs ? costs->fetchCost : FetchCost{};
+  }
+
  private:
   struct StartDetails {
     /**
@@ -133,6 +192,11 @@ struct FuseTraceEvent : TraceEventBase {
     std::unique_ptr<std::string> arguments;
   };
 
+  struct FinishCosts {
+    std::optional<SlowRequest> slowRequest;
+    FetchCost fetchCost;
+  };
+
   struct FinishDetails {
     /**
      * If set, a response code was sent to the kernel.
@@ -144,6 +208,12 @@ struct FuseTraceEvent : TraceEventBase {
      * inode, result will contain fuse_entry_out::nodeid.
      */
     std::optional<int64_t> result;
+
+    /**
+     * Only allocated for the requests that were slow or fetched objects, to
+     * keep the events in the TraceBus small.
+     */
+    std::unique_ptr<const FinishCosts> costs;
   };
 
   using Details = std::variant<StartDetails, FinishDetails>;
@@ -208,6 +278,22 @@ class FuseChannel {
   };
   using StopFuture = folly::SemiFuture<StopData>;
 
+#ifdef __linux__
+  /**
+   * The pipes the replies to large reads are spliced through: the data is
+   * spliced into the data pipe, then after the fuse_out_header into the reply
+   * pipe, which is spliced into the fuse device.  Both are non-blocking.
+   */
+  struct SplicePipes {
+    folly::File dataRead;
+    folly::File dataWrite;
+    folly::File replyRead;
+    folly::File replyWrite;
+    // The number of bytes of data both pipes are known to have room for.
+    size_t capacity{0};
+  };
+#endif
+
   struct OutstandingRequest {
     uint64_t unique;
     FuseTraceEvent::RequestHeader request;
@@ -224,6 +310,19 @@ class FuseChannel {
    * The caller is expected to follow up with a call to the
    * initialize() method to perform the handshake with the
    * kernel and set up the thread pool.
+   *
+   * With cloneDevice, each worker thread reads the requests from its own
+   * clone of fuseDevice (see FUSE_DEV_IOC_CLONE) instead of all of them
+   * contending on fuseDevice.  With pinWorkerThreads, each worker thread is
+   * pinned to one of the CPUs the process may run on, the workers being
+   * spread over the NUMA nodes.  With spliceReads,
+   * the data of reads from materialized files is spliced to the kernel
+   * instead of being copied through userspace, when the kernel supports it.
+   * With readdirPlus, the kernel may ask for the attributes of the entries
+   * along with directory listings.  Invalidations are sent to the kernel by
+   * numInvalidationThreads threads.  Requests that take at least
+   * slowRequestThreshold are reported as slow on the TraceBus, 0 disables
+   * this.  If set, admissionControl decides when each request is dispatched.
    */
   FuseChannel(
       folly::File&& fuseDevice,
@@ -238,7 +337,14 @@ class FuseChannel {
       CaseSensitivity caseSensitive,
       bool requireUtf8Path,
       int32_t maximumBackgroundRequests,
-      bool useWriteBackCache);
+      bool useWriteBackCache,
+      bool cloneDevice = false,
+      bool pinWorkerThreads = false,
+      bool spliceReads = false,
+      bool readdirPlus = false,
+      size_t numInvalidationThreads = 1,
+      std::chrono::nanoseconds slowRequestThreshold = std::chrono::seconds{1},
+      std::unique_ptr<FuseAdmissionControl> admissionControl = nullptr);
 
   /**
    * Destroy the FuseChannel.
@@ -364,10 +470,13 @@ class FuseChannel {
    * status (no additional payload).
    * `err` may be 0 (indicating success) or a positive errno value.
    *
+   * Replies must be written to deviceFd, the fuse device the request was read
+   * from: the kernel only looks up the requests read from the same device.
+   *
    * throws system_error if the write fails.  Writes can fail if the
    * data we send to the kernel is invalid.
    */
-  void replyError(const fuse_in_header& request, int err);
+  void replyError(int deviceFd, const fuse_in_header& request, int err);
 
   /**
    * Sends a raw data packet to the kernel.
@@ -380,7 +489,7 @@ class FuseChannel {
    * throws system_error if the write fails.  Writes can fail if the
    * data we send to the kernel is invalid.
    */
-  void sendRawReply(const iovec iov[], size_t count) const;
+  void sendRawReply(int deviceFd, const iovec iov[], size_t count) const;
 
   /**
    * Sends a range of contiguous bytes as a reply to the kernel.
@@ -391,11 +500,16 @@ class FuseChannel {
    * throws system_error if the write fails.  Writes can fail if the
    * data we send to the kernel is invalid.
    */
-  void sendReply(const fuse_in_header& request, folly::ByteRange bytes) const;
+  void sendReply(
+      int deviceFd,
+      const fuse_in_header& request,
+      folly::ByteRange bytes) const;
 
-  void sendReply(const fuse_in_header& request, folly::StringPiece bytes)
-      const {
-    sendReply(request, folly::ByteRange{bytes});
+  void sendReply(
+      int deviceFd,
+      const fuse_in_header& request,
+      folly::StringPiece bytes) const {
+    sendReply(deviceFd, request, folly::ByteRange{bytes});
   }
 
   /**
@@ -407,8 +521,10 @@ class FuseChannel {
    * throws system_error if the write fails.  Writes can fail if the
    * data we send to the kernel is invalid.
    */
-  void sendReply(const fuse_in_header& request, folly::fbvector<iovec>&& vec)
-      const;
+  void sendReply(
+      int deviceFd,
+      const fuse_in_header& request,
+      folly::fbvector<iovec>&& vec) const;
 
   /**
    * Sends a reply to a kernel request potentially consisting of multiple
@@ -417,7 +533,10 @@ class FuseChannel {
    * throws system_error if the write fails.  Writes can fail if the
    * data we send to the kernel is invalid.
    */
-  void sendReply(const fuse_in_header& request, const folly::IOBuf& buf) const;
+  void sendReply(
+      int deviceFd,
+      const fuse_in_header& request,
+      const folly::IOBuf& buf) const;
 
   /**
    * Sends a reply to the kernel.
@@ -428,15 +547,32 @@ class FuseChannel {
    * data we send to the kernel is invalid.
    */
   template <typename T>
-  void sendReply(const fuse_in_header& request, const T& payload) const {
+  void sendReply(int deviceFd, const fuse_in_header& request, const T& payload)
+      const {
     static_assert(std::is_standard_layout_v<T>);
     static_assert(std::is_trivial_v<T>);
     sendReply(
+        deviceFd,
         request,
         folly::ByteRange{
             reinterpret_cast<const uint8_t*>(&payload), sizeof(T)});
   }
 
+#ifdef __linux__
+  /**
+   * Sends the reply to a read request whose size bytes of data are in the data
+   * pipe of pipes, splicing them to the kernel.
+   *
+   * throws system_error if a splice fails, in which case the pipes may still
+   * hold part of the reply.
+   */
+  void sendSplicedReply(
+      int deviceFd,
+      const fuse_in_header& request,
+      const SplicePipes& pipes,
+      size_t size) const;
+#endif
+
   /**
    * Returns the approximate number of outstanding FUSE requests. Since
    * telemetry is tracked on a background thread, this number may very slightly
@@ -467,6 +603,24 @@ class FuseChannel {
 
   size_t getRequestMetric(RequestMetricsScope::RequestMetric metric) const;
 
+  /**
+   * Opcodes from kNumLatencyHistograms on have no handler.
+   */
+  static constexpr uint32_t kNumLatencyHistograms = 64;
+
+  /**
+   * The latencies of the requests with the given opcode handled so far, or
+   * nullptr if there is no handler for it.
+   */
+  const LatencyHistogram* getLatencyHistogram(uint32_t opcode) const;
+
+  /**
+   * The number of requests that took at least the slow request threshold.
+   */
+  uint64_t getSlowRequestCount() const {
+    return slowRequestCount_.load(std::memory_order_relaxed);
+  }
+
  private:
   /**
    * All of our mutable state that may be accessed from the worker threads,
@@ -665,6 +819,12 @@ class FuseChannel {
       FuseRequestContext& request,
       const fuse_in_header& header,
       folly::ByteRange arg);
+#ifdef __linux__
+  ImmediateFuture<folly::Unit> fuseReadDirPlus(
+      FuseRequestContext& request,
+      const fuse_in_header& header,
+      folly::ByteRange arg);
+#endif
   ImmediateFuture<folly::Unit> fuseReleaseDir(
       FuseRequestContext& request,
       const fuse_in_header& header,
@@ -697,15 +857,78 @@ class FuseChannel {
  private:
   void setThreadSigmask();
   void initWorkerThread() noexcept;
-  void fuseWorkerThread() noexcept;
+  void fuseWorkerThread(size_t index) noexcept;
   void invalidationThread() noexcept;
   void stopInvalidationThread();
   void sendInvalidation(InvalidationEntry& entry);
+
+  /**
+   * Send a batch of invalidations queued between two flushes, each only once,
+   * spread across the invalidation threads.  Returns once all were sent.
+   */
+  void sendInvalidationBatch(std::vector<InvalidationEntry>& batch);
   void sendInvalidateInode(InodeNumber ino, int64_t off, int64_t len);
   void sendInvalidateEntry(InodeNumber parent, PathComponentPiece name);
   void readInitPacket();
   void startWorkerThreads();
 
+  /**
+   * Fill workerDevices_ with a clone of fuseDevice_ for each worker thread
+   * but the first one, if the kernel supports it.
+   */
+  void cloneWorkerDevices();
+
+  /**
+   * The fuse device the worker thread index reads its requests from.
+   */
+  int getWorkerDevice(size_t index) const;
+
+  /**
+   * Pin the calling worker thread to a CPU, picked by its index among the
+   * CPUs the process may run on: consecutive workers go to different NUMA
+   * nodes, so that each node gets its share of the workers and of their
+   * device clones and buffers.
+   */
+  static void pinWorkerThread(size_t index);
+
+#ifdef __linux__
+  /**
+   * Whether the reply to a read of size bytes should be spliced.
+   */
+  bool shouldSpliceRead(size_t size) const;
+
+  /**
+   * Take empty pipes with room for size bytes from splicePipes_, creating
+   * them if there are none.  Returns std::nullopt if they can't be created.
+   */
+  std::optional<SplicePipes> takeSplicePipes(size_t size);
+
+  /**
+   * Put back empty pipes into splicePipes_.
+   */
+  void returnSplicePipes(SplicePipes&& pipes);
+
+  /**
+   * Reply to a read by splicing its data through pipes, falling back to
+   * FuseDispatcher::read() when the dispatcher can't splice it.
+   */
+  ImmediateFuture<folly::Unit> spliceRead(
+      FuseRequestContext& request,
+      InodeNumber ino,
+      size_t size,
+      off_t offset,
+      SplicePipes&& pipes);
+#endif
+
+  /**
+   * Record the latency of a completed request and publish its FINISH event,
+   * reporting it as slow if it took at least slowRequestThreshold_.
+   */
+  void recordLatency(
+      const FuseRequestContext& request,
+      uint64_t requestId,
+      const fuse_in_header& header);
+
   /**
    * sessionComplete() will fulfill the sessionCompletePromise_.
    *
@@ -731,9 +954,10 @@ class FuseChannel {
    * Dispatches fuse requests until the session is torn down.
    * This function blocks until the fuse session is stopped.
    * The intent is that this is called from each of the
-   * fuse worker threads provided by the MountPoint.
+   * fuse worker threads provided by the MountPoint, with the fuse device it
+   * reads the requests from.
    */
-  void processSession();
+  void processSession(int deviceFd);
 
   /**
    * Requests that the worker threads terminate their processing loop.
@@ -757,6 +981,19 @@ class FuseChannel {
   bool requireUtf8Path_;
   int32_t maximumBackgroundRequests_;
   bool useWriteBackCache_;
+  const bool cloneDevice_;
+  const bool pinWorkerThreads_;
+  const bool spliceReads_;
+  const bool readdirPlus_;
+  const size_t numInvalidationThreads_;
+  const std::chrono::nanoseconds slowRequestThreshold_;
+  const std::unique_ptr<FuseAdmissionControl> admissionControl_;
+
+  /**
+   * Indexed by opcode, like the table of handlers.
+   */
+  std::array<LatencyHistogram, kNumLatencyHistograms> latencyHistograms_;
+  std::atomic<uint64_t> slowRequestCount_{0};
 
   /*
    * connInfo_ is modified during the initialization process,
@@ -782,6 +1019,25 @@ class FuseChannel {
    */
   folly::File fuseDevice_;
 
+  /*
+   * The clones of fuseDevice_ read by each of the worker threads, indexed
+   * like them.  Empty devices, like the one of the first worker thread, stand
+   * for fuseDevice_ itself.
+   *
+   * This is filled before the worker threads but the first one are started,
+   * and emptied once they all stopped, with the same synchronization as for
+   * fuseDevice_.
+   */
+  std::vector<folly::File> workerDevices_;
+
+#ifdef __linux__
+  /*
+   * Empty pipes to splice the replies to reads through, kept for the next
+   * reads.  At most numThreads_ are kept.
+   */
+  folly::Synchronized<std::vector<SplicePipes>, std::mutex> splicePipes_;
+#endif
+
   /*
    * Mutable state that is accessed from the worker threads.
    * All of this state uses locking or other synchronization.
@@ -797,11 +1053,22 @@ class FuseChannel {
   // To prevent logging unsupported opcodes twice.
   folly::Synchronized<std::unordered_set<FuseOpcode>> unhandledOpcodes_;
 
+#ifdef __linux__
+  // The in-flight requests by unique, for FUSE_INTERRUPT. Linux doesn't
+  // reuse uniques of requests that weren't replied to.
+  folly::Synchronized<
+      std::unordered_map<uint64_t, std::weak_ptr<FuseRequestContext>>>
+      liveRequests_;
+#endif
+
   // State for sending inode invalidation requests to the kernel
   // These are processed in their own dedicated thread.
   folly::Synchronized<InvalidationQueue, std::mutex> invalidationQueue_;
   std::condition_variable invalidationCV_;
   std::thread invalidationThread_;
+  // The threads helping invalidationThread_ send large batches, if
+  // numInvalidationThreads_ is more than 1.
+  std::unique_ptr<UnboundedQueueExecutor> invalidationExecutor_;
 
   ProcessAccessLog processAccessLog_;
 
@@ -179,6 +179,17 @@ ImmediateFuture<BufVec> FuseDispatcher::read(
   FUSELL_NOT_IMPL();
 }
 
+#ifdef __linux__
+ImmediateFuture<std::optional<size_t>> FuseDispatcher::spliceRead(
+    InodeNumber /*ino*/,
+    size_t /*size*/,
+    off_t /*off*/,
+    int /*pipeFd*/,
+    const ObjectFetchContextPtr& /*context*/) {
+  return std::optional<size_t>{};
+}
+#endif
+
 ImmediateFuture<size_t> FuseDispatcher::write(
     InodeNumber /*ino*/,
     StringPiece /*data*/,
@@ -216,6 +227,17 @@ ImmediateFuture<FuseDirList> FuseDispatcher::readdir(
   FUSELL_NOT_IMPL();
 }
 
+#ifdef __linux__
+ImmediateFuture<FuseDirPlusList> FuseDispatcher::readdirplus(
+    InodeNumber,
+    FuseDirPlusList&&,
+    off_t,
+    uint64_t,
+    const ObjectFetchContextPtr&) {
+  FUSELL_NOT_IMPL();
+}
+#endif
+
 ImmediateFuture<struct fuse_kstatfs> FuseDispatcher::statfs(
     InodeNumber /*ino*/) {
   struct fuse_kstatfs info = {};
@@ -9,6 +9,7 @@
 
 #include <folly/Portability.h>
 #include <folly/Range.h>
+#include <optional>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/store/IObjectStore.h"
 #include "eden/fs/utils/BufVec.h"
@@ -31,6 +32,7 @@ namespace facebook::eden {
   } while (0)
 
 class FuseDirList;
+class FuseDirPlusList;
 class EdenStats;
 
 class FuseDispatcher {
@@ -310,6 +312,25 @@ class FuseDispatcher {
       off_t off,
       const ObjectFetchContextPtr& context);
 
+#ifdef __linux__
+  /**
+   * Read data by splicing it into a pipe, without copying it
+   *
+   * Splices up to size bytes into the pipe, and returns the number of bytes
+   * spliced, fewer than size only on EOF. Returns std::nullopt when the data
+   * can't be spliced, in which case read() is used instead. The default
+   * implementation never splices.
+   *
+   * @param pipeFd write end of a pipe with room for size bytes
+   */
+  virtual ImmediateFuture<std::optional<size_t>> spliceRead(
+      InodeNumber ino,
+      size_t size,
+      off_t off,
+      int pipeFd,
+      const ObjectFetchContextPtr& context);
+#endif
+
   /**
    * Write data
    *
@@ -394,6 +415,22 @@ class FuseDispatcher {
       uint64_t fh,
       const ObjectFetchContextPtr& context);
 
+#ifdef __linux__
+  /**
+   * Read directory, with the attributes of its entries.
+   *
+   * Like readdir(), but with a FuseDirPlusList whose entries' attributes are
+   * set like the replies to lookup(): the kernel takes a lookup reference on
+   * each entry with a nodeid, but "." and "..".
+   */
+  virtual ImmediateFuture<FuseDirPlusList> readdirplus(
+      InodeNumber ino,
+      FuseDirPlusList&& dirList,
+      off_t offset,
+      uint64_t fh,
+      const ObjectFetchContextPtr& context);
+#endif
+
   /**
    * Get file system statistics
    *
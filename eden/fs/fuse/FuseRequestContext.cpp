@@ -21,14 +21,17 @@ namespace facebook::eden {
 
 FuseRequestContext::FuseRequestContext(
     FuseChannel* channel,
-    const fuse_in_header& fuseHeader)
+    const fuse_in_header& fuseHeader,
+    int deviceFd,
+    RequestArena& arena)
     : RequestContext(
           channel->getProcessAccessLog(),
-          makeRefPtr<FuseObjectFetchContext>(
-              static_cast<pid_t>(fuseHeader.pid),
-              fuseHeader.opcode)),
+          FsObjectFetchContextPtr::takeOwnership(
+              new (arena) FuseObjectFetchContext(
+                  static_cast<pid_t>(fuseHeader.pid), fuseHeader.opcode))),
       channel_(channel),
-      fuseHeader_(fuseHeader) {}
+      fuseHeader_(fuseHeader),
+      deviceFd_(deviceFd) {}
 
 fuse_in_header FuseRequestContext::stealReqWithResult(int64_t result) {
   if (result_.has_value()) {
@@ -82,7 +85,7 @@ void FuseRequestContext::timeoutErrorHandler(
 
 void FuseRequestContext::replyError(int err) {
   XCHECK(err >= 0) << "errno values are positive";
-  channel_->replyError(stealReqWithResult(-err), err);
+  channel_->replyError(deviceFd_, stealReqWithResult(-err), err);
 }
 
 void FuseRequestContext::replyNone() {
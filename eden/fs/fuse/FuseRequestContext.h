@@ -18,14 +18,28 @@
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/utils/FsChannelTypes.h"
+#include "eden/fs/utils/RequestArena.h"
 
 namespace facebook::eden {
 
+/**
+ * Allocated from the RequestArena of the worker thread that read the request.
+ */
 class FuseObjectFetchContext : public FsObjectFetchContext {
  public:
   FuseObjectFetchContext(pid_t pid, uint32_t opcode)
       : pid_{pid}, opcode_{opcode} {}
 
+  static void* operator new(size_t size, RequestArena& arena) {
+    return arena.allocate(size);
+  }
+  static void operator delete(void* ptr, RequestArena& /* arena */) {
+    RequestArena::deallocate(ptr);
+  }
+  static void operator delete(void* ptr) {
+    RequestArena::deallocate(ptr);
+  }
+
   std::optional<pid_t> getClientPid() const override {
     return pid_;
   }
@@ -34,23 +48,42 @@ class FuseObjectFetchContext : public FsObjectFetchContext {
     return fuseOpcodeName(opcode_);
   }
 
+  folly::CancellationToken getCancellationToken() const override {
+    return cancellation_.getToken();
+  }
+
+  /**
+   * Called when the kernel interrupted the request.
+   */
+  void interrupt() {
+    cancellation_.requestCancellation();
+  }
+
  private:
   pid_t pid_;
   uint32_t opcode_;
+  folly::CancellationSource cancellation_;
 };
 
 /**
  * Each FUSE request has a corresponding FuseRequestContext object that is
- * allocated at request start and deallocated when it finishes.
+ * allocated at request start and deallocated when it finishes, from the
+ * RequestArena of the worker thread that read the request.
  *
  * Unless a member function indicates otherwise, FuseRequestContext may be used
  * from multiple threads, but only by one thread at a time.
  */
 class FuseRequestContext : public RequestContext {
  public:
-  explicit FuseRequestContext(
+  /**
+   * deviceFd is the fuse device the request was read from, to which its reply
+   * is written. The fetch context is allocated from the arena.
+   */
+  FuseRequestContext(
       FuseChannel* channel,
-      const fuse_in_header& fuseHeader);
+      const fuse_in_header& fuseHeader,
+      int deviceFd,
+      RequestArena& arena);
 
   FuseRequestContext(const FuseRequestContext&) = delete;
   FuseRequestContext& operator=(const FuseRequestContext&) = delete;
@@ -74,6 +107,15 @@ class FuseRequestContext : public RequestContext {
    */
   const fuse_in_header& getReq() const;
 
+  /**
+   * Request cancellation of the imports the request waits on, after the
+   * kernel sent FUSE_INTERRUPT for it. May be called from any thread.
+   */
+  void interrupt() {
+    static_cast<FuseObjectFetchContext&>(getFsObjectFetchContext())
+        .interrupt();
+  }
+
   /**
    * Append error handling clauses to a future chain. These clauses result in
    * reporting a fuse request error back to the kernel.
@@ -86,6 +128,10 @@ class FuseRequestContext : public RequestContext {
       if (try_.hasException()) {
         if (auto* err = try_.tryGetExceptionObject<folly::FutureTimeout>()) {
           timeoutErrorHandler(*err, notifier);
+        } else if (try_.tryGetExceptionObject<folly::OperationCancelled>()) {
+          // Only the kernel interrupts requests, and it doesn't need a
+          // notification for it.
+          replyError(EINTR);
         } else if (
             auto* err = try_.tryGetExceptionObject<std::system_error>()) {
           systemErrorHandler(*err, notifier);
@@ -111,7 +157,8 @@ class FuseRequestContext : public RequestContext {
 
   template <typename... T>
   void sendReply(T&&... payload) {
-    channel_->sendReply(stealReqWithResult(0), std::forward<T>(payload)...);
+    channel_->sendReply(
+        deviceFd_, stealReqWithResult(0), std::forward<T>(payload)...);
   }
 
   /**
@@ -121,8 +168,19 @@ class FuseRequestContext : public RequestContext {
    */
   template <typename T>
   void sendReplyWithInode(uint64_t nodeid, T&& reply) {
-    channel_->sendReply(stealReqWithResult(nodeid), std::forward<T>(reply));
+    channel_->sendReply(
+        deviceFd_, stealReqWithResult(nodeid), std::forward<T>(reply));
+  }
+
+#ifdef __linux__
+  /**
+   * Same as sendReply, but for the replies to reads whose data was spliced
+   * into pipes.
+   */
+  void sendSplicedReply(const FuseChannel::SplicePipes& pipes, size_t size) {
+    channel_->sendSplicedReply(deviceFd_, stealReqWithResult(0), pipes, size);
   }
+#endif
 
   // Reply with a negative errno value or 0 for success
   void replyError(int err);
@@ -137,6 +195,7 @@ class FuseRequestContext : public RequestContext {
 
   FuseChannel* channel_;
   const fuse_in_header fuseHeader_;
+  const int deviceFd_;
 
   std::optional<int64_t> result_;
 };
@@ -74,7 +74,8 @@ class PrivHelper {
       folly::SocketAddress nfsdAddr,
       bool readOnly,
       uint32_t iosize,
-      bool useReaddirplus) = 0;
+      bool useReaddirplus,
+      uint32_t nconnect) = 0;
 
   /**
    * Ask the privileged helper process to perform a fuse unmount.
@@ -172,7 +172,8 @@ UnixSocket::Message PrivHelperConn::serializeMountNfsRequest(
     folly::SocketAddress nfsdAddr,
     bool readOnly,
     uint32_t iosize,
-    bool useReaddirplus) {
+    bool useReaddirplus,
+    uint32_t nconnect) {
   auto msg = serializeHeader(xid, REQ_MOUNT_NFS);
   Appender appender(&msg.data, kDefaultBufferSize);
 
@@ -182,6 +183,7 @@ UnixSocket::Message PrivHelperConn::serializeMountNfsRequest(
   serializeBool(appender, readOnly);
   serializeUint32(appender, iosize);
   serializeBool(appender, useReaddirplus);
+  serializeUint32(appender, nconnect);
   return msg;
 }
 
@@ -192,13 +194,15 @@ void PrivHelperConn::parseMountNfsRequest(
     folly::SocketAddress& nfsdAddr,
     bool& readOnly,
     uint32_t& iosize,
-    bool& useReaddirplus) {
+    bool& useReaddirplus,
+    uint32_t& nconnect) {
   mountPoint = deserializeString(cursor);
   mountdAddr = deserializeSocketAddress(cursor);
   nfsdAddr = deserializeSocketAddress(cursor);
   readOnly = deserializeBool(cursor);
   iosize = deserializeUint32(cursor);
   useReaddirplus = deserializeBool(cursor);
+  nconnect = deserializeUint32(cursor);
   checkAtEnd(cursor, "mount nfs request");
 }
 
@@ -369,6 +373,103 @@ void PrivHelperConn::parseBindUnMountRequest(
   checkAtEnd(cursor, "bind mount request");
 }
 
+bool PrivHelperConn::isBatchable(MsgType type) {
+  switch (type) {
+    case REQ_MOUNT_BIND:
+    case REQ_UNMOUNT_BIND:
+    case REQ_UNMOUNT_FUSE:
+    case REQ_UNMOUNT_NFS:
+      return true;
+    default:
+      return false;
+  }
+}
+
+UnixSocket::Message PrivHelperConn::serializeBatchRequest(
+    uint32_t xid,
+    const std::vector<BatchOperation>& operations) {
+  auto msg = serializeHeader(xid, REQ_BATCH);
+  Appender appender(&msg.data, kDefaultBufferSize);
+
+  appender.writeBE<uint32_t>(operations.size());
+  for (const auto& operation : operations) {
+    XCHECK(isBatchable(operation.type));
+    appender.writeBE<uint32_t>(static_cast<uint32_t>(operation.type));
+    serializeString(appender, operation.mountPath);
+    serializeString(appender, operation.clientPath);
+  }
+  return msg;
+}
+
+void PrivHelperConn::parseBatchRequest(
+    Cursor& cursor,
+    std::vector<BatchOperation>& operations) {
+  auto n = cursor.readBE<uint32_t>();
+  while (n-- != 0) {
+    auto type = static_cast<MsgType>(cursor.readBE<uint32_t>());
+    if (!isBatchable(type)) {
+      throw std::runtime_error(folly::to<string>(
+          "unexpected operation of type ", type, " in batch request"));
+    }
+    auto mountPath = deserializeString(cursor);
+    auto clientPath = deserializeString(cursor);
+    operations.push_back(
+        BatchOperation{type, std::move(mountPath), std::move(clientPath)});
+  }
+  checkAtEnd(cursor, "batch request");
+}
+
+void PrivHelperConn::serializeBatchResponse(
+    Appender& appender,
+    const std::vector<folly::Try<folly::Unit>>& results) {
+  appender.writeBE<uint32_t>(results.size());
+  for (const auto& result : results) {
+    serializeBool(appender, result.hasValue());
+    if (result.hasValue()) {
+      continue;
+    }
+    if (auto* ex = result.exception().get_exception<std::exception>()) {
+      serializeErrorResponse(appender, *ex);
+    } else {
+      serializeErrorResponse(appender, result.exception().what());
+    }
+  }
+}
+
+std::vector<folly::Try<folly::Unit>> PrivHelperConn::parseBatchResponse(
+    const UnixSocket::Message& msg) {
+  Cursor cursor(&msg.data);
+  auto xid = cursor.readBE<uint32_t>();
+  auto msgType = static_cast<MsgType>(cursor.readBE<uint32_t>());
+
+  if (msgType == RESP_ERROR) {
+    rethrowErrorResponse(cursor);
+  } else if (msgType != REQ_BATCH) {
+    throw std::runtime_error(folly::to<string>(
+        "unexpected response type ",
+        msgType,
+        " for batch request ",
+        xid));
+  }
+
+  std::vector<folly::Try<folly::Unit>> results;
+  auto n = cursor.readBE<uint32_t>();
+  while (n-- != 0) {
+    if (deserializeBool(cursor)) {
+      results.emplace_back(folly::unit);
+      continue;
+    }
+    try {
+      rethrowErrorResponse(cursor);
+    } catch (const std::exception&) {
+      results.emplace_back(
+          folly::exception_wrapper{std::current_exception()});
+    }
+  }
+  checkAtEnd(cursor, "batch response");
+  return results;
+}
+
 UnixSocket::Message PrivHelperConn::serializeSetLogFileRequest(
     uint32_t xid,
     folly::File logFile) {
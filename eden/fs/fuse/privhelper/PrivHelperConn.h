@@ -8,8 +8,10 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/Try.h>
 #include <cinttypes>
 #include <stdexcept>
+#include <vector>
 #include "eden/fs/utils/UnixSocket.h"
 
 namespace folly {
@@ -47,6 +49,20 @@ class PrivHelperConn {
     REQ_SET_USE_EDENFS = 10,
     REQ_MOUNT_NFS = 11,
     REQ_UNMOUNT_NFS = 12,
+    REQ_BATCH = 13,
+  };
+
+  /**
+   * One of the operations of a REQ_BATCH request.
+   *
+   * Only the requests that don't transfer file descriptors can be batched:
+   * REQ_MOUNT_BIND, REQ_UNMOUNT_BIND, REQ_UNMOUNT_FUSE and REQ_UNMOUNT_NFS.
+   * clientPath is only used by REQ_MOUNT_BIND.
+   */
+  struct BatchOperation {
+    MsgType type;
+    std::string mountPath;
+    std::string clientPath;
   };
 
   /**
@@ -86,7 +102,8 @@ class PrivHelperConn {
       folly::SocketAddress nfsdAddr,
       bool readOnly,
       uint32_t iosize,
-      bool useReaddirplus);
+      bool useReaddirplus,
+      uint32_t nconnect);
   static void parseMountNfsRequest(
       folly::io::Cursor& cursor,
       std::string& mountPoint,
@@ -94,7 +111,8 @@ class PrivHelperConn {
       folly::SocketAddress& nfsdAddr,
       bool& readOnly,
       uint32_t& iosize,
-      bool& useReaddirplus);
+      bool& useReaddirplus,
+      uint32_t& nconnect);
 
   static UnixSocket::Message serializeUnmountRequest(
       uint32_t xid,
@@ -142,6 +160,26 @@ class PrivHelperConn {
       std::string& mountPoint,
       std::vector<std::string>& bindMounts);
 
+  static bool isBatchable(MsgType type);
+  static UnixSocket::Message serializeBatchRequest(
+      uint32_t xid,
+      const std::vector<BatchOperation>& operations);
+  static void parseBatchRequest(
+      folly::io::Cursor& cursor,
+      std::vector<BatchOperation>& operations);
+
+  /**
+   * The results of a REQ_BATCH request, in the order of its operations.
+   *
+   * Each failed operation carries its error, serialized like the body of a
+   * RESP_ERROR response.
+   */
+  static void serializeBatchResponse(
+      folly::io::Appender& appender,
+      const std::vector<folly::Try<folly::Unit>>& results);
+  static std::vector<folly::Try<folly::Unit>> parseBatchResponse(
+      const UnixSocket::Message& msg);
+
   static UnixSocket::Message serializeSetLogFileRequest(
       uint32_t xid,
       folly::File logFile);
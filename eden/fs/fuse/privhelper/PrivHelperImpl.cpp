@@ -22,6 +22,7 @@
 #include <folly/logging/xlog.h>
 #include <folly/portability/SysTypes.h>
 #include <folly/portability/Unistd.h>
+#include <algorithm>
 #ifndef _WIN32
 #include <sys/wait.h>
 #endif // !_WIN32
@@ -69,7 +70,8 @@ namespace {
 class PrivHelperClientImpl : public PrivHelper,
                              private UnixSocket::ReceiveCallback,
                              private UnixSocket::SendCallback,
-                             private EventBase::OnDestructionCallback {
+                             private EventBase::OnDestructionCallback,
+                             private EventBase::LoopCallback {
  public:
   PrivHelperClientImpl(File&& conn, std::optional<SpawnedProcess> proc)
       : helperProc_(std::move(proc)),
@@ -96,6 +98,10 @@ class PrivHelperClientImpl : public PrivHelper,
       state->conn_->setReceiveCallback(this);
     }
     eventBase->runOnDestruction(*this);
+    // Send the operations queued before we were last detached.
+    if (!batch_.empty()) {
+      eventBase->runInLoop(this);
+    }
   }
 
   void detachEventBase() override {
@@ -110,7 +116,8 @@ class PrivHelperClientImpl : public PrivHelper,
       folly::SocketAddress nfsdAddr,
       bool readOnly,
       uint32_t iosize,
-      bool useReaddirplus) override;
+      bool useReaddirplus,
+      uint32_t nconnect) override;
   Future<Unit> fuseUnmount(StringPiece mountPath) override;
   Future<Unit> nfsUnmount(StringPiece mountPath) override;
   Future<Unit> bindMount(StringPiece clientPath, StringPiece mountPath)
@@ -134,6 +141,10 @@ class PrivHelperClientImpl : public PrivHelper,
  private:
   using PendingRequestMap =
       std::unordered_map<uint32_t, folly::Promise<UnixSocket::Message>>;
+  struct QueuedOperation {
+    PrivHelperConn::BatchOperation operation;
+    folly::Promise<Unit> promise;
+  };
   enum class Status : uint32_t {
     NOT_STARTED,
     RUNNING,
@@ -179,6 +190,7 @@ class PrivHelperClientImpl : public PrivHelper,
           state->conn_->detachEventBase();
         }
         cancel();
+        cancelLoopCallback();
       });
     }
     // Make sure the socket is closed, and fail any outstanding requests.
@@ -225,7 +237,37 @@ class PrivHelperClientImpl : public PrivHelper,
                                      xid,
                                      msg = std::move(msg),
                                      promise = std::move(promise)]() mutable {
-      // Double check that the connection is still open
+      send(xid, std::move(msg), std::move(promise));
+    });
+    return future;
+  }
+
+  /**
+   * Send a request that can be part of a REQ_BATCH, and wait for its result.
+   *
+   * The operations requested during the same EventBase loop iteration are
+   * sent together at the end of it, which saves a round trip to the
+   * privhelper process for each of them when many bind mounts or mount points
+   * are set up or torn down at once, and lets it apply them concurrently.
+   */
+  Future<Unit> sendBatchable(PrivHelperConn::BatchOperation&& operation) {
+    EventBase* eventBase;
+    {
+      auto state = state_.rlock();
+      if (state->status != Status::RUNNING) {
+        return folly::makeFuture<Unit>(std::runtime_error(
+            "cannot send new requests on closed privhelper connection"));
+      }
+      eventBase = state->eventBase;
+    }
+
+    folly::Promise<Unit> promise;
+    auto future = promise.getFuture();
+    eventBase->runInEventBaseThread([this,
+                                     eventBase,
+                                     operation = std::move(operation),
+                                     promise = std::move(promise)]() mutable {
+      bool attached;
       {
         auto state = state_.rlock();
         if (!state->conn_) {
@@ -233,17 +275,138 @@ class PrivHelperClientImpl : public PrivHelper,
               "cannot send new requests on closed privhelper connection"));
           return;
         }
+        attached = state->eventBase == eventBase;
       }
-      pendingRequests_.emplace(xid, std::move(promise));
-      ++sendPending_;
-      {
-        auto state = state_.wlock();
-        state->conn_->send(std::move(msg), this);
+      // The privhelper applies the operations of a batch concurrently, so
+      // the ones on the same path must stay in separate requests to keep
+      // their order.
+      if (attached &&
+          std::any_of(
+              batch_.begin(), batch_.end(), [&](const QueuedOperation& queued) {
+                return queued.operation.mountPath == operation.mountPath;
+              })) {
+        flushBatch();
+      }
+      batch_.push_back(
+          QueuedOperation{std::move(operation), std::move(promise)});
+      // If we were detached since, attachEventBase() schedules the flush.
+      if (attached && !isLoopCallbackScheduled()) {
+        eventBase->runInLoop(this);
       }
     });
     return future;
   }
 
+  /**
+   * Send the operations queued by sendBatchable(), as a REQ_BATCH unless
+   * there is only one of them.
+   *
+   * This must be called on the EventBase thread.
+   */
+  void flushBatch() {
+    std::vector<QueuedOperation> batch;
+    batch.swap(batch_);
+    if (batch.empty()) {
+      return;
+    }
+
+    auto xid = getNextXid();
+    UnixSocket::Message request;
+    if (batch.size() == 1) {
+      request = serializeOperation(xid, batch[0].operation);
+    } else {
+      std::vector<PrivHelperConn::BatchOperation> operations;
+      operations.reserve(batch.size());
+      for (const auto& queued : batch) {
+        operations.push_back(queued.operation);
+      }
+      request = PrivHelperConn::serializeBatchRequest(xid, operations);
+    }
+
+    folly::Promise<UnixSocket::Message> promise;
+    auto future = promise.getFuture();
+    send(xid, std::move(request), std::move(promise));
+    std::move(future).thenTry(
+        [batch = std::move(batch)](
+            folly::Try<UnixSocket::Message>&& response) mutable {
+          std::vector<folly::Try<Unit>> results;
+          try {
+            if (batch.size() == 1) {
+              PrivHelperConn::parseEmptyResponse(
+                  batch[0].operation.type, response.value());
+              results.emplace_back(folly::unit);
+            } else {
+              results = PrivHelperConn::parseBatchResponse(response.value());
+              if (results.size() != batch.size()) {
+                throw_<std::runtime_error>(
+                    "expected privhelper batch response to contain ",
+                    batch.size(),
+                    " results; got ",
+                    results.size());
+              }
+            }
+          } catch (const std::exception&) {
+            auto ew = folly::exception_wrapper{std::current_exception()};
+            for (auto& queued : batch) {
+              queued.promise.setException(ew);
+            }
+            return;
+          }
+          for (size_t i = 0; i < batch.size(); ++i) {
+            batch[i].promise.setTry(std::move(results[i]));
+          }
+        });
+  }
+
+  static UnixSocket::Message serializeOperation(
+      uint32_t xid,
+      const PrivHelperConn::BatchOperation& operation) {
+    switch (operation.type) {
+      case PrivHelperConn::REQ_MOUNT_BIND:
+        return PrivHelperConn::serializeBindMountRequest(
+            xid, operation.clientPath, operation.mountPath);
+      case PrivHelperConn::REQ_UNMOUNT_BIND:
+        return PrivHelperConn::serializeBindUnMountRequest(
+            xid, operation.mountPath);
+      case PrivHelperConn::REQ_UNMOUNT_FUSE:
+        return PrivHelperConn::serializeUnmountRequest(
+            xid, operation.mountPath);
+      case PrivHelperConn::REQ_UNMOUNT_NFS:
+        return PrivHelperConn::serializeNfsUnmountRequest(
+            xid, operation.mountPath);
+      default:
+        break;
+    }
+    throw_<std::logic_error>(
+        "unexpected privhelper batch operation type ", operation.type);
+  }
+
+  /**
+   * Send a request, and fulfill promise with its response.
+   *
+   * This must be called on the EventBase thread.
+   */
+  void send(
+      uint32_t xid,
+      UnixSocket::Message&& msg,
+      folly::Promise<UnixSocket::Message>&& promise) {
+    // Double check that the connection is still open
+    {
+      auto state = state_.rlock();
+      if (!state->conn_) {
+        promise.setException(std::runtime_error(
+            "cannot send new requests on closed privhelper connection"));
+        return;
+      }
+    }
+    pendingRequests_.emplace(xid, std::move(promise));
+    ++sendPending_;
+    {
+      auto state = state_.wlock();
+      state->conn_->send(std::move(msg), this);
+    }
+  }
+
   void messageReceived(UnixSocket::Message&& message) noexcept override {
     try {
       processResponse(std::move(message));
@@ -298,6 +461,10 @@ class PrivHelperClientImpl : public PrivHelper,
         "error sending to privhelper process: ", folly::exceptionStr(ew))));
   }
 
+  void runLoopCallback() noexcept override {
+    flushBatch();
+  }
+
   void onEventBaseDestruction() noexcept override {
     // This callback is run when the EventBase is destroyed.
     // Detach from the EventBase.  We may be restarted later if
@@ -331,6 +498,8 @@ class PrivHelperClientImpl : public PrivHelper,
   void closeSocket(const std::exception& ex) {
     PendingRequestMap pending;
     pending.swap(pendingRequests_);
+    std::vector<QueuedOperation> batch;
+    batch.swap(batch_);
     {
       auto state = state_.wlock();
       state->conn_.reset();
@@ -340,11 +509,16 @@ class PrivHelperClientImpl : public PrivHelper,
     for (auto& entry : pending) {
       entry.second.setException(ex);
     }
+    for (auto& queued : batch) {
+      queued.promise.setException(ex);
+    }
   }
 
   // Separated out from detachEventBase() since it is not safe to cancel() an
   // EventBase::OnDestructionCallback within the callback itself.
   void detachWithinEventBaseDestructor() noexcept {
+    // Any queued operations are sent once we are attached again.
+    cancelLoopCallback();
     {
       auto state = state_.wlock();
       if (state->status != Status::RUNNING) {
@@ -361,10 +535,11 @@ class PrivHelperClientImpl : public PrivHelper,
   std::atomic<uint32_t> nextXid_{1};
   folly::Synchronized<ThreadSafeData> state_;
 
-  // sendPending_, and pendingRequests_ are only accessed from the
+  // sendPending_, pendingRequests_ and batch_ are only accessed from the
   // EventBase thread.
   size_t sendPending_{0};
   PendingRequestMap pendingRequests_;
+  std::vector<QueuedOperation> batch_;
 };
 
 Future<File> PrivHelperClientImpl::fuseMount(
@@ -393,10 +568,18 @@ Future<Unit> PrivHelperClientImpl::nfsMount(
     folly::SocketAddress nfsdAddr,
     bool readOnly,
     uint32_t iosize,
-    bool useReaddirplus) {
+    bool useReaddirplus,
+    uint32_t nconnect) {
   auto xid = getNextXid();
   auto request = PrivHelperConn::serializeMountNfsRequest(
-      xid, mountPath, mountdAddr, nfsdAddr, readOnly, iosize, useReaddirplus);
+      xid,
+      mountPath,
+      mountdAddr,
+      nfsdAddr,
+      readOnly,
+      iosize,
+      useReaddirplus,
+      nconnect);
   return sendAndRecv(xid, std::move(request))
       .thenValue([](UnixSocket::Message&& response) {
         PrivHelperConn::parseEmptyResponse(
@@ -405,49 +588,26 @@ Future<Unit> PrivHelperClientImpl::nfsMount(
 }
 
 Future<Unit> PrivHelperClientImpl::fuseUnmount(StringPiece mountPath) {
-  auto xid = getNextXid();
-  auto request = PrivHelperConn::serializeUnmountRequest(xid, mountPath);
-  return sendAndRecv(xid, std::move(request))
-      .thenValue([](UnixSocket::Message&& response) {
-        PrivHelperConn::parseEmptyResponse(
-            PrivHelperConn::REQ_UNMOUNT_FUSE, response);
-      });
+  return sendBatchable(PrivHelperConn::BatchOperation{
+      PrivHelperConn::REQ_UNMOUNT_FUSE, mountPath.str(), {}});
 }
 
 Future<Unit> PrivHelperClientImpl::nfsUnmount(StringPiece mountPath) {
-  auto xid = getNextXid();
-  auto request = PrivHelperConn::serializeNfsUnmountRequest(xid, mountPath);
-  return sendAndRecv(xid, std::move(request))
-      .thenValue([](UnixSocket::Message&& response) {
-        PrivHelperConn::parseEmptyResponse(
-            PrivHelperConn::REQ_UNMOUNT_NFS, response);
-      });
+  return sendBatchable(PrivHelperConn::BatchOperation{
+      PrivHelperConn::REQ_UNMOUNT_NFS, mountPath.str(), {}});
 }
 
 Future<Unit> PrivHelperClientImpl::bindMount(
     StringPiece clientPath,
     StringPiece mountPath) {
-  auto xid = getNextXid();
-  auto request =
-      PrivHelperConn::serializeBindMountRequest(xid, clientPath, mountPath);
-
-  return sendAndRecv(xid, std::move(request))
-      .thenValue([](UnixSocket::Message&& response) {
-        PrivHelperConn::parseEmptyResponse(
-            PrivHelperConn::REQ_MOUNT_BIND, response);
-      });
+  return sendBatchable(PrivHelperConn::BatchOperation{
+      PrivHelperConn::REQ_MOUNT_BIND, mountPath.str(), clientPath.str()});
 }
 
 folly::Future<folly::Unit> PrivHelperClientImpl::bindUnMount(
     folly::StringPiece mountPath) {
-  auto xid = getNextXid();
-  auto request = PrivHelperConn::serializeBindUnMountRequest(xid, mountPath);
-
-  return sendAndRecv(xid, std::move(request))
-      .thenValue([](UnixSocket::Message&& response) {
-        PrivHelperConn::parseEmptyResponse(
-            PrivHelperConn::REQ_UNMOUNT_BIND, response);
-      });
+  return sendBatchable(PrivHelperConn::BatchOperation{
+      PrivHelperConn::REQ_UNMOUNT_BIND, mountPath.str(), {}});
 }
 
 Future<Unit> PrivHelperClientImpl::takeoverShutdown(StringPiece mountPath) {
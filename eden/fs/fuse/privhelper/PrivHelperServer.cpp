@@ -17,6 +17,7 @@
 #include <folly/FileUtil.h>
 #include <folly/SocketAddress.h>
 #include <folly/String.h>
+#include <folly/Try.h>
 #include <folly/Utility.h>
 #include <folly/init/Init.h>
 #include <folly/io/Cursor.h>
@@ -32,8 +33,11 @@
 #include <sys/stat.h>
 #include <sys/statvfs.h>
 #include <sys/types.h>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <set>
+#include <thread>
 #include "eden/fs/fuse/privhelper/NfsMountRpc.h"
 #include "eden/fs/fuse/privhelper/PrivHelperConn.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -62,6 +66,47 @@ using std::string;
 
 namespace facebook::eden {
 
+namespace {
+
+// The operations of a batch mostly wait on the kernel, for up to 2 seconds for
+// a bind unmount (see bindUnmount()), so each of them gets its own thread up
+// to this limit.
+constexpr size_t kMaxBatchThreads = 16;
+
+/**
+ * Call fn(i) for every i in [0, count) from several threads, and return once
+ * they have all returned.  fn() must not throw.
+ */
+template <typename Fn>
+void runConcurrently(size_t count, Fn&& fn) {
+  std::atomic<size_t> next{0};
+  auto worker = [&] {
+    size_t i;
+    while ((i = next.fetch_add(1, std::memory_order_relaxed)) < count) {
+      fn(i);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  const auto numThreads = std::min(count, kMaxBatchThreads);
+  for (size_t i = 1; i < numThreads; ++i) {
+    try {
+      threads.emplace_back(worker);
+    } catch (const std::system_error& ex) {
+      // The threads already started and this one share the remaining work.
+      XLOG(WARN) << "unable to start a thread for a privhelper batch: "
+                 << folly::exceptionStr(ex);
+      break;
+    }
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+
+} // namespace
+
 PrivHelperServer::PrivHelperServer() {}
 
 PrivHelperServer::~PrivHelperServer() {}
@@ -560,8 +605,11 @@ void PrivHelperServer::nfsMount(
     folly::SocketAddress nfsdAddr,
     bool readOnly,
     uint32_t iosize,
-    bool useReaddirplus) {
+    bool useReaddirplus,
+    uint32_t nconnect) {
 #ifdef __APPLE__
+  // The macOS NFS client always uses a single connection.
+  (void)nconnect;
   if (shouldLoadNfsKext()) {
     XLOG(DBG3) << "Apple nfs.kext is not loaded. Attempting to load.";
     loadNfsKext();
@@ -743,15 +791,22 @@ void PrivHelperServer::nfsMount(
   if (useReaddirplus) {
     noReaddirplusStr = ",";
   }
+  // Kernels older than 5.3 don't know about nconnect, only pass it when more
+  // than one connection is wanted.
+  std::string nconnectStr;
+  if (nconnect > 1) {
+    nconnectStr = fmt::format(",nconnect={}", nconnect);
+  }
   auto mountOpts = fmt::format(
       "addr={},vers=3,proto=tcp,port={},mountvers=3,mountproto=tcp,mountport={},"
-      "noresvport,nolock{}soft,retrans=0,rsize={},wsize={}",
+      "noresvport,nolock{}soft,retrans=0,rsize={},wsize={}{}",
       nfsdAddr.getAddressStr(),
       nfsdAddr.getPort(),
       mountdAddr.getPort(),
       noReaddirplusStr,
       iosize,
-      iosize);
+      iosize,
+      nconnectStr);
 
   // The mount flags.
   // We do not use MS_NODEV.  MS_NODEV prevents mount points from being created
@@ -858,7 +913,7 @@ UnixSocket::Message PrivHelperServer::processMountNfsMsg(Cursor& cursor) {
   string mountPath;
   folly::SocketAddress mountdAddr, nfsdAddr;
   bool readOnly, useReaddirplus;
-  uint32_t iosize;
+  uint32_t iosize, nconnect;
   PrivHelperConn::parseMountNfsRequest(
       cursor,
       mountPath,
@@ -866,12 +921,20 @@ UnixSocket::Message PrivHelperServer::processMountNfsMsg(Cursor& cursor) {
       nfsdAddr,
       readOnly,
       iosize,
-      useReaddirplus);
+      useReaddirplus,
+      nconnect);
   XLOG(DBG3) << "mount.nfs \"" << mountPath << "\"";
 
   sanityCheckMountPoint(mountPath);
 
-  nfsMount(mountPath, mountdAddr, nfsdAddr, readOnly, iosize, useReaddirplus);
+  nfsMount(
+      mountPath,
+      mountdAddr,
+      nfsdAddr,
+      readOnly,
+      iosize,
+      useReaddirplus,
+      nconnect);
   mountPoints_.insert(mountPath);
 
   return makeResponse();
@@ -961,6 +1024,114 @@ UnixSocket::Message PrivHelperServer::processBindUnMountMsg(Cursor& cursor) {
   return makeResponse();
 }
 
+UnixSocket::Message PrivHelperServer::processBatchMsg(Cursor& cursor) {
+  std::vector<PrivHelperConn::BatchOperation> operations;
+  PrivHelperConn::parseBatchRequest(cursor, operations);
+  XLOG(DBG3) << "batch of " << operations.size() << " operations";
+
+  // Check the operations in order, as if they had been sent one at a time.
+  std::vector<folly::Try<folly::Unit>> results(operations.size());
+  std::vector<size_t> bindOperations;
+  std::vector<size_t> unmountOperations;
+  std::set<string> unmounted;
+  for (size_t i = 0; i < operations.size(); ++i) {
+    const auto& operation = operations[i];
+    results[i] = folly::makeTryWith(
+        [&] { checkBatchOperation(operation, unmounted); });
+    if (results[i].hasException()) {
+      continue;
+    }
+    if (operation.type == PrivHelperConn::REQ_MOUNT_BIND ||
+        operation.type == PrivHelperConn::REQ_UNMOUNT_BIND) {
+      bindOperations.push_back(i);
+    } else {
+      unmountOperations.push_back(i);
+    }
+  }
+
+  // Bind mounts live inside the FUSE and NFS mounts, so they are all done
+  // before unmounting any of those.
+  for (const auto* indices : {&bindOperations, &unmountOperations}) {
+    runConcurrently(indices->size(), [&](size_t i) {
+      auto index = (*indices)[i];
+      results[index] =
+          folly::makeTryWith([&] { runBatchOperation(operations[index]); });
+    });
+  }
+
+  for (auto index : unmountOperations) {
+    if (results[index].hasValue()) {
+      mountPoints_.erase(operations[index].mountPath);
+    }
+  }
+
+  auto response = makeResponse();
+  Appender appender(&response.data, 1024);
+  PrivHelperConn::serializeBatchResponse(appender, results);
+  return response;
+}
+
+void PrivHelperServer::checkBatchOperation(
+    const PrivHelperConn::BatchOperation& operation,
+    std::set<std::string>& unmounted) {
+  switch (operation.type) {
+    case PrivHelperConn::REQ_MOUNT_BIND:
+    case PrivHelperConn::REQ_UNMOUNT_BIND: {
+      XLOG(DBG3) << "batched bind "
+                 << (operation.type == PrivHelperConn::REQ_MOUNT_BIND
+                         ? "mount"
+                         : "unmount")
+                 << " \"" << operation.mountPath << "\"";
+      // As in processBindMountMsg(), so that we're not a vector for mounting
+      // or unmounting things in arbitrary places.
+      auto mountPoint = findMatchingMountPrefix(operation.mountPath);
+      if (unmounted.count(mountPoint) != 0) {
+        throw_<std::domain_error>(
+            "No FUSE mount found for ", operation.mountPath);
+      }
+      return;
+    }
+    case PrivHelperConn::REQ_UNMOUNT_FUSE:
+    case PrivHelperConn::REQ_UNMOUNT_NFS:
+      XLOG(DBG3) << "batched unmount \"" << operation.mountPath << "\"";
+      if (mountPoints_.count(operation.mountPath) == 0 ||
+          !unmounted.insert(operation.mountPath).second) {
+        throw_<std::domain_error>(
+            "No ",
+            operation.type == PrivHelperConn::REQ_UNMOUNT_FUSE ? "FUSE" : "NFS",
+            " mount found for ",
+            operation.mountPath);
+      }
+      return;
+    default:
+      break;
+  }
+  throw_<std::runtime_error>(
+      "unexpected privhelper batch operation type: ",
+      folly::to_underlying(operation.type));
+}
+
+void PrivHelperServer::runBatchOperation(
+    const PrivHelperConn::BatchOperation& operation) {
+  switch (operation.type) {
+    case PrivHelperConn::REQ_MOUNT_BIND:
+      bindMount(operation.clientPath.c_str(), operation.mountPath.c_str());
+      return;
+    case PrivHelperConn::REQ_UNMOUNT_BIND:
+      bindUnmount(operation.mountPath.c_str());
+      return;
+    case PrivHelperConn::REQ_UNMOUNT_FUSE:
+    case PrivHelperConn::REQ_UNMOUNT_NFS:
+      unmount(operation.mountPath.c_str());
+      return;
+    default:
+      break;
+  }
+  throw_<std::runtime_error>(
+      "unexpected privhelper batch operation type: ",
+      folly::to_underlying(operation.type));
+}
+
 UnixSocket::Message PrivHelperServer::processSetLogFileMsg(
     folly::io::Cursor& cursor,
     UnixSocket::Message& request) {
@@ -1183,6 +1354,8 @@ UnixSocket::Message PrivHelperServer::processMessage(
       return processSetDaemonTimeout(cursor, request);
     case PrivHelperConn::REQ_SET_USE_EDENFS:
       return processSetUseEdenFs(cursor, request);
+    case PrivHelperConn::REQ_BATCH:
+      return processBatchMsg(cursor);
     case PrivHelperConn::MSG_TYPE_NONE:
     case PrivHelperConn::RESP_ERROR:
       break;
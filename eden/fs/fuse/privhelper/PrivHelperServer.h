@@ -84,6 +84,7 @@ class PrivHelperServer : private UnixSocket::ReceiveCallback {
   UnixSocket::Message processNfsUnmountMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processBindMountMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processBindUnMountMsg(folly::io::Cursor& cursor);
+  UnixSocket::Message processBatchMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processTakeoverShutdownMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processTakeoverStartupMsg(folly::io::Cursor& cursor);
   UnixSocket::Message processSetLogFileMsg(
@@ -91,6 +92,19 @@ class PrivHelperServer : private UnixSocket::ReceiveCallback {
       UnixSocket::Message& request);
   std::string findMatchingMountPrefix(folly::StringPiece path);
 
+  /**
+   * Apply the checks of the equivalent unbatched request to one operation of
+   * a batch.
+   *
+   * unmounted holds the mount points unmounted by the previous operations of
+   * the batch, which are still in mountPoints_ since the batch only runs once
+   * every operation has been checked.
+   */
+  void checkBatchOperation(
+      const PrivHelperConn::BatchOperation& operation,
+      std::set<std::string>& unmounted);
+  void runBatchOperation(const PrivHelperConn::BatchOperation& operation);
+
   UnixSocket::Message processSetDaemonTimeout(
       folly::io::Cursor& cursor,
       UnixSocket::Message& request);
@@ -115,7 +129,8 @@ class PrivHelperServer : private UnixSocket::ReceiveCallback {
       folly::SocketAddress nfsdPort,
       bool readOnly,
       uint32_t iosize,
-      bool useReaddirplus);
+      bool useReaddirplus,
+      uint32_t nconnect);
   virtual void unmount(const char* mountPath);
   // Both clientPath and mountPath must be existing directories.
   virtual void bindMount(const char* clientPath, const char* mountPath);
@@ -130,8 +145,8 @@ class PrivHelperServer : private UnixSocket::ReceiveCallback {
   std::chrono::nanoseconds fuseTimeout_{std::chrono::seconds(60)};
   bool useDevEdenFs_{false};
 
-  // The privhelper server only has a single thread,
-  // so we don't need to lock the following state
+  // The privhelper server only has a single thread, and only the operations of
+  // a batch run on other threads, so we don't need to lock the following state
   std::set<std::string> mountPoints_;
 };
 
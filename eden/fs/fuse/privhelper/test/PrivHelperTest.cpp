@@ -395,6 +395,60 @@ TEST_F(PrivHelperTest, bindMounts) {
       UnorderedElementsAre("/bind/never/actually/mounted"));
 }
 
+TEST_F(PrivHelperTest, batchedBindMounts) {
+  auto abcMountPoint = makeTempDir("abc");
+  auto abcPath = abcMountPoint.path().string();
+  TemporaryFile tempFile;
+
+  server_.setFuseMountResult(abcPath).setValue(File(tempFile.fd(), false));
+  server_.setBindMountResult(abcPath + "/buck-out").setValue();
+  server_.setBindMountResult(abcPath + "/foo/buck-out").setValue();
+  // No result for bar/buck-out, so that this bind mount fails.
+
+  server_.setBindUnmountResult(abcPath + "/buck-out").setValue();
+  server_.setFuseUnmountResult(abcPath).setValue();
+
+  client_->fuseMount(abcPath, false).get(1s);
+
+  // The requests made during the same EventBase loop iteration are sent in a
+  // single batch, but each of them still gets its own result.
+  auto* eventBase = clientIoThread_.getEventBase();
+  std::vector<Future<Unit>> bindResults;
+  eventBase->runInEventBaseThreadAndWait([&] {
+    bindResults.push_back(
+        client_->bindMount("/bind/mount/source", abcPath + "/buck-out"));
+    bindResults.push_back(
+        client_->bindMount("/bind/mount/source", abcPath + "/foo/buck-out"));
+    bindResults.push_back(
+        client_->bindMount("/bind/mount/source", abcPath + "/bar/buck-out"));
+  });
+  std::move(bindResults[0]).get(1s);
+  std::move(bindResults[1]).get(1s);
+  EXPECT_THROW_RE(
+      std::move(bindResults[2]).get(1s),
+      std::exception,
+      fmt::format("no result available for {}/bar/buck-out", abcPath));
+
+  // The operations of a batch are checked in order, so a bind mount can't be
+  // unmounted once the mount containing it has been.
+  std::vector<Future<Unit>> unmountResults;
+  eventBase->runInEventBaseThreadAndWait([&] {
+    unmountResults.push_back(client_->bindUnMount(abcPath + "/buck-out"));
+    unmountResults.push_back(client_->fuseUnmount(abcPath));
+    unmountResults.push_back(client_->bindUnMount(abcPath + "/foo/buck-out"));
+  });
+  std::move(unmountResults[0]).get(1s);
+  std::move(unmountResults[1]).get(1s);
+  EXPECT_THROW_RE(
+      std::move(unmountResults[2]).get(1s),
+      std::exception,
+      fmt::format("No FUSE mount found for {}/foo/buck-out", abcPath));
+
+  cleanup();
+  EXPECT_THAT(server_.getUnusedFuseUnmountResults(), UnorderedElementsAre());
+  EXPECT_THAT(server_.getUnusedBindUnmountResults(), UnorderedElementsAre());
+}
+
 TEST_F(PrivHelperTest, takeoverShutdown) {
   auto abcMountPoint = makeTempDir("abc");
   auto abcPath = abcMountPoint.path().string();
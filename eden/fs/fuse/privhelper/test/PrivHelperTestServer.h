@@ -10,6 +10,7 @@
 #include "eden/fs/fuse/privhelper/PrivHelperServer.h"
 
 #include <folly/Range.h>
+#include <folly/Synchronized.h>
 
 namespace facebook::eden {
 
@@ -39,8 +40,9 @@ class PrivHelperTestServer : public PrivHelperServer {
 
  private:
   // all of the paths we've ever bind mounted; we remember this
-  // so that we can mark them as unmounted when we unmount things.
-  std::vector<std::string> allBindMounts_;
+  // so that we can mark them as unmounted when we unmount things.  The
+  // operations of a batch run concurrently, hence the lock.
+  folly::Synchronized<std::vector<std::string>> allBindMounts_;
 
   folly::File fuseMount(const char* mountPath, bool readOnly) override;
   void unmount(const char* mountPath) override;
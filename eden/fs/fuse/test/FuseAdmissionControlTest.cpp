@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/fuse/FuseAdmissionControl.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/common/utils/ProcessNameCache.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+constexpr pid_t kShell = 10;
+constexpr pid_t kCrawler = 20;
+constexpr pid_t kIndexer = 30;
+
+/**
+ * Classifies every pid from kCrawler on as a background process rather than
+ * looking up process names.
+ */
+class TestAdmissionControl : public PriorityLaneAdmissionControl {
+ public:
+  explicit TestAdmissionControl(Limits limits)
+      : PriorityLaneAdmissionControl{
+            std::make_shared<ProcessNameCache>(),
+            {},
+            limits} {}
+
+ protected:
+  std::optional<Lane> classify(pid_t pid) override {
+    return pid >= kCrawler ? Lane::Background : Lane::Interactive;
+  }
+};
+
+} // namespace
+
+// The admissions are checked on SemiFutures, since ImmediateFuture::isReady()
+// is always false in debug builds.
+
+TEST(FuseAdmissionControlTest, interactiveRequestsAreNeverDelayed) {
+  TestAdmissionControl control{{/*maxRequestsPerProcess=*/1,
+                                /*maxBackgroundRequests=*/1}};
+  EXPECT_TRUE(control.admit(kCrawler).semi().isReady());
+  auto crawler = control.admit(kCrawler).semi();
+  EXPECT_FALSE(crawler.isReady());
+
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(control.admit(kShell).semi().isReady());
+  }
+  EXPECT_EQ(1, control.getWaitingCount());
+
+  for (int i = 0; i < 10; ++i) {
+    control.release(kShell);
+  }
+  EXPECT_FALSE(crawler.isReady());
+  control.release(kCrawler);
+  EXPECT_TRUE(crawler.isReady());
+  EXPECT_EQ(0, control.getWaitingCount());
+}
+
+TEST(FuseAdmissionControlTest, perProcessLimit) {
+  TestAdmissionControl control{{/*maxRequestsPerProcess=*/2,
+                                /*maxBackgroundRequests=*/0}};
+  EXPECT_TRUE(control.admit(kCrawler).semi().isReady());
+  EXPECT_TRUE(control.admit(kCrawler).semi().isReady());
+  auto third = control.admit(kCrawler).semi();
+  EXPECT_FALSE(third.isReady());
+
+  // Other background processes have their own limit.
+  EXPECT_TRUE(control.admit(kIndexer).semi().isReady());
+
+  control.release(kCrawler);
+  EXPECT_TRUE(third.isReady());
+}
+
+TEST(FuseAdmissionControlTest, backgroundProcessesTakeTurns) {
+  TestAdmissionControl control{{/*maxRequestsPerProcess=*/0,
+                                /*maxBackgroundRequests=*/1}};
+  EXPECT_TRUE(control.admit(kCrawler).semi().isReady());
+  auto crawler1 = control.admit(kCrawler).semi();
+  auto crawler2 = control.admit(kCrawler).semi();
+  auto indexer = control.admit(kIndexer).semi();
+  EXPECT_EQ(3, control.getWaitingCount());
+
+  control.release(kCrawler);
+  EXPECT_TRUE(crawler1.isReady());
+  EXPECT_FALSE(crawler2.isReady());
+  EXPECT_FALSE(indexer.isReady());
+
+  // The indexer goes before the crawler's next request.
+  control.release(kCrawler);
+  EXPECT_TRUE(indexer.isReady());
+  EXPECT_FALSE(crawler2.isReady());
+
+  control.release(kIndexer);
+  EXPECT_TRUE(crawler2.isReady());
+  EXPECT_EQ(0, control.getWaitingCount());
+}
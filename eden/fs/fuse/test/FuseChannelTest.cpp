@@ -11,6 +11,7 @@
 #include <folly/logging/xlog.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#include <thread>
 #include <unordered_map>
 #include "eden/common/utils/ProcessNameCache.h"
 #include "eden/fs/fuse/FuseDispatcher.h"
@@ -66,7 +67,11 @@ fuse_entry_out genRandomLookupResponse(uint64_t nodeid) {
 class FuseChannelTest : public ::testing::Test {
  protected:
   unique_ptr<FuseChannel, FuseChannelDeleter> createChannel(
-      size_t numThreads = 2) {
+      size_t numThreads = 2,
+      bool cloneDevice = false,
+      bool pinWorkerThreads = false,
+      size_t numInvalidationThreads = 1,
+      std::chrono::nanoseconds slowRequestThreshold = std::chrono::seconds(1)) {
     auto testDispatcher = std::make_unique<TestDispatcher>(&stats_);
     dispatcher_ = testDispatcher.get();
     return unique_ptr<FuseChannel, FuseChannelDeleter>(new FuseChannel(
@@ -82,7 +87,13 @@ class FuseChannelTest : public ::testing::Test {
         CaseSensitivity::Sensitive,
         /*requireUtf8Path=*/true,
         /*maximumBackgroundRequests=*/12,
-        /*useWriteBackCache=*/false));
+        /*useWriteBackCache=*/false,
+        cloneDevice,
+        pinWorkerThreads,
+        /*spliceReads=*/false,
+        /*readdirPlus=*/false,
+        numInvalidationThreads,
+        slowRequestThreshold));
   }
 
   FuseChannel::StopFuture performInit(
@@ -374,3 +385,104 @@ TEST_F(FuseChannelTest, interruptLookups) {
     EXPECT_EQ(requestId, received.header.unique);
   }
 }
+
+TEST_F(FuseChannelTest, latenciesAreRecordedAndSlowRequestsCounted) {
+  auto channel = createChannel(
+      /*numThreads=*/2,
+      /*cloneDevice=*/false,
+      /*pinWorkerThreads=*/false,
+      /*numInvalidationThreads=*/1,
+      /*slowRequestThreshold=*/std::chrono::milliseconds(100));
+  auto completeFuture = performInit(channel.get());
+  auto* histogram = channel->getLatencyHistogram(FUSE_LOOKUP);
+  ASSERT_NE(nullptr, histogram);
+  EXPECT_EQ(nullptr, channel->getLatencyHistogram(FUSE_INTERRUPT));
+
+  auto fastId = fuse_.sendLookup(FUSE_ROOT_ID, "fast");
+  dispatcher_->waitForLookup(fastId).promise.setValue(
+      genRandomLookupResponse(5));
+  EXPECT_EQ(fastId, fuse_.recvResponse().header.unique);
+
+  auto slowId = fuse_.sendLookup(FUSE_ROOT_ID, "slow");
+  auto slowRequest = dispatcher_->waitForLookup(slowId);
+  /* sleep override */ std::this_thread::sleep_for(
+      std::chrono::milliseconds(200));
+  slowRequest.promise.setValue(genRandomLookupResponse(6));
+  EXPECT_EQ(slowId, fuse_.recvResponse().header.unique);
+
+  // The latencies are recorded once the responses are sent.
+  auto deadline = std::chrono::steady_clock::now() + kTimeout;
+  while (histogram->getCount() < 2 &&
+         std::chrono::steady_clock::now() < deadline) {
+    /* sleep override */ std::this_thread::sleep_for(
+        std::chrono::milliseconds(1));
+  }
+  EXPECT_EQ(2, histogram->getCount());
+  EXPECT_EQ(1, channel->getSlowRequestCount());
+  EXPECT_GE(histogram->getPercentile(100), 200000);
+}
+
+TEST_F(FuseChannelTest, workersShareTheDeviceWhenItCannotBeCloned) {
+  // The fake FUSE device is a socket, which can't be cloned, so the worker
+  // threads all fall back to reading from it.
+  auto channel = createChannel(
+      /*numThreads=*/4, /*cloneDevice=*/true, /*pinWorkerThreads=*/true);
+  auto completeFuture = performInit(channel.get());
+
+  for (int i = 0; i < 100; ++i) {
+    auto requestId = fuse_.sendLookup(FUSE_ROOT_ID, "foo");
+    auto req = dispatcher_->waitForLookup(requestId);
+    req.promise.setValue(genRandomLookupResponse(5 + i));
+
+    auto received = fuse_.recvResponse();
+    EXPECT_EQ(requestId, received.header.unique);
+    EXPECT_EQ(0, received.header.error);
+  }
+}
+
+TEST_F(FuseChannelTest, invalidationsAreSentOnceBetweenFlushes) {
+  auto channel = createChannel(
+      /*numThreads=*/2,
+      /*cloneDevice=*/false,
+      /*pinWorkerThreads=*/false,
+      /*numInvalidationThreads=*/3);
+  auto completeFuture = performInit(channel.get());
+
+  channel->invalidateInode(InodeNumber{5}, 10, 20);
+  channel->invalidateInode(InodeNumber{5}, 0, 0);
+  channel->invalidateInode(InodeNumber{5}, 0, 0);
+  channel->invalidateInode(InodeNumber{6}, -1, 0);
+  channel->invalidateInode(InodeNumber{6}, -1, 0);
+  channel->invalidateEntry(kRootNodeId, "a"_pc);
+  channel->invalidateEntry(kRootNodeId, "a"_pc);
+  channel->invalidateEntry(kRootNodeId, "b"_pc);
+  channel->flushInvalidations().get(kTimeout);
+
+  // Everything was sent by the time the flush completed.
+  fuse_.setTimeout(10ms);
+  std::unordered_map<uint64_t, fuse_notify_inval_inode_out> inodes;
+  size_t entries = 0;
+  for (const auto& response : fuse_.getAllResponses()) {
+    EXPECT_EQ(0, response.header.unique);
+    if (response.header.error == FUSE_NOTIFY_INVAL_INODE) {
+      ASSERT_EQ(sizeof(fuse_notify_inval_inode_out), response.body.size());
+      fuse_notify_inval_inode_out out;
+      memcpy(&out, response.body.data(), sizeof(out));
+      EXPECT_TRUE(inodes.emplace(out.ino, out).second);
+    } else {
+      EXPECT_EQ(FUSE_NOTIFY_INVAL_ENTRY, response.header.error);
+      ++entries;
+    }
+  }
+  // Invalidating all of inode 5 subsumes invalidating part of it.
+  ASSERT_EQ(2, inodes.size());
+  EXPECT_EQ(0, inodes[5].off);
+  EXPECT_EQ(0, inodes[5].len);
+  EXPECT_EQ(-1, inodes[6].off);
+  EXPECT_EQ(2, entries);
+
+  // Invalidations queued after a flush are sent again.
+  channel->invalidateEntry(kRootNodeId, "a"_pc);
+  channel->flushInvalidations().get(kTimeout);
+  EXPECT_EQ(1, fuse_.getAllResponses().size());
+}
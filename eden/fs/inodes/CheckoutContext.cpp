@@ -7,6 +7,8 @@
 
 #include "eden/fs/inodes/CheckoutContext.h"
 
+#include <folly/ScopeGuard.h>
+#include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 #include <folly/system/Pid.h>
 #include <optional>
@@ -15,6 +17,7 @@
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/InodePtr.h"
 #include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
 
 using folly::Future;
 using std::vector;
@@ -33,7 +36,8 @@ CheckoutContext::CheckoutContext(
           clientPid,
           ObjectFetchContext::Cause::Thrift,
           thriftMethodName,
-          requestInfo)} {}
+          requestInfo)},
+      parallelism_{mount->getEdenConfig()->checkoutParallelism.getValue()} {}
 
 CheckoutContext::~CheckoutContext() {}
 
@@ -110,6 +114,38 @@ Future<vector<CheckoutConflict>> CheckoutContext::flush() {
   return std::move(*conflicts_.wlock());
 }
 
+Future<folly::Unit> CheckoutContext::checkoutSubtree(
+    folly::Function<Future<folly::Unit>()> checkout) {
+  auto inFlight = subtreesInFlight_.fetch_add(1, std::memory_order_relaxed);
+  if (inFlight >= parallelism_) {
+    subtreesInFlight_.fetch_sub(1, std::memory_order_relaxed);
+    return checkout();
+  }
+
+  subtreesScheduled_.fetch_add(1, std::memory_order_relaxed);
+  return folly::via(
+      mount_->getServerThreadPool().get(),
+      [this, checkout = std::move(checkout)]() mutable {
+        // Only the synchronous part occupies a thread: the rest of the
+        // checkout of the subtree runs as its loads complete.
+        SCOPE_EXIT {
+          subtreesInFlight_.fetch_sub(1, std::memory_order_relaxed);
+        };
+        return checkout();
+      });
+}
+
+CheckoutProgress CheckoutContext::getProgress() const {
+  CheckoutProgress progress;
+  progress.treesCompared = treesCompared_.load(std::memory_order_relaxed);
+  progress.actionsStarted = actionsStarted_.load(std::memory_order_relaxed);
+  progress.actionsCompleted = actionsCompleted_.load(std::memory_order_relaxed);
+  progress.treesSaved = treesSaved_.load(std::memory_order_relaxed);
+  progress.subtreesScheduled =
+      subtreesScheduled_.load(std::memory_order_relaxed);
+  return progress;
+}
+
 void CheckoutContext::addConflict(ConflictType type, RelativePathPiece path) {
   // Errors should be added using addError()
   XCHECK(type != ConflictType::ERROR)
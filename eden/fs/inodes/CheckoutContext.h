@@ -7,10 +7,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <optional>
 #include <unordered_map>
 #include <vector>
 
+#include <folly/Function.h>
 #include <folly/Range.h>
 #include <folly/Synchronized.h>
 #include <folly/stop_watch.h>
@@ -140,6 +142,37 @@ class CheckoutContext {
     return fetchContext_.as<ObjectFetchContext>();
   }
 
+  /**
+   * Check out a subdirectory.
+   *
+   * The checkout is queued on the server thread pool while fewer than
+   * `mount:checkout-parallelism` of them are queued or running their
+   * synchronous part there, so that the idle threads share the directories
+   * of a large checkout. Otherwise it runs on the calling thread, which keeps
+   * the queue bounded.
+   */
+  folly::Future<folly::Unit> checkoutSubtree(
+      folly::Function<folly::Future<folly::Unit>()> checkout);
+
+  void recordTreeCompared() {
+    treesCompared_.fetch_add(1, std::memory_order_relaxed);
+  }
+  void recordActionsStarted(size_t count) {
+    actionsStarted_.fetch_add(count, std::memory_order_relaxed);
+  }
+  void recordActionsCompleted(size_t count) {
+    actionsCompleted_.fetch_add(count, std::memory_order_relaxed);
+  }
+  void recordTreeSaved() {
+    treesSaved_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns how far the checkout went so far. May be called from any thread
+   * while the checkout runs.
+   */
+  CheckoutProgress getProgress() const;
+
  private:
   CheckoutMode checkoutMode_;
   EdenMount* const mount_;
@@ -150,5 +183,16 @@ class CheckoutContext {
   // if some data load operations complete asynchronously on other threads.
   // Therefore access to the conflicts list must be synchronized.
   folly::Synchronized<std::vector<CheckoutConflict>> conflicts_;
+
+  const size_t parallelism_;
+  // Subdirectory checkouts queued on the server thread pool or running their
+  // synchronous part there.
+  std::atomic<size_t> subtreesInFlight_{0};
+
+  std::atomic<size_t> treesCompared_{0};
+  std::atomic<size_t> actionsStarted_{0};
+  std::atomic<size_t> actionsCompleted_{0};
+  std::atomic<size_t> treesSaved_{0};
+  std::atomic<size_t> subtreesScheduled_{0};
 };
 } // namespace facebook::eden
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/CompactDirContents.h"
+
+#include <folly/Memory.h>
+#include <folly/Range.h>
+#include <folly/Utility.h>
+#include <algorithm>
+#include <limits>
+#include <string_view>
+#include "eden/fs/inodes/Overlay.h"
+#include "eden/fs/model/Tree.h"
+
+namespace facebook::eden {
+
+CompactDirContents::CompactDirContents(
+    const Tree& tree,
+    CaseSensitivity caseSensitive)
+    : caseSensitive_{caseSensitive} {
+  std::vector<const Tree::value_type*> sorted;
+  sorted.reserve(tree.size());
+  size_t namesSize = 0;
+  size_t hashesSize = 0;
+  for (const auto& entry : tree) {
+    sorted.push_back(&entry);
+    namesSize += entry.first.value().size();
+    hashesSize += entry.second.getHash().size();
+  }
+  XCHECK_LE(namesSize, std::numeric_limits<uint32_t>::max());
+  XCHECK_LE(hashesSize, std::numeric_limits<uint32_t>::max());
+
+  // The Tree is sorted according to its own case sensitivity, which may not be
+  // the one of the mount.
+  if (tree.getCaseSensitivity() != caseSensitive) {
+    std::sort(sorted.begin(), sorted.end(), [&](auto* lhs, auto* rhs) {
+      return isPathPieceLess(lhs->first, rhs->first, caseSensitive);
+    });
+  }
+
+  names_.reserve(namesSize);
+  nameOffsets_.reserve(sorted.size() + 1);
+  hashes_.reserve(hashesSize);
+  hashOffsets_.reserve(sorted.size() + 1);
+  types_.reserve(sorted.size());
+
+  nameOffsets_.push_back(0);
+  hashOffsets_.push_back(0);
+  for (const auto* entry : sorted) {
+    names_.append(entry->first.value().data(), entry->first.value().size());
+    nameOffsets_.push_back(folly::to_narrow(names_.size()));
+
+    auto hash = folly::StringPiece{entry->second.getHash().getBytes()};
+    hashes_.append(hash.data(), hash.size());
+    hashOffsets_.push_back(folly::to_narrow(hashes_.size()));
+
+    types_.push_back(entry->second.getType());
+  }
+  inodeNumbers_.resize(sorted.size(), 0);
+}
+
+std::optional<size_t> CompactDirContents::find(PathComponentPiece name) const {
+  size_t low = 0;
+  size_t high = size();
+  while (low < high) {
+    auto mid = low + (high - low) / 2;
+    if (isPathPieceLess(getName(mid), name, caseSensitive_)) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  if (low == size() || isPathPieceLess(name, getName(low), caseSensitive_)) {
+    return std::nullopt;
+  }
+  return low;
+}
+
+PathComponentPiece CompactDirContents::getName(size_t index) const {
+  auto start = nameOffsets_[index];
+  auto end = nameOffsets_[index + 1];
+  // The names were validated when the Tree was built.
+  return PathComponentPiece{
+      std::string_view{names_.data() + start, end - start},
+      detail::SkipPathSanityCheck{}};
+}
+
+ObjectId CompactDirContents::getHash(size_t index) const {
+  auto start = hashOffsets_[index];
+  auto end = hashOffsets_[index + 1];
+  return ObjectId{folly::ByteRange{
+      folly::StringPiece{hashes_.data() + start, hashes_.data() + end}}};
+}
+
+InodeNumber CompactDirContents::getInodeNumber(
+    size_t index,
+    Overlay& overlay) {
+  auto& raw = inodeNumbers_[index];
+  if (raw == 0) {
+    raw = overlay.allocateInodeNumber().get();
+  }
+  return InodeNumber{raw};
+}
+
+DirContents CompactDirContents::toDirContents(Overlay& overlay) && {
+  DirContents dir(caseSensitive_);
+  dir.reserve(size());
+  for (size_t i = 0; i < size(); ++i) {
+    // The entries are sorted, so every emplace appends to the vector.
+    dir.emplace(
+        getName(i), getInitialMode(i), getInodeNumber(i, overlay), getHash(i));
+  }
+  return dir;
+}
+
+size_t CompactDirContents::getSizeBytes() const {
+  return sizeof(*this) + folly::goodMallocSize(names_.capacity()) +
+      folly::goodMallocSize(hashes_.capacity()) +
+      folly::goodMallocSize(nameOffsets_.capacity() * sizeof(uint32_t)) +
+      folly::goodMallocSize(hashOffsets_.capacity() * sizeof(uint32_t)) +
+      folly::goodMallocSize(types_.capacity() * sizeof(TreeEntryType)) +
+      folly::goodMallocSize(inodeNumbers_.capacity() * sizeof(uint64_t));
+}
+
+} // namespace facebook::eden
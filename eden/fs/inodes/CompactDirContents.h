@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+#include "eden/fs/inodes/DirEntry.h"
+#include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/model/TreeEntry.h"
+#include "eden/fs/utils/CaseSensitivity.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class Overlay;
+class Tree;
+
+/**
+ * A read-only representation of the entries of an unmaterialized directory,
+ * for directories too large to be held as DirContents.
+ *
+ * Every DirContents entry costs a PathComponent, a DirEntry and, for long
+ * hashes, a heap allocated ObjectId. Here, names and hashes are instead
+ * interned in two arenas and the entries are laid out as a structure of
+ * arrays, so that an entry only costs its name and hash bytes plus about 17
+ * bytes of bookkeeping.
+ *
+ * Inode numbers are only allocated when an entry's inode number is first
+ * requested, e.g. on lookup, rather than for every entry when the directory is
+ * loaded. Entries are identified by their index, in the same order as the
+ * DirContents built from the same Tree.
+ *
+ * The directory is converted to DirContents with toDirContents() before its
+ * first mutation, which allocates the remaining inode numbers. The caller
+ * holds the TreeInode's contents lock for all non-const methods.
+ */
+class CompactDirContents {
+ public:
+  CompactDirContents(const Tree& tree, CaseSensitivity caseSensitive);
+
+  CompactDirContents(CompactDirContents&&) = default;
+  CompactDirContents& operator=(CompactDirContents&&) = default;
+  CompactDirContents(const CompactDirContents&) = delete;
+  CompactDirContents& operator=(const CompactDirContents&) = delete;
+
+  size_t size() const {
+    return types_.size();
+  }
+
+  bool empty() const {
+    return types_.empty();
+  }
+
+  CaseSensitivity getCaseSensitivity() const {
+    return caseSensitive_;
+  }
+
+  /**
+   * Index of the entry named name, honoring the case sensitivity of the
+   * directory, or std::nullopt if there is no such entry.
+   */
+  std::optional<size_t> find(PathComponentPiece name) const;
+
+  PathComponentPiece getName(size_t index) const;
+
+  ObjectId getHash(size_t index) const;
+
+  TreeEntryType getType(size_t index) const {
+    return types_[index];
+  }
+
+  /**
+   * Same as DirEntry::getInitialMode().
+   */
+  mode_t getInitialMode(size_t index) const {
+    return modeFromTreeEntryType(types_[index]);
+  }
+
+  dtype_t getDtype(size_t index) const {
+    return mode_to_dtype(getInitialMode(index));
+  }
+
+  /**
+   * The inode number of the entry, allocated from the overlay on first call.
+   */
+  InodeNumber getInodeNumber(size_t index, Overlay& overlay);
+
+  /**
+   * The inode number of the entry if it was already allocated, an empty
+   * InodeNumber otherwise.
+   */
+  InodeNumber getAllocatedInodeNumber(size_t index) const {
+    auto raw = inodeNumbers_[index];
+    return raw ? InodeNumber{raw} : InodeNumber{};
+  }
+
+  /**
+   * Build the DirContents of this directory, allocating the inode numbers
+   * that weren't yet. The inode numbers aren't saved in the overlay: as for
+   * TreeInode::buildDirFromTree(), this is up to the caller.
+   */
+  DirContents toDirContents(Overlay& overlay) &&;
+
+  /**
+   * An estimate of the memory footprint of the directory.
+   */
+  size_t getSizeBytes() const;
+
+ private:
+  /**
+   * Arenas of the concatenated names and hashes of the entries. The entry at
+   * index i spans from offsets[i] to offsets[i + 1].
+   */
+  std::string names_;
+  std::vector<uint32_t> nameOffsets_;
+  std::string hashes_;
+  std::vector<uint32_t> hashOffsets_;
+
+  std::vector<TreeEntryType> types_;
+  // Raw InodeNumbers, 0 until allocated.
+  std::vector<uint64_t> inodeNumbers_;
+
+  CaseSensitivity caseSensitive_;
+};
+
+} // namespace facebook::eden
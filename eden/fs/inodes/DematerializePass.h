@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <atomic>
+#include <cstdint>
+
+#include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/inodes/InodeTimestamps.h"
+
+namespace facebook::eden {
+
+/**
+ * Statistics of a pass of EdenMount::dematerializeUnchangedFiles().
+ */
+struct DematerializePassStats {
+  // Materialized files hashed and compared with the checked out commit.
+  size_t checked = 0;
+  uint64_t bytesHashed = 0;
+  size_t dematerialized = 0;
+  // Whether the pass stopped at one of its limits, leaving the files it
+  // didn't get to to the next passes.
+  bool rateLimited = false;
+};
+
+/**
+ * The state shared by every directory visited by a pass of
+ * EdenMount::dematerializeUnchangedFiles(). Directories are visited
+ * concurrently, so this is safe to use from arbitrary threads.
+ */
+class DematerializePass {
+ public:
+  using FileMtimes = folly::F14FastMap<InodeNumber, EdenTimestamp>;
+
+  /**
+   * Files are only hashed if they were last modified before modifiedBefore,
+   * and the pass stops once it hashed maxFiles files or maxBytes bytes. A
+   * limit of 0 means no limit.
+   *
+   * Files in knownDifferent were found to differ from the checked out commit
+   * by earlier passes, and are skipped unless modified since.
+   */
+  DematerializePass(
+      size_t maxFiles,
+      uint64_t maxBytes,
+      EdenTimestamp modifiedBefore,
+      FileMtimes knownDifferent)
+      : maxFiles_{maxFiles},
+        maxBytes_{maxBytes},
+        modifiedBefore_{modifiedBefore},
+        knownDifferent_{std::move(knownDifferent)} {}
+
+  /**
+   * Whether the file should be hashed, given its last modification time.
+   * The files skipped because they're known to differ are remembered as
+   * different again.
+   */
+  bool shouldCheck(InodeNumber ino, EdenTimestamp mtime) {
+    if (!(mtime < modifiedBefore_)) {
+      return false;
+    }
+    auto it = knownDifferent_.find(ino);
+    if (it != knownDifferent_.end() && it->second == mtime) {
+      recordDifferent(ino, mtime);
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Reserve the budget to hash a file of `size` bytes. Returns false once the
+   * pass is out of budget.
+   */
+  bool tryStartCheck(uint64_t size) {
+    if ((maxFiles_ != 0 && checked_.load() >= maxFiles_) ||
+        (maxBytes_ != 0 && bytesHashed_.load() >= maxBytes_)) {
+      rateLimited_.store(true);
+      return false;
+    }
+    checked_.fetch_add(1);
+    bytesHashed_.fetch_add(size);
+    return true;
+  }
+
+  bool isRateLimited() const {
+    return rateLimited_.load();
+  }
+
+  void recordDifferent(InodeNumber ino, EdenTimestamp mtime) {
+    foundDifferent_.wlock()->insert_or_assign(ino, mtime);
+  }
+
+  void recordDematerialized() {
+    dematerialized_.fetch_add(1);
+  }
+
+  /**
+   * The files found to differ by this pass, including the ones skipped
+   * because they were known to.
+   */
+  FileMtimes takeFoundDifferent() {
+    return std::move(*foundDifferent_.wlock());
+  }
+
+  DematerializePassStats getStats() const {
+    DematerializePassStats stats;
+    stats.checked = checked_.load();
+    stats.bytesHashed = bytesHashed_.load();
+    stats.dematerialized = dematerialized_.load();
+    stats.rateLimited = rateLimited_.load();
+    return stats;
+  }
+
+ private:
+  const size_t maxFiles_;
+  const uint64_t maxBytes_;
+  const EdenTimestamp modifiedBefore_;
+  const FileMtimes knownDifferent_;
+
+  folly::Synchronized<FileMtimes> foundDifferent_;
+  std::atomic<size_t> checked_{0};
+  std::atomic<uint64_t> bytesHashed_{0};
+  std::atomic<size_t> dematerialized_{0};
+  std::atomic<bool> rateLimited_{false};
+};
+
+} // namespace facebook::eden
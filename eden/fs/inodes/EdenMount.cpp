@@ -13,6 +13,7 @@
 #include <folly/File.h>
 #include <folly/chrono/Conv.h>
 #include <folly/futures/Future.h>
+#include <folly/futures/FutureSplitter.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/logging/Logger.h>
 #include <folly/logging/xlog.h>
@@ -23,6 +24,7 @@
 
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/config/MountProtocol.h"
+#include "eden/fs/fuse/FuseAdmissionControl.h"
 #include "eden/fs/fuse/FuseChannel.h"
 #include "eden/fs/fuse/privhelper/PrivHelper.h"
 #include "eden/fs/inodes/CheckoutContext.h"
@@ -43,6 +45,7 @@
 #include "eden/fs/prjfs/PrjfsChannel.h"
 #include "eden/fs/service/PrettyPrinters.h"
 #include "eden/fs/service/gen-cpp2/eden_types.h"
+#include "eden/fs/store/BackingStore.h"
 #include "eden/fs/store/BlobAccess.h"
 #include "eden/fs/store/Diff.h"
 #include "eden/fs/store/DiffCallback.h"
@@ -63,6 +66,10 @@
 #include "eden/fs/utils/SpawnedProcess.h"
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
 
+#ifndef _WIN32
+#include "eden/fs/inodes/fscatalog/SegmentInodeCatalog.h"
+#endif
+
 #include <chrono>
 
 using folly::Future;
@@ -101,14 +108,47 @@ void InodeTraceEvent::setPath(std::string_view stringPath) {
   path[stringPath.size()] = 0;
 }
 
+void ActivityBufferCodec<InodeTraceEvent>::encode(
+    const InodeTraceEvent& event,
+    std::string& out) {
+  ActivityBufferEncoding::append(out, event.systemTime);
+  ActivityBufferEncoding::append(out, event.monotonicTime);
+  ActivityBufferEncoding::append(out, event.ino);
+  ActivityBufferEncoding::append(out, event.inodeType);
+  ActivityBufferEncoding::append(out, event.eventType);
+  ActivityBufferEncoding::append(out, event.progress);
+  ActivityBufferEncoding::append(out, event.duration);
+  ActivityBufferEncoding::append(out, event.loadPhases);
+  if (event.path) {
+    out.append(event.path.get());
+  }
+}
+
+InodeTraceEvent ActivityBufferCodec<InodeTraceEvent>::decode(
+    folly::ByteRange in) {
+  InodeTraceEvent event;
+  event.systemTime =
+      ActivityBufferEncoding::read<std::chrono::system_clock::time_point>(in);
+  event.monotonicTime =
+      ActivityBufferEncoding::read<std::chrono::steady_clock::time_point>(in);
+  event.ino = ActivityBufferEncoding::read<InodeNumber>(in);
+  event.inodeType = ActivityBufferEncoding::read<InodeType>(in);
+  event.eventType = ActivityBufferEncoding::read<InodeEventType>(in);
+  event.progress = ActivityBufferEncoding::read<InodeEventProgress>(in);
+  event.duration = ActivityBufferEncoding::read<std::chrono::microseconds>(in);
+  event.loadPhases = ActivityBufferEncoding::read<InodeLoadPhases>(in);
+  event.path = ActivityBufferEncoding::readRemainingString(in);
+  return event;
+}
+
 // These static asserts exist to make explicit the memory usage of the per-mount
 // InodeTraceBus. TraceBus uses 2 * capacity * sizeof(TraceEvent) memory usage,
 // so limit total memory usage to around 0.67 MB per mount. Note
 // InodeTraceEvents do include pointers to path info that is saved on the heap,
 // and there is memory usage of this data outside of the mount (by the
 // EdenServiceHandler during eden trace inode calls)
-constexpr size_t kInodeTraceBusCapacity = 25000;
-static_assert(CheckSize<InodeTraceEvent, 64>());
+constexpr size_t kInodeTraceBusCapacity = 20000;
+static_assert(CheckSize<InodeTraceEvent, 80>());
 static_assert(
     CheckEqual<1600000, kInodeTraceBusCapacity * sizeof(InodeTraceEvent)>());
 
@@ -125,6 +165,37 @@ constexpr PathComponentPiece kNfsdSocketName{"nfsd.socket"_pc};
 } // namespace
 #endif
 
+namespace {
+/**
+ * The DiffCallback of EdenMount::prefetchCheckoutObjects(), which only diffs
+ * for the fetches it makes.
+ */
+class CheckoutPrefetchCallback : public DiffCallback {
+ public:
+  void ignoredPath(RelativePathPiece, dtype_t) override {}
+
+  void addedPath(RelativePathPiece, dtype_t) override {
+    changedPaths.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void removedPath(RelativePathPiece, dtype_t) override {
+    changedPaths.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void modifiedPath(RelativePathPiece, dtype_t) override {
+    changedPaths.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void diffError(RelativePathPiece path, const folly::exception_wrapper& ew)
+      override {
+    XLOG(DBG3) << "error prefetching " << path
+               << " for checkout: " << folly::exceptionStr(ew);
+  }
+
+  std::atomic<size_t> changedPaths{0};
+};
+} // namespace
+
 /**
  * Helper for computing unclean paths when changing parents
  *
@@ -203,10 +274,9 @@ constexpr int EdenMount::kMaxSymlinkChainDepth;
 static constexpr folly::StringPiece kEdenStracePrefix = "eden.strace.";
 
 // We compute this when the process is initialized, but stash a copy
-// in each EdenMount.  We may in the future manage to propagate enough
-// state across upgrades or restarts that we can preserve this, but
-// as implemented today, a process restart will invalidate any cached
-// mountGeneration that a client may be holding on to.
+// in each EdenMount.  Unless the journal restored the generation of its
+// deltas from before the restart, a process restart will invalidate any
+// cached mountGeneration that a client may be holding on to.
 // We take the bottom 16-bits of the pid and 32-bits of the current
 // time and shift them up, leaving 16 bits for a mount point generation
 // number.
@@ -265,10 +335,14 @@ EdenMount::EdenMount(
           serverState_->getStructuredLogger(),
           *serverState_->getEdenConfig())},
 #ifndef _WIN32
-      overlayFileAccess_{overlay_.get()},
+      overlayFileAccess_{
+          overlay_.get(),
+          serverState_->getEdenConfig()->overlayWriteBufferSize.getValue(),
+          serverState_->getEdenConfig()->overlayWriteBufferMaxDelay.getValue()},
 #endif
       journal_{std::move(journal)},
-      mountGeneration_{globalProcessGeneration | ++mountGeneration},
+      mountGeneration_{journal_->getRestoredMountGeneration().value_or(
+          globalProcessGeneration | ++mountGeneration)},
       straceLogger_{
           kEdenStracePrefix.str() + checkoutConfig_->getMountPath().value()},
       lastCheckoutTime_{EdenTimestamp{serverState_->getClock()->getRealtime()}},
@@ -277,7 +351,18 @@ EdenMount::EdenMount(
       inodeTraceBus_{
           TraceBus<InodeTraceEvent>::create("inode", kInodeTraceBusCapacity)},
       clock_{serverState_->getClock()} {
+  journal_->setMountGeneration(mountGeneration_);
   subscribeInodeActivityBuffer();
+  if (auto cacheSize = getEdenConfig()->pathLookupCacheSize.getValue()) {
+    pathLookupCache_ =
+        std::make_unique<PathLookupCache>(folly::in_place, cacheSize);
+  }
+  if (getEdenConfig()->migrateLegacyObjectIds.getValue()) {
+    overlay_->setObjectIdMigrator(
+        [backingStore = objectStore_->getBackingStore()](const ObjectId& id) {
+          return backingStore->migrateObjectId(id);
+        });
+  }
 }
 
 Overlay::InodeCatalogType EdenMount::getInodeCatalogType(
@@ -311,6 +396,13 @@ Overlay::InodeCatalogType EdenMount::getInodeCatalogType(
     }
     return Overlay::InodeCatalogType::Tree;
   } else {
+#ifndef _WIN32
+    if (SegmentInodeCatalog::shouldUse(
+            checkoutConfig_->getOverlayPath(),
+            getEdenConfig()->overlaySegmentCatalog.getValue())) {
+      return Overlay::InodeCatalogType::Segment;
+    }
+#endif
     return Overlay::InodeCatalogType::Legacy;
   }
 }
@@ -390,67 +482,116 @@ FOLLY_NODISCARD folly::Future<folly::Unit> EdenMount::initialize(
   return serverState_->getFaultInjector()
       .checkAsync("mount", getPath().view())
       .via(getServerThreadPool().get())
-      .thenValue([this, parent](auto&&) {
-        return objectStore_->getRootTree(parent, context)
-            .semi()
-            .via(&folly::QueuedImmediateExecutor::instance());
-      })
       .thenValue([this,
-                  progressCallback = std::move(progressCallback),
                   parent,
+                  progressCallback = std::move(progressCallback),
                   workingCopyParentRootId = parentCommit.getWorkingCopyParent(),
                   inProgressCheckout = parentCommit.isCheckoutInProgress(),
                   checkoutOriginalDest = parentCommit.getLastCheckoutId(
                       ParentCommit::RootIdPreference::To),
                   checkoutOriginalSrc = parentCommit.getLastCheckoutId(
                       ParentCommit::RootIdPreference::From),
-                  checkoutPid = parentCommit.getInProgressPid()](
-                     std::shared_ptr<const Tree> parentTree) mutable {
-        std::optional<std::tuple<RootId, RootId>> originalCheckoutTrees =
-            std::nullopt;
-        if (inProgressCheckout) {
-          originalCheckoutTrees = {std::make_tuple(
-              checkoutOriginalSrc.value(), checkoutOriginalDest.value())};
-        }
-        *parentState_.wlock() = ParentCommitState{
-            parent,
-            parentTree,
-            workingCopyParentRootId,
-            inProgressCheckout,
-            originalCheckoutTrees,
-            checkoutPid,
-        };
-
-        // Record the transition from no snapshot to the current snapshot in
-        // the journal.  This also sets things up so that we can carry the
-        // snapshot id forward through subsequent journal entries.
-        journal_->recordHashUpdate(parent);
+                  checkoutPid =
+                      parentCommit.getInProgressPid()](auto&&) mutable {
+        // The root tree is fetched while the overlay is initialized: neither
+        // needs the other, except for the few lookups a consistency check
+        // may do, which wait for the tree.
+        auto rootTreeStart = std::chrono::steady_clock::now();
+        auto rootTree = std::make_shared<
+            folly::FutureSplitter<std::shared_ptr<const Tree>>>(
+            objectStore_->getRootTree(parent, context)
+                .semi()
+                .via(&folly::QueuedImmediateExecutor::instance()));
+
+        auto rootTreeFuture =
+            rootTree->getFuture().thenValue([this,
+                                             rootTreeStart,
+                                             parent,
+                                             workingCopyParentRootId,
+                                             inProgressCheckout,
+                                             checkoutOriginalDest,
+                                             checkoutOriginalSrc,
+                                             checkoutPid](
+                                                std::shared_ptr<const Tree>
+                                                    parentTree) {
+              initializeTimings_.rootTree =
+                  std::chrono::steady_clock::now() - rootTreeStart;
+
+              std::optional<std::tuple<RootId, RootId>> originalCheckoutTrees =
+                  std::nullopt;
+              if (inProgressCheckout) {
+                originalCheckoutTrees = {std::make_tuple(
+                    checkoutOriginalSrc.value(),
+                    checkoutOriginalDest.value())};
+              }
+              *parentState_.wlock() = ParentCommitState{
+                  parent,
+                  parentTree,
+                  workingCopyParentRootId,
+                  inProgressCheckout,
+                  originalCheckoutTrees,
+                  checkoutPid,
+              };
+
+              // Record the transition from no snapshot to the current
+              // snapshot in the journal.  This also sets things up so that we
+              // can carry the snapshot id forward through subsequent journal
+              // entries. A journal restored from before a restart already
+              // ends on the current snapshot.
+              if (!journal_->getRestoredMountGeneration()) {
+                journal_->recordHashUpdate(parent);
+              }
+              return parentTree;
+            });
 
         // Initialize the overlay.
         // This must be performed before we do any operations that may
         // allocate inode numbers, including creating the root TreeInode.
-        return overlay_
-            ->initialize(
-                getEdenConfig(),
-                getPath(),
-                std::move(progressCallback),
-                [this](RelativePathPiece path) {
-                  auto lookup = std::make_unique<TreeLookupProcessor>(
-                      path, objectStore_, context.copy());
-                  // Do the next() and the ensure() on separate lines to make
-                  // the order of 'lookup' accesses explicit, so we don't move
-                  // it before calling next.
-                  auto future = lookup->next(getCheckedOutRootTree());
-                  // The 'ensure' makes sure the lookup lasts until the future
-                  // finishes.
-                  return std::move(future).ensure(
-                      [proc = std::move(lookup)] {});
-                })
-            .deferValue([parentTree = std::move(parentTree)](auto&&) mutable {
+        auto overlayStart = std::chrono::steady_clock::now();
+        auto overlayFuture =
+            overlay_
+                ->initialize(
+                    getEdenConfig(),
+                    getPath(),
+                    std::move(progressCallback),
+                    [this, rootTree](RelativePathPiece path) {
+                      auto lookup = std::make_unique<TreeLookupProcessor>(
+                          path, objectStore_, context.copy());
+                      return ImmediateFuture<std::shared_ptr<const Tree>>{
+                          rootTree->getSemiFuture()}
+                          .thenValue([lookup = std::move(lookup)](
+                                         std::shared_ptr<const Tree>
+                                             tree) mutable {
+                            // Do the next() and the ensure() on separate
+                            // lines to make the order of 'lookup' accesses
+                            // explicit, so we don't move it before calling
+                            // next.
+                            auto future = lookup->next(std::move(tree));
+                            // The 'ensure' makes sure the lookup lasts until
+                            // the future finishes.
+                            return std::move(future).ensure(
+                                [proc = std::move(lookup)] {});
+                          });
+                    })
+                .deferValue([this, overlayStart](auto&&) {
+                  initializeTimings_.overlay =
+                      std::chrono::steady_clock::now() - overlayStart;
+                });
+
+        // Wait for both even if one fails, the other still uses this mount.
+        return folly::collectAll(
+                   std::move(rootTreeFuture), std::move(overlayFuture))
+            .via(&folly::QueuedImmediateExecutor::instance())
+            .thenValue([](std::tuple<
+                           folly::Try<std::shared_ptr<const Tree>>,
+                           folly::Try<folly::Unit>>&& results) {
+              auto parentTree = std::move(std::get<0>(results)).value();
+              std::get<1>(results).throwUnlessValue();
               return parentTree;
             });
       })
       .thenValue([this, takeover](std::shared_ptr<const Tree> parentTree) {
+        auto inodeMapStart = std::chrono::steady_clock::now();
         auto initTreeNode = createRootInode(std::move(parentTree));
         if (takeover) {
           inodeMap_->initializeFromTakeover(std::move(initTreeNode), *takeover);
@@ -459,6 +600,8 @@ FOLLY_NODISCARD folly::Future<folly::Unit> EdenMount::initialize(
         } else {
           inodeMap_->initialize(std::move(initTreeNode));
         }
+        initializeTimings_.inodeMap =
+            std::chrono::steady_clock::now() - inodeMapStart;
 
         // TODO: It would be nice if the .eden inode was created before
         // allocating inode numbers for the Tree's entries. This would give the
@@ -770,13 +913,81 @@ TreeEntryType toEdenTreeEntryType(facebook::eden::ObjectType objectType) {
   throw std::runtime_error("unsupported root type");
 }
 
+ImmediateFuture<TreeInodePtr> ensureDirectoryExistsHelper(
+    TreeInodePtr parent,
+    PathComponentPiece childName,
+    RelativePathPiece rest,
+    const ObjectFetchContextPtr& context);
+
+/**
+ * Resolves the directories a batch of setPathObjectId grafts into, creating
+ * the missing ones. Each directory is resolved once, from its own parent, so
+ * that the leading directories shared by the paths of the batch are looked up
+ * or created once rather than once per path.
+ */
+class DirectoryResolver {
+ public:
+  DirectoryResolver(TreeInodePtr root, const ObjectFetchContextPtr& context)
+      : root_{std::move(root)}, context_{context.copy()} {}
+
+  ImmediateFuture<TreeInodePtr> resolve(RelativePathPiece path) {
+    if (path.empty()) {
+      return root_;
+    }
+    auto it = directories_.find(path.view());
+    if (it != directories_.end()) {
+      if (it->second.inode) {
+        return it->second.inode;
+      }
+      return it->second.pending->getSemiFuture();
+    }
+
+    auto future = resolve(path.dirname())
+                      .thenValue([name = PathComponent{path.basename()},
+                                  context = context_.copy()](
+                                     TreeInodePtr parent) {
+                        return ensureDirectoryExistsHelper(
+                            std::move(parent),
+                            name,
+                            RelativePathPiece{},
+                            context);
+                      });
+    auto& directory = directories_[std::string{path.view()}];
+    if (future.isReady()) {
+      // Already loaded: skip the splitter, which costs an allocation and
+      // makes every waiter asynchronous. Failures aren't remembered.
+      auto inode = std::move(future).getTry();
+      if (inode.hasValue()) {
+        directory.inode = inode.value();
+      } else {
+        directories_.erase(std::string{path.view()});
+      }
+      return std::move(inode);
+    }
+    directory.pending =
+        std::make_shared<folly::FutureSplitter<TreeInodePtr>>(
+            std::move(future).semi().via(
+                &folly::QueuedImmediateExecutor::instance()));
+    return directory.pending->getSemiFuture();
+  }
+
+ private:
+  struct Directory {
+    TreeInodePtr inode;
+    std::shared_ptr<folly::FutureSplitter<TreeInodePtr>> pending;
+  };
+
+  TreeInodePtr root_;
+  ObjectFetchContextPtr context_;
+  folly::F14FastMap<std::string, Directory> directories_;
+};
+
 } // namespace
 
 ImmediateFuture<SetPathObjectIdResultAndTimes> EdenMount::setPathsToObjectIds(
     std::vector<SetPathObjectIdObjectAndPath> objects,
     CheckoutMode checkoutMode,
     const ObjectFetchContextPtr& context) {
-  std::vector<ImmediateFuture<SetPathObjectIdResultAndTimes>> futures;
   // Helper structs to heterogeneous lookup parentToObjectsMap by
   // RelativePathPiece whose index is RelativePath
   struct RelativePathHeterogeneousHasher {
@@ -829,32 +1040,34 @@ ImmediateFuture<SetPathObjectIdResultAndTimes> EdenMount::setPathsToObjectIds(
   }
   objects.clear();
 
-  for (auto& [path, objects] : parentToObjectsMap) {
-    const folly::stop_watch<> stopWatch;
-    auto setPathObjectIdTime = std::make_shared<SetPathObjectIdTimes>();
-
-    auto ctx = std::make_shared<CheckoutContext>(
-        this,
-        checkoutMode,
-        std::nullopt,
-        "setPathObjectId",
-        context->getRequestInfo());
-
-    /**
-     * This will update the timestamp for the entire mount,
-     * TODO(yipu) We should only update the timestamp for the
-     * partial node so only affects its children.
-     */
-    setLastCheckoutTime(EdenTimestamp{clock_->getRealtime()});
+  const folly::stop_watch<> stopWatch;
+  // All the groups share a single checkout context, so that the invalidations
+  // they send are flushed once, after the last of them.
+  auto ctx = std::make_shared<CheckoutContext>(
+      this,
+      checkoutMode,
+      std::nullopt,
+      "setPathObjectId",
+      context->getRequestInfo());
+
+  /**
+   * This will update the timestamp for the entire mount,
+   * TODO(yipu) We should only update the timestamp for the
+   * partial node so only affects its children.
+   */
+  setLastCheckoutTime(EdenTimestamp{clock_->getRealtime()});
 
+  DirectoryResolver directoryResolver{getRootInode(), ctx->getFetchContext()};
+  std::vector<ImmediateFuture<SetPathObjectIdTimes>> futures;
+  futures.reserve(parentToObjectsMap.size());
+  for (auto& [path, objects] : parentToObjectsMap) {
     // A special case is set root to a tree. Then setPathObjectId is essentially
     // checkout
     bool setOnRoot = path.empty() && objects.size() == 1 &&
         objects.at(0).path.empty() &&
         facebook::eden::ObjectType::TREE == objects.at(0).type;
 
-    auto getTargetTreeInodeFuture =
-        ensureDirectoryExists(path, ctx->getFetchContext());
+    auto getTargetTreeInodeFuture = directoryResolver.resolve(path);
 
     std::vector<ImmediateFuture<shared_ptr<TreeEntry>>> getTreeEntryFutures;
     if (!setOnRoot) {
@@ -891,6 +1104,7 @@ ImmediateFuture<SetPathObjectIdResultAndTimes> EdenMount::setPathsToObjectIds(
                         std::move(treeEntries), fakeObjectId);
                   });
 
+    auto setPathObjectIdTime = std::make_shared<SetPathObjectIdTimes>();
     auto future =
         collectAllSafe(getTargetTreeInodeFuture, getRootTreeFuture)
             .thenValue(
@@ -904,60 +1118,55 @@ ImmediateFuture<SetPathObjectIdResultAndTimes> EdenMount::setPathsToObjectIds(
                       ->checkout(ctx.get(), nullptr, incomingTree)
                       .semi();
                 })
-            .thenValue([ctx, setPathObjectIdTime, stopWatch](auto&&) {
+            .thenValue([setPathObjectIdTime, stopWatch](auto&&) {
               setPathObjectIdTime->didCheckout = stopWatch.elapsed();
-              return ctx->flush().semi();
-            })
-            .thenValue([ctx, setPathObjectIdTime, stopWatch](
+              return *setPathObjectIdTime;
+            });
+    futures.emplace_back(std::move(future));
+  }
+
+  // Flush even if one of the groups failed, as the others may have sent
+  // invalidations already.
+  return collectAll(std::move(futures))
+      .thenValue([ctx](std::vector<Try<SetPathObjectIdTimes>> timesList) {
+        return ctx->flush()
+            .thenValue([timesList = std::move(timesList)](
                            std::vector<CheckoutConflict>&& conflicts) {
-              setPathObjectIdTime->didFinish = stopWatch.elapsed();
-              SetPathObjectIdResultAndTimes resultAndTimes;
-              resultAndTimes.times = *setPathObjectIdTime;
+              // Merge the stats of the groups.
+              SetPathObjectIdTimes times;
+              for (auto& groupTimesTry : timesList) {
+                // Rethrows the error of the first group that failed.
+                const auto& groupTimes = groupTimesTry.value();
+                times.didLookupTreesOrGetInodeByPath +=
+                    groupTimes.didLookupTreesOrGetInodeByPath;
+                times.didCheckout += groupTimes.didCheckout;
+              }
               SetPathObjectIdResult result;
               result.conflicts_ref() = std::move(conflicts);
+              SetPathObjectIdResultAndTimes resultAndTimes;
+              resultAndTimes.times = std::move(times);
               resultAndTimes.result = std::move(result);
               return resultAndTimes;
             })
-            .thenTry([this, ctx](
-                         Try<SetPathObjectIdResultAndTimes>&& resultAndTimes) {
-              auto fetchStats = ctx->getStatsContext().computeStatistics();
-              XLOG(DBG4) << (resultAndTimes.hasValue() ? "" : "failed ")
-                         << "setPathObjectId for " << this->getPath()
-                         << " accessed " << fetchStats.tree.accessCount
-                         << " trees (" << fetchStats.tree.cacheHitRate
-                         << "% chr), " << fetchStats.blob.accessCount
-                         << " blobs (" << fetchStats.blob.cacheHitRate
-                         << "% chr), and " << fetchStats.metadata.accessCount
-                         << " metadata (" << fetchStats.metadata.cacheHitRate
-                         << "% chr).";
-
-              return std::move(resultAndTimes);
-            });
-    futures.emplace_back(std::move(future));
-  }
+            .semi();
+      })
+      .thenTry([this, ctx, stopWatch](
+                   Try<SetPathObjectIdResultAndTimes>&& resultAndTimes) {
+        if (resultAndTimes.hasValue()) {
+          resultAndTimes->times.didFinish = stopWatch.elapsed();
+        }
+        auto fetchStats = ctx->getStatsContext().computeStatistics();
+        XLOG(DBG4) << (resultAndTimes.hasValue() ? "" : "failed ")
+                   << "setPathObjectId for " << this->getPath() << " accessed "
+                   << fetchStats.tree.accessCount << " trees ("
+                   << fetchStats.tree.cacheHitRate << "% chr), "
+                   << fetchStats.blob.accessCount << " blobs ("
+                   << fetchStats.blob.cacheHitRate << "% chr), and "
+                   << fetchStats.metadata.accessCount << " metadata ("
+                   << fetchStats.metadata.cacheHitRate << "% chr).";
 
-  // Merge conflicts and stats
-  return collectAllSafe(std::move(futures))
-      .thenValue(
-          [](std::vector<SetPathObjectIdResultAndTimes> resultAndTimesList) {
-            SetPathObjectIdTimes times;
-            std::vector<CheckoutConflict> conflicts;
-            for (auto& resultAndTime : resultAndTimesList) {
-              for (auto conflict : *resultAndTime.result.conflicts_ref()) {
-                conflicts.emplace_back(std::move(conflict));
-              }
-              times.didLookupTreesOrGetInodeByPath +=
-                  resultAndTime.times.didLookupTreesOrGetInodeByPath;
-              times.didCheckout += resultAndTime.times.didCheckout;
-              times.didFinish += resultAndTime.times.didFinish;
-            }
-            SetPathObjectIdResult result;
-            result.conflicts_ref() = std::move(conflicts);
-            SetPathObjectIdResultAndTimes resultAndTimes;
-            resultAndTimes.times = std::move(times);
-            resultAndTimes.result = std::move(result);
-            return resultAndTimes;
-          });
+        return std::move(resultAndTimes);
+      });
 }
 #endif // !_WIN32
 
@@ -1031,6 +1240,10 @@ folly::SemiFuture<SerializedInodeMap> EdenMount::shutdownImpl(bool doTakeover) {
   return inodeMap_->shutdown(doTakeover)
       .thenValue([this](SerializedInodeMap inodeMap) {
         XLOG(DBG1) << "shutdown complete for EdenMount " << getPath();
+#ifndef _WIN32
+        // Buffered writes must reach the overlay files before they're closed.
+        overlayFileAccess_.flushBufferedWrites();
+#endif
         // Close the Overlay object to make sure we have released its lock.
         // This is important during graceful restart to ensure that we have
         // released the lock before the new edenfs process begins to take over
@@ -1313,22 +1526,96 @@ InodeNumber EdenMount::getDotEdenInodeNumber() const {
 ImmediateFuture<InodePtr> EdenMount::getInodeSlow(
     RelativePathPiece path,
     const ObjectFetchContextPtr& context) const {
-  return inodeMap_->getRootInode()->getChildRecursive(path, context);
+  if (!pathLookupCache_ || path.empty()) {
+    return inodeMap_->getRootInode()->getChildRecursive(path, context);
+  }
+  if (auto inode = lookupCachedPath(path)) {
+    return inode;
+  }
+
+  // Siblings looked up one after the other, as by the batched thrift calls,
+  // share the resolution of their parent.
+  auto future = [&] {
+    if (auto parent = lookupCachedParent(path)) {
+      return parent->getOrLoadChild(path.basename(), context);
+    }
+    return inodeMap_->getRootInode()->getChildRecursive(path, context);
+  }();
+  return std::move(future).thenValue(
+      [this, path = path.copy()](InodePtr inode) {
+        cachePath(path, inode);
+        return inode;
+      });
+}
+
+InodePtr EdenMount::lookupCachedPath(RelativePathPiece path) const {
+  InodeNumber number;
+  {
+    auto cache = pathLookupCache_->lock();
+    auto it = cache->find(path.copy());
+    if (it == cache->end()) {
+      return nullptr;
+    }
+    number = it->second;
+  }
+
+  auto inode = inodeMap_->lookupLoadedInode(number);
+  if (inode) {
+    auto currentPath = inode->getPath();
+    if (currentPath && currentPath->piece() == path) {
+      return inode;
+    }
+  }
+  // Unloaded, renamed or unlinked since.
+  pathLookupCache_->lock()->erase(path.copy());
+  return nullptr;
+}
+
+void EdenMount::cachePath(RelativePathPiece path, const InodePtr& inode) const {
+  // On case insensitive mounts, paths only differing by case from the name of
+  // the inode would never match it.
+  if (inode->getNameRacy() != path.basename()) {
+    return;
+  }
+  auto parent = inode->getParentRacy();
+  auto dirname = path.dirname();
+  auto cache = pathLookupCache_->lock();
+  cache->set(path.copy(), inode->getNodeId());
+  if (parent && !dirname.empty()) {
+    cache->set(dirname.copy(), parent->getNodeId());
+  }
+}
+
+TreeInodePtr EdenMount::lookupCachedParent(RelativePathPiece path) const {
+  auto dirname = path.dirname();
+  if (dirname.empty()) {
+    return nullptr;
+  }
+  if (auto parent = lookupCachedPath(dirname)) {
+    return parent.asTreePtrOrNull();
+  }
+  return nullptr;
 }
 
 namespace {
 
 class VirtualInodeLookupProcessor {
  public:
+  /**
+   * Looks up path starting skipComponents components into it.
+   */
   explicit VirtualInodeLookupProcessor(
       RelativePathPiece path,
       ObjectStore* objectStore,
-      ObjectFetchContextPtr context)
+      ObjectFetchContextPtr context,
+      size_t skipComponents = 0)
       : path_{path},
         iterRange_{path_.components()},
         iter_{iterRange_.begin()},
         objectStore_(objectStore),
-        context_{std::move(context)} {}
+        context_{std::move(context)} {
+    std::advance(iter_, skipComponents);
+  }
 
   ImmediateFuture<VirtualInode> next(VirtualInode inodeTreeEntry) {
     if (iter_ == iterRange_.end()) {
@@ -1362,13 +1649,44 @@ class VirtualInodeLookupProcessor {
 ImmediateFuture<VirtualInode> EdenMount::getVirtualInode(
     RelativePathPiece path,
     const ObjectFetchContextPtr& context) const {
-  auto rootInode = static_cast<InodePtr>(getRootInode());
+  if (!pathLookupCache_ || path.empty()) {
+    auto rootInode = static_cast<InodePtr>(getRootInode());
+    auto processor = std::make_unique<VirtualInodeLookupProcessor>(
+        path, getObjectStore(), context.copy());
+    auto future = processor->next(VirtualInode(std::move(rootInode)));
+    return std::move(future).ensure(
+        [p = std::move(processor)]() mutable { p.reset(); });
+  }
 
-  auto processor = std::make_unique<VirtualInodeLookupProcessor>(
-      path, getObjectStore(), context.copy());
-  auto future = processor->next(VirtualInode(std::move(rootInode)));
-  return std::move(future).ensure(
-      [p = std::move(processor)]() mutable { p.reset(); });
+  if (auto inode = lookupCachedPath(path)) {
+    return VirtualInode{std::move(inode)};
+  }
+
+  std::unique_ptr<VirtualInodeLookupProcessor> processor;
+  InodePtr start;
+  if (auto parent = lookupCachedParent(path)) {
+    // Only the last component is left to resolve.
+    size_t parentComponents = 0;
+    for ([[maybe_unused]] auto component : path.dirname().components()) {
+      ++parentComponents;
+    }
+    processor = std::make_unique<VirtualInodeLookupProcessor>(
+        path, getObjectStore(), context.copy(), parentComponents);
+    start = static_cast<InodePtr>(std::move(parent));
+  } else {
+    processor = std::make_unique<VirtualInodeLookupProcessor>(
+        path, getObjectStore(), context.copy());
+    start = static_cast<InodePtr>(getRootInode());
+  }
+  auto future = processor->next(VirtualInode(std::move(start)));
+  return std::move(future)
+      .thenValue([this, path = path.copy()](VirtualInode virtualInode) {
+        if (auto inode = virtualInode.getInodePtrOrNull()) {
+          cachePath(path, inode);
+        }
+        return virtualInode;
+      })
+      .ensure([p = std::move(processor)]() mutable { p.reset(); });
 }
 
 ImmediateFuture<folly::Unit> EdenMount::waitForPendingNotifications() const {
@@ -1439,6 +1757,10 @@ folly::Future<CheckoutResult> EdenMount::checkout(
   // checkout
   setLastCheckoutTime(EdenTimestamp{clock_->getRealtime()});
 
+  // The destination commit may contain objects that were previously looked up
+  // and not found.
+  objectStore_->clearNegativeCache();
+
   auto journalDiffCallback = std::make_shared<JournalDiffCallback>();
   return serverState_->getFaultInjector()
       .checkAsync("checkout", getPath().view())
@@ -1468,31 +1790,49 @@ folly::Future<CheckoutResult> EdenMount::checkout(
                   checkoutTimes,
                   stopWatch,
                   journalDiffCallback,
-                  resumingCheckout](
+                  resumingCheckout,
+                  parent1Hash = oldParent,
+                  snapshotHash](
                      std::tuple<shared_ptr<const Tree>, shared_ptr<const Tree>>
                          treeResults) {
         XLOG(DBG7) << "Checkout: performDiff";
         checkoutTimes->didLookupTrees = stopWatch.elapsed();
+
+        // Fetch what the inode phase is going to need while the journal diff
+        // runs, rather than as the checkout actions discover it.
+        auto prefetchFuture = ImmediateFuture<folly::Unit>{folly::unit};
+        if (getEdenConfig()->prefetchCheckoutObjects.getValue()) {
+          prefetchFuture =
+              prefetchCheckoutObjects(parent1Hash, snapshotHash, ctx)
+                  .thenValue([checkoutTimes, stopWatch](folly::Unit) {
+                    checkoutTimes->didPrefetch = stopWatch.elapsed();
+                  });
+        }
+
         // Call JournalDiffCallback::performDiff() to compute the changes
         // between the original working directory state and the source
         // tree state.
         //
         // If we are doing a dry-run update we aren't going to create a
         // journal entry, so we can skip this step entirely.
-        if (ctx->isDryRun()) {
-          return folly::makeFuture(treeResults);
+        auto diffFuture = ImmediateFuture<folly::Unit>{folly::unit};
+        if (!ctx->isDryRun()) {
+          auto& fromTree = std::get<0>(treeResults);
+          auto trees = std::vector{fromTree};
+          if (resumingCheckout) {
+            trees.push_back(std::get<1>(treeResults));
+          }
+          diffFuture =
+              journalDiffCallback
+                  ->performDiff(this, getRootInode(), std::move(trees))
+                  .thenValue([ctx, journalDiffCallback](
+                                 const StatsFetchContext& diffFetchContext) {
+                    ctx->getStatsContext().merge(diffFetchContext);
+                  });
         }
 
-        auto& fromTree = std::get<0>(treeResults);
-        auto trees = std::vector{fromTree};
-        if (resumingCheckout) {
-          trees.push_back(std::get<1>(treeResults));
-        }
-        return journalDiffCallback
-            ->performDiff(this, getRootInode(), std::move(trees))
-            .thenValue([ctx, journalDiffCallback, treeResults](
-                           const StatsFetchContext& diffFetchContext) {
-              ctx->getStatsContext().merge(diffFetchContext);
+        return collectAllSafe(std::move(prefetchFuture), std::move(diffFuture))
+            .thenValue([treeResults = std::move(treeResults)](auto&&) {
               return treeResults;
             })
             .semi()
@@ -1580,6 +1920,7 @@ folly::Future<CheckoutResult> EdenMount::checkout(
 
             CheckoutResult result;
             result.times = *checkoutTimes;
+            result.progress = ctx->getProgress();
             result.conflicts = std::move(conflicts);
             if (ctx->isDryRun()) {
               // This is a dry run, so all we need to do is tell the caller
@@ -1605,8 +1946,13 @@ folly::Future<CheckoutResult> EdenMount::checkout(
 
             return result;
           })
-      .thenTry([this, ctx, stopWatch, oldParent, snapshotHash, checkoutMode](
-                   Try<CheckoutResult>&& result) {
+      .thenTry([this,
+                ctx,
+                checkoutTimes,
+                stopWatch,
+                oldParent,
+                snapshotHash,
+                checkoutMode](Try<CheckoutResult>&& result) {
         auto fetchStats = ctx->getStatsContext().computeStatistics();
 
         XLOG(DBG1) << (result.hasValue() ? "" : "failed ") << "checkout for "
@@ -1618,6 +1964,14 @@ folly::Future<CheckoutResult> EdenMount::checkout(
                    << fetchStats.blob.cacheHitRate << "% chr), and "
                    << fetchStats.metadata.accessCount << " metadata ("
                    << fetchStats.metadata.cacheHitRate << "% chr).";
+        auto progress = ctx->getProgress();
+        XLOG(DBG1) << "checkout for " << this->getPath() << " compared "
+                   << progress.treesCompared << " trees, updated "
+                   << progress.actionsCompleted << "/"
+                   << progress.actionsStarted << " loaded entries, saved "
+                   << progress.treesSaved << " trees, ran "
+                   << progress.subtreesScheduled
+                   << " subtrees on the server thread pool";
 
         auto checkoutTimeInSeconds =
             std::chrono::duration<double>{stopWatch.elapsed()};
@@ -1627,6 +1981,22 @@ folly::Future<CheckoutResult> EdenMount::checkout(
         event.success = result.hasValue();
         event.fetchedTrees = fetchStats.tree.fetchCount;
         event.fetchedBlobs = fetchStats.blob.fetchCount;
+        auto seconds = [](CheckoutTimes::duration duration) {
+          return std::chrono::duration<double>{duration}.count();
+        };
+        event.lookupTreesDuration = seconds(checkoutTimes->didLookupTrees);
+        if (checkoutTimes->didPrefetch != CheckoutTimes::duration{}) {
+          event.prefetchDuration = seconds(
+              checkoutTimes->didPrefetch - checkoutTimes->didLookupTrees);
+        }
+        if (checkoutTimes->didDiff != CheckoutTimes::duration{}) {
+          event.diffDuration =
+              seconds(checkoutTimes->didDiff - checkoutTimes->didLookupTrees);
+        }
+        if (checkoutTimes->didCheckout != CheckoutTimes::duration{}) {
+          event.inodeCheckoutDuration = seconds(
+              checkoutTimes->didCheckout - checkoutTimes->didAcquireRenameLock);
+        }
         if (result.hasValue()) {
           auto& conflicts = result.value().conflicts;
           event.numConflicts = conflicts.size();
@@ -1659,6 +2029,121 @@ void EdenMount::forgetStaleInodes() {
   inodeMap_->forgetStaleInodes();
 }
 
+#ifndef _WIN32
+EdenMount::InodeUnloadPassStats EdenMount::runInodeUnloadPolicy(
+    const EdenConfig& config) {
+  auto getLoadedCount = [&] {
+    auto counts = inodeMap_->getInodeCounts();
+    return std::make_pair(counts.fileCount, counts.treeCount);
+  };
+
+  InodeUnloadPassStats stats;
+  auto [fileCount, treeCount] = getLoadedCount();
+  stats.loadedBefore = fileCount + treeCount;
+
+  stats.target = stats.loadedBefore;
+  if (auto targetCount = config.inodeUnloadTargetCount.getValue()) {
+    stats.target = std::min<size_t>(stats.target, targetCount);
+  }
+  if (auto budget = config.inodeUnloadMemoryBudget.getValue();
+      budget != 0 && stats.loadedBefore != 0) {
+    auto memory = fileCount * sizeof(FileInode) + treeCount * sizeof(TreeInode);
+    auto averageSize = memory / stats.loadedBefore;
+    stats.target = std::min(stats.target, budget / averageSize);
+  }
+
+  auto maxPerPass = config.inodeUnloadMaxPerPass.getValue();
+  auto minimumAge = config.inodeUnloadMinimumAge.getValue();
+  auto loaded = stats.loadedBefore;
+  auto root = getRootInode();
+  for (auto age = config.inodeUnloadMaximumAge.getValue();
+       loaded > stats.target && age >= minimumAge && age.count() > 0;
+       age /= 2) {
+    if (maxPerPass != 0 && stats.unloaded >= maxPerPass) {
+      stats.rateLimited = true;
+      break;
+    }
+
+    auto now = getClock().getRealtime();
+    auto cutoff = folly::to<timespec>(
+        folly::to<std::chrono::system_clock::time_point>(now) -
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(age));
+    stats.unloaded += root->unloadChildrenLastAccessedBefore(cutoff);
+    ++stats.steps;
+
+    auto [files, trees] = getLoadedCount();
+    loaded = files + trees;
+  }
+  stats.loadedAfter = loaded;
+
+  inodeMap_->recordPeriodicInodeUnload(stats.unloaded);
+  return stats;
+}
+
+ImmediateFuture<DematerializePassStats> EdenMount::dematerializeUnchangedFiles(
+    const EdenConfig& config,
+    const ObjectFetchContextPtr& context) {
+  if (dematerializing_.exchange(true)) {
+    XLOG(DBG2) << "a dematerialization pass is already running for "
+               << getPath();
+    return DematerializePassStats{};
+  }
+
+  std::shared_ptr<const Tree> rootTree;
+  {
+    auto parentState = parentState_.rlock();
+    if (parentState->checkoutInProgress) {
+      // The files will be compared with the commit being checked out by the
+      // next pass.
+      dematerializing_.store(false);
+      return DematerializePassStats{};
+    }
+    rootTree = parentState->checkedOutRootTree;
+  }
+
+  auto now = getClock().getRealtime();
+  auto modifiedBefore = folly::to<timespec>(
+      folly::to<std::chrono::system_clock::time_point>(now) -
+      std::chrono::duration_cast<std::chrono::system_clock::duration>(
+          config.dematerializeUnchangedFilesMinimumAge.getValue()));
+
+  auto pass = std::make_shared<DematerializePass>(
+      config.dematerializeUnchangedFilesMaxPerPass.getValue(),
+      config.dematerializeUnchangedFilesMaxBytesPerPass.getValue(),
+      EdenTimestamp{modifiedBefore},
+      *knownDifferentFiles_.rlock());
+  return makeImmediateFutureWith([&] {
+           return getRootInode()->dematerializeUnchangedChildren(
+               std::move(rootTree), pass, context);
+         })
+      .thenTry([self = shared_from_this(), pass](folly::Try<folly::Unit>&& t) {
+        auto stats = pass->getStats();
+        {
+          auto known = self->knownDifferentFiles_.wlock();
+          auto foundDifferent = pass->takeFoundDifferent();
+          if (t.hasValue() && !stats.rateLimited) {
+            // Every file was visited, so the files that aren't in
+            // foundDifferent anymore were dematerialized, modified or
+            // removed.
+            *known = std::move(foundDifferent);
+          } else {
+            for (auto& [ino, mtime] : foundDifferent) {
+              known->insert_or_assign(ino, mtime);
+            }
+          }
+        }
+        self->dematerializing_.store(false);
+
+        auto* edenStats = self->getStats();
+        edenStats->increment(&InodeStats::dematerializeChecked, stats.checked);
+        edenStats->increment(
+            &InodeStats::dematerializeDematerialized, stats.dematerialized);
+        t.throwUnlessValue();
+        return stats;
+      });
+}
+#endif
+
 ImmediateFuture<folly::Unit> EdenMount::flushInvalidations() {
 #ifndef _WIN32
   XLOG(DBG4) << "waiting for inode invalidations to complete";
@@ -1692,6 +2177,7 @@ folly::Future<folly::Unit> EdenMount::chown(uid_t uid, gid_t gid) {
     record.uid = uid;
     record.gid = gid;
   });
+  inodeMetadataGeneration_.fetch_add(1, std::memory_order_acq_rel);
 
   // Note that any files being created at this point are not
   // guaranteed to have the requested uid/gid, but that racyness is
@@ -1707,6 +2193,32 @@ folly::Future<folly::Unit> EdenMount::chown(uid_t uid, gid_t gid) {
 }
 #endif
 
+ImmediateFuture<folly::Unit> EdenMount::prefetchCheckoutObjects(
+    const RootId& fromRoot,
+    const RootId& toRoot,
+    std::shared_ptr<CheckoutContext> ctx) const {
+  auto callback = std::make_unique<CheckoutPrefetchCallback>();
+  auto diffContext = createDiffContext(
+      callback.get(), folly::CancellationToken{}, /*listIgnored=*/true);
+  auto* rawContext = diffContext.get();
+  return makeImmediateFutureWith(
+             [&] { return diffRoots(rawContext, fromRoot, toRoot); })
+      .thenTry([ctx = std::move(ctx),
+                callback = std::move(callback),
+                diffContext = std::move(diffContext)](
+                   folly::Try<folly::Unit>&& result) {
+        ctx->getStatsContext().merge(diffContext->getStatsContext());
+        if (result.hasException()) {
+          XLOG(DBG2) << "error prefetching objects for checkout: "
+                     << folly::exceptionStr(result.exception());
+        } else {
+          XLOG(DBG3) << "prefetched the objects of "
+                     << callback->changedPaths.load()
+                     << " changed paths for checkout";
+        }
+      });
+}
+
 std::unique_ptr<DiffContext> EdenMount::createDiffContext(
     DiffCallback* callback,
     folly::CancellationToken cancellation,
@@ -1717,7 +2229,8 @@ std::unique_ptr<DiffContext> EdenMount::createDiffContext(
       listIgnored,
       getCheckoutConfig()->getCaseSensitive(),
       getObjectStore(),
-      serverState_->getTopLevelIgnores());
+      serverState_->getTopLevelIgnores(),
+      &serverState_->getGitIgnoreCache());
 }
 
 ImmediateFuture<Unit> EdenMount::diff(
@@ -1805,6 +2318,59 @@ ImmediateFuture<std::unique_ptr<ScmStatus>> EdenMount::diff(
     folly::CancellationToken cancellation,
     bool listIgnored,
     bool enforceCurrentParent) {
+  if (!getEdenConfig()->enableScmStatusCache.getValue()) {
+    return computeScmStatus(
+        commitHash,
+        std::move(cancellation),
+        listIgnored,
+        enforceCurrentParent,
+        std::nullopt);
+  }
+
+  // Only the status of the checked out commit is cached, since that's the
+  // one the journal records the changes against.
+  std::shared_ptr<const Tree> rootTree;
+  {
+    auto parentInfo = parentState_.rlock();
+    if (!parentInfo->checkoutInProgress &&
+        parentInfo->checkedOutRootId == commitHash &&
+        parentInfo->workingCopyParentRootId == commitHash) {
+      rootTree = parentInfo->checkedOutRootTree;
+    }
+  }
+  if (!rootTree) {
+    return computeScmStatus(
+        commitHash,
+        std::move(cancellation),
+        listIgnored,
+        enforceCurrentParent,
+        std::nullopt);
+  }
+
+  // The journal only knows about the changes once the channel processed
+  // their notifications.
+  return waitForPendingNotifications().thenValue(
+      [this,
+       commitHash,
+       rootTree = std::move(rootTree),
+       cancellation = std::move(cancellation),
+       listIgnored,
+       enforceCurrentParent](auto&&) mutable {
+        return diffWithStatusCache(
+            commitHash,
+            std::move(rootTree),
+            std::move(cancellation),
+            listIgnored,
+            enforceCurrentParent);
+      });
+}
+
+ImmediateFuture<std::unique_ptr<ScmStatus>> EdenMount::computeScmStatus(
+    const RootId& commitHash,
+    folly::CancellationToken cancellation,
+    bool listIgnored,
+    bool enforceCurrentParent,
+    std::optional<uint64_t> cacheAtSequence) {
   auto callback = std::make_unique<ScmStatusDiffCallback>();
   auto callbackPtr = callback.get();
   return this
@@ -1814,8 +2380,245 @@ ImmediateFuture<std::unique_ptr<ScmStatus>> EdenMount::diff(
           listIgnored,
           enforceCurrentParent,
           std::move(cancellation))
-      .thenValue([callback = std::move(callback)](auto&&) {
-        return std::make_unique<ScmStatus>(callback->extractStatus());
+      .thenValue([this,
+                  callback = std::move(callback),
+                  commitHash,
+                  listIgnored,
+                  cacheAtSequence](auto&&) {
+        auto status = std::make_unique<ScmStatus>(callback->extractStatus());
+        // The paths that failed to diff would have to be diffed again.
+        if (cacheAtSequence && status->errors_ref()->empty()) {
+          *scmStatusCache_.wlock() = CachedScmStatus{
+              commitHash, listIgnored, *cacheAtSequence, *status};
+        }
+        return status;
+      });
+}
+
+ImmediateFuture<std::unique_ptr<ScmStatus>> EdenMount::diffWithStatusCache(
+    const RootId& commitHash,
+    std::shared_ptr<const Tree> rootTree,
+    folly::CancellationToken cancellation,
+    bool listIgnored,
+    bool enforceCurrentParent) {
+  // Read before diffing, so that the changes made while diffing are
+  // verified again by the next status.
+  auto latest = journal_->getLatest();
+  uint64_t sequence = latest ? latest->sequenceID : 0;
+
+  std::optional<CachedScmStatus> cached;
+  {
+    auto cache = scmStatusCache_.rlock();
+    if (*cache && (*cache)->commit == commitHash &&
+        (*cache)->listIgnored == listIgnored) {
+      cached = **cache;
+    }
+  }
+
+  auto fullDiff = [&] {
+    getStats()->increment(&InodeStats::statusCacheMiss);
+    return computeScmStatus(
+        commitHash,
+        std::move(cancellation),
+        listIgnored,
+        enforceCurrentParent,
+        sequence);
+  };
+  if (!cached) {
+    return fullDiff();
+  }
+  if (cached->sequence == sequence) {
+    getStats()->increment(&InodeStats::statusCacheHit);
+    return std::make_unique<ScmStatus>(std::move(cached->status));
+  }
+
+  // Checkouts and resets don't record the paths they change, so the status
+  // has to be computed again after them.
+  auto range = journal_->accumulateRange(cached->sequence + 1);
+  if (!range || range->isTruncated || range->snapshotTransitions.size() > 1 ||
+      !range->uncleanPaths.empty() ||
+      range->changedFilesInOverlay.size() >
+          getEdenConfig()->scmStatusCacheMaxChangedPaths.getValue()) {
+    return fullDiff();
+  }
+
+  std::vector<RelativePath> paths;
+  paths.reserve(range->changedFilesInOverlay.size());
+  for (const auto& [path, info] : range->changedFilesInOverlay) {
+    paths.push_back(path);
+  }
+  return updateScmStatus(
+             std::move(cached->status), std::move(rootTree), std::move(paths))
+      .thenValue(
+          [this,
+           commitHash,
+           cancellation = std::move(cancellation),
+           listIgnored,
+           enforceCurrentParent,
+           toSequence = range->toSequence](
+              std::optional<ScmStatus> status) mutable
+          -> ImmediateFuture<std::unique_ptr<ScmStatus>> {
+            if (!status) {
+              getStats()->increment(&InodeStats::statusCacheMiss);
+              return computeScmStatus(
+                  commitHash,
+                  std::move(cancellation),
+                  listIgnored,
+                  enforceCurrentParent,
+                  toSequence);
+            }
+            getStats()->increment(&InodeStats::statusCacheUpdate);
+            // The paths changed up to toSequence were verified against the
+            // current working copy, which is at least as recent.
+            *scmStatusCache_.wlock() =
+                CachedScmStatus{commitHash, listIgnored, toSequence, *status};
+            return std::make_unique<ScmStatus>(std::move(*status));
+          });
+}
+
+namespace {
+
+/**
+ * What EdenMount::updateScmStatus() found out about a changed path.
+ */
+enum class ChangedPathStatus {
+  // The path is the same as in the commit, or absent from both.
+  Clean,
+  Modified,
+  Removed,
+  // The path is a file absent from the commit, which is either ADDED or
+  // IGNORED depending on the ignore files.
+  Untracked,
+  // The path has to be diffed with the rest of its directory.
+  Unknown,
+};
+
+bool isNotFoundError(const folly::exception_wrapper& ew) {
+  auto* err = ew.get_exception<std::system_error>();
+  return err &&
+      (err->code().value() == ENOENT || err->code().value() == ENOTDIR);
+}
+
+bool isHiddenFromStatus(RelativePathPiece path) {
+  for (auto component : path.components()) {
+    if (component.view() == ".hg" || component.view() == ".eden") {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+ImmediateFuture<std::optional<ScmStatus>> EdenMount::updateScmStatus(
+    ScmStatus status,
+    std::shared_ptr<const Tree> rootTree,
+    std::vector<RelativePath> paths) {
+  static auto context = ObjectFetchContext::getNullContextWithCauseDetail(
+      "EdenMount::updateScmStatus");
+
+  std::vector<RelativePath> statusPaths;
+  std::vector<ImmediateFuture<ChangedPathStatus>> futures;
+  for (auto& path : paths) {
+    if (isHiddenFromStatus(path)) {
+      continue;
+    }
+    // Editing an ignore file changes the status of the files it matches.
+    if (path.basename().view() == ".gitignore") {
+      return std::optional<ScmStatus>{};
+    }
+    // The path was a directory whose entries are listed in the status.
+    auto prefix = fmt::format("{}/", path.view());
+    auto below = status.entries_ref()->lower_bound(prefix);
+    if (below != status.entries_ref()->end() &&
+        std::string_view{below->first}.substr(0, prefix.size()) == prefix) {
+      return std::optional<ScmStatus>{};
+    }
+
+    auto lookup = std::make_unique<TreeLookupProcessor>(
+        path, objectStore_, context.copy());
+    auto* lookupPtr = lookup.get();
+    futures.push_back(
+        lookupPtr->next(rootTree)
+            .thenTry(
+                [this, path](
+                    folly::Try<OverlayChecker::LookupCallbackValue> scm)
+                    -> ImmediateFuture<ChangedPathStatus> {
+                  std::optional<TreeEntry> scmEntry;
+                  if (scm.hasException()) {
+                    if (!isNotFoundError(scm.exception())) {
+                      return ChangedPathStatus::Unknown;
+                    }
+                  } else if (
+                      auto* entry = std::get_if<TreeEntry>(&scm.value())) {
+                    scmEntry = *entry;
+                  } else {
+                    return ChangedPathStatus::Unknown;
+                  }
+
+                  return getInodeSlow(path, context)
+                      .thenTry([scmEntry = std::move(scmEntry)](
+                                   folly::Try<InodePtr> inode)
+                                   -> ImmediateFuture<ChangedPathStatus> {
+                        if (inode.hasException()) {
+                          if (!isNotFoundError(inode.exception())) {
+                            return ChangedPathStatus::Unknown;
+                          }
+                          return scmEntry ? ChangedPathStatus::Removed
+                                          : ChangedPathStatus::Clean;
+                        }
+                        auto file = inode.value().asFilePtrOrNull();
+                        if (!file) {
+                          return ChangedPathStatus::Unknown;
+                        }
+                        if (!scmEntry) {
+                          return ChangedPathStatus::Untracked;
+                        }
+                        return file
+                            ->isSameAs(
+                                scmEntry->getHash(),
+                                scmEntry->getType(),
+                                context)
+                            .thenValue([](bool same) {
+                              return same ? ChangedPathStatus::Clean
+                                          : ChangedPathStatus::Modified;
+                            });
+                      });
+                })
+            .ensure([lookup = std::move(lookup)] {}));
+    statusPaths.push_back(std::move(path));
+  }
+
+  return collectAllSafe(std::move(futures))
+      .thenValue([status = std::move(status),
+                  statusPaths = std::move(statusPaths)](
+                     std::vector<ChangedPathStatus> results) mutable
+                 -> std::optional<ScmStatus> {
+        auto& entries = *status.entries_ref();
+        for (size_t i = 0; i < results.size(); ++i) {
+          auto path = std::string{statusPaths[i].view()};
+          switch (results[i]) {
+            case ChangedPathStatus::Clean:
+              entries.erase(path);
+              break;
+            case ChangedPathStatus::Modified:
+              entries[path] = ScmFileStatus::MODIFIED;
+              break;
+            case ChangedPathStatus::Removed:
+              entries[path] = ScmFileStatus::REMOVED;
+              break;
+            case ChangedPathStatus::Untracked:
+              // Whether a new file is ignored takes evaluating the ignore
+              // files, but one already listed keeps its status.
+              if (entries.find(path) == entries.end()) {
+                return std::nullopt;
+              }
+              break;
+            case ChangedPathStatus::Unknown:
+              return std::nullopt;
+          }
+        }
+        return std::move(status);
       });
 }
 
@@ -1891,12 +2694,24 @@ std::string EdenMount::getCounterName(CounterName name) {
       return folly::to<std::string>("journal.", base, ".duration_secs");
     case CounterName::JOURNAL_MAX_FILES_ACCUMULATED:
       return folly::to<std::string>("journal.", base, ".files_accumulated.max");
+    case CounterName::JOURNAL_BYTES_PER_DELTA:
+      return folly::to<std::string>("journal.", base, ".bytes_per_delta");
     case CounterName::PERIODIC_INODE_UNLOAD:
       return folly::to<std::string>(
           "inodemap.", base, ".unloaded_linked_inodes");
     case CounterName::PERIODIC_UNLINKED_INODE_UNLOAD:
       return folly::to<std::string>(
           "inodemap.", base, ".unloaded_unlinked_inodes");
+    case CounterName::METADATA_TABLE_SIZE:
+      return folly::to<std::string>("overlay.", base, ".metadata_table.size");
+    case CounterName::METADATA_TABLE_ENTRIES:
+      return folly::to<std::string>(
+          "overlay.", base, ".metadata_table.entries");
+    case CounterName::METADATA_TABLE_UNUSED_PERCENT:
+      return folly::to<std::string>(
+          "overlay.", base, ".metadata_table.unused_pct");
+    case CounterName::TAKEOVER_BLACKOUT:
+      return folly::to<std::string>("takeover.", base, ".blackout_ms");
   }
   EDEN_BUG() << "unknown counter name "
              << static_cast<std::underlying_type_t<CounterName>>(name);
@@ -1912,6 +2727,16 @@ std::unique_ptr<FuseChannel, FuseChannelDeleter> makeFuseChannel(
     EdenMount* mount,
     folly::File fuseFd) {
   auto edenConfig = mount->getEdenConfig();
+  std::unique_ptr<FuseAdmissionControl> admissionControl;
+  auto backgroundProcesses = edenConfig->fuseBackgroundProcesses.getValue();
+  if (!backgroundProcesses.empty()) {
+    admissionControl = std::make_unique<PriorityLaneAdmissionControl>(
+        mount->getServerState()->getProcessNameCache(),
+        std::move(backgroundProcesses),
+        PriorityLaneAdmissionControl::Limits{
+            edenConfig->fuseMaxRequestsPerBackgroundProcess.getValue(),
+            edenConfig->fuseMaxBackgroundRequests.getValue()});
+  }
   return std::unique_ptr<FuseChannel, FuseChannelDeleter>{new FuseChannel(
       std::move(fuseFd),
       mount->getPath(),
@@ -1926,7 +2751,14 @@ std::unique_ptr<FuseChannel, FuseChannelDeleter> makeFuseChannel(
       mount->getCheckoutConfig()->getCaseSensitive(),
       mount->getCheckoutConfig()->getRequireUtf8Path(),
       edenConfig->fuseMaximumRequests.getValue(),
-      mount->getCheckoutConfig()->getUseWriteBackCache())};
+      mount->getCheckoutConfig()->getUseWriteBackCache(),
+      edenConfig->fuseCloneDevice.getValue(),
+      edenConfig->fusePinWorkerThreads.getValue(),
+      edenConfig->fuseSpliceReads.getValue(),
+      edenConfig->fuseReaddirPlus.getValue(),
+      edenConfig->fuseInvalidationThreads.getValue(),
+      edenConfig->fuseSlowRequestThreshold.getValue(),
+      std::move(admissionControl))};
 }
 
 folly::Future<NfsServer::NfsMountInfo> makeNfsChannel(
@@ -1935,11 +2767,19 @@ folly::Future<NfsServer::NfsMountInfo> makeNfsChannel(
   auto edenConfig = mount->getEdenConfig();
   auto nfsServer = mount->getServerState()->getNfsServer();
   auto iosize = edenConfig->nfsIoSize.getValue();
+  // Only one of the connections of the client survives a takeover.
+  size_t numConnections =
+      connectedSocket ? 1 : edenConfig->nfsNumConnections.getValue();
   auto mountPath = mount->getPath();
   // Make sure that we are running on the EventBase while registering
   // the mount point.
   return via(nfsServer->getEventBase(),
-             [mount, mountPath, nfsServer, iosize, edenConfig]() {
+             [mount,
+              mountPath,
+              nfsServer,
+              iosize,
+              numConnections,
+              edenConfig]() {
                return nfsServer->registerMount(
                    mountPath,
                    mount->getRootInode()->getNodeId(),
@@ -1953,6 +2793,7 @@ folly::Future<NfsServer::NfsMountInfo> makeNfsChannel(
                    mount->getServerState()->getNotifier(),
                    mount->getCheckoutConfig()->getCaseSensitive(),
                    iosize,
+                   numConnections,
                    edenConfig->nfsTraceBusCapacity.getValue());
              })
       .thenValue([mount, connectedSocket = std::move(connectedSocket)](
@@ -1997,10 +2838,13 @@ folly::Future<folly::Unit> EdenMount::channelMount(bool readOnly) {
                      &getStraceLogger(),
                      serverState_->getProcessNameCache(),
                      getCheckoutConfig()->getRepoGuid(),
-                     this->getServerState()->getNotifier());
+                     this->getServerState()->getNotifier(),
+                     edenConfig->prjfsNumServicingThreads.getValue());
                  channel->start(
                      readOnly,
-                     edenConfig->prjfsUseNegativePathCaching.getValue());
+                     edenConfig->prjfsUseNegativePathCaching.getValue(),
+                     edenConfig->prjfsPlaceholderBatchMaxEntries.getValue(),
+                     edenConfig->prjfsNumCallbackThreads.getValue());
                  return channel;
                })
             .thenTry([this, mountPromise](
@@ -2021,6 +2865,7 @@ folly::Future<folly::Unit> EdenMount::channelMount(bool readOnly) {
         if (shouldUseNFSMount_) {
           auto iosize = edenConfig->nfsIoSize.getValue();
           auto useReaddirplus = edenConfig->useReaddirplus.getValue();
+          auto numConnections = edenConfig->nfsNumConnections.getValue();
 
           // Make sure that we are running on the EventBase while registering
           // the mount point.
@@ -2030,6 +2875,7 @@ folly::Future<folly::Unit> EdenMount::channelMount(bool readOnly) {
                readOnly,
                iosize,
                useReaddirplus,
+               numConnections,
                mountPromise = std::move(mountPromise),
                mountPath = std::move(mountPath)](
                   NfsServer::NfsMountInfo mountInfo) mutable {
@@ -2042,7 +2888,8 @@ folly::Future<folly::Unit> EdenMount::channelMount(bool readOnly) {
                         channel->getAddr(),
                         readOnly,
                         iosize,
-                        useReaddirplus)
+                        useReaddirplus,
+                        numConnections)
                     .thenTry([this,
                               mountPromise = std::move(mountPromise),
                               channel = std::move(channel)](
@@ -2107,6 +2954,7 @@ folly::Future<folly::Unit> EdenMount::startChannel(bool readOnly) {
   return folly::makeFutureWith([&]() {
     transitionState(
         /*expected=*/State::INITIALIZED, /*newState=*/State::STARTING);
+    auto channelStart = std::chrono::steady_clock::now();
 
     // Just in case the mount point directory doesn't exist,
     // automatically create it.
@@ -2154,6 +3002,10 @@ folly::Future<folly::Unit> EdenMount::startChannel(bool readOnly) {
               channel_);
 #endif
         })
+        .thenValue([this, channelStart](auto&&) {
+          channelStartDuration_ =
+              std::chrono::steady_clock::now() - channelStart;
+        })
         .thenError([this](folly::exception_wrapper&& ew) {
           transitionToFuseInitializationErrorState();
           return makeFuture<folly::Unit>(std::move(ew));
@@ -2357,9 +3209,11 @@ struct stat EdenMount::initStatData() const {
 
 std::optional<ActivityBuffer<InodeTraceEvent>>
 EdenMount::initInodeActivityBuffer() {
-  if (serverState_->getEdenConfig()->enableActivityBuffer.getValue()) {
+  auto config = serverState_->getEdenConfig();
+  if (config->enableActivityBuffer.getValue()) {
     return std::make_optional<ActivityBuffer<InodeTraceEvent>>(
-        serverState_->getEdenConfig()->ActivityBufferMaxEvents.getValue());
+        config->ActivityBufferMaxEvents.getValue(),
+        config->ActivityBufferMaxBytes.getValue());
   }
   return std::nullopt;
 }
@@ -2466,6 +3320,12 @@ std::optional<TreePrefetchLease> EdenMount::tryStartTreePrefetch(
     const ObjectFetchContext& context) {
   auto config = serverState_->getEdenConfig(ConfigReloadBehavior::NoReload);
   auto maxTreePrefetches = config->maxTreePrefetches.getValue();
+  if (config->adaptiveTreePrefetch.getValue()) {
+    maxTreePrefetches = readdirPrefetchPolicy_.getMaxPrefetches(
+        maxTreePrefetches,
+        config->maxTreePrefetchesAdaptive.getValue(),
+        config->treePrefetchReferenceLatency.getValue());
+  }
   auto numInProgress =
       numPrefetchesInProgress_.fetch_add(1, std::memory_order_acq_rel);
   if (numInProgress < maxTreePrefetches) {
@@ -2476,12 +3336,29 @@ std::optional<TreePrefetchLease> EdenMount::tryStartTreePrefetch(
   }
 }
 
-void EdenMount::treePrefetchFinished() noexcept {
+void EdenMount::treePrefetchFinished(
+    std::chrono::steady_clock::duration duration) noexcept {
+  readdirPrefetchPolicy_.recordPrefetchDuration(duration);
   auto oldValue =
       numPrefetchesInProgress_.fetch_sub(1, std::memory_order_acq_rel);
   XDCHECK_NE(uint64_t{0}, oldValue);
 }
 
+void EdenMount::recordChildLookup(
+    InodeNumber dir,
+    const ObjectFetchContext& context) {
+  switch (readdirPrefetchPolicy_.recordLookup(context.getClientPid(), dir)) {
+    case ReaddirPrefetchPolicy::LookupResult::Untracked:
+      break;
+    case ReaddirPrefetchPolicy::LookupResult::Hit:
+      getStats()->increment(&InodeStats::readdirPrefetchHit);
+      break;
+    case ReaddirPrefetchPolicy::LookupResult::Miss:
+      getStats()->increment(&InodeStats::readdirPrefetchMiss);
+      break;
+  }
+}
+
 bool EdenMount::MountingUnmountingState::channelMountStarted() const noexcept {
   return channelMountPromise.has_value();
 }
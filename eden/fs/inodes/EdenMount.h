@@ -12,6 +12,7 @@
 #include <folly/SharedMutex.h>
 #include <folly/Synchronized.h>
 #include <folly/ThreadLocal.h>
+#include <folly/container/EvictingCacheMap.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
 #include <folly/futures/SharedPromise.h>
@@ -26,10 +27,14 @@
 #include "eden/fs/config/CheckoutConfig.h"
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/inodes/CacheHint.h"
+#include "eden/fs/inodes/DematerializePass.h"
+#include "eden/fs/inodes/InodeLoadTiming.h"
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/InodePtrFwd.h"
 #include "eden/fs/inodes/InodeTimestamps.h"
 #include "eden/fs/inodes/Overlay.h"
+#include "eden/fs/inodes/ReadAheadTracker.h"
+#include "eden/fs/inodes/ReaddirPrefetchPolicy.h"
 #include "eden/fs/inodes/VirtualInode.h"
 #include "eden/fs/model/RootId.h"
 #include "eden/fs/service/gen-cpp2/eden_types.h"
@@ -62,6 +67,7 @@ namespace facebook::eden {
 class BindMount;
 class BlobCache;
 class CheckoutConfig;
+class CheckoutContext;
 class CheckoutConflict;
 class Clock;
 class DiffContext;
@@ -109,6 +115,8 @@ class SharedRenameLock;
  * Note, path could be the full path (in the case of inode creations), or,
  * more commonly, just base filenames depending on how much is easily
  * available during the inode event.
+ *
+ * The END event of a load also breaks its duration down into loadPhases.
  */
 struct InodeTraceEvent : TraceEventBase {
   template <typename Path>
@@ -140,10 +148,16 @@ struct InodeTraceEvent : TraceEventBase {
   InodeEventType eventType;
   InodeEventProgress progress;
   std::chrono::microseconds duration;
+  // Only set on the END event of a load.
+  InodeLoadPhases loadPhases;
   // Always null-terminated, and saves space in the trace event structure.
   std::shared_ptr<char[]> path;
 
  private:
+  friend struct ActivityBufferCodec<InodeTraceEvent>;
+
+  InodeTraceEvent() = default;
+
   InodeTraceEvent(
       std::chrono::system_clock::time_point startTime,
       InodeNumber ino,
@@ -152,6 +166,15 @@ struct InodeTraceEvent : TraceEventBase {
       InodeEventProgress progress);
 };
 
+/**
+ * Stores the fields of InodeTraceEvents next to their path.
+ */
+template <>
+struct ActivityBufferCodec<InodeTraceEvent> {
+  static void encode(const InodeTraceEvent& event, std::string& out);
+  static InodeTraceEvent decode(folly::ByteRange in);
+};
+
 /**
  * Represents types of keys for some fb303 counters.
  */
@@ -180,6 +203,10 @@ enum class CounterName {
    * Represents the maximum deltas iterated over in the Journal's forEachDelta
    */
   JOURNAL_MAX_FILES_ACCUMULATED,
+  /**
+   * Represents the average memory used by each delta in the change log
+   */
+  JOURNAL_BYTES_PER_DELTA,
 
   /**
    * Represents the number of inodes unloaded for this mount by periodic
@@ -193,8 +220,26 @@ enum class CounterName {
    * unlinked inode unloading. This is used on NFS mounts to clean up old
    * inodes.
    */
-  PERIODIC_UNLINKED_INODE_UNLOAD
+  PERIODIC_UNLINKED_INODE_UNLOAD,
 
+  /**
+   * Represents the size in bytes of the inode metadata table file.
+   */
+  METADATA_TABLE_SIZE,
+  /**
+   * Represents the number of records in the inode metadata table.
+   */
+  METADATA_TABLE_ENTRIES,
+  /**
+   * Represents the percentage of the inode metadata table file left unused
+   * by freed inodes, until the overlay maintenance compacts it.
+   */
+  METADATA_TABLE_UNUSED_PERCENT,
+  /**
+   * Represents how long requests were left waiting in the kernel while this
+   * mount was handed over by a graceful restart, in milliseconds.
+   */
+  TAKEOVER_BLACKOUT,
 };
 
 /**
@@ -211,6 +256,9 @@ struct Owner {
 struct CheckoutTimes {
   using duration = std::chrono::steady_clock::duration;
   duration didLookupTrees{};
+  // When the objects the checkout needs were prefetched, which overlaps the
+  // journal diff.
+  duration didPrefetch{};
   duration didDiff{};
   duration didAcquireRenameLock{};
   duration didCheckout{};
@@ -227,9 +275,28 @@ struct SetPathObjectIdTimes {
   duration didFinish{};
 };
 
+/**
+ * How far a checkout went through each of its phases.
+ */
+struct CheckoutProgress {
+  // Directories whose entries were compared with the source and destination
+  // trees.
+  size_t treesCompared{0};
+  // Entries whose inode or source control objects had to be loaded before
+  // being updated, and those done.
+  size_t actionsStarted{0};
+  size_t actionsCompleted{0};
+  // Directories whose new contents were saved to the overlay.
+  size_t treesSaved{0};
+  // Directory checkouts run on the server thread pool rather than on the
+  // thread that reached them.
+  size_t subtreesScheduled{0};
+};
+
 struct CheckoutResult {
   std::vector<CheckoutConflict> conflicts;
   CheckoutTimes times;
+  CheckoutProgress progress;
 };
 
 struct SetPathObjectIdResultAndTimes {
@@ -302,6 +369,43 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       OverlayChecker::ProgressCallback&& progressCallback = [](auto) {},
       const std::optional<SerializedInodeMap>& takeover = std::nullopt);
 
+  /**
+   * How long each phase of initialize() took.
+   */
+  struct InitializeTimings {
+    std::chrono::steady_clock::duration rootTree{};
+    std::chrono::steady_clock::duration overlay{};
+    std::chrono::steady_clock::duration inodeMap{};
+  };
+
+  /**
+   * Only meaningful once the future returned by initialize() completed.
+   */
+  const InitializeTimings& getInitializeTimings() const {
+    return initializeTimings_;
+  }
+
+  /**
+   * How long startChannel() took to mount the filesystem and initialize its
+   * channel. Only meaningful once the future it returned completed
+   * successfully.
+   */
+  std::chrono::steady_clock::duration getChannelStartDuration() const {
+    return channelStartDuration_;
+  }
+
+  /**
+   * How long the requests to this mount waited while it was taken over from
+   * the previous EdenFS process, or 0 if it wasn't.
+   */
+  std::chrono::milliseconds getTakeoverBlackout() const {
+    return std::chrono::milliseconds{
+        takeoverBlackoutMs_.load(std::memory_order_relaxed)};
+  }
+  void setTakeoverBlackout(std::chrono::milliseconds blackout) {
+    takeoverBlackoutMs_.store(blackout.count(), std::memory_order_relaxed);
+  }
+
   /**
    * Destroy the EdenMount.
    *
@@ -530,6 +634,15 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
 
   InodeMetadataTable* getInodeMetadataTable() const;
 
+  /**
+   * Incremented whenever the metadata of the inodes is modified without
+   * holding their state lock, e.g. by chown(), so that the metadata the inodes
+   * published for lock-free reads isn't used anymore.
+   */
+  uint64_t getInodeMetadataGeneration() const {
+    return inodeMetadataGeneration_.load(std::memory_order_acquire);
+  }
+
   /**
    * Return the Journal used by this mount point.
    *
@@ -716,6 +829,22 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       bool listIgnored = false,
       bool enforceCurrentParent = true);
 
+  /**
+   * This accepts a callback which will be invoked as differences are found.
+   * Note that the callback methods may be invoked simultaneously from multiple
+   * different threads, and the callback is responsible for performing
+   * synchronization (if it is needed). It will be packaged into a DiffContext
+   * and passed through the TreeInode diff() codepath.
+   *
+   * Unlike the diff() above, this never uses the cached status.
+   */
+  FOLLY_NODISCARD ImmediateFuture<folly::Unit> diff(
+      DiffCallback* callback,
+      const RootId& commitHash,
+      bool listIgnored,
+      bool enforceCurrentParent,
+      folly::CancellationToken cancellation) const;
+
   /**
    * Compute the difference between the passed in roots.
    *
@@ -754,6 +883,10 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
 
   /**
    * Acquire the rename lock in shared mode.
+   *
+   * Renames that don't move a directory to another parent only hold the
+   * rename lock in shared mode, so this guarantees that the ancestors of every
+   * directory stay the same, but files may still be renamed.
    */
   SharedRenameLock acquireSharedRenameLock();
 
@@ -892,6 +1025,22 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   std::optional<ActivityBuffer<InodeTraceEvent>> initInodeActivityBuffer();
 
+  /**
+   * Return the inode cached for path, if it is still loaded and at this path.
+   */
+  InodePtr lookupCachedPath(RelativePathPiece path) const;
+
+  /**
+   * Cache the inode found at path, and its parent directory.
+   */
+  void cachePath(RelativePathPiece path, const InodePtr& inode) const;
+
+  /**
+   * The directory containing path, if cached, to resume the lookup of path
+   * from.
+   */
+  TreeInodePtr lookupCachedParent(RelativePathPiece path) const;
+
   /**
    * Subscribes inodeActivityBuffer_ to the inodeTraceBus_ in order to read and
    * store InodeTraceEvents into the ActivityBuffer as they occur. In addition,
@@ -957,6 +1106,28 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       TreeInodePtr treeInode,
       const ObjectFetchContext& context);
 
+  /**
+   * Decides which readdirs prefetch, from how the previous prefetches were
+   * used. See ReaddirPrefetchPolicy.
+   */
+  ReaddirPrefetchPolicy& getReaddirPrefetchPolicy() {
+    return readdirPrefetchPolicy_;
+  }
+
+  /**
+   * Detects the processes reading files in order, for the read ahead of
+   * FileInode. See ReadAheadTracker.
+   */
+  ReadAheadTracker& getReadAheadTracker() {
+    return readAheadTracker_;
+  }
+
+  /**
+   * Called by the lookups of the children of dir on behalf of the
+   * filesystem, to account the hits of the readdir prefetches.
+   */
+  void recordChildLookup(InodeNumber dir, const ObjectFetchContext& context);
+
   /**
    * Get a weak_ptr to this EdenMount object. EdenMounts are stored as shared
    * pointers inside of EdenServer's MountList.
@@ -976,6 +1147,10 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    * 2. In FORCE mode, only new tree will exist after the operation and any
    * other contents will disappear
    * 3. In DRYRUN mode, no action action will be executed.
+   *
+   * The objects are applied as one operation: those sharing a parent
+   * directory are checked out together, the directories leading to them are
+   * resolved once, and the invalidations are flushed once at the end.
    */
   FOLLY_NODISCARD ImmediateFuture<SetPathObjectIdResultAndTimes>
   setPathsToObjectIds(
@@ -1012,6 +1187,56 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   void forgetStaleInodes();
 
+#ifndef _WIN32
+  /**
+   * Statistics of a pass of the inode unload policy.
+   */
+  struct InodeUnloadPassStats {
+    // Loaded inodes before and after the pass.
+    size_t loadedBefore = 0;
+    size_t loadedAfter = 0;
+    // The number of loaded inodes the pass unloaded down to.
+    size_t target = 0;
+    size_t unloaded = 0;
+    // Number of access time cutoffs the pass went through.
+    size_t steps = 0;
+    // Whether the pass stopped at `mount:inode-unload-max-per-pass`.
+    bool rateLimited = false;
+  };
+
+  /**
+   * Unload the least recently accessed inodes that aren't referenced by the
+   * kernel until the loaded inodes fit both `mount:inode-unload-target-count`
+   * and `mount:inode-unload-memory-budget`.
+   *
+   * The inodes not accessed since `mount:inode-unload-maximum-age` are
+   * unloaded first, then that age is halved until the target is reached or
+   * the age drops below `mount:inode-unload-minimum-age`. The memory of the
+   * inodes is estimated from the size of the inode objects.
+   */
+  InodeUnloadPassStats runInodeUnloadPolicy(const EdenConfig& config);
+
+  /**
+   * Look for materialized files whose contents and type match the checked
+   * out commit and dematerialize them, so that status and checkout no longer
+   * need to compare them. Formatters and checkouts that touch files without
+   * changing them commonly leave such files behind.
+   *
+   * Only the files whose inodes aren't loaded and that weren't modified in
+   * the last `mount:dematerialize-unchanged-files-minimum-age` are hashed. A
+   * pass stops after hashing `mount:dematerialize-unchanged-files-max-per-pass`
+   * files or `mount:dematerialize-unchanged-files-max-bytes-per-pass` bytes.
+   * The files found to differ are remembered with their mtime, and skipped
+   * by the next passes unless modified, so that rate limited passes make
+   * progress.
+   *
+   * Returns empty stats if a pass is already running.
+   */
+  ImmediateFuture<DematerializePassStats> dematerializeUnchangedFiles(
+      const EdenConfig& config,
+      const ObjectFetchContextPtr& context);
+#endif
+
   /**
    * If we have a FUSE or NFS channel, flush all invalidations we sent to the
    * kernel This will ensure that other processes will see up-to-date data once
@@ -1090,18 +1315,54 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
       bool listIgnored = false) const;
 
   /**
-   * This accepts a callback which will be invoked as differences are found.
-   * Note that the callback methods may be invoked simultaneously from multiple
-   * different threads, and the callback is responsible for performing
-   * synchronization (if it is needed). It will be packaged into a DiffContext
-   * and passed through the TreeInode diff() codepath
+   * Diff the whole working copy against commitHash. When
+   * cacheAtSequence is set and the status has no errors, it is cached as the
+   * status of the working copy at that journal sequence number.
    */
-  FOLLY_NODISCARD ImmediateFuture<folly::Unit> diff(
-      DiffCallback* callback,
+  ImmediateFuture<std::unique_ptr<ScmStatus>> computeScmStatus(
       const RootId& commitHash,
+      folly::CancellationToken cancellation,
       bool listIgnored,
       bool enforceCurrentParent,
-      folly::CancellationToken cancellation) const;
+      std::optional<uint64_t> cacheAtSequence);
+
+  /**
+   * The part of diff() that runs once the pending notifications are
+   * processed, when the status is for the checked out commit rootTree.
+   */
+  ImmediateFuture<std::unique_ptr<ScmStatus>> diffWithStatusCache(
+      const RootId& commitHash,
+      std::shared_ptr<const Tree> rootTree,
+      folly::CancellationToken cancellation,
+      bool listIgnored,
+      bool enforceCurrentParent);
+
+  /**
+   * Update status, the status of the working copy against rootTree, for the
+   * changes to paths. Returns std::nullopt when one of the paths can't be
+   * re-verified on its own, for instance because it is a directory or a
+   * .gitignore file, or because telling whether it is ignored would take
+   * evaluating the ignore files.
+   */
+  ImmediateFuture<std::optional<ScmStatus>> updateScmStatus(
+      ScmStatus status,
+      std::shared_ptr<const Tree> rootTree,
+      std::vector<RelativePath> paths);
+
+  /**
+   * Fetch the trees and blob metadata a checkout from fromRoot to toRoot is
+   * going to need, before the checkout walks the inodes, by diffing the two
+   * roots: the diff requests every tree that differs between them and the
+   * metadata of the files modified between them concurrently, which lets the
+   * backing store batch the requests.
+   *
+   * Errors are only logged, the checkout fetches the objects again and
+   * reports them.
+   */
+  ImmediateFuture<folly::Unit> prefetchCheckoutObjects(
+      const RootId& fromRoot,
+      const RootId& toRoot,
+      std::shared_ptr<CheckoutContext> ctx) const;
 
   /**
    * Signal to unmount() that fuseMount() or takeoverFuse() has started.
@@ -1153,7 +1414,8 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
   ~EdenMount();
 
   friend class TreePrefetchLease;
-  void treePrefetchFinished() noexcept;
+  void treePrefetchFinished(
+      std::chrono::steady_clock::duration duration) noexcept;
 
   static constexpr int kMaxSymlinkChainDepth = 40; // max depth of symlink chain
 
@@ -1203,6 +1465,19 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
 #endif // !_WIN32
   InodeNumber dotEdenInodeNumber_{};
 
+  using PathLookupCache = folly::Synchronized<
+      folly::EvictingCacheMap<RelativePath, InodeNumber>,
+      std::mutex>;
+
+  /**
+   * The inodes recently found by getInodeSlow() and getVirtualInode(), by
+   * path, so that resolving a deep path again, or the path of a sibling,
+   * doesn't walk every directory along it. Renames and unlinks don't update
+   * it: entries are checked against the current path of the inode when used.
+   * Null when mount:path-lookup-cache-size is 0.
+   */
+  std::unique_ptr<PathLookupCache> pathLookupCache_;
+
   /**
    * A mutex around all name-changing operations in this mount point.
    *
@@ -1237,6 +1512,14 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
   std::unique_ptr<Journal> journal_;
   folly::Synchronized<std::unique_ptr<IActivityRecorder>> activityRecorder_;
 
+  /**
+   * Written by the initialize() callbacks, one after the other.
+   */
+  InitializeTimings initializeTimings_;
+  std::chrono::steady_clock::duration channelStartDuration_{};
+
+  std::atomic<int64_t> takeoverBlackoutMs_{0};
+
   /**
    * A number to uniquely identify this particular incarnation of this mount.
    * We use bits from the process id and the time at which we were mounted.
@@ -1264,6 +1547,35 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   std::atomic<EdenTimestamp> lastCheckoutTime_;
 
+  std::atomic<uint64_t> inodeMetadataGeneration_{0};
+
+  /**
+   * The last status computed against the checked out commit by diff(), and
+   * the journal sequence number of the working copy it reflects.
+   */
+  struct CachedScmStatus {
+    RootId commit;
+    bool listIgnored;
+    uint64_t sequence;
+    ScmStatus status;
+  };
+  folly::Synchronized<std::optional<CachedScmStatus>> scmStatusCache_;
+
+#ifndef _WIN32
+  /**
+   * Set while a dematerializeUnchangedFiles() pass runs, so that passes
+   * don't overlap.
+   */
+  std::atomic<bool> dematerializing_{false};
+
+  /**
+   * The materialized files found to differ from the checked out commit by
+   * the last passes of dematerializeUnchangedFiles(), with their mtime at the
+   * time.
+   */
+  folly::Synchronized<DematerializePass::FileMtimes> knownDifferentFiles_;
+#endif
+
   struct MountingUnmountingState {
     bool channelMountStarted() const noexcept;
     bool channelUnmountStarted() const noexcept;
@@ -1324,6 +1636,9 @@ class EdenMount : public std::enable_shared_from_this<EdenMount> {
    */
   std::atomic<uint64_t> numPrefetchesInProgress_{0};
 
+  ReaddirPrefetchPolicy readdirPrefetchPolicy_;
+  ReadAheadTracker readAheadTracker_;
+
   /**
    * Fixed sized buffer containing recent inode events that have occured within
    * EdenFS. Used in the retroactive version of the eden inode trace command.
@@ -10,6 +10,7 @@
 #include <fmt/format.h>
 #include <optional>
 
+#include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 #include <folly/io/async/EventBase.h>
@@ -44,6 +45,43 @@ using std::vector;
 
 namespace facebook::eden {
 
+#ifndef _WIN32
+namespace {
+/**
+ * The fetches issued ahead of the reads of a process, on its behalf.
+ */
+class ReadAheadFetchContext : public ObjectFetchContext {
+ public:
+  explicit ReadAheadFetchContext(std::optional<pid_t> clientPid)
+      : clientPid_{clientPid} {}
+
+  std::optional<pid_t> getClientPid() const override {
+    return clientPid_;
+  }
+
+  Cause getCause() const override {
+    return Cause::Prefetch;
+  }
+
+  std::optional<std::string_view> getCauseDetail() const override {
+    return "read-ahead";
+  }
+
+  ImportPriority getPriority() const override {
+    return kReadAheadPriority;
+  }
+
+  const std::unordered_map<std::string, std::string>* FOLLY_NULLABLE
+  getRequestInfo() const override {
+    return nullptr;
+  }
+
+ private:
+  std::optional<pid_t> clientPid_;
+};
+} // namespace
+#endif // !_WIN32
+
 /*********************************************************************
  * FileInode::LockedState
  ********************************************************************/
@@ -54,12 +92,19 @@ namespace facebook::eden {
  *
  * It implements operator->() and operator*() so it can be used just like
  * LockedPtr.
+ *
+ * Acquiring it invalidates the stat snapshot of the inode, as the state may be
+ * modified until it is released.
  */
 class FileInode::LockedState {
  public:
-  explicit LockedState(FileInode* inode) : ptr_{inode->state_.wlock()} {}
+  explicit LockedState(FileInode* inode) : ptr_{inode->state_.wlock()} {
+    invalidateStatSnapshot(*inode);
+  }
   explicit LockedState(const FileInodePtr& inode)
-      : ptr_{inode->state_.wlock()} {}
+      : ptr_{inode->state_.wlock()} {
+    invalidateStatSnapshot(*inode);
+  }
 
   LockedState(LockedState&&) = default;
   LockedState& operator=(LockedState&&) = default;
@@ -102,6 +147,12 @@ class FileInode::LockedState {
       BlobCache::Interest interest);
 
  private:
+  static void invalidateStatSnapshot(FOLLY_MAYBE_UNUSED FileInode& inode) {
+#ifndef _WIN32
+    inode.statSnapshot_.invalidate();
+#endif
+  }
+
   folly::Synchronized<State>::LockedPtr ptr_;
 };
 
@@ -565,7 +616,21 @@ ImmediateFuture<std::string> FileInode::readlink(
     throw InodeError(EINVAL, inodePtrFromThis(), "not a symlink");
   }
 
-  // The symlink contents are simply the file contents!
+  // The symlink contents are simply the file contents! Unless it was
+  // materialized, read them through the ObjectStore, which remembers them
+  // after this inode and its blob were unloaded.
+  std::optional<ObjectId> id;
+  {
+    auto state = LockedState{this};
+    if (state->nonMaterializedState) {
+      id = state->nonMaterializedState->hash;
+      updateAtimeLocked(*state);
+    }
+  }
+  if (id) {
+    logAccess(*fetchContext);
+    return getObjectStore().getSymlinkTarget(*id, fetchContext);
+  }
   return readAll(fetchContext, cacheHint);
 }
 #endif // !_WIN32
@@ -675,10 +740,31 @@ mode_t FileInode::getPermissions() const {
 }
 
 InodeMetadata FileInode::getMetadata() const {
+  if (auto snapshot = loadStatSnapshot()) {
+    return snapshot->metadata;
+  }
   auto lock = state_.rlock();
   return getMetadataLocked(*lock);
 }
 
+std::optional<FileInode::StatSnapshot> FileInode::loadStatSnapshot() const {
+  auto snapshot = statSnapshot_.load();
+  if (snapshot &&
+      snapshot->metadataGeneration !=
+          getMount()->getInodeMetadataGeneration()) {
+    return std::nullopt;
+  }
+  return snapshot;
+}
+
+void FileInode::publishStatSnapshot(
+    LockedState&,
+    uint64_t metadataGeneration,
+    const InodeMetadata& metadata,
+    uint64_t size) {
+  statSnapshot_.store(StatSnapshot{metadata, size, metadataGeneration});
+}
+
 #else
 mode_t FileInode::getMode() const {
   // On Windows we only store the dir type info and no permissions bits here.
@@ -688,7 +774,7 @@ mode_t FileInode::getMode() const {
 #endif // !_WIN32
 
 void FileInode::forceMetadataUpdate() {
-  auto state = state_.wlock();
+  auto state = LockedState{this};
   InodeBaseMetadata::updateMtimeAndCtimeLocked(*state, getNow());
 }
 
@@ -700,6 +786,10 @@ std::optional<ObjectId> FileInode::getBlobHash() const {
   }
 }
 
+bool FileInode::isMaterialized() const {
+  return state_.rlock()->isMaterialized();
+}
+
 void FileInode::materializeInParent() {
   auto renameLock = getMount()->acquireRenameLock();
   auto loc = getLocationInfo(renameLock);
@@ -806,10 +896,23 @@ ImmediateFuture<struct stat> FileInode::stat(
   // NOTE: we don't set rdev to anything special here because we
   // don't support committing special device nodes.
 
+#ifndef _WIN32
+  // Hot files are stat'd concurrently by many threads, serve them without
+  // acquiring the state_ lock when nothing changed since the last stat.
+  if (auto snapshot = loadStatSnapshot()) {
+    snapshot->metadata.applyToStat(st);
+    st.st_size = snapshot->size;
+    updateBlockCount(st);
+    return st;
+  }
+#endif
+
   auto state = LockedState{this};
 
 #ifndef _WIN32
-  getMetadataLocked(*state).applyToStat(st);
+  auto metadataGeneration = getMount()->getInodeMetadataGeneration();
+  auto metadata = getMetadataLocked(*state);
+  metadata.applyToStat(st);
 #endif
 
   if (state->isMaterialized()) {
@@ -818,6 +921,7 @@ ImmediateFuture<struct stat> FileInode::stat(
     getMaterializedFileSize(st, pathToFile);
 #else
     st.st_size = getOverlayFileAccess(state)->getFileSize(*this);
+    publishStatSnapshot(state, metadataGeneration, metadata, st.st_size);
 #endif
     updateBlockCount(st);
     return st;
@@ -827,6 +931,13 @@ ImmediateFuture<struct stat> FileInode::stat(
     if (state->nonMaterializedState->size !=
         FileInodeState::NonMaterializedState::kUnknownSize) {
       st.st_size = state->nonMaterializedState->size;
+#ifndef _WIN32
+      publishStatSnapshot(
+          state,
+          metadataGeneration,
+          metadata,
+          state->nonMaterializedState->size);
+#endif
       updateBlockCount(st);
       return st;
     }
@@ -1010,12 +1121,26 @@ ImmediateFuture<folly::Unit> FileInode::ensureMaterialized(
 ImmediateFuture<std::tuple<BufVec, bool>>
 FileInode::read(size_t size, off_t off, const ObjectFetchContextPtr& context) {
   XDCHECK_GE(off, 0);
+  if (off == 0) {
+    // Before locking the state, as this locks the contents of the parent.
+    readAheadFiles(*context);
+  }
+  auto state = LockedState{this};
+  std::shared_ptr<const Blob> blob;
+  if (shouldReadBlobRange(state)) {
+    // Prefer the whole blob if it happens to be cached already.
+    blob = state.getCachedBlob(getMount(), BlobCache::Interest::WantHandle);
+    if (!blob) {
+      return readBlobRange(std::move(state), size, off, context);
+    }
+  }
+
   return runWhileDataLoaded(
-      LockedState{this},
+      std::move(state),
       BlobCache::Interest::WantHandle,
       // This function is only called by FUSE.
       context,
-      nullptr,
+      std::move(blob),
       [size, off, self = inodePtrFromThis()](
           LockedState&& state,
           std::shared_ptr<const Blob> blob) -> std::tuple<BufVec, bool> {
@@ -1048,8 +1173,11 @@ FileInode::read(size_t size, off_t off, const ObjectFetchContextPtr& context) {
           state->readByteRanges.clear();
         }
 
-        auto buf = blob->getContents();
-        folly::io::Cursor cursor(&buf);
+        // Slice the requested range straight out of the blob's buffers: the
+        // returned chain shares them by refcount and is handed as-is to the
+        // FS channel. Copying the IOBuf first would clone the header of every
+        // element of the chain, even the ones outside of the range.
+        folly::io::Cursor cursor(&blob->getContents());
 
         if (!cursor.canAdvance(off)) {
           // Seek beyond EOF.  Return an empty result.
@@ -1065,6 +1193,183 @@ FileInode::read(size_t size, off_t off, const ObjectFetchContextPtr& context) {
       });
 }
 
+#ifdef __linux__
+std::optional<size_t>
+FileInode::spliceRead(size_t size, off_t off, int pipeFd) {
+  XDCHECK_GE(off, 0);
+  auto state = LockedState{this};
+  if (state->tag != State::MATERIALIZED_IN_OVERLAY) {
+    return std::nullopt;
+  }
+  auto spliced = getOverlayFileAccess(state)->splice(*this, size, off, pipeFd);
+  updateAtimeLocked(*state);
+  return spliced;
+}
+#endif
+
+bool FileInode::shouldReadBlobRange(const LockedState& state) const {
+  if (state->tag != State::BLOB_NOT_LOADING) {
+    return false;
+  }
+  auto blobSize = state->nonMaterializedState->size;
+  auto minimumSize =
+      getMount()->getEdenConfig()->blobRangeReadMinimumSize.getValue();
+  return blobSize != State::NonMaterializedState::kUnknownSize &&
+      minimumSize != 0 && blobSize >= minimumSize &&
+      getObjectStore().supportsBlobRanges();
+}
+
+ImmediateFuture<std::tuple<BufVec, bool>> FileInode::readBlobRange(
+    LockedState state,
+    size_t size,
+    off_t off,
+    const ObjectFetchContextPtr& context) {
+  XDCHECK_EQ(state->tag, State::BLOB_NOT_LOADING);
+  auto id = state->nonMaterializedState->hash;
+  auto blobSize = state->nonMaterializedState->size;
+  state.unlock();
+
+  logAccess(*context);
+  readAheadRange(id, blobSize, size, off, *context);
+  return getObjectStore()
+      .getBlobRange(id, static_cast<uint64_t>(off), size, context)
+      .thenValue([self = inodePtrFromThis(), size, off, blobSize](
+                     std::unique_ptr<folly::IOBuf> buf)
+                     -> std::tuple<BufVec, bool> {
+        auto state = LockedState{self};
+        SCOPE_SUCCESS {
+          self->updateAtimeLocked(*state);
+        };
+
+        // The file was written to while the range was fetched, the overlay
+        // has the current contents.
+        if (state->tag == State::MATERIALIZED_IN_OVERLAY) {
+          auto overlayBuf =
+              self->getOverlayFileAccess(state)->read(*self, size, off);
+          auto eof = size != 0 && overlayBuf->empty();
+          return {std::move(overlayBuf), eof};
+        }
+
+        auto end = static_cast<uint64_t>(off) + buf->computeChainDataLength();
+        return {BufVec{std::move(buf)}, end >= blobSize};
+      });
+}
+
+void FileInode::readAheadFiles(const ObjectFetchContext& context) {
+  auto* mount = getMount();
+  auto config = mount->getEdenConfig();
+  size_t maxFiles = config->readAheadFiles.getValue();
+  if (!config->readAhead.getValue() || maxFiles == 0) {
+    return;
+  }
+  auto parent = getParentRacy();
+  if (!parent) {
+    // Unlinked.
+    return;
+  }
+  auto name = getNameRacy();
+
+  // The files around this one in directory order, which is the order in which
+  // readdir lists them. Directories are skipped, and the materialized files
+  // have nothing to fetch.
+  std::optional<InodeNumber> previous;
+  std::vector<std::optional<ObjectId>> next;
+  {
+    auto contents = parent->getContents().rlock();
+    const auto& entries = contents->entries;
+    auto it = entries.find(name);
+    if (it == entries.end()) {
+      return;
+    }
+    for (auto prev = it; prev != entries.begin();) {
+      --prev;
+      if (!prev->second.isDirectory()) {
+        previous = prev->second.getInodeNumber();
+        break;
+      }
+    }
+    for (++it; it != entries.end() && next.size() < maxFiles; ++it) {
+      if (!it->second.isDirectory()) {
+        next.push_back(it->second.getOptionalHash());
+      }
+    }
+  }
+
+  auto files = mount->getReadAheadTracker().recordFileStart(
+      context.getClientPid(),
+      parent->getNodeId(),
+      getNodeId(),
+      previous,
+      maxFiles);
+  auto ids = std::make_shared<std::vector<ObjectId>>();
+  for (size_t i = files.first; i < files.first + files.count && i < next.size();
+       ++i) {
+    if (next[i]) {
+      ids->push_back(std::move(*next[i]));
+    }
+  }
+  if (ids->empty()) {
+    return;
+  }
+
+  XLOG(DBG4) << "reading ahead " << ids->size() << " files after "
+             << getLogPath();
+  mount->getStats()->increment(&InodeStats::readAheadFiles, ids->size());
+  auto fetchContext =
+      makeRefPtr<ReadAheadFetchContext>(context.getClientPid());
+  getObjectStore()
+      .prefetchBlobs(ObjectIdRange{ids->data(), ids->size()}, fetchContext)
+      .semi()
+      .via(&folly::QueuedImmediateExecutor::instance())
+      .thenTry([ids](folly::Try<size_t>&& result) {
+        if (result.hasException()) {
+          XLOG(DBG3) << "read ahead of " << ids->size()
+                     << " files failed: " << result.exception().what();
+        }
+      });
+}
+
+void FileInode::readAheadRange(
+    const ObjectId& id,
+    uint64_t blobSize,
+    size_t size,
+    off_t off,
+    const ObjectFetchContext& context) {
+  auto* mount = getMount();
+  auto config = mount->getEdenConfig();
+  if (!config->readAhead.getValue()) {
+    return;
+  }
+  auto range = mount->getReadAheadTracker().recordRead(
+      context.getClientPid(),
+      getNodeId(),
+      static_cast<uint64_t>(off),
+      size,
+      blobSize,
+      config->readAheadMaxBytes.getValue());
+  if (range.length == 0) {
+    return;
+  }
+
+  XLOG(DBG4) << "reading ahead " << range.length << " bytes at "
+             << range.offset << " of " << getLogPath();
+  mount->getStats()->increment(&InodeStats::readAheadBytes, range.length);
+  // Fetching the range fills the chunk cache of the ObjectStore, which the
+  // next reads are served from.
+  auto fetchContext =
+      makeRefPtr<ReadAheadFetchContext>(context.getClientPid());
+  getObjectStore()
+      .getBlobRange(id, range.offset, range.length, fetchContext)
+      .semi()
+      .via(&folly::QueuedImmediateExecutor::instance())
+      .thenTry([id](folly::Try<std::unique_ptr<folly::IOBuf>>&& result) {
+        if (result.hasException()) {
+          XLOG(DBG3) << "read ahead of " << id
+                     << " failed: " << result.exception().what();
+        }
+      });
+}
+
 size_t FileInode::writeImpl(
     LockedState& state,
     const struct iovec* iov,
@@ -1223,7 +1528,8 @@ void FileInode::materializeNow(
     blobSha1 = std::move(blobSha1Future).get();
   }
 
-  getOverlayFileAccess(state)->createFile(getNodeId(), *blob, blobSha1);
+  getOverlayFileAccess(state)->createFile(
+      getNodeId(), state->nonMaterializedState->hash, *blob, blobSha1);
 
   state.setMaterialized();
 }
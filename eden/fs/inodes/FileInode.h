@@ -20,6 +20,7 @@
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/utils/BufVec.h"
 #include "eden/fs/utils/CoverageSet.h"
+#include "eden/fs/utils/SeqLock.h"
 
 namespace folly {
 class File;
@@ -239,6 +240,12 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
    */
   std::optional<ObjectId> getBlobHash() const;
 
+  /**
+   * Whether the contents of this file are in the overlay. Like getBlobHash(),
+   * this may be outdated by the time it returns.
+   */
+  bool isMaterialized() const;
+
   /**
    * Read the entire file contents, and return them as a string.
    *
@@ -270,6 +277,19 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
   ImmediateFuture<std::tuple<BufVec, bool>>
   read(size_t size, off_t off, const ObjectFetchContextPtr& context);
 
+#ifdef __linux__
+  /**
+   * If the file is materialized, splice up to size bytes from the specified
+   * offset into the pipe and return the number of bytes spliced, fewer than
+   * size only at EOF. Returns std::nullopt otherwise, in which case read()
+   * should be used instead. The pipe must have room for size bytes.
+   *
+   * May throw exceptions on error, in which case the pipe may hold part of
+   * the data.
+   */
+  std::optional<size_t> spliceRead(size_t size, off_t off, int pipeFd);
+#endif
+
   ImmediateFuture<size_t>
   write(BufVec&& buf, off_t off, const ObjectFetchContextPtr& fetchContext);
   ImmediateFuture<size_t> write(
@@ -392,6 +412,44 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
    */
   void truncateInOverlay(LockedState& state);
 
+  /**
+   * Whether read() should only fetch the range it reads instead of the whole
+   * blob: the file isn't materialized nor being loaded, is at least
+   * store:blob-range-read-minimum-size bytes, and the ObjectStore can fetch
+   * ranges of blobs.
+   */
+  bool shouldReadBlobRange(const LockedState& state) const;
+
+  /**
+   * Read from the blob by fetching only the chunks covering the range.
+   * state->tag must be BLOB_NOT_LOADING and the size of the blob known.
+   */
+  ImmediateFuture<std::tuple<BufVec, bool>> readBlobRange(
+      LockedState state,
+      size_t size,
+      off_t off,
+      const ObjectFetchContextPtr& context);
+
+  /**
+   * Called by read() when it reads from the start of the file, before the
+   * state is locked. Prefetches the files that follow this one in its
+   * directory when the reading process reads the files of the directory in
+   * order. See ReadAheadTracker.
+   */
+  void readAheadFiles(const ObjectFetchContext& context);
+
+  /**
+   * Called by readBlobRange(). Fetches the bytes that follow the range read,
+   * into the chunk cache of the ObjectStore, when the reading process reads
+   * the file sequentially. See ReadAheadTracker.
+   */
+  void readAheadRange(
+      const ObjectId& id,
+      uint64_t blobSize,
+      size_t size,
+      off_t off,
+      const ObjectFetchContext& context);
+
 #endif // !_WIN32
 
   /**
@@ -480,8 +538,45 @@ class FileInode final : public InodeBaseMetadata<FileInodeState> {
    */
   void logAccess(const ObjectFetchContext& fetchContext);
 
+#ifndef _WIN32
+  /**
+   * The fields of the inode returned by stat(), published so that stat() and
+   * getMetadata() don't have to acquire the state_ lock.
+   */
+  struct StatSnapshot {
+    InodeMetadata metadata;
+    uint64_t size;
+    // EdenMount::getInodeMetadataGeneration() when the snapshot was taken.
+    uint64_t metadataGeneration;
+  };
+
+  /**
+   * Returns the published snapshot, or std::nullopt if there is none or it is
+   * stale.
+   */
+  std::optional<StatSnapshot> loadStatSnapshot() const;
+
+  /**
+   * Publish the snapshot of an inode whose metadata generation, metadata and
+   * size were read under the state_ lock, currently held.
+   */
+  void publishStatSnapshot(
+      LockedState& state,
+      uint64_t metadataGeneration,
+      const InodeMetadata& metadata,
+      uint64_t size);
+#endif // !_WIN32
+
   folly::Synchronized<State> state_;
 
+#ifndef _WIN32
+  /**
+   * Published by stat() while holding the state_ lock, and invalidated
+   * whenever it is acquired for writing, before anything is modified.
+   */
+  SeqLock<StatSnapshot> statSnapshot_;
+#endif // !_WIN32
+
   // So it can call inodePtrFromThis() for better error messages.
   friend class ::facebook::eden::OverlayFileAccess;
 };
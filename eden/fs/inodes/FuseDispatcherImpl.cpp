@@ -9,6 +9,9 @@
 
 #include "eden/fs/inodes/FuseDispatcherImpl.h"
 #include <folly/logging/xlog.h>
+#include <algorithm>
+#include <limits>
+#include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/fuse/DirList.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
@@ -56,17 +59,37 @@ FuseDispatcher::Attr attrForInodeWithCorruptOverlay(InodeNumber ino) noexcept {
 FuseDispatcherImpl::FuseDispatcherImpl(EdenMount* mount)
     : FuseDispatcher(mount->getStats()),
       mount_(mount),
-      inodeMap_(mount_->getInodeMap()) {}
+      inodeMap_(mount_->getInodeMap()),
+      materializedAttrTimeout_(static_cast<uint64_t>(std::clamp<int64_t>(
+          std::chrono::duration_cast<std::chrono::seconds>(
+              mount->getEdenConfig()->fuseMaterializedAttrTimeout.getValue())
+              .count(),
+          0,
+          std::numeric_limits<int32_t>::max()))) {}
+
+FuseDispatcher::Attr FuseDispatcherImpl::makeAttr(
+    const InodeBase& inode,
+    const struct stat& st) const {
+  // Source control trees and blobs can only change through checkout, which
+  // invalidates the kernel's caches, and so do the changes to directories
+  // made by EdenFS. The kernel knows about the writes it sends us.
+  if (!inode.isDir() &&
+      static_cast<const FileInode&>(inode).isMaterialized()) {
+    return FuseDispatcher::Attr{st, materializedAttrTimeout_};
+  }
+  return FuseDispatcher::Attr{st};
+}
 
 ImmediateFuture<FuseDispatcher::Attr> FuseDispatcherImpl::getattr(
     InodeNumber ino,
     const ObjectFetchContextPtr& context) {
-  return inodeMap_->lookupInode(ino)
-      .thenValue([context = context.copy()](const InodePtr& inode) {
-        return inode->stat(context);
-      })
-      .thenValue(
-          [](const struct stat& st) { return FuseDispatcher::Attr{st}; });
+  return inodeMap_->lookupInode(ino).thenValue(
+      [this, context = context.copy()](const InodePtr& inode) {
+        return inode->stat(context).thenValue(
+            [this, inode](const struct stat& st) {
+              return makeAttr(*inode, st);
+            });
+      });
 }
 
 ImmediateFuture<uint64_t> FuseDispatcherImpl::opendir(
@@ -98,15 +121,15 @@ ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::lookup(
   return inodeMap_->lookupTreeInode(parent)
       .thenValue([name = PathComponent(namepiece),
                   context = context.copy()](const TreeInodePtr& tree) {
+        tree->getMount()->recordChildLookup(tree->getNodeId(), *context);
         return tree->getOrLoadChild(name, context);
       })
-      .thenValue([context = context.copy()](const InodePtr& inode) {
+      .thenValue([this, context = context.copy()](const InodePtr& inode) {
         return makeImmediateFutureWith([&]() { return inode->stat(context); })
-            .thenTry([inode](folly::Try<struct stat> maybeStat) {
+            .thenTry([this, inode](folly::Try<struct stat> maybeStat) {
               if (maybeStat.hasValue()) {
                 inode->incFsRefcount();
-                return computeEntryParam(
-                    FuseDispatcher::Attr{maybeStat.value()});
+                return computeEntryParam(makeAttr(*inode, maybeStat.value()));
               } else {
                 // The most common case for stat() failing is if this file is
                 // materialized but the data for it in the overlay is missing
@@ -197,10 +220,10 @@ ImmediateFuture<FuseDispatcher::Attr> FuseDispatcherImpl::setattr(
           desired.mtime = now;
         }
 
-        return inode->setattr(desired, context);
-      })
-      .thenValue([](struct stat&& stat) {
-        return FuseDispatcher::Attr{std::move(stat)};
+        return inode->setattr(desired, context)
+            .thenValue([this, inode](struct stat&& stat) {
+              return makeAttr(*inode, stat);
+            });
       });
 }
 
@@ -232,13 +255,13 @@ ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::create(
   // (and thus can be zero)
   mode = S_IFREG | (07777 & mode);
   return inodeMap_->lookupTreeInode(parent).thenValue(
-      [mode, childName = PathComponent{name}, context = context.copy()](
+      [this, mode, childName = PathComponent{name}, context = context.copy()](
           const TreeInodePtr& inode) {
         auto child = inode->mknod(childName, mode, 0, InvalidationRequired::No);
         return child->stat(context).thenValue(
-            [child](struct stat st) -> fuse_entry_out {
+            [this, child](struct stat st) -> fuse_entry_out {
               child->incFsRefcount();
-              return computeEntryParam(FuseDispatcher::Attr{st});
+              return computeEntryParam(makeAttr(*child, st));
             });
       });
 }
@@ -257,6 +280,20 @@ ImmediateFuture<BufVec> FuseDispatcherImpl::read(
       });
 }
 
+#ifdef __linux__
+ImmediateFuture<std::optional<size_t>> FuseDispatcherImpl::spliceRead(
+    InodeNumber ino,
+    size_t size,
+    off_t off,
+    int pipeFd,
+    const ObjectFetchContextPtr& /*context*/) {
+  return inodeMap_->lookupFileInode(ino).thenValue(
+      [size, off, pipeFd](FileInodePtr&& inode) {
+        return inode->spliceRead(size, off, pipeFd);
+      });
+}
+#endif
+
 ImmediateFuture<size_t> FuseDispatcherImpl::write(
     InodeNumber ino,
     folly::StringPiece data,
@@ -336,6 +373,56 @@ ImmediateFuture<FuseDirList> FuseDispatcherImpl::readdir(
       });
 }
 
+#ifdef __linux__
+ImmediateFuture<FuseDirPlusList> FuseDispatcherImpl::readdirplus(
+    InodeNumber ino,
+    FuseDirPlusList&& dirList,
+    off_t offset,
+    uint64_t /*fh*/,
+    const ObjectFetchContextPtr& context) {
+  return inodeMap_->lookupTreeInode(ino).thenValue(
+      [this, dirList = std::move(dirList), offset, context = context.copy()](
+          TreeInodePtr tree) mutable {
+        auto list = tree->fuseReaddirPlus(std::move(dirList), offset, context);
+
+        // Look up the entries like lookup() does. An entry whose lookup fails,
+        // e.g. because it was removed since, is only listed.
+        std::vector<ImmediateFuture<fuse_entry_out>> entryOuts;
+        entryOuts.reserve(list.size());
+        for (auto& entry : list.extract()) {
+          if (entry.name == "." || entry.name == "..") {
+            entryOuts.emplace_back(fuse_entry_out{});
+            continue;
+          }
+          entryOuts.push_back(
+              tree->getOrLoadChild(PathComponent{entry.name}, context)
+                  .thenValue([this, context = context.copy()](InodePtr inode) {
+                    return makeImmediateFutureWith([&]() {
+                             return inode->stat(context);
+                           })
+                        .thenValue([this, inode](struct stat st) {
+                          inode->incFsRefcount();
+                          return computeEntryParam(makeAttr(*inode, st));
+                        });
+                  })
+                  .thenTry([](folly::Try<fuse_entry_out> entryOut) {
+                    return entryOut.hasValue() ? entryOut.value()
+                                               : fuse_entry_out{};
+                  }));
+        }
+
+        return collectAllSafe(std::move(entryOuts))
+            .thenValue([list = std::move(list)](
+                           std::vector<fuse_entry_out> entryOuts) mutable {
+              for (size_t i = 0; i < entryOuts.size(); ++i) {
+                list.setEntryOut(i, entryOuts[i]);
+              }
+              return std::move(list);
+            });
+      });
+}
+#endif
+
 ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::mknod(
     InodeNumber parent,
     PathComponentPiece name,
@@ -343,14 +430,17 @@ ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::mknod(
     dev_t rdev,
     const ObjectFetchContextPtr& context) {
   return inodeMap_->lookupTreeInode(parent).thenValue(
-      [childName = PathComponent{name}, mode, rdev, context = context.copy()](
-          const TreeInodePtr& inode) {
+      [this,
+       childName = PathComponent{name},
+       mode,
+       rdev,
+       context = context.copy()](const TreeInodePtr& inode) {
         auto child =
             inode->mknod(childName, mode, rdev, InvalidationRequired::No);
         return child->stat(context).thenValue(
-            [child](struct stat st) -> fuse_entry_out {
+            [this, child](struct stat st) -> fuse_entry_out {
               child->incFsRefcount();
-              return computeEntryParam(FuseDispatcher::Attr{st});
+              return computeEntryParam(makeAttr(*child, st));
             });
       });
 }
@@ -361,12 +451,12 @@ ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::mkdir(
     mode_t mode,
     const ObjectFetchContextPtr& context) {
   return inodeMap_->lookupTreeInode(parent).thenValue(
-      [childName = PathComponent{name}, mode, context = context.copy()](
+      [this, childName = PathComponent{name}, mode, context = context.copy()](
           const TreeInodePtr& inode) {
         auto child = inode->mkdir(childName, mode, InvalidationRequired::No);
-        return child->stat(context).thenValue([child](struct stat st) {
+        return child->stat(context).thenValue([this, child](struct stat st) {
           child->incFsRefcount();
-          return computeEntryParam(FuseDispatcher::Attr{st});
+          return computeEntryParam(makeAttr(*child, st));
         });
       });
 }
@@ -401,15 +491,16 @@ ImmediateFuture<fuse_entry_out> FuseDispatcherImpl::symlink(
     StringPiece link,
     const ObjectFetchContextPtr& context) {
   return inodeMap_->lookupTreeInode(parent).thenValue(
-      [linkContents = link.str(),
+      [this,
+       linkContents = link.str(),
        childName = PathComponent{name},
        context = context.copy()](const TreeInodePtr& inode) {
         auto symlinkInode =
             inode->symlink(childName, linkContents, InvalidationRequired::No);
         symlinkInode->incFsRefcount();
         return symlinkInode->stat(context).thenValue(
-            [symlinkInode](struct stat st) {
-              return computeEntryParam(FuseDispatcher::Attr{st});
+            [this, symlinkInode](struct stat st) {
+              return computeEntryParam(makeAttr(*symlinkInode, st));
             });
       });
 }
@@ -12,6 +12,7 @@
 namespace facebook::eden {
 
 class EdenMount;
+class InodeBase;
 class InodeMap;
 
 /**
@@ -95,6 +96,14 @@ class FuseDispatcherImpl : public FuseDispatcher {
       size_t size,
       off_t off,
       const ObjectFetchContextPtr& context) override;
+#ifdef __linux__
+  ImmediateFuture<std::optional<size_t>> spliceRead(
+      InodeNumber ino,
+      size_t size,
+      off_t off,
+      int pipeFd,
+      const ObjectFetchContextPtr& context) override;
+#endif
   ImmediateFuture<size_t> write(
       InodeNumber ino,
       folly::StringPiece data,
@@ -118,6 +127,14 @@ class FuseDispatcherImpl : public FuseDispatcher {
       off_t offset,
       uint64_t fh,
       const ObjectFetchContextPtr& context) override;
+#ifdef __linux__
+  ImmediateFuture<FuseDirPlusList> readdirplus(
+      InodeNumber ino,
+      FuseDirPlusList&& dirList,
+      off_t offset,
+      uint64_t fh,
+      const ObjectFetchContextPtr& context) override;
+#endif
 
   ImmediateFuture<std::string> getxattr(
       InodeNumber ino,
@@ -126,6 +143,12 @@ class FuseDispatcherImpl : public FuseDispatcher {
   ImmediateFuture<std::vector<std::string>> listxattr(InodeNumber ino) override;
 
  private:
+  /**
+   * The attributes of inode to send to the kernel, with a timeout depending
+   * on whether the inode may change without the kernel being told.
+   */
+  Attr makeAttr(const InodeBase& inode, const struct stat& st) const;
+
   // The EdenMount associated with this dispatcher.
   EdenMount* const mount_;
 
@@ -134,6 +157,10 @@ class FuseDispatcherImpl : public FuseDispatcher {
   // every FUSE request, and having it locally avoids having to dereference
   // mount_ first.
   InodeMap* const inodeMap_;
+
+  // How long the kernel may cache the attributes of materialized files, in
+  // seconds.
+  const uint64_t materializedAttrTimeout_;
 };
 
 } // namespace facebook::eden
@@ -6,6 +6,8 @@
  */
 
 #include "GlobNode.h"
+#include <folly/ScopeGuard.h>
+#include <folly/futures/Future.h>
 #include <iomanip>
 #include <iostream>
 #include "eden/fs/inodes/TreeInode.h"
@@ -143,14 +145,76 @@ struct TreeRoot {
     return !entryIsTree(entry);
   }
 };
+
+using TreeBatch = vector<folly::Try<std::shared_ptr<const Tree>>>;
+
+/**
+ * Append the matches found in a directory to the lists shared by the whole
+ * glob, or hand them to the sink. Directories may be evaluated concurrently,
+ * so the matches are gathered locally and the locks only taken once per
+ * directory.
+ */
+void appendMatches(
+    GlobNode::ResultList& globResult,
+    GlobNode::ResultSink* sink,
+    vector<GlobNode::GlobResult>& matches,
+    GlobNode::PrefetchList* fileBlobsToPrefetch,
+    const vector<ObjectId>& blobsToPrefetch) {
+  if (sink && !matches.empty()) {
+    sink->addResults(std::move(matches));
+  } else if (!matches.empty()) {
+    auto results = globResult.wlock();
+    results->insert(
+        results->end(),
+        std::make_move_iterator(matches.begin()),
+        std::make_move_iterator(matches.end()));
+  }
+  if (fileBlobsToPrefetch && !blobsToPrefetch.empty()) {
+    auto blobs = fileBlobsToPrefetch->wlock();
+    blobs->insert(blobs->end(), blobsToPrefetch.begin(), blobsToPrefetch.end());
+  }
+}
 } // namespace
 
+ImmediateFuture<folly::Unit> GlobNode::FanOut::run(
+    folly::Function<ImmediateFuture<folly::Unit>()> evaluate) {
+  auto inFlight = inFlight_.fetch_add(1, std::memory_order_relaxed);
+  if (inFlight >= parallelism_) {
+    inFlight_.fetch_sub(1, std::memory_order_relaxed);
+    return makeImmediateFutureWith(std::move(evaluate));
+  }
+
+  return folly::via(
+             executor_,
+             [this, evaluate = std::move(evaluate)]() mutable {
+               // Only the synchronous part occupies a thread: the rest of
+               // the evaluation runs as the trees it needs are fetched.
+               SCOPE_EXIT {
+                 inFlight_.fetch_sub(1, std::memory_order_relaxed);
+               };
+               return evaluate().semi();
+             })
+      .semi();
+}
+
+ImmediateFuture<folly::Unit> GlobNode::evaluateChild(
+    FanOut* fanOut,
+    folly::Function<ImmediateFuture<folly::Unit>()> evaluate) {
+  if (fanOut) {
+    return fanOut->run(std::move(evaluate));
+  }
+  return makeImmediateFutureWith(std::move(evaluate));
+}
+
 GlobNode::GlobNode(
     StringPiece pattern,
     bool includeDotfiles,
     bool hasSpecials,
     CaseSensitivity caseSensitive)
     : pattern_(pattern.str()),
+      caseSensitive_(caseSensitive),
+      childIndex_(caseSensitive),
+      recursiveIndex_(caseSensitive),
       includeDotfiles_(includeDotfiles),
       hasSpecials_(hasSpecials) {
   if (includeDotfiles && (pattern == "**" || pattern == "*")) {
@@ -214,6 +278,12 @@ void GlobNode::parse(StringPiece pattern) {
       container->emplace_back(std::make_unique<GlobNode>(
           token, includeDotfiles_, hasSpecials, caseSensitive_));
       node = container->back().get();
+      if (container == &parent->recursiveChildren_) {
+        parent->recursiveIndex_.add(token);
+      } else if (hasSpecials) {
+        parent->childIndex_.add(token);
+        parent->specialChildren_.push_back(node);
+      }
     }
 
     // If there are no more tokens remaining then we have a leaf node
@@ -238,8 +308,16 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
     ROOT&& root,
     GlobNode::PrefetchList* fileBlobsToPrefetch,
     GlobNode::ResultList& globResult,
-    const RootId& originRootId) const {
+    const RootId& originRootId,
+    FanOut* fanOut,
+    ResultSink* sink) const {
   vector<std::pair<PathComponentPiece, GlobNode*>> recurse;
+  // The children only known to the object store, whose trees are fetched as
+  // one batch once all the entries have been matched.
+  vector<std::pair<RelativePath, GlobNode*>> subtrees;
+  vector<ObjectId> subtreeIds;
+  vector<GlobResult> matches;
+  vector<ObjectId> blobsToPrefetch;
   vector<ImmediateFuture<folly::Unit>> futures;
 
   if (!recursiveChildren_.empty()) {
@@ -251,7 +329,9 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
         root,
         fileBlobsToPrefetch,
         globResult,
-        originRootId));
+        originRootId,
+        fanOut,
+        sink));
   }
 
   auto recurseIfNecessary =
@@ -261,25 +341,8 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
           if (root.entryShouldLoadChildTree(entry)) {
             recurse.emplace_back(name, node);
           } else {
-            futures.emplace_back(
-                store->getTree(entry->getHash(), context)
-                    .thenValue([candidateName = rootPath + name,
-                                store,
-                                context = context.copy(),
-                                innerNode = node,
-                                fileBlobsToPrefetch,
-                                &globResult,
-                                &originRootId](
-                                   std::shared_ptr<const Tree> dir) mutable {
-                      return innerNode->evaluateImpl(
-                          store,
-                          context,
-                          candidateName,
-                          TreeRoot(std::move(dir)),
-                          fileBlobsToPrefetch,
-                          globResult,
-                          originRootId);
-                    }));
+            subtrees.emplace_back(rootPath + name, node);
+            subtreeIds.push_back(entry->getHash());
           }
         }
       };
@@ -298,62 +361,137 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateImpl(
           name = entry->first;
 
           if (node->isLeaf_) {
-            globResult.wlock()->emplace_back(
+            matches.emplace_back(
                 rootPath + name, entry->second.getDtype(), originRootId);
 
             if (fileBlobsToPrefetch &&
                 root.entryShouldPrefetch(&entry->second)) {
-              fileBlobsToPrefetch->wlock()->emplace_back(
-                  entry->second.getHash());
+              blobsToPrefetch.push_back(entry->second.getHash());
             }
           }
 
           // Not the leaf of a pattern; if this is a dir, we need to recurse
           recurseIfNecessary(name, node.get(), &entry->second);
         }
-      } else {
-        // We need to match it out of the entries in this inode
-        for (auto& entry : root.iterate(contents)) {
-          PathComponentPiece name = entry.first;
+      }
+    }
+
+    // The remaining children need to be matched out of the entries in this
+    // inode. Each entry is only matched against the patterns that the index
+    // can't rule out.
+    if (!specialChildren_.empty()) {
+      vector<size_t> candidates;
+      for (auto& entry : root.iterate(contents)) {
+        PathComponentPiece name = entry.first;
+        childIndex_.getCandidates(name.view(), candidates);
+        for (auto id : candidates) {
+          auto* node = specialChildren_[id];
           if (node->alwaysMatch_ || node->matcher_.match(name.view())) {
             if (node->isLeaf_) {
-              globResult.wlock()->emplace_back(
+              matches.emplace_back(
                   rootPath + name, entry.second.getDtype(), originRootId);
               if (fileBlobsToPrefetch &&
                   root.entryShouldPrefetch(&entry.second)) {
-                fileBlobsToPrefetch->wlock()->emplace_back(
-                    entry.second.getHash());
+                blobsToPrefetch.push_back(entry.second.getHash());
               }
             }
             // Not the leaf of a pattern; if this is a dir, we need to
             // recurse
-            recurseIfNecessary(name, node.get(), &entry.second);
+            recurseIfNecessary(name, node, &entry.second);
           }
         }
       }
     }
   }
 
+  appendMatches(
+      globResult, sink, matches, fileBlobsToPrefetch, blobsToPrefetch);
+
   // Recursively load child inodes and evaluate matches
 
   for (auto& item : recurse) {
-    futures.emplace_back(root.getOrLoadChildTree(item.first, context)
-                             .thenValue([store,
-                                         context = context.copy(),
-                                         candidateName = rootPath + item.first,
-                                         node = item.second,
-                                         fileBlobsToPrefetch,
-                                         &globResult,
-                                         &originRootId](TreeInodePtr dir) {
-                               return node->evaluateImpl(
-                                   store,
-                                   context,
-                                   candidateName,
-                                   TreeInodePtrRoot(std::move(dir)),
-                                   fileBlobsToPrefetch,
-                                   globResult,
-                                   originRootId);
-                             }));
+    futures.emplace_back(
+        root.getOrLoadChildTree(item.first, context)
+            .thenValue([store,
+                        context = context.copy(),
+                        candidateName = rootPath + item.first,
+                        node = item.second,
+                        fileBlobsToPrefetch,
+                        &globResult,
+                        &originRootId,
+                        fanOut,
+                        sink](TreeInodePtr dir) mutable {
+              return evaluateChild(
+                  fanOut,
+                  [store,
+                   context = std::move(context),
+                   candidateName = std::move(candidateName),
+                   node,
+                   dir = std::move(dir),
+                   fileBlobsToPrefetch,
+                   &globResult,
+                   &originRootId,
+                   fanOut,
+                   sink]() mutable {
+                    return node->evaluateImpl(
+                        store,
+                        context,
+                        candidateName,
+                        TreeInodePtrRoot(std::move(dir)),
+                        fileBlobsToPrefetch,
+                        globResult,
+                        originRootId,
+                        fanOut,
+                        sink);
+                  });
+            }));
+  }
+
+  if (!subtreeIds.empty()) {
+    futures.emplace_back(
+        store->getTreeBatch(subtreeIds, context)
+            .thenValue([subtrees = std::move(subtrees),
+                        store,
+                        context = context.copy(),
+                        fileBlobsToPrefetch,
+                        &globResult,
+                        &originRootId,
+                        fanOut,
+                        sink](TreeBatch&& trees) mutable {
+              vector<ImmediateFuture<folly::Unit>> childFutures;
+              childFutures.reserve(trees.size());
+              for (size_t i = 0; i < trees.size(); ++i) {
+                if (trees[i].hasException()) {
+                  childFutures.emplace_back(
+                      makeImmediateFuture<folly::Unit>(trees[i].exception()));
+                  continue;
+                }
+                childFutures.emplace_back(evaluateChild(
+                    fanOut,
+                    [store,
+                     context = context.copy(),
+                     candidateName = std::move(subtrees[i].first),
+                     node = subtrees[i].second,
+                     tree = std::move(trees[i]).value(),
+                     fileBlobsToPrefetch,
+                     &globResult,
+                     &originRootId,
+                     fanOut,
+                     sink]() mutable {
+                      return node->evaluateImpl(
+                          store,
+                          context,
+                          candidateName,
+                          TreeRoot(std::move(tree)),
+                          fileBlobsToPrefetch,
+                          globResult,
+                          originRootId,
+                          fanOut,
+                          sink);
+                    }));
+              }
+              return collectAllSafe(std::move(childFutures)).unit();
+            }));
   }
 
   // Note: we use collectAll() rather than collect() here to make sure that
@@ -376,7 +514,9 @@ ImmediateFuture<folly::Unit> GlobNode::evaluate(
     TreeInodePtr root,
     GlobNode::PrefetchList* fileBlobsToPrefetch,
     GlobNode::ResultList& globResult,
-    const RootId& originRootId) const {
+    const RootId& originRootId,
+    FanOut* fanOut,
+    ResultSink* sink) const {
   return evaluateImpl(
       store,
       context,
@@ -384,7 +524,9 @@ ImmediateFuture<folly::Unit> GlobNode::evaluate(
       TreeInodePtrRoot(std::move(root)),
       fileBlobsToPrefetch,
       globResult,
-      originRootId);
+      originRootId,
+      fanOut,
+      sink);
 }
 
 ImmediateFuture<folly::Unit> GlobNode::evaluate(
@@ -394,7 +536,9 @@ ImmediateFuture<folly::Unit> GlobNode::evaluate(
     std::shared_ptr<const Tree> tree,
     GlobNode::PrefetchList* fileBlobsToPrefetch,
     GlobNode::ResultList& globResult,
-    const RootId& originRootId) const {
+    const RootId& originRootId,
+    FanOut* fanOut,
+    ResultSink* sink) const {
   return evaluateImpl(
       store,
       context,
@@ -402,7 +546,9 @@ ImmediateFuture<folly::Unit> GlobNode::evaluate(
       TreeRoot(std::move(tree)),
       fileBlobsToPrefetch,
       globResult,
-      originRootId);
+      originRootId,
+      fanOut,
+      sink);
 }
 
 StringPiece GlobNode::tokenize(StringPiece& pattern, bool* hasSpecials) {
@@ -452,20 +598,31 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
     ROOT&& root,
     GlobNode::PrefetchList* fileBlobsToPrefetch,
     GlobNode::ResultList& globResult,
-    const RootId& originRootId) const {
+    const RootId& originRootId,
+    FanOut* fanOut,
+    ResultSink* sink) const {
   vector<RelativePath> subDirNames;
+  // The child directories only known to the object store, whose trees are
+  // fetched as one batch once all the entries have been matched.
+  vector<RelativePath> subtreeNames;
+  vector<ObjectId> subtreeIds;
+  vector<GlobResult> matches;
+  vector<ObjectId> blobsToPrefetch;
   vector<ImmediateFuture<folly::Unit>> futures;
+  vector<size_t> candidates;
   {
     const auto& contents = root.lockContents();
     for (auto& entry : root.iterate(contents)) {
       auto candidateName = startOfRecursive + entry.first;
 
-      for (auto& node : recursiveChildren_) {
+      recursiveIndex_.getCandidates(candidateName.view(), candidates);
+      for (auto id : candidates) {
+        const auto& node = recursiveChildren_[id];
         if (node->alwaysMatch_ || node->matcher_.match(candidateName.view())) {
-          globResult.wlock()->emplace_back(
+          matches.emplace_back(
               rootPath + candidateName, entry.second.getDtype(), originRootId);
           if (fileBlobsToPrefetch && root.entryShouldPrefetch(&entry.second)) {
-            fileBlobsToPrefetch->wlock()->emplace_back(entry.second.getHash());
+            blobsToPrefetch.push_back(entry.second.getHash());
           }
           // No sense running multiple matches for this same file.
           break;
@@ -478,31 +635,16 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
         if (root.entryShouldLoadChildTree(&entry.second)) {
           subDirNames.emplace_back(std::move(candidateName));
         } else {
-          futures.emplace_back(
-              store->getTree(entry.second.getHash(), context)
-                  .thenValue([candidateName = std::move(candidateName),
-                              rootPath = rootPath.copy(),
-                              store,
-                              context = context.copy(),
-                              this,
-                              fileBlobsToPrefetch,
-                              &globResult,
-                              &originRootId](std::shared_ptr<const Tree> tree) {
-                    return evaluateRecursiveComponentImpl(
-                        store,
-                        context,
-                        rootPath,
-                        candidateName,
-                        TreeRoot(std::move(tree)),
-                        fileBlobsToPrefetch,
-                        globResult,
-                        originRootId);
-                  }));
+          subtreeNames.emplace_back(std::move(candidateName));
+          subtreeIds.push_back(entry.second.getHash());
         }
       }
     }
   }
 
+  appendMatches(
+      globResult, sink, matches, fileBlobsToPrefetch, blobsToPrefetch);
+
   // Recursively load child inodes and evaluate matches
   for (auto& candidateName : subDirNames) {
     auto childTreeFuture =
@@ -516,16 +658,85 @@ ImmediateFuture<folly::Unit> GlobNode::evaluateRecursiveComponentImpl(
                         this,
                         fileBlobsToPrefetch,
                         &globResult,
-                        &originRootId](TreeInodePtr dir) {
-              return evaluateRecursiveComponentImpl(
-                  store,
-                  context,
-                  rootPath,
-                  candidateName,
-                  TreeInodePtrRoot(std::move(dir)),
-                  fileBlobsToPrefetch,
-                  globResult,
-                  originRootId);
+                        &originRootId,
+                        fanOut,
+                        sink](TreeInodePtr dir) mutable {
+              return evaluateChild(
+                  fanOut,
+                  [candidateName = std::move(candidateName),
+                   rootPath = std::move(rootPath),
+                   store,
+                   context = std::move(context),
+                   this,
+                   dir = std::move(dir),
+                   fileBlobsToPrefetch,
+                   &globResult,
+                   &originRootId,
+                   fanOut,
+                   sink]() mutable {
+                    return evaluateRecursiveComponentImpl(
+                        store,
+                        context,
+                        rootPath,
+                        candidateName,
+                        TreeInodePtrRoot(std::move(dir)),
+                        fileBlobsToPrefetch,
+                        globResult,
+                        originRootId,
+                        fanOut,
+                        sink);
+                  });
+            }));
+  }
+
+  if (!subtreeIds.empty()) {
+    futures.emplace_back(
+        store->getTreeBatch(subtreeIds, context)
+            .thenValue([subtreeNames = std::move(subtreeNames),
+                        rootPath = rootPath.copy(),
+                        store,
+                        context = context.copy(),
+                        this,
+                        fileBlobsToPrefetch,
+                        &globResult,
+                        &originRootId,
+                        fanOut,
+                        sink](TreeBatch&& trees) mutable {
+              vector<ImmediateFuture<folly::Unit>> childFutures;
+              childFutures.reserve(trees.size());
+              for (size_t i = 0; i < trees.size(); ++i) {
+                if (trees[i].hasException()) {
+                  childFutures.emplace_back(
+                      makeImmediateFuture<folly::Unit>(trees[i].exception()));
+                  continue;
+                }
+                childFutures.emplace_back(evaluateChild(
+                    fanOut,
+                    [candidateName = std::move(subtreeNames[i]),
+                     rootPath = rootPath.copy(),
+                     store,
+                     context = context.copy(),
+                     this,
+                     tree = std::move(trees[i]).value(),
+                     fileBlobsToPrefetch,
+                     &globResult,
+                     &originRootId,
+                     fanOut,
+                     sink]() mutable {
+                      return evaluateRecursiveComponentImpl(
+                          store,
+                          context,
+                          rootPath,
+                          candidateName,
+                          TreeRoot(std::move(tree)),
+                          fileBlobsToPrefetch,
+                          globResult,
+                          originRootId,
+                          fanOut,
+                          sink);
+                    }));
+              }
+              return collectAllSafe(std::move(childFutures)).unit();
             }));
   }
 
@@ -6,10 +6,14 @@
  */
 
 #pragma once
+#include <folly/Executor.h>
+#include <folly/Function.h>
+#include <atomic>
 #include <ostream>
 #include "eden/fs/inodes/InodePtrFwd.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/model/git/GlobMatcher.h"
+#include "eden/fs/model/git/GlobPatternIndex.h"
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/utils/CaseSensitivity.h"
 #include "eden/fs/utils/DirType.h"
@@ -35,7 +39,10 @@ class GlobNode {
   // Two-parameter constructor is intended to create the root of a set of
   // globs that will be parsed into the overall glob tree.
   explicit GlobNode(bool includeDotfiles, CaseSensitivity caseSensitive)
-      : caseSensitive_(caseSensitive), includeDotfiles_(includeDotfiles) {}
+      : caseSensitive_(caseSensitive),
+        childIndex_(caseSensitive),
+        recursiveIndex_(caseSensitive),
+        includeDotfiles_(includeDotfiles) {}
 
   using PrefetchList = folly::Synchronized<std::vector<ObjectId>>;
 
@@ -86,6 +93,44 @@ class GlobNode {
 
   using ResultList = folly::Synchronized<std::vector<GlobResult>>;
 
+  /**
+   * Spreads the directories visited by evaluate() over an executor.
+   *
+   * A directory is evaluated on the executor while fewer than `parallelism`
+   * of them are queued or running their synchronous part there, so that the
+   * idle threads share the directories of a large glob. Otherwise it is
+   * evaluated on the thread that reached it, which keeps the queue bounded.
+   *
+   * The results of concurrent evaluations are appended in no particular
+   * order, so callers that need a deterministic order must sort them.
+   */
+  class FanOut {
+   public:
+    FanOut(folly::Executor* executor, size_t parallelism)
+        : executor_{executor}, parallelism_{parallelism} {}
+
+    ImmediateFuture<folly::Unit> run(
+        folly::Function<ImmediateFuture<folly::Unit>()> evaluate);
+
+   private:
+    folly::Executor* const executor_;
+    const size_t parallelism_;
+    std::atomic<size_t> inFlight_{0};
+  };
+
+  /**
+   * Receives the matches of each directory as soon as it has been evaluated,
+   * for evaluate() to stream them rather than append them to its result
+   * list. Called from whichever thread evaluated the directory, so
+   * concurrently when evaluate() is given a FanOut.
+   */
+  class ResultSink {
+   public:
+    virtual ~ResultSink() = default;
+
+    virtual void addResults(std::vector<GlobResult>&& results) = 0;
+  };
+
   // Compile and add a new glob pattern to the tree.
   // Compilation splits the pattern into nodes, with one node for each
   // directory separator separated path component.
@@ -100,6 +145,12 @@ class GlobNode {
    *
    * When fileBlobsToPrefetch is non-null, the Hash of the globbed files will
    * be appended to it.
+   *
+   * When fanOut is non-null, the subdirectories are evaluated concurrently on
+   * its executor, and it must outlive the returned ImmediateFuture.
+   *
+   * When sink is non-null, the matches are handed to it instead of being
+   * appended to globResult, and it must outlive the returned ImmediateFuture.
    */
   ImmediateFuture<folly::Unit> evaluate(
       const ObjectStore* store,
@@ -108,7 +159,9 @@ class GlobNode {
       TreeInodePtr root,
       PrefetchList* fileBlobsToPrefetch,
       ResultList& globResult,
-      const RootId& originRootId) const;
+      const RootId& originRootId,
+      FanOut* fanOut = nullptr,
+      ResultSink* sink = nullptr) const;
 
   /**
    * Evaluate the compiled glob against the provided Tree.
@@ -122,7 +175,9 @@ class GlobNode {
       std::shared_ptr<const Tree> tree,
       PrefetchList* fileBlobsToPrefetch,
       ResultList& globResult,
-      const RootId& originRootId) const;
+      const RootId& originRootId,
+      FanOut* fanOut = nullptr,
+      ResultSink* sink = nullptr) const;
 
   /**
    * Print a human-readable description of this GlobNode to stderr.
@@ -164,7 +219,9 @@ class GlobNode {
       ROOT&& root,
       PrefetchList* fileBlobsToPrefetch,
       ResultList& globResult,
-      const RootId& originRootId) const;
+      const RootId& originRootId,
+      FanOut* fanOut,
+      ResultSink* sink) const;
 
   template <typename ROOT>
   ImmediateFuture<folly::Unit> evaluateImpl(
@@ -174,7 +231,14 @@ class GlobNode {
       ROOT&& root,
       PrefetchList* fileBlobsToPrefetch,
       ResultList& globResult,
-      const RootId& originRootId) const;
+      const RootId& originRootId,
+      FanOut* fanOut,
+      ResultSink* sink) const;
+
+  // Evaluates a subdirectory, through fanOut when there is one.
+  static ImmediateFuture<folly::Unit> evaluateChild(
+      FanOut* fanOut,
+      folly::Function<ImmediateFuture<folly::Unit>()> evaluate);
 
   void debugDump(int currentDepth) const;
 
@@ -190,6 +254,16 @@ class GlobNode {
   // The case sensitivity of this glob node.
   CaseSensitivity caseSensitive_;
 
+  // The children_ with special characters, which have to be matched against
+  // every entry of a directory, and the index that narrows down which of
+  // them may match an entry. The ids of childIndex_ are positions in
+  // specialChildren_.
+  std::vector<GlobNode*> specialChildren_;
+  GlobPatternIndex childIndex_;
+  // Likewise for recursiveChildren_, whose positions are the ids of
+  // recursiveIndex_.
+  GlobPatternIndex recursiveIndex_;
+
   // For a child GlobNode that is added to this GlobNode (presumably via
   // parse()), the GlobMatcher pattern associated with the child node should use
   // this value for its includeDotfiles parameter.
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/GlobResultCache.h"
+
+#include <algorithm>
+#include <string_view>
+
+namespace facebook::eden {
+
+GlobResultCache::GlobResultCache(size_t maxEntries)
+    : cache_{folly::in_place, std::max<size_t>(maxEntries, 1)} {}
+
+std::string GlobResultCache::makeKey(
+    const ObjectId& treeId,
+    const std::vector<std::string>& globs,
+    bool includeDotfiles,
+    bool prefetchFiles,
+    CaseSensitivity caseSensitive) {
+  std::vector<std::string_view> sortedGlobs{globs.begin(), globs.end()};
+  std::sort(sortedGlobs.begin(), sortedGlobs.end());
+
+  auto treeBytes = treeId.getBytes();
+  std::string key;
+  key.push_back(static_cast<char>(treeBytes.size()));
+  key.append(reinterpret_cast<const char*>(treeBytes.data()), treeBytes.size());
+  key.push_back(includeDotfiles ? '1' : '0');
+  key.push_back(prefetchFiles ? '1' : '0');
+  key.push_back(caseSensitive == CaseSensitivity::Sensitive ? '1' : '0');
+  // Patterns can't contain NUL characters, which separates them.
+  for (auto glob : sortedGlobs) {
+    key.append(glob);
+    key.push_back('\0');
+  }
+  return key;
+}
+
+std::shared_ptr<const GlobResultCache::Results> GlobResultCache::get(
+    const std::string& key) {
+  auto cache = cache_.lock();
+  auto it = cache->find(key);
+  if (it == cache->end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+void GlobResultCache::insert(
+    std::string key,
+    std::shared_ptr<const Results> results,
+    size_t maxEntries) {
+  auto cache = cache_.lock();
+  if (cache->getMaxSize() != maxEntries) {
+    cache->setMaxSize(maxEntries);
+  }
+  cache->set(std::move(key), std::move(results));
+}
+
+size_t GlobResultCache::size() const {
+  return cache_.lock()->size();
+}
+
+} // namespace facebook::eden
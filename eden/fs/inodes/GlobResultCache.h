@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/utils/CaseSensitivity.h"
+#include "eden/fs/utils/DirType.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * The results of globs evaluated against source control trees.
+ *
+ * A glob over a tree without local changes only depends on the id of the
+ * tree, the patterns and the flags changing what is matched, so the build
+ * tools repeating the same globs against a commit are answered without
+ * walking it again. Entries are keyed by all of these, see makeKey().
+ *
+ * Safe to use from any thread.
+ */
+class GlobResultCache {
+ public:
+  struct Match {
+    RelativePath name;
+    dtype_t dtype;
+  };
+
+  struct Results {
+    // Relative to the tree the glob was evaluated against.
+    std::vector<Match> matches;
+    // The blobs of the matched files, when the glob prefetches them.
+    std::vector<ObjectId> blobsToPrefetch;
+  };
+
+  explicit GlobResultCache(size_t maxEntries);
+
+  /**
+   * The key of a glob evaluated against the tree treeId. The order of the
+   * globs doesn't matter.
+   */
+  static std::string makeKey(
+      const ObjectId& treeId,
+      const std::vector<std::string>& globs,
+      bool includeDotfiles,
+      bool prefetchFiles,
+      CaseSensitivity caseSensitive);
+
+  /**
+   * Returns the cached results for key, or nullptr.
+   */
+  std::shared_ptr<const Results> get(const std::string& key);
+
+  /**
+   * Caches the results for key, evicting the least recently used entries
+   * beyond maxEntries.
+   */
+  void insert(
+      std::string key,
+      std::shared_ptr<const Results> results,
+      size_t maxEntries);
+
+  size_t size() const;
+
+ private:
+  folly::Synchronized<
+      folly::EvictingCacheMap<std::string, std::shared_ptr<const Results>>,
+      std::mutex>
+      cache_;
+};
+
+} // namespace facebook::eden
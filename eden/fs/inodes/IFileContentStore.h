@@ -8,6 +8,8 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <optional>
+#include <string_view>
 
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -96,6 +98,16 @@ class IFileContentStore {
   virtual folly::File createOverlayFile(
       InodeNumber inodeNumber,
       const folly::IOBuf& contents) = 0;
+
+  /**
+   * Same as createOverlayFile(), but clones the file from a copy of contents
+   * kept under blobKey, if the filesystem supports it. Returns std::nullopt,
+   * without creating the file, otherwise.
+   */
+  virtual std::optional<folly::File> cloneOverlayFile(
+      InodeNumber inodeNumber,
+      std::string_view blobKey,
+      const folly::IOBuf& contents) = 0;
 #endif
 };
 
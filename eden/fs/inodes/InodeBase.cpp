@@ -197,8 +197,22 @@ std::unique_ptr<InodeBase> InodeBase::markUnlinked(
     TreeInode* parent,
     PathComponentPiece name,
     const RenameLock& renameLock) {
-  XLOG(DBG5) << "inode " << this << " unlinked: " << getLogPath();
   XDCHECK(renameLock.isHeld(mount_));
+  return markUnlinkedImpl(parent, name);
+}
+
+std::unique_ptr<InodeBase> InodeBase::markUnlinked(
+    TreeInode* parent,
+    PathComponentPiece name,
+    const SharedRenameLock& renameLock) {
+  XDCHECK(renameLock.isHeld(mount_));
+  return markUnlinkedImpl(parent, name);
+}
+
+std::unique_ptr<InodeBase> InodeBase::markUnlinkedImpl(
+    TreeInode* parent,
+    PathComponentPiece name) {
+  XLOG(DBG5) << "inode " << this << " unlinked: " << getLogPath();
 
   {
     auto loc = location_.wlock();
@@ -210,7 +224,7 @@ std::unique_ptr<InodeBase> InodeBase::markUnlinked(
   // Grab the inode map lock, and check if we should unload
   // ourself immediately.
   auto* inodeMap = getMount()->getInodeMap();
-  auto inodeMapLock = inodeMap->lockForUnload();
+  auto inodeMapLock = inodeMap->lockForUnload(getNodeId());
   if (isPtrAcquireCountZero() && getFsRefcount() == 0) {
     inodeMap->unloadInode(this, parent, name, true, inodeMapLock);
     // We have to delete ourself now.
@@ -238,9 +252,23 @@ void InodeBase::updateLocation(
     TreeInodePtr newParent,
     PathComponentPiece newName,
     const RenameLock& renameLock) {
+  XDCHECK(renameLock.isHeld(mount_));
+  updateLocationImpl(std::move(newParent), newName);
+}
+
+void InodeBase::updateLocation(
+    TreeInodePtr newParent,
+    PathComponentPiece newName,
+    const SharedRenameLock& renameLock) {
+  XDCHECK(renameLock.isHeld(mount_));
+  updateLocationImpl(std::move(newParent), newName);
+}
+
+void InodeBase::updateLocationImpl(
+    TreeInodePtr newParent,
+    PathComponentPiece newName) {
   XLOG(DBG5) << "inode " << this << " renamed: " << getLogPath() << " --> "
              << newParent->getLogPath() << " / \"" << newName << "\"";
-  XDCHECK(renameLock.isHeld(mount_));
   XDCHECK_EQ(mount_, newParent->mount_);
 
   auto loc = location_.wlock();
@@ -235,11 +235,18 @@ class InodeBase {
    * context after they release their contents lock.  If unlinking this inode
    * does not cause it to be immediately unloaded then this method will return
    * a null pointer.
+   *
+   * The rename lock may be held in shared mode only by renames, which hold the
+   * contents_ lock of every directory whose entries they change.
    */
   std::unique_ptr<InodeBase> markUnlinked(
       TreeInode* parent,
       PathComponentPiece name,
       const RenameLock& renameLock);
+  std::unique_ptr<InodeBase> markUnlinked(
+      TreeInode* parent,
+      PathComponentPiece name,
+      const SharedRenameLock& renameLock);
 
   /**
    * This method should only be called by TreeInode::loadUnlinkedChildInode().
@@ -252,12 +259,18 @@ class InodeBase {
   /**
    * updateLocation() should only be invoked by TreeInode.
    *
-   * This is called when an inode is renamed to a new location.
+   * This is called when an inode is renamed to a new location.  Directories
+   * may only be moved to a new parent while holding the rename lock in
+   * exclusive mode.
    */
   void updateLocation(
       TreeInodePtr newParent,
       PathComponentPiece newName,
       const RenameLock& renameLock);
+  void updateLocation(
+      TreeInodePtr newParent,
+      PathComponentPiece newName,
+      const SharedRenameLock& renameLock);
 
   /**
    * Check to see if the ptrAcquire reference count is zero.
@@ -324,6 +337,16 @@ class InodeBase {
     return numFsReferences_.load(std::memory_order_acquire);
   }
 
+  /**
+   * Whether the channel holds references to this inode's number.
+   *
+   * Like getFsRefcount() outside of unload, this is racy: only use it where
+   * acting on a stale answer is harmless or tolerated.
+   */
+  bool hasFsReferencesRacy() const {
+    return numFsReferences_.load(std::memory_order_acquire) != 0;
+  }
+
   /**
    * Set the channel reference count.
    *
@@ -346,7 +369,9 @@ class InodeBase {
    * this file is unlinked.
    *
    * This must be called while holding the rename lock, to ensure the parent
-   * does not change before the return value can be used.
+   * does not change before the return value can be used.  When the rename
+   * lock is only held in shared mode, this is only guaranteed for
+   * directories.
    */
   TreeInodePtr getParent(const RenameLock&) const {
     return location_.rlock()->parent;
@@ -470,6 +495,11 @@ class InodeBase {
   void updateAtime();
   void updateMtimeAndCtime(EdenTimestamp now);
 
+  std::unique_ptr<InodeBase> markUnlinkedImpl(
+      TreeInode* parent,
+      PathComponentPiece name);
+  void updateLocationImpl(TreeInodePtr newParent, PathComponentPiece newName);
+
   template <typename InodeType>
   friend class InodePtrImpl;
   friend class InodePtrTestHelper;
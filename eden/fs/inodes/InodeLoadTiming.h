@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+namespace facebook::eden {
+
+/**
+ * How long each phase of an inode load took, in microseconds. Phases that a
+ * load did not go through are left at zero.
+ *
+ * The phases are stored as 32-bit counts to keep InodeTraceEvent small, and
+ * saturate after about 71 minutes.
+ */
+struct InodeLoadPhases {
+  /**
+   * From the load being requested from the InodeMap until the parent
+   * TreeInode started it. This includes waiting for the parent itself to
+   * load when the inode was looked up by number.
+   */
+  uint32_t inodeMapWait{0};
+
+  /**
+   * Fetching the source control tree of an unmaterialized directory.
+   */
+  uint32_t treeFetch{0};
+
+  /**
+   * Reading the directory contents from the overlay.
+   */
+  uint32_t overlayRead{0};
+
+  /**
+   * Constructing the inode, which populates its entry in the inode metadata
+   * table.
+   */
+  uint32_t metadataLookup{0};
+
+  template <typename Rep, typename Period>
+  static uint32_t toMicros(std::chrono::duration<Rep, Period> elapsed) {
+    auto micros =
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+    if (micros <= 0) {
+      return 0;
+    }
+    constexpr auto kMax = std::numeric_limits<uint32_t>::max();
+    return static_cast<uint64_t>(micros) > kMax ? kMax
+                                                : static_cast<uint32_t>(micros);
+  }
+
+  static uint32_t elapsedSince(std::chrono::steady_clock::time_point start) {
+    return toMicros(std::chrono::steady_clock::now() - start);
+  }
+};
+
+/**
+ * The phases of loading one inode, as measured by the TreeInode loading it
+ * and handed to InodeMap::inodeLoadComplete().
+ */
+struct InodeLoadTiming {
+  /**
+   * When the parent TreeInode started loading the inode. The InodeMap derives
+   * the inodeMapWait phase from it. Left unset when unknown.
+   */
+  std::chrono::system_clock::time_point start;
+
+  InodeLoadPhases phases;
+
+  static InodeLoadTiming startNow() {
+    InodeLoadTiming timing;
+    timing.start = std::chrono::system_clock::now();
+    return timing;
+  }
+};
+
+} // namespace facebook::eden
@@ -20,6 +20,7 @@
 #include "eden/fs/inodes/Overlay.h"
 #include "eden/fs/inodes/ParentInodeInfo.h"
 #include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/NotImplemented.h"
 #include "eden/fs/utils/SystemError.h"
@@ -136,33 +137,35 @@ inline void InodeMap::insertLoadedInode(
   }
 }
 
-void InodeMap::initializeRoot(
-    const folly::Synchronized<Members>::LockedPtr& data,
-    TreeInodePtr root) {
-  XCHECK_EQ(data->loadedInodes_.size(), 0ul)
-      << "cannot load InodeMap data over a populated instance";
-  XCHECK_EQ(data->unloadedInodes_.size(), 0ul)
-      << "cannot load InodeMap data over a populated instance";
+void InodeMap::initializeRoot(const InodeMapLock& lock, TreeInodePtr root) {
+  for (const auto& data : lock.shards_) {
+    XCHECK_EQ(data->loadedInodes_.size(), 0ul)
+        << "cannot load InodeMap data over a populated instance";
+    XCHECK_EQ(data->unloadedInodes_.size(), 0ul)
+        << "cannot load InodeMap data over a populated instance";
+  }
 
   XCHECK(!root_);
   root_ = std::move(root);
+  const auto& data = lock.get(root_->getNodeId());
   insertLoadedInode(data, root_.get());
   XDCHECK_EQ(1ul, data->numTreeInodes_);
   XDCHECK_EQ(0ul, data->numFileInodes_);
 }
 
 void InodeMap::initialize(TreeInodePtr root) {
-  initializeRoot(data_.wlock(), std::move(root));
+  initializeRoot(lockAllShards(), std::move(root));
 }
 
 template <class... Args>
 void InodeMap::initializeUnloadedInode(
-    const folly::Synchronized<Members>::LockedPtr& data,
+    const InodeMapLock& lock,
     InodeNumber parentIno,
     InodeNumber ino,
     Args&&... args) {
   auto unloadedEntry = UnloadedInode(parentIno, std::forward<Args>(args)...);
-  auto result = data->unloadedInodes_.emplace(ino, std::move(unloadedEntry));
+  auto result =
+      lock.get(ino)->unloadedInodes_.emplace(ino, std::move(unloadedEntry));
   if (!result.second) {
     auto message = fmt::format(
         "failed to emplace inode number {}; is it already present in the InodeMap?",
@@ -175,8 +178,8 @@ void InodeMap::initializeUnloadedInode(
 void InodeMap::initializeFromTakeover(
     TreeInodePtr root,
     const SerializedInodeMap& takeover) {
-  auto data = data_.wlock();
-  initializeRoot(data, std::move(root));
+  auto lock = lockAllShards();
+  initializeRoot(lock, std::move(root));
 
   for (const auto& entry : *takeover.unloadedInodes_ref()) {
     if (*entry.numFsReferences_ref() < 0) {
@@ -201,7 +204,7 @@ void InodeMap::initializeFromTakeover(
       }
     }
     initializeUnloadedInode(
-        data,
+        lock,
         InodeNumber::fromThrift(*entry.parentInode_ref()),
         InodeNumber::fromThrift(*entry.inodeNumber_ref()),
         PathComponentPiece{*entry.name_ref()},
@@ -212,7 +215,7 @@ void InodeMap::initializeFromTakeover(
   }
 
   XLOG(DBG2) << "InodeMap initialized mount " << mount_->getPath()
-             << " from takeover, " << data->unloadedInodes_.size()
+             << " from takeover, " << takeover.unloadedInodes_ref()->size()
              << " inodes registered";
 }
 
@@ -221,9 +224,10 @@ void InodeMap::initializeFromOverlay(TreeInodePtr root, Overlay& overlay) {
 
   XLOG(DBG2) << "Initializing InodeMap for " << mount_->getPath();
 
-  auto data = data_.wlock();
-  initializeRoot(data, std::move(root));
+  auto lock = lockAllShards();
+  initializeRoot(lock, std::move(root));
 
+  size_t registered = 0;
   std::vector<std::tuple<AbsolutePath, InodeNumber>> pending;
   pending.emplace_back(mount_->getPath(), root_->getNodeId());
 
@@ -249,7 +253,7 @@ void InodeMap::initializeFromOverlay(TreeInodePtr root, Overlay& overlay) {
       }
 
       initializeUnloadedInode(
-          data,
+          lock,
           dirInode,
           ino,
           name,
@@ -257,19 +261,19 @@ void InodeMap::initializeFromOverlay(TreeInodePtr root, Overlay& overlay) {
           dirent.getInitialMode(),
           dirent.getOptionalHash(),
           1);
+      ++registered;
     }
   }
 
   XLOG(DBG2) << "InodeMap initialized mount " << mount_->getPath()
-             << " from overlay, " << data->unloadedInodes_.size()
-             << " inodes registered";
+             << " from overlay, " << registered << " inodes registered";
 }
 
 ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
-  // Lock the data.
+  // Lock the shard of the inode.
   // We hold it while doing most of our work below, but explicitly unlock it
   // before triggering inode loading or before fulfilling any Promises.
-  auto data = data_.wlock();
+  auto data = getShard(number).wlock();
   std::vector<InodeTraceEvent> startLoadEvents;
 
   // Check to see if this Inode is already loaded
@@ -324,22 +328,28 @@ ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
   // For parents we don't find, add a promise that will trigger the lookup on
   // its necessary child.
   //
+  // The parents are generally in other shards. Only one shard is locked at a
+  // time, so that lookups never hold several shard locks.
+  //
   // (It might have been simpler to recursively call lookupInode() to get the
   // parent, but that would require releasing and re-acquiring the lock more
   // than necessary.)
   auto childInodeNumber = number;
   while (true) {
+    // Grab copies of what we need from the child before unlocking its shard.
+    auto parentNumber = unloadedData->parent;
+    PathComponent childName = unloadedData->name;
+    bool isUnlinked = unloadedData->isUnlinked;
+    std::optional<ObjectId> optionalHash = unloadedData->hash;
+    auto mode = unloadedData->mode;
+    data.unlock();
+    data = getShard(parentNumber).wlock();
+
     // Check to see if this parent is loaded
-    loadedIter = data->loadedInodes_.find(unloadedData->parent);
+    loadedIter = data->loadedInodes_.find(parentNumber);
     if (loadedIter != data->loadedInodes_.end()) {
       // We found a loaded parent.
-      // Grab copies of the arguments we need for startChildLookup(),
-      // with the lock still held.
       InodePtr firstLoadedParent = loadedIter->second.getPtr();
-      PathComponent requiredChildName = unloadedData->name;
-      bool isUnlinked = unloadedData->isUnlinked;
-      std::optional<ObjectId> optionalHash = unloadedData->hash;
-      auto mode = unloadedData->mode;
       // Unlock data and publish load events before starting the child lookup
       data.unlock();
       for (auto& event : startLoadEvents) {
@@ -348,7 +358,7 @@ ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
       // Trigger the lookup, then return to our caller.
       startChildLookup(
           firstLoadedParent,
-          requiredChildName,
+          childName,
           isUnlinked,
           childInodeNumber,
           optionalHash,
@@ -357,13 +367,13 @@ ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
     }
 
     // Look up the parent in unloadedInodes_
-    unloadedIter = data->unloadedInodes_.find(unloadedData->parent);
+    unloadedIter = data->unloadedInodes_.find(parentNumber);
     if (UNLIKELY(unloadedIter == data->unloadedInodes_.end())) {
       // This shouldn't happen.  We must know about the parent inode number if
       // we knew about the child.
       auto bug = EDEN_BUG_EXCEPTION()
-          << "unknown parent inode " << unloadedData->parent << " (of "
-          << unloadedData->name << ")";
+          << "unknown parent inode " << parentNumber << " (of " << childName
+          << ")";
       // Unlock our data before publishing any stored load start events and
       // calling inodeLoadFailed()
       data.unlock();
@@ -379,7 +389,7 @@ ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
 
     if (!alreadyLoading) {
       startLoadEvents.push_back(
-          createInodeLoadStartEvent(unloadedData->parent, *parentData, data));
+          createInodeLoadStartEvent(parentNumber, *parentData, data));
     }
 
     // Add a new entry to the promises list.
@@ -388,11 +398,11 @@ ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
     parentData->promises.emplace_back();
     setupParentLookupPromise(
         parentData->promises.back(),
-        unloadedData->name,
-        unloadedData->isUnlinked,
+        childName,
+        isUnlinked,
         childInodeNumber,
-        unloadedData->hash,
-        unloadedData->mode);
+        optionalHash,
+        mode);
 
     if (alreadyLoading) {
       // This parent is already being loaded.
@@ -405,7 +415,7 @@ ImmediateFuture<InodePtr> InodeMap::lookupInode(InodeNumber number) {
     }
 
     // Continue around the loop to look up our parent's parent
-    childInodeNumber = unloadedData->parent;
+    childInodeNumber = parentNumber;
     unloadedData = parentData;
   }
 }
@@ -461,7 +471,9 @@ void InodeMap::startChildLookup(
   treeInode->loadChildInode(childName, childInodeNumber);
 }
 
-InodeMap::PromiseVector InodeMap::inodeLoadComplete(InodeBase* inode) {
+InodeMap::PromiseVector InodeMap::inodeLoadComplete(
+    InodeBase* inode,
+    const InodeLoadTiming& timing) {
   auto number = inode->getNodeId();
   // Since XLOG only evaluates the arguments if it is going to log, its cheaper
   // in the most common case to not save the inode log path to a local variable
@@ -472,28 +484,8 @@ InodeMap::PromiseVector InodeMap::inodeLoadComplete(InodeBase* inode) {
   try {
     std::optional<InodeTraceEvent> endLoadEvent;
     {
-      auto data = data_.wlock();
-      auto it = data->unloadedInodes_.find(number);
-      XCHECK(it != data->unloadedInodes_.end())
-          << "failed to find unloaded inode data when finishing load of inode "
-          << number << ": " << inode->getLogPath();
-      swap(promises, it->second.promises);
-
-      inode->setChannelRefcount(it->second.numFsReferences);
-
-      // Insert the entry into loadedInodes_ and remove it from unloadedInodes_
-      insertLoadedInode(data, inode);
-      // Before removing from unloadedInodes_, create an inode end event (for
-      // which we need the data_ lock to read attributes) and publish the event
-      // after releasing the data_ lock
-      endLoadEvent = std::make_optional<InodeTraceEvent>(
-          it->second.loadStartTime,
-          number,
-          it->second.getInodeType(),
-          InodeEventType::LOAD,
-          InodeEventProgress::END,
-          it->second.name);
-      data->unloadedInodes_.erase(it);
+      auto data = getShard(number).wlock();
+      endLoadEvent = inodeLoadCompleteLocked(data, inode, timing, promises);
     }
     mount_->publishInodeTraceEvent(std::move(endLoadEvent.value()));
     return promises;
@@ -511,6 +503,103 @@ InodeMap::PromiseVector InodeMap::inodeLoadComplete(InodeBase* inode) {
   }
 }
 
+InodeTraceEvent InodeMap::inodeLoadCompleteLocked(
+    const folly::Synchronized<Members>::WLockedPtr& data,
+    InodeBase* inode,
+    const InodeLoadTiming& timing,
+    PromiseVector& promises) {
+  auto number = inode->getNodeId();
+  auto it = data->unloadedInodes_.find(number);
+  XCHECK(it != data->unloadedInodes_.end())
+      << "failed to find unloaded inode data when finishing load of inode "
+      << number << ": " << inode->getLogPath();
+  swap(promises, it->second.promises);
+
+  inode->setChannelRefcount(it->second.numFsReferences);
+
+  // Insert the entry into loadedInodes_ and remove it from unloadedInodes_
+  insertLoadedInode(data, inode);
+  // Before removing from unloadedInodes_, create an inode end event (for
+  // which we need the shard lock to read attributes) and publish the event
+  // after releasing the shard lock
+  InodeTraceEvent endLoadEvent{
+      it->second.loadStartTime,
+      number,
+      it->second.getInodeType(),
+      InodeEventType::LOAD,
+      InodeEventProgress::END,
+      it->second.name};
+  endLoadEvent.loadPhases = timing.phases;
+  if (timing.start != std::chrono::system_clock::time_point{}) {
+    auto wait = timing.start - it->second.loadStartTime;
+    endLoadEvent.loadPhases.inodeMapWait = InodeLoadPhases::toMicros(wait);
+    mount_->getStats()->addDuration(
+        &InodeStats::loadInodeMapWait,
+        std::chrono::microseconds{endLoadEvent.loadPhases.inodeMapWait});
+  }
+  data->unloadedInodes_.erase(it);
+  return endLoadEvent;
+}
+
+template <typename GetNumber, typename Fn>
+void InodeMap::forEachByShard(size_t count, GetNumber&& getNumber, Fn&& fn) {
+  std::array<std::vector<size_t>, kShardCount> byShard;
+  for (size_t i = 0; i < count; ++i) {
+    byShard[getShardIndex(getNumber(i))].push_back(i);
+  }
+  for (size_t shard = 0; shard < kShardCount; ++shard) {
+    if (byShard[shard].empty()) {
+      continue;
+    }
+    auto data = shards_[shard].data.wlock();
+    for (auto i : byShard[shard]) {
+      fn(data, i);
+    }
+  }
+}
+
+std::vector<InodeMap::PromiseVector> InodeMap::inodesLoadComplete(
+    const std::vector<InodeBase*>& inodes,
+    const std::vector<InodeLoadTiming>& timings) {
+  XDCHECK_EQ(inodes.size(), timings.size());
+  std::vector<PromiseVector> promises(inodes.size());
+  std::vector<InodeTraceEvent> endLoadEvents;
+  endLoadEvents.reserve(inodes.size());
+  std::vector<std::pair<size_t, folly::exception_wrapper>> failures;
+  forEachByShard(
+      inodes.size(),
+      [&](size_t i) { return inodes[i]->getNodeId(); },
+      [&](const auto& data, size_t i) {
+        XLOG(DBG5) << "successfully loaded inode " << inodes[i]->getNodeId()
+                   << ": " << inodes[i]->getLogPath();
+        try {
+          endLoadEvents.push_back(inodeLoadCompleteLocked(
+              data, inodes[i], timings[i], promises[i]));
+        } catch (...) {
+          failures.emplace_back(
+              i, folly::exception_wrapper{std::current_exception()});
+        }
+      });
+
+  for (auto& event : endLoadEvents) {
+    mount_->publishInodeTraceEvent(std::move(event));
+  }
+  // Same as inodeLoadComplete(), once the shards are unlocked.
+  for (auto& [i, ew] : failures) {
+    auto number = inodes[i]->getNodeId();
+    XLOG(ERR) << "error marking inode " << number << " loaded: " << ew;
+    for (auto& promise : promises[i]) {
+      promise.setException(ew);
+    }
+    promises[i].clear();
+    auto optionalFailEvent = createInodeLoadFailEvent(number);
+    if (optionalFailEvent.has_value()) {
+      mount_->publishInodeTraceEvent(std::move(optionalFailEvent.value()));
+    }
+  }
+  return promises;
+}
+
 void InodeMap::inodeLoadFailed(
     InodeNumber number,
     const folly::exception_wrapper& ex) {
@@ -542,7 +631,7 @@ InodeTraceEvent InodeMap::createInodeLoadStartEvent(
 
 std::optional<InodeTraceEvent> InodeMap::createInodeLoadFailEvent(
     InodeNumber number) {
-  auto data = data_.rlock();
+  auto data = getShard(number).rlock();
   auto it = data->unloadedInodes_.find(number);
   if (it != data->unloadedInodes_.end()) {
     XLOG(ERR)
@@ -562,7 +651,7 @@ std::optional<InodeTraceEvent> InodeMap::createInodeLoadFailEvent(
 InodeMap::PromiseVector InodeMap::extractPendingPromises(InodeNumber number) {
   PromiseVector promises;
   {
-    auto data = data_.wlock();
+    auto data = getShard(number).wlock();
     auto it = data->unloadedInodes_.find(number);
     XCHECK(it != data->unloadedInodes_.end())
         << "failed to find unloaded inode data when finishing load of inode "
@@ -583,7 +672,7 @@ ImmediateFuture<FileInodePtr> InodeMap::lookupFileInode(InodeNumber number) {
 }
 
 InodePtr InodeMap::lookupLoadedInode(InodeNumber number) {
-  auto data = data_.rlock();
+  auto data = getShard(number).rlock();
   auto it = data->loadedInodes_.find(number);
   if (it == data->loadedInodes_.end()) {
     return nullptr;
@@ -608,45 +697,45 @@ FileInodePtr InodeMap::lookupLoadedFile(InodeNumber number) {
 }
 
 std::optional<RelativePath> InodeMap::getPathForInode(InodeNumber inodeNumber) {
-  auto data = data_.rlock();
-  return getPathForInodeHelper(inodeNumber, data);
-}
-
-std::optional<RelativePath> InodeMap::getPathForInodeHelper(
-    InodeNumber inodeNumber,
-    const folly::Synchronized<Members>::RLockedPtr& data) {
-  auto loadedIt = data->loadedInodes_.find(inodeNumber);
-  if (loadedIt != data->loadedInodes_.cend()) {
-    // If the inode is loaded, return its RelativePath
-    return loadedIt->second->getPath();
-  } else {
+  InodeNumber parent;
+  std::optional<PathComponent> name;
+  {
+    auto data = getShard(inodeNumber).rlock();
+    auto loadedIt = data->loadedInodes_.find(inodeNumber);
+    if (loadedIt != data->loadedInodes_.cend()) {
+      // If the inode is loaded, return its RelativePath
+      return loadedIt->second->getPath();
+    }
     auto unloadedIt = data->unloadedInodes_.find(inodeNumber);
-    if (unloadedIt != data->unloadedInodes_.cend()) {
-      if (unloadedIt->second.isUnlinked) {
-        return std::nullopt;
-      }
-      // If the inode is not loaded, return its parent's path as long as it's
-      // parent isn't the root
-      auto parent = unloadedIt->second.parent;
-      if (parent == kRootNodeId) {
-        // The parent is the Eden mount root, just return its name (base case)
-        return RelativePath(unloadedIt->second.name);
-      }
-      auto dir = getPathForInodeHelper(parent, data);
-      if (!dir) {
-        EDEN_BUG() << "unlinked parent inode " << parent
-                   << "appears to contain non-unlinked child " << inodeNumber;
-      }
-      return *dir + unloadedIt->second.name;
-    } else {
+    if (unloadedIt == data->unloadedInodes_.cend()) {
       throwSystemErrorExplicit(EINVAL, "unknown inode number ", inodeNumber);
     }
+    if (unloadedIt->second.isUnlinked) {
+      return std::nullopt;
+    }
+    parent = unloadedIt->second.parent;
+    name = unloadedIt->second.name;
   }
+
+  // If the inode is not loaded, return its parent's path as long as it's
+  // parent isn't the root. The parent is looked up with the lock of this
+  // inode's shard released, as it is generally in another shard.
+  if (parent == kRootNodeId) {
+    // The parent is the Eden mount root, just return its name (base case)
+    return RelativePath(*name);
+  }
+  auto dir = getPathForInode(parent);
+  if (!dir) {
+    EDEN_BUG() << "unlinked parent inode " << parent
+               << "appears to contain non-unlinked child " << inodeNumber;
+  }
+  return *dir + *name;
 }
+
 void InodeMap::decFsRefcount(InodeNumber number, uint32_t count) {
   InodePtr inodePtr;
   {
-    auto data = data_.wlock();
+    auto data = getShard(number).wlock();
     inodePtr = decFsRefcountHelper(data, number, count);
   }
   // Now release our lock before decrementing the inode's FS reference
@@ -721,8 +810,8 @@ void InodeMap::forgetStaleInodes() {
   // TODO: this will unload by atime, atime is not updated by stat -- fix it
 
   XLOG(DBG2) << "forgetting stale inodes";
-  // We have to destroy InodePtrs outside of the data lock. These hold all the
-  // InodePtrs we created.
+  // We have to destroy InodePtrs outside of the shard locks. These hold all
+  // the InodePtrs we created.
   std::vector<InodePtr> toClearFSRef;
   std::vector<InodePtr> justToHoldBeyondScopeOfLock;
   auto cutoff = std::chrono::system_clock::now() -
@@ -730,8 +819,9 @@ void InodeMap::forgetStaleInodes() {
   auto cutoff_ts = folly::to<timespec>(cutoff);
   std::vector<InodeNumber> unloadedInodesToClearFSRef;
 
-  {
-    auto data = data_.wlock();
+  for (auto& shard : shards_) {
+    auto data = shard.data.wlock();
+    unloadedInodesToClearFSRef.clear();
 
     for (auto& inode : data->unloadedInodes_) {
       XLOG(DBG9) << "Considering forgetting unloaded inode " << inode.first;
@@ -756,10 +846,13 @@ void InodeMap::forgetStaleInodes() {
           << "decFsRefcountHelper should not return a loaded inode that  "
           << "needs to be dereferenced for an inode we know to be unloaded.";
     }
+  }
 
-    // we do this second because dereferencing a loaded inode will cause it to
-    // be unloaded. Thus this will create lots of unloaded inodes. we don't want
-    // to double decRef them, so we decref loaded inodes after unloaded ones.
+  // we do this second because dereferencing a loaded inode will cause it to
+  // be unloaded. Thus this will create lots of unloaded inodes. we don't want
+  // to double decRef them, so we decref loaded inodes after unloaded ones.
+  for (auto& shard : shards_) {
+    auto data = shard.data.wlock();
     for (auto& inode : data->loadedInodes_) {
       XLOG(DBG9) << "Considering forgetting loaded inode " << inode.first;
       auto inodePtr = decFsRefcountHelper(
@@ -798,9 +891,9 @@ void InodeMap::forgetStaleInodes() {
         }
       }
     }
-    numPeriodicallyUnloadedUnlinkedInodes_.fetch_add(
-        toClearFSRef.size(), std::memory_order_relaxed);
   }
+  numPeriodicallyUnloadedUnlinkedInodes_.fetch_add(
+      toClearFSRef.size(), std::memory_order_relaxed);
 
   for (auto& inodePtr : toClearFSRef) {
     XLOG(DBG7) << "forgetting NFS inode: " << inodePtr->getNodeId();
@@ -811,9 +904,8 @@ void InodeMap::forgetStaleInodes() {
 }
 
 void InodeMap::setUnmounted() {
-  auto data = data_.wlock();
-  XDCHECK(!data->isUnmounted_);
-  data->isUnmounted_ = true;
+  auto wasUnmounted = isUnmounted_.exchange(true, std::memory_order_acq_rel);
+  XDCHECK(!wasUnmounted);
 }
 
 Future<SerializedInodeMap> InodeMap::shutdown(
@@ -821,16 +913,17 @@ Future<SerializedInodeMap> InodeMap::shutdown(
   // Record that we are in the process of shutting down.
   auto future = Future<folly::Unit>::makeEmpty();
   {
-    auto data = data_.wlock();
-    XCHECK(!data->shutdownPromise.has_value())
+    XCHECK(!shuttingDown_.load(std::memory_order_acquire))
         << "shutdown() invoked more than once on InodeMap for "
         << mount_->getPath();
-    data->shutdownPromise.emplace(Promise<Unit>{});
-    future = data->shutdownPromise->getFuture();
+    shutdownPromise_.emplace(Promise<Unit>{});
+    future = shutdownPromise_->getFuture();
+    shuttingDown_.store(true, std::memory_order_release);
 
+    auto counts = getInodeCounts();
     XLOG(DBG3) << "starting InodeMap::shutdown: loadedCount="
-               << data->loadedInodes_.size()
-               << " unloadedCount=" << data->unloadedInodes_.size();
+               << counts.treeCount + counts.fileCount
+               << " unloadedCount=" << counts.unloadedInodeCount;
   }
 
   // If an error occurs during mount point initialization, shutdown() can be
@@ -843,13 +936,14 @@ Future<SerializedInodeMap> InodeMap::shutdown(
   // Walk from the root of the tree down, finding all unreferenced inodes,
   // and immediately destroy them.
   //
-  // Hold the the mountpoint-wide rename lock in shared mode while doing the
-  // walk.  We want to make sure that we walk *all* children.  While doing the
-  // walk we want to make sure that an Inode that hasn't been processed yet
-  // cannot be moved from the unprocessed part of the tree into a processed
-  // part of the tree.
+  // Hold the the mountpoint-wide rename lock while doing the walk.  We want
+  // to make sure that we walk *all* children.  While doing the walk we want to
+  // make sure that an Inode that hasn't been processed yet cannot be moved
+  // from the unprocessed part of the tree into a processed part of the tree.
+  // This needs exclusive mode, as files can be renamed with the rename lock
+  // held in shared mode.
   {
-    auto renameLock = mount_->acquireSharedRenameLock();
+    auto renameLock = mount_->acquireRenameLock();
     root_->unloadChildrenNow();
   }
 
@@ -867,19 +961,20 @@ Future<SerializedInodeMap> InodeMap::shutdown(
     // to them, then let the normal pointer release process be responsible for
     // unloading them.
     std::vector<InodePtr> inodesToUnload;
-    auto data = data_.wlock();
-    for (const auto& entry : data->loadedInodes_) {
-      if (!entry.second->isPtrAcquireCountZero()) {
-        continue;
-      }
-      if (!entry.second->isUnlinked()) {
-        continue;
+    for (auto& shard : shards_) {
+      auto data = shard.data.wlock();
+      for (const auto& entry : data->loadedInodes_) {
+        if (!entry.second->isPtrAcquireCountZero()) {
+          continue;
+        }
+        if (!entry.second->isUnlinked()) {
+          continue;
+        }
+        inodesToUnload.push_back(entry.second.getPtr());
       }
-      inodesToUnload.push_back(entry.second.getPtr());
     }
-    // Release the lock, then release all of our InodePtrs to unload
+    // Release the locks, then release all of our InodePtrs to unload
     // the inodes.
-    data.unlock();
     inodesToUnload.clear();
   }
 
@@ -896,74 +991,83 @@ Future<SerializedInodeMap> InodeMap::shutdown(
       return SerializedInodeMap{};
     }
 
-    auto data = data_.wlock();
+    // A consistent view of all the shards.
+    auto lock = lockAllShards();
+    size_t loadedCount = 0;
+    size_t unloadedCount = 0;
+    for (const auto& data : lock.shards_) {
+      loadedCount += data->loadedInodes_.size();
+      unloadedCount += data->unloadedInodes_.size();
+    }
     XLOG(DBG3)
         << "InodeMap::shutdown after releasing inodesToClear: loadedCount="
-        << data->loadedInodes_.size()
-        << " unloadedCount=" << data->unloadedInodes_.size();
+        << loadedCount << " unloadedCount=" << unloadedCount;
 
-    if (!data->loadedInodes_.empty()) {
-      EDEN_BUG() << "After InodeMap::shutdown() finished, "
-                 << data->loadedInodes_.size()
+    if (loadedCount != 0) {
+      EDEN_BUG() << "After InodeMap::shutdown() finished, " << loadedCount
                  << " inodes still loaded; they must all "
                  << "have been unloaded for this to succeed!";
     }
 
     SerializedInodeMap result;
-    result.unloadedInodes_ref()->reserve(data->unloadedInodes_.size());
-    for (const auto& [inodeNumber, entry] : data->unloadedInodes_) {
-      SerializedInodeMapEntry serializedEntry;
-
-      XLOG(DBG5) << "  serializing unloaded inode " << inodeNumber
-                 << " parent=" << entry.parent.get() << " name=" << entry.name;
-
-      serializedEntry.inodeNumber_ref() = inodeNumber.get();
-      serializedEntry.parentInode_ref() = entry.parent.get();
-      serializedEntry.name() = entry.name.asString();
-      serializedEntry.isUnlinked_ref() = entry.isUnlinked;
-      serializedEntry.numFsReferences_ref() = entry.numFsReferences;
-      if (entry.hash.has_value()) {
-        serializedEntry.hash_ref() = entry.hash.value().asString();
-      }
-      // If entry.hash is empty, the inode is materialized.
-      serializedEntry.mode_ref() = entry.mode;
+    result.unloadedInodes_ref()->reserve(unloadedCount);
+    for (const auto& data : lock.shards_) {
+      for (const auto& [inodeNumber, entry] : data->unloadedInodes_) {
+        SerializedInodeMapEntry serializedEntry;
+
+        XLOG(DBG5) << "  serializing unloaded inode " << inodeNumber
+                   << " parent=" << entry.parent.get()
+                   << " name=" << entry.name;
+
+        serializedEntry.inodeNumber_ref() = inodeNumber.get();
+        serializedEntry.parentInode_ref() = entry.parent.get();
+        serializedEntry.name() = entry.name.asString();
+        serializedEntry.isUnlinked_ref() = entry.isUnlinked;
+        serializedEntry.numFsReferences_ref() = entry.numFsReferences;
+        if (entry.hash.has_value()) {
+          serializedEntry.hash_ref() = entry.hash.value().asString();
+        }
+        // If entry.hash is empty, the inode is materialized.
+        serializedEntry.mode_ref() = entry.mode;
 
-      result.unloadedInodes_ref()->emplace_back(std::move(serializedEntry));
+        result.unloadedInodes_ref()->emplace_back(std::move(serializedEntry));
+      }
     }
 
     return result;
   });
 }
 
-void InodeMap::shutdownComplete(
-    folly::Synchronized<Members>::LockedPtr&& data) {
+void InodeMap::shutdownComplete(InodeMapLock&& lock) {
   // We manually dropped our reference count to the root inode in
   // shutdown().  Destroy it now, remove it from the loadedInodes, and call
   // resetNoDecRef() on our pointer to make sure it doesn't try to decrement the
   // reference count again when the pointer is destroyed. Note: we don't add
   // the root to unloadedInodes here as it has been freed and we don't want to
   // serialize the freed root during graceful shutdown for takeover.
-  auto numErased = data->loadedInodes_.erase(kRootNodeId);
-  XCHECK_EQ(numErased, 1u) << "inconsistent loaded inodes data: "
-                           << kRootNodeId;
-  --data->numTreeInodes_;
+  {
+    const auto& data = lock.get(kRootNodeId);
+    auto numErased = data->loadedInodes_.erase(kRootNodeId);
+    XCHECK_EQ(numErased, 1u)
+        << "inconsistent loaded inodes data: " << kRootNodeId;
+    --data->numTreeInodes_;
+  }
   delete root_.get();
   root_.resetNoDecRef();
 
-  // Unlock data_ before fulfilling the shutdown promise, just in case the
+  // Unlock the shards before fulfilling the shutdown promise, just in case the
   // promise invokes a callback that calls some of our other methods that
-  // may need to acquire this lock.
-  auto* shutdownPromise = &data->shutdownPromise.value();
-  data.unlock();
-  shutdownPromise->setValue();
+  // may need to acquire these locks.
+  lock.unlock();
+  shutdownPromise_->setValue();
 }
 
 bool InodeMap::isInodeRemembered(InodeNumber ino) const {
-  return data_.rlock()->unloadedInodes_.count(ino) > 0;
+  return getShard(ino).rlock()->unloadedInodes_.count(ino) > 0;
 }
 
 bool InodeMap::isInodeLoadedOrRemembered(InodeNumber ino) const {
-  auto members = data_.rlock();
+  auto members = getShard(ino).rlock();
   return members->unloadedInodes_.count(ino) > 0 ||
       members->loadedInodes_.count(ino) > 0;
 }
@@ -973,8 +1077,19 @@ void InodeMap::onInodeUnreferenced(
     ParentInodeInfo&& parentInfo) {
   XLOG(DBG8) << "inode " << inode->getNodeId()
              << " unreferenced: " << inode->getLogPath();
-  // Acquire our lock.
-  auto data = data_.wlock();
+  // Acquire our lock. Inodes are only unloaded here when they are unlinked,
+  // which only needs the shard of the inode, or when shutting down. Unloading
+  // a linked tree looks up its children, so shutting down locks all the
+  // shards.
+  //
+  // shuttingDown_ is checked with the shard locked: if it isn't set yet, the
+  // walk of shutdown() will only look at this inode after we are done.
+  auto lock = lockForUnload(inode->getNodeId());
+  bool shuttingDown = shuttingDown_.load(std::memory_order_acquire);
+  if (shuttingDown) {
+    lock.unlock();
+    lock = lockAllShards();
+  }
 
   // Decrement the Inode's acquire count
   auto acquireCount = inode->decPtrAcquireCount();
@@ -986,13 +1101,12 @@ void InodeMap::onInodeUnreferenced(
 
   // Decide if we should unload the inode now, or wait until later.
   bool unloadNow = false;
-  bool shuttingDown = data->shutdownPromise.has_value();
   XDCHECK(shuttingDown || inode != root_.get());
   if (shuttingDown) {
     // Check to see if this was the root inode that got unloaded.
     // This indicates that the shutdown is complete.
     if (inode == root_.get()) {
-      shutdownComplete(std::move(data));
+      shutdownComplete(std::move(lock));
       return;
     }
 
@@ -1016,7 +1130,7 @@ void InodeMap::onInodeUnreferenced(
         parentInfo.getParent().get(),
         parentInfo.getName(),
         parentInfo.isUnlinked(),
-        data);
+        lock);
     if (!parentInfo.isUnlinked()) {
       const auto& parentContents = parentInfo.getParentContents();
       auto it = parentContents->entries.find(parentInfo.getName());
@@ -1030,24 +1144,39 @@ void InodeMap::onInodeUnreferenced(
   // Deleting it may cause its parent TreeInode to become unreferenced, causing
   // another recursive call to onInodeUnreferenced(), which will need to
   // reacquire the lock.
-  data.unlock();
+  lock.unlock();
   parentInfo.reset();
   if (unloadNow) {
     delete inode;
   }
 }
 
+const InodeMapLock::LockedShard& InodeMapLock::get(InodeNumber number) const {
+  const auto& shard = shards_[InodeMap::getShardIndex(number)];
+  XCHECK(!shard.isNull()) << "the InodeMap shard of inode " << number
+                          << " isn't locked";
+  return shard;
+}
+
+InodeMapLock InodeMap::lockAllShards() {
+  InodeMapLock lock;
+  // Always in the same order, so that threads locking several shards can't
+  // deadlock.
+  for (size_t i = 0; i < kShardCount; ++i) {
+    lock.shards_[i] = shards_[i].data.wlock();
+  }
+  return lock;
+}
+
 InodeMapLock InodeMap::lockForUnload() {
-  return InodeMapLock{data_.wlock()};
+  return lockAllShards();
 }
 
-void InodeMap::unloadInode(
-    InodeBase* inode,
-    TreeInode* parent,
-    PathComponentPiece name,
-    bool isUnlinked,
-    const InodeMapLock& lock) {
-  return unloadInode(inode, parent, name, isUnlinked, lock.data_);
+InodeMapLock InodeMap::lockForUnload(InodeNumber number) {
+  InodeMapLock lock;
+  auto index = getShardIndex(number);
+  lock.shards_[index] = shards_[index].data.wlock();
+  return lock;
 }
 
 void InodeMap::unloadInode(
@@ -1055,11 +1184,12 @@ void InodeMap::unloadInode(
     TreeInode* parent,
     PathComponentPiece name,
     bool isUnlinked,
-    const folly::Synchronized<Members>::LockedPtr& data) {
+    const InodeMapLock& lock) {
+  const auto& data = lock.get(inode->getNodeId());
   // Call updateOverlayForUnload() to update the overlay and compute
   // if we need to remember an UnloadedInode entry.
   auto unloadedEntry =
-      updateOverlayForUnload(inode, parent, name, isUnlinked, data);
+      updateOverlayForUnload(inode, parent, name, isUnlinked, lock);
   if (unloadedEntry) {
     // Insert the unloaded entry
     XLOG(DBG7) << "inserting unloaded map entry for inode "
@@ -1084,9 +1214,10 @@ optional<InodeMap::UnloadedInode> InodeMap::updateOverlayForUnload(
     TreeInode* parent,
     PathComponentPiece name,
     bool isUnlinked,
-    const folly::Synchronized<Members>::LockedPtr& data) {
+    const InodeMapLock& lock) {
   auto fsCount = inode->getFsRefcount();
-  if (isUnlinked && (data->isUnmounted_ || fsCount == 0)) {
+  auto isUnmounted = isUnmounted_.load(std::memory_order_acquire);
+  if (isUnlinked && (isUnmounted || fsCount == 0)) {
     try {
       if (inode->getType() == dtype_t::Dir) {
         mount_->getOverlay()->removeOverlayDir(inode->getNodeId());
@@ -1113,7 +1244,7 @@ optional<InodeMap::UnloadedInode> InodeMap::updateOverlayForUnload(
   // refcounts on inodes that still existed before it was unmounted.
   // Everything is unreferenced by FS after an unmount operation, and we no
   // longer need to remember anything in the unloadedInodes_ map.
-  if (data->isUnmounted_) {
+  if (isUnmounted) {
     XLOG(DBG5) << "forgetting unreferenced inode " << inode->getNodeId()
                << " after unmount: " << inode->getLogPath();
     return std::nullopt;
@@ -1150,7 +1281,8 @@ optional<InodeMap::UnloadedInode> InodeMap::updateOverlayForUnload(
     for (const auto& pair : treeContents.entries) {
       const auto& childName = pair.first;
       const auto& entry = pair.second;
-      if (data->unloadedInodes_.count(entry.getInodeNumber())) {
+      auto childNumber = entry.getInodeNumber();
+      if (lock.get(childNumber)->unloadedInodes_.count(childNumber)) {
         XLOG(DBG5) << "remembering inode " << asTree->getNodeId() << " ("
                    << asTree->getLogPath() << ") because its child "
                    << childName << " was remembered";
@@ -1184,32 +1316,15 @@ bool InodeMap::startLoadingChildIfNotLoading(
   bool isFirstPromise;
   std::optional<InodeTraceEvent> startLoadEvent;
   {
-    auto data = data_.wlock();
-    UnloadedInode* unloadedData{nullptr};
-    auto iter = data->unloadedInodes_.find(childInode);
-    if (iter == data->unloadedInodes_.end()) {
-      InodeNumber parentNumber = parent->getNodeId();
-      // T127459236: not all attributes of the UnloadedInode are set here. For
-      // example, isUnlinked, hash, and numFsReferences are set to default
-      // values
-      auto newUnloadedData = UnloadedInode(parentNumber, name, mode);
-      auto ret =
-          data->unloadedInodes_.emplace(childInode, std::move(newUnloadedData));
-      XDCHECK(ret.second);
-      unloadedData = &ret.first->second;
-    } else {
-      unloadedData = &iter->second;
-    }
-
-    isFirstPromise = unloadedData->promises.empty();
-
-    if (isFirstPromise) {
-      startLoadEvent = std::make_optional<InodeTraceEvent>(
-          createInodeLoadStartEvent(childInode, *unloadedData, data));
-    }
-
-    // Add the promise to the existing list for this inode.
-    unloadedData->promises.push_back(std::move(promise));
+    auto data = getShard(childInode).wlock();
+    isFirstPromise = startLoadingChildLocked(
+        data,
+        parent,
+        name,
+        childInode,
+        mode,
+        std::move(promise),
+        startLoadEvent);
   }
   if (startLoadEvent.has_value()) {
     mount_->publishInodeTraceEvent(std::move(startLoadEvent.value()));
@@ -1220,10 +1335,73 @@ bool InodeMap::startLoadingChildIfNotLoading(
   return isFirstPromise;
 }
 
+void InodeMap::startLoadingChildrenIfNotLoading(
+    const TreeInode* parent,
+    std::vector<ChildLoad>& children) {
+  std::vector<InodeTraceEvent> startLoadEvents;
+  forEachByShard(
+      children.size(),
+      [&](size_t i) { return children[i].number; },
+      [&](const auto& data, size_t i) {
+        auto& child = children[i];
+        std::optional<InodeTraceEvent> startLoadEvent;
+        child.startLoad = startLoadingChildLocked(
+            data,
+            parent,
+            child.name,
+            child.number,
+            child.mode,
+            std::move(child.promise),
+            startLoadEvent);
+        if (startLoadEvent.has_value()) {
+          startLoadEvents.push_back(std::move(startLoadEvent.value()));
+        }
+      });
+  for (auto& event : startLoadEvents) {
+    mount_->publishInodeTraceEvent(std::move(event));
+  }
+}
+
+bool InodeMap::startLoadingChildLocked(
+    const folly::Synchronized<Members>::WLockedPtr& data,
+    const TreeInode* parent,
+    PathComponentPiece name,
+    InodeNumber childInode,
+    mode_t mode,
+    folly::Promise<InodePtr> promise,
+    std::optional<InodeTraceEvent>& startLoadEvent) {
+  UnloadedInode* unloadedData{nullptr};
+  auto iter = data->unloadedInodes_.find(childInode);
+  if (iter == data->unloadedInodes_.end()) {
+    InodeNumber parentNumber = parent->getNodeId();
+    // T127459236: not all attributes of the UnloadedInode are set here. For
+    // example, isUnlinked, hash, and numFsReferences are set to default
+    // values
+    auto newUnloadedData = UnloadedInode(parentNumber, name, mode);
+    auto ret =
+        data->unloadedInodes_.emplace(childInode, std::move(newUnloadedData));
+    XDCHECK(ret.second);
+    unloadedData = &ret.first->second;
+  } else {
+    unloadedData = &iter->second;
+  }
+
+  bool isFirstPromise = unloadedData->promises.empty();
+
+  if (isFirstPromise) {
+    startLoadEvent = std::make_optional<InodeTraceEvent>(
+        createInodeLoadStartEvent(childInode, *unloadedData, data));
+  }
+
+  // Add the promise to the existing list for this inode.
+  unloadedData->promises.push_back(std::move(promise));
+  return isFirstPromise;
+}
+
 void InodeMap::inodeCreated(const InodePtr& inode) {
   XLOG(DBG4) << "created new inode " << inode->getNodeId() << ": "
              << inode->getLogPath();
-  auto data = data_.wlock();
+  auto data = getShard(inode->getNodeId()).wlock();
   insertLoadedInode(data, inode.get());
 }
 
@@ -1234,12 +1412,17 @@ void InodeMap::recordPeriodicInodeUnload(size_t numInodesToUnload) {
 
 InodeMap::InodeCounts InodeMap::getInodeCounts() const {
   InodeCounts counts;
-  auto data = data_.rlock();
-  XDCHECK_EQ(
-      data->numTreeInodes_ + data->numFileInodes_, data->loadedInodes_.size());
-  counts.treeCount = data->numTreeInodes_;
-  counts.fileCount = data->numFileInodes_;
-  counts.unloadedInodeCount = data->unloadedInodes_.size();
+  // Each shard is only locked while it is read: the counts of different
+  // shards may be from slightly different points in time.
+  for (const auto& shard : shards_) {
+    auto data = shard.data.rlock();
+    XDCHECK_EQ(
+        data->numTreeInodes_ + data->numFileInodes_,
+        data->loadedInodes_.size());
+    counts.treeCount += data->numTreeInodes_;
+    counts.fileCount += data->numFileInodes_;
+    counts.unloadedInodeCount += data->unloadedInodes_.size();
+  }
   counts.periodicUnlinkedUnloadInodeCount =
       numPeriodicallyUnloadedUnlinkedInodes_.load(std::memory_order_relaxed);
   counts.periodicLinkedUnloadInodeCount =
@@ -1249,8 +1432,8 @@ InodeMap::InodeCounts InodeMap::getInodeCounts() const {
 
 std::vector<InodeNumber> InodeMap::getReferencedInodes() const {
   std::vector<InodeNumber> inodes;
-  {
-    auto data = data_.rlock();
+  for (const auto& shard : shards_) {
+    auto data = shard.data.rlock();
 
     for (auto& kv : data->loadedInodes_) {
       auto& loadedInode = kv.second;
@@ -9,12 +9,16 @@
 
 #include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
+#include <folly/lang/Align.h>
+#include <array>
+#include <atomic>
 #include <list>
 #include <memory>
 #include <optional>
 #include <unordered_map>
 
 #include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/InodeLoadTiming.h"
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/InodePtr.h"
 #include "eden/fs/inodes/Overlay.h"
@@ -93,6 +97,13 @@ class InodeMapLock;
  *
  *   We currently always allocate a InodeNumber value for any new Inode object
  *   even if it is not needed yet by the FUSE APIs.
+ *
+ * Both maps are sharded by InodeNumber, each shard under its own lock, so that
+ * operations on different inodes from many FS threads don't serialize on a
+ * single lock. Operations on one inode only lock the shard of that inode.
+ * The few operations that need a consistent view of several inodes, such as
+ * unloading the children of a tree or serializing the map for takeover, lock
+ * all the shards, always in the same order.
  */
 class InodeMap {
  public:
@@ -300,10 +311,19 @@ class InodeMap {
    * unloading.  It should only be called *after* acquring the TreeInode
    * contents lock.
    *
+   * This locks all the shards of the InodeMap.
+   *
    * This is an internal API that should not be used by most callers.
    */
   InodeMapLock lockForUnload();
 
+  /**
+   * Same as lockForUnload(), but only locks what is needed to unload the
+   * unlinked inode number, which is all that InodeBase::markUnlinked()
+   * needs.
+   */
+  InodeMapLock lockForUnload(InodeNumber number);
+
   /**
    * unloadedInode() should be called to unload an unreferenced inode.
    *
@@ -366,6 +386,28 @@ class InodeMap {
       mode_t mode,
       folly::Promise<InodePtr> promise);
 
+  /**
+   * A child to load with startLoadingChildrenIfNotLoading().
+   */
+  struct ChildLoad {
+    PathComponentPiece name;
+    InodeNumber number;
+    mode_t mode;
+    folly::Promise<InodePtr> promise;
+    // Set to what startLoadingChildIfNotLoading() would have returned for
+    // this child.
+    bool startLoad{false};
+  };
+
+  /**
+   * Same as startLoadingChildIfNotLoading() for several children of parent,
+   * locking each shard once for all the children it holds instead of once per
+   * child.
+   */
+  void startLoadingChildrenIfNotLoading(
+      const TreeInode* parent,
+      std::vector<ChildLoad>& children);
+
   /**
    * inodeLoadComplete() should only be called by TreeInode.
    *
@@ -378,8 +420,23 @@ class InodeMap {
    *
    * Returns a vector of Promises waiting on this TreeInode to be loaded.  The
    * TreeInode must fulfill these promises after releasing its contents lock.
+   *
+   * timing holds the phases of the load the TreeInode measured. They are
+   * reported by the END load event, along with the time the load waited in
+   * the InodeMap.
    */
-  PromiseVector inodeLoadComplete(InodeBase* inode);
+  PromiseVector inodeLoadComplete(
+      InodeBase* inode,
+      const InodeLoadTiming& timing);
+
+  /**
+   * Same as inodeLoadComplete() for several inodes, locking each shard once.
+   * timings holds the timing of each inode's load. Returns the promises
+   * waiting on each inode, in order.
+   */
+  std::vector<PromiseVector> inodesLoadComplete(
+      const std::vector<InodeBase*>& inodes,
+      const std::vector<InodeLoadTiming>& timings);
 
   /**
    * inodeLoadFailed() should only be called by TreeInode (or startChildLookup)
@@ -491,7 +548,7 @@ class InodeMap {
      *
      * (We could use folly::SharedPromise here instead, but it has extra
      * overhead that we don't really need.  It performs its own locking, but we
-     * are already protected by the data_ lock.)
+     * are already protected by the lock of the shard.)
      */
     PromiseVector promises;
 
@@ -526,7 +583,7 @@ class InodeMap {
 
     InodePtr getPtr() const {
       // Calling InodePtr::newPtrLocked is safe because interacting with
-      // LoadedInode implies the data_ lock is held.
+      // LoadedInode implies the lock of its shard is held.
       return InodePtr::newPtrLocked(inode_);
     }
 
@@ -561,14 +618,6 @@ class InodeMap {
      */
     std::unordered_map<InodeNumber, UnloadedInode> unloadedInodes_;
 
-    /**
-     * Indicates if the FS mount point has been unmounted.
-     *
-     * If this is true then the FS refcount on all inodes should be treated
-     * as 0, and we can forget all inodes while shutting down.
-     */
-    bool isUnmounted_{false};
-
     /**
      * The number of loaded TreeInode objects
      */
@@ -582,25 +631,37 @@ class InodeMap {
      * hold true to make sure our calculations are correct.
      */
     size_t numFileInodes_{0};
+  };
 
-    /**
-     * A promise to fulfill once shutdown() completes.
-     *
-     * This is only initialized when shutdown() is called, and will be
-     * std::nullopt until we are shutting down.
-     *
-     * In the future we could update this to just use an empty promise to
-     * indicate that we are not shutting down yet.  However, currently
-     * folly::Promise does not have a simple API to check if it is empty or not,
-     * so we have to wrap it in a std::optional.
-     */
-    std::optional<folly::Promise<folly::Unit>> shutdownPromise;
+  static constexpr size_t kShardCount = 16;
+
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    folly::Synchronized<Members> data;
   };
 
   InodeMap(InodeMap const&) = delete;
   InodeMap& operator=(InodeMap const&) = delete;
 
-  void shutdownComplete(folly::Synchronized<Members>::LockedPtr&& data);
+  static size_t getShardIndex(InodeNumber number) {
+    // Inode numbers are allocated sequentially, so that the inodes of a
+    // directory, often loaded together, are spread over the shards.
+    return number.get() % kShardCount;
+  }
+
+  folly::Synchronized<Members>& getShard(InodeNumber number) {
+    return shards_[getShardIndex(number)].data;
+  }
+
+  const folly::Synchronized<Members>& getShard(InodeNumber number) const {
+    return shards_[getShardIndex(number)].data;
+  }
+
+  /**
+   * Lock all the shards, in order.
+   */
+  InodeMapLock lockAllShards();
+
+  void shutdownComplete(InodeMapLock&& lock);
 
   void setupParentLookupPromise(
       folly::Promise<InodePtr>& promise,
@@ -621,8 +682,8 @@ class InodeMap {
    * Create and return inode load start event that will later be published to
    * tracebus for telemetry. Additionally sets the unloaded inode's
    * loadStartTime timestamp for when the start event began. This function
-   * should be called while holding the data_ write lock, and the event should
-   * be published after releasing the lock.
+   * should be called while holding the write lock of the shard of the inode,
+   * and the event should be published after releasing the lock.
    */
   InodeTraceEvent createInodeLoadStartEvent(
       InodeNumber number,
@@ -631,40 +692,53 @@ class InodeMap {
 
   /**
    * Create and return an inode load failure event that will later be published
-   * to tracebus for telemetry. This method acquires a read lock on data_. It
-   * should never be called while already holding the lock. The function returns
-   * std::nullopt if failing to find the inode number passed in.
+   * to tracebus for telemetry. This method acquires a read lock on the shard of
+   * the inode. It should never be called while already holding the lock. The
+   * function returns std::nullopt if failing to find the inode number passed
+   * in.
    */
   std::optional<InodeTraceEvent> createInodeLoadFailEvent(InodeNumber number);
 
   /**
-   * Extract the list of promises waiting on the specified inode number to be
-   * loaded.
-   *
-   * This method acquires the data_ lock internally.
-   * It should never be called while already holding the lock.
+   * Implementation of startLoadingChildIfNotLoading(), with the shard of the
+   * child locked. Sets startLoadEvent to the event to publish once the lock is
+   * released, if any.
    */
-  PromiseVector extractPendingPromises(InodeNumber number);
+  bool startLoadingChildLocked(
+      const folly::Synchronized<Members>::WLockedPtr& data,
+      const TreeInode* parent,
+      PathComponentPiece name,
+      InodeNumber childInode,
+      mode_t mode,
+      folly::Promise<InodePtr> promise,
+      std::optional<InodeTraceEvent>& startLoadEvent);
 
-  std::optional<RelativePath> getPathForInodeHelper(
-      InodeNumber inodeNumber,
-      const folly::Synchronized<Members>::RLockedPtr& data);
+  /**
+   * Implementation of inodeLoadComplete(), with the shard of the inode locked.
+   * Moves the promises waiting on the inode to promises and returns the event
+   * to publish once the lock is released.
+   */
+  InodeTraceEvent inodeLoadCompleteLocked(
+      const folly::Synchronized<Members>::WLockedPtr& data,
+      InodeBase* inode,
+      const InodeLoadTiming& timing,
+      PromiseVector& promises);
 
   /**
-   * Unload an inode
-   *
-   * This simply removes it from the loadedInodes_ map and, if it is still
-   * referenced by the FS, adds it to the unloadedInodes_ map.
+   * Call fn(data, i) for every i in [0, count) with the shard of
+   * getNumber(i) locked, locking each shard once.
+   */
+  template <typename GetNumber, typename Fn>
+  void forEachByShard(size_t count, GetNumber&& getNumber, Fn&& fn);
+
+  /**
+   * Extract the list of promises waiting on the specified inode number to be
+   * loaded.
    *
-   * The caller is responsible for actually deleting the Inode object after
-   * releasing the InodeMap lock.
+   * This method acquires the lock of the shard of the inode internally.
+   * It should never be called while already holding the lock.
    */
-  void unloadInode(
-      InodeBase* inode,
-      TreeInode* parent,
-      PathComponentPiece name,
-      bool isUnlinked,
-      const folly::Synchronized<Members>::LockedPtr& lock);
+  PromiseVector extractPendingPromises(InodeNumber number);
 
   /**
    * Update the overlay data for an inode before unloading it.
@@ -672,13 +746,16 @@ class InodeMap {
    *
    * This returns an UnloadedInode if we need to remember this inode in the
    * unloadedInodes_ map, or std::nullopt if we can forget about it completely.
+   *
+   * Deciding whether to remember a linked tree looks up its children, so
+   * the lock must then hold all the shards.
    */
   std::optional<UnloadedInode> updateOverlayForUnload(
       InodeBase* inode,
       TreeInode* parent,
       PathComponentPiece name,
       bool isUnlinked,
-      const folly::Synchronized<Members>::LockedPtr& lock);
+      const InodeMapLock& lock);
 
   void insertLoadedInode(
       const folly::Synchronized<Members>::LockedPtr& data,
@@ -687,9 +764,7 @@ class InodeMap {
   /**
    * Verify the InodeMap precondition and initialize the root_ member.
    */
-  void initializeRoot(
-      const folly::Synchronized<Members>::LockedPtr& data,
-      TreeInodePtr root);
+  void initializeRoot(const InodeMapLock& lock, TreeInodePtr root);
 
   /**
    * Construct an UnloadedInode and insert it onto the unloadedInodes_ map.
@@ -702,7 +777,7 @@ class InodeMap {
    */
   template <class... Args>
   void initializeUnloadedInode(
-      const folly::Synchronized<Members>::LockedPtr& data,
+      const InodeMapLock& lock,
       InodeNumber parentIno,
       InodeNumber ino,
       Args&&... args);
@@ -736,16 +811,38 @@ class InodeMap {
   TreeInodePtr root_;
 
   /**
-   * The locked data.
+   * The locked data, sharded by inode number.
    *
-   * Note: be very careful to hold this lock only when necessary.  No other
-   * locks should be acquired when holding this lock.  In particular this means
+   * Note: be very careful to hold these locks only when necessary.  No other
+   * locks should be acquired when holding one of these locks, except for
+   * the following shards when locking them in order.  In particular this means
    * that we should never access any InodeBase objects while holding the lock,
    * since we should not hold our lock while an InodeBase acquires its own
    * internal lock.  (This makes it safe for InodeBase to perform operations on
    * the InodeMap while holding their own lock.)
    */
-  folly::Synchronized<Members> data_;
+  std::array<Shard, kShardCount> shards_;
+
+  /**
+   * Indicates if the FS mount point has been unmounted.
+   *
+   * If this is true then the FS refcount on all inodes should be treated
+   * as 0, and we can forget all inodes while shutting down.
+   */
+  std::atomic<bool> isUnmounted_{false};
+
+  /**
+   * Set once shutdown() initialized shutdownPromise_.
+   */
+  std::atomic<bool> shuttingDown_{false};
+
+  /**
+   * A promise to fulfill once shutdown() completes.
+   *
+   * This is only initialized when shutdown() is called, before shuttingDown_
+   * is set, and is only accessed after, so it needs no lock.
+   */
+  std::optional<folly::Promise<folly::Unit>> shutdownPromise_;
 
   /**
    * This boolean controls EdenFS's response to receiving a request for an
@@ -780,20 +877,31 @@ class InodeMap {
  * in order to make multiple calls to unloadInode() without releasing and
  * re-acquiring the lock.
  *
+ * It holds the locks of all or some of the shards of the InodeMap.
+ *
  * This mostly exists to make forward declarations simpler.
  */
 class InodeMapLock {
  public:
-  explicit InodeMapLock(
-      folly::Synchronized<InodeMap::Members>::LockedPtr&& data)
-      : data_(std::move(data)) {}
-
   void unlock() {
-    data_.unlock();
+    for (auto& shard : shards_) {
+      if (!shard.isNull()) {
+        shard.unlock();
+      }
+    }
   }
 
  private:
   friend class InodeMap;
-  folly::Synchronized<InodeMap::Members>::LockedPtr data_;
+  using LockedShard = folly::Synchronized<InodeMap::Members>::LockedPtr;
+
+  InodeMapLock() = default;
+
+  /**
+   * The lock of the shard of number, which must be held.
+   */
+  const LockedShard& get(InodeNumber number) const;
+
+  std::array<LockedShard, InodeMap::kShardCount> shards_;
 };
 } // namespace facebook::eden
@@ -9,6 +9,8 @@
 
 #ifndef _WIN32
 
+#include <folly/Range.h>
+#include <folly/ScopeGuard.h>
 #include <optional>
 #include "eden/fs/inodes/InodeMetadata.h"
 #include "eden/fs/inodes/InodeNumber.h"
@@ -59,7 +61,8 @@ struct InodeTableEntry {
  * is killed.
  *
  * The storage remains dense - rather than using a free list, upon removal of an
- * entry, the last entry is moved to the removed entry's index.
+ * entry, the last entry is moved to the removed entry's index. The file is
+ * only shrunk by compact().
  *
  * The locking strategy is as follows:
  *
@@ -90,12 +93,70 @@ class InodeTable {
 
   /**
    * Create or open an InodeTable at the specified path.
+   *
+   * With populate, the whole file is read in when it is mapped rather than
+   * faulted in as records are accessed.
    */
   template <typename... OldRecords>
-  static std::unique_ptr<InodeTable> open(folly::StringPiece path) {
+  static std::unique_ptr<InodeTable> open(
+      folly::StringPiece path,
+      bool populate = true) {
+    MappedDiskVectorOptions options;
+    options.populate = populate;
+    return open<OldRecords...>(path, options);
+  }
+
+  template <typename... OldRecords>
+  static std::unique_ptr<InodeTable> open(
+      folly::StringPiece path,
+      MappedDiskVectorOptions options) {
     return std::unique_ptr<InodeTable>{
         new InodeTable{MappedDiskVector<Entry>::template open<
-            detail::InodeTableEntry<OldRecords>...>(path, true)}};
+            detail::InodeTableEntry<OldRecords>...>(path, options)}};
+  }
+
+  struct Stats {
+    /// Number of inodes with a record.
+    size_t entryCount;
+    /// Number of records the file has room for.
+    size_t capacity;
+    /// Size of the file, in bytes.
+    size_t fileSizeInBytes;
+  };
+
+  Stats getStats() const {
+    auto state = state_.rlock();
+    return Stats{
+        state->storage.size(),
+        state->storage.capacity(),
+        state->storage.fileSizeInBytes()};
+  }
+
+  /**
+   * Shrink the file if more than maxUnusedFraction of its capacity is left
+   * unused, as after many inodes were freed: the storage stays dense but the
+   * file never shrinks otherwise. Returns the number of bytes released.
+   */
+  size_t compact(double maxUnusedFraction) {
+    auto state = state_.wlock();
+    auto capacity = state->storage.capacity();
+    auto unused = capacity - state->storage.size();
+    if (capacity == 0 ||
+        static_cast<double>(unused) / capacity <= maxUnusedFraction) {
+      return 0;
+    }
+    state->indices.rehash(0);
+    return state->storage.shrinkToFit();
+  }
+
+  /**
+   * Synchronously write out the records modified since the previous flush,
+   * for the callers that want them to survive a kernel or disk shutdown.
+   * Returns the number of bytes synced.
+   */
+  size_t flush() {
+    auto state = state_.rlock();
+    return state->storage.flush();
   }
 
   /**
@@ -186,40 +247,48 @@ class InodeTable {
       auto index = iter->second;
       XCHECK_LT(index, state.storage.size());
       fn(state.storage[index].record);
-      // TODO: maybe trigger a background msync
+      state.storage.markDirty(index);
       return state.storage[index].record;
     });
   }
 
-  // TODO: replace with freeInodes - it's much more efficient to free a bunch
-  // at once.
   void freeInode(InodeNumber ino) {
+    freeInodes(folly::Range<const InodeNumber*>{&ino, 1});
+  }
+
+  /**
+   * Free the entries of all the given inodes, taking the lock only once.
+   */
+  void freeInodes(folly::Range<const InodeNumber*> inodes) {
     state_.withWLock([&](auto& state) {
       auto& storage = state.storage;
       auto& indices = state.indices;
 
-      auto iter = indices.find(ino);
-      if (iter == indices.end()) {
-        // While transitioning metadata from the overlay to the
-        // InodeMetadataTable, it is common for there to be no metadata for an
-        // inode whose number is known. The Overlay calls freeInode()
-        // unconditionally, so simply do nothing.
-        return;
-      }
+      for (auto ino : inodes) {
+        auto iter = indices.find(ino);
+        if (iter == indices.end()) {
+          // While transitioning metadata from the overlay to the
+          // InodeMetadataTable, it is common for there to be no metadata for
+          // an inode whose number is known. The Overlay calls freeInode()
+          // unconditionally, so simply do nothing.
+          continue;
+        }
 
-      size_t indexToDelete = iter->second;
-      indices.erase(iter);
+        size_t indexToDelete = iter->second;
+        indices.erase(iter);
 
-      XDCHECK_GT(storage.size(), 0ul);
-      size_t lastIndex = storage.size() - 1;
+        XDCHECK_GT(storage.size(), 0ul);
+        size_t lastIndex = storage.size() - 1;
 
-      if (lastIndex != indexToDelete) {
-        auto lastInode = storage[lastIndex].inode;
-        storage[indexToDelete] = storage[lastIndex];
-        indices[lastInode] = indexToDelete;
-      }
+        if (lastIndex != indexToDelete) {
+          auto lastInode = storage[lastIndex].inode;
+          storage[indexToDelete] = storage[lastIndex];
+          storage.markDirty(indexToDelete);
+          indices[lastInode] = indexToDelete;
+        }
 
-      storage.pop_back();
+        storage.pop_back();
+      }
     });
   }
 
@@ -237,6 +306,7 @@ class InodeTable {
       auto index = entry.second;
       auto& record = state->storage[index].record;
       fn(inode, record);
+      state->storage.markDirty(index);
     }
   }
 
@@ -276,6 +346,9 @@ class InodeTable {
       auto iter = state->indices.find(ino);
       if (LIKELY(iter != state->indices.end())) {
         auto index = iter->second;
+        SCOPE_EXIT {
+          state->storage.markDirty(index);
+        };
         return modify(state->storage[index].record);
       }
     }
@@ -289,6 +362,9 @@ class InodeTable {
     auto iter = state->indices.find(ino);
     if (UNLIKELY(iter != state->indices.end())) {
       auto index = iter->second;
+      SCOPE_EXIT {
+        state->storage.markDirty(index);
+      };
       return modify(state->storage[index].record);
     }
 
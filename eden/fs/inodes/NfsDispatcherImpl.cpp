@@ -14,7 +14,9 @@
 #include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/inodes/InodeBase.h"
 #include "eden/fs/inodes/InodeMap.h"
+#include "eden/fs/inodes/InodeTable.h"
 #include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/inodes/VirtualInode.h"
 #include "eden/fs/nfs/NfsUtils.h"
 
 namespace facebook::eden {
@@ -64,6 +66,7 @@ ImmediateFuture<std::tuple<InodeNumber, struct stat>> NfsDispatcherImpl::lookup(
   return inodeMap_->lookupTreeInode(dir)
       .thenValue([name = std::move(name),
                   context = context.copy()](const TreeInodePtr& inode) {
+        inode->getMount()->recordChildLookup(inode->getNodeId(), *context);
         return inode->getOrLoadChild(name, context);
       })
       .thenValue([context = context.copy()](InodePtr&& inode) {
@@ -110,15 +113,25 @@ ImmediateFuture<NfsDispatcher::WriteRes> NfsDispatcherImpl::write(
   return inodeMap_->lookupFileInode(ino).thenValue(
       [data = std::move(data), offset, context = context.copy()](
           const FileInodePtr& inode) mutable {
-        // TODO(xavierd): Modify write to obtain pre and post stat of the
-        // file.
+        // The pre stat can't be collected atomically with the write, only
+        // the post stat is returned.
         return inode->write(std::move(data), offset, context)
-            .thenValue([](size_t written) {
-              return WriteRes{written, std::nullopt, std::nullopt};
+            .thenValue([inode, context = context.copy()](size_t written) {
+              return inode->stat(context).thenValue(
+                  [written](struct stat&& stat) {
+                    return WriteRes{written, std::nullopt, stat};
+                  });
             });
       });
 }
 
+ImmediateFuture<folly::Unit> NfsDispatcherImpl::fsync(
+    InodeNumber ino,
+    bool datasync) {
+  return inodeMap_->lookupFileInode(ino).thenValue(
+      [datasync](const FileInodePtr& inode) { inode->fsync(datasync); });
+}
+
 ImmediateFuture<NfsDispatcher::CreateRes> NfsDispatcherImpl::create(
     InodeNumber dir,
     PathComponent name,
@@ -129,19 +142,18 @@ ImmediateFuture<NfsDispatcher::CreateRes> NfsDispatcherImpl::create(
   return inodeMap_->lookupTreeInode(dir).thenValue(
       [context = context.copy(), name = std::move(name), mode](
           const TreeInodePtr& inode) {
-        // TODO(xavierd): Modify mknod to obtain the pre and post stat of the
-        // directory.
         // Set dev to 0 as this is unused for a regular file.
         auto newFile = inode->mknod(name, mode, 0, InvalidationRequired::No);
         auto statFut = newFile->stat(context);
         return std::move(statFut).thenValue(
-            [newFile = std::move(newFile)](struct stat&& stat) {
+            [dir = inode,
+             newFile = std::move(newFile),
+             context = context.copy()](struct stat&& stat) {
               newFile->incFsRefcount();
-              return CreateRes{
-                  newFile->getNodeId(),
-                  std::move(stat),
-                  std::nullopt,
-                  std::nullopt};
+              return dir->stat(context).thenValue(
+                  [ino = newFile->getNodeId(), stat](struct stat&& dirStat) {
+                    return CreateRes{ino, stat, std::nullopt, dirStat};
+                  });
             });
       });
 }
@@ -154,16 +166,18 @@ ImmediateFuture<NfsDispatcher::MkdirRes> NfsDispatcherImpl::mkdir(
   return inodeMap_->lookupTreeInode(dir).thenValue(
       [context = context.copy(), name = std::move(name), mode](
           const TreeInodePtr& inode) {
-        // TODO(xavierd): Modify mkdir to obtain the pre and post stat of the
-        // directory.
         auto newDir = inode->mkdir(name, mode, InvalidationRequired::No);
         auto statFut = newDir->stat(context);
-        return std::move(statFut).thenValue([newDir = std::move(newDir)](
-                                                struct stat&& stat) {
-          newDir->incFsRefcount();
-          return MkdirRes{
-              newDir->getNodeId(), std::move(stat), std::nullopt, std::nullopt};
-        });
+        return std::move(statFut).thenValue(
+            [dir = inode,
+             newDir = std::move(newDir),
+             context = context.copy()](struct stat&& stat) {
+              newDir->incFsRefcount();
+              return dir->stat(context).thenValue(
+                  [ino = newDir->getNodeId(), stat](struct stat&& dirStat) {
+                    return MkdirRes{ino, stat, std::nullopt, dirStat};
+                  });
+            });
       });
 }
 
@@ -176,18 +190,17 @@ ImmediateFuture<NfsDispatcher::SymlinkRes> NfsDispatcherImpl::symlink(
       [context = context.copy(),
        name = std::move(name),
        data = std::move(data)](const TreeInodePtr& inode) {
-        // TODO(xavierd): Modify symlink to obtain the pre and post stat of the
-        // directory.
         auto symlink = inode->symlink(name, data, InvalidationRequired::No);
         auto statFut = symlink->stat(context);
         return std::move(statFut).thenValue(
-            [symlink = std::move(symlink)](struct stat&& stat) {
+            [dir = inode,
+             symlink = std::move(symlink),
+             context = context.copy()](struct stat&& stat) {
               symlink->incFsRefcount();
-              return SymlinkRes{
-                  symlink->getNodeId(),
-                  std::move(stat),
-                  std::nullopt,
-                  std::nullopt};
+              return dir->stat(context).thenValue(
+                  [ino = symlink->getNodeId(), stat](struct stat&& dirStat) {
+                    return SymlinkRes{ino, stat, std::nullopt, dirStat};
+                  });
             });
       });
 }
@@ -201,18 +214,17 @@ ImmediateFuture<NfsDispatcher::MknodRes> NfsDispatcherImpl::mknod(
   return inodeMap_->lookupTreeInode(dir).thenValue(
       [context = context.copy(), name = std::move(name), mode, rdev](
           const TreeInodePtr& inode) {
-        // TODO(xavierd): Modify mknod to obtain the pre and post stat of the
-        // directory.
         auto newFile = inode->mknod(name, mode, rdev, InvalidationRequired::No);
         auto statFut = newFile->stat(context);
         return std::move(statFut).thenValue(
-            [newFile = std::move(newFile)](struct stat&& stat) {
+            [dir = inode,
+             newFile = std::move(newFile),
+             context = context.copy()](struct stat&& stat) {
               newFile->incFsRefcount();
-              return MknodRes{
-                  newFile->getNodeId(),
-                  std::move(stat),
-                  std::nullopt,
-                  std::nullopt};
+              return dir->stat(context).thenValue(
+                  [ino = newFile->getNodeId(), stat](struct stat&& dirStat) {
+                    return MknodRes{ino, stat, std::nullopt, dirStat};
+                  });
             });
       });
 }
@@ -225,10 +237,10 @@ ImmediateFuture<NfsDispatcher::UnlinkRes> NfsDispatcherImpl::unlink(
       [context = context.copy(),
        name = std::move(name)](const TreeInodePtr& inode) {
         return inode->unlink(name, InvalidationRequired::No, context)
-            .thenValue([](auto&&) {
-              // TODO(xavierd): Modify unlink to obtain the pre and post stat
-              // of the directory.
-              return NfsDispatcher::UnlinkRes{std::nullopt, std::nullopt};
+            .thenValue([dir = inode, context = context.copy()](auto&&) {
+              return dir->stat(context).thenValue([](struct stat&& dirStat) {
+                return NfsDispatcher::UnlinkRes{std::nullopt, dirStat};
+              });
             });
       });
 }
@@ -241,10 +253,10 @@ ImmediateFuture<NfsDispatcher::RmdirRes> NfsDispatcherImpl::rmdir(
       [context = context.copy(),
        name = std::move(name)](const TreeInodePtr& inode) {
         return inode->rmdir(name, InvalidationRequired::No, context)
-            .thenValue([](auto&&) {
-              // TODO(xavierd): Modify rmdir to obtain the pre and post stat of
-              // the directory.
-              return NfsDispatcher::RmdirRes{std::nullopt, std::nullopt};
+            .thenValue([dir = inode, context = context.copy()](auto&&) {
+              return dir->stat(context).thenValue([](struct stat&& dirStat) {
+                return NfsDispatcher::RmdirRes{std::nullopt, dirStat};
+              });
             });
       });
 }
@@ -266,17 +278,25 @@ ImmediateFuture<NfsDispatcher::RenameRes> NfsDispatcherImpl::rename(
              toName = std::move(toName),
              toDirInode = std::move(toDirInode),
              context = context.copy()](const TreeInodePtr& fromDirInode) {
-              return fromDirInode->rename(
-                  fromName,
-                  toDirInode,
-                  toName,
-                  InvalidationRequired::No,
-                  context);
+              return fromDirInode
+                  ->rename(
+                      fromName,
+                      toDirInode,
+                      toName,
+                      InvalidationRequired::No,
+                      context)
+                  .thenValue([fromDirInode,
+                              toDirInode,
+                              context = context.copy()](auto&&) {
+                    return collectAllSafe(
+                        fromDirInode->stat(context), toDirInode->stat(context));
+                  });
             });
       })
-      .thenValue([](auto&&) {
-        // TODO(xavierd): collect pre and post dir stats.
-        return NfsDispatcher::RenameRes{};
+      .thenValue([](std::tuple<struct stat, struct stat>&& dirStats) {
+        auto& [fromDirStat, toDirStat] = dirStats;
+        return NfsDispatcher::RenameRes{
+            std::nullopt, fromDirStat, std::nullopt, toDirStat};
       });
 }
 
@@ -315,11 +335,17 @@ ImmediateFuture<NfsDispatcher::ReaddirRes> NfsDispatcherImpl::readdirplus(
                     }));
           } else {
             futuresVec.push_back(
-                inode->getOrLoadChild(PathComponent{entry.name}, context)
-                    .thenValue(
-                        [entry, context = context.copy()](InodePtr&& inodep) {
-                          return inodep->stat(context);
-                        })
+                inode
+                    ->getOrFindChild(
+                        PathComponentPiece{entry.name},
+                        context,
+                        /*loadInodes=*/false)
+                    .thenValue([this,
+                                ino = InodeNumber{entry.fileid},
+                                context = context.copy()](
+                                   VirtualInode&& child) {
+                      return statChild(ino, child, context);
+                    })
                     .thenTry([&entry](folly::Try<struct stat> st) {
                       entry.name_attributes = statToPostOpAttr(st);
                       return folly::unit;
@@ -335,6 +361,37 @@ ImmediateFuture<NfsDispatcher::ReaddirRes> NfsDispatcherImpl::readdirplus(
       });
 }
 
+ImmediateFuture<struct stat> NfsDispatcherImpl::statChild(
+    InodeNumber ino,
+    const VirtualInode& child,
+    const ObjectFetchContextPtr& context) {
+  if (auto inode = child.getInodePtrOrNull()) {
+    return inode->stat(context);
+  }
+
+  // The child isn't loaded: its mode and size come from source control, and
+  // the rest is what its inode will report once loaded, so that loading it
+  // doesn't change the attributes the client cached.
+  auto lastCheckoutTime = mount_->getLastCheckoutTime().toTimespec();
+  return child.stat(lastCheckoutTime, mount_->getObjectStore(), context)
+      .thenValue([this, ino](struct stat&& scmStat) {
+        auto st = mount_->initStatData();
+        st.st_ino = ino.get();
+        st.st_nlink = scmStat.st_nlink;
+        st.st_size = scmStat.st_size;
+        auto metadata = mount_->getInodeMetadataTable()->getOptional(ino);
+        if (!metadata) {
+          metadata = mount_->getInitialInodeMetadata(scmStat.st_mode);
+        }
+        metadata->applyToStat(st);
+        if (!S_ISDIR(st.st_mode)) {
+          // Like FileInode::stat, count 512 byte blocks.
+          st.st_blocks = (st.st_size + 511) / 512;
+        }
+        return st;
+      });
+}
+
 ImmediateFuture<struct statfs> NfsDispatcherImpl::statfs(
     InodeNumber /*dir*/,
     const ObjectFetchContextPtr& /*context*/) {
@@ -14,6 +14,7 @@
 namespace facebook::eden {
 class EdenMount;
 class InodeMap;
+class VirtualInode;
 
 class NfsDispatcherImpl : public NfsDispatcher {
  public:
@@ -53,6 +54,8 @@ class NfsDispatcherImpl : public NfsDispatcher {
       off_t offset,
       const ObjectFetchContextPtr& context) override;
 
+  ImmediateFuture<folly::Unit> fsync(InodeNumber ino, bool datasync) override;
+
   ImmediateFuture<NfsDispatcher::CreateRes> create(
       InodeNumber ino,
       PathComponent name,
@@ -112,6 +115,14 @@ class NfsDispatcherImpl : public NfsDispatcher {
       const ObjectFetchContextPtr& context) override;
 
  private:
+  /**
+   * Stat a child listed by readdirplus, without loading its inode.
+   */
+  ImmediateFuture<struct stat> statChild(
+      InodeNumber ino,
+      const VirtualInode& child,
+      const ObjectFetchContextPtr& context);
+
   // The EdenMount associated with this dispatcher.
   EdenMount* const mount_;
   InodeMap* const inodeMap_;
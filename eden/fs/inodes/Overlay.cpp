@@ -26,11 +26,18 @@
 #include "eden/fs/inodes/InodeTable.h"
 #include "eden/fs/inodes/OverlayFile.h"
 #include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/inodes/WriteBehindInodeCatalog.h"
 #include "eden/fs/inodes/sqlitecatalog/BufferedSqliteInodeCatalog.h"
 #include "eden/fs/inodes/sqlitecatalog/SqliteInodeCatalog.h"
+#include "eden/fs/model/Hash.h"
 #include "eden/fs/sqlite/SqliteDatabase.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/PathFuncs.h"
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
+
+#ifndef _WIN32
+#include "eden/fs/inodes/fscatalog/SegmentInodeCatalog.h"
+#endif
 
 namespace facebook::eden {
 
@@ -77,18 +84,25 @@ std::unique_ptr<InodeCatalog> makeInodeCatalog(
   }
   return std::make_unique<SqliteInodeCatalog>(localDir);
 #else
+  if (inodeCatalogType == Overlay::InodeCatalogType::Segment) {
+    return std::make_unique<SegmentInodeCatalog>(
+        localDir, config.overlaySegmentSize.getValue());
+  }
   return std::make_unique<FsInodeCatalog>(
       static_cast<FileContentStore*>(fileContentStore));
 #endif
 }
 
 std::unique_ptr<IFileContentStore> makeFileContentStore(
-    AbsolutePathPiece localDir) {
+    AbsolutePathPiece localDir,
+    const EdenConfig& config) {
 #ifdef _WIN32
   (void)localDir;
+  (void)config;
   return nullptr;
 #else
-  return std::make_unique<FileContentStore>(localDir);
+  return std::make_unique<FileContentStore>(
+      localDir, config.overlayCloneCacheSize.getValue());
 #endif
 }
 } // namespace
@@ -122,7 +136,7 @@ Overlay::Overlay(
     InodeCatalogType inodeCatalogType,
     std::shared_ptr<StructuredLogger> logger,
     const EdenConfig& config)
-    : fileContentStore_{makeFileContentStore(localDir)},
+    : fileContentStore_{makeFileContentStore(localDir, config)},
       inodeCatalog_{makeInodeCatalog(
           localDir,
           inodeCatalogType,
@@ -132,7 +146,20 @@ Overlay::Overlay(
       supportsSemanticOperations_{inodeCatalog_->supportsSemanticOperations()},
       localDir_{localDir},
       caseSensitive_{caseSensitive},
-      structuredLogger_{logger} {}
+      structuredLogger_{logger} {
+  if (auto ioThreads = config.overlayIoThreads.getValue()) {
+    ioExecutor_ =
+        std::make_unique<UnboundedQueueExecutor>(ioThreads, "OverlayIO");
+  }
+#ifndef _WIN32
+  metadataTableMaxUnusedFraction_ =
+      config.overlayMetadataTableMaxUnusedFraction.getValue();
+  metadataTableSync_ = config.overlayMetadataTableSync.getValue();
+  if (config.overlayCloneMaterialization.getValue()) {
+    cloneMinimumSize_ = config.overlayCloneMinimumSize.getValue();
+  }
+#endif // !_WIN32
+}
 
 Overlay::~Overlay() {
   close();
@@ -147,6 +174,9 @@ void Overlay::close() {
     gcThread_.join();
   }
 
+  // The pending asynchronous reads reference this, wait for them.
+  ioExecutor_.reset();
+
   // Make sure everything is shut down in reverse of construction order.
   // Cleanup is not necessary if tree overlay was not initialized and either
   // there is no file content store or the it was not initalized
@@ -168,6 +198,9 @@ void Overlay::close() {
 
   closeAndWaitForOutstandingIO();
 #ifndef _WIN32
+  if (inodeMetadataTable_ && metadataTableSync_) {
+    inodeMetadataTable_->flush();
+  }
   inodeMetadataTable_.reset();
 #endif // !_WIN32
 
@@ -234,8 +267,15 @@ void Overlay::initOverlay(
     FOLLY_MAYBE_UNUSED const OverlayChecker::ProgressCallback& progressCallback,
     FOLLY_MAYBE_UNUSED OverlayChecker::LookupCallback& lookupCallback) {
   IORequest req{this};
+  // The segments live in the FileContentStore's directory, open them with its
+  // lock held.
+  bool contentStoreFirst = inodeCatalogType_ == InodeCatalogType::Segment;
+  if (fileContentStore_ && contentStoreFirst) {
+    fileContentStore_->initialize(true);
+  }
   auto optNextInodeNumber = inodeCatalog_->initOverlay(true);
-  if (fileContentStore_ && inodeCatalogType_ != InodeCatalogType::Legacy) {
+  if (fileContentStore_ && inodeCatalogType_ != InodeCatalogType::Legacy &&
+      !contentStoreFirst) {
     fileContentStore_->initialize(true);
   }
   if (!optNextInodeNumber.has_value()) {
@@ -260,7 +300,10 @@ void Overlay::initOverlay(
         static_cast<FsInodeCatalog*>(inodeCatalog_.get()),
         static_cast<FileContentStore*>(fileContentStore_.get()),
         std::nullopt,
-        lookupCallback);
+        lookupCallback,
+        config ? config->fsckThreads.getValue()
+               : OverlayChecker::kDefaultThreadCount,
+        config && config->fsckCheckpoint.getValue());
     folly::stop_watch<> fsckRuntime;
     checker.scanForErrors(progressCallback);
     auto result = checker.repairErrors();
@@ -296,7 +339,17 @@ void Overlay::initOverlay(
   if (folly::kIsWindows && mountPath.has_value()) {
     optNextInodeNumber =
         dynamic_cast<SqliteInodeCatalog*>(inodeCatalog_.get())
-            ->scanLocalChanges(std::move(config), *mountPath, lookupCallback);
+            ->scanLocalChanges(config, *mountPath, lookupCallback);
+  }
+
+  // The checks above need the underlying catalog, wrap it afterwards. The
+  // buffered sqlite catalogs already write behind.
+  if (config && config->overlayWriteBehind.getValue() &&
+      inodeCatalogType_ == InodeCatalogType::Legacy) {
+    inodeCatalog_ = std::make_unique<WriteBehindInodeCatalog>(
+        std::move(inodeCatalog_),
+        config->overlayWriteBehindDelay.getValue(),
+        config->overlayWriteBehindMaxPending.getValue());
   }
 
   nextInodeNumber_.store(optNextInodeNumber->get(), std::memory_order_relaxed);
@@ -304,9 +357,17 @@ void Overlay::initOverlay(
 #ifndef _WIN32
   // Open after infoFile_'s lock is acquired because the InodeTable acquires
   // its own lock, which should be released prior to infoFile_.
+  MappedDiskVectorOptions tableOptions;
+  tableOptions.populate =
+      !config || config->overlayMetadataTablePopulate.getValue();
+  tableOptions.hugePages =
+      config && config->overlayMetadataTableHugePages.getValue();
+  tableOptions.willNeed =
+      config && config->overlayMetadataTableWillNeed.getValue();
   inodeMetadataTable_ = InodeMetadataTable::open(
       (localDir_ + PathComponentPiece{FileContentStore::kMetadataFile})
-          .c_str());
+          .c_str(),
+      tableOptions);
 #endif // !_WIN32
 }
 
@@ -329,6 +390,14 @@ InodeNumber Overlay::allocateInodeNumber() {
   return InodeNumber{previous};
 }
 
+InodeNumber Overlay::allocateInodeNumbers(size_t count) {
+  XDCHECK_NE(0u, count);
+  // See allocateInodeNumber() for why wrapping isn't handled.
+  auto first = nextInodeNumber_.fetch_add(count);
+  XDCHECK_NE(0u, first) << "allocateInodeNumbers called before initialize";
+  return InodeNumber{first};
+}
+
 DirContents Overlay::loadOverlayDir(InodeNumber inodeNumber) {
   DirContents result(caseSensitive_);
   IORequest req{this};
@@ -355,6 +424,22 @@ DirContents Overlay::loadOverlayDir(InodeNumber inodeNumber) {
     if (value.hash_ref() && !value.hash_ref()->empty()) {
       auto hash =
           ObjectId{folly::ByteRange{folly::StringPiece{*value.hash_ref()}}};
+      if (objectIdMigrator_) {
+        try {
+          if (auto migrated = objectIdMigrator_(hash)) {
+            hash = std::move(*migrated);
+            shouldMigrateToNewFormat = true;
+          }
+        } catch (const std::exception& ex) {
+          // Keep the legacy ObjectId, it may be migrated on a later load.
+          XLOGF(
+              DBG3,
+              "Failed to migrate object ID {} of {}: {}",
+              hash,
+              name,
+              ex.what());
+        }
+      }
       result.emplace(PathComponentPiece{name}, *value.mode_ref(), ino, hash);
     } else {
       // The inode is materialized
@@ -416,6 +501,18 @@ overlay::OverlayDir Overlay::serializeOverlayDir(
   return odir;
 }
 
+ImmediateFuture<DirContents> Overlay::loadOverlayDirAsync(
+    InodeNumber inodeNumber) {
+  if (!ioExecutor_) {
+    return makeImmediateFutureWith(
+        [&] { return loadOverlayDir(inodeNumber); });
+  }
+  return folly::via(
+             ioExecutor_.get(),
+             [this, inodeNumber] { return loadOverlayDir(inodeNumber); })
+      .semi();
+}
+
 void Overlay::saveOverlayDir(InodeNumber inodeNumber, const DirContents& dir) {
   inodeCatalog_->saveOverlayDir(
       inodeNumber, serializeOverlayDir(inodeNumber, dir));
@@ -441,6 +538,20 @@ void Overlay::removeOverlayFile(InodeNumber inodeNumber) {
 #endif
 }
 
+void Overlay::removeOverlayFiles(
+    folly::Range<const InodeNumber*> inodeNumbers) {
+#ifndef _WIN32
+  IORequest req{this};
+
+  getInodeMetadataTable()->freeInodes(inodeNumbers);
+  for (auto inodeNumber : inodeNumbers) {
+    fileContentStore_->removeOverlayFile(inodeNumber);
+  }
+#else
+  (void)inodeNumbers;
+#endif
+}
+
 void Overlay::removeOverlayDir(InodeNumber inodeNumber) {
   IORequest req{this};
 
@@ -530,6 +641,34 @@ OverlayFile Overlay::createOverlayFile(
       weak_from_this());
 }
 
+OverlayFile Overlay::createOverlayFileFromBlob(
+    InodeNumber inodeNumber,
+    const ObjectId& blobId,
+    const folly::IOBuf& contents) {
+  IORequest req{this};
+  XCHECK_LT(inodeNumber.get(), nextInodeNumber_.load(std::memory_order_relaxed))
+      << "createOverlayFileFromBlob called with unallocated inode number";
+  XCHECK(fileContentStore_);
+  if (cloneMinimumSize_ &&
+      contents.computeChainDataLength() >= *cloneMinimumSize_) {
+    try {
+      // Object IDs can be long, key the blobs by a hash of their ID instead.
+      auto blobKey = Hash20::sha1(blobId.getBytes()).toString();
+      if (auto file = fileContentStore_->cloneOverlayFile(
+              inodeNumber, blobKey, contents)) {
+        return OverlayFile(std::move(*file), weak_from_this());
+      }
+    } catch (const std::exception& ex) {
+      // The blob cache is only an optimization, write the file instead.
+      XLOG(WARN) << "failed to clone overlay file for inode " << inodeNumber
+                 << " from blob " << blobId << ": " << ex.what();
+    }
+  }
+  return OverlayFile(
+      fileContentStore_->createOverlayFile(inodeNumber, contents),
+      weak_from_this());
+}
+
 #endif // !_WIN32
 
 InodeNumber Overlay::getMaxInodeNumber() {
@@ -617,6 +756,20 @@ void Overlay::handleGCRequest(GCRequest& request) {
   if (std::holds_alternative<GCRequest::MaintenanceRequest>(
           request.requestType)) {
     inodeCatalog_->maintenance();
+#ifndef _WIN32
+    if (inodeMetadataTable_) {
+      if (auto released = inodeMetadataTable_->compact(
+              metadataTableMaxUnusedFraction_)) {
+        XLOG(DBG2) << "released " << released
+                   << " bytes from the inode metadata table of " << localDir_;
+      }
+      if (metadataTableSync_) {
+        auto synced = inodeMetadataTable_->flush();
+        XLOG(DBG4) << "synced " << synced
+                   << " bytes of the inode metadata table of " << localDir_;
+      }
+    }
+#endif // !_WIN32
     return;
   }
 
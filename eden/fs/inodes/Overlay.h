@@ -14,11 +14,13 @@
 #include <array>
 #include <atomic>
 #include <condition_variable>
+#include <functional>
 #include <optional>
 #include <thread>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/fscatalog/OverlayChecker.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
+#include "eden/fs/model/ObjectId.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
 #include "eden/fs/utils/CaseSensitivity.h"
 #include "eden/fs/utils/DirType.h"
@@ -49,6 +51,7 @@ template <typename T>
 class InodeTable;
 using InodeMetadataTable = InodeTable<InodeMetadata>;
 class OverlayFile;
+class UnboundedQueueExecutor;
 #endif
 
 /** Manages the write overlay storage area.
@@ -79,6 +82,7 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
     TreeBuffered = 4,
     TreeInMemoryBuffered = 5,
     TreeSynchronousOffBuffered = 6,
+    Segment = 7,
   };
 
   /**
@@ -170,11 +174,14 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
    *   TreeInode::create() or TreeInode::mkdir().  In this case
    *   inodeCreated() should be called immediately afterwards to register the
    *   new child Inode object.
-   *
-   * TODO: It would be easy to extend this function to allocate a range of
-   * inode values in one atomic operation.
    */
   InodeNumber allocateInodeNumber();
+
+  /**
+   * Allocates `count` consecutive inode numbers in one atomic operation, and
+   * returns the first one. Same constraints as allocateInodeNumber().
+   */
+  InodeNumber allocateInodeNumbers(size_t count);
 #ifndef _WIN32
 
   /**
@@ -189,14 +196,42 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
 
   void saveOverlayDir(InodeNumber inodeNumber, const DirContents& dir);
 
+  using ObjectIdMigrator =
+      std::function<std::optional<ObjectId>(const ObjectId&)>;
+
+  /**
+   * Set the function used by loadOverlayDir to rewrite ObjectIds from a
+   * legacy encoding, see BackingStore::migrateObjectId. Directories with
+   * rewritten ObjectIds are saved back to the overlay.
+   *
+   * Must be called before the overlay is accessed.
+   */
+  void setObjectIdMigrator(ObjectIdMigrator migrator) {
+    objectIdMigrator_ = std::move(migrator);
+  }
+
   /*
    * Load content of the directory from overlay. If the directory does not
    * exist, this function will return an empty `DirContents`.
    */
   DirContents loadOverlayDir(InodeNumber inodeNumber);
 
+  /**
+   * Same as loadOverlayDir(), performed on the overlay I/O threads so that
+   * the caller, often a channel thread holding the parent's contents lock,
+   * doesn't wait on the disk. When overlay:io-threads is 0, the load happens
+   * inline and the returned future is ready.
+   */
+  ImmediateFuture<DirContents> loadOverlayDirAsync(InodeNumber inodeNumber);
+
   void removeOverlayFile(InodeNumber inodeNumber);
 
+  /**
+   * Same as calling removeOverlayFile() on each of the inodes, while freeing
+   * their metadata all at once.
+   */
+  void removeOverlayFiles(folly::Range<const InodeNumber*> inodeNumbers);
+
   void removeOverlayDir(InodeNumber inodeNumber);
 
   /**
@@ -244,6 +279,16 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents);
 
+  /**
+   * Same as createOverlayFile(), for a FileInode being materialized from the
+   * blob blobId. With overlay:clone-materialization, large blobs are cloned
+   * from a copy kept in the overlay when the filesystem supports it.
+   */
+  OverlayFile createOverlayFileFromBlob(
+      InodeNumber inodeNumber,
+      const ObjectId& blobId,
+      const folly::IOBuf& contents);
+
   /**
    * call statfs(2) on the filesystem in which the overlay is located
    */
@@ -373,6 +418,21 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
    * should be released first during shutdown.
    */
   std::unique_ptr<InodeMetadataTable> inodeMetadataTable_;
+
+  /**
+   * overlay:metadata-table-max-unused-fraction, for maintenance().
+   */
+  double metadataTableMaxUnusedFraction_;
+
+  /**
+   * overlay:metadata-table-sync, for maintenance() and close().
+   */
+  bool metadataTableSync_{false};
+
+  /**
+   * overlay:clone-minimum-size, when overlay:clone-materialization is set.
+   */
+  std::optional<size_t> cloneMinimumSize_;
 #endif // !_WIN32
 
   /**
@@ -390,6 +450,13 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
   folly::Synchronized<GCQueue, std::mutex> gcQueue_;
   std::condition_variable gcCondVar_;
 
+  /**
+   * Threads performing the reads of loadOverlayDirAsync(), null when
+   * overlay:io-threads is 0. Unbounded so that queuing a read never blocks a
+   * caller holding locks. Joined by close() before the overlay is closed.
+   */
+  std::unique_ptr<UnboundedQueueExecutor> ioExecutor_;
+
   /**
    * This uint64_t holds two values, a single bit on the MSB that
    * acts a boolean closed: True if the the Overlay has been closed with
@@ -407,6 +474,8 @@ class Overlay : public std::enable_shared_from_this<Overlay> {
 
   std::shared_ptr<StructuredLogger> structuredLogger_;
 
+  ObjectIdMigrator objectIdMigrator_;
+
   friend class IORequest;
 };
 
@@ -10,6 +10,7 @@
 #include "eden/fs/inodes/OverlayFile.h"
 
 #include <folly/FileUtil.h>
+#include <folly/portability/Fcntl.h>
 
 #include "eden/fs/inodes/Overlay.h"
 
@@ -47,6 +48,29 @@ OverlayFile::preadNoInt(void* buf, size_t n, off_t offset) const {
   return ret;
 }
 
+#ifdef __linux__
+folly::Expected<ssize_t, int>
+OverlayFile::splice(int pipeFd, size_t n, off_t offset) const {
+  std::shared_ptr<Overlay> overlay = overlay_.lock();
+  if (!overlay) {
+    return folly::makeUnexpected(EIO);
+  }
+  IORequest req{overlay.get()};
+
+  loff_t off = offset;
+  ssize_t ret;
+  do {
+    // The pipe is never waited on: the caller makes sure it has room for n
+    // bytes.
+    ret = ::splice(file_.fd(), &off, pipeFd, nullptr, n, SPLICE_F_NONBLOCK);
+  } while (ret == -1 && errno == EINTR);
+  if (ret == -1) {
+    return folly::makeUnexpected(errno);
+  }
+  return ret;
+}
+#endif
+
 folly::Expected<off_t, int> OverlayFile::lseek(off_t offset, int whence) const {
   std::shared_ptr<Overlay> overlay = overlay_.lock();
   if (!overlay) {
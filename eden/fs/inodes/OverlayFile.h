@@ -38,6 +38,14 @@ class OverlayFile {
   folly::Expected<int, int> fallocate(off_t offset, off_t length) const;
   folly::Expected<int, int> fdatasync() const;
   folly::Expected<std::string, int> readFile() const;
+#ifdef __linux__
+  /**
+   * Splices up to n bytes of the file from offset into the pipe, without
+   * copying them to userspace. Returns the number of bytes spliced, 0 at EOF.
+   */
+  folly::Expected<ssize_t, int> splice(int pipeFd, size_t n, off_t offset)
+      const;
+#endif
 
  private:
   OverlayFile(const OverlayFile&) = delete;
@@ -11,6 +11,7 @@
 
 #include <folly/Expected.h>
 #include <folly/Range.h>
+#include <folly/String.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/GFlags.h>
 #include <folly/portability/OpenSSL.h>
@@ -23,8 +24,13 @@
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/utils/Bug.h"
+#include "eden/fs/utils/FileHash.h"
 #include "folly/FileUtil.h"
 
+#include <algorithm>
+#include <memory>
+#include <utility>
+
 namespace facebook::eden {
 
 /*
@@ -41,14 +47,57 @@ void OverlayFileAccess::Entry::Info::invalidateMetadata() {
   sha1 = std::nullopt;
 }
 
+int OverlayFileAccess::Entry::flushLocked(WriteBuffer& buffer) const {
+  auto data = std::move(buffer.data);
+  buffer.data.clear();
+  size_t written = 0;
+  while (written < data.size()) {
+    iovec iov;
+    iov.iov_base = data.data() + written;
+    iov.iov_len = data.size() - written;
+    auto xfer = file.pwritev(
+        &iov,
+        1,
+        buffer.offset + written + FileContentStore::kHeaderLength);
+    if (xfer.hasError()) {
+      XLOG(ERR) << "failed to write back " << data.size() - written
+                << " buffered bytes to overlay file: "
+                << folly::errnoStr(xfer.error());
+      buffer.error = xfer.error();
+      return xfer.error();
+    }
+    written += xfer.value();
+  }
+  return 0;
+}
+
 OverlayFileAccess::State::State(size_t cacheSize) : entries{cacheSize} {
   if (cacheSize == 0) {
     throw std::range_error{"overlayFileCacheSize must be at least 1"};
   }
+  entries.setPruneHook([this](InodeNumber ino, EntryPtr&& entry) {
+    onEvict(ino, std::move(entry));
+  });
 }
 
-OverlayFileAccess::OverlayFileAccess(Overlay* overlay)
-    : overlay_{overlay}, state_{folly::in_place, FLAGS_overlayFileCacheSize} {}
+void OverlayFileAccess::State::onEvict(InodeNumber ino, EntryPtr&& entry) {
+  // This is IO with the state lock held, but only for the evicted files that
+  // have buffered writes, which are bounded by the buffer size.
+  auto buffer = entry->writeBuffer.lock();
+  entry->flushLocked(*buffer);
+  if (buffer->error != 0) {
+    deferredWriteErrors[ino] = buffer->error;
+  }
+}
+
+OverlayFileAccess::OverlayFileAccess(
+    Overlay* overlay,
+    size_t writeBufferSize,
+    std::chrono::nanoseconds writeBufferMaxDelay)
+    : overlay_{overlay},
+      writeBufferSize_{writeBufferSize},
+      writeBufferMaxDelay_{writeBufferMaxDelay},
+      state_{folly::in_place, FLAGS_overlayFileCacheSize} {}
 
 OverlayFileAccess::~OverlayFileAccess() = default;
 
@@ -63,9 +112,11 @@ void OverlayFileAccess::createEmptyFile(InodeNumber ino) {
 
 void OverlayFileAccess::createFile(
     InodeNumber ino,
+    const ObjectId& blobId,
     const Blob& blob,
     const std::optional<Hash20>& sha1) {
-  auto file = overlay_->createOverlayFile(ino, blob.getContents());
+  auto file =
+      overlay_->createOverlayFileFromBlob(ino, blobId, blob.getContents());
   auto state = state_.wlock();
   XCHECK(!state->entries.exists(ino))
       << "Cannot create overlay file " << ino << " when it's already open!";
@@ -90,6 +141,15 @@ off_t OverlayFileAccess::getFileSize(InodeNumber ino, InodeBase* inode) {
 
   // Size is not known, so fstat the file. Do so while the lock is not held to
   // improve concurrency.
+  {
+    auto buffer = entry->writeBuffer.lock();
+    if (auto error = entry->flushLocked(*buffer)) {
+      throw InodeError(
+          error,
+          inode ? inode->inodePtrFromThis() : InodePtr{},
+          "unable to write back buffered writes to overlay file");
+    }
+  }
   auto ret = entry->file.fstat();
   if (ret.hasError()) {
     throw InodeError(
@@ -121,7 +181,11 @@ off_t OverlayFileAccess::getFileSize(InodeNumber ino, InodeBase* inode) {
 }
 
 Hash20 OverlayFileAccess::getSha1(FileInode& inode) {
-  auto entry = getEntryForInode(inode.getNodeId());
+  return getSha1(inode.getNodeId(), &inode);
+}
+
+Hash20 OverlayFileAccess::getSha1(InodeNumber ino, InodeBase* inode) {
+  auto entry = getEntryForInode(ino);
   uint64_t version;
   {
     auto info = entry->info.rlock();
@@ -133,6 +197,16 @@ Hash20 OverlayFileAccess::getSha1(FileInode& inode) {
 
   // SHA-1 is not known, so recompute it. Do so while the lock is not held to
   // improve concurrency.
+  flushBufferedWrites(inode, *entry);
+
+  // Sized from the file so that most files are hashed from a single read,
+  // and large ones from 1MB reads rather than many small ones.
+  auto st = entry->file.fstat();
+  auto contentSize = st.hasValue()
+      ? st.value().st_size - static_cast<off_t>(FileContentStore::kHeaderLength)
+      : 0;
+  auto bufSize = getFileHashBufferSize(std::max<off_t>(contentSize, 0));
+  std::unique_ptr<uint8_t[]> buf{new uint8_t[bufSize]};
 
   SHA_CTX ctx;
   SHA1_Init(&ctx);
@@ -144,19 +218,18 @@ Hash20 OverlayFileAccess::getSha1(FileInode& inode) {
     // and while we serialize the requests to FileData, it seems
     // like a good property of this function to avoid changing that
     // state.
-    uint8_t buf[8192];
-    auto ret = entry->file.preadNoInt(&buf, sizeof(buf), off);
+    auto ret = entry->file.preadNoInt(buf.get(), bufSize, off);
     if (ret.hasError()) {
       throw InodeError(
           ret.error(),
-          inode.inodePtrFromThis(),
+          inode ? inode->inodePtrFromThis() : InodePtr{},
           "pread failed during SHA-1 calculation");
     }
     auto len = ret.value();
     if (len == 0) {
       break;
     }
-    SHA1_Update(&ctx, buf, len);
+    SHA1_Update(&ctx, buf.get(), len);
     off += len;
   }
 
@@ -184,6 +257,7 @@ std::string OverlayFileAccess::readAllContents(FileInode& inode) {
   // must read.
   //
   // TODO: implement readFile with pread instead of lseek.
+  flushBufferedWrites(&inode, *entry);
   auto info = entry->info.wlock();
 
   auto rc = entry->file.lseek(FileContentStore::kHeaderLength, SEEK_SET);
@@ -206,6 +280,7 @@ std::string OverlayFileAccess::readAllContents(FileInode& inode) {
 
 BufVec OverlayFileAccess::read(FileInode& inode, size_t size, off_t off) {
   auto entry = getEntryForInode(inode.getNodeId());
+  flushBufferedWrites(&inode, *entry);
 
   auto buf = folly::IOBuf::createCombined(size);
   auto res = entry->file.preadNoInt(
@@ -222,6 +297,36 @@ BufVec OverlayFileAccess::read(FileInode& inode, size_t size, off_t off) {
   return BufVec{std::move(buf)};
 }
 
+#ifdef __linux__
+size_t OverlayFileAccess::splice(
+    FileInode& inode,
+    size_t size,
+    off_t off,
+    int pipeFd) {
+  auto entry = getEntryForInode(inode.getNodeId());
+  flushBufferedWrites(&inode, *entry);
+
+  size_t spliced = 0;
+  while (spliced < size) {
+    auto res = entry->file.splice(
+        pipeFd,
+        size - spliced,
+        off + spliced + FileContentStore::kHeaderLength);
+    if (res.hasError()) {
+      throw InodeError(
+          res.error(),
+          inode.inodePtrFromThis(),
+          "splice failed during overlay file read");
+    }
+    if (res.value() == 0) {
+      break;
+    }
+    spliced += res.value();
+  }
+  return spliced;
+}
+#endif
+
 size_t OverlayFileAccess::write(
     FileInode& inode,
     const struct iovec* iov,
@@ -229,6 +334,45 @@ size_t OverlayFileAccess::write(
     off_t off) {
   auto entry = getEntryForInode(inode.getNodeId());
 
+  size_t size = 0;
+  for (size_t i = 0; i < iovcnt; ++i) {
+    size += iov[i].iov_len;
+  }
+  if (size < writeBufferSize_) {
+    auto now = std::chrono::steady_clock::now();
+    auto buffer = entry->writeBuffer.lock();
+    bool sequential = !buffer->data.empty() &&
+        off == buffer->offset + static_cast<off_t>(buffer->data.size());
+    if (!sequential || buffer->data.size() + size > writeBufferSize_) {
+      if (auto error = entry->flushLocked(*buffer)) {
+        throw InodeError(
+            error,
+            inode.inodePtrFromThis(),
+            "unable to write back buffered writes to overlay file");
+      }
+    }
+    if (buffer->data.empty()) {
+      buffer->offset = off;
+      buffer->firstWriteTime = now;
+    }
+    buffer->data.reserve(writeBufferSize_);
+    for (size_t i = 0; i < iovcnt; ++i) {
+      buffer->data.append(
+          static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    }
+    if (buffer->data.size() >= writeBufferSize_ ||
+        now - buffer->firstWriteTime >= writeBufferMaxDelay_) {
+      // The error, if any, is reported by the next fsync().
+      entry->flushLocked(*buffer);
+    }
+    buffer.unlock();
+
+    entry->info.wlock()->invalidateMetadata();
+    return size;
+  }
+
+  // Larger writes go straight to the file, after the buffered ones.
+  flushBufferedWrites(&inode, *entry);
   auto xfer =
       entry->file.pwritev(iov, iovcnt, off + FileContentStore::kHeaderLength);
   if (xfer.hasError()) {
@@ -245,6 +389,7 @@ size_t OverlayFileAccess::write(
 
 void OverlayFileAccess::truncate(FileInode& inode, off_t size) {
   auto entry = getEntryForInode(inode.getNodeId());
+  flushBufferedWrites(&inode, *entry);
   auto result = entry->file.ftruncate(size + FileContentStore::kHeaderLength);
   if (result.hasError()) {
     throw InodeError(
@@ -262,6 +407,16 @@ void OverlayFileAccess::fsync(FileInode& inode, bool datasync) {
   // That said, close() does not ensure data is synced, so it's safest to
   // reopen.
   auto entry = getEntryForInode(inode.getNodeId());
+  {
+    auto buffer = entry->writeBuffer.lock();
+    entry->flushLocked(*buffer);
+    if (auto error = std::exchange(buffer->error, 0)) {
+      throw InodeError(
+          error,
+          inode.inodePtrFromThis(),
+          "unable to write back buffered writes to overlay file");
+    }
+  }
   auto result = datasync ? entry->file.fdatasync() : entry->file.fsync();
   if (result.hasError()) {
     throw InodeError(
@@ -276,6 +431,7 @@ void OverlayFileAccess::fallocate(
     uint64_t offset,
     uint64_t length) {
   auto entry = getEntryForInode(inode.getNodeId());
+  flushBufferedWrites(&inode, *entry);
   auto result =
       entry->file.fallocate(offset, length + FileContentStore::kHeaderLength);
   if (result.hasError()) {
@@ -305,12 +461,65 @@ OverlayFileAccess::EntryPtr OverlayFileAccess::getEntryForInode(
 
   {
     auto state = state_.wlock();
+    auto error = state->deferredWriteErrors.find(ino);
+    if (error != state->deferredWriteErrors.end()) {
+      entry->writeBuffer.lock()->error = error->second;
+      state->deferredWriteErrors.erase(error);
+    }
     state->entries.set(ino, entry);
   }
 
   return entry;
 }
 
+void OverlayFileAccess::flushBufferedWrites(InodeBase* inode, Entry& entry) {
+  auto buffer = entry.writeBuffer.lock();
+  if (auto error = entry.flushLocked(*buffer)) {
+    throw InodeError(
+        error,
+        inode ? inode->inodePtrFromThis() : InodePtr{},
+        "unable to write back buffered writes to overlay file");
+  }
+}
+
+void OverlayFileAccess::closeFile(InodeNumber ino) {
+  EntryPtr entry;
+  {
+    auto state = state_.wlock();
+    state->deferredWriteErrors.erase(ino);
+    auto iter = state->entries.find(ino);
+    if (iter == state->entries.end()) {
+      return;
+    }
+    entry = iter->second;
+    state->entries.erase(ino);
+  }
+  flushBufferedWrites(nullptr, *entry);
+}
+
+void OverlayFileAccess::flushBufferedWrites(std::chrono::nanoseconds minAge) {
+  if (writeBufferSize_ == 0) {
+    return;
+  }
+  std::vector<EntryPtr> entries;
+  {
+    auto state = state_.wlock();
+    entries.reserve(state->entries.size());
+    for (const auto& [ino, entry] : state->entries) {
+      entries.push_back(entry);
+    }
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  for (const auto& entry : entries) {
+    auto buffer = entry->writeBuffer.lock();
+    if (!buffer->data.empty() && now - buffer->firstWriteTime >= minAge) {
+      // The error, if any, is reported by the next fsync().
+      entry->flushLocked(*buffer);
+    }
+  }
+}
+
 } // namespace facebook::eden
 
 #endif
@@ -10,7 +10,11 @@
 #include <folly/File.h>
 #include <folly/Synchronized.h>
 #include <folly/container/EvictingCacheMap.h>
+#include <folly/container/F14Map.h>
+#include <chrono>
 #include <memory>
+#include <mutex>
+#include <string>
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/InodePtr.h"
 #include "eden/fs/inodes/OverlayFile.h"
@@ -21,16 +25,29 @@ namespace facebook::eden {
 
 class Blob;
 class FileInode;
+class ObjectId;
 class Overlay;
 
 /**
  * Provides a file handle caching layer between FileInode and the Overlay. Read
  * and write operations for different inodes can be interleaved, and the
  * OverlayFileAccess will keep a number of file handles open in LRU.
+ *
+ * When writeBufferSize is not 0, small writes are not written to the overlay
+ * file right away: sequential writes are coalesced in memory, up to
+ * writeBufferSize bytes per open file, and written back as one pwrite. The
+ * buffer of a file is written back before any other operation on the file,
+ * when a non-sequential write comes in, when the file is evicted from the LRU,
+ * on flushBufferedWrites(), and by the first write coming more than
+ * writeBufferMaxDelay after the buffered ones. As with the page cache, errors
+ * writing back buffered data are reported by the next fsync().
  */
 class OverlayFileAccess {
  public:
-  explicit OverlayFileAccess(Overlay* overlay);
+  explicit OverlayFileAccess(
+      Overlay* overlay,
+      size_t writeBufferSize = 0,
+      std::chrono::nanoseconds writeBufferMaxDelay = std::chrono::seconds{1});
   ~OverlayFileAccess();
 
   /**
@@ -44,7 +61,7 @@ class OverlayFileAccess {
 
   /**
    * Creates a new file in the overlay populated with the contents of the given
-   * blob. If a sha1 is given, it is cached in memory.
+   * blob, identified by blobId. If a sha1 is given, it is cached in memory.
    *
    * The caller must verify the overlay file does not already exist. Calls to
    * any other OverlayFileAccess functions for this inode must occur after
@@ -52,6 +69,7 @@ class OverlayFileAccess {
    */
   void createFile(
       InodeNumber ino,
+      const ObjectId& blobId,
       const Blob& blob,
       const std::optional<Hash20>& sha1);
 
@@ -69,6 +87,15 @@ class OverlayFileAccess {
    * Returns the SHA-1 hash of the file contents for the given inode number.
    */
   Hash20 getSha1(FileInode& inode);
+  Hash20 getSha1(InodeNumber ino, InodeBase* inode);
+
+  /**
+   * Write back the buffered writes to the file of the given inode and close
+   * it, if it is open. Called before removing the overlay file of an inode
+   * that keeps its number, so that a later createFile() for it doesn't find
+   * the old file open.
+   */
+  void closeFile(InodeNumber ino);
 
   /**
    * Reads the entire file's contents into memory and returns it.
@@ -81,6 +108,15 @@ class OverlayFileAccess {
    */
   BufVec read(FileInode& inode, size_t size, off_t off);
 
+#ifdef __linux__
+  /**
+   * Like read(), but splices the range into the pipe instead of copying it.
+   * Returns the number of bytes spliced, fewer than size only at EOF. The pipe
+   * must have room for size bytes.
+   */
+  size_t splice(FileInode& inode, size_t size, off_t off, int pipeFd);
+#endif
+
   /**
    * Writes data into the file at the specified offset. Returns the number of
    * bytes written.
@@ -104,6 +140,14 @@ class OverlayFileAccess {
    */
   void fallocate(FileInode& inode, uint64_t offset, uint64_t size);
 
+  /**
+   * Write back the buffered writes of all the open files that were buffered
+   * at least minAge ago. Called periodically so that buffered data doesn't
+   * linger in memory, and before closing the overlay.
+   */
+  void flushBufferedWrites(
+      std::chrono::nanoseconds minAge = std::chrono::nanoseconds{0});
+
  private:
   /*
    * OverlayFileAccess can be accessed concurrently. There are two types of data
@@ -142,8 +186,28 @@ class OverlayFileAccess {
       uint64_t version{0};
     };
 
+    /**
+     * Coalesced sequential writes not yet written to the file.
+     */
+    struct WriteBuffer {
+      // Offset in the file, excluding the header, of the first buffered byte.
+      off_t offset{0};
+      std::string data;
+      std::chrono::steady_clock::time_point firstWriteTime;
+      // errno of a failed write back, to be reported by the next fsync().
+      int error{0};
+    };
+
+    /**
+     * Write the buffered data to the file and empty the buffer, even if the
+     * write fails. Returns 0 or the errno of the failure, which is also
+     * recorded in buffer.error.
+     */
+    int flushLocked(WriteBuffer& buffer) const;
+
     const OverlayFile file;
     folly::Synchronized<Info> info;
+    folly::Synchronized<WriteBuffer, std::mutex> writeBuffer;
   };
 
   using EntryPtr = std::shared_ptr<Entry>;
@@ -151,7 +215,18 @@ class OverlayFileAccess {
   struct State {
     explicit State(size_t cacheSize);
 
+    /**
+     * Called with the state locked when an entry is evicted from the LRU.
+     * Its buffered writes are written back before the lock is released, so
+     * that they can't land after the writes made through a reopened entry.
+     */
+    void onEvict(InodeNumber ino, EntryPtr&& entry);
+
     folly::EvictingCacheMap<InodeNumber, EntryPtr> entries;
+
+    // Write back errors of evicted entries, handed to the entry that is
+    // reopened for the inode.
+    folly::F14FastMap<InodeNumber, int> deferredWriteErrors;
   };
 
   using LockedStatePtr = folly::Synchronized<State>::LockedPtr;
@@ -162,7 +237,15 @@ class OverlayFileAccess {
    */
   EntryPtr getEntryForInode(InodeNumber);
 
+  /**
+   * Write back the buffered writes of entry before performing another
+   * operation on its file. Throws if the write back fails.
+   */
+  void flushBufferedWrites(InodeBase* inode, Entry& entry);
+
   Overlay* overlay_ = nullptr;
+  const size_t writeBufferSize_;
+  const std::chrono::nanoseconds writeBufferMaxDelay_;
   folly::Synchronized<State> state_;
 };
 
@@ -657,17 +657,38 @@ ImmediateFuture<folly::Unit> fileNotificationImpl(
       });
 }
 
-ImmediateFuture<folly::Unit> fileNotification(
-    EdenMount& mount,
+} // namespace
+
+ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileNotification(
     RelativePath path,
-    folly::Executor::KeepAlive<folly::SequencedExecutor> executor,
     const ObjectFetchContextPtr& context) {
   auto receivedAt = std::chrono::steady_clock::now();
+  {
+    auto pending = pendingNotifications_.wlock();
+    auto [it, inserted] = pending->try_emplace(path, receivedAt);
+    if (!inserted) {
+      it->second = receivedAt;
+      mount_->getStats()->increment(&PrjfsStats::coalescedFileNotification);
+      return folly::unit;
+    }
+  }
   folly::stop_watch<std::chrono::milliseconds> watch;
 
   folly::via(
-      executor,
-      [&mount, path, receivedAt, context = context.copy(), watch]() mutable {
+      notificationExecutor_,
+      [this,
+       &mount = *mount_,
+       path,
+       context = context.copy(),
+       watch]() mutable {
+        std::chrono::steady_clock::time_point receivedAt;
+        {
+          auto pending = pendingNotifications_.wlock();
+          auto it = pending->find(path);
+          receivedAt = it->second;
+          pending->erase(it);
+        }
+
         auto fault = ImmediateFuture{
             mount.getServerState()->getFaultInjector().checkAsync(
                 "PrjfsDispatcherImpl::fileNotification", path)};
@@ -696,27 +717,22 @@ ImmediateFuture<folly::Unit> fileNotification(
   return folly::unit;
 }
 
-} // namespace
-
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileCreated(
     RelativePath path,
     const ObjectFetchContextPtr& context) {
-  return fileNotification(
-      *mount_, std::move(path), notificationExecutor_, context);
+  return fileNotification(std::move(path), context);
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::dirCreated(
     RelativePath path,
     const ObjectFetchContextPtr& context) {
-  return fileNotification(
-      *mount_, std::move(path), notificationExecutor_, context);
+  return fileNotification(std::move(path), context);
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileModified(
     RelativePath path,
     const ObjectFetchContextPtr& context) {
-  return fileNotification(
-      *mount_, std::move(path), notificationExecutor_, context);
+  return fileNotification(std::move(path), context);
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileRenamed(
@@ -725,10 +741,8 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileRenamed(
     const ObjectFetchContextPtr& context) {
   // A rename is just handled like 2 notifications separate notifications on
   // the old and new paths.
-  auto oldNotification = fileNotification(
-      *mount_, std::move(oldPath), notificationExecutor_, context);
-  auto newNotification = fileNotification(
-      *mount_, std::move(newPath), notificationExecutor_, context);
+  auto oldNotification = fileNotification(std::move(oldPath), context);
+  auto newNotification = fileNotification(std::move(newPath), context);
 
   return collectAllSafe(std::move(oldNotification), std::move(newNotification))
       .thenValue(
@@ -768,8 +782,7 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preDirRename(
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::fileDeleted(
     RelativePath path,
     const ObjectFetchContextPtr& context) {
-  return fileNotification(
-      *mount_, std::move(path), notificationExecutor_, context);
+  return fileNotification(std::move(path), context);
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preFileDelete(
@@ -785,8 +798,7 @@ ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preFileDelete(
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::dirDeleted(
     RelativePath path,
     const ObjectFetchContextPtr& context) {
-  return fileNotification(
-      *mount_, std::move(path), notificationExecutor_, context);
+  return fileNotification(std::move(path), context);
 }
 
 ImmediateFuture<folly::Unit> PrjfsDispatcherImpl::preDirDelete(
@@ -7,7 +7,10 @@
 
 #pragma once
 
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
 #include <folly/executors/SequencedExecutor.h>
+#include <chrono>
 #include "eden/fs/prjfs/PrjfsDispatcher.h"
 #include "eden/fs/service/gen-cpp2/eden_types.h"
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
@@ -82,9 +85,26 @@ class PrjfsDispatcherImpl : public PrjfsDispatcher {
   ImmediateFuture<folly::Unit> waitForPendingNotifications() override;
 
  private:
+  /**
+   * Queue the handling of a notification about path on
+   * notificationExecutor_, unless one is already queued.
+   */
+  ImmediateFuture<folly::Unit> fileNotification(
+      RelativePath path,
+      const ObjectFetchContextPtr& context);
+
   // The EdenMount associated with this dispatcher.
   EdenMount* const mount_;
 
+  // The paths whose notifications are queued and not being handled yet, with
+  // the time the last of their notifications was received. Since a handled
+  // notification looks at the current state of the path on disk, it is also
+  // the handling of the notifications about the path received while it was
+  // queued.
+  folly::Synchronized<
+      folly::F14NodeMap<RelativePath, std::chrono::steady_clock::time_point>>
+      pendingNotifications_;
+
   UnboundedQueueExecutor executor_;
   // All the notifications are dispatched to this executor. The
   // waitForPendingNotifications implementation depends on this being a
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/ReadAheadTracker.h"
+
+#include <folly/hash/Hash.h>
+#include <algorithm>
+
+namespace facebook::eden {
+
+template <typename Fn>
+auto ReadAheadTracker::withProcess(std::optional<pid_t> pid, Fn&& fn) {
+  auto key = pid.value_or(0);
+  auto& shard =
+      shards_[folly::hash::twang_mix64(static_cast<uint64_t>(key)) %
+              kShardCount];
+  auto processes = shard.processes.lock();
+  auto it = processes->find(key);
+  if (it == processes->end()) {
+    processes->set(key, Process{});
+    it = processes->find(key);
+  }
+  return fn(it->second);
+}
+
+ReadAheadTracker::Range ReadAheadTracker::recordRead(
+    std::optional<pid_t> pid,
+    InodeNumber ino,
+    uint64_t offset,
+    uint64_t size,
+    uint64_t fileSize,
+    uint64_t maxWindow) {
+  return withProcess(pid, [&](Process& process) -> Range {
+    auto end = offset + size;
+    bool sequential = process.file == ino && offset == process.nextOffset;
+    if (!sequential) {
+      process.file = ino;
+      process.window = 0;
+      process.readAheadEnd = 0;
+    }
+    process.nextOffset = end;
+    if (!sequential || maxWindow == 0 || size == 0 || end >= fileSize) {
+      return {};
+    }
+
+    if (process.window == 0) {
+      process.window = std::min(
+          maxWindow, std::max(kMinWindow, kInitialWindowReads * size));
+    }
+    // Read ahead again once the reads got within half a window of the end of
+    // the previous read ahead.
+    if (process.readAheadEnd > end + process.window / 2) {
+      return {};
+    }
+
+    auto start = std::max(end, process.readAheadEnd);
+    if (start >= fileSize) {
+      return {};
+    }
+    Range range{start, std::min(process.window, fileSize - start)};
+    process.readAheadEnd = start + range.length;
+    process.window = std::min(process.window * 2, maxWindow);
+    return range;
+  });
+}
+
+ReadAheadTracker::Files ReadAheadTracker::recordFileStart(
+    std::optional<pid_t> pid,
+    InodeNumber dir,
+    InodeNumber ino,
+    std::optional<InodeNumber> previous,
+    size_t maxFiles) {
+  return withProcess(pid, [&](Process& process) -> Files {
+    if (process.dir == dir && process.lastFile == ino) {
+      // The same file read from its start again.
+      return {};
+    }
+    if (process.dir == dir && previous && *previous == process.lastFile) {
+      ++process.fileRun;
+    } else {
+      process.fileRun = 1;
+    }
+    process.dir = dir;
+    process.lastFile = ino;
+
+    if (maxFiles == 0 || process.fileRun < kMinFileRun) {
+      return {};
+    }
+    if (process.fileRun == kMinFileRun) {
+      return {0, maxFiles};
+    }
+    // The previous files were prefetched when the run was detected.
+    return {maxFiles - 1, 1};
+  });
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/portability/SysTypes.h>
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+
+#include "eden/fs/inodes/InodeNumber.h"
+
+namespace facebook::eden {
+
+/**
+ * Detects the processes reading unmaterialized files in a predictable order,
+ * and tells FileInode what they will likely read next, so that it is fetched
+ * before they ask for it.
+ *
+ * Two patterns are recognized per process:
+ *
+ * - Sequential reads of a file, as done by archive tools or anything
+ *   streaming a file. Once a read starts where the previous one of the
+ *   process ended, the bytes that follow are read ahead. As with the kernel
+ *   page cache, the window starts at a few reads and doubles every time the
+ *   reads catch up with half of it, up to a maximum.
+ *
+ * - Files of a directory read one after the other in directory order, as
+ *   done by linkers, compilers of a whole directory, or `tar`. Once a process
+ *   started reading two consecutive files, the files that follow are
+ *   prefetched, and then one more every time it starts the next one.
+ *
+ * Each process is tracked as a single stream: processes reading several
+ * files at once mostly don't match either pattern. Requests without a client
+ * pid, e.g. over NFS, are accounted as a single process.
+ *
+ * Thread-safe.
+ */
+class ReadAheadTracker {
+ public:
+  ReadAheadTracker() = default;
+
+  struct Range {
+    uint64_t offset = 0;
+    uint64_t length = 0;
+  };
+
+  /**
+   * Record that the process pid read size bytes at offset of the file ino,
+   * which has fileSize bytes. Returns the range to read ahead, of at most
+   * maxWindow bytes, or an empty range.
+   */
+  Range recordRead(
+      std::optional<pid_t> pid,
+      InodeNumber ino,
+      uint64_t offset,
+      uint64_t size,
+      uint64_t fileSize,
+      uint64_t maxWindow);
+
+  /**
+   * The files to prefetch among the ones that follow a file in its
+   * directory, 0 being the one right after it.
+   */
+  struct Files {
+    size_t first = 0;
+    size_t count = 0;
+  };
+
+  /**
+   * Record that the process pid started reading the file ino of the directory
+   * dir, previous being the file before it in that directory, if any.
+   * Returns which of the following files to prefetch, so that maxFiles files
+   * ahead are prefetched.
+   */
+  Files recordFileStart(
+      std::optional<pid_t> pid,
+      InodeNumber dir,
+      InodeNumber ino,
+      std::optional<InodeNumber> previous,
+      size_t maxFiles);
+
+  /**
+   * The first read ahead window is this many reads, and at least
+   * kMinWindow bytes.
+   */
+  static constexpr uint64_t kInitialWindowReads = 4;
+  static constexpr uint64_t kMinWindow = 256 * 1024;
+
+  /**
+   * Number of consecutive files of a directory a process must start reading
+   * in order before the next ones are prefetched.
+   */
+  static constexpr size_t kMinFileRun = 2;
+
+  /**
+   * Number of processes remembered, per shard.
+   */
+  static constexpr size_t kProcessesPerShard = 64;
+
+ private:
+  struct Process {
+    // The file read sequentially, and where its next read is expected.
+    InodeNumber file;
+    uint64_t nextOffset = 0;
+    // The size of the next read ahead, 0 until the reads are sequential.
+    uint64_t window = 0;
+    // The end of what was read ahead.
+    uint64_t readAheadEnd = 0;
+
+    // The directory whose files are read in order, the last one started, and
+    // how many were started in order.
+    InodeNumber dir;
+    InodeNumber lastFile;
+    size_t fileRun = 0;
+  };
+
+  using Processes = folly::EvictingCacheMap<pid_t, Process>;
+
+  struct Shard {
+    folly::Synchronized<Processes, std::mutex> processes{
+        std::in_place, kProcessesPerShard};
+  };
+
+  static constexpr size_t kShardCount = 16;
+
+  /**
+   * Calls fn with the state of the process pid, under the lock of its shard.
+   */
+  template <typename Fn>
+  auto withProcess(std::optional<pid_t> pid, Fn&& fn);
+
+  std::array<Shard, kShardCount> shards_;
+};
+
+} // namespace facebook::eden
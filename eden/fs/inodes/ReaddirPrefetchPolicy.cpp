@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/ReaddirPrefetchPolicy.h"
+
+#include <folly/hash/Hash.h>
+#include <algorithm>
+
+namespace facebook::eden {
+
+namespace {
+// Weight of a new sample in the average prefetch duration.
+constexpr int64_t kDurationWeightShift = 3;
+} // namespace
+
+ReaddirPrefetchPolicy::Listing* ReaddirPrefetchPolicy::Process::find(
+    InodeNumber dir) {
+  for (size_t i = 0; i < count; ++i) {
+    if (listings[i].dir == dir) {
+      return &listings[i];
+    }
+  }
+  return nullptr;
+}
+
+ReaddirPrefetchPolicy::Listing& ReaddirPrefetchPolicy::Process::add(
+    InodeNumber dir) {
+  auto& listing = listings[next];
+  listing = Listing{dir};
+  next = (next + 1) % kListingsPerProcess;
+  count = std::min(count + 1, kListingsPerProcess);
+  return listing;
+}
+
+ReaddirPrefetchPolicy::Shard& ReaddirPrefetchPolicy::getShard(pid_t pid) {
+  return shards_
+      [folly::hash::twang_mix64(static_cast<uint64_t>(pid)) % kShardCount];
+}
+
+bool ReaddirPrefetchPolicy::recordListing(
+    std::optional<pid_t> pid,
+    InodeNumber dir,
+    bool adaptive) {
+  auto key = pid.value_or(0);
+  auto processes = getShard(key).processes.lock();
+  auto it = processes->find(key);
+  if (it == processes->end()) {
+    processes->set(key, Process{});
+    it = processes->find(key);
+  }
+  auto& process = it->second;
+
+  if (auto* listing = process.find(dir)) {
+    // Listed again, e.g. the next readdir of a skipped listing, or a listing
+    // whose prefetch was throttled.
+    return !adaptive || listing->lookedUp;
+  }
+
+  bool prefetch = true;
+  if (adaptive && process.count >= kMinListings) {
+    auto lookedUp = std::count_if(
+        process.listings.begin(),
+        process.listings.begin() + process.count,
+        [](const Listing& listing) { return listing.lookedUp; });
+    prefetch = lookedUp >= kMinLookupRate * process.count;
+  }
+  process.add(dir);
+  return prefetch;
+}
+
+void ReaddirPrefetchPolicy::recordPrefetch(
+    std::optional<pid_t> pid,
+    InodeNumber dir) {
+  auto key = pid.value_or(0);
+  auto processes = getShard(key).processes.lock();
+  auto it = processes->findWithoutPromotion(key);
+  if (it == processes->end()) {
+    return;
+  }
+  if (auto* listing = it->second.find(dir)) {
+    // The lookups that follow are attributed to the prefetched listing.
+    listing->prefetched = true;
+    listing->lookedUp = false;
+  }
+}
+
+ReaddirPrefetchPolicy::LookupResult ReaddirPrefetchPolicy::recordLookup(
+    std::optional<pid_t> pid,
+    InodeNumber dir) {
+  auto key = pid.value_or(0);
+  auto processes = getShard(key).processes.lock();
+  auto it = processes->findWithoutPromotion(key);
+  if (it == processes->end()) {
+    return LookupResult::Untracked;
+  }
+  auto* listing = it->second.find(dir);
+  if (!listing || listing->lookedUp) {
+    return LookupResult::Untracked;
+  }
+  listing->lookedUp = true;
+  return listing->prefetched ? LookupResult::Hit : LookupResult::Miss;
+}
+
+void ReaddirPrefetchPolicy::recordPrefetchDuration(Clock::duration duration) {
+  auto sample =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+  // Concurrent updates may lose a sample, which doesn't matter for an
+  // average.
+  auto average = averageDuration_.load(std::memory_order_relaxed);
+  if (average == 0) {
+    average = sample;
+  } else {
+    average += (sample - average) >> kDurationWeightShift;
+  }
+  averageDuration_.store(average, std::memory_order_relaxed);
+}
+
+uint64_t ReaddirPrefetchPolicy::getMaxPrefetches(
+    uint64_t maxPrefetches,
+    uint64_t maxAdaptivePrefetches,
+    std::chrono::nanoseconds referenceLatency) const {
+  auto average = getAveragePrefetchDuration();
+  if (maxPrefetches == 0 || referenceLatency.count() <= 0 ||
+      average <= referenceLatency) {
+    return maxPrefetches;
+  }
+  auto scaled = static_cast<double>(maxPrefetches) * average.count() /
+      referenceLatency.count();
+  return std::clamp<uint64_t>(
+      static_cast<uint64_t>(scaled),
+      maxPrefetches,
+      std::max(maxPrefetches, maxAdaptivePrefetches));
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/portability/SysTypes.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+
+#include "eden/fs/inodes/InodeNumber.h"
+
+namespace facebook::eden {
+
+/**
+ * Decides whether the first readdir of a directory prefetches the trees and
+ * blob metadata of its children, and how many of these prefetches may run at
+ * once, from how the processes used the previous prefetches.
+ *
+ * Prefetching pays off for `ls -l` or `find -ls`, which stat every entry they
+ * list, and is wasted on `find` or a shell completion, which only read the
+ * names. So the recent listings of each process are remembered, with whether
+ * the process then looked up a child of the listed directory. A directory is
+ * prefetched when its own previous listing by the same process led to
+ * lookups, or for a directory not listed recently, when most of the recent
+ * listings of the process did. Processes with too few listings to tell are
+ * prefetched for. Requests without a client pid, e.g. over NFS, are accounted
+ * as a single process.
+ *
+ * The prefetches of a directory fetch its children in parallel, and thus
+ * take about one round trip to the backing store. The number of prefetches
+ * in flight needed to keep up with a stream of listings grows with that
+ * latency, so the limit scales with the average duration of the prefetches.
+ *
+ * Thread-safe.
+ */
+class ReaddirPrefetchPolicy {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  ReaddirPrefetchPolicy() = default;
+
+  /**
+   * Record that the process pid listed the directory dir, whose children are
+   * not prefetched yet. Returns whether to prefetch them. When adaptive is
+   * false the listing is only recorded, for the hit ratio, and the answer is
+   * always yes.
+   */
+  bool recordListing(std::optional<pid_t> pid, InodeNumber dir, bool adaptive);
+
+  /**
+   * Record that the children of the listing of dir by pid were prefetched.
+   */
+  void recordPrefetch(std::optional<pid_t> pid, InodeNumber dir);
+
+  enum class LookupResult {
+    // Not the first lookup that follows a recent listing of dir by pid.
+    Untracked,
+    // The first lookup after a listing whose children were prefetched.
+    Hit,
+    // The first lookup after a listing whose children weren't prefetched.
+    Miss,
+  };
+
+  /**
+   * Record that the process pid looked up a child of dir.
+   */
+  LookupResult recordLookup(std::optional<pid_t> pid, InodeNumber dir);
+
+  /**
+   * Record how long a prefetch took, from the start of its lease to the
+   * completion of the loads of the children.
+   */
+  void recordPrefetchDuration(Clock::duration duration);
+
+  /**
+   * The number of prefetches allowed at once: maxPrefetches while the average
+   * prefetch duration is below referenceLatency, and proportionally more
+   * above, up to maxAdaptivePrefetches.
+   */
+  uint64_t getMaxPrefetches(
+      uint64_t maxPrefetches,
+      uint64_t maxAdaptivePrefetches,
+      std::chrono::nanoseconds referenceLatency) const;
+
+  /**
+   * Exponentially weighted average of the recorded prefetch durations.
+   */
+  std::chrono::nanoseconds getAveragePrefetchDuration() const {
+    return std::chrono::nanoseconds{
+        averageDuration_.load(std::memory_order_relaxed)};
+  }
+
+  /**
+   * Number of recent listings remembered per process.
+   */
+  static constexpr size_t kListingsPerProcess = 32;
+
+  /**
+   * Number of processes remembered, per shard.
+   */
+  static constexpr size_t kProcessesPerShard = 64;
+
+  /**
+   * Processes with fewer remembered listings than this are prefetched for.
+   */
+  static constexpr size_t kMinListings = 4;
+
+  /**
+   * A directory not listed recently is prefetched when at least this fraction
+   * of the remembered listings of the process led to lookups.
+   */
+  static constexpr double kMinLookupRate = 0.5;
+
+ private:
+  struct Listing {
+    InodeNumber dir;
+    bool prefetched = false;
+    bool lookedUp = false;
+  };
+
+  /**
+   * The recent listings of a process, the oldest being replaced first.
+   */
+  struct Process {
+    Listing* find(InodeNumber dir);
+    Listing& add(InodeNumber dir);
+
+    std::array<Listing, kListingsPerProcess> listings;
+    size_t next = 0;
+    size_t count = 0;
+  };
+
+  using Processes = folly::EvictingCacheMap<pid_t, Process>;
+
+  struct Shard {
+    folly::Synchronized<Processes, std::mutex> processes{
+        std::in_place, kProcessesPerShard};
+  };
+
+  static constexpr size_t kShardCount = 16;
+
+  Shard& getShard(pid_t pid);
+
+  std::array<Shard, kShardCount> shards_;
+  // In nanoseconds, 0 until a prefetch completed.
+  std::atomic<int64_t> averageDuration_{0};
+};
+
+} // namespace facebook::eden
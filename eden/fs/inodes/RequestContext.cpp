@@ -17,6 +17,7 @@ using namespace std::chrono;
 namespace facebook::eden {
 
 RequestContext::~RequestContext() noexcept {
+  samplerScope_.reset();
   try {
     const auto diff = steady_clock::now() - startTime_;
     const auto diff_ns = duration_cast<nanoseconds>(diff);
@@ -49,6 +50,9 @@ RequestContext::~RequestContext() noexcept {
           break;
       }
       pal_.recordDuration(*pid, diff_ns);
+      if (bytesRead_) {
+        pal_.recordBytesRead(*pid, bytesRead_);
+      }
     }
   } catch (const std::exception& ex) {
     XLOG(WARN) << "Failed to complete request: " << folly::exceptionStr(ex);
@@ -68,6 +72,31 @@ void RequestContext::startRequest(
   if (requestWatchList_) {
     requestMetricsScope_ = RequestMetricsScope(requestWatchList_.get());
   }
+  if (stats_ && stats_->getRequestSampler().isEnabled()) {
+    requestName_ = latencyStat_(*stats_).getName();
+    samplerScope_ = stats_->getRequestSampler().track(*this);
+  }
+}
+
+void RequestContext::appendFrames(std::string& stack) const {
+  // Stat names end in "_us", which says nothing about the request.
+  appendFrame(stack, requestName_.substr(0, requestName_.size() - 3));
+  if (auto detail = fsObjectFetchContext_->getCauseDetail()) {
+    appendFrame(stack, *detail);
+  }
+  switch (fsObjectFetchContext_->getEdenTopStats().getFetchOrigin()) {
+    case ObjectFetchContext::Origin::FromMemoryCache:
+      appendFrame(stack, "from_memory_cache");
+      break;
+    case ObjectFetchContext::Origin::FromDiskCache:
+      appendFrame(stack, "from_disk_cache");
+      break;
+    case ObjectFetchContext::Origin::FromNetworkFetch:
+      appendFrame(stack, "from_backing_store");
+      break;
+    default:
+      break;
+  }
 }
 
 } // namespace facebook::eden
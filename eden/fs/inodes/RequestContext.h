@@ -11,10 +11,12 @@
 #include <atomic>
 #include <utility>
 
+#include "eden/fs/store/FetchCostAccumulator.h"
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
+#include "eden/fs/telemetry/RequestSampler.h"
 #include "eden/fs/utils/ProcessAccessLog.h"
 
 namespace facebook::eden {
@@ -31,16 +33,37 @@ class FsObjectFetchContext : public ObjectFetchContext {
       fetchOrigin_.store(origin, std::memory_order_relaxed);
     }
 
+    /**
+     * The total time spent waiting for BackingStore requests made on behalf
+     * of this request.
+     */
+    std::chrono::nanoseconds getBackingStoreDuration() const {
+      return std::chrono::nanoseconds{
+          backingStoreNs_.load(std::memory_order_relaxed)};
+    }
+
+    void addBackingStoreDuration(std::chrono::nanoseconds duration) {
+      backingStoreNs_.fetch_add(duration.count(), std::memory_order_relaxed);
+    }
+
     std::chrono::nanoseconds fuseDuration{0};
 
    private:
     std::atomic<Origin> fetchOrigin_{Origin::NotFetched};
+    std::atomic<int64_t> backingStoreNs_{0};
   };
 
   EdenTopStats& getEdenTopStats() {
     return edenTopStats_;
   }
 
+  /**
+   * Where the objects this request fetched came from, and what they cost.
+   */
+  FetchCost getFetchCost() const {
+    return fetchCost_.getFetchCost();
+  }
+
   // ObjectFetchContext overrides:
 
   void didFetch(ObjectType /*type*/, const ObjectId& /*hash*/, Origin origin)
@@ -48,6 +71,17 @@ class FsObjectFetchContext : public ObjectFetchContext {
     edenTopStats_.setFetchOrigin(origin);
   }
 
+  void didWaitForBackingStore(std::chrono::nanoseconds duration) override {
+    edenTopStats_.addBackingStoreDuration(duration);
+  }
+
+  void didSpendFetching(
+      Origin origin,
+      std::chrono::nanoseconds duration,
+      uint64_t bytes) override {
+    fetchCost_.add(origin, duration, bytes);
+  }
+
   Cause getCause() const override {
     return Cause::Fs;
   }
@@ -73,6 +107,7 @@ class FsObjectFetchContext : public ObjectFetchContext {
 
  private:
   EdenTopStats edenTopStats_;
+  FetchCostAccumulator fetchCost_;
 
   /**
    * Normally, one requestData is created for only one fetch request,
@@ -86,7 +121,7 @@ class FsObjectFetchContext : public ObjectFetchContext {
 
 using FsObjectFetchContextPtr = RefPtr<FsObjectFetchContext>;
 
-class RequestContext {
+class RequestContext : private RequestSampler::SampledRequest {
  public:
   explicit RequestContext(
       ProcessAccessLog& pal,
@@ -121,6 +156,21 @@ class RequestContext {
     return *fsObjectFetchContext_;
   }
 
+  /**
+   * The time elapsed since startRequest() was called.
+   */
+  std::chrono::nanoseconds getElapsedTime() const {
+    return std::chrono::steady_clock::now() - startTime_;
+  }
+
+  /**
+   * Records the bytes returned by a read request, accounted to the client
+   * process when the request completes.
+   */
+  void setBytesRead(uint64_t bytesRead) {
+    bytesRead_ = bytesRead;
+  }
+
  private:
   // RequestContext is used for every FsChannel implementation, each of which
   // has its own statistics. If non-empty, this function returns a Duration
@@ -139,6 +189,12 @@ class RequestContext {
 
   void finishRequest() noexcept;
 
+  /**
+   * Samples the request as its stat name, followed by the cause detail of its
+   * fetch context and where its objects were fetched from, once known.
+   */
+  void appendFrames(std::string& stack) const override;
+
   // Needed to track stats
   std::chrono::time_point<std::chrono::steady_clock> startTime_;
   EdenStats* stats_ = nullptr;
@@ -148,8 +204,13 @@ class RequestContext {
   std::shared_ptr<RequestMetricsScope::LockedRequestWatchList>
       requestWatchList_;
   ProcessAccessLog& pal_;
+  uint64_t bytesRead_ = 0;
 
   const FsObjectFetchContextPtr fsObjectFetchContext_;
+
+  // Only set while the request is sampled.
+  std::string_view requestName_;
+  RequestSampler::Scope samplerScope_;
 };
 
 } // namespace facebook::eden
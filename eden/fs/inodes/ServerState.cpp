@@ -50,6 +50,9 @@ ServerState::ServerState(
       edenStats_{std::make_unique<EdenStats>()},
       privHelper_{std::move(privHelper)},
       threadPool_{std::move(threadPool)},
+      journalNotificationExecutor_{std::make_shared<UnboundedQueueExecutor>(
+          1,
+          "JournalNotify")},
       clock_{std::move(clock)},
       processNameCache_{std::move(processNameCache)},
       structuredLogger_{std::move(structuredLogger)},
@@ -62,23 +65,26 @@ ServerState::ServerState(
                     mainEventBase,
                     initialConfig.numNfsThreads.getValue(),
                     initialConfig.maxNfsInflightRequests.getValue(),
+                    initialConfig.numNfsIoThreads.getValue(),
+                    initialConfig.maxNfsInflightRequestsPerConnection
+                        .getValue(),
                     structuredLogger_)
               :
 #endif
               nullptr,
       },
       config_{std::move(reloadableConfig)},
-      userIgnoreFileMonitor_{CachedParsedFileMonitor<GitIgnoreFileParser>{
+      topLevelIgnores_{
+          std::in_place,
           initialConfig.userIgnoreFile.getValue(),
-          kUserIgnoreMinPollSeconds}},
-      systemIgnoreFileMonitor_{CachedParsedFileMonitor<GitIgnoreFileParser>{
-          initialConfig.systemIgnoreFile.getValue(),
-          kSystemIgnoreMinPollSeconds}},
+          initialConfig.systemIgnoreFile.getValue()},
       notifier_{std::move(notifier)},
       fsEventLogger_{
           initialConfig.requestSamplesPerMinute.getValue()
               ? std::make_shared<FsEventLogger>(config_, hiveLogger_)
-              : nullptr} {
+              : nullptr},
+      globResultCache_{initialConfig.globResultCacheSize.getValue()},
+      gitIgnoreCache_{initialConfig.gitIgnoreCacheSize.getValue()} {
   // It would be nice if we eventually built a more generic mechanism for
   // defining faults to be configured on start up.  (e.g., loading this from the
   // EdenConfig).
@@ -94,7 +100,13 @@ ServerState::ServerState(
 
 ServerState::~ServerState() {}
 
-std::unique_ptr<TopLevelIgnores> ServerState::getTopLevelIgnores() {
+ServerState::TopLevelIgnoresCache::TopLevelIgnoresCache(
+    AbsolutePathPiece userIgnoreFile,
+    AbsolutePathPiece systemIgnoreFile)
+    : userIgnoreFileMonitor{userIgnoreFile, kUserIgnoreMinPollSeconds},
+      systemIgnoreFileMonitor{systemIgnoreFile, kSystemIgnoreMinPollSeconds} {}
+
+std::shared_ptr<const TopLevelIgnores> ServerState::getTopLevelIgnores() {
   // Update EdenConfig to detect changes to the system or user ignore files
   auto edenConfig = getEdenConfig();
 
@@ -102,23 +114,36 @@ std::unique_ptr<TopLevelIgnores> ServerState::getTopLevelIgnores() {
   auto userIgnoreFile = edenConfig->userIgnoreFile.getValue();
   auto systemIgnoreFile = edenConfig->systemIgnoreFile.getValue();
 
+  auto cache = topLevelIgnores_.lock();
+  // Only stats the files once per poll interval, and only parses them when
+  // they changed.
+  auto userUpdateCount =
+      cache->userIgnoreFileMonitor.checkForUpdates(userIgnoreFile);
+  auto systemUpdateCount =
+      cache->systemIgnoreFileMonitor.checkForUpdates(systemIgnoreFile);
+  if (cache->ignores && userUpdateCount == cache->userUpdateCount &&
+      systemUpdateCount == cache->systemUpdateCount) {
+    return cache->ignores;
+  }
+
   // Get the userIgnoreFile
   GitIgnore userGitIgnore{};
-  auto fcResult =
-      userIgnoreFileMonitor_.wlock()->getFileContents(userIgnoreFile);
+  auto fcResult = cache->userIgnoreFileMonitor.getFileContents();
   if (fcResult.hasValue()) {
-    userGitIgnore = fcResult.value();
+    userGitIgnore = std::move(fcResult).value();
   }
 
   // Get the systemIgnoreFile
   GitIgnore systemGitIgnore{};
-  fcResult =
-      systemIgnoreFileMonitor_.wlock()->getFileContents(systemIgnoreFile);
+  fcResult = cache->systemIgnoreFileMonitor.getFileContents();
   if (fcResult.hasValue()) {
-    systemGitIgnore = fcResult.value();
+    systemGitIgnore = std::move(fcResult).value();
   }
-  return std::make_unique<TopLevelIgnores>(
+  cache->ignores = std::make_shared<const TopLevelIgnores>(
       std::move(userGitIgnore), std::move(systemGitIgnore));
+  cache->userUpdateCount = userUpdateCount;
+  cache->systemUpdateCount = systemUpdateCount;
+  return cache->ignores;
 }
 
 } // namespace facebook::eden
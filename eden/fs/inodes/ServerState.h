@@ -7,13 +7,17 @@
 
 #pragma once
 
+#include <folly/Synchronized.h>
 #include <folly/ThreadLocal.h>
 #include <chrono>
 #include <memory>
+#include <mutex>
 
 #include "eden/fs/config/CachedParsedFileMonitor.h"
 #include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/fuse/privhelper/PrivHelper.h"
+#include "eden/fs/inodes/GlobResultCache.h"
+#include "eden/fs/model/git/GitIgnoreCache.h"
 #include "eden/fs/model/git/GitIgnoreFileParser.h"
 #include "eden/fs/notifications/Notifier.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -101,7 +105,7 @@ class ServerState {
    * Get the TopLevelIgnores. It is based on the system and user git ignore
    * files.
    */
-  std::unique_ptr<TopLevelIgnores> getTopLevelIgnores();
+  std::shared_ptr<const TopLevelIgnores> getTopLevelIgnores();
 
   /**
    * Get the UserInfo object describing the user running this edenfs process.
@@ -127,6 +131,15 @@ class ServerState {
     return threadPool_;
   }
 
+  /**
+   * Get the executor Journal subscribers are notified on, so that slow
+   * subscribers neither delay the writes to the mounts nor the thread pool.
+   */
+  const std::shared_ptr<UnboundedQueueExecutor>&
+  getJournalNotificationExecutor() const {
+    return journalNotificationExecutor_;
+  }
+
   /**
    * Get the Clock.
    */
@@ -183,12 +196,28 @@ class ServerState {
     return notifier_;
   }
 
+  /**
+   * The results of the recent globs evaluated against unmodified trees,
+   * shared by all the mounts.
+   */
+  GlobResultCache& getGlobResultCache() {
+    return globResultCache_;
+  }
+
+  /**
+   * The .gitignore files recently parsed by the diffs of all the mounts.
+   */
+  GitIgnoreCache& getGitIgnoreCache() {
+    return gitIgnoreCache_;
+  }
+
  private:
   AbsolutePath socketPath_;
   UserInfo userInfo_;
   std::unique_ptr<EdenStats> edenStats_;
   std::shared_ptr<PrivHelper> privHelper_;
   std::shared_ptr<UnboundedQueueExecutor> threadPool_;
+  std::shared_ptr<UnboundedQueueExecutor> journalNotificationExecutor_;
   std::shared_ptr<Clock> clock_;
   std::shared_ptr<ProcessNameCache> processNameCache_;
   std::shared_ptr<StructuredLogger> structuredLogger_;
@@ -197,11 +226,27 @@ class ServerState {
   std::shared_ptr<NfsServer> nfs_;
 
   std::shared_ptr<ReloadableConfig> config_;
-  folly::Synchronized<CachedParsedFileMonitor<GitIgnoreFileParser>>
-      userIgnoreFileMonitor_;
-  folly::Synchronized<CachedParsedFileMonitor<GitIgnoreFileParser>>
-      systemIgnoreFileMonitor_;
+
+  /**
+   * The system and user ignore files, and the TopLevelIgnores built from
+   * them, shared by the diffs of all the mounts until either file changes.
+   */
+  struct TopLevelIgnoresCache {
+    TopLevelIgnoresCache(
+        AbsolutePathPiece userIgnoreFile,
+        AbsolutePathPiece systemIgnoreFile);
+
+    CachedParsedFileMonitor<GitIgnoreFileParser> userIgnoreFileMonitor;
+    CachedParsedFileMonitor<GitIgnoreFileParser> systemIgnoreFileMonitor;
+    std::shared_ptr<const TopLevelIgnores> ignores;
+    // The update counts of the monitors ignores was built at.
+    size_t userUpdateCount{0};
+    size_t systemUpdateCount{0};
+  };
+  folly::Synchronized<TopLevelIgnoresCache, std::mutex> topLevelIgnores_;
   std::shared_ptr<Notifier> notifier_;
   std::shared_ptr<FsEventLogger> fsEventLogger_;
+  GlobResultCache globResultCache_;
+  GitIgnoreCache gitIgnoreCache_;
 };
 } // namespace facebook::eden
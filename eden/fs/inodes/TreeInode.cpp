@@ -8,11 +8,16 @@
 #include "eden/fs/inodes/TreeInode.h"
 
 #include <boost/polymorphic_cast.hpp>
+#include <folly/ExceptionWrapper.h>
 #include <folly/FileUtil.h>
 #include <folly/chrono/Conv.h>
 #include <folly/futures/Future.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/logging/xlog.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <numeric>
 #include <vector>
 
 #include "eden/common/utils/Synchronized.h"
@@ -22,6 +27,7 @@
 #include "eden/fs/inodes/CheckoutAction.h"
 #include "eden/fs/inodes/CheckoutContext.h"
 #include "eden/fs/inodes/DeferredDiffEntry.h"
+#include "eden/fs/inodes/DematerializePass.h"
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/inodes/InodeError.h"
@@ -43,6 +49,7 @@
 #include "eden/fs/store/DiffCallback.h"
 #include "eden/fs/store/DiffContext.h"
 #include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/Tracing.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/CaseSensitivity.h"
@@ -92,7 +99,7 @@ class TreeInode::IncompleteInodeLoad {
  public:
   IncompleteInodeLoad(
       TreeInode* inode,
-      Future<unique_ptr<InodeBase>>&& future,
+      Future<LoadedChild>&& future,
       PathComponentPiece name,
       InodeNumber number)
       : treeInode_{inode},
@@ -137,7 +144,7 @@ class TreeInode::IncompleteInodeLoad {
   std::unique_ptr<TreeInode, NoopDeleter> treeInode_;
   InodeNumber number_;
   PathComponent name_;
-  Future<unique_ptr<InodeBase>> future_;
+  Future<LoadedChild> future_;
 };
 
 TreeInode::TreeInode(
@@ -237,6 +244,7 @@ std::optional<ImmediateFuture<VirtualInode>> TreeInode::rlockGetOrFindChild(
   // modified/materialized yet (it has to have been loaded prior),
   // so it's safe here to ignore the loading inode and instead
   // query the object store for information about the path.
+  getMount()->getStats()->increment(&InodeStats::loadAvoided);
   auto hash = entry.getHash();
   if (entry.isDirectory()) {
     // This is a directory, always get the tree corresponding to
@@ -261,7 +269,7 @@ TreeInode::loadChild(
     folly::Synchronized<TreeInodeState>::LockedPtr& contents,
     PathComponentPiece name,
     const ObjectFetchContextPtr& context) {
-  auto inodeLoadFuture = Future<unique_ptr<InodeBase>>::makeEmpty();
+  auto inodeLoadFuture = Future<LoadedChild>::makeEmpty();
   InodePtr childInodePtr;
   InodeMap::PromiseVector promises;
 
@@ -286,10 +294,11 @@ TreeInode::loadChild(
       // If we finished loading the inode immediately, just call
       // InodeMap::inodeLoadComplete() now, since we still have the
       // data_ lock.
-      auto childInode = std::move(loadFuture).get();
-      entry.setInode(childInode.get());
-      promises = getInodeMap()->inodeLoadComplete(childInode.get());
-      childInodePtr = InodePtr::takeOwnership(std::move(childInode));
+      auto child = std::move(loadFuture).get();
+      entry.setInode(child.inode.get());
+      promises =
+          getInodeMap()->inodeLoadComplete(child.inode.get(), child.timing);
+      childInodePtr = InodePtr::takeOwnership(std::move(child.inode));
     } else {
       inodeLoadFuture = std::move(loadFuture);
     }
@@ -304,6 +313,108 @@ TreeInode::loadChild(
       });
 }
 
+std::vector<std::pair<folly::SemiFuture<InodePtr>, TreeInode::LoadChildCleanUp>>
+TreeInode::loadChildren(
+    folly::Synchronized<TreeInodeState>::LockedPtr& contents,
+    const std::vector<PathComponent>& names,
+    const ObjectFetchContextPtr& context) {
+  // The canonical names must outlive the InodeMap::ChildLoad pieces.
+  std::vector<PathComponent> inodeNames;
+  inodeNames.reserve(names.size());
+  std::vector<DirEntry*> entries;
+  entries.reserve(names.size());
+  std::vector<folly::SemiFuture<InodePtr>> returnFutures;
+  returnFutures.reserve(names.size());
+  std::vector<InodeMap::ChildLoad> loads;
+  loads.reserve(names.size());
+  for (const auto& name : names) {
+    auto iter = contents->entries.find(name);
+    inodeNames.push_back(copyCanonicalInodeName(iter));
+    auto& entry = iter->second;
+    entries.push_back(&entry);
+    folly::Promise<InodePtr> promise;
+    returnFutures.push_back(promise.getSemiFuture());
+    loads.push_back(InodeMap::ChildLoad{
+        inodeNames.back().piece(),
+        entry.getInodeNumber(),
+        entry.getInitialMode(),
+        std::move(promise)});
+  }
+  getInodeMap()->startLoadingChildrenIfNotLoading(this, loads);
+
+  std::vector<Future<LoadedChild>> loadFutures;
+  loadFutures.reserve(names.size());
+  std::vector<unique_ptr<InodeBase>> childInodes(names.size());
+  std::vector<InodeBase*> loadedInodes;
+  std::vector<InodeLoadTiming> loadedTimings;
+  for (size_t i = 0; i < names.size(); ++i) {
+    auto inodeLoadFuture = Future<LoadedChild>::makeEmpty();
+    if (loads[i].startLoad) {
+      auto loadFuture =
+          startLoadingInodeNoThrow(*entries[i], loads[i].name, context);
+      if (loadFuture.isReady() && loadFuture.hasValue()) {
+        auto child = std::move(loadFuture).get();
+        childInodes[i] = std::move(child.inode);
+        entries[i]->setInode(childInodes[i].get());
+        loadedInodes.push_back(childInodes[i].get());
+        loadedTimings.push_back(child.timing);
+      } else {
+        inodeLoadFuture = std::move(loadFuture);
+      }
+    }
+    loadFutures.push_back(std::move(inodeLoadFuture));
+  }
+
+  // As in loadChild(), the inodes that finished loading immediately are
+  // marked loaded while we still have the contents lock.
+  auto loadedPromises =
+      getInodeMap()->inodesLoadComplete(loadedInodes, loadedTimings);
+
+  std::vector<std::pair<folly::SemiFuture<InodePtr>, LoadChildCleanUp>> result;
+  result.reserve(names.size());
+  size_t loadedIndex = 0;
+  for (size_t i = 0; i < names.size(); ++i) {
+    InodeMap::PromiseVector promises;
+    InodePtr childInodePtr;
+    if (childInodes[i]) {
+      promises = std::move(loadedPromises[loadedIndex++]);
+      childInodePtr = InodePtr::takeOwnership(std::move(childInodes[i]));
+    }
+    result.emplace_back(
+        std::move(returnFutures[i]),
+        LoadChildCleanUp{
+            std::move(loadFutures[i]),
+            std::move(promises),
+            loads[i].number,
+            std::move(childInodePtr),
+        });
+  }
+  return result;
+}
+
+folly::SemiFuture<InodePtr> TreeInode::loadChildWithSiblings(
+    folly::Synchronized<TreeInodeState>::LockedPtr& contents,
+    PathComponentPiece name,
+    const ObjectFetchContextPtr& context,
+    std::vector<std::pair<PathComponent, LoadChildCleanUp>>& cleanUps) {
+  auto requested = contents->entries.find(name);
+  std::vector<PathComponent> names;
+  names.reserve(contents->entries.size());
+  names.emplace_back(name);
+  for (const auto& [childName, entry] : contents->entries) {
+    if (&entry != &requested->second && !entry.getInode()) {
+      names.push_back(childName);
+    }
+  }
+
+  auto results = loadChildren(contents, names, context);
+  cleanUps.reserve(cleanUps.size() + results.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    cleanUps.emplace_back(std::move(names[i]), std::move(results[i].second));
+  }
+  return std::move(results.front().first);
+}
+
 void TreeInode::loadChildCleanUp(
     PathComponentPiece name,
     TreeInode::LoadChildCleanUp result) {
@@ -342,6 +453,21 @@ ImmediateFuture<VirtualInode> TreeInode::getOrFindChild(
                return rlockGetOrFindChild(contents, name, context, loadInodes);
              },
              [&](auto& contents) -> ImmediateFuture<VirtualInode> {
+               // Only batch the loads of lookups that want an inode, as
+               // loading the siblings of a materialized child reached without
+               // loading inodes defeats the purpose of not loading them.
+               if (loadInodes && batchLoadOnNextLookup_.exchange(false)) {
+                 std::vector<std::pair<PathComponent, LoadChildCleanUp>>
+                     cleanUps;
+                 auto future =
+                     loadChildWithSiblings(contents, name, context, cleanUps);
+                 contents.unlock();
+                 for (auto& cleanUp : cleanUps) {
+                   loadChildCleanUp(cleanUp.first, std::move(cleanUp.second));
+                 }
+                 return ImmediateFuture<InodePtr>{std::move(future)}.thenValue(
+                     [](auto&& inode) { return VirtualInode{inode}; });
+               }
                auto result = loadChild(contents, name, context);
                // it's important the code between loadChild and loadChildCleanUp
                // is no throw. We need to perform the loadChildCleanUp now
@@ -378,26 +504,43 @@ TreeInode::getChildren(const ObjectFetchContextPtr& context, bool loadInodes) {
       }
     };
     auto contents = contents_.wlock();
-    result.reserve(contents->entries.size());
     inodeLoadCleanUps.reserve(contents->entries.size());
+    std::vector<std::optional<ImmediateFuture<VirtualInode>>> found;
+    found.reserve(contents->entries.size());
+    std::vector<PathComponent> toLoad;
+    for (const auto& entry : contents->entries) {
+      found.push_back(
+          rlockGetOrFindChild(*contents, entry.first, context, loadInodes));
+      if (!found.back()) {
+        toLoad.push_back(entry.first);
+      }
+    }
+
+    // Load all the children at once, so that the InodeMap is only updated
+    // once and the fetches of the children are queued together.
+    auto childResults = loadChildren(contents, toLoad, context);
+    // The moves into inodeLoadCleanUps must be no-except to guarantee the
+    // cleanups will run if building the result below throws.
+    XCHECK_LE(childResults.size(), inodeLoadCleanUps.capacity());
+    for (size_t i = 0; i < childResults.size(); ++i) {
+      inodeLoadCleanUps.push_back(
+          std::make_pair(toLoad[i], std::move(childResults[i].second)));
+    }
+
+    result.reserve(contents->entries.size());
+    size_t loadIndex = 0;
+    size_t index = 0;
     for (const auto& entry : contents->entries) {
-      auto virtualInode =
-          rlockGetOrFindChild(*contents, entry.first, context, loadInodes);
+      auto& virtualInode = found[index++];
       if (virtualInode) {
         result.push_back(
             std::make_pair(entry.first, std::move(virtualInode.value())));
       } else {
-        auto childResult = loadChild(contents, entry.first, context);
-        // inodeLoadCleanUps.push_back must be no-except to guarantee
-        // the cleanup will run if result.push_back below throws.
-        XCHECK_LT(inodeLoadCleanUps.size(), inodeLoadCleanUps.capacity());
-        inodeLoadCleanUps.push_back(
-            std::make_pair(entry.first, std::move(childResult.second)));
-
         result.push_back(std::make_pair(
             entry.first,
-            ImmediateFuture<InodePtr>{std::move(childResult.first)}.thenValue(
-                [](auto&& inode) { return VirtualInode{inode}; })));
+            ImmediateFuture<InodePtr>{
+                std::move(childResults[loadIndex++].first)}
+                .thenValue([](auto&& inode) { return VirtualInode{inode}; })));
       }
     }
   }
@@ -495,6 +638,23 @@ InodeNumber TreeInode::getChildInodeNumber(PathComponentPiece name) {
   return ent.getInodeNumber();
 }
 
+namespace {
+/**
+ * Record a phase of an inode load that started at start in both its timing
+ * and the mount's stats.
+ */
+void recordLoadPhase(
+    const EdenMount& mount,
+    InodeLoadTiming& timing,
+    uint32_t InodeLoadPhases::*phase,
+    StatsGroupBase::Duration InodeStats::*stat,
+    std::chrono::steady_clock::time_point start) {
+  auto elapsed = InodeLoadPhases::elapsedSince(start);
+  timing.phases.*phase = elapsed;
+  mount.getStats()->addDuration(stat, std::chrono::microseconds{elapsed});
+}
+} // namespace
+
 void TreeInode::loadUnlinkedChildInode(
     PathComponentPiece name,
     InodeNumber number,
@@ -503,8 +663,10 @@ void TreeInode::loadUnlinkedChildInode(
   try {
     InodeMap::PromiseVector promises;
     InodePtr inodePtr;
+    auto timing = InodeLoadTiming::startNow();
 
     if (!S_ISDIR(mode)) {
+      auto constructStart = std::chrono::steady_clock::now();
       auto file = std::make_unique<FileInode>(
           number,
           inodePtrFromThis(),
@@ -512,10 +674,23 @@ void TreeInode::loadUnlinkedChildInode(
           mode,
           std::nullopt,
           hash ? &*hash : nullptr);
-      promises = getInodeMap()->inodeLoadComplete(file.get());
+      recordLoadPhase(
+          *getMount(),
+          timing,
+          &InodeLoadPhases::metadataLookup,
+          &InodeStats::loadMetadataLookup,
+          constructStart);
+      promises = getInodeMap()->inodeLoadComplete(file.get(), timing);
       inodePtr = InodePtr::takeOwnership(std::move(file));
     } else {
+      auto readStart = std::chrono::steady_clock::now();
       auto overlayContents = getOverlay()->loadOverlayDir(number);
+      recordLoadPhase(
+          *getMount(),
+          timing,
+          &InodeLoadPhases::overlayRead,
+          &InodeStats::loadOverlayRead,
+          readStart);
       if (!hash) {
         // If the inode is materialized, the overlay must have an entry
         // for the directory.
@@ -530,6 +705,7 @@ void TreeInode::loadUnlinkedChildInode(
         }
       }
 
+      auto constructStart = std::chrono::steady_clock::now();
       auto tree = std::make_unique<TreeInode>(
           number,
           inodePtrFromThis(),
@@ -538,7 +714,13 @@ void TreeInode::loadUnlinkedChildInode(
           std::nullopt,
           std::move(overlayContents),
           hash ? std::optional<ObjectId>{*hash} : std::nullopt);
-      promises = getInodeMap()->inodeLoadComplete(tree.get());
+      recordLoadPhase(
+          *getMount(),
+          timing,
+          &InodeLoadPhases::metadataLookup,
+          &InodeStats::loadMetadataLookup,
+          constructStart);
+      promises = getInodeMap()->inodeLoadComplete(tree.get(), timing);
       inodePtr = InodePtr::takeOwnership(std::move(tree));
     }
 
@@ -561,7 +743,7 @@ void TreeInode::loadUnlinkedChildInode(
 
 void TreeInode::loadChildInode(PathComponentPiece name, InodeNumber number) {
   std::optional<PathComponent> inodeName;
-  auto future = Future<unique_ptr<InodeBase>>::makeEmpty();
+  auto future = Future<LoadedChild>::makeEmpty();
   {
     auto contents = contents_.rlock();
     auto iter = contents->entries.find(name);
@@ -604,15 +786,15 @@ void TreeInode::loadChildInode(PathComponentPiece name, InodeNumber number) {
 }
 
 void TreeInode::registerInodeLoadComplete(
-    folly::Future<unique_ptr<InodeBase>>& future,
+    folly::Future<LoadedChild>& future,
     PathComponentPiece name,
     InodeNumber number) {
   // This method should never be called with the contents_ lock held.  If the
   // future is already ready we will try to acquire the contents_ lock now.
   std::move(future)
       .thenValue([self = inodePtrFromThis(), childName = PathComponent{name}](
-                     unique_ptr<InodeBase>&& childInode) {
-        self->inodeLoadComplete(childName, std::move(childInode));
+                     LoadedChild&& child) {
+        self->inodeLoadComplete(childName, std::move(child));
       })
       .thenError([self = inodePtrFromThis(),
                   number](const folly::exception_wrapper& ew) {
@@ -622,7 +804,8 @@ void TreeInode::registerInodeLoadComplete(
 
 void TreeInode::inodeLoadComplete(
     PathComponentPiece childName,
-    std::unique_ptr<InodeBase> childInode) {
+    LoadedChild child) {
+  auto& childInode = child.inode;
   InodeMap::PromiseVector promises;
 
   {
@@ -650,7 +833,7 @@ void TreeInode::inodeLoadComplete(
     // the inode by name before it is also available in the InodeMap.
     // However, we must wait to fulfill pending promises until after
     // releasing our lock.
-    promises = getInodeMap()->inodeLoadComplete(childInode.get());
+    promises = getInodeMap()->inodeLoadComplete(childInode.get(), child.timing);
   }
 
   // Fulfill all of the pending promises after releasing our lock
@@ -660,7 +843,7 @@ void TreeInode::inodeLoadComplete(
   }
 }
 
-Future<unique_ptr<InodeBase>> TreeInode::startLoadingInodeNoThrow(
+Future<TreeInode::LoadedChild> TreeInode::startLoadingInodeNoThrow(
     const DirEntry& entry,
     PathComponentPiece name,
     const ObjectFetchContextPtr& fetchContext) noexcept {
@@ -672,12 +855,22 @@ Future<unique_ptr<InodeBase>> TreeInode::startLoadingInodeNoThrow(
   // and always return a Future object.  Therefore we simply wrap
   // startLoadingInode() and convert any thrown exceptions into Future.
   try {
-    return startLoadingInode(entry, name, fetchContext);
+    auto start = std::chrono::steady_clock::now();
+    auto future = startLoadingInode(entry, name, fetchContext);
+    if (!entry.isDirectory()) {
+      // Files are constructed inline, their loads aren't worth reporting.
+      return future;
+    }
+    return std::move(future).thenValue(
+        [fetchContext = fetchContext.copy(), start](LoadedChild&& child) {
+          fetchContext->didLoadInode(std::chrono::steady_clock::now() - start);
+          return std::move(child);
+        });
   } catch (...) {
     // It's possible that makeFuture() itself could throw, but this only
     // happens on out of memory, in which case the whole process is pretty much
     // hosed anyway.
-    return makeFuture<unique_ptr<InodeBase>>(
+    return makeFuture<LoadedChild>(
         folly::exception_wrapper{std::current_exception()});
   }
 }
@@ -727,13 +920,14 @@ std::optional<std::vector<std::string>> findEntryDifferences(
   return std::nullopt;
 }
 
-Future<unique_ptr<InodeBase>> TreeInode::startLoadingInode(
+Future<TreeInode::LoadedChild> TreeInode::startLoadingInode(
     const DirEntry& entry,
     PathComponentPiece name,
     const ObjectFetchContextPtr& fetchContext) {
   XLOG(DBG5) << "starting to load inode " << entry.getInodeNumber() << ": "
              << getLogPath() << " / \"" << name << "\"";
   XDCHECK(entry.getInode() == nullptr);
+  auto timing = InodeLoadTiming::startNow();
   if (!entry.isDirectory()) {
     // If this is a file we can just go ahead and create it now;
     // we don't need to load anything else.
@@ -741,16 +935,25 @@ Future<unique_ptr<InodeBase>> TreeInode::startLoadingInode(
     // Eventually we may want to go ahead start loading some of the blob data
     // now, but we don't have to wait for it to be ready before marking the
     // inode loaded.
-    return make_unique<FileInode>(
+    auto constructStart = std::chrono::steady_clock::now();
+    auto file = make_unique<FileInode>(
         entry.getInodeNumber(),
         inodePtrFromThis(),
         name,
         entry.getInitialMode(),
         std::nullopt,
         entry.getHashPtr());
+    recordLoadPhase(
+        *getMount(),
+        timing,
+        &InodeLoadPhases::metadataLookup,
+        &InodeStats::loadMetadataLookup,
+        constructStart);
+    return LoadedChild{std::move(file), timing};
   }
 
   if (!entry.isMaterialized()) {
+    auto fetchStart = std::chrono::steady_clock::now();
     return getObjectStore()
         .getTree(entry.getHash(), fetchContext)
         .semi()
@@ -760,12 +963,28 @@ Future<unique_ptr<InodeBase>> TreeInode::startLoadingInode(
              childName = PathComponent{name},
              treeHash = entry.getHash(),
              entryMode = entry.getInitialMode(),
-             number = entry.getInodeNumber()](
-                std::shared_ptr<const Tree> tree) mutable
-            -> unique_ptr<InodeBase> {
+             number = entry.getInodeNumber(),
+             timing,
+             fetchStart](
+                std::shared_ptr<const Tree> tree) mutable -> LoadedChild {
+              auto& mount = *self->getMount();
+              recordLoadPhase(
+                  mount,
+                  timing,
+                  &InodeLoadPhases::treeFetch,
+                  &InodeStats::loadTreeFetch,
+                  fetchStart);
+
               // Even if the inode is not materialized, it may have inode
               // numbers stored in the overlay.
+              auto readStart = std::chrono::steady_clock::now();
               auto overlayDir = self->loadOverlayDir(number);
+              recordLoadPhase(
+                  mount,
+                  timing,
+                  &InodeLoadPhases::overlayRead,
+                  &InodeStats::loadOverlayRead,
+                  readStart);
 
               // If the directory we loaded from overlay is empty, there is no
               // need to compare them and we can just use the version from
@@ -791,31 +1010,68 @@ Future<unique_ptr<InodeBase>> TreeInode::startLoadingInode(
 
                 XLOG(DBG6) << "found entry " << childName
                            << " with inode number " << number << " in overlay";
-                return make_unique<TreeInode>(
-                    number,
-                    std::move(self),
-                    childName,
-                    entryMode,
-                    std::nullopt,
-                    std::move(overlayDir),
-                    treeHash);
               }
 
-              return make_unique<TreeInode>(
-                  number, self, childName, entryMode, std::move(tree));
+              auto constructStart = std::chrono::steady_clock::now();
+              auto child = overlayDir.empty()
+                  ? make_unique<TreeInode>(
+                        number, self, childName, entryMode, std::move(tree))
+                  : make_unique<TreeInode>(
+                        number,
+                        self,
+                        childName,
+                        entryMode,
+                        std::nullopt,
+                        std::move(overlayDir),
+                        treeHash);
+              recordLoadPhase(
+                  mount,
+                  timing,
+                  &InodeLoadPhases::metadataLookup,
+                  &InodeStats::loadMetadataLookup,
+                  constructStart);
+              return LoadedChild{std::move(child), timing};
             });
   }
 
-  // The entry is materialized, so data must exist in the overlay.
-  auto overlayDir = loadOverlayDir(entry.getInodeNumber());
-  return make_unique<TreeInode>(
-      entry.getInodeNumber(),
-      inodePtrFromThis(),
-      name,
-      entry.getInitialMode(),
-      std::nullopt,
-      std::move(overlayDir),
-      std::nullopt);
+  // The entry is materialized, so data must exist in the overlay. The
+  // returned future is ready when the overlay is read inline.
+  auto readStart = std::chrono::steady_clock::now();
+  return getOverlay()
+      ->loadOverlayDirAsync(entry.getInodeNumber())
+      .semi()
+      .via(&folly::QueuedImmediateExecutor::instance())
+      .thenValue(
+          [self = inodePtrFromThis(),
+           childName = PathComponent{name},
+           entryMode = entry.getInitialMode(),
+           number = entry.getInodeNumber(),
+           timing,
+           readStart](DirContents overlayDir) mutable -> LoadedChild {
+            auto& mount = *self->getMount();
+            recordLoadPhase(
+                mount,
+                timing,
+                &InodeLoadPhases::overlayRead,
+                &InodeStats::loadOverlayRead,
+                readStart);
+            auto constructStart = std::chrono::steady_clock::now();
+            auto child = make_unique<TreeInode>(
+                number,
+                self,
+                childName,
+                entryMode,
+                std::nullopt,
+                std::move(overlayDir),
+                std::nullopt);
+            recordLoadPhase(
+                mount,
+                timing,
+                &InodeLoadPhases::metadataLookup,
+                &InodeStats::loadMetadataLookup,
+                constructStart);
+            return LoadedChild{std::move(child), timing};
+          });
 }
 
 void TreeInode::materialize(const RenameLock* renameLock) {
@@ -1062,18 +1318,20 @@ DirContents TreeInode::buildDirFromTree(
     CaseSensitivity caseSensitive) {
   XCHECK(tree);
 
-  // A future optimization is for this code to allocate all of the inode numbers
-  // at once and then dole them out, one per entry. It would reduce the number
-  // of atomic operations from N to 1, though if the atomic is issued with the
-  // other work this loop is doing it may not matter much.
-
   DirContents dir(caseSensitive);
-  // TODO: O(N^2)
+  if (tree->size() == 0) {
+    return dir;
+  }
+  dir.reserve(tree->size());
+
+  // The entries of the tree are sorted, so unless the case sensitivity of the
+  // tree differs from the mount's, each emplace appends to the directory.
+  auto ino = overlay->allocateInodeNumbers(tree->size()).get();
   for (const auto& treeEntry : *tree) {
     dir.emplace(
         treeEntry.first,
         modeFromTreeEntryType(treeEntry.second.getType()),
-        overlay->allocateInodeNumber(),
+        InodeNumber{ino++},
         treeEntry.second.getHash());
   }
   return dir;
@@ -1396,10 +1654,109 @@ ImmediateFuture<folly::Unit> TreeInode::rmdir(
       });
 }
 
+namespace {
+/**
+ * Call func on each of the items, on up to parallelism threads: the calling
+ * one and threads of the executor.
+ *
+ * The calling thread only waits for the items that another thread already
+ * started. When the executor runs a helper after all the items were claimed,
+ * the helper has nothing left to do, so nested calls from executor threads
+ * can't starve the executor.
+ *
+ * After func throws, the items not started yet are skipped. The first
+ * exception is rethrown once the started items completed.
+ */
+template <typename T, typename Func>
+void forEachInParallel(
+    std::vector<T>& items,
+    folly::Executor& executor,
+    size_t parallelism,
+    Func func) {
+  if (items.size() < 2 || parallelism < 2) {
+    for (auto& item : items) {
+      func(item);
+    }
+    return;
+  }
+
+  struct Progress {
+    explicit Progress(size_t count) : count{count} {}
+
+    const size_t count;
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::mutex mutex;
+    std::condition_variable completedCV;
+    size_t completed{0};
+    folly::exception_wrapper error;
+  };
+  // Helpers that the executor runs late only touch progress, which they keep
+  // alive.
+  auto progress = std::make_shared<Progress>(items.size());
+  auto run = [progress, &items, &func] {
+    for (;;) {
+      auto index = progress->next.fetch_add(1, std::memory_order_relaxed);
+      if (index >= progress->count) {
+        return;
+      }
+      if (!progress->failed.load(std::memory_order_relaxed)) {
+        try {
+          func(items[index]);
+        } catch (...) {
+          auto lock = std::lock_guard{progress->mutex};
+          if (!progress->error) {
+            progress->error =
+                folly::exception_wrapper{std::current_exception()};
+          }
+          progress->failed = true;
+        }
+      }
+      {
+        auto lock = std::lock_guard{progress->mutex};
+        ++progress->completed;
+      }
+      progress->completedCV.notify_all();
+    }
+  };
+
+  auto helpers = std::min(parallelism, items.size()) - 1;
+  for (size_t i = 0; i < helpers; ++i) {
+    executor.add(run);
+  }
+  run();
+
+  auto lock = std::unique_lock{progress->mutex};
+  progress->completedCV.wait(
+      lock, [&] { return progress->completed == progress->count; });
+  if (progress->error) {
+    progress->error.throw_exception();
+  }
+}
+} // namespace
+
 void TreeInode::removeAllChildrenRecursively(
     InvalidationRequired invalidate,
     const ObjectFetchContextPtr& context,
     const RenameLock& renameLock) {
+  std::vector<ImmediateFuture<folly::Unit>> invalidations;
+  try {
+    removeAllChildrenRecursivelyImpl(
+        invalidate, context, renameLock, invalidations);
+  } catch (...) {
+    // The directories already emptied must still be invalidated.
+    collectAll(std::move(invalidations)).get();
+    throw;
+  }
+  // Wait for all the directories at once rather than one after the other.
+  collectAllSafe(std::move(invalidations)).get();
+}
+
+void TreeInode::removeAllChildrenRecursivelyImpl(
+    InvalidationRequired invalidate,
+    const ObjectFetchContextPtr& context,
+    const RenameLock& renameLock,
+    std::vector<ImmediateFuture<folly::Unit>>& invalidations) {
   // TODO: Unconditional materialization is slightly conservative. If the
   // BackingStore Tree is empty, then this function can return without
   // materializing.
@@ -1421,15 +1778,36 @@ void TreeInode::removeAllChildrenRecursively(
     }
   }
 
-  // Step 2, Clear contents in the child folders
-  for (auto& treeNode : loadedTreeNodes) {
-    treeNode->removeAllChildrenRecursively(invalidate, context, renameLock);
+  // Step 2, Clear contents in the child folders. The subtrees are disjoint,
+  // so they are cleared in parallel, each thread collecting the invalidations
+  // of its subtrees.
+  std::vector<std::vector<ImmediateFuture<folly::Unit>>> subtreeInvalidations(
+      loadedTreeNodes.size());
+  std::vector<size_t> subtrees(loadedTreeNodes.size());
+  std::iota(subtrees.begin(), subtrees.end(), 0);
+  forEachInParallel(
+      subtrees,
+      *getMount()->getServerThreadPool(),
+      getMount()->getEdenConfig()->removeRecursivelyParallelism.getValue(),
+      [&](size_t index) {
+        loadedTreeNodes[index]->removeAllChildrenRecursivelyImpl(
+            invalidate, context, renameLock, subtreeInvalidations[index]);
+      });
+  for (auto& futures : subtreeInvalidations) {
+    for (auto& future : futures) {
+      invalidations.push_back(std::move(future));
+    }
   }
 
   loadedTreeNodes.clear();
 
   // Step 3, Now all child nodes are removable, unless one of the directories
   // had a new entry added while the contents lock was not held.
+  //
+  // The overlay data of the children is removed afterwards, once this
+  // directory no longer refers to them and without holding its contents lock.
+  std::vector<InodeNumber> removedFiles;
+  std::vector<InodeNumber> removedDirs;
   auto contents = contents_.wlock();
   auto it = contents->entries.begin();
   while (it != contents->entries.end()) {
@@ -1466,17 +1844,23 @@ void TreeInode::removeAllChildrenRecursively(
     it = contents->entries.erase(it);
 
     if (isDir) {
-      getOverlay()->recursivelyRemoveOverlayDir(inodeNum);
+      removedDirs.push_back(inodeNum);
     } else {
-      getOverlay()->removeOverlayFile(inodeNum);
+      removedFiles.push_back(inodeNum);
     }
   }
 
   if (InvalidationRequired::Yes == invalidate) {
-    invalidateChannelDirCache(*contents).get();
+    invalidations.push_back(invalidateChannelDirCache(*contents));
   }
   updateMtimeAndCtimeLocked(contents->entries, getNow());
   getOverlay()->removeChildren(getNodeId(), contents->entries);
+  contents.unlock();
+
+  for (auto inodeNumber : removedDirs) {
+    getOverlay()->recursivelyRemoveOverlayDir(inodeNumber);
+  }
+  getOverlay()->removeOverlayFiles(removedFiles);
 }
 
 InodePtr TreeInode::tryRemoveUnloadedChild(
@@ -1752,6 +2136,36 @@ int TreeInode::checkPreRemove(const FileInode& /* child */) {
   return 0;
 }
 
+namespace {
+template <typename Lock>
+bool isAncestor(const Lock& renameLock, TreeInode* a, TreeInode* b) {
+  auto parent = b->getParent(renameLock);
+  while (parent) {
+    if (parent.get() == a) {
+      return true;
+    }
+    parent = parent->getParent(renameLock);
+  }
+  return false;
+}
+
+/**
+ * The position of a directory in the order in which renames holding the
+ * rename lock in shared mode acquire contents_ locks: ancestors come before
+ * their descendants, like everywhere else.
+ */
+std::pair<size_t, InodeNumber> getRenameLockOrder(
+    const SharedRenameLock& renameLock,
+    TreeInode* tree) {
+  size_t depth = 0;
+  for (auto parent = tree->getParent(renameLock); parent;
+       parent = parent->getParent(renameLock)) {
+    ++depth;
+  }
+  return {depth, tree->getNodeId()};
+}
+} // namespace
+
 /**
  * A helper class that stores all locks required to perform a rename.
  *
@@ -1767,6 +2181,23 @@ class TreeInode::TreeRenameLocks {
       TreeInode* destTree,
       PathComponentPiece destName);
 
+  /**
+   * Acquire the locks for a rename that cannot change the parent of any
+   * directory, holding the mountpoint-wide rename lock in shared mode so that
+   * renames in unrelated directories can run concurrently.
+   *
+   * Returns false without holding any lock if the rename must be done with
+   * the rename lock held exclusively instead: when the source is a directory
+   * moving to another parent, or when one of the directories is not
+   * materialized.
+   */
+  bool tryAcquireSharedLocks(
+      SharedRenameLock&& renameLock,
+      TreeInode* srcTree,
+      PathComponentPiece srcName,
+      TreeInode* destTree,
+      PathComponentPiece destName);
+
   /**
    * Reset the TreeRenameLocks to the empty state, releasing all locks that it
    * holds.
@@ -1783,8 +2214,31 @@ class TreeInode::TreeRenameLocks {
     *this = TreeRenameLocks(std::move(renameLock_));
   }
 
-  const RenameLock& renameLock() const {
-    return renameLock_;
+  bool holdsSharedRenameLock() const {
+    return sharedRenameLock_.has_value();
+  }
+
+  bool isAncestor(TreeInode* a, TreeInode* b) const {
+    return sharedRenameLock_ ? eden::isAncestor(*sharedRenameLock_, a, b)
+                             : eden::isAncestor(renameLock_, a, b);
+  }
+
+  std::unique_ptr<InodeBase>
+  markUnlinked(InodeBase* inode, TreeInode* parent, PathComponentPiece name) {
+    return sharedRenameLock_
+        ? inode->markUnlinked(parent, name, *sharedRenameLock_)
+        : inode->markUnlinked(parent, name, renameLock_);
+  }
+
+  void updateLocation(
+      InodeBase* inode,
+      TreeInodePtr newParent,
+      PathComponentPiece newName) {
+    if (sharedRenameLock_) {
+      inode->updateLocation(std::move(newParent), newName, *sharedRenameLock_);
+    } else {
+      inode->updateLocation(std::move(newParent), newName, renameLock_);
+    }
   }
 
   DirContents* srcContents() {
@@ -1830,9 +2284,10 @@ class TreeInode::TreeRenameLocks {
   void lockDestChild(PathComponentPiece destName);
 
   /**
-   * The mountpoint-wide rename lock.
+   * The mountpoint-wide rename lock, held in either exclusive or shared mode.
    */
   RenameLock renameLock_;
+  std::optional<SharedRenameLock> sharedRenameLock_;
 
   /**
    * Locks for the contents of the source and destination directories.
@@ -1885,15 +2340,23 @@ ImmediateFuture<Unit> TreeInode::rename(
   bool needSrc = false;
   bool needDest = false;
   {
-    auto renameLock = getMount()->acquireRenameLock();
-    materialize(&renameLock);
-    if (destParent.get() != this) {
-      destParent->materialize(&renameLock);
-    }
-
-    // Acquire the locks required to do the rename
+    // Acquire the locks required to do the rename.  Only renames moving a
+    // directory to another parent need to exclude all other renames.
     TreeRenameLocks locks;
-    locks.acquireLocks(std::move(renameLock), this, destParent.get(), destName);
+    if (!locks.tryAcquireSharedLocks(
+            getMount()->acquireSharedRenameLock(),
+            this,
+            name,
+            destParent.get(),
+            destName)) {
+      auto renameLock = getMount()->acquireRenameLock();
+      materialize(&renameLock);
+      if (destParent.get() != this) {
+        destParent->materialize(&renameLock);
+      }
+      locks.acquireLocks(
+          std::move(renameLock), this, destParent.get(), destName);
+    }
 
     // Look up the source entry.  The destination entry info was already
     // loaded by TreeRenameLocks::acquireLocks().
@@ -2002,19 +2465,6 @@ ImmediateFuture<Unit> TreeInode::rename(
   }
 }
 
-namespace {
-bool isAncestor(const RenameLock& renameLock, TreeInode* a, TreeInode* b) {
-  auto parent = b->getParent(renameLock);
-  while (parent) {
-    if (parent.get() == a) {
-      return true;
-    }
-    parent = parent->getParent(renameLock);
-  }
-  return false;
-}
-} // namespace
-
 ImmediateFuture<Unit> TreeInode::doRename(
     TreeRenameLocks&& locks,
     PathComponentPiece srcName,
@@ -2045,7 +2495,7 @@ ImmediateFuture<Unit> TreeInode::doRename(
     auto* srcTreeInode =
         boost::polymorphic_downcast<TreeInode*>(srcEntry.getInode());
     if (srcTreeInode == destParent.get() ||
-        isAncestor(locks.renameLock(), srcTreeInode, destParent.get())) {
+        locks.isAncestor(srcTreeInode, destParent.get())) {
       return ImmediateFuture<Unit>{
           folly::Try<Unit>{InodeError{EINVAL, destParent, destName}}};
     }
@@ -2075,8 +2525,8 @@ ImmediateFuture<Unit> TreeInode::doRename(
   auto* childInode = srcEntry.getInode();
   bool destChildExists = locks.destChildExists();
   if (destChildExists) {
-    deletedInode = locks.destChild()->markUnlinked(
-        destParent.get(), destName, locks.renameLock());
+    deletedInode =
+        locks.markUnlinked(locks.destChild(), destParent.get(), destName);
 
     // Replace the destination contents entry with the source data
     locks.destChildIter()->second = std::move(srcIter->second);
@@ -2094,7 +2544,7 @@ ImmediateFuture<Unit> TreeInode::doRename(
   }
 
   // Inform the child inode that it has been moved
-  childInode->updateLocation(destParent, destName, locks.renameLock());
+  locks.updateLocation(childInode, destParent, destName);
 
   // Now remove the source information
   locks.srcContents()->erase(srcIter);
@@ -2117,7 +2567,13 @@ ImmediateFuture<Unit> TreeInode::doRename(
   // We keep holding the mount point rename lock for now though.  This ensures
   // that rename and deletion events do show up in the journal in the correct
   // order.
-  locks.releaseAllButRename();
+  //
+  // Holding it in shared mode does not keep other renames out, so in that
+  // case keep the TreeInode locks instead: the next change to these entries
+  // cannot be journaled before this one.
+  if (!locks.holdsSharedRenameLock()) {
+    locks.releaseAllButRename();
+  }
 
   // Add a journal entry
   auto srcPath = getPath();
@@ -2207,6 +2663,55 @@ void TreeInode::TreeRenameLocks::acquireLocks(
   }
 }
 
+bool TreeInode::TreeRenameLocks::tryAcquireSharedLocks(
+    SharedRenameLock&& renameLock,
+    TreeInode* srcTree,
+    PathComponentPiece srcName,
+    TreeInode* destTree,
+    PathComponentPiece destName) {
+  sharedRenameLock_.emplace(std::move(renameLock));
+
+  if (srcTree == destTree) {
+    srcContentsLock_ = srcTree->contents_.wlock();
+    srcContents_ = &srcContentsLock_->entries;
+    destContents_ = &srcContentsLock_->entries;
+    if (!srcContentsLock_->isMaterialized()) {
+      reset();
+      return false;
+    }
+    lockDestChild(destName);
+    return true;
+  }
+
+  // Directories can't change parent while the rename lock is held, so the
+  // order is stable.  Other renames may be locking these same directories, so
+  // unlike acquireLocks() there is no order to choose freely here.
+  auto srcOrder = getRenameLockOrder(*sharedRenameLock_, srcTree);
+  auto destOrder = getRenameLockOrder(*sharedRenameLock_, destTree);
+  if (srcOrder < destOrder) {
+    srcContentsLock_ = srcTree->contents_.wlock();
+    destContentsLock_ = destTree->contents_.wlock();
+  } else {
+    destContentsLock_ = destTree->contents_.wlock();
+    srcContentsLock_ = srcTree->contents_.wlock();
+  }
+  srcContents_ = &srcContentsLock_->entries;
+  destContents_ = &destContentsLock_->entries;
+
+  auto srcIter = srcContents_->find(srcName);
+  if (!srcContentsLock_->isMaterialized() ||
+      !destContentsLock_->isMaterialized() ||
+      (srcIter != srcContents_->end() && srcIter->second.isDirectory())) {
+    reset();
+    return false;
+  }
+  // The source is not a directory, so the rename fails if the destination
+  // is one: its contents are not needed, and locking them here would break
+  // the order above.
+  destChildIter_ = destContents_->find(destName);
+  return true;
+}
+
 void TreeInode::TreeRenameLocks::lockDestChild(PathComponentPiece destName) {
   // Look up the destination child entry
   destChildIter_ = destContents_->find(destName);
@@ -2300,6 +2805,75 @@ bool TreeInode::readdirImpl(
   auto dir = contents_.rlock();
   auto& entries = dir->entries;
 
+  // Tools that list a directory usually go on to look up all of its entries,
+  // so load all the children on the first lookup following the listing.
+  auto batchLoadMaxEntries = getMount()
+                                 ->getServerState()
+                                 ->getEdenConfig()
+                                 ->batchLoadAfterReaddirMaxEntries.getValue();
+  if (batchLoadMaxEntries > 0 && entries.size() <= batchLoadMaxEntries) {
+    batchLoadOnNextLookup_.store(true, std::memory_order_relaxed);
+  }
+
+  // A listing of a large directory sorts its entries once, when it starts,
+  // and the following pages binary search their offset in that order. Entries
+  // removed or replaced since then are skipped, entries added since then are
+  // not listed, both of which POSIX allows.
+  std::shared_ptr<const ReaddirIndex> readdirIndex;
+  auto readdirIndexMinEntries = getMount()
+                                    ->getServerState()
+                                    ->getEdenConfig()
+                                    ->readdirIndexMinEntries.getValue();
+  if (off <= 2) {
+    if (readdirIndexMinEntries > 0 &&
+        entries.size() >= readdirIndexMinEntries) {
+      auto index = std::make_shared<ReaddirIndex>();
+      index->reserve(entries.size());
+      for (auto& [name, entry] : entries) {
+        index->emplace_back(entry.getInodeNumber(), name);
+      }
+      std::sort(
+          index->begin(), index->end(), [](const auto& a, const auto& b) {
+            return a.first < b.first;
+          });
+      readdirIndex = std::move(index);
+      *readdirIndex_.wlock() = readdirIndex;
+    }
+  } else {
+    readdirIndex = readdirIndex_.copy();
+  }
+
+  if (readdirIndex) {
+    auto it = readdirIndex->begin();
+    if (off > 2) {
+      it = std::upper_bound(
+          readdirIndex->begin(),
+          readdirIndex->end(),
+          InodeNumber{static_cast<uint64_t>(off - 2)},
+          [](InodeNumber ino, const auto& indexEntry) {
+            return ino < indexEntry.first;
+          });
+    }
+    for (; it != readdirIndex->end(); ++it) {
+      auto entry = entries.find(it->second);
+      if (entry == entries.end() ||
+          entry->second.getInodeNumber() != it->first) {
+        continue;
+      }
+      if (!add(entry->first.view(),
+               entry->second,
+               entry->second.getInodeNumber().get() + 2)) {
+        return false;
+      }
+    }
+
+    auto currentIndex = readdirIndex_.wlock();
+    if (*currentIndex == readdirIndex) {
+      currentIndex->reset();
+    }
+    return true;
+  }
+
   // Compute an index into the PathMap by InodeNumber, only including the
   // entries that are greater than the given offset.
   std::vector<std::pair<InodeNumber, size_t>> indices;
@@ -2343,6 +2917,23 @@ FuseDirList TreeInode::fuseReaddir(
   return std::move(list);
 }
 
+#ifdef __linux__
+FuseDirPlusList TreeInode::fuseReaddirPlus(
+    FuseDirPlusList&& list,
+    off_t off,
+    const ObjectFetchContextPtr& context) {
+  readdirImpl(
+      off,
+      context,
+      [&list](StringPiece name, const DirEntry& entry, uint64_t offset) {
+        return list.add(
+            name, entry.getInodeNumber().get(), entry.getDtype(), offset);
+      });
+
+  return std::move(list);
+}
+#endif
+
 std::tuple<NfsDirList, bool> TreeInode::nfsReaddir(
     NfsDirList&& list,
     off_t off,
@@ -2518,6 +3109,7 @@ ImmediateFuture<Unit> TreeInode::loadGitIgnoreThenDiff(
     std::vector<shared_ptr<const Tree>> trees,
     const GitIgnoreStack* parentIgnore,
     bool isIgnored) {
+  using GitIgnorePtr = std::shared_ptr<const GitIgnore>;
   return makeImmediateFutureWith([gitignoreInode = std::move(gitignoreInode),
                                   context] {
            auto fileInode = gitignoreInode.asFileOrNull();
@@ -2525,16 +3117,33 @@ ImmediateFuture<Unit> TreeInode::loadGitIgnoreThenDiff(
              XLOG(WARN)
                  << "loadGitIgnoreThenDiff() invoked with a non-file inode: "
                  << gitignoreInode->getLogPath();
-             return makeImmediateFuture<std::string>(
+             return makeImmediateFuture<GitIgnorePtr>(
                  InodeError(EISDIR, gitignoreInode));
            } else {
 #ifndef _WIN32
              if (fileInode->getType() == dtype_t::Symlink) {
-               return makeImmediateFuture<std::string>(
+               return makeImmediateFuture<GitIgnorePtr>(
                    InodeError(EMLINK, gitignoreInode));
              }
 #endif
-             return fileInode->readAll(context->getFetchContext());
+             // Unmodified .gitignore files don't need to be read if an earlier
+             // diff already parsed their blob.
+             auto blobHash = fileInode->getBlobHash();
+             if (blobHash) {
+               if (auto cached = context->getCachedGitIgnore(*blobHash)) {
+                 return ImmediateFuture<GitIgnorePtr>{std::move(cached)};
+               }
+             }
+             return fileInode->readAll(context->getFetchContext())
+                 .thenValue([fileInode, blobHash, context](
+                                std::string contents) {
+                   // The file is identified by the hash of its contents if
+                   // it was modified, even while it was read.
+                   auto id = blobHash && fileInode->getBlobHash() == blobHash
+                       ? *blobHash
+                       : ObjectId::sha1(contents);
+                   return context->parseGitIgnore(id, contents);
+                 });
            }
          })
       .thenTry([self = inodePtrFromThis(),
@@ -2542,21 +3151,20 @@ ImmediateFuture<Unit> TreeInode::loadGitIgnoreThenDiff(
                 currentPath = RelativePath{currentPath}, // deep copy
                 trees = std::move(trees),
                 parentIgnore,
-                isIgnored](
-                   folly::Try<std::string> ignoreFileContentsTry) mutable {
-        std::string ignoreFileContents;
-        if (ignoreFileContentsTry.hasException()) {
+                isIgnored](folly::Try<GitIgnorePtr> ignoreTry) mutable {
+        GitIgnorePtr ignore;
+        if (ignoreTry.hasException()) {
           XLOG(WARN) << "error reading ignore file: "
-                     << folly::exceptionStr(ignoreFileContentsTry.exception());
+                     << folly::exceptionStr(ignoreTry.exception());
         } else {
-          ignoreFileContents = std::move(ignoreFileContentsTry).value();
+          ignore = std::move(ignoreTry).value();
         }
         return self->computeDiff(
             self->contents_.wlock(),
             context,
             currentPath,
             std::move(trees),
-            make_unique<GitIgnoreStack>(parentIgnore, ignoreFileContents),
+            make_unique<GitIgnoreStack>(parentIgnore, std::move(ignore)),
             isIgnored);
       });
 }
@@ -2706,6 +3314,23 @@ ImmediateFuture<Unit> TreeInode::computeDiff(
                                   DirEntry* inodeEntry) {
       XCHECK_GT(scmEntries.size(), 0ull);
 
+      // Materializing an inode materializes all of its parents, so the entry
+      // of a directory with no changes below it keeps its source control
+      // hash. Skip such directories without diffing them even when they are
+      // loaded, which most directories that were only listed or read from
+      // are.
+      if (inodeEntry->isDirectory() && !inodeEntry->isMaterialized()) {
+        for (const auto& scmEntry : scmEntries) {
+          if (scmEntry.isTree() &&
+              getObjectStore().areObjectsKnownIdentical(
+                  inodeEntry->getHash(), scmEntry.getHash())) {
+            XLOG(DBG9) << "diff: unchanged directory: "
+                       << currentPath + componentPath;
+            return;
+          }
+        }
+      }
+
       // We only need to know the ignored status if this is a directory.
       // If this is a regular file on disk and in source control, then it
       // is always included since it is already tracked in source control.
@@ -3003,6 +3628,8 @@ Future<Unit> TreeInode::checkout(
       actions,
       pendingLoads,
       wasDirectoryListModified);
+  ctx->recordTreeCompared();
+  ctx->recordActionsStarted(actions.size());
 
   // Wire up the callbacks for any pending inode loads we started
   for (auto& load : pendingLoads) {
@@ -3034,6 +3661,8 @@ Future<Unit> TreeInode::checkout(
            actions = std::move(actions),
            wasDirectoryListModified](
               vector<folly::Try<InvalidationRequired>> actionResults) mutable {
+            ctx->recordActionsCompleted(actionResults.size());
+
             // Record any errors that occurred
             size_t numErrors = 0;
             for (size_t n = 0; n < actionResults.size(); ++n) {
@@ -3081,6 +3710,7 @@ Future<Unit> TreeInode::checkout(
                                        numErrors](auto&&) {
                              // Update our state in the overlay
                              self->saveOverlayPostCheckout(ctx, toTree.get());
+                             ctx->recordTreeSaved();
 
                              XLOG(DBG4) << "checkout: finished update of "
                                         << self->getLogPath() << ": "
@@ -3623,7 +4253,14 @@ Future<InvalidationRequired> TreeInode::checkoutUpdateEntry(
       // permissions never being changed during the checkout operation. We
       // would need to be more clever with our invalidation hack for NFS if we
       // supported changing permissions on checkout.
-      return treeInode->checkout(ctx, std::move(oldTree), std::move(newTree))
+      return ctx
+          ->checkoutSubtree([ctx,
+                             treeInode = std::move(treeInode),
+                             oldTree = std::move(oldTree),
+                             newTree = std::move(newTree)]() mutable {
+            return treeInode->checkout(
+                ctx, std::move(oldTree), std::move(newTree));
+          })
           .thenValue([](folly::Unit) { return InvalidationRequired::No; });
     }
   }
@@ -3632,7 +4269,11 @@ Future<InvalidationRequired> TreeInode::checkoutUpdateEntry(
   // First we have to recursively unlink everything inside the directory.
   // Fortunately, calling checkout() with an empty destination tree does
   // exactly what we want.
-  return treeInode->checkout(ctx, std::move(oldTree), nullptr)
+  return ctx
+      ->checkoutSubtree(
+          [ctx, treeInode, oldTree = std::move(oldTree)]() mutable {
+            return treeInode->checkout(ctx, std::move(oldTree), nullptr);
+          })
       .thenValue(
           [ctx,
            newTree = std::move(newTree),
@@ -3766,6 +4407,20 @@ bool needDecFsRefcount(InodeMap& inodeMap, InodeNumber ino) {
   return inodeMap.isInodeLoadedOrRemembered(ino);
 }
 } // namespace
+#else
+namespace {
+/**
+ * Test if the kernel may cache the attributes or entries of this directory.
+ * When it doesn't hold a reference to the inode, it has forgotten all about
+ * it. The root is never looked up, but always referenced.
+ */
+bool mayBeCachedByFuse(const TreeInode& inode) {
+  return inode.getNodeId() == kRootNodeId || inode.hasFsReferencesRacy() ||
+      !inode.getMount()
+           ->getEdenConfig()
+           ->fuseSkipUnreferencedInvalidations.getValue();
+}
+} // namespace
 #endif
 
 folly::Try<folly::Unit> TreeInode::invalidateChannelEntryCache(
@@ -3774,7 +4429,11 @@ folly::Try<folly::Unit> TreeInode::invalidateChannelEntryCache(
     FOLLY_MAYBE_UNUSED std::optional<InodeNumber> ino) {
 #ifndef _WIN32
   if (auto* fuseChannel = getMount()->getFuseChannel()) {
-    fuseChannel->invalidateEntry(getNodeId(), name);
+    // Negative entries are cached too, so this depends on the directory
+    // rather than on the child.
+    if (mayBeCachedByFuse(*this)) {
+      fuseChannel->invalidateEntry(getNodeId(), name);
+    }
   }
   // For NFS, the entry cache is flushed when the directory mtime is changed.
   // Directly invalidating an entry is not possible.
@@ -3816,7 +4475,9 @@ ImmediateFuture<folly::Unit> TreeInode::invalidateChannelDirCache(
     // FUSE_NOTIFY_INVAL_ENTRY is the appropriate invalidation function
     // when an entry is removed or modified. But when new entries are
     // added, the inode itself must be invalidated.
-    fuseChannel->invalidateInode(getNodeId(), 0, 0);
+    if (mayBeCachedByFuse(*this)) {
+      fuseChannel->invalidateInode(getNodeId(), 0, 0);
+    }
   } else if (auto* nfsdChannel = getMount()->getNfsdChannel()) {
     const auto path = getPath();
     if (path.has_value()) {
@@ -4357,6 +5018,146 @@ size_t TreeInode::unloadChildrenLastAccessedBefore(const timespec& cutoff) {
       });
 }
 
+ImmediateFuture<Unit> TreeInode::dematerializeUnchangedChildren(
+    std::shared_ptr<const Tree> scmTree,
+    std::shared_ptr<DematerializePass> pass,
+    const ObjectFetchContextPtr& context) {
+  struct Candidate {
+    PathComponent name;
+    InodeNumber ino;
+    ObjectId scmId;
+    TreeEntryType scmType;
+  };
+  std::vector<Candidate> files;
+  std::vector<Candidate> dirs;
+  {
+    auto contents = contents_.rlock();
+    for (const auto& [name, entry] : contents->entries) {
+      if (!entry.isMaterialized()) {
+        continue;
+      }
+      auto scmEntry = scmTree->find(name);
+      if (scmEntry == scmTree->end() ||
+          entry.isDirectory() != scmEntry->second.isTree()) {
+        continue;
+      }
+      if (!entry.isDirectory() && entry.getInode()) {
+        // Loaded files may be in use, only idle ones are dematerialized.
+        continue;
+      }
+      auto& candidates = entry.isDirectory() ? dirs : files;
+      candidates.push_back(Candidate{
+          name,
+          entry.getInodeNumber(),
+          scmEntry->second.getHash(),
+          scmEntry->second.getType()});
+    }
+  }
+
+  std::vector<ImmediateFuture<Unit>> futures;
+  auto* metadataTable = getMount()->getInodeMetadataTable();
+  auto* overlayFileAccess = getMount()->getOverlayFileAccess();
+  for (auto& file : files) {
+    auto metadata = metadataTable->getOptional(file.ino);
+    if (!metadata || treeEntryTypeFromMode(metadata->mode) != file.scmType ||
+        !pass->shouldCheck(file.ino, metadata->timestamps.mtime)) {
+      continue;
+    }
+
+    Hash20 sha1;
+    try {
+      auto size = overlayFileAccess->getFileSize(file.ino, nullptr);
+      if (!pass->tryStartCheck(static_cast<uint64_t>(size))) {
+        break;
+      }
+      sha1 = overlayFileAccess->getSha1(file.ino, nullptr);
+    } catch (const std::exception& ex) {
+      XLOG(DBG2) << "unable to hash " << getLogPath() << "/" << file.name
+                 << " to compare it with source control: "
+                 << folly::exceptionStr(ex);
+      continue;
+    }
+
+    auto mtime = metadata->timestamps.mtime;
+    futures.push_back(
+        getObjectStore()
+            .getBlobSha1(file.scmId, context)
+            .thenValue([self = inodePtrFromThis(),
+                        pass,
+                        file = std::move(file),
+                        sha1,
+                        mtime](const Hash20& scmSha1) {
+              if (scmSha1 != sha1) {
+                pass->recordDifferent(file.ino, mtime);
+              } else if (self->tryDematerializeChild(
+                             file.name, file.ino, file.scmId, sha1)) {
+                pass->recordDematerialized();
+              }
+            }));
+  }
+
+  for (auto& dir : dirs) {
+    if (pass->isRateLimited()) {
+      break;
+    }
+    futures.push_back(
+        getOrLoadChildTree(dir.name, context)
+            .thenValue([pass, scmId = dir.scmId, context = context.copy()](
+                           TreeInodePtr child) {
+              return child->getObjectStore()
+                  .getTree(scmId, context)
+                  .thenValue([child, pass, context = context.copy()](
+                                 std::shared_ptr<const Tree> tree) {
+                    return child->dematerializeUnchangedChildren(
+                        std::move(tree), pass, context);
+                  });
+            }));
+  }
+
+  return collectAll(std::move(futures))
+      .thenValue([self = inodePtrFromThis()](
+                     std::vector<folly::Try<Unit>> results) {
+        for (const auto& result : results) {
+          if (result.hasException()) {
+            XLOG(DBG2) << "error dematerializing unchanged files under "
+                       << self->getLogPath() << ": "
+                       << folly::exceptionStr(result.exception());
+          }
+        }
+      });
+}
+
+bool TreeInode::tryDematerializeChild(
+    PathComponentPiece name,
+    InodeNumber ino,
+    const ObjectId& scmId,
+    const Hash20& sha1) {
+  {
+    auto contents = contents_.wlock();
+    auto it = contents->entries.find(name);
+    if (it == contents->entries.end() || !it->second.isMaterialized() ||
+        it->second.getInode() || it->second.getInodeNumber() != ino) {
+      return false;
+    }
+
+    // The file may have been loaded and written to since it was hashed. The
+    // SHA-1 is only recomputed if it was. Holding the contents lock keeps the
+    // inode from being loaded again.
+    auto* overlayFileAccess = getMount()->getOverlayFileAccess();
+    if (overlayFileAccess->getSha1(ino, nullptr) != sha1) {
+      return false;
+    }
+    overlayFileAccess->closeFile(ino);
+    it->second = DirEntry{it->second.getInitialMode(), ino, scmId};
+    saveOverlayDir(contents->entries);
+  }
+
+  // Like childDematerialized(), only remove the overlay file once the
+  // directory no longer refers to it.
+  getOverlay()->removeOverlayFile(ino);
+  return true;
+}
+
 InodeMetadata TreeInode::getMetadata() const {
   auto lock = contents_.rlock();
   return getMetadataLocked(lock->entries);
@@ -4382,15 +5183,30 @@ void TreeInode::prefetch(const ObjectFetchContextPtr& context) {
                << ": metadata prefetching is turned on in the backing store";
     return;
   }
+  auto* mount = getMount();
+  auto& policy = mount->getReaddirPrefetchPolicy();
+  if (!policy.recordListing(
+          context->getClientPid(),
+          getNodeId(),
+          config->adaptiveTreePrefetch.getValue())) {
+    XLOG(DBG4) << "skipping prefetch for " << getLogPath()
+               << ": the listings of this process rarely lead to lookups";
+    mount->getStats()->increment(&InodeStats::readdirPrefetchSkipped);
+    prefetched_.store(false);
+    return;
+  }
   auto prefetchLease =
-      getMount()->tryStartTreePrefetch(inodePtrFromThis(), *context);
+      mount->tryStartTreePrefetch(inodePtrFromThis(), *context);
   if (!prefetchLease) {
     XLOG(DBG3) << "skipping prefetch for " << getLogPath()
                << ": too many prefetches already in progress";
+    mount->getStats()->increment(&InodeStats::readdirPrefetchThrottled);
     prefetched_.store(false);
     return;
   }
   XLOG(DBG4) << "starting prefetch for " << getLogPath();
+  policy.recordPrefetch(context->getClientPid(), getNodeId());
+  mount->getStats()->increment(&InodeStats::readdirPrefetchIssued);
 
   folly::via(
       getMount()->getServerThreadPool().get(),
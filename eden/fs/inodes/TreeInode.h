@@ -14,17 +14,21 @@
 #include "eden/fs/inodes/CheckoutAction.h"
 #include "eden/fs/inodes/DirEntry.h"
 #include "eden/fs/inodes/InodeBase.h"
+#include "eden/fs/inodes/InodeLoadTiming.h"
 #include "eden/fs/utils/PathFuncs.h"
 
 namespace facebook::eden {
 
 class CheckoutAction;
 class CheckoutContext;
+class DematerializePass;
 class DiffContext;
 class FuseDirList;
+class FuseDirPlusList;
 class NfsDirList;
 class EdenMount;
 class GitIgnoreStack;
+class Hash20;
 class DiffCallback;
 class InodeMap;
 class ObjectStore;
@@ -196,6 +200,17 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
       off_t off,
       const ObjectFetchContextPtr& context);
 
+#ifdef __linux__
+  /**
+   * Like fuseReaddir(), but the attributes of the entries are left empty for
+   * the caller to fill in.
+   */
+  FuseDirPlusList fuseReaddirPlus(
+      FuseDirPlusList&& list,
+      off_t off,
+      const ObjectFetchContextPtr& context);
+#endif
+
   /**
    * Populate the list with as many directory entries as possible starting from
    * the inode start.
@@ -443,6 +458,20 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    * Returns the number of inodes unloaded.
    */
   size_t unloadChildrenLastAccessedBefore(const timespec& cutoff);
+
+  /**
+   * Dematerialize the materialized files under this tree whose contents and
+   * type match the corresponding entry of scmTree, the source control tree
+   * at the same path in the checked out commit.
+   *
+   * Only the files whose inodes aren't loaded are considered, and
+   * subdirectories are visited concurrently. Errors are logged and the file
+   * or directory skipped.
+   */
+  ImmediateFuture<folly::Unit> dematerializeUnchangedChildren(
+      std::shared_ptr<const Tree> scmTree,
+      std::shared_ptr<DematerializePass> pass,
+      const ObjectFetchContextPtr& context);
 #endif
 
   /**
@@ -517,20 +546,27 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    */
   InodeMap* getInodeMap() const;
 
+  /**
+   * A child inode that finished loading, along with how long each phase of
+   * its load took.
+   */
+  struct LoadedChild {
+    std::unique_ptr<InodeBase> inode;
+    InodeLoadTiming timing;
+  };
+
   void registerInodeLoadComplete(
-      folly::Future<std::unique_ptr<InodeBase>>& future,
+      folly::Future<LoadedChild>& future,
       PathComponentPiece name,
       InodeNumber number);
-  void inodeLoadComplete(
-      PathComponentPiece childName,
-      std::unique_ptr<InodeBase> childInode);
+  void inodeLoadComplete(PathComponentPiece childName, LoadedChild child);
 
-  folly::Future<std::unique_ptr<InodeBase>> startLoadingInodeNoThrow(
+  folly::Future<LoadedChild> startLoadingInodeNoThrow(
       const DirEntry& entry,
       PathComponentPiece name,
       const ObjectFetchContextPtr& context) noexcept;
 
-  folly::Future<std::unique_ptr<InodeBase>> startLoadingInode(
+  folly::Future<LoadedChild> startLoadingInode(
       const DirEntry& entry,
       PathComponentPiece name,
       const ObjectFetchContextPtr& context);
@@ -563,6 +599,21 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    */
   void saveOverlayDir(const DirContents& contents) const;
 
+#ifndef _WIN32
+  /**
+   * Replace the materialized, unloaded entry `name` with a dematerialized
+   * entry for scmId, and remove its overlay file, if it is still inode `ino`
+   * and its contents still hash to sha1.
+   *
+   * Returns whether the entry was dematerialized.
+   */
+  bool tryDematerializeChild(
+      PathComponentPiece name,
+      InodeNumber ino,
+      const ObjectId& scmId,
+      const Hash20& sha1);
+#endif
+
   /**
    * Saves the entries for a specified inode number.
    */
@@ -622,6 +673,16 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
       InvalidationRequired invalidate,
       std::chrono::system_clock::time_point startTime);
 
+  /**
+   * removeAllChildrenRecursively() without waiting for the invalidation of the
+   * directory caches, which are added to invalidations instead.
+   */
+  void removeAllChildrenRecursivelyImpl(
+      InvalidationRequired invalidate,
+      const ObjectFetchContextPtr& context,
+      const RenameLock& renameLock,
+      std::vector<ImmediateFuture<folly::Unit>>& invalidations);
+
   /**
    * removeImpl() is the actual implementation used for unlink() and rmdir().
    *
@@ -834,7 +895,7 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
     // yet, then we need to register the inode load, so that someone will take
     // care of the cleanup after loading the inode. This future will be valid if
     // we are the ones responsible for the inode load.
-    folly::Future<std::unique_ptr<InodeBase>> inodeLoadFuture;
+    folly::Future<LoadedChild> inodeLoadFuture;
 
     // If we are the ones responsible for the inode load and the load is
     // complete, then these are the promises we need to notify.
@@ -859,6 +920,30 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
       PathComponentPiece name,
       const ObjectFetchContextPtr& context);
 
+  /**
+   * Same as loadChild() for each of names, which must all be unloaded
+   * children of this directory. The InodeMap is updated once for all of them
+   * rather than once per child, and the loads are started back to back so
+   * that their fetches are queued together.
+   */
+  std::vector<std::pair<folly::SemiFuture<InodePtr>, LoadChildCleanUp>>
+  loadChildren(
+      folly::Synchronized<TreeInodeState>::LockedPtr& contents,
+      const std::vector<PathComponent>& names,
+      const ObjectFetchContextPtr& context);
+
+  /**
+   * Loads the child name along with all the other unloaded children of this
+   * directory, for the first lookup following a readdir. Same contract as
+   * loadChild(), except that the clean ups of all the loaded children are
+   * appended to cleanUps; the first one is for name.
+   */
+  folly::SemiFuture<InodePtr> loadChildWithSiblings(
+      folly::Synchronized<TreeInodeState>::LockedPtr& contents,
+      PathComponentPiece name,
+      const ObjectFetchContextPtr& context,
+      std::vector<std::pair<PathComponent, LoadChildCleanUp>>& cleanUps);
+
   /**
    * Handles the inode loading related clean up for a wlockGetOrFindChild call.
    * This should be called without the contents lock held!
@@ -871,6 +956,20 @@ class TreeInode final : public InodeBaseMetadata<DirContents> {
    * Only prefetch blob metadata on the first readdir() of a loaded inode.
    */
   std::atomic<bool> prefetched_{false};
+
+  /**
+   * Set by readdir() when the next lookup should load all the unloaded
+   * children, see the mount:batch-load-after-readdir-max-entries config.
+   */
+  std::atomic<bool> batchLoadOnNextLookup_{false};
+
+  /**
+   * The names of the entries of a large directory, sorted by inode number
+   * when its current listing started, see the mount:readdir-index-min-entries
+   * config. Dropped when a listing reaches the end of the directory.
+   */
+  using ReaddirIndex = std::vector<std::pair<InodeNumber, PathComponent>>;
+  folly::Synchronized<std::shared_ptr<const ReaddirIndex>> readdirIndex_;
 };
 
 /**
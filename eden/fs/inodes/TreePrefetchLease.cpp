@@ -13,7 +13,8 @@ namespace facebook::eden {
 
 void TreePrefetchLease::release() noexcept {
   if (inode_) {
-    inode_->getMount()->treePrefetchFinished();
+    inode_->getMount()->treePrefetchFinished(
+        std::chrono::steady_clock::now() - start_);
   }
 }
 
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <chrono>
+
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/store/ObjectFetchContext.h"
@@ -21,7 +23,8 @@ namespace facebook::eden {
  * EdenMount::tryStartTreePrefetch() to obtain a prefetch lease.  If it obtains
  * a lease it can perform the prefetch, and should hold the TreePrefetchLease
  * object around until the prefetch completes.  When the TreePrefetchLease is
- * destroyed this will inform the EdenMount that the prefetch is complete.
+ * destroyed this will inform the EdenMount that the prefetch is complete, and
+ * how long it took.
  */
 class TreePrefetchLease {
   class TreePrefetchContext : public ObjectFetchContext {
@@ -62,12 +65,15 @@ class TreePrefetchLease {
     release();
   }
   TreePrefetchLease(TreePrefetchLease&& lease) noexcept
-      : inode_{std::move(lease.inode_)}, context_(std::move(lease.context_)) {}
+      : inode_{std::move(lease.inode_)},
+        context_(std::move(lease.context_)),
+        start_{lease.start_} {}
   TreePrefetchLease& operator=(TreePrefetchLease&& lease) noexcept {
     if (&lease != this) {
       release();
       inode_ = std::move(lease.inode_);
       context_ = std::move(lease.context_);
+      start_ = lease.start_;
     }
     return *this;
   }
@@ -89,6 +95,9 @@ class TreePrefetchLease {
   TreeInodePtr inode_;
 
   ObjectFetchContextPtr context_;
+
+  std::chrono::steady_clock::time_point start_ =
+      std::chrono::steady_clock::now();
 };
 
 } // namespace facebook::eden
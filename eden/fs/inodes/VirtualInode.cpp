@@ -26,6 +26,13 @@ InodePtr VirtualInode::asInodePtr() const {
   return std::get<InodePtr>(variant_);
 }
 
+InodePtr VirtualInode::getInodePtrOrNull() const {
+  if (auto* inode = std::get_if<InodePtr>(&variant_)) {
+    return *inode;
+  }
+  return nullptr;
+}
+
 // Helper template for std::visit calls below
 template <class>
 inline constexpr bool always_false_v = false;
@@ -190,11 +197,50 @@ ImmediateFuture<BlobMetadata> VirtualInode::getBlobMetadata(
       variant_);
 }
 
+std::optional<ObjectId> VirtualInode::getUnloadedBlobId() const {
+  return std::visit(
+      [](auto&& arg) -> std::optional<ObjectId> {
+        using T = std::decay_t<decltype(arg)>;
+        if constexpr (
+            std::is_same_v<T, UnmaterializedUnloadedBlobDirEntry> ||
+            std::is_same_v<T, TreeEntry>) {
+          return arg.getHash();
+        } else {
+          return std::nullopt;
+        }
+      },
+      variant_);
+}
+
 ImmediateFuture<EntryAttributes> VirtualInode::getEntryAttributes(
     EntryAttributeFlags requestedAttributes,
     RelativePathPiece path,
     ObjectStore* objectStore,
     const ObjectFetchContextPtr& fetchContext) const {
+  return getEntryAttributesImpl(
+      requestedAttributes,
+      path,
+      [&] { return getBlobMetadata(path, objectStore, fetchContext); },
+      fetchContext);
+}
+
+ImmediateFuture<EntryAttributes> VirtualInode::getEntryAttributes(
+    EntryAttributeFlags requestedAttributes,
+    RelativePathPiece path,
+    folly::Try<BlobMetadata> blobMetadata,
+    const ObjectFetchContextPtr& fetchContext) const {
+  return getEntryAttributesImpl(
+      requestedAttributes,
+      path,
+      [&] { return ImmediateFuture<BlobMetadata>{std::move(blobMetadata)}; },
+      fetchContext);
+}
+
+ImmediateFuture<EntryAttributes> VirtualInode::getEntryAttributesImpl(
+    EntryAttributeFlags requestedAttributes,
+    RelativePathPiece path,
+    folly::FunctionRef<ImmediateFuture<BlobMetadata>()> getBlobMetadata,
+    const ObjectFetchContextPtr& fetchContext) const {
   std::optional<folly::Try<Hash20>> sha1;
   std::optional<folly::Try<uint64_t>> size;
   std::optional<folly::Try<TreeEntryType>> type;
@@ -244,7 +290,7 @@ ImmediateFuture<EntryAttributes> VirtualInode::getEntryAttributes(
   // sha1 and size come together so, there isn't much point of splitting them up
   if (requestedAttributes.containsAnyOf(
           ENTRY_ATTRIBUTE_SIZE | ENTRY_ATTRIBUTE_SHA1)) {
-    blobMetadataFuture = getBlobMetadata(path, objectStore, fetchContext);
+    blobMetadataFuture = getBlobMetadata();
   }
 
   return collectAll(std::move(entryTypeFuture), std::move(blobMetadataFuture))
@@ -329,6 +375,9 @@ ImmediateFuture<struct stat> VirtualInode::stat(
             struct timespec ts0 {};
             stMtime(st, ts0);
           }
+#else
+          // Like TreeInode::stat, count the "." and ".." links.
+          st.st_nlink = arg->size() + 2;
 #endif
           st.st_size = 0U;
           return st;
@@ -343,6 +392,7 @@ ImmediateFuture<struct stat> VirtualInode::stat(
             .thenValue([mode, lastCheckoutTime](const BlobMetadata& metadata) {
               struct stat st = {};
               st.st_mode = static_cast<decltype(st.st_mode)>(mode);
+              st.st_nlink = 1;
               stMtime(st, lastCheckoutTime);
 #ifdef _WIN32
               // Windows returns zero for st_mode and mtime
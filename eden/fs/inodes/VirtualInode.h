@@ -8,8 +8,10 @@
 #pragma once
 
 #include <sys/stat.h>
+#include <optional>
 #include <variant>
 
+#include <folly/Function.h>
 #include <folly/String.h>
 
 #include "eden/fs/inodes/InodePtr.h"
@@ -78,6 +80,11 @@ class VirtualInode {
    */
   InodePtr asInodePtr() const;
 
+  /**
+   * Returns the contained InodePtr, or null if there is not one.
+   */
+  InodePtr getInodePtrOrNull() const;
+
   dtype_t getDtype() const;
 
   bool isDirectory() const;
@@ -135,6 +142,24 @@ class VirtualInode {
       ObjectStore* objectStore,
       const ObjectFetchContextPtr& fetchContext) const;
 
+  /**
+   * Like getEntryAttributes, with the metadata of the blob of a regular file
+   * already fetched, for instance as part of a batch. `blobMetadata` is
+   * ignored for the other types of entries.
+   */
+  ImmediateFuture<EntryAttributes> getEntryAttributes(
+      EntryAttributeFlags requestedAttributes,
+      RelativePathPiece path,
+      folly::Try<BlobMetadata> blobMetadata,
+      const ObjectFetchContextPtr& fetchContext) const;
+
+  /**
+   * Returns the id of the blob of a file whose inode isn't loaded, whose
+   * metadata can thus be fetched from the ObjectStore directly. Returns
+   * std::nullopt for loaded inodes and for trees.
+   */
+  std::optional<ObjectId> getUnloadedBlobId() const;
+
   /**
    * Emulate stat in a way that works for source control.
    *
@@ -188,6 +213,16 @@ class VirtualInode {
       ObjectStore* objectStore,
       const ObjectFetchContextPtr& fetchContext) const;
 
+  /**
+   * Implements getEntryAttributes, calling getBlobMetadata only if the entry
+   * is a regular file and its sha1 or size was requested.
+   */
+  ImmediateFuture<EntryAttributes> getEntryAttributesImpl(
+      EntryAttributeFlags requestedAttributes,
+      RelativePathPiece path,
+      folly::FunctionRef<ImmediateFuture<BlobMetadata>()> getBlobMetadata,
+      const ObjectFetchContextPtr& fetchContext) const;
+
   /**
    * The main object this encapsulates
    */
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/WriteBehindInodeCatalog.h"
+
+#include <folly/ExceptionString.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+#include <algorithm>
+#include <vector>
+
+namespace facebook::eden {
+
+WriteBehindInodeCatalog::WriteBehindInodeCatalog(
+    std::unique_ptr<InodeCatalog> inner,
+    std::chrono::nanoseconds delay,
+    size_t maxPending)
+    : inner_{std::move(inner)},
+      delay_{delay},
+      maxPending_{std::max(maxPending, size_t{1})} {
+  workerThread_ = std::thread{[this] {
+    folly::setThreadName("OverlayWriteBehind");
+    processOnWorkerThread();
+  }};
+}
+
+WriteBehindInodeCatalog::~WriteBehindInodeCatalog() {
+  stopWorkerThread();
+}
+
+std::optional<InodeNumber> WriteBehindInodeCatalog::initOverlay(
+    bool createIfNonExisting) {
+  return inner_->initOverlay(createIfNonExisting);
+}
+
+void WriteBehindInodeCatalog::close(
+    std::optional<InodeNumber> nextInodeNumber) {
+  // Write everything back before the underlying catalog records a clean
+  // shutdown.
+  stopWorkerThread();
+  inner_->close(nextInodeNumber);
+}
+
+bool WriteBehindInodeCatalog::initialized() const {
+  return inner_->initialized();
+}
+
+void WriteBehindInodeCatalog::stopWorkerThread() {
+  {
+    auto state = state_.lock();
+    if (state->stopRequested) {
+      return;
+    }
+    state->stopRequested = true;
+  }
+  workCV_.notify_one();
+  progressCV_.notify_all();
+  workerThread_.join();
+}
+
+void WriteBehindInodeCatalog::processOnWorkerThread() {
+  std::vector<std::pair<InodeNumber, std::unique_ptr<overlay::OverlayDir>>>
+      batch;
+  for (;;) {
+    {
+      auto state = state_.lock();
+      state->inflight.clear();
+      progressCV_.notify_all();
+
+      workCV_.wait(state.as_lock(), [&] {
+        return !state->order.empty() || state->stopRequested;
+      });
+      if (state->order.empty()) {
+        // Stop was requested and everything was written back.
+        state->workerStopped = true;
+        return;
+      }
+      // Give the directory being modified time to be saved again.
+      workCV_.wait_for(state.as_lock(), delay_, [&] {
+        return state->stopRequested || state->flushWaiters > 0;
+      });
+
+      batch.reserve(state->order.size());
+      for (const auto& [sequence, inodeNumber] : state->order) {
+        auto it = state->pending.find(inodeNumber);
+        batch.emplace_back(inodeNumber, std::move(it->second.odir));
+        state->inflight.insert(inodeNumber);
+        state->pending.erase(it);
+      }
+      state->order.clear();
+      progressCV_.notify_all();
+    }
+
+    for (auto& [inodeNumber, odir] : batch) {
+      try {
+        if (odir) {
+          inner_->saveOverlayDir(inodeNumber, std::move(*odir));
+        } else {
+          inner_->removeOverlayDir(inodeNumber);
+        }
+      } catch (const std::exception& ex) {
+        XLOG(ERR) << "failed to write back overlay directory " << inodeNumber
+                  << ": " << folly::exceptionStr(ex);
+      }
+    }
+    batch.clear();
+  }
+}
+
+void WriteBehindInodeCatalog::enqueue(
+    InodeNumber inodeNumber,
+    std::unique_ptr<overlay::OverlayDir> odir) {
+  auto state = state_.lock();
+  progressCV_.wait(state.as_lock(), [&] {
+    return state->stopRequested || state->pending.size() < maxPending_ ||
+        state->pending.count(inodeNumber);
+  });
+  if (state->workerStopped) {
+    // Nothing is pending anymore, write through.
+    state.unlock();
+    if (odir) {
+      inner_->saveOverlayDir(inodeNumber, std::move(*odir));
+    } else {
+      inner_->removeOverlayDir(inodeNumber);
+    }
+    return;
+  }
+
+  auto [it, inserted] = state->pending.try_emplace(inodeNumber);
+  if (!inserted) {
+    state->order.erase(it->second.sequence);
+  }
+  it->second.odir = std::move(odir);
+  // Moving the directory to the end of the queue keeps it behind the writes
+  // it may depend on.
+  it->second.sequence = state->nextSequence++;
+  state->order.emplace(it->second.sequence, inodeNumber);
+  workCV_.notify_one();
+}
+
+void WriteBehindInodeCatalog::waitForInflight(
+    LockedState& state,
+    InodeNumber inodeNumber) {
+  progressCV_.wait(
+      state.as_lock(), [&] { return !state->inflight.count(inodeNumber); });
+}
+
+void WriteBehindInodeCatalog::flush() {
+  auto state = state_.lock();
+  ++state->flushWaiters;
+  workCV_.notify_one();
+  progressCV_.wait(state.as_lock(), [&] {
+    return state->order.empty() && state->inflight.empty();
+  });
+  --state->flushWaiters;
+}
+
+std::optional<overlay::OverlayDir> WriteBehindInodeCatalog::loadOverlayDir(
+    InodeNumber inodeNumber) {
+  {
+    auto state = state_.lock();
+    auto it = state->pending.find(inodeNumber);
+    if (it != state->pending.end()) {
+      if (!it->second.odir) {
+        return std::nullopt;
+      }
+      return *it->second.odir;
+    }
+    waitForInflight(state, inodeNumber);
+  }
+  return inner_->loadOverlayDir(inodeNumber);
+}
+
+std::optional<overlay::OverlayDir>
+WriteBehindInodeCatalog::loadAndRemoveOverlayDir(InodeNumber inodeNumber) {
+  auto state = state_.lock();
+  auto it = state->pending.find(inodeNumber);
+  if (it == state->pending.end()) {
+    waitForInflight(state, inodeNumber);
+    state.unlock();
+    return inner_->loadAndRemoveOverlayDir(inodeNumber);
+  }
+  if (!it->second.odir) {
+    return std::nullopt;
+  }
+
+  // Turn the pending save into a removal, as the underlying catalog may hold
+  // an older version of the directory.
+  auto odir = std::move(it->second.odir);
+  state->order.erase(it->second.sequence);
+  it->second.sequence = state->nextSequence++;
+  state->order.emplace(it->second.sequence, inodeNumber);
+  workCV_.notify_one();
+  return std::move(*odir);
+}
+
+void WriteBehindInodeCatalog::saveOverlayDir(
+    InodeNumber inodeNumber,
+    overlay::OverlayDir&& odir) {
+  enqueue(
+      inodeNumber, std::make_unique<overlay::OverlayDir>(std::move(odir)));
+}
+
+void WriteBehindInodeCatalog::removeOverlayDir(InodeNumber inodeNumber) {
+  enqueue(inodeNumber, nullptr);
+}
+
+bool WriteBehindInodeCatalog::hasOverlayDir(InodeNumber inodeNumber) {
+  {
+    auto state = state_.lock();
+    auto it = state->pending.find(inodeNumber);
+    if (it != state->pending.end()) {
+      return it->second.odir != nullptr;
+    }
+    waitForInflight(state, inodeNumber);
+  }
+  return inner_->hasOverlayDir(inodeNumber);
+}
+
+void WriteBehindInodeCatalog::maintenance() {
+  inner_->maintenance();
+}
+
+} // namespace facebook::eden
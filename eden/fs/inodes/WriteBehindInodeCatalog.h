@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "eden/fs/inodes/InodeCatalog.h"
+
+namespace facebook::eden {
+
+/**
+ * An InodeCatalog that defers the directory saves and removals of another
+ * InodeCatalog to a worker thread, coalescing the repeated saves of a
+ * directory into a single write.
+ *
+ * Catalogs without semantic operations rewrite a whole directory on every
+ * change to it, so creating N files in a directory costs N rewrites of a
+ * growing directory. Here, the saves made while the previous batch is
+ * being written, or within the configured delay, only cost one write of
+ * the last version.
+ *
+ * Reads are served from the pending writes first, so callers observe their
+ * writes right away. Pending writes are applied in the order of their last
+ * update: a directory is only ever written after the directories saved
+ * before its last save, so that a crash never leaves a directory pointing to
+ * a child whose own directory was saved before it but not yet written. The
+ * pending writes are lost on crash, which leaves the overlay without its
+ * clean shutdown marker and has the next startup check it, as for any
+ * unclean shutdown. close() writes everything back before closing the
+ * underlying catalog, so a clean shutdown stays clean.
+ *
+ * Errors writing back are logged rather than reported to the caller.
+ */
+class WriteBehindInodeCatalog : public InodeCatalog {
+ public:
+  /**
+   * The worker waits for delay after the first pending write before writing
+   * a batch back. Savers block while maxPending directories are pending.
+   */
+  WriteBehindInodeCatalog(
+      std::unique_ptr<InodeCatalog> inner,
+      std::chrono::nanoseconds delay,
+      size_t maxPending);
+
+  ~WriteBehindInodeCatalog() override;
+
+  /**
+   * Semantic operations on the underlying catalog would have to be ordered
+   * with the pending saves, and catalogs supporting them don't need write
+   * behind in the first place.
+   */
+  bool supportsSemanticOperations() const override {
+    return false;
+  }
+
+  std::optional<InodeNumber> initOverlay(bool createIfNonExisting) override;
+
+  void close(std::optional<InodeNumber> nextInodeNumber) override;
+
+  bool initialized() const override;
+
+  std::optional<overlay::OverlayDir> loadOverlayDir(
+      InodeNumber inodeNumber) override;
+
+  std::optional<overlay::OverlayDir> loadAndRemoveOverlayDir(
+      InodeNumber inodeNumber) override;
+
+  void saveOverlayDir(InodeNumber inodeNumber, overlay::OverlayDir&& odir)
+      override;
+
+  void removeOverlayDir(InodeNumber inodeNumber) override;
+
+  bool hasOverlayDir(InodeNumber inodeNumber) override;
+
+  void maintenance() override;
+
+  /**
+   * Returns once all the writes made before the call are applied to the
+   * underlying catalog.
+   */
+  void flush();
+
+ private:
+  /**
+   * The last write to a directory. A null odir is a removal.
+   */
+  struct Pending {
+    std::unique_ptr<overlay::OverlayDir> odir;
+    uint64_t sequence;
+  };
+
+  struct State {
+    std::unordered_map<InodeNumber, Pending> pending;
+    // The pending directories by their Pending::sequence, the order they are
+    // written back in.
+    std::map<uint64_t, InodeNumber> order;
+    uint64_t nextSequence{0};
+    // Directories being written back by the worker thread.
+    std::unordered_set<InodeNumber> inflight;
+    size_t flushWaiters{0};
+    bool stopRequested{false};
+    // Set by the worker thread once it wrote everything back after a stop
+    // request, after which writes go straight to the underlying catalog.
+    bool workerStopped{false};
+  };
+
+  using LockedState = folly::Synchronized<State, std::mutex>::LockedPtr;
+
+  void enqueue(InodeNumber inodeNumber, std::unique_ptr<overlay::OverlayDir>);
+
+  /**
+   * Wait until inodeNumber is no longer being written back, so that the
+   * underlying catalog can be read.
+   */
+  void waitForInflight(LockedState& state, InodeNumber inodeNumber);
+
+  void processOnWorkerThread();
+
+  void stopWorkerThread();
+
+  const std::unique_ptr<InodeCatalog> inner_;
+  const std::chrono::nanoseconds delay_;
+  const size_t maxPending_;
+
+  folly::Synchronized<State, std::mutex> state_;
+  // Signaled when writes are pending, and on flush and stop requests.
+  std::condition_variable workCV_;
+  // Signaled when a batch was taken or written back.
+  std::condition_variable progressCV_;
+  std::thread workerThread_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/inodes/fscatalog/BlobCloneCache.h"
+
+#include <fmt/format.h>
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/ScopeGuard.h>
+#include <folly/logging/xlog.h>
+#include <folly/portability/Fcntl.h>
+#include <folly/portability/SysStat.h>
+#include <algorithm>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#elif defined(__APPLE__)
+#include <sys/clonefile.h>
+#endif
+
+#include "eden/fs/utils/FileUtils.h"
+
+namespace facebook::eden {
+
+namespace {
+
+/**
+ * Files being written, named after the key followed by a unique number.
+ * Those left behind by a crash are removed when the cache is loaded.
+ */
+constexpr std::string_view kTmpSuffix{".tmp"};
+
+constexpr folly::StringPiece kProbeData{"probe"};
+
+bool isTmpFile(std::string_view name) {
+  return name.size() > kTmpSuffix.size() &&
+      name.substr(name.size() - kTmpSuffix.size()) == kTmpSuffix;
+}
+
+bool isCloneUnsupportedError(int err) {
+  switch (err) {
+    case EOPNOTSUPP:
+#if defined(ENOTSUP) && ENOTSUP != EOPNOTSUPP
+    case ENOTSUP:
+#endif
+    case ENOTTY:
+    case EXDEV:
+    case EINVAL:
+    case ENOSYS:
+      return true;
+    default:
+      return false;
+  }
+}
+
+} // namespace
+
+std::optional<folly::File>
+cloneFileAt(const folly::File& source, int dirFd, const char* path) {
+#if defined(__linux__)
+  int fd = openat(
+      dirFd, path, O_CREAT | O_RDWR | O_CLOEXEC | O_NOFOLLOW | O_TRUNC, 0600);
+  folly::checkUnixError(fd, "failed to create ", path);
+  folly::File file{fd, /* ownsFd */ true};
+  if (ioctl(fd, FICLONE, source.fd()) == 0) {
+    return file;
+  }
+  int err = errno;
+  unlinkat(dirFd, path, 0);
+  if (isCloneUnsupportedError(err)) {
+    return std::nullopt;
+  }
+  folly::throwSystemErrorExplicit(err, "failed to clone file into ", path);
+#elif defined(__APPLE__)
+  // fclonefileat() does not replace existing files.
+  unlinkat(dirFd, path, 0);
+  if (fclonefileat(source.fd(), dirFd, path, 0) != 0) {
+    int err = errno;
+    if (isCloneUnsupportedError(err)) {
+      return std::nullopt;
+    }
+    folly::throwSystemErrorExplicit(err, "failed to clone file into ", path);
+  }
+  int fd = openat(dirFd, path, O_RDWR | O_CLOEXEC | O_NOFOLLOW);
+  folly::checkUnixError(fd, "failed to open cloned file ", path);
+  return folly::File{fd, /* ownsFd */ true};
+#else
+  (void)source;
+  (void)dirFd;
+  (void)path;
+  return std::nullopt;
+#endif
+}
+
+BlobCloneCache::BlobCloneCache(AbsolutePathPiece dir, size_t maxSize)
+    : dir_{dir}, maxSize_{maxSize} {}
+
+std::optional<folly::File> BlobCloneCache::clone(
+    std::string_view key,
+    const iovec* iov,
+    size_t iovCount,
+    int dirFd,
+    const char* path) {
+  std::optional<folly::File> source;
+  {
+    auto state = state_.wlock();
+    if (!state->loaded) {
+      load(*state);
+    }
+    if (!state->cloneSupported) {
+      return std::nullopt;
+    }
+    source = openCached(*state, key);
+  }
+
+  // Write the contents without holding the lock: two concurrent inserts of
+  // a key write the same contents, and the last one to be renamed wins.
+  if (!source) {
+    source = insert(key, iov, iovCount);
+  }
+  return cloneFileAt(*source, dirFd, path);
+}
+
+size_t BlobCloneCache::getCachedBytes() const {
+  return state_.rlock()->totalBytes;
+}
+
+void BlobCloneCache::load(State& state) {
+  state.loaded = true;
+  ensureDirectoryExists(dir_);
+  state.cloneSupported = probeCloneSupport();
+  if (!state.cloneSupported) {
+    XLOG(DBG2) << "The filesystem of " << dir_
+               << " can't clone files, materializing files by copying them";
+    return;
+  }
+
+  struct CachedFile {
+    std::string name;
+    size_t size;
+    time_t mtime;
+  };
+  std::vector<CachedFile> files;
+  for (const auto& name : getAllDirectoryEntryNames(dir_).value()) {
+    auto path = dir_ + name;
+    if (isTmpFile(name.view())) {
+      unlink(path.c_str());
+      continue;
+    }
+    struct stat st;
+    if (lstat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode)) {
+      files.push_back(CachedFile{
+          std::string{name.view()},
+          static_cast<size_t>(st.st_size),
+          st.st_mtime});
+    }
+  }
+
+  // The files were written when they were first cached, so the least recently
+  // cached ones come first.
+  std::sort(files.begin(), files.end(), [](const auto& a, const auto& b) {
+    return a.mtime < b.mtime;
+  });
+  for (const auto& file : files) {
+    addEntry(state, file.name, file.size);
+  }
+}
+
+bool BlobCloneCache::probeCloneSupport() {
+  auto probePath = dir_ + PathComponent{fmt::format("probe{}", kTmpSuffix)};
+  folly::File probe{
+      probePath.c_str(), O_CREAT | O_RDWR | O_CLOEXEC | O_TRUNC, 0600};
+  SCOPE_EXIT {
+    unlink(probePath.c_str());
+  };
+  folly::checkUnixError(
+      folly::writeFull(probe.fd(), kProbeData.data(), kProbeData.size()),
+      "error writing ",
+      probePath);
+
+  folly::File dir{dir_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC};
+  auto cloneName = fmt::format("probe-clone{}", kTmpSuffix);
+  auto cloned = cloneFileAt(probe, dir.fd(), cloneName.c_str());
+  if (!cloned) {
+    return false;
+  }
+  unlinkat(dir.fd(), cloneName.c_str(), 0);
+  return true;
+}
+
+std::optional<folly::File> BlobCloneCache::openCached(
+    State& state,
+    std::string_view key) {
+  auto it = state.entries.find(key);
+  if (it == state.entries.end()) {
+    return std::nullopt;
+  }
+
+  auto path = dir_ + PathComponentPiece{key};
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+  if (fd == -1) {
+    // The file was removed from under us, forget about it.
+    XLOG(DBG3) << "error opening cached blob " << path << ": "
+               << folly::errnoStr(errno);
+    state.totalBytes -= it->second.size;
+    state.lru.erase(it->second.lruPosition);
+    state.entries.erase(it);
+    return std::nullopt;
+  }
+  state.lru.splice(state.lru.end(), state.lru, it->second.lruPosition);
+  return folly::File{fd, /* ownsFd */ true};
+}
+
+folly::File BlobCloneCache::insert(
+    std::string_view key,
+    const iovec* iov,
+    size_t iovCount) {
+  auto path = dir_ + PathComponentPiece{key};
+  auto tmpPath = dir_ +
+      PathComponent{fmt::format(
+          "{}.{}{}", key, nextTmpId_.fetch_add(1), kTmpSuffix)};
+  folly::File file{
+      tmpPath.c_str(),
+      O_CREAT | O_RDWR | O_CLOEXEC | O_NOFOLLOW | O_TRUNC,
+      0600};
+  bool success = false;
+  SCOPE_EXIT {
+    if (!success) {
+      unlink(tmpPath.c_str());
+    }
+  };
+
+  auto written = folly::writevFull(
+      file.fd(), const_cast<iovec*>(iov), static_cast<int>(iovCount));
+  folly::checkUnixError(written, "error writing ", tmpPath);
+  folly::checkUnixError(
+      rename(tmpPath.c_str(), path.c_str()), "error committing ", path);
+  success = true;
+
+  addEntry(*state_.wlock(), key, static_cast<size_t>(written));
+  return file;
+}
+
+void BlobCloneCache::addEntry(
+    State& state,
+    std::string_view key,
+    size_t size) {
+  auto it = state.entries.find(key);
+  if (it != state.entries.end()) {
+    state.totalBytes -= it->second.size;
+    it->second.size = size;
+    state.lru.splice(state.lru.end(), state.lru, it->second.lruPosition);
+  } else {
+    state.lru.emplace_back(key);
+    state.entries.emplace(
+        std::string{key}, Entry{std::prev(state.lru.end()), size});
+  }
+  state.totalBytes += size;
+  evict(state);
+}
+
+void BlobCloneCache::evict(State& state) {
+  // The most recently used file is kept even when it is larger than the
+  // cache, since it is about to be cloned.
+  while (state.totalBytes > maxSize_ && state.lru.size() > 1) {
+    const auto& key = state.lru.front();
+    auto it = state.entries.find(key);
+    XCHECK(it != state.entries.end());
+    unlink((dir_ + PathComponentPiece{key}).c_str());
+    state.totalBytes -= it->second.size;
+    state.entries.erase(it);
+    state.lru.pop_front();
+  }
+}
+
+} // namespace facebook::eden
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <sys/uio.h>
+#include <atomic>
+#include <list>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * A content-addressed directory of files to create other files from by
+ * cloning them, so that materializing a large file shares its extents with
+ * the cached copy instead of writing all of its contents.
+ *
+ * Cloning relies on FICLONE on Linux (btrfs, XFS) and fclonefileat() on
+ * macOS (APFS). Whether the filesystem supports it is probed once, before
+ * anything is cached.
+ *
+ * The least recently used files are removed once the cache holds more than
+ * maxSize bytes. The files created from them are not affected.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class BlobCloneCache {
+ public:
+  BlobCloneCache(AbsolutePathPiece dir, size_t maxSize);
+
+  /**
+   * Create the file at path, relative to dirFd, by cloning the file cached
+   * under key, after first writing iov to the cache if key isn't cached yet.
+   * The contents must always be the same for a given key.
+   *
+   * Returns the created file, open for reading and writing, or std::nullopt
+   * if the filesystem doesn't support cloning files, in which case nothing
+   * is created.
+   */
+  std::optional<folly::File> clone(
+      std::string_view key,
+      const iovec* iov,
+      size_t iovCount,
+      int dirFd,
+      const char* path);
+
+  /**
+   * The number of bytes of the files in the cache.
+   */
+  size_t getCachedBytes() const;
+
+ private:
+  struct Entry {
+    std::list<std::string>::iterator lruPosition;
+    size_t size;
+  };
+
+  struct State {
+    bool loaded{false};
+    bool cloneSupported{false};
+    // Least recently used first.
+    std::list<std::string> lru;
+    folly::F14NodeMap<std::string, Entry> entries;
+    size_t totalBytes{0};
+  };
+
+  /**
+   * Create the cache directory, probe for clone support, and index the files
+   * already cached.
+   */
+  void load(State& state);
+
+  bool probeCloneSupport();
+
+  /**
+   * Open the file cached under key, marking it most recently used.
+   */
+  std::optional<folly::File> openCached(State& state, std::string_view key);
+
+  folly::File insert(std::string_view key, const iovec* iov, size_t iovCount);
+
+  void addEntry(State& state, std::string_view key, size_t size);
+
+  void evict(State& state);
+
+  const AbsolutePath dir_;
+  const size_t maxSize_;
+  std::atomic<uint64_t> nextTmpId_{0};
+  folly::Synchronized<State> state_;
+};
+
+/**
+ * Clone the contents of source into a new file at path, relative to dirFd.
+ *
+ * Returns std::nullopt if the filesystem doesn't support cloning files.
+ * Throws on any other error.
+ */
+std::optional<folly::File>
+cloneFileAt(const folly::File& source, int dirFd, const char* path);
+
+} // namespace facebook::eden
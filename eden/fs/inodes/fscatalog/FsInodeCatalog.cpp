@@ -46,7 +46,6 @@ using std::string;
 /* Relative to the localDir, the metaFile holds the serialized rendition
  * of the overlay_ data.  We use thrift CompactSerialization for this.
  */
-constexpr StringPiece kInfoFile{"info"};
 constexpr const char* kNextInodeNumberFile{"next-inode-number"};
 
 /**
@@ -66,6 +65,7 @@ constexpr uint32_t kOverlayVersion = 1;
 constexpr size_t kInfoHeaderSize =
     kInfoHeaderMagic.size() + sizeof(kOverlayVersion);
 
+constexpr folly::StringPiece FileContentStore::kInfoFile;
 constexpr folly::StringPiece FileContentStore::kHeaderIdentifierDir;
 constexpr folly::StringPiece FileContentStore::kHeaderIdentifierFile;
 constexpr uint32_t FileContentStore::kHeaderVersion;
@@ -598,6 +598,46 @@ folly::File FileContentStore::createOverlayFile(
   return createOverlayFileImpl(inodeNumber, iov.data(), iov.size());
 }
 
+std::optional<folly::File> FileContentStore::cloneOverlayFile(
+    InodeNumber inodeNumber,
+    std::string_view blobKey,
+    const IOBuf& contents) {
+  // The header of file contents never changes, so the cached copy can be a
+  // complete overlay file and the clone needs no further writes.
+  auto header = createHeader(kHeaderIdentifierFile, kHeaderVersion);
+
+  fbvector<struct iovec> iov;
+  iov.resize(1);
+  iov[0].iov_base = header.data();
+  iov[0].iov_len = header.size();
+  contents.appendToIov(&iov);
+
+  auto path = getFilePath(inodeNumber);
+  auto tmpPath = getFileTmpPath(inodeNumber);
+  auto file = blobCloneCache_.clone(
+      blobKey, iov.data(), iov.size(), dirFile_.fd(), tmpPath.data());
+  if (!file) {
+    return std::nullopt;
+  }
+  bool success = false;
+  SCOPE_EXIT {
+    if (!success) {
+      unlinkat(dirFile_.fd(), tmpPath.data(), 0);
+    }
+  };
+
+  auto returnCode =
+      renameat(dirFile_.fd(), tmpPath.data(), dirFile_.fd(), path.c_str());
+  folly::checkUnixError(
+      returnCode,
+      "error committing overlay file for inode ",
+      inodeNumber,
+      " in ",
+      localDir_.view());
+  success = true;
+  return file;
+}
+
 void FileContentStore::validateHeader(
     InodeNumber inodeNumber,
     folly::StringPiece contents,
@@ -16,6 +16,7 @@
 #include "eden/fs/inodes/IFileContentStore.h"
 #include "eden/fs/inodes/InodeCatalog.h"
 #include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/inodes/fscatalog/BlobCloneCache.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
 #include "eden/fs/utils/DirType.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -38,7 +39,16 @@ class InodePath;
  */
 class FileContentStore : public IFileContentStore {
  public:
-  explicit FileContentStore(AbsolutePathPiece localDir) : localDir_{localDir} {}
+  /**
+   * blobCacheSize bounds the bytes of blobs kept for cloneOverlayFile().
+   */
+  explicit FileContentStore(
+      AbsolutePathPiece localDir,
+      size_t blobCacheSize = kDefaultBlobCacheSize)
+      : localDir_{localDir},
+        blobCloneCache_{
+            localDir_ + PathComponentPiece{kBlobCacheDir},
+            blobCacheSize} {}
 
   /**
    * Initialize the FileContentStore, acquire the "info" file lock and load the
@@ -91,6 +101,14 @@ class FileContentStore : public IFileContentStore {
       InodeNumber inodeNumber,
       const folly::IOBuf& contents) override;
 
+  /**
+   * Clones the file from the blob cache, see BlobCloneCache.
+   */
+  std::optional<folly::File> cloneOverlayFile(
+      InodeNumber inodeNumber,
+      std::string_view blobKey,
+      const folly::IOBuf& contents) override;
+
   /**
    * Remove the overlay directory data associated with the passed InodeNumber.
    */
@@ -155,6 +173,17 @@ class FileContentStore : public IFileContentStore {
 
   static constexpr folly::StringPiece kMetadataFile{"metadata.table"};
 
+  /**
+   * Holds the blobs that large files are cloned from.
+   */
+  static constexpr folly::StringPiece kBlobCacheDir{"blob-cache"};
+  static constexpr size_t kDefaultBlobCacheSize = 8ull * 1024 * 1024 * 1024;
+
+  /**
+   * Holds the overlay version, and the lock of the process using the overlay.
+   */
+  static constexpr folly::StringPiece kInfoFile{"info"};
+
   /**
    * Constants for an header in overlay file.
    */
@@ -225,6 +254,8 @@ class FileContentStore : public IFileContentStore {
   /** Path to ".eden/CLIENT/local" */
   const AbsolutePath localDir_;
 
+  BlobCloneCache blobCloneCache_;
+
   /**
    * An open file descriptor to the overlay info file.
    *
@@ -13,6 +13,7 @@
 #include <fcntl.h>
 #include <folly/portability/Unistd.h>
 #include <time.h>
+#include <unordered_set>
 
 #include <folly/Conv.h>
 #include <folly/ExceptionWrapper.h>
@@ -20,6 +21,7 @@
 #include <folly/FileUtil.h>
 #include <folly/Overload.h>
 #include <folly/String.h>
+#include <folly/Synchronized.h>
 #include <folly/gen/Base.h>
 #include <folly/gen/ParallelMap.h>
 #include <folly/logging/xlog.h>
@@ -40,6 +42,11 @@ using std::chrono::seconds;
 
 namespace facebook::eden {
 
+namespace {
+constexpr StringPiece kCheckpointFile{"fsck-checkpoint"};
+constexpr StringPiece kCheckpointHeader{"eden-fsck-checkpoint-v1\n"};
+} // namespace
+
 struct OverlayChecker::InodeInfo {
   InodeInfo(InodeNumber num, InodeType t) : number(num), type(t) {}
   InodeInfo(InodeNumber num, overlay::OverlayDir&& c)
@@ -62,17 +69,28 @@ struct OverlayChecker::Impl {
   FileContentStore* const fcs;
   std::optional<InodeNumber> loadedNextInodeNumber;
   LookupCallback& lookupCallback;
+  const size_t threadCount;
+  const bool useCheckpoint;
   std::unordered_map<InodeNumber, InodeInfo> inodes;
+  // The inode numbers of the valid files found by an interrupted scan, by
+  // shard.
+  std::unordered_map<ShardID, std::unordered_set<uint64_t>> checkpointedFiles;
+  // Each shard is recorded to it once scanned.
+  folly::Synchronized<folly::File> checkpointFile;
 
   Impl(
       FsInodeCatalog* fs,
       FileContentStore* fcs,
       std::optional<InodeNumber> nextInodeNumber,
-      LookupCallback& lookupCallback)
+      LookupCallback& lookupCallback,
+      size_t threadCount,
+      bool useCheckpoint)
       : fs{fs},
         fcs{fcs},
         loadedNextInodeNumber{nextInodeNumber},
-        lookupCallback{lookupCallback} {}
+        lookupCallback{lookupCallback},
+        threadCount{std::max(threadCount, size_t{1})},
+        useCheckpoint{useCheckpoint} {}
 };
 
 class OverlayChecker::RepairState {
@@ -761,8 +779,16 @@ OverlayChecker::OverlayChecker(
     FsInodeCatalog* fs,
     FileContentStore* fcs,
     optional<InodeNumber> nextInodeNumber,
-    LookupCallback& lookupCallback)
-    : impl_{std::make_unique<Impl>(fs, fcs, nextInodeNumber, lookupCallback)} {}
+    LookupCallback& lookupCallback,
+    size_t threadCount,
+    bool useCheckpoint)
+    : impl_{std::make_unique<Impl>(
+          fs,
+          fcs,
+          nextInodeNumber,
+          lookupCallback,
+          threadCount,
+          useCheckpoint)} {}
 
 OverlayChecker::~OverlayChecker() {}
 
@@ -788,6 +814,7 @@ void OverlayChecker::scanForErrors(const ProgressCallback& progressCallback) {
 
 optional<OverlayChecker::RepairResult> OverlayChecker::repairErrors() {
   if (errors_.empty()) {
+    removeCheckpoint();
     return std::nullopt;
   }
 
@@ -847,6 +874,7 @@ optional<OverlayChecker::RepairResult> OverlayChecker::repairErrors() {
   repair.log(finalMsg);
   XLOG(INFO) << "fsck:" << impl_->fcs->getLocalDir() << ": " << finalMsg;
 
+  removeCheckpoint();
   return result;
 }
 
@@ -977,91 +1005,41 @@ std::unique_ptr<OverlayChecker::Error> make_error(Args&&... args) {
 void OverlayChecker::readInodes(const ProgressCallback& progressCallback) {
   using namespace folly::gen;
 
-  auto threads = 4;
+  if (impl_->useCheckpoint) {
+    loadCheckpoint();
+  }
+
   uint32_t progress10pct = 0;
+  uint32_t shardsScanned = 0;
 
   folly::Synchronized<std::vector<std::unique_ptr<Error>>> errors;
 
   seq(0u, FileContentStore::kNumShards - 1) |
       pmap(
-          [this, &errors](
-              uint32_t shardID) -> std::vector<std::tuple<uint64_t, uint32_t>> {
-            // Get entries in directory
-            std::array<char, 2> subdirBuffer;
-            MutableStringPiece subdir{subdirBuffer.data(), subdirBuffer.size()};
-            FileContentStore::formatSubdirShardPath(shardID, subdir);
-            auto path = impl_->fcs->getLocalDir() + PathComponentPiece{subdir};
-
-            XLOG(DBG5) << "fsck:" << impl_->fcs->getLocalDir() << ": scanning "
-                       << path;
-
-            std::vector<std::tuple<uint64_t, uint32_t>> inodes;
-
-            boost::system::error_code error;
-            auto boostPath = boost::filesystem::path{path.value().c_str()};
-            auto iterator =
-                boost::filesystem::directory_iterator(boostPath, error);
-            if (error.value() != 0) {
-              errors.wlock()->push_back(
-                  make_error<ShardDirectoryEnumerationError>(path, error));
-              return inodes;
-            }
-
-            auto endIterator = boost::filesystem::directory_iterator();
-            while (iterator != endIterator) {
-              const auto& dirEntry = *iterator;
-              AbsolutePath inodePath(dirEntry.path().string());
-              auto entryInodeNumber =
-                  folly::tryTo<uint64_t>(inodePath.basename().value());
-              if (entryInodeNumber.hasValue()) {
-                inodes.push_back(std::make_tuple(*entryInodeNumber, shardID));
-              } else {
-                errors.wlock()->push_back(
-                    make_error<UnexpectedOverlayFile>(inodePath));
-              }
-
-              iterator.increment(error);
-              if (error.value() != 0) {
-                errors.wlock()->push_back(
-                    make_error<ShardDirectoryEnumerationError>(path, error));
-                break;
-              }
-            }
-
-            return inodes;
+          [this, &errors](uint32_t shardID) {
+            auto shardInodes = readInodeShard(shardID, errors);
+            recordCheckpoint(shardID, shardInodes);
+            return shardInodes;
           },
-          threads) |
-      rconcat | move |
-      pmap(
-          [this, &errors](std::tuple<uint64_t, uint32_t> result)
-              -> std::optional<InodeInfo> {
-            return this->loadInode(
-                InodeNumber(std::get<0>(result)), std::get<1>(result), errors);
-          },
-          threads) |
+          impl_->threadCount) |
       move |
-      map([this, progressCallback, &progress10pct](
-              std::optional<InodeInfo> inodeInfoOpt) -> bool {
-        if (inodeInfoOpt.has_value()) {
-          auto inodeInfo = inodeInfoOpt.value();
-          ShardID shardID = static_cast<ShardID>(inodeInfo.number.get() & 0xff);
-          uint32_t progress = (10 * shardID) / FileContentStore::kNumShards;
-          if (progress > progress10pct) {
-            XLOG(INFO) << "fsck:" << impl_->fcs->getLocalDir() << ": scan "
-                       << progress << "0% complete: " << impl_->inodes.size()
-                       << " inodes scanned";
-            if (auto callback = progressCallback) {
-              callback(progress);
-            }
-            progress10pct = progress;
-          }
-
+      map([this, progressCallback, &progress10pct, &shardsScanned](
+              std::vector<InodeInfo> shardInodes) -> bool {
+        for (auto& inodeInfo : shardInodes) {
           updateMaxInodeNumber(inodeInfo.number);
-          impl_->inodes.emplace(inodeInfo.number, inodeInfo);
-          if (impl_->inodes.size() % 10000 == 0) {
-            XLOG(DBG5) << "fsck: " << impl_->fcs->getLocalDir() << ": scanned "
-                       << impl_->inodes.size() << " inodes";
+          impl_->inodes.emplace(inodeInfo.number, std::move(inodeInfo));
+        }
+
+        ++shardsScanned;
+        uint32_t progress = (10 * shardsScanned) / FileContentStore::kNumShards;
+        if (progress > progress10pct) {
+          XLOG(INFO) << "fsck:" << impl_->fcs->getLocalDir() << ": scan "
+                     << progress << "0% complete: " << impl_->inodes.size()
+                     << " inodes scanned";
+          if (auto callback = progressCallback) {
+            callback(progress);
           }
+          progress10pct = progress;
         }
         return true;
       }) |
@@ -1077,6 +1055,158 @@ void OverlayChecker::readInodes(const ProgressCallback& progressCallback) {
              << impl_->inodes.size() << " inodes";
 }
 
+std::vector<OverlayChecker::InodeInfo> OverlayChecker::readInodeShard(
+    ShardID shardID,
+    folly::Synchronized<std::vector<std::unique_ptr<Error>>>& errors) const {
+  // Get entries in directory
+  std::array<char, 2> subdirBuffer;
+  MutableStringPiece subdir{subdirBuffer.data(), subdirBuffer.size()};
+  FileContentStore::formatSubdirShardPath(shardID, subdir);
+  auto path = impl_->fcs->getLocalDir() + PathComponentPiece{subdir};
+
+  XLOG(DBG5) << "fsck:" << impl_->fcs->getLocalDir() << ": scanning " << path;
+
+  std::vector<InodeInfo> inodes;
+
+  boost::system::error_code error;
+  auto boostPath = boost::filesystem::path{path.value().c_str()};
+  auto iterator = boost::filesystem::directory_iterator(boostPath, error);
+  if (error.value() != 0) {
+    errors.wlock()->push_back(
+        make_error<ShardDirectoryEnumerationError>(path, error));
+    return inodes;
+  }
+
+  // Files found valid by an interrupted scan are still valid: nothing but
+  // fsck touched the overlay since.
+  const std::unordered_set<uint64_t>* checkedFiles = nullptr;
+  auto checkpointIt = impl_->checkpointedFiles.find(shardID);
+  if (checkpointIt != impl_->checkpointedFiles.end()) {
+    checkedFiles = &checkpointIt->second;
+  }
+
+  auto endIterator = boost::filesystem::directory_iterator();
+  while (iterator != endIterator) {
+    const auto& dirEntry = *iterator;
+    AbsolutePath inodePath(dirEntry.path().string());
+    auto entryInodeNumber =
+        folly::tryTo<uint64_t>(inodePath.basename().value());
+    if (!entryInodeNumber.hasValue()) {
+      errors.wlock()->push_back(make_error<UnexpectedOverlayFile>(inodePath));
+    } else if (checkedFiles && checkedFiles->count(*entryInodeNumber)) {
+      inodes.emplace_back(InodeNumber(*entryInodeNumber), InodeType::File);
+    } else if (
+        auto inodeInfo =
+            loadInode(InodeNumber(*entryInodeNumber), shardID, errors)) {
+      inodes.push_back(std::move(*inodeInfo));
+    }
+
+    iterator.increment(error);
+    if (error.value() != 0) {
+      errors.wlock()->push_back(
+          make_error<ShardDirectoryEnumerationError>(path, error));
+      break;
+    }
+  }
+
+  return inodes;
+}
+
+void OverlayChecker::loadCheckpoint() {
+  // The checkpoint holds a header line, then a line per scanned shard: the
+  // shard ID followed by the inode numbers of its valid files.
+  auto path = impl_->fcs->getLocalDir() + PathComponentPiece{kCheckpointFile};
+  std::string contents;
+  bool resume = folly::readFile(path.c_str(), contents) &&
+      StringPiece{contents}.startsWith(kCheckpointHeader);
+  if (resume) {
+    StringPiece records{contents};
+    records.advance(kCheckpointHeader.size());
+    // The last line may have been cut short, only complete lines count.
+    for (auto eol = records.find('\n'); eol != StringPiece::npos;
+         eol = records.find('\n')) {
+      std::vector<StringPiece> fields;
+      folly::split(' ', records.subpiece(0, eol), fields);
+      records.advance(eol + 1);
+
+      auto shardID = folly::tryTo<ShardID>(fields[0]);
+      if (!shardID.hasValue() || *shardID >= FileContentStore::kNumShards) {
+        continue;
+      }
+      std::unordered_set<uint64_t> files;
+      bool valid = true;
+      for (size_t i = 1; i < fields.size() && valid; ++i) {
+        auto number = folly::tryTo<uint64_t>(fields[i]);
+        valid = number.hasValue();
+        if (valid) {
+          files.insert(*number);
+        }
+      }
+      if (valid) {
+        impl_->checkpointedFiles[*shardID] = std::move(files);
+      }
+    }
+    XLOG(INFO) << "fsck:" << impl_->fcs->getLocalDir() << ": resuming from "
+               << impl_->checkpointedFiles.size() << " checked shards";
+  }
+
+  try {
+    auto flags = O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC;
+    folly::File file{path.c_str(), resume ? flags : flags | O_TRUNC, 0600};
+    if (!resume) {
+      folly::writeFull(
+          file.fd(), kCheckpointHeader.data(), kCheckpointHeader.size());
+    }
+    *impl_->checkpointFile.wlock() = std::move(file);
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "fsck:" << impl_->fcs->getLocalDir()
+               << ": unable to record the scan progress: "
+               << folly::exceptionStr(ex);
+  }
+}
+
+void OverlayChecker::recordCheckpoint(
+    ShardID shardID,
+    const std::vector<InodeInfo>& shardInodes) const {
+  if (!impl_->useCheckpoint) {
+    return;
+  }
+
+  auto line = folly::to<std::string>(shardID);
+  for (const auto& inodeInfo : shardInodes) {
+    // Directories are read again to rebuild their children.
+    if (inodeInfo.type == InodeType::File) {
+      folly::toAppend(' ', inodeInfo.number.get(), &line);
+    }
+  }
+  line.push_back('\n');
+
+  // Write the whole line at once, so that an interrupted write only cuts
+  // the last line short.
+  auto file = impl_->checkpointFile.wlock();
+  if (*file && folly::writeFull(file->fd(), line.data(), line.size()) < 0) {
+    int errnum = errno;
+    XLOG(WARN) << "fsck:" << impl_->fcs->getLocalDir()
+               << ": unable to record the scan progress: "
+               << folly::errnoStr(errnum);
+    file->close();
+  }
+}
+
+void OverlayChecker::removeCheckpoint() {
+  if (!impl_->useCheckpoint) {
+    return;
+  }
+  impl_->checkpointFile.wlock()->close();
+  auto path = impl_->fcs->getLocalDir() + PathComponentPiece{kCheckpointFile};
+  if (unlink(path.c_str()) != 0 && errno != ENOENT) {
+    int errnum = errno;
+    XLOG(WARN) << "fsck:" << impl_->fcs->getLocalDir()
+               << ": unable to remove the scan checkpoint: "
+               << folly::errnoStr(errnum);
+  }
+}
+
 overlay::OverlayDir loadDirectoryChildren(folly::File& file) {
   std::string serializedData;
   if (!folly::readFile(file.fd(), serializedData)) {
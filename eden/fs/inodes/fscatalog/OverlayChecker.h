@@ -56,6 +56,8 @@ class OverlayChecker {
   using LookupCallback =
       std::function<ImmediateFuture<LookupCallbackValue>(RelativePathPiece)>;
 
+  static constexpr size_t kDefaultThreadCount = 4;
+
   /**
    * Create a new OverlayChecker.
    *
@@ -63,12 +65,20 @@ class OverlayChecker {
    * FileContentStore for the duration of the check operation.  The caller is
    * responsible for ensuring that the FsInodeCatalog and FileContentStore
    * objects exist for at least as long as the OverlayChecker object.
+   *
+   * The shard directories of the overlay are scanned by threadCount threads.
+   *
+   * With useCheckpoint, the files found valid are recorded in the overlay as
+   * each shard is scanned, and not read again by a scan interrupted before
+   * repairErrors() completes.
    */
   OverlayChecker(
       FsInodeCatalog* fs,
       FileContentStore* fcs,
       std::optional<InodeNumber> nextInodeNumber,
-      LookupCallback& lookupCallback);
+      LookupCallback& lookupCallback,
+      size_t threadCount = kDefaultThreadCount,
+      bool useCheckpoint = false);
 
   ~OverlayChecker();
 
@@ -82,6 +92,8 @@ class OverlayChecker {
    *
    * Returns std::nullopt if repairErrors() is called when there are no errors
    * to repair, otherwise returns a RepairResult.
+   *
+   * The scan checkpoint is removed once the repair completes.
    */
   std::optional<RepairResult> repairErrors();
 
@@ -185,7 +197,9 @@ class OverlayChecker {
 
   using ShardID = uint32_t;
   void readInodes(const ProgressCallback& progressCallback = [](auto) {});
-  void readInodeSubdir(const AbsolutePath& path, ShardID shardID);
+  std::vector<InodeInfo> readInodeShard(
+      ShardID shardID,
+      folly::Synchronized<std::vector<std::unique_ptr<Error>>>& errors) const;
   // loadInode and loadInodeInfo are called from a multi-threaded context, so
   // make them const so they can't accidentally mutate 'this'.
   std::optional<OverlayChecker::InodeInfo> loadInode(
@@ -196,6 +210,12 @@ class OverlayChecker {
       InodeNumber number,
       folly::Synchronized<std::vector<std::unique_ptr<Error>>>& errors) const;
 
+  void loadCheckpoint();
+  void recordCheckpoint(
+      ShardID shardID,
+      const std::vector<InodeInfo>& shardInodes) const;
+  void removeCheckpoint();
+
   void linkInodeChildren();
   void scanForParentErrors();
   void checkNextInodeNumber();
@@ -0,0 +1,701 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/inodes/fscatalog/SegmentInodeCatalog.h"
+
+#include <fmt/format.h>
+#include <folly/Conv.h>
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/hash/Checksum.h>
+#include <folly/logging/xlog.h>
+#include <folly/portability/Fcntl.h>
+#include <folly/portability/SysMman.h>
+#include <folly/portability/SysStat.h>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "eden/fs/inodes/fscatalog/FsInodeCatalog.h"
+#include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
+#include "eden/fs/utils/FileUtils.h"
+
+namespace facebook::eden {
+
+namespace {
+constexpr PathComponentPiece kSegmentDir{"dirsegments"};
+constexpr PathComponentPiece kIndexFile{"index"};
+constexpr std::string_view kSegmentSuffix{".seg"};
+
+constexpr uint32_t kSegmentMagic = 0x47455345; // "ESEG"
+constexpr uint32_t kIndexMagic = 0x58444945; // "EIDX"
+constexpr uint32_t kVersion = 1;
+
+// Offsets in a segment are stored on 32 bits.
+constexpr size_t kMaximumSegmentSize = 1024 * 1024 * 1024;
+constexpr size_t kMinimumSegmentSize = 64 * 1024;
+
+constexpr size_t kRecordAlignment = 8;
+constexpr uint32_t kTombstone = std::numeric_limits<uint32_t>::max();
+constexpr uint16_t kNoHash = std::numeric_limits<uint16_t>::max();
+
+struct SegmentHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t id;
+  uint32_t reserved;
+};
+
+struct RecordHeader {
+  uint32_t checksum;
+  // Size of the entries following the header, padding excluded.
+  uint32_t payloadSize;
+  uint64_t inodeNumber;
+  // Of the records of a directory, the one with the highest sequence wins.
+  // Compaction preserves it. Never 0, which marks the unused tail of a
+  // segment.
+  uint64_t sequence;
+  // kTombstone for removals.
+  uint32_t entryCount;
+  uint32_t reserved;
+};
+
+// Followed by the name and the hash.
+struct EntryHeader {
+  uint64_t inodeNumber;
+  uint32_t mode;
+  uint16_t nameLength;
+  // kNoHash if the entry has no hash.
+  uint16_t hashLength;
+};
+
+struct IndexHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t nextInodeNumber;
+  uint64_t nextSequence;
+  uint64_t segmentCount;
+  uint64_t entryCount;
+};
+
+struct IndexSegment {
+  uint32_t id;
+  uint32_t end;
+  uint64_t liveBytes;
+};
+
+struct IndexEntry {
+  uint64_t inodeNumber;
+  uint32_t segment;
+  uint32_t offset;
+};
+
+size_t alignRecord(size_t size) {
+  return (size + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+}
+
+size_t recordSize(const RecordHeader& header) {
+  return alignRecord(sizeof(RecordHeader) + header.payloadSize);
+}
+
+uint32_t recordChecksum(const uint8_t* record, size_t payloadSize) {
+  return folly::crc32c(
+      record + sizeof(uint32_t),
+      sizeof(RecordHeader) - sizeof(uint32_t) + payloadSize);
+}
+
+RecordHeader readRecordHeader(const uint8_t* record) {
+  RecordHeader header;
+  memcpy(&header, record, sizeof(header));
+  return header;
+}
+
+size_t payloadSize(const overlay::OverlayDir& odir) {
+  size_t size = 0;
+  for (const auto& [name, entry] : *odir.entries()) {
+    if (name.size() >= std::numeric_limits<uint16_t>::max()) {
+      throw std::invalid_argument(
+          fmt::format("directory entry name too long: {}", name.size()));
+    }
+    auto hash = entry.hash();
+    if (hash && hash->size() >= kNoHash) {
+      throw std::invalid_argument(
+          fmt::format("directory entry hash too long: {}", hash->size()));
+    }
+    size += sizeof(EntryHeader) + name.size() + (hash ? hash->size() : 0);
+  }
+  return size;
+}
+
+/**
+ * Check that the record at offset is complete and intact. Returns its header.
+ */
+std::optional<RecordHeader>
+validateRecord(const uint8_t* data, size_t offset, size_t end) {
+  if (offset + sizeof(RecordHeader) > end) {
+    return std::nullopt;
+  }
+  auto header = readRecordHeader(data + offset);
+  if (header.sequence == 0 || offset + recordSize(header) > end ||
+      recordChecksum(data + offset, header.payloadSize) != header.checksum) {
+    return std::nullopt;
+  }
+  return header;
+}
+} // namespace
+
+SegmentInodeCatalog::SegmentInodeCatalog(
+    AbsolutePathPiece localDir,
+    size_t segmentSize)
+    : localDir_{localDir},
+      segmentDir_{localDir + kSegmentDir},
+      segmentSize_{std::clamp(
+          segmentSize,
+          kMinimumSegmentSize,
+          kMaximumSegmentSize)} {}
+
+SegmentInodeCatalog::~SegmentInodeCatalog() = default;
+
+bool SegmentInodeCatalog::existsIn(AbsolutePathPiece localDir) {
+  struct stat st;
+  return ::stat((localDir + kSegmentDir).c_str(), &st) == 0 &&
+      S_ISDIR(st.st_mode);
+}
+
+bool SegmentInodeCatalog::shouldUse(
+    AbsolutePathPiece localDir,
+    bool enabled) {
+  if (existsIn(localDir)) {
+    return true;
+  }
+  struct stat st;
+  auto infoPath = localDir + PathComponentPiece{FileContentStore::kInfoFile};
+  return enabled && ::stat(infoPath.c_str(), &st) != 0 && errno == ENOENT;
+}
+
+AbsolutePath SegmentInodeCatalog::segmentPath(uint32_t id) const {
+  return segmentDir_ +
+      PathComponent{fmt::format("{:08}{}", id, kSegmentSuffix)};
+}
+
+std::optional<InodeNumber> SegmentInodeCatalog::initOverlay(
+    bool createIfNonExisting) {
+  if (!createIfNonExisting && !existsIn(localDir_)) {
+    throw std::runtime_error(
+        fmt::format("overlay directory segments not found in {}", localDir_));
+  }
+  ensureDirectoryExists(segmentDir_);
+
+  auto state = state_.wlock();
+  for (const auto& name : getAllDirectoryEntryNames(segmentDir_).value()) {
+    auto view = name.view();
+    if (view.size() <= kSegmentSuffix.size() ||
+        view.substr(view.size() - kSegmentSuffix.size()) != kSegmentSuffix) {
+      continue;
+    }
+    auto id = folly::tryTo<uint32_t>(
+        view.substr(0, view.size() - kSegmentSuffix.size()));
+    if (id.hasValue()) {
+      openSegment(*state, id.value());
+    }
+  }
+
+  auto nextInodeNumber = loadIndex(*state);
+  if (!nextInodeNumber) {
+    if (!state->segments.empty()) {
+      XLOG(WARN) << "Overlay " << localDir_
+                 << " was not shut down cleanly. Scanning directory segments.";
+    }
+    nextInodeNumber = rebuildIndex(*state);
+  }
+  if (state->segments.empty()) {
+    createSegment(*state, 0);
+  }
+  state->initialized = true;
+  XLOG(DBG2) << "Loaded " << state->index.size() << " directories from "
+             << state->segments.size() << " segments in " << segmentDir_;
+  return nextInodeNumber;
+}
+
+void SegmentInodeCatalog::openSegment(State& state, uint32_t id) {
+  auto path = segmentPath(id);
+  folly::File file{path.c_str(), O_RDWR | O_CLOEXEC};
+  struct stat st;
+  folly::checkUnixError(fstat(file.fd(), &st), "fstat failed on ", path);
+
+  SegmentHeader header{};
+  if (static_cast<size_t>(st.st_size) < sizeof(header) ||
+      folly::preadFull(file.fd(), &header, sizeof(header), 0) !=
+          sizeof(header) ||
+      header.magic != kSegmentMagic || header.version != kVersion ||
+      header.id != id) {
+    // Most likely a crash while the segment was being created, before any
+    // record was added to it.
+    XLOG(WARN) << "Removing invalid directory segment " << path;
+    folly::checkUnixError(::unlink(path.c_str()), "failed to unlink ", path);
+    return;
+  }
+
+  auto segment = std::make_unique<Segment>(Segment{
+      id,
+      folly::MemoryMapping{
+          std::move(file), 0, st.st_size, folly::MemoryMapping::writable()},
+      static_cast<size_t>(st.st_size),
+      0});
+  state.segments.emplace(id, std::move(segment));
+}
+
+SegmentInodeCatalog::Segment& SegmentInodeCatalog::createSegment(
+    State& state,
+    size_t minimumSize) {
+  uint32_t id = state.segments.empty() ? 0 : state.segments.rbegin()->first + 1;
+  auto size = std::max(segmentSize_, alignRecord(minimumSize));
+  if (size > std::numeric_limits<uint32_t>::max()) {
+    throw std::invalid_argument(
+        fmt::format("directory record too large: {} bytes", minimumSize));
+  }
+
+  auto path = segmentPath(id);
+  folly::File file{path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644};
+  // The file is sparse: only the appended records use disk space.
+  folly::checkUnixError(
+      folly::ftruncateNoInt(file.fd(), size), "failed to resize ", path);
+
+  auto segment = std::make_unique<Segment>(Segment{
+      id,
+      folly::MemoryMapping{
+          std::move(file),
+          0,
+          static_cast<off_t>(size),
+          folly::MemoryMapping::writable()},
+      sizeof(SegmentHeader),
+      0});
+  SegmentHeader header{kSegmentMagic, kVersion, id, 0};
+  memcpy(segment->data(), &header, sizeof(header));
+  return *state.segments.emplace(id, std::move(segment)).first->second;
+}
+
+SegmentInodeCatalog::Segment& SegmentInodeCatalog::activeSegment(
+    State& state,
+    size_t recordSize) {
+  if (!state.segments.empty()) {
+    auto& last = *state.segments.rbegin()->second;
+    if (last.end + recordSize <= last.size()) {
+      return last;
+    }
+  }
+  return createSegment(state, sizeof(SegmentHeader) + recordSize);
+}
+
+std::optional<InodeNumber> SegmentInodeCatalog::loadIndex(State& state) {
+  auto indexPath = segmentDir_ + kIndexFile;
+  auto contents = readFile(indexPath);
+  if (contents.hasException()) {
+    return std::nullopt;
+  }
+  // The presence of the index indicates a clean shutdown: remove it right
+  // away, as the segments are about to diverge from it.
+  folly::checkUnixError(
+      ::unlink(indexPath.c_str()), "failed to unlink ", indexPath);
+
+  auto invalid = [&](std::string_view reason) {
+    XLOG(WARN) << "Ignoring invalid directory segment index: " << reason;
+    state.index.clear();
+    return std::nullopt;
+  };
+
+  const auto& data = contents.value();
+  IndexHeader header;
+  if (data.size() < sizeof(header)) {
+    return invalid("truncated");
+  }
+  memcpy(&header, data.data(), sizeof(header));
+  if (header.magic != kIndexMagic || header.version != kVersion ||
+      header.nextInodeNumber <= kRootNodeId.get() ||
+      header.segmentCount != state.segments.size() ||
+      data.size() !=
+          sizeof(header) + header.segmentCount * sizeof(IndexSegment) +
+              header.entryCount * sizeof(IndexEntry)) {
+    return invalid("bad header");
+  }
+
+  auto* cursor = data.data() + sizeof(header);
+  for (uint64_t i = 0; i < header.segmentCount; ++i) {
+    IndexSegment indexSegment;
+    memcpy(&indexSegment, cursor, sizeof(indexSegment));
+    cursor += sizeof(indexSegment);
+    auto it = state.segments.find(indexSegment.id);
+    if (it == state.segments.end() || indexSegment.end > it->second->size() ||
+        indexSegment.liveBytes > indexSegment.end) {
+      return invalid("segment mismatch");
+    }
+    it->second->end = indexSegment.end;
+    it->second->liveBytes = indexSegment.liveBytes;
+  }
+
+  state.index.reserve(header.entryCount);
+  for (uint64_t i = 0; i < header.entryCount; ++i) {
+    IndexEntry entry;
+    memcpy(&entry, cursor, sizeof(entry));
+    cursor += sizeof(entry);
+    auto it = state.segments.find(entry.segment);
+    if (it == state.segments.end() ||
+        entry.offset + sizeof(RecordHeader) > it->second->end) {
+      return invalid("entry out of bounds");
+    }
+    state.index.emplace(
+        InodeNumber{entry.inodeNumber}, Location{entry.segment, entry.offset});
+  }
+  state.nextSequence = header.nextSequence;
+  return InodeNumber{header.nextInodeNumber};
+}
+
+InodeNumber SegmentInodeCatalog::rebuildIndex(State& state) {
+  struct Latest {
+    Location location;
+    uint64_t sequence;
+    bool tombstone;
+  };
+  folly::F14FastMap<InodeNumber, Latest> latest;
+  uint64_t maxInodeNumber = kRootNodeId.get();
+  uint64_t maxSequence = 0;
+
+  for (auto& [id, segment] : state.segments) {
+    size_t offset = sizeof(SegmentHeader);
+    while (auto header =
+               validateRecord(segment->data(), offset, segment->size())) {
+      Location location{id, static_cast<uint32_t>(offset)};
+      auto inodeNumber = InodeNumber{header->inodeNumber};
+      Latest record{
+          location, header->sequence, header->entryCount == kTombstone};
+      auto [it, inserted] = latest.try_emplace(inodeNumber, record);
+      if (!inserted && it->second.sequence < header->sequence) {
+        it->second = record;
+      }
+
+      maxSequence = std::max(maxSequence, header->sequence);
+      maxInodeNumber = std::max(maxInodeNumber, header->inodeNumber);
+      if (header->entryCount != kTombstone) {
+        for (const auto& [name, entry] :
+             *parseRecord(*segment, offset).entries()) {
+          maxInodeNumber = std::max<uint64_t>(
+              maxInodeNumber, folly::to_unsigned(*entry.inodeNumber()));
+        }
+      }
+      offset += recordSize(*header);
+    }
+    segment->end = offset;
+    segment->liveBytes = 0;
+  }
+
+  state.index.clear();
+  state.index.reserve(latest.size());
+  for (const auto& [inodeNumber, record] : latest) {
+    if (record.tombstone) {
+      continue;
+    }
+    state.index.emplace(inodeNumber, record.location);
+    auto& segment = *state.segments.at(record.location.segment);
+    segment.liveBytes +=
+        recordSize(readRecordHeader(segment.data() + record.location.offset));
+  }
+  state.nextSequence = maxSequence + 1;
+  return InodeNumber{maxInodeNumber + 1};
+}
+
+void SegmentInodeCatalog::saveIndex(
+    const State& state,
+    InodeNumber nextInodeNumber) {
+  IndexHeader header{
+      kIndexMagic,
+      kVersion,
+      nextInodeNumber.get(),
+      state.nextSequence,
+      state.segments.size(),
+      state.index.size()};
+
+  std::string data;
+  data.reserve(
+      sizeof(header) + state.segments.size() * sizeof(IndexSegment) +
+      state.index.size() * sizeof(IndexEntry));
+  data.append(reinterpret_cast<const char*>(&header), sizeof(header));
+  for (const auto& [id, segment] : state.segments) {
+    IndexSegment indexSegment{
+        id, static_cast<uint32_t>(segment->end), segment->liveBytes};
+    data.append(
+        reinterpret_cast<const char*>(&indexSegment), sizeof(indexSegment));
+  }
+  for (const auto& [inodeNumber, location] : state.index) {
+    IndexEntry entry{inodeNumber.get(), location.segment, location.offset};
+    data.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+  }
+
+  writeFileAtomic(
+      segmentDir_ + kIndexFile,
+      folly::ByteRange{
+          reinterpret_cast<const uint8_t*>(data.data()), data.size()})
+      .value();
+}
+
+void SegmentInodeCatalog::close(std::optional<InodeNumber> nextInodeNumber) {
+  auto state = state_.wlock();
+  if (!state->initialized) {
+    return;
+  }
+  if (nextInodeNumber) {
+    // The index describes the segments: make sure they reached the disk
+    // before it does.
+    for (const auto& [id, segment] : state->segments) {
+      folly::checkUnixError(
+          ::msync(segment->data(), segment->size(), MS_SYNC),
+          "failed to sync directory segment ",
+          id);
+    }
+    saveIndex(*state, *nextInodeNumber);
+  }
+  state->segments.clear();
+  state->index.clear();
+  state->initialized = false;
+}
+
+bool SegmentInodeCatalog::initialized() const {
+  return state_.rlock()->initialized;
+}
+
+overlay::OverlayDir SegmentInodeCatalog::parseRecord(
+    const Segment& segment,
+    size_t offset) {
+  const auto* record = segment.data() + offset;
+  auto header = readRecordHeader(record);
+  const auto* cursor = record + sizeof(RecordHeader);
+  const auto* end = cursor + header.payloadSize;
+
+  overlay::OverlayDir odir;
+  auto& entries = *odir.entries();
+  for (uint32_t i = 0; i < header.entryCount && cursor < end; ++i) {
+    EntryHeader entryHeader;
+    memcpy(&entryHeader, cursor, sizeof(entryHeader));
+    cursor += sizeof(entryHeader);
+    auto hashLength =
+        entryHeader.hashLength == kNoHash ? 0 : entryHeader.hashLength;
+    if (cursor + entryHeader.nameLength + hashLength > end) {
+      // The checksum matched, so this was written by a buggy version.
+      throw std::runtime_error(fmt::format(
+          "corrupt directory record for inode {}", header.inodeNumber));
+    }
+
+    overlay::OverlayEntry entry;
+    entry.mode() = entryHeader.mode;
+    entry.inodeNumber() = folly::to_signed(entryHeader.inodeNumber);
+    const auto* name = reinterpret_cast<const char*>(cursor);
+    cursor += entryHeader.nameLength;
+    if (entryHeader.hashLength != kNoHash) {
+      entry.hash() =
+          std::string{reinterpret_cast<const char*>(cursor), hashLength};
+      cursor += hashLength;
+    }
+    entries.emplace_hint(
+        entries.end(),
+        std::string{name, entryHeader.nameLength},
+        std::move(entry));
+  }
+  return odir;
+}
+
+void SegmentInodeCatalog::append(
+    State& state,
+    InodeNumber inodeNumber,
+    const overlay::OverlayDir* odir) {
+  auto payload = odir ? payloadSize(*odir) : 0;
+  auto size = alignRecord(sizeof(RecordHeader) + payload);
+  auto& segment = activeSegment(state, size);
+  auto* record = segment.data() + segment.end;
+
+  auto* cursor = record + sizeof(RecordHeader);
+  if (odir) {
+    for (const auto& [name, entry] : *odir->entries()) {
+      auto hash = entry.hash();
+      EntryHeader entryHeader{
+          folly::to_unsigned(*entry.inodeNumber()),
+          static_cast<uint32_t>(*entry.mode()),
+          static_cast<uint16_t>(name.size()),
+          hash ? static_cast<uint16_t>(hash->size()) : kNoHash};
+      memcpy(cursor, &entryHeader, sizeof(entryHeader));
+      cursor += sizeof(entryHeader);
+      memcpy(cursor, name.data(), name.size());
+      cursor += name.size();
+      if (hash) {
+        memcpy(cursor, hash->data(), hash->size());
+        cursor += hash->size();
+      }
+    }
+  }
+
+  RecordHeader header{
+      0,
+      static_cast<uint32_t>(payload),
+      inodeNumber.get(),
+      state.nextSequence++,
+      odir ? static_cast<uint32_t>(odir->entries()->size()) : kTombstone,
+      0};
+  memcpy(record, &header, sizeof(header));
+  header.checksum = recordChecksum(record, payload);
+  memcpy(record, &header.checksum, sizeof(header.checksum));
+
+  Location location{segment.id, static_cast<uint32_t>(segment.end)};
+  segment.end += size;
+
+  auto it = state.index.find(inodeNumber);
+  if (it != state.index.end()) {
+    auto& previous = *state.segments.at(it->second.segment);
+    previous.liveBytes -=
+        recordSize(readRecordHeader(previous.data() + it->second.offset));
+  }
+  if (odir) {
+    state.index.insert_or_assign(inodeNumber, location);
+    segment.liveBytes += size;
+  } else if (it != state.index.end()) {
+    state.index.erase(it);
+  }
+}
+
+std::optional<overlay::OverlayDir> SegmentInodeCatalog::loadOverlayDir(
+    InodeNumber inodeNumber) {
+  auto state = state_.rlock();
+  auto it = state->index.find(inodeNumber);
+  if (it == state->index.end()) {
+    return std::nullopt;
+  }
+  return parseRecord(
+      *state->segments.at(it->second.segment), it->second.offset);
+}
+
+std::optional<overlay::OverlayDir>
+SegmentInodeCatalog::loadAndRemoveOverlayDir(InodeNumber inodeNumber) {
+  auto state = state_.wlock();
+  auto it = state->index.find(inodeNumber);
+  if (it == state->index.end()) {
+    return std::nullopt;
+  }
+  auto odir =
+      parseRecord(*state->segments.at(it->second.segment), it->second.offset);
+  append(*state, inodeNumber, nullptr);
+  return odir;
+}
+
+void SegmentInodeCatalog::saveOverlayDir(
+    InodeNumber inodeNumber,
+    overlay::OverlayDir&& odir) {
+  auto state = state_.wlock();
+  append(*state, inodeNumber, &odir);
+}
+
+void SegmentInodeCatalog::removeOverlayDir(InodeNumber inodeNumber) {
+  auto state = state_.wlock();
+  // Directories without a record don't need a tombstone.
+  if (state->index.count(inodeNumber)) {
+    append(*state, inodeNumber, nullptr);
+  }
+}
+
+bool SegmentInodeCatalog::hasOverlayDir(InodeNumber inodeNumber) {
+  return state_.rlock()->index.count(inodeNumber);
+}
+
+void SegmentInodeCatalog::maintenance() {
+  // Compact one segment at a time so that loads can make progress in between.
+  for (;;) {
+    auto state = state_.wlock();
+    if (!state->initialized || state->segments.size() < 2) {
+      return;
+    }
+    std::optional<uint32_t> candidate;
+    auto active = state->segments.rbegin()->first;
+    for (const auto& [id, segment] : state->segments) {
+      if (id != active &&
+          2 * segment->liveBytes < segment->end - sizeof(SegmentHeader)) {
+        candidate = id;
+        break;
+      }
+    }
+    if (!candidate) {
+      return;
+    }
+    compactSegment(*state, *candidate);
+  }
+}
+
+void SegmentInodeCatalog::compactSegment(State& state, uint32_t id) {
+  auto& segment = *state.segments.at(id);
+  // No record older than the tombstones of the oldest segment remains, so
+  // those can be dropped. Others still shadow records in older segments.
+  bool oldest = id == state.segments.begin()->first;
+
+  size_t moved = 0;
+  size_t offset = sizeof(SegmentHeader);
+  while (auto header = validateRecord(segment.data(), offset, segment.end)) {
+    auto size = recordSize(*header);
+    auto inodeNumber = InodeNumber{header->inodeNumber};
+    auto it = state.index.find(inodeNumber);
+    bool live = header->entryCount != kTombstone && it != state.index.end() &&
+        it->second == Location{id, static_cast<uint32_t>(offset)};
+    bool keepTombstone = header->entryCount == kTombstone && !oldest &&
+        it == state.index.end();
+
+    if (live || keepTombstone) {
+      // The copy keeps its sequence and thus its checksum.
+      auto& destination = activeSegment(state, size);
+      memcpy(
+          destination.data() + destination.end,
+          segment.data() + offset,
+          size);
+      if (live) {
+        it->second =
+            Location{destination.id, static_cast<uint32_t>(destination.end)};
+        destination.liveBytes += size;
+      }
+      destination.end += size;
+      moved += size;
+    }
+    offset += size;
+  }
+
+  // The copies must be durable before the originals are deleted.
+  for (auto it = state.segments.upper_bound(id); it != state.segments.end();
+       ++it) {
+    folly::checkUnixError(
+        ::msync(it->second->data(), it->second->size(), MS_SYNC),
+        "failed to sync directory segment ",
+        it->first);
+  }
+
+  XLOG(DBG2) << "Compacted directory segment " << id << ": moved " << moved
+             << " of " << segment.end << " bytes";
+  auto path = segmentPath(id);
+  state.segments.erase(id);
+  folly::checkUnixError(::unlink(path.c_str()), "failed to unlink ", path);
+}
+
+SegmentInodeCatalog::Stats SegmentInodeCatalog::getStats() const {
+  auto state = state_.rlock();
+  Stats stats;
+  stats.segmentCount = state->segments.size();
+  stats.directoryCount = state->index.size();
+  for (const auto& [id, segment] : state->segments) {
+    stats.usedBytes += segment->end;
+    stats.liveBytes += segment->liveBytes;
+  }
+  return stats;
+}
+
+} // namespace facebook::eden
+
+#endif
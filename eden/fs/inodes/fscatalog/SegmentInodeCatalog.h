@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/SharedMutex.h>
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/system/MemoryMapping.h>
+#include <map>
+#include <memory>
+#include <optional>
+
+#include "eden/fs/inodes/InodeCatalog.h"
+#include "eden/fs/inodes/InodeNumber.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * An InodeCatalog packing the directory records into a few large segment
+ * files. The segments are memory-mapped and only ever appended to, and an
+ * in-memory index maps each inode number to the latest record of its
+ * directory.
+ *
+ * FsInodeCatalog stores every directory in its own file, so each load costs
+ * an open, a read and a close followed by a Thrift deserialization. Here,
+ * loads and existence checks parse the record in place from the mapping,
+ * without any syscall.
+ *
+ * Saving a directory again appends a new record and removing it appends a
+ * tombstone. Either way the previous record is left dead. maintenance()
+ * rewrites the live records of the full segments that are mostly dead and
+ * then deletes those segments.
+ *
+ * Records are checksummed and ordered by a sequence number. After an unclean
+ * shutdown the index is rebuilt by scanning the segments, stopping at the
+ * first torn record of each, so initOverlay() always knows the next inode
+ * number and the overlay never needs an fsck scan. On close(), the index is
+ * saved along with the next inode number. It is only loaded back after a
+ * clean shutdown.
+ *
+ * File contents are still stored by the FileContentStore.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class SegmentInodeCatalog : public InodeCatalog {
+ public:
+  static constexpr size_t kDefaultSegmentSize = 64 * 1024 * 1024;
+
+  explicit SegmentInodeCatalog(
+      AbsolutePathPiece localDir,
+      size_t segmentSize = kDefaultSegmentSize);
+
+  ~SegmentInodeCatalog() override;
+
+  /**
+   * Whether the overlay in localDir was created with a SegmentInodeCatalog,
+   * which it must then keep using.
+   */
+  static bool existsIn(AbsolutePathPiece localDir);
+
+  /**
+   * Whether the overlay in localDir should use a SegmentInodeCatalog: either
+   * it was created with one, or it doesn't exist yet and enabled is set.
+   */
+  static bool shouldUse(AbsolutePathPiece localDir, bool enabled);
+
+  bool supportsSemanticOperations() const override {
+    return false;
+  }
+
+  std::optional<InodeNumber> initOverlay(bool createIfNonExisting) override;
+
+  void close(std::optional<InodeNumber> nextInodeNumber) override;
+
+  bool initialized() const override;
+
+  std::optional<overlay::OverlayDir> loadOverlayDir(
+      InodeNumber inodeNumber) override;
+
+  std::optional<overlay::OverlayDir> loadAndRemoveOverlayDir(
+      InodeNumber inodeNumber) override;
+
+  void saveOverlayDir(InodeNumber inodeNumber, overlay::OverlayDir&& odir)
+      override;
+
+  void removeOverlayDir(InodeNumber inodeNumber) override;
+
+  bool hasOverlayDir(InodeNumber inodeNumber) override;
+
+  /**
+   * Compact the full segments whose records are mostly dead.
+   */
+  void maintenance() override;
+
+  struct Stats {
+    size_t segmentCount{0};
+    size_t directoryCount{0};
+    size_t usedBytes{0};
+    size_t liveBytes{0};
+  };
+
+  Stats getStats() const;
+
+ private:
+  struct Segment {
+    uint32_t id;
+    folly::MemoryMapping mapping;
+    // Offset past the last record.
+    size_t end;
+    // Bytes of the records the index points to.
+    size_t liveBytes;
+
+    uint8_t* data() const {
+      return mapping.writableRange().data();
+    }
+
+    size_t size() const {
+      return mapping.range().size();
+    }
+  };
+
+  struct Location {
+    uint32_t segment;
+    uint32_t offset;
+
+    bool operator==(const Location& other) const {
+      return segment == other.segment && offset == other.offset;
+    }
+  };
+
+  struct State {
+    // By id. Records are appended to the last one.
+    std::map<uint32_t, std::unique_ptr<Segment>> segments;
+    folly::F14FastMap<InodeNumber, Location> index;
+    uint64_t nextSequence{1};
+    bool initialized{false};
+  };
+
+  AbsolutePath segmentPath(uint32_t id) const;
+
+  void openSegment(State& state, uint32_t id);
+
+  Segment& createSegment(State& state, size_t minimumSize);
+
+  /**
+   * The segment to append a record of recordSize bytes to.
+   */
+  Segment& activeSegment(State& state, size_t recordSize);
+
+  /**
+   * Load the index saved by the last clean shutdown, returning the next
+   * inode number.
+   */
+  std::optional<InodeNumber> loadIndex(State& state);
+
+  /**
+   * Rebuild the index by scanning all the records, returning the next inode
+   * number.
+   */
+  InodeNumber rebuildIndex(State& state);
+
+  void saveIndex(const State& state, InodeNumber nextInodeNumber);
+
+  /**
+   * Append a record for inodeNumber. A null odir appends a tombstone.
+   */
+  void append(
+      State& state,
+      InodeNumber inodeNumber,
+      const overlay::OverlayDir* odir);
+
+  static overlay::OverlayDir parseRecord(const Segment& segment, size_t offset);
+
+  void compactSegment(State& state, uint32_t id);
+
+  const AbsolutePath localDir_;
+  const AbsolutePath segmentDir_;
+  const size_t segmentSize_;
+
+  /**
+   * Loads take the lock shared, appends and compactions exclusively.
+   */
+  folly::Synchronized<State, folly::SharedMutex> state_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/inodes/fscatalog/BlobCloneCache.h"
+
+#include <folly/FileUtil.h>
+#include <folly/portability/GTest.h>
+#include <folly/portability/SysStat.h>
+#include <string>
+
+#include "eden/fs/testharness/TempFile.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+class BlobCloneCacheTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    cacheDir_ = path() + "cache"_pc;
+    dir_ = folly::File{path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC};
+  }
+
+  AbsolutePath path() const {
+    return canonicalPath(tempDir_.path().string());
+  }
+
+  std::optional<folly::File>
+  clone(BlobCloneCache& cache, std::string_view key, std::string contents) {
+    iovec iov{contents.data(), contents.size()};
+    return cache.clone(key, &iov, 1, dir_.fd(), std::string{key}.c_str());
+  }
+
+  static std::string readAll(const folly::File& file) {
+    std::string contents;
+    EXPECT_TRUE(folly::readFile(file.fd(), contents));
+    return contents;
+  }
+
+  folly::test::TemporaryDirectory tempDir_ = makeTempDir();
+  AbsolutePath cacheDir_;
+  folly::File dir_;
+};
+
+} // namespace
+
+TEST_F(BlobCloneCacheTest, clonesCachedContents) {
+  BlobCloneCache cache{cacheDir_, 1024};
+  auto file = clone(cache, "a", "contents of a");
+  if (!file) {
+    EXPECT_EQ(0u, cache.getCachedBytes());
+    struct stat st;
+    EXPECT_NE(0, lstat((path() + "a"_pc).c_str(), &st));
+    GTEST_SKIP() << "the filesystem of " << path() << " can't clone files";
+  }
+  EXPECT_EQ("contents of a", readAll(*file));
+  EXPECT_EQ(13u, cache.getCachedBytes());
+
+  // The cached copy is used, whatever the contents passed.
+  unlink((path() + "a"_pc).c_str());
+  file = clone(cache, "a", "ignored");
+  ASSERT_TRUE(file.has_value());
+  EXPECT_EQ("contents of a", readAll(*file));
+  EXPECT_EQ(13u, cache.getCachedBytes());
+}
+
+TEST_F(BlobCloneCacheTest, evictsLeastRecentlyUsed) {
+  BlobCloneCache cache{cacheDir_, 20};
+  if (!clone(cache, "a", "0123456789")) {
+    GTEST_SKIP() << "the filesystem of " << path() << " can't clone files";
+  }
+  ASSERT_TRUE(clone(cache, "b", "0123456789"));
+  // Using "a" again makes "b" the least recently used.
+  ASSERT_TRUE(clone(cache, "a", "0123456789"));
+  ASSERT_TRUE(clone(cache, "c", "0123456789"));
+  EXPECT_EQ(20u, cache.getCachedBytes());
+
+  struct stat st;
+  EXPECT_EQ(0, lstat((cacheDir_ + "a"_pc).c_str(), &st));
+  EXPECT_NE(0, lstat((cacheDir_ + "b"_pc).c_str(), &st));
+  EXPECT_EQ(0, lstat((cacheDir_ + "c"_pc).c_str(), &st));
+
+  // A new cache picks up the cached files.
+  BlobCloneCache reopened{cacheDir_, 20};
+  auto file = clone(reopened, "c", "ignored");
+  ASSERT_TRUE(file.has_value());
+  EXPECT_EQ("0123456789", readAll(*file));
+  EXPECT_EQ(20u, reopened.getCachedBytes());
+}
+
+#endif
@@ -460,6 +460,46 @@ TEST(Fsck, testBadFileData) {
   overlay->fs().close(checker.getNextInodeNumber());
 }
 
+TEST(Fsck, testCheckpointSkipsCheckedFiles) {
+  auto overlay = make_shared<TestOverlay>();
+  auto root = overlay->init();
+  SimpleOverlayLayout layout(root);
+  auto checkpointPath = overlay->overlayPath() + "fsck-checkpoint"_pc;
+
+  OverlayChecker::LookupCallback lookup = [](auto&&) {
+    return makeImmediateFuture<OverlayChecker::LookupCallbackValue>(
+        std::runtime_error("no lookup callback"));
+  };
+  auto scan = [&] {
+    auto checker = std::make_unique<OverlayChecker>(
+        &overlay->fs(),
+        &overlay->fcs(),
+        std::nullopt,
+        lookup,
+        OverlayChecker::kDefaultThreadCount,
+        /*useCheckpoint=*/true);
+    checker->scanForErrors();
+    return checker;
+  };
+
+  // A scan interrupted before the repair leaves its checkpoint behind.
+  EXPECT_THAT(errorMessages(*scan()), UnorderedElementsAre());
+  EXPECT_TRUE(readFile(checkpointPath).hasValue());
+
+  // The files it checked are not read again.
+  std::string badHeader(FileContentStore::kHeaderLength, 0x55);
+  overlay->corruptInodeHeader(layout.src_foo_testTxt.number(), badHeader);
+  auto resumed = scan();
+  EXPECT_THAT(errorMessages(*resumed), UnorderedElementsAre());
+
+  // Completing the repair removes the checkpoint.
+  resumed->repairErrors();
+  EXPECT_FALSE(readFile(checkpointPath).hasValue());
+  EXPECT_EQ(1, scan()->getErrors().size());
+
+  overlay->fs().close(resumed->getNextInodeNumber());
+}
+
 TEST(Fsck, testTruncatedDirData) {
   auto overlay = make_shared<TestOverlay>();
   auto root = overlay->init();
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/inodes/fscatalog/SegmentInodeCatalog.h"
+
+#include <fmt/format.h>
+#include <folly/portability/GTest.h>
+#include <string>
+
+#include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
+#include "eden/fs/testharness/TempFile.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+overlay::OverlayDir makeDir(std::initializer_list<std::string> names) {
+  overlay::OverlayDir odir;
+  int64_t inodeNumber = 100;
+  for (const auto& name : names) {
+    overlay::OverlayEntry entry;
+    entry.mode() = S_IFREG | 0644;
+    entry.inodeNumber() = inodeNumber++;
+    odir.entries()->emplace(name, std::move(entry));
+  }
+  return odir;
+}
+
+class SegmentInodeCatalogTest : public ::testing::Test {
+ protected:
+  std::unique_ptr<SegmentInodeCatalog> open(
+      size_t segmentSize = SegmentInodeCatalog::kDefaultSegmentSize) {
+    auto catalog = std::make_unique<SegmentInodeCatalog>(path(), segmentSize);
+    nextInodeNumber_ = catalog->initOverlay(true);
+    return catalog;
+  }
+
+  AbsolutePath path() const {
+    return canonicalPath(dir_.path().string());
+  }
+
+  folly::test::TemporaryDirectory dir_ = makeTempDir();
+  std::optional<InodeNumber> nextInodeNumber_;
+};
+
+} // namespace
+
+TEST_F(SegmentInodeCatalogTest, savesAndLoadsDirectories) {
+  auto catalog = open();
+  EXPECT_EQ(kRootNodeId.get() + 1, nextInodeNumber_->get());
+
+  auto odir = makeDir({"a", "b"});
+  odir.entries()->at("a").hash() = std::string{"\x01\x02\x03", 3};
+  // An empty hash is not the same as no hash.
+  odir.entries()->at("b").hash() = std::string{};
+  overlay::OverlayEntry subdir;
+  subdir.mode() = S_IFDIR | 0755;
+  subdir.inodeNumber() = 3;
+  odir.entries()->emplace("c", std::move(subdir));
+  catalog->saveOverlayDir(kRootNodeId, overlay::OverlayDir{odir});
+
+  EXPECT_TRUE(catalog->hasOverlayDir(kRootNodeId));
+  EXPECT_FALSE(catalog->hasOverlayDir(InodeNumber{3}));
+  auto loaded = catalog->loadOverlayDir(kRootNodeId);
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(odir, *loaded);
+  EXPECT_FALSE(loaded->entries()->at("c").hash().has_value());
+  EXPECT_TRUE(loaded->entries()->at("b").hash().has_value());
+  EXPECT_FALSE(catalog->loadOverlayDir(InodeNumber{3}).has_value());
+
+  catalog->saveOverlayDir(kRootNodeId, makeDir({"d"}));
+  loaded = catalog->loadOverlayDir(kRootNodeId);
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(makeDir({"d"}), *loaded);
+}
+
+TEST_F(SegmentInodeCatalogTest, removesDirectories) {
+  auto catalog = open();
+  catalog->saveOverlayDir(InodeNumber{2}, makeDir({"a"}));
+  catalog->saveOverlayDir(InodeNumber{3}, makeDir({"b"}));
+
+  auto removed = catalog->loadAndRemoveOverlayDir(InodeNumber{2});
+  ASSERT_TRUE(removed.has_value());
+  EXPECT_EQ(makeDir({"a"}), *removed);
+  EXPECT_FALSE(catalog->hasOverlayDir(InodeNumber{2}));
+  EXPECT_FALSE(catalog->loadAndRemoveOverlayDir(InodeNumber{2}).has_value());
+
+  catalog->removeOverlayDir(InodeNumber{3});
+  EXPECT_FALSE(catalog->hasOverlayDir(InodeNumber{3}));
+  EXPECT_EQ(0, catalog->getStats().directoryCount);
+}
+
+TEST_F(SegmentInodeCatalogTest, reopensAfterCleanShutdown) {
+  {
+    auto catalog = open();
+    catalog->saveOverlayDir(InodeNumber{2}, makeDir({"a"}));
+    catalog->saveOverlayDir(InodeNumber{3}, makeDir({"b"}));
+    catalog->removeOverlayDir(InodeNumber{3});
+    catalog->close(InodeNumber{42});
+  }
+
+  EXPECT_TRUE(SegmentInodeCatalog::existsIn(path()));
+  auto catalog = open();
+  EXPECT_EQ(InodeNumber{42}, nextInodeNumber_);
+  auto loaded = catalog->loadOverlayDir(InodeNumber{2});
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(makeDir({"a"}), *loaded);
+  EXPECT_FALSE(catalog->hasOverlayDir(InodeNumber{3}));
+}
+
+TEST_F(SegmentInodeCatalogTest, rebuildsIndexAfterUncleanShutdown) {
+  {
+    auto catalog = open();
+    catalog->saveOverlayDir(InodeNumber{2}, makeDir({"a"}));
+    catalog->saveOverlayDir(InodeNumber{3}, makeDir({"b"}));
+    catalog->saveOverlayDir(InodeNumber{2}, makeDir({"a", "c"}));
+    catalog->removeOverlayDir(InodeNumber{3});
+    // Not closed, as if the process had crashed.
+  }
+
+  auto catalog = open();
+  ASSERT_TRUE(nextInodeNumber_.has_value());
+  // The children of the saved directories used inode numbers 100 and 101.
+  EXPECT_EQ(102, nextInodeNumber_->get());
+  auto loaded = catalog->loadOverlayDir(InodeNumber{2});
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(makeDir({"a", "c"}), *loaded);
+  EXPECT_FALSE(catalog->hasOverlayDir(InodeNumber{3}));
+}
+
+TEST_F(SegmentInodeCatalogTest, maintenanceCompactsDeadRecords) {
+  std::vector<std::string> names;
+  for (int i = 0; i < 100; ++i) {
+    names.push_back(fmt::format("some_file_name_{}", i));
+  }
+  overlay::OverlayDir bigDir;
+  for (const auto& name : names) {
+    overlay::OverlayEntry entry;
+    entry.mode() = S_IFREG | 0644;
+    entry.inodeNumber() = 100;
+    bigDir.entries()->emplace(name, std::move(entry));
+  }
+
+  auto catalog = open(64 * 1024);
+  // Rewriting the same directories leaves the earlier segments mostly dead.
+  for (int round = 0; round < 50; ++round) {
+    for (uint64_t ino = 2; ino < 6; ++ino) {
+      catalog->saveOverlayDir(InodeNumber{ino}, overlay::OverlayDir{bigDir});
+    }
+  }
+  catalog->saveOverlayDir(InodeNumber{6}, makeDir({"kept"}));
+  catalog->removeOverlayDir(InodeNumber{5});
+
+  auto before = catalog->getStats();
+  ASSERT_GT(before.segmentCount, 2);
+  catalog->maintenance();
+  auto after = catalog->getStats();
+  EXPECT_LT(after.segmentCount, before.segmentCount);
+  EXPECT_LT(after.usedBytes, before.usedBytes);
+  EXPECT_EQ(before.liveBytes, after.liveBytes);
+  EXPECT_EQ(4, after.directoryCount);
+
+  for (uint64_t ino = 2; ino < 5; ++ino) {
+    auto loaded = catalog->loadOverlayDir(InodeNumber{ino});
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(bigDir, *loaded);
+  }
+  EXPECT_FALSE(catalog->hasOverlayDir(InodeNumber{5}));
+
+  // The compacted segments must hold up without the index too.
+  catalog.reset();
+  catalog = open(64 * 1024);
+  EXPECT_EQ(4, catalog->getStats().directoryCount);
+  EXPECT_FALSE(catalog->hasOverlayDir(InodeNumber{5}));
+  auto loaded = catalog->loadOverlayDir(InodeNumber{6});
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(makeDir({"kept"}), *loaded);
+}
+
+TEST_F(SegmentInodeCatalogTest, onlyNewOverlaysOptIn) {
+  EXPECT_FALSE(SegmentInodeCatalog::shouldUse(path(), false));
+  EXPECT_TRUE(SegmentInodeCatalog::shouldUse(path(), true));
+
+  // An existing legacy overlay.
+  writeFile(path() + "info"_pc, folly::StringPiece{"legacy"}).value();
+  EXPECT_FALSE(SegmentInodeCatalog::shouldUse(path(), true));
+
+  open();
+  EXPECT_TRUE(SegmentInodeCatalog::shouldUse(path(), false));
+}
+
+#endif
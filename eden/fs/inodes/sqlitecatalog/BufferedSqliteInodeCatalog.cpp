@@ -11,7 +11,9 @@
 #include <folly/logging/xlog.h>
 #include <folly/system/ThreadName.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
+#include <algorithm>
 #include <cstddef>
+#include <iterator>
 
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/inodes/InodeNumber.h"
@@ -24,7 +26,8 @@ BufferedSqliteInodeCatalog::BufferedSqliteInodeCatalog(
     const EdenConfig& config,
     SqliteTreeStore::SynchronousMode mode)
     : SqliteInodeCatalog(path, mode),
-      bufferSize_{config.overlayBufferSize.getValue()} {
+      bufferSize_{config.overlayBufferSize.getValue()},
+      groupCommit_{config.overlayBufferGroupCommit.getValue()} {
   workerThread_ = std::thread{[this] {
     folly::setThreadName("OverlayBuffer");
     processOnWorkerThread();
@@ -35,7 +38,8 @@ BufferedSqliteInodeCatalog::BufferedSqliteInodeCatalog(
     std::unique_ptr<SqliteDatabase> store,
     const EdenConfig& config)
     : SqliteInodeCatalog(std::move(store)),
-      bufferSize_{config.overlayBufferSize.getValue()} {
+      bufferSize_{config.overlayBufferSize.getValue()},
+      groupCommit_{config.overlayBufferGroupCommit.getValue()} {
   workerThread_ = std::thread{[this] {
     folly::setThreadName("OverlayBuffer");
     processOnWorkerThread();
@@ -52,8 +56,8 @@ void BufferedSqliteInodeCatalog::stopWorkerThread() {
     state->workerThreadStopRequested = true;
     // Manually insert the shutdown request to avoid waiting for the enforced
     // size limit.
-    state->work.push_back(
-        std::make_unique<Work>([]() { return true; }, std::nullopt, 0));
+    state->work.push_back(std::make_unique<Work>(
+        []() { return true; }, std::nullopt, 0, /*barrier=*/true));
     workCV_.notify_one();
     fullCV_.notify_all();
   }
@@ -116,14 +120,46 @@ void BufferedSqliteInodeCatalog::processOnWorkerThread() {
       // processed
     }
 
-    for (auto& event : work) {
-      // event will return true if it was a stopping event, in which case the
-      // thread should exit
-      if (event->operation()) {
+    // Committing every write on its own dominates the cost of small writes,
+    // so commit the writes between two barriers at once.
+    auto begin = work.begin();
+    while (begin != work.end()) {
+      auto end = std::find_if(
+          begin, work.end(), [](const auto& event) { return event->barrier; });
+      if (end != work.end()) {
+        ++end;
+      }
+      if (runWork(begin, end)) {
         return;
       }
+      begin = end;
+    }
+  }
+}
+
+bool BufferedSqliteInodeCatalog::runWork(
+    std::vector<std::unique_ptr<Work>>::iterator begin,
+    std::vector<std::unique_ptr<Work>>::iterator end) {
+  // The barrier, if any, is last and runs after the commit.
+  auto writesEnd = end;
+  if (begin != end && (*std::prev(end))->barrier) {
+    --writesEnd;
+  }
+
+  auto runWrites = [&] {
+    for (auto it = begin; it != writesEnd; ++it) {
+      (*it)->operation();
     }
+  };
+  if (!groupCommit_ || std::distance(begin, writesEnd) < 2) {
+    runWrites();
+  } else {
+    groupTransactions(runWrites);
   }
+
+  // The barrier will return true if it was a stopping event, in which case the
+  // thread should exit
+  return writesEnd != end && (*writesEnd)->operation();
 }
 
 void BufferedSqliteInodeCatalog::process(
@@ -174,7 +210,8 @@ void BufferedSqliteInodeCatalog::pause(folly::Future<folly::Unit>&& fut) {
         return false;
       },
       std::nullopt,
-      0));
+      0,
+      /*barrier=*/true));
   workCV_.notify_one();
 }
 
@@ -192,7 +229,8 @@ void BufferedSqliteInodeCatalog::flush() {
           return false;
         },
         std::nullopt,
-        0));
+        0,
+        /*barrier=*/true));
     workCV_.notify_one();
   }
 
@@ -81,19 +81,23 @@ class BufferedSqliteInodeCatalog : public SqliteInodeCatalog {
 
   /**
    * Structure wrapping work waiting to be processed. odir will be std::nullopt
-   * except when the creator was saveOverlayDir
+   * except when the creator was saveOverlayDir. Barriers (shutdown, flush and
+   * pause requests) only run once the work queued before them is committed.
    */
   struct Work {
     explicit Work(
         folly::Function<bool()> operation,
         std::optional<overlay::OverlayDir> odir,
-        size_t estimateIndirectMemoryUsage)
+        size_t estimateIndirectMemoryUsage,
+        bool barrier = false)
         : operation(std::move(operation)),
           odir(std::move(odir)),
-          estimateIndirectMemoryUsage(estimateIndirectMemoryUsage) {}
+          estimateIndirectMemoryUsage(estimateIndirectMemoryUsage),
+          barrier(barrier) {}
     folly::Function<bool()> operation;
     std::optional<overlay::OverlayDir> odir;
     size_t estimateIndirectMemoryUsage;
+    bool barrier;
   };
 
   /**
@@ -122,6 +126,8 @@ class BufferedSqliteInodeCatalog : public SqliteInodeCatalog {
 
   // Maximum size of the buffer in bytes
   const size_t bufferSize_;
+  // Whether the writes taken from the buffer at once are committed together
+  const bool groupCommit_;
   std::thread workerThread_;
   folly::Synchronized<State, std::mutex> state_;
   // Encodes the condition !state_.work.empty()
@@ -147,6 +153,14 @@ class BufferedSqliteInodeCatalog : public SqliteInodeCatalog {
    */
   void processOnWorkerThread();
 
+  /**
+   * Run the work between two barriers. Returns whether the worker thread
+   * should stop.
+   */
+  bool runWork(
+      std::vector<std::unique_ptr<Work>>::iterator begin,
+      std::vector<std::unique_ptr<Work>>::iterator end);
+
   void stopWorkerThread();
 
   /**
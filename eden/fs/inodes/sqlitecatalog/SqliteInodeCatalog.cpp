@@ -8,17 +8,44 @@
 #include "eden/fs/inodes/sqlitecatalog/SqliteInodeCatalog.h"
 
 #include <folly/File.h>
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+#include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
 #include "eden/fs/inodes/sqlitecatalog/WindowsFsck.h"
 #include "eden/fs/utils/Bug.h"
+#include "eden/fs/utils/FileUtils.h"
 
 namespace facebook::eden {
 
+namespace {
+constexpr PathComponentPiece kUsnJournalPositionFile =
+    PathComponentPiece{"usn-journal-position"};
+
+#ifdef _WIN32
+std::optional<UsnJournalPosition> loadUsnJournalPosition(
+    AbsolutePathPiece path) {
+  auto contents = readFile(path);
+  if (contents.hasException()) {
+    return std::nullopt;
+  }
+  uint64_t journalId;
+  int64_t usn;
+  if (!folly::split(' ', folly::trimWhitespace(*contents), journalId, usn)) {
+    XLOGF(WARN, "Ignoring the malformed change journal position in {}", path);
+    return std::nullopt;
+  }
+  return UsnJournalPosition{journalId, usn};
+}
+#endif
+} // namespace
+
 SqliteInodeCatalog::SqliteInodeCatalog(
     AbsolutePathPiece path,
     SqliteTreeStore::SynchronousMode mode)
-    : store_{path, mode} {}
+    : store_{path, mode},
+      usnJournalPositionPath_{path + kUsnJournalPositionFile} {}
 
 std::optional<InodeNumber> SqliteInodeCatalog::initOverlay(
     bool createIfNonExisting) {
@@ -31,6 +58,24 @@ std::optional<InodeNumber> SqliteInodeCatalog::initOverlay(
 
 void SqliteInodeCatalog::close(std::optional<InodeNumber> /*nextInodeNumber*/) {
   store_.close();
+#ifdef _WIN32
+  if (usnJournalMountPath_) {
+    if (auto position = getUsnJournalPosition(*usnJournalMountPath_)) {
+      auto contents =
+          fmt::format("{} {}", position->journalId, position->usn);
+      auto result = writeFileAtomic(
+          *usnJournalPositionPath_,
+          folly::ByteRange{folly::StringPiece{contents}});
+      if (result.hasException()) {
+        XLOGF(
+            WARN,
+            "Unable to record the change journal position of {}: {}",
+            *usnJournalMountPath_,
+            result.exception().what());
+      }
+    }
+  }
+#endif
 }
 
 std::optional<overlay::OverlayDir> SqliteInodeCatalog::loadOverlayDir(
@@ -93,6 +138,20 @@ InodeNumber SqliteInodeCatalog::scanLocalChanges(
     AbsolutePathPiece mountPath,
     FOLLY_MAYBE_UNUSED SqliteInodeCatalog::LookupCallback& callback) {
 #ifdef _WIN32
+  if (usnJournalPositionPath_ && config->fsckUseUsnJournal.getValue()) {
+    // Only a clean close records the position, and it is removed right away
+    // for a crash to cause a full scan on the next startup.
+    auto since = loadUsnJournalPosition(*usnJournalPositionPath_);
+    removeFileWithAbsolutePath(*usnJournalPositionPath_);
+    usnJournalMountPath_ = mountPath.copy();
+    if (since && !mayHaveChangedSince(mountPath, *since)) {
+      XLOGF(
+          INFO,
+          "Skipping the scan of {}, which didn't change since EdenFS stopped",
+          mountPath);
+      return store_.loadCounters();
+    }
+  }
   windowsFsckScanLocalChanges(config, *this, mountPath, callback);
 #else
   (void)config;
@@ -96,6 +96,10 @@ class SqliteInodeCatalog : public InodeCatalog {
    * Scan filesystem changes when EdenFS is not running. This is only required
    * on Windows as ProjectedFS allows user to make changes under certain
    * directory when EdenFS is not running.
+   *
+   * With fsck:use-usn-journal, the scan is skipped when the previous
+   * shutdown was clean and the change journal shows no change under
+   * mountPath since.
    */
   InodeNumber scanLocalChanges(
       std::shared_ptr<const EdenConfig> config,
@@ -106,9 +110,30 @@ class SqliteInodeCatalog : public InodeCatalog {
     store_.maintenance();
   }
 
+ protected:
+  /**
+   * Commit the changes made by func at once, see
+   * SqliteDatabase::groupTransactions().
+   */
+  void groupTransactions(folly::FunctionRef<void()> func) {
+    store_.groupTransactions(func);
+  }
+
  private:
   SqliteTreeStore store_;
 
   bool initialized_ = false;
+
+  /**
+   * Where a clean close records the position of the change journal. Unset
+   * for the catalogs that aren't stored in a directory.
+   */
+  std::optional<AbsolutePath> usnJournalPositionPath_;
+
+  /**
+   * The mount whose change journal position is recorded on close, set by
+   * scanLocalChanges.
+   */
+  std::optional<AbsolutePath> usnJournalMountPath_;
 };
 } // namespace facebook::eden
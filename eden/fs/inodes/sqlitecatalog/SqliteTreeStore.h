@@ -145,6 +145,14 @@ class SqliteTreeStore {
     db_->checkpoint();
   }
 
+  /**
+   * Commit the changes made by func at once, see
+   * SqliteDatabase::groupTransactions().
+   */
+  void groupTransactions(folly::FunctionRef<void()> func) {
+    db_->groupTransactions(func);
+  }
+
  private:
   FRIEND_TEST(SqliteTreeStoreTest, testRecoverInodeEntryNumber);
 
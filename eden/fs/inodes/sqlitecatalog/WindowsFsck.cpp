@@ -10,6 +10,10 @@
 
 #ifdef _WIN32
 #include <boost/filesystem.hpp>
+#include <folly/container/F14Map.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <folly/futures/Future.h>
 #include <folly/portability/Windows.h>
 
 #include <ProjectedFSLib.h> // @manual
@@ -510,21 +514,54 @@ std::optional<InodeNumber> fixup(
   }
 }
 
+/**
+ * The state shared by all the directories of one thorough scan. The
+ * directories are processed concurrently on the executor, each of them only
+ * writing the overlay entries of its own children.
+ */
+struct ThoroughScan {
+  ThoroughScan(
+      SqliteInodeCatalog& inodeCatalog,
+      AbsolutePathPiece root,
+      const SqliteInodeCatalog::LookupCallback& callback,
+      uint64_t logFrequency,
+      folly::Executor::KeepAlive<> executor)
+      : inodeCatalog{inodeCatalog},
+        root{root},
+        callback{callback},
+        logFrequency{logFrequency},
+        executor{std::move(executor)} {}
+
+  SqliteInodeCatalog& inodeCatalog;
+  AbsolutePathPiece root;
+  const SqliteInodeCatalog::LookupCallback& callback;
+  const uint64_t logFrequency;
+  folly::Executor::KeepAlive<> executor;
+  std::atomic<uint64_t> traversedDirectories{1};
+};
+
+ImmediateFuture<bool> processChildDirectory(
+    ThoroughScan& scan,
+    InodeNumber parentInodeNumber,
+    RelativePath childPath,
+    InodeNumber childInodeNumber,
+    FsckFileState childState);
+
 // Returns true if the given path is considered materialized.
-bool processChildren(
-    SqliteInodeCatalog& inodeCatalog,
+//
+// The insensitiveOverlayDir and scmTree are only used before this returns,
+// the returned future completes once all the descendant directories were
+// processed.
+ImmediateFuture<bool> processChildren(
+    ThoroughScan& scan,
     RelativePathPiece path,
-    AbsolutePathPiece root,
     InodeNumber inodeNumber,
     const PathMap<overlay::OverlayEntry>& insensitiveOverlayDir,
-    const std::shared_ptr<const Tree>& scmTree,
-    const SqliteInodeCatalog::LookupCallback& callback,
-    uint64_t logFrequency,
-    uint64_t& traversedDirectories) {
+    const std::shared_ptr<const Tree>& scmTree) {
   XLOGF(DBG9, "processChildren - {}", path);
 
-  traversedDirectories++;
-  if (traversedDirectories % logFrequency == 0) {
+  auto traversedDirectories = ++scan.traversedDirectories;
+  if (traversedDirectories % scan.logFrequency == 0) {
     // TODO: We could also report the progress to the StartupLogger to be
     // displayed in the user console. That however requires a percent and it's
     // a bit unclear how we can compute this percent.
@@ -535,8 +572,10 @@ bool processChildren(
   PathMap<FsckFileState> children{CaseSensitivity::Insensitive};
 
   // Populate children disk information
-  auto absPath = (root + path + "*"_relpath).wide();
+  auto absPath = (scan.root + path + "*"_relpath).wide();
 
+  // Large fetches let each NtQueryDirectoryFile call made under the hood
+  // return many more entries, which matters for the wide directories.
   WIN32_FIND_DATAW findFileData;
   HANDLE h = FindFirstFileExW(
       absPath.c_str(),
@@ -544,7 +583,7 @@ bool processChildren(
       &findFileData,
       FindExSearchNameMatch,
       nullptr,
-      0);
+      FIND_FIRST_EX_LARGE_FETCH);
   if (h == INVALID_HANDLE_VALUE) {
     throw std::runtime_error(
         fmt::format("unable to iterate over directory - {}", path));
@@ -558,7 +597,7 @@ bool processChildren(
     }
     PathComponent name{findFileData.cFileName};
     auto& childState = children[name];
-    populateDiskState(root, path + name, childState, findFileData);
+    populateDiskState(scan.root, path + name, childState, findFileData);
   } while (FindNextFileW(h, &findFileData) != 0);
 
   auto error = GetLastError();
@@ -591,13 +630,14 @@ bool processChildren(
 
   // Recurse for any children.
   bool anyChildMaterialized = false;
+  std::vector<ImmediateFuture<bool>> childDirectories;
   for (auto& [childName, childState] : children) {
     auto childPath = path + childName;
     XLOGF(DBG9, "process child - {}", childPath);
 
     std::optional<InodeNumber> childInodeNumberOpt = fixup(
         childState,
-        inodeCatalog,
+        scan.inodeCatalog,
         childPath,
         inodeNumber,
         insensitiveOverlayDir);
@@ -606,58 +646,88 @@ bool processChildren(
 
     if (childState.desiredDtype == dtype_t::Dir && childState.onDisk &&
         !childState.diskEmptyPlaceholder && childInodeNumberOpt.has_value()) {
-      // Fetch child scm tree.
-      std::shared_ptr<const Tree> childScmTree;
-      if (childState.scmDtype == dtype_t::Dir) {
-        // TODO: handle scm failure
-        auto scmEntryTry = callback(childPath).getTry();
-        std::variant<
-            std::shared_ptr<const facebook::eden::Tree>,
-            facebook::eden::TreeEntry>& childScmEntry = scmEntryTry.value();
-        // It's guaranteed to be a Tree since scmDtype is Dir.
-        childScmTree = std::get<std::shared_ptr<const Tree>>(childScmEntry);
-      }
-
-      auto childInodeNumber = *childInodeNumberOpt;
-      auto childOverlayDir = *inodeCatalog.loadOverlayDir(childInodeNumber);
-      auto childInsensitiveOverlayDir = toPathMap(childOverlayDir);
-      bool childMaterialized = childState.diskMaterialized;
-      childMaterialized |= processChildren(
-          inodeCatalog,
-          childPath,
-          root,
-          childInodeNumber,
-          childInsensitiveOverlayDir,
-          childScmTree,
-          callback,
-          logFrequency,
-          traversedDirectories);
-      anyChildMaterialized |= childMaterialized;
-
-      if (childMaterialized && childState.desiredHash != std::nullopt) {
-        XLOGF(
-            DBG9,
-            "Directory {} has a materialized child, and therefore is materialized too. Marking.",
-            childPath);
-        childState.diskMaterialized = true;
-        childState.desiredHash = std::nullopt;
-        // Refresh the parent state so we see and update the current overlay
-        // entry.
-        auto updatedOverlayDir = *inodeCatalog.loadOverlayDir(inodeNumber);
-        auto updatedInsensitiveOverlayDir = toPathMap(updatedOverlayDir);
-        // Update the overlay entry to remove the scmHash.
-        addOrUpdateOverlay(
-            inodeCatalog,
-            inodeNumber,
-            childName,
-            childState.desiredDtype,
-            childState.desiredHash,
-            updatedInsensitiveOverlayDir);
-      }
+      childDirectories.push_back(processChildDirectory(
+          scan,
+          inodeNumber,
+          std::move(childPath),
+          *childInodeNumberOpt,
+          std::move(childState)));
     }
   }
 
-  return anyChildMaterialized;
+  return collectAllSafe(std::move(childDirectories))
+      .thenValue([anyChildMaterialized](std::vector<bool> materialized) {
+        return anyChildMaterialized ||
+            std::find(materialized.begin(), materialized.end(), true) !=
+            materialized.end();
+      });
+}
+
+// Returns true if the given child directory is considered materialized.
+ImmediateFuture<bool> processChildDirectory(
+    ThoroughScan& scan,
+    InodeNumber parentInodeNumber,
+    RelativePath childPath,
+    InodeNumber childInodeNumber,
+    FsckFileState childState) {
+  auto scmDtype = childState.scmDtype;
+  auto descendants =
+      folly::via(scan.executor, [&scan, childPath, childInodeNumber, scmDtype] {
+        // Fetch child scm tree.
+        std::shared_ptr<const Tree> childScmTree;
+        if (scmDtype == dtype_t::Dir) {
+          // TODO: handle scm failure
+          auto scmEntryTry = scan.callback(childPath).getTry();
+          std::variant<
+              std::shared_ptr<const facebook::eden::Tree>,
+              facebook::eden::TreeEntry>& childScmEntry = scmEntryTry.value();
+          // It's guaranteed to be a Tree since scmDtype is Dir.
+          childScmTree = std::get<std::shared_ptr<const Tree>>(childScmEntry);
+        }
+
+        auto childOverlayDir =
+            *scan.inodeCatalog.loadOverlayDir(childInodeNumber);
+        auto childInsensitiveOverlayDir = toPathMap(childOverlayDir);
+        return processChildren(
+                   scan,
+                   childPath,
+                   childInodeNumber,
+                   childInsensitiveOverlayDir,
+                   childScmTree)
+            .semi();
+      });
+
+  return ImmediateFuture<bool>{std::move(descendants).semi()}.thenValue(
+      [&scan,
+       parentInodeNumber,
+       childPath = std::move(childPath),
+       childState = std::move(childState)](bool materialized) mutable {
+        // A directory with a materialized descendant is materialized too.
+        bool childMaterialized = childState.diskMaterialized || materialized;
+
+        if (childMaterialized && childState.desiredHash != std::nullopt) {
+          XLOGF(
+              DBG9,
+              "Directory {} has a materialized child, and therefore is materialized too. Marking.",
+              childPath);
+          childState.diskMaterialized = true;
+          childState.desiredHash = std::nullopt;
+          // Refresh the parent state so we see and update the current overlay
+          // entry.
+          auto updatedOverlayDir =
+              *scan.inodeCatalog.loadOverlayDir(parentInodeNumber);
+          auto updatedInsensitiveOverlayDir = toPathMap(updatedOverlayDir);
+          // Update the overlay entry to remove the scmHash.
+          addOrUpdateOverlay(
+              scan.inodeCatalog,
+              parentInodeNumber,
+              childPath.basename(),
+              childState.desiredDtype,
+              childState.desiredHash,
+              updatedInsensitiveOverlayDir);
+        }
+        return childMaterialized;
+      });
 }
 
 void scanCurrentDir(
@@ -800,6 +870,104 @@ void scanCurrentDir(
     }
   }
 }
+constexpr size_t kUsnJournalReadSize = 64 * 1024;
+
+// Past this many records, scanning the working copy is likely cheaper than
+// finding the directories of all the records.
+constexpr size_t kMaxUsnJournalRecords = 100000;
+
+FileHandle openDirectory(AbsolutePathPiece path) {
+  return FileHandle{CreateFileW(
+      path.wide().c_str(),
+      FILE_READ_ATTRIBUTES,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+      nullptr,
+      OPEN_EXISTING,
+      FILE_FLAG_BACKUP_SEMANTICS,
+      nullptr)};
+}
+
+std::optional<USN_JOURNAL_DATA_V0> queryUsnJournal(
+    HANDLE handle,
+    AbsolutePathPiece mountPath) {
+  USN_JOURNAL_DATA_V0 journal;
+  DWORD bytes;
+  if (!DeviceIoControl(
+          handle,
+          FSCTL_QUERY_USN_JOURNAL,
+          nullptr,
+          0,
+          &journal,
+          sizeof(journal),
+          &bytes,
+          nullptr)) {
+    XLOGF(
+        WARN,
+        "Unable to query the change journal of {}: {}",
+        mountPath,
+        win32ErrorToString(GetLastError()));
+    return std::nullopt;
+  }
+  return journal;
+}
+
+std::optional<std::wstring> getFinalPath(HANDLE handle) {
+  constexpr DWORD kFlags = FILE_NAME_NORMALIZED | VOLUME_NAME_NT;
+  std::wstring path(MAX_PATH, L'\0');
+  auto length =
+      GetFinalPathNameByHandleW(handle, path.data(), path.size(), kFlags);
+  if (length >= path.size()) {
+    // The returned length is then the needed size, null terminator included.
+    path.resize(length);
+    length =
+        GetFinalPathNameByHandleW(handle, path.data(), path.size(), kFlags);
+  }
+  if (length == 0 || length >= path.size()) {
+    return std::nullopt;
+  }
+  path.resize(length);
+  return path;
+}
+
+bool isUnder(std::wstring_view path, std::wstring_view root) {
+  if (path.size() < root.size() ||
+      CompareStringOrdinal(
+          path.data(), root.size(), root.data(), root.size(), TRUE) !=
+          CSTR_EQUAL) {
+    return false;
+  }
+  return path.size() == root.size() || path[root.size()] == L'\\';
+}
+
+// Returns true if the directory with the given file reference number is
+// currently under root.
+//
+// A directory that no longer exists is reported as not being under root: had
+// it been under root, its removal or rename would have been recorded in its
+// parent, and so on up to a directory that still exists.
+bool directoryIsUnder(
+    HANDLE volumeHint,
+    DWORDLONG fileReference,
+    std::wstring_view root) {
+  FILE_ID_DESCRIPTOR id{};
+  id.dwSize = sizeof(id);
+  id.Type = FileIdType;
+  id.FileId.QuadPart = fileReference;
+  FileHandle dir{OpenFileById(
+      volumeHint,
+      &id,
+      FILE_READ_ATTRIBUTES,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+      nullptr,
+      FILE_FLAG_BACKUP_SEMANTICS)};
+  if (!dir) {
+    return false;
+  }
+  auto path = getFinalPath(dir.get());
+  // A directory that exists but can't be resolved could be anywhere.
+  return !path || isUnder(*path, root);
+}
+
 } // namespace
 
 void windowsFsckScanLocalChanges(
@@ -818,17 +986,20 @@ void windowsFsckScanLocalChanges(
           facebook::eden::TreeEntry>& scmEntry = scmEntryTry.value();
       std::shared_ptr<const Tree> scmTree =
           std::get<std::shared_ptr<const Tree>>(scmEntry);
-      uint64_t traversedDirectories = 1;
-      processChildren(
+      // The directories are listed and fixed up by the threads of the
+      // executor while this thread waits for the whole scan to complete.
+      folly::CPUThreadPoolExecutor executor{
+          std::max(config->fsckThreads.getValue(), size_t{1}),
+          std::make_shared<folly::NamedThreadFactory>("WindowsFsck")};
+      ThoroughScan scan{
           inodeCatalog,
-          ""_relpath,
           mountPath,
-          kRootNodeId,
-          insensitiveOverlayDir,
-          scmTree,
           callback,
           config->fsckLogFrequency.getValue(),
-          traversedDirectories);
+          folly::getKeepAliveToken(executor)};
+      processChildren(
+          scan, ""_relpath, kRootNodeId, insensitiveOverlayDir, scmTree)
+          .get();
     } else {
       scanCurrentDir(
           inodeCatalog,
@@ -846,6 +1017,110 @@ void windowsFsckScanLocalChanges(
   }
 }
 
+std::optional<UsnJournalPosition> getUsnJournalPosition(
+    AbsolutePathPiece mountPath) {
+  auto root = openDirectory(mountPath);
+  if (!root) {
+    XLOGF(
+        WARN,
+        "Unable to open {}: {}",
+        mountPath,
+        win32ErrorToString(GetLastError()));
+    return std::nullopt;
+  }
+  auto journal = queryUsnJournal(root.get(), mountPath);
+  if (!journal) {
+    return std::nullopt;
+  }
+  return UsnJournalPosition{journal->UsnJournalID, journal->NextUsn};
+}
+
+bool mayHaveChangedSince(
+    AbsolutePathPiece mountPath,
+    const UsnJournalPosition& since) {
+  auto root = openDirectory(mountPath);
+  if (!root) {
+    return true;
+  }
+  auto rootPath = getFinalPath(root.get());
+  auto journal = queryUsnJournal(root.get(), mountPath);
+  if (!rootPath || !journal) {
+    return true;
+  }
+  if (journal->UsnJournalID != since.journalId) {
+    XLOGF(INFO, "The change journal of {} was recreated", mountPath);
+    return true;
+  }
+  if (since.usn < journal->FirstUsn) {
+    XLOGF(INFO, "The change journal of {} dropped records", mountPath);
+    return true;
+  }
+
+  // Whether the parent directories of the records are under the mount.
+  folly::F14FastMap<DWORDLONG, bool> parents;
+  size_t numRecords = 0;
+
+  READ_USN_JOURNAL_DATA_V0 read{};
+  read.StartUsn = since.usn;
+  read.ReasonMask = 0xFFFFFFFF;
+  read.UsnJournalID = journal->UsnJournalID;
+  // USN_RECORD_V2 are 8 bytes aligned.
+  std::vector<uint64_t> buffer(kUsnJournalReadSize / sizeof(uint64_t));
+  auto* data = reinterpret_cast<char*>(buffer.data());
+
+  // Only the records written before this startup matter.
+  while (read.StartUsn < journal->NextUsn) {
+    DWORD bytes;
+    if (!DeviceIoControl(
+            root.get(),
+            FSCTL_READ_UNPRIVILEGED_USN_JOURNAL,
+            &read,
+            sizeof(read),
+            data,
+            kUsnJournalReadSize,
+            &bytes,
+            nullptr) ||
+        bytes < sizeof(USN)) {
+      XLOGF(
+          WARN,
+          "Unable to read the change journal of {}: {}",
+          mountPath,
+          win32ErrorToString(GetLastError()));
+      return true;
+    }
+
+    // The output starts with the USN to continue reading from.
+    auto nextUsn = *reinterpret_cast<USN*>(data);
+    for (DWORD offset = sizeof(USN); offset < bytes;) {
+      auto* record = reinterpret_cast<USN_RECORD_V2*>(data + offset);
+      offset += record->RecordLength;
+      if (record->Usn >= journal->NextUsn) {
+        return false;
+      }
+      if (++numRecords > kMaxUsnJournalRecords) {
+        XLOGF(INFO, "Too many changes on the volume of {}", mountPath);
+        return true;
+      }
+      auto [it, inserted] =
+          parents.try_emplace(record->ParentFileReferenceNumber, false);
+      if (inserted) {
+        it->second = directoryIsUnder(
+            root.get(), record->ParentFileReferenceNumber, *rootPath);
+      }
+      if (it->second) {
+        XLOGF(DBG2, "{} changed while EdenFS was not running", mountPath);
+        return true;
+      }
+    }
+
+    if (nextUsn <= read.StartUsn) {
+      break;
+    }
+    read.StartUsn = nextUsn;
+  }
+  return false;
+}
+
 } // namespace facebook::eden
 
 #endif
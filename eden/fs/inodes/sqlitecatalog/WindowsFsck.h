@@ -52,6 +52,30 @@ void windowsFsckScanLocalChanges(
     AbsolutePathPiece mountPath,
     SqliteInodeCatalog::LookupCallback& callback);
 
+/**
+ * A position in the change journal of an NTFS volume.
+ */
+struct UsnJournalPosition {
+  uint64_t journalId;
+  int64_t usn;
+};
+
+/**
+ * Returns the current end of the change journal of the volume holding
+ * `mountPath`, or std::nullopt if the journal can't be queried.
+ */
+std::optional<UsnJournalPosition> getUsnJournalPosition(
+    AbsolutePathPiece mountPath);
+
+/**
+ * Returns true unless the change journal proves that nothing under
+ * `mountPath` changed since `since`. Any doubt, like a journal that was
+ * recreated or that dropped the records since then, returns true.
+ */
+bool mayHaveChangedSince(
+    AbsolutePathPiece mountPath,
+    const UsnJournalPosition& since);
+
 } // namespace facebook::eden
 
 #endif
@@ -1454,6 +1454,48 @@ TEST(Checkout, testSetPathObjectIdCheckoutMultipleFiles) {
   EXPECT_FILE_INODE(testMount.getFileInode(path2), contents2, 0644);
 }
 
+TEST(Checkout, testSetPathObjectIdBatchUnderSharedDirectories) {
+  // Start with an empty mount
+  auto builder1 = FakeTreeBuilder{};
+  TestMount testMount{builder1, false};
+
+  testMount.getBackingStore()->putBlob(ObjectId{"1"}, "one")->setReady();
+  testMount.getBackingStore()->putBlob(ObjectId{"2"}, "two")->setReady();
+  testMount.getBackingStore()->putBlob(ObjectId{"3"}, "three")->setReady();
+
+  // Several parents, created by the batch, sharing their leading directories.
+  std::vector<SetPathObjectIdObjectAndPath> objects;
+  for (auto [path, id] :
+       {std::pair{"shared/a/file.txt", "1"},
+        std::pair{"shared/a/sub/file.txt", "2"},
+        std::pair{"shared/b/file.txt", "3"}}) {
+    auto object = getObjects(
+        RelativePathPiece{path}, id, facebook::eden::ObjectType::REGULAR_FILE);
+    objects.push_back(std::move(object.at(0)));
+  }
+
+  auto setPathObjectIdResultAndTimes =
+      testMount.getEdenMount()
+          ->setPathsToObjectIds(
+              std::move(objects),
+              facebook::eden::CheckoutMode::NORMAL,
+              ObjectFetchContext::getNullContext())
+          .semi()
+          .via(testMount.getServerExecutor().get());
+
+  testMount.drainServerExecutor();
+
+  auto result = std::move(setPathObjectIdResultAndTimes).get();
+  EXPECT_EQ(0, result.result.conflicts_ref()->size());
+
+  EXPECT_FILE_INODE(
+      testMount.getFileInode("shared/a/file.txt"_relpath), "one", 0644);
+  EXPECT_FILE_INODE(
+      testMount.getFileInode("shared/a/sub/file.txt"_relpath), "two", 0644);
+  EXPECT_FILE_INODE(
+      testMount.getFileInode("shared/b/file.txt"_relpath), "three", 0644);
+}
+
 #endif
 
 template <typename Unloader>
@@ -1633,6 +1675,96 @@ TEST(Checkout, conflict_when_directory_containing_modified_file_is_removed) {
   }
 }
 
+namespace {
+CheckoutResult checkoutLoadedSubdirectories(size_t parallelism) {
+  auto builder1 = FakeTreeBuilder{};
+  auto builder2 = FakeTreeBuilder{};
+  for (auto dir : {"d1", "d2", "d3", "d4"}) {
+    builder1.setFile(fmt::format("{}/file.txt", dir), "old");
+    builder2.setFile(fmt::format("{}/file.txt", dir), "new");
+  }
+  TestMount testMount{builder1};
+  testMount.getEdenConfig()->checkoutParallelism.setValue(
+      parallelism, ConfigSource::CommandLine);
+  builder2.finalize(testMount.getBackingStore(), true);
+  testMount.getBackingStore()->putCommit("2", builder2)->setReady();
+
+  // Keep the directories loaded so that checkout recurses into them.
+  std::vector<TreeInodePtr> dirs;
+  for (auto dir : {"d1", "d2", "d3", "d4"}) {
+    dirs.push_back(testMount.getTreeInode(folly::StringPiece{dir}));
+  }
+
+  auto executor = testMount.getServerExecutor().get();
+  auto checkoutResult = testMount.getEdenMount()
+                            ->checkout(RootId{"2"}, std::nullopt, __func__)
+                            .waitVia(executor);
+  EXPECT_TRUE(checkoutResult.isReady());
+  auto result = std::move(checkoutResult).get();
+  EXPECT_THAT(result.conflicts, UnorderedElementsAre());
+  for (auto dir : {"d1", "d2", "d3", "d4"}) {
+    EXPECT_FILE_INODE(
+        testMount.getFileInode(fmt::format("{}/file.txt", dir)), "new", 0644);
+  }
+  return result;
+}
+} // namespace
+
+TEST(Checkout, checkoutSchedulesSubdirectoriesOnThreadPool) {
+  auto result = checkoutLoadedSubdirectories(8);
+  EXPECT_EQ(5u, result.progress.treesCompared);
+  EXPECT_EQ(5u, result.progress.treesSaved);
+  // Only the loaded directories needed loading, the files are replaced
+  // directly.
+  EXPECT_EQ(4u, result.progress.actionsStarted);
+  EXPECT_EQ(4u, result.progress.actionsCompleted);
+  EXPECT_EQ(4u, result.progress.subtreesScheduled);
+
+  // Past the limit, directories are checked out on the thread reaching them.
+  result = checkoutLoadedSubdirectories(2);
+  EXPECT_EQ(5u, result.progress.treesCompared);
+  EXPECT_LE(result.progress.subtreesScheduled, 2u);
+
+  result = checkoutLoadedSubdirectories(0);
+  EXPECT_EQ(5u, result.progress.treesCompared);
+  EXPECT_EQ(0u, result.progress.subtreesScheduled);
+}
+
+namespace {
+size_t countTreeFetchesBeforeInodeCheckout(bool prefetch) {
+  auto builder1 = FakeTreeBuilder{};
+  builder1.setFile("dir/sub/file.txt", "old");
+  TestMount testMount{builder1};
+  testMount.getEdenConfig()->prefetchCheckoutObjects.setValue(
+      prefetch, ConfigSource::CommandLine);
+  auto builder2 = FakeTreeBuilder{};
+  builder2.setFile("dir/sub/file.txt", "new");
+  builder2.finalize(testMount.getBackingStore(), true);
+  testMount.getBackingStore()->putCommit("2", builder2)->setReady();
+  auto subTreeId = builder2.getStoredTree("dir/sub"_relpath)->get().getHash();
+
+  auto& faultInjector = testMount.getServerState()->getFaultInjector();
+  faultInjector.injectBlock("inodeCheckout", ".*");
+  auto executor = testMount.getServerExecutor().get();
+  auto checkout =
+      testMount.getEdenMount()->checkout(RootId{"2"}, std::nullopt, __func__);
+  testMount.drainServerExecutor();
+  EXPECT_FALSE(checkout.isReady());
+  auto fetches = testMount.getBackingStore()->getAccessCount(subTreeId);
+
+  faultInjector.unblock("inodeCheckout", ".*");
+  auto result = std::move(checkout).waitVia(executor);
+  EXPECT_TRUE(result.isReady());
+  EXPECT_FILE_INODE(testMount.getFileInode("dir/sub/file.txt"), "new", 0644);
+  return fetches;
+}
+} // namespace
+
+TEST(Checkout, checkoutPrefetchesChangedTreesBeforeWalkingInodes) {
+  EXPECT_LT(0u, countTreeFetchesBeforeInodeCheckout(true));
+  EXPECT_EQ(0u, countTreeFetchesBeforeInodeCheckout(false));
+}
+
 TEST(Checkout, checkoutFailsOnInProgressCheckout) {
   auto builder1 = FakeTreeBuilder();
   builder1.setFile("src/main.c", "// Some code.\n");
@@ -1737,7 +1869,8 @@ class FakePrjfsChannel : public PrjfsChannel {
             straceLogger,
             std::move(processNameCache),
             guid,
-            nullptr),
+            nullptr,
+            /*numServicingThreads=*/1),
         actions_{std::move(actions)} {}
 
   static void initializeFakePrjfsChannel(
@@ -1750,7 +1883,7 @@ class FakePrjfsChannel : public PrjfsChannel {
         &mount->getStraceLogger(),
         mount->getServerState()->getProcessNameCache(),
         mount->getCheckoutConfig()->getRepoGuid());
-    channel->start(false, false);
+    channel->start(false, false, 0, 0);
     mount->setTestPrjfsChannel(std::move(channel));
   }
 
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/CompactDirContents.h"
+
+#include <folly/portability/GTest.h>
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/Overlay.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+Tree makeTree(CaseSensitivity caseSensitive) {
+  Tree::container entries{caseSensitive};
+  entries.emplace(
+      "b"_pc, ObjectId{"object_b"}, TreeEntryType::EXECUTABLE_FILE);
+  entries.emplace("A"_pc, ObjectId{"object_A"}, TreeEntryType::TREE);
+  entries.emplace(
+      "c"_pc,
+      ObjectId{"a hash that doesn't fit in the small string buffer"},
+      TreeEntryType::REGULAR_FILE);
+  return Tree{std::move(entries), ObjectId{"tree"}};
+}
+
+} // namespace
+
+TEST(CompactDirContents, holdsTheEntriesOfTheTree) {
+  auto tree = makeTree(CaseSensitivity::Sensitive);
+  CompactDirContents dir{tree, CaseSensitivity::Sensitive};
+
+  ASSERT_EQ(3, dir.size());
+  EXPECT_EQ("A"_pc, dir.getName(0));
+  EXPECT_EQ("b"_pc, dir.getName(1));
+  EXPECT_EQ("c"_pc, dir.getName(2));
+
+  EXPECT_EQ(ObjectId{"object_A"}, dir.getHash(0));
+  EXPECT_EQ(
+      ObjectId{"a hash that doesn't fit in the small string buffer"},
+      dir.getHash(2));
+  EXPECT_EQ(dtype_t::Dir, dir.getDtype(0));
+  EXPECT_EQ(
+      modeFromTreeEntryType(TreeEntryType::EXECUTABLE_FILE),
+      dir.getInitialMode(1));
+
+  EXPECT_EQ(1, dir.find("b"_pc));
+  EXPECT_EQ(std::nullopt, dir.find("a"_pc));
+  EXPECT_EQ(std::nullopt, dir.find("d"_pc));
+}
+
+TEST(CompactDirContents, findHonorsCaseSensitivity) {
+  auto tree = makeTree(CaseSensitivity::Sensitive);
+  CompactDirContents dir{tree, CaseSensitivity::Insensitive};
+
+  EXPECT_EQ("A"_pc, dir.getName(0));
+  EXPECT_EQ(0, dir.find("a"_pc));
+  EXPECT_EQ(1, dir.find("B"_pc));
+}
+
+TEST(CompactDirContents, sortsForTheMountCaseSensitivity) {
+  // "a" < "B" when case insensitive, but "B" < "a" otherwise.
+  Tree::container entries{CaseSensitivity::Insensitive};
+  entries.emplace("a"_pc, ObjectId{"1"}, TreeEntryType::REGULAR_FILE);
+  entries.emplace("B"_pc, ObjectId{"2"}, TreeEntryType::REGULAR_FILE);
+  Tree mixed{std::move(entries), ObjectId{"tree"}};
+  CompactDirContents sensitive{mixed, CaseSensitivity::Sensitive};
+
+  EXPECT_EQ("B"_pc, sensitive.getName(0));
+  EXPECT_EQ("a"_pc, sensitive.getName(1));
+  EXPECT_EQ(1, sensitive.find("a"_pc));
+  EXPECT_EQ(std::nullopt, sensitive.find("b"_pc));
+}
+
+TEST(CompactDirContents, inodeNumbersAreAllocatedLazily) {
+  TestMount mount{FakeTreeBuilder{}};
+  auto& overlay = *mount.getEdenMount()->getOverlay();
+
+  auto tree = makeTree(CaseSensitivity::Sensitive);
+  CompactDirContents dir{tree, CaseSensitivity::Sensitive};
+  EXPECT_TRUE(dir.getAllocatedInodeNumber(1).empty());
+
+  auto number = dir.getInodeNumber(1, overlay);
+  EXPECT_TRUE(number.hasValue());
+  EXPECT_EQ(number, dir.getAllocatedInodeNumber(1));
+  EXPECT_EQ(number, dir.getInodeNumber(1, overlay));
+  EXPECT_TRUE(dir.getAllocatedInodeNumber(0).empty());
+
+  auto contents = std::move(dir).toDirContents(overlay);
+  ASSERT_EQ(3, contents.size());
+  EXPECT_EQ(number, contents.find("b"_pc)->second.getInodeNumber());
+  EXPECT_EQ(ObjectId{"object_A"}, contents.find("A"_pc)->second.getHash());
+  EXPECT_TRUE(contents.find("A"_pc)->second.isDirectory());
+  EXPECT_NE(
+      contents.find("A"_pc)->second.getInodeNumber(),
+      contents.find("c"_pc)->second.getInodeNumber());
+}
@@ -8,6 +8,7 @@
 #include <folly/executors/ManualExecutor.h>
 #include <folly/portability/GTest.h>
 
+#include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/model/TestOps.h"
@@ -136,4 +137,76 @@ TEST(Dematerialize, test_dematerialization_migrates_to_the_new_ID_scheme) {
   EXPECT_TRUE(inode->isUnlinked());
 }
 
+#ifndef _WIN32
+DematerializePassStats dematerializeUnchangedFiles(TestMount& mount) {
+  auto executor = mount.getServerExecutor().get();
+  return mount.getEdenMount()
+      ->dematerializeUnchangedFiles(
+          *mount.getEdenConfig(), ObjectFetchContext::getNullContext())
+      .semi()
+      .via(executor)
+      .getVia(executor);
+}
+
+TEST(Dematerialize, idle_files_matching_the_checked_out_commit) {
+  FakeTreeBuilder builder;
+  builder.setFile("a/same.txt"_relpath, "same\n", false, ObjectId{"same"});
+  builder.setFile("a/changed.txt"_relpath, "old\n", false, ObjectId{"old"});
+  builder.setFile("a/recent.txt"_relpath, "recent\n");
+  TestMount mount{builder};
+
+  // Materialize the files, but only change the contents of one.
+  mount.overwriteFile("a/same.txt", "same\n");
+  mount.overwriteFile("a/changed.txt", "new\n");
+  mount.getClock().advance(2h);
+  mount.overwriteFile("a/recent.txt", "recent\n");
+  mount.getEdenMount()->getRootInode()->unloadChildrenNow();
+
+  auto stats = dematerializeUnchangedFiles(mount);
+  EXPECT_EQ(2u, stats.checked);
+  EXPECT_EQ(1u, stats.dematerialized);
+  EXPECT_FALSE(stats.rateLimited);
+
+  auto same = mount.getFileInode("a/same.txt");
+  EXPECT_EQ(std::make_optional(ObjectId{"same"}), same->getBlobHash());
+  EXPECT_EQ(
+      "same\n", same->readAll(ObjectFetchContext::getNullContext()).get());
+  EXPECT_EQ(std::nullopt, mount.getFileInode("a/changed.txt")->getBlobHash());
+  EXPECT_EQ(std::nullopt, mount.getFileInode("a/recent.txt")->getBlobHash());
+  EXPECT_EQ(
+      "new\n",
+      mount.getFileInode("a/changed.txt")
+          ->readAll(ObjectFetchContext::getNullContext())
+          .get());
+}
+
+TEST(Dematerialize, files_known_to_differ_are_not_hashed_again) {
+  FakeTreeBuilder builder;
+  builder.setFile("changed.txt"_relpath, "old\n");
+  builder.setFile("same.txt"_relpath, "same\n");
+  TestMount mount{builder};
+  mount.getEdenConfig()->dematerializeUnchangedFilesMaxPerPass.setValue(
+      1, ConfigSource::CommandLine);
+
+  mount.overwriteFile("changed.txt", "new\n");
+  mount.overwriteFile("same.txt", "same\n");
+  mount.getClock().advance(2h);
+  mount.getEdenMount()->getRootInode()->unloadChildrenNow();
+
+  // The first pass stops after changed.txt, the second one skips it.
+  auto stats = dematerializeUnchangedFiles(mount);
+  EXPECT_EQ(1u, stats.checked);
+  EXPECT_EQ(0u, stats.dematerialized);
+  EXPECT_TRUE(stats.rateLimited);
+
+  stats = dematerializeUnchangedFiles(mount);
+  EXPECT_EQ(1u, stats.checked);
+  EXPECT_EQ(1u, stats.dematerialized);
+  EXPECT_FALSE(stats.rateLimited);
+
+  stats = dematerializeUnchangedFiles(mount);
+  EXPECT_EQ(0u, stats.checked);
+}
+#endif
+
 } // namespace
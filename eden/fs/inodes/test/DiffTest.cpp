@@ -172,6 +172,20 @@ TEST(DiffTest, noChanges) {
   test.checkNoChanges();
 }
 
+TEST(DiffTest, fileModifiedBelowLoadedDirectories) {
+  DiffTest test;
+  // Loaded directories with no change below them are skipped by their hash,
+  // while the ones above the modified file are diffed.
+  test.getMount().loadAllInodes();
+  test.getMount().overwriteFile("src/a/b/c/4.txt", "updated 4.txt\n");
+
+  auto result = test.diff();
+  EXPECT_THAT(
+      *result.entries_ref(),
+      UnorderedElementsAre(
+          std::make_pair("src/a/b/c/4.txt", ScmFileStatus::MODIFIED)));
+}
+
 TEST(DiffTest, fileModified) {
   DiffTest test;
   test.getMount().overwriteFile("src/1.txt", "This file has been updated.\n");
@@ -2209,3 +2223,49 @@ TEST(DiffTest, multiTreeDiff) {
       *status.entries(),
       UnorderedElementsAre(std::make_pair("b", ScmFileStatus::MODIFIED)));
 }
+
+TEST(DiffTest, statusCacheFollowsJournal) {
+  DiffTest test;
+  auto& mount = test.getMount();
+  mount.getEdenConfig()->enableScmStatusCache.setValue(
+      true, ConfigSource::CommandLine);
+  auto status = [&] {
+    auto future = test.diffFuture().semi().via(mount.getServerExecutor().get());
+    mount.drainServerExecutor();
+    return EXPECT_FUTURE_RESULT(future);
+  };
+
+  EXPECT_THAT(*status().entries(), UnorderedElementsAre());
+  // Nothing changed since the cached status.
+  EXPECT_THAT(*status().entries(), UnorderedElementsAre());
+
+  // Changes to tracked files only re-verify the changed paths.
+  mount.overwriteFile("src/1.txt", "This file has been updated.\n");
+  mount.deleteFile("src/a/b/3.txt");
+  EXPECT_THAT(
+      *status().entries(),
+      UnorderedElementsAre(
+          std::make_pair("src/1.txt", ScmFileStatus::MODIFIED),
+          std::make_pair("src/a/b/3.txt", ScmFileStatus::REMOVED)));
+
+  mount.overwriteFile("src/1.txt", "This is src/1.txt.\n");
+  EXPECT_THAT(
+      *status().entries(),
+      UnorderedElementsAre(
+          std::make_pair("src/a/b/3.txt", ScmFileStatus::REMOVED)));
+
+  // New files need the ignore files, and are found by diffing again.
+  mount.addFile("src/new.txt", "new\n");
+  EXPECT_THAT(
+      *status().entries(),
+      UnorderedElementsAre(
+          std::make_pair("src/a/b/3.txt", ScmFileStatus::REMOVED),
+          std::make_pair("src/new.txt", ScmFileStatus::ADDED)));
+
+  mount.overwriteFile("src/new.txt", "newer\n");
+  mount.addFile("src/a/b/3.txt", "This is 3.txt.\n");
+  EXPECT_THAT(
+      *status().entries(),
+      UnorderedElementsAre(
+          std::make_pair("src/new.txt", ScmFileStatus::ADDED)));
+}
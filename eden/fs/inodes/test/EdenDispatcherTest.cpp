@@ -12,6 +12,7 @@
 #include <folly/experimental/TestUtil.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/testharness/FakeTreeBuilder.h"
@@ -162,4 +163,36 @@ TEST(RawEdenDispatcherTest, lookup_returns_valid_inode_for_bad_file) {
   EXPECT_EQ(entry.nodeid, entry.attr.ino);
 }
 
+TEST(RawEdenDispatcherTest, materialized_files_use_their_own_attr_timeout) {
+  FakeTreeBuilder builder;
+  builder.setFile("clean", "contents");
+  TestMount mount;
+  mount.getEdenConfig()->fuseMaterializedAttrTimeout.setValue(
+      10s, ConfigSource::CommandLine);
+  mount.initialize(builder);
+
+  auto clean =
+      mount.getDispatcher()
+          ->lookup(
+              0, kRootNodeId, "clean"_pc, ObjectFetchContext::getNullContext())
+          .get(0ms);
+  EXPECT_EQ(std::numeric_limits<int32_t>::max(), clean.attr_valid);
+  EXPECT_EQ(std::numeric_limits<int32_t>::max(), clean.entry_valid);
+
+  auto created = mount.getDispatcher()
+                     ->create(
+                         kRootNodeId,
+                         "new"_pc,
+                         S_IFREG | 0644,
+                         0,
+                         ObjectFetchContext::getNullContext())
+                     .get(0ms);
+  EXPECT_EQ(10, created.attr_valid);
+
+  auto root = mount.getDispatcher()
+                  ->getattr(kRootNodeId, ObjectFetchContext::getNullContext())
+                  .get(0ms);
+  EXPECT_EQ(std::numeric_limits<int32_t>::max(), root.timeout_seconds);
+}
+
 #endif
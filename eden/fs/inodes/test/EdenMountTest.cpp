@@ -520,6 +520,43 @@ TEST(EdenMount, concurrentDeepEnsureDirectoryExists) {
   EXPECT_NE(nullptr, testMount.getTreeInode(dirPath));
 }
 
+TEST(EdenMount, pathLookupCacheFollowsRenames) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"a/b/c/d.txt", "d"}, {"a/b/c/e.txt", "e"}});
+  TestMount testMount;
+  testMount.getEdenConfig()->pathLookupCacheSize.setValue(
+      100, ConfigSource::CommandLine);
+  testMount.initialize(builder);
+  auto edenMount = testMount.getEdenMount();
+  auto context = ObjectFetchContext::getNullContext();
+
+  auto d = edenMount->getInodeSlow("a/b/c/d.txt"_relpath, context).get(0ms);
+  EXPECT_EQ(
+      d, edenMount->getInodeSlow("a/b/c/d.txt"_relpath, context).get(0ms));
+  auto e = edenMount->getVirtualInode("a/b/c/e.txt"_relpath, context).get(0ms);
+  EXPECT_EQ("a/b/c/e.txt"_relpath, e.asInodePtr()->getPath().value());
+
+  auto renameFuture = testMount.getTreeInode("a"_relpath)
+                          ->rename(
+                              "b"_pc,
+                              edenMount->getRootInode(),
+                              "f"_pc,
+                              InvalidationRequired::No,
+                              context)
+                          .semi()
+                          .via(testMount.getServerExecutor().get());
+  testMount.drainServerExecutor();
+  std::move(renameFuture).get(0ms);
+
+  EXPECT_THROW_ERRNO(
+      edenMount->getInodeSlow("a/b/c/d.txt"_relpath, context).get(0ms),
+      ENOENT);
+  EXPECT_THROW_ERRNO(
+      edenMount->getInodeSlow("a/b/c/e.txt"_relpath, context).get(0ms),
+      ENOENT);
+  EXPECT_EQ(d, edenMount->getInodeSlow("f/c/d.txt"_relpath, context).get(0ms));
+}
+
 TEST(EdenMount, setOwnerChangesTakeEffect) {
   FakeTreeBuilder builder;
   builder.setFile("dir/file.txt", "contents");
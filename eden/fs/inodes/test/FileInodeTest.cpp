@@ -15,7 +15,10 @@
 #include <folly/test/TestUtils.h>
 #include <chrono>
 
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/inodes/Overlay.h"
 #include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/inodes/fscatalog/FsInodeCatalog.h"
 #include "eden/fs/store/IObjectStore.h"
 #include "eden/fs/testharness/FakeBackingStore.h"
 #include "eden/fs/testharness/FakeTreeBuilder.h"
@@ -385,6 +388,27 @@ bool isInodeMaterialized(const TreeInodePtr& inode) {
 }
 } // namespace
 
+TEST_F(FileInodeTest, statReflectsChangesSinceLastStat) {
+  auto inode = mount_.getFileInode("dir/a.txt");
+  // The second stat of an unmodified file is served without the state lock.
+  EXPECT_EQ(15, getFileAttr(mount_, inode).st_size);
+  EXPECT_EQ(15, getFileAttr(mount_, inode).st_size);
+
+  DesiredMetadata desired;
+  desired.mode = 0600;
+  setFileAttr(mount_, inode, desired);
+  EXPECT_EQ((S_IFREG | 0600), getFileAttr(mount_, inode).st_mode);
+  EXPECT_EQ((S_IFREG | 0600), inode->getMetadata().mode);
+
+  mount_.getClock().advance(1min);
+  auto now = mount_.getClock().getTimePoint();
+  inode->write("more text\n", 15, ObjectFetchContext::getNullContext()).get();
+  auto attr = getFileAttr(mount_, inode);
+  EXPECT_EQ(25, attr.st_size);
+  EXPECT_EQ(stMtimepoint(attr), now);
+  EXPECT_EQ(25, getFileAttr(mount_, inode).st_size);
+}
+
 TEST_F(FileInodeTest, writingMaterializesParent) {
   auto inode = mount_.getFileInode("dir/sub/b.txt");
   auto parent = mount_.getTreeInode("dir/sub");
@@ -563,6 +587,40 @@ TEST(FileInode, writeDuringLoad) {
   EXPECT_FILE_INODE(inode, "ConTENTS not ready.\n", 0644);
 }
 
+TEST(FileInode, coalescesSmallSequentialWrites) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"a.txt", ""}});
+  TestMount mount;
+  mount.getEdenConfig()->overlayWriteBufferSize.setValue(
+      64, ConfigSource::CommandLine);
+  mount.initialize(builder);
+  auto inode = mount.getFileInode("a.txt");
+
+  auto overlayFileSize = [&] {
+    auto* overlay = mount.getEdenMount()->getOverlay();
+    auto file = overlay->openFileNoVerify(inode->getNodeId());
+    return file.fstat().value().st_size -
+        static_cast<off_t>(FileContentStore::kHeaderLength);
+  };
+
+  auto context = ObjectFetchContext::getNullContext();
+  EXPECT_EQ(3, inode->write("abc"_sp, 0, context).get(0ms));
+  EXPECT_EQ(3, inode->write("def"_sp, 3, context).get(0ms));
+  EXPECT_EQ(0, overlayFileSize());
+
+  // Reads see the buffered writes.
+  EXPECT_FILE_INODE(inode, "abcdef", 0644);
+  EXPECT_EQ(6, overlayFileSize());
+
+  // A non-sequential write writes back the buffered ones.
+  EXPECT_EQ(3, inode->write("ghi"_sp, 6, context).get(0ms));
+  EXPECT_EQ(1, inode->write("A"_sp, 0, context).get(0ms));
+  EXPECT_EQ(9, overlayFileSize());
+
+  inode->fsync(false);
+  EXPECT_FILE_INODE(inode, "Abcdefghi", 0644);
+}
+
 TEST(FileInode, truncateDuringLoad) {
   // Build a tree to test against, but do not mark the state ready yet
   FakeTreeBuilder builder;
@@ -634,6 +692,36 @@ TEST(FileInode, dropsCacheWhenFullyRead) {
   EXPECT_FALSE(blobCache->contains(hash));
 }
 
+TEST(FileInode, readsRangesOfLargeBlobs) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"bigfile.txt", "1234567890ab"}});
+  TestMount mount;
+  mount.getEdenConfig()->blobRangeReadMinimumSize.setValue(
+      8, ConfigSource::CommandLine);
+  mount.initialize(builder);
+  mount.getBackingStore()->setSupportsBlobRanges(true);
+  auto blobCache = mount.getBlobCache();
+
+  auto inode = mount.getFileInode("bigfile.txt");
+  auto hash = inode->getBlobHash().value();
+  auto context = ObjectFetchContext::getNullContext();
+  // Ranged reads need the size of the file, which stat() caches.
+  inode->stat(context).get(0ms);
+  auto accessCount = mount.getBackingStore()->getAccessCount(hash);
+
+  auto [data, isEof] = inode->read(4, 4, context).get(0ms);
+  EXPECT_EQ("5678", data->moveToFbString());
+  EXPECT_FALSE(isEof);
+
+  std::tie(data, isEof) = inode->read(8, 8, context).get(0ms);
+  EXPECT_EQ("90ab", data->moveToFbString());
+  EXPECT_TRUE(isEof);
+
+  EXPECT_FALSE(blobCache->contains(hash));
+  EXPECT_EQ(accessCount, mount.getBackingStore()->getAccessCount(hash));
+  EXPECT_EQ(1, mount.getBackingStore()->getRangeAccessCount(hash));
+}
+
 TEST(FileInode, keepsCacheIfPartiallyReread) {
   FakeTreeBuilder builder;
   builder.setFiles({{"bigfile.txt", "1234567890ab"}});
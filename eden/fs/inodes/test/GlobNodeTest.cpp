@@ -7,6 +7,7 @@
 
 #include "eden/fs/inodes/GlobNode.h"
 
+#include <algorithm>
 #include <utility>
 
 #include <folly/Conv.h>
@@ -436,6 +437,101 @@ TEST(GlobNodeTest, treeLoadError) {
   }
 }
 
+TEST(GlobNodeTest, fanOutEvaluatesDirectoriesOnTheServerThreadPool) {
+  auto mount = TestMount{};
+  auto builder = FakeTreeBuilder{};
+  builder.setFiles({
+      {"top.txt", "top"},
+      {"a/x.txt", "x"},
+      {"a/b/y.txt", "y"},
+      {"c/z.txt", "z"},
+      {"c/d/e/w.txt", "w"},
+  });
+  mount.initialize(builder, /*startReady=*/true);
+
+  GlobNode globRoot(
+      /*includeDotfiles=*/false, mount.getConfig()->getCaseSensitive());
+  globRoot.parse("**/*.txt");
+  GlobNode::FanOut fanOut{mount.getEdenMount()->getServerThreadPool().get(), 2};
+  GlobNode::ResultList globResults;
+
+  auto future = globRoot.evaluate(
+      mount.getEdenMount()->getObjectStore(),
+      ObjectFetchContext::getNullContext(),
+      RelativePathPiece(),
+      mount.getTreeInode(RelativePathPiece()),
+      /*fileBlobsToPrefetch=*/nullptr,
+      globResults,
+      kZeroRootId,
+      &fanOut);
+  EXPECT_FALSE(future.isReady())
+      << "the subdirectories should be queued on the server thread pool";
+
+  mount.drainServerExecutor();
+  ASSERT_TRUE(future.isReady());
+  std::move(future).get();
+
+  auto matches = std::move(*globResults.wlock());
+  std::sort(matches.begin(), matches.end());
+  EXPECT_EQ(
+      (std::vector<GlobResult>{
+          GlobResult("a/b/y.txt"_relpath, dtype_t::Regular, kZeroRootId),
+          GlobResult("a/x.txt"_relpath, dtype_t::Regular, kZeroRootId),
+          GlobResult("c/d/e/w.txt"_relpath, dtype_t::Regular, kZeroRootId),
+          GlobResult("c/z.txt"_relpath, dtype_t::Regular, kZeroRootId),
+          GlobResult("top.txt"_relpath, dtype_t::Regular, kZeroRootId),
+      }),
+      matches);
+}
+
+TEST(GlobNodeTest, sinkReceivesTheMatchesOfEachDirectory) {
+  auto mount = TestMount{};
+  auto builder = FakeTreeBuilder{};
+  builder.setFiles({
+      {"top.txt", "top"},
+      {"a/x.txt", "x"},
+      {"a/y.txt", "y"},
+      {"b/z.txt", "z"},
+  });
+  mount.initialize(builder, /*startReady=*/true);
+
+  struct RecordingSink : GlobNode::ResultSink {
+    void addResults(std::vector<GlobResult>&& results) override {
+      batches.push_back(std::move(results));
+    }
+    std::vector<std::vector<GlobResult>> batches;
+  };
+
+  GlobNode globRoot(
+      /*includeDotfiles=*/false, mount.getConfig()->getCaseSensitive());
+  globRoot.parse("**/*.txt");
+  GlobNode::ResultList globResults;
+  RecordingSink sink;
+  globRoot
+      .evaluate(
+          mount.getEdenMount()->getObjectStore(),
+          ObjectFetchContext::getNullContext(),
+          RelativePathPiece(),
+          mount.getTreeInode(RelativePathPiece()),
+          /*fileBlobsToPrefetch=*/nullptr,
+          globResults,
+          kZeroRootId,
+          /*fanOut=*/nullptr,
+          &sink)
+      .get(kSmallTimeout);
+
+  EXPECT_TRUE(globResults.rlock()->empty());
+  // One batch per directory with matches.
+  EXPECT_EQ(
+      (std::vector<std::vector<GlobResult>>{
+          {GlobResult("top.txt"_relpath, dtype_t::Regular, kZeroRootId)},
+          {GlobResult("a/x.txt"_relpath, dtype_t::Regular, kZeroRootId),
+           GlobResult("a/y.txt"_relpath, dtype_t::Regular, kZeroRootId)},
+          {GlobResult("b/z.txt"_relpath, dtype_t::Regular, kZeroRootId)},
+      }),
+      sink.batches);
+}
+
 TEST_P(GlobNodeTest, testCommitHashSet) {
   const RootId randomHash{"37ce5515c1b313ce722366c31c10db0883fff7e0"};
 
@@ -10,6 +10,8 @@
 #include <folly/String.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#include <atomic>
+#include <thread>
 
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
@@ -452,6 +454,63 @@ TEST(InodeMap, lookingUpAnUnloadedInodeAddsLoadsToTraceBus) {
   EXPECT_FALSE(queue.try_dequeue_for(loadTimeoutLimit).has_value());
 }
 
+TEST(InodeMap, loadEndEventsBreakDownTheLoadDuration) {
+  folly::UnboundedQueue<InodeTraceEvent, true, true, false> queue;
+  auto builder = FakeTreeBuilder();
+  builder.setFile("a/file.txt", "this is a test file");
+  TestMount testMount{builder, false};
+  const auto& edenMount = testMount.getEdenMount();
+  auto& trace_bus = edenMount->getInodeTraceBus();
+
+  auto handle = trace_bus.subscribeFunction(
+      fmt::format("inodeMapTest-{}", edenMount->getPath().basename()),
+      [&](const InodeTraceEvent& event) {
+        if (event.eventType == InodeEventType::LOAD &&
+            event.progress == InodeEventProgress::END) {
+          queue.enqueue(event);
+        }
+      });
+
+  auto fileFuture = edenMount
+                        ->getInodeSlow(
+                            "a/file.txt"_relpath,
+                            ObjectFetchContext::getNullContext())
+                        .semi()
+                        .via(testMount.getServerExecutor().get());
+  testMount.drainServerExecutor();
+  // Make the tree fetch of "a" take measurably long.
+  std::this_thread::sleep_for(20ms);
+  builder.setReady("a");
+  builder.setReady("a/file.txt");
+  testMount.drainServerExecutor();
+  auto fileNumber = std::move(fileFuture).get(0ms)->getNodeId();
+  auto treeNumber = testMount.getTreeInode("a"_relpath)->getNodeId();
+
+  std::optional<InodeTraceEvent> treeEvent;
+  std::optional<InodeTraceEvent> fileEvent;
+  while (!treeEvent || !fileEvent) {
+    auto event = queue.try_dequeue_for(loadTimeoutLimit);
+    ASSERT_TRUE(event.has_value());
+    if (event->ino == treeNumber) {
+      treeEvent = std::move(*event);
+    } else if (event->ino == fileNumber) {
+      fileEvent = std::move(*event);
+    }
+  }
+
+  const auto& treePhases = treeEvent->loadPhases;
+  EXPECT_GE(treePhases.treeFetch, 20000u);
+  EXPECT_LT(treePhases.overlayRead, treePhases.treeFetch);
+  EXPECT_LT(treePhases.metadataLookup, treePhases.treeFetch);
+  EXPECT_GE(treeEvent->duration.count(), treePhases.treeFetch);
+
+  // Files are set up without fetching anything.
+  const auto& filePhases = fileEvent->loadPhases;
+  EXPECT_EQ(0u, filePhases.treeFetch);
+  EXPECT_EQ(0u, filePhases.overlayRead);
+  EXPECT_GE(fileEvent->duration.count(), filePhases.metadataLookup);
+}
+
 TEST(InodeMap, unloadedUnlinkedTreesAreRemovedFromOverlay) {
   FakeTreeBuilder builder;
   builder.setFile("dir1/file.txt", "contents");
@@ -560,6 +619,43 @@ TEST(InodeMap, unloadedFileMetadataIsForgotten) {
 }
 #endif
 
+TEST(InodeMap, concurrentLookupsOfLoadedInodes) {
+  // Enough files for every shard of the InodeMap to have some.
+  constexpr size_t kFileCount = 64;
+  FakeTreeBuilder builder;
+  for (size_t i = 0; i < kFileCount; ++i) {
+    builder.setFile(fmt::format("dir/file{}.txt", i), "contents");
+  }
+  TestMount testMount{builder};
+  auto* inodeMap = testMount.getEdenMount()->getInodeMap();
+
+  std::vector<FileInodePtr> files;
+  for (size_t i = 0; i < kFileCount; ++i) {
+    files.push_back(testMount.getFileInode(fmt::format("dir/file{}.txt", i)));
+  }
+  auto counts = inodeMap->getInodeCounts();
+  EXPECT_GE(counts.fileCount, kFileCount);
+
+  std::vector<std::thread> threads;
+  std::atomic<size_t> mismatches{0};
+  for (size_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&] {
+      for (size_t round = 0; round < 100; ++round) {
+        for (const auto& file : files) {
+          if (inodeMap->lookupLoadedFile(file->getNodeId()) != file) {
+            ++mismatches;
+          }
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(0, mismatches.load());
+  EXPECT_EQ(counts.fileCount, inodeMap->getInodeCounts().fileCount);
+}
+
 struct InodePersistenceTreeTest : ::testing::Test {
   InodePersistenceTreeTest() {
     builder.setFile("dir/file1.txt", "contents1");
@@ -164,6 +164,40 @@ TEST_F(InodeTableTest, setDefault) {
   EXPECT_EQ(14, inodeTable->setDefault(1_ino, 16));
 }
 
+TEST_F(InodeTableTest, compactShrinksTheFileAfterFrees) {
+  auto inodeTable = InodeTable<Int>::open(tablePath);
+  constexpr uint64_t kCount = 200000;
+  for (uint64_t i = 1; i <= kCount; ++i) {
+    inodeTable->set(InodeNumber{i}, static_cast<int>(i));
+  }
+  auto grown = inodeTable->getStats();
+  EXPECT_EQ(kCount, grown.entryCount);
+  EXPECT_EQ(0, inodeTable->compact(0.5));
+
+  for (uint64_t i = 11; i <= kCount; ++i) {
+    inodeTable->freeInode(InodeNumber{i});
+  }
+  EXPECT_EQ(grown.fileSizeInBytes, inodeTable->getStats().fileSizeInBytes);
+
+  auto released = inodeTable->compact(0.5);
+  auto compacted = inodeTable->getStats();
+  EXPECT_GT(released, 0);
+  EXPECT_EQ(grown.fileSizeInBytes - released, compacted.fileSizeInBytes);
+  EXPECT_EQ(10, compacted.entryCount);
+  EXPECT_GE(compacted.capacity, compacted.entryCount);
+  EXPECT_EQ(0, inodeTable->compact(0.5));
+
+  for (uint64_t i = 1; i <= 10; ++i) {
+    EXPECT_EQ(static_cast<int>(i), inodeTable->getOrThrow(InodeNumber{i}));
+  }
+  // The table grows again as needed.
+  for (uint64_t i = 11; i <= kCount; ++i) {
+    inodeTable->set(InodeNumber{i}, static_cast<int>(i));
+  }
+  EXPECT_EQ(
+      static_cast<int>(kCount), inodeTable->getOrThrow(InodeNumber{kCount}));
+}
+
 // TEST(INodeTable, set) {}
 // TEST(INodeTable, getOrThrow) {}
 // TEST(INodeTable, getOptional) {}
@@ -0,0 +1,318 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+#include <folly/Utility.h>
+#include <folly/executors/ManualExecutor.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/portability/GFlags.h>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/inodes/EdenMount.h"
+#include "eden/fs/inodes/FileInode.h"
+#include "eden/fs/inodes/NfsDispatcherImpl.h"
+#include "eden/fs/inodes/ServerState.h"
+#include "eden/fs/inodes/TreeInode.h"
+#include "eden/fs/nfs/NfsServer.h"
+#include "eden/fs/nfs/NfsdRpc.h"
+#include "eden/fs/nfs/rpc/StreamClient.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/TestMount.h"
+
+/**
+ * Measures the NFS server the way the kernel uses it: each benchmark thread
+ * opens its own connection to an Nfsd3 serving a TestMount and issues raw
+ * NFSv3 calls, one at a time. The number of threads is therefore the number
+ * of concurrent requests.
+ *
+ * Besides the throughput, reported as items_per_second, every benchmark
+ * reports the p50, p90 and p99 latencies of its calls in microseconds, the
+ * average over the threads of each thread's percentile. Use
+ * --benchmark_format=json or --benchmark_out to compare runs.
+ */
+
+DEFINE_uint64(numDirEntries, 1000, "Number of files in the listed directory");
+DEFINE_uint64(fileSize, 16 * 1024 * 1024, "Size of the read and written file");
+DEFINE_uint32(ioSize, 64 * 1024, "Bytes read or written by each call");
+DEFINE_uint32(
+    readdirMaxCount,
+    32 * 1024,
+    "Maximum reply size requested by each READDIRPLUS call");
+DEFINE_uint64(numServicingThreads, 8, "Threads servicing the NFS requests");
+
+namespace facebook::eden {
+namespace {
+
+class NfsBenchServer {
+ public:
+  NfsBenchServer() {
+    FakeTreeBuilder builder;
+    builder.setFile("file", std::string(FLAGS_fileSize, 'a'));
+    for (uint64_t i = 0; i < FLAGS_numDirEntries; i++) {
+      builder.setFile(fmt::format("dir/file{}", i), "contents\n");
+    }
+    mount_.emplace(builder);
+
+    // Nothing waits for the work the mount queues on its server executor.
+    drainer_ = std::thread{[executor = mount_->getServerExecutor()] {
+      while (true) {
+        executor->wait();
+        executor->run();
+      }
+    }};
+
+    auto& edenMount = mount_->getEdenMount();
+    rootIno_ = edenMount->getRootInode()->getNodeId();
+    fileIno_ = mount_->getFileInode("file")->getNodeId();
+    dirIno_ = mount_->getTreeInode("dir")->getNodeId();
+
+    const auto& serverState = edenMount->getServerState();
+    auto config = serverState->getEdenConfig();
+    nfsServer_.emplace(
+        evbThread_.getEventBase(),
+        FLAGS_numServicingThreads,
+        /*maxInflightRequests=*/1000,
+        /*numIoThreads=*/0,
+        /*maxInflightRequestsPerConnection=*/0,
+        serverState->getStructuredLogger());
+    evbThread_.getEventBase()->runInEventBaseThreadAndWait([&] {
+      nfsServer_->initialize(folly::SocketAddress{"127.0.0.1", 0}, false);
+      auto mountInfo = nfsServer_->registerMount(
+          edenMount->getPath(),
+          rootIno_,
+          std::make_unique<NfsDispatcherImpl>(edenMount.get()),
+          &edenMount->getStraceLogger(),
+          serverState->getProcessNameCache(),
+          serverState->getFsEventLogger(),
+          serverState->getStructuredLogger(),
+          std::chrono::duration_cast<folly::Duration>(
+              config->nfsRequestTimeout.getValue()),
+          serverState->getNotifier(),
+          edenMount->getCheckoutConfig()->getCaseSensitive(),
+          FLAGS_ioSize,
+          /*numConnections=*/1,
+          config->nfsTraceBusCapacity.getValue());
+      nfsd_ = std::move(mountInfo.nfsd);
+      nfsd_->initialize(folly::SocketAddress{"127.0.0.1", 0}, false);
+    });
+  }
+
+  StreamClient connect() const {
+    StreamClient client{nfsd_->getAddr()};
+    client.connect();
+    return client;
+  }
+
+  nfs_fh3 root() const {
+    return nfs_fh3{rootIno_};
+  }
+
+  nfs_fh3 file() const {
+    return nfs_fh3{fileIno_};
+  }
+
+  nfs_fh3 dir() const {
+    return nfs_fh3{dirIno_};
+  }
+
+ private:
+  std::optional<TestMount> mount_;
+  std::thread drainer_;
+  folly::ScopedEventBaseThread evbThread_;
+  std::optional<NfsServer> nfsServer_;
+  std::unique_ptr<Nfsd3> nfsd_;
+  InodeNumber rootIno_;
+  InodeNumber fileIno_;
+  InodeNumber dirIno_;
+};
+
+const NfsBenchServer& getServer() {
+  // Shared by all the benchmarks, and leaked rather than torn down at exit
+  // along with the connections and the thread draining its executor.
+  static auto* server = new NfsBenchServer();
+  return *server;
+}
+
+/**
+ * The latencies of the calls of one benchmark thread.
+ */
+class Latencies {
+ public:
+  template <typename Fn>
+  void time(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    samples_.push_back(std::chrono::steady_clock::now() - start);
+  }
+
+  void report(benchmark::State& state) {
+    state.SetItemsProcessed(state.iterations());
+    if (samples_.empty()) {
+      return;
+    }
+    std::sort(samples_.begin(), samples_.end());
+    auto percentile = [&](double p) {
+      auto index = static_cast<size_t>(p * (samples_.size() - 1));
+      return std::chrono::duration<double, std::micro>{samples_[index]}
+          .count();
+    };
+    state.counters["p50_us"] =
+        benchmark::Counter{percentile(0.5), benchmark::Counter::kAvgThreads};
+    state.counters["p90_us"] =
+        benchmark::Counter{percentile(0.9), benchmark::Counter::kAvgThreads};
+    state.counters["p99_us"] =
+        benchmark::Counter{percentile(0.99), benchmark::Counter::kAvgThreads};
+  }
+
+ private:
+  std::vector<std::chrono::steady_clock::duration> samples_;
+};
+
+template <typename Res>
+void checkOk(const Res& res) {
+  if (res.tag != nfsstat3::NFS3_OK) {
+    throw std::runtime_error(
+        fmt::format("NFS call failed: {}", folly::to_underlying(res.tag)));
+  }
+}
+
+template <typename Res, typename Args>
+Res call(StreamClient& client, nfsv3Procs proc, const Args& args) {
+  auto res = client.call<Res>(
+      kNfsdProgNumber, kNfsd3ProgVersion, folly::to_underlying(proc), args);
+  checkOk(res);
+  return res;
+}
+
+void nfs_getattr(benchmark::State& state) {
+  const auto& server = getServer();
+  auto client = server.connect();
+  Latencies latencies;
+  for (auto _ : state) {
+    latencies.time([&] {
+      call<GETATTR3res>(
+          client, nfsv3Procs::getattr, GETATTR3args{server.file()});
+    });
+  }
+  latencies.report(state);
+}
+
+void nfs_lookup(benchmark::State& state) {
+  const auto& server = getServer();
+  auto client = server.connect();
+  Latencies latencies;
+  for (auto _ : state) {
+    latencies.time([&] {
+      call<LOOKUP3res>(
+          client,
+          nfsv3Procs::lookup,
+          LOOKUP3args{diropargs3{server.root(), "file"}});
+    });
+  }
+  latencies.report(state);
+}
+
+void nfs_read(benchmark::State& state) {
+  const auto& server = getServer();
+  auto client = server.connect();
+  Latencies latencies;
+  // Each thread reads the whole file sequentially, starting at a different
+  // offset.
+  uint64_t offset = state.thread_index() * FLAGS_ioSize % FLAGS_fileSize;
+  for (auto _ : state) {
+    latencies.time([&] {
+      call<READ3res>(
+          client,
+          nfsv3Procs::read,
+          READ3args{server.file(), offset, FLAGS_ioSize});
+    });
+    offset = (offset + FLAGS_ioSize) % FLAGS_fileSize;
+  }
+  latencies.report(state);
+  state.SetBytesProcessed(state.iterations() * FLAGS_ioSize);
+}
+
+void nfs_write(benchmark::State& state) {
+  const auto& server = getServer();
+  auto client = server.connect();
+  auto data = folly::IOBuf::create(FLAGS_ioSize);
+  data->append(FLAGS_ioSize);
+  memset(data->writableData(), 'b', FLAGS_ioSize);
+  Latencies latencies;
+  uint64_t offset = state.thread_index() * FLAGS_ioSize % FLAGS_fileSize;
+  for (auto _ : state) {
+    // Sent like the writeback of the page cache, which is committed later.
+    latencies.time([&] {
+      call<WRITE3res>(
+          client,
+          nfsv3Procs::write,
+          WRITE3args{
+              server.file(),
+              offset,
+              FLAGS_ioSize,
+              stable_how::UNSTABLE,
+              data->clone()});
+    });
+    offset = (offset + FLAGS_ioSize) % FLAGS_fileSize;
+  }
+  latencies.report(state);
+  state.SetBytesProcessed(state.iterations() * FLAGS_ioSize);
+}
+
+void nfs_readdirplus(benchmark::State& state) {
+  const auto& server = getServer();
+  auto client = server.connect();
+  Latencies latencies;
+  // Each call lists the next page of the directory, starting over once the
+  // whole directory was listed.
+  uint64_t cookie = 0;
+  uint64_t cookieverf = 0;
+  for (auto _ : state) {
+    latencies.time([&] {
+      auto res = call<READDIRPLUS3res>(
+          client,
+          nfsv3Procs::readdirplus,
+          READDIRPLUS3args{
+              server.dir(),
+              cookie,
+              cookieverf,
+              FLAGS_readdirMaxCount,
+              FLAGS_readdirMaxCount});
+      auto& resok = std::get<READDIRPLUS3resok>(res.v);
+      auto& entries = resok.reply.entries.list;
+      if (resok.reply.eof || entries.empty()) {
+        cookie = 0;
+      } else {
+        cookie = entries.back().cookie;
+      }
+      cookieverf = resok.cookieverf;
+    });
+  }
+  latencies.report(state);
+}
+
+BENCHMARK(nfs_getattr)->UseRealTime()->Threads(1)->Threads(8)->Threads(64);
+BENCHMARK(nfs_lookup)->UseRealTime()->Threads(1)->Threads(8)->Threads(64);
+BENCHMARK(nfs_read)->UseRealTime()->Threads(1)->Threads(8)->Threads(64);
+BENCHMARK(nfs_write)->UseRealTime()->Threads(1)->Threads(8)->Threads(64);
+BENCHMARK(nfs_readdirplus)->UseRealTime()->Threads(1)->Threads(8)->Threads(64);
+
+} // namespace
+} // namespace facebook::eden
+
+EDEN_BENCHMARK_MAIN();
+
+#endif
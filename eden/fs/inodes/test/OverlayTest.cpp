@@ -46,6 +46,8 @@ namespace facebook::eden {
 constexpr Overlay::InodeCatalogType kInodeCatalogType =
     Overlay::InodeCatalogType::Legacy;
 
+constexpr auto kFutureTimeout = std::chrono::seconds{10};
+
 TEST(OverlayGoldMasterTest, can_load_overlay_v2) {
   // eden/test-data/overlay-v2.tgz contains a saved copy of an overlay
   // directory generated by edenfs.  Unpack it into a temporary directory,
@@ -256,6 +258,33 @@ TEST(PlainOverlayTest, new_overlay_is_clean) {
   EXPECT_TRUE(overlay->hadCleanStartup());
 }
 
+TEST(PlainOverlayTest, loads_dirs_on_io_threads) {
+  folly::test::TemporaryDirectory testDir;
+  auto config = EdenConfig::createTestEdenConfig();
+  config->overlayIoThreads.setValue(2, ConfigSource::CommandLine);
+  auto overlay = Overlay::create(
+      AbsolutePath{testDir.path().string()},
+      kPathMapDefaultCaseSensitive,
+      kInodeCatalogType,
+      std::make_shared<NullStructuredLogger>(),
+      *config);
+  overlay->initialize(config).get();
+
+  auto ino1 = overlay->allocateInodeNumber();
+  auto ino2 = overlay->allocateInodeNumber();
+  DirContents dir(kPathMapDefaultCaseSensitive);
+  dir.emplace("one"_pc, S_IFDIR | 0755, ino2);
+  overlay->saveOverlayDir(ino1, dir);
+
+  auto result = overlay->loadOverlayDirAsync(ino1).get(kFutureTimeout);
+  ASSERT_EQ(1, result.size());
+  EXPECT_EQ(ino2, result.find("one"_pc)->second.getInodeNumber());
+
+  auto missing = overlay->allocateInodeNumber();
+  auto empty = overlay->loadOverlayDirAsync(missing).get(kFutureTimeout);
+  EXPECT_TRUE(empty.empty());
+}
+
 TEST(PlainOverlayTest, reopened_overlay_is_clean) {
   folly::test::TemporaryDirectory testDir;
   {
@@ -516,6 +545,17 @@ TEST_P(RawOverlayTest, max_inode_number_is_1_if_overlay_is_empty) {
   EXPECT_EQ(2_ino, overlay->allocateInodeNumber());
 }
 
+TEST_P(RawOverlayTest, allocates_consecutive_ranges_of_inode_numbers) {
+  EXPECT_EQ(2_ino, overlay->allocateInodeNumbers(3));
+  EXPECT_EQ(5_ino, overlay->allocateInodeNumber());
+  EXPECT_EQ(6_ino, overlay->allocateInodeNumbers(1));
+
+  recreate(OverlayRestartMode::CLEAN);
+
+  EXPECT_EQ(6_ino, overlay->getMaxInodeNumber());
+  EXPECT_EQ(7_ino, overlay->allocateInodeNumbers(2));
+}
+
 TEST_P(RawOverlayTest, remembers_max_inode_number_of_tree_inodes) {
   auto ino2 = overlay->allocateInodeNumber();
   EXPECT_EQ(2_ino, ino2);
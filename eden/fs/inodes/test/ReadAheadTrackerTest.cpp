@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/ReadAheadTracker.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+namespace {
+constexpr pid_t kPid = 42;
+constexpr uint64_t kReadSize = 128 * 1024;
+constexpr uint64_t kFileSize = 1024 * 1024 * 1024;
+constexpr uint64_t kMaxWindow = 8 * 1024 * 1024;
+const InodeNumber kFile{10};
+const InodeNumber kDir{20};
+
+InodeNumber file(uint64_t n) {
+  return InodeNumber{100 + n};
+}
+} // namespace
+
+TEST(ReadAheadTrackerTest, randomReadsDontReadAhead) {
+  ReadAheadTracker tracker;
+  for (uint64_t offset : {0, 10, 3, 7, 1}) {
+    auto range = tracker.recordRead(
+        kPid, kFile, offset * kReadSize * 2, kReadSize, kFileSize, kMaxWindow);
+    EXPECT_EQ(0, range.length);
+  }
+}
+
+TEST(ReadAheadTrackerTest, sequentialReadsReadAheadWithGrowingWindow) {
+  ReadAheadTracker tracker;
+  EXPECT_EQ(
+      0,
+      tracker.recordRead(kPid, kFile, 0, kReadSize, kFileSize, kMaxWindow)
+          .length);
+
+  uint64_t readAheadEnd = 0;
+  uint64_t lastLength = 0;
+  size_t readAheads = 0;
+  for (uint64_t offset = kReadSize; offset < 64 * kReadSize;
+       offset += kReadSize) {
+    auto range = tracker.recordRead(
+        kPid, kFile, offset, kReadSize, kFileSize, kMaxWindow);
+    if (range.length == 0) {
+      continue;
+    }
+    ++readAheads;
+    // Contiguous with the previous read ahead, and ahead of the reads.
+    EXPECT_EQ(std::max(readAheadEnd, offset + kReadSize), range.offset);
+    EXPECT_LT(lastLength, range.length);
+    readAheadEnd = range.offset + range.length;
+    lastLength = range.length;
+    EXPECT_TRUE(readAheadEnd > offset + kReadSize);
+  }
+  EXPECT_TRUE(readAheads > 1);
+  EXPECT_TRUE(readAheads < 16);
+  EXPECT_TRUE(lastLength <= kMaxWindow);
+}
+
+TEST(ReadAheadTrackerTest, readAheadStopsAtTheEndOfTheFile) {
+  ReadAheadTracker tracker;
+  const uint64_t fileSize = 3 * kReadSize + 10;
+  tracker.recordRead(kPid, kFile, 0, kReadSize, fileSize, kMaxWindow);
+  auto range =
+      tracker.recordRead(kPid, kFile, kReadSize, kReadSize, fileSize, kMaxWindow);
+  EXPECT_EQ(2 * kReadSize, range.offset);
+  EXPECT_EQ(kReadSize + 10, range.length);
+  EXPECT_EQ(
+      0,
+      tracker
+          .recordRead(kPid, kFile, 2 * kReadSize, kReadSize, fileSize, kMaxWindow)
+          .length);
+}
+
+TEST(ReadAheadTrackerTest, processesAreTrackedSeparately) {
+  ReadAheadTracker tracker;
+  tracker.recordRead(kPid, kFile, 0, kReadSize, kFileSize, kMaxWindow);
+  tracker.recordRead(kPid + 1, file(1), 0, kReadSize, kFileSize, kMaxWindow);
+  EXPECT_NE(
+      0,
+      tracker
+          .recordRead(kPid, kFile, kReadSize, kReadSize, kFileSize, kMaxWindow)
+          .length);
+  // Disabled.
+  EXPECT_EQ(
+      0,
+      tracker.recordRead(kPid + 1, file(1), kReadSize, kReadSize, kFileSize, 0)
+          .length);
+}
+
+TEST(ReadAheadTrackerTest, filesReadInOrderPrefetchTheNextOnes) {
+  ReadAheadTracker tracker;
+  auto first = tracker.recordFileStart(kPid, kDir, file(0), std::nullopt, 4);
+  EXPECT_EQ(0, first.count);
+
+  auto second = tracker.recordFileStart(kPid, kDir, file(1), file(0), 4);
+  EXPECT_EQ(0, second.first);
+  EXPECT_EQ(4, second.count);
+
+  // Reading the same file from the start again changes nothing.
+  EXPECT_EQ(0, tracker.recordFileStart(kPid, kDir, file(1), file(0), 4).count);
+
+  auto third = tracker.recordFileStart(kPid, kDir, file(2), file(1), 4);
+  EXPECT_EQ(3, third.first);
+  EXPECT_EQ(1, third.count);
+
+  // Skipping a file breaks the run.
+  EXPECT_EQ(0, tracker.recordFileStart(kPid, kDir, file(4), file(3), 4).count);
+  EXPECT_EQ(4, tracker.recordFileStart(kPid, kDir, file(5), file(4), 4).count);
+
+  // As does another directory.
+  EXPECT_EQ(
+      0,
+      tracker.recordFileStart(kPid, InodeNumber{21}, file(6), file(5), 4)
+          .count);
+}
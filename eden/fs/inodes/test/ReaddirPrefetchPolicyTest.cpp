@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/ReaddirPrefetchPolicy.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+using LookupResult = ReaddirPrefetchPolicy::LookupResult;
+
+namespace {
+constexpr pid_t kPid = 42;
+
+InodeNumber dir(uint64_t n) {
+  return InodeNumber{100 + n};
+}
+
+/** A listing as TreeInode::prefetch() does it, optionally followed by ls -l. */
+bool list(ReaddirPrefetchPolicy& policy, uint64_t n, bool lookup) {
+  auto prefetch = policy.recordListing(kPid, dir(n), true);
+  if (prefetch) {
+    policy.recordPrefetch(kPid, dir(n));
+  }
+  if (lookup) {
+    policy.recordLookup(kPid, dir(n));
+  }
+  return prefetch;
+}
+} // namespace
+
+TEST(ReaddirPrefetchPolicyTest, newProcessesArePrefetchedFor) {
+  ReaddirPrefetchPolicy policy;
+  for (uint64_t n = 0; n < ReaddirPrefetchPolicy::kMinListings; ++n) {
+    EXPECT_TRUE(list(policy, n, false));
+  }
+}
+
+TEST(ReaddirPrefetchPolicyTest, listingsWithoutLookupsStopPrefetching) {
+  ReaddirPrefetchPolicy policy;
+  for (uint64_t n = 0; n < ReaddirPrefetchPolicy::kMinListings; ++n) {
+    list(policy, n, false);
+  }
+  EXPECT_FALSE(list(policy, 100, false));
+  // Other processes aren't affected.
+  EXPECT_TRUE(policy.recordListing(kPid + 1, dir(100), true));
+  // Nor is the listing decision when not adaptive.
+  EXPECT_TRUE(policy.recordListing(kPid, dir(101), false));
+}
+
+TEST(ReaddirPrefetchPolicyTest, listingsWithLookupsKeepPrefetching) {
+  ReaddirPrefetchPolicy policy;
+  for (uint64_t n = 0; n < 100; ++n) {
+    EXPECT_TRUE(list(policy, n, true));
+  }
+}
+
+TEST(ReaddirPrefetchPolicyTest, relistedDirectoryUsesItsOwnOutcome) {
+  ReaddirPrefetchPolicy policy;
+  for (uint64_t n = 0; n < ReaddirPrefetchPolicy::kMinListings; ++n) {
+    list(policy, n, false);
+  }
+  EXPECT_FALSE(policy.recordListing(kPid, dir(100), true));
+  // The process stats the entries it listed even though they weren't
+  // prefetched, so the next listing of that directory prefetches.
+  EXPECT_EQ(LookupResult::Miss, policy.recordLookup(kPid, dir(100)));
+  EXPECT_TRUE(policy.recordListing(kPid, dir(100), true));
+}
+
+TEST(ReaddirPrefetchPolicyTest, onlyTheFirstLookupOfAListingCounts) {
+  ReaddirPrefetchPolicy policy;
+  EXPECT_EQ(LookupResult::Untracked, policy.recordLookup(kPid, dir(0)));
+  EXPECT_TRUE(policy.recordListing(kPid, dir(0), true));
+  policy.recordPrefetch(kPid, dir(0));
+  EXPECT_EQ(LookupResult::Hit, policy.recordLookup(kPid, dir(0)));
+  EXPECT_EQ(LookupResult::Untracked, policy.recordLookup(kPid, dir(0)));
+  EXPECT_EQ(LookupResult::Untracked, policy.recordLookup(kPid, dir(1)));
+  EXPECT_EQ(LookupResult::Untracked, policy.recordLookup(std::nullopt, dir(0)));
+}
+
+TEST(ReaddirPrefetchPolicyTest, oldListingsAreForgotten) {
+  ReaddirPrefetchPolicy policy;
+  for (uint64_t n = 0; n < ReaddirPrefetchPolicy::kListingsPerProcess; ++n) {
+    list(policy, n, false);
+  }
+  // Enough listings with lookups push the ones without out.
+  for (uint64_t n = 0; n < ReaddirPrefetchPolicy::kListingsPerProcess; ++n) {
+    policy.recordListing(kPid, dir(1000 + n), true);
+    policy.recordLookup(kPid, dir(1000 + n));
+  }
+  EXPECT_EQ(LookupResult::Untracked, policy.recordLookup(kPid, dir(0)));
+  EXPECT_TRUE(list(policy, 5000, false));
+}
+
+TEST(ReaddirPrefetchPolicyTest, maxPrefetchesScaleWithLatency) {
+  ReaddirPrefetchPolicy policy;
+  EXPECT_EQ(5, policy.getMaxPrefetches(5, 32, 10ms));
+
+  policy.recordPrefetchDuration(5ms);
+  EXPECT_EQ(5ms, policy.getAveragePrefetchDuration());
+  EXPECT_EQ(5, policy.getMaxPrefetches(5, 32, 10ms));
+
+  for (int i = 0; i < 100; ++i) {
+    policy.recordPrefetchDuration(41ms);
+  }
+  EXPECT_EQ(20, policy.getMaxPrefetches(5, 32, 10ms));
+  EXPECT_EQ(16, policy.getMaxPrefetches(5, 16, 10ms));
+  // 0 still disables prefetches.
+  EXPECT_EQ(0, policy.getMaxPrefetches(0, 32, 10ms));
+  EXPECT_EQ(5, policy.getMaxPrefetches(5, 32, 0ms));
+}
@@ -8,6 +8,7 @@
 #include <folly/String.h>
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
+#include <thread>
 
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/FileInode.h"
@@ -536,6 +537,67 @@ TEST_F(RenameTest, renameUpdatesMtime) {
 }
 #endif
 
+TEST_F(RenameTest, concurrentRenames) {
+  // Back and forth renames in crossing directions, between related and
+  // unrelated directories, next to renames of a directory to another parent.
+  struct Move {
+    RelativePath path;
+    TreeInodePtr from;
+    TreeInodePtr to;
+  };
+  auto makeMove = [&](StringPiece path, StringPiece to) {
+    RelativePath relPath{path};
+    // Load the inode, so that the renames complete immediately.
+    mount_->getInode(relPath);
+    return Move{
+        relPath,
+        mount_->getTreeInode(relPath.dirname()),
+        mount_->getTreeInode(to)};
+  };
+  std::vector<Move> moves{
+      makeMove("a/b/c/doc.txt", "a/x/y/z"),
+      makeMove("a/x/y/z/readme.txt", "a/b/c"),
+      makeMove("a/b/readme.txt", "a/b/c/d"),
+      makeMove("a/b/c/d/e/f/readme.txt", "a/b/c/d/e/f"),
+      makeMove("a/b/c/1/2", "a/x"),
+  };
+
+  auto rename = [](const TreeInodePtr& from,
+                   PathComponentPiece fromName,
+                   const TreeInodePtr& to,
+                   PathComponentPiece toName) {
+    from->rename(
+            fromName,
+            to,
+            toName,
+            InvalidationRequired::No,
+            ObjectFetchContext::getNullContext())
+        .get(10s);
+  };
+
+  std::vector<std::thread> threads;
+  for (const auto& move : moves) {
+    threads.emplace_back([&] {
+      auto name = move.path.basename();
+      auto movedName = "moved"_pc;
+      for (int i = 0; i < 500; ++i) {
+        rename(move.from, name, move.to, movedName);
+        rename(move.to, movedName, move.from, name);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  for (const auto& move : moves) {
+    EXPECT_EQ(move.path, mount_->getInode(move.path)->getPath().value());
+  }
+  EXPECT_THROW_ERRNO(mount_->getInode("a/x/moved"), ENOENT);
+  EXPECT_THROW_ERRNO(mount_->getInode("a/x/y/z/moved"), ENOENT);
+  EXPECT_THROW_ERRNO(mount_->getInode("a/b/c/moved"), ENOENT);
+}
+
 /*
  * Rename tests where the source and destination inode objects
  * are not loaded yet when the rename starts.
@@ -7,6 +7,7 @@
 
 #include "eden/fs/inodes/TreeInode.h"
 
+#include <fmt/format.h>
 #include <folly/Exception.h>
 #include <folly/Random.h>
 #include <folly/executors/ManualExecutor.h>
@@ -15,6 +16,8 @@
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
 #include <optional>
+#include <set>
+#include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/fuse/DirList.h"
 #include "eden/fs/inodes/FileInode.h"
 #include "eden/fs/model/Tree.h"
@@ -23,6 +26,7 @@
 #include "eden/fs/prjfs/Enumerator.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/testharness/FakeTreeBuilder.h"
+#include "eden/fs/testharness/LoggingFetchContext.h"
 #include "eden/fs/testharness/TestChecks.h"
 #include "eden/fs/testharness/TestMount.h"
 #include "eden/fs/testharness/TestUtil.h"
@@ -199,6 +203,50 @@ TEST(TreeInode, fuseReaddirRespectsOffset) {
   EXPECT_EQ(0, resultE.size());
 }
 
+#ifdef __linux__
+TEST(TreeInode, fuseReaddirPlusListsEntriesWithoutAttributes) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"file", ""}});
+  TestMount mount{builder};
+
+  auto root = mount.getEdenMount()->getRootInode();
+  auto list = root->fuseReaddirPlus(
+      FuseDirPlusList{4096}, 0, ObjectFetchContext::getNullContext());
+  ASSERT_EQ(4, list.size());
+
+  fuse_entry_out entryOut = {};
+  entryOut.nodeid = 42;
+  list.setEntryOut(2, entryOut);
+
+  auto result = list.extract();
+  ASSERT_EQ(4, result.size());
+  EXPECT_EQ(".", result[0].name);
+  EXPECT_EQ("..", result[1].name);
+  EXPECT_EQ("file", result[2].name);
+  EXPECT_EQ(".eden", result[3].name);
+  EXPECT_EQ(0, result[0].entryOut.nodeid);
+  EXPECT_EQ(42, result[2].entryOut.nodeid);
+  EXPECT_EQ(0, result[3].entryOut.nodeid);
+}
+
+TEST(TreeInode, fuseReaddirPlusStopsWhenFull) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"file", ""}});
+  TestMount mount{builder};
+
+  // Room for "." and ".." only.
+  auto root = mount.getEdenMount()->getRootInode();
+  auto result = root->fuseReaddirPlus(
+                        FuseDirPlusList{2 * sizeof(fuse_direntplus) + 16},
+                        0,
+                        ObjectFetchContext::getNullContext())
+                    .extract();
+  ASSERT_EQ(2, result.size());
+  EXPECT_EQ(".", result[0].name);
+  EXPECT_EQ("..", result[1].name);
+}
+#endif
+
 TEST(TreeInode, fuseReaddirIgnoresWildOffsets) {
   TestMount mount{FakeTreeBuilder{}};
 
@@ -212,6 +260,51 @@ TEST(TreeInode, fuseReaddirIgnoresWildOffsets) {
   EXPECT_EQ(0, result.size());
 }
 
+TEST(TreeInode, readdirIndexSkipsEntriesModifiedDuringTheListing) {
+  FakeTreeBuilder builder;
+  builder.setFiles({{"a", ""}, {"b", ""}, {"c", ""}, {"d", ""}});
+  TestMount mount{builder};
+  mount.getEdenConfig()->readdirIndexMinEntries.setValue(
+      1, ConfigSource::CommandLine);
+
+  auto root = mount.getEdenMount()->getRootInode();
+  // Room for ".", ".." and one more entry.
+  auto page = root->fuseReaddir(
+                      FuseDirList{3 * FUSE_DIRENT_ALIGN(FUSE_NAME_OFFSET + 2)},
+                      0,
+                      ObjectFetchContext::getNullContext())
+                  .extract();
+  ASSERT_EQ(3, page.size());
+
+  std::set<std::string> remaining{"a", "b", "c", "d", ".eden"};
+  remaining.erase(page[2].name);
+  auto removed = page[2].name == "a" ? "b" : "a";
+  remaining.erase(removed);
+  mount.deleteFile(removed);
+  mount.addFile("e", "");
+
+  std::multiset<std::string> listed;
+  auto offset = page[2].offset;
+  while (true) {
+    page = root->fuseReaddir(
+                   FuseDirList{FUSE_DIRENT_ALIGN(FUSE_NAME_OFFSET + 6)},
+                   offset,
+                   ObjectFetchContext::getNullContext())
+               .extract();
+    if (page.empty()) {
+      break;
+    }
+    ASSERT_EQ(1, page.size());
+    listed.insert(page[0].name);
+    offset = page[0].offset;
+  }
+
+  // The removed entry isn't listed, and neither is the entry added after the
+  // listing started, even though its inode number is the largest.
+  EXPECT_EQ(
+      std::multiset<std::string>(remaining.begin(), remaining.end()), listed);
+}
+
 TEST(TreeInode, nfsReaddirEofIsCorrect) {
   FakeTreeBuilder builder;
   builder.setFiles({{"foo", ""}, {"bar", ""}, {"baz", ""}});
@@ -382,6 +475,29 @@ TEST(TreeInode, fuzzConcurrentModificationAndReaddir) {
 }
 #endif
 
+TEST(TreeInode, directoryLoadsAreReportedToTheFetchContext) {
+  FakeTreeBuilder builder;
+  builder.setFile("somedir/foo.txt", "test\n");
+  TestMount mount{builder};
+  auto context = makeRefPtr<LoggingFetchContext>();
+  auto root = mount.getEdenMount()->getRootInode();
+
+  root->getOrLoadChild("somedir"_pc, context.as<ObjectFetchContext>())
+      .get(0ms);
+  EXPECT_EQ(1, context->inodeLoads);
+
+  // Files are constructed inline and aren't reported.
+  auto somedir = mount.getTreeInode("somedir"_relpath);
+  somedir->getOrLoadChild("foo.txt"_pc, context.as<ObjectFetchContext>())
+      .get(0ms);
+  EXPECT_EQ(1, context->inodeLoads);
+
+  // Nor are the children that were already loaded.
+  root->getOrLoadChild("somedir"_pc, context.as<ObjectFetchContext>())
+      .get(0ms);
+  EXPECT_EQ(1, context->inodeLoads);
+}
+
 TEST(TreeInode, create) {
   FakeTreeBuilder builder;
   builder.setFile("somedir/foo.txt", "test\n");
@@ -455,6 +571,50 @@ TEST(TreeInode, removeRecursively) {
   EXPECT_THROW_ERRNO(mount.getTreeInode("somedir"_relpath), ENOENT);
 }
 
+#ifndef _WIN32
+TEST(TreeInode, removeRecursivelyLoadedSubtrees) {
+  FakeTreeBuilder builder;
+  builder.setFile("somedir/foo.txt", "foo\n");
+  TestMount mount{builder};
+  mount.getEdenConfig()->removeRecursivelyParallelism.setValue(
+      4, ConfigSource::CommandLine);
+
+  // Materialized and loaded subtrees, which are removed in parallel.
+  std::vector<InodeNumber> removed;
+  auto somedir = mount.getTreeInode("somedir"_relpath);
+  for (int i = 0; i < 8; ++i) {
+    auto sub = somedir->mkdir(
+        PathComponent{fmt::format("sub{}", i)},
+        S_IFDIR | 0755,
+        InvalidationRequired::No);
+    removed.push_back(sub->getNodeId());
+    auto nested =
+        sub->mkdir("nested"_pc, S_IFDIR | 0755, InvalidationRequired::No);
+    removed.push_back(nested->getNodeId());
+    for (int j = 0; j < 4; ++j) {
+      nested->mknod(
+          PathComponent{fmt::format("file{}", j)},
+          S_IFREG | 0644,
+          0,
+          InvalidationRequired::No);
+    }
+  }
+
+  auto root = mount.getEdenMount()->getRootInode();
+  root->removeRecursively(
+          "somedir"_pc,
+          InvalidationRequired::No,
+          ObjectFetchContext::getNullContext())
+      .get(0ms);
+
+  EXPECT_THROW_ERRNO(mount.getTreeInode("somedir"_relpath), ENOENT);
+  auto* overlay = mount.getEdenMount()->getOverlay();
+  for (auto inodeNumber : removed) {
+    EXPECT_FALSE(overlay->hasOverlayDir(inodeNumber)) << inodeNumber;
+  }
+}
+#endif
+
 TEST(TreeInode, removeRecursivelyNotReady) {
   FakeTreeBuilder builder;
   builder.setFile("somedir/foo.txt", "foo\n");
@@ -641,6 +801,31 @@ TEST(TreeInode, getOrFindChildrenLoadInodes) {
   collectResults(mount, std::move(result));
 }
 
+TEST(TreeInode, getOrFindChildrenLoadInodesLoadsEveryChild) {
+  FakeTreeBuilder builder;
+  builder.setFile("somedir/bar.txt", "test\n");
+  builder.setFile("somedir/foo.txt", "test\n");
+  builder.setFile("somedir/subdir/baz.txt", "test\n");
+  TestMount mount{builder};
+  auto somedir = mount.getTreeInode("somedir"_relpath);
+  auto* inodeMap = mount.getEdenMount()->getInodeMap();
+
+  somedir->unloadChildrenNow();
+  auto before = inodeMap->getInodeCounts();
+  auto result =
+      somedir->getChildren(ObjectFetchContext::getNullContext(), true);
+  ASSERT_EQ(3, result.size());
+  for (auto& [name, child] : result) {
+    mount.drainServerExecutor();
+    auto inode = std::move(child).get(kFutureTimeout).asInodePtr();
+    EXPECT_EQ(name, inode->getNameRacy());
+  }
+
+  auto after = inodeMap->getInodeCounts();
+  EXPECT_EQ(before.fileCount + 2, after.fileCount);
+  EXPECT_EQ(before.treeCount + 1, after.treeCount);
+}
+
 TEST(TreeInode, getOrFindChildrenMaterializedLoadedChild) {
   FakeTreeBuilder builder;
   builder.setFile("somedir/foo.txt", "test\n");
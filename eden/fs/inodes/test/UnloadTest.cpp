@@ -10,6 +10,8 @@
 #include <folly/portability/GTest.h>
 #include <folly/test/TestUtils.h>
 
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/inodes/InodeMap.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/store/ObjectFetchContext.h"
@@ -157,4 +159,54 @@ TEST(UnloadUnreferencedByFuse, inodesReferencedByFuseAreNotUnloaded) {
   EXPECT_EQ(0, counts.unloadedInodeCount);
 }
 
+
+TEST(InodeUnloadPolicy, unloadsInodesNotRecentlyAccessedDownToTarget) {
+  FakeTreeBuilder builder;
+  builder.setFile("src/a.c", "a");
+  builder.setFile("src/b.c", "b");
+  TestMount testMount{builder};
+  auto edenMount = testMount.getEdenMount();
+  testMount.getInode("src/a.c"_relpath);
+  testMount.getInode("src/b.c"_relpath);
+
+  auto config = EdenConfig::createTestEdenConfig();
+  config->inodeUnloadTargetCount.setValue(3, ConfigSource::CommandLine);
+
+  // 2 files + 1 subdirectory + 1 root + 1 .eden + 4 .eden entries, all of
+  // them accessed too recently to be unloaded.
+  auto stats = edenMount->runInodeUnloadPolicy(*config);
+  EXPECT_EQ(9, stats.loadedBefore);
+  EXPECT_EQ(3, stats.target);
+  EXPECT_EQ(0, stats.unloaded);
+  EXPECT_EQ(9, stats.loadedAfter);
+
+  testMount.getClock().advance(48h);
+  stats = edenMount->runInodeUnloadPolicy(*config);
+  EXPECT_EQ(1, stats.steps);
+  EXPECT_EQ(8, stats.unloaded);
+  EXPECT_EQ(1, stats.loadedAfter);
+  EXPECT_FALSE(stats.rateLimited);
+
+  // Under the target, nothing to do.
+  stats = edenMount->runInodeUnloadPolicy(*config);
+  EXPECT_EQ(0, stats.steps);
+}
+
+TEST(InodeUnloadPolicy, memoryBudgetLimitsLoadedInodes) {
+  FakeTreeBuilder builder;
+  builder.setFile("src/a.c", "a");
+  TestMount testMount{builder};
+  auto edenMount = testMount.getEdenMount();
+  testMount.getInode("src/a.c"_relpath);
+
+  auto config = EdenConfig::createTestEdenConfig();
+  config->inodeUnloadMemoryBudget.setValue(1, ConfigSource::CommandLine);
+
+  testMount.getClock().advance(48h);
+  auto stats = edenMount->runInodeUnloadPolicy(*config);
+  EXPECT_EQ(0, stats.target);
+  EXPECT_EQ(7, stats.unloaded);
+  EXPECT_EQ(1, stats.loadedAfter);
+}
+
 #endif
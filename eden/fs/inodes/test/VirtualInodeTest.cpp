@@ -883,6 +883,55 @@ TEST(VirtualInodeTest, getEntryAttributesAttributeError) {
   EXPECT_FALSE(attributes.type.value().hasException());
 }
 
+TEST(VirtualInodeTest, getEntryAttributesWithFetchedBlobMetadata) {
+  FakeTreeBuilder builder;
+  builder.setFile("dir/file", "contents");
+  builder.setFile("dir/loaded", "loaded");
+  auto mount = TestMount{builder};
+  mount.getFileInode("dir/loaded");
+
+  EXPECT_EQ(std::nullopt, mount.getVirtualInode("dir").getUnloadedBlobId());
+  EXPECT_EQ(
+      std::nullopt, mount.getVirtualInode("dir/loaded").getUnloadedBlobId());
+
+  auto virtualInode = mount.getVirtualInode("dir/file");
+  auto blobId = virtualInode.getUnloadedBlobId();
+  ASSERT_TRUE(blobId.has_value());
+
+  auto* objectStore = mount.getEdenMount()->getObjectStore();
+  auto metadata = objectStore
+                      ->getBlobMetadataBatch(
+                          {*blobId}, ObjectFetchContext::getNullContext())
+                      .get()
+                      .at(0);
+  auto attributes = virtualInode
+                        .getEntryAttributes(
+                            ENTRY_ATTRIBUTE_SIZE | ENTRY_ATTRIBUTE_SHA1 |
+                                ENTRY_ATTRIBUTE_TYPE,
+                            RelativePathPiece{"dir/file"},
+                            std::move(metadata),
+                            ObjectFetchContext::getNullContext())
+                        .get();
+  EXPECT_EQ(8, attributes.size.value().value());
+  EXPECT_EQ(
+      Hash20::sha1(std::string{"contents"}),
+      attributes.sha1.value().value());
+  EXPECT_EQ(TreeEntryType::REGULAR_FILE, attributes.type.value().value());
+
+  // Errors fetching the metadata are reported as the sha1 and size.
+  attributes =
+      virtualInode
+          .getEntryAttributes(
+              ENTRY_ATTRIBUTE_SIZE | ENTRY_ATTRIBUTE_SHA1,
+              RelativePathPiece{"dir/file"},
+              folly::Try<BlobMetadata>{std::domain_error{"fake error"}},
+              ObjectFetchContext::getNullContext())
+          .get();
+  EXPECT_TRUE(attributes.size.value().hasException());
+  EXPECT_TRUE(attributes.sha1.value().hasException());
+  EXPECT_FALSE(attributes.type.has_value());
+}
+
 TEST(VirtualInodeTest, sha1DoesNotChangeState) {
   TestFileDatabase files;
   auto mount = TestMount{MakeTestTreeBuilder(files)};
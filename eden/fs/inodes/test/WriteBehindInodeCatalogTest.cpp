@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/inodes/WriteBehindInodeCatalog.h"
+
+#include <folly/Synchronized.h>
+#include <folly/portability/GTest.h>
+#include <map>
+#include <string>
+#include <vector>
+#include "eden/fs/inodes/overlay/gen-cpp2/overlay_types.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+/**
+ * Keeps the directories in memory and records the order of the writes.
+ */
+class RecordingInodeCatalog : public InodeCatalog {
+ public:
+  struct State {
+    std::map<InodeNumber, overlay::OverlayDir> dirs;
+    std::vector<InodeNumber> writes;
+    std::optional<InodeNumber> closedWith;
+  };
+
+  explicit RecordingInodeCatalog(folly::Synchronized<State>& state)
+      : state_{state} {}
+
+  bool supportsSemanticOperations() const override {
+    return false;
+  }
+
+  std::optional<InodeNumber> initOverlay(bool) override {
+    return InodeNumber{2};
+  }
+
+  void close(std::optional<InodeNumber> nextInodeNumber) override {
+    state_.wlock()->closedWith = nextInodeNumber;
+  }
+
+  bool initialized() const override {
+    return true;
+  }
+
+  std::optional<overlay::OverlayDir> loadOverlayDir(
+      InodeNumber inodeNumber) override {
+    auto state = state_.rlock();
+    auto it = state->dirs.find(inodeNumber);
+    if (it == state->dirs.end()) {
+      return std::nullopt;
+    }
+    return it->second;
+  }
+
+  std::optional<overlay::OverlayDir> loadAndRemoveOverlayDir(
+      InodeNumber inodeNumber) override {
+    auto odir = loadOverlayDir(inodeNumber);
+    removeOverlayDir(inodeNumber);
+    return odir;
+  }
+
+  void saveOverlayDir(InodeNumber inodeNumber, overlay::OverlayDir&& odir)
+      override {
+    auto state = state_.wlock();
+    state->dirs[inodeNumber] = std::move(odir);
+    state->writes.push_back(inodeNumber);
+  }
+
+  void removeOverlayDir(InodeNumber inodeNumber) override {
+    auto state = state_.wlock();
+    state->dirs.erase(inodeNumber);
+    state->writes.push_back(inodeNumber);
+  }
+
+  bool hasOverlayDir(InodeNumber inodeNumber) override {
+    return state_.rlock()->dirs.count(inodeNumber);
+  }
+
+  void maintenance() override {}
+
+ private:
+  folly::Synchronized<State>& state_;
+};
+
+overlay::OverlayDir makeDir(std::initializer_list<std::string> names) {
+  overlay::OverlayDir odir;
+  for (const auto& name : names) {
+    odir.entries_ref()->emplace(name, overlay::OverlayEntry{});
+  }
+  return odir;
+}
+
+class WriteBehindInodeCatalogTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    // A delay long enough for the tests to only see writes on flush.
+    catalog_ = std::make_unique<WriteBehindInodeCatalog>(
+        std::make_unique<RecordingInodeCatalog>(inner_), 1h, 1000);
+  }
+
+  folly::Synchronized<RecordingInodeCatalog::State> inner_;
+  std::unique_ptr<WriteBehindInodeCatalog> catalog_;
+};
+
+} // namespace
+
+TEST_F(WriteBehindInodeCatalogTest, coalescesRepeatedSaves) {
+  catalog_->saveOverlayDir(InodeNumber{2}, makeDir({"a"}));
+  catalog_->saveOverlayDir(InodeNumber{2}, makeDir({"a", "b"}));
+  catalog_->saveOverlayDir(InodeNumber{2}, makeDir({"a", "b", "c"}));
+  catalog_->flush();
+
+  auto inner = inner_.rlock();
+  EXPECT_EQ(std::vector<InodeNumber>{InodeNumber{2}}, inner->writes);
+  EXPECT_EQ(3, inner->dirs.at(InodeNumber{2}).entries_ref()->size());
+}
+
+TEST_F(WriteBehindInodeCatalogTest, readsSeePendingWrites) {
+  inner_.wlock()->dirs[InodeNumber{3}] = makeDir({"old"});
+
+  catalog_->saveOverlayDir(InodeNumber{2}, makeDir({"a", "b"}));
+  catalog_->removeOverlayDir(InodeNumber{3});
+
+  EXPECT_TRUE(inner_.rlock()->writes.empty());
+  auto loaded = catalog_->loadOverlayDir(InodeNumber{2});
+  ASSERT_TRUE(loaded.has_value());
+  EXPECT_EQ(2, loaded->entries_ref()->size());
+  EXPECT_TRUE(catalog_->hasOverlayDir(InodeNumber{2}));
+  EXPECT_FALSE(catalog_->hasOverlayDir(InodeNumber{3}));
+  EXPECT_FALSE(catalog_->loadOverlayDir(InodeNumber{3}).has_value());
+
+  auto removed = catalog_->loadAndRemoveOverlayDir(InodeNumber{2});
+  ASSERT_TRUE(removed.has_value());
+  EXPECT_EQ(2, removed->entries_ref()->size());
+  EXPECT_FALSE(catalog_->hasOverlayDir(InodeNumber{2}));
+
+  catalog_->flush();
+  auto inner = inner_.rlock();
+  EXPECT_TRUE(inner->dirs.empty());
+}
+
+TEST_F(WriteBehindInodeCatalogTest, writesBackInTheOrderOfTheLastSave) {
+  catalog_->saveOverlayDir(InodeNumber{2}, makeDir({"child"}));
+  catalog_->saveOverlayDir(InodeNumber{3}, makeDir({}));
+  catalog_->saveOverlayDir(InodeNumber{2}, makeDir({"child", "other"}));
+  catalog_->flush();
+
+  EXPECT_EQ(
+      (std::vector<InodeNumber>{InodeNumber{3}, InodeNumber{2}}),
+      inner_.rlock()->writes);
+}
+
+TEST_F(WriteBehindInodeCatalogTest, closeWritesEverythingBackFirst) {
+  catalog_->saveOverlayDir(InodeNumber{2}, makeDir({"a"}));
+  catalog_->close(InodeNumber{10});
+
+  {
+    auto inner = inner_.rlock();
+    EXPECT_EQ(1, inner->dirs.count(InodeNumber{2}));
+    EXPECT_EQ(InodeNumber{10}, inner->closedWith);
+  }
+
+  // Writes after close go straight to the underlying catalog.
+  catalog_->saveOverlayDir(InodeNumber{3}, makeDir({}));
+  EXPECT_EQ(1, inner_.rlock()->dirs.count(InodeNumber{3}));
+}
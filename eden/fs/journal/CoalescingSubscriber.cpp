@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/journal/CoalescingSubscriber.h"
+
+#include <folly/futures/Future.h>
+#include <folly/logging/xlog.h>
+
+namespace facebook::eden {
+
+CoalescingSubscriber::CoalescingSubscriber(
+    folly::Executor::KeepAlive<> executor,
+    std::chrono::nanoseconds interval,
+    Journal::SubscriberCallback callback)
+    : executor_{std::move(executor)},
+      interval_{interval},
+      callback_{std::move(callback)} {}
+
+Journal::SubscriberId CoalescingSubscriber::subscribe(
+    Journal& journal,
+    folly::Executor::KeepAlive<> executor,
+    std::chrono::nanoseconds interval,
+    Journal::SubscriberCallback callback) {
+  auto subscriber = std::make_shared<CoalescingSubscriber>(
+      std::move(executor), interval, std::move(callback));
+  return journal.registerSubscriber(
+      [subscriber = std::move(subscriber)] { subscriber->notify(); });
+}
+
+void CoalescingSubscriber::notify() {
+  {
+    auto state = state_.lock();
+    if (*state != State::Idle) {
+      *state = State::Pending;
+      return;
+    }
+    *state = State::Delivering;
+  }
+  executor_->add([weak = weak_from_this()] {
+    if (auto self = weak.lock()) {
+      self->deliver();
+    }
+  });
+}
+
+void CoalescingSubscriber::deliver() {
+  try {
+    callback_();
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "journal subscriber failed: " << folly::exceptionStr(ex);
+  }
+
+  // Once the interval ends, deliver what was notified in the meantime. The
+  // executor is only used while the subscriber is alive, as its owner only
+  // outlives the Journal.
+  folly::futures::sleep(interval_).toUnsafeFuture().thenTry(
+      [weak = weak_from_this()](folly::Try<folly::Unit>&&) {
+        if (auto self = weak.lock()) {
+          self->executor_->add([self] { self->intervalEnded(); });
+        }
+      });
+}
+
+void CoalescingSubscriber::intervalEnded() {
+  {
+    auto state = state_.lock();
+    if (*state != State::Pending) {
+      *state = State::Idle;
+      return;
+    }
+    *state = State::Delivering;
+  }
+  deliver();
+}
+
+} // namespace facebook::eden
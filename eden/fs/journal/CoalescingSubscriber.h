@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Executor.h>
+#include <folly/Synchronized.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+
+#include "eden/fs/journal/Journal.h"
+
+namespace facebook::eden {
+
+/**
+ * Wraps a Journal subscriber callback so that bursts of notifications are
+ * delivered as at most one call per interval.
+ *
+ * notify() is meant to be called by the Journal, on the thread recording the
+ * change. It never calls the callback itself: the callback runs on the given
+ * executor, right away if nothing was delivered during the last interval,
+ * and once at the end of the interval otherwise. Since subscribers query the
+ * Journal for what changed, a single call covers all the notifications that
+ * were coalesced into it.
+ *
+ * Deliveries hold a weak reference to the subscriber, so destroying it, as
+ * cancelling the Journal subscription does, stops the pending ones. The
+ * executor must outlive the subscriber.
+ */
+class CoalescingSubscriber
+    : public std::enable_shared_from_this<CoalescingSubscriber> {
+ public:
+  CoalescingSubscriber(
+      folly::Executor::KeepAlive<> executor,
+      std::chrono::nanoseconds interval,
+      Journal::SubscriberCallback callback);
+
+  CoalescingSubscriber(const CoalescingSubscriber&) = delete;
+  CoalescingSubscriber& operator=(const CoalescingSubscriber&) = delete;
+
+  /**
+   * Registers a CoalescingSubscriber with the journal, returning the id to
+   * cancel it with.
+   */
+  static Journal::SubscriberId subscribe(
+      Journal& journal,
+      folly::Executor::KeepAlive<> executor,
+      std::chrono::nanoseconds interval,
+      Journal::SubscriberCallback callback);
+
+  void notify();
+
+ private:
+  enum class State {
+    /** Nothing was delivered during the last interval. */
+    Idle,
+    /** A delivery is queued or its interval didn't end yet. */
+    Delivering,
+    /** Like Delivering, with a notification to deliver once it ends. */
+    Pending,
+  };
+
+  void deliver();
+  void intervalEnded();
+
+  const folly::Executor::KeepAlive<> executor_;
+  const std::chrono::nanoseconds interval_;
+  const Journal::SubscriberCallback callback_;
+  folly::Synchronized<State, std::mutex> state_{State::Idle};
+};
+
+} // namespace facebook::eden
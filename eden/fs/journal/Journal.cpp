@@ -11,6 +11,49 @@
 
 namespace facebook::eden {
 
+namespace {
+/**
+ * Calls fn with the distinct top-level names of the paths of delta.
+ */
+template <typename Fn>
+void forEachTopLevelName(
+    const CompactFileChangeJournalDelta& delta,
+    const JournalPathTable& paths,
+    Fn&& fn) {
+  std::optional<PathComponentPiece> name1;
+  if (delta.isPath1Valid) {
+    name1 = paths.getTopLevelName(delta.path1);
+    fn(*name1);
+  }
+  if (delta.isPath2Valid) {
+    auto name2 = paths.getTopLevelName(delta.path2);
+    if (name1 != name2) {
+      fn(name2);
+    }
+  }
+}
+
+bool isUnder(RelativePathPiece path, RelativePathPiece prefix) {
+  return prefix.empty() || path == prefix || path.isSubDirOf(prefix);
+}
+
+/**
+ * The first delta of deltas whose sequence number is at least from.
+ */
+template <typename T>
+auto lowerBound(
+    const std::deque<T>& deltas,
+    JournalDelta::SequenceNumber from) {
+  return std::lower_bound(
+      deltas.begin(),
+      deltas.end(),
+      from,
+      [](const T& delta, JournalDelta::SequenceNumber sequence) {
+        return delta.sequenceID < sequence;
+      });
+}
+} // namespace
+
 JournalDeltaPtr Journal::DeltaState::frontPtr() noexcept {
   bool isFileChangeEmpty = fileChangeDeltas.empty();
   bool isHashUpdateEmpty = hashUpdateDeltas.empty();
@@ -37,12 +80,12 @@ void Journal::DeltaState::popFront() {
   if (!isFileChangeEmpty && !isHashUpdateEmpty) {
     if (fileChangeDeltas.front().sequenceID <
         hashUpdateDeltas.front().sequenceID) {
-      fileChangeDeltas.pop_front();
+      popFrontFileChange();
     } else {
       hashUpdateDeltas.pop_front();
     }
   } else if (!isFileChangeEmpty) {
-    fileChangeDeltas.pop_front();
+    popFrontFileChange();
   } else if (!isHashUpdateEmpty) {
     hashUpdateDeltas.pop_front();
   }
@@ -88,10 +131,56 @@ bool Journal::DeltaState::isFileChangeInBack() const {
   return !isFileChangeEmpty && isHashUpdateEmpty;
 }
 
-void Journal::DeltaState::appendDelta(FileChangeJournalDelta&& delta) {
+void Journal::DeltaState::popFrontFileChange() {
+  auto& front = fileChangeDeltas.front();
+  forEachTopLevelName(front, paths, [&](PathComponentPiece name) {
+    auto it = topLevelIndex.find(name.view());
+    XDCHECK(it != topLevelIndex.end());
+    XDCHECK_EQ(it->second.front(), front.sequenceID);
+    it->second.pop_front();
+    --topLevelIndexSize;
+    if (it->second.empty()) {
+      topLevelIndex.erase(it);
+    }
+  });
+  front.release(paths);
+  fileChangeDeltas.pop_front();
+}
+
+void Journal::DeltaState::appendDelta(CompactFileChangeJournalDelta&& delta) {
+  forEachTopLevelName(delta, paths, [&](PathComponentPiece name) {
+    auto it = topLevelIndex.find(name.view());
+    if (it == topLevelIndex.end()) {
+      it = topLevelIndex.emplace(name.asString(), std::deque<SequenceNumber>{})
+               .first;
+    }
+    it->second.push_back(delta.sequenceID);
+    ++topLevelIndexSize;
+  });
   fileChangeDeltas.emplace_back(std::move(delta));
 }
 
+void Journal::DeltaState::replaceBack(CompactFileChangeJournalDelta&& delta) {
+  auto& back = fileChangeDeltas.back();
+  forEachTopLevelName(back, paths, [&](PathComponentPiece name) {
+    auto& sequences = topLevelIndex.find(name.view())->second;
+    XDCHECK_EQ(sequences.back(), back.sequenceID);
+    sequences.back() = delta.sequenceID;
+  });
+  back.release(paths);
+  back = std::move(delta);
+}
+
+void Journal::DeltaState::clearDeltas() {
+  fileChangeDeltas.clear();
+  hashUpdateDeltas.clear();
+  paths.clear();
+  topLevelIndex.clear();
+  topLevelIndexSize = 0;
+  stats = std::nullopt;
+  deltaMemoryUsage = 0;
+}
+
 void Journal::DeltaState::appendDelta(RootUpdateJournalDelta&& delta) {
   hashUpdateDeltas.emplace_back(std::move(delta));
 }
@@ -154,7 +243,7 @@ void Journal::recordUncleanPaths(
   addDelta(std::move(delta), std::move(toHash));
 }
 
-void Journal::truncateIfNecessary(DeltaState& deltaState) {
+void Journal::truncateIfNecessary(DeltaState& deltaState) const {
   while (JournalDeltaPtr front = deltaState.frontPtr()) {
     if (estimateMemoryUsage(deltaState) <= deltaState.memoryLimit) {
       break;
@@ -166,13 +255,15 @@ void Journal::truncateIfNecessary(DeltaState& deltaState) {
   }
 }
 
-bool Journal::compact(FileChangeJournalDelta& delta, DeltaState& deltaState) {
+bool Journal::compact(
+    CompactFileChangeJournalDelta& delta,
+    DeltaState& deltaState) const {
   auto back = deltaState.backPtr().getAsFileChangeJournalDelta();
   if (back && delta.isModification() && delta.isSameAction(*back)) {
     deltaState.stats->latestTimestamp = delta.time;
     deltaState.deltaMemoryUsage -= back->estimateMemoryUsage();
     deltaState.deltaMemoryUsage += delta.estimateMemoryUsage();
-    *back = std::move(delta);
+    deltaState.replaceBack(std::move(delta));
     return true;
   }
   return false;
@@ -180,17 +271,43 @@ bool Journal::compact(FileChangeJournalDelta& delta, DeltaState& deltaState) {
 
 bool Journal::compact(
     RootUpdateJournalDelta& /* unused */,
-    DeltaState& /* unused */) {
+    DeltaState& /* unused */) const {
   return false;
 }
 
 template <typename T>
-bool Journal::addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState) {
+bool Journal::addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState)
+    const {
   delta.sequenceID = deltaState.nextSequence++;
   delta.time = std::chrono::steady_clock::now();
 
+  // Root updates set currentHash to their new root before being added.
+  if (deltaState.segment) {
+    deltaState.segment->append(delta, deltaState.currentHash);
+  }
+  return storeDeltaBeforeNotifying(std::forward<T>(delta), deltaState);
+}
+
+template <typename T>
+bool Journal::storeDeltaBeforeNotifying(T&& delta, DeltaState& deltaState)
+    const {
   truncateIfNecessary(deltaState);
 
+  if constexpr (std::is_same_v<std::decay_t<T>, FileChangeJournalDelta>) {
+    // Interned after the truncation, which may release some of its paths.
+    return addStoredDeltaBeforeNotifying(
+        CompactFileChangeJournalDelta{std::forward<T>(delta), deltaState.paths},
+        deltaState);
+  } else {
+    return addStoredDeltaBeforeNotifying(std::forward<T>(delta), deltaState);
+  }
+}
+
+template <typename T>
+bool Journal::addStoredDeltaBeforeNotifying(
+    T&& delta,
+    DeltaState& deltaState) const {
+
   // We will compact the delta if possible. We can compact the delta if it is
   // a modification to a single file and matches the last delta added to the
   // Journal. For a consumer the only differences seen due to compaction are
@@ -229,29 +346,50 @@ void Journal::notifySubscribers() const {
   }
 }
 
-void Journal::addDelta(FileChangeJournalDelta&& delta) {
+bool Journal::mergeStagedFileChanges(DeltaState& deltaState) const {
+  bool shouldNotify = false;
+  stagedFileChanges_.sweep([&](FileChangeJournalDelta&& delta) {
+    shouldNotify |= addDeltaBeforeNotifying(std::move(delta), deltaState);
+  });
+  return shouldNotify;
+}
+
+void Journal::mergeStagedFileChanges() const {
+  if (stagedFileChanges_.empty()) {
+    return;
+  }
   bool shouldNotify;
   {
     auto deltaState = deltaState_.lock();
-    shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
+    shouldNotify = mergeStagedFileChanges(*deltaState);
   }
   if (shouldNotify) {
     notifySubscribers();
   }
 }
 
+void Journal::addDelta(FileChangeJournalDelta&& delta) {
+  // When other changes are already staged, the thread that staged the first
+  // of them merges this one too.
+  if (stagedFileChanges_.insertHead(std::move(delta))) {
+    mergeStagedFileChanges();
+  }
+}
+
 void Journal::addDelta(RootUpdateJournalDelta&& delta, RootId newRootId) {
   bool shouldNotify;
   {
     auto deltaState = deltaState_.lock();
+    // The file changes recorded before come first.
+    shouldNotify = mergeStagedFileChanges(*deltaState);
 
     // If the hashes were not set to anything, default to copying
     // the value from the prior journal entry
     if (delta.fromHash == RootId{}) {
       delta.fromHash = deltaState->currentHash;
     }
-    shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
     deltaState->currentHash = std::move(newRootId);
+    shouldNotify |= addDeltaBeforeNotifying(std::move(delta), *deltaState);
   }
   if (shouldNotify) {
     notifySubscribers();
@@ -259,13 +397,15 @@ void Journal::addDelta(RootUpdateJournalDelta&& delta, RootId newRootId) {
 }
 
 std::optional<JournalDeltaInfo> Journal::getLatest() {
+  mergeStagedFileChanges();
   auto deltaState = deltaState_.lock();
   deltaState->lastModificationHasBeenObserved = true;
   if (deltaState->empty()) {
     return std::nullopt;
   } else {
     if (deltaState->isFileChangeInBack()) {
-      const FileChangeJournalDelta& back = deltaState->fileChangeDeltas.back();
+      const CompactFileChangeJournalDelta& back =
+          deltaState->fileChangeDeltas.back();
       return JournalDeltaInfo{
           deltaState->currentHash,
           deltaState->currentHash,
@@ -316,7 +456,14 @@ bool Journal::isSubscriberValid(uint64_t id) const {
 }
 
 std::optional<InternalJournalStats> Journal::getStats() {
-  return deltaState_.lock()->stats;
+  mergeStagedFileChanges();
+  auto deltaState = deltaState_.lock();
+  auto stats = deltaState->stats;
+  if (stats && stats->entryCount > 0) {
+    stats->bytesPerDelta =
+        estimateMemoryUsage(*deltaState) / stats->entryCount;
+  }
+  return stats;
 }
 
 namespace {
@@ -344,6 +491,7 @@ size_t Journal::getMemoryLimit() const {
 }
 
 size_t Journal::estimateMemoryUsage() const {
+  mergeStagedFileChanges();
   return estimateMemoryUsage(*deltaState_.lock());
 }
 
@@ -362,6 +510,9 @@ size_t Journal::estimateMemoryUsage(const DeltaState& deltaState) const {
   // Account for overhead of deques which have a maximum buffer size of 512.
   memoryUsage += getPaddingAmount(deltaState.fileChangeDeltas);
   memoryUsage += getPaddingAmount(deltaState.hashUpdateDeltas);
+  memoryUsage += deltaState.paths.estimateMemoryUsage();
+  memoryUsage += deltaState.topLevelIndex.getAllocatedMemorySize() +
+      deltaState.topLevelIndexSize * sizeof(SequenceNumber);
 
   if (deltaState.stats) {
     memoryUsage += deltaState.deltaMemoryUsage;
@@ -369,15 +520,74 @@ size_t Journal::estimateMemoryUsage(const DeltaState& deltaState) const {
   return memoryUsage;
 }
 
+void Journal::persistTo(
+    AbsolutePathPiece path,
+    size_t capacityBytes,
+    const std::optional<RootId>& expectedRoot) {
+  auto segment = JournalSegment::open(path, capacityBytes);
+  auto deltaState = deltaState_.lock();
+  XCHECK(deltaState->empty()) << "deltas were recorded before persisting them";
+
+  auto restore = [&](auto&& delta) {
+    delta.time = std::chrono::steady_clock::now();
+    deltaState->nextSequence = delta.sequenceID + 1;
+    (void)storeDeltaBeforeNotifying(std::move(delta), *deltaState);
+  };
+  // Replayed even when it won't be restored, as that also finds the torn
+  // records the reset below must erase.
+  bool replayed = segment->replay(
+      [&](SequenceNumber nextSequence, RootId root) {
+        deltaState->nextSequence = nextSequence;
+        deltaState->currentHash = std::move(root);
+      },
+      [&](FileChangeJournalDelta&& delta) { restore(std::move(delta)); },
+      [&](RootUpdateJournalDelta&& delta, RootId toHash) {
+        deltaState->currentHash = std::move(toHash);
+        restore(std::move(delta));
+      });
+  auto mountGeneration = segment->getMountGeneration();
+  bool restored = replayed && mountGeneration != 0 && expectedRoot &&
+      deltaState->currentHash == *expectedRoot;
+
+  if (restored) {
+    XLOG(DBG1) << "Restored the journal from " << path << " up to sequence "
+               << deltaState->nextSequence - 1;
+    deltaState->restoredMountGeneration = mountGeneration;
+  } else {
+    // Start over from an empty journal.
+    deltaState->clearDeltas();
+    deltaState->nextSequence = 1;
+    deltaState->currentHash = RootId{};
+    segment->setMountGeneration(0);
+    segment->reset(deltaState->nextSequence, deltaState->currentHash);
+  }
+  deltaState->segment = std::move(segment);
+}
+
+std::optional<uint64_t> Journal::getRestoredMountGeneration() const {
+  return deltaState_.lock()->restoredMountGeneration;
+}
+
+void Journal::setMountGeneration(uint64_t mountGeneration) {
+  auto deltaState = deltaState_.lock();
+  if (deltaState->segment) {
+    deltaState->segment->setMountGeneration(mountGeneration);
+  }
+}
+
 void Journal::flush() {
   bool shouldNotify;
   {
     auto deltaState = deltaState_.lock();
+    // The staged file changes are flushed along with the others.
+    shouldNotify = mergeStagedFileChanges(*deltaState);
     ++deltaState->nextSequence;
     auto lastHash = deltaState->currentHash;
-    deltaState->fileChangeDeltas.clear();
-    deltaState->hashUpdateDeltas.clear();
-    deltaState->stats = std::nullopt;
+    deltaState->clearDeltas();
+    if (deltaState->segment) {
+      deltaState->segment->reset(
+          deltaState->nextSequence, deltaState->currentHash);
+    }
     auto delta = RootUpdateJournalDelta();
     /* Tracking the hash correctly when the journal is flushed is important
      * since Watchman uses the hash to correctly determine what additional files
@@ -387,30 +597,63 @@ void Journal::flush() {
      * flush operation.
      */
     delta.fromHash = lastHash;
-    shouldNotify = addDeltaBeforeNotifying(std::move(delta), *deltaState);
+    shouldNotify |= addDeltaBeforeNotifying(std::move(delta), *deltaState);
   }
   if (shouldNotify) {
     notifySubscribers();
   }
 }
 
+namespace {
+void accumulateFileChange(
+    JournalDeltaRange& result,
+    const CompactFileChangeJournalDelta& current,
+    const JournalPathTable& paths,
+    RelativePathPiece prefix) {
+  for (auto& entry : current.getChangedFilesInOverlay(paths)) {
+    auto& name = entry.first;
+    if (!isUnder(name, prefix)) {
+      continue;
+    }
+    auto& currentInfo = entry.second;
+    auto* resultInfo = folly::get_ptr(result.changedFilesInOverlay, name);
+    if (!resultInfo) {
+      result.changedFilesInOverlay.emplace(name, currentInfo);
+    } else {
+      if (resultInfo->existedBefore != currentInfo.existedAfter) {
+        auto event1 = eventCharacterizationFor(currentInfo);
+        auto event2 = eventCharacterizationFor(*resultInfo);
+        XLOG(ERR) << "Journal for " << name << " holds invalid " << event1
+                  << ", " << event2 << " sequence";
+      }
+
+      resultInfo->existedBefore = currentInfo.existedBefore;
+    }
+  }
+}
+} // namespace
+
 std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
-    SequenceNumber from) {
+    SequenceNumber from,
+    RelativePathPiece prefix) {
   XDCHECK(from > 0);
   std::unique_ptr<JournalDeltaRange> result = nullptr;
 
   size_t filesAccumulated = 0;
+  mergeStagedFileChanges();
   auto deltaState = deltaState_.lock();
   // If this is going to be truncated, handle it before iterating.
   if (!deltaState->empty() && deltaState->getFrontSequenceID() > from) {
     result = std::make_unique<JournalDeltaRange>();
     result->isTruncated = true;
+  } else if (!prefix.empty()) {
+    result = accumulatePrefix(*deltaState, from, prefix, filesAccumulated);
   } else {
     forEachDelta(
         *deltaState,
         from,
         std::nullopt,
-        [&](const FileChangeJournalDelta& current) -> void {
+        [&](const CompactFileChangeJournalDelta& current) -> void {
           ++filesAccumulated;
           if (!result) {
             result = std::make_unique<JournalDeltaRange>();
@@ -422,24 +665,8 @@ std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
           result->fromSequence = current.sequenceID;
           result->fromTime = current.time;
 
-          for (auto& entry : current.getChangedFilesInOverlay()) {
-            auto& name = entry.first;
-            auto& currentInfo = entry.second;
-            auto* resultInfo =
-                folly::get_ptr(result->changedFilesInOverlay, name);
-            if (!resultInfo) {
-              result->changedFilesInOverlay.emplace(name, currentInfo);
-            } else {
-              if (resultInfo->existedBefore != currentInfo.existedAfter) {
-                auto event1 = eventCharacterizationFor(currentInfo);
-                auto event2 = eventCharacterizationFor(*resultInfo);
-                XLOG(ERR) << "Journal for " << name << " holds invalid "
-                          << event1 << ", " << event2 << " sequence";
-              }
-
-              resultInfo->existedBefore = currentInfo.existedBefore;
-            }
-          }
+          accumulateFileChange(
+              *result, current, deltaState->paths, RelativePathPiece{});
         },
         [&](const RootUpdateJournalDelta& current) -> void {
           if (!result) {
@@ -479,19 +706,84 @@ std::unique_ptr<JournalDeltaRange> Journal::accumulateRange(
   return result;
 }
 
+std::unique_ptr<JournalDeltaRange> Journal::accumulatePrefix(
+    const DeltaState& deltaState,
+    SequenceNumber from,
+    RelativePathPiece prefix,
+    size_t& filesAccumulated) const {
+  // The range covers all the deltas since from, whether or not they touch
+  // prefix, so that it can be resumed from its end.
+  auto fileChangeIt = lowerBound(deltaState.fileChangeDeltas, from);
+  auto hashUpdateIt = lowerBound(deltaState.hashUpdateDeltas, from);
+  const JournalDelta* oldest = nullptr;
+  const JournalDelta* newest = nullptr;
+  if (fileChangeIt != deltaState.fileChangeDeltas.end()) {
+    oldest = &*fileChangeIt;
+    newest = &deltaState.fileChangeDeltas.back();
+  }
+  if (hashUpdateIt != deltaState.hashUpdateDeltas.end()) {
+    if (!oldest || hashUpdateIt->sequenceID < oldest->sequenceID) {
+      oldest = &*hashUpdateIt;
+    }
+    auto& back = deltaState.hashUpdateDeltas.back();
+    if (!newest || back.sequenceID > newest->sequenceID) {
+      newest = &back;
+    }
+  }
+  if (!newest) {
+    return nullptr;
+  }
+
+  auto result = std::make_unique<JournalDeltaRange>();
+  result->fromSequence = oldest->sequenceID;
+  result->fromTime = oldest->time;
+  result->toSequence = newest->sequenceID;
+  result->toTime = newest->time;
+  result->snapshotTransitions.push_back(deltaState.currentHash);
+
+  // Only the file changes under the top-level directory of prefix can be
+  // under it. They are accumulated newest first, like forEachDelta does.
+  auto topLevelName = *prefix.components().begin();
+  auto indexIt = deltaState.topLevelIndex.find(topLevelName.view());
+  if (indexIt != deltaState.topLevelIndex.end()) {
+    const auto& sequences = indexIt->second;
+    for (auto it = sequences.rbegin();
+         it != sequences.rend() && *it >= from;
+         ++it) {
+      auto delta = lowerBound(deltaState.fileChangeDeltas, *it);
+      XDCHECK_EQ(delta->sequenceID, *it);
+      ++filesAccumulated;
+      accumulateFileChange(*result, *delta, deltaState.paths, prefix);
+    }
+  }
+
+  for (auto it = deltaState.hashUpdateDeltas.rbegin();
+       it != deltaState.hashUpdateDeltas.rend() && it->sequenceID >= from;
+       ++it) {
+    result->snapshotTransitions.push_back(it->fromHash);
+    for (const auto& path : it->uncleanPaths) {
+      if (isUnder(path, prefix)) {
+        result->uncleanPaths.insert(path);
+      }
+    }
+  }
+  return result;
+}
+
 std::vector<DebugJournalDelta> Journal::getDebugRawJournalInfo(
     SequenceNumber from,
     std::optional<size_t> limit,
     long mountGeneration,
     RootIdCodec& rootIdCodec) const {
   auto result = std::vector<DebugJournalDelta>();
+  mergeStagedFileChanges();
   auto deltaState = deltaState_.lock();
   RootId currentHash = deltaState->currentHash;
   forEachDelta(
       *deltaState,
       from,
       limit,
-      [&](const FileChangeJournalDelta& current) -> void {
+      [&](const CompactFileChangeJournalDelta& current) -> void {
         DebugJournalDelta delta;
         JournalPosition fromPosition;
         fromPosition.mountGeneration_ref() = mountGeneration;
@@ -505,7 +797,8 @@ std::vector<DebugJournalDelta> Journal::getDebugRawJournalInfo(
         toPosition.snapshotHash_ref() = rootIdCodec.renderRootId(currentHash);
         delta.toPosition_ref() = toPosition;
 
-        for (const auto& entry : current.getChangedFilesInOverlay()) {
+        for (const auto& entry :
+             current.getChangedFilesInOverlay(deltaState->paths)) {
           auto& path = entry.first;
           auto& changeInfo = entry.second;
 
@@ -543,7 +836,7 @@ std::vector<DebugJournalDelta> Journal::getDebugRawJournalInfo(
 }
 
 /**
- * FileChangeFunc: void(const FileChangeJournalDelta&)
+ * FileChangeFunc: void(const CompactFileChangeJournalDelta&)
  * HashUpdateFunc: void(const RootUpdateJournalDelta&)
  */
 template <class FileChangeFunc, class HashUpdateFunc>
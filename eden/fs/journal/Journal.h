@@ -7,14 +7,17 @@
 
 #pragma once
 
+#include <folly/AtomicLinkedList.h>
 #include <folly/Function.h>
 #include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
 #include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <optional>
 #include <unordered_map>
 #include "eden/fs/journal/JournalDelta.h"
+#include "eden/fs/journal/JournalSegment.h"
 #include "eden/fs/model/RootId.h"
 #include "eden/fs/service/gen-cpp2/streamingeden_types.h"
 #include "eden/fs/telemetry/EdenStats.h"
@@ -27,6 +30,8 @@ struct InternalJournalStats {
   std::chrono::steady_clock::time_point earliestTimestamp;
   std::chrono::steady_clock::time_point latestTimestamp;
   size_t maxFilesAccumulated = 0;
+  /// The memory used by the journal per delta, their paths included.
+  size_t bytesPerDelta = 0;
   uint64_t getDurationInSeconds() {
     return std::chrono::duration_cast<std::chrono::seconds>(
                std::chrono::steady_clock::now() - earliestTimestamp)
@@ -55,7 +60,8 @@ struct JournalDeltaInfo {
  * the larger list of files.
  *
  * The Journal class is thread-safe.  Subscribers are called on the thread
- * that called addDelta.
+ * that called addDelta, or on the thread that merged the recorded file
+ * changes into the journal.
  */
 class Journal {
  public:
@@ -119,10 +125,16 @@ class Journal {
    *
    * The default limit value indicates that all deltas should be summed.
    *
+   * If prefix is not empty, only the paths under it, or equal to it, are
+   * accumulated, and only the deltas touching the same top-level directory
+   * are looked at. The sequence range and the snapshot transitions still
+   * cover all the deltas.
+   *
    * If the limitSequence means that no deltas will match, returns nullptr.
    */
   std::unique_ptr<JournalDeltaRange> accumulateRange(
-      SequenceNumber limitSequence = 1);
+      SequenceNumber limitSequence = 1,
+      RelativePathPiece prefix = RelativePathPiece{});
 
   // Subscription functionality:
 
@@ -178,6 +190,38 @@ class Journal {
 
   size_t estimateMemoryUsage() const;
 
+  // Persistence:
+
+  /**
+   * Appends the deltas to the segment file at `path`, bounded to
+   * `capacityBytes`, so that they survive EdenFS restarting.
+   *
+   * If the segment holds the deltas of a previous run that ended on
+   * `expectedRoot`, they are restored first, along with their sequence
+   * numbers, and getRestoredMountGeneration() returns the mount generation
+   * they belong to. Otherwise the segment is reset. Pass nullopt to never
+   * restore, for example when the working copy may have changed without being
+   * recorded.
+   *
+   * Must be called before any delta is recorded.
+   */
+  void persistTo(
+      AbsolutePathPiece path,
+      size_t capacityBytes,
+      const std::optional<RootId>& expectedRoot);
+
+  /**
+   * The mount generation of the deltas restored by persistTo, or nullopt if
+   * none were.
+   */
+  std::optional<uint64_t> getRestoredMountGeneration() const;
+
+  /**
+   * Records the mount generation the sequence numbers belong to, for a later
+   * run to restore them.
+   */
+  void setMountGeneration(uint64_t mountGeneration);
+
  private:
   /** Add a delta to the journal and notify subscribers.
    * The delta will have a new sequence number and timestamp
@@ -198,14 +242,27 @@ class Journal {
      * All recorded entries. Newer (more recent) deltas are added to the back of
      * the appropriate deque.
      */
-    std::deque<FileChangeJournalDelta> fileChangeDeltas;
+    std::deque<CompactFileChangeJournalDelta> fileChangeDeltas;
     std::deque<RootUpdateJournalDelta> hashUpdateDeltas;
+    /// The paths of fileChangeDeltas.
+    JournalPathTable paths;
+    /**
+     * The sequence numbers of the fileChangeDeltas touching each top-level
+     * directory, or file at the root, oldest first.
+     */
+    folly::F14FastMap<std::string, std::deque<SequenceNumber>> topLevelIndex;
+    /// The number of sequence numbers in topLevelIndex.
+    size_t topLevelIndexSize = 0;
     RootId currentHash;
     /// The stats about this Journal up to the latest delta.
     std::optional<InternalJournalStats> stats;
     size_t memoryLimit = kDefaultJournalMemoryLimit;
     size_t deltaMemoryUsage = 0;
 
+    /// Where the deltas are persisted, if they are.
+    std::unique_ptr<JournalSegment> segment;
+    std::optional<uint64_t> restoredMountGeneration;
+
     // Set to false when a delta is added.
     // Set to true when getLatest() or accumulateRange() are called.
     // If true before calling addDelta, subscribers are notified.
@@ -213,6 +270,7 @@ class Journal {
 
     JournalDeltaPtr frontPtr() noexcept;
     void popFront();
+    void popFrontFileChange();
     JournalDeltaPtr backPtr() noexcept;
 
     bool empty() const {
@@ -222,9 +280,18 @@ class Journal {
     bool isFileChangeInFront() const;
     bool isFileChangeInBack() const;
 
-    void appendDelta(FileChangeJournalDelta&& delta);
+    void appendDelta(CompactFileChangeJournalDelta&& delta);
     void appendDelta(RootUpdateJournalDelta&& delta);
 
+    /**
+     * Replaces the newest file change with delta, which touches the same
+     * paths.
+     */
+    void replaceBack(CompactFileChangeJournalDelta&& delta);
+
+    /** Removes all the deltas, keeping the sequence number and root. */
+    void clearDeltas();
+
     JournalDelta::SequenceNumber getFrontSequenceID() const {
       if (isFileChangeInFront()) {
         return fileChangeDeltas.front().sequenceID;
@@ -233,20 +300,47 @@ class Journal {
       }
     }
   };
-  folly::Synchronized<DeltaState, std::mutex> deltaState_;
+  // Mutable as all the readers, const ones included, first merge the staged
+  // file changes.
+  mutable folly::Synchronized<DeltaState, std::mutex> deltaState_;
+
+  /**
+   * The file changes recorded but not yet added to deltaState_, which is
+   * where they get their sequence number.
+   *
+   * Recording a file change only stages it without locking. The thread that
+   * staged a change in an empty list then merges the list into deltaState_,
+   * while the others return right away, their change being merged by that
+   * thread. Readers also merge the list before looking at deltaState_, so
+   * they see all the changes recorded before they were called.
+   */
+  mutable folly::AtomicLinkedList<FileChangeJournalDelta> stagedFileChanges_;
+
+  /**
+   * Adds the staged file changes to the journal, in the order they were
+   * staged, and notifies subscribers if needed.
+   */
+  void mergeStagedFileChanges() const;
+
+  /**
+   * Adds the staged file changes to the journal without notifying
+   * subscribers. Returns true if subscribers should be notified.
+   */
+  [[nodiscard]] bool mergeStagedFileChanges(DeltaState& deltaState) const;
 
   /**
    * Removes the oldest deltas until the memory usage of the journal is below
    * the journal's memory limit.
    */
-  void truncateIfNecessary(DeltaState& deltaState);
+  void truncateIfNecessary(DeltaState& deltaState) const;
 
   /**
    * Tries to compact a new Journal Delta with an old one if possible,
    * returning true if it did compact it and false if not
    */
-  bool compact(FileChangeJournalDelta& delta, DeltaState& deltaState);
-  bool compact(RootUpdateJournalDelta& delta, DeltaState& deltaState);
+  bool compact(CompactFileChangeJournalDelta& delta, DeltaState& deltaState)
+      const;
+  bool compact(RootUpdateJournalDelta& delta, DeltaState& deltaState) const;
 
   struct SubscriberState {
     SubscriberId nextSubscriberId{1};
@@ -262,7 +356,26 @@ class Journal {
    * Returns true if subscribers should be notified.
    */
   template <typename T>
-  [[nodiscard]] bool addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState);
+  [[nodiscard]] bool addDeltaBeforeNotifying(T&& delta, DeltaState& deltaState)
+      const;
+
+  /**
+   * The part of addDeltaBeforeNotifying after the delta got its sequence
+   * number and timestamp, shared with the deltas restored by persistTo.
+   */
+  template <typename T>
+  [[nodiscard]] bool storeDeltaBeforeNotifying(
+      T&& delta,
+      DeltaState& deltaState) const;
+
+  /**
+   * The part of storeDeltaBeforeNotifying after the file change deltas were
+   * converted to the form they are stored in.
+   */
+  template <typename T>
+  [[nodiscard]] bool addStoredDeltaBeforeNotifying(
+      T&& delta,
+      DeltaState& deltaState) const;
 
   /**
    * Notify subscribers that a change has happened. Must not be called while
@@ -272,6 +385,16 @@ class Journal {
 
   size_t estimateMemoryUsage(const DeltaState& deltaState) const;
 
+  /**
+   * The part of accumulateRange accumulating the changes under a non-empty
+   * prefix, looking only at the file changes of its top-level directory.
+   */
+  std::unique_ptr<JournalDeltaRange> accumulatePrefix(
+      const DeltaState& deltaState,
+      SequenceNumber from,
+      RelativePathPiece prefix,
+      size_t& filesAccumulated) const;
+
   /**
    * Runs from the latest delta to the delta with sequence ID (if 'lengthLimit'
    * is not nullopt then checks at most 'lengthLimit' entries) and runs
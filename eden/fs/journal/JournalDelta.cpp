@@ -6,7 +6,9 @@
  */
 
 #include "JournalDelta.h"
+#include <folly/Utility.h>
 #include <folly/logging/xlog.h>
+#include "eden/fs/utils/Memory.h"
 
 namespace facebook::eden {
 
@@ -53,23 +55,6 @@ FileChangeJournalDelta::FileChangeJournalDelta(
       isPath1Valid{true},
       isPath2Valid{true} {}
 
-size_t FileChangeJournalDelta::estimateMemoryUsage() const {
-  size_t mem = sizeof(FileChangeJournalDelta);
-
-  /* NOTE: The following code assumes an unordered_set is separated into an
-   * array of buckets, each one being a chain of nodes containing a next
-   * pointer, a key-value pair, and a stored hash
-   */
-  if (isPath1Valid) {
-    mem += facebook::eden::estimateIndirectMemoryUsage(path1);
-  }
-  if (isPath2Valid) {
-    mem += facebook::eden::estimateIndirectMemoryUsage(path2);
-  }
-
-  return mem;
-}
-
 size_t RootUpdateJournalDelta::estimateMemoryUsage() const {
   size_t mem = sizeof(RootUpdateJournalDelta);
 
@@ -97,33 +82,132 @@ size_t RootUpdateJournalDelta::estimateMemoryUsage() const {
   return mem;
 }
 
+JournalPathTable::Path JournalPathTable::intern(RelativePathPiece path) {
+  return Path{
+      internString(path.dirname().view()),
+      internString(path.basename().view())};
+}
+
+void JournalPathTable::release(Path path) {
+  releaseString(path.dir);
+  releaseString(path.name);
+}
+
+RelativePath JournalPathTable::lookup(Path path) const {
+  // Either can be empty, for the files at the root and for the root itself.
+  RelativePathPiece dir{*strings_[path.dir], detail::SkipPathSanityCheck()};
+  RelativePathPiece name{*strings_[path.name], detail::SkipPathSanityCheck()};
+  return dir + name;
+}
+
+PathComponentPiece JournalPathTable::getTopLevelName(Path path) const {
+  std::string_view dir = *strings_[path.dir];
+  if (dir.empty()) {
+    return PathComponentPiece{
+        *strings_[path.name], detail::SkipPathSanityCheck()};
+  }
+  return PathComponentPiece{
+      dir.substr(0, dir.find(kDirSeparator)), detail::SkipPathSanityCheck()};
+}
+
+void JournalPathTable::clear() {
+  entries_.clear();
+  strings_.clear();
+  freeIds_.clear();
+  stringMemoryUsage_ = 0;
+}
+
+size_t JournalPathTable::estimateMemoryUsage() const {
+  return entries_.getAllocatedMemorySize() + stringMemoryUsage_ +
+      folly::goodMallocSize(strings_.capacity() * sizeof(strings_[0])) +
+      folly::goodMallocSize(freeIds_.capacity() * sizeof(Id));
+}
+
+JournalPathTable::Id JournalPathTable::internString(std::string_view value) {
+  auto it = entries_.find(value);
+  if (it == entries_.end()) {
+    Id id;
+    if (freeIds_.empty()) {
+      id = folly::to_narrow(strings_.size());
+      strings_.push_back(nullptr);
+    } else {
+      id = freeIds_.back();
+      freeIds_.pop_back();
+    }
+    it = entries_.emplace(std::string{value}, Entry{id, 0}).first;
+    strings_[id] = &it->first;
+    stringMemoryUsage_ += estimateIndirectMemoryUsage(it->first);
+  }
+  ++it->second.refCount;
+  return it->second.id;
+}
+
+void JournalPathTable::releaseString(Id id) {
+  auto it = entries_.find(*strings_[id]);
+  XDCHECK(it != entries_.end());
+  if (--it->second.refCount == 0) {
+    stringMemoryUsage_ -= estimateIndirectMemoryUsage(it->first);
+    strings_[id] = nullptr;
+    freeIds_.push_back(id);
+    entries_.erase(it);
+  }
+}
+
+CompactFileChangeJournalDelta::CompactFileChangeJournalDelta(
+    FileChangeJournalDelta&& delta,
+    JournalPathTable& paths)
+    : JournalDelta{delta},
+      path1{
+          delta.isPath1Valid ? paths.intern(delta.path1)
+                             : JournalPathTable::Path{}},
+      path2{
+          delta.isPath2Valid ? paths.intern(delta.path2)
+                             : JournalPathTable::Path{}},
+      info1{delta.info1},
+      info2{delta.info2},
+      isPath1Valid{delta.isPath1Valid},
+      isPath2Valid{delta.isPath2Valid} {}
+
+void CompactFileChangeJournalDelta::release(JournalPathTable& paths) {
+  if (isPath1Valid) {
+    paths.release(path1);
+  }
+  if (isPath2Valid) {
+    paths.release(path2);
+  }
+}
+
 std::unordered_map<RelativePath, PathChangeInfo>
-FileChangeJournalDelta::getChangedFilesInOverlay() const {
+CompactFileChangeJournalDelta::getChangedFilesInOverlay(
+    const JournalPathTable& paths) const {
   std::unordered_map<RelativePath, PathChangeInfo> changedFilesInOverlay;
   if (isPath1Valid) {
-    changedFilesInOverlay[path1] = info1;
+    changedFilesInOverlay[paths.lookup(path1)] = info1;
   }
   if (isPath2Valid) {
-    changedFilesInOverlay[path2] = info2;
+    changedFilesInOverlay[paths.lookup(path2)] = info2;
   }
   return changedFilesInOverlay;
 }
 
-bool FileChangeJournalDelta::isModification() const {
+bool CompactFileChangeJournalDelta::isModification() const {
   return isPath1Valid && !isPath2Valid && info1.existedBefore &&
       info1.existedAfter;
 }
 
-bool FileChangeJournalDelta::isSameAction(
-    const FileChangeJournalDelta& other) const {
+bool CompactFileChangeJournalDelta::isSameAction(
+    const CompactFileChangeJournalDelta& other) const {
+  // Interned in the same table, equal paths have equal ids.
   return isPath1Valid == other.isPath1Valid && info1 == other.info1 &&
-      path1 == other.path1 && isPath2Valid == other.isPath2Valid &&
-      info2 == other.info2 && path2 == other.path2;
+      (!isPath1Valid || path1 == other.path1) &&
+      isPath2Valid == other.isPath2Valid && info2 == other.info2 &&
+      (!isPath2Valid || path2 == other.path2);
 }
 
 JournalDeltaPtr::JournalDeltaPtr(std::nullptr_t) {}
 
-JournalDeltaPtr::JournalDeltaPtr(FileChangeJournalDelta* p) : data_{p} {
+JournalDeltaPtr::JournalDeltaPtr(CompactFileChangeJournalDelta* p)
+    : data_{p} {
   XCHECK(p);
 }
 
@@ -155,11 +239,12 @@ const JournalDelta* JournalDeltaPtr::operator->() const noexcept {
       data_);
 }
 
-FileChangeJournalDelta* JournalDeltaPtr::getAsFileChangeJournalDelta() {
+CompactFileChangeJournalDelta* JournalDeltaPtr::getAsFileChangeJournalDelta() {
   return std::visit(
-      [](auto delta) -> FileChangeJournalDelta* {
-        if constexpr (std::
-                          is_same_v<decltype(delta), FileChangeJournalDelta*>) {
+      [](auto delta) -> CompactFileChangeJournalDelta* {
+        if constexpr (std::is_same_v<
+                          decltype(delta),
+                          CompactFileChangeJournalDelta*>) {
           return delta;
         } else {
           return nullptr;
@@ -7,10 +7,13 @@
 
 #pragma once
 
+#include <folly/container/F14Map.h>
 #include <chrono>
+#include <string>
 #include <type_traits>
 #include <unordered_set>
 #include <variant>
+#include <vector>
 #include "eden/fs/model/RootId.h"
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -102,19 +105,119 @@ class FileChangeJournalDelta : public JournalDelta {
   PathChangeInfo info2;
   bool isPath1Valid = false;
   bool isPath2Valid = false;
+};
+
+/**
+ * The paths of the file changes stored in the Journal.
+ *
+ * A path is stored as the ids of its parent directory and of its basename,
+ * each distinct directory and basename being stored once however many deltas
+ * refer to it. The ids are reference counted and reused once no delta refers
+ * to them anymore.
+ */
+class JournalPathTable {
+ public:
+  using Id = uint32_t;
+
+  struct Path {
+    Id dir;
+    Id name;
+
+    bool operator==(const Path& other) const {
+      return dir == other.dir && name == other.name;
+    }
+  };
+
+  JournalPathTable() = default;
+  JournalPathTable(const JournalPathTable&) = delete;
+  JournalPathTable& operator=(const JournalPathTable&) = delete;
+
+  /** Adds a reference to the directory and basename of path. */
+  Path intern(RelativePathPiece path);
 
-  std::unordered_map<RelativePath, PathChangeInfo> getChangedFilesInOverlay()
-      const;
+  /** Removes the references added by intern. */
+  void release(Path path);
+
+  RelativePath lookup(Path path) const;
+
+  /**
+   * The first component of path: its top-level directory, or the file itself
+   * for the files at the root.
+   */
+  PathComponentPiece getTopLevelName(Path path) const;
+
+  /** Forgets all the paths, invalidating all the interned ones. */
+  void clear();
+
+  /** Number of distinct directories and basenames stored. */
+  size_t size() const {
+    return entries_.size();
+  }
+
+  /** Get memory used (in bytes) by the stored paths */
+  size_t estimateMemoryUsage() const;
+
+ private:
+  struct Entry {
+    Id id;
+    uint32_t refCount;
+  };
+
+  Id internString(std::string_view value);
+  void releaseString(Id id);
+
+  folly::F14NodeMap<std::string, Entry> entries_;
+  /** The key in entries_ of each id, nullptr for the unused ids. */
+  std::vector<const std::string*> strings_;
+  std::vector<Id> freeIds_;
+  /** Memory used by the keys of entries_ that aren't stored inline. */
+  size_t stringMemoryUsage_ = 0;
+};
+
+/**
+ * A FileChangeJournalDelta as stored in the Journal, with its paths interned
+ * in the Journal's JournalPathTable. Not owning any memory, these are packed
+ * in the Journal's deque.
+ */
+class CompactFileChangeJournalDelta : public JournalDelta {
+ public:
+  CompactFileChangeJournalDelta(
+      FileChangeJournalDelta&& delta,
+      JournalPathTable& paths);
+  CompactFileChangeJournalDelta(CompactFileChangeJournalDelta&&) = default;
+  CompactFileChangeJournalDelta& operator=(CompactFileChangeJournalDelta&&) =
+      default;
+  CompactFileChangeJournalDelta(const CompactFileChangeJournalDelta&) = delete;
+  CompactFileChangeJournalDelta& operator=(
+      const CompactFileChangeJournalDelta&) = delete;
+
+  JournalPathTable::Path path1;
+  JournalPathTable::Path path2;
+  PathChangeInfo info1;
+  PathChangeInfo info2;
+  bool isPath1Valid = false;
+  bool isPath2Valid = false;
+
+  /** Removes the references of this delta to its paths. */
+  void release(JournalPathTable& paths);
+
+  std::unordered_map<RelativePath, PathChangeInfo> getChangedFilesInOverlay(
+      const JournalPathTable& paths) const;
 
   /** Checks whether this delta is a modification */
   bool isModification() const;
 
   /** Checks whether this delta and other are the same disregarding time and
    * sequenceID [whether they do the same action] */
-  bool isSameAction(const FileChangeJournalDelta& other) const;
+  bool isSameAction(const CompactFileChangeJournalDelta& other) const;
 
-  /** Get memory used (in bytes) by this Delta */
-  size_t estimateMemoryUsage() const;
+  /**
+   * Get memory used (in bytes) by this Delta, its paths being accounted for
+   * by the JournalPathTable.
+   */
+  size_t estimateMemoryUsage() const {
+    return sizeof(CompactFileChangeJournalDelta);
+  }
 };
 
 /** A delta that stores information about changing commits */
@@ -145,7 +248,7 @@ class JournalDeltaPtr {
  public:
   /* implicit */ JournalDeltaPtr(std::nullptr_t);
 
-  /* implicit */ JournalDeltaPtr(FileChangeJournalDelta* p);
+  /* implicit */ JournalDeltaPtr(CompactFileChangeJournalDelta* p);
 
   /* implicit */ JournalDeltaPtr(RootUpdateJournalDelta* p);
 
@@ -155,15 +258,18 @@ class JournalDeltaPtr {
     return !std::holds_alternative<std::monostate>(data_);
   }
 
-  /** If this JournalDeltaPtr points to a FileChangeJournalDelta then returns
-   * the raw pointer, if it does not point to a FileChangeJournalDelta then
-   * return nullptr. */
-  FileChangeJournalDelta* getAsFileChangeJournalDelta();
+  /** If this JournalDeltaPtr points to a CompactFileChangeJournalDelta then
+   * returns the raw pointer, if it does not point to a
+   * CompactFileChangeJournalDelta then return nullptr. */
+  CompactFileChangeJournalDelta* getAsFileChangeJournalDelta();
 
   const JournalDelta* operator->() const noexcept;
 
  private:
-  std::variant<std::monostate, FileChangeJournalDelta*, RootUpdateJournalDelta*>
+  std::variant<
+      std::monostate,
+      CompactFileChangeJournalDelta*,
+      RootUpdateJournalDelta*>
       data_;
 };
 
@@ -0,0 +1,410 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/journal/JournalSegment.h"
+
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/Utility.h>
+#include <folly/hash/Checksum.h>
+#include <folly/logging/xlog.h>
+#include <folly/portability/Fcntl.h>
+#include <folly/portability/SysMman.h>
+#include <folly/portability/SysStat.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <optional>
+#include <string_view>
+
+namespace facebook::eden {
+
+namespace {
+constexpr uint64_t kMagic = 0x4544454e4a524e4c; // "EDENJRNL"
+constexpr uint32_t kVersion = 1;
+
+constexpr size_t kRecordAlignment = 8;
+
+struct RecordHeader {
+  uint32_t checksum;
+  uint32_t length;
+  uint64_t sequence;
+  uint8_t type;
+  uint8_t info;
+  uint16_t reserved;
+  uint32_t reserved2;
+};
+
+// The bits of RecordHeader::info for file changes.
+constexpr uint8_t kPath1Valid = 1 << 0;
+constexpr uint8_t kPath1ExistedBefore = 1 << 1;
+constexpr uint8_t kPath1ExistedAfter = 1 << 2;
+constexpr uint8_t kPath2Valid = 1 << 3;
+constexpr uint8_t kPath2ExistedBefore = 1 << 4;
+constexpr uint8_t kPath2ExistedAfter = 1 << 5;
+
+size_t alignRecordLength(size_t length) {
+  return (length + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+}
+
+uint32_t recordChecksum(const RecordHeader& header, folly::ByteRange payload) {
+  auto checksum = folly::crc32c(
+      reinterpret_cast<const uint8_t*>(&header.length),
+      sizeof(RecordHeader) - sizeof(header.checksum));
+  return folly::crc32c(payload.data(), payload.size(), checksum);
+}
+
+void appendString(std::string& payload, std::string_view str) {
+  uint32_t length = folly::to_narrow(str.size());
+  payload.append(reinterpret_cast<const char*>(&length), sizeof(length));
+  payload.append(str.data(), str.size());
+}
+
+/**
+ * Reads back the strings written by appendString, failing on the first one
+ * that overruns the payload.
+ */
+class PayloadReader {
+ public:
+  explicit PayloadReader(folly::ByteRange payload) : payload_{payload} {}
+
+  bool empty() const {
+    return payload_.empty();
+  }
+
+  std::optional<std::string_view> readString() {
+    uint32_t length;
+    if (payload_.size() < sizeof(length)) {
+      return std::nullopt;
+    }
+    memcpy(&length, payload_.data(), sizeof(length));
+    payload_.advance(sizeof(length));
+    if (payload_.size() < length) {
+      return std::nullopt;
+    }
+    std::string_view str{
+        reinterpret_cast<const char*>(payload_.data()), length};
+    payload_.advance(length);
+    return str;
+  }
+
+ private:
+  folly::ByteRange payload_;
+};
+} // namespace
+
+enum class JournalSegment::RecordType : uint8_t {
+  /** The sequence number and root the following records start from. */
+  Start = 1,
+  FileChange = 2,
+  RootUpdate = 3,
+};
+
+struct JournalSegment::Header {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t dataCapacity;
+  uint64_t dataUsed;
+  uint64_t mountGeneration;
+};
+
+std::unique_ptr<JournalSegment> JournalSegment::open(
+    AbsolutePathPiece path,
+    size_t capacityBytes) {
+  folly::File file{path.copy().c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644};
+  auto fileSize = sizeof(Header) + capacityBytes;
+
+  struct stat st;
+  folly::checkUnixError(fstat(file.fd(), &st), "fstat failed");
+  if (static_cast<size_t>(st.st_size) != fileSize) {
+    // Either a new file, or one created with a different capacity: start over.
+    folly::checkUnixError(
+        folly::ftruncateNoInt(file.fd(), 0), "failed to truncate journal");
+    folly::checkUnixError(
+        folly::ftruncateNoInt(file.fd(), fileSize), "failed to resize journal");
+  }
+
+  return std::unique_ptr<JournalSegment>{
+      new JournalSegment{std::move(file), capacityBytes}};
+}
+
+JournalSegment::JournalSegment(folly::File file, size_t capacityBytes)
+    : capacityBytes_{capacityBytes},
+      mapping_{
+          std::move(file),
+          0,
+          static_cast<off_t>(sizeof(Header) + capacityBytes_),
+          folly::MemoryMapping::writable()} {
+  auto& hdr = header();
+  if (hdr.magic != kMagic || hdr.version != kVersion ||
+      hdr.dataCapacity != capacityBytes_ || hdr.dataUsed > capacityBytes_) {
+    XLOG(DBG2) << "Initializing journal segment";
+    // Zero the whole file, as it may hold records of another format.
+    hdr.magic = 0;
+    memset(data(), 0, capacityBytes_);
+    hdr.version = kVersion;
+    hdr.reserved = 0;
+    hdr.dataCapacity = capacityBytes_;
+    hdr.dataUsed = 0;
+    hdr.mountGeneration = 0;
+    hdr.magic = kMagic;
+  }
+}
+
+JournalSegment::~JournalSegment() {
+  flush();
+}
+
+JournalSegment::Header& JournalSegment::header() const {
+  return *reinterpret_cast<Header*>(mapping_.writableRange().data());
+}
+
+uint8_t* JournalSegment::data() const {
+  return mapping_.writableRange().data() + sizeof(Header);
+}
+
+uint64_t JournalSegment::getMountGeneration() const {
+  return header().mountGeneration;
+}
+
+void JournalSegment::setMountGeneration(uint64_t mountGeneration) {
+  header().mountGeneration = mountGeneration;
+}
+
+bool JournalSegment::replay(
+    folly::FunctionRef<void(SequenceNumber nextSequence, RootId root)> onStart,
+    folly::FunctionRef<void(FileChangeJournalDelta&& delta)> onFileChange,
+    folly::FunctionRef<void(RootUpdateJournalDelta&& delta, RootId toHash)>
+        onRootUpdate) {
+  auto& hdr = header();
+  size_t offset = 0;
+  bool started = false;
+  while (offset + sizeof(RecordHeader) <= capacityBytes_) {
+    RecordHeader record;
+    memcpy(&record, data() + offset, sizeof(RecordHeader));
+    if (record.length > capacityBytes_ - offset - sizeof(RecordHeader)) {
+      break;
+    }
+    folly::ByteRange payload{
+        data() + offset + sizeof(RecordHeader), record.length};
+    if (recordChecksum(record, payload) != record.checksum) {
+      break;
+    }
+    auto type = static_cast<RecordType>(record.type);
+    if (started ? record.sequence < nextSequence_ || type == RecordType::Start
+                : type != RecordType::Start) {
+      break;
+    }
+
+    PayloadReader reader{payload};
+    try {
+      if (type == RecordType::Start) {
+        auto root = reader.readString();
+        if (!root) {
+          break;
+        }
+        onStart(record.sequence, RootId{std::string{*root}});
+        nextSequence_ = record.sequence;
+        started = true;
+      } else if (type == RecordType::FileChange) {
+        FileChangeJournalDelta delta;
+        auto path1 = reader.readString();
+        auto path2 = reader.readString();
+        if (!path1 || !path2) {
+          break;
+        }
+        delta.sequenceID = record.sequence;
+        delta.isPath1Valid = record.info & kPath1Valid;
+        delta.isPath2Valid = record.info & kPath2Valid;
+        if (delta.isPath1Valid) {
+          delta.path1 = RelativePath{*path1};
+        }
+        if (delta.isPath2Valid) {
+          delta.path2 = RelativePath{*path2};
+        }
+        delta.info1 = PathChangeInfo{
+            (record.info & kPath1ExistedBefore) != 0,
+            (record.info & kPath1ExistedAfter) != 0};
+        delta.info2 = PathChangeInfo{
+            (record.info & kPath2ExistedBefore) != 0,
+            (record.info & kPath2ExistedAfter) != 0};
+        onFileChange(std::move(delta));
+        nextSequence_ = record.sequence + 1;
+      } else if (type == RecordType::RootUpdate) {
+        RootUpdateJournalDelta delta;
+        auto fromHash = reader.readString();
+        auto toHash = reader.readString();
+        if (!fromHash || !toHash) {
+          break;
+        }
+        delta.sequenceID = record.sequence;
+        delta.fromHash = RootId{std::string{*fromHash}};
+        while (!reader.empty()) {
+          auto path = reader.readString();
+          if (!path) {
+            break;
+          }
+          delta.uncleanPaths.emplace(*path);
+        }
+        onRootUpdate(std::move(delta), RootId{std::string{*toHash}});
+        nextSequence_ = record.sequence + 1;
+      } else {
+        break;
+      }
+    } catch (const std::exception& ex) {
+      XLOG(WARN) << "invalid record in journal segment: "
+                 << folly::exceptionStr(ex);
+      break;
+    }
+    offset = std::min(
+        offset + alignRecordLength(sizeof(RecordHeader) + record.length),
+        capacityBytes_);
+  }
+
+  if (!started) {
+    return false;
+  }
+  // The bytes after the last record are zeroed by reset, so anything else
+  // there is a record that was being written when EdenFS or the system
+  // crashed.
+  bool torn = hdr.dataUsed > offset;
+  auto tailLength = std::min(sizeof(RecordHeader), capacityBytes_ - offset);
+  for (size_t i = 0; i < tailLength && !torn; ++i) {
+    torn = data()[offset + i] != 0;
+  }
+  if (torn) {
+    // Where the torn record ends isn't known, so the reset zeroes it all.
+    hdr.dataUsed = capacityBytes_;
+    return false;
+  }
+  hdr.dataUsed = offset;
+  return true;
+}
+
+void JournalSegment::reset(SequenceNumber nextSequence, const RootId& root) {
+  auto& hdr = header();
+  memset(data(), 0, hdr.dataUsed);
+  hdr.dataUsed = 0;
+
+  std::string payload;
+  appendString(payload, root.value());
+  writeRecord(RecordType::Start, 0, nextSequence, payload);
+  nextSequence_ = nextSequence;
+}
+
+void JournalSegment::append(
+    const FileChangeJournalDelta& delta,
+    const RootId& currentRoot) {
+  std::string payload;
+  appendString(payload, delta.isPath1Valid ? delta.path1.view() : "");
+  appendString(payload, delta.isPath2Valid ? delta.path2.view() : "");
+
+  uint8_t info = 0;
+  info |= delta.isPath1Valid ? kPath1Valid : 0;
+  info |= delta.info1.existedBefore ? kPath1ExistedBefore : 0;
+  info |= delta.info1.existedAfter ? kPath1ExistedAfter : 0;
+  info |= delta.isPath2Valid ? kPath2Valid : 0;
+  info |= delta.info2.existedBefore ? kPath2ExistedBefore : 0;
+  info |= delta.info2.existedAfter ? kPath2ExistedAfter : 0;
+
+  if (!appendRecord(
+          RecordType::FileChange,
+          info,
+          delta.sequenceID,
+          payload,
+          currentRoot)) {
+    reset(delta.sequenceID + 1, currentRoot);
+  }
+}
+
+void JournalSegment::append(
+    const RootUpdateJournalDelta& delta,
+    const RootId& toHash) {
+  std::string payload;
+  appendString(payload, delta.fromHash.value());
+  appendString(payload, toHash.value());
+  for (const auto& path : delta.uncleanPaths) {
+    appendString(payload, path.view());
+  }
+
+  if (!appendRecord(
+          RecordType::RootUpdate,
+          0,
+          delta.sequenceID,
+          payload,
+          delta.fromHash)) {
+    reset(delta.sequenceID + 1, toHash);
+  }
+}
+
+bool JournalSegment::appendRecord(
+    RecordType type,
+    uint8_t info,
+    SequenceNumber sequence,
+    const std::string& payload,
+    const RootId& resetRoot) {
+  // The Start record of a reset segment takes some room too.
+  auto recordLength = alignRecordLength(sizeof(RecordHeader) + payload.size());
+  auto startLength = alignRecordLength(
+      sizeof(RecordHeader) + sizeof(uint32_t) + resetRoot.value().size());
+  if (payload.size() > std::numeric_limits<uint32_t>::max() ||
+      recordLength + startLength > capacityBytes_) {
+    return false;
+  }
+
+  if (header().dataUsed + recordLength > capacityBytes_) {
+    XLOG(DBG2) << "journal segment is full, resetting it";
+    reset(sequence, resetRoot);
+  }
+  writeRecord(type, info, sequence, payload);
+  nextSequence_ = sequence + 1;
+  return true;
+}
+
+void JournalSegment::writeRecord(
+    RecordType type,
+    uint8_t info,
+    SequenceNumber sequence,
+    const std::string& payload) {
+  auto& hdr = header();
+  auto recordLength = alignRecordLength(sizeof(RecordHeader) + payload.size());
+  if (hdr.dataUsed + recordLength > capacityBytes_) {
+    return;
+  }
+
+  RecordHeader record;
+  record.length = folly::to_narrow(payload.size());
+  record.sequence = sequence;
+  record.type = folly::to_underlying(type);
+  record.info = info;
+  record.reserved = 0;
+  record.reserved2 = 0;
+  folly::ByteRange payloadBytes{folly::StringPiece{payload}};
+  record.checksum = recordChecksum(record, payloadBytes);
+
+  auto* out = data() + hdr.dataUsed;
+  memcpy(out, &record, sizeof(RecordHeader));
+  memcpy(out + sizeof(RecordHeader), payload.data(), payload.size());
+  hdr.dataUsed += recordLength;
+}
+
+void JournalSegment::flush() {
+#ifndef _WIN32
+  auto range = mapping_.writableRange();
+  if (range.empty()) {
+    return;
+  }
+  if (msync(range.data(), range.size(), MS_ASYNC) != 0) {
+    XLOG(WARN) << "failed to flush journal segment: "
+               << folly::errnoStr(errno);
+  }
+#endif
+}
+
+} // namespace facebook::eden
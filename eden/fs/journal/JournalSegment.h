@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <folly/Function.h>
+#include <folly/system/MemoryMapping.h>
+#include <memory>
+
+#include "eden/fs/journal/JournalDelta.h"
+#include "eden/fs/model/RootId.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * A bounded, memory-mapped file where a Journal appends its deltas, so that
+ * they can be restored after EdenFS restarts.
+ *
+ * The file is made of a fixed header, holding the mount generation the
+ * sequence numbers belong to, followed by checksummed records. The first
+ * record holds the sequence number and root the others follow from, and each
+ * of the others holds one delta. When the file is full it is reset to a new
+ * first record, forgetting the older deltas.
+ *
+ * The mapping is shared, so records written by this process survive it
+ * crashing. Records are checksummed and their sequence numbers increase, so
+ * torn writes after a system crash end the replay instead of being restored.
+ *
+ * This class is not thread-safe: the Journal only uses it with its lock held.
+ */
+class JournalSegment {
+ public:
+  using SequenceNumber = JournalDelta::SequenceNumber;
+
+  /**
+   * Open the segment stored at `path`, creating it if needed, with room for
+   * `capacityBytes` of records. A file created with a different capacity or
+   * an incompatible format is reset.
+   */
+  static std::unique_ptr<JournalSegment> open(
+      AbsolutePathPiece path,
+      size_t capacityBytes);
+
+  ~JournalSegment();
+
+  JournalSegment(const JournalSegment&) = delete;
+  JournalSegment& operator=(const JournalSegment&) = delete;
+
+  /**
+   * The generation of the mount the recorded sequence numbers belong to, or
+   * 0 if none was set.
+   */
+  uint64_t getMountGeneration() const;
+  void setMountGeneration(uint64_t mountGeneration);
+
+  /**
+   * Calls the callbacks with the content of the records, oldest first, and
+   * positions the segment to append after the last valid one.
+   *
+   * Returns false if the segment holds no first record, or if the records
+   * end with a torn one, in which case some of the deltas could be missing.
+   * The segment must then be reset before appending.
+   */
+  bool replay(
+      folly::FunctionRef<void(SequenceNumber nextSequence, RootId root)>
+          onStart,
+      folly::FunctionRef<void(FileChangeJournalDelta&& delta)> onFileChange,
+      folly::FunctionRef<void(RootUpdateJournalDelta&& delta, RootId toHash)>
+          onRootUpdate);
+
+  /**
+   * Forget all the records, the next deltas following from `nextSequence`
+   * and `root`.
+   */
+  void reset(SequenceNumber nextSequence, const RootId& root);
+
+  /**
+   * Append a delta, recorded while the root was `currentRoot`. The segment
+   * is reset first if the delta doesn't fit.
+   */
+  void append(const FileChangeJournalDelta& delta, const RootId& currentRoot);
+
+  /** Append a delta moving the root from delta.fromHash to `toHash`. */
+  void append(const RootUpdateJournalDelta& delta, const RootId& toHash);
+
+  /**
+   * Ask the kernel to write back dirty pages of the mapping.
+   */
+  void flush();
+
+ private:
+  struct Header;
+  enum class RecordType : uint8_t;
+
+  JournalSegment(folly::File file, size_t capacityBytes);
+
+  Header& header() const;
+  uint8_t* data() const;
+
+  /**
+   * Write a record, resetting the segment first if it doesn't fit. Returns
+   * false if the record doesn't fit in an empty segment either.
+   */
+  bool appendRecord(
+      RecordType type,
+      uint8_t info,
+      SequenceNumber sequence,
+      const std::string& payload,
+      const RootId& resetRoot);
+
+  void writeRecord(
+      RecordType type,
+      uint8_t info,
+      SequenceNumber sequence,
+      const std::string& payload);
+
+  const size_t capacityBytes_;
+  folly::MemoryMapping mapping_;
+  /** The smallest sequence number the next record can have. */
+  SequenceNumber nextSequence_{0};
+};
+
+} // namespace facebook::eden
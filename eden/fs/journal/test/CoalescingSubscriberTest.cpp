@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/journal/CoalescingSubscriber.h"
+
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+#include <thread>
+
+#include "eden/fs/telemetry/EdenStats.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+class CoalescingSubscriberTest : public ::testing::Test {
+ protected:
+  ~CoalescingSubscriberTest() override {
+    // Destroy the subscribers before the executor, as EdenFS does.
+    journal_.cancelAllSubscribers();
+    executor_.join();
+  }
+
+  Journal::SubscriberId subscribe(std::chrono::nanoseconds interval) {
+    return CoalescingSubscriber::subscribe(
+        journal_, folly::getKeepAliveToken(executor_), interval, [this] {
+          callingThread_ = std::this_thread::get_id();
+          if (++calls_ == 2) {
+            secondCall_.post();
+          }
+        });
+  }
+
+  /**
+   * The Journal only notifies its subscribers of the first change they didn't
+   * observe, so observe the journal first, like a subscriber catching up.
+   */
+  void recordChange() {
+    journal_.getLatest();
+    journal_.recordChanged("file"_relpath);
+  }
+
+  folly::CPUThreadPoolExecutor executor_{1};
+  Journal journal_{std::make_shared<EdenStats>()};
+  std::atomic<size_t> calls_{0};
+  std::atomic<std::thread::id> callingThread_;
+  folly::Baton<> secondCall_;
+};
+
+} // namespace
+
+TEST_F(CoalescingSubscriberTest, bursts_are_coalesced) {
+  subscribe(100ms);
+  for (int i = 0; i < 100; ++i) {
+    recordChange();
+  }
+
+  // The first change is delivered right away, and the others once the
+  // interval ends.
+  ASSERT_TRUE(secondCall_.try_wait_for(10s));
+  std::this_thread::sleep_for(300ms);
+  EXPECT_EQ(2, calls_.load());
+  EXPECT_NE(std::this_thread::get_id(), callingThread_.load());
+
+  // Once idle, the next change is delivered again.
+  recordChange();
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(3, calls_.load());
+}
+
+TEST_F(CoalescingSubscriberTest, cancelled_subscribers_are_not_called) {
+  auto id = subscribe(100ms);
+  recordChange();
+  recordChange();
+  journal_.cancelSubscriber(id);
+
+  std::this_thread::sleep_for(300ms);
+  EXPECT_GE(1, calls_.load());
+}
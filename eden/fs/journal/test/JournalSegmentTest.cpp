@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/journal/JournalSegment.h"
+
+#include <fmt/format.h>
+#include <folly/FileUtil.h>
+#include <folly/portability/GTest.h>
+#include <folly/testing/TestUtil.h>
+
+#include "eden/fs/journal/Journal.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+namespace {
+
+constexpr size_t kCapacity = 64 * 1024;
+constexpr uint64_t kMountGeneration = 42;
+
+class JournalSegmentTest : public ::testing::Test {
+ protected:
+  AbsolutePath getSegmentPath() const {
+    return canonicalPath(tempDir_.path().string()) + "journal"_pc;
+  }
+
+  std::unique_ptr<Journal> openJournal(
+      const std::optional<RootId>& expectedRoot,
+      size_t capacity = kCapacity) {
+    auto journal = std::make_unique<Journal>(std::make_shared<EdenStats>());
+    journal->persistTo(getSegmentPath(), capacity, expectedRoot);
+    journal->setMountGeneration(kMountGeneration);
+    return journal;
+  }
+
+  /** Runs until the restart, leaving the journal on root "a". */
+  void recordChanges() {
+    auto journal = openJournal(RootId{"a"});
+    EXPECT_EQ(std::nullopt, journal->getRestoredMountGeneration());
+    journal->recordHashUpdate(RootId{"a"});
+    journal->recordCreated("created"_relpath);
+    journal->recordRenamed("created"_relpath, "renamed"_relpath);
+  }
+
+  folly::test::TemporaryDirectory tempDir_;
+};
+
+} // namespace
+
+TEST_F(JournalSegmentTest, deltas_are_restored_after_a_restart) {
+  recordChanges();
+
+  auto journal = openJournal(RootId{"a"});
+  EXPECT_EQ(kMountGeneration, journal->getRestoredMountGeneration());
+  auto latest = journal->getLatest();
+  ASSERT_TRUE(latest);
+  EXPECT_EQ(3, latest->sequenceID);
+  EXPECT_EQ(RootId{"a"}, latest->toHash);
+
+  auto range = journal->accumulateRange(2);
+  ASSERT_TRUE(range);
+  EXPECT_FALSE(range->isTruncated);
+  EXPECT_EQ(2, range->fromSequence);
+  EXPECT_EQ(3, range->toSequence);
+  EXPECT_EQ(
+      PathChangeInfo(false, false),
+      range->changedFilesInOverlay["created"_relpath]);
+  EXPECT_EQ(
+      PathChangeInfo(false, true),
+      range->changedFilesInOverlay["renamed"_relpath]);
+
+  // The sequence numbers carry on from the restored ones.
+  journal->recordChanged("renamed"_relpath);
+  EXPECT_EQ(4, journal->getLatest()->sequenceID);
+}
+
+TEST_F(JournalSegmentTest, deltas_ending_on_another_root_are_not_restored) {
+  recordChanges();
+
+  auto journal = openJournal(RootId{"b"});
+  EXPECT_EQ(std::nullopt, journal->getRestoredMountGeneration());
+  EXPECT_EQ(std::nullopt, journal->getLatest());
+}
+
+TEST_F(JournalSegmentTest, deltas_are_not_restored_without_a_root) {
+  recordChanges();
+
+  auto journal = openJournal(std::nullopt);
+  EXPECT_EQ(std::nullopt, journal->getRestoredMountGeneration());
+  EXPECT_EQ(std::nullopt, journal->getLatest());
+}
+
+TEST_F(JournalSegmentTest, torn_deltas_are_not_restored) {
+  recordChanges();
+
+  // Corrupt the last path recorded.
+  std::string contents;
+  ASSERT_TRUE(folly::readFile(getSegmentPath().c_str(), contents));
+  auto pos = contents.rfind("renamed");
+  ASSERT_NE(std::string::npos, pos);
+  contents[pos] = 'R';
+  ASSERT_TRUE(folly::writeFile(contents, getSegmentPath().c_str()));
+
+  auto journal = openJournal(RootId{"a"});
+  EXPECT_EQ(std::nullopt, journal->getRestoredMountGeneration());
+  EXPECT_EQ(std::nullopt, journal->getLatest());
+
+  // The reset segment is usable again.
+  journal->recordHashUpdate(RootId{"a"});
+  journal.reset();
+  journal = openJournal(RootId{"a"});
+  EXPECT_EQ(kMountGeneration, journal->getRestoredMountGeneration());
+  EXPECT_EQ(1, journal->getLatest()->sequenceID);
+}
+
+TEST_F(JournalSegmentTest, full_segment_forgets_the_oldest_deltas) {
+  {
+    auto journal = openJournal(RootId{"a"}, 1024);
+    journal->recordHashUpdate(RootId{"a"});
+    for (int i = 0; i < 100; ++i) {
+      journal->recordCreated(RelativePath{fmt::format("file{}", i)});
+    }
+  }
+
+  auto journal = openJournal(RootId{"a"}, 1024);
+  EXPECT_EQ(kMountGeneration, journal->getRestoredMountGeneration());
+  EXPECT_EQ(101, journal->getLatest()->sequenceID);
+  EXPECT_TRUE(journal->accumulateRange(1)->isTruncated);
+
+  auto range = journal->accumulateRange(101);
+  ASSERT_TRUE(range);
+  EXPECT_FALSE(range->isTruncated);
+  EXPECT_TRUE(range->changedFilesInOverlay.count("file99"_relpath));
+}
+
+TEST_F(JournalSegmentTest, flush_is_persisted) {
+  {
+    auto journal = openJournal(RootId{"a"});
+    journal->recordHashUpdate(RootId{"a"});
+    journal->recordCreated("created"_relpath);
+    journal->flush();
+  }
+
+  auto journal = openJournal(RootId{"a"});
+  EXPECT_EQ(kMountGeneration, journal->getRestoredMountGeneration());
+  EXPECT_TRUE(journal->accumulateRange(2)->isTruncated);
+  auto latest = journal->getLatest();
+  ASSERT_TRUE(latest);
+  EXPECT_EQ(4, latest->sequenceID);
+  EXPECT_EQ(RootId{"a"}, latest->toHash);
+}
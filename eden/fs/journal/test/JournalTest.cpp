@@ -7,8 +7,11 @@
 
 #include "eden/fs/journal/Journal.h"
 
+#include <fmt/format.h>
 #include <folly/portability/GMock.h>
 #include <folly/portability/GTest.h>
+#include <atomic>
+#include <thread>
 
 #include "eden/fs/model/RootId.h"
 
@@ -657,3 +660,148 @@ TEST_F(JournalTest, all_subscribers_are_notified_after_any_observation) {
   EXPECT_EQ(2u, calls1);
   EXPECT_EQ(2u, calls2);
 }
+
+TEST_F(JournalTest, concurrently_recorded_changes_are_all_merged) {
+  constexpr size_t kThreads = 8;
+  constexpr size_t kChangesPerThread = 1000;
+  std::atomic<size_t> notifications{0};
+  journal.registerSubscriber([&] { ++notifications; });
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&, i] {
+      for (size_t j = 0; j < kChangesPerThread; ++j) {
+        journal.recordChanged(
+            RelativePath{fmt::format("thread{}/file{}", i, j)});
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // Every change got its own sequence number, and subscribers heard of them.
+  EXPECT_EQ(kThreads * kChangesPerThread, journal.getLatest()->sequenceID);
+  EXPECT_LE(1u, notifications.load());
+  auto summed = journal.accumulateRange();
+  ASSERT_NE(nullptr, summed);
+  EXPECT_EQ(1, summed->fromSequence);
+  EXPECT_EQ(kThreads * kChangesPerThread, summed->toSequence);
+  EXPECT_EQ(
+      kThreads * kChangesPerThread, summed->changedFilesInOverlay.size());
+}
+
+TEST_F(JournalTest, bytes_per_delta_stats) {
+  for (int i = 0; i < 100; i++) {
+    journal.recordCreated(RelativePath{fmt::format("some/dir/file{}", i)});
+  }
+  auto stats = journal.getStats();
+  ASSERT_TRUE(stats);
+  EXPECT_EQ(100, stats->entryCount);
+  EXPECT_EQ(journal.estimateMemoryUsage() / 100, stats->bytesPerDelta);
+}
+
+TEST_F(JournalTest, accumulate_range_under_a_prefix) {
+  journal.recordHashUpdate(RootId{"a"});
+  journal.recordCreated("src/main.cpp"_relpath);
+  journal.recordCreated("docs/README"_relpath);
+  journal.recordCreated("src2/main.cpp"_relpath);
+  journal.recordRenamed("src/main.cpp"_relpath, "docs/main.cpp"_relpath);
+  journal.recordCreated("src/lib/lib.cpp"_relpath);
+  journal.recordHashUpdate(RootId{"a"}, RootId{"b"});
+  journal.recordChanged("README"_relpath);
+
+  auto summed = journal.accumulateRange(2, "src"_relpath);
+  ASSERT_NE(nullptr, summed);
+  EXPECT_FALSE(summed->isTruncated);
+  // The range covers all the deltas, not only the matching ones.
+  EXPECT_EQ(2, summed->fromSequence);
+  EXPECT_EQ(8, summed->toSequence);
+  EXPECT_EQ(
+      (std::vector<RootId>{RootId{"a"}, RootId{"b"}}),
+      summed->snapshotTransitions);
+  EXPECT_EQ(2, summed->changedFilesInOverlay.size());
+  EXPECT_EQ(
+      PathChangeInfo(false, false),
+      summed->changedFilesInOverlay["src/main.cpp"_relpath]);
+  EXPECT_EQ(
+      PathChangeInfo(false, true),
+      summed->changedFilesInOverlay["src/lib/lib.cpp"_relpath]);
+
+  summed = journal.accumulateRange(5, "docs"_relpath);
+  ASSERT_NE(nullptr, summed);
+  EXPECT_EQ(5, summed->fromSequence);
+  EXPECT_EQ(1, summed->changedFilesInOverlay.size());
+  EXPECT_EQ(
+      PathChangeInfo(false, true),
+      summed->changedFilesInOverlay["docs/main.cpp"_relpath]);
+
+  summed = journal.accumulateRange(1, "README"_relpath);
+  ASSERT_NE(nullptr, summed);
+  EXPECT_EQ(1, summed->changedFilesInOverlay.size());
+  EXPECT_TRUE(summed->changedFilesInOverlay.count("README"_relpath));
+
+  summed = journal.accumulateRange(2, "missing"_relpath);
+  ASSERT_NE(nullptr, summed);
+  EXPECT_EQ(8, summed->toSequence);
+  EXPECT_TRUE(summed->changedFilesInOverlay.empty());
+
+  EXPECT_EQ(nullptr, journal.accumulateRange(9, "src"_relpath));
+}
+
+TEST_F(JournalTest, prefix_index_follows_compaction_and_truncation) {
+  journal.recordChanged("dir/file"_relpath);
+  journal.recordChanged("other/file"_relpath);
+  journal.recordChanged("other/file"_relpath);
+  // Compacted into sequence 3.
+  auto summed = journal.accumulateRange(3, "other"_relpath);
+  ASSERT_NE(nullptr, summed);
+  EXPECT_EQ(1, summed->changedFilesInOverlay.size());
+
+  journal.setMemoryLimit(0);
+  journal.recordChanged("dir/file"_relpath);
+  summed = journal.accumulateRange(4, "dir"_relpath);
+  ASSERT_NE(nullptr, summed);
+  EXPECT_FALSE(summed->isTruncated);
+  EXPECT_EQ(1, summed->changedFilesInOverlay.size());
+  EXPECT_TRUE(journal.accumulateRange(1, "dir"_relpath)->isTruncated);
+}
+
+TEST(JournalPathTableTest, paths_share_their_directory) {
+  JournalPathTable paths;
+  auto file1 = paths.intern("some/dir/file1"_relpath);
+  auto file2 = paths.intern("some/dir/file2"_relpath);
+  EXPECT_EQ(file1.dir, file2.dir);
+  EXPECT_NE(file1.name, file2.name);
+  EXPECT_EQ(3, paths.size());
+
+  EXPECT_EQ("some/dir/file1"_relpath, paths.lookup(file1));
+  EXPECT_EQ("some/dir/file2"_relpath, paths.lookup(file2));
+  EXPECT_TRUE(paths.intern("some/dir/file1"_relpath) == file1);
+}
+
+TEST(JournalPathTableTest, paths_at_the_root) {
+  JournalPathTable paths;
+  EXPECT_EQ("file"_relpath, paths.lookup(paths.intern("file"_relpath)));
+  EXPECT_EQ(""_relpath, paths.lookup(paths.intern(""_relpath)));
+}
+
+TEST(JournalPathTableTest, released_paths_are_forgotten) {
+  JournalPathTable paths;
+  auto file1 = paths.intern("dir/file1"_relpath);
+  auto file2 = paths.intern("dir/file2"_relpath);
+  auto emptyUsage = JournalPathTable{}.estimateMemoryUsage();
+  EXPECT_LT(emptyUsage, paths.estimateMemoryUsage());
+
+  paths.release(file1);
+  EXPECT_EQ(2, paths.size());
+  EXPECT_EQ("dir/file2"_relpath, paths.lookup(file2));
+
+  paths.release(file2);
+  EXPECT_EQ(0, paths.size());
+
+  // The ids are reused.
+  auto file3 = paths.intern("other/file3"_relpath);
+  EXPECT_EQ("other/file3"_relpath, paths.lookup(file3));
+  EXPECT_EQ(2, paths.size());
+}
@@ -19,12 +19,14 @@ class Blob {
   Blob(const ObjectId& hash, folly::IOBuf&& contents)
       : hash_{hash},
         contents_{std::move(contents)},
-        size_{contents_.computeChainDataLength()} {}
+        size_{contents_.computeChainDataLength()},
+        sizeBytes_{computeSizeBytes()} {}
 
   Blob(const ObjectId& hash, const folly::IOBuf& contents)
       : hash_{hash},
         contents_{contents},
-        size_{contents_.computeChainDataLength()} {}
+        size_{contents_.computeChainDataLength()},
+        sizeBytes_{computeSizeBytes()} {}
 
   /**
    * Convenience constructor for unit tests. Always copies the given
@@ -33,7 +35,8 @@ class Blob {
   Blob(const ObjectId& hash, folly::StringPiece contents)
       : hash_{hash},
         contents_{folly::IOBuf::COPY_BUFFER, contents.data(), contents.size()},
-        size_{contents.size()} {}
+        size_{contents.size()},
+        sizeBytes_{computeSizeBytes()} {}
 
   const ObjectId& getHash() const {
     return hash_;
@@ -53,14 +56,25 @@ class Blob {
     return size_;
   }
 
+  /**
+   * The memory held by this Blob, as accounted by the caches. Computed once,
+   * since whether its buffers are shared changes over its lifetime, and the
+   * caches must remove what they added.
+   */
   size_t getSizeBytes() const {
-    return size_;
+    return sizeBytes_;
   }
 
  private:
+  size_t computeSizeBytes() const {
+    return sizeof(*this) + hash_.getIndirectSizeBytes() +
+        estimateIndirectMemoryUsage(contents_);
+  }
+
   const ObjectId hash_;
   const folly::IOBuf contents_;
   const size_t size_;
+  const size_t sizeBytes_;
 };
 
 } // namespace facebook::eden
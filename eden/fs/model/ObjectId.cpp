@@ -35,15 +35,6 @@ std::string ObjectId::asString() const {
   return std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size());
 }
 
-size_t ObjectId::getHashCode() const noexcept {
-  if (bytes_.size() > sizeof(size_t) + 1) {
-    size_t ret;
-    memcpy(&ret, bytes_.data() + 1, sizeof(size_t));
-    return ret;
-  }
-  return std::hash<folly::fbstring>{}(bytes_);
-}
-
 ObjectId ObjectId::sha1(const folly::IOBuf& buf) {
   Hash20::Storage hashBytes;
   OpenSSLHash::sha1(range(hashBytes), buf);
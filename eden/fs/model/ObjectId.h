@@ -12,8 +12,11 @@
 #include <folly/Range.h>
 #include <stdint.h>
 #include <array>
+#include <cstring>
 #include <iosfwd>
 
+#include "eden/fs/utils/Memory.h"
+
 namespace folly {
 class IOBuf;
 }
@@ -80,6 +83,14 @@ class ObjectId {
     return bytes_.size();
   }
 
+  /**
+   * The heap memory used by the bytes of this ObjectId, which is none unless
+   * they are too large to be stored inline.
+   */
+  size_t getIndirectSizeBytes() const {
+    return estimateIndirectMemoryUsage(bytes_);
+  }
+
   /** @return [lowercase] hex representation of this ObjectId. */
   std::string toLogString() const {
     return asHexString();
@@ -107,8 +118,17 @@ class ObjectId {
    * [1,9].
    *
    * Smaller ObjectID will use `std::hash`.
+   *
+   * Inline, as every lookup in the maps keyed by ObjectId calls it.
    */
-  size_t getHashCode() const noexcept;
+  size_t getHashCode() const noexcept {
+    if (bytes_.size() > sizeof(size_t) + 1) {
+      size_t ret;
+      memcpy(&ret, bytes_.data() + 1, sizeof(size_t));
+      return ret;
+    }
+    return std::hash<folly::fbstring>{}(bytes_);
+  }
 
   /**
    * Returns true if the two ObjectIds are equal, compared byte-by-byte. If
@@ -0,0 +1,157 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/SerializedTree.h"
+
+#include <folly/logging/xlog.h>
+#include <cstring>
+
+#include "eden/fs/model/Tree.h"
+
+namespace facebook::eden {
+
+namespace {
+constexpr size_t kHeaderSize = 3 * sizeof(uint32_t);
+// type, followed by the hash length.
+constexpr size_t kNameLengthOffset = sizeof(uint8_t) + sizeof(uint16_t);
+
+template <typename T>
+T load(const void* data) {
+  T value;
+  memcpy(&value, data, sizeof(T));
+  return value;
+}
+} // namespace
+
+std::optional<SerializedTree> SerializedTree::tryParse(
+    folly::StringPiece data) {
+  if (data.size() < kHeaderSize) {
+    return std::nullopt;
+  }
+  auto version = load<uint32_t>(data.data());
+  if (version != kVersion) {
+    return std::nullopt;
+  }
+  auto entryCount = load<uint32_t>(data.data() + sizeof(uint32_t));
+  auto flags = load<uint32_t>(data.data() + 2 * sizeof(uint32_t));
+  data.advance(kHeaderSize);
+
+  if (data.size() / sizeof(uint32_t) < entryCount) {
+    XLOG(ERR) << "Can not read tree index of " << entryCount
+              << " entries, bytes remaining " << data.size();
+    return std::nullopt;
+  }
+  auto offsets = reinterpret_cast<const uint8_t*>(data.data());
+  data.advance(entryCount * sizeof(uint32_t));
+
+  return SerializedTree{
+      offsets,
+      data,
+      entryCount,
+      (flags & kCaseInsensitiveFlag) ? CaseSensitivity::Insensitive
+                                     : CaseSensitivity::Sensitive};
+}
+
+std::optional<folly::StringPiece> SerializedTree::getEntryData(
+    size_t index) const {
+  auto begin = load<uint32_t>(offsets_ + index * sizeof(uint32_t));
+  size_t end = index + 1 < entryCount_
+      ? load<uint32_t>(offsets_ + (index + 1) * sizeof(uint32_t))
+      : entries_.size();
+  if (begin > end || end > entries_.size()) {
+    XLOG(ERR) << "Corrupted tree index, entry " << index << " spans [" << begin
+              << ", " << end << ") of " << entries_.size() << " bytes";
+    return std::nullopt;
+  }
+  return entries_.subpiece(begin, end - begin);
+}
+
+std::optional<PathComponentPiece> SerializedTree::getName(size_t index) const {
+  auto data = getEntryData(index);
+  if (!data) {
+    return std::nullopt;
+  }
+  if (data->size() < kNameLengthOffset) {
+    return std::nullopt;
+  }
+  size_t nameOffset = kNameLengthOffset +
+      load<uint16_t>(data->data() + sizeof(uint8_t)) + sizeof(uint16_t);
+  if (data->size() < nameOffset) {
+    return std::nullopt;
+  }
+  auto nameLength =
+      load<uint16_t>(data->data() + nameOffset - sizeof(uint16_t));
+  if (data->size() - nameOffset < nameLength) {
+    return std::nullopt;
+  }
+  try {
+    return PathComponentPiece{
+        std::string_view{data->data() + nameOffset, nameLength}};
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "Corrupted tree entry name: " << ex.what();
+    return std::nullopt;
+  }
+}
+
+std::optional<std::pair<PathComponent, TreeEntry>> SerializedTree::getEntry(
+    size_t index) const {
+  auto data = getEntryData(index);
+  if (!data) {
+    return std::nullopt;
+  }
+  try {
+    auto entry = TreeEntry::deserialize(*data);
+    if (entry && !data->empty()) {
+      XLOG(ERR) << "Corrupted tree entry, extra bytes remaining "
+                << data->size();
+      return std::nullopt;
+    }
+    return entry;
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "Corrupted tree entry: " << ex.what();
+    return std::nullopt;
+  }
+}
+
+std::optional<std::pair<PathComponent, TreeEntry>> SerializedTree::find(
+    PathComponentPiece name) const {
+  size_t low = 0;
+  size_t high = entryCount_;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    auto midName = getName(mid);
+    if (!midName) {
+      return std::nullopt;
+    }
+    switch (comparePathPiece(*midName, name, caseSensitive_)) {
+      case CompareResult::EQUAL:
+        return getEntry(mid);
+      case CompareResult::BEFORE:
+        low = mid + 1;
+        break;
+      case CompareResult::AFTER:
+        high = mid;
+        break;
+    }
+  }
+  return std::nullopt;
+}
+
+std::unique_ptr<Tree> SerializedTree::materialize(ObjectId hash) const {
+  Tree::container entries{caseSensitive_};
+  entries.reserve(entryCount_);
+  for (size_t i = 0; i < entryCount_; ++i) {
+    auto entry = getEntry(i);
+    if (!entry) {
+      return nullptr;
+    }
+    entries.emplace(std::move(entry->first), std::move(entry->second));
+  }
+  return std::make_unique<Tree>(std::move(entries), std::move(hash));
+}
+
+} // namespace facebook::eden
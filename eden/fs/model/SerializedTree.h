@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <memory>
+#include <optional>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/model/TreeEntry.h"
+#include "eden/fs/utils/CaseSensitivity.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class Tree;
+
+/**
+ * A read-only view of a Tree serialized with Tree::serialize(), that decodes
+ * entries only when they are accessed.
+ *
+ * The indexed format (version 2) is laid out as:
+ *
+ *   uint32_t version
+ *   uint32_t entryCount
+ *   uint32_t flags
+ *   uint32_t offsets[entryCount]
+ *   entries, each encoded as by TreeEntry::serialize()
+ *
+ * Offsets are relative to the first entry, and entries are sorted by name in
+ * the order of the Tree's case sensitivity, recorded in flags. Looking up a
+ * name is thus a binary search that only decodes O(log(entryCount)) names,
+ * rather than building the whole PathMap of the Tree.
+ *
+ * The view points into the serialized bytes, which must outlive it.
+ */
+class SerializedTree {
+ public:
+  static constexpr uint32_t kVersion = 2;
+  static constexpr uint32_t kCaseInsensitiveFlag = 1;
+
+  /**
+   * Returns std::nullopt if data isn't in the indexed format, or if its index
+   * is corrupted.
+   */
+  static std::optional<SerializedTree> tryParse(folly::StringPiece data);
+
+  size_t size() const {
+    return entryCount_;
+  }
+
+  /**
+   * The case sensitivity the entries are sorted and looked up with.
+   */
+  CaseSensitivity getCaseSensitivity() const {
+    return caseSensitive_;
+  }
+
+  /**
+   * Name of the entry at index, without decoding the rest of the entry.
+   * Returns std::nullopt if the entry is corrupted.
+   */
+  std::optional<PathComponentPiece> getName(size_t index) const;
+
+  /**
+   * Decode the entry at index. Returns std::nullopt if it is corrupted.
+   */
+  std::optional<std::pair<PathComponent, TreeEntry>> getEntry(
+      size_t index) const;
+
+  /**
+   * Find the entry with the given name, with the case sensitivity of the
+   * serialized Tree. Returns std::nullopt if there is none, or if the entries
+   * that were visited are corrupted.
+   */
+  std::optional<std::pair<PathComponent, TreeEntry>> find(
+      PathComponentPiece name) const;
+
+  /**
+   * Decode every entry into a Tree. Returns nullptr if any is corrupted.
+   */
+  std::unique_ptr<Tree> materialize(ObjectId hash) const;
+
+ private:
+  SerializedTree(
+      const uint8_t* offsets,
+      folly::StringPiece entries,
+      uint32_t entryCount,
+      CaseSensitivity caseSensitive)
+      : offsets_{offsets},
+        entries_{entries},
+        entryCount_{entryCount},
+        caseSensitive_{caseSensitive} {}
+
+  /**
+   * The bytes of the entry at index, up to the next entry.
+   */
+  std::optional<folly::StringPiece> getEntryData(size_t index) const;
+
+  // Not necessarily aligned.
+  const uint8_t* offsets_;
+  folly::StringPiece entries_;
+  uint32_t entryCount_;
+  CaseSensitivity caseSensitive_;
+};
+
+} // namespace facebook::eden
@@ -7,6 +7,8 @@
 
 #include "Tree.h"
 #include <folly/io/IOBuf.h>
+#include <folly/memory/Malloc.h>
+#include "eden/fs/model/SerializedTree.h"
 
 namespace facebook::eden {
 
@@ -16,30 +18,45 @@ using namespace folly::io;
 size_t Tree::getSizeBytes() const {
   // TODO: we should consider using a standard memory framework across
   // eden for this type of thing. D17174143 is one such idea.
-  size_t internal_size = sizeof(*this);
-
-  size_t indirect_size =
-      folly::goodMallocSize(sizeof(TreeEntry) * entries_.capacity());
+  size_t internal_size = folly::goodMallocSize(sizeof(*this));
 
+  // Each entry is a name and a TreeEntry, either of which may spill to the
+  // heap: long names, and ObjectIds that embed a path.
+  size_t indirect_size = entries_.getAllocatedMemorySize() +
+      hash_.getIndirectSizeBytes();
   for (auto& entry : entries_) {
-    indirect_size += estimateIndirectMemoryUsage(entry.first.value());
+    indirect_size += estimateIndirectMemoryUsage(entry.first.value()) +
+        entry.second.getHash().getIndirectSizeBytes();
   }
   return internal_size + indirect_size;
 }
 
 IOBuf Tree::serialize() const {
-  size_t serialized_size = sizeof(uint32_t) + sizeof(uint32_t);
+  // Header, followed by the index of entry offsets.
+  size_t header_size =
+      (3 + entries_.size()) * sizeof(uint32_t);
+  size_t entries_size = 0;
   for (auto& entry : entries_) {
-    serialized_size += entry.second.serializedSize(entry.first);
+    entries_size += entry.second.serializedSize(entry.first);
   }
-  IOBuf buf(IOBuf::CREATE, serialized_size);
+  IOBuf buf(IOBuf::CREATE, header_size + entries_size);
   Appender appender(&buf, 0);
 
   XCHECK_LE(entries_.size(), std::numeric_limits<uint32_t>::max());
+  XCHECK_LE(entries_size, std::numeric_limits<uint32_t>::max());
   uint32_t numberOfEntries = static_cast<uint32_t>(entries_.size());
+  uint32_t flags = getCaseSensitivity() == CaseSensitivity::Insensitive
+      ? SerializedTree::kCaseInsensitiveFlag
+      : 0;
 
-  appender.write<uint32_t>(V1_VERSION);
+  appender.write<uint32_t>(SerializedTree::kVersion);
   appender.write<uint32_t>(numberOfEntries);
+  appender.write<uint32_t>(flags);
+  uint32_t offset = 0;
+  for (auto& entry : entries_) {
+    appender.write<uint32_t>(offset);
+    offset += entry.second.serializedSize(entry.first);
+  }
   for (auto& entry : entries_) {
     entry.second.serialize(entry.first, appender);
   }
@@ -55,6 +72,13 @@ std::unique_ptr<Tree> Tree::tryDeserialize(
   }
   uint32_t version;
   memcpy(&version, data.data(), sizeof(uint32_t));
+  if (version == SerializedTree::kVersion) {
+    auto serialized = SerializedTree::tryParse(data);
+    if (!serialized) {
+      return nullptr;
+    }
+    return serialized->materialize(std::move(hash));
+  }
   data.advance(sizeof(uint32_t));
   if (version != V1_VERSION) {
     return nullptr;
@@ -82,7 +82,7 @@ class Tree {
   }
 
   /**
-   * Serialize tree using custom format.
+   * Serialize tree using custom format, see SerializedTree for the layout.
    */
   folly::IOBuf serialize() const;
 
@@ -92,8 +92,8 @@ class Tree {
    *
    * First byte is used to identify serialization format.
    * Git tree starts with 'tree', so we can use any bytes other then 't' as a
-   * version identifier. Currently only V1_VERSION is supported, along with
-   * git tree format.
+   * version identifier. V1_VERSION and SerializedTree::kVersion are
+   * supported, along with git tree format.
    */
   static std::unique_ptr<Tree> tryDeserialize(
       ObjectId hash,
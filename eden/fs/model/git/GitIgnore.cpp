@@ -9,12 +9,32 @@
 
 #include <algorithm>
 #include "GitIgnorePattern.h"
+#include "GlobPatternIndex.h"
 
 using folly::StringPiece;
 using std::string;
 
 namespace facebook::eden {
 
+namespace {
+/**
+ * Below this many rules, matching a path against each of them is cheaper than
+ * looking up the candidates in the PatternIndex.
+ */
+constexpr size_t kMinIndexedRules = 8;
+} // namespace
+
+struct GitIgnore::PatternIndex {
+  // gitignore patterns are always case sensitive.
+  GlobPatternIndex basenamePatterns{CaseSensitivity::Sensitive};
+  GlobPatternIndex pathPatterns{CaseSensitivity::Sensitive};
+  // The position in rules_ of each pattern, by its id in the index above.
+  // Since the patterns are added in the order of rules_, these are
+  // increasing.
+  std::vector<size_t> basenameRules;
+  std::vector<size_t> pathRules;
+};
+
 GitIgnore::GitIgnore() {}
 
 GitIgnore::GitIgnore(GitIgnore const&) = default;
@@ -66,20 +86,64 @@ void GitIgnore::loadFile(StringPiece contents) {
   // reverse them so that we can do a forward walk through our patterns and
   // stop at the first match.
   std::reverse(newRules.begin(), newRules.end());
+
+  std::shared_ptr<PatternIndex> index;
+  if (newRules.size() >= kMinIndexedRules) {
+    index = std::make_shared<PatternIndex>();
+    for (size_t i = 0; i < newRules.size(); ++i) {
+      const auto& rule = newRules[i];
+      if (rule.isBasenameOnly()) {
+        index->basenamePatterns.add(rule.getGlob());
+        index->basenameRules.push_back(i);
+      } else {
+        index->pathPatterns.add(rule.getGlob());
+        index->pathRules.push_back(i);
+      }
+    }
+  }
+
   std::swap(rules_, newRules);
+  index_ = std::move(index);
 }
 
 GitIgnore::MatchResult GitIgnore::match(
     RelativePathPiece path,
     PathComponentPiece basename,
     FileType fileType) const {
-  for (const auto& pattern : rules_) {
-    auto result = pattern.match(path, basename, fileType);
+  if (!index_) {
+    for (const auto& pattern : rules_) {
+      auto result = pattern.match(path, basename, fileType);
+      if (result != NO_MATCH) {
+        return result;
+      }
+    }
+    return NO_MATCH;
+  }
+
+  std::vector<size_t> basenameCandidates;
+  std::vector<size_t> pathCandidates;
+  index_->basenamePatterns.getCandidates(basename.view(), basenameCandidates);
+  index_->pathPatterns.getCandidates(path.view(), pathCandidates);
+
+  // Walk the candidates of both indexes in the order of rules_, so that the
+  // rule with the highest precedence still wins.
+  auto basenameIt = basenameCandidates.begin();
+  auto pathIt = pathCandidates.begin();
+  while (basenameIt != basenameCandidates.end() ||
+         pathIt != pathCandidates.end()) {
+    size_t rule;
+    if (pathIt == pathCandidates.end() ||
+        (basenameIt != basenameCandidates.end() &&
+         index_->basenameRules[*basenameIt] < index_->pathRules[*pathIt])) {
+      rule = index_->basenameRules[*basenameIt++];
+    } else {
+      rule = index_->pathRules[*pathIt++];
+    }
+    auto result = rules_[rule].match(path, basename, fileType);
     if (result != NO_MATCH) {
       return result;
     }
   }
-
   return NO_MATCH;
 }
 
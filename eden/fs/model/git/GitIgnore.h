@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <memory>
 #include <vector>
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -173,12 +174,22 @@ class GitIgnore {
   static std::string matchString(MatchResult result);
 
  private:
+  struct PatternIndex;
+
   /*
    * The patterns loaded from the gitignore file.  These are sorted from
    * highest to lowest precedence (the reverse of the order they are actually
    * listed in the .gitignore file).
    */
   std::vector<GitIgnorePattern> rules_;
+
+  /*
+   * Tells which of the rules can match a path, so that paths aren't matched
+   * against every rule of large files.  Built by loadFile() for files with
+   * enough rules for this to pay off, nullptr otherwise.  It is immutable, so
+   * copies of this GitIgnore share it.
+   */
+  std::shared_ptr<const PatternIndex> index_;
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/git/GitIgnoreCache.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+GitIgnoreCache::GitIgnoreCache(size_t maxEntries)
+    : maxEntries_{maxEntries},
+      cache_{folly::in_place, std::max<size_t>(maxEntries, 1)} {}
+
+std::shared_ptr<const GitIgnore> GitIgnoreCache::get(const ObjectId& id) {
+  auto cache = cache_.lock();
+  auto it = cache->find(id);
+  if (it == cache->end()) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+std::shared_ptr<const GitIgnore> GitIgnoreCache::parse(
+    const ObjectId& id,
+    folly::StringPiece contents) {
+  if (auto cached = get(id)) {
+    return cached;
+  }
+
+  // Parse without holding the lock: concurrent parses of the same file give
+  // the same result.
+  auto ignore = std::make_shared<GitIgnore>();
+  ignore->loadFile(contents);
+  if (maxEntries_ != 0) {
+    cache_.lock()->set(id, ignore);
+  }
+  return ignore;
+}
+
+size_t GitIgnoreCache::size() const {
+  return cache_.lock()->size();
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <memory>
+#include <mutex>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/model/git/GitIgnore.h"
+
+namespace facebook::eden {
+
+/**
+ * The recently parsed .gitignore files, so that every status doesn't parse
+ * the .gitignore files of every directory again.
+ *
+ * Files are identified by an ObjectId for their contents: the id of their
+ * blob when they are unmodified, or the SHA-1 of their contents otherwise.
+ *
+ * Safe to use from any thread.
+ */
+class GitIgnoreCache {
+ public:
+  /**
+   * A cache of maxEntries files. A cache of 0 entries caches nothing.
+   */
+  explicit GitIgnoreCache(size_t maxEntries);
+
+  /**
+   * Returns the parsed file identified by id, or nullptr.
+   */
+  std::shared_ptr<const GitIgnore> get(const ObjectId& id);
+
+  /**
+   * Parses contents, the contents of the file identified by id, unless they
+   * are already cached.
+   */
+  std::shared_ptr<const GitIgnore> parse(
+      const ObjectId& id,
+      folly::StringPiece contents);
+
+  size_t size() const;
+
+ private:
+  const size_t maxEntries_;
+  folly::Synchronized<
+      folly::EvictingCacheMap<ObjectId, std::shared_ptr<const GitIgnore>>,
+      std::mutex>
+      cache_;
+};
+
+} // namespace facebook::eden
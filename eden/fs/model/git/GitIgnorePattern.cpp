@@ -137,11 +137,14 @@ optional<GitIgnorePattern> GitIgnorePattern::parseLine(StringPiece line) {
     return std::nullopt;
   }
 
-  return GitIgnorePattern(flags, std::move(matcher).value());
+  return GitIgnorePattern(flags, line.str(), std::move(matcher).value());
 }
 
-GitIgnorePattern::GitIgnorePattern(uint32_t flags, GlobMatcher&& matcher)
-    : flags_(flags), matcher_(std::move(matcher)) {}
+GitIgnorePattern::GitIgnorePattern(
+    uint32_t flags,
+    std::string glob,
+    GlobMatcher&& matcher)
+    : flags_(flags), glob_(std::move(glob)), matcher_(std::move(matcher)) {}
 
 GitIgnorePattern::~GitIgnorePattern() {}
 
@@ -9,6 +9,7 @@
 
 #include <folly/Range.h>
 #include <optional>
+#include <string>
 #include "eden/fs/model/git/GitIgnore.h"
 #include "eden/fs/model/git/GlobMatcher.h"
 
@@ -69,6 +70,20 @@ class GitIgnorePattern {
       PathComponentPiece basename,
       GitIgnore::FileType fileType) const;
 
+  /**
+   * Whether this pattern is only matched against the last component of paths.
+   */
+  bool isBasenameOnly() const {
+    return flags_ & FLAG_BASENAME_ONLY;
+  }
+
+  /**
+   * The glob the paths, or their last component, are matched against.
+   */
+  const std::string& getGlob() const {
+    return glob_;
+  }
+
  private:
   /**
    * Flag values that can be bitwise-ORed to create the flags_ value.
@@ -84,12 +99,16 @@ class GitIgnorePattern {
     FLAG_BASENAME_ONLY = 0x04,
   };
 
-  GitIgnorePattern(uint32_t flags, GlobMatcher&& matcher);
+  GitIgnorePattern(uint32_t flags, std::string glob, GlobMatcher&& matcher);
 
   /**
    * A bit set of the Flags defined above.
    */
   uint32_t flags_{0};
+  /**
+   * The glob matcher_ was created from.
+   */
+  std::string glob_;
   /**
    * The GlobMatcher object for performing matching.
    */
@@ -185,7 +185,33 @@ bool operator&(GlobOptions a, GlobOptions b) {
 }
 
 GlobMatcher::GlobMatcher(vector<uint8_t> pattern, CaseSensitivity caseSensitive)
-    : pattern_(std::move(pattern)), caseSensitive_(caseSensitive) {}
+    : pattern_(std::move(pattern)), caseSensitive_(caseSensitive) {
+  classify();
+}
+
+void GlobMatcher::classify() {
+  // Literal runs of more than 255 bytes are split in several opcodes, and are
+  // left to the generic matching.
+  auto size = pattern_.size();
+  if (size >= 2 && pattern_[0] == GLOB_LITERAL) {
+    literalOffset_ = 2;
+    literalLength_ = pattern_[1];
+    if (size == 2u + literalLength_) {
+      shape_ = Shape::Literal;
+    } else if (
+        size == 4u + literalLength_ && pattern_[size - 2] == GLOB_STAR) {
+      shape_ = Shape::Prefix;
+      matchCanStartWithDot_ = pattern_[size - 1] == GLOB_TRUE;
+    }
+  } else if (size >= 3 && pattern_[0] == GLOB_ENDS_WITH) {
+    literalOffset_ = 3;
+    literalLength_ = pattern_[2];
+    if (size == 3u + literalLength_) {
+      shape_ = Shape::Suffix;
+      matchCanStartWithDot_ = pattern_[1] == GLOB_TRUE;
+    }
+  }
+}
 
 GlobMatcher::GlobMatcher() {}
 
@@ -608,6 +634,38 @@ bool GlobMatcher::addCharClass(
 }
 
 bool GlobMatcher::match(std::string_view text) const {
+  // These mirror what tryMatchAt() does for the same opcodes.
+  switch (shape_) {
+    case Shape::Literal:
+      return text.size() == literalLength_ &&
+          isStringPieceEqual(text, literal(), caseSensitive_);
+    case Shape::Prefix: {
+      if (text.size() < literalLength_ ||
+          !isStringPieceEqual(
+              text.substr(0, literalLength_), literal(), caseSensitive_)) {
+        return false;
+      }
+      auto rest = text.substr(literalLength_);
+      if (!matchCanStartWithDot_ && !rest.empty() && rest[0] == '.') {
+        return false;
+      }
+      return memchr(rest.data(), '/', rest.size()) == nullptr;
+    }
+    case Shape::Suffix: {
+      if (text.size() < literalLength_) {
+        return false;
+      }
+      if (!matchCanStartWithDot_ && !text.empty() && text[0] == '.') {
+        return false;
+      }
+      auto starLength = text.size() - literalLength_;
+      return isStringPieceEqual(
+                 text.substr(starLength), literal(), caseSensitive_) &&
+          memchr(text.data(), '/', starLength) == nullptr;
+    }
+    case Shape::Generic:
+      break;
+  }
   return tryMatchAt(text, 0, 0);
 }
 
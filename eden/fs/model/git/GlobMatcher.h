@@ -95,6 +95,32 @@ class GlobMatcher {
   static void
   addCharClassRange(uint8_t low, uint8_t high, std::vector<uint8_t>* pattern);
 
+  /**
+   * The shapes of most patterns, which match() compares to the text directly
+   * rather than by interpreting the opcodes of pattern_.
+   */
+  enum class Shape : uint8_t {
+    Generic,
+    // A literal name, like "BUCK".
+    Literal,
+    // A literal followed by a '*', like "README*".
+    Prefix,
+    // A '*' followed by a literal, like "*.cpp".
+    Suffix,
+  };
+
+  /**
+   * Recognizes the shape of pattern_, and where the literal it compares the
+   * text to is.
+   */
+  void classify();
+
+  std::string_view literal() const {
+    return std::string_view{
+        reinterpret_cast<const char*>(pattern_.data()) + literalOffset_,
+        literalLength_};
+  }
+
   /**
    * Returns true if the trailing section of the input text (starting at
    * textIdx) is a mattern for the trailing portion of the pattern buffer
@@ -127,6 +153,13 @@ class GlobMatcher {
   std::vector<uint8_t> pattern_;
 
   CaseSensitivity caseSensitive_;
+
+  Shape shape_{Shape::Generic};
+  // Whether the text matched by the '*' of a Prefix or Suffix shape may start
+  // with a '.'.
+  bool matchCanStartWithDot_{true};
+  uint8_t literalOffset_{0};
+  uint8_t literalLength_{0};
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/git/GlobPatternIndex.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+namespace {
+
+bool isGlobSpecial(char c) {
+  return c == '*' || c == '?' || c == '[' || c == '\\';
+}
+
+std::string foldCase(std::string_view text) {
+  std::string folded{text};
+  for (auto& c : folded) {
+    if (c >= 'A' && c <= 'Z') {
+      c = static_cast<char>(c - 'A' + 'a');
+    }
+  }
+  return folded;
+}
+
+} // namespace
+
+size_t GlobPatternIndex::add(std::string_view pattern) {
+  auto id = size_++;
+  std::string folded;
+  if (caseSensitive_ == CaseSensitivity::Insensitive) {
+    folded = foldCase(pattern);
+    pattern = folded;
+  }
+
+  auto firstSpecial =
+      std::find_if(pattern.begin(), pattern.end(), isGlobSpecial);
+  if (firstSpecial == pattern.end()) {
+    // A literal pattern only matches itself.
+    insert(bySuffix_, suffixLengths_, pattern, id);
+    return id;
+  }
+
+  // Bracket expressions and escapes may end with a character that reads as
+  // literal text, so only patterns whose special characters are all
+  // wildcards get a suffix.
+  std::string_view suffix;
+  if (pattern.find_first_of("[\\") == std::string_view::npos) {
+    auto lastWildcard = pattern.find_last_of("*?");
+    suffix = pattern.substr(lastWildcard + 1);
+    // "**/" also matches no directory at all: "**/foo" matches "foo".
+    if (lastWildcard >= 1 && pattern.substr(lastWildcard - 1, 2) == "**" &&
+        !suffix.empty() && suffix.front() == '/') {
+      suffix.remove_prefix(1);
+    }
+  }
+
+  auto prefix = pattern.substr(0, firstSpecial - pattern.begin());
+  // Likewise "foo/**" may match "foo".
+  if (!prefix.empty() && prefix.back() == '/' &&
+      pattern.substr(prefix.size(), 2) == "**") {
+    prefix.remove_suffix(1);
+  }
+
+  if (!suffix.empty()) {
+    insert(bySuffix_, suffixLengths_, suffix, id);
+  } else if (!prefix.empty()) {
+    insert(byPrefix_, prefixLengths_, prefix, id);
+  } else {
+    unindexed_.push_back(id);
+  }
+  return id;
+}
+
+void GlobPatternIndex::insert(
+    Buckets& buckets,
+    std::vector<size_t>& lengths,
+    std::string_view key,
+    size_t id) {
+  buckets[std::string{key}].push_back(id);
+  auto it = std::lower_bound(lengths.begin(), lengths.end(), key.size());
+  if (it == lengths.end() || *it != key.size()) {
+    lengths.insert(it, key.size());
+  }
+}
+
+void GlobPatternIndex::getCandidates(
+    std::string_view name,
+    std::vector<size_t>& candidates) const {
+  candidates.clear();
+  std::string folded;
+  if (caseSensitive_ == CaseSensitivity::Insensitive) {
+    folded = foldCase(name);
+    name = folded;
+  }
+
+  auto addBucket = [&](const Buckets& buckets, std::string_view key) {
+    auto it = buckets.find(key);
+    if (it != buckets.end()) {
+      candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+    }
+  };
+  for (auto length : suffixLengths_) {
+    if (length > name.size()) {
+      break;
+    }
+    addBucket(bySuffix_, name.substr(name.size() - length));
+  }
+  for (auto length : prefixLengths_) {
+    if (length > name.size()) {
+      break;
+    }
+    addBucket(byPrefix_, name.substr(0, length));
+  }
+  candidates.insert(candidates.end(), unindexed_.begin(), unindexed_.end());
+
+  // Every pattern is in a single bucket, so there are no duplicates to drop.
+  std::sort(candidates.begin(), candidates.end());
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/container/F14Map.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "eden/fs/utils/CaseSensitivity.h"
+
+namespace facebook::eden {
+
+/**
+ * An index over a set of glob patterns that tells which of them can match a
+ * name, so that a name is only run through the GlobMatcher of these
+ * candidates rather than through the GlobMatcher of every pattern.
+ *
+ * Every pattern is indexed by a literal piece of text any matching name must
+ * have: the text following its last wildcard, otherwise the text preceding
+ * its first one. A name is looked up once for each distinct length of these
+ * pieces, whatever the number of patterns. Patterns with no such text, like
+ * "*" or "a*b*", are candidates for every name.
+ */
+class GlobPatternIndex {
+ public:
+  explicit GlobPatternIndex(CaseSensitivity caseSensitive)
+      : caseSensitive_{caseSensitive} {}
+
+  /**
+   * Add a pattern using the GlobMatcher syntax. Returns its id, which is the
+   * number of patterns added before it.
+   */
+  size_t add(std::string_view pattern);
+
+  /**
+   * Replace the contents of candidates with the ids, in increasing order, of
+   * the patterns that may match name. The patterns that are left out
+   * definitely don't match it.
+   */
+  void getCandidates(std::string_view name, std::vector<size_t>& candidates)
+      const;
+
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  using Buckets = folly::F14FastMap<std::string, std::vector<size_t>>;
+
+  void insert(
+      Buckets& buckets,
+      std::vector<size_t>& lengths,
+      std::string_view key,
+      size_t id);
+
+  CaseSensitivity caseSensitive_;
+  size_t size_{0};
+
+  // The patterns indexed by the literal text that ends all of their matches,
+  // and the distinct lengths of these texts in increasing order.
+  Buckets bySuffix_;
+  std::vector<size_t> suffixLengths_;
+  // Likewise for the literal text that starts all of their matches.
+  Buckets byPrefix_;
+  std::vector<size_t> prefixLengths_;
+  // The patterns that may match any name.
+  std::vector<size_t> unindexed_;
+};
+
+} // namespace facebook::eden
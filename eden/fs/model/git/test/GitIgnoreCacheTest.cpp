@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/git/GitIgnoreCache.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+TEST(GitIgnoreCache, parsesEachFileOnce) {
+  GitIgnoreCache cache{2};
+  auto a = ObjectId::sha1(std::string{"a"});
+  auto b = ObjectId::sha1(std::string{"b"});
+  EXPECT_EQ(nullptr, cache.get(a));
+
+  auto ignore = cache.parse(a, "*.o\n");
+  EXPECT_EQ(
+      GitIgnore::EXCLUDE,
+      ignore->match(RelativePathPiece{"foo.o"}, GitIgnore::TYPE_FILE));
+  EXPECT_EQ(ignore, cache.get(a));
+  // The contents are only parsed the first time.
+  EXPECT_EQ(ignore, cache.parse(a, "*.txt\n"));
+
+  cache.parse(b, "*.txt\n");
+  EXPECT_EQ(2u, cache.size());
+  EXPECT_NE(ignore, cache.get(b));
+}
+
+TEST(GitIgnoreCache, emptyCacheCachesNothing) {
+  GitIgnoreCache cache{0};
+  auto a = ObjectId::sha1(std::string{"a"});
+  auto ignore = cache.parse(a, "*.o\n");
+  EXPECT_FALSE(ignore->empty());
+  EXPECT_EQ(nullptr, cache.get(a));
+  EXPECT_EQ(0u, cache.size());
+}
@@ -668,3 +668,50 @@ TEST(GitIgnore, directory) {
   // path known to be a file.  It expects ignored directories earlier in the
   // path to have already been filtered out.
 }
+
+TEST(GitIgnore, manyRules) {
+  // Enough rules for the paths to only be matched against the rules that can
+  // match them, which must still give the same results.
+  GitIgnore ignore;
+  ignore.loadFile(
+      "*.o\n"
+      "*.pyc\n"
+      "/build/\n"
+      "buck-out\n"
+      "src/**/gen\n"
+      "!keep.o\n"
+      "tmp*\n"
+      "**/logs/*.log\n"
+      "[Mm]akefile\n"
+      "doc/*.html\n"
+      "!doc/index.html\n"
+      "*~\n"
+      "!tmp.txt\n");
+
+  EXPECT_IGNORE(ignore, EXCLUDE, "foo.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, "dir/foo.o");
+  EXPECT_IGNORE(ignore, INCLUDE, "keep.o");
+  EXPECT_IGNORE(ignore, INCLUDE, "dir/keep.o");
+  EXPECT_IGNORE(ignore, EXCLUDE, "a/b/c.pyc");
+  EXPECT_IGNORE(ignore, NO_MATCH, "build");
+  EXPECT_IGNORE_DIR(ignore, EXCLUDE, "build");
+  EXPECT_IGNORE_DIR(ignore, NO_MATCH, "dir/build");
+  EXPECT_IGNORE_DIR(ignore, EXCLUDE, "dir/buck-out");
+  EXPECT_IGNORE(ignore, EXCLUDE, "src/gen");
+  EXPECT_IGNORE(ignore, EXCLUDE, "src/a/b/gen");
+  EXPECT_IGNORE(ignore, NO_MATCH, "lib/gen");
+  EXPECT_IGNORE(ignore, EXCLUDE, "tmp");
+  EXPECT_IGNORE(ignore, EXCLUDE, "dir/tmpfile");
+  EXPECT_IGNORE(ignore, INCLUDE, "tmp.txt");
+  EXPECT_IGNORE(ignore, EXCLUDE, "logs/a.log");
+  EXPECT_IGNORE(ignore, EXCLUDE, "x/logs/a.log");
+  EXPECT_IGNORE(ignore, NO_MATCH, "x/logs/a.txt");
+  EXPECT_IGNORE(ignore, EXCLUDE, "Makefile");
+  EXPECT_IGNORE(ignore, EXCLUDE, "dir/makefile");
+  EXPECT_IGNORE(ignore, NO_MATCH, "dir/MAKEFILE");
+  EXPECT_IGNORE(ignore, EXCLUDE, "doc/a.html");
+  EXPECT_IGNORE(ignore, INCLUDE, "doc/index.html");
+  EXPECT_IGNORE(ignore, NO_MATCH, "doc/sub/a.html");
+  EXPECT_IGNORE(ignore, EXCLUDE, "notes.txt~");
+  EXPECT_IGNORE(ignore, NO_MATCH, "notes.txt");
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+#include <folly/io/IOBuf.h>
+#include <string>
+
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/model/git/GitBlob.h"
+#include "eden/fs/model/git/GitTree.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+/**
+ * A git tree object of `count` entries, with names of the length found in
+ * source directories, one in eight of them being directories.
+ */
+std::string makeGitTree(size_t count) {
+  std::string body;
+  for (size_t i = 0; i < count; ++i) {
+    bool isDir = i % 8 == 0;
+    body += fmt::format(
+        "{} entry{:06}{}", isDir ? "40000" : "100644", i, isDir ? "" : ".cpp");
+    body.push_back('\0');
+    auto hash = Hash20::sha1(folly::StringPiece{std::to_string(i)});
+    body.append(
+        reinterpret_cast<const char*>(hash.getBytes().data()),
+        hash.getBytes().size());
+  }
+  auto object = fmt::format("tree {}", body.size());
+  object.push_back('\0');
+  return object + body;
+}
+
+void deserialize_tree(benchmark::State& state) {
+  auto object = makeGitTree(state.range(0));
+  auto hash = ObjectId::sha1(object);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        deserializeGitTree(hash, folly::StringPiece{object}));
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * object.size());
+}
+BENCHMARK(deserialize_tree)->Arg(10)->Arg(1000)->Arg(100000);
+
+/**
+ * A managed buffer is sliced, a wrapped one must be copied since it may not
+ * outlive the Blob.
+ */
+void deserialize_blob(benchmark::State& state) {
+  std::string contents(state.range(1), 'x');
+  auto object = fmt::format("blob {}", contents.size());
+  object.push_back('\0');
+  object += contents;
+  auto hash = ObjectId::sha1(object);
+  auto managed = folly::IOBuf::copyBuffer(object);
+  folly::IOBuf wrapped{folly::IOBuf::WRAP_BUFFER, folly::StringPiece{object}};
+  auto* data = state.range(0) ? managed.get() : &wrapped;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(deserializeGitBlob(hash, data));
+  }
+  state.SetBytesProcessed(state.iterations() * object.size());
+}
+BENCHMARK(deserialize_blob)
+    ->ArgNames({"managed", "size"})
+    ->Args({0, 4096})
+    ->Args({1, 4096})
+    ->Args({0, 1 << 20})
+    ->Args({1, 1 << 20});
+
+} // namespace
+
+BENCHMARK_MAIN();
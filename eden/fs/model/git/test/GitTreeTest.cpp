@@ -163,6 +163,32 @@ TEST(GitTree, deserializeEmpty) {
   EXPECT_EQ(0, tree->size());
 }
 
+TEST(GitTree, deserializeChained) {
+  auto gitTreeObject = folly::to<string>(
+      string("tree 67\x00", 8),
+      string("100644 README.md\x00", 17),
+      toBinaryHash("c5f15617ed29cd35964dc197a7960aeaedf2c2d5"),
+      string("40000 lib\x00", 10),
+      toBinaryHash("e95798e17f694c227b7a8441cc5c7dae50a187d0"));
+  auto hash = ObjectId::sha1(gitTreeObject);
+
+  // Split in the middle of the first name, as a read from a pack would.
+  auto buf = IOBuf::copyBuffer(gitTreeObject.data(), 16);
+  buf->appendToChain(IOBuf::copyBuffer(
+      gitTreeObject.data() + 16, gitTreeObject.size() - 16));
+  ASSERT_TRUE(buf->isChained());
+
+  auto tree = deserializeGitTree(hash, buf.get());
+  EXPECT_TRUE(*deserializeGitTree(hash, StringPiece(gitTreeObject)) == *tree);
+  ASSERT_EQ(2, tree->size());
+  auto readme = tree->find("README.md"_pc);
+  ASSERT_NE(tree->cend(), readme);
+  EXPECT_EQ(
+      ObjectId::fromHex("c5f15617ed29cd35964dc197a7960aeaedf2c2d5"),
+      readme->second.getHash());
+  EXPECT_TRUE(tree->find("lib"_pc)->second.isTree());
+}
+
 TEST(GitTree, testBadDeserialize) {
   ObjectId zero = ObjectId::fromHex("0000000000000000000000000000000000000000");
   // Partial header
@@ -433,6 +433,44 @@ TEST(Glob, testRangeMerging) {
   EXPECT_NOMATCH("A", "[b-ca-c]");
 }
 
+TEST(Glob, testCommonShapes) {
+  // Literal names.
+  EXPECT_MATCH("BUCK", "BUCK");
+  EXPECT_NOMATCH("BUCK.v2", "BUCK");
+  EXPECT_NOMATCH("BUC", "BUCK");
+  EXPECT_NOMATCH("", "BUCK");
+  EXPECT_CASE_INSENSITIVE_MATCH("buck", "BUCK");
+  EXPECT_MATCH("*.cpp", "\\*.cpp");
+  EXPECT_NOMATCH("foo.cpp", "\\*.cpp");
+  auto longName = std::string(300, 'a');
+  EXPECT_MATCH(longName, longName);
+  EXPECT_NOMATCH(longName.substr(1), longName);
+
+  // Prefixes.
+  EXPECT_MATCH("README", "README*");
+  EXPECT_MATCH("README.md", "README*");
+  EXPECT_NOMATCH("READ", "README*");
+  EXPECT_NOMATCH("README/index.md", "README*");
+  EXPECT_CASE_INSENSITIVE_MATCH("readme.MD", "README*");
+  EXPECT_IGNORE_DOTFILES_NOMATCH("docs/.hidden", "docs/*");
+  EXPECT_IGNORE_DOTFILES_MATCH("docs/", "docs/*");
+  EXPECT_MATCH("docs/.hidden", "docs/*");
+
+  // Suffixes.
+  EXPECT_MATCH(".cpp", "*.cpp");
+  EXPECT_MATCH("foo.cpp", "*.cpp");
+  EXPECT_NOMATCH("foo.cpp.orig", "*.cpp");
+  EXPECT_NOMATCH("cpp", "*.cpp");
+  EXPECT_NOMATCH("foo/bar.cpp", "*.cpp");
+  EXPECT_CASE_INSENSITIVE_MATCH("FOO.CPP", "*.cpp");
+  EXPECT_IGNORE_DOTFILES_NOMATCH(".foo.cpp", "*.cpp");
+
+  // A default constructed matcher only matches the empty string.
+  GlobMatcher empty;
+  EXPECT_TRUE(empty.match(""));
+  EXPECT_FALSE(empty.match("a"));
+}
+
 TEST(Glob, testCaseInsensitive) {
   EXPECT_CASE_INSENSITIVE_MATCH("a", "[A-Z]");
   EXPECT_CASE_INSENSITIVE_MATCH("A", "[a-z]");
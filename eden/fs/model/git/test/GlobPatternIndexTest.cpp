@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/git/GlobPatternIndex.h"
+
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/git/GlobMatcher.h"
+
+namespace {
+
+using namespace facebook::eden;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+std::vector<size_t> candidatesFor(
+    const GlobPatternIndex& index,
+    std::string_view name) {
+  std::vector<size_t> candidates;
+  index.getCandidates(name, candidates);
+  return candidates;
+}
+
+TEST(GlobPatternIndex, narrowsDownByLiteralText) {
+  GlobPatternIndex index{CaseSensitivity::Sensitive};
+  EXPECT_EQ(0u, index.add("*.cpp"));
+  EXPECT_EQ(1u, index.add("*.h"));
+  EXPECT_EQ(2u, index.add("test_*"));
+  EXPECT_EQ(3u, index.add("BUCK"));
+  EXPECT_EQ(4u, index.add("*"));
+  EXPECT_EQ(5u, index.add("lib[ab]*.cpp"));
+
+  EXPECT_THAT(candidatesFor(index, "main.cpp"), ElementsAre(0, 4));
+  EXPECT_THAT(candidatesFor(index, "test_main.cpp"), ElementsAre(0, 2, 4));
+  EXPECT_THAT(candidatesFor(index, "BUCK"), ElementsAre(3, 4));
+  EXPECT_THAT(candidatesFor(index, "liba.cpp"), ElementsAre(0, 4, 5));
+  EXPECT_THAT(candidatesFor(index, "README"), ElementsAre(4));
+  EXPECT_EQ(6u, index.size());
+}
+
+TEST(GlobPatternIndex, recursivePatternsMatchingNoDirectory) {
+  GlobPatternIndex index{CaseSensitivity::Sensitive};
+  index.add("**/foo");
+  index.add("src/**");
+  EXPECT_THAT(candidatesFor(index, "foo"), ElementsAre(0));
+  EXPECT_THAT(candidatesFor(index, "a/b/foo"), ElementsAre(0));
+  EXPECT_THAT(candidatesFor(index, "src"), ElementsAre(1));
+  EXPECT_THAT(candidatesFor(index, "srcfoo"), ElementsAre(0, 1));
+  EXPECT_THAT(candidatesFor(index, "lib/bar"), IsEmpty());
+}
+
+TEST(GlobPatternIndex, caseInsensitive) {
+  GlobPatternIndex index{CaseSensitivity::Insensitive};
+  index.add("*.CPP");
+  index.add("Makefile");
+  EXPECT_THAT(candidatesFor(index, "main.cpp"), ElementsAre(0));
+  EXPECT_THAT(candidatesFor(index, "MAKEFILE"), ElementsAre(1));
+}
+
+TEST(GlobPatternIndex, neverRulesOutAMatch) {
+  std::vector<std::string> patterns = {
+      "*.txt",
+      "a?c",
+      "a*b*c",
+      "**/*.h",
+      "include/**",
+      "x/**/y",
+      "[a-c]*",
+      "foo\\*",
+      "*[xyz]",
+      "??",
+      "dir/*",
+  };
+  std::vector<std::string> names = {
+      "a.txt",
+      "abc",
+      "aXbYc",
+      "inc.h",
+      "include/linux/types.h",
+      "include",
+      "x/y",
+      "x/a/b/y",
+      ".hidden",
+      "foo*",
+      "fooz",
+      "ab",
+      "dir/file",
+  };
+
+  GlobPatternIndex index{CaseSensitivity::Sensitive};
+  std::vector<GlobMatcher> matchers;
+  for (const auto& pattern : patterns) {
+    index.add(pattern);
+    matchers.push_back(
+        GlobMatcher::create(pattern, GlobOptions::DEFAULT).value());
+  }
+  for (const auto& name : names) {
+    auto candidates = candidatesFor(index, name);
+    for (size_t id = 0; id < patterns.size(); ++id) {
+      if (matchers[id].match(name)) {
+        EXPECT_NE(
+            candidates.end(),
+            std::find(candidates.begin(), candidates.end(), id))
+            << patterns[id] << " matches " << name;
+      }
+    }
+  }
+}
+
+} // namespace
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/Blob.h"
+
+#include <folly/io/IOBuf.h>
+#include <folly/portability/GTest.h>
+
+namespace facebook::eden {
+
+namespace {
+const ObjectId kBlobId{"blob"};
+} // namespace
+
+TEST(Blob, sizeBytesCountsTheWholeAllocationOfOwnedBuffers) {
+  auto buf = folly::IOBuf::create(4096);
+  buf->append(10);
+  Blob blob{kBlobId, std::move(*buf)};
+  EXPECT_EQ(10, blob.getSize());
+  EXPECT_LE(sizeof(Blob) + 4096, blob.getSizeBytes());
+}
+
+TEST(Blob, sizeBytesCountsOnlyTheSliceOfSharedBuffers) {
+  auto buf = folly::IOBuf::create(4096);
+  buf->append(4096);
+  auto slice = buf->cloneOneAsValue();
+  slice.trimEnd(4086);
+  Blob blob{kBlobId, std::move(slice)};
+  EXPECT_EQ(10, blob.getSize());
+  EXPECT_EQ(sizeof(Blob) + 10, blob.getSizeBytes());
+}
+
+TEST(Blob, sizeBytesDoesNotChangeOnceShared) {
+  auto buf = folly::IOBuf::create(4096);
+  buf->append(100);
+  Blob blob{kBlobId, std::move(*buf)};
+  auto sizeBytes = blob.getSizeBytes();
+  auto copy = blob.getContents();
+  EXPECT_EQ(sizeBytes, blob.getSizeBytes());
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/model/SerializedTree.h"
+
+#include <fmt/format.h>
+#include <folly/io/Cursor.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/TestOps.h"
+#include "eden/fs/model/Tree.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+ObjectId testHash{"faceb00cdeadbeefc00010ff1badb0028badf00d"};
+
+Tree makeTree(CaseSensitivity caseSensitive, size_t count) {
+  Tree::container entries{caseSensitive};
+  for (size_t i = 0; i < count; ++i) {
+    entries.emplace(
+        PathComponent{fmt::format("File{:04}", i)},
+        testHash,
+        i % 2 ? TreeEntryType::TREE : TreeEntryType::REGULAR_FILE,
+        i % 2 ? std::nullopt : std::optional<uint64_t>{i},
+        std::nullopt);
+  }
+  return Tree{std::move(entries), testHash};
+}
+
+std::string serialize(const Tree& tree) {
+  auto buf = tree.serialize();
+  buf.coalesce();
+  return buf.moveToFbString().toStdString();
+}
+
+} // namespace
+
+TEST(SerializedTree, find_entries_without_materializing) {
+  auto tree = makeTree(CaseSensitivity::Sensitive, 100);
+  auto data = serialize(tree);
+  auto serialized = SerializedTree::tryParse(data);
+  ASSERT_TRUE(serialized);
+  EXPECT_EQ(100, serialized->size());
+  EXPECT_EQ(CaseSensitivity::Sensitive, serialized->getCaseSensitivity());
+
+  for (auto& [name, entry] : tree) {
+    auto found = serialized->find(name);
+    ASSERT_TRUE(found) << name;
+    EXPECT_EQ(name, found->first);
+    EXPECT_EQ(entry, found->second);
+    EXPECT_EQ(entry.getSize(), found->second.getSize());
+  }
+  EXPECT_FALSE(serialized->find(PathComponentPiece{"File0100"}));
+  EXPECT_FALSE(serialized->find(PathComponentPiece{"file0001"}));
+  EXPECT_FALSE(serialized->find(PathComponentPiece{"A"}));
+}
+
+TEST(SerializedTree, entries_are_indexed_in_order) {
+  auto tree = makeTree(CaseSensitivity::Sensitive, 10);
+  auto data = serialize(tree);
+  auto serialized = SerializedTree::tryParse(data);
+  ASSERT_TRUE(serialized);
+  size_t i = 0;
+  for (auto& [name, entry] : tree) {
+    EXPECT_EQ(name, serialized->getName(i).value());
+    EXPECT_EQ(entry, serialized->getEntry(i).value().second);
+    ++i;
+  }
+}
+
+TEST(SerializedTree, case_insensitive_lookup) {
+  auto tree = makeTree(CaseSensitivity::Insensitive, 10);
+  auto data = serialize(tree);
+  auto serialized = SerializedTree::tryParse(data);
+  ASSERT_TRUE(serialized);
+  EXPECT_EQ(CaseSensitivity::Insensitive, serialized->getCaseSensitivity());
+  auto found = serialized->find(PathComponentPiece{"FILE0003"});
+  ASSERT_TRUE(found);
+  EXPECT_EQ("File0003", found->first);
+}
+
+TEST(SerializedTree, empty_tree) {
+  auto tree = makeTree(CaseSensitivity::Sensitive, 0);
+  auto data = serialize(tree);
+  auto serialized = SerializedTree::tryParse(data);
+  ASSERT_TRUE(serialized);
+  EXPECT_EQ(0, serialized->size());
+  EXPECT_FALSE(serialized->find(PathComponentPiece{"a"}));
+  auto materialized = serialized->materialize(testHash);
+  ASSERT_TRUE(materialized);
+  EXPECT_EQ(tree, *materialized);
+}
+
+TEST(SerializedTree, round_trips_through_tree) {
+  auto tree = makeTree(CaseSensitivity::Insensitive, 20);
+  auto data = serialize(tree);
+  auto deserialized = Tree::tryDeserialize(testHash, data);
+  ASSERT_TRUE(deserialized);
+  EXPECT_EQ(tree, *deserialized);
+  EXPECT_EQ(CaseSensitivity::Insensitive, deserialized->getCaseSensitivity());
+}
+
+TEST(SerializedTree, version_1_trees_are_still_readable) {
+  auto tree = makeTree(kPathMapDefaultCaseSensitive, 3);
+  folly::IOBuf buf{folly::IOBuf::CREATE, 0};
+  folly::io::Appender appender{&buf, 256};
+  appender.write<uint32_t>(1);
+  appender.write<uint32_t>(tree.size());
+  for (auto& [name, entry] : tree) {
+    entry.serialize(name, appender);
+  }
+  buf.coalesce();
+  auto data = buf.moveToFbString().toStdString();
+
+  EXPECT_FALSE(SerializedTree::tryParse(data));
+  auto deserialized = Tree::tryDeserialize(testHash, data);
+  ASSERT_TRUE(deserialized);
+  EXPECT_EQ(tree, *deserialized);
+}
+
+TEST(SerializedTree, corrupted_index_is_rejected) {
+  auto tree = makeTree(CaseSensitivity::Sensitive, 4);
+  auto data = serialize(tree);
+
+  auto truncated = data.substr(0, 3 * sizeof(uint32_t) + sizeof(uint32_t));
+  EXPECT_FALSE(SerializedTree::tryParse(truncated));
+
+  // Point the second entry past the end of the data.
+  uint32_t offset = data.size();
+  memcpy(&data[4 * sizeof(uint32_t)], &offset, sizeof(offset));
+  auto serialized = SerializedTree::tryParse(data);
+  ASSERT_TRUE(serialized);
+  EXPECT_FALSE(serialized->getEntry(1));
+  EXPECT_FALSE(serialized->materialize(testHash));
+  EXPECT_FALSE(Tree::tryDeserialize(testHash, data));
+}
@@ -5,7 +5,10 @@
  * GNU General Public License version 2.
  */
 
+#include <fmt/format.h>
 #include <folly/String.h>
+#include <folly/memory/Malloc.h>
+#include <folly/memory/MallctlHelper.h>
 #include <folly/portability/GTest.h>
 
 #include "eden/fs/model/Hash.h"
@@ -25,6 +28,15 @@ std::string testHashHex = folly::to<std::string>(
     "8badf00d");
 
 ObjectId testHash(testHashHex);
+
+/** The bytes allocated by this thread and not freed yet, per jemalloc. */
+uint64_t threadAllocatedBytes() {
+  uint64_t allocated = 0;
+  uint64_t deallocated = 0;
+  folly::mallctlRead("thread.allocated", &allocated);
+  folly::mallctlRead("thread.deallocated", &deallocated);
+  return allocated - deallocated;
+}
 } // namespace
 
 TEST(Tree, testFind) {
@@ -83,4 +95,42 @@ TEST(Tree, testSize) {
   EXPECT_LE(numEntries * entrySize + Hash20::RAW_SIZE, tree.getSizeBytes());
 }
 
+TEST(Tree, sizeCountsObjectIdsStoredOnTheHeap) {
+  auto makeTree = [](size_t idSize) {
+    Tree::container entries{kPathMapDefaultCaseSensitive};
+    for (size_t i = 0; i < 100; ++i) {
+      auto id = ObjectId{fmt::format("{:0{}}", i, idSize)};
+      entries.emplace(
+          PathComponent{fmt::format("f{}", i)},
+          id,
+          TreeEntryType::REGULAR_FILE);
+    }
+    return Tree{std::move(entries), ObjectId{"tree"}};
+  };
+  // 20 bytes are stored inline, 60 bytes aren't.
+  EXPECT_GE(
+      makeTree(60).getSizeBytes(), makeTree(20).getSizeBytes() + 100 * 60);
+}
+
+TEST(Tree, sizeEstimateMatchesAllocator) {
+  if (!folly::usingJEMalloc()) {
+    GTEST_SKIP() << "needs the per-thread statistics of jemalloc";
+  }
+  auto before = threadAllocatedBytes();
+  std::unique_ptr<Tree> tree;
+  {
+    Tree::container entries{kPathMapDefaultCaseSensitive};
+    for (size_t i = 0; i < 10000; ++i) {
+      auto name = fmt::format("some_source_file_with_a_long_name_{}.cpp", i);
+      entries.emplace(
+          PathComponentPiece{name}, testHash, TreeEntryType::REGULAR_FILE);
+    }
+    tree = std::make_unique<Tree>(std::move(entries), testHash);
+  }
+  auto actual = threadAllocatedBytes() - before;
+  auto estimate = tree->getSizeBytes();
+  EXPECT_NEAR(actual, estimate, actual / 10)
+      << "estimated " << estimate << " bytes, allocated " << actual;
+}
+
 } // namespace facebook::eden
@@ -20,6 +20,7 @@
 #include "eden/fs/monitor/EdenInstance.h"
 #include "eden/fs/monitor/LogFile.h"
 #include "eden/fs/monitor/LogRotation.h"
+#include "eden/fs/monitor/ResourceGovernor.h"
 #include "eden/fs/service/gen-cpp2/EdenServiceAsyncClient.h"
 
 #ifdef __linux__
@@ -101,6 +102,22 @@ EdenMonitor::EdenMonitor(
   }
   log_ = std::make_shared<LogFile>(
       logDir + "edenfs.log"_relpath, maxLogSize, std::move(rotationStrategy));
+
+  auto governorLimits = ResourceGovernor::Limits::fromConfig(*config);
+  if (governorLimits.interval.count() > 0) {
+    unique_ptr<LogRotationStrategy> governorRotationStrategy;
+    if (maxLogSize > 0) {
+      governorRotationStrategy = make_unique<TimestampLogRotation>(
+          config->maxRotatedLogFiles.getValue());
+    }
+    governor_ = make_unique<ResourceGovernor>(
+        this,
+        governorLimits,
+        std::make_shared<LogFile>(
+            logDir + "resource-governor.log"_relpath,
+            maxLogSize,
+            std::move(governorRotationStrategy)));
+  }
 }
 
 EdenMonitor::~EdenMonitor() {}
@@ -122,6 +139,9 @@ Future<Unit> EdenMonitor::start() {
   return getEdenInstance().thenValue([this](auto&&) {
     XCHECK(edenfs_ != nullptr);
     state_ = State::Running;
+    if (governor_) {
+      governor_->start();
+    }
 #ifdef __linux__
     auto rc = sd_notify(/*unset_environment=*/false, "READY=1");
     if (rc < 0) {
@@ -165,6 +185,10 @@ Future<Unit> EdenMonitor::getEdenInstance() {
   });
 }
 
+pid_t EdenMonitor::getEdenPid() const {
+  return edenfs_->getPid();
+}
+
 std::shared_ptr<EdenServiceAsyncClient> EdenMonitor::createEdenThriftClient() {
   auto socketPath = edenDir_ + PathComponentPiece("socket");
   uint32_t connectTimeoutMS = 500;
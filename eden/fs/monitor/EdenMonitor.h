@@ -30,6 +30,7 @@ class EdenConfig;
 class EdenInstance;
 class EdenService;
 class LogFile;
+class ResourceGovernor;
 
 /**
  * EdenMonitor is the main singleton that drives the monitoring process.
@@ -61,6 +62,11 @@ class EdenMonitor {
     return edenDir_;
   }
 
+  /**
+   * The process ID of the EdenFS daemon being monitored.
+   */
+  pid_t getEdenPid() const;
+
   /**
    * Create a EdenFS thrift client.
    *
@@ -102,6 +108,8 @@ class EdenMonitor {
   std::unique_ptr<SignalHandler> signalHandler_;
   std::unique_ptr<EdenInstance> edenfs_;
   std::shared_ptr<LogFile> log_;
+  // Null if the resource policies are disabled.
+  std::unique_ptr<ResourceGovernor> governor_;
 
   std::string selfExe_;
   std::vector<std::string> selfArgv_;
@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/monitor/ResourceGovernor.h"
+
+#include <boost/filesystem.hpp>
+#include <fmt/format.h>
+#include <folly/String.h>
+#include <folly/futures/Future.h>
+#include <folly/json.h>
+#include <folly/logging/xlog.h>
+#include <folly/portability/Unistd.h>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/monitor/EdenMonitor.h"
+#include "eden/fs/monitor/LogFile.h"
+#include "eden/fs/service/gen-cpp2/EdenServiceAsyncClient.h"
+#include "eden/fs/utils/FileUtils.h"
+#include "eden/fs/utils/ProcUtil.h"
+
+using folly::Future;
+using folly::Unit;
+using std::chrono::duration_cast;
+
+namespace facebook::eden {
+
+namespace {
+
+// One counter per FUSE mount, holding the duration of its oldest live
+// request.
+constexpr folly::StringPiece kLiveRequestLatencyCounters{
+    "fuse\\..*\\.live_requests\\.max_duration_us"};
+
+size_t actionIndex(ResourceGovernor::Action action) {
+  return static_cast<size_t>(action);
+}
+
+std::optional<uint64_t> countOpenFiles(AbsolutePathPiece fdDir) {
+  boost::system::error_code ec;
+  uint64_t count = 0;
+  boost::filesystem::directory_iterator it{fdDir.c_str(), ec};
+  for (; !ec && it != boost::filesystem::directory_iterator{};
+       it.increment(ec)) {
+    ++count;
+  }
+  if (ec) {
+    return std::nullopt;
+  }
+  return count;
+}
+
+folly::dynamic sampleToDynamic(const ResourceGovernor::Sample& sample) {
+  folly::dynamic result = folly::dynamic::object;
+  if (sample.residentBytes) {
+    result["rss_bytes"] = *sample.residentBytes;
+  }
+  if (sample.openFiles) {
+    result["open_files"] = *sample.openFiles;
+  }
+  if (sample.cpu) {
+    result["cpu"] = *sample.cpu;
+  }
+  if (sample.maxRequestLatency) {
+    result["max_request_latency_us"] = sample.maxRequestLatency->count();
+  }
+  return result;
+}
+
+} // namespace
+
+ResourceGovernor::Limits ResourceGovernor::Limits::fromConfig(
+    const EdenConfig& config) {
+  Limits limits;
+  limits.interval = duration_cast<std::chrono::milliseconds>(
+      config.monitorGovernorInterval.getValue());
+  limits.residentBytes = config.monitorRssLimit.getValue();
+  limits.openFiles = config.monitorOpenFilesLimit.getValue();
+  limits.requestLatency = duration_cast<std::chrono::microseconds>(
+      config.monitorRequestLatencyLimit.getValue());
+  limits.compactionMaxCpu = config.monitorCompactionMaxCpu.getValue();
+  limits.actionCooldown = duration_cast<std::chrono::steady_clock::duration>(
+      config.monitorActionCooldown.getValue());
+  limits.unloadInodeAge = duration_cast<std::chrono::seconds>(
+      config.monitorUnloadInodeAge.getValue());
+  return limits;
+}
+
+ResourceGovernor::ResourceGovernor(
+    EdenMonitor* monitor,
+    Limits limits,
+    std::shared_ptr<LogFile> log)
+    : AsyncTimeout(monitor->getEventBase()),
+      monitor_{monitor},
+      limits_{limits},
+      log_{std::move(log)} {}
+
+ResourceGovernor::~ResourceGovernor() {}
+
+void ResourceGovernor::start() {
+  scheduleTimeout(limits_.interval);
+}
+
+folly::StringPiece ResourceGovernor::actionName(Action action) {
+  switch (action) {
+    case Action::ClearMemoryCaches:
+      return "clear_memory_caches";
+    case Action::UnloadInodes:
+      return "unload_inodes";
+    case Action::CompactLocalStore:
+      return "compact_local_store";
+  }
+  return "unknown";
+}
+
+std::optional<ResourceGovernor::Decision> ResourceGovernor::decide(
+    const Limits& limits,
+    const Sample& sample,
+    const LastRun& lastRun,
+    std::chrono::steady_clock::time_point now) {
+  auto ready = [&](Action action) {
+    const auto& last = lastRun[actionIndex(action)];
+    return !last || now - *last >= limits.actionCooldown;
+  };
+
+  if (limits.residentBytes != 0 && sample.residentBytes &&
+      *sample.residentBytes > limits.residentBytes) {
+    auto reason = fmt::format(
+        "resident set size of {} bytes above {}",
+        *sample.residentBytes,
+        limits.residentBytes);
+    // Inodes are only unloaded when clearing the caches wasn't enough, since
+    // reloading them costs more.
+    if (ready(Action::ClearMemoryCaches)) {
+      return Decision{Action::ClearMemoryCaches, std::move(reason)};
+    }
+    if (ready(Action::UnloadInodes)) {
+      return Decision{Action::UnloadInodes, std::move(reason)};
+    }
+  }
+
+  if (limits.openFiles != 0 && sample.openFiles &&
+      *sample.openFiles > limits.openFiles && ready(Action::UnloadInodes)) {
+    return Decision{
+        Action::UnloadInodes,
+        fmt::format(
+            "{} open files above {}", *sample.openFiles, limits.openFiles)};
+  }
+
+  // A compaction competes with the requests for the CPU, only ask for one
+  // when they are slow for another reason.
+  if (limits.requestLatency.count() != 0 && sample.maxRequestLatency &&
+      *sample.maxRequestLatency > limits.requestLatency && sample.cpu &&
+      *sample.cpu <= limits.compactionMaxCpu &&
+      ready(Action::CompactLocalStore)) {
+    return Decision{
+        Action::CompactLocalStore,
+        fmt::format(
+            "request running for {}us, above {}us",
+            sample.maxRequestLatency->count(),
+            limits.requestLatency.count())};
+  }
+
+  return std::nullopt;
+}
+
+void ResourceGovernor::timeoutExpired() noexcept {
+  folly::makeFutureWith([this] { return run(monitor_->getEdenPid()); })
+      .thenTry([this](folly::Try<Unit>&& result) {
+        if (result.hasException()) {
+          XLOG(WARN) << "error applying the EdenFS resource policies: "
+                     << result.exception().what();
+        }
+        scheduleTimeout(limits_.interval);
+      });
+}
+
+Future<Unit> ResourceGovernor::run(pid_t pid) {
+  return takeSample(pid).thenValue([this](Sample sample) {
+    if (pending_) {
+      record(*pending_, sample);
+      pending_.reset();
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    auto decision = decide(limits_, sample, lastRun_, now);
+    if (!decision) {
+      return folly::makeFuture();
+    }
+    XLOG(INFO) << "asking EdenFS to " << actionName(decision->action) << ": "
+               << decision->reason;
+    auto action = decision->action;
+    lastRun_[actionIndex(action)] = now;
+    pending_ = PendingAction{std::move(*decision), std::move(sample), {}};
+    return apply(action).thenError([this](folly::exception_wrapper&& ew) {
+      XLOG(WARN) << "EdenFS failed to " << actionName(pending_->decision.action)
+                 << ": " << ew.what();
+      pending_->error = ew.what().toStdString();
+    });
+  });
+}
+
+Future<ResourceGovernor::Sample> ResourceGovernor::takeSample(pid_t pid) {
+  Sample sample;
+  auto procDir = AbsolutePath{fmt::format("/proc/{}", pid)};
+
+  if (auto stats = proc_util::readStatmFile(procDir + "statm"_pc)) {
+    sample.residentBytes = stats->resident;
+  }
+  sample.openFiles = countOpenFiles(procDir + "fd"_pc);
+
+  auto stat = readFile(procDir + "stat"_pc);
+  auto ticks = stat.hasValue() ? proc_util::parseStatCpuTicks(stat.value())
+                               : std::nullopt;
+  auto ticksPerSecond = sysconf(_SC_CLK_TCK);
+  if (ticks && ticksPerSecond > 0) {
+    auto now = std::chrono::steady_clock::now();
+    if (lastCpuTime_ && lastCpuTime_->pid == pid &&
+        *ticks >= lastCpuTime_->ticks) {
+      auto elapsed =
+          std::chrono::duration<double>{now - lastCpuTime_->time}.count();
+      if (elapsed > 0) {
+        sample.cpu = static_cast<double>(*ticks - lastCpuTime_->ticks) /
+            ticksPerSecond / elapsed;
+      }
+    }
+    lastCpuTime_ = CpuTime{pid, *ticks, now};
+  }
+
+  auto client = monitor_->createEdenThriftClient();
+  return client->future_getRegexCounters(kLiveRequestLatencyCounters.str())
+      .thenTry([client, sample = std::move(sample)](auto&& counters) mutable {
+        if (counters.hasValue()) {
+          std::chrono::microseconds latency{0};
+          for (const auto& counter : counters.value()) {
+            latency =
+                std::max(latency, std::chrono::microseconds{counter.second});
+          }
+          sample.maxRequestLatency = latency;
+        }
+        return std::move(sample);
+      });
+}
+
+Future<Unit> ResourceGovernor::apply(Action action) {
+  auto client = monitor_->createEdenThriftClient();
+  switch (action) {
+    case Action::ClearMemoryCaches:
+      return client->future_clearMemoryCaches().ensure([client] {});
+    case Action::CompactLocalStore:
+      return client->future_debugCompactLocalStorage().ensure([client] {});
+    case Action::UnloadInodes:
+      return client->future_listMounts().thenValue(
+          [client, age = limits_.unloadInodeAge](
+              std::vector<MountInfo> mounts) {
+            TimeSpec timeSpec;
+            timeSpec.seconds() = age.count();
+            timeSpec.nanoSeconds() = 0;
+            std::vector<Future<int64_t>> unloads;
+            for (const auto& mount : mounts) {
+              unloads.push_back(client->future_unloadInodeForPath(
+                  *mount.mountPoint(), "", timeSpec));
+            }
+            return folly::collectUnsafe(std::move(unloads))
+                .ensure([client] {})
+                .unit();
+          });
+  }
+  return folly::makeFuture<Unit>(std::logic_error("unknown action"));
+}
+
+void ResourceGovernor::record(
+    const PendingAction& action,
+    const Sample& after) {
+  auto now = std::chrono::system_clock::now();
+  folly::dynamic entry = folly::dynamic::object(
+      "time",
+      duration_cast<std::chrono::seconds>(now.time_since_epoch()).count())(
+      "action", actionName(action.decision.action))(
+      "reason", action.decision.reason)(
+      "before", sampleToDynamic(action.before))(
+      "after", sampleToDynamic(after));
+  if (action.error) {
+    entry["error"] = *action.error;
+  }
+
+  auto line = folly::toJson(entry) + "\n";
+  if (auto error = log_->write(line.data(), line.size())) {
+    XLOG(WARN) << "error recording EdenFS resource policy action: "
+               << folly::errnoStr(error);
+  }
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <sys/types.h>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include <folly/Range.h>
+#include <folly/io/async/AsyncTimeout.h>
+
+namespace folly {
+template <typename T>
+class Future;
+struct Unit;
+} // namespace folly
+
+namespace facebook::eden {
+
+class EdenConfig;
+class EdenMonitor;
+class LogFile;
+
+/**
+ * ResourceGovernor periodically samples the resources used by the EdenFS
+ * process, and asks it over Thrift to release some of them before they run
+ * out: clearing its memory caches, unloading inodes or compacting its
+ * LocalStore.
+ *
+ * Each action is appended as a JSON line to a LogFile, along with the sample
+ * that triggered it and the one that followed, so that the effect of the
+ * policies can be measured.
+ *
+ * Like the rest of the monitor it runs on the EdenMonitor's EventBase thread.
+ */
+class ResourceGovernor : private folly::AsyncTimeout {
+ public:
+  struct Limits {
+    std::chrono::milliseconds interval{0};
+    /** 0 means no limit, as for the other limits. */
+    uint64_t residentBytes{0};
+    uint64_t openFiles{0};
+    std::chrono::microseconds requestLatency{0};
+    /** EdenFS isn't asked to compact while it uses more cores than this. */
+    double compactionMaxCpu{0};
+    std::chrono::steady_clock::duration actionCooldown{0};
+    std::chrono::seconds unloadInodeAge{0};
+
+    static Limits fromConfig(const EdenConfig& config);
+  };
+
+  struct Sample {
+    std::optional<uint64_t> residentBytes;
+    std::optional<uint64_t> openFiles;
+    /** Cores used on average since the previous sample. */
+    std::optional<double> cpu;
+    /** How long the oldest filesystem request still running has been. */
+    std::optional<std::chrono::microseconds> maxRequestLatency;
+  };
+
+  enum class Action : uint8_t {
+    ClearMemoryCaches,
+    UnloadInodes,
+    CompactLocalStore,
+  };
+  static constexpr size_t kActionCount = 3;
+
+  struct Decision {
+    Action action;
+    std::string reason;
+  };
+
+  /** When each action last ran, indexed by Action. */
+  using LastRun = std::array<
+      std::optional<std::chrono::steady_clock::time_point>,
+      kActionCount>;
+
+  ResourceGovernor(
+      EdenMonitor* monitor,
+      Limits limits,
+      std::shared_ptr<LogFile> log);
+  ~ResourceGovernor() override;
+
+  void start();
+
+  static folly::StringPiece actionName(Action action);
+
+  /**
+   * Pick the action to apply for `sample`, skipping the ones that ran less
+   * than limits.actionCooldown before `now`.
+   *
+   * At most one action is picked at a time, so that the next sample shows
+   * its effect.
+   */
+  static std::optional<Decision> decide(
+      const Limits& limits,
+      const Sample& sample,
+      const LastRun& lastRun,
+      std::chrono::steady_clock::time_point now);
+
+ private:
+  struct CpuTime {
+    pid_t pid;
+    uint64_t ticks;
+    std::chrono::steady_clock::time_point time;
+  };
+
+  /** An action waiting for the next sample to be recorded. */
+  struct PendingAction {
+    Decision decision;
+    Sample before;
+    std::optional<std::string> error;
+  };
+
+  ResourceGovernor(ResourceGovernor const&) = delete;
+  ResourceGovernor& operator=(ResourceGovernor const&) = delete;
+
+  void timeoutExpired() noexcept override;
+
+  folly::Future<folly::Unit> run(pid_t pid);
+  folly::Future<Sample> takeSample(pid_t pid);
+  folly::Future<folly::Unit> apply(Action action);
+  void record(const PendingAction& action, const Sample& after);
+
+  /*
+   * The EdenMonitor owns us, and will destroy us before it is destroyed.
+   */
+  EdenMonitor* const monitor_;
+  const Limits limits_;
+  std::shared_ptr<LogFile> log_;
+
+  LastRun lastRun_;
+  std::optional<CpuTime> lastCpuTime_;
+  std::optional<PendingAction> pending_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/monitor/ResourceGovernor.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace std::chrono_literals;
+
+namespace facebook::eden {
+
+namespace {
+
+using Action = ResourceGovernor::Action;
+
+ResourceGovernor::Limits makeLimits() {
+  ResourceGovernor::Limits limits;
+  limits.interval = 1min;
+  limits.residentBytes = 1000;
+  limits.openFiles = 100;
+  limits.requestLatency = 1s;
+  limits.compactionMaxCpu = 0.5;
+  limits.actionCooldown = 10min;
+  return limits;
+}
+
+std::optional<Action> decide(
+    const ResourceGovernor::Sample& sample,
+    const ResourceGovernor::LastRun& lastRun = {},
+    std::chrono::steady_clock::time_point now = {}) {
+  auto decision = ResourceGovernor::decide(makeLimits(), sample, lastRun, now);
+  if (!decision) {
+    return std::nullopt;
+  }
+  return decision->action;
+}
+
+} // namespace
+
+TEST(ResourceGovernor, nothingToDoUnderTheLimits) {
+  ResourceGovernor::Sample sample;
+  sample.residentBytes = 1000;
+  sample.openFiles = 100;
+  sample.cpu = 0.1;
+  sample.maxRequestLatency = 1s;
+  EXPECT_EQ(std::nullopt, decide(sample));
+  EXPECT_EQ(std::nullopt, decide(ResourceGovernor::Sample{}));
+}
+
+TEST(ResourceGovernor, unlimitedWhenZero) {
+  ResourceGovernor::Sample sample;
+  sample.residentBytes = 1 << 30;
+  auto limits = makeLimits();
+  limits.residentBytes = 0;
+  EXPECT_EQ(std::nullopt, ResourceGovernor::decide(limits, sample, {}, {}));
+}
+
+TEST(ResourceGovernor, rssClearsCachesThenUnloadsInodes) {
+  ResourceGovernor::Sample sample;
+  sample.residentBytes = 2000;
+  auto start = std::chrono::steady_clock::time_point{} + 1h;
+  ResourceGovernor::LastRun lastRun;
+  EXPECT_EQ(Action::ClearMemoryCaches, decide(sample, lastRun, start));
+
+  lastRun[static_cast<size_t>(Action::ClearMemoryCaches)] = start;
+  EXPECT_EQ(Action::UnloadInodes, decide(sample, lastRun, start + 1min));
+
+  lastRun[static_cast<size_t>(Action::UnloadInodes)] = start + 1min;
+  EXPECT_EQ(std::nullopt, decide(sample, lastRun, start + 2min));
+
+  // The caches can be cleared again once the cooldown passed.
+  EXPECT_EQ(Action::ClearMemoryCaches, decide(sample, lastRun, start + 10min));
+}
+
+TEST(ResourceGovernor, openFilesUnloadInodes) {
+  ResourceGovernor::Sample sample;
+  sample.openFiles = 200;
+  EXPECT_EQ(Action::UnloadInodes, decide(sample));
+}
+
+TEST(ResourceGovernor, slowRequestsCompactWhenTheCpuIsIdle) {
+  ResourceGovernor::Sample sample;
+  sample.maxRequestLatency = 2s;
+  // Compactions aren't requested before the CPU usage is known.
+  EXPECT_EQ(std::nullopt, decide(sample));
+
+  sample.cpu = 0.2;
+  EXPECT_EQ(Action::CompactLocalStore, decide(sample));
+
+  sample.cpu = 1.5;
+  EXPECT_EQ(std::nullopt, decide(sample));
+}
+
+TEST(ResourceGovernor, decisionsExplainTheirReason) {
+  ResourceGovernor::Sample sample;
+  sample.openFiles = 200;
+  auto decision = ResourceGovernor::decide(makeLimits(), sample, {}, {});
+  ASSERT_TRUE(decision);
+  EXPECT_EQ("200 open files above 100", decision->reason);
+  EXPECT_EQ("unload_inodes", ResourceGovernor::actionName(decision->action));
+}
+
+} // namespace facebook::eden
@@ -51,7 +51,7 @@ bool NfsDirList::add(
     folly::StringPiece name,
     InodeNumber ino,
     uint64_t offset) {
-  auto fn = [name, ino, offset](auto&& list, uint32_t& remainingSize) {
+  auto fn = [this, name, ino, offset](auto&& list, uint32_t& remainingSize) {
     size_t neededSize;
     using ListType = std::decay_t<decltype(list->list)>;
     using EntryT = typename ListType::value_type;
@@ -72,6 +72,14 @@ bool NfsDirList::add(
     }
 
     remainingSize -= neededSize;
+    entriesSize_ += neededSize;
+    if constexpr (std::is_same_v<EntryT, entryplus3>) {
+      // The attributes don't count towards the size limit, but do make it
+      // to the reply.
+      entriesSize_ +=
+          XdrTrait<post_op_attr>::serializedSize(post_op_attr{fattr3{}}) -
+          XdrTrait<post_op_attr>::serializedSize(entry.name_attributes);
+    }
     list->list.push_back(std::move(entry));
     return true;
   };
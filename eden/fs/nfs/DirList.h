@@ -43,6 +43,15 @@ class NfsDirList {
    */
   bool add(folly::StringPiece name, InodeNumber ino, uint64_t offset);
 
+  /**
+   * Return the serialized size of the READDIR3resok or READDIRPLUS3resok
+   * holding the entries added so far, once the attributes of the entryplus3
+   * are filled in. This allows the reply buffer to be allocated at once.
+   */
+  size_t getSerializedSize() const {
+    return kNfsDirListInitialOverhead + entriesSize_;
+  }
+
   /**
    * Move the built list out of the NfsDirList.
    */
@@ -63,6 +72,7 @@ class NfsDirList {
 
  private:
   uint32_t remaining_;
+  size_t entriesSize_{0};
   std::variant<XdrList<entry3>, XdrList<entryplus3>> list_{};
 };
 
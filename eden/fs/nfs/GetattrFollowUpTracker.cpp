@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/nfs/GetattrFollowUpTracker.h"
+
+#include <folly/hash/Hash.h>
+
+namespace facebook::eden {
+
+GetattrFollowUpTracker::GetattrFollowUpTracker(
+    std::chrono::nanoseconds window,
+    size_t numSlots)
+    : window_{window}, slots_(numSlots) {}
+
+folly::Synchronized<GetattrFollowUpTracker::Slot, std::mutex>&
+GetattrFollowUpTracker::getSlot(InodeNumber ino) {
+  return slots_[folly::hash::twang_mix64(ino.get()) % slots_.size()];
+}
+
+void GetattrFollowUpTracker::recordCompletion(
+    InodeNumber ino,
+    uint32_t procNumber,
+    Clock::time_point now) {
+  auto slot = getSlot(ino).lock();
+  slot->ino = ino;
+  slot->procNumber = procNumber;
+  slot->completionTime = now;
+}
+
+std::optional<uint32_t> GetattrFollowUpTracker::getattrReceived(
+    InodeNumber ino,
+    Clock::time_point now) {
+  auto slot = getSlot(ino).lock();
+  if (slot->ino != ino || now - slot->completionTime >= window_) {
+    return std::nullopt;
+  }
+  slot->ino = InodeNumber{};
+  return slot->procNumber;
+}
+
+} // namespace facebook::eden
+
+#endif
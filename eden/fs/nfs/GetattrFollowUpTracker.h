@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#ifndef _WIN32
+
+#include <folly/Synchronized.h>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "eden/fs/inodes/InodeNumber.h"
+
+namespace facebook::eden {
+
+/**
+ * Remembers the last procedure that completed on each inode, to find the
+ * GETATTR calls that follow closely after another procedure on the same inode.
+ * These usually mean the reply of that procedure lacked the attributes the
+ * client wanted.
+ *
+ * To keep the per-request cost constant, inodes are hashed into a fixed number
+ * of slots, each only remembering the latest procedure of one inode. Some
+ * follow-ups are thus missed when recently used inodes collide, which is fine
+ * for a statistic.
+ */
+class GetattrFollowUpTracker {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit GetattrFollowUpTracker(
+      std::chrono::nanoseconds window = std::chrono::milliseconds{1},
+      size_t numSlots = 1024);
+
+  /**
+   * Record that the procedure procNumber on ino completed at time now.
+   */
+  void recordCompletion(
+      InodeNumber ino,
+      uint32_t procNumber,
+      Clock::time_point now = Clock::now());
+
+  /**
+   * Called when a GETATTR on ino is received at time now. Return the procedure
+   * that completed on ino less than window ago, if any. That procedure is then
+   * forgotten, so that it is only blamed for one GETATTR.
+   */
+  std::optional<uint32_t> getattrReceived(
+      InodeNumber ino,
+      Clock::time_point now = Clock::now());
+
+ private:
+  struct Slot {
+    InodeNumber ino;
+    uint32_t procNumber{0};
+    Clock::time_point completionTime;
+  };
+
+  folly::Synchronized<Slot, std::mutex>& getSlot(InodeNumber ino);
+
+  const std::chrono::nanoseconds window_;
+  std::vector<folly::Synchronized<Slot, std::mutex>> slots_;
+};
+
+} // namespace facebook::eden
+
+#endif
@@ -147,6 +147,15 @@ class NfsDispatcher {
       off_t offset,
       const ObjectFetchContextPtr& context) = 0;
 
+  /**
+   * Make the data previously written to the file referenced by the
+   * InodeNumber ino durable. If datasync is true, only the data and the
+   * metadata needed to read it back are flushed.
+   */
+  virtual ImmediateFuture<folly::Unit> fsync(
+      InodeNumber ino,
+      bool datasync) = 0;
+
   /**
    * Return value of the create method.
    */
@@ -169,7 +178,9 @@ class NfsDispatcher {
    * atomic manner: no other operation on the directory needs to be allowed in
    * between them. This is to ensure that the NFS client can properly detect if
    * its cache needs to be invalidated. Setting them both to std::nullopt is an
-   * acceptable approach if the stat cannot be collected atomically.
+   * acceptable approach if the stat cannot be collected atomically. So is
+   * only returning the post stat, which spares the client a GETATTR to
+   * refresh the attributes of the directory.
    */
   virtual ImmediateFuture<CreateRes> create(
       InodeNumber dir,
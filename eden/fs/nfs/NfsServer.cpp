@@ -9,6 +9,7 @@
 
 #include "eden/fs/nfs/NfsServer.h"
 
+#include <folly/executors/IOThreadPoolExecutor.h>
 #include <folly/executors/thread_factory/NamedThreadFactory.h>
 #include "eden/fs/nfs/Nfsd3.h"
 #include "eden/fs/utils/EdenTaskQueue.h"
@@ -19,12 +20,22 @@ NfsServer::NfsServer(
     folly::EventBase* evb,
     uint64_t numServicingThreads,
     uint64_t maxInflightRequests,
+    uint64_t numIoThreads,
+    uint64_t maxInflightRequestsPerConnection,
     const std::shared_ptr<StructuredLogger>& structuredLogger)
     : evb_(evb),
       threadPool_(std::make_shared<folly::CPUThreadPoolExecutor>(
           numServicingThreads,
           std::make_unique<EdenTaskQueue>(maxInflightRequests),
           std::make_unique<folly::NamedThreadFactory>("NfsThreadPool"))),
+      ioExecutor_(
+          numIoThreads == 0
+              ? nullptr
+              : std::make_shared<folly::IOThreadPoolExecutor>(
+                    numIoThreads,
+                    std::make_shared<folly::NamedThreadFactory>(
+                        "NfsIoThread"))),
+      maxInflightRequestsPerConnection_(maxInflightRequestsPerConnection),
       mountd_(evb_, threadPool_, structuredLogger) {}
 
 void NfsServer::initialize(
@@ -49,10 +60,13 @@ NfsServer::NfsMountInfo NfsServer::registerMount(
     std::shared_ptr<Notifier> notifier,
     CaseSensitivity caseSensitive,
     uint32_t iosize,
+    size_t numConnections,
     size_t traceBusCapacity) {
   auto nfsd = std::make_unique<Nfsd3>(
       evb_,
       threadPool_,
+      ioExecutor_,
+      maxInflightRequestsPerConnection_,
       std::move(dispatcher),
       straceLogger,
       std::move(processNameCache),
@@ -62,6 +76,7 @@ NfsServer::NfsMountInfo NfsServer::registerMount(
       std::move(notifier),
       caseSensitive,
       iosize,
+      numConnections,
       traceBusCapacity);
   mountd_.registerMount(path, rootIno);
 
@@ -16,7 +16,8 @@
 
 namespace folly {
 class Executor;
-}
+class IOExecutor;
+} // namespace folly
 
 namespace facebook::eden {
 
@@ -33,6 +34,10 @@ class NfsServer {
    * blocking thread pool initialized with numServicingThreads and
    * maxInflightRequests.
    *
+   * If numIoThreads isn't 0, the nfsd connections are served by a pool of
+   * that many IO threads, rather than all on evb. Each of them processes at
+   * most maxInflightRequestsPerConnection requests at once, 0 for no limit.
+   *
    * One mountd program will be created per NfsServer, while one nfsd program
    * will be created per-mount point, this allows nfsd program to be only aware
    * of its own mount point which greatly simplifies it.
@@ -41,6 +46,8 @@ class NfsServer {
       folly::EventBase* evb,
       uint64_t numServicingThreads,
       uint64_t maxInflightRequests,
+      uint64_t numIoThreads,
+      uint64_t maxInflightRequestsPerConnection,
       const std::shared_ptr<StructuredLogger>& structuredLogger);
 
   /**
@@ -63,7 +70,8 @@ class NfsServer {
    * Register a path as the root of a mount point.
    *
    * This will create an nfs program for that mount point and register it with
-   * the mountd program.
+   * the mountd program. numConnections is the number of connections that the
+   * client will open to it.
    *
    * @return: the created nfsd program as well as a tuple that holds the TCP
    * port number that mountd and nfsd are listening to.
@@ -80,6 +88,7 @@ class NfsServer {
       std::shared_ptr<Notifier> notifier,
       CaseSensitivity caseSensitive,
       uint32_t iosize,
+      size_t numConnections,
       size_t traceBusCapacity);
 
   /**
@@ -107,6 +116,8 @@ class NfsServer {
  private:
   folly::EventBase* evb_;
   std::shared_ptr<folly::Executor> threadPool_;
+  std::shared_ptr<folly::IOExecutor> ioExecutor_;
+  uint64_t maxInflightRequestsPerConnection_;
   Mountd mountd_;
 };
 
@@ -10,10 +10,12 @@
 
 #include <memory>
 
+#include <folly/Random.h>
 #include <folly/Utility.h>
 #include <folly/executors/SerialExecutor.h>
 #include <folly/futures/Future.h>
 
+#include "eden/fs/nfs/GetattrFollowUpTracker.h"
 #include "eden/fs/nfs/NfsRequestContext.h"
 #include "eden/fs/nfs/NfsUtils.h"
 #include "eden/fs/nfs/NfsdRpc.h"
@@ -38,6 +40,18 @@ namespace facebook::eden {
 namespace {
 static_assert(CheckSize<NfsTraceEvent, 40>());
 
+/**
+ * Generate a unique per-EdenFS instance write cookie.
+ *
+ * UNSTABLE writes may only be buffered in memory until they are committed.
+ * Clients keep the data of the writes they haven't committed yet and re-send
+ * it when the cookie returned by COMMIT differs from the one of the WRITE,
+ * which is how they learn that a restarted EdenFS may have lost it.
+ */
+writeverf3 makeWriteVerf() {
+  return folly::Random::rand64();
+}
+
 class Nfsd3ServerProcessor final : public RpcServerProcessor {
  public:
   explicit Nfsd3ServerProcessor(
@@ -46,6 +60,7 @@ class Nfsd3ServerProcessor final : public RpcServerProcessor {
       const std::shared_ptr<StructuredLogger>& structuredLogger,
       CaseSensitivity caseSensitive,
       uint32_t iosize,
+      size_t numConnections,
       folly::Promise<Nfsd3::StopData>& stopPromise,
       ProcessAccessLog& processAccessLog,
       std::atomic<size_t>& traceDetailedArguments,
@@ -55,10 +70,12 @@ class Nfsd3ServerProcessor final : public RpcServerProcessor {
         structuredLogger_(structuredLogger),
         caseSensitive_(caseSensitive),
         iosize_(iosize),
+        numConnections_(numConnections),
         stopPromise_{stopPromise},
         processAccessLog_{processAccessLog},
         traceDetailedArguments_(traceDetailedArguments),
-        traceBus_(traceBus) {}
+        traceBus_(traceBus),
+        writeVerf_{makeWriteVerf()} {}
 
   Nfsd3ServerProcessor(const Nfsd3ServerProcessor&) = delete;
   Nfsd3ServerProcessor(Nfsd3ServerProcessor&&) = delete;
@@ -179,11 +196,16 @@ class Nfsd3ServerProcessor final : public RpcServerProcessor {
   // this server processor. This promise should only be used during the
   // lifetime of  nfs3d. The way we currently enforce this is by waiting for
   // this promise to be set before destroying of the nfs3d.
+  const size_t numConnections_;
   folly::Promise<Nfsd3::StopData>& stopPromise_;
   ProcessAccessLog& processAccessLog_;
-  std::atomic_int32_t numberOfClients_;
+  // Connections that are open or still shutting down.
+  std::atomic_int32_t numberOfClients_{0};
   std::atomic<size_t>& traceDetailedArguments_;
   std::shared_ptr<TraceBus<NfsTraceEvent>>& traceBus_;
+  // Returned by WRITE and COMMIT, see makeWriteVerf.
+  const writeverf3 writeVerf_;
+  GetattrFollowUpTracker getattrFollowUps_;
 };
 
 /**
@@ -561,6 +583,9 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::read(
           context.getObjectFetchContext())
       .thenTry([this, ser = std::move(ser), ino = args.file.ino, &context](
                    folly::Try<NfsDispatcher::ReadRes> tryRead) mutable {
+        if (tryRead.hasValue()) {
+          context.setBytesRead(tryRead->data->computeChainDataLength());
+        }
         return dispatcher_->getattr(ino, context.getObjectFetchContext())
             .thenTry([ser = std::move(ser), tryRead = std::move(tryRead)](
                          const folly::Try<struct stat>& tryStat) mutable {
@@ -585,31 +610,20 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::read(
                 XDCHECK_LE(
                     length, size_t{std::numeric_limits<uint32_t>::max()});
 
-                READ3res res{
-                    {{nfsstat3::NFS3_OK,
-                      READ3resok{
-                          /*file_attributes*/ statToPostOpAttr(tryStat),
-                          /*count*/ folly::to_narrow(length),
-                          /*eof*/ read.isEof,
-                          /*data*/ std::move(read.data),
-                      }}}};
-                XdrTrait<READ3res>::serialize(ser, res);
+                serializeReadResOk(
+                    ser,
+                    READ3resok{
+                        /*file_attributes*/ statToPostOpAttr(tryStat),
+                        /*count*/ folly::to_narrow(length),
+                        /*eof*/ read.isEof,
+                        /*data*/ std::move(read.data),
+                    });
               }
               return folly::unit;
             });
       });
 }
 
-/**
- * Generate a unique per-EdenFS instance write cookie.
- *
- * TODO(xavierd): Note that for now this will always be 0 as this is to handle
- * the case where the server restart while the client isn't aware.
- */
-writeverf3 makeWriteVerf() {
-  return 0;
-}
-
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::write(
     folly::io::Cursor deser,
     folly::io::QueueAppender ser,
@@ -623,13 +637,27 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::write(
   queue.append(std::move(args.data));
   auto data = queue.split(args.count);
 
+  // UNSTABLE writes are left in the write buffers of the overlay, or in the
+  // page cache, until the client sends a COMMIT. The other ones have to be
+  // durable before we reply.
+  auto ino = args.file.ino;
+  auto stable = args.stable;
   return dispatcher_
       ->write(
-          args.file.ino,
-          std::move(data),
-          args.offset,
-          context.getObjectFetchContext())
-      .thenTry([ser = std::move(ser)](
+          ino, std::move(data), args.offset, context.getObjectFetchContext())
+      .thenValue(
+          [this, ino, stable](NfsDispatcher::WriteRes&& writeRes)
+              -> ImmediateFuture<NfsDispatcher::WriteRes> {
+            if (stable == stable_how::UNSTABLE) {
+              return std::move(writeRes);
+            }
+            return dispatcher_
+                ->fsync(ino, /*datasync=*/stable == stable_how::DATA_SYNC)
+                .thenValue([writeRes = std::move(writeRes)](auto&&) mutable {
+                  return std::move(writeRes);
+                });
+          })
+      .thenTry([this, stable, ser = std::move(ser)](
                    folly::Try<NfsDispatcher::WriteRes> writeTry) mutable {
         if (writeTry.hasException()) {
           WRITE3res res{
@@ -650,13 +678,8 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::write(
                     /*file_wcc*/ statToWccData(
                         writeRes.preStat, writeRes.postStat),
                     /*count*/ folly::to_narrow(writeRes.written),
-                    // TODO(xavierd): the following is a total lie and we
-                    // should call inode->fdatasync() in the case where
-                    // args.stable is anything other than
-                    // stable_how::UNSTABLE. For testing purpose, this is
-                    // OK.
-                    /*committed*/ stable_how::FILE_SYNC,
-                    /*verf*/ makeWriteVerf(),
+                    /*committed*/ stable,
+                    /*verf*/ writeVerf_,
                 }}}};
           XdrTrait<WRITE3res>::serialize(ser, res);
         }
@@ -1138,6 +1161,19 @@ uint64_t getReaddirCookieverf() {
   return 0;
 }
 
+/**
+ * Allocate the room for a successful READDIR or READDIRPLUS reply holding
+ * entries at once, rather than growing the reply buffer one small buffer at
+ * a time while serializing it.
+ */
+void reserveDirListReply(
+    folly::io::QueueAppender& ser,
+    const NfsDirList& entries) {
+  ser.ensure(
+      XdrTrait<nfsstat3>::serializedSize(nfsstat3::NFS3_OK) +
+      entries.getSerializedSize());
+}
+
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdir(
     folly::io::Cursor deser,
     folly::io::QueueAppender ser,
@@ -1169,6 +1205,7 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdir(
                 XdrTrait<READDIR3res>::serialize(ser, res);
               } else {
                 auto& readdirRes = try_.value();
+                reserveDirListReply(ser, readdirRes.entries);
 
                 READDIR3res res{
                     {{nfsstat3::NFS3_OK,
@@ -1221,6 +1258,7 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::readdirplus(
                 XdrTrait<READDIRPLUS3res>::serialize(ser, res);
               } else {
                 auto& readdirRes = try_.value();
+                reserveDirListReply(ser, readdirRes.entries);
                 /* TODO @cuev: This is prob where we'd use args.maxcount:
                  *
                  * From rfc 1813 section 3.3.17:
@@ -1295,28 +1333,31 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::fsinfo(
     NfsRequestContext& context) {
   serializeReply(ser, accept_stat::SUCCESS, context.getXid());
   auto args = XdrTrait<FSINFO3args>::deserialize(deser);
-  (void)args;
-
-  FSINFO3res res{
-      {{nfsstat3::NFS3_OK,
-        FSINFO3resok{
-            // TODO(xavierd): fill the post_op_attr.
-            post_op_attr{},
-            /*rtmax=*/iosize_,
-            /*rtpref=*/iosize_,
-            /*rtmult=*/1,
-            /*wtmax=*/iosize_,
-            /*wtpref=*/iosize_,
-            /*wtmult=*/1,
-            /*dtpref=*/iosize_,
-            /*maxfilesize=*/std::numeric_limits<uint64_t>::max(),
-            nfstime3{0, 1},
-            /*properties*/ FSF3_SYMLINK | FSF3_HOMOGENEOUS | FSF3_CANSETTIME,
-        }}}};
-
-  XdrTrait<FSINFO3res>::serialize(ser, res);
 
-  return folly::unit;
+  return dispatcher_->getattr(args.fsroot.ino, context.getObjectFetchContext())
+      .thenTry([this, ser = std::move(ser)](
+                   const folly::Try<struct stat>& statTry) mutable {
+        FSINFO3res res{
+            {{nfsstat3::NFS3_OK,
+              FSINFO3resok{
+                  /*obj_attributes*/ statToPostOpAttr(statTry),
+                  /*rtmax=*/iosize_,
+                  /*rtpref=*/iosize_,
+                  /*rtmult=*/1,
+                  /*wtmax=*/iosize_,
+                  /*wtpref=*/iosize_,
+                  /*wtmult=*/1,
+                  /*dtpref=*/iosize_,
+                  /*maxfilesize=*/std::numeric_limits<uint64_t>::max(),
+                  nfstime3{0, 1},
+                  /*properties*/ FSF3_SYMLINK | FSF3_HOMOGENEOUS |
+                      FSF3_CANSETTIME,
+              }}}};
+
+        XdrTrait<FSINFO3res>::serialize(ser, res);
+
+        return folly::unit;
+      });
 }
 
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::pathconf(
@@ -1325,32 +1366,68 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::pathconf(
     NfsRequestContext& context) {
   serializeReply(ser, accept_stat::SUCCESS, context.getXid());
   auto args = XdrTrait<PATHCONF3args>::deserialize(deser);
-  (void)args;
-
-  PATHCONF3res res{
-      {{nfsstat3::NFS3_OK,
-        PATHCONF3resok{
-            // TODO(xavierd): fill up the post_op_attr
-            post_op_attr{},
-            /*linkmax=*/0,
-            /*name_max=*/NAME_MAX,
-            /*no_trunc=*/true,
-            /*chown_restricted=*/true,
-            /*case_insensitive=*/caseSensitive_ == CaseSensitivity::Insensitive,
-            /*case_preserving=*/true,
-        }}}};
-
-  XdrTrait<PATHCONF3res>::serialize(ser, res);
 
-  return folly::unit;
+  return dispatcher_->getattr(args.object.ino, context.getObjectFetchContext())
+      .thenTry([this, ser = std::move(ser)](
+                   const folly::Try<struct stat>& statTry) mutable {
+        PATHCONF3res res{
+            {{nfsstat3::NFS3_OK,
+              PATHCONF3resok{
+                  /*obj_attributes*/ statToPostOpAttr(statTry),
+                  /*linkmax=*/0,
+                  /*name_max=*/NAME_MAX,
+                  /*no_trunc=*/true,
+                  /*chown_restricted=*/true,
+                  /*case_insensitive=*/caseSensitive_ ==
+                      CaseSensitivity::Insensitive,
+                  /*case_preserving=*/true,
+              }}}};
+
+        XdrTrait<PATHCONF3res>::serialize(ser, res);
+
+        return folly::unit;
+      });
 }
 
 ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::commit(
-    folly::io::Cursor /*deser*/,
+    folly::io::Cursor deser,
     folly::io::QueueAppender ser,
     NfsRequestContext& context) {
-  serializeReply(ser, accept_stat::PROC_UNAVAIL, context.getXid());
-  return folly::unit;
+  serializeReply(ser, accept_stat::SUCCESS, context.getXid());
+  auto args = XdrTrait<COMMIT3args>::deserialize(deser);
+
+  // The overlay has no cheaper way to flush a range of the file than the
+  // whole of it, the offset and count are thus ignored.
+  return dispatcher_->fsync(args.file.ino, /*datasync=*/true)
+      .thenTry([this, ser = std::move(ser), ino = args.file.ino, &context](
+                   folly::Try<folly::Unit> fsyncTry) mutable {
+        return dispatcher_->getattr(ino, context.getObjectFetchContext())
+            .thenTry([this,
+                      ser = std::move(ser),
+                      fsyncTry = std::move(fsyncTry)](
+                         const folly::Try<struct stat>& statTry) mutable {
+              auto fileWcc = wcc_data{
+                  /*before*/ pre_op_attr{},
+                  /*after*/ statToPostOpAttr(statTry),
+              };
+              if (fsyncTry.hasException()) {
+                COMMIT3res res{
+                    {{exceptionToNfsError(fsyncTry.exception()),
+                      COMMIT3resfail{std::move(fileWcc)}}}};
+                XdrTrait<COMMIT3res>::serialize(ser, res);
+              } else {
+                COMMIT3res res{
+                    {{nfsstat3::NFS3_OK,
+                      COMMIT3resok{
+                          /*file_wcc*/ std::move(fileWcc),
+                          /*verf*/ writeVerf_,
+                      }}}};
+                XdrTrait<COMMIT3res>::serialize(ser, res);
+              }
+
+              return folly::unit;
+            });
+      });
 }
 
 NfsArgsDetails formatNull(folly::io::Cursor /*deser*/) {
@@ -1627,9 +1704,15 @@ NfsArgsDetails formatPathconf(folly::io::Cursor deser) {
   return {fmt::format(FMT_STRING("ino={}"), args.object.ino), args.object.ino};
 }
 
-NfsArgsDetails formatCommit(folly::io::Cursor /*deser*/) {
-  // TODO(xavierd): Fill this in.
-  return {""};
+NfsArgsDetails formatCommit(folly::io::Cursor deser) {
+  auto args = XdrTrait<COMMIT3args>::deserialize(deser);
+  return {
+      fmt::format(
+          FMT_STRING("ino={}, offset={}, count={}"),
+          args.file.ino,
+          args.offset,
+          args.count),
+      args.file.ino};
 }
 
 using Handler = ImmediateFuture<folly::Unit> (Nfsd3ServerProcessor::*)(
@@ -1651,12 +1734,14 @@ struct HandlerEntry {
       Handler h,
       FormatArgs format,
       NfsStats::DurationPtr s,
+      NfsStats::CounterPtr getattrAfter,
       AccessType at = AccessType::FsChannelOther,
       SamplingGroup samplingGroup = SamplingGroup::DropAll)
       : name(n),
         handler(h),
         formatArgs(format),
         stat{s},
+        getattrAfter{getattrAfter},
         accessType(at),
         samplingGroup{samplingGroup} {}
 
@@ -1664,6 +1749,8 @@ struct HandlerEntry {
   Handler handler = nullptr;
   FormatArgs formatArgs = nullptr;
   NfsStats::DurationPtr stat = nullptr;
+  // Bumped when a GETATTR on the same inode follows this procedure.
+  NfsStats::CounterPtr getattrAfter = nullptr;
   AccessType accessType = AccessType::FsChannelOther;
   SamplingGroup samplingGroup = SamplingGroup::DropAll;
 };
@@ -1674,42 +1761,52 @@ constexpr auto kNfs3dHandlers = [] {
 
   std::array<HandlerEntry, 22> handlers;
   handlers[folly::to_underlying(nfsv3Procs::null)] = {
-      "NULL", &Nfsd3ServerProcessor::null, formatNull, &NfsStats::nfsNull};
+      "NULL",
+      &Nfsd3ServerProcessor::null,
+      formatNull,
+      &NfsStats::nfsNull,
+      nullptr};
   handlers[folly::to_underlying(nfsv3Procs::getattr)] = {
       "GETATTR",
       &Nfsd3ServerProcessor::getattr,
       formatGetattr,
       &NfsStats::nfsGetattr,
+      &NfsStats::nfsGetattrAfterGetattr,
       Read};
   handlers[folly::to_underlying(nfsv3Procs::setattr)] = {
       "SETATTR",
       &Nfsd3ServerProcessor::setattr,
       formatSetattr,
       &NfsStats::nfsSetattr,
+      &NfsStats::nfsGetattrAfterSetattr,
       Write};
   handlers[folly::to_underlying(nfsv3Procs::lookup)] = {
       "LOOKUP",
       &Nfsd3ServerProcessor::lookup,
       formatLookup,
       &NfsStats::nfsLookup,
+      &NfsStats::nfsGetattrAfterLookup,
       Read};
   handlers[folly::to_underlying(nfsv3Procs::access)] = {
       "ACCESS",
       &Nfsd3ServerProcessor::access,
       formatAccess,
       &NfsStats::nfsAccess,
+      &NfsStats::nfsGetattrAfterAccess,
       Read};
   handlers[folly::to_underlying(nfsv3Procs::readlink)] = {
       "READLINK",
       &Nfsd3ServerProcessor::readlink,
       formatReadlink,
       &NfsStats::nfsReadlink,
+      &NfsStats::nfsGetattrAfterReadlink,
       Read};
   handlers[folly::to_underlying(nfsv3Procs::read)] = {
       "READ",
       &Nfsd3ServerProcessor::read,
       formatRead,
       &NfsStats::nfsRead,
+      &NfsStats::nfsGetattrAfterRead,
       Read,
       SamplingGroup::Three};
   handlers[folly::to_underlying(nfsv3Procs::write)] = {
@@ -1717,6 +1814,7 @@ constexpr auto kNfs3dHandlers = [] {
       &Nfsd3ServerProcessor::write,
       formatWrite,
       &NfsStats::nfsWrite,
+      &NfsStats::nfsGetattrAfterWrite,
       Write,
       SamplingGroup::Two};
   handlers[folly::to_underlying(nfsv3Procs::create)] = {
@@ -1724,81 +1822,95 @@ constexpr auto kNfs3dHandlers = [] {
       &Nfsd3ServerProcessor::create,
       formatCreate,
       &NfsStats::nfsCreate,
+      &NfsStats::nfsGetattrAfterCreate,
       Write};
   handlers[folly::to_underlying(nfsv3Procs::mkdir)] = {
       "MKDIR",
       &Nfsd3ServerProcessor::mkdir,
       formatMkdir,
       &NfsStats::nfsMkdir,
+      &NfsStats::nfsGetattrAfterMkdir,
       Write};
   handlers[folly::to_underlying(nfsv3Procs::symlink)] = {
       "SYMLINK",
       &Nfsd3ServerProcessor::symlink,
       formatSymlink,
       &NfsStats::nfsSymlink,
+      &NfsStats::nfsGetattrAfterSymlink,
       Write};
   handlers[folly::to_underlying(nfsv3Procs::mknod)] = {
       "MKNOD",
       &Nfsd3ServerProcessor::mknod,
       formatMknod,
       &NfsStats::nfsMknod,
+      &NfsStats::nfsGetattrAfterMknod,
       Write};
   handlers[folly::to_underlying(nfsv3Procs::remove)] = {
       "REMOVE",
       &Nfsd3ServerProcessor::remove,
       formatRemove,
       &NfsStats::nfsRemove,
+      &NfsStats::nfsGetattrAfterRemove,
       Write};
   handlers[folly::to_underlying(nfsv3Procs::rmdir)] = {
       "RMDIR",
       &Nfsd3ServerProcessor::rmdir,
       formatRmdir,
       &NfsStats::nfsRmdir,
+      &NfsStats::nfsGetattrAfterRmdir,
       Write};
   handlers[folly::to_underlying(nfsv3Procs::rename)] = {
       "RENAME",
       &Nfsd3ServerProcessor::rename,
       formatRename,
       &NfsStats::nfsRename,
+      &NfsStats::nfsGetattrAfterRename,
       Write};
   handlers[folly::to_underlying(nfsv3Procs::link)] = {
       "LINK",
       &Nfsd3ServerProcessor::link,
       formatLink,
       &NfsStats::nfsLink,
+      &NfsStats::nfsGetattrAfterLink,
       Write};
   handlers[folly::to_underlying(nfsv3Procs::readdir)] = {
       "READDIR",
       &Nfsd3ServerProcessor::readdir,
       formatReaddir,
       &NfsStats::nfsReaddir,
+      &NfsStats::nfsGetattrAfterReaddir,
       Read};
   handlers[folly::to_underlying(nfsv3Procs::readdirplus)] = {
       "READDIRPLUS",
       &Nfsd3ServerProcessor::readdirplus,
       formatReaddirplus,
       &NfsStats::nfsReaddirplus,
+      &NfsStats::nfsGetattrAfterReaddirplus,
       Read};
   handlers[folly::to_underlying(nfsv3Procs::fsstat)] = {
       "FSSTAT",
       &Nfsd3ServerProcessor::fsstat,
       formatFsstat,
-      &NfsStats::nfsFsstat};
+      &NfsStats::nfsFsstat,
+      &NfsStats::nfsGetattrAfterFsstat};
   handlers[folly::to_underlying(nfsv3Procs::fsinfo)] = {
       "FSINFO",
       &Nfsd3ServerProcessor::fsinfo,
       formatFsinfo,
-      &NfsStats::nfsFsinfo};
+      &NfsStats::nfsFsinfo,
+      &NfsStats::nfsGetattrAfterFsinfo};
   handlers[folly::to_underlying(nfsv3Procs::pathconf)] = {
       "PATHCONF",
       &Nfsd3ServerProcessor::pathconf,
       formatPathconf,
-      &NfsStats::nfsPathconf};
+      &NfsStats::nfsPathconf,
+      &NfsStats::nfsGetattrAfterPathconf};
   handlers[folly::to_underlying(nfsv3Procs::commit)] = {
       "COMMIT",
       &Nfsd3ServerProcessor::commit,
       formatCommit,
       &NfsStats::nfsCommit,
+      &NfsStats::nfsGetattrAfterCommit,
       Write};
 
   return handlers;
@@ -1827,15 +1939,33 @@ struct LiveRequest {
 
   ~LiveRequest() {
     if (traceBus_) {
-      traceBus_->publish(NfsTraceEvent::finish(xid_, procNumber_));
+      traceBus_->publish(NfsTraceEvent::finish(xid_, procNumber_, fetchCost));
     }
   }
 
+  /** Set once the request completed. */
+  FetchCost fetchCost;
+
   std::shared_ptr<TraceBus<NfsTraceEvent>> traceBus_;
   uint32_t xid_;
   uint32_t procNumber_;
 };
 
+/**
+ * Return the inode of the file handle the arguments of every procedure but
+ * NULL start with, without consuming the cursor. Malformed arguments are left
+ * for the handler to reject.
+ */
+std::optional<InodeNumber> peekFileHandle(folly::io::Cursor deser) {
+  uint32_t size;
+  uint64_t ino;
+  if (!deser.tryReadBE(size) || size != sizeof(nfs_fh3) ||
+      !deser.tryReadBE(ino)) {
+    return std::nullopt;
+  }
+  return InodeNumber{ino};
+}
+
 SamplingGroup nfsProcSamplingGroup(uint32_t procNumber) {
   XDCHECK(procNumber < kNfs3dHandlers.size())
       << "got invalid NFS procedure: " << procNumber;
@@ -1879,6 +2009,18 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::dispatchRpc(
   auto liveRequest = LiveRequest{
       traceBus_, traceDetailedArguments_, handlerEntry, deser, xid, procNumber};
 
+  // Count the GETATTR calls the client had to send because the reply of the
+  // previous procedure on that inode lacked up to date attributes.
+  auto ino = procNumber != folly::to_underlying(nfsv3Procs::null)
+      ? peekFileHandle(deser)
+      : std::nullopt;
+  if (ino && procNumber == folly::to_underlying(nfsv3Procs::getattr)) {
+    auto previous = getattrFollowUps_.getattrReceived(*ino);
+    if (auto* stats = dispatcher_->getStats(); previous && stats) {
+      stats->increment(kNfs3dHandlers[*previous].getattrAfter);
+    }
+  }
+
   // TODO: Add requestMetrics for NFS.
   std::shared_ptr<RequestMetricsScope::LockedRequestWatchList> nullRequestWatch;
   auto context = std::make_unique<NfsRequestContext>(
@@ -1901,11 +2043,26 @@ ImmediateFuture<folly::Unit> Nfsd3ServerProcessor::dispatchRpc(
         }
         return std::move(res);
       })
-      .ensure([liveRequest = std::move(liveRequest),
-               context = std::move(context)]() {});
+      .ensure([this,
+               ino,
+               procNumber,
+               liveRequest = std::move(liveRequest),
+               context = std::move(context)]() mutable {
+        if (ino) {
+          getattrFollowUps_.recordCompletion(*ino, procNumber);
+        }
+        liveRequest.fetchCost =
+            context->getFsObjectFetchContext().getFetchCost();
+      });
 }
 
 void Nfsd3ServerProcessor::onShutdown(RpcStopData data) {
+  // With several connections, the client may close some of them while the
+  // mount is still in use. Only the last one to close stops the mount, and
+  // only its socket is handed over on takeover.
+  if (numberOfClients_.fetch_sub(1, std::memory_order_acq_rel) > 1) {
+    return;
+  }
   // Note this triggers the Nfsd3 destruction which will also destroy
   // Nfsd3ServerProcessor. Don't do anything will the Nfsd3ServerProcessor
   // member variables after this!
@@ -1915,7 +2072,7 @@ void Nfsd3ServerProcessor::onShutdown(RpcStopData data) {
 void Nfsd3ServerProcessor::clientConnected() {
   auto numberOfClients =
       numberOfClients_.fetch_add(1, std::memory_order_acq_rel);
-  if (numberOfClients > 1) {
+  if (static_cast<size_t>(numberOfClients) > numConnections_) {
     structuredLogger_->logEvent(TooManyNfsClients{});
   }
 }
@@ -1924,6 +2081,8 @@ void Nfsd3ServerProcessor::clientConnected() {
 Nfsd3::Nfsd3(
     folly::EventBase* evb,
     std::shared_ptr<folly::Executor> threadPool,
+    std::shared_ptr<folly::IOExecutor> ioExecutor,
+    size_t maxInflightRequestsPerConnection,
     std::unique_ptr<NfsDispatcher> dispatcher,
     const folly::Logger* straceLogger,
     std::shared_ptr<ProcessNameCache> processNameCache,
@@ -1933,6 +2092,7 @@ Nfsd3::Nfsd3(
     std::shared_ptr<Notifier> /*notifier*/,
     CaseSensitivity caseSensitive,
     uint32_t iosize,
+    size_t numConnections,
     size_t traceBusCapacity)
     : server_(RpcServer::create(
           std::make_shared<Nfsd3ServerProcessor>(
@@ -1941,13 +2101,16 @@ Nfsd3::Nfsd3(
               structuredLogger,
               caseSensitive,
               iosize,
+              numConnections,
               stopPromise_,
               processAccessLog_,
               traceDetailedArguments_,
               traceBus_),
           evb,
           std::move(threadPool),
-          structuredLogger)),
+          structuredLogger,
+          std::move(ioExecutor),
+          maxInflightRequestsPerConnection)),
       processAccessLog_(std::move(processNameCache)),
       invalidationExecutor_{
           folly::SerialExecutor::create(folly::getGlobalCPUExecutor())},
@@ -1987,6 +2150,7 @@ Nfsd3::Nfsd3(
                   durationNs,
                   nfsProcSamplingGroup(procNumber),
                   nfsProcName(procNumber),
+                  event.getFetchCost(),
               });
             }
             break;
@@ -14,6 +14,7 @@
 
 #include "eden/fs/nfs/NfsDispatcher.h"
 #include "eden/fs/nfs/rpc/Server.h"
+#include "eden/fs/telemetry/FetchCost.h"
 #include "eden/fs/telemetry/TraceBus.h"
 #include "eden/fs/utils/CaseSensitivity.h"
 #include "eden/fs/utils/ProcessAccessLog.h"
@@ -60,8 +61,14 @@ struct NfsTraceEvent : TraceEventBase {
         xid, procNumber, StartDetails{std::make_unique<NfsArgsDetails>(args)}};
   }
 
-  static NfsTraceEvent finish(uint32_t xid, uint32_t procNumber) {
-    return NfsTraceEvent{xid, procNumber, FinishDetails{}};
+  static NfsTraceEvent
+  finish(uint32_t xid, uint32_t procNumber, const FetchCost& fetchCost) {
+    return NfsTraceEvent{
+        xid,
+        procNumber,
+        FinishDetails{
+            fetchCost.empty() ? nullptr
+                              : std::make_unique<const FetchCost>(fetchCost)}};
   }
 
   Type getType() const {
@@ -89,6 +96,14 @@ struct NfsTraceEvent : TraceEventBase {
     return argDetails ? argDetails->inode : std::nullopt;
   }
 
+  /**
+   * Where the objects fetched by the request of a FINISH event came from.
+   */
+  FetchCost getFetchCost() const {
+    auto& fetchCost = std::get<FinishDetails>(details_).fetchCost;
+    return fetchCost ? *fetchCost : FetchCost{};
+  }
+
  private:
   struct StartDetails {
     explicit StartDetails(std::unique_ptr<NfsArgsDetails> args)
@@ -96,7 +111,13 @@ struct NfsTraceEvent : TraceEventBase {
     std::unique_ptr<NfsArgsDetails> argDetails;
   };
 
-  struct FinishDetails {};
+  struct FinishDetails {
+    /**
+     * Only allocated for the requests that fetched objects, to keep the
+     * events in the TraceBus small.
+     */
+    std::unique_ptr<const FetchCost> fetchCost;
+  };
 
   using Details = std::variant<StartDetails, FinishDetails>;
 
@@ -120,7 +141,14 @@ class Nfsd3 {
    * host, EdenFS won't be able to register itself.
    *
    * All the socket processing will be run on the EventBase passed in. This
-   * also must be called on that EventBase thread.
+   * also must be called on that EventBase thread. When an ioExecutor is
+   * passed in, the connections are served on its EventBases instead, and
+   * only accepted on evb. Each connection processes at most
+   * maxInflightRequestsPerConnection requests at once, 0 for no limit.
+   *
+   * numConnections is the number of connections the client was asked to
+   * open. The mount is only considered unmounted once all of them are
+   * closed.
    *
    * Note: at mount time, EdenFS will manually call mount.nfs with -o port
    * to manually specify the port on which this server is bound, so registering
@@ -129,6 +157,8 @@ class Nfsd3 {
   Nfsd3(
       folly::EventBase* evb,
       std::shared_ptr<folly::Executor> threadPool,
+      std::shared_ptr<folly::IOExecutor> ioExecutor,
+      size_t maxInflightRequestsPerConnection,
       std::unique_ptr<NfsDispatcher> dispatcher,
       const folly::Logger* straceLogger,
       std::shared_ptr<ProcessNameCache> processNameCache,
@@ -138,6 +168,7 @@ class Nfsd3 {
       std::shared_ptr<Notifier> notifications,
       CaseSensitivity caseSensitive,
       uint32_t iosize,
+      size_t numConnections,
       size_t traceBusCapacity);
 
   /**
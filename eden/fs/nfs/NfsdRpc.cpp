@@ -53,6 +53,14 @@ EDEN_XDR_SERDE_IMPL(READLINK3resfail, symlink_attributes);
 EDEN_XDR_SERDE_IMPL(READ3args, file, offset, count);
 EDEN_XDR_SERDE_IMPL(READ3resok, file_attributes, count, eof, data);
 EDEN_XDR_SERDE_IMPL(READ3resfail, file_attributes);
+
+void serializeReadResOk(folly::io::QueueAppender& appender, READ3resok&& res) {
+  XdrTrait<nfsstat3>::serialize(appender, nfsstat3::NFS3_OK);
+  XdrTrait<post_op_attr>::serialize(appender, res.file_attributes);
+  XdrTrait<uint32_t>::serialize(appender, res.count);
+  XdrTrait<bool>::serialize(appender, res.eof);
+  detail::serialize_iobuf(appender, std::move(res.data));
+}
 EDEN_XDR_SERDE_IMPL(WRITE3args, file, offset, count, stable, data);
 EDEN_XDR_SERDE_IMPL(WRITE3resok, file_wcc, count, committed, verf);
 EDEN_XDR_SERDE_IMPL(WRITE3resfail, file_wcc);
@@ -141,6 +149,9 @@ EDEN_XDR_SERDE_IMPL(
     case_insensitive,
     case_preserving);
 EDEN_XDR_SERDE_IMPL(PATHCONF3resfail, obj_attributes);
+EDEN_XDR_SERDE_IMPL(COMMIT3args, file, offset, count);
+EDEN_XDR_SERDE_IMPL(COMMIT3resok, file_wcc, verf);
+EDEN_XDR_SERDE_IMPL(COMMIT3resfail, file_wcc);
 
 RpcParsingError constructInodeParsingError(
     folly::io::Cursor cursor,
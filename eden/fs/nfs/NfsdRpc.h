@@ -436,6 +436,13 @@ EDEN_XDR_SERDE_DECL(READ3resfail, file_attributes);
 
 struct READ3res : public detail::Nfsstat3Variant<READ3resok, READ3resfail> {};
 
+/**
+ * Serialize a successful READ3res holding res. Unlike XdrTrait<READ3res>,
+ * which only has a const reference to the data and must clone its chain, the
+ * buffers of the data are moved into the reply.
+ */
+void serializeReadResOk(folly::io::QueueAppender& appender, READ3resok&& res);
+
 // WRITE Procedure:
 
 using writeverf3 = uint64_t;
@@ -925,6 +932,29 @@ EDEN_XDR_SERDE_DECL(PATHCONF3resfail, obj_attributes);
 struct PATHCONF3res
     : public detail::Nfsstat3Variant<PATHCONF3resok, PATHCONF3resfail> {};
 
+// COMMIT Procedure:
+
+struct COMMIT3args {
+  nfs_fh3 file;
+  uint64_t offset;
+  uint32_t count;
+};
+EDEN_XDR_SERDE_DECL(COMMIT3args, file, offset, count);
+
+struct COMMIT3resok {
+  wcc_data file_wcc;
+  writeverf3 verf;
+};
+EDEN_XDR_SERDE_DECL(COMMIT3resok, file_wcc, verf);
+
+struct COMMIT3resfail {
+  wcc_data file_wcc;
+};
+EDEN_XDR_SERDE_DECL(COMMIT3resfail, file_wcc);
+
+struct COMMIT3res
+    : public detail::Nfsstat3Variant<COMMIT3resok, COMMIT3resfail> {};
+
 } // namespace facebook::eden
 
 #endif
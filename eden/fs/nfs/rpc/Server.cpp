@@ -13,10 +13,12 @@
 
 #include <folly/Exception.h>
 #include <folly/String.h>
+#include <folly/executors/IOExecutor.h>
 #include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/io/IOBufQueue.h>
 #include <folly/io/async/AsyncSocket.h>
+#include <folly/net/NetOps.h>
 
 #include "eden/fs/nfs/rpc/Rpc.h"
 #include "eden/fs/telemetry/LogEvent.h"
@@ -108,12 +110,14 @@ RpcTcpHandler::RpcTcpHandler(
     AsyncSocket::UniquePtr&& socket,
     std::shared_ptr<folly::Executor> threadPool,
     const std::shared_ptr<StructuredLogger>& structuredLogger,
-    std::weak_ptr<RpcServer> owningServer)
+    std::weak_ptr<RpcServer> owningServer,
+    size_t maxInflightRequests)
     : proc_(proc),
       sock_(std::move(socket)),
       threadPool_(std::move(threadPool)),
       errorLogger_(structuredLogger),
       reader_(std::make_unique<Reader>(this)),
+      maxInflightRequests_(maxInflightRequests),
       state_(sock_->getEventBase()),
       owningServer_(std::move(owningServer)) {
   sock_->setReadCB(reader_.get());
@@ -194,6 +198,10 @@ folly::SemiFuture<folly::Unit> RpcTcpHandler::resetReader(
         XLOG(DBG7) << "Pending Requests complete;"
                    << "finishing destroying this rpc tcp handler";
         this->sock_->getEventBase()->dcheckIsInEventBaseThread();
+        // The last replies may still be waiting for the end of the loop
+        // iteration, write them before the socket is handed over or closed.
+        this->replyFlusher_.cancelLoopCallback();
+        this->flushReplies();
         if (auto owningServer = this->owningServer_.lock()) {
           owningServer->unregisterRpcHandler(this);
         }
@@ -223,13 +231,14 @@ std::string displayBuffer(folly::IOBuf* buf) {
 void RpcTcpHandler::tryConsumeReadBuffer() noexcept {
   // Iterate over all the complete fragments and dispatch these to the
   // threadPool_.
+  auto& state = state_.get();
   while (true) {
     auto buf = readOneRequest();
     if (!buf) {
       break;
     }
     XLOG(DBG7) << "received a request";
-    state_.get().pendingRequests += 1;
+    state.pendingRequests += 1;
     // Send the work to a thread pool to increase the number of inflight
     // requests that can be handled concurrently.
     threadPool_->add(
@@ -266,6 +275,18 @@ void RpcTcpHandler::tryConsumeReadBuffer() noexcept {
           dispatchAndReply(bufQueue.move(), std::move(guard));
         });
   }
+
+  // Stop reading from the socket until some requests complete. This bounds
+  // both the memory used by the connection and its share of the threadPool_.
+  // All the complete requests that were read are dispatched above, so none
+  // are left behind in readBuf_ if a takeover starts while paused.
+  if (maxInflightRequests_ != 0 &&
+      state.pendingRequests >= maxInflightRequests_ && !state.readPaused &&
+      state.stopReason == RpcStopReason::RUNNING) {
+    XLOG(DBG7) << "Too many pending requests, pausing reads";
+    sock_->setReadCB(nullptr);
+    state.readPaused = true;
+  }
 }
 
 std::unique_ptr<folly::IOBuf> RpcTcpHandler::readOneRequest() noexcept {
@@ -450,9 +471,7 @@ void RpcTcpHandler::dispatchAndReply(
         if (result.hasException()) {
           // XXX: This should never happen.
         } else {
-          auto resultBuffer = std::move(result).value();
-          XLOG(DBG7) << "About to write to the socket.";
-          sock_->writeChain(&writer_, std::move(resultBuffer));
+          queueReply(std::move(result).value());
         }
       })
       .ensure([this, guard = std::move(guard)]() {
@@ -470,22 +489,42 @@ void RpcTcpHandler::dispatchAndReply(
             if (state.pendingRequests == 0) {
               this->pendingRequestsComplete_.setValue();
             }
+          } else if (
+              UNLIKELY(state.readPaused) &&
+              state.pendingRequests < this->maxInflightRequests_) {
+            XLOG(DBG7) << "Resuming reads";
+            state.readPaused = false;
+            this->sock_->setReadCB(this->reader_.get());
           }
         }
       });
 }
 
+void RpcTcpHandler::queueReply(std::unique_ptr<folly::IOBuf> reply) {
+  pendingReplies_.append(std::move(reply));
+  if (!replyFlusher_.isLoopCallbackScheduled()) {
+    sock_->getEventBase()->runInLoop(&replyFlusher_);
+  }
+}
+
+void RpcTcpHandler::flushReplies() {
+  if (pendingReplies_.empty()) {
+    return;
+  }
+  XLOG(DBG7) << "About to write to the socket.";
+  // The AsyncSocket writes the whole chain with a single writev.
+  sock_->writeChain(&writer_, pendingReplies_.move());
+}
+
 void RpcServer::RpcAcceptCallback::connectionAccepted(
     folly::NetworkSocket fd,
     const folly::SocketAddress& clientAddr,
     AcceptInfo /* info */) noexcept {
   XLOG(DBG7) << "Accepted connection from: " << clientAddr;
-  auto socket = AsyncSocket::newSocket(evb_, fd);
-  auto handler = RpcTcpHandler::create(
-      proc_, std::move(socket), threadPool_, structuredLogger_, owningServer_);
-
   if (auto server = owningServer_.lock()) {
-    server->registerRpcHandler(std::move(handler));
+    server->addConnection(fd);
+  } else {
+    folly::netops::close(fd);
   }
 
   // At this point we could stop accepting connections with this callback for
@@ -530,18 +569,29 @@ std::shared_ptr<RpcServer> RpcServer::create(
     std::shared_ptr<RpcServerProcessor> proc,
     folly::EventBase* evb,
     std::shared_ptr<folly::Executor> threadPool,
-    const std::shared_ptr<StructuredLogger>& structuredLogger) {
+    const std::shared_ptr<StructuredLogger>& structuredLogger,
+    std::shared_ptr<folly::IOExecutor> ioExecutor,
+    size_t maxInflightRequestsPerConnection) {
   return std::shared_ptr<RpcServer>{new RpcServer{
-      std::move(proc), evb, std::move(threadPool), structuredLogger}};
+      std::move(proc),
+      evb,
+      std::move(threadPool),
+      structuredLogger,
+      std::move(ioExecutor),
+      maxInflightRequestsPerConnection}};
 }
 
 RpcServer::RpcServer(
     std::shared_ptr<RpcServerProcessor> proc,
     folly::EventBase* evb,
     std::shared_ptr<folly::Executor> threadPool,
-    const std::shared_ptr<StructuredLogger>& structuredLogger)
+    const std::shared_ptr<StructuredLogger>& structuredLogger,
+    std::shared_ptr<folly::IOExecutor> ioExecutor,
+    size_t maxInflightRequestsPerConnection)
     : evb_(evb),
       threadPool_(threadPool),
+      ioExecutor_(std::move(ioExecutor)),
+      maxInflightRequestsPerConnection_(maxInflightRequestsPerConnection),
       structuredLogger_(structuredLogger),
       acceptCb_(nullptr),
       serverSocket_(new AsyncServerSocket(evb_)),
@@ -550,10 +600,6 @@ RpcServer::RpcServer(
 
 void RpcServer::initialize(folly::SocketAddress addr) {
   acceptCb_.reset(new RpcServer::RpcAcceptCallback{
-      proc_,
-      evb_,
-      threadPool_,
-      structuredLogger_,
       std::weak_ptr<RpcServer>{shared_from_this()}});
 
   // Ask kernel to assign us a port on the loopback interface
@@ -573,21 +619,11 @@ void RpcServer::initialize(folly::File&& socket, InitialSocketType type) {
       // meant for server that only ever has one connected socket (nfsd3). Since
       // we already have the one connected socket, we will not need the
       // accepting socket to make any more connections.
-      rpcTcpHandlers_.wlock()->emplace_back(RpcTcpHandler::create(
-          proc_,
-          AsyncSocket::newSocket(
-              evb_, folly::NetworkSocket::fromFd(socket.release())),
-          threadPool_,
-          structuredLogger_,
-          shared_from_this()));
+      addConnection(folly::NetworkSocket::fromFd(socket.release()));
       return;
     case InitialSocketType::SERVER_SOCKET:
       XLOG(DBG7) << "Initializing server from server socket: " << socket.fd();
       acceptCb_.reset(new RpcServer::RpcAcceptCallback{
-          proc_,
-          evb_,
-          threadPool_,
-          structuredLogger_,
           std::weak_ptr<RpcServer>{shared_from_this()}});
       serverSocket_->useExistingSocket(
           folly::NetworkSocket::fromFd(socket.release()));
@@ -599,6 +635,24 @@ void RpcServer::initialize(folly::File&& socket, InitialSocketType type) {
   throw std::runtime_error("Impossible socket type.");
 }
 
+void RpcServer::addConnection(folly::NetworkSocket fd) {
+  // IOExecutor::getEventBase() hands out its EventBases in turn, spreading the
+  // connections evenly.
+  auto* evb = ioExecutor_ ? ioExecutor_->getEventBase() : evb_;
+  // The socket must be created and have its read callback set on the
+  // EventBase it is attached to.
+  evb->runImmediatelyOrRunInEventBaseThread(
+      [this, self = shared_from_this(), evb, fd] {
+        registerRpcHandler(RpcTcpHandler::create(
+            proc_,
+            AsyncSocket::newSocket(evb, fd),
+            threadPool_,
+            structuredLogger_,
+            std::weak_ptr<RpcServer>{self},
+            maxInflightRequestsPerConnection_));
+      });
+}
+
 void RpcServer::registerRpcHandler(RpcTcpHandler::UniquePtr handler) {
   rpcTcpHandlers_.wlock()->emplace_back(std::move(handler));
 }
@@ -637,7 +691,17 @@ folly::SemiFuture<folly::File> RpcServer::takeoverStop() {
   std::vector<folly::SemiFuture<folly::Unit>> futures{};
   futures.reserve(handlers.size());
   for (auto& handler : handlers) {
-    futures.emplace_back(handler->takeoverStop());
+    // Connections must be stopped on their own EventBase, see
+    // RpcTcpHandler::takeoverStop.
+    auto* handlerEvb = handler->getEventBase();
+    if (handlerEvb->isInEventBaseThread()) {
+      futures.emplace_back(handler->takeoverStop());
+    } else {
+      futures.emplace_back(
+          folly::via(handlerEvb, [handler = std::move(handler)]() {
+            return handler->takeoverStop();
+          }).semi());
+    }
   }
   return collectAll(futures)
       .via(evb_) // make sure we are running on the eventbase to do some more
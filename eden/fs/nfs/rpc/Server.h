@@ -23,7 +23,8 @@
 
 namespace folly {
 class Executor;
-}
+class IOExecutor;
+} // namespace folly
 
 namespace facebook::eden {
 class StructuredLogger;
@@ -100,13 +101,23 @@ class RpcTcpHandler : public folly::DelayedDestruction {
    */
   folly::SemiFuture<folly::Unit> takeoverStop();
 
+  /**
+   * Return the EventBase that the socket of this connection is attached to.
+   * All the socket operations and accesses to the connection state happen on
+   * it.
+   */
+  folly::EventBase* getEventBase() const {
+    return sock_->getEventBase();
+  }
+
  private:
   RpcTcpHandler(
       std::shared_ptr<RpcServerProcessor> proc,
       folly::AsyncSocket::UniquePtr&& socket,
       std::shared_ptr<folly::Executor> threadPool,
       const std::shared_ptr<StructuredLogger>& structuredLogger,
-      std::weak_ptr<RpcServer> owningServer);
+      std::weak_ptr<RpcServer> owningServer,
+      size_t maxInflightRequests);
 
   class Reader : public folly::AsyncReader::ReadCallback {
    public:
@@ -150,12 +161,42 @@ class RpcTcpHandler : public folly::DelayedDestruction {
         const folly::AsyncSocketException& ex) noexcept override;
   };
 
+  /**
+   * Writes the replies queued during an iteration of the EventBase loop.
+   */
+  class ReplyFlusher : public folly::EventBase::LoopCallback {
+   public:
+    explicit ReplyFlusher(RpcTcpHandler* handler) : handler_(handler) {}
+
+   private:
+    void runLoopCallback() noexcept override {
+      handler_->flushReplies();
+    }
+
+    RpcTcpHandler* handler_;
+  };
+
   /**
    * Parse the buffer that was just read from the socket. Complete RPC buffers
-   * will be dispatched to the RpcServerProcessor.
+   * will be dispatched to the RpcServerProcessor. Once maxInflightRequests_
+   * are pending, reading from the socket is paused until some of them
+   * complete.
    */
   void tryConsumeReadBuffer() noexcept;
 
+  /**
+   * Queue the reply to a request, to be written along with the other replies
+   * that complete during this iteration of the EventBase loop. The replies
+   * are written in the order they complete, which is allowed by the RPC
+   * protocol since each reply carries the xid of its call.
+   */
+  void queueReply(std::unique_ptr<folly::IOBuf> reply);
+
+  /**
+   * Write all the queued replies to the socket in a single writev.
+   */
+  void flushReplies();
+
   /**
    * Delete the reader, called when the socket is closed or on takeover.
    *
@@ -237,6 +278,19 @@ class RpcTcpHandler : public folly::DelayedDestruction {
 
   folly::IOBufQueue readBuf_{folly::IOBufQueue::cacheChainLength()};
 
+  /**
+   * Maximum number of requests of this connection being processed at once, 0
+   * for no limit.
+   */
+  const size_t maxInflightRequests_;
+
+  /**
+   * Replies waiting to be written by replyFlusher_. Only accessed on the
+   * socket's eventbase.
+   */
+  folly::IOBufQueue pendingReplies_;
+  ReplyFlusher replyFlusher_{this};
+
   /**
    * Status for the rpc connection. The State may only be accessed from the
    * socket's eventbase thread. We use this invariant so that we don't have to
@@ -248,6 +302,9 @@ class RpcTcpHandler : public folly::DelayedDestruction {
     RpcStopReason stopReason = RpcStopReason::RUNNING;
     // number of requests we are in the middle of processing
     size_t pendingRequests = 0;
+    // Whether reading was paused because maxInflightRequests_ requests are
+    // being processed.
+    bool readPaused = false;
 
     State() {}
     State(const State& state) = delete;
@@ -298,12 +355,22 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
    *
    * Request will be received on the passed EventBase and dispatched to the
    * RpcServerProcessor on the passed in threadPool.
+   *
+   * When an ioExecutor is passed in, connections are instead distributed
+   * across its EventBases, each connection staying on the one it was given.
+   * This allows a client opening several connections to have their requests
+   * parsed and their replies serialized and written concurrently.
+   *
+   * Each connection processes at most maxInflightRequestsPerConnection
+   * requests at once, 0 meaning no limit.
    */
   static std::shared_ptr<RpcServer> create(
       std::shared_ptr<RpcServerProcessor> proc,
       folly::EventBase* evb,
       std::shared_ptr<folly::Executor> threadPool,
-      const std::shared_ptr<StructuredLogger>& structuredLogger);
+      const std::shared_ptr<StructuredLogger>& structuredLogger,
+      std::shared_ptr<folly::IOExecutor> ioExecutor = nullptr,
+      size_t maxInflightRequestsPerConnection = 0);
 
   ~RpcServer();
 
@@ -326,7 +393,8 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
   void registerService(uint32_t progNumber, uint32_t progVersion);
 
   /**
-   * Return the EventBase that this RpcServer is running on.
+   * Return the EventBase that this RpcServer is running on. This is where
+   * connections are accepted, which isn't necessarily where they are served.
    */
   folly::EventBase* getEventBase() const {
     return evb_;
@@ -356,7 +424,15 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
       std::shared_ptr<RpcServerProcessor> proc,
       folly::EventBase* evb,
       std::shared_ptr<folly::Executor> threadPool,
-      const std::shared_ptr<StructuredLogger>& structuredLogger);
+      const std::shared_ptr<StructuredLogger>& structuredLogger,
+      std::shared_ptr<folly::IOExecutor> ioExecutor,
+      size_t maxInflightRequestsPerConnection);
+
+  /**
+   * Start serving the connected socket fd on the EventBase picked for it,
+   * and register its handler.
+   */
+  void addConnection(folly::NetworkSocket fd);
 
   class RpcAcceptCallback : public folly::AsyncServerSocket::AcceptCallback,
                             public folly::DelayedDestruction {
@@ -364,18 +440,8 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
     using UniquePtr = std::
         unique_ptr<RpcAcceptCallback, folly::DelayedDestruction::Destructor>;
 
-    explicit RpcAcceptCallback(
-        std::shared_ptr<RpcServerProcessor> proc,
-        folly::EventBase* evb,
-        std::shared_ptr<folly::Executor> threadPool,
-        const std::shared_ptr<StructuredLogger>& structuredLogger,
-        std::weak_ptr<RpcServer> owningServer)
-        : evb_(evb),
-          proc_(proc),
-          threadPool_(std::move(threadPool)),
-          structuredLogger_(structuredLogger),
-          owningServer_(std::move(owningServer)),
-          guard_(this) {}
+    explicit RpcAcceptCallback(std::weak_ptr<RpcServer> owningServer)
+        : owningServer_(std::move(owningServer)), guard_(this) {}
 
    private:
     void connectionAccepted(
@@ -389,10 +455,6 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
 
     ~RpcAcceptCallback() override = default;
 
-    folly::EventBase* evb_;
-    std::shared_ptr<RpcServerProcessor> proc_;
-    std::shared_ptr<folly::Executor> threadPool_;
-    std::shared_ptr<StructuredLogger> structuredLogger_;
     std::weak_ptr<RpcServer> owningServer_;
 
     /**
@@ -410,6 +472,13 @@ class RpcServer : public std::enable_shared_from_this<RpcServer> {
   // Threadpool for processing requests off the main event base.
   std::shared_ptr<folly::Executor> threadPool_;
 
+  // When set, the connections are served on its event bases instead of the
+  // main one.
+  std::shared_ptr<folly::IOExecutor> ioExecutor_;
+
+  // See RpcTcpHandler::maxInflightRequests_.
+  size_t maxInflightRequestsPerConnection_;
+
   // Logger for logging anomalous things to Scuba
   std::shared_ptr<StructuredLogger> structuredLogger_;
 
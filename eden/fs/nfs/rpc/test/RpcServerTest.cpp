@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/nfs/rpc/Server.h"
+
+#include <map>
+#include <thread>
+
+#include <folly/Exception.h>
+#include <folly/Synchronized.h>
+#include <folly/executors/CPUThreadPoolExecutor.h>
+#include <folly/executors/IOThreadPoolExecutor.h>
+#include <folly/futures/Future.h>
+#include <folly/io/async/EventBaseManager.h>
+#include <folly/io/async/ScopedEventBaseThread.h>
+#include <folly/net/NetOps.h>
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+
+#include "eden/fs/nfs/rpc/StreamClient.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+/**
+ * Records the EventBase each connection is served on, which is the one
+ * clientConnected() is called on.
+ */
+class RecordingProcessor : public RpcServerProcessor {
+ public:
+  explicit RecordingProcessor(size_t expectedConnections)
+      : expectedConnections_{expectedConnections} {}
+
+  void clientConnected() override {
+    auto evbs = evbs_.wlock();
+    evbs->push_back(folly::EventBaseManager::get()->getExistingEventBase());
+    if (evbs->size() == expectedConnections_) {
+      connected.post();
+    }
+  }
+
+  void onShutdown(RpcStopData /*stopData*/) override {
+    if (++shutdowns_ == expectedConnections_) {
+      shutdown.post();
+    }
+  }
+
+  std::vector<folly::EventBase*> getEventBases() const {
+    return *evbs_.rlock();
+  }
+
+  folly::Baton<> connected;
+  folly::Baton<> shutdown;
+
+ private:
+  const size_t expectedConnections_;
+  folly::Synchronized<std::vector<folly::EventBase*>> evbs_;
+  std::atomic<size_t> shutdowns_{0};
+};
+
+/**
+ * Holds on to every request until the test completes it.
+ */
+class HoldingProcessor : public RpcServerProcessor {
+ public:
+  ImmediateFuture<folly::Unit> dispatchRpc(
+      folly::io::Cursor /*deser*/,
+      folly::io::QueueAppender ser,
+      uint32_t xid,
+      uint32_t /*progNumber*/,
+      uint32_t /*progVersion*/,
+      uint32_t /*procNumber*/) override {
+    serializeReply(ser, accept_stat::SUCCESS, xid);
+    folly::Promise<folly::Unit> promise;
+    auto future = promise.getSemiFuture();
+    requests_.wlock()->emplace(xid, std::move(promise));
+    dispatched_.fetch_add(1);
+    return ImmediateFuture<folly::Unit>{std::move(future)};
+  }
+
+  size_t getDispatchedCount() const {
+    return dispatched_.load();
+  }
+
+  bool waitForDispatched(size_t count) const {
+    for (int i = 0; i < 10000; i++) {
+      if (getDispatchedCount() >= count) {
+        return true;
+      }
+      std::this_thread::sleep_for(1ms);
+    }
+    return false;
+  }
+
+  void complete(uint32_t xid) {
+    auto promise = [&] {
+      auto requests = requests_.wlock();
+      auto it = requests->find(xid);
+      auto promise = std::move(it->second);
+      requests->erase(it);
+      return promise;
+    }();
+    promise.setValue();
+  }
+
+ private:
+  folly::Synchronized<std::map<uint32_t, folly::Promise<folly::Unit>>>
+      requests_;
+  std::atomic<size_t> dispatched_{0};
+};
+
+/**
+ * An RpcServer running on its own EventBase thread, that is stopped, along
+ * with its connections, on destruction.
+ */
+class ServerThread {
+ public:
+  ServerThread(
+      std::shared_ptr<RpcServerProcessor> processor,
+      size_t maxInflightRequestsPerConnection) {
+    evb_.getEventBase()->runInEventBaseThreadAndWait([&] {
+      server_ = RpcServer::create(
+          std::move(processor),
+          evb_.getEventBase(),
+          std::make_shared<folly::CPUThreadPoolExecutor>(1),
+          std::make_shared<NullStructuredLogger>(),
+          nullptr,
+          maxInflightRequestsPerConnection);
+      server_->initialize(folly::SocketAddress{"127.0.0.1", 0});
+    });
+  }
+
+  ~ServerThread() {
+    folly::via(evb_.getEventBase(), [this] { return server_->takeoverStop(); })
+        .get(10s);
+    evb_.getEventBase()->runInEventBaseThreadAndWait([&] { server_.reset(); });
+  }
+
+  folly::SocketAddress getAddr() const {
+    return server_->getAddr();
+  }
+
+ private:
+  folly::ScopedEventBaseThread evb_;
+  std::shared_ptr<RpcServer> server_;
+};
+
+uint32_t sendCall(StreamClient& client) {
+  return client.serializeCall(1, 1, 1, uint32_t{0});
+}
+
+uint32_t receiveXid(StreamClient& client) {
+  return std::get<2>(client.receiveChunk());
+}
+
+folly::NetworkSocket connectTo(const folly::SocketAddress& addr) {
+  auto sock = folly::netops::socket(AF_INET, SOCK_STREAM, 0);
+  sockaddr_storage storage;
+  auto len = addr.getAddress(&storage);
+  folly::checkUnixError(
+      folly::netops::connect(sock, reinterpret_cast<sockaddr*>(&storage), len),
+      "connect");
+  return sock;
+}
+
+} // namespace
+
+TEST(RpcServerTest, connectionsAreSpreadAcrossTheIoExecutor) {
+  folly::ScopedEventBaseThread mainEvb;
+  auto ioExecutor = std::make_shared<folly::IOThreadPoolExecutor>(2);
+  auto processor = std::make_shared<RecordingProcessor>(2);
+
+  std::shared_ptr<RpcServer> server;
+  mainEvb.getEventBase()->runInEventBaseThreadAndWait([&] {
+    server = RpcServer::create(
+        processor,
+        mainEvb.getEventBase(),
+        std::make_shared<folly::CPUThreadPoolExecutor>(1),
+        std::make_shared<NullStructuredLogger>(),
+        ioExecutor);
+    server->initialize(folly::SocketAddress{"127.0.0.1", 0});
+  });
+
+  auto first = connectTo(server->getAddr());
+  auto second = connectTo(server->getAddr());
+  ASSERT_TRUE(processor->connected.try_wait_for(10s));
+
+  auto evbs = processor->getEventBases();
+  ASSERT_EQ(2, evbs.size());
+  EXPECT_NE(evbs[0], evbs[1]);
+  for (auto* evb : evbs) {
+    EXPECT_NE(mainEvb.getEventBase(), evb);
+  }
+
+  folly::netops::close(first);
+  folly::netops::close(second);
+  ASSERT_TRUE(processor->shutdown.try_wait_for(10s));
+
+  mainEvb.getEventBase()->runInEventBaseThreadAndWait(
+      [&] { server.reset(); });
+}
+
+TEST(RpcServerTest, repliesAreSentAsRequestsComplete) {
+  auto processor = std::make_shared<HoldingProcessor>();
+  ServerThread server{processor, 0};
+  StreamClient client{server.getAddr()};
+  client.connect();
+
+  auto first = sendCall(client);
+  auto second = sendCall(client);
+  ASSERT_TRUE(processor->waitForDispatched(2));
+
+  processor->complete(second);
+  EXPECT_EQ(second, receiveXid(client));
+  processor->complete(first);
+  EXPECT_EQ(first, receiveXid(client));
+}
+
+TEST(RpcServerTest, readsArePausedAtTheInflightLimit) {
+  auto processor = std::make_shared<HoldingProcessor>();
+  ServerThread server{processor, 1};
+  StreamClient client{server.getAddr()};
+  client.connect();
+
+  auto first = sendCall(client);
+  ASSERT_TRUE(processor->waitForDispatched(1));
+
+  auto second = sendCall(client);
+  std::this_thread::sleep_for(50ms);
+  EXPECT_EQ(1, processor->getDispatchedCount());
+
+  processor->complete(first);
+  EXPECT_EQ(first, receiveXid(client));
+  ASSERT_TRUE(processor->waitForDispatched(2));
+  processor->complete(second);
+  EXPECT_EQ(second, receiveXid(client));
+}
+
+#endif
@@ -29,6 +29,34 @@ TEST(DirListTest, size) {
   EXPECT_EQ(computeInitialOverhead(), kNfsDirListInitialOverhead);
 }
 
+TEST(DirListTest, serializedSize) {
+  NfsDirList entries{4096, nfsv3Procs::readdir};
+  EXPECT_TRUE(entries.add("foo", InodeNumber{2}, 1));
+  EXPECT_TRUE(entries.add("a longer name", InodeNumber{3}, 2));
+  auto size = entries.getSerializedSize();
+
+  READDIR3resok res{
+      post_op_attr{fattr3{}}, 0, dirlist3{entries.extractList<entry3>(), true}};
+  EXPECT_EQ(XdrTrait<READDIR3resok>::serializedSize(res), size);
+}
+
+TEST(DirListTest, serializedSizeAccountsForAttributes) {
+  NfsDirList entries{4096, nfsv3Procs::readdirplus};
+  EXPECT_TRUE(entries.add("foo", InodeNumber{2}, 1));
+  EXPECT_TRUE(entries.add("a longer name", InodeNumber{3}, 2));
+  auto size = entries.getSerializedSize();
+
+  // The attributes are filled in once the list is built.
+  for (auto& entry : entries.getListRef()) {
+    entry.name_attributes = post_op_attr{fattr3{}};
+  }
+  READDIRPLUS3resok res{
+      post_op_attr{fattr3{}},
+      0,
+      dirlistplus3{entries.extractList<entryplus3>(), true}};
+  EXPECT_EQ(XdrTrait<READDIRPLUS3resok>::serializedSize(res), size);
+}
+
 } // namespace facebook::eden
 
 #endif
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/nfs/GetattrFollowUpTracker.h"
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+constexpr uint32_t kWrite = 7;
+constexpr uint32_t kCommit = 21;
+} // namespace
+
+TEST(GetattrFollowUpTrackerTest, getattrWithinTheWindowIsAFollowUp) {
+  GetattrFollowUpTracker tracker{1ms};
+  auto now = GetattrFollowUpTracker::Clock::now();
+  tracker.recordCompletion(InodeNumber{42}, kWrite, now);
+
+  EXPECT_EQ(std::nullopt, tracker.getattrReceived(InodeNumber{43}, now));
+  EXPECT_EQ(kWrite, tracker.getattrReceived(InodeNumber{42}, now + 500us));
+  // Only the first GETATTR is blamed on the write.
+  EXPECT_EQ(std::nullopt, tracker.getattrReceived(InodeNumber{42}, now + 1us));
+}
+
+TEST(GetattrFollowUpTrackerTest, getattrAfterTheWindowIsNotAFollowUp) {
+  GetattrFollowUpTracker tracker{1ms};
+  auto now = GetattrFollowUpTracker::Clock::now();
+  tracker.recordCompletion(InodeNumber{42}, kWrite, now);
+  EXPECT_EQ(std::nullopt, tracker.getattrReceived(InodeNumber{42}, now + 1ms));
+}
+
+TEST(GetattrFollowUpTrackerTest, latestProcedureIsBlamed) {
+  GetattrFollowUpTracker tracker{1ms, 1};
+  auto now = GetattrFollowUpTracker::Clock::now();
+  tracker.recordCompletion(InodeNumber{42}, kWrite, now);
+  tracker.recordCompletion(InodeNumber{42}, kCommit, now + 1us);
+  EXPECT_EQ(kCommit, tracker.getattrReceived(InodeNumber{42}, now + 2us));
+
+  // With a single slot, another inode evicts the first one.
+  tracker.recordCompletion(InodeNumber{42}, kWrite, now);
+  tracker.recordCompletion(InodeNumber{43}, kWrite, now);
+  EXPECT_EQ(std::nullopt, tracker.getattrReceived(InodeNumber{42}, now));
+  EXPECT_EQ(kWrite, tracker.getattrReceived(InodeNumber{43}, now));
+}
+
+#endif
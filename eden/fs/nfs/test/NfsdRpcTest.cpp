@@ -43,6 +43,30 @@ TEST(NfsdRpcTest, variant) {
   roundtrip(var4);
 }
 
+TEST(NfsdRpcTest, serializeReadResOk) {
+  auto data = folly::IOBuf::copyBuffer("some file contents");
+  READ3res res{
+      {{nfsstat3::NFS3_OK,
+        READ3resok{post_op_attr{fattr3{}}, 18, true, data->clone()}}}};
+  auto expected = ser(res);
+
+  folly::IOBufQueue queue;
+  folly::io::QueueAppender appender(&queue, 1024);
+  serializeReadResOk(
+      appender, READ3resok{post_op_attr{fattr3{}}, 18, true, std::move(data)});
+  EXPECT_TRUE(folly::IOBufEqualTo()(expected, queue.move()));
+}
+
+TEST(NfsdRpcTest, commit) {
+  roundtrip(COMMIT3args{nfs_fh3{InodeNumber{42}}, 4096, 8192});
+
+  COMMIT3res ok{{{nfsstat3::NFS3_OK, COMMIT3resok{wcc_data{}, 0x1234}}}};
+  roundtrip(ok);
+
+  COMMIT3res fail{{{nfsstat3::NFS3ERR_IO, COMMIT3resfail{wcc_data{}}}}};
+  roundtrip(fail);
+}
+
 } // namespace facebook::eden
 
 #endif
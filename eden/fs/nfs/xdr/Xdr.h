@@ -209,6 +209,16 @@ void serialize_iobuf(
     folly::io::QueueAppender& appender,
     const folly::IOBuf& buf);
 
+/**
+ * Serialize an IOBuf chain like above, but move its buffers into the
+ * appender's queue rather than cloning every element of the chain. The data
+ * itself is never copied, unless it is small enough to be packed into the
+ * tailroom of the queue.
+ */
+void serialize_iobuf(
+    folly::io::QueueAppender& appender,
+    std::unique_ptr<folly::IOBuf> buf);
+
 /**
  * Skip the padding bytes that were written during serialization.
  */
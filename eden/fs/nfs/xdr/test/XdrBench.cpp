@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include <folly/io/IOBuf.h>
+#include <folly/io/IOBufQueue.h>
+
+#include "eden/common/utils/benchharness/Bench.h"
+#include "eden/fs/nfs/xdr/Xdr.h"
+
+namespace facebook::eden {
+
+struct BenchEntry {
+  uint64_t fileid;
+  std::string name;
+  uint64_t cookie;
+};
+EDEN_XDR_SERDE_DECL(BenchEntry, fileid, name, cookie);
+EDEN_XDR_SERDE_IMPL(BenchEntry, fileid, name, cookie);
+
+namespace {
+
+constexpr size_t kDefaultBufferSize = 1024;
+
+/**
+ * A 1MiB read reply, as a chain of 64KiB buffers like the ones of a blob.
+ */
+std::unique_ptr<folly::IOBuf> makeReadData() {
+  constexpr size_t kChunkSize = 64 * 1024;
+  std::unique_ptr<folly::IOBuf> data;
+  for (size_t i = 0; i < 16; i++) {
+    auto chunk = folly::IOBuf::create(kChunkSize);
+    chunk->append(kChunkSize);
+    memset(chunk->writableData(), 'a', kChunkSize);
+    if (data) {
+      data->appendToChain(std::move(chunk));
+    } else {
+      data = std::move(chunk);
+    }
+  }
+  return data;
+}
+
+void serializeClonedIOBuf(benchmark::State& st) {
+  auto data = makeReadData();
+  auto length = data->computeChainDataLength();
+  for (auto _ : st) {
+    folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+    folly::io::QueueAppender appender(&queue, kDefaultBufferSize);
+    detail::serialize_iobuf(appender, *data);
+    benchmark::DoNotOptimize(queue.front());
+  }
+  st.SetBytesProcessed(st.iterations() * length);
+}
+
+void serializeMovedIOBuf(benchmark::State& st) {
+  auto data = makeReadData();
+  auto length = data->computeChainDataLength();
+  for (auto _ : st) {
+    // The chain handed over by FileInode::read is already built, only time
+    // its serialization.
+    auto buf = data->clone();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+    folly::io::QueueAppender appender(&queue, kDefaultBufferSize);
+    detail::serialize_iobuf(appender, std::move(buf));
+    benchmark::DoNotOptimize(queue.front());
+    auto end = std::chrono::high_resolution_clock::now();
+
+    auto elapsed =
+        std::chrono::duration_cast<std::chrono::duration<double>>(end - start);
+    st.SetIterationTime(elapsed.count());
+  }
+  st.SetBytesProcessed(st.iterations() * length);
+}
+
+XdrList<BenchEntry> makeDirList() {
+  XdrList<BenchEntry> list;
+  for (uint64_t i = 0; i < 1000; i++) {
+    list.list.push_back(BenchEntry{i, fmt::format("file_number_{}", i), i});
+  }
+  return list;
+}
+
+void serializeDirListGrowing(benchmark::State& st) {
+  auto list = makeDirList();
+  auto size = XdrTrait<XdrList<BenchEntry>>::serializedSize(list);
+  for (auto _ : st) {
+    folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+    folly::io::QueueAppender appender(&queue, kDefaultBufferSize);
+    XdrTrait<XdrList<BenchEntry>>::serialize(appender, list);
+    benchmark::DoNotOptimize(queue.front());
+  }
+  st.SetBytesProcessed(st.iterations() * size);
+}
+
+void serializeDirListReserved(benchmark::State& st) {
+  auto list = makeDirList();
+  auto size = XdrTrait<XdrList<BenchEntry>>::serializedSize(list);
+  for (auto _ : st) {
+    folly::IOBufQueue queue{folly::IOBufQueue::cacheChainLength()};
+    folly::io::QueueAppender appender(&queue, kDefaultBufferSize);
+    appender.ensure(size);
+    XdrTrait<XdrList<BenchEntry>>::serialize(appender, list);
+    benchmark::DoNotOptimize(queue.front());
+  }
+  st.SetBytesProcessed(st.iterations() * size);
+}
+
+BENCHMARK(serializeClonedIOBuf);
+BENCHMARK(serializeMovedIOBuf)->UseManualTime();
+BENCHMARK(serializeDirListGrowing);
+BENCHMARK(serializeDirListReserved);
+
+} // namespace
+} // namespace facebook::eden
+
+EDEN_BENCHMARK_MAIN();
+
+#endif
@@ -139,6 +139,27 @@ TEST(XdrSerialize, iobuf) {
   roundtrip(std::move(buf));
 }
 
+TEST(XdrSerialize, movedIobufIsNotCopied) {
+  // Larger than what IOBufQueue packs into the tailroom of its last buffer.
+  auto data = folly::IOBuf::create(16 * 1024 + 1);
+  data->append(16 * 1024 + 1);
+  memset(data->writableData(), 'a', data->length());
+  auto dataPtr = data->data();
+  auto expected = ser(data);
+
+  folly::IOBufQueue queue;
+  folly::io::QueueAppender appender(&queue, 1024);
+  detail::serialize_iobuf(appender, std::move(data));
+  auto encoded = queue.move();
+
+  bool shared = false;
+  for (const auto& buf : *encoded) {
+    shared |= buf.data() == dataPtr;
+  }
+  EXPECT_TRUE(shared);
+  EXPECT_TRUE(folly::IOBufEqualTo()(expected, encoded));
+}
+
 struct ListElement {
   uint32_t value;
 };
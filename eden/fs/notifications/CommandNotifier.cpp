@@ -7,7 +7,10 @@
 
 #include "eden/fs/notifications/CommandNotifier.h"
 
+#include <folly/ExceptionString.h>
 #include <folly/futures/Future.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/utils/SpawnedProcess.h"
 #include "eden/fs/utils/SystemError.h"
@@ -15,6 +18,15 @@
 namespace facebook::eden {
 
 namespace {
+
+// Notifications beyond this many waiting for their command are dropped, and
+// counted as suppressed.
+constexpr size_t kMaxQueuedCommands = 8;
+
+// A command still running after this long is left to finish on its own, so
+// that a stuck command doesn't hold back the next notifications.
+constexpr auto kCommandTimeout = std::chrono::seconds(30);
+
 bool isGenericConnectivityError(const std::exception& err) {
   int errnum = EIO;
   if (auto* sys = dynamic_cast<const std::system_error*>(&err)) {
@@ -28,6 +40,17 @@ bool isGenericConnectivityError(const std::exception& err) {
 }
 } // namespace
 
+CommandNotifier::~CommandNotifier() {
+  {
+    auto state = state_.lock();
+    state->stopRequested = true;
+  }
+  workCV_.notify_one();
+  if (workerThread_.joinable()) {
+    workerThread_.join();
+  }
+}
+
 void CommandNotifier::showNotification(
     std::string_view notifTitle,
     std::string_view notifBody,
@@ -45,7 +68,8 @@ void CommandNotifier::showNetworkNotification(const std::exception& err) {
     return;
   }
 
-  if (!updateLastShown()) {
+  auto suppressed = admitNotification("network");
+  if (!suppressed) {
     return;
   }
 
@@ -62,7 +86,58 @@ void CommandNotifier::showNetworkNotification(const std::exception& err) {
   args.emplace_back(
       config_->getEdenConfig()->genericErrorNotificationCommand.getValue());
 
-  SpawnedProcess(args).detach();
+  enqueue(Command{std::move(args), *suppressed});
+}
+
+void CommandNotifier::enqueue(Command command) {
+  {
+    auto state = state_.lock();
+    if (state->commands.size() >= kMaxQueuedCommands) {
+      recordSuppressed();
+      return;
+    }
+    state->commands.push_back(std::move(command));
+    if (!workerThread_.joinable()) {
+      workerThread_ = std::thread{[this] {
+        folly::setThreadName("CommandNotifier");
+        runCommandsOnWorkerThread();
+      }};
+    }
+  }
+  workCV_.notify_one();
+}
+
+void CommandNotifier::runCommandsOnWorkerThread() {
+  for (;;) {
+    Command command;
+    {
+      auto state = state_.lock();
+      workCV_.wait(state.as_lock(), [&] {
+        return !state->commands.empty() || state->stopRequested;
+      });
+      if (state->stopRequested) {
+        return;
+      }
+      command = std::move(state->commands.front());
+      state->commands.pop_front();
+    }
+
+    try {
+      SpawnedProcess::Options opts;
+      opts.environment().set(
+          "EDENFS_SUPPRESSED_NOTIFICATIONS",
+          folly::to<std::string>(command.suppressed));
+      SpawnedProcess process{std::move(command.args), std::move(opts)};
+      recordShown();
+      process.waitTimeout(kCommandTimeout);
+      if (!process.terminated()) {
+        std::move(process).detach();
+      }
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "failed to run the notification command: "
+                << folly::exceptionStr(ex);
+    }
+  }
 }
 
 } // namespace facebook::eden
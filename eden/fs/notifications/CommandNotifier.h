@@ -7,6 +7,13 @@
 
 #pragma once
 
+#include <folly/Synchronized.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 #include "eden/fs/notifications/Notifier.h"
 
 namespace facebook::eden {
@@ -21,11 +28,18 @@ struct InodePopulationReport;
  * This is implemented by invoking the command specified by the
  * configuration value named:
  * notifications:generic-connectivity-notification-cmd
+ *
+ * The commands are run one at a time by a background thread, so that the
+ * thread reporting the error doesn't pay for spawning them and an outage
+ * doesn't fork a process per failed request.  The number of notifications
+ * suppressed since the previous command is passed in the
+ * EDENFS_SUPPRESSED_NOTIFICATIONS environment variable.
  */
 class CommandNotifier : public Notifier {
  public:
   explicit CommandNotifier(std::shared_ptr<ReloadableConfig> edenConfig)
       : Notifier(std::move(edenConfig)) {}
+  ~CommandNotifier() override;
 
   void showNotification(
       std::string_view notifTitle,
@@ -39,6 +53,25 @@ class CommandNotifier : public Notifier {
   void registerInodePopulationReportCallback(
       std::function<std::vector<InodePopulationReport>()> /*callback*/)
       override {}
+
+ private:
+  struct Command {
+    std::vector<std::string> args;
+    uint64_t suppressed;
+  };
+
+  struct State {
+    std::deque<Command> commands;
+    bool stopRequested{false};
+  };
+
+  void enqueue(Command command);
+  void runCommandsOnWorkerThread();
+
+  folly::Synchronized<State, std::mutex> state_;
+  std::condition_variable workCV_;
+  // Started by the first notification, since most processes never show any.
+  std::thread workerThread_;
 };
 
 } // namespace facebook::eden
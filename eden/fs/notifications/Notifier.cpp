@@ -8,26 +8,37 @@
 #include "eden/fs/notifications/Notifier.h"
 
 #include <folly/futures/Future.h>
+#include <utility>
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/utils/SystemError.h"
 
 namespace facebook::eden {
 
-bool Notifier::updateLastShown() {
-  if (!config_->getEdenConfig()->enableNotifications.getValue()) {
-    return false;
+std::optional<uint64_t> Notifier::admitNotification(
+    std::string_view category) {
+  auto config = config_->getEdenConfig();
+  if (!config->enableNotifications.getValue()) {
+    return std::nullopt;
   }
+  auto interval = config->notificationInterval.getValue();
+  auto maxPerInterval = config->notificationMaxPerInterval.getValue();
+
   auto now = std::chrono::steady_clock::now();
-  auto last = lastShown_.wlock();
-  if (*last) {
-    auto expiry = last->value() +
-        config_->getEdenConfig()->notificationInterval.getValue();
-    if (now < expiry) {
-      return false;
-    }
+  auto categories = categories_.wlock();
+  auto [it, inserted] =
+      categories->try_emplace(std::string{category}, CategoryState{now});
+  auto& state = it->second;
+  if (!inserted && now >= state.windowStart + interval) {
+    state.windowStart = now;
+    state.shownInWindow = 0;
+  }
+  if (state.shownInWindow >= maxPerInterval) {
+    ++state.suppressedSinceShown;
+    recordSuppressed();
+    return std::nullopt;
   }
-  *last = std::chrono::steady_clock::now();
-  return true;
+  ++state.shownInWindow;
+  return std::exchange(state.suppressedSinceShown, 0);
 }
 
 } // namespace facebook::eden
@@ -8,7 +8,12 @@
 #pragma once
 
 #include <folly/Synchronized.h>
+#include <atomic>
+#include <chrono>
 #include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include "eden/fs/config/ReloadableConfig.h"
 
 namespace facebook::eden {
@@ -27,8 +32,10 @@ class ReloadableConfig;
  * might instead trigger eg: a Workplace Messenger chat notification.
  *
  * This Notifications instance will throttle the rate at which these
- * occur based on the value of the notifications:interval configuration
- * which defaults to a reasonable value to avoid spamming the user.
+ * occur: at most notifications:max-per-interval notifications of each
+ * category are shown per notifications:interval, which default to reasonable
+ * values to avoid spamming the user.  The suppressed notifications are
+ * counted, and mentioned by the next notification of their category.
  *
  * Users can also disable notifications altogether.
  */
@@ -63,11 +70,56 @@ class Notifier {
   virtual void registerInodePopulationReportCallback(
       std::function<std::vector<InodePopulationReport>()> callback) = 0;
 
+  /**
+   * The number of notifications shown, and of those suppressed by the rate
+   * limit, since this Notifier was created.
+   */
+  struct Counts {
+    uint64_t shown{0};
+    uint64_t suppressed{0};
+  };
+  Counts getCounts() const {
+    return Counts{
+        shown_.load(std::memory_order_relaxed),
+        suppressed_.load(std::memory_order_relaxed)};
+  }
+
  protected:
-  bool updateLastShown();
+  /**
+   * Check whether a notification of the given category can be shown now.
+   *
+   * Returns std::nullopt if notifications are disabled or if this would
+   * exceed the rate limit of its category, in which case it is counted as
+   * suppressed.  Otherwise returns the number of notifications of this
+   * category suppressed since the previous one shown, so that this one can
+   * mention them.
+   */
+  std::optional<uint64_t> admitNotification(std::string_view category);
+
+  /**
+   * Record that an admitted notification was shown, or that it was dropped
+   * because too many are already waiting to be shown.
+   */
+  void recordShown() {
+    shown_.fetch_add(1, std::memory_order_relaxed);
+  }
+  void recordSuppressed() {
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+  }
+
   std::shared_ptr<ReloadableConfig> config_;
-  folly::Synchronized<std::optional<std::chrono::steady_clock::time_point>>
-      lastShown_;
+
+ private:
+  struct CategoryState {
+    std::chrono::steady_clock::time_point windowStart;
+    uint64_t shownInWindow{0};
+    uint64_t suppressedSinceShown{0};
+  };
+
+  folly::Synchronized<std::unordered_map<std::string, CategoryState>>
+      categories_;
+  std::atomic<uint64_t> shown_{0};
+  std::atomic<uint64_t> suppressed_{0};
 };
 
 } // namespace facebook::eden
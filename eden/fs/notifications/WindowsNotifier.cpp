@@ -788,7 +788,12 @@ void WindowsNotifier::showNotification(
     std::string_view notifTitle,
     std::string_view notifBody,
     std::string_view mount = {}) {
-  if (!areNotificationsEnabled() || !updateLastShown()) {
+  if (!areNotificationsEnabled()) {
+    return;
+  }
+  // The title tells the kind of notification apart.
+  auto suppressed = admitNotification(notifTitle);
+  if (!suppressed) {
     return;
   }
 
@@ -797,6 +802,10 @@ void WindowsNotifier::showNotification(
   if (!mount.empty()) {
     body = fmt::format("{}: {}", mount, body);
   }
+  if (*suppressed != 0) {
+    body = fmt::format(
+        "{} ({} similar notifications were suppressed)", body, *suppressed);
+  }
 
   // Win32 NOTIFYICONDATAW has a limit for the length of notification
   // titles and bodies. We need to truncate any titles/bodies that are too long
@@ -811,6 +820,7 @@ void WindowsNotifier::showNotification(
   notif->body = std::move(body);
   notif->title = std::move(title);
   notifQ_.push(std::move(notif));
+  recordShown();
   PostMessage(
       hwnd_.get(),
       WM_COMMAND,
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/notifications/Notifier.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/config/EdenConfig.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+class TestNotifier : public Notifier {
+ public:
+  using Notifier::admitNotification;
+  using Notifier::Notifier;
+
+  void showNotification(std::string_view, std::string_view, std::string_view)
+      override {}
+  void showNetworkNotification(const std::exception&) override {}
+  void signalCheckout(size_t) override {}
+  void registerInodePopulationReportCallback(
+      std::function<std::vector<InodePopulationReport>()>) override {}
+};
+
+class NotifierTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    config_ = EdenConfig::createTestEdenConfig();
+    config_->enableNotifications.setValue(true, ConfigSource::CommandLine);
+    config_->notificationInterval.setValue(1h, ConfigSource::CommandLine);
+    config_->notificationMaxPerInterval.setValue(2, ConfigSource::CommandLine);
+    notifier_ = std::make_unique<TestNotifier>(
+        std::make_shared<ReloadableConfig>(
+            config_, ConfigReloadBehavior::NoReload));
+  }
+
+  std::shared_ptr<EdenConfig> config_;
+  std::unique_ptr<TestNotifier> notifier_;
+};
+
+} // namespace
+
+TEST_F(NotifierTest, notifications_beyond_the_limit_are_suppressed) {
+  EXPECT_EQ(0, notifier_->admitNotification("network"));
+  EXPECT_EQ(0, notifier_->admitNotification("network"));
+  EXPECT_EQ(std::nullopt, notifier_->admitNotification("network"));
+  EXPECT_EQ(std::nullopt, notifier_->admitNotification("network"));
+  EXPECT_EQ(2, notifier_->getCounts().suppressed);
+}
+
+TEST_F(NotifierTest, categories_are_limited_separately) {
+  EXPECT_EQ(0, notifier_->admitNotification("network"));
+  EXPECT_EQ(0, notifier_->admitNotification("network"));
+  EXPECT_EQ(std::nullopt, notifier_->admitNotification("network"));
+  EXPECT_EQ(0, notifier_->admitNotification("checkout"));
+}
+
+TEST_F(NotifierTest, next_notification_counts_the_suppressed_ones) {
+  EXPECT_EQ(0, notifier_->admitNotification("network"));
+  EXPECT_EQ(0, notifier_->admitNotification("network"));
+  EXPECT_EQ(std::nullopt, notifier_->admitNotification("network"));
+  EXPECT_EQ(std::nullopt, notifier_->admitNotification("network"));
+
+  // A new window starts with every notification.
+  config_->notificationInterval.setValue(0ns, ConfigSource::CommandLine);
+  EXPECT_EQ(2, notifier_->admitNotification("network"));
+  EXPECT_EQ(0, notifier_->admitNotification("network"));
+}
+
+TEST_F(NotifierTest, nothing_is_admitted_when_disabled) {
+  config_->enableNotifications.setValue(false, ConfigSource::CommandLine);
+  EXPECT_EQ(std::nullopt, notifier_->admitNotification("network"));
+  EXPECT_EQ(0, notifier_->getCounts().suppressed);
+}
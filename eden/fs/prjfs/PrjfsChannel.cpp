@@ -9,6 +9,7 @@
 
 #include "eden/fs/prjfs/PrjfsChannel.h"
 #include <fmt/format.h>
+#include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
 
 #include "eden/common/utils/StringConv.h"
@@ -36,6 +37,18 @@ static_assert(CheckSize<PrjfsTraceEvent, 48>());
 static_assert(
     CheckEqual<1200000, kTraceBusCapacity * sizeof(PrjfsTraceEvent)>());
 
+// Number of listed directories whose placeholders may be written together.
+constexpr size_t kMaxPlaceholderBatches = 64;
+
+// Number of files whose content is kept while ProjectedFS reads them.
+constexpr size_t kMaxFileDataStreams = 16;
+
+// Smallest aligned buffer handed out by the PrjfsAlignedBufferPool.
+constexpr size_t kMinAlignedBufferSize = 64 * 1024;
+
+// Number of free aligned buffers of each size kept by the pool.
+constexpr size_t kMaxFreeAlignedBuffers = 2;
+
 folly::ReadMostlySharedPtr<PrjfsChannelInner> getChannel(
     const PRJ_CALLBACK_DATA* callbackData) noexcept {
   XDCHECK(callbackData);
@@ -351,15 +364,21 @@ void detachAndCompleteCallback(
 } // namespace
 
 PrjfsChannelInner::PrjfsChannelInner(
+    AbsolutePathPiece mountPath,
     std::unique_ptr<PrjfsDispatcher> dispatcher,
     const folly::Logger* straceLogger,
     ProcessAccessLog& processAccessLog,
     folly::Promise<folly::Unit> deletedPromise,
-    std::shared_ptr<Notifier> notifier)
-    : dispatcher_(std::move(dispatcher)),
+    std::shared_ptr<Notifier> notifier,
+    folly::Executor& executor)
+    : mountPath_(mountPath),
+      dispatcher_(std::move(dispatcher)),
       straceLogger_(straceLogger),
       notifier_(std::move(notifier)),
       processAccessLog_(processAccessLog),
+      executor_(executor),
+      placeholderBatches_(kMaxPlaceholderBatches),
+      fileData_(kMaxFileDataStreams),
       deletedPromise_(std::move(deletedPromise)),
       traceDetailedArguments_(std::atomic<size_t>(0)),
       traceBus_(
@@ -388,6 +407,17 @@ PrjfsChannelInner::~PrjfsChannelInner() {
   deletedPromise_.setValue(folly::unit);
 }
 
+template <typename Func>
+ImmediateFuture<folly::Unit> PrjfsChannelInner::dispatchOnServiceThread(
+    Func&& func) {
+  return folly::via(
+             folly::getKeepAliveToken(executor_),
+             [func = std::forward<Func>(func)]() mutable {
+               return func().semi();
+             })
+      .semi();
+}
+
 ImmediateFuture<folly::Unit> PrjfsChannelInner::waitForPendingNotifications() {
   return dispatcher_->waitForPendingNotifications();
 }
@@ -399,7 +429,7 @@ HRESULT PrjfsChannelInner::startEnumeration(
     const GUID* enumerationId) {
   auto guid = Guid(*enumerationId);
   auto path = RelativePath(callbackData->FilePathName);
-  auto fut = makeImmediateFutureWith([this,
+  auto fut = dispatchOnServiceThread([this,
                                       context,
                                       guid = std::move(guid),
                                       path = std::move(path)]() mutable {
@@ -410,10 +440,12 @@ HRESULT PrjfsChannelInner::startEnumeration(
 
     FB_LOGF(
         getStraceLogger(), DBG7, "opendir({}, guid={})", path, guid.toString());
-    return dispatcher_
-        ->opendir(std::move(path), context->getObjectFetchContext())
-        .thenValue([this, context = std::move(context), guid = std::move(guid)](
-                       auto&& dirents) {
+    return dispatcher_->opendir(path, context->getObjectFetchContext())
+        .thenValue([this,
+                    context = std::move(context),
+                    guid = std::move(guid),
+                    path = std::move(path)](auto&& dirents) {
+          recordPlaceholderBatch(path, dirents);
           addDirectoryEnumeration(std::move(guid), std::move(dirents));
           context->sendSuccess();
         });
@@ -477,7 +509,7 @@ HRESULT PrjfsChannelInner::getEnumerationData(
     enumerator->restartEnumeration();
   }
 
-  auto fut = makeImmediateFutureWith([this,
+  auto fut = dispatchOnServiceThread([this,
                                       context,
                                       enumerator = std::move(enumerator),
                                       buffer = dirEntryBufferHandle] {
@@ -553,7 +585,7 @@ HRESULT PrjfsChannelInner::getPlaceholderInfo(
   auto path = RelativePath(callbackData->FilePathName);
   auto virtualizationContext = callbackData->NamespaceVirtualizationContext;
 
-  auto fut = makeImmediateFutureWith([this,
+  auto fut = dispatchOnServiceThread([this,
                                       context,
                                       path = std::move(path),
                                       virtualizationContext]() mutable {
@@ -566,7 +598,7 @@ HRESULT PrjfsChannelInner::getPlaceholderInfo(
     return dispatcher_
         ->lookup(std::move(path), context->getObjectFetchContext())
         .thenValue(
-            [context, virtualizationContext = virtualizationContext](
+            [this, context, virtualizationContext = virtualizationContext](
                 std::optional<LookupResult>&& optLookupResult)
                 -> ImmediateFuture<folly::Unit> {
               if (!optLookupResult) {
@@ -597,6 +629,17 @@ HRESULT PrjfsChannelInner::getPlaceholderInfo(
 
               context->sendSuccess();
 
+              // The request is complete, the sibling placeholders are written
+              // in the background.
+              auto batch = writeSiblingPlaceholders(
+                               lookupResult.path,
+                               context->getObjectFetchContext())
+                               .ensure([context] {});
+              if (!batch.isReady()) {
+                folly::futures::detachOnGlobalCPUExecutor(
+                    std::move(batch).semi());
+              }
+
               return folly::unit;
             });
   });
@@ -607,13 +650,96 @@ HRESULT PrjfsChannelInner::getPlaceholderInfo(
   return HRESULT_FROM_WIN32(ERROR_IO_PENDING);
 }
 
+void PrjfsChannelInner::recordPlaceholderBatch(
+    const RelativePath& path,
+    const std::vector<PrjfsDirEntry>& dirents) {
+  if (dirents.empty() || dirents.size() > placeholderBatchMaxEntries_) {
+    return;
+  }
+
+  std::vector<PathComponent> names;
+  names.reserve(dirents.size());
+  for (const auto& dirent : dirents) {
+    names.emplace_back(dirent.getName());
+  }
+  placeholderBatches_.wlock()->set(path, std::move(names));
+}
+
+ImmediateFuture<folly::Unit> PrjfsChannelInner::writeSiblingPlaceholders(
+    RelativePathPiece path,
+    const ObjectFetchContextPtr& context) {
+  auto dir = RelativePath{path.dirname()};
+  std::vector<PathComponent> names;
+  {
+    auto batches = placeholderBatches_.wlock();
+    auto it = batches->find(dir);
+    if (it == batches->end()) {
+      return folly::unit;
+    }
+    names = std::move(it->second);
+    batches->erase(dir);
+  }
+
+  std::vector<ImmediateFuture<std::optional<LookupResult>>> lookups;
+  for (const auto& name : names) {
+    if (name == path.basename()) {
+      continue;
+    }
+    auto childPath = dir + name;
+
+    // Leave alone the entries ProjectedFS already has a placeholder, a full
+    // file or a tombstone for.
+    PRJ_FILE_STATE state;
+    auto winPath = (mountPath_ + childPath).wide();
+    if (SUCCEEDED(PrjGetOnDiskFileState(winPath.c_str(), &state))) {
+      continue;
+    }
+    lookups.push_back(dispatcher_->lookup(std::move(childPath), context));
+  }
+  if (lookups.empty()) {
+    return folly::unit;
+  }
+
+  XLOGF(DBG6, "Writing {} placeholders in {}", lookups.size(), dir);
+  return collectAll(std::move(lookups))
+      .thenValue([this](std::vector<folly::Try<std::optional<LookupResult>>>
+                            results) {
+        for (const auto& result : results) {
+          if (result.hasException() || !result.value().has_value()) {
+            continue;
+          }
+          const auto& lookupResult = result.value().value();
+
+          PRJ_PLACEHOLDER_INFO placeholderInfo{};
+          placeholderInfo.FileBasicInfo.IsDirectory = lookupResult.isDir;
+          placeholderInfo.FileBasicInfo.FileSize = lookupResult.size;
+          auto inodeName = lookupResult.path.wide();
+
+          HRESULT hr = PrjWritePlaceholderInfo(
+              mountChannel_,
+              inodeName.c_str(),
+              &placeholderInfo,
+              sizeof(placeholderInfo));
+          if (FAILED(hr)) {
+            // ProjectedFS may have requested this placeholder meanwhile, or
+            // the entry may have been removed since it was looked up.
+            XLOGF(
+                DBG6,
+                "Couldn't write the placeholder for {}: {:#x}",
+                lookupResult.path,
+                static_cast<uint32_t>(hr));
+          }
+        }
+      });
+}
+
 HRESULT PrjfsChannelInner::queryFileName(
     std::shared_ptr<PrjfsRequestContext> context,
     const PRJ_CALLBACK_DATA* callbackData,
     std::unique_ptr<detail::PrjfsLiveRequest> liveRequest) {
   auto path = RelativePath(callbackData->FilePathName);
 
-  auto fut = makeImmediateFutureWith([this,
+  auto fut = dispatchOnServiceThread([this,
                                       context,
                                       path = std::move(path)]() mutable {
     auto requestWatch =
@@ -638,24 +764,60 @@ HRESULT PrjfsChannelInner::queryFileName(
   return HRESULT_FROM_WIN32(ERROR_IO_PENDING);
 }
 
-namespace {
+PrjfsAlignedBufferPool::~PrjfsAlignedBufferPool() {
+  for (auto& [size, buffers] : *free_.wlock()) {
+    for (auto* buffer : buffers) {
+      PrjFreeAlignedBuffer(buffer);
+    }
+  }
+}
 
-struct PrjAlignedBufferDeleter {
-  void operator()(void* buffer) noexcept {
-    ::PrjFreeAlignedBuffer(buffer);
+PrjfsAlignedBufferPool::Buffer PrjfsAlignedBufferPool::allocate(
+    PRJ_NAMESPACE_VIRTUALIZATION_CONTEXT context,
+    size_t size) {
+  size = folly::nextPowTwo(std::max(size, kMinAlignedBufferSize));
+  {
+    auto freeBuffers = free_.wlock();
+    auto it = freeBuffers->find(size);
+    if (it != freeBuffers->end() && !it->second.empty()) {
+      auto* data = it->second.back();
+      it->second.pop_back();
+      return Buffer{this, data, size};
+    }
   }
-};
+
+  auto* data = PrjAllocateAlignedBuffer(context, size);
+  if (data == nullptr) {
+    return Buffer{};
+  }
+  return Buffer{this, data, size};
+}
+
+void PrjfsAlignedBufferPool::release(void* data, size_t size) {
+  {
+    auto freeBuffers = free_.wlock();
+    auto& buffers = (*freeBuffers)[size];
+    if (buffers.size() < kMaxFreeAlignedBuffers) {
+      buffers.push_back(data);
+      return;
+    }
+  }
+  PrjFreeAlignedBuffer(data);
+}
+
+namespace {
 
 HRESULT readMultipleFileChunks(
     PRJ_NAMESPACE_VIRTUALIZATION_CONTEXT namespaceVirtualizationContext,
+    PrjfsAlignedBufferPool& bufferPool,
     const Guid& dataStreamId,
     const std::string& content,
     uint64_t startOffset,
     uint64_t length,
     uint64_t chunkSize) {
   HRESULT result;
-  std::unique_ptr<void, PrjAlignedBufferDeleter> writeBuffer{
-      PrjAllocateAlignedBuffer(namespaceVirtualizationContext, chunkSize)};
+  auto writeBuffer =
+      bufferPool.allocate(namespaceVirtualizationContext, chunkSize);
 
   if (writeBuffer.get() == nullptr) {
     return E_OUTOFMEMORY;
@@ -697,12 +859,14 @@ HRESULT readMultipleFileChunks(
 
 HRESULT readSingleFileChunk(
     PRJ_NAMESPACE_VIRTUALIZATION_CONTEXT namespaceVirtualizationContext,
+    PrjfsAlignedBufferPool& bufferPool,
     const Guid& dataStreamId,
     const std::string& content,
     uint64_t startOffset,
     uint64_t length) {
   return readMultipleFileChunks(
       namespaceVirtualizationContext,
+      bufferPool,
       dataStreamId,
       content,
       /*startOffset=*/startOffset,
@@ -725,7 +889,7 @@ HRESULT PrjfsChannelInner::getFileData(
     std::unique_ptr<detail::PrjfsLiveRequest> liveRequest,
     UINT64 byteOffset,
     UINT32 length) {
-  auto fut = makeImmediateFutureWith(
+  auto fut = dispatchOnServiceThread(
       [this,
        context,
        path = RelativePath(callbackData->FilePathName),
@@ -746,13 +910,19 @@ HRESULT PrjfsChannelInner::getFileData(
             path,
             byteOffset,
             length);
-        return dispatcher_
-            ->read(std::move(path), context->getObjectFetchContext())
-            .thenValue([context = std::move(context),
+        return readFileData(
+                   std::move(path),
+                   dataStreamId,
+                   context->getObjectFetchContext())
+            .thenValue([this,
+                        context = std::move(context),
                         virtualizationContext = virtualizationContext,
                         dataStreamId = std::move(dataStreamId),
                         byteOffset = byteOffset,
-                        length = length](const std::string content) {
+                        length = length](
+                           std::shared_ptr<const std::string> data) {
+              const auto& content = *data;
+
               //
               // We should return file data which is smaller than
               // our kMaxChunkSize and meets the memory alignment
@@ -767,6 +937,7 @@ HRESULT PrjfsChannelInner::getFileData(
                 //
                 result = readSingleFileChunk(
                     virtualizationContext,
+                    bufferPool_,
                     dataStreamId,
                     content,
                     /*startOffset=*/0,
@@ -779,6 +950,7 @@ HRESULT PrjfsChannelInner::getFileData(
                 //
                 result = readSingleFileChunk(
                     virtualizationContext,
+                    bufferPool_,
                     dataStreamId,
                     content,
                     /*startOffset=*/byteOffset,
@@ -802,6 +974,7 @@ HRESULT PrjfsChannelInner::getFileData(
                   uint64_t chunkSize = endOffset - startOffset;
                   result = readMultipleFileChunks(
                       virtualizationContext,
+                      bufferPool_,
                       dataStreamId,
                       content,
                       /*startOffset=*/startOffset,
@@ -810,6 +983,11 @@ HRESULT PrjfsChannelInner::getFileData(
                 }
               }
 
+              if (FAILED(result) || content.length() <= kMinChunkSize ||
+                  byteOffset + length >= content.length()) {
+                forgetFileData(dataStreamId);
+              }
+
               if (FAILED(result)) {
                 context->sendError(result);
               } else {
@@ -824,6 +1002,49 @@ HRESULT PrjfsChannelInner::getFileData(
   return HRESULT_FROM_WIN32(ERROR_IO_PENDING);
 }
 
+ImmediateFuture<std::shared_ptr<const std::string>>
+PrjfsChannelInner::readFileData(
+    RelativePath path,
+    const Guid& dataStreamId,
+    const ObjectFetchContextPtr& context) {
+  auto promise = std::make_shared<FileDataPromise>();
+  {
+    auto fileData = fileData_.wlock();
+    auto it = fileData->find(dataStreamId);
+    if (it != fileData->end()) {
+      return it->second->getSemiFuture();
+    }
+    fileData->set(dataStreamId, promise);
+  }
+
+  auto future = promise->getSemiFuture();
+  auto read =
+      dispatcher_->read(std::move(path), context)
+          .thenTry([this, promise, dataStreamId](
+                       folly::Try<std::string>&& content) {
+            if (content.hasException()) {
+              // Let the next request read it again.
+              auto fileData = fileData_.wlock();
+              auto it = fileData->find(dataStreamId);
+              if (it != fileData->end() && it->second == promise) {
+                fileData->erase(dataStreamId);
+              }
+              promise->setException(std::move(content).exception());
+            } else {
+              promise->setValue(std::make_shared<const std::string>(
+                  std::move(content).value()));
+            }
+          });
+  if (!read.isReady()) {
+    folly::futures::detachOnGlobalCPUExecutor(std::move(read).semi());
+  }
+  return future;
+}
+
+void PrjfsChannelInner::forgetFileData(const Guid& dataStreamId) {
+  fileData_.wlock()->erase(dataStreamId);
+}
+
 std::vector<PrjfsChannelInner::OutstandingRequest>
 PrjfsChannelInner::getOutstandingRequests() {
   std::vector<PrjfsChannelInner::OutstandingRequest> outstandingCalls;
@@ -1118,9 +1339,23 @@ HRESULT PrjfsChannelInner::notification(
         isDirectory,
         context->getObjectFetchContext());
 
-    // Since the future should just be enqueing to an executor, it should
-    // always be ready.
-    return tryToHResult(std::move(fut).getTry(0ms));
+    // The handlers are called right away, in the order ProjectedFS sent the
+    // notifications, and mostly just enqueue to an executor. Those that can't
+    // complete right away are completed asynchronously.
+    auto semi = std::move(fut).semi();
+    if (semi.isReady()) {
+      return tryToHResult(std::move(semi).getTry());
+    }
+    folly::futures::detachOnGlobalCPUExecutor(std::move(semi).defer(
+        [context = std::move(context)](folly::Try<folly::Unit>&& try_) {
+          auto result = tryToHResult(try_);
+          if (result == S_OK) {
+            context->sendNotificationSuccess();
+          } else {
+            context->sendError(result);
+          }
+        }));
+    return HRESULT_FROM_WIN32(ERROR_IO_PENDING);
   }
 }
 
@@ -1154,19 +1389,23 @@ PrjfsChannel::PrjfsChannel(
     const folly::Logger* straceLogger,
     std::shared_ptr<ProcessNameCache> processNameCache,
     Guid guid,
-    std::shared_ptr<Notifier> notifier)
+    std::shared_ptr<Notifier> notifier,
+    size_t numServicingThreads)
     : mountPath_(mountPath),
       mountId_(std::move(guid)),
-      processAccessLog_(std::move(processNameCache)) {
+      processAccessLog_(std::move(processNameCache)),
+      executor_(numServicingThreads, "PrjfsServicing") {
   auto [innerDeletedPromise, innerDeletedFuture] =
       folly::makePromiseContract<folly::Unit>();
   innerDeleted_ = std::move(innerDeletedFuture);
   inner_.store(std::make_shared<PrjfsChannelInner>(
+      mountPath_,
       std::move(dispatcher),
       straceLogger,
       processAccessLog_,
       std::move(innerDeletedPromise),
-      std::move(notifier)));
+      std::move(notifier),
+      executor_));
 }
 
 PrjfsChannel::~PrjfsChannel() {
@@ -1174,7 +1413,11 @@ PrjfsChannel::~PrjfsChannel() {
       << "stop() must be called before destroying the channel";
 }
 
-void PrjfsChannel::start(bool readOnly, bool useNegativePathCaching) {
+void PrjfsChannel::start(
+    bool readOnly,
+    bool useNegativePathCaching,
+    size_t placeholderBatchMaxEntries,
+    uint32_t numCallbackThreads) {
   if (readOnly) {
     NOT_IMPLEMENTED();
   }
@@ -1209,12 +1452,19 @@ void PrjfsChannel::start(bool readOnly, bool useNegativePathCaching) {
     startOpts.Flags = PRJ_FLAG_USE_NEGATIVE_PATH_CACHE;
   }
 
+  // The callbacks only queue work on the servicing threads, few threads are
+  // enough to dispatch them.
+  startOpts.PoolThreadCount = numCallbackThreads;
+  startOpts.ConcurrentThreadCount = numCallbackThreads;
+
   XLOGF(
       INFO,
       "Starting PrjfsChannel for: {} with GUID: {}",
       mountPath_,
       mountId_);
 
+  getInner()->setPlaceholderBatchMaxEntries(placeholderBatchMaxEntries);
+
   auto winPath = mountPath_.wide();
 
   auto result = PrjMarkDirectoryAsPlaceholder(
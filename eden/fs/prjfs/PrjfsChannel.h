@@ -7,9 +7,13 @@
 
 #pragma once
 
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/container/F14Map.h>
 #include <folly/experimental/AtomicReadMostlyMainPtr.h>
+#include <folly/futures/SharedPromise.h>
 #include <folly/portability/Windows.h>
 #include <thrift/lib/cpp/util/EnumUtils.h>
+#include <utility>
 
 #include "eden/fs/prjfs/Enumerator.h"
 #include "eden/fs/prjfs/PrjfsDispatcher.h"
@@ -18,6 +22,7 @@
 #include "eden/fs/utils/Guid.h"
 #include "eden/fs/utils/PathFuncs.h"
 #include "eden/fs/utils/ProcessAccessLog.h"
+#include "eden/fs/utils/UnboundedQueueExecutor.h"
 
 #ifdef _WIN32
 #include <ProjectedFSLib.h> // @manual
@@ -126,14 +131,73 @@ struct PrjfsTraceEvent : TraceEventBase {
   Details details_;
 };
 
+/**
+ * Recycles the aligned buffers that file data is copied into before being
+ * handed to ProjectedFS, rather than allocating and freeing one for each
+ * GetFileData callback.
+ *
+ * Buffers are rounded up to a power of two, and a few free buffers of each
+ * size are kept.
+ */
+class PrjfsAlignedBufferPool {
+ public:
+  class Buffer {
+   public:
+    Buffer() = default;
+    Buffer(PrjfsAlignedBufferPool* pool, void* data, size_t size)
+        : pool_{pool}, data_{data}, size_{size} {}
+    Buffer(Buffer&& other) noexcept
+        : pool_{other.pool_},
+          data_{std::exchange(other.data_, nullptr)},
+          size_{other.size_} {}
+    Buffer& operator=(Buffer&&) = delete;
+    ~Buffer() {
+      if (data_) {
+        pool_->release(data_, size_);
+      }
+    }
+
+    /**
+     * The buffer, nullptr if it couldn't be allocated.
+     */
+    void* get() const {
+      return data_;
+    }
+
+   private:
+    PrjfsAlignedBufferPool* pool_{nullptr};
+    void* data_{nullptr};
+    size_t size_{0};
+  };
+
+  PrjfsAlignedBufferPool() = default;
+  ~PrjfsAlignedBufferPool();
+
+  PrjfsAlignedBufferPool(const PrjfsAlignedBufferPool&) = delete;
+  PrjfsAlignedBufferPool& operator=(const PrjfsAlignedBufferPool&) = delete;
+
+  /**
+   * Return a buffer of at least size bytes, aligned for the storage device of
+   * the virtualization instance.
+   */
+  Buffer allocate(PRJ_NAMESPACE_VIRTUALIZATION_CONTEXT context, size_t size);
+
+ private:
+  void release(void* data, size_t size);
+
+  folly::Synchronized<folly::F14FastMap<size_t, std::vector<void*>>> free_;
+};
+
 class PrjfsChannelInner {
  public:
   PrjfsChannelInner(
+      AbsolutePathPiece mountPath,
       std::unique_ptr<PrjfsDispatcher> dispatcher,
       const folly::Logger* straceLogger,
       ProcessAccessLog& processAccessLog,
       folly::Promise<folly::Unit> deletedPromise,
-      std::shared_ptr<Notifier> notifier);
+      std::shared_ptr<Notifier> notifier,
+      folly::Executor& executor);
 
   ~PrjfsChannelInner();
 
@@ -311,6 +375,14 @@ class PrjfsChannelInner {
     mountChannel_ = channel;
   }
 
+  /**
+   * See PrjfsChannel::start. Must be called before ProjectedFS starts
+   * invoking the callbacks.
+   */
+  void setPlaceholderBatchMaxEntries(size_t maxEntries) {
+    placeholderBatchMaxEntries_ = maxEntries;
+  }
+
   void sendSuccess(
       int32_t commandId,
       PRJ_COMPLETE_COMMAND_EXTENDED_PARAMETERS* FOLLY_NULLABLE extra);
@@ -348,6 +420,31 @@ class PrjfsChannelInner {
     return *straceLogger_;
   }
 
+  /**
+   * Run func, which dispatches a callback, on executor_ rather than on the
+   * ProjectedFS thread that invoked the callback, so that thread is free to
+   * take the next callback even when func blocks, e.g. reading the local
+   * store.
+   */
+  template <typename Func>
+  ImmediateFuture<folly::Unit> dispatchOnServiceThread(Func&& func);
+
+  /**
+   * Read the content of the file at path for the GetFileData callbacks of
+   * dataStreamId. ProjectedFS may request a file in several chunks, sharing
+   * the same dataStreamId: the content is only read once for all of them,
+   * until forgetFileData is called.
+   */
+  ImmediateFuture<std::shared_ptr<const std::string>> readFileData(
+      RelativePath path,
+      const Guid& dataStreamId,
+      const ObjectFetchContextPtr& context);
+
+  /**
+   * Called once the last chunk of dataStreamId has been written.
+   */
+  void forgetFileData(const Guid& dataStreamId);
+
   void addDirectoryEnumeration(Guid guid, std::vector<PrjfsDirEntry> dirents) {
     auto [iterator, inserted] = enumSessions_.wlock()->emplace(
         std::move(guid), std::make_shared<Enumerator>(std::move(dirents)));
@@ -366,6 +463,25 @@ class PrjfsChannelInner {
     return it->second;
   }
 
+  /**
+   * Remember the entries of a directory that was just listed, if it is small
+   * enough for placeholders to be created for all of them together.
+   */
+  void recordPlaceholderBatch(
+      const RelativePath& path,
+      const std::vector<PrjfsDirEntry>& dirents);
+
+  /**
+   * Called once ProjectedFS asked for the placeholder of path. If its parent
+   * directory was recorded by recordPlaceholderBatch, this is likely a crawler
+   * going through every entry of it: write the placeholders of the siblings
+   * of path that aren't on disk yet, saving a getPlaceholderInfo callback for
+   * each of them.
+   */
+  ImmediateFuture<folly::Unit> writeSiblingPlaceholders(
+      RelativePathPiece path,
+      const ObjectFetchContextPtr& context);
+
   void removeDirectoryEnumeration(Guid& guid) {
     enumSessions_.wlock()->erase(guid);
     // In theory, we should check that we removed an entry, but ProjectedFS
@@ -378,6 +494,8 @@ class PrjfsChannelInner {
   // Internal ProjectedFS channel used to communicate with ProjectedFS.
   PRJ_NAMESPACE_VIRTUALIZATION_CONTEXT mountChannel_{nullptr};
 
+  const AbsolutePath mountPath_;
+
   std::unique_ptr<PrjfsDispatcher> dispatcher_;
   const folly::Logger* const straceLogger_{nullptr};
 
@@ -387,10 +505,32 @@ class PrjfsChannelInner {
   // its lifetime be longer than that of PrjfsChannelInner.
   ProcessAccessLog& processAccessLog_;
 
+  // Runs the callbacks, also owned by PrjfsChannel.
+  folly::Executor& executor_;
+
   // Set of currently active directory enumerations.
   folly::Synchronized<folly::F14FastMap<Guid, std::shared_ptr<Enumerator>>>
       enumSessions_;
 
+  // Directories with at most that many entries have the placeholders of all
+  // their entries written together, 0 to disable.
+  size_t placeholderBatchMaxEntries_{0};
+
+  // The entries of the small directories listed recently that may have their
+  // placeholders written together.
+  folly::Synchronized<
+      folly::EvictingCacheMap<RelativePath, std::vector<PathComponent>>>
+      placeholderBatches_;
+
+  // The content of the files being read by ProjectedFS, by data stream.
+  using FileDataPromise =
+      folly::SharedPromise<std::shared_ptr<const std::string>>;
+  folly::Synchronized<
+      folly::EvictingCacheMap<Guid, std::shared_ptr<FileDataPromise>>>
+      fileData_;
+
+  PrjfsAlignedBufferPool bufferPool_;
+
   // Set when the destructor is called.
   folly::Promise<folly::Unit> deletedPromise_;
 
@@ -419,11 +559,27 @@ class PrjfsChannel {
       const folly::Logger* straceLogger,
       std::shared_ptr<ProcessNameCache> processNameCache,
       Guid guid,
-      std::shared_ptr<Notifier> notifier);
+      std::shared_ptr<Notifier> notifier,
+      size_t numServicingThreads);
 
   virtual ~PrjfsChannel();
 
-  void start(bool readOnly, bool useNegativePathCaching);
+  /**
+   * Start the channel.
+   *
+   * Once a directory with at most placeholderBatchMaxEntries entries is listed
+   * and the placeholder of one of its entries is requested, the placeholders
+   * of all of them are written, 0 to disable.
+   *
+   * The callbacks are dispatched from numCallbackThreads ProjectedFS threads,
+   * 0 for the ProjectedFS default, and then run on the channel's servicing
+   * threads.
+   */
+  void start(
+      bool readOnly,
+      bool useNegativePathCaching,
+      size_t placeholderBatchMaxEntries,
+      uint32_t numCallbackThreads);
 
   /**
    * Wait for all the received notifications to be fully handled.
@@ -500,6 +656,9 @@ class PrjfsChannel {
 
   ProcessAccessLog processAccessLog_;
 
+  // Servicing threads of the callbacks.
+  UnboundedQueueExecutor executor_;
+
   folly::AtomicReadMostlyMainPtr<PrjfsChannelInner> inner_;
   folly::SemiFuture<folly::Unit> innerDeleted_;
 
@@ -10,10 +10,25 @@
 #include <folly/portability/GFlags.h>
 
 DEFINE_int32(num_eden_threads, 12, "the number of eden CPU worker threads");
+DEFINE_bool(
+    eden_threads_work_stealing,
+    false,
+    "give each eden CPU worker thread its own queue, and let the idle ones "
+    "steal from the others, rather than sharing a single queue");
+DEFINE_bool(
+    eden_threads_numa_affinity,
+    false,
+    "spread the eden CPU worker threads over the NUMA nodes, and restrict "
+    "each of them to the CPUs of its node");
 
 namespace facebook::eden {
 
 EdenCPUThreadPool::EdenCPUThreadPool()
-    : UnboundedQueueExecutor(FLAGS_num_eden_threads, "EdenCPUThread") {}
+    : UnboundedQueueExecutor(
+          FLAGS_num_eden_threads,
+          "EdenCPUThread",
+          FLAGS_eden_threads_work_stealing ? Scheduling::WorkStealing
+                                           : Scheduling::SharedQueue,
+          FLAGS_eden_threads_numa_affinity) {}
 
 } // namespace facebook::eden
@@ -36,6 +36,7 @@
 #include "eden/fs/store/BackingStoreLogger.h"
 #include "eden/fs/store/EmptyBackingStore.h"
 #include "eden/fs/store/LocalStoreCachedBackingStore.h"
+#include "eden/fs/store/LocalStoreIngester.h"
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
 #include "eden/fs/telemetry/IHiveLogger.h"
 #include "eden/fs/telemetry/SessionInfo.h"
@@ -82,6 +83,24 @@ SessionInfo makeSessionInfo(
   return env;
 }
 
+/**
+ * Returns nullptr when batching imported objects is disabled.
+ */
+std::shared_ptr<LocalStoreIngester> makeLocalStoreIngester(
+    const BackingStoreFactory::CreateParams& params) {
+  auto config = params.serverState->getEdenConfig();
+  auto batchSize = config->localStoreIngestBatchSize.getValue();
+  if (batchSize == 0) {
+    return nullptr;
+  }
+  return std::make_shared<LocalStoreIngester>(
+      params.localStore,
+      params.sharedStats,
+      batchSize,
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          config->localStoreIngestFlushInterval.getValue()));
+}
+
 constexpr int kExitCodeSuccess = 0;
 constexpr int kExitCodeError = 1;
 constexpr int kExitCodeUsage = 2;
@@ -154,7 +173,8 @@ void EdenMain::registerStandardBackingStores() {
                 params.serverState->getStructuredLogger(),
                 params.serverState->getProcessNameCache())),
         params.localStore,
-        params.sharedStats);
+        params.sharedStats,
+        makeLocalStoreIngester(params));
   });
 
   registerBackingStore(
@@ -163,9 +183,11 @@ void EdenMain::registerStandardBackingStores() {
 #ifdef EDEN_HAVE_GIT
         const auto repoPath = realpath(params.name);
         return std::make_shared<LocalStoreCachedBackingStore>(
-            std::make_shared<GitBackingStore>(repoPath),
+            std::make_shared<GitBackingStore>(
+                repoPath, *params.serverState->getEdenConfig()),
             params.localStore,
-            params.sharedStats);
+            params.sharedStats,
+            makeLocalStoreIngester(params));
 #else // EDEN_HAVE_GIT
         (void)params;
         throw std::domain_error(
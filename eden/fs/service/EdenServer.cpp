@@ -53,13 +53,19 @@
 #include "eden/fs/service/gen-cpp2/eden_types.h"
 #include "eden/fs/store/BackingStoreLogger.h"
 #include "eden/fs/store/BlobCache.h"
+#include "eden/fs/store/CacheMemoryGovernor.h"
+#include "eden/fs/store/CacheWarmer.h"
 #include "eden/fs/store/EmptyBackingStore.h"
+#include "eden/fs/store/InstrumentedLocalStore.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/LocalStoreCachedBackingStore.h"
 #include "eden/fs/store/MemoryLocalStore.h"
 #include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/store/PackLocalStore.h"
 #include "eden/fs/store/RocksDbLocalStore.h"
 #include "eden/fs/store/SqliteLocalStore.h"
+#include "eden/fs/store/TieredLocalStore.h"
+#include "eden/fs/store/PersistentTreeCache.h"
 #include "eden/fs/store/TreeCache.h"
 #include "eden/fs/store/hg/HgBackingStore.h"
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
@@ -83,6 +89,7 @@
 
 #ifndef _WIN32
 #include "eden/fs/fuse/FuseChannel.h"
+#include "eden/fs/inodes/InodeTable.h"
 #include "eden/fs/inodes/Overlay.h"
 #include "eden/fs/notifications/CommandNotifier.h"
 #include "eden/fs/takeover/TakeoverClient.h"
@@ -107,7 +114,7 @@ DEFINE_bool(
     "Enable the fault injection framework.");
 
 #define DEFAULT_STORAGE_ENGINE "rocksdb"
-#define SUPPORTED_STORAGE_ENGINES "rocksdb|sqlite|memory"
+#define SUPPORTED_STORAGE_ENGINES "rocksdb|sqlite|pack|memory|memory-bounded"
 
 DEFINE_string(
     local_storage_engine_unsafe,
@@ -118,6 +125,8 @@ DEFINE_string(
     "). "
     "memory is currently very dangerous as you will "
     "lose state across restarts and graceful restarts! "
+    "memory-bounded is the same, but keeps cached objects under the "
+    "store:*-size-limit budgets, which suits short-lived checkouts. "
     "This flag will only be used on the first invocation");
 
 DEFINE_int64(
@@ -187,11 +196,15 @@ std::shared_ptr<Notifier> getPlatformNotifier(
 
 constexpr StringPiece kRocksDBPath{"storage/rocks-db"};
 constexpr StringPiece kSqlitePath{"storage/sqlite.db"};
+constexpr StringPiece kPackPath{"storage/packs"};
+constexpr StringPiece kPersistentTreeCachePath{"storage/tree-cache"};
 constexpr StringPiece kHgStorePrefix{"store.hg"};
 #ifndef _WIN32
 constexpr StringPiece kFuseRequestPrefix{"fuse"};
 #endif
 constexpr StringPiece kStateConfig{"config.toml"};
+constexpr StringPiece kHotObjectIds{"hot-object-ids"};
+constexpr StringPiece kJournalSegment{"journal"};
 
 std::optional<std::string> getUnixDomainSocketPath(
     const folly::SocketAddress& address) {
@@ -239,6 +252,39 @@ std::string getCounterNameForFuseRequests(
       ".",
       RequestMetricsScope::stringOfRequestMetric(metric));
 }
+
+constexpr std::pair<StringPiece, double> kFuseLatencyPercentiles[] = {
+    {"p50_us", 50},
+    {"p99_us", 99},
+    {"p999_us", 99.9},
+};
+
+std::string getCounterNameForFuseLatency(
+    uint32_t opcode,
+    StringPiece percentile,
+    const EdenMount* mount) {
+  auto opcodeName = fuseOpcodeName(opcode);
+  opcodeName.removePrefix("FUSE_");
+  auto name = opcodeName.str();
+  folly::toLowerAscii(name);
+  // prefix . mount . latency . opcode . percentile
+  return folly::to<std::string>(
+      kFuseRequestPrefix,
+      ".",
+      basename(mount->getPath().view()),
+      ".latency.",
+      name,
+      ".",
+      percentile);
+}
+
+std::string getCounterNameForFuseSlowRequests(const EdenMount* mount) {
+  return folly::to<std::string>(
+      kFuseRequestPrefix,
+      ".",
+      basename(mount->getPath().view()),
+      ".slow_requests");
+}
 #endif
 
 #ifdef __linux__
@@ -272,6 +318,60 @@ size_t getNumberPendingFuseRequests(const EdenMount* mount) {
 }
 #endif // __linux__
 
+/**
+ * When the checkout in `clientDir` was last used, or 0 if unknown. The
+ * persisted journal is written on every change to the working copy, and the
+ * state directory on checkouts.
+ */
+time_t getCheckoutLastUsedTime(AbsolutePathPiece clientDir) {
+  time_t lastUsed = 0;
+  for (auto path :
+       {clientDir.copy(), clientDir + PathComponentPiece{kJournalSegment}}) {
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0) {
+      lastUsed = std::max(lastUsed, st.st_mtime);
+    }
+  }
+  return lastUsed;
+}
+
+std::chrono::milliseconds toMilliseconds(
+    std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(duration);
+}
+
+#ifndef _WIN32
+SerializedHotObjectIds serializeHotObjectIds(const HotObjectIds& ids) {
+  auto toBytes = [](const std::vector<ObjectId>& ids) {
+    std::vector<std::string> bytes;
+    bytes.reserve(ids.size());
+    for (const auto& id : ids) {
+      bytes.push_back(folly::StringPiece{id.getBytes()}.str());
+    }
+    return bytes;
+  };
+  SerializedHotObjectIds serialized;
+  serialized.trees() = toBytes(ids.trees);
+  serialized.blobs() = toBytes(ids.blobs);
+  return serialized;
+}
+
+HotObjectIds deserializeHotObjectIds(const SerializedHotObjectIds& serialized) {
+  auto fromBytes = [](const std::vector<std::string>& bytes) {
+    std::vector<ObjectId> ids;
+    ids.reserve(bytes.size());
+    for (const auto& id : bytes) {
+      ids.emplace_back(folly::ByteRange{folly::StringPiece{id}});
+    }
+    return ids;
+  };
+  HotObjectIds ids;
+  ids.trees = fromBytes(*serialized.trees());
+  ids.blobs = fromBytes(*serialized.blobs());
+  return ids;
+}
+#endif // !_WIN32
+
 } // namespace
 
 namespace facebook::eden {
@@ -331,6 +431,18 @@ class EdenServer::ThriftServerEventHandler
 };
 
 static constexpr folly::StringPiece kBlobCacheMemory{"blob_cache.memory"};
+static constexpr folly::StringPiece kCacheWarmingFetched{
+    "cache_warming.fetched"};
+static constexpr folly::StringPiece kCacheWarmingFailed{
+    "cache_warming.failed"};
+static constexpr folly::StringPiece kCacheWarmingTotal{"cache_warming.total"};
+static constexpr folly::StringPiece kNotificationsShown{"notifications.shown"};
+static constexpr folly::StringPiece kNotificationsSuppressed{
+    "notifications.suppressed"};
+static constexpr folly::StringPiece kThreadPoolQueueDepth{
+    "eden_cpu_thread_pool.queue_depth"};
+static constexpr folly::StringPiece kThreadPoolSteals{
+    "eden_cpu_thread_pool.steals"};
 
 EdenServer::EdenServer(
     std::vector<std::string> originalCommandLine,
@@ -348,7 +460,10 @@ EdenServer::EdenServer(
       backingStoreFactory_{backingStoreFactory},
       blobCache_{BlobCache::create(
           FLAGS_maximumBlobCacheSize,
-          FLAGS_minimumBlobCacheEntryCount)},
+          FLAGS_minimumBlobCacheEntryCount,
+          edenConfig->blobCacheShardCount.getValue(),
+          edenConfig->blobCacheEvictionPolicy.getValue(),
+          edenConfig->blobCacheCompressedTierSize.getValue())},
       config_{std::make_shared<ReloadableConfig>(edenConfig)},
       mountPoints_{std::make_shared<folly::Synchronized<MountMap>>(
           MountMap{kPathMapDefaultCaseSensitive})},
@@ -373,10 +488,36 @@ EdenServer::EdenServer(
       progressManager_{std::make_unique<
           folly::Synchronized<EdenServer::ProgressManager>>()} {
   treeCache_ = TreeCache::create(serverState_->getReloadableConfig());
+  cacheMemoryGovernor_ = std::make_unique<CacheMemoryGovernor>(
+      blobCache_, treeCache_, getSharedStats());
   auto counters = fb303::ServiceData::get()->getDynamicCounters();
   counters->registerCallback(kBlobCacheMemory, [this] {
     return this->getBlobCache()->getStats().totalSizeInBytes;
   });
+  counters->registerCallback(kCacheWarmingFetched, [this] {
+    auto warmer = getCacheWarmer();
+    return warmer ? warmer->getProgress().fetchedCount : 0;
+  });
+  counters->registerCallback(kCacheWarmingFailed, [this] {
+    auto warmer = getCacheWarmer();
+    return warmer ? warmer->getProgress().failedCount : 0;
+  });
+  counters->registerCallback(kCacheWarmingTotal, [this] {
+    auto warmer = getCacheWarmer();
+    return warmer ? warmer->getProgress().totalCount : 0;
+  });
+  counters->registerCallback(kNotificationsShown, [this] {
+    return serverState_->getNotifier()->getCounts().shown;
+  });
+  counters->registerCallback(kNotificationsSuppressed, [this] {
+    return serverState_->getNotifier()->getCounts().suppressed;
+  });
+  counters->registerCallback(kThreadPoolQueueDepth, [this] {
+    return serverState_->getThreadPool()->getPendingTaskCount();
+  });
+  counters->registerCallback(kThreadPoolSteals, [this] {
+    return serverState_->getThreadPool()->getStealCount();
+  });
 
   registerInodePopulationReportsCallback();
 
@@ -414,8 +555,19 @@ EdenServer::EdenServer(
 }
 
 EdenServer::~EdenServer() {
+  if (localStore_) {
+    localStore_->getCompactionScheduler().setLatencyProbe(nullptr);
+  }
+
   auto counters = fb303::ServiceData::get()->getDynamicCounters();
   counters->unregisterCallback(kBlobCacheMemory);
+  counters->unregisterCallback(kCacheWarmingFetched);
+  counters->unregisterCallback(kCacheWarmingFailed);
+  counters->unregisterCallback(kCacheWarmingTotal);
+  counters->unregisterCallback(kNotificationsShown);
+  counters->unregisterCallback(kNotificationsSuppressed);
+  counters->unregisterCallback(kThreadPoolQueueDepth);
+  counters->unregisterCallback(kThreadPoolSteals);
 
   unregisterInodePopulationReportsCallback();
 
@@ -573,6 +725,7 @@ Future<TakeoverData> EdenServer::stopMountsForTakeover(
         info.takeoverPromise.emplace();
         auto future = info.takeoverPromise->getFuture();
 
+        auto channelStopTime = std::chrono::steady_clock::now();
         if (auto* channel = info.edenMount->getFuseChannel()) {
           XLOG(DBG7) << "Calling takeover stop on fuse channel";
           channel->takeoverStop();
@@ -598,9 +751,10 @@ Future<TakeoverData> EdenServer::stopMountsForTakeover(
         }
 
         futures.emplace_back(std::move(future).thenValue(
-            [self = this,
-             edenMount = info.edenMount](TakeoverData::MountInfo takeover)
+            [self = this, edenMount = info.edenMount, channelStopTime](
+                TakeoverData::MountInfo takeover)
                 -> Future<optional<TakeoverData::MountInfo>> {
+              takeover.channelStopTime = channelStopTime;
               auto fuseChannelInfo =
                   std::get_if<FuseChannelData>(&takeover.channelInfo);
               auto nfsChannelInfo =
@@ -704,9 +858,49 @@ void EdenServer::updatePeriodicTaskIntervals(const EdenConfig& config) {
       std::chrono::duration_cast<std::chrono::milliseconds>(
           config.overlayMaintenanceInterval.getValue()));
 
+#ifndef _WIN32
+  overlayWriteFlushTask_.updateInterval(
+      config.overlayWriteBufferSize.getValue() > 0
+          ? std::chrono::duration_cast<std::chrono::milliseconds>(
+                config.overlayWriteBufferMaxDelay.getValue())
+          : std::chrono::milliseconds{0});
+#endif
+
   localStoreTask_.updateInterval(
       std::chrono::duration_cast<std::chrono::milliseconds>(
           config.localStoreManagementInterval.getValue()));
+
+  memoryGovernorTask_.updateInterval(
+      config.enableMemoryGovernor.getValue()
+          ? std::chrono::duration_cast<std::chrono::milliseconds>(
+                config.memoryGovernorInterval.getValue())
+          : std::chrono::milliseconds{0});
+
+  saveHotObjectIdsTask_.updateInterval(
+      config.enableCacheWarming.getValue()
+          ? std::chrono::duration_cast<std::chrono::milliseconds>(
+                config.cacheWarmingSaveInterval.getValue())
+          : std::chrono::milliseconds{0});
+
+#ifndef _WIN32
+  inodeUnloadPolicyTask_.updateInterval(
+      config.enableInodeUnloadPolicy.getValue()
+          ? std::chrono::duration_cast<std::chrono::milliseconds>(
+                config.inodeUnloadPolicyInterval.getValue())
+          : std::chrono::milliseconds{0});
+
+  dematerializeUnchangedFilesTask_.updateInterval(
+      config.enableDematerializeUnchangedFiles.getValue()
+          ? std::chrono::duration_cast<std::chrono::milliseconds>(
+                config.dematerializeUnchangedFilesInterval.getValue())
+          : std::chrono::milliseconds{0});
+#endif
+
+  auto samplingInterval = std::chrono::duration_cast<std::chrono::milliseconds>(
+      config.requestSamplingInterval.getValue());
+  serverState_->getStats().getRequestSampler().setEnabled(
+      samplingInterval.count() > 0);
+  requestSamplingTask_.updateInterval(samplingInterval);
 }
 
 void EdenServer::scheduleCallbackOnMainEventBase(
@@ -874,6 +1068,19 @@ Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
 
   startPeriodicTasks();
 
+  // Everything that doesn't need the lock of the previous process is done
+  // before asking for its mounts, since its filesystem requests wait from
+  // then on until ours are mounted.
+  //
+  // TODO: The "state config" only has one configuration knob now. When
+  // another is required, introduce an EdenStateConfig class to manage
+  // defaults and save on update.
+  auto config = parseConfig();
+  bool shouldSaveConfig = createStorageEngine(*config);
+  if (shouldSaveConfig) {
+    saveConfig(*config);
+  }
+
 #ifndef _WIN32
   // If we are gracefully taking over from an existing edenfs process,
   // receive its lock, thrift socket, and mount points now.
@@ -921,15 +1128,6 @@ Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
   }
 #endif
 
-  // TODO: The "state config" only has one configuration knob now. When
-  // another is required, introduce an EdenStateConfig class to manage
-  // defaults and save on update.
-  auto config = parseConfig();
-  bool shouldSaveConfig = createStorageEngine(*config);
-  if (shouldSaveConfig) {
-    saveConfig(*config);
-  }
-
 #ifndef _WIN32
   // Start listening for graceful takeover requests
   takeoverServer_.reset(new TakeoverServer(
@@ -963,10 +1161,25 @@ Future<Unit> EdenServer::prepareImpl(std::shared_ptr<StartupLogger> logger) {
           mountFutures = prepareMounts(logger);
         }
 
+        // The object ids sent by the previous process are fresher than
+        // the ones it recorded on disk.
+        std::optional<HotObjectIds> takenOverHotObjectIds;
+#ifndef _WIN32
+        if (takeoverData.hotObjectIds.has_value()) {
+          takenOverHotObjectIds =
+              deserializeHotObjectIds(*takeoverData.hotObjectIds);
+        }
+#endif // !_WIN32
+
         // Return a future that will complete only when all mount points have
         // started and the thrift server is also running.
         mountFutures.emplace_back(std::move(thriftRunningFuture));
-        return folly::collectAllUnsafe(std::move(mountFutures)).unit();
+        return folly::collectAllUnsafe(std::move(mountFutures))
+            .thenValue([this,
+                        hotObjectIds = std::move(takenOverHotObjectIds)](
+                           auto&&) mutable {
+              startCacheWarming(std::move(hotObjectIds));
+            });
       });
 }
 
@@ -1013,15 +1226,31 @@ bool EdenServer::createStorageEngine(cpptoml::table& config) {
   if (storageEngine == "memory") {
     XLOG(DBG2) << "Creating new memory store.";
     localStore_ = make_shared<MemoryLocalStore>();
+  } else if (storageEngine == "memory-bounded") {
+    XLOG(DBG2) << "Creating new bounded memory store.";
+    localStore_ =
+        make_shared<MemoryLocalStore>(*serverState_->getEdenConfig());
   } else if (storageEngine == "sqlite") {
     const auto path = edenDir_.getPath() + RelativePathPiece{kSqlitePath};
     const auto parentDir = path.dirname();
     ensureDirectoryExists(parentDir);
     XLOG(DBG2) << "Creating local SQLite store " << path << "...";
     folly::stop_watch<std::chrono::milliseconds> watch;
-    localStore_ = make_shared<SqliteLocalStore>(path);
+    localStore_ = make_shared<SqliteLocalStore>(
+        path,
+        serverState_->getEdenConfig()
+            ->localStoreSqliteReadConnections.getValue());
     XLOG(DBG2) << "Opened SQLite store in " << watch.elapsed().count() / 1000.0
                << " seconds.";
+  } else if (storageEngine == "pack") {
+    const auto packPath = edenDir_.getPath() + RelativePathPiece{kPackPath};
+    XLOG(DBG2) << "Creating local pack store " << packPath << "...";
+    localStore_ = make_shared<PackLocalStore>(
+        packPath,
+        serverState_->getEdenConfig()->localStorePackSize.getValue());
+    localStore_->enableBlobCaching.store(
+        serverState_->getEdenConfig()->enableBlobCaching.getValue(),
+        std::memory_order_relaxed);
   } else if (storageEngine == "rocksdb") {
     XLOG(DBG2) << "Creating local RocksDB store...";
     folly::stop_watch<std::chrono::milliseconds> watch;
@@ -1030,7 +1259,10 @@ bool EdenServer::createStorageEngine(cpptoml::table& config) {
     localStore_ = make_shared<RocksDbLocalStore>(
         rocksPath,
         serverState_->getStructuredLogger(),
-        &serverState_->getFaultInjector());
+        &serverState_->getFaultInjector(),
+        RocksDBOpenMode::ReadWrite,
+        serverState_->getEdenConfig()->localStoreBlockCacheSize.getValue(),
+        getSharedStats());
     localStore_->enableBlobCaching.store(
         serverState_->getEdenConfig()->enableBlobCaching.getValue(),
         std::memory_order_relaxed);
@@ -1041,6 +1273,31 @@ bool EdenServer::createStorageEngine(cpptoml::table& config) {
         folly::to<string>("invalid storage engine: ", storageEngine));
   }
 
+  auto sharedPackPath =
+      serverState_->getEdenConfig()->localStoreSharedPackPath.getValue();
+  if (!sharedPackPath.empty()) {
+    XLOG(INFO) << "Looking objects up in the shared packs at "
+               << sharedPackPath << " first";
+    auto sharedPacks = make_shared<PackLocalStore>(
+        canonicalPath(sharedPackPath),
+        PackLocalStore::kDefaultPackSize,
+        PackLocalStore::OpenMode::ReadOnly);
+    localStore_ = make_shared<TieredLocalStore>(
+        std::move(localStore_), std::move(sharedPacks));
+  }
+
+  // putBlob() checks the flag of the outermost store.
+  localStore_ = make_shared<InstrumentedLocalStore>(
+      std::move(localStore_), getSharedStats());
+  localStore_->enableBlobCaching.store(
+      serverState_->getEdenConfig()->enableBlobCaching.getValue(),
+      std::memory_order_relaxed);
+
+  // Background local store maintenance backs off while filesystem requests
+  // are slow to complete.
+  localStore_->getCompactionScheduler().setLatencyProbe(
+      [this] { return getMaxLiveRequestLatency(); });
+
   return configUpdated;
 }
 
@@ -1048,8 +1305,26 @@ void EdenServer::openStorageEngine(StartupLogger& logger) {
   logger.log("Opening local store...");
   folly::stop_watch<std::chrono::milliseconds> watch;
   localStore_->open();
+  localStoreOpenDuration_ = watch.elapsed();
   logger.log(
-      "Opened local store in ", watch.elapsed().count() / 1000.0, " seconds.");
+      "Opened local store in ",
+      localStoreOpenDuration_.count() / 1000.0,
+      " seconds.");
+
+  auto edenConfig = serverState_->getEdenConfig();
+  if (edenConfig->enablePersistentTreeCache.getValue()) {
+    const auto path =
+        edenDir_.getPath() + RelativePathPiece{kPersistentTreeCachePath};
+    ensureDirectoryExists(path.dirname());
+    try {
+      persistentTreeCache_ = PersistentTreeCache::open(
+          path, edenConfig->persistentTreeCacheSize.getValue());
+    } catch (const std::exception& ex) {
+      // The cache is purely an optimization, run without it.
+      XLOG(ERR) << "Unable to open persistent tree cache " << path << ": "
+                << folly::exceptionStr(ex);
+    }
+  }
 }
 
 std::vector<Future<Unit>> EdenServer::prepareMountsTakeover(
@@ -1118,45 +1393,110 @@ std::vector<Future<Unit>> EdenServer::prepareMounts(
   }
   logger->log("Remounting ", dirs.size(), " mount points...");
 
+  struct PendingMount {
+    std::string mountPath;
+    std::string clientName;
+    time_t lastUsed;
+  };
+  std::vector<PendingMount> pendingMounts;
   for (const auto& client : dirs.items()) {
-    auto mountFuture = makeFutureWith([&] {
-      auto mountPath = canonicalPath(client.first.stringPiece());
-      auto edenClientPath =
-          edenDir_.getCheckoutStateDir(client.second.stringPiece());
-      auto initialConfig =
-          CheckoutConfig::loadFromClientDirectory(mountPath, edenClientPath);
-      auto progressIndex = progressManager_->wlock()->registerEntry(
-          client.first.asString(), initialConfig->getOverlayPath().c_str());
-
-      return mount(
-                 std::move(initialConfig),
-                 false,
-                 [this, logger, progressIndex](auto percent) {
-                   progressManager_->wlock()->manageProgress(
-                       logger, progressIndex, percent);
-                 })
-          .thenTry([this, logger, mountPath, progressIndex](
-                       folly::Try<std::shared_ptr<EdenMount>>&& result) {
-            if (result.hasValue()) {
-              auto wl = progressManager_->wlock();
-              wl->finishProgress(progressIndex);
-              wl->printProgresses(logger);
-              return makeFuture();
-            } else {
-              incrementStartupMountFailures();
-              logger->warn(
-                  "Failed to remount ",
-                  mountPath,
-                  ": ",
-                  result.exception().what());
-              return makeFuture<Unit>(std::move(result).exception());
-            }
-          });
-    });
+    auto clientName = client.second.asString();
+    auto lastUsed =
+        getCheckoutLastUsedTime(edenDir_.getCheckoutStateDir(clientName));
+    pendingMounts.push_back(
+        PendingMount{client.first.asString(), std::move(clientName), lastUsed});
+  }
+  // Remount the checkouts the user is most likely to be waiting on first.
+  std::stable_sort(
+      pendingMounts.begin(),
+      pendingMounts.end(),
+      [](const PendingMount& a, const PendingMount& b) {
+        return a.lastUsed > b.lastUsed;
+      });
 
-    mountFutures.push_back(std::move(mountFuture));
+  auto parallelism =
+      serverState_->getEdenConfig()->startupMountParallelism.getValue();
+  if (parallelism == 0) {
+    parallelism = pendingMounts.size();
   }
-  return mountFutures;
+
+  return folly::window(
+      folly::getKeepAliveToken(getMainEventBase()),
+      std::move(pendingMounts),
+      [this, logger](PendingMount pending) {
+        return makeFutureWith([&] {
+          return prepareMount(logger, pending.mountPath, pending.clientName);
+        });
+      },
+      parallelism);
+}
+
+Future<Unit> EdenServer::prepareMount(
+    std::shared_ptr<StartupLogger> logger,
+    folly::StringPiece mountPathStr,
+    folly::StringPiece clientName) {
+  folly::stop_watch<> mountStopWatch;
+  auto mountPath = canonicalPath(mountPathStr);
+  auto edenClientPath = edenDir_.getCheckoutStateDir(clientName);
+  // The checkout configs are parsed concurrently on the server thread pool
+  // rather than one after the other on the main EventBase.
+  return folly::via(
+             serverState_->getThreadPool().get(),
+             [mountPath, edenClientPath] {
+               return CheckoutConfig::loadFromClientDirectory(
+                   mountPath, edenClientPath);
+             })
+      .via(mainEventBase_)
+      .thenValue([this,
+                  logger,
+                  mountPath,
+                  mountPathStr = mountPathStr.str(),
+                  mountStopWatch](
+                     std::unique_ptr<CheckoutConfig> initialConfig) {
+        auto progressIndex = progressManager_->wlock()->registerEntry(
+            mountPathStr, initialConfig->getOverlayPath().c_str());
+
+        return mount(
+                   std::move(initialConfig),
+                   false,
+                   [this, logger, progressIndex](auto percent) {
+                     progressManager_->wlock()->manageProgress(
+                         logger, progressIndex, percent);
+                   })
+            .thenTry([this, logger, mountPath, progressIndex, mountStopWatch](
+                         folly::Try<std::shared_ptr<EdenMount>>&& result) {
+              if (result.hasValue()) {
+                const auto& timings = result.value()->getInitializeTimings();
+                logger->logVerbose(
+                    "Remounted ",
+                    mountPath,
+                    " in ",
+                    toMilliseconds(mountStopWatch.elapsed()).count(),
+                    "ms: root tree ",
+                    toMilliseconds(timings.rootTree).count(),
+                    "ms, overlay ",
+                    toMilliseconds(timings.overlay).count(),
+                    "ms, inode map ",
+                    toMilliseconds(timings.inodeMap).count(),
+                    "ms, channel ",
+                    toMilliseconds(result.value()->getChannelStartDuration())
+                        .count(),
+                    "ms");
+                auto wl = progressManager_->wlock();
+                wl->finishProgress(progressIndex);
+                wl->printProgresses(logger);
+                return makeFuture();
+              } else {
+                incrementStartupMountFailures();
+                logger->warn(
+                    "Failed to remount ",
+                    mountPath,
+                    ": ",
+                    result.exception().what());
+                return makeFuture<Unit>(std::move(result).exception());
+              }
+            });
+      });
 }
 
 void EdenServer::incrementStartupMountFailures() {
@@ -1204,6 +1544,9 @@ bool EdenServer::performCleanup() {
     XDCHECK_EQ(state->state, RunState::SHUTTING_DOWN);
     state->state = RunState::SHUTTING_DOWN;
   }
+  if (auto warmer = getCacheWarmer()) {
+    warmer->cancel();
+  }
   if (!takeover) {
     shutdownFuture =
         performNormalShutdown().thenValue([](auto&&) { return std::nullopt; });
@@ -1218,6 +1561,9 @@ bool EdenServer::performCleanup() {
     mainEventBase_->loopOnce();
   }
   auto&& shutdownResult = shutdownFuture.result();
+  // Record what is cached now, so that the next process can warm up even if
+  // this one took over from it.
+  saveHotObjectIds();
 #ifndef _WIN32
   shutdownSuccess = !shutdownResult.hasException();
 
@@ -1331,7 +1677,40 @@ void EdenServer::registerStats(std::shared_ptr<EdenMount> edenMount) {
         auto stats = edenMount->getJournal().getStats();
         return stats ? stats->maxFilesAccumulated : 0;
       });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::JOURNAL_BYTES_PER_DELTA),
+      [edenMount] {
+        auto stats = edenMount->getJournal().getStats();
+        return stats ? stats->bytesPerDelta : 0;
+      });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::TAKEOVER_BLACKOUT),
+      [edenMount] { return edenMount->getTakeoverBlackout().count(); });
 #ifndef _WIN32
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::METADATA_TABLE_SIZE),
+      [edenMount] {
+        auto* table = edenMount->getInodeMetadataTable();
+        return table ? table->getStats().fileSizeInBytes : 0;
+      });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::METADATA_TABLE_ENTRIES),
+      [edenMount] {
+        auto* table = edenMount->getInodeMetadataTable();
+        return table ? table->getStats().entryCount : 0;
+      });
+  counters->registerCallback(
+      edenMount->getCounterName(CounterName::METADATA_TABLE_UNUSED_PERCENT),
+      [edenMount] {
+        auto* table = edenMount->getInodeMetadataTable();
+        if (!table) {
+          return size_t{0};
+        }
+        auto stats = table->getStats();
+        return stats.capacity
+            ? 100 * (stats.capacity - stats.entryCount) / stats.capacity
+            : 0;
+      });
   if (auto* channel = edenMount->getFuseChannel()) {
     for (auto metric : RequestMetricsScope::requestMetrics) {
       counters->registerCallback(
@@ -1341,6 +1720,24 @@ void EdenServer::registerStats(std::shared_ptr<EdenMount> edenMount) {
             return channel->getRequestMetric(metric);
           });
     }
+    for (uint32_t opcode = 0; opcode < FuseChannel::kNumLatencyHistograms;
+         ++opcode) {
+      if (!channel->getLatencyHistogram(opcode)) {
+        continue;
+      }
+      for (auto [percentileName, percentile] : kFuseLatencyPercentiles) {
+        counters->registerCallback(
+            getCounterNameForFuseLatency(
+                opcode, percentileName, edenMount.get()),
+            [edenMount, channel, opcode, percentile = percentile] {
+              return channel->getLatencyHistogram(opcode)->getPercentile(
+                  percentile);
+            });
+      }
+    }
+    counters->registerCallback(
+        getCounterNameForFuseSlowRequests(edenMount.get()),
+        [edenMount, channel] { return channel->getSlowRequestCount(); });
   } else if (edenMount->getNfsdChannel()) {
     // TODO(xavierd): Add requestMetrics for NFS.
   }
@@ -1381,12 +1778,34 @@ void EdenServer::unregisterStats(EdenMount* edenMount) {
       edenMount->getCounterName(CounterName::JOURNAL_DURATION));
   counters->unregisterCallback(
       edenMount->getCounterName(CounterName::JOURNAL_MAX_FILES_ACCUMULATED));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::JOURNAL_BYTES_PER_DELTA));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::TAKEOVER_BLACKOUT));
 #ifndef _WIN32
-  if (edenMount->getFuseChannel()) {
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::METADATA_TABLE_SIZE));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::METADATA_TABLE_ENTRIES));
+  counters->unregisterCallback(
+      edenMount->getCounterName(CounterName::METADATA_TABLE_UNUSED_PERCENT));
+  if (auto* channel = edenMount->getFuseChannel()) {
     for (auto metric : RequestMetricsScope::requestMetrics) {
       counters->unregisterCallback(getCounterNameForFuseRequests(
           RequestMetricsScope::RequestStage::LIVE, metric, edenMount));
     }
+    for (uint32_t opcode = 0; opcode < FuseChannel::kNumLatencyHistograms;
+         ++opcode) {
+      if (!channel->getLatencyHistogram(opcode)) {
+        continue;
+      }
+      for (const auto& percentile : kFuseLatencyPercentiles) {
+        counters->unregisterCallback(
+            getCounterNameForFuseLatency(opcode, percentile.first, edenMount));
+      }
+    }
+    counters->unregisterCallback(
+        getCounterNameForFuseSlowRequests(edenMount));
   } else if (edenMount->getNfsdChannel()) {
     // TODO(xavierd): Unregister NFS metrics
   }
@@ -1513,8 +1932,36 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
       serverState_->getProcessNameCache(),
       serverState_->getStructuredLogger(),
       serverState_->getReloadableConfig()->getEdenConfig(),
-      initialConfig->getCaseSensitive());
+      initialConfig->getCaseSensitive(),
+      persistentTreeCache_);
   auto journal = std::make_unique<Journal>(getSharedStats());
+  const auto journalPath =
+      initialConfig->getClientDirectory() + PathComponentPiece{kJournalSegment};
+  auto edenConfig = serverState_->getEdenConfig();
+  bool persistJournal =
+      !folly::kIsWindows && edenConfig->persistJournal.getValue();
+  if (persistJournal) {
+    try {
+      // A checkout interrupted by the restart changed files it didn't record.
+      auto parentCommit = initialConfig->getParentCommit();
+      auto expectedRoot = parentCommit.isCheckoutInProgress()
+          ? std::nullopt
+          : std::make_optional(parentCommit.getWorkingCopyParent());
+      journal->persistTo(
+          journalPath,
+          edenConfig->persistedJournalSize.getValue(),
+          expectedRoot);
+    } catch (const std::exception& ex) {
+      // Persisting the journal is purely an optimization, run without it.
+      XLOG(ERR) << "Unable to persist the journal to " << journalPath << ": "
+                << folly::exceptionStr(ex);
+      persistJournal = false;
+    }
+  }
+  if (!persistJournal) {
+    // The changes made while running without it would be missing from it.
+    unlink(journalPath.c_str());
+  }
 
   // Create the EdenMount object and insert the mount into the mountPoints_ map.
   auto edenMount = EdenMount::create(
@@ -1528,6 +1975,8 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
   registerStats(edenMount);
 
   const bool doTakeover = optionalTakeover.has_value();
+  const auto channelStopTime =
+      doTakeover ? optionalTakeover->channelStopTime : std::nullopt;
 
   auto initFuture = edenMount->initialize(
       std::move(progressCallback),
@@ -1538,6 +1987,7 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
   return std::move(initFuture)
       .thenTry([this,
                 doTakeover,
+                channelStopTime,
                 readOnly,
                 edenMount,
                 mountStopWatch,
@@ -1553,7 +2003,7 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
         return (optionalTakeover ? performTakeoverStart(
                                        edenMount, std::move(*optionalTakeover))
                                  : performFreshStart(edenMount, readOnly))
-            .thenTry([edenMount, doTakeover, this](
+            .thenTry([edenMount, doTakeover, channelStopTime, this](
                          folly::Try<Unit>&& result) mutable {
               // Call mountFinished() if an error occurred during FUSE
               // initialization.
@@ -1563,6 +2013,16 @@ folly::Future<std::shared_ptr<EdenMount>> EdenServer::mount(
                     std::move(result).exception());
               }
 
+              if (channelStopTime) {
+                auto blackout =
+                    std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::steady_clock::now() - *channelStopTime);
+                edenMount->setTakeoverBlackout(blackout);
+                XLOG(INFO) << "Requests to " << edenMount->getPath()
+                           << " waited " << blackout.count()
+                           << "ms during the takeover";
+              }
+
               registerStats(edenMount);
 
               // Now that we've started the workers, arrange to call
@@ -2079,6 +2539,9 @@ folly::Future<TakeoverData> EdenServer::startTakeoverShutdown() {
       .thenValue([this, socket = std::move(thriftSocket)](
                      TakeoverData&& takeover) mutable {
         takeover.lockFile = edenDir_.extractLock();
+        if (auto hotObjectIds = collectHotObjectIds()) {
+          takeover.hotObjectIds = serializeHotObjectIds(*hotObjectIds);
+        }
 
         takeover.thriftSocket = std::move(socket);
         return via(getMainEventBase())
@@ -2126,6 +2589,10 @@ void EdenServer::shutdownSubscribers() {
   }
 }
 
+void EdenServer::sampleRequests() {
+  serverState_->getStats().getRequestSampler().sample();
+}
+
 void EdenServer::flushStatsNow() {
   serverState_->getStats().flush();
 }
@@ -2148,12 +2615,148 @@ void EdenServer::reportMemoryStats() {
   }
 }
 
+std::chrono::microseconds EdenServer::getMaxLiveRequestLatency() const {
+  std::chrono::microseconds latency{0};
+#ifndef _WIN32
+  for (const auto& edenMount : getMountPoints()) {
+    if (auto* channel = edenMount->getFuseChannel()) {
+      latency = std::max(
+          latency,
+          std::chrono::microseconds{
+              static_cast<std::chrono::microseconds::rep>(
+                  channel->getRequestMetric(
+                      RequestMetricsScope::RequestMetric::MAX_DURATION_US))});
+    }
+    // TODO: NFS requests aren't tracked by RequestMetricsScope yet.
+  }
+#endif
+  return latency;
+}
+
 void EdenServer::manageLocalStore() {
   auto config = serverState_->getReloadableConfig()->getEdenConfig(
       ConfigReloadBehavior::NoReload);
   localStore_->periodicManagementTask(*config);
 }
 
+void EdenServer::governCacheMemory() {
+  auto config = serverState_->getReloadableConfig()->getEdenConfig(
+      ConfigReloadBehavior::NoReload);
+  cacheMemoryGovernor_->run(*config);
+}
+
+void EdenServer::runInodeUnloadPolicy() {
+#ifndef _WIN32
+  auto config = serverState_->getReloadableConfig()->getEdenConfig(
+      ConfigReloadBehavior::NoReload);
+  for (const auto& mount : getMountPoints()) {
+    auto stats = mount->runInodeUnloadPolicy(*config);
+    if (stats.unloaded) {
+      XLOG(INFO) << "Inode unload policy unloaded " << stats.unloaded
+                 << " inodes from mount " << mount->getPath() << " in "
+                 << stats.steps << " steps: " << stats.loadedBefore << " -> "
+                 << stats.loadedAfter << " loaded inodes, target "
+                 << stats.target << (stats.rateLimited ? ", rate limited" : "");
+    }
+  }
+#endif
+}
+
+void EdenServer::dematerializeUnchangedFiles() {
+#ifndef _WIN32
+  static auto context = ObjectFetchContext::getNullContextWithCauseDetail(
+      "EdenServer::dematerializeUnchangedFiles");
+  auto config = serverState_->getReloadableConfig()->getEdenConfig(
+      ConfigReloadBehavior::NoReload);
+  for (const auto& mount : getMountPoints()) {
+    // Hashing files can take a while, don't block the main event base.
+    folly::via(
+        serverState_->getThreadPool().get(),
+        [mount, config] {
+          return mount->dematerializeUnchangedFiles(*config, context).semi();
+        })
+        .thenTry([mount](folly::Try<DematerializePassStats>&& stats) {
+          if (stats.hasException()) {
+            XLOG(WARN) << "Error dematerializing unchanged files of mount "
+                       << mount->getPath() << ": " << stats.exception();
+          } else if (stats->checked) {
+            XLOG(INFO) << "Compared " << stats->checked << " files ("
+                       << stats->bytesHashed << " bytes) of mount "
+                       << mount->getPath()
+                       << " with the checked out commit, dematerialized "
+                       << stats->dematerialized
+                       << (stats->rateLimited ? ", rate limited" : "");
+          }
+        });
+  }
+#endif
+}
+
+std::optional<HotObjectIds> EdenServer::collectHotObjectIds() {
+  auto config = serverState_->getReloadableConfig()->getEdenConfig(
+      ConfigReloadBehavior::NoReload);
+  if (!config->enableCacheWarming.getValue()) {
+    return std::nullopt;
+  }
+  if (auto warmer = getCacheWarmer(); warmer && !warmer->getProgress().done) {
+    // The caches only hold part of what is being warmed up, don't overwrite
+    // the full list with it.
+    XLOG(DBG3) << "Not recording cached object ids during cache warm-up";
+    return std::nullopt;
+  }
+  return HotObjectIds::fromCaches(
+      *blobCache_, *treeCache_, config->cacheWarmingMaxObjects.getValue());
+}
+
+void EdenServer::saveHotObjectIds() {
+  auto ids = collectHotObjectIds();
+  if (!ids) {
+    return;
+  }
+
+  auto path = edenDir_.getPath() + PathComponentPiece{kHotObjectIds};
+  try {
+    ids->save(path);
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "Failed to record cached object ids to " << path << ": "
+               << folly::exceptionStr(ex);
+  }
+}
+
+void EdenServer::startCacheWarming(std::optional<HotObjectIds> ids) {
+  auto config = serverState_->getReloadableConfig()->getEdenConfig(
+      ConfigReloadBehavior::NoReload);
+  if (!config->enableCacheWarming.getValue()) {
+    return;
+  }
+
+  // Object ids are only meaningful to the backing store that produced them.
+  // The caches are shared by all the mounts, so warm up through the first
+  // one; ids it doesn't know about are counted as failures.
+  auto mounts = getMountPoints();
+  if (mounts.empty()) {
+    return;
+  }
+  auto objectStore =
+      mounts.front()->getObjectStore()->shared_from_this();
+
+  if (!ids) {
+    auto path = edenDir_.getPath() + PathComponentPiece{kHotObjectIds};
+    try {
+      ids = HotObjectIds::load(path);
+    } catch (const std::exception& ex) {
+      XLOG(DBG2) << "Not warming up caches, unable to read " << path << ": "
+                 << folly::exceptionStr(ex);
+      return;
+    }
+  }
+
+  *cacheWarmer_.wlock() = CacheWarmer::start(
+      std::move(objectStore),
+      std::move(*ids),
+      config->cacheWarmingMaxInFlight.getValue());
+}
+
 void EdenServer::refreshBackingStore() {
   std::vector<shared_ptr<BackingStore>> backingStores;
   {
@@ -2177,6 +2780,18 @@ void EdenServer::manageOverlay() {
   }
 }
 
+void EdenServer::flushOverlayWrites() {
+#ifndef _WIN32
+  auto config = serverState_->getReloadableConfig()->getEdenConfig(
+      ConfigReloadBehavior::NoReload);
+  auto maxDelay = config->overlayWriteBufferMaxDelay.getValue();
+  const auto mountPoints = mountPoints_->rlock();
+  for (const auto& [_, info] : *mountPoints) {
+    info.edenMount->getOverlayFileAccess()->flushBufferedWrites(maxDelay);
+  }
+#endif
+}
+
 void EdenServer::reloadConfig() {
   // Get the config, forcing a reload now.
   auto config = serverState_->getReloadableConfig()->getEdenConfig(
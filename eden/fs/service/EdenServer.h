@@ -64,6 +64,10 @@ class BackingStore;
 class HgQueuedBackingStore;
 class IHiveLogger;
 class BlobCache;
+class CacheMemoryGovernor;
+class CacheWarmer;
+struct HotObjectIds;
+class PersistentTreeCache;
 class TreeCache;
 class Dirstate;
 class EdenServiceHandler;
@@ -318,6 +322,14 @@ class EdenServer : private TakeoverHandler {
     return localStore_;
   }
 
+  /**
+   * How long opening the LocalStore took during prepare(). Only meaningful
+   * once the mounts started being remounted.
+   */
+  std::chrono::milliseconds getLocalStoreOpenDuration() const {
+    return localStoreOpenDuration_;
+  }
+
   const std::shared_ptr<BlobCache>& getBlobCache() const {
     return blobCache_;
   }
@@ -326,6 +338,21 @@ class EdenServer : private TakeoverHandler {
     return treeCache_;
   }
 
+  /**
+   * Returns the cache warm-up started at startup, or nullptr if there was
+   * none.
+   */
+  std::shared_ptr<CacheWarmer> getCacheWarmer() const {
+    return *cacheWarmer_.rlock();
+  }
+
+  /**
+   * Returns the on-disk tree cache, or nullptr if it is disabled.
+   */
+  const std::shared_ptr<PersistentTreeCache>& getPersistentTreeCache() const {
+    return persistentTreeCache_;
+  }
+
   /**
    * Look up the BackingStore object for the specified repository type+name.
    *
@@ -523,6 +550,11 @@ class EdenServer : private TakeoverHandler {
       std::vector<TakeoverData::MountInfo>&& takeoverMounts);
   FOLLY_NODISCARD std::vector<folly::Future<folly::Unit>> prepareMounts(
       std::shared_ptr<StartupLogger> logger);
+  // Remount one of the checkouts listed in the config.json file.
+  FOLLY_NODISCARD folly::Future<folly::Unit> prepareMount(
+      std::shared_ptr<StartupLogger> logger,
+      folly::StringPiece mountPath,
+      folly::StringPiece clientName);
   static void incrementStartupMountFailures();
 
 #ifndef _WIN32
@@ -603,6 +635,37 @@ class EdenServer : private TakeoverHandler {
   // necessary
   void manageLocalStore();
 
+  // How long the oldest outstanding filesystem request across all mounts has
+  // been running for.
+  std::chrono::microseconds getMaxLiveRequestLatency() const;
+
+  // Resize the blob and tree caches based on memory pressure.
+  void governCacheMemory();
+
+  // Unload the least recently accessed inodes of the mounts over their
+  // target count or memory budget.
+  void runInodeUnloadPolicy();
+
+  // Dematerialize the idle materialized files of the mounts whose contents
+  // match their checked out commit.
+  void dematerializeUnchangedFiles();
+
+  // Take one sample of the requests in flight, while request sampling is
+  // enabled.
+  void sampleRequests();
+
+  // Collect the ids of the objects in the blob and tree caches, unless cache
+  // warming is disabled or still in progress.
+  std::optional<HotObjectIds> collectHotObjectIds();
+
+  // Record the ids of the objects in the blob and tree caches so that the
+  // next EdenFS process can warm its caches up with them.
+  void saveHotObjectIds();
+
+  // Start prefetching the objects sent by the EdenFS process we took over
+  // from, or else the ones recorded by a previous EdenFS process.
+  void startCacheWarming(std::optional<HotObjectIds> ids);
+
   // some backing store may require periodic maintenance, specifically rust
   // datapack store needs to release file descriptor it holds every once in a
   // while.
@@ -611,6 +674,9 @@ class EdenServer : private TakeoverHandler {
   // Tree overlay needs periodically run checkpoint to flush its journal file.
   void manageOverlay();
 
+  // Write back the buffered overlay file writes older than their max delay.
+  void flushOverlayWrites();
+
   // Cancel all subscribers on all mounts so that we can tear
   // down the thrift server without blocking
   void shutdownSubscribers();
@@ -643,9 +709,13 @@ class EdenServer : private TakeoverHandler {
   BackingStoreFactory* const backingStoreFactory_;
 
   std::shared_ptr<LocalStore> localStore_;
+  std::chrono::milliseconds localStoreOpenDuration_{0};
   folly::Synchronized<BackingStoreMap> backingStores_;
   const std::shared_ptr<BlobCache> blobCache_;
   std::shared_ptr<TreeCache> treeCache_;
+  std::unique_ptr<CacheMemoryGovernor> cacheMemoryGovernor_;
+  folly::Synchronized<std::shared_ptr<CacheWarmer>> cacheWarmer_;
+  std::shared_ptr<PersistentTreeCache> persistentTreeCache_;
   std::shared_ptr<ReloadableConfig> config_;
 
   std::shared_ptr<folly::Synchronized<MountMap>> mountPoints_;
@@ -775,5 +845,22 @@ class EdenServer : private TakeoverHandler {
       this,
       "backing_store"};
   PeriodicFnTask<&EdenServer::manageOverlay> overlayTask_{this, "overlay"};
+  PeriodicFnTask<&EdenServer::flushOverlayWrites> overlayWriteFlushTask_{
+      this,
+      "overlay_write_flush"};
+  PeriodicFnTask<&EdenServer::governCacheMemory> memoryGovernorTask_{
+      this,
+      "memory_governor"};
+  PeriodicFnTask<&EdenServer::saveHotObjectIds> saveHotObjectIdsTask_{
+      this,
+      "save_hot_object_ids"};
+  PeriodicFnTask<&EdenServer::runInodeUnloadPolicy> inodeUnloadPolicyTask_{
+      this,
+      "inode_unload_policy"};
+  PeriodicFnTask<&EdenServer::dematerializeUnchangedFiles>
+      dematerializeUnchangedFilesTask_{this, "dematerialize_unchanged_files"};
+  PeriodicFnTask<&EdenServer::sampleRequests> requestSamplingTask_{
+      this,
+      "request_sampling"};
 };
 } // namespace facebook::eden
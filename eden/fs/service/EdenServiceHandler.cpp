@@ -26,6 +26,7 @@
 #include <folly/logging/xlog.h>
 #include <folly/stop_watch.h>
 #include <folly/system/Shell.h>
+#include <thrift/lib/cpp/transport/THeader.h>
 #include <thrift/lib/cpp/util/EnumUtils.h>
 
 #include "eden/common/utils/ProcessNameCache.h"
@@ -41,6 +42,7 @@
 #include "eden/fs/inodes/Traverse.h"
 #include "eden/fs/inodes/TreeInode.h"
 #include "eden/fs/inodes/VirtualInodeLoader.h"
+#include "eden/fs/journal/CoalescingSubscriber.h"
 #include "eden/fs/journal/Journal.h"
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/model/BlobMetadata.h"
@@ -58,13 +60,17 @@
 #include "eden/fs/service/gen-cpp2/eden_types.h"
 #include "eden/fs/service/gen-cpp2/streamingeden_constants.h"
 #include "eden/fs/store/BackingStore.h"
+#include "eden/fs/store/BlobCache.h"
 #include "eden/fs/store/Diff.h"
+#include "eden/fs/store/FetchCostAccumulator.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/LocalStoreCachedBackingStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/ObjectStore.h"
 #include "eden/fs/store/PathLoader.h"
+#include "eden/fs/store/PrefetchProfile.h"
 #include "eden/fs/store/ScmStatusDiffCallback.h"
+#include "eden/fs/store/TreeCache.h"
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
 #include "eden/fs/telemetry/SessionInfo.h"
 #include "eden/fs/telemetry/Tracing.h"
@@ -72,11 +78,13 @@
 #include "eden/fs/utils/Clock.h"
 #include "eden/fs/utils/EdenError.h"
 #include "eden/fs/utils/FaultInjector.h"
+#include "eden/fs/utils/FileUtils.h"
 #include "eden/fs/utils/NotImplemented.h"
 #include "eden/fs/utils/ProcUtil.h"
 #include "eden/fs/utils/SourceLocation.h"
 #include "eden/fs/utils/StatTimes.h"
 #include "eden/fs/utils/String.h"
+#include "eden/fs/utils/SystemError.h"
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
 
 #ifdef EDEN_HAVE_USAGE_SERVICE
@@ -129,17 +137,75 @@ namespace /* anonymous namespace for helper functions */ {
 
 #define EDEN_MICRO reinterpret_cast<const char*>(u8"\u00B5s")
 
+/**
+ * Publishes the time a Thrift request spends in the subsystems it goes
+ * through as SPAN events on the Thrift request trace bus, so that a slow
+ * request can be broken down by `eden trace thrift`.
+ */
+class ThriftRequestSpans {
+ public:
+  ThriftRequestSpans(
+      std::shared_ptr<TraceBus<ThriftRequestTraceEvent>> traceBus,
+      uint64_t requestId,
+      folly::StringPiece method,
+      std::optional<pid_t> pid)
+      : traceBus_{std::move(traceBus)},
+        requestId_{requestId},
+        method_{method},
+        pid_{pid} {}
+
+  void publish(
+      ThriftRequestTraceEvent::SpanKind kind,
+      std::chrono::nanoseconds duration) const {
+    traceBus_->publish(ThriftRequestTraceEvent::span(
+        requestId_, method_, pid_, kind, duration));
+  }
+
+  /**
+   * Memory cache hits are too cheap and too numerous to be worth a span.
+   */
+  void publishFetch(
+      ObjectFetchContext::Origin origin,
+      std::chrono::nanoseconds duration) const {
+    switch (origin) {
+      case ObjectFetchContext::FromDiskCache:
+        publish(ThriftRequestTraceEvent::DISK_CACHE_FETCH, duration);
+        break;
+      case ObjectFetchContext::FromNetworkFetch:
+        publish(ThriftRequestTraceEvent::NETWORK_FETCH, duration);
+        break;
+      default:
+        break;
+    }
+  }
+
+ private:
+  std::shared_ptr<TraceBus<ThriftRequestTraceEvent>> traceBus_;
+  uint64_t requestId_;
+  folly::StringPiece method_;
+  std::optional<pid_t> pid_;
+};
+
 class ThriftFetchContext : public ObjectFetchContext {
  public:
-  explicit ThriftFetchContext(
+  ThriftFetchContext(
       std::optional<pid_t> pid,
-      folly::StringPiece endpoint)
-      : pid_(pid), endpoint_(endpoint) {}
+      folly::StringPiece endpoint,
+      folly::CancellationToken cancellation,
+      ThriftRequestSpans spans)
+      : pid_(pid),
+        endpoint_(endpoint),
+        cancellation_(std::move(cancellation)),
+        spans_(std::move(spans)) {}
 
   std::optional<pid_t> getClientPid() const override {
     return pid_;
   }
 
+  folly::CancellationToken getCancellationToken() const override {
+    return cancellation_;
+  }
+
   Cause getCause() const override {
     return ObjectFetchContext::Cause::Thrift;
   }
@@ -163,23 +229,55 @@ class ThriftFetchContext : public ObjectFetchContext {
     requestInfo_.insert(another.begin(), another.end());
   }
 
+  void didSpendFetching(
+      Origin origin,
+      std::chrono::nanoseconds duration,
+      uint64_t bytes) override {
+    fetchCost_.add(origin, duration, bytes);
+    spans_.publishFetch(origin, duration);
+  }
+
+  void didWaitForBackingStore(std::chrono::nanoseconds duration) override {
+    spans_.publish(ThriftRequestTraceEvent::BACKING_STORE_REQUEST, duration);
+  }
+
+  void didLoadInode(std::chrono::nanoseconds duration) override {
+    spans_.publish(ThriftRequestTraceEvent::INODE_LOAD, duration);
+  }
+
+  FetchCost getFetchCost() const {
+    return fetchCost_.getFetchCost();
+  }
+
  private:
   std::optional<pid_t> pid_;
   std::string_view endpoint_;
+  folly::CancellationToken cancellation_;
   std::unordered_map<std::string, std::string> requestInfo_;
+  FetchCostAccumulator fetchCost_;
+  ThriftRequestSpans spans_;
 };
 
 class PrefetchFetchContext : public ObjectFetchContext {
  public:
-  explicit PrefetchFetchContext(
+  PrefetchFetchContext(
       std::optional<pid_t> pid,
-      std::string_view endpoint)
-      : pid_(pid), endpoint_(endpoint) {}
+      std::string_view endpoint,
+      folly::CancellationToken cancellation,
+      ThriftRequestSpans spans)
+      : pid_(pid),
+        endpoint_(endpoint),
+        cancellation_(std::move(cancellation)),
+        spans_(std::move(spans)) {}
 
   std::optional<pid_t> getClientPid() const override {
     return pid_;
   }
 
+  folly::CancellationToken getCancellationToken() const override {
+    return cancellation_;
+  }
+
   Cause getCause() const override {
     return ObjectFetchContext::Cause::Prefetch;
   }
@@ -197,18 +295,42 @@ class PrefetchFetchContext : public ObjectFetchContext {
     return nullptr;
   }
 
+  void didSpendFetching(
+      Origin origin,
+      std::chrono::nanoseconds duration,
+      uint64_t /*bytes*/) override {
+    spans_.publishFetch(origin, duration);
+  }
+
+  void didWaitForBackingStore(std::chrono::nanoseconds duration) override {
+    spans_.publish(ThriftRequestTraceEvent::BACKING_STORE_REQUEST, duration);
+  }
+
+  void didLoadInode(std::chrono::nanoseconds duration) override {
+    spans_.publish(ThriftRequestTraceEvent::INODE_LOAD, duration);
+  }
+
  private:
   std::optional<pid_t> pid_;
   std::string_view endpoint_;
+  folly::CancellationToken cancellation_;
+  ThriftRequestSpans spans_;
 };
 
 constexpr size_t kTraceBusCapacity = 25000;
 
+/**
+ * Clients that send this Thrift header, with any value, get the FetchCost of
+ * their request back in the response header of the same name. This helps
+ * attribute slow requests to cache misses.
+ */
+const std::string kFetchCostHeader = "eden-fetch-cost";
+
 /**
  * Lives as long as a Thrift request and primarily exists to record logging and
  * telemetry.
  */
-class ThriftRequestScope {
+class ThriftRequestScope : private RequestSampler::SampledRequest {
  public:
   ThriftRequestScope(ThriftRequestScope&&) = delete;
   ThriftRequestScope& operator=(ThriftRequestScope&&) = delete;
@@ -222,6 +344,8 @@ class ThriftRequestScope {
       std::shared_ptr<EdenStats> edenStats,
       ThriftStats::DurationPtr statPtr,
       std::optional<pid_t> pid,
+      folly::CancellationToken cancellation,
+      apache::thrift::Cpp2RequestContext* requestContext,
       JoinFn&& join)
       : traceBus_{std::move(traceBus)},
         requestId_(generateUniqueID()),
@@ -232,10 +356,16 @@ class ThriftRequestScope {
         itcLogger_(logger),
         thriftFetchContext_{makeRefPtr<ThriftFetchContext>(
             pid,
-            sourceLocation_.function_name())},
+            sourceLocation_.function_name(),
+            cancellation,
+            ThriftRequestSpans{
+                traceBus_, requestId_, sourceLocation_.function_name(), pid})},
         prefetchFetchContext_{makeRefPtr<PrefetchFetchContext>(
             pid,
-            sourceLocation_.function_name())} {
+            sourceLocation_.function_name(),
+            std::move(cancellation),
+            ThriftRequestSpans{
+                traceBus_, requestId_, sourceLocation_.function_name(), pid})} {
     FB_LOG_RAW(
         itcLogger_,
         level,
@@ -247,9 +377,20 @@ class ThriftRequestScope {
 
     traceBus_->publish(ThriftRequestTraceEvent::start(
         requestId_, sourceLocation_.function_name(), pid));
+
+    if (edenStats_) {
+      samplerScope_ = edenStats_->getRequestSampler().track(*this);
+    }
+
+    if (auto* header = requestContext ? requestContext->getHeader() : nullptr;
+        header && header->getHeaders().count(kFetchCostHeader)) {
+      fetchCostHeader_ = header;
+    }
   }
 
-  ~ThriftRequestScope() {
+  ~ThriftRequestScope() override {
+    samplerScope_.reset();
+
     // Logging completion time for the request
     // The line number points to where the object was originally created
     auto elapsed = itcTimer_.elapsed();
@@ -278,6 +419,11 @@ class ThriftRequestScope {
         requestId_,
         sourceLocation_.function_name(),
         thriftFetchContext_->getClientPid()));
+    // The scope is destroyed before the response is sent.
+    if (fetchCostHeader_) {
+      fetchCostHeader_->setHeader(
+          kFetchCostHeader, thriftFetchContext_->getFetchCost().toString());
+    }
   }
 
   const ObjectFetchContextPtr& getPrefetchFetchContext() {
@@ -297,6 +443,11 @@ class ThriftRequestScope {
   }
 
  private:
+  void appendFrames(std::string& stack) const override {
+    appendFrame(stack, "thrift");
+    appendFrame(stack, sourceLocation_.function_name());
+  }
+
   std::shared_ptr<TraceBus<ThriftRequestTraceEvent>> traceBus_;
   uint64_t requestId_;
   SourceLocation sourceLocation_;
@@ -307,6 +458,9 @@ class ThriftRequestScope {
   folly::stop_watch<std::chrono::microseconds> itcTimer_ = {};
   RefPtr<ThriftFetchContext> thriftFetchContext_;
   RefPtr<PrefetchFetchContext> prefetchFetchContext_;
+  RequestSampler::Scope samplerScope_;
+  // Set when the client asked for the FetchCost of its request.
+  apache::thrift::transport::THeader* fetchCostHeader_ = nullptr;
 };
 
 template <typename ReturnType>
@@ -323,6 +477,30 @@ ImmediateFuture<ReturnType> wrapImmediateFuture(
   return std::move(f).ensure([logHelper = std::move(logHelper)]() {});
 }
 
+/**
+ * Completes the callback of a method running on the Thrift IO thread
+ * (`thread = 'eb'`). A ready future is answered right away, without hopping
+ * to another thread and back. Otherwise the rest of the request runs on
+ * `executor`, so that the IO thread never waits.
+ */
+template <typename ReturnType>
+void completeOnEventBase(
+    typename apache::thrift::HandlerCallback<ReturnType>::Ptr callback,
+    ImmediateFuture<ReturnType>&& f,
+    folly::Executor* executor) {
+  if (f.isReady()) {
+    callback->complete(std::move(f).getTry());
+    return;
+  }
+  folly::futures::detachOn(
+      folly::getKeepAliveToken(executor),
+      std::move(f).semi().deferTry(
+          [callback = std::move(callback)](
+              folly::Try<ReturnType>&& result) mutable {
+            callback->complete(std::move(result));
+          }));
+}
+
 #undef EDEN_MICRO
 
 RelativePath relpathFromUserPath(StringPiece userPath) {
@@ -382,6 +560,8 @@ std::string absolutePathToThrift(AbsolutePathPiece path) {
         nullptr,                                              \
         nullptr,                                              \
         getAndRegisterClientPid(),                            \
+        getRequestCancellationToken(),                        \
+        getRequestContext(),                                  \
         [&] {                                                 \
           return fmt::to_string(                              \
               fmt::join(std::make_tuple(__VA_ARGS__), ", ")); \
@@ -400,6 +580,8 @@ std::string absolutePathToThrift(AbsolutePathPiece path) {
         server_->getSharedStats(),                            \
         stat,                                                 \
         getAndRegisterClientPid(),                            \
+        getRequestCancellationToken(),                        \
+        getRequestContext(),                                  \
         [&] {                                                 \
           return fmt::to_string(                              \
               fmt::join(std::make_tuple(__VA_ARGS__), ", ")); \
@@ -422,6 +604,53 @@ ThriftRequestTraceEvent ThriftRequestTraceEvent::finish(
       ThriftRequestTraceEvent::FINISH, requestId, method, clientPid};
 }
 
+ThriftRequestTraceEvent ThriftRequestTraceEvent::span(
+    uint64_t requestId,
+    folly::StringPiece method,
+    std::optional<pid_t> clientPid,
+    SpanKind spanKind,
+    std::chrono::nanoseconds spanDuration) {
+  return ThriftRequestTraceEvent{
+      ThriftRequestTraceEvent::SPAN,
+      requestId,
+      method,
+      clientPid,
+      spanKind,
+      spanDuration};
+}
+
+void ActivityBufferCodec<ThriftRequestTraceEvent>::encode(
+    const ThriftRequestTraceEvent& event,
+    std::string& out) {
+  ActivityBufferEncoding::append(out, event.systemTime);
+  ActivityBufferEncoding::append(out, event.monotonicTime);
+  ActivityBufferEncoding::append(out, event.type);
+  ActivityBufferEncoding::append(out, event.requestId);
+  ActivityBufferEncoding::append(out, event.method);
+  if (event.clientPid) {
+    ActivityBufferEncoding::append(out, *event.clientPid);
+  }
+}
+
+ThriftRequestTraceEvent ActivityBufferCodec<ThriftRequestTraceEvent>::decode(
+    folly::ByteRange in) {
+  auto systemTime =
+      ActivityBufferEncoding::read<std::chrono::system_clock::time_point>(in);
+  auto monotonicTime =
+      ActivityBufferEncoding::read<std::chrono::steady_clock::time_point>(in);
+  auto type = ActivityBufferEncoding::read<ThriftRequestTraceEvent::Type>(in);
+  auto requestId = ActivityBufferEncoding::read<uint64_t>(in);
+  auto method = ActivityBufferEncoding::read<folly::StringPiece>(in);
+  std::optional<pid_t> clientPid;
+  if (!in.empty()) {
+    clientPid = ActivityBufferEncoding::read<pid_t>(in);
+  }
+  ThriftRequestTraceEvent event{type, requestId, method, clientPid};
+  event.systemTime = systemTime;
+  event.monotonicTime = monotonicTime;
+  return event;
+}
+
 template <>
 struct fmt::formatter<facebook::eden::MountId> : public formatter<std::string> {
   template <typename Context>
@@ -436,13 +665,11 @@ const char* const kServiceName = "EdenFS";
 
 std::optional<ActivityBuffer<ThriftRequestTraceEvent>>
 EdenServiceHandler::initThriftRequestActivityBuffer() {
-  if (server_->getServerState()
-          ->getEdenConfig()
-          ->enableActivityBuffer.getValue()) {
+  auto config = server_->getServerState()->getEdenConfig();
+  if (config->enableActivityBuffer.getValue()) {
     return std::make_optional<ActivityBuffer<ThriftRequestTraceEvent>>(
-        server_->getServerState()
-            ->getEdenConfig()
-            ->ActivityBufferMaxEvents.getValue());
+        config->ActivityBufferMaxEvents.getValue(),
+        config->ActivityBufferMaxBytes.getValue());
   }
   return std::nullopt;
 }
@@ -456,7 +683,22 @@ EdenServiceHandler::EdenServiceHandler(
       thriftRequestActivityBuffer_(initThriftRequestActivityBuffer()),
       thriftRequestTraceBus_(TraceBus<ThriftRequestTraceEvent>::create(
           "ThriftRequestTrace",
-          kTraceBusCapacity)) {
+          kTraceBusCapacity)),
+      globLimiter_{
+          "glob",
+          server->getSharedStats(),
+          &ThriftStats::globQueueTime,
+          &ThriftStats::globRejected},
+      statusLimiter_{
+          "status",
+          server->getSharedStats(),
+          &ThriftStats::statusQueueTime,
+          &ThriftStats::statusRejected},
+      checkoutLimiter_{
+          "checkout",
+          server->getSharedStats(),
+          &ThriftStats::checkoutQueueTime,
+          &ThriftStats::checkoutRejected} {
   struct HistConfig {
     int64_t bucketSize{250};
     int64_t min{0};
@@ -512,6 +754,10 @@ EdenServiceHandler::EdenServiceHandler(
               case ThriftRequestTraceEvent::FINISH:
                 outstandingThriftRequests_.wlock()->erase(event.requestId);
                 break;
+              case ThriftRequestTraceEvent::SPAN:
+                // Spans are only streamed live by traceThriftRequestEvents,
+                // they would crowd the requests out of the activity buffer.
+                return;
             }
             if (thriftRequestActivityBuffer_.has_value()) {
               thriftRequestActivityBuffer_->addEvent(event);
@@ -599,16 +845,29 @@ EdenServiceHandler::semifuture_checkOutRevision(
           : "(unspecified hg root manifest)");
 
   auto mountPath = absolutePathFromThrift(*mountPoint);
-  auto checkoutFuture =
-      ImmediateFuture{server_
-                          ->checkOutRevision(
-                              mountPath,
-                              *hash,
-                              params->hgRootManifest_ref().to_optional(),
-                              helper->getFetchContext()->getClientPid(),
-                              helper->getFunctionName(),
-                              checkoutMode)
-                          .semi()};
+  auto config = server_->getServerState()->getEdenConfig();
+  auto checkoutFuture = checkoutLimiter_.run(
+      config->thriftMaxConcurrentCheckouts.getValue(),
+      config->thriftMaxQueuedRequests.getValue(),
+      ThriftRequestLimiter::Priority::High,
+      [this,
+       mountPath = std::move(mountPath),
+       hash = std::move(hash),
+       params = std::move(params),
+       clientPid = helper->getFetchContext()->getClientPid(),
+       functionName = helper->getFunctionName(),
+       checkoutMode] {
+        return ImmediateFuture{
+            server_
+                ->checkOutRevision(
+                    mountPath,
+                    *hash,
+                    params->hgRootManifest_ref().to_optional(),
+                    clientPid,
+                    functionName,
+                    checkoutMode)
+                .semi()};
+      });
 
   return wrapImmediateFuture(
              std::move(helper),
@@ -697,8 +956,9 @@ EdenServiceHandler::semifuture_synchronizeWorkingCopy(
       .semi();
 }
 
-folly::SemiFuture<std::unique_ptr<std::vector<SHA1Result>>>
-EdenServiceHandler::semifuture_getSHA1(
+void EdenServiceHandler::async_eb_getSHA1(
+    apache::thrift::HandlerCallback<
+        std::unique_ptr<std::vector<SHA1Result>>>::Ptr callback,
     std::unique_ptr<string> mountPoint,
     std::unique_ptr<vector<string>> paths,
     std::unique_ptr<SyncBehavior> sync) {
@@ -706,46 +966,47 @@ EdenServiceHandler::semifuture_getSHA1(
   auto helper = INSTRUMENT_THRIFT_CALL(
       DBG3, *mountPoint, getSyncTimeout(*sync), toLogArg(*paths));
   auto& fetchContext = helper->getFetchContext();
-  auto mountPath = absolutePathFromThrift(*mountPoint);
-  auto mount = server_->getMount(mountPath);
+  auto future = makeImmediateFutureWith([&] {
+    auto mountPath = absolutePathFromThrift(*mountPoint);
+    auto mount = server_->getMount(mountPath);
 
-  auto notificationFuture = waitForPendingNotifications(*mount, *sync);
-  return wrapImmediateFuture(
-             std::move(helper),
-             std::move(notificationFuture)
-                 .thenValue([this,
-                             mount = std::move(mount),
-                             paths = std::move(paths),
-                             fetchContext =
-                                 fetchContext.copy()](auto&&) mutable {
-                   std::vector<ImmediateFuture<Hash20>> futures;
-                   futures.reserve(paths->size());
-                   for (auto& path : *paths) {
-                     futures.push_back(makeImmediateFutureWith([&]() mutable {
-                       return getSHA1ForPath(
-                           *mount, RelativePath{std::move(path)}, fetchContext);
-                     }));
-                   }
+    return waitForPendingNotifications(*mount, *sync)
+        .thenValue([this,
+                    mount = std::move(mount),
+                    paths = std::move(paths),
+                    fetchContext =
+                        fetchContext.copy()](auto&&) mutable {
+          std::vector<ImmediateFuture<Hash20>> futures;
+          futures.reserve(paths->size());
+          for (auto& path : *paths) {
+            futures.push_back(makeImmediateFutureWith([&]() mutable {
+              return getSHA1ForPath(
+                  *mount, RelativePath{std::move(path)}, fetchContext);
+            }));
+          }
 
-                   return collectAll(std::move(futures))
-                       .ensure([mount = std::move(mount)] {});
-                 })
-                 .thenValue([](std::vector<folly::Try<Hash20>> results) {
-                   auto out = std::make_unique<std::vector<SHA1Result>>();
-                   out->reserve(results.size());
-
-                   for (auto& result : results) {
-                     auto& sha1Result = out->emplace_back();
-                     if (result.hasValue()) {
-                       sha1Result.sha1_ref() = thriftHash20(result.value());
-                     } else {
-                       sha1Result.error_ref() =
-                           newEdenError(result.exception());
-                     }
-                   }
-                   return out;
-                 }))
-      .semi();
+          return collectAll(std::move(futures))
+              .ensure([mount = std::move(mount)] {});
+        })
+        .thenValue([](std::vector<folly::Try<Hash20>> results) {
+          auto out = std::make_unique<std::vector<SHA1Result>>();
+          out->reserve(results.size());
+
+          for (auto& result : results) {
+            auto& sha1Result = out->emplace_back();
+            if (result.hasValue()) {
+              sha1Result.sha1_ref() = thriftHash20(result.value());
+            } else {
+              sha1Result.error_ref() = newEdenError(result.exception());
+            }
+          }
+          return out;
+        });
+  });
+  completeOnEventBase(
+      std::move(callback),
+      wrapImmediateFuture(std::move(helper), std::move(future)),
+      server_->getServerState()->getThreadPool().get());
 }
 
 ImmediateFuture<Hash20> EdenServiceHandler::getSHA1ForPath(
@@ -768,38 +1029,6 @@ ImmediateFuture<Hash20> EdenServiceHandler::getSHA1ForPath(
       });
 }
 
-ImmediateFuture<EntryAttributes> EdenServiceHandler::getEntryAttributesForPath(
-    EntryAttributeFlags reqBitmask,
-    AbsolutePathPiece mountPoint,
-    StringPiece path,
-    const ObjectFetchContextPtr& fetchContext) {
-  if (path.empty()) {
-    return ImmediateFuture<EntryAttributes>(newEdenError(
-        EINVAL,
-        EdenErrorType::ARGUMENT_ERROR,
-        "path cannot be the empty string"));
-  }
-
-  try {
-    auto edenMount = server_->getMount(mountPoint);
-    auto objectStore = edenMount->getObjectStore();
-    auto relativePath = RelativePathPiece{path};
-
-    return edenMount->getVirtualInode(relativePath, fetchContext)
-        .thenValue([reqBitmask,
-                    relativePath,
-                    objectStore,
-                    fetchContext =
-                        fetchContext.copy()](const VirtualInode& virtualInode) {
-          return virtualInode.getEntryAttributes(
-              reqBitmask, relativePath, objectStore, fetchContext);
-        });
-  } catch (const std::exception& e) {
-    return ImmediateFuture<EntryAttributes>(
-        newEdenError(EINVAL, EdenErrorType::ARGUMENT_ERROR, e.what()));
-  }
-}
-
 void EdenServiceHandler::addBindMount(
     FOLLY_MAYBE_UNUSED std::unique_ptr<std::string> mountPoint,
     FOLLY_MAYBE_UNUSED std::unique_ptr<std::string> repoPath,
@@ -834,24 +1063,34 @@ void EdenServiceHandler::removeBindMount(
 #endif
 }
 
-void EdenServiceHandler::getCurrentJournalPosition(
-    JournalPosition& out,
+void EdenServiceHandler::async_eb_getCurrentJournalPosition(
+    apache::thrift::HandlerCallback<std::unique_ptr<JournalPosition>>::Ptr
+        callback,
     std::unique_ptr<std::string> mountPoint) {
   auto helper = INSTRUMENT_THRIFT_CALL(DBG3, *mountPoint);
-  auto mountPath = absolutePathFromThrift(*mountPoint);
-  auto edenMount = server_->getMount(mountPath);
-  auto latest = edenMount->getJournal().getLatest();
-
-  *out.mountGeneration_ref() = edenMount->getMountGeneration();
-  if (latest) {
-    out.sequenceNumber_ref() = latest->sequenceID;
-    out.snapshotHash_ref() =
-        edenMount->getObjectStore()->renderRootId(latest->toHash);
-  } else {
-    out.sequenceNumber_ref() = 0;
-    out.snapshotHash_ref() =
-        edenMount->getObjectStore()->renderRootId(RootId{});
-  }
+  // Only reads in-memory state, so this is always answered inline.
+  auto future = makeImmediateFutureWith([&] {
+    auto mountPath = absolutePathFromThrift(*mountPoint);
+    auto edenMount = server_->getMount(mountPath);
+    auto latest = edenMount->getJournal().getLatest();
+
+    auto out = std::make_unique<JournalPosition>();
+    *out->mountGeneration_ref() = edenMount->getMountGeneration();
+    if (latest) {
+      out->sequenceNumber_ref() = latest->sequenceID;
+      out->snapshotHash_ref() =
+          edenMount->getObjectStore()->renderRootId(latest->toHash);
+    } else {
+      out->sequenceNumber_ref() = 0;
+      out->snapshotHash_ref() =
+          edenMount->getObjectStore()->renderRootId(RootId{});
+    }
+    return out;
+  });
+  completeOnEventBase(
+      std::move(callback),
+      wrapImmediateFuture(std::move(helper), std::move(future)),
+      server_->getServerState()->getThreadPool().get());
 }
 
 apache::thrift::ServerStream<JournalPosition>
@@ -917,7 +1156,13 @@ EdenServiceHandler::subscribeStreamTemporary(
 
   // Register onJournalChange with the journal subsystem, and assign
   // the subscriber id into the handle so that the callbacks can consume it.
-  handle->emplace(edenMount->getJournal().registerSubscriber(
+  // Bursts of changes are coalesced, and pushed off the writers' threads.
+  const auto& serverState = server_->getServerState();
+  handle->emplace(CoalescingSubscriber::subscribe(
+      edenMount->getJournal(),
+      folly::getKeepAliveToken(
+          serverState->getJournalNotificationExecutor().get()),
+      serverState->getEdenConfig()->journalNotificationInterval.getValue(),
       [stream = std::move(stream)]() mutable {
         JournalPosition pos;
         // The value is intentionally undefined and should not be used. Instead,
@@ -1052,6 +1297,29 @@ bool isEventMasked(int64_t eventCategoryMask, const NfsTraceEvent& event) {
       eventCategoryMask, nfsProcAccessType(event.getProcNumber()));
 }
 
+SlowFsRequest thriftSlowFsRequest(
+    const FuseTraceEvent::SlowRequest& slowRequest,
+    uint64_t nodeid,
+    InodeMap& inodeMap) {
+  SlowFsRequest result;
+  result.durationNs_ref() =
+      std::chrono::nanoseconds{slowRequest.duration}.count();
+  result.backingStoreDurationNs_ref() =
+      std::chrono::nanoseconds{slowRequest.backingStoreDuration}.count();
+  // Slow requests are rare enough to afford resolving their path here, off
+  // the FUSE threads.
+  if (nodeid != 0) {
+    try {
+      if (auto path = inodeMap.getPathForInode(InodeNumber{nodeid})) {
+        result.path_ref() = path->asString();
+      }
+    } catch (const std::system_error&) {
+      // The kernel may refer to inodes EdenFS doesn't know anymore.
+    }
+  }
+  return result;
+}
+
 } // namespace
 
 #endif //!_WIN32
@@ -1083,6 +1351,23 @@ ThriftRequestMetadata populateThriftRequestMetadata(
   return thriftRequestMetadata;
 }
 
+ThriftRequestSpanKind thriftRequestSpanKind(
+    ThriftRequestTraceEvent::SpanKind kind) {
+  switch (kind) {
+    case ThriftRequestTraceEvent::NO_SPAN:
+      break;
+    case ThriftRequestTraceEvent::DISK_CACHE_FETCH:
+      return ThriftRequestSpanKind::DISK_CACHE_FETCH;
+    case ThriftRequestTraceEvent::NETWORK_FETCH:
+      return ThriftRequestSpanKind::NETWORK_FETCH;
+    case ThriftRequestTraceEvent::BACKING_STORE_REQUEST:
+      return ThriftRequestSpanKind::BACKING_STORE_REQUEST;
+    case ThriftRequestTraceEvent::INODE_LOAD:
+      return ThriftRequestSpanKind::INODE_LOAD;
+  }
+  return ThriftRequestSpanKind::UNKNOWN;
+}
+
 /**
  * Helper function to convert a ThriftRequestTraceEvent to a ThriftRequestEvent
  * type. Used in EdenServiceHandler::traceThriftRequestEvents and
@@ -1099,6 +1384,14 @@ void convertThriftRequestTraceEventToThriftRequestEvent(
     case ThriftRequestTraceEvent::FINISH:
       te.eventType() = ThriftRequestEventType::FINISH;
       break;
+    case ThriftRequestTraceEvent::SPAN: {
+      te.eventType() = ThriftRequestEventType::SPAN;
+      ThriftRequestSpan span;
+      span.kind() = thriftRequestSpanKind(event.spanKind);
+      span.durationNs() = event.spanDuration.count();
+      te.span() = std::move(span);
+      break;
+    }
   }
   te.requestMetadata_ref() = populateThriftRequestMetadata(event);
 }
@@ -1226,6 +1519,7 @@ apache::thrift::ServerStream<FsEvent> EdenServiceHandler::traceFsEvents(
         fmt::format("strace-{}", edenMount->getPath().basename()),
         [publisher = ThriftStreamPublisherOwner{std::move(publisher)},
          serverState = server_->getServerState(),
+         inodeMap = edenMount->getInodeMap(),
          eventCategoryMask](const FuseTraceEvent& event) {
           if (isEventMasked(eventCategoryMask, event)) {
             return;
@@ -1254,6 +1548,10 @@ apache::thrift::ServerStream<FsEvent> EdenServiceHandler::traceFsEvents(
             case FuseTraceEvent::FINISH:
               te.type_ref() = FsEventType::FINISH;
               te.result_ref().from_optional(event.getResponseCode());
+              if (auto slow = event.getSlowRequest()) {
+                te.slowRequest_ref() = thriftSlowFsRequest(
+                    *slow, event.getRequest().nodeid, *inodeMap);
+              }
               break;
           }
 
@@ -1399,6 +1697,21 @@ void convertHgImportTraceEventToHgEvent(
       break;
   }
 
+  switch (event.fetchedSource) {
+    case HgImportRequest::FetchedSource::Unknown:
+      te.fetchedSource_ref() = HgImportFetchedSource::UNKNOWN;
+      break;
+    case HgImportRequest::FetchedSource::Local:
+      te.fetchedSource_ref() = HgImportFetchedSource::LOCAL;
+      break;
+    case HgImportRequest::FetchedSource::Remote:
+      te.fetchedSource_ref() = HgImportFetchedSource::REMOTE;
+      break;
+    case HgImportRequest::FetchedSource::HgImporter:
+      te.fetchedSource_ref() = HgImportFetchedSource::HG_IMPORTER;
+      break;
+  }
+
   te.unique_ref() = event.unique;
 
   te.manifestNodeId_ref() = event.manifestNodeId.toString();
@@ -1457,6 +1770,15 @@ void ConvertInodeTraceEventToThriftInodeEvent(
   thriftEvent.eventType() = traceEvent.eventType;
   thriftEvent.progress() = traceEvent.progress;
   thriftEvent.duration() = traceEvent.duration.count();
+  if (traceEvent.eventType == InodeEventType::LOAD &&
+      traceEvent.progress == InodeEventProgress::END) {
+    InodeLoadBreakdown breakdown;
+    breakdown.inodeMapWait() = traceEvent.loadPhases.inodeMapWait;
+    breakdown.treeFetch() = traceEvent.loadPhases.treeFetch;
+    breakdown.overlayRead() = traceEvent.loadPhases.overlayRead;
+    breakdown.metadataLookup() = traceEvent.loadPhases.metadataLookup;
+    thriftEvent.loadBreakdown() = std::move(breakdown);
+  }
   // TODO: trace requesting pid
   // thriftEvent.requestInfo() = thriftRequestInfo(pid);
 }
@@ -1530,24 +1852,26 @@ void publishFile(
 
 class StreamingDiffCallback : public DiffCallback {
  public:
-  explicit StreamingDiffCallback(
+  StreamingDiffCallback(
       std::shared_ptr<
           folly::Synchronized<ThriftStreamPublisherOwner<ChangedFileResult>>>
-          publisher)
-      : publisher_{std::move(publisher)} {}
+          publisher,
+      RelativePath relativeRoot)
+      : publisher_{std::move(publisher)},
+        relativeRoot_{std::move(relativeRoot)} {}
 
   void ignoredPath(RelativePathPiece, dtype_t) override {}
 
   void addedPath(RelativePathPiece path, dtype_t type) override {
-    publishFile(*publisher_, path.view(), ScmFileStatus::ADDED, type);
+    publish(path, ScmFileStatus::ADDED, type);
   }
 
   void removedPath(RelativePathPiece path, dtype_t type) override {
-    publishFile(*publisher_, path.view(), ScmFileStatus::REMOVED, type);
+    publish(path, ScmFileStatus::REMOVED, type);
   }
 
   void modifiedPath(RelativePathPiece path, dtype_t type) override {
-    publishFile(*publisher_, path.view(), ScmFileStatus::MODIFIED, type);
+    publish(path, ScmFileStatus::MODIFIED, type);
   }
 
   void diffError(RelativePathPiece /*path*/, const folly::exception_wrapper& ew)
@@ -1557,9 +1881,17 @@ class StreamingDiffCallback : public DiffCallback {
   }
 
  private:
+  void publish(RelativePathPiece path, ScmFileStatus status, dtype_t type) {
+    if (relativeRoot_.empty() || path == relativeRoot_ ||
+        path.isSubDirOf(relativeRoot_)) {
+      publishFile(*publisher_, path.view(), status, type);
+    }
+  }
+
   std::shared_ptr<
       folly::Synchronized<ThriftStreamPublisherOwner<ChangedFileResult>>>
       publisher_;
+  const RelativePath relativeRoot_;
 };
 
 } // namespace
@@ -1586,12 +1918,13 @@ EdenServiceHandler::streamChangesSince(
   // potentially unbounded.
 
   checkMountGeneration(fromPosition, edenMount, "fromPosition"sv);
+  RelativePath relativeRoot{*params->relativeRoot()};
 
   // The +1 is because the core merge stops at the item prior to
   // its limitSequence parameter and we want the changes *since*
   // the provided sequence number.
   auto summed = edenMount->getJournal().accumulateRange(
-      *fromPosition.sequenceNumber_ref() + 1);
+      *fromPosition.sequenceNumber_ref() + 1, relativeRoot);
 
   ChangesSinceResult result;
   if (!summed) {
@@ -1652,7 +1985,10 @@ EdenServiceHandler::streamChangesSince(
   }
 
   if (summed->snapshotTransitions.size() > 1) {
-    auto callback = std::make_shared<StreamingDiffCallback>(sharedPublisher);
+    // The diffs cover the whole mount, their results outside of relativeRoot
+    // are dropped.
+    auto callback = std::make_shared<StreamingDiffCallback>(
+        sharedPublisher, std::move(relativeRoot));
 
     std::vector<ImmediateFuture<folly::Unit>> futures;
     for (auto rootIt = summed->snapshotTransitions.begin();
@@ -1699,6 +2035,140 @@ EdenServiceHandler::streamChangesSince(
   return {std::move(result), std::move(serverStream)};
 }
 
+namespace {
+
+/**
+ * Publishes the matches of a streamGlobFiles request, once at least
+ * chunkSize of them are pending.
+ */
+class StreamingGlobSink : public GlobNode::ResultSink {
+ public:
+  StreamingGlobSink(
+      std::shared_ptr<folly::Synchronized<ThriftStreamPublisherOwner<Glob>>>
+          publisher,
+      const ObjectStore* objectStore,
+      bool listOnlyFiles,
+      bool wantDtype,
+      size_t chunkSize)
+      : publisher_{std::move(publisher)},
+        objectStore_{objectStore},
+        listOnlyFiles_{listOnlyFiles},
+        wantDtype_{wantDtype},
+        chunkSize_{chunkSize} {}
+
+  void addResults(std::vector<GlobNode::GlobResult>&& results) override {
+    std::vector<GlobNode::GlobResult> chunk;
+    {
+      auto pending = pending_.lock();
+      pending->insert(
+          pending->end(),
+          std::make_move_iterator(results.begin()),
+          std::make_move_iterator(results.end()));
+      if (pending->size() < chunkSize_) {
+        return;
+      }
+      chunk.swap(*pending);
+    }
+    publish(chunk);
+  }
+
+  /**
+   * Publish the matches still pending, once the glob completed.
+   */
+  void flush() {
+    std::vector<GlobNode::GlobResult> chunk;
+    chunk.swap(*pending_.lock());
+    if (!chunk.empty()) {
+      publish(chunk);
+    }
+  }
+
+ private:
+  void publish(const std::vector<GlobNode::GlobResult>& chunk) {
+    Glob glob;
+    ThriftGlobImpl::appendResults(
+        glob, chunk, *objectStore_, listOnlyFiles_, wantDtype_);
+    if (!glob.matchingFiles()->empty()) {
+      publisher_->rlock()->next(std::move(glob));
+    }
+  }
+
+  std::shared_ptr<folly::Synchronized<ThriftStreamPublisherOwner<Glob>>>
+      publisher_;
+  const ObjectStore* const objectStore_;
+  const bool listOnlyFiles_;
+  const bool wantDtype_;
+  const size_t chunkSize_;
+  folly::Synchronized<std::vector<GlobNode::GlobResult>, std::mutex> pending_;
+};
+
+} // namespace
+
+apache::thrift::ServerStream<Glob> EdenServiceHandler::streamGlobFiles(
+    std::unique_ptr<GlobParams> params) {
+  ThriftGlobImpl globber{*params};
+  auto helper = INSTRUMENT_THRIFT_CALL_WITH_STAT(
+      DBG3,
+      &ThriftStats::streamGlobFiles,
+      *params->mountPoint_ref(),
+      toLogArg(*params->globs_ref()),
+      globber.logString());
+  auto& context = helper->getFetchContext();
+  auto edenMount =
+      server_->getMount(absolutePathFromThrift(*params->mountPoint_ref()));
+  auto& serverState = server_->getServerState();
+
+  // As for streamChangesSince, the publisher is driven by EdenFS: the chunks
+  // are published as soon as they are ready, whether or not the client
+  // consumed the previous ones.
+  auto [serverStream, publisher] =
+      apache::thrift::ServerStream<Glob>::createPublisher([] {});
+  auto sharedPublisher =
+      std::make_shared<folly::Synchronized<ThriftStreamPublisherOwner<Glob>>>(
+          ThriftStreamPublisherOwner{std::move(publisher)});
+  auto sink = std::make_shared<StreamingGlobSink>(
+      sharedPublisher,
+      edenMount->getObjectStore(),
+      globber.listOnlyFiles(),
+      globber.wantDtype(),
+      serverState->getEdenConfig()->globStreamChunkSize.getValue());
+
+  // Evaluate the glob on a background thread, so that the stream is returned
+  // to the client right away.
+  folly::futures::detachOn(
+      serverState->getThreadPool().get(),
+      makeNotReadyImmediateFuture()
+          .thenValue([edenMount,
+                      serverState,
+                      globs = std::move(*params->globs()),
+                      globber = std::move(globber),
+                      sink,
+                      &context](auto&&) mutable {
+            return globber.glob(
+                edenMount, serverState, std::move(globs), context, sink.get());
+          })
+          // The mount, params, sink and helper must outlive the glob.
+          // Dropping the last reference to the publisher completes the
+          // stream.
+          .thenTry([edenMount,
+                    sharedPublisher,
+                    sink,
+                    helper = std::move(helper),
+                    params = std::move(params)](
+                       folly::Try<std::unique_ptr<Glob>>&& result) mutable {
+            if (result.hasException()) {
+              auto publisher = std::move(*sharedPublisher->wlock());
+              std::move(publisher).next(
+                  newEdenError(std::move(result).exception()));
+              return;
+            }
+            sink->flush();
+          })
+          .semi());
+
+  return std::move(serverStream);
+}
+
 void EdenServiceHandler::getFilesChangedSince(
     FileDelta& out,
     std::unique_ptr<std::string> mountPoint,
@@ -1958,6 +2428,51 @@ SourceControlType entryTypeToThriftType(TreeEntryType type) {
   }
 }
 
+Dtype entryTypeToDtype(TreeEntryType type) {
+  switch (type) {
+    case TreeEntryType::TREE:
+      return Dtype::DIR;
+    case TreeEntryType::REGULAR_FILE:
+    case TreeEntryType::EXECUTABLE_FILE:
+      return Dtype::REGULAR;
+    case TreeEntryType::SYMLINK:
+      return Dtype::LINK;
+  }
+  return Dtype::UNKNOWN;
+}
+
+/**
+ * Fill the dtype and attributes of a path returned by getChangesSince from
+ * its current state.
+ */
+void fillChangedPath(
+    ChangedPath& change,
+    const folly::Try<EntryAttributes>& tryAttributes) {
+  if (tryAttributes.hasException()) {
+    auto* ex = tryAttributes.exception().get_exception<std::system_error>();
+    if (ex && isEnoent(*ex)) {
+      // Removed after the journal was read.
+      change.status() = ScmFileStatus::REMOVED;
+    } else {
+      change.error() = newEdenError(tryAttributes.exception());
+    }
+    return;
+  }
+
+  // Directories and symlinks carry errors for the file attributes, which
+  // are left unset.
+  const auto& attributes = tryAttributes.value();
+  if (attributes.type.has_value() && attributes.type->hasValue()) {
+    change.dtype() = entryTypeToDtype(attributes.type->value());
+  }
+  if (attributes.size.has_value() && attributes.size->hasValue()) {
+    change.size() = attributes.size->value();
+  }
+  if (attributes.sha1.has_value() && attributes.sha1->hasValue()) {
+    change.sha1() = thriftHash20(attributes.sha1->value());
+  }
+}
+
 ImmediateFuture<
     std::vector<std::pair<PathComponent, folly::Try<EntryAttributes>>>>
 getAllEntryAttributes(
@@ -2139,6 +2654,268 @@ EdenServiceHandler::semifuture_readdir(std::unique_ptr<ReaddirParams> params) {
 constexpr EntryAttributeFlags kAllEntryAttributes =
     ENTRY_ATTRIBUTE_SIZE | ENTRY_ATTRIBUTE_SHA1 | ENTRY_ATTRIBUTE_TYPE;
 
+namespace {
+
+/**
+ * Resolves the attributes of many paths of a mount at once.
+ *
+ * The paths are sorted so that siblings are looked up together: their parent
+ * directory is resolved once for all of them. The metadata of all the files
+ * whose inodes aren't loaded is then fetched with a single
+ * ObjectStore::getBlobMetadataBatch call, while loaded files, whose SHA-1 may
+ * have to be computed from their materialized contents, are handled in
+ * parallel on the server's thread pool.
+ */
+class EntryAttributesBatch {
+ public:
+  EntryAttributesBatch(
+      std::shared_ptr<EdenMount> edenMount,
+      const std::vector<std::string>& paths,
+      EntryAttributeFlags requestedAttributes,
+      std::shared_ptr<UnboundedQueueExecutor> threadPool,
+      EdenStats& stats,
+      const ObjectFetchContextPtr& fetchContext)
+      : edenMount_{std::move(edenMount)},
+        paths_{paths},
+        requestedAttributes_{requestedAttributes},
+        threadPool_{std::move(threadPool)},
+        stats_{stats},
+        fetchContext_{fetchContext.copy()},
+        results_(paths.size()) {}
+
+  static ImmediateFuture<std::vector<folly::Try<EntryAttributes>>> run(
+      std::shared_ptr<EntryAttributesBatch> batch) {
+    auto lookups = batch->lookUpPaths();
+    return std::move(lookups).thenValue(
+        [batch](std::vector<std::optional<folly::Try<VirtualInode>>> inodes) {
+          auto lookupTime = batch->watch_.lap();
+          batch->stats_.addDuration(
+              &ThriftStats::getAttributesLookup, lookupTime);
+          return batch->computeAttributes(std::move(inodes))
+              .thenValue([batch, lookupTime](auto&&) {
+                auto computeTime = batch->watch_.lap();
+                batch->stats_.addDuration(
+                    &ThriftStats::getAttributesCompute, computeTime);
+                XLOG(DBG4) << "attributes of " << batch->paths_.size()
+                           << " paths: lookup took " << lookupTime.count()
+                           << "ns, computing took " << computeTime.count()
+                           << "ns, with " << batch->batchedCount_
+                           << " blobs fetched in a batch";
+                std::vector<folly::Try<EntryAttributes>> results;
+                results.reserve(batch->results_.size());
+                for (auto& result : batch->results_) {
+                  results.push_back(std::move(result).value());
+                }
+                return results;
+              });
+        });
+  }
+
+ private:
+  /**
+   * Paths that can't be resolved are rejected before any lookup, like a
+   * single invalid path would be.
+   */
+  std::optional<RelativePathPiece> validatePath(size_t index) {
+    const auto& path = paths_[index];
+    if (path.empty()) {
+      results_[index] = folly::Try<EntryAttributes>{newEdenError(
+          EINVAL,
+          EdenErrorType::ARGUMENT_ERROR,
+          "path cannot be the empty string")};
+      return std::nullopt;
+    }
+    try {
+      return RelativePathPiece{path};
+    } catch (const std::exception& e) {
+      results_[index] = folly::Try<EntryAttributes>{
+          newEdenError(EINVAL, EdenErrorType::ARGUMENT_ERROR, e.what())};
+      return std::nullopt;
+    }
+  }
+
+  /**
+   * Returns one VirtualInode per path, or std::nullopt for the paths that
+   * were rejected by validatePath, whose results are already set.
+   */
+  ImmediateFuture<std::vector<std::optional<folly::Try<VirtualInode>>>>
+  lookUpPaths() {
+    std::vector<std::pair<RelativePathPiece, size_t>> sorted;
+    sorted.reserve(paths_.size());
+    for (size_t index = 0; index < paths_.size(); ++index) {
+      if (auto path = validatePath(index)) {
+        sorted.emplace_back(*path, index);
+      }
+    }
+    std::sort(sorted.begin(), sorted.end());
+
+    // Sorting places the children of a directory next to each other.
+    std::vector<std::vector<std::pair<RelativePathPiece, size_t>>> groups;
+    for (auto& entry : sorted) {
+      if (groups.empty() ||
+          groups.back().front().first.dirname() != entry.first.dirname()) {
+        groups.emplace_back();
+      }
+      groups.back().push_back(entry);
+    }
+
+    std::vector<ImmediateFuture<std::vector<folly::Try<VirtualInode>>>>
+        groupFutures;
+    groupFutures.reserve(groups.size());
+    for (auto& group : groups) {
+      groupFutures.push_back(lookUpSiblings(group));
+    }
+
+    return collectAllSafe(std::move(groupFutures))
+        .thenValue([this, groups = std::move(groups)](
+                       std::vector<std::vector<folly::Try<VirtualInode>>>
+                           groupInodes) {
+          std::vector<std::optional<folly::Try<VirtualInode>>> inodes(
+              paths_.size());
+          for (size_t group = 0; group < groups.size(); ++group) {
+            for (size_t i = 0; i < groups[group].size(); ++i) {
+              inodes[groups[group][i].second] =
+                  std::move(groupInodes[group][i]);
+            }
+          }
+          return inodes;
+        });
+  }
+
+  ImmediateFuture<std::vector<folly::Try<VirtualInode>>> lookUpSiblings(
+      const std::vector<std::pair<RelativePathPiece, size_t>>& siblings) {
+    auto parent = siblings.front().first.dirname();
+    return edenMount_->getVirtualInode(parent, fetchContext_)
+        .thenTry([this, siblings](folly::Try<VirtualInode> parent) {
+          std::vector<ImmediateFuture<VirtualInode>> children;
+          children.reserve(siblings.size());
+          for (auto& [path, index] : siblings) {
+            if (parent.hasValue()) {
+              children.push_back(parent->getOrFindChild(
+                  path.basename(),
+                  path,
+                  edenMount_->getObjectStore(),
+                  fetchContext_));
+            } else {
+              // Look the path up on its own, so that the error names it.
+              children.push_back(
+                  edenMount_->getVirtualInode(path, fetchContext_));
+            }
+          }
+          return collectAll(std::move(children));
+        });
+  }
+
+  ImmediateFuture<folly::Unit> computeAttributes(
+      std::vector<std::optional<folly::Try<VirtualInode>>> inodes) {
+    bool needsBlobMetadata = requestedAttributes_.containsAnyOf(
+        ENTRY_ATTRIBUTE_SIZE | ENTRY_ATTRIBUTE_SHA1);
+
+    std::vector<size_t> batched;
+    std::vector<ObjectId> batchedIds;
+    std::vector<ImmediateFuture<folly::Unit>> futures;
+    for (size_t index = 0; index < inodes.size(); ++index) {
+      if (!inodes[index]) {
+        // Rejected by validatePath.
+        continue;
+      }
+      auto& inode = *inodes[index];
+      if (inode.hasException()) {
+        results_[index] = folly::Try<EntryAttributes>{inode.exception()};
+        continue;
+      }
+
+      const auto& virtualInode = inode.value();
+      auto path = RelativePathPiece{paths_[index]};
+      std::optional<ObjectId> blobId;
+      if (needsBlobMetadata && virtualInode.getDtype() == dtype_t::Regular) {
+        blobId = virtualInode.getUnloadedBlobId();
+        if (!blobId) {
+          // Hashing a materialized file reads all of it: spread them over
+          // the thread pool.
+          futures.push_back(setResult(
+              index,
+              ImmediateFuture<EntryAttributes>{
+                  folly::via(
+                      threadPool_.get(),
+                      [this, virtualInode, path] {
+                        return virtualInode
+                            .getEntryAttributes(
+                                requestedAttributes_,
+                                path,
+                                edenMount_->getObjectStore(),
+                                fetchContext_)
+                            .semi();
+                      })
+                      .semi()}));
+          continue;
+        }
+      }
+      if (blobId) {
+        batched.push_back(index);
+        batchedIds.push_back(std::move(*blobId));
+        continue;
+      }
+      futures.push_back(setResult(
+          index,
+          virtualInode.getEntryAttributes(
+              requestedAttributes_,
+              path,
+              edenMount_->getObjectStore(),
+              fetchContext_)));
+    }
+
+    batchedCount_ = batched.size();
+    if (!batched.empty()) {
+      futures.push_back(
+          edenMount_->getObjectStore()
+              ->getBlobMetadataBatch(batchedIds, fetchContext_)
+              .thenValue(
+                  [this,
+                   inodes = std::move(inodes),
+                   batched = std::move(batched)](
+                      std::vector<folly::Try<BlobMetadata>> metadata) {
+                    std::vector<ImmediateFuture<folly::Unit>> futures;
+                    futures.reserve(batched.size());
+                    for (size_t i = 0; i < batched.size(); ++i) {
+                      auto index = batched[i];
+                      futures.push_back(setResult(
+                          index,
+                          (*inodes[index])->getEntryAttributes(
+                              requestedAttributes_,
+                              RelativePathPiece{paths_[index]},
+                              std::move(metadata[i]),
+                              fetchContext_)));
+                    }
+                    return collectAllSafe(std::move(futures))
+                        .unit();
+                  }));
+    }
+    return collectAllSafe(std::move(futures)).unit();
+  }
+
+  ImmediateFuture<folly::Unit> setResult(
+      size_t index,
+      ImmediateFuture<EntryAttributes> attributes) {
+    return std::move(attributes).thenTry(
+        [this, index](folly::Try<EntryAttributes> result) {
+          results_[index] = std::move(result);
+        });
+  }
+
+  const std::shared_ptr<EdenMount> edenMount_;
+  const std::vector<std::string>& paths_;
+  const EntryAttributeFlags requestedAttributes_;
+  const std::shared_ptr<UnboundedQueueExecutor> threadPool_;
+  EdenStats& stats_;
+  const ObjectFetchContextPtr fetchContext_;
+  folly::stop_watch<std::chrono::nanoseconds> watch_;
+  size_t batchedCount_ = 0;
+  std::vector<std::optional<folly::Try<EntryAttributes>>> results_;
+};
+
+} // namespace
+
 ImmediateFuture<std::vector<folly::Try<EntryAttributes>>>
 EdenServiceHandler::getEntryAttributes(
     AbsolutePathPiece mountPath,
@@ -2146,20 +2923,18 @@ EdenServiceHandler::getEntryAttributes(
     EntryAttributeFlags reqBitmask,
     SyncBehavior sync,
     const ObjectFetchContextPtr& fetchContext) {
-  return waitForPendingNotifications(*server_->getMount(mountPath), sync)
-      .thenValue([this,
-                  &paths,
-                  fetchContext = fetchContext.copy(),
-                  mountPath = mountPath.copy(),
-                  reqBitmask](auto&&) mutable {
-        vector<ImmediateFuture<EntryAttributes>> futures;
-        for (const auto& p : paths) {
-          futures.emplace_back(getEntryAttributesForPath(
-              reqBitmask, mountPath, p, fetchContext));
-        }
-
-        // Collect all futures into a single tuple
-        return facebook::eden::collectAll(std::move(futures));
+  auto edenMount = server_->getMount(mountPath);
+  auto& serverState = *server_->getServerState();
+  auto batch = std::make_shared<EntryAttributesBatch>(
+      edenMount,
+      paths,
+      reqBitmask,
+      serverState.getThreadPool(),
+      serverState.getStats(),
+      fetchContext);
+  return waitForPendingNotifications(*edenMount, sync)
+      .thenValue([batch = std::move(batch)](auto&&) mutable {
+        return EntryAttributesBatch::run(std::move(batch));
       });
 }
 
@@ -2306,6 +3081,119 @@ EdenServiceHandler::semifuture_getAttributesFromFilesV2(
       .semi();
 }
 
+folly::SemiFuture<std::unique_ptr<GetChangesSinceResult>>
+EdenServiceHandler::semifuture_getChangesSince(
+    std::unique_ptr<GetChangesSinceParams> params) {
+  auto mountPoint = *params->mountPoint();
+  auto helper =
+      INSTRUMENT_THRIFT_CALL(DBG3, mountPoint, getSyncTimeout(*params->sync()));
+  auto mountPath = absolutePathFromThrift(mountPoint);
+  auto edenMount = server_->getMount(mountPath);
+  const auto& fromPosition = *params->fromPosition();
+
+  checkMountGeneration(fromPosition, edenMount, "fromPosition"sv);
+
+  auto result = std::make_unique<GetChangesSinceResult>();
+  result->toPosition() = fromPosition;
+  result->toPosition()->mountGeneration() = edenMount->getMountGeneration();
+  result->fromPosition() = *result->toPosition();
+
+  // As in getFilesChangedSince, the +1 is because we want the changes *since*
+  // the provided sequence number.
+  auto summed = edenMount->getJournal().accumulateRange(
+      *fromPosition.sequenceNumber() + 1);
+  if (!summed) {
+    return folly::makeSemiFuture(std::move(result));
+  }
+  if (summed->isTruncated) {
+    throw newEdenError(
+        EDOM,
+        EdenErrorType::JOURNAL_TRUNCATED,
+        "Journal entry range has been truncated.");
+  }
+
+  RootIdCodec& rootIdCodec = *edenMount->getObjectStore();
+  result->fromPosition()->sequenceNumber() = summed->fromSequence;
+  result->fromPosition()->snapshotHash() =
+      rootIdCodec.renderRootId(summed->snapshotTransitions.front());
+  result->toPosition()->sequenceNumber() = summed->toSequence;
+  result->toPosition()->snapshotHash() =
+      rootIdCodec.renderRootId(summed->snapshotTransitions.back());
+  result->snapshotTransitions()->reserve(summed->snapshotTransitions.size());
+  for (auto& hash : summed->snapshotTransitions) {
+    result->snapshotTransitions()->push_back(rootIdCodec.renderRootId(hash));
+  }
+
+  auto addChange = [&](const RelativePath& path, ScmFileStatus status) {
+    ChangedPath change;
+    change.path() = path.asString();
+    change.status() = status;
+    change.dtype() = Dtype::UNKNOWN;
+    result->changes()->push_back(std::move(change));
+  };
+  for (const auto& [path, changeInfo] : summed->changedFilesInOverlay) {
+    if (!changeInfo.existedBefore && changeInfo.existedAfter) {
+      addChange(path, ScmFileStatus::ADDED);
+    } else if (changeInfo.existedBefore && !changeInfo.existedAfter) {
+      addChange(path, ScmFileStatus::REMOVED);
+    } else if (changeInfo.existedBefore) {
+      addChange(path, ScmFileStatus::MODIFIED);
+    }
+    // Otherwise the path was created and removed within the range.
+  }
+  for (const auto& path : summed->uncleanPaths) {
+    if (summed->changedFilesInOverlay.count(path) == 0) {
+      addChange(path, ScmFileStatus::MODIFIED);
+    }
+  }
+
+  // Look up the current state of the paths that weren't removed, in one
+  // batch.
+  auto paths = std::make_unique<std::vector<std::string>>();
+  std::vector<size_t> indices;
+  for (size_t i = 0; i < result->changes()->size(); ++i) {
+    const auto& change = (*result->changes())[i];
+    if (*change.status() != ScmFileStatus::REMOVED) {
+      paths->push_back(*change.path());
+      indices.push_back(i);
+    }
+  }
+  if (paths->empty()) {
+    return folly::makeSemiFuture(std::move(result));
+  }
+
+  auto requestedAttributes =
+      EntryAttributeFlags::raw(*params->requestedAttributes());
+  EntryAttributeFlags reqBitmask = ENTRY_ATTRIBUTE_TYPE;
+  if (requestedAttributes.contains(ENTRY_ATTRIBUTE_SIZE)) {
+    reqBitmask |= ENTRY_ATTRIBUTE_SIZE;
+  }
+  if (requestedAttributes.contains(ENTRY_ATTRIBUTE_SHA1)) {
+    reqBitmask |= ENTRY_ATTRIBUTE_SHA1;
+  }
+  auto& fetchContext = helper->getFetchContext();
+  auto entryAttributesFuture = getEntryAttributes(
+      mountPath, *paths, reqBitmask, *params->sync(), fetchContext);
+
+  return wrapImmediateFuture(
+             std::move(helper),
+             std::move(entryAttributesFuture)
+                 .thenValue([result = std::move(result),
+                             indices = std::move(indices)](
+                                std::vector<folly::Try<EntryAttributes>>&&
+                                    allRes) mutable {
+                   auto& changes = *result->changes();
+                   for (size_t i = 0; i < allRes.size(); ++i) {
+                     fillChangedPath(changes[indices[i]], allRes[i]);
+                   }
+                   return std::move(result);
+                 }))
+      .ensure([paths = std::move(paths)]() {
+        // getEntryAttributes uses the paths by reference.
+      })
+      .semi();
+}
+
 folly::SemiFuture<std::unique_ptr<SetPathObjectIdResult>>
 EdenServiceHandler::semifuture_setPathObjectId(
     std::unique_ptr<SetPathObjectIdParams> params) {
@@ -2659,15 +3547,26 @@ EdenServiceHandler::semifuture_globFiles(std::unique_ptr<GlobParams> params) {
       context,
       server_->getServerState());
 
+  // Background globs only run once no foreground glob waits.
+  auto priority = isBackground ? ThriftRequestLimiter::Priority::Low
+                               : ThriftRequestLimiter::Priority::High;
   auto globFut =
       std::move(backgroundFuture)
+          .thenValue([this, priority](auto&&) {
+            auto config = server_->getServerState()->getEdenConfig();
+            return globLimiter_.acquire(
+                config->thriftMaxConcurrentGlobs.getValue(),
+                config->thriftMaxQueuedRequests.getValue(),
+                priority);
+          })
           .thenValue([mount = server_->getMount(
                           absolutePathFromThrift(*params->mountPoint())),
                       serverState = server_->getServerState(),
                       globs = std::move(*params->globs()),
                       globber = std::move(globber),
-                      &context](auto&&) mutable {
-            return globber.glob(mount, serverState, std::move(globs), context);
+                      &context](ThriftRequestLimiter::Permit&& permit) mutable {
+            return globber.glob(mount, serverState, std::move(globs), context)
+                .ensure([permit = std::move(permit)] {});
           });
   globFut = std::move(globFut).ensure(
       [helper = std::move(helper), params = std::move(params)] {});
@@ -2699,16 +3598,25 @@ folly::SemiFuture<folly::Unit> EdenServiceHandler::semifuture_prefetchFiles(
       context,
       server_->getServerState());
 
+  // Prefetches only run once no glob waits.
   auto globFut =
       std::move(backgroundFuture)
+          .thenValue([this](auto&&) {
+            auto config = server_->getServerState()->getEdenConfig();
+            return globLimiter_.acquire(
+                config->thriftMaxConcurrentGlobs.getValue(),
+                config->thriftMaxQueuedRequests.getValue(),
+                ThriftRequestLimiter::Priority::Low);
+          })
           .thenValue([mount = server_->getMount(
                           absolutePathFromThrift(*params->mountPoint())),
                       serverState = server_->getServerState(),
                       globs = std::move(*params->globs()),
                       globber = std::move(globber),
                       context = helper->getPrefetchFetchContext().copy()](
-                         auto&&) mutable {
-            return globber.glob(mount, serverState, std::move(globs), context);
+                         ThriftRequestLimiter::Permit&& permit) mutable {
+            return globber.glob(mount, serverState, std::move(globs), context)
+                .ensure([permit = std::move(permit)] {});
           })
           .thenValue([](std::unique_ptr<Glob>) { return folly::unit; });
   globFut = std::move(globFut).ensure(
@@ -2745,18 +3653,24 @@ EdenServiceHandler::semifuture_getScmStatusV2(
   auto mountPath = absolutePathFromThrift(*params->mountPoint_ref());
   auto mount = server_->getMount(mountPath);
   auto rootId = mount->getObjectStore()->parseRootId(*params->commit_ref());
-  const auto& enforceParents = server_->getServerState()
-                                   ->getReloadableConfig()
-                                   ->getEdenConfig()
-                                   ->enforceParents.getValue();
+  auto config =
+      server_->getServerState()->getReloadableConfig()->getEdenConfig();
   return wrapImmediateFuture(
              std::move(helper),
-             mount
-                 ->diff(
-                     rootId,
-                     context->getConnectionContext()->getCancellationToken(),
-                     *params->listIgnored_ref(),
-                     enforceParents)
+             statusLimiter_
+                 .run(
+                     config->thriftMaxConcurrentStatus.getValue(),
+                     config->thriftMaxQueuedRequests.getValue(),
+                     ThriftRequestLimiter::Priority::High,
+                     [mount,
+                      rootId = std::move(rootId),
+                      cancellation = context->getConnectionContext()
+                                         ->getCancellationToken(),
+                      listIgnored = *params->listIgnored_ref(),
+                      enforceParents = config->enforceParents.getValue()] {
+                       return mount->diff(
+                           rootId, cancellation, listIgnored, enforceParents);
+                     })
                  .thenValue([this, mount](std::unique_ptr<ScmStatus>&& status) {
                    auto result = std::make_unique<GetScmStatusResult>();
                    result->status_ref() = std::move(*status);
@@ -2766,6 +3680,220 @@ EdenServiceHandler::semifuture_getScmStatusV2(
       .semi();
 }
 
+apache::thrift::ServerStream<ScmStatusStreamItem>
+EdenServiceHandler::streamScmStatus(unique_ptr<GetScmStatusParams> params) {
+  auto* context = getRequestContext();
+  auto helper = INSTRUMENT_THRIFT_CALL_WITH_STAT(
+      DBG2,
+      &ThriftStats::streamScmStatus,
+      *params->mountPoint_ref(),
+      folly::to<string>("commitHash=", logHash(*params->commit_ref())),
+      folly::to<string>("listIgnored=", *params->listIgnored_ref()));
+
+  auto mountPath = absolutePathFromThrift(*params->mountPoint_ref());
+  auto mount = server_->getMount(mountPath);
+  auto rootId = mount->getObjectStore()->parseRootId(*params->commit_ref());
+  auto& serverState = server_->getServerState();
+  auto config = serverState->getEdenConfig();
+
+  // Closing the stream, like dropping the connection, cancels the diff.
+  auto cancellationSource = std::make_shared<folly::CancellationSource>();
+  auto cancellation = folly::CancellationToken::merge(
+      cancellationSource->getToken(),
+      context->getConnectionContext()->getCancellationToken());
+
+  // As for streamGlobFiles, the publisher is driven by EdenFS: the chunks are
+  // published as soon as they are ready, whether or not the client consumed
+  // the previous ones. EdenFS only holds on to the chunk being filled.
+  auto [serverStream, publisher] =
+      apache::thrift::ServerStream<ScmStatusStreamItem>::createPublisher(
+          [cancellationSource] { cancellationSource->requestCancellation(); });
+  auto sharedPublisher = std::make_shared<
+      folly::Synchronized<ThriftStreamPublisherOwner<ScmStatusStreamItem>>>(
+      ThriftStreamPublisherOwner{std::move(publisher)});
+  auto callback = std::make_shared<ChunkedScmStatusDiffCallback>(
+      config->scmStatusStreamChunkSize.getValue(),
+      [sharedPublisher](ScmStatus&& chunk) {
+        ScmStatusStreamItem item;
+        item.chunk_ref() = std::move(chunk);
+        sharedPublisher->rlock()->next(std::move(item));
+      });
+
+  // Diff on a background thread, so that the stream is returned to the
+  // client right away.
+  folly::futures::detachOn(
+      serverState->getThreadPool().get(),
+      makeNotReadyImmediateFuture()
+          .thenValue([mount,
+                      callback,
+                      rootId = std::move(rootId),
+                      listIgnored = *params->listIgnored_ref(),
+                      enforceParents = config->enforceParents.getValue(),
+                      cancellation = std::move(cancellation)](auto&&) mutable {
+            return mount->diff(
+                callback.get(),
+                rootId,
+                listIgnored,
+                enforceParents,
+                std::move(cancellation));
+          })
+          // The mount and the callback must outlive the diff. Dropping the
+          // last reference to the publisher completes the stream.
+          .thenTry([mount,
+                    sharedPublisher,
+                    callback,
+                    version = server_->getVersion(),
+                    helper = std::move(helper)](
+                       folly::Try<folly::Unit>&& result) mutable {
+            if (result.hasException()) {
+              auto publisher = std::move(*sharedPublisher->wlock());
+              std::move(publisher).next(
+                  newEdenError(std::move(result).exception()));
+              return;
+            }
+            callback->flush();
+            ScmStatusSummary summary;
+            summary.entryCount_ref() = callback->getEntryCount();
+            summary.errorCount_ref() = callback->getErrorCount();
+            summary.version_ref() = std::move(version);
+            ScmStatusStreamItem item;
+            item.summary_ref() = std::move(summary);
+            sharedPublisher->rlock()->next(std::move(item));
+          })
+          .semi());
+
+  return std::move(serverStream);
+}
+
+namespace {
+/**
+ * The blobs of a streamBlobs request. Each of its workers fetches and
+ * publishes the next blob not taken by another worker, until none is left.
+ */
+struct StreamBlobsState {
+  StreamBlobsState(
+      std::shared_ptr<EdenMount> mount,
+      std::vector<ObjectId> ids,
+      size_t chunkSize,
+      ObjectFetchContextPtr fetchContext,
+      folly::CancellationToken cancellation,
+      ThriftStreamPublisherOwner<BlobChunk> publisher)
+      : mount{std::move(mount)},
+        ids{std::move(ids)},
+        chunkSize{chunkSize},
+        fetchContext{std::move(fetchContext)},
+        cancellation{std::move(cancellation)},
+        publisher{std::move(publisher)} {}
+
+  const std::shared_ptr<EdenMount> mount;
+  const std::vector<ObjectId> ids;
+  const size_t chunkSize;
+  const ObjectFetchContextPtr fetchContext;
+  const folly::CancellationToken cancellation;
+  folly::Synchronized<ThriftStreamPublisherOwner<BlobChunk>> publisher;
+  std::atomic<size_t> nextIndex{0};
+};
+
+void publishBlob(
+    StreamBlobsState& state,
+    size_t index,
+    const folly::Try<std::shared_ptr<const Blob>>& blob) {
+  publishBlobChunks(
+      state.ids[index], index, blob, state.chunkSize, [&](BlobChunk&& chunk) {
+        state.publisher.rlock()->next(std::move(chunk));
+      });
+}
+
+ImmediateFuture<folly::Unit> streamNextBlobs(
+    std::shared_ptr<StreamBlobsState> state) {
+  // The blobs that are ready right away, such as the ones in the memory
+  // cache, are published in this loop rather than recursively.
+  while (!state->cancellation.isCancellationRequested()) {
+    auto index = state->nextIndex.fetch_add(1, std::memory_order_relaxed);
+    if (index >= state->ids.size()) {
+      break;
+    }
+    auto blobFuture = state->mount->getObjectStore()->getBlob(
+        state->ids[index], state->fetchContext);
+    if (!blobFuture.isReady()) {
+      return std::move(blobFuture)
+          .thenTry([state, index](
+                       folly::Try<std::shared_ptr<const Blob>>&& blob) mutable {
+            publishBlob(*state, index, blob);
+            return streamNextBlobs(std::move(state));
+          });
+    }
+    publishBlob(*state, index, std::move(blobFuture).getTry());
+  }
+  return folly::unit;
+}
+} // namespace
+
+apache::thrift::ServerStream<BlobChunk> EdenServiceHandler::streamBlobs(
+    std::unique_ptr<StreamBlobsParams> params) {
+  auto* context = getRequestContext();
+  auto helper = INSTRUMENT_THRIFT_CALL_WITH_STAT(
+      DBG3,
+      &ThriftStats::streamBlobs,
+      *params->mountId(),
+      folly::to<string>("ids=", params->ids()->size()));
+
+  auto mount = lookupMount(*params->mountId());
+  std::vector<ObjectId> ids;
+  ids.reserve(params->ids()->size());
+  for (const auto& id : *params->ids()) {
+    ids.push_back(mount->getObjectStore()->parseObjectId(id));
+  }
+  auto& serverState = server_->getServerState();
+  auto config = serverState->getEdenConfig();
+
+  // Closing the stream, like dropping the connection, stops the fetches.
+  auto cancellationSource = std::make_shared<folly::CancellationSource>();
+  auto cancellation = folly::CancellationToken::merge(
+      cancellationSource->getToken(),
+      context->getConnectionContext()->getCancellationToken());
+
+  // The chunks are published as soon as their blob is fetched, so EdenFS
+  // holds on to at most thrift:stream-blobs-parallelism blobs at a time.
+  auto [serverStream, publisher] =
+      apache::thrift::ServerStream<BlobChunk>::createPublisher(
+          [cancellationSource] { cancellationSource->requestCancellation(); });
+  auto state = std::make_shared<StreamBlobsState>(
+      std::move(mount),
+      std::move(ids),
+      config->thriftStreamBlobsChunkSize.getValue(),
+      helper->getFetchContext().copy(),
+      std::move(cancellation),
+      ThriftStreamPublisherOwner{std::move(publisher)});
+  auto parallelism =
+      std::max<size_t>(config->thriftStreamBlobsParallelism.getValue(), 1);
+
+  folly::futures::detachOn(
+      serverState->getThreadPool().get(),
+      makeNotReadyImmediateFuture()
+          .thenValue([state, parallelism](auto&&) {
+            auto workerCount = std::min(parallelism, state->ids.size());
+            std::vector<ImmediateFuture<folly::Unit>> workers;
+            workers.reserve(workerCount);
+            for (size_t i = 0; i < workerCount; ++i) {
+              workers.push_back(streamNextBlobs(state));
+            }
+            return collectAllSafe(std::move(workers)).unit();
+          })
+          // Dropping the last reference to the state completes the stream.
+          .thenTry([state, helper = std::move(helper)](
+                       folly::Try<folly::Unit>&& result) mutable {
+            if (result.hasException()) {
+              auto publisher = std::move(*state->publisher.wlock());
+              std::move(publisher).next(
+                  newEdenError(std::move(result).exception()));
+            }
+          })
+          .semi());
+
+  return std::move(serverStream);
+}
+
 folly::SemiFuture<std::unique_ptr<ScmStatus>>
 EdenServiceHandler::semifuture_getScmStatus(
     unique_ptr<string> mountPoint,
@@ -2785,13 +3913,24 @@ EdenServiceHandler::semifuture_getScmStatus(
   auto mountPath = absolutePathFromThrift(*mountPoint);
   auto mount = server_->getMount(mountPath);
   auto hash = mount->getObjectStore()->parseRootId(*commitHash);
+  auto config = server_->getServerState()->getEdenConfig();
   return wrapImmediateFuture(
              std::move(helper),
-             mount->diff(
-                 hash,
-                 context->getConnectionContext()->getCancellationToken(),
-                 listIgnored,
-                 /*enforceCurrentParent=*/false))
+             statusLimiter_.run(
+                 config->thriftMaxConcurrentStatus.getValue(),
+                 config->thriftMaxQueuedRequests.getValue(),
+                 ThriftRequestLimiter::Priority::High,
+                 [mount,
+                  hash = std::move(hash),
+                  cancellation =
+                      context->getConnectionContext()->getCancellationToken(),
+                  listIgnored] {
+                   return mount->diff(
+                       hash,
+                       cancellation,
+                       listIgnored,
+                       /*enforceCurrentParent=*/false);
+                 }))
       .semi();
 }
 
@@ -3394,6 +4533,99 @@ void EdenServiceHandler::stopRecordingBackingStoreFetch(
   }
 } // namespace eden
 
+namespace {
+
+AbsolutePath getPrefetchProfilePath(
+    AbsolutePathPiece edenDir,
+    const std::string& name) {
+  try {
+    return edenDir + "prefetch-profiles"_pc + PathComponentPiece{name};
+  } catch (const std::exception& ex) {
+    throw newEdenError(
+        EINVAL,
+        EdenErrorType::ARGUMENT_ERROR,
+        fmt::format("invalid prefetch profile name {}: {}", name, ex.what()));
+  }
+}
+
+} // namespace
+
+void EdenServiceHandler::savePrefetchProfile(
+    std::unique_ptr<SavePrefetchProfileParams> params) {
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG2, *params->name(), fmt::format("{} paths", params->paths()->size()));
+  auto path = getPrefetchProfilePath(server_->getEdenDir(), *params->name());
+
+  std::vector<RelativePath> paths;
+  paths.reserve(params->paths()->size());
+  for (const auto& profilePath : *params->paths()) {
+    paths.push_back(relpathFromUserPath(profilePath));
+  }
+  auto contents = serializePrefetchProfile(std::move(paths));
+  ensureDirectoryExists(path.dirname());
+  writeFileAtomic(path, folly::StringPiece{contents}).value();
+}
+
+folly::SemiFuture<std::unique_ptr<PrefetchProfileResult>>
+EdenServiceHandler::semifuture_prefetchProfile(
+    std::unique_ptr<PrefetchProfileParams> params) {
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG2,
+      *params->mountPoint(),
+      *params->name(),
+      fmt::format("background={}", *params->background()));
+  auto mount = server_->getMount(absolutePathFromThrift(*params->mountPoint()));
+  auto path = getPrefetchProfilePath(server_->getEdenDir(), *params->name());
+  auto contents = readFile(path);
+  if (contents.hasException()) {
+    throw newEdenError(contents.exception());
+  }
+  auto paths = parsePrefetchProfile(contents.value());
+  auto pathCount = paths.size();
+  auto batchSize = server_->getServerState()
+                       ->getEdenConfig()
+                       ->prefetchProfileBlobBatchSize.getValue();
+
+  // The trees and blobs are looked up as of the checked out commit, the
+  // local changes being either already materialized or not worth fetching.
+  const ObjectStore* objectStore = mount->getObjectStore();
+  auto& context = helper->getPrefetchFetchContext();
+  auto future =
+      resolvePrefetchProfile(
+          objectStore,
+          mount->getCheckedOutRootTree(),
+          std::move(paths),
+          context)
+          .thenValue([objectStore,
+                      batchSize,
+                      context = context.copy(),
+                      pathCount](PrefetchProfileResolution&& resolution) {
+            auto result = std::make_unique<PrefetchProfileResult>();
+            result->pathCount() = pathCount;
+            result->missingPathCount() = resolution.missingPaths;
+            result->blobCount() = resolution.blobIds.size();
+            return prefetchProfileBlobs(
+                       objectStore,
+                       std::move(resolution.blobIds),
+                       batchSize,
+                       context)
+                .thenValue(
+                    [result = std::move(result)](size_t fetched) mutable {
+                      result->fetchedBlobCount() = fetched;
+                      return std::move(result);
+                    });
+          })
+          .ensure([mount, helper = std::move(helper)] {});
+
+  if (*params->background()) {
+    folly::futures::detachOn(
+        server_->getServerState()->getThreadPool().get(),
+        std::move(future).semi());
+    return std::make_unique<PrefetchProfileResult>();
+  }
+  return std::move(future).semi();
+}
+
 void EdenServiceHandler::getAccessCounts(
     GetAccessCountsResult& result,
     int64_t duration) {
@@ -3422,14 +4654,75 @@ void EdenServiceHandler::getAccessCounts(
   }
 }
 
+void EdenServiceHandler::getTopProcessesByCost(
+    GetTopProcessesByCostResult& result,
+    std::unique_ptr<GetTopProcessesByCostRequest> request) {
+  auto helper = INSTRUMENT_THRIFT_CALL(
+      DBG3, *request->duration_ref(), *request->limit_ref());
+
+  auto seconds = std::chrono::seconds{*request->duration_ref()};
+  auto limit = static_cast<size_t>(std::max(0, *request->limit_ref()));
+
+  // Each mount returns its own top processes, so that only those are
+  // converted and merged.
+  auto& processes = *result.processes_ref();
+  for (auto& mount : server_->getMountPoints()) {
+    auto& pal = mount->getProcessAccessLog();
+    for (auto& [pid, accessCounts] :
+         pal.getTopAccessCountsByDuration(seconds, limit)) {
+      ProcessCost cost;
+      cost.pid_ref() = pid;
+      cost.mountPoint_ref() = mount->getPath().value();
+      cost.accessCounts_ref() = std::move(accessCounts);
+      processes.push_back(std::move(cost));
+    }
+  }
+
+  auto byDuration = [](const ProcessCost& a, const ProcessCost& b) {
+    return *a.accessCounts_ref()->fsChannelDurationNs_ref() >
+        *b.accessCounts_ref()->fsChannelDurationNs_ref();
+  };
+  std::sort(processes.begin(), processes.end(), byDuration);
+  if (processes.size() > limit) {
+    processes.resize(limit);
+  }
+
+  auto processNameCache = server_->getServerState()->getProcessNameCache();
+  for (auto& process : processes) {
+    if (auto cmd = processNameCache->getProcessName(*process.pid_ref())) {
+      process.cmd_ref() = std::move(*cmd);
+    }
+  }
+}
+
+void EdenServiceHandler::getSampledRequestStacks(
+    std::string& result,
+    bool reset) {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG3, reset);
+  auto& sampler = server_->getServerState()->getStats().getRequestSampler();
+  result = sampler.getFoldedStacks(reset);
+}
+
 void EdenServiceHandler::clearAndCompactLocalStore() {
   auto helper = INSTRUMENT_THRIFT_CALL(DBG1);
   server_->getLocalStore()->clearCachesAndCompactAll();
+  if (auto& persistentTreeCache = server_->getPersistentTreeCache()) {
+    persistentTreeCache->clear();
+  }
 }
 
 void EdenServiceHandler::debugClearLocalStoreCaches() {
   auto helper = INSTRUMENT_THRIFT_CALL(DBG1);
   server_->getLocalStore()->clearCaches();
+  if (auto& persistentTreeCache = server_->getPersistentTreeCache()) {
+    persistentTreeCache->clear();
+  }
+}
+
+void EdenServiceHandler::clearMemoryCaches() {
+  auto helper = INSTRUMENT_THRIFT_CALL(DBG1);
+  server_->getBlobCache()->clear();
+  server_->getTreeCache()->clear();
 }
 
 void EdenServiceHandler::debugCompactLocalStorage() {
@@ -3599,6 +4892,20 @@ void EdenServiceHandler::getStatInfo(
     result.blobCacheStats_ref()->evictionCount_ref() =
         blobCacheStats.evictionCount;
     result.blobCacheStats_ref()->dropCount_ref() = blobCacheStats.dropCount;
+    result.blobCacheStats_ref()->admissionRejectionCount_ref() =
+        blobCacheStats.admissionRejectionCount;
+    if (server_->getBlobCache()->hasCompressedTier()) {
+      const auto compressedStats =
+          server_->getBlobCache()->getCompressedTierStats();
+      auto& blobStats = *result.blobCacheStats_ref();
+      blobStats.compressedEntryCount_ref() = compressedStats.entryCount;
+      blobStats.compressedSizeInBytes_ref() =
+          compressedStats.compressedSizeInBytes;
+      blobStats.compressedHitCount_ref() = compressedStats.compressedHitCount;
+      blobStats.rawHitTimeNs_ref() = compressedStats.rawHitTime.count();
+      blobStats.compressedHitTimeNs_ref() =
+          compressedStats.compressedHitTime.count();
+    }
 
     const auto treeCacheStats = server_->getTreeCache()->getStats();
     result.treeCacheStats_ref() = CacheStats{};
@@ -3609,6 +4916,8 @@ void EdenServiceHandler::getStatInfo(
     result.treeCacheStats_ref()->missCount_ref() = treeCacheStats.missCount;
     result.treeCacheStats_ref()->evictionCount_ref() =
         treeCacheStats.evictionCount;
+    result.treeCacheStats_ref()->admissionRejectionCount_ref() =
+        treeCacheStats.admissionRejectionCount;
   }
 }
 
@@ -3757,13 +5066,12 @@ void EdenServiceHandler::getRetroactiveThriftRequestEvents(
   }
 
   std::vector<ThriftRequestEvent> thriftEvents;
-  auto bufferEvents = thriftRequestActivityBuffer_->getAllEvents();
-  thriftEvents.reserve(bufferEvents.size());
-  for (auto const& event : bufferEvents) {
-    ThriftRequestEvent thriftEvent;
-    convertThriftRequestTraceEventToThriftRequestEvent(event, thriftEvent);
-    thriftEvents.push_back(std::move(thriftEvent));
-  }
+  thriftRequestActivityBuffer_->forEachEvent(
+      [&](const ThriftRequestTraceEvent& event) {
+        ThriftRequestEvent thriftEvent;
+        convertThriftRequestTraceEventToThriftRequestEvent(event, thriftEvent);
+        thriftEvents.push_back(std::move(thriftEvent));
+      });
 
   result.events() = std::move(thriftEvents);
 }
@@ -3786,13 +5094,12 @@ void EdenServiceHandler::getRetroactiveHgEvents(
   }
 
   std::vector<HgEvent> thriftEvents;
-  auto bufferEvents = hgBackingStore->getActivityBuffer()->getAllEvents();
-  thriftEvents.reserve(bufferEvents.size());
-  for (auto const& event : bufferEvents) {
-    HgEvent thriftEvent{};
-    convertHgImportTraceEventToHgEvent(event, thriftEvent);
-    thriftEvents.push_back(std::move(thriftEvent));
-  }
+  hgBackingStore->getActivityBuffer()->forEachEvent(
+      [&](const HgImportTraceEvent& event) {
+        HgEvent thriftEvent{};
+        convertHgImportTraceEventToHgEvent(event, thriftEvent);
+        thriftEvents.push_back(std::move(thriftEvent));
+      });
 
   result.events() = std::move(thriftEvents);
 }
@@ -3812,14 +5119,13 @@ void EdenServiceHandler::getRetroactiveInodeEvents(
   }
 
   std::vector<InodeEvent> thriftEvents;
-  auto bufferEvents = edenMount->getActivityBuffer()->getAllEvents();
-  thriftEvents.reserve(bufferEvents.size());
-  for (auto const& event : bufferEvents) {
-    InodeEvent thriftEvent{};
-    ConvertInodeTraceEventToThriftInodeEvent(event, thriftEvent);
-    thriftEvent.path() = event.getPath();
-    thriftEvents.push_back(std::move(thriftEvent));
-  }
+  edenMount->getActivityBuffer()->forEachEvent(
+      [&](const InodeTraceEvent& event) {
+        InodeEvent thriftEvent{};
+        ConvertInodeTraceEventToThriftInodeEvent(event, thriftEvent);
+        thriftEvent.path() = event.getPath();
+        thriftEvents.push_back(std::move(thriftEvent));
+      });
 
   result.events() = std::move(thriftEvents);
 }
@@ -4011,4 +5317,14 @@ std::optional<pid_t> EdenServiceHandler::getAndRegisterClientPid() {
 #endif
 }
 
+folly::CancellationToken EdenServiceHandler::getRequestCancellationToken() {
+  // Like getAndRegisterClientPid, the request context is only available on
+  // the thread on which the thrift request originates.
+  auto requestContext = getRequestContext();
+  if (!requestContext) {
+    return {};
+  }
+  return requestContext->getConnectionContext()->getCancellationToken();
+}
+
 } // namespace facebook::eden
@@ -8,8 +8,10 @@
 #pragma once
 
 #include <fb303/BaseService.h>
+#include <folly/CancellationToken.h>
 #include <optional>
 #include "eden/fs/eden-config.h"
+#include "eden/fs/service/ThriftRequestLimiter.h"
 #include "eden/fs/service/gen-cpp2/StreamingEdenService.h"
 #include "eden/fs/telemetry/ActivityBuffer.h"
 #include "eden/fs/telemetry/TraceBus.h"
@@ -49,6 +51,16 @@ struct ThriftRequestTraceEvent : TraceEventBase {
   enum Type : unsigned char {
     START,
     FINISH,
+    /** Time spent in a subsystem on behalf of a request, ending now. */
+    SPAN,
+  };
+
+  enum SpanKind : unsigned char {
+    NO_SPAN,
+    DISK_CACHE_FETCH,
+    NETWORK_FETCH,
+    BACKING_STORE_REQUEST,
+    INODE_LOAD,
   };
 
   ThriftRequestTraceEvent() = delete;
@@ -63,21 +75,45 @@ struct ThriftRequestTraceEvent : TraceEventBase {
       folly::StringPiece method,
       std::optional<pid_t> clientPid);
 
+  static ThriftRequestTraceEvent span(
+      uint64_t requestId,
+      folly::StringPiece method,
+      std::optional<pid_t> clientPid,
+      SpanKind spanKind,
+      std::chrono::nanoseconds spanDuration);
+
   ThriftRequestTraceEvent(
       Type type,
       uint64_t requestId,
       folly::StringPiece method,
-      std::optional<pid_t> clientPid)
+      std::optional<pid_t> clientPid,
+      SpanKind spanKind = NO_SPAN,
+      std::chrono::nanoseconds spanDuration = {})
       : type(type),
+        spanKind(spanKind),
         requestId(requestId),
         method(method),
-        clientPid(clientPid) {}
+        clientPid(clientPid),
+        spanDuration(spanDuration) {}
 
   Type type;
+  // Only set on SPAN events.
+  SpanKind spanKind;
   uint64_t requestId;
   // Safe to use StringPiece because method names are string literals.
   folly::StringPiece method;
   std::optional<pid_t> clientPid;
+  std::chrono::nanoseconds spanDuration;
+};
+
+/**
+ * Stores the fields of ThriftRequestTraceEvents without padding. The method
+ * name is stored as is, since it refers to a string literal.
+ */
+template <>
+struct ActivityBufferCodec<ThriftRequestTraceEvent> {
+  static void encode(const ThriftRequestTraceEvent& event, std::string& out);
+  static ThriftRequestTraceEvent decode(folly::ByteRange in);
 };
 
 /*
@@ -133,19 +169,15 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       std::unique_ptr<std::string> mountPoint,
       std::unique_ptr<std::string> repoPath) override;
 
-  folly::SemiFuture<std::unique_ptr<std::vector<SHA1Result>>>
-  semifuture_getSHA1(
+  void async_eb_getSHA1(
+      apache::thrift::HandlerCallback<
+          std::unique_ptr<std::vector<SHA1Result>>>::Ptr callback,
       std::unique_ptr<std::string> mountPoint,
       std::unique_ptr<std::vector<std::string>> paths,
       std::unique_ptr<SyncBehavior> sync) override;
 
-  // the caller should ensure the relativePath is valid until the returned
-  // futures complete.
-  ImmediateFuture<EntryAttributes> getEntryAttributesForPath(
-      EntryAttributeFlags reqBitmask,
-      AbsolutePathPiece mountPoint,
-      folly::StringPiece path,
-      const ObjectFetchContextPtr& fetchContext);
+  // the caller should ensure the paths are valid until the returned future
+  // completes.
   ImmediateFuture<std::vector<folly::Try<EntryAttributes>>> getEntryAttributes(
       AbsolutePathPiece mountPath,
       std::vector<std::string>& paths,
@@ -153,8 +185,9 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       SyncBehavior sync,
       const ObjectFetchContextPtr& fetchContext);
 
-  void getCurrentJournalPosition(
-      JournalPosition& out,
+  void async_eb_getCurrentJournalPosition(
+      apache::thrift::HandlerCallback<std::unique_ptr<JournalPosition>>::Ptr
+          callback,
       std::unique_ptr<std::string> mountPoint) override;
 
   void getFilesChangedSince(
@@ -162,6 +195,10 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
       std::unique_ptr<std::string> mountPoint,
       std::unique_ptr<JournalPosition> fromPosition) override;
 
+  folly::SemiFuture<std::unique_ptr<GetChangesSinceResult>>
+  semifuture_getChangesSince(
+      std::unique_ptr<GetChangesSinceParams> params) override;
+
   void setJournalMemoryLimit(
       std::unique_ptr<PathString> mountPoint,
       int64_t limit) override;
@@ -235,6 +272,15 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   apache::thrift::ResponseAndServerStream<ChangesSinceResult, ChangedFileResult>
   streamChangesSince(std::unique_ptr<StreamChangesSinceParams> params) override;
 
+  apache::thrift::ServerStream<Glob> streamGlobFiles(
+      std::unique_ptr<GlobParams> params) override;
+
+  apache::thrift::ServerStream<ScmStatusStreamItem> streamScmStatus(
+      std::unique_ptr<GetScmStatusParams> params) override;
+
+  apache::thrift::ServerStream<BlobChunk> streamBlobs(
+      std::unique_ptr<StreamBlobsParams> params) override;
+
   folly::SemiFuture<std::unique_ptr<ScmStatus>> semifuture_getScmStatus(
       std::unique_ptr<std::string> mountPoint,
       bool listIgnored,
@@ -316,10 +362,16 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   void getAccessCounts(GetAccessCountsResult& result, int64_t duration)
       override;
 
+  void getTopProcessesByCost(
+      GetTopProcessesByCostResult& result,
+      std::unique_ptr<GetTopProcessesByCostRequest> request) override;
+
   void clearAndCompactLocalStore() override;
 
   void debugClearLocalStoreCaches() override;
 
+  void clearMemoryCaches() override;
+
   void debugCompactLocalStorage() override;
 
   int64_t debugDropAllPendingRequests() override;
@@ -405,6 +457,15 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
    */
   void stopRecordingBackingStoreFetch(GetFetchedFilesResult& results) override;
 
+  void savePrefetchProfile(
+      std::unique_ptr<SavePrefetchProfileParams> params) override;
+
+  folly::SemiFuture<std::unique_ptr<PrefetchProfileResult>>
+  semifuture_prefetchProfile(
+      std::unique_ptr<PrefetchProfileParams> params) override;
+
+  void getSampledRequestStacks(std::string& result, bool reset) override;
+
   /**
    * Returns the pid that caused the Thrift request running on the calling
    * Thrift worker thread and registers it with the ProcessNameCache.
@@ -414,6 +475,15 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
    */
   std::optional<pid_t> getAndRegisterClientPid();
 
+  /**
+   * Returns a token cancelled when the client of the Thrift request running on
+   * the calling Thrift worker thread disconnects.
+   *
+   * As with getAndRegisterClientPid, this must be run from a Thrift worker
+   * thread.
+   */
+  folly::CancellationToken getRequestCancellationToken();
+
  private:
   std::shared_ptr<EdenMount> lookupMount(MountId& mountId);
 
@@ -443,5 +513,11 @@ class EdenServiceHandler : virtual public StreamingEdenServiceSvIf,
   std::shared_ptr<ThriftRequestTraceHandle> thriftRequestTraceHandle_;
 
   std::shared_ptr<TraceBus<ThriftRequestTraceEvent>> thriftRequestTraceBus_;
+
+  // Bound the concurrent requests of the expensive methods, so that they
+  // don't starve the cheap ones.
+  ThriftRequestLimiter globLimiter_;
+  ThriftRequestLimiter statusLimiter_;
+  ThriftRequestLimiter checkoutLimiter_;
 };
 } // namespace facebook::eden
@@ -8,6 +8,7 @@
 #include "eden/fs/service/ThriftGetObjectImpl.h"
 
 #include "folly/Try.h"
+#include "folly/io/Cursor.h"
 
 #include "eden/fs/inodes/EdenMount.h"
 #include "eden/fs/model/Blob.h"
@@ -80,4 +81,43 @@ ScmBlobWithOrigin getBlobFromOrigin(
       origin);
 }
 
+void publishBlobChunks(
+    const ObjectId& id,
+    size_t index,
+    const folly::Try<std::shared_ptr<const Blob>>& blob,
+    size_t chunkSize,
+    folly::FunctionRef<void(BlobChunk&&)> publish) {
+  auto makeChunk = [index](size_t offset, size_t totalSize) {
+    BlobChunk chunk;
+    chunk.index() = index;
+    chunk.offset() = offset;
+    chunk.totalSize() = totalSize;
+    return chunk;
+  };
+  if (blob.hasException() || !blob.value()) {
+    auto chunk = makeChunk(0, 0);
+    chunk.error() = blob.hasException() ? newEdenError(blob.exception())
+                                        : newEdenError(
+                                              ENOENT,
+                                              EdenErrorType::POSIX_ERROR,
+                                              "no blob found for id ",
+                                              id.toLogString());
+    publish(std::move(chunk));
+    return;
+  }
+
+  const auto& contents = blob.value()->getContents();
+  auto totalSize = contents.computeChainDataLength();
+  chunkSize = std::max<size_t>(chunkSize, 1);
+  folly::io::Cursor cursor{&contents};
+  size_t offset = 0;
+  do {
+    auto size = std::min(chunkSize, totalSize - offset);
+    auto chunk = makeChunk(offset, totalSize);
+    chunk.data() = cursor.readFixedString(size);
+    publish(std::move(chunk));
+    offset += size;
+  } while (offset < totalSize);
+}
+
 } // namespace facebook::eden
@@ -7,9 +7,12 @@
 
 #pragma once
 
+#include <folly/Function.h>
+
 #include "eden/common/utils/OptionSet.h"
 
 #include "eden/fs/service/gen-cpp2/eden_types.h"
+#include "eden/fs/service/gen-cpp2/streamingeden_types.h"
 
 namespace folly {
 template <typename T>
@@ -65,4 +68,16 @@ ScmBlobWithOrigin getBlobFromOrigin(
     ObjectId id,
     folly::Try<std::shared_ptr<Blob>> blobFuture,
     DataFetchOrigin origin);
+
+/**
+ * Calls `publish` with the chunks of at most `chunkSize` bytes of the blob
+ * ids[index] of a streamBlobs request, in order, or with a single chunk
+ * holding the error fetching it. An empty blob gets a single empty chunk.
+ */
+void publishBlobChunks(
+    const ObjectId& id,
+    size_t index,
+    const folly::Try<std::shared_ptr<const Blob>>& blob,
+    size_t chunkSize,
+    folly::FunctionRef<void(BlobChunk&&)> publish);
 } // namespace facebook::eden
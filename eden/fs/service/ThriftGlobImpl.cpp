@@ -18,11 +18,172 @@
 #include "eden/fs/service/gen-cpp2/eden_types.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/PathLoader.h"
+#include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/utils/EdenError.h"
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
 
 namespace facebook::eden {
 
+namespace {
+
+void forwardResults(
+    std::vector<GlobNode::GlobResult>&& results,
+    GlobNode::ResultSink* sink,
+    GlobNode::ResultList& globResults) {
+  if (sink) {
+    sink->addResults(std::move(results));
+    return;
+  }
+  auto lockedResults = globResults.wlock();
+  lockedResults->insert(
+      lockedResults->end(),
+      std::make_move_iterator(results.begin()),
+      std::make_move_iterator(results.end()));
+}
+
+void appendCachedResults(
+    const GlobResultCache::Results& cached,
+    GlobNode::ResultSink* sink,
+    GlobNode::ResultList& globResults,
+    GlobNode::PrefetchList* fileBlobsToPrefetch,
+    const RootId& originRootId) {
+  std::vector<GlobNode::GlobResult> results;
+  results.reserve(cached.matches.size());
+  for (const auto& match : cached.matches) {
+    results.emplace_back(match.name.copy(), match.dtype, originRootId);
+  }
+  forwardResults(std::move(results), sink, globResults);
+  if (fileBlobsToPrefetch) {
+    auto blobs = fileBlobsToPrefetch->wlock();
+    blobs->insert(
+        blobs->end(),
+        cached.blobsToPrefetch.begin(),
+        cached.blobsToPrefetch.end());
+  }
+}
+
+/**
+ * Keeps a copy of the matches of a tree for the glob result cache, while
+ * passing them on to the sink or the result list of the request.
+ */
+class CachingSink : public GlobNode::ResultSink {
+ public:
+  CachingSink(GlobNode::ResultSink* sink, GlobNode::ResultList& globResults)
+      : sink_{sink}, globResults_{globResults} {}
+
+  void addResults(std::vector<GlobNode::GlobResult>&& results) override {
+    {
+      auto matches = matches_.wlock();
+      for (const auto& result : results) {
+        matches->push_back(
+            GlobResultCache::Match{result.name.copy(), result.dtype});
+      }
+    }
+    forwardResults(std::move(results), sink_, globResults_);
+  }
+
+  std::vector<GlobResultCache::Match> takeMatches() {
+    return std::move(*matches_.wlock());
+  }
+
+ private:
+  GlobNode::ResultSink* const sink_;
+  GlobNode::ResultList& globResults_;
+  folly::Synchronized<std::vector<GlobResultCache::Match>> matches_;
+};
+
+/**
+ * Evaluate globRoot against a source control tree, or answer from the glob
+ * result cache when the same globs were evaluated against the same tree.
+ */
+ImmediateFuture<folly::Unit> evaluateCachedTree(
+    const std::shared_ptr<EdenMount>& edenMount,
+    const std::shared_ptr<ServerState>& serverState,
+    const GlobNode& globRoot,
+    std::string cacheKey,
+    const ObjectFetchContextPtr& fetchContext,
+    std::shared_ptr<const Tree> tree,
+    GlobNode::PrefetchList* fileBlobsToPrefetch,
+    GlobNode::ResultList& globResults,
+    const RootId& originRootId,
+    GlobNode::FanOut* fanOut,
+    GlobNode::ResultSink* sink) {
+  auto& cache = serverState->getGlobResultCache();
+  if (auto cached = cache.get(cacheKey)) {
+    serverState->getStats().increment(&ThriftStats::globResultCacheHit);
+    appendCachedResults(
+        *cached, sink, globResults, fileBlobsToPrefetch, originRootId);
+    return folly::unit;
+  }
+  serverState->getStats().increment(&ThriftStats::globResultCacheMiss);
+
+  // Record the matches and blobs of this tree on their own, so that only
+  // they are cached.
+  auto cachingSink = std::make_shared<CachingSink>(sink, globResults);
+  auto treeBlobs = fileBlobsToPrefetch
+      ? std::make_shared<GlobNode::PrefetchList>()
+      : nullptr;
+  return globRoot
+      .evaluate(
+          edenMount->getObjectStore(),
+          fetchContext,
+          RelativePathPiece(),
+          std::move(tree),
+          treeBlobs.get(),
+          globResults,
+          originRootId,
+          fanOut,
+          cachingSink.get())
+      .thenValue([serverState,
+                  cacheKey = std::move(cacheKey),
+                  cachingSink,
+                  treeBlobs,
+                  fileBlobsToPrefetch](folly::Unit) mutable {
+        auto cached = std::make_shared<GlobResultCache::Results>();
+        cached->matches = cachingSink->takeMatches();
+        if (treeBlobs) {
+          cached->blobsToPrefetch = std::move(*treeBlobs->wlock());
+          auto blobs = fileBlobsToPrefetch->wlock();
+          blobs->insert(
+              blobs->end(),
+              cached->blobsToPrefetch.begin(),
+              cached->blobsToPrefetch.end());
+        }
+
+        auto config = serverState->getEdenConfig();
+        if (cached->matches.size() <=
+            config->globResultCacheMaxMatches.getValue()) {
+          serverState->getGlobResultCache().insert(
+              std::move(cacheKey),
+              std::move(cached),
+              config->globResultCacheSize.getValue());
+        }
+        return folly::unit;
+      });
+}
+
+} // namespace
+
+void ThriftGlobImpl::appendResults(
+    Glob& out,
+    const std::vector<GlobNode::GlobResult>& results,
+    const ObjectStore& objectStore,
+    bool listOnlyFiles,
+    bool wantDtype) {
+  for (auto& entry : results) {
+    if (!listOnlyFiles || entry.dtype != dtype_t::Dir) {
+      out.matchingFiles_ref()->emplace_back(entry.name.asString());
+
+      if (wantDtype) {
+        out.dtypes_ref()->emplace_back(static_cast<OsDtype>(entry.dtype));
+      }
+
+      out.originHashes_ref()->emplace_back(
+          objectStore.renderRootId(*entry.originHash));
+    }
+  }
+}
+
 ThriftGlobImpl::ThriftGlobImpl(const GlobParams& params)
     : includeDotfiles_{*params.includeDotfiles_ref()},
       prefetchFiles_{*params.prefetchFiles_ref()},
@@ -42,13 +203,14 @@ ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::glob(
     std::shared_ptr<EdenMount> edenMount,
     std::shared_ptr<ServerState> serverState,
     std::vector<std::string> globs,
-    const ObjectFetchContextPtr& fetchContext) {
+    const ObjectFetchContextPtr& fetchContext,
+    GlobNode::ResultSink* sink) {
   // Compile the list of globs into a tree
-  auto globRoot = std::make_shared<GlobNode>(
-      includeDotfiles_,
+  auto caseSensitive =
       serverState->getEdenConfig()->globUseMountCaseSensitivity.getValue()
-          ? edenMount->getCheckoutConfig()->getCaseSensitive()
-          : CaseSensitivity::Sensitive);
+      ? edenMount->getCheckoutConfig()->getCaseSensitive()
+      : CaseSensitivity::Sensitive;
+  auto globRoot = std::make_shared<GlobNode>(includeDotfiles_, caseSensitive);
   try {
     for (auto& globString : globs) {
       try {
@@ -69,6 +231,24 @@ ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::glob(
   auto fileBlobsToPrefetch =
       prefetchFiles_ ? std::make_shared<GlobNode::PrefetchList>() : nullptr;
 
+  // The directories are evaluated concurrently, so the order of globResults
+  // is only made deterministic by the sort below.
+  auto fanOut = std::make_shared<GlobNode::FanOut>(
+      edenMount->getServerThreadPool().get(),
+      serverState->getEdenConfig()->globParallelism.getValue());
+
+  // The results of globs over trees without local changes are cached, by
+  // the id of the tree they were evaluated against.
+  auto useResultCache =
+      serverState->getEdenConfig()->globResultCacheSize.getValue() > 0;
+  auto makeCacheKey = [globs = std::move(globs),
+                       includeDotfiles = includeDotfiles_,
+                       prefetchFiles = prefetchFiles_,
+                       caseSensitive](const ObjectId& treeId) {
+    return GlobResultCache::makeKey(
+        treeId, globs, includeDotfiles, prefetchFiles, caseSensitive);
+  };
+
   // These hashes must outlive the GlobResult created by evaluate as the
   // GlobResults will hold on to references to these hashes
   auto originRootIds = std::make_unique<std::vector<RootId>>();
@@ -107,11 +287,32 @@ ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::glob(
               })
               .thenValue(
                   [edenMount,
+                   serverState,
                    globRoot,
                    fetchContext = fetchContext.copy(),
                    fileBlobsToPrefetch,
                    globResults,
-                   &originRootId](std::shared_ptr<const Tree>&& tree) mutable {
+                   fanOut,
+                   sink,
+                   useResultCache,
+                   makeCacheKey,
+                   &originRootId](std::shared_ptr<const Tree>&& tree) mutable
+                  -> ImmediateFuture<folly::Unit> {
+                    if (useResultCache) {
+                      auto cacheKey = makeCacheKey(tree->getHash());
+                      return evaluateCachedTree(
+                          edenMount,
+                          serverState,
+                          *globRoot,
+                          std::move(cacheKey),
+                          fetchContext,
+                          std::move(tree),
+                          fileBlobsToPrefetch.get(),
+                          *globResults,
+                          originRootId,
+                          fanOut.get(),
+                          sink);
+                    }
                     return globRoot->evaluate(
                         edenMount->getObjectStore(),
                         fetchContext,
@@ -119,7 +320,9 @@ ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::glob(
                         std::move(tree),
                         fileBlobsToPrefetch.get(),
                         *globResults,
-                        originRootId);
+                        originRootId,
+                        fanOut.get(),
+                        sink);
                   }));
     }
   } else {
@@ -130,17 +333,59 @@ ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::glob(
             .thenValue([fetchContext = fetchContext.copy(),
                         globRoot,
                         edenMount,
+                        serverState,
                         fileBlobsToPrefetch,
                         globResults,
-                        &originRootId](InodePtr inode) mutable {
+                        fanOut,
+                        sink,
+                        useResultCache,
+                        makeCacheKey = std::move(makeCacheKey),
+                        &originRootId](InodePtr inode) mutable
+                       -> ImmediateFuture<folly::Unit> {
+              auto tree = inode.asTreePtr();
+              // Without local changes below the search root, the glob only
+              // depends on its source control tree.
+              auto treeHash = useResultCache
+                  ? tree->getContents().rlock()->treeHash
+                  : std::nullopt;
+              if (treeHash) {
+                return edenMount->getObjectStore()
+                    ->getTree(*treeHash, fetchContext)
+                    .thenValue([edenMount,
+                                serverState,
+                                globRoot,
+                                fetchContext = fetchContext.copy(),
+                                fileBlobsToPrefetch,
+                                globResults,
+                                fanOut,
+                                sink,
+                                cacheKey = makeCacheKey(*treeHash),
+                                &originRootId](
+                                   std::shared_ptr<const Tree> sourceTree) {
+                      return evaluateCachedTree(
+                          edenMount,
+                          serverState,
+                          *globRoot,
+                          std::move(cacheKey),
+                          fetchContext,
+                          std::move(sourceTree),
+                          fileBlobsToPrefetch.get(),
+                          *globResults,
+                          originRootId,
+                          fanOut.get(),
+                          sink);
+                    });
+              }
               return globRoot->evaluate(
                   edenMount->getObjectStore(),
                   fetchContext,
                   RelativePathPiece(),
-                  inode.asTreePtr(),
+                  std::move(tree),
                   fileBlobsToPrefetch.get(),
                   *globResults,
-                  originRootId);
+                  originRootId,
+                  fanOut.get(),
+                  sink);
             }));
   }
 
@@ -195,24 +440,15 @@ ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::glob(
 
                 if (!suppressFileList) {
                   // already deduplicated at this point, no need to de-dup
-                  for (auto& entry : results) {
-                    if (!listOnlyFiles || entry.dtype != dtype_t::Dir) {
-                      out->matchingFiles_ref()->emplace_back(
-                          entry.name.asString());
-
-                      if (wantDtype) {
-                        out->dtypes_ref()->emplace_back(
-                            static_cast<OsDtype>(entry.dtype));
-                      }
-
-                      out->originHashes_ref()->emplace_back(
-                          edenMount->getObjectStore()->renderRootId(
-                              *entry.originHash));
-                    }
-                  }
+                  appendResults(
+                      *out,
+                      results,
+                      *edenMount->getObjectStore(),
+                      listOnlyFiles,
+                      wantDtype);
                 }
                 if (fileBlobsToPrefetch) {
-                  std::vector<ImmediateFuture<folly::Unit>> futures;
+                  std::vector<ImmediateFuture<size_t>> futures;
 
                   auto store = edenMount->getObjectStore();
                   auto blobs = fileBlobsToPrefetch->rlock();
@@ -230,15 +466,29 @@ ImmediateFuture<std::unique_ptr<Glob>> ThriftGlobImpl::glob(
                   }
 
                   return collectAll(std::move(futures))
-                      .thenValue([glob = std::move(out),
-                                  fileBlobsToPrefetch](auto&&) mutable {
+                      .thenValue([glob = std::move(out), fileBlobsToPrefetch](
+                                     std::vector<folly::Try<size_t>>&&
+                                         fetched) mutable {
+                        size_t fetchedCount = 0;
+                        for (const auto& count : fetched) {
+                          if (count.hasValue()) {
+                            fetchedCount += count.value();
+                          }
+                        }
+                        XLOGF(
+                            DBG3,
+                            "glob prefetch fetched {} of {} blobs remotely",
+                            fetchedCount,
+                            fileBlobsToPrefetch->rlock()->size());
                         return std::move(glob);
                       });
                 }
                 return std::move(out);
               })
-          .ensure([globRoot, originRootIds = std::move(originRootIds)]() {
-            // keep globRoot and originRootIds alive until the end
+          .ensure([globRoot,
+                   fanOut,
+                   originRootIds = std::move(originRootIds)]() {
+            // keep globRoot, fanOut and originRootIds alive until the end
           });
 
   return prefetchFuture;
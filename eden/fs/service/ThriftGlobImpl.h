@@ -12,6 +12,7 @@
 #include <vector>
 
 #include <folly/Range.h>
+#include "eden/fs/inodes/GlobNode.h"
 #include "eden/fs/utils/ImmediateFuture.h"
 #include "eden/fs/utils/RefPtr.h"
 
@@ -23,6 +24,7 @@ class Glob;
 class GlobParams;
 class PrefetchParams;
 class ObjectFetchContext;
+class ObjectStore;
 using ObjectFetchContextPtr = RefPtr<ObjectFetchContext>;
 
 class ThriftGlobImpl {
@@ -30,11 +32,38 @@ class ThriftGlobImpl {
   explicit ThriftGlobImpl(const GlobParams& params);
   explicit ThriftGlobImpl(const PrefetchParams& params);
 
+  /**
+   * Evaluate the globs against the working copy or the requested revisions.
+   *
+   * When sink is non-null, the matches are handed to it as the directories
+   * are evaluated, unsorted and not deduplicated, and the returned Glob has
+   * no files. The sink must outlive the returned ImmediateFuture.
+   */
   ImmediateFuture<std::unique_ptr<Glob>> glob(
       std::shared_ptr<EdenMount> edenMount,
       std::shared_ptr<ServerState> serverState,
       std::vector<std::string> globs,
-      const ObjectFetchContextPtr& fetchContext);
+      const ObjectFetchContextPtr& fetchContext,
+      GlobNode::ResultSink* sink = nullptr);
+
+  /**
+   * Append results to the file list of out, keeping directories unless
+   * listOnlyFiles and the dtypes when wantDtype.
+   */
+  static void appendResults(
+      Glob& out,
+      const std::vector<GlobNode::GlobResult>& results,
+      const ObjectStore& objectStore,
+      bool listOnlyFiles,
+      bool wantDtype);
+
+  bool listOnlyFiles() const {
+    return listOnlyFiles_;
+  }
+
+  bool wantDtype() const {
+    return wantDtype_;
+  }
 
   std::string logString();
   std::string logString(const std::vector<std::string>& globs) const;
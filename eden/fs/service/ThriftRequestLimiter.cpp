@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/ThriftRequestLimiter.h"
+
+#include <deque>
+#include <mutex>
+#include <optional>
+
+#include <fmt/format.h>
+#include <folly/Synchronized.h>
+#include <folly/futures/Promise.h>
+#include <folly/stop_watch.h>
+
+#include "eden/fs/utils/EdenError.h"
+
+namespace facebook::eden {
+
+struct ThriftRequestLimiter::State {
+  struct Data {
+    size_t running{0};
+    std::deque<folly::Promise<Permit>> high;
+    std::deque<folly::Promise<Permit>> low;
+
+    size_t queued() const {
+      return high.size() + low.size();
+    }
+  };
+
+  folly::Synchronized<Data, std::mutex> data;
+};
+
+ThriftRequestLimiter::Permit::~Permit() {
+  if (!state_) {
+    return;
+  }
+  std::optional<folly::Promise<Permit>> next;
+  {
+    auto data = state_->data.lock();
+    auto& queue = !data->high.empty() ? data->high : data->low;
+    if (queue.empty()) {
+      --data->running;
+    } else {
+      // The slot is handed over to the next request as is.
+      next = std::move(queue.front());
+      queue.pop_front();
+    }
+  }
+  if (next) {
+    next->setValue(Permit{std::move(state_)});
+  }
+}
+
+ThriftRequestLimiter::ThriftRequestLimiter(
+    std::string name,
+    std::shared_ptr<EdenStats> stats,
+    ThriftStats::DurationPtr queueTime,
+    ThriftStats::CounterPtr rejected)
+    : name_{std::move(name)},
+      stats_{std::move(stats)},
+      queueTime_{queueTime},
+      rejected_{rejected},
+      state_{std::make_shared<State>()} {}
+
+ImmediateFuture<ThriftRequestLimiter::Permit> ThriftRequestLimiter::acquire(
+    size_t maxConcurrent,
+    size_t maxQueued,
+    Priority priority) {
+  folly::SemiFuture<Permit> future = folly::SemiFuture<Permit>::makeEmpty();
+  {
+    auto data = state_->data.lock();
+    if (maxConcurrent == 0 || data->running < maxConcurrent) {
+      ++data->running;
+      data.unlock();
+      stats_->addDuration(queueTime_, std::chrono::microseconds{0});
+      return Permit{state_};
+    }
+    if (data->queued() >= maxQueued) {
+      data.unlock();
+      stats_->increment(rejected_);
+      return makeImmediateFuture<Permit>(newEdenError(
+          EBUSY,
+          EdenErrorType::POSIX_ERROR,
+          fmt::format(
+              "too many {} requests: {} are running and {} are waiting",
+              name_,
+              maxConcurrent,
+              maxQueued)));
+    }
+    auto& queue = priority == Priority::High ? data->high : data->low;
+    queue.emplace_back();
+    future = queue.back().getSemiFuture();
+  }
+
+  folly::stop_watch<std::chrono::microseconds> watch;
+  return ImmediateFuture<Permit>{std::move(future).deferValue(
+      [stats = stats_, queueTime = queueTime_, watch](Permit&& permit) {
+        stats->addDuration(queueTime, watch.elapsed());
+        return std::move(permit);
+      })};
+}
+
+size_t ThriftRequestLimiter::getRunningCount() const {
+  return state_->data.lock()->running;
+}
+
+size_t ThriftRequestLimiter::getQueuedCount() const {
+  return state_->data.lock()->queued();
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+
+namespace facebook::eden {
+
+/**
+ * Bounds the number of concurrent requests of an expensive Thrift method, so
+ * that a burst of them doesn't starve the cheap ones of the threads they
+ * share.
+ *
+ * Requests beyond the limit wait for a running one to complete. High priority
+ * requests are admitted first, then the low priority ones, each in the order
+ * they arrived. Requests are rejected with EBUSY once too many of them are
+ * waiting.
+ *
+ * The limits are passed on each request so that config changes apply without
+ * a restart. A limit of 0 lets every request run.
+ */
+class ThriftRequestLimiter {
+  struct State;
+
+ public:
+  enum class Priority { High, Low };
+
+  /**
+   * Held while a request runs. Destroying it admits the next waiting request.
+   */
+  class Permit {
+   public:
+    Permit(Permit&&) noexcept = default;
+    Permit& operator=(Permit&&) = delete;
+    ~Permit();
+
+   private:
+    friend class ThriftRequestLimiter;
+    explicit Permit(std::shared_ptr<State> state) : state_{std::move(state)} {}
+
+    std::shared_ptr<State> state_;
+  };
+
+  /**
+   * name is used in the errors. The time each request waited and the
+   * rejected requests are recorded in queueTime and rejected.
+   */
+  ThriftRequestLimiter(
+      std::string name,
+      std::shared_ptr<EdenStats> stats,
+      ThriftStats::DurationPtr queueTime,
+      ThriftStats::CounterPtr rejected);
+
+  /**
+   * Run fn, which returns an ImmediateFuture, once fewer than maxConcurrent
+   * requests are running. The permit is held until its future completes.
+   */
+  template <typename Fn>
+  auto run(size_t maxConcurrent, size_t maxQueued, Priority priority, Fn&& fn) {
+    return acquire(maxConcurrent, maxQueued, priority)
+        .thenValue([fn = std::forward<Fn>(fn)](Permit&& permit) mutable {
+          return fn().ensure([permit = std::move(permit)] {});
+        });
+  }
+
+  ImmediateFuture<Permit>
+  acquire(size_t maxConcurrent, size_t maxQueued, Priority priority);
+
+  /** The number of running and waiting requests. */
+  size_t getRunningCount() const;
+  size_t getQueuedCount() const;
+
+ private:
+  const std::string name_;
+  const std::shared_ptr<EdenStats> stats_;
+  const ThriftStats::DurationPtr queueTime_;
+  const ThriftStats::CounterPtr rejected_;
+  // Shared with the permits, which can outlive the limiter.
+  const std::shared_ptr<State> state_;
+};
+
+} // namespace facebook::eden
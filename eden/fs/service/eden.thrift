@@ -505,6 +505,59 @@ struct FileDelta {
   7: list<ThriftRootId> snapshotTransitions;
 }
 
+/** Params for getChangesSince(). */
+struct GetChangesSinceParams {
+  1: PathString mountPoint;
+  2: JournalPosition fromPosition;
+  /**
+   * Bitmask of FileAttributes to return for each changed path that still
+   * exists. Only SHA1_HASH and FILE_SIZE are meaningful, the dtype is always
+   * returned.
+   */
+  3: unsigned64 requestedAttributes;
+  4: SyncBehavior sync;
+}
+
+/**
+ * A path that changed between two journal positions, and its state at the
+ * time getChangesSince() was called.
+ */
+struct ChangedPath {
+  1: PathString path;
+  /**
+   * ADDED if the path didn't exist at fromPosition, REMOVED if it no longer
+   * exists, and MODIFIED otherwise. A path both created and removed in the
+   * range isn't returned.
+   */
+  2: ScmFileStatus status;
+  /** UNKNOWN if the path was removed or couldn't be looked up. */
+  3: Dtype dtype;
+  /** Set if requested and the path is a file. */
+  4: optional i64 size;
+  /** Set if requested and the path is a regular file. */
+  5: optional BinaryHash sha1;
+  /** Set if the path exists but looking it up failed. */
+  6: optional EdenError error;
+}
+
+/**
+ * Returned by getChangesSince(). Unlike FileDelta, each changed path is
+ * listed once.
+ */
+struct GetChangesSinceResult {
+  1: JournalPosition fromPosition;
+  2: JournalPosition toPosition;
+  /**
+   * The paths changed in the overlay between fromPosition and toPosition,
+   * and the paths that were modified in the working copy across a checkout.
+   * As in FileDelta, files only changed by the checkout itself are not
+   * listed: clients should diff the snapshotTransitions for those.
+   */
+  3: list<ChangedPath> changes;
+  /** Same as FileDelta.snapshotTransitions. */
+  4: list<ThriftRootId> snapshotTransitions;
+}
+
 struct DebugGetRawJournalParams {
   1: PathString mountPoint;
   2: optional i32 limit;
@@ -720,6 +773,34 @@ struct GetFetchedFilesResult {
   1: map<string, set<PathString>> fetchedFilePaths;
 }
 
+/** Params for savePrefetchProfile(). */
+struct SavePrefetchProfileParams {
+  // The name of the profile, a single path component.
+  1: string name;
+  // The repository paths of the files to prefetch, as recorded by
+  // stopRecordingBackingStoreFetch() for instance.
+  2: list<PathString> paths;
+}
+
+/** Params for prefetchProfile(). */
+struct PrefetchProfileParams {
+  1: PathString mountPoint;
+  2: string name;
+  // If set, will run the prefetch but will not wait for the result.
+  3: bool background = false;
+}
+
+struct PrefetchProfileResult {
+  // The number of paths of the profile, and those that aren't files of the
+  // checked out commit.
+  1: i64 pathCount;
+  2: i64 missingPathCount;
+  // The number of files prefetched, and those that had to be fetched
+  // remotely.
+  3: i64 blobCount;
+  4: i64 fetchedBlobCount;
+}
+
 struct WorkingDirectoryParents {
   1: ThriftRootId parent1;
   // This field is never used by EdenFS.
@@ -820,6 +901,14 @@ struct CacheStats {
   4: i64 missCount;
   5: i64 evictionCount;
   6: i64 dropCount;
+  7: i64 admissionRejectionCount;
+  // Only set for the blob cache when its compressed tier is enabled.
+  8: optional i64 compressedEntryCount;
+  9: optional i64 compressedSizeInBytes;
+  10: optional i64 compressedHitCount;
+  // Total time spent in lookups that hit, by tier.
+  11: optional i64 rawHitTimeNs;
+  12: optional i64 compressedHitTimeNs;
 }
 
 /*
@@ -907,12 +996,38 @@ enum ThriftRequestEventType {
   UNKNOWN = 0,
   START = 1,
   FINISH = 2,
+  SPAN = 3,
+}
+
+/** The subsystem a Thrift request spent the time of a SPAN event in. */
+enum ThriftRequestSpanKind {
+  UNKNOWN = 0,
+  // Objects read from the local store.
+  DISK_CACHE_FETCH = 1,
+  // Objects fetched from the backing store.
+  NETWORK_FETCH = 2,
+  // A backing store request, from being queued to being imported.
+  BACKING_STORE_REQUEST = 3,
+  // A directory inode load, including fetching its tree.
+  INODE_LOAD = 4,
+}
+
+/**
+ * Time spent by a request in a subsystem. The span ends at the time of its
+ * event. Spans of the same request may overlap.
+ */
+struct ThriftRequestSpan {
+  1: ThriftRequestSpanKind kind;
+  2: i64 durationNs;
 }
 
 struct ThriftRequestEvent {
   1: TraceEventTimes times;
   2: ThriftRequestEventType eventType;
   3: ThriftRequestMetadata requestMetadata;
+  /** Set on SPAN events, which traceThriftRequestEvents streams between the
+   * START and FINISH events of their request. */
+  4: optional ThriftRequestSpan span;
 }
 
 /**
@@ -955,6 +1070,15 @@ enum HgImportCause {
   PREFETCH = 3,
 }
 
+enum HgImportFetchedSource {
+  UNKNOWN = 0,
+  // The hg cache.
+  LOCAL = 1,
+  // A remote fetch through the native backing store.
+  REMOTE = 2,
+  HG_IMPORTER = 3,
+}
+
 struct HgEvent {
   1: TraceEventTimes times;
 
@@ -970,6 +1094,8 @@ struct HgEvent {
   7: optional RequestInfo requestInfo;
   8: HgImportPriority importPriority;
   9: HgImportCause importCause;
+  // Only set for FINISH events.
+  10: HgImportFetchedSource fetchedSource;
 }
 
 /**
@@ -1003,6 +1129,22 @@ enum InodeEventProgress {
   FAIL = 2,
 }
 
+/**
+ * Where the duration of an inode load went, in microseconds (μs). Phases the
+ * load did not go through are 0.
+ */
+struct InodeLoadBreakdown {
+  // Waiting in the InodeMap for the parent to start the load, including the
+  // time it took to load the parent itself.
+  1: i64 inodeMapWait;
+  // Fetching the source control tree of an unmaterialized directory.
+  2: i64 treeFetch;
+  // Reading the directory contents from the overlay.
+  3: i64 overlayRead;
+  // Setting up the inode and its entry in the inode metadata table.
+  4: i64 metadataLookup;
+}
+
 struct InodeEvent {
   2: i64 ino;
   3: InodeType inodeType;
@@ -1012,6 +1154,8 @@ struct InodeEvent {
   6: InodeEventProgress progress;
   7: TraceEventTimes times;
   8: PathString path;
+  // Only set on the END event of a LOAD.
+  9: optional InodeLoadBreakdown loadBreakdown;
 }
 
 /**
@@ -1250,6 +1394,13 @@ struct AccessCounts {
   5: i64 fsChannelDurationNs;
   6: i64 fsChannelMemoryCacheImports;
   7: i64 fsChannelDiskCacheImports;
+  // Bytes returned by read requests.
+  8: i64 fsChannelBytesRead;
+  // Percentiles of the request latencies, rounded up to a power of two of
+  // microseconds. 0 if no duration was recorded.
+  9: i64 fsChannelLatencyP50Ns;
+  10: i64 fsChannelLatencyP90Ns;
+  11: i64 fsChannelLatencyP99Ns;
 }
 
 struct MountAccesses {
@@ -1264,6 +1415,27 @@ struct GetAccessCountsResult {
 // 3: map<pid_t, AccessCount> thriftAccesses
 }
 
+struct ProcessCost {
+  1: pid_t pid;
+  // The command line of the process, if known.
+  2: binary cmd;
+  3: PathString mountPoint;
+  4: AccessCounts accessCounts;
+}
+
+struct GetTopProcessesByCostRequest {
+  // The number of seconds to look back, up to 16.
+  1: i64 duration;
+  // The maximum number of processes to return.
+  2: i32 limit;
+}
+
+struct GetTopProcessesByCostResult {
+  // Sorted by decreasing accessCounts.fsChannelDurationNs. A process
+  // accessing several mounts has an entry per mount.
+  1: list<ProcessCost> processes;
+}
+
 enum TracePointEvent {
   // Start of a new block
   START = 0,
@@ -1526,12 +1698,15 @@ service EdenService extends fb303_core.BaseService {
    * Note: may return stale data if synchronizeWorkingCopy isn't called, and if
    * the SyncBehavior specify a 0 timeout. see the documentation for both of
    * these for more details.
+   *
+   * Runs on the Thrift IO thread, which answers right away when the SHA-1s
+   * are in memory. Otherwise the request continues on the EdenFS CPU pool.
    */
   list<SHA1Result> getSHA1(
     1: PathString mountPoint,
     2: list<PathString> paths,
     3: SyncBehavior sync,
-  ) throws (1: EdenError ex);
+  ) throws (1: EdenError ex) (thread = 'eb');
 
   /**
    * On systems that support bind mounts, establish a bind mount within the
@@ -1564,10 +1739,11 @@ service EdenService extends fb303_core.BaseService {
 
   /** Returns the sequence position at the time the method is called.
    * Returns the instantaneous value of the journal sequence number.
+   * Answered on the Thrift IO thread.
    */
   JournalPosition getCurrentJournalPosition(1: PathString mountPoint) throws (
     1: EdenError ex,
-  );
+  ) (thread = 'eb');
 
   /** Returns the set of files (and dirs) that changed since a prior point.
    * If fromPosition.mountGeneration is mismatched with the current
@@ -1583,6 +1759,17 @@ service EdenService extends fb303_core.BaseService {
     2: JournalPosition fromPosition,
   ) throws (1: EdenError ex);
 
+  /**
+   * Like getFilesChangedSince(), but describes how each path changed along
+   * with its current dtype and the requested attributes, so that clients
+   * don't need to look the changed paths up.
+   *
+   * Throws the same errors as getFilesChangedSince().
+   */
+  GetChangesSinceResult getChangesSince(
+    1: GetChangesSinceParams params,
+  ) throws (1: EdenError ex);
+
   /** Sets the memory limit on the journal such that the journal will forget
    * old data to keep itself under a certain estimated memory use.
    */
@@ -2000,6 +2187,15 @@ service EdenService extends fb303_core.BaseService {
     1: EdenError ex,
   );
 
+  /**
+   * Returns the processes whose filesystem requests took the longest in the
+   * last `duration` seconds, without transferring the access counts of all
+   * the other processes like getAccessCounts does.
+   */
+  GetTopProcessesByCostResult getTopProcessesByCost(
+    1: GetTopProcessesByCostRequest request,
+  ) throws (1: EdenError ex);
+
   /**
    * Start recording paths of the files fetched from the backing store.
    *
@@ -2018,6 +2214,36 @@ service EdenService extends fb303_core.BaseService {
     1: EdenError ex,
   );
 
+  /**
+   * Store a prefetch profile in the EdenFS state directory, replacing the
+   * profile of the same name if any. Profiles are shared by all the mounts.
+   */
+  void savePrefetchProfile(1: SavePrefetchProfileParams params) throws (
+    1: EdenError ex,
+  );
+
+  /**
+   * Prefetch the files of a profile stored by savePrefetchProfile(), as of
+   * the checked out commit. The trees are walked one level at a time and the
+   * blobs fetched prefetch-profile:blob-batch-size at a time, at the priority
+   * of prefetchFiles(). Paths that aren't files of the commit are skipped.
+   *
+   * An empty result is returned for background prefetches.
+   */
+  PrefetchProfileResult prefetchProfile(
+    1: PrefetchProfileParams params,
+  ) throws (1: EdenError ex) (priority = 'BEST_EFFORT');
+
+  /**
+   * Returns the stacks of the filesystem and Thrift requests in flight,
+   * sampled every telemetry:request-sampling-interval, in the folded format
+   * of flame graph tools: one "frame;frame;frame count" line per stack.
+   *
+   * The counts add up since sampling was enabled, or since the last call
+   * that set `reset`.
+   */
+  string getSampledRequestStacks(1: bool reset) throws (1: EdenError ex);
+
   /**
    * Column by column, clears and compacts the LocalStore. All columns are
    * compacted, but only columns that contain ephemeral data are cleared.
@@ -2036,6 +2262,12 @@ service EdenService extends fb303_core.BaseService {
    */
   void debugClearLocalStoreCaches() throws (1: EdenError ex);
 
+  /**
+   * Evicts every object from the in-memory blob and tree caches. They are
+   * read back from the LocalStore when needed again.
+   */
+  void clearMemoryCaches() throws (1: EdenError ex);
+
   /**
    * Asks RocksDB to perform a compaction.
    */
@@ -15,6 +15,19 @@ enum FsEventType {
   FINISH = 2,
 }
 
+/**
+ * Where the time of a request that took longer than the slow request
+ * threshold (see fuse:slow-request-threshold) went.
+ */
+struct SlowFsRequest {
+  1: i64 durationNs;
+  // Time spent waiting for the backing store. The remainder of durationNs was
+  // spent in the filesystem dispatcher or local caches.
+  2: i64 backingStoreDurationNs;
+  // The path of the inode the request was for, if it could be resolved.
+  3: optional eden.PathString path;
+}
+
 struct FsEvent {
   // Nanoseconds since epoch.
   1: i64 timestamp;
@@ -48,6 +61,9 @@ struct FsEvent {
    * Negative indicates an error.
    */
   9: optional i64 result;
+
+  // Set on the FINISH events of slow requests.
+  12: optional SlowFsRequest slowRequest;
 }
 
 /*
@@ -88,6 +104,49 @@ struct ChangesSinceResult {
 struct StreamChangesSinceParams {
   1: eden.PathString mountPoint;
   2: eden.JournalPosition fromPosition;
+  /**
+   * Only stream the changes under this directory, relative to the mount.
+   * Empty to stream the changes of the whole mount. The returned toPosition
+   * is the same either way.
+   */
+  3: eden.PathString relativeRoot;
+}
+
+/**
+ * Sent last on a streamScmStatus stream, once the whole working copy was
+ * diffed.
+ */
+struct ScmStatusSummary {
+  // The number of entries and errors sent in the preceding chunks.
+  1: i64 entryCount;
+  2: i64 errorCount;
+  // The version of the EdenFS daemon, as in GetScmStatusResult.
+  3: string version;
+}
+
+union ScmStatusStreamItem {
+  1: eden.ScmStatus chunk;
+  2: ScmStatusSummary summary;
+}
+
+struct StreamBlobsParams {
+  1: eden.MountId mountId;
+  2: list<eden.ThriftObjectId> ids;
+}
+
+/**
+ * A piece of the blob ids[index] of a streamBlobs request, or the error
+ * fetching it.
+ */
+struct BlobChunk {
+  1: i64 index;
+  /** Where data starts in the blob. */
+  2: i64 offset;
+  /** The size of the whole blob. */
+  3: i64 totalSize;
+  4: binary data;
+  /** Set, on the only chunk of the blob, if it couldn't be fetched. */
+  5: optional eden.EdenError error;
 }
 
 /**
@@ -177,4 +236,52 @@ service StreamingEdenService extends eden.EdenService {
   > streamChangesSince(1: StreamChangesSinceParams params) throws (
     1: eden.EdenError ex,
   );
+
+  /**
+   * Evaluates globs like globFiles, but returns the matching files as a
+   * stream of Glob chunks, published as the directories are evaluated. Clients
+   * can thus start working on the first matches before the whole glob has
+   * been evaluated, and EdenFS doesn't hold the whole result in memory.
+   *
+   * The files are neither sorted nor deduplicated across chunks. Each chunk
+   * holds the files of whole directories, and is published once it holds at
+   * least glob:stream-chunk-size files, or when the glob completes.
+   * suppressFileList and background are ignored.
+   */
+  stream<eden.Glob throws (1: eden.EdenError ex)> streamGlobFiles(
+    1: eden.GlobParams params,
+  ) throws (1: eden.EdenError ex);
+
+  /**
+   * Computes the status like getScmStatusV2, but returns it as a stream of
+   * ScmStatus chunks, published as the working copy is diffed, followed by a
+   * single ScmStatusSummary. A stream that ends without the summary is
+   * incomplete.
+   *
+   * The entries are neither sorted nor spread across the chunks in any
+   * particular order. A chunk is published once it holds
+   * scm-status:stream-chunk-size entries and errors, or when the diff
+   * completes. Closing the stream cancels the diff.
+   */
+  stream<
+    ScmStatusStreamItem throws (1: eden.EdenError ex)
+  > streamScmStatus(1: eden.GetScmStatusParams params) throws (
+    1: eden.EdenError ex,
+  );
+
+  /**
+   * Fetches blobs like debugGetBlob does from the ANYWHERE origin: from the
+   * memory cache, the local store, or the backing store. Returns their
+   * contents as a stream of chunks of at most thrift:stream-blobs-chunk-size
+   * bytes.
+   *
+   * Up to thrift:stream-blobs-parallelism blobs are fetched concurrently.
+   * Blobs are streamed in the order they are fetched. The chunks of a blob
+   * are sent in order, but may be interleaved with those of other blobs. A
+   * blob is complete once offset plus the size of data reaches totalSize.
+   * Closing the stream stops the fetches.
+   */
+  stream<BlobChunk throws (1: eden.EdenError ex)> streamBlobs(
+    1: StreamBlobsParams params,
+  ) throws (1: eden.EdenError ex);
 }
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/ThriftGetObjectImpl.h"
+
+#include <folly/Try.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/ObjectId.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+std::vector<BlobChunk> publish(
+    const folly::Try<std::shared_ptr<const Blob>>& blob,
+    size_t chunkSize) {
+  std::vector<BlobChunk> chunks;
+  publishBlobChunks(
+      ObjectId{"blob"}, 3, blob, chunkSize, [&](BlobChunk&& chunk) {
+        chunks.push_back(std::move(chunk));
+      });
+  return chunks;
+}
+
+folly::Try<std::shared_ptr<const Blob>> makeBlob(folly::StringPiece contents) {
+  return folly::Try<std::shared_ptr<const Blob>>{
+      std::make_shared<const Blob>(ObjectId{"blob"}, contents)};
+}
+
+} // namespace
+
+TEST(ThriftGetObjectImplTest, blob_is_split_in_chunks) {
+  auto chunks = publish(makeBlob("0123456789"), 4);
+  ASSERT_EQ(3, chunks.size());
+  std::string contents;
+  for (const auto& chunk : chunks) {
+    EXPECT_EQ(3, *chunk.index());
+    EXPECT_EQ(contents.size(), *chunk.offset());
+    EXPECT_EQ(10, *chunk.totalSize());
+    EXPECT_FALSE(chunk.error().has_value());
+    contents += *chunk.data();
+  }
+  EXPECT_EQ("0123456789", contents);
+  EXPECT_EQ("89", *chunks.back().data());
+}
+
+TEST(ThriftGetObjectImplTest, blob_smaller_than_a_chunk_is_sent_whole) {
+  auto chunks = publish(makeBlob("0123"), 4);
+  ASSERT_EQ(1, chunks.size());
+  EXPECT_EQ("0123", *chunks[0].data());
+  EXPECT_EQ(4, *chunks[0].totalSize());
+}
+
+TEST(ThriftGetObjectImplTest, empty_blob_gets_one_empty_chunk) {
+  auto chunks = publish(makeBlob(""), 4);
+  ASSERT_EQ(1, chunks.size());
+  EXPECT_EQ("", *chunks[0].data());
+  EXPECT_EQ(0, *chunks[0].totalSize());
+  EXPECT_FALSE(chunks[0].error().has_value());
+}
+
+TEST(ThriftGetObjectImplTest, fetch_error_gets_one_error_chunk) {
+  auto chunks = publish(
+      folly::Try<std::shared_ptr<const Blob>>{
+          folly::make_exception_wrapper<std::runtime_error>("fetch failed")},
+      4);
+  ASSERT_EQ(1, chunks.size());
+  EXPECT_EQ(3, *chunks[0].index());
+  ASSERT_TRUE(chunks[0].error().has_value());
+  EXPECT_NE(
+      std::string::npos, chunks[0].error()->message()->find("fetch failed"));
+  EXPECT_EQ("", *chunks[0].data());
+}
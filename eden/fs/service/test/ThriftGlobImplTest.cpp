@@ -9,7 +9,9 @@
 #include <cstddef>
 #include <memory>
 
+#include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/inodes/InodeMap.h"
+#include "eden/fs/inodes/ServerState.h"
 #include "eden/fs/service/ThriftGlobImpl.h"
 #include "eden/fs/service/gen-cpp2/eden_types.h"
 #include "eden/fs/store/ObjectFetchContext.h"
@@ -17,6 +19,8 @@
 #include "eden/fs/testharness/TestMount.h"
 #include "eden/fs/testharness/TestServerState.h"
 
+using namespace std::chrono_literals;
+
 namespace facebook::eden {
 
 std::tuple<size_t, size_t> getInodeCounters(InodeMap* map) {
@@ -50,13 +54,18 @@ TEST(ThriftGlobImplTest, testGlobFilesNotLoadingInode) {
 
   std::string glob{"**/*.txt"};
   auto globber = ThriftGlobImpl{GlobParams{}};
-  auto globFuture = globber.glob(
-      edenMount,
-      serverState,
-      std::vector<std::string>{"**/*.txt"},
-      ObjectFetchContext::getNullContext());
+  auto globFuture = globber
+                        .glob(
+                            edenMount,
+                            serverState,
+                            std::vector<std::string>{"**/*.txt"},
+                            ObjectFetchContext::getNullContext())
+                        .semi()
+                        .via(mount.getServerExecutor().get());
 
-  auto _result = std::move(globFuture).get();
+  // The subdirectories are evaluated on the server executor.
+  mount.drainServerExecutor();
+  auto _result = std::move(globFuture).get(1s);
 
   // Then we compare the number, both counter should remain the same before and
   // after the call.
@@ -75,4 +84,45 @@ TEST(ThriftGlobImplTest, testGlobFilesNotLoadingInode) {
   // - foo/bar/dir2/file.txt
   assertInodeCounters(inodeMap, loaded + 6, unloaded);
 }
+
+TEST(ThriftGlobImplTest, globResultsAreCachedForUnmodifiedTrees) {
+  FakeTreeBuilder builder;
+  builder.setFile("dir/a.txt", "a");
+  builder.setFile("dir/b.txt", "b");
+  TestMount mount{builder};
+  mount.getEdenConfig()->globResultCacheSize.setValue(
+      16, ConfigSource::CommandLine);
+  auto& cache = mount.getServerState()->getGlobResultCache();
+
+  auto glob = [&](bool includeDotfiles) {
+    GlobParams params;
+    params.searchRoot() = "dir";
+    params.includeDotfiles() = includeDotfiles;
+    auto future = ThriftGlobImpl{params}
+                      .glob(
+                          mount.getEdenMount(),
+                          mount.getServerState(),
+                          std::vector<std::string>{"**/*.txt"},
+                          ObjectFetchContext::getNullContext())
+                      .semi()
+                      .via(mount.getServerExecutor().get());
+    mount.drainServerExecutor();
+    return *std::move(future).get(1s)->matchingFiles();
+  };
+  using Files = std::vector<std::string>;
+
+  EXPECT_EQ((Files{"a.txt", "b.txt"}), glob(false));
+  EXPECT_EQ(1u, cache.size());
+  EXPECT_EQ((Files{"a.txt", "b.txt"}), glob(false));
+  EXPECT_EQ(1u, cache.size());
+
+  // The flags changing the results are part of the key.
+  EXPECT_EQ((Files{"a.txt", "b.txt"}), glob(true));
+  EXPECT_EQ(2u, cache.size());
+
+  // Directories with local changes are globbed live.
+  mount.addFile("dir/c.txt", "c");
+  EXPECT_EQ((Files{"a.txt", "b.txt", "c.txt"}), glob(false));
+  EXPECT_EQ(2u, cache.size());
+}
 } // namespace facebook::eden
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/service/ThriftRequestLimiter.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/service/gen-cpp2/eden_types.h"
+
+using namespace facebook::eden;
+using Priority = ThriftRequestLimiter::Priority;
+
+namespace {
+
+class ThriftRequestLimiterTest : public ::testing::Test {
+ protected:
+  ImmediateFuture<ThriftRequestLimiter::Permit> acquire(
+      Priority priority = Priority::High) {
+    return limiter_.acquire(2, 2, priority);
+  }
+
+  ThriftRequestLimiter limiter_{
+      "test",
+      std::make_shared<EdenStats>(),
+      &ThriftStats::globQueueTime,
+      &ThriftStats::globRejected};
+};
+
+} // namespace
+
+TEST_F(ThriftRequestLimiterTest, requests_under_the_limit_run_right_away) {
+  auto first = acquire();
+  auto second = acquire();
+  EXPECT_TRUE(first.isReady());
+  EXPECT_TRUE(second.isReady());
+  EXPECT_EQ(2, limiter_.getRunningCount());
+
+  auto third = acquire();
+  EXPECT_FALSE(third.isReady());
+  EXPECT_EQ(1, limiter_.getQueuedCount());
+
+  // Completing a request admits the waiting one.
+  std::move(first).get();
+  EXPECT_EQ(0, limiter_.getQueuedCount());
+  EXPECT_EQ(2, limiter_.getRunningCount());
+  std::move(third).get();
+  EXPECT_EQ(1, limiter_.getRunningCount());
+}
+
+TEST_F(ThriftRequestLimiterTest, high_priority_requests_are_admitted_first) {
+  auto first = acquire();
+  auto second = acquire();
+  auto low = acquire(Priority::Low);
+  auto high = acquire(Priority::High);
+  EXPECT_EQ(2, limiter_.getQueuedCount());
+
+  // The slot of second goes to high even though low waited longer.
+  std::move(second).get();
+  EXPECT_EQ(1, limiter_.getQueuedCount());
+  EXPECT_EQ(2, limiter_.getRunningCount());
+
+  // Then the slot of high goes to low.
+  std::move(high).get();
+  EXPECT_EQ(0, limiter_.getQueuedCount());
+  std::move(first).get();
+  std::move(low).get();
+  EXPECT_EQ(0, limiter_.getRunningCount());
+}
+
+TEST_F(ThriftRequestLimiterTest, requests_are_rejected_when_the_queue_is_full) {
+  auto first = acquire();
+  auto second = acquire();
+  auto third = acquire();
+  auto fourth = acquire();
+  auto fifth = acquire();
+  EXPECT_THROW(std::move(fifth).get(), EdenError);
+  EXPECT_EQ(2, limiter_.getQueuedCount());
+}
+
+TEST_F(ThriftRequestLimiterTest, run_holds_the_permit_until_completion) {
+  auto first = acquire();
+  folly::Promise<folly::Unit> promise;
+  auto running = limiter_.run(1, 1, Priority::High, [&] {
+    return ImmediateFuture<folly::Unit>{promise.getSemiFuture()};
+  });
+  // The limit of 1 is already reached by first.
+  EXPECT_EQ(1, limiter_.getQueuedCount());
+  std::move(first).get();
+  EXPECT_EQ(1, limiter_.getRunningCount());
+  promise.setValue();
+  std::move(running).get();
+  EXPECT_EQ(0, limiter_.getRunningCount());
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/sqlite/SqliteConnectionPool.h"
+
+#include <folly/logging/xlog.h>
+#include <algorithm>
+
+#include "eden/fs/sqlite/SqliteDatabase.h"
+
+namespace facebook::eden {
+
+namespace {
+// Readers only wait for the writer in rare cases, e.g. while the WAL is
+// being reset after a checkpoint.
+constexpr int kBusyTimeoutMs = 1000;
+
+void checkOpen(const SqliteConnection& conn) {
+  switch (conn.status) {
+    case SqliteDbStatus::OPEN:
+      return;
+    case SqliteDbStatus::NOT_YET_OPENED:
+    case SqliteDbStatus::FAILED_TO_OPEN:
+      throw std::runtime_error("the SqliteConnectionPool failed to be opened");
+    case SqliteDbStatus::CLOSED:
+      throw std::runtime_error(
+          "the SqliteConnectionPool has already been closed");
+  }
+}
+} // namespace
+
+PersistentSqliteStatement::Guard SqliteConnectionPool::Lease::statement(
+    folly::StringPiece sql) {
+  auto it = statements_.find(sql);
+  if (it == statements_.end()) {
+    it = statements_
+             .emplace(
+                 std::piecewise_construct,
+                 std::forward_as_tuple(sql.str()),
+                 std::forward_as_tuple(conn_, sql))
+             .first;
+  }
+  return it->second.get(conn_);
+}
+
+SqliteConnectionPool::SqliteConnectionPool(
+    AbsolutePathPiece path,
+    size_t connectionCount) {
+  auto dbPath = path.copy().value();
+  connectionCount = std::max<size_t>(connectionCount, 1);
+  readers_.reserve(connectionCount);
+  try {
+    for (size_t i = 0; i < connectionCount; ++i) {
+      sqlite3* db = nullptr;
+      // Each connection is only ever used under its lock, SQLite's own
+      // mutexes would be redundant.
+      auto result = sqlite3_open_v2(
+          dbPath.c_str(),
+          &db,
+          SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX,
+          nullptr);
+      if (result != SQLITE_OK) {
+        // sqlite3_close handles nullptr fine
+        // @lint-ignore CLANGTIDY
+        sqlite3_close(db);
+        checkSqliteResult(nullptr, result);
+      }
+      sqlite3_busy_timeout(db, kBusyTimeoutMs);
+
+      auto& reader = readers_.emplace_back(std::make_unique<Reader>());
+      auto conn = reader->conn.wlock();
+      conn->db = db;
+      conn->status = SqliteDbStatus::OPEN;
+    }
+  } catch (const std::exception&) {
+    close();
+    throw;
+  }
+  XLOG(DBG2) << "opened " << connectionCount << " SQLite read connections to "
+             << dbPath;
+}
+
+SqliteConnectionPool::~SqliteConnectionPool() {
+  close();
+}
+
+void SqliteConnectionPool::close() {
+  for (auto& reader : readers_) {
+    auto conn = reader->conn.wlock();
+    conn->status = SqliteDbStatus::CLOSED;
+    // The prepared statements must be finalized before closing, otherwise
+    // sqlite3_close fails with SQLITE_BUSY.
+    reader->statements.clear();
+    if (conn->db) {
+      sqlite3_close(conn->db);
+      conn->db = nullptr;
+    }
+  }
+}
+
+SqliteConnectionPool::Lease SqliteConnectionPool::acquire() {
+  auto start = next_.fetch_add(1, std::memory_order_relaxed);
+  auto count = readers_.size();
+  for (size_t i = 0; i < count; ++i) {
+    auto& reader = *readers_[(start + i) % count];
+    if (auto conn = reader.conn.tryWLock()) {
+      checkOpen(*conn);
+      return Lease{std::move(conn), reader.statements};
+    }
+  }
+
+  // All the connections are busy, queue up on one of them.
+  auto& reader = *readers_[start % count];
+  auto conn = reader.conn.wlock();
+  checkOpen(*conn);
+  return Lease{std::move(conn), reader.statements};
+}
+
+} // namespace facebook::eden
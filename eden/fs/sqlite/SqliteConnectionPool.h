@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "eden/fs/sqlite/PersistentSqliteStatement.h"
+#include "eden/fs/sqlite/SqliteConnection.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * A pool of read-only connections to a SQLite database in WAL mode.
+ *
+ * SqliteDatabase serializes every access behind the lock of its single
+ * connection. In WAL mode, readers don't block each other nor the writer, so
+ * spreading reads over several connections lets them run concurrently.
+ *
+ * Each connection has its own cache of prepared statements, keyed by their
+ * SQL, so that repeated queries are only prepared once per connection.
+ *
+ * The database must already exist and be in WAL mode: this is usually
+ * arranged by opening it read-write through SqliteDatabase first.
+ */
+class SqliteConnectionPool {
+ public:
+  /**
+   * Open connectionCount read-only connections to the database at path.
+   * Throws if any of them fails to open.
+   */
+  SqliteConnectionPool(AbsolutePathPiece path, size_t connectionCount);
+
+  SqliteConnectionPool(const SqliteConnectionPool&) = delete;
+  SqliteConnectionPool& operator=(const SqliteConnectionPool&) = delete;
+
+  /**
+   * Close all the connections. This will happen implicitly at destruction.
+   * Later calls to acquire() throw.
+   */
+  void close();
+
+  ~SqliteConnectionPool();
+
+  class Lease {
+   public:
+    /**
+     * The locked connection, suitable for passing to SqliteStatement.
+     */
+    LockedSqliteConnection& connection() {
+      return conn_;
+    }
+
+    /**
+     * Return the statement prepared from sql on this connection, preparing
+     * it the first time it is used. The statement is reset when the guard is
+     * destroyed.
+     */
+    PersistentSqliteStatement::Guard statement(folly::StringPiece sql);
+
+   private:
+    friend class SqliteConnectionPool;
+
+    using StatementCache =
+        folly::F14NodeMap<std::string, PersistentSqliteStatement>;
+
+    Lease(LockedSqliteConnection conn, StatementCache& statements)
+        : conn_{std::move(conn)}, statements_{statements} {}
+
+    LockedSqliteConnection conn_;
+    StatementCache& statements_;
+  };
+
+  /**
+   * Lock a connection of the pool for the caller's exclusive use. Idle
+   * connections are preferred; if all of them are in use, this blocks until
+   * one is released.
+   */
+  Lease acquire();
+
+  size_t getConnectionCount() const {
+    return readers_.size();
+  }
+
+ private:
+  struct Reader {
+    folly::Synchronized<SqliteConnection> conn;
+    /**
+     * Only accessed while holding conn. Must be cleared before the
+     * connection is closed.
+     */
+    Lease::StatementCache statements;
+  };
+
+  std::vector<std::unique_ptr<Reader>> readers_;
+  // Spreads the callers that have to wait over all the connections.
+  std::atomic<size_t> next_{0};
+};
+
+} // namespace facebook::eden
@@ -15,11 +15,17 @@ struct SqliteDatabase::StatementCache {
   explicit StatementCache(LockedSqliteConnection& db)
       : beginTransaction{db, "BEGIN"},
         commitTransaction{db, "COMMIT"},
-        rollbackTransaction{db, "ROLLBACK"} {}
+        rollbackTransaction{db, "ROLLBACK"},
+        savepoint{db, "SAVEPOINT grouped"},
+        releaseSavepoint{db, "RELEASE grouped"},
+        rollbackToSavepoint{db, "ROLLBACK TO grouped"} {}
 
   PersistentSqliteStatement beginTransaction;
   PersistentSqliteStatement commitTransaction;
   PersistentSqliteStatement rollbackTransaction;
+  PersistentSqliteStatement savepoint;
+  PersistentSqliteStatement releaseSavepoint;
+  PersistentSqliteStatement rollbackToSavepoint;
 };
 
 void checkSqliteResult(sqlite3* db, int result) {
@@ -118,6 +124,21 @@ LockedSqliteConnection SqliteDatabase::lock() {
 void SqliteDatabase::transaction(
     const std::function<void(LockedSqliteConnection&)>& func) {
   auto conn = lock();
+  if (groupTransactionOpen_) {
+    try {
+      cache_->savepoint.get(conn)->step();
+      func(conn);
+      cache_->releaseSavepoint.get(conn)->step();
+    } catch (const std::exception& ex) {
+      // Rolling back to a savepoint leaves it open.
+      cache_->rollbackToSavepoint.get(conn)->step();
+      cache_->releaseSavepoint.get(conn)->step();
+      XLOG(WARN) << "SQLite transaction failed: " << ex.what();
+      throw;
+    }
+    return;
+  }
+
   try {
     cache_->beginTransaction.get(conn)->step();
     func(conn);
@@ -129,6 +150,35 @@ void SqliteDatabase::transaction(
   }
 }
 
+void SqliteDatabase::groupTransactions(folly::FunctionRef<void()> func) {
+  {
+    auto conn = lock();
+    XCHECK(!groupTransactionOpen_) << "transaction groups don't nest";
+    cache_->beginTransaction.get(conn)->step();
+    groupTransactionOpen_ = true;
+  }
+
+  auto commit = [&] {
+    auto conn = lock();
+    groupTransactionOpen_ = false;
+    try {
+      cache_->commitTransaction.get(conn)->step();
+    } catch (const std::exception& ex) {
+      cache_->rollbackTransaction.get(conn)->step();
+      XLOG(WARN) << "SQLite transaction group failed: " << ex.what();
+      throw;
+    }
+  };
+
+  try {
+    func();
+  } catch (const std::exception&) {
+    commit();
+    throw;
+  }
+  commit();
+}
+
 void SqliteDatabase::checkpoint() {
   if (auto conn = db_.tryWLock()) {
     XLOG(DBG6) << "Checkpoint thread acquired SQLite lock";
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <folly/Function.h>
 #include <folly/Synchronized.h>
 #include <sqlite3.h>
 
@@ -86,6 +87,17 @@ class SqliteDatabase {
    */
   void transaction(const std::function<void(LockedSqliteConnection&)>& func);
 
+  /**
+   * Runs func with all the statements and transactions executed on this
+   * database until it returns grouped into a single SQLite transaction, so
+   * that they share the cost of one commit. The transactions run by func
+   * become savepoints: a failing one is still rolled back on its own.
+   *
+   * The group is committed even if func throws, as the transactions it ran
+   * before throwing succeeded.
+   */
+  void groupTransactions(folly::FunctionRef<void()> func);
+
   void checkpoint();
 
  private:
@@ -98,5 +110,8 @@ class SqliteDatabase {
   folly::Synchronized<SqliteConnection> db_;
 
   std::unique_ptr<StatementCache> cache_;
+
+  // Set while groupTransactions() runs, protected by the db_ lock.
+  bool groupTransactionOpen_{false};
 };
 } // namespace facebook::eden
@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/sqlite/SqliteConnectionPool.h"
+
+#include <folly/portability/GTest.h>
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "eden/fs/sqlite/SqliteDatabase.h"
+#include "eden/fs/sqlite/SqliteStatement.h"
+#include "eden/fs/testharness/TempFile.h"
+
+namespace facebook::eden {
+
+class SqliteConnectionPoolTest : public testing::Test {
+ public:
+  SqliteConnectionPoolTest()
+      : dbPath{canonicalPath(testDir.path().string()) + "test.db"_pc},
+        db{dbPath} {
+    auto conn = db.lock();
+    SqliteStatement(conn, "PRAGMA journal_mode=WAL").step();
+    SqliteStatement(
+        conn, "CREATE TABLE test (key BINARY NOT NULL, PRIMARY KEY (key))")
+        .step();
+  }
+
+  void insert(int64_t key) {
+    auto conn = db.lock();
+    SqliteStatement stmt{conn, "INSERT INTO test VALUES (?)"};
+    stmt.bind(1, key);
+    stmt.step();
+  }
+
+  static bool contains(SqliteConnectionPool& pool, int64_t key) {
+    auto lease = pool.acquire();
+    auto stmt = lease.statement("SELECT 1 FROM test WHERE key = ?");
+    stmt->bind(1, key);
+    return stmt->step();
+  }
+
+  folly::test::TemporaryDirectory testDir{makeTempDir()};
+  AbsolutePath dbPath;
+  SqliteDatabase db;
+};
+
+TEST_F(SqliteConnectionPoolTest, readers_see_committed_writes) {
+  SqliteConnectionPool pool{dbPath, 2};
+  EXPECT_FALSE(contains(pool, 1));
+  insert(1);
+  EXPECT_TRUE(contains(pool, 1));
+  EXPECT_TRUE(contains(pool, 1));
+}
+
+TEST_F(SqliteConnectionPoolTest, connections_are_leased_concurrently) {
+  SqliteConnectionPool pool{dbPath, 2};
+  auto first = pool.acquire();
+  auto second = pool.acquire();
+  EXPECT_NE(first.connection()->db, second.connection()->db);
+}
+
+TEST_F(SqliteConnectionPoolTest, readers_are_read_only) {
+  SqliteConnectionPool pool{dbPath, 1};
+  auto lease = pool.acquire();
+  SqliteStatement stmt{lease.connection(), "INSERT INTO test VALUES (1)"};
+  EXPECT_THROW(stmt.step(), std::runtime_error);
+}
+
+TEST_F(SqliteConnectionPoolTest, concurrent_reads) {
+  for (int64_t key = 0; key < 100; ++key) {
+    insert(key);
+  }
+
+  SqliteConnectionPool pool{dbPath, 4};
+  std::vector<std::thread> threads;
+  std::atomic<size_t> found{0};
+  for (size_t i = 0; i < 8; ++i) {
+    threads.emplace_back([&] {
+      for (int64_t key = 0; key < 100; ++key) {
+        if (contains(pool, key)) {
+          found.fetch_add(1, std::memory_order_relaxed);
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(800, found.load());
+}
+
+TEST_F(SqliteConnectionPoolTest, acquire_throws_after_close) {
+  SqliteConnectionPool pool{dbPath, 2};
+  EXPECT_FALSE(contains(pool, 1));
+  pool.close();
+  EXPECT_THROW(pool.acquire(), std::runtime_error);
+}
+
+} // namespace facebook::eden
@@ -81,4 +81,47 @@ TEST_F(SqliteTest, testPersistentSqliteStatement) {
     exec->step();
   }
 }
+
+TEST_F(SqliteTest, testGroupTransactions) {
+  {
+    auto conn = db.lock();
+    SqliteStatement(
+        conn, "CREATE TABLE test (id INTEGER NOT NULL, PRIMARY KEY (id))")
+        .step();
+  }
+  auto insert = [&](int64_t id) {
+    db.transaction([&](auto& txn) {
+      SqliteStatement stmt{txn, "INSERT INTO test (id) VALUES (?)"};
+      stmt.bind(1, id);
+      stmt.step();
+    });
+  };
+  auto count = [&] {
+    auto conn = db.lock();
+    SqliteStatement stmt{conn, "SELECT COUNT(*) FROM test"};
+    stmt.step();
+    return stmt.columnUint64(0);
+  };
+
+  db.groupTransactions([&] {
+    insert(1);
+    // Only the failing transaction of the group is rolled back.
+    ASSERT_THROW(insert(1), std::runtime_error);
+    insert(2);
+  });
+  EXPECT_EQ(2, count());
+
+  // A group is committed up to the point func threw.
+  ASSERT_THROW(
+      db.groupTransactions([&] {
+        insert(3);
+        throw std::runtime_error("failed");
+      }),
+      std::runtime_error);
+  EXPECT_EQ(3, count());
+
+  // Transactions outside of a group still work.
+  insert(4);
+  EXPECT_EQ(4, count());
+}
 } // namespace facebook::eden
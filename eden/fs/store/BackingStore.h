@@ -9,6 +9,8 @@
 
 #include <folly/Range.h>
 #include <folly/futures/Future.h>
+#include <folly/io/IOBuf.h>
+#include <stdexcept>
 #include <memory>
 
 #include "eden/fs/model/BlobMetadata.h"
@@ -70,6 +72,17 @@ class BackingStore : public RootIdCodec, public ObjectIdCodec {
       const ObjectId& one,
       const ObjectId& two) = 0;
 
+  /**
+   * Returns the ObjectId in the current encoding of this BackingStore for an
+   * ObjectId in a legacy encoding, or std::nullopt if it doesn't need to be
+   * migrated. Used to rewrite the ObjectIds persisted in the overlay.
+   *
+   * May block on a LocalStore read.
+   */
+  virtual std::optional<ObjectId> migrateObjectId(const ObjectId& /*id*/) {
+    return std::nullopt;
+  }
+
   /**
    * Return the root Tree corresponding to the passed in RootId.
    */
@@ -120,6 +133,30 @@ class BackingStore : public RootIdCodec, public ObjectIdCodec {
       const ObjectId& id,
       const ObjectFetchContextPtr& context) = 0;
 
+  /**
+   * Whether getBlobRange() fetches only the requested range of a blob.
+   * ObjectStore only issues ranged reads to BackingStores that do.
+   */
+  virtual bool supportsBlobRanges() const {
+    return false;
+  }
+
+  /**
+   * Fetch `length` bytes of the blob starting at `offset`, without fetching
+   * the rest of it. The result is shorter than `length` if the range extends
+   * past the end of the blob, and empty if it starts past it.
+   *
+   * Only called when supportsBlobRanges() returns true.
+   */
+  virtual folly::SemiFuture<std::unique_ptr<folly::IOBuf>> getBlobRange(
+      const ObjectId& /*id*/,
+      uint64_t /*offset*/,
+      uint64_t /*length*/,
+      const ObjectFetchContextPtr& /*context*/) {
+    return folly::makeSemiFuture<std::unique_ptr<folly::IOBuf>>(
+        std::logic_error("this BackingStore does not support ranged reads"));
+  }
+
   /**
    * Fetch blob metadata if available in a local cache. Returns nullptr if not
    * locally available.
@@ -133,11 +170,14 @@ class BackingStore : public RootIdCodec, public ObjectIdCodec {
    *
    * The caller is responsible for making sure that the HashRange stays valid
    * for as long as the returned SemiFuture.
+   *
+   * Returns the number of blobs that had to be fetched remotely, which leaves
+   * out the blobs that were already available or being fetched.
    */
-  FOLLY_NODISCARD virtual folly::SemiFuture<folly::Unit> prefetchBlobs(
+  FOLLY_NODISCARD virtual folly::SemiFuture<size_t> prefetchBlobs(
       ObjectIdRange /*ids*/,
       const ObjectFetchContextPtr& /*context*/) {
-    return folly::unit;
+    return size_t{0};
   }
 
   virtual void periodicManagementTask() {}
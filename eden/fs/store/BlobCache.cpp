@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BlobCache.h"
+
+#include <folly/compression/Compression.h>
+#include <folly/logging/xlog.h>
+#include <optional>
+
+namespace facebook::eden {
+
+namespace {
+std::optional<folly::io::CodecType> pickCodecType() {
+  // LZ4 decompresses several times faster than zstd, which matters more than
+  // the compression ratio since decompression is on the read path.
+  for (auto type : {folly::io::CodecType::LZ4, folly::io::CodecType::ZSTD}) {
+    if (folly::io::hasCodec(type)) {
+      return type;
+    }
+  }
+  return std::nullopt;
+}
+
+const std::optional<folly::io::CodecType>& getCodecType() {
+  static const auto codecType = pickCodecType();
+  return codecType;
+}
+
+/**
+ * Codecs may keep per-stream state and are not safe to share between
+ * threads.
+ */
+folly::io::Codec& getCodec() {
+  thread_local auto codec = folly::io::getCodec(getCodecType().value());
+  return *codec;
+}
+
+uint64_t elapsedNanos(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+} // namespace
+
+BlobCache::BlobCache(
+    size_t maximumCacheSizeBytes,
+    size_t minimumEntryCount,
+    size_t shardCount,
+    CacheEvictionPolicy evictionPolicy,
+    size_t compressedTierSizeBytes)
+    : ObjectCache<Blob, ObjectCacheFlavor::InterestHandle>{
+          maximumCacheSizeBytes,
+          minimumEntryCount,
+          shardCount,
+          evictionPolicy},
+      compressedTierSizeBytes_{
+          getCodecType().has_value() ? compressedTierSizeBytes : 0} {
+  if (compressedTierSizeBytes != 0 && compressedTierSizeBytes_ == 0) {
+    XLOG(WARN) << "No compression codec available, disabling the compressed "
+               << "blob cache tier";
+  }
+  if (hasCompressedTier()) {
+    setEvictionCallback([this](const ObjectPtr& blob) {
+      try {
+        evictedBlobs_.wlock()->push_back(blob);
+      } catch (const std::exception&) {
+        // Not compressing a blob is harmless.
+      }
+    });
+  }
+}
+
+BlobCache::GetResult BlobCache::get(
+    const ObjectId& hash,
+    Interest interest) {
+  if (!hasCompressedTier()) {
+    return getInterestHandle(hash, interest);
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  auto result = getInterestHandle(hash, interest);
+  if (result.object) {
+    rawHitCount_.fetch_add(1, std::memory_order_relaxed);
+    rawHitNanos_.fetch_add(elapsedNanos(start), std::memory_order_relaxed);
+    return result;
+  }
+
+  auto blob = takeCompressed(hash);
+  if (!blob) {
+    return result;
+  }
+  auto handle = insertInterestHandle(blob, interest);
+  compressEvictedBlobs();
+  compressedHitCount_.fetch_add(1, std::memory_order_relaxed);
+  compressedHitNanos_.fetch_add(
+      elapsedNanos(start), std::memory_order_relaxed);
+  return GetResult{std::move(blob), std::move(handle)};
+}
+
+BlobInterestHandle BlobCache::insert(ObjectPtr blob, Interest interest) {
+  if (!hasCompressedTier()) {
+    return insertInterestHandle(std::move(blob), interest);
+  }
+
+  auto hash = blob->getHash();
+  auto handle = insertInterestHandle(std::move(blob), interest);
+  {
+    // The uncompressed copy takes precedence, don't keep both.
+    auto tier = compressedTier_.wlock();
+    auto it = tier->blobs.find(hash);
+    if (it != tier->blobs.end()) {
+      tier->compressedSize -= it->second.data->computeChainDataLength();
+      tier->uncompressedSize -= it->second.uncompressedSize;
+      tier->blobs.erase(it);
+    }
+  }
+  compressEvictedBlobs();
+  return handle;
+}
+
+void BlobCache::clear() {
+  ObjectCache<Blob, ObjectCacheFlavor::InterestHandle>::clear();
+  evictedBlobs_.wlock()->clear();
+  auto tier = compressedTier_.wlock();
+  tier->blobs.clear();
+  tier->compressedSize = 0;
+  tier->uncompressedSize = 0;
+}
+
+void BlobCache::compressEvictedBlobs() {
+  std::vector<ObjectPtr> evicted;
+  evictedBlobs_.wlock()->swap(evicted);
+  if (evicted.empty()) {
+    return;
+  }
+
+  for (auto& blob : evicted) {
+    const auto& contents = blob->getContents();
+    auto uncompressedSize = contents.computeChainDataLength();
+    if (uncompressedSize == 0 || uncompressedSize > compressedTierSizeBytes_) {
+      continue;
+    }
+
+    std::unique_ptr<folly::IOBuf> compressed;
+    try {
+      compressed = getCodec().compress(&contents);
+    } catch (const std::exception& ex) {
+      XLOG(DBG3) << "unable to compress blob " << blob->getHash() << ": "
+                 << ex.what();
+      continue;
+    }
+    auto compressedSize = compressed->computeChainDataLength();
+    if (compressedSize >= uncompressedSize) {
+      // Incompressible, keeping it would only waste memory.
+      continue;
+    }
+    compressionCount_.fetch_add(1, std::memory_order_relaxed);
+
+    auto tier = compressedTier_.wlock();
+    if (tier->blobs.exists(blob->getHash())) {
+      continue;
+    }
+    tier->blobs.set(
+        blob->getHash(),
+        CompressedBlob{std::move(compressed), uncompressedSize});
+    tier->compressedSize += compressedSize;
+    tier->uncompressedSize += uncompressedSize;
+    while (tier->compressedSize > compressedTierSizeBytes_) {
+      auto oldest = std::prev(tier->blobs.end());
+      tier->compressedSize -= oldest->second.data->computeChainDataLength();
+      tier->uncompressedSize -= oldest->second.uncompressedSize;
+      tier->blobs.erase(oldest);
+    }
+  }
+}
+
+BlobCache::ObjectPtr BlobCache::takeCompressed(const ObjectId& hash) {
+  CompressedBlob compressed;
+  {
+    auto tier = compressedTier_.wlock();
+    auto it = tier->blobs.find(hash);
+    if (it == tier->blobs.end()) {
+      return nullptr;
+    }
+    compressed = std::move(it->second);
+    tier->compressedSize -= compressed.data->computeChainDataLength();
+    tier->uncompressedSize -= compressed.uncompressedSize;
+    tier->blobs.erase(it);
+  }
+
+  // Decompress outside of the lock, this is the expensive part of a
+  // compressed hit.
+  try {
+    auto contents = getCodec().uncompress(
+        compressed.data.get(), compressed.uncompressedSize);
+    return std::make_shared<const Blob>(hash, std::move(*contents));
+  } catch (const std::exception& ex) {
+    XLOG(WARN) << "unable to decompress cached blob " << hash << ": "
+               << ex.what();
+    return nullptr;
+  }
+}
+
+BlobCache::CompressedTierStats BlobCache::getCompressedTierStats() const {
+  CompressedTierStats stats;
+  {
+    auto tier = compressedTier_.rlock();
+    stats.entryCount = tier->blobs.size();
+    stats.compressedSizeInBytes = tier->compressedSize;
+    stats.uncompressedSizeInBytes = tier->uncompressedSize;
+  }
+  stats.compressionCount = compressionCount_.load(std::memory_order_relaxed);
+  stats.rawHitCount = rawHitCount_.load(std::memory_order_relaxed);
+  stats.rawHitTime = std::chrono::nanoseconds{
+      rawHitNanos_.load(std::memory_order_relaxed)};
+  stats.compressedHitCount =
+      compressedHitCount_.load(std::memory_order_relaxed);
+  stats.compressedHitTime = std::chrono::nanoseconds{
+      compressedHitNanos_.load(std::memory_order_relaxed)};
+  return stats;
+}
+
+} // namespace facebook::eden
@@ -6,6 +6,13 @@
  */
 
 #pragma once
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/io/IOBuf.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/store/ObjectCache.h"
 
@@ -23,17 +30,52 @@ using BlobInterestHandle = ObjectInterestHandle<Blob>;
  * frequently-accessed large blobs when they are larger than the maximum cache
  * size.
  *
+ * Optionally, blobs evicted from the cache can be kept compressed in a second,
+ * separately budgeted tier. A lookup that misses the uncompressed blobs but
+ * finds the blob in the compressed tier decompresses it and moves it back
+ * into the uncompressed cache. Source files typically compress several times,
+ * so this holds many more blobs in the same amount of memory, at the cost of
+ * decompressing them on access.
+ *
  * It is safe to use this object from arbitrary threads.
  */
 class BlobCache : public ObjectCache<Blob, ObjectCacheFlavor::InterestHandle> {
  public:
+  struct CompressedTierStats {
+    size_t entryCount{0};
+    /// Memory used by the compressed blobs.
+    size_t compressedSizeInBytes{0};
+    /// Size the compressed blobs would have uncompressed.
+    size_t uncompressedSizeInBytes{0};
+    /// Number of evicted blobs that were compressed into the tier.
+    uint64_t compressionCount{0};
+    /// Lookups served by the uncompressed cache.
+    uint64_t rawHitCount{0};
+    std::chrono::nanoseconds rawHitTime{0};
+    /// Lookups served by decompressing a blob from the compressed tier.
+    uint64_t compressedHitCount{0};
+    std::chrono::nanoseconds compressedHitTime{0};
+  };
+
+  /**
+   * A compressedTierSizeBytes of 0 disables the compressed tier.
+   */
   static std::shared_ptr<BlobCache> create(
       size_t maximumCacheSizeBytes,
-      size_t minimumEntryCount) {
+      size_t minimumEntryCount,
+      size_t shardCount = 1,
+      CacheEvictionPolicy evictionPolicy = CacheEvictionPolicy::LRU,
+      size_t compressedTierSizeBytes = 0) {
     struct BC : BlobCache {
-      BC(size_t x, size_t y) : BlobCache{x, y} {}
+      BC(size_t x, size_t y, size_t z, CacheEvictionPolicy p, size_t c)
+          : BlobCache{x, y, z, p, c} {}
     };
-    return std::make_shared<BC>(maximumCacheSizeBytes, minimumEntryCount);
+    return std::make_shared<BC>(
+        maximumCacheSizeBytes,
+        minimumEntryCount,
+        shardCount,
+        evictionPolicy,
+        compressedTierSizeBytes);
   }
   ~BlobCache() = default;
 
@@ -51,9 +93,7 @@ class BlobCache : public ObjectCache<Blob, ObjectCacheFlavor::InterestHandle> {
    */
   GetResult get(
       const ObjectId& hash,
-      Interest interest = Interest::LikelyNeededAgain) {
-    return getInterestHandle(hash, interest);
-  }
+      Interest interest = Interest::LikelyNeededAgain);
 
   /**
    * Inserts a blob into the cache for future lookup. If the new total size
@@ -65,15 +105,66 @@ class BlobCache : public ObjectCache<Blob, ObjectCacheFlavor::InterestHandle> {
    */
   BlobInterestHandle insert(
       ObjectPtr blob,
-      Interest interest = Interest::LikelyNeededAgain) {
-    return insertInterestHandle(blob, interest);
+      Interest interest = Interest::LikelyNeededAgain);
+
+  /**
+   * Evicts everything from cache, including the compressed tier.
+   */
+  void clear();
+
+  bool hasCompressedTier() const {
+    return compressedTierSizeBytes_ != 0;
   }
 
+  CompressedTierStats getCompressedTierStats() const;
+
  private:
-  explicit BlobCache(size_t maximumCacheSizeBytes, size_t minimumEntryCount)
-      : ObjectCache<Blob, ObjectCacheFlavor::InterestHandle>{
-            maximumCacheSizeBytes,
-            minimumEntryCount} {}
+  explicit BlobCache(
+      size_t maximumCacheSizeBytes,
+      size_t minimumEntryCount,
+      size_t shardCount,
+      CacheEvictionPolicy evictionPolicy,
+      size_t compressedTierSizeBytes);
+
+  struct CompressedBlob {
+    std::unique_ptr<folly::IOBuf> data;
+    size_t uncompressedSize;
+  };
+
+  struct CompressedTier {
+    // EvictingCacheMap is only used for its LRU ordering, the tier is budgeted
+    // in bytes.
+    folly::EvictingCacheMap<ObjectId, CompressedBlob> blobs{0};
+    size_t compressedSize{0};
+    size_t uncompressedSize{0};
+  };
+
+  /**
+   * Compress the blobs evicted since the last call into the compressed tier.
+   * Must be called without holding any of the cache's locks.
+   */
+  void compressEvictedBlobs();
+
+  /**
+   * Remove the blob from the compressed tier and return it decompressed, or
+   * return nullptr if it isn't there.
+   */
+  ObjectPtr takeCompressed(const ObjectId& hash);
+
+  const size_t compressedTierSizeBytes_;
+
+  /**
+   * Blobs evicted from the uncompressed cache, waiting to be compressed. The
+   * eviction callback only queues them here, as it runs under a shard lock.
+   */
+  folly::Synchronized<std::vector<ObjectPtr>> evictedBlobs_;
+  folly::Synchronized<CompressedTier> compressedTier_;
+
+  std::atomic<uint64_t> compressionCount_{0};
+  std::atomic<uint64_t> rawHitCount_{0};
+  std::atomic<uint64_t> rawHitNanos_{0};
+  std::atomic<uint64_t> compressedHitCount_{0};
+  std::atomic<uint64_t> compressedHitNanos_{0};
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BlobMetadataCache.h"
+
+#include <folly/Bits.h>
+#include <folly/hash/SpookyHashV2.h>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+namespace facebook::eden {
+
+BlobMetadataCache::BlobMetadataCache(size_t capacity)
+    : bucketCount_{folly::nextPowTwo(
+          std::max<size_t>(capacity / kEntriesPerBucket, 1))},
+      buckets_{
+          static_cast<Bucket*>(std::calloc(bucketCount_, sizeof(Bucket)))} {
+  // A zeroed Bucket is a valid, empty and unlocked bucket.
+  static_assert(std::is_trivially_default_constructible_v<Bucket>);
+  static_assert(std::is_trivially_destructible_v<Bucket>);
+  if (!buckets_) {
+    throw std::bad_alloc();
+  }
+}
+
+BlobMetadataCache::Fingerprint BlobMetadataCache::fingerprint(
+    const ObjectId& id) {
+  auto bytes = id.getBytes();
+  uint64_t high = 0;
+  uint64_t low = 0;
+  folly::hash::SpookyHashV2::Hash128(bytes.data(), bytes.size(), &high, &low);
+  // An all-zero fingerprint marks an empty entry.
+  return Fingerprint{high | 1, low};
+}
+
+BlobMetadataCache::Bucket& BlobMetadataCache::getBucket(
+    const Fingerprint& fingerprint) const {
+  return buckets_[fingerprint.low & (bucketCount_ - 1)];
+}
+
+BlobMetadataCache::Entry* BlobMetadataCache::findEntry(
+    Bucket& bucket,
+    const Fingerprint& fingerprint) {
+  for (auto& entry : bucket.entries) {
+    if (entry.fingerprint.high == fingerprint.high &&
+        entry.fingerprint.low == fingerprint.low) {
+      return &entry;
+    }
+  }
+  return nullptr;
+}
+
+std::optional<BlobMetadata> BlobMetadataCache::get(const ObjectId& id) const {
+  auto key = fingerprint(id);
+  auto& bucket = getBucket(key);
+  std::lock_guard<folly::MicroSpinLock> guard{bucket.lock};
+  auto* entry = findEntry(bucket, key);
+  if (!entry) {
+    return std::nullopt;
+  }
+  entry->lastUse = ++bucket.clock;
+  return BlobMetadata{Hash20{entry->sha1}, entry->size};
+}
+
+bool BlobMetadataCache::contains(const ObjectId& id) const {
+  auto key = fingerprint(id);
+  auto& bucket = getBucket(key);
+  std::lock_guard<folly::MicroSpinLock> guard{bucket.lock};
+  return findEntry(bucket, key) != nullptr;
+}
+
+void BlobMetadataCache::insert(
+    const ObjectId& id,
+    const BlobMetadata& metadata) {
+  auto key = fingerprint(id);
+  auto& bucket = getBucket(key);
+  std::lock_guard<folly::MicroSpinLock> guard{bucket.lock};
+  auto* entry = findEntry(bucket, key);
+  if (!entry) {
+    // Take an empty entry if there is one, or else the least recently used.
+    // Comparing ages rather than raw clock values keeps this correct when the
+    // clock wraps around.
+    entry = &bucket.entries[0];
+    for (auto& candidate : bucket.entries) {
+      if (candidate.fingerprint.high == 0) {
+        entry = &candidate;
+        break;
+      }
+      if (bucket.clock - candidate.lastUse > bucket.clock - entry->lastUse) {
+        entry = &candidate;
+      }
+    }
+  }
+  entry->fingerprint = key;
+  entry->size = metadata.size;
+  auto sha1 = metadata.sha1.getBytes();
+  std::memcpy(entry->sha1.data(), sha1.data(), entry->sha1.size());
+  entry->lastUse = ++bucket.clock;
+}
+
+void BlobMetadataCache::clear() {
+  for (size_t i = 0; i < bucketCount_; ++i) {
+    auto& bucket = buckets_[i];
+    std::lock_guard<folly::MicroSpinLock> guard{bucket.lock};
+    for (auto& entry : bucket.entries) {
+      entry = Entry{};
+    }
+  }
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/synchronization/MicroSpinLock.h>
+#include <array>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+
+#include "eden/fs/model/BlobMetadata.h"
+#include "eden/fs/model/ObjectId.h"
+
+namespace facebook::eden {
+
+/**
+ * A bounded in-memory cache of blob sizes and SHA-1s, keyed by blob id.
+ *
+ * Build tools query the metadata of tens of thousands of files at once, so
+ * this is laid out to be as small and allocation-free as possible: a flat,
+ * set-associative table of fixed-size entries. Each entry holds a 128-bit
+ * fingerprint of the blob id, the blob size and its SHA-1, with no per-entry
+ * heap allocation. When a set is full, its least recently used entry is
+ * replaced.
+ *
+ * The table is allocated zeroed with calloc, so its memory is only committed
+ * as entries get populated.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class BlobMetadataCache {
+ public:
+  /**
+   * Create a cache holding at most roughly `capacity` entries.
+   */
+  explicit BlobMetadataCache(size_t capacity);
+
+  BlobMetadataCache(const BlobMetadataCache&) = delete;
+  BlobMetadataCache& operator=(const BlobMetadataCache&) = delete;
+
+  std::optional<BlobMetadata> get(const ObjectId& id) const;
+  bool contains(const ObjectId& id) const;
+  void insert(const ObjectId& id, const BlobMetadata& metadata);
+  void clear();
+
+  size_t getCapacity() const {
+    return bucketCount_ * kEntriesPerBucket;
+  }
+
+ private:
+  static constexpr size_t kEntriesPerBucket = 8;
+
+  struct Fingerprint {
+    uint64_t high;
+    uint64_t low;
+  };
+
+  struct Entry {
+    /// Both zero for an empty entry.
+    Fingerprint fingerprint;
+    uint64_t size;
+    std::array<uint8_t, Hash20::RAW_SIZE> sha1;
+    /// Value of the bucket's clock when this entry was last used.
+    uint32_t lastUse;
+  };
+
+  struct Bucket {
+    folly::MicroSpinLock lock;
+    uint32_t clock;
+    Entry entries[kEntriesPerBucket];
+  };
+
+  struct FreeDeleter {
+    void operator()(Bucket* buckets) const {
+      std::free(buckets);
+    }
+  };
+
+  static Fingerprint fingerprint(const ObjectId& id);
+  Bucket& getBucket(const Fingerprint& fingerprint) const;
+  static Entry* findEntry(Bucket& bucket, const Fingerprint& fingerprint);
+
+  const size_t bucketCount_;
+  std::unique_ptr<Bucket[], FreeDeleter> buckets_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/CacheMemoryGovernor.h"
+
+#include <folly/logging/xlog.h>
+#include <algorithm>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/store/BlobCache.h"
+#include "eden/fs/store/TreeCache.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace facebook::eden {
+
+namespace {
+// Budgets are cut quickly when memory gets tight and recovered slowly, so
+// that the caches don't oscillate around the pressure threshold.
+constexpr double kShrinkFactor = 0.5;
+constexpr double kGrowStep = 0.1;
+} // namespace
+
+CacheMemoryGovernor::CacheMemoryGovernor(
+    std::shared_ptr<BlobCache> blobCache,
+    std::shared_ptr<TreeCache> treeCache,
+    std::shared_ptr<EdenStats> stats)
+    : blobCache_{std::move(blobCache)},
+      treeCache_{std::move(treeCache)},
+      stats_{std::move(stats)},
+      blobCacheMaximumSize_{blobCache_->getMaximumCacheSize()},
+      treeCacheMaximumSize_{treeCache_->getMaximumCacheSize()} {}
+
+void CacheMemoryGovernor::run(const EdenConfig& config) {
+  Sample sample;
+  sample.pressure = proc_util::readMemoryPressure();
+  if (auto memoryStats = proc_util::readMemoryStats()) {
+    sample.residentBytes = memoryStats->resident;
+  }
+  adjust(config, sample);
+}
+
+void CacheMemoryGovernor::adjust(
+    const EdenConfig& config,
+    const Sample& sample) {
+  auto rssLimit = config.memoryGovernorRssLimit.getValue();
+  bool overRssLimit = rssLimit != 0 && sample.residentBytes &&
+      *sample.residentBytes > rssLimit;
+  bool highPressure = sample.pressure &&
+      sample.pressure->someAvg10 >=
+          config.memoryGovernorHighPressure.getValue();
+  bool lowPressure = !sample.pressure ||
+      sample.pressure->someAvg10 <= config.memoryGovernorLowPressure.getValue();
+
+  auto minimumFraction =
+      std::clamp(config.memoryGovernorMinimumFraction.getValue(), 0.0, 1.0);
+  auto fraction = budgetFraction_;
+  if (overRssLimit || highPressure) {
+    fraction = std::max(minimumFraction, fraction * kShrinkFactor);
+  } else if (lowPressure) {
+    fraction = std::min(1.0, fraction + kGrowStep);
+  }
+  // Config changes may have raised the floor since the last check.
+  fraction = std::max(minimumFraction, fraction);
+
+  if (fraction == budgetFraction_) {
+    return;
+  }
+
+  XLOG(INFO) << (fraction < budgetFraction_ ? "Shrinking" : "Growing")
+             << " cache budgets to " << fraction * 100
+             << "% of their maximum (memory pressure: "
+             << (sample.pressure ? sample.pressure->someAvg10 : 0.0)
+             << "%, rss: " << sample.residentBytes.value_or(0) << " bytes)";
+  stats_->increment(
+      fraction < budgetFraction_ ? &ObjectStoreStats::cacheBudgetShrink
+                                 : &ObjectStoreStats::cacheBudgetGrow);
+  applyBudgetFraction(fraction);
+}
+
+void CacheMemoryGovernor::applyBudgetFraction(double fraction) {
+  budgetFraction_ = fraction;
+  blobCache_->setMaximumCacheSize(
+      static_cast<size_t>(blobCacheMaximumSize_ * fraction));
+  treeCache_->setMaximumCacheSize(
+      static_cast<size_t>(treeCacheMaximumSize_ * fraction));
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+#include <optional>
+
+#include "eden/fs/utils/ProcUtil.h"
+
+namespace facebook::eden {
+
+class BlobCache;
+class EdenConfig;
+class EdenStats;
+class TreeCache;
+
+/**
+ * Adjusts the size budgets of the BlobCache and TreeCache at runtime based on
+ * how much memory pressure the system, or the cgroup EdenFS runs in, is
+ * under.
+ *
+ * The budgets configured at startup are the upper bound. While memory
+ * pressure or the resident set size is above the configured thresholds, the
+ * budgets are halved on every check, down to a configured fraction of the
+ * startup budgets. Once pressure subsides, they grow back by a fixed step per
+ * check. Shrinking a cache evicts entries right away.
+ *
+ * This object is not thread-safe: it is meant to be driven by a single
+ * periodic task.
+ */
+class CacheMemoryGovernor {
+ public:
+  struct Sample {
+    std::optional<proc_util::MemoryPressure> pressure;
+    std::optional<size_t> residentBytes;
+  };
+
+  CacheMemoryGovernor(
+      std::shared_ptr<BlobCache> blobCache,
+      std::shared_ptr<TreeCache> treeCache,
+      std::shared_ptr<EdenStats> stats);
+
+  /**
+   * Sample the current memory pressure and RSS of this process and adjust the
+   * cache budgets accordingly.
+   */
+  void run(const EdenConfig& config);
+
+  /**
+   * Adjust the cache budgets for the given sample.
+   */
+  void adjust(const EdenConfig& config, const Sample& sample);
+
+  /**
+   * Fraction of the startup budgets the caches are currently allowed to use.
+   */
+  double getBudgetFraction() const {
+    return budgetFraction_;
+  }
+
+ private:
+  void applyBudgetFraction(double fraction);
+
+  const std::shared_ptr<BlobCache> blobCache_;
+  const std::shared_ptr<TreeCache> treeCache_;
+  const std::shared_ptr<EdenStats> stats_;
+
+  const size_t blobCacheMaximumSize_;
+  const size_t treeCacheMaximumSize_;
+
+  double budgetFraction_{1.0};
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/CacheWarmer.h"
+
+#include <folly/String.h>
+#include <folly/executors/QueuedImmediateExecutor.h>
+#include <folly/logging/xlog.h>
+
+#include "eden/fs/store/BlobCache.h"
+#include "eden/fs/store/ImportPriority.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/store/TreeCache.h"
+#include "eden/fs/utils/FileUtils.h"
+
+namespace facebook::eden {
+
+namespace {
+// Every line of the file is "<kind> <hex object id>".
+constexpr char kTreeKind = 't';
+constexpr char kBlobKind = 'b';
+
+class CacheWarmingFetchContext : public ObjectFetchContext {
+ public:
+  Cause getCause() const override {
+    return Cause::Prefetch;
+  }
+
+  std::optional<std::string_view> getCauseDetail() const override {
+    return "cache-warming";
+  }
+
+  ImportPriority getPriority() const override {
+    return kCacheWarmingPriority;
+  }
+
+  const std::unordered_map<std::string, std::string>* FOLLY_NULLABLE
+  getRequestInfo() const override {
+    return nullptr;
+  }
+};
+
+void appendIds(std::string& out, char kind, const std::vector<ObjectId>& ids) {
+  for (const auto& id : ids) {
+    out.push_back(kind);
+    out.push_back(' ');
+    out.append(folly::hexlify(id.getBytes()));
+    out.push_back('\n');
+  }
+}
+} // namespace
+
+HotObjectIds HotObjectIds::fromCaches(
+    const BlobCache& blobCache,
+    const TreeCache& treeCache,
+    size_t maxCount) {
+  HotObjectIds ids;
+  ids.trees = treeCache.getHotObjectIds(maxCount);
+  ids.blobs = blobCache.getHotObjectIds(maxCount);
+  return ids;
+}
+
+void HotObjectIds::save(AbsolutePathPiece path) const {
+  std::string contents;
+  appendIds(contents, kTreeKind, trees);
+  appendIds(contents, kBlobKind, blobs);
+  writeFileAtomic(path, folly::StringPiece{contents}).value();
+}
+
+HotObjectIds HotObjectIds::load(AbsolutePathPiece path) {
+  auto contents = readFile(path).value();
+
+  HotObjectIds ids;
+  std::vector<folly::StringPiece> lines;
+  folly::split('\n', contents, lines, /*ignoreEmpty=*/true);
+  std::string bytes;
+  for (auto line : lines) {
+    if (line.size() < 3 || line[1] != ' ' ||
+        !folly::unhexlify(line.subpiece(2), bytes)) {
+      XLOG(DBG3) << "skipping malformed line in " << path << ": " << line;
+      continue;
+    }
+    auto id = ObjectId{folly::ByteRange{folly::StringPiece{bytes}}};
+    switch (line[0]) {
+      case kTreeKind:
+        ids.trees.push_back(std::move(id));
+        break;
+      case kBlobKind:
+        ids.blobs.push_back(std::move(id));
+        break;
+      default:
+        XLOG(DBG3) << "skipping malformed line in " << path << ": " << line;
+        break;
+    }
+  }
+  return ids;
+}
+
+std::shared_ptr<CacheWarmer> CacheWarmer::start(
+    std::shared_ptr<ObjectStore> objectStore,
+    HotObjectIds ids,
+    size_t maxInFlight) {
+  auto warmer = std::shared_ptr<CacheWarmer>{
+      new CacheWarmer{std::move(objectStore), std::move(ids)}};
+  XLOG(INFO) << "Warming up caches with " << warmer->totalCount_
+             << " objects";
+
+  auto laneCount = std::max<size_t>(
+      1, std::min<size_t>(maxInFlight, warmer->totalCount_));
+  // Count every lane before starting any, so that the first lane to finish
+  // doesn't complete the warm-up early.
+  warmer->activeLanes_.store(laneCount, std::memory_order_relaxed);
+  for (size_t i = 0; i < laneCount; ++i) {
+    warmer->fetchNext();
+  }
+  return warmer;
+}
+
+CacheWarmer::CacheWarmer(
+    std::shared_ptr<ObjectStore> objectStore,
+    HotObjectIds ids)
+    : objectStore_{std::move(objectStore)},
+      ids_{std::move(ids)},
+      totalCount_{ids_.trees.size() + ids_.blobs.size()},
+      context_{makeRefPtr<CacheWarmingFetchContext>()} {}
+
+void CacheWarmer::cancel() {
+  if (!cancelled_.exchange(true, std::memory_order_relaxed)) {
+    XLOG(INFO) << "Cancelling cache warm-up";
+  }
+}
+
+CacheWarmer::Progress CacheWarmer::getProgress() const {
+  Progress progress;
+  progress.totalCount = totalCount_;
+  progress.fetchedCount = fetchedCount_.load(std::memory_order_relaxed);
+  progress.failedCount = failedCount_.load(std::memory_order_relaxed);
+  progress.cancelled = cancelled_.load(std::memory_order_relaxed);
+  progress.done = done_.load(std::memory_order_acquire);
+  return progress;
+}
+
+folly::SemiFuture<folly::Unit> CacheWarmer::getCompletionFuture() {
+  return completion_.getSemiFuture();
+}
+
+void CacheWarmer::fetchNext() {
+  // Fetches served from memory or the LocalStore usually complete right away.
+  // Loop over those instead of recursing, and only go asynchronous for the
+  // others.
+  while (!cancelled_.load(std::memory_order_relaxed)) {
+    auto index = nextIndex_.fetch_add(1, std::memory_order_relaxed);
+    if (index >= totalCount_) {
+      break;
+    }
+
+    auto future = makeImmediateFutureWith([&] {
+      if (index < ids_.trees.size()) {
+        return objectStore_->getTree(ids_.trees[index], context_).unit();
+      }
+      return objectStore_
+          ->getBlob(ids_.blobs[index - ids_.trees.size()], context_)
+          .unit();
+    });
+
+    if (future.isReady()) {
+      recordResult(std::move(future).getTry().hasValue());
+      continue;
+    }
+
+    std::move(future)
+        .semi()
+        .via(&folly::QueuedImmediateExecutor::instance())
+        .thenTry([self = shared_from_this()](folly::Try<folly::Unit>&& t) {
+          self->recordResult(t.hasValue());
+          self->fetchNext();
+        });
+    return;
+  }
+  finishLane();
+}
+
+void CacheWarmer::recordResult(bool success) {
+  size_t finished;
+  if (success) {
+    finished = fetchedCount_.fetch_add(1, std::memory_order_relaxed) + 1 +
+        failedCount_.load(std::memory_order_relaxed);
+  } else {
+    finished = failedCount_.fetch_add(1, std::memory_order_relaxed) + 1 +
+        fetchedCount_.load(std::memory_order_relaxed);
+  }
+
+  auto step = std::max<size_t>(1, totalCount_ / 10);
+  if (finished % step == 0) {
+    XLOG(DBG2) << "Cache warm-up progress: " << finished << "/" << totalCount_;
+  }
+}
+
+void CacheWarmer::finishLane() {
+  if (activeLanes_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+    return;
+  }
+  done_.store(true, std::memory_order_release);
+  auto progress = getProgress();
+  XLOG(INFO) << "Cache warm-up " << (progress.cancelled ? "cancelled" : "done")
+             << ": fetched " << progress.fetchedCount << " objects, "
+             << progress.failedCount << " failed, out of "
+             << progress.totalCount;
+  completion_.setValue();
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/futures/SharedPromise.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class BlobCache;
+class ObjectStore;
+class TreeCache;
+
+/**
+ * The ids of the objects that were hot in the in-memory caches, most recently
+ * used first. Only ids are recorded, never the contents.
+ */
+struct HotObjectIds {
+  std::vector<ObjectId> trees;
+  std::vector<ObjectId> blobs;
+
+  /**
+   * Collect up to `maxCount` ids from each cache.
+   */
+  static HotObjectIds fromCaches(
+      const BlobCache& blobCache,
+      const TreeCache& treeCache,
+      size_t maxCount);
+
+  /**
+   * Write the ids to `path`, atomically replacing it. Throws on error.
+   */
+  void save(AbsolutePathPiece path) const;
+
+  /**
+   * Read ids written by save(). Throws if the file can't be read. Malformed
+   * lines are skipped.
+   */
+  static HotObjectIds load(AbsolutePathPiece path);
+};
+
+/**
+ * Warms up the in-memory caches after a restart (or on a fresh host) by
+ * prefetching a set of HotObjectIds through an ObjectStore, at low import
+ * priority so that it doesn't compete with real work.
+ *
+ * Trees are fetched before blobs. At most `maxInFlight` fetches are
+ * outstanding at any time. Objects that fail to load are counted and
+ * skipped.
+ *
+ * It is safe to call cancel() and getProgress() from arbitrary threads.
+ */
+class CacheWarmer : public std::enable_shared_from_this<CacheWarmer> {
+ public:
+  struct Progress {
+    size_t totalCount{0};
+    size_t fetchedCount{0};
+    size_t failedCount{0};
+    bool cancelled{false};
+    bool done{false};
+  };
+
+  /**
+   * Start warming up the caches in the background.
+   */
+  static std::shared_ptr<CacheWarmer> start(
+      std::shared_ptr<ObjectStore> objectStore,
+      HotObjectIds ids,
+      size_t maxInFlight);
+
+  /**
+   * Stop issuing new fetches. Fetches already in flight still complete.
+   */
+  void cancel();
+
+  Progress getProgress() const;
+
+  /**
+   * Completes once every fetch issued by this warmer has finished, whether
+   * the warm-up ran to completion or was cancelled.
+   */
+  folly::SemiFuture<folly::Unit> getCompletionFuture();
+
+ private:
+  CacheWarmer(std::shared_ptr<ObjectStore> objectStore, HotObjectIds ids);
+
+  /**
+   * Fetch objects one after the other until the warm-up is over. Each of the
+   * maxInFlight "lanes" runs this loop.
+   */
+  void fetchNext();
+  void recordResult(bool success);
+  void finishLane();
+
+  const std::shared_ptr<ObjectStore> objectStore_;
+  const HotObjectIds ids_;
+  const size_t totalCount_;
+  const ObjectFetchContextPtr context_;
+
+  std::atomic<size_t> nextIndex_{0};
+  std::atomic<size_t> fetchedCount_{0};
+  std::atomic<size_t> failedCount_{0};
+  std::atomic<size_t> activeLanes_{0};
+  std::atomic<bool> cancelled_{false};
+  std::atomic<bool> done_{false};
+
+  folly::SharedPromise<folly::Unit> completion_;
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/CompactionScheduler.h"
+
+#include <folly/logging/xlog.h>
+#include <algorithm>
+
+#include "eden/fs/config/EdenConfig.h"
+
+namespace facebook::eden {
+
+CompactionScheduler::CompactionScheduler(
+    std::chrono::milliseconds pollInterval)
+    : pollInterval_{pollInterval} {}
+
+void CompactionScheduler::setLatencyProbe(LatencyProbe probe) {
+  *probe_.wlock() = std::move(probe);
+}
+
+void CompactionScheduler::updateConfig(const EdenConfig& config) {
+  deferLatencyUs_.store(
+      std::chrono::duration_cast<std::chrono::microseconds>(
+          config.localStoreGcDeferLatency.getValue())
+          .count(),
+      std::memory_order_relaxed);
+  maxDeferralMs_.store(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          config.localStoreGcMaxDeferral.getValue())
+          .count(),
+      std::memory_order_relaxed);
+  evictionBatchSize_.store(
+      std::max<uint64_t>(config.localStoreGcEvictionBatchSize.getValue(), 1),
+      std::memory_order_relaxed);
+  rateLimit_.store(
+      config.localStoreCompactionRateLimit.getValue(),
+      std::memory_order_relaxed);
+}
+
+std::chrono::microseconds CompactionScheduler::getForegroundLatency() const {
+  auto probe = probe_.rlock();
+  if (!*probe) {
+    return std::chrono::microseconds{0};
+  }
+  return (*probe)();
+}
+
+bool CompactionScheduler::shouldDefer() const {
+  auto threshold = std::chrono::microseconds{
+      deferLatencyUs_.load(std::memory_order_relaxed)};
+  if (threshold.count() <= 0) {
+    return false;
+  }
+  return getForegroundLatency() > threshold;
+}
+
+bool CompactionScheduler::waitUntilIdle() {
+  if (isCancelled()) {
+    return false;
+  }
+  if (!shouldDefer()) {
+    return true;
+  }
+
+  deferralCount_.fetch_add(1, std::memory_order_relaxed);
+  auto deadline = std::chrono::steady_clock::now() +
+      std::chrono::milliseconds{maxDeferralMs_.load(std::memory_order_relaxed)};
+  XLOG(DBG3) << "deferring local store maintenance: foreground latency is "
+             << getForegroundLatency().count() << "us";
+
+  std::unique_lock<std::mutex> lock{cancelMutex_};
+  while (std::chrono::steady_clock::now() < deadline) {
+    if (cancelCondition_.wait_for(
+            lock, pollInterval_, [this] { return isCancelled(); })) {
+      return false;
+    }
+    lock.unlock();
+    auto defer = shouldDefer();
+    lock.lock();
+    if (!defer) {
+      return true;
+    }
+  }
+  XLOG(DBG2) << "running local store maintenance despite elevated "
+                "foreground latency: maximum deferral reached";
+  return !isCancelled();
+}
+
+void CompactionScheduler::cancel() {
+  {
+    std::lock_guard<std::mutex> guard{cancelMutex_};
+    cancelled_.store(true, std::memory_order_release);
+  }
+  cancelCondition_.notify_all();
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+namespace facebook::eden {
+
+class EdenConfig;
+
+/**
+ * Decides when background LocalStore maintenance (garbage collection and
+ * compaction) may run, so that it doesn't compete with filesystem requests
+ * for I/O.
+ *
+ * The server installs a latency probe reporting how long the oldest
+ * outstanding filesystem request has been running. While that exceeds the
+ * configured threshold, maintenance work waits, for at most the configured
+ * maximum deferral so that the store still gets collected on a machine that
+ * is never idle.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class CompactionScheduler {
+ public:
+  using LatencyProbe = std::function<std::chrono::microseconds()>;
+
+  explicit CompactionScheduler(
+      std::chrono::milliseconds pollInterval = std::chrono::milliseconds{100});
+
+  CompactionScheduler(const CompactionScheduler&) = delete;
+  CompactionScheduler& operator=(const CompactionScheduler&) = delete;
+
+  /**
+   * Install the function reporting the current foreground request latency.
+   * Pass nullptr to remove it, after which work is never deferred. This
+   * waits for concurrent calls of the previous probe to return.
+   */
+  void setLatencyProbe(LatencyProbe probe);
+
+  /**
+   * Pick up the deferral thresholds, eviction batch size and rate limit
+   * from the config.
+   */
+  void updateConfig(const EdenConfig& config);
+
+  /**
+   * The latency reported by the probe, or 0 if there is none.
+   */
+  std::chrono::microseconds getForegroundLatency() const;
+
+  /**
+   * Whether foreground latency is currently elevated enough that background
+   * work should wait.
+   */
+  bool shouldDefer() const;
+
+  /**
+   * Block until shouldDefer() returns false or the maximum deferral has
+   * elapsed. Returns false, without waiting further, if cancel() was called.
+   */
+  bool waitUntilIdle();
+
+  /**
+   * Make current and future waitUntilIdle() calls return false. Called when
+   * the store is closing so that maintenance work stops early.
+   */
+  void cancel();
+
+  bool isCancelled() const {
+    return cancelled_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Approximate number of bytes incremental eviction deletes in one step.
+   */
+  uint64_t getEvictionBatchSize() const {
+    return evictionBatchSize_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Configured compaction write rate limit in bytes per second, 0 when
+   * unlimited. Only the storage engine can enforce it.
+   */
+  uint64_t getRateLimit() const {
+    return rateLimit_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Number of waitUntilIdle() calls that had to wait.
+   */
+  uint64_t getDeferralCount() const {
+    return deferralCount_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  const std::chrono::milliseconds pollInterval_;
+
+  folly::Synchronized<LatencyProbe> probe_;
+
+  std::atomic<std::chrono::microseconds::rep> deferLatencyUs_{0};
+  std::atomic<std::chrono::milliseconds::rep> maxDeferralMs_{0};
+  std::atomic<uint64_t> evictionBatchSize_{64 * 1024 * 1024};
+  std::atomic<uint64_t> rateLimit_{0};
+  std::atomic<uint64_t> deferralCount_{0};
+
+  std::atomic<bool> cancelled_{false};
+  std::mutex cancelMutex_;
+  std::condition_variable cancelCondition_;
+};
+
+} // namespace facebook::eden
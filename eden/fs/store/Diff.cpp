@@ -11,6 +11,7 @@
 #include <folly/Synchronized.h>
 #include <folly/logging/xlog.h>
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include "eden/fs/model/Blob.h"
@@ -39,14 +40,44 @@ namespace facebook::eden {
  */
 namespace {
 
+/**
+ * A pair of trees to diff, identified by their IDs. The scm side is missing
+ * for added directories, and the wd side for removed ones.
+ */
+struct SubtreeDiff {
+  RelativePath path;
+  std::optional<ObjectId> scmHash;
+  std::optional<ObjectId> wdHash;
+  const GitIgnoreStack* ignore;
+  bool isIgnored;
+};
+
 struct ChildFutures {
   void add(RelativePath&& path, ImmediateFuture<Unit>&& future) {
     paths.emplace_back(std::move(path));
     futures.emplace_back(std::move(future));
   }
 
+  void addSubtree(
+      RelativePath&& path,
+      std::optional<ObjectId> scmHash,
+      std::optional<ObjectId> wdHash,
+      const GitIgnoreStack* ignore,
+      bool isIgnored) {
+    subtrees.push_back(SubtreeDiff{
+        std::move(path),
+        std::move(scmHash),
+        std::move(wdHash),
+        ignore,
+        isIgnored});
+  }
+
   vector<RelativePath> paths;
   vector<ImmediateFuture<Unit>> futures;
+
+  // The subtrees of the directory being diffed that differ. Their trees are
+  // fetched together once the whole directory has been walked.
+  vector<SubtreeDiff> subtrees;
 };
 
 static constexpr PathComponentPiece kIgnoreFilename{".gitignore"};
@@ -68,10 +99,12 @@ void processRemovedSide(
   if (!scmEntry.second.isTree()) {
     return;
   }
-  auto entryPath = currentPath + scmEntry.first;
-  auto childFuture =
-      diffRemovedTree(context, entryPath, scmEntry.second.getHash());
-  childFutures.add(std::move(entryPath), std::move(childFuture));
+  childFutures.addSubtree(
+      currentPath + scmEntry.first,
+      scmEntry.second.getHash(),
+      std::nullopt,
+      nullptr,
+      false);
 }
 
 /**
@@ -113,9 +146,12 @@ void processAddedSide(
 
   if (wdEntry.second.isTree()) {
     if (!entryIgnored || context->listIgnored) {
-      auto childFuture = diffAddedTree(
-          context, entryPath, wdEntry.second.getHash(), ignore, entryIgnored);
-      childFutures.add(std::move(entryPath), std::move(childFuture));
+      childFutures.addSubtree(
+          std::move(entryPath),
+          std::nullopt,
+          wdEntry.second.getHash(),
+          ignore,
+          entryIgnored);
     }
   }
 }
@@ -164,14 +200,12 @@ void processBothPresent(
         return;
       }
       context->callback->modifiedPath(entryPath, wdEntry.second.getDtype());
-      auto childFuture = diffTrees(
-          context,
-          entryPath,
+      childFutures.addSubtree(
+          std::move(entryPath),
           scmEntry.second.getHash(),
           wdEntry.second.getHash(),
           ignore,
           entryIgnored);
-      childFutures.add(std::move(entryPath), std::move(childFuture));
     } else {
       // tree-to-file
       // Add a ADDED entry for this path and a removal of the directory
@@ -185,9 +219,12 @@ void processBothPresent(
 
       // Report everything in scmTree as REMOVED
       context->callback->removedPath(entryPath, scmEntry.second.getDtype());
-      auto childFuture =
-          diffRemovedTree(context, entryPath, scmEntry.second.getHash());
-      childFutures.add(std::move(entryPath), std::move(childFuture));
+      childFutures.addSubtree(
+          std::move(entryPath),
+          scmEntry.second.getHash(),
+          std::nullopt,
+          nullptr,
+          false);
     }
   } else {
     if (isTreeWD) {
@@ -197,9 +234,12 @@ void processBothPresent(
 
       // Report everything in wdEntry as ADDED
       context->callback->addedPath(entryPath, wdEntry.second.getDtype());
-      auto childFuture = diffAddedTree(
-          context, entryPath, wdEntry.second.getHash(), ignore, entryIgnored);
-      childFutures.add(std::move(entryPath), std::move(childFuture));
+      childFutures.addSubtree(
+          std::move(entryPath),
+          std::nullopt,
+          wdEntry.second.getHash(),
+          ignore,
+          entryIgnored);
     } else {
       // file-to-file diff
       // Even if blobs have different hashes, they could have the same contents.
@@ -255,6 +295,10 @@ FOLLY_NODISCARD ImmediateFuture<Unit> waitOnResults(
       });
 }
 
+FOLLY_NODISCARD ImmediateFuture<Unit> diffSubtrees(
+    DiffContext* context,
+    vector<SubtreeDiff> subtrees);
+
 /**
  * Diff two trees.
  *
@@ -324,6 +368,12 @@ FOLLY_NODISCARD ImmediateFuture<Unit> computeTreeDiff(
     }
   }
 
+  if (!childFutures.subtrees.empty()) {
+    auto subtrees = std::move(childFutures.subtrees);
+    childFutures.add(
+        currentPath.copy(), diffSubtrees(context, std::move(subtrees)));
+  }
+
   // Add an ensure() block that makes sure the ignore stack exists until all of
   // our children results have finished processing
   return waitOnResults(context, std::move(childFutures))
@@ -331,9 +381,9 @@ FOLLY_NODISCARD ImmediateFuture<Unit> computeTreeDiff(
 }
 
 /**
- * Load the content of the .gitignore file and return it.
+ * Load the .gitignore file and return its parsed contents.
  */
-ImmediateFuture<std::string> loadGitIgnore(
+ImmediateFuture<std::shared_ptr<const GitIgnore>> loadGitIgnore(
     DiffContext* context,
     const TreeEntry& treeEntry,
     RelativePath gitIgnorePath) {
@@ -342,12 +392,16 @@ ImmediateFuture<std::string> loadGitIgnore(
       type != TreeEntryType::EXECUTABLE_FILE) {
     XLOG(WARN) << "error loading gitignore at " << gitIgnorePath
                << ": not a regular file";
-    return std::string{};
+    return std::shared_ptr<const GitIgnore>{};
   } else {
     const auto& hash = treeEntry.getHash();
+    if (auto cached = context->getCachedGitIgnore(hash)) {
+      return cached;
+    }
     return context->store->getBlob(hash, context->getFetchContext())
-        .thenTry([entryPath = std::move(gitIgnorePath)](
-                     folly::Try<std::shared_ptr<const Blob>> blobTry) {
+        .thenTry([context, hash, entryPath = std::move(gitIgnorePath)](
+                     folly::Try<std::shared_ptr<const Blob>> blobTry)
+                     -> std::shared_ptr<const GitIgnore> {
           if (blobTry.hasException()) {
             // TODO: add an API to DiffCallback to report user
             // errors like this (errors that do not indicate a
@@ -356,11 +410,13 @@ ImmediateFuture<std::string> loadGitIgnore(
             XLOG(WARN) << "error loading gitignore at " << entryPath << ": "
                        << folly::exceptionStr(blobTry.exception());
 
-            return std::string{};
+            return nullptr;
           }
           const auto& contentsBuf = blobTry.value()->getContents();
           folly::io::Cursor cursor(&contentsBuf);
-          return cursor.readFixedString(contentsBuf.computeChainDataLength());
+          return context->parseGitIgnore(
+              hash,
+              cursor.readFixedString(contentsBuf.computeChainDataLength()));
         });
   }
 }
@@ -396,7 +452,7 @@ FOLLY_NODISCARD ImmediateFuture<Unit> diffTrees(
         isIgnored);
   }
 
-  ImmediateFuture<std::string> gitIgnore{};
+  ImmediateFuture<std::shared_ptr<const GitIgnore>> gitIgnore{};
   if (wdTree) {
     // If this directory has a .gitignore file, load it first.
     const auto it = wdTree->find(kIgnoreFilename);
@@ -411,9 +467,9 @@ FOLLY_NODISCARD ImmediateFuture<Unit> diffTrees(
        scmTree = std::move(scmTree),
        wdTree = std::move(wdTree),
        parentIgnore,
-       isIgnored](std::string gitIgnore) mutable {
-        auto gitIgnoreStack =
-            std::make_unique<GitIgnoreStack>(parentIgnore, gitIgnore);
+       isIgnored](std::shared_ptr<const GitIgnore> gitIgnore) mutable {
+        auto gitIgnoreStack = std::make_unique<GitIgnoreStack>(
+            parentIgnore, std::move(gitIgnore));
         return computeTreeDiff(
             context,
             currentPath,
@@ -424,6 +480,56 @@ FOLLY_NODISCARD ImmediateFuture<Unit> diffTrees(
       });
 }
 
+/**
+ * Diff the subtrees that differ in a directory.
+ *
+ * Their trees are all fetched with a single ObjectStore::getTreeBatch() call,
+ * so that diffing distant commits costs a batch of fetches per directory
+ * rather than one fetch per subtree.
+ */
+FOLLY_NODISCARD ImmediateFuture<Unit> diffSubtrees(
+    DiffContext* context,
+    vector<SubtreeDiff> subtrees) {
+  vector<ObjectId> ids;
+  ids.reserve(subtrees.size() * 2);
+  for (const auto& subtree : subtrees) {
+    if (subtree.scmHash) {
+      ids.push_back(*subtree.scmHash);
+    }
+    if (subtree.wdHash) {
+      ids.push_back(*subtree.wdHash);
+    }
+  }
+
+  return context->store->getTreeBatch(ids, context->getFetchContext())
+      .thenValue([context, subtrees = std::move(subtrees)](
+                     vector<Try<std::shared_ptr<const Tree>>>&& trees) mutable {
+        size_t nextTree = 0;
+        auto takeTree = [&](const std::optional<ObjectId>& hash) {
+          return hash ? std::move(trees[nextTree++])
+                      : Try<std::shared_ptr<const Tree>>{
+                            std::shared_ptr<const Tree>{}};
+        };
+
+        ChildFutures childFutures;
+        for (auto& subtree : subtrees) {
+          auto scmTree = takeTree(subtree.scmHash);
+          auto wdTree = takeTree(subtree.wdHash);
+          auto childFuture = makeImmediateFutureWith([&] {
+            return diffTrees(
+                context,
+                subtree.path,
+                std::move(scmTree).value(),
+                std::move(wdTree).value(),
+                subtree.ignore,
+                subtree.isIgnored);
+          });
+          childFutures.add(std::move(subtree.path), std::move(childFuture));
+        }
+        return waitOnResults(context, std::move(childFutures));
+      });
+}
+
 FOLLY_NODISCARD ImmediateFuture<Unit> diffTrees(
     DiffContext* context,
     RelativePathPiece currentPath,
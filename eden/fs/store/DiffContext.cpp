@@ -7,6 +7,7 @@
 
 #include "eden/fs/store/DiffContext.h"
 
+#include "eden/fs/model/git/GitIgnoreCache.h"
 #include "eden/fs/model/git/GitIgnoreStack.h"
 #include "eden/fs/model/git/TopLevelIgnores.h"
 #include "eden/fs/store/IObjectStore.h"
@@ -19,11 +20,13 @@ DiffContext::DiffContext(
     bool listIgnored,
     CaseSensitivity caseSensitive,
     const ObjectStore* os,
-    std::unique_ptr<TopLevelIgnores> topLevelIgnores)
+    std::shared_ptr<const TopLevelIgnores> topLevelIgnores,
+    GitIgnoreCache* gitIgnoreCache)
     : callback{cb},
       store{os},
       listIgnored{listIgnored},
       topLevelIgnores_(std::move(topLevelIgnores)),
+      gitIgnoreCache_{gitIgnoreCache},
       cancellation_{std::move(cancellation)},
       caseSensitive_{caseSensitive} {}
 
@@ -37,4 +40,23 @@ bool DiffContext::isCancelled() const {
   return cancellation_.isCancellationRequested();
 }
 
+std::shared_ptr<const GitIgnore> DiffContext::getCachedGitIgnore(
+    const ObjectId& id) const {
+  if (!gitIgnoreCache_) {
+    return nullptr;
+  }
+  return gitIgnoreCache_->get(id);
+}
+
+std::shared_ptr<const GitIgnore> DiffContext::parseGitIgnore(
+    const ObjectId& id,
+    folly::StringPiece contents) const {
+  if (gitIgnoreCache_) {
+    return gitIgnoreCache_->parse(id, contents);
+  }
+  auto ignore = std::make_shared<GitIgnore>();
+  ignore->loadFile(contents);
+  return ignore;
+}
+
 } // namespace facebook::eden
@@ -9,6 +9,7 @@
 
 #include <folly/CancellationToken.h>
 #include <folly/Range.h>
+#include <memory>
 
 #include "eden/fs/store/StatsFetchContext.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -18,7 +19,10 @@ namespace facebook::eden {
 template <typename T>
 class ImmediateFuture;
 class DiffCallback;
+class GitIgnore;
+class GitIgnoreCache;
 class GitIgnoreStack;
+class ObjectId;
 class ObjectStore;
 class UserInfo;
 class TopLevelIgnores;
@@ -41,7 +45,8 @@ class DiffContext {
       bool listIgnored,
       CaseSensitivity caseSensitive,
       const ObjectStore* os,
-      std::unique_ptr<TopLevelIgnores> topLevelIgnores);
+      std::shared_ptr<const TopLevelIgnores> topLevelIgnores,
+      GitIgnoreCache* gitIgnoreCache = nullptr);
 
   DiffContext(const DiffContext&) = delete;
   DiffContext& operator=(const DiffContext&) = delete;
@@ -62,6 +67,20 @@ class DiffContext {
   const GitIgnoreStack* getToplevelIgnore() const;
   bool isCancelled() const;
 
+  /**
+   * Returns the parsed .gitignore file identified by id if an earlier diff
+   * already parsed it, or nullptr.
+   */
+  std::shared_ptr<const GitIgnore> getCachedGitIgnore(const ObjectId& id) const;
+
+  /**
+   * Parse contents, the contents of the .gitignore file identified by id,
+   * reusing the result of earlier diffs when possible.
+   */
+  std::shared_ptr<const GitIgnore> parseGitIgnore(
+      const ObjectId& id,
+      folly::StringPiece contents) const;
+
   const StatsFetchContext& getStatsContext() {
     return *statsContext_;
   }
@@ -76,7 +95,10 @@ class DiffContext {
   }
 
  private:
-  std::unique_ptr<TopLevelIgnores> topLevelIgnores_;
+  // Shared with the diffs started while the ignore files didn't change.
+  std::shared_ptr<const TopLevelIgnores> topLevelIgnores_;
+  // Shared by the diffs of all the mounts, can be nullptr.
+  GitIgnoreCache* const gitIgnoreCache_;
   const folly::CancellationToken cancellation_;
 
   // TODO: We could populate pid and cause here.
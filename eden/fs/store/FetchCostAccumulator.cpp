@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FetchCostAccumulator.h"
+
+namespace facebook::eden {
+
+void FetchCostAccumulator::add(
+    ObjectFetchContext::Origin origin,
+    std::chrono::nanoseconds duration,
+    uint64_t bytes) {
+  FetchCost::Source source;
+  switch (origin) {
+    case ObjectFetchContext::FromMemoryCache:
+      source = FetchCost::MemoryCache;
+      break;
+    case ObjectFetchContext::FromDiskCache:
+      source = FetchCost::DiskCache;
+      break;
+    case ObjectFetchContext::FromNetworkFetch:
+      source = FetchCost::BackingStore;
+      break;
+    default:
+      return;
+  }
+  auto& tier = tiers_[source];
+  tier.count.fetch_add(1, std::memory_order_relaxed);
+  tier.durationNs.fetch_add(duration.count(), std::memory_order_relaxed);
+  tier.bytes.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+FetchCost FetchCostAccumulator::getFetchCost() const {
+  FetchCost cost;
+  for (size_t source = 0; source < FetchCost::kSourceEnumMax; ++source) {
+    const auto& tier = tiers_[source];
+    cost.tiers[source].count = tier.count.load(std::memory_order_relaxed);
+    cost.tiers[source].duration = std::chrono::nanoseconds{
+        tier.durationNs.load(std::memory_order_relaxed)};
+    cost.tiers[source].bytes = tier.bytes.load(std::memory_order_relaxed);
+  }
+  return cost;
+}
+
+} // namespace facebook::eden
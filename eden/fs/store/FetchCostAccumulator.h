@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/telemetry/FetchCost.h"
+
+namespace facebook::eden {
+
+/**
+ * Sums the FetchCost of the objects fetched on behalf of a request, for the
+ * ObjectFetchContexts that implement didSpendFetching.
+ *
+ * The fetches of a request may complete on several threads at once.
+ */
+class FetchCostAccumulator {
+ public:
+  void add(
+      ObjectFetchContext::Origin origin,
+      std::chrono::nanoseconds duration,
+      uint64_t bytes);
+
+  FetchCost getFetchCost() const;
+
+ private:
+  struct Tier {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> durationNs{0};
+    std::atomic<uint64_t> bytes{0};
+  };
+
+  std::array<Tier, FetchCost::kSourceEnumMax> tiers_;
+};
+
+} // namespace facebook::eden
@@ -60,8 +60,10 @@ class IObjectStore {
    *
    * The caller is responsible for making sure that the HashRange stays valid
    * for as long as the returned ImmediateFuture.
+   *
+   * Returns the number of blobs that had to be fetched remotely.
    */
-  virtual ImmediateFuture<folly::Unit> prefetchBlobs(
+  virtual ImmediateFuture<size_t> prefetchBlobs(
       ObjectIdRange ids,
       const ObjectFetchContextPtr& context) const = 0;
 };
@@ -166,6 +166,16 @@ inline constexpr ImportPriority kReaddirPrefetchPriority{
     ImportPriority::Class::Low};
 inline constexpr ImportPriority kThriftPrefetchPriority{
     ImportPriority::Class::Low};
+// Read ahead of the processes reading files in order.
+inline constexpr ImportPriority kReadAheadPriority{ImportPriority::Class::Low};
+// Speculative child tree prefetches yield to the requested prefetches.
+inline constexpr ImportPriority kSpeculativeTreePrefetchPriority{
+    ImportPriority::Class::Low,
+    -1};
+// Cache warming is speculative, so it yields to every other prefetch.
+inline constexpr ImportPriority kCacheWarmingPriority{
+    ImportPriority::Class::Low,
+    -1};
 
 } // namespace facebook::eden
 
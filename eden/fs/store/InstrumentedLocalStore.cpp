@@ -0,0 +1,232 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/InstrumentedLocalStore.h"
+
+#include <folly/futures/Future.h>
+#include <folly/stop_watch.h>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace facebook::eden {
+
+namespace {
+using DurationPtr = StatsGroupBase::Duration LocalStoreStats::*;
+using CounterPtr = StatsGroupBase::Counter LocalStoreStats::*;
+
+struct KeySpaceStats {
+  DurationPtr get;
+  DurationPtr getBatch;
+  DurationPtr put;
+  CounterPtr readBytes;
+  CounterPtr writeBytes;
+};
+
+constexpr KeySpaceStats kKeySpaceStats[] = {
+    {&LocalStoreStats::blobGet,
+     &LocalStoreStats::blobGetBatch,
+     &LocalStoreStats::blobPut,
+     &LocalStoreStats::blobReadBytes,
+     &LocalStoreStats::blobWriteBytes},
+    {&LocalStoreStats::blobMetaDataGet,
+     &LocalStoreStats::blobMetaDataGetBatch,
+     &LocalStoreStats::blobMetaDataPut,
+     &LocalStoreStats::blobMetaDataReadBytes,
+     &LocalStoreStats::blobMetaDataWriteBytes},
+    {&LocalStoreStats::treeGet,
+     &LocalStoreStats::treeGetBatch,
+     &LocalStoreStats::treePut,
+     &LocalStoreStats::treeReadBytes,
+     &LocalStoreStats::treeWriteBytes},
+    {&LocalStoreStats::hgProxyHashGet,
+     &LocalStoreStats::hgProxyHashGetBatch,
+     &LocalStoreStats::hgProxyHashPut,
+     &LocalStoreStats::hgProxyHashReadBytes,
+     &LocalStoreStats::hgProxyHashWriteBytes},
+    {&LocalStoreStats::hgCommitToTreeGet,
+     &LocalStoreStats::hgCommitToTreeGetBatch,
+     &LocalStoreStats::hgCommitToTreePut,
+     &LocalStoreStats::hgCommitToTreeReadBytes,
+     &LocalStoreStats::hgCommitToTreeWriteBytes},
+};
+static_assert(
+    std::size(kKeySpaceStats) == KeySpace::BlobSizeFamily.index,
+    "every non-deprecated KeySpace needs its LocalStoreStats");
+
+/**
+ * Returns nullptr for the deprecated KeySpaces, which are only ever cleared.
+ */
+const KeySpaceStats* getKeySpaceStats(KeySpace keySpace) {
+  if (keySpace->index >= std::size(kKeySpaceStats)) {
+    return nullptr;
+  }
+  return &kKeySpaceStats[keySpace->index];
+}
+
+size_t totalSize(const std::vector<folly::ByteRange>& slices) {
+  size_t size = 0;
+  for (auto& slice : slices) {
+    size += slice.size();
+  }
+  return size;
+}
+
+class InstrumentedWriteBatch final : public LocalStore::WriteBatch {
+ public:
+  InstrumentedWriteBatch(
+      std::unique_ptr<LocalStore::WriteBatch> batch,
+      std::shared_ptr<EdenStats> stats)
+      : batch_{std::move(batch)}, stats_{std::move(stats)} {}
+
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
+      override {
+    recordWrite(keySpace, value.size());
+    batch_->put(keySpace, key, value);
+  }
+
+  void put(
+      KeySpace keySpace,
+      folly::ByteRange key,
+      std::vector<folly::ByteRange> valueSlices) override {
+    recordWrite(keySpace, totalSize(valueSlices));
+    batch_->put(keySpace, key, std::move(valueSlices));
+  }
+
+  void flush() override {
+    folly::stop_watch<std::chrono::microseconds> watch;
+    batch_->flush();
+    stats_->addDuration(&LocalStoreStats::writeBatchFlush, watch.elapsed());
+    stats_->increment(&LocalStoreStats::writeBatchFlushBytes, pendingBytes_);
+    pendingBytes_ = 0;
+  }
+
+ private:
+  void recordWrite(KeySpace keySpace, size_t size) {
+    pendingBytes_ += size;
+    if (auto* keySpaceStats = getKeySpaceStats(keySpace)) {
+      stats_->increment(keySpaceStats->writeBytes, size);
+    }
+  }
+
+  std::unique_ptr<LocalStore::WriteBatch> batch_;
+  std::shared_ptr<EdenStats> stats_;
+  // Bytes put since the last flush. The wrapped batch may also flush on its
+  // own when given a buffer size, these are then accounted to the next
+  // explicit flush.
+  size_t pendingBytes_{0};
+};
+} // namespace
+
+InstrumentedLocalStore::InstrumentedLocalStore(
+    std::shared_ptr<LocalStore> store,
+    std::shared_ptr<EdenStats> stats)
+    : store_{std::move(store)}, stats_{std::move(stats)} {}
+
+void InstrumentedLocalStore::open() {
+  store_->open();
+}
+
+void InstrumentedLocalStore::close() {
+  store_->close();
+}
+
+void InstrumentedLocalStore::clearKeySpace(KeySpace keySpace) {
+  store_->clearKeySpace(keySpace);
+}
+
+void InstrumentedLocalStore::compactKeySpace(KeySpace keySpace) {
+  store_->compactKeySpace(keySpace);
+}
+
+StoreResult InstrumentedLocalStore::get(
+    KeySpace keySpace,
+    folly::ByteRange key) const {
+  auto* keySpaceStats = getKeySpaceStats(keySpace);
+  if (!keySpaceStats) {
+    return store_->get(keySpace, key);
+  }
+
+  folly::stop_watch<std::chrono::microseconds> watch;
+  auto result = store_->get(keySpace, key);
+  stats_->addDuration(keySpaceStats->get, watch.elapsed());
+  if (result.isValid()) {
+    stats_->increment(keySpaceStats->readBytes, result.bytes().size());
+  }
+  return result;
+}
+
+folly::Future<std::vector<StoreResult>> InstrumentedLocalStore::getBatch(
+    KeySpace keySpace,
+    const std::vector<folly::ByteRange>& keys) const {
+  auto* keySpaceStats = getKeySpaceStats(keySpace);
+  if (!keySpaceStats) {
+    return store_->getBatch(keySpace, keys);
+  }
+
+  folly::stop_watch<std::chrono::microseconds> watch;
+  return store_->getBatch(keySpace, keys)
+      .thenValue([stats = stats_, keySpaceStats, watch](
+                     std::vector<StoreResult>&& results) {
+        stats->addDuration(keySpaceStats->getBatch, watch.elapsed());
+        size_t bytes = 0;
+        for (auto& result : results) {
+          if (result.isValid()) {
+            bytes += result.bytes().size();
+          }
+        }
+        stats->increment(keySpaceStats->readBytes, bytes);
+        return std::move(results);
+      });
+}
+
+bool InstrumentedLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key)
+    const {
+  return store_->hasKey(keySpace, key);
+}
+
+void InstrumentedLocalStore::put(
+    KeySpace keySpace,
+    folly::ByteRange key,
+    folly::ByteRange value) {
+  auto* keySpaceStats = getKeySpaceStats(keySpace);
+  if (!keySpaceStats) {
+    store_->put(keySpace, key, value);
+    return;
+  }
+
+  folly::stop_watch<std::chrono::microseconds> watch;
+  store_->put(keySpace, key, value);
+  stats_->addDuration(keySpaceStats->put, watch.elapsed());
+  stats_->increment(keySpaceStats->writeBytes, value.size());
+}
+
+std::unique_ptr<LocalStore::WriteBatch> InstrumentedLocalStore::beginWrite(
+    size_t bufSize) {
+  return std::make_unique<InstrumentedWriteBatch>(
+      store_->beginWrite(bufSize), stats_);
+}
+
+std::unique_ptr<LocalStore::WriteBatch>
+InstrumentedLocalStore::beginEphemeralWrite(size_t bufSize) {
+  return std::make_unique<InstrumentedWriteBatch>(
+      store_->beginEphemeralWrite(bufSize), stats_);
+}
+
+void InstrumentedLocalStore::periodicManagementTask(const EdenConfig& config) {
+  // putBlob() checks the flag of the store it is called on.
+  enableBlobCaching.store(
+      config.enableBlobCaching.getValue(), std::memory_order_relaxed);
+  store_->periodicManagementTask(config);
+}
+
+CompactionScheduler& InstrumentedLocalStore::getCompactionScheduler() {
+  return store_->getCompactionScheduler();
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "eden/fs/store/LocalStore.h"
+
+namespace facebook::eden {
+
+class EdenStats;
+
+/**
+ * A LocalStore that forwards every operation to another LocalStore, recording
+ * the duration of reads and writes and the number of bytes transferred for
+ * each KeySpace in the LocalStoreStats.
+ *
+ * Wrapping the store rather than instrumenting each storage engine means the
+ * measurements are comparable across engines, and that they cover the cost
+ * of the engine alone: deserializing the returned values and fetching
+ * missing objects from the backing store are measured by the ObjectStore.
+ */
+class InstrumentedLocalStore final : public LocalStore {
+ public:
+  InstrumentedLocalStore(
+      std::shared_ptr<LocalStore> store,
+      std::shared_ptr<EdenStats> stats);
+
+  void open() override;
+  void close() override;
+  void clearKeySpace(KeySpace keySpace) override;
+  void compactKeySpace(KeySpace keySpace) override;
+  StoreResult get(KeySpace keySpace, folly::ByteRange key) const override;
+  FOLLY_NODISCARD folly::Future<std::vector<StoreResult>> getBatch(
+      KeySpace keySpace,
+      const std::vector<folly::ByteRange>& keys) const override;
+  bool hasKey(KeySpace keySpace, folly::ByteRange key) const override;
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
+      override;
+  std::unique_ptr<WriteBatch> beginWrite(size_t bufSize = 0) override;
+  std::unique_ptr<WriteBatch> beginEphemeralWrite(size_t bufSize = 0) override;
+
+  void periodicManagementTask(const EdenConfig& config) override;
+
+  CompactionScheduler& getCompactionScheduler() override;
+
+ private:
+  const std::shared_ptr<LocalStore> store_;
+  const std::shared_ptr<EdenStats> stats_;
+};
+
+} // namespace facebook::eden
@@ -132,6 +132,29 @@ ImmediateFuture<optional<BlobMetadata>> LocalStore::getBlobMetadata(
       });
 }
 
+ImmediateFuture<std::vector<optional<BlobMetadata>>>
+LocalStore::getBlobMetadataBatch(const std::vector<ObjectId>& ids) const {
+  std::vector<ByteRange> keys;
+  keys.reserve(ids.size());
+  for (const auto& id : ids) {
+    keys.push_back(id.getBytes());
+  }
+  return ImmediateFuture{getBatch(KeySpace::BlobMetaDataFamily, keys).semi()}
+      .thenValue([ids](std::vector<StoreResult>&& results) {
+        std::vector<optional<BlobMetadata>> metadata;
+        metadata.reserve(results.size());
+        for (size_t i = 0; i < results.size(); ++i) {
+          if (results[i].isValid()) {
+            metadata.emplace_back(
+                SerializedBlobMetadata::parse(ids[i], results[i]));
+          } else {
+            metadata.emplace_back(std::nullopt);
+          }
+        }
+        return metadata;
+      });
+}
+
 folly::IOBuf LocalStore::serializeTree(const Tree& tree) {
   return tree.serialize();
 }
@@ -13,6 +13,7 @@
 #include <optional>
 #include "eden/fs/model/BlobMetadata.h"
 #include "eden/fs/model/ObjectId.h"
+#include "eden/fs/store/CompactionScheduler.h"
 #include "eden/fs/store/KeySpace.h"
 #include "eden/fs/utils/ImmediateFuture.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -153,6 +154,15 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
   ImmediateFuture<std::optional<BlobMetadata>> getBlobMetadata(
       const ObjectId& id) const;
 
+  /**
+   * Get the metadata of several blobs with a single getBatch call.
+   *
+   * The returned vector has one element per id, std::nullopt for the blobs
+   * whose metadata is not present in the store.
+   */
+  ImmediateFuture<std::vector<std::optional<BlobMetadata>>>
+  getBlobMetadataBatch(const std::vector<ObjectId>& ids) const;
+
   /**
    * Test whether the key is stored.
    */
@@ -252,6 +262,16 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
    */
   virtual std::unique_ptr<WriteBatch> beginWrite(size_t bufSize = 0) = 0;
 
+  /**
+   * Like beginWrite(), for writing data that can be fetched again from the
+   * backing store. Only ephemeral KeySpaces may be written to the returned
+   * batch. Stores may make these writes cheaper by making them less durable,
+   * so the data may be missing after a crash.
+   */
+  virtual std::unique_ptr<WriteBatch> beginEphemeralWrite(size_t bufSize = 0) {
+    return beginWrite(bufSize);
+  }
+
   virtual void periodicManagementTask(const EdenConfig& config);
 
   /*
@@ -263,6 +283,17 @@ class LocalStore : public std::enable_shared_from_this<LocalStore> {
    */
   std::atomic<bool> enableBlobCaching = true;
 
+  /**
+   * Decides when background garbage collection and compaction may run.
+   * Stores that don't do any background maintenance ignore it.
+   */
+  virtual CompactionScheduler& getCompactionScheduler() {
+    return compactionScheduler_;
+  }
+
+ protected:
+  CompactionScheduler compactionScheduler_;
+
  private:
   /**
    * Compute the serialized version of the tree in a (not coalesced) IOBuf.
@@ -9,6 +9,7 @@
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/model/Tree.h"
 #include "eden/fs/store/LocalStore.h"
+#include "eden/fs/store/LocalStoreIngester.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/utils/ImmediateFuture.h"
 
@@ -17,10 +18,12 @@ namespace facebook::eden {
 LocalStoreCachedBackingStore::LocalStoreCachedBackingStore(
     std::shared_ptr<BackingStore> backingStore,
     std::shared_ptr<LocalStore> localStore,
-    std::shared_ptr<EdenStats> stats)
+    std::shared_ptr<EdenStats> stats,
+    std::shared_ptr<LocalStoreIngester> ingester)
     : backingStore_{std::move(backingStore)},
       localStore_{std::move(localStore)},
-      stats_{std::move(stats)} {}
+      stats_{std::move(stats)},
+      ingester_{std::move(ingester)} {}
 
 LocalStoreCachedBackingStore::~LocalStoreCachedBackingStore() {}
 
@@ -30,16 +33,26 @@ ObjectComparison LocalStoreCachedBackingStore::compareObjectsById(
   return backingStore_->compareObjectsById(one, two);
 }
 
+std::optional<ObjectId> LocalStoreCachedBackingStore::migrateObjectId(
+    const ObjectId& id) {
+  return backingStore_->migrateObjectId(id);
+}
+
 ImmediateFuture<std::unique_ptr<Tree>>
 LocalStoreCachedBackingStore::getRootTree(
     const RootId& rootId,
     const ObjectFetchContextPtr& context) {
   return backingStore_->getRootTree(rootId, context)
-      .thenValue([localStore = localStore_](std::unique_ptr<Tree> tree) {
+      .thenValue([localStore = localStore_,
+                  ingester = ingester_](std::unique_ptr<Tree> tree) {
         // TODO: perhaps this callback should use toUnsafeFuture() to ensure the
         // tree is cached whether or not the caller consumes the future.
         if (tree) {
-          localStore->putTree(*tree);
+          if (ingester) {
+            ingester->putTree(*tree);
+          } else {
+            localStore->putTree(*tree);
+          }
         }
         return tree;
       });
@@ -58,10 +71,19 @@ folly::SemiFuture<BackingStore::GetTreeResult>
 LocalStoreCachedBackingStore::getTree(
     const ObjectId& id,
     const ObjectFetchContextPtr& context) {
+  if (ingester_) {
+    // Trees that were just imported may not have been written yet.
+    if (auto tree = ingester_->getPendingTree(id)) {
+      return folly::makeSemiFuture(
+          GetTreeResult{std::move(tree), ObjectFetchContext::FromDiskCache});
+    }
+  }
+
   return localStore_->getTree(id)
       .thenValue([id = id,
                   context = context.copy(),
                   localStore = localStore_,
+                  ingester = ingester_,
                   backingStore =
                       backingStore_](std::unique_ptr<Tree> tree) mutable {
         if (tree) {
@@ -73,14 +95,18 @@ LocalStoreCachedBackingStore::getTree(
             ->getTree(id, context)
             // TODO: This is a good use for toUnsafeFuture to ensure the tree is
             // cached even if the resulting future is never consumed.
-            .deferValue(
-                [localStore = std::move(localStore)](GetTreeResult result) {
-                  if (result.tree) {
-                    localStore->putTree(*result.tree);
-                  }
-
-                  return result;
-                });
+            .deferValue([localStore = std::move(localStore),
+                         ingester = std::move(ingester)](GetTreeResult result) {
+              if (result.tree) {
+                if (ingester) {
+                  ingester->putTree(*result.tree);
+                } else {
+                  localStore->putTree(*result.tree);
+                }
+              }
+
+              return result;
+            });
       })
       .semi();
 }
@@ -96,10 +122,20 @@ folly::SemiFuture<BackingStore::GetBlobResult>
 LocalStoreCachedBackingStore::getBlob(
     const ObjectId& id,
     const ObjectFetchContextPtr& context) {
+  if (ingester_) {
+    // Blobs that were just imported may not have been written yet.
+    if (auto blob = ingester_->getPendingBlob(id)) {
+      stats_->increment(&ObjectStoreStats::getBlobFromLocalStore);
+      return folly::makeSemiFuture(
+          GetBlobResult{std::move(blob), ObjectFetchContext::FromDiskCache});
+    }
+  }
+
   return localStore_->getBlob(id)
       .thenValue([id = id,
                   context = context.copy(),
                   localStore = localStore_,
+                  ingester = ingester_,
                   backingStore = backingStore_,
                   stats = stats_](std::unique_ptr<Blob> blob) mutable {
         if (blob) {
@@ -113,10 +149,15 @@ LocalStoreCachedBackingStore::getBlob(
             // TODO: This is a good use for toUnsafeFuture to ensure the tree is
             // cached even if the resulting future is never consumed.
             .deferValue([localStore = std::move(localStore),
+                         ingester = std::move(ingester),
                          stats = std::move(stats),
                          id](GetBlobResult result) {
               if (result.blob) {
-                localStore->putBlob(id, result.blob.get());
+                if (ingester) {
+                  ingester->putBlob(id, *result.blob);
+                } else {
+                  localStore->putBlob(id, result.blob.get());
+                }
                 stats->increment(&ObjectStoreStats::getBlobFromBackingStore);
               }
               return result;
@@ -125,7 +166,20 @@ LocalStoreCachedBackingStore::getBlob(
       .semi();
 }
 
-folly::SemiFuture<folly::Unit> LocalStoreCachedBackingStore::prefetchBlobs(
+bool LocalStoreCachedBackingStore::supportsBlobRanges() const {
+  return backingStore_->supportsBlobRanges();
+}
+
+folly::SemiFuture<std::unique_ptr<folly::IOBuf>>
+LocalStoreCachedBackingStore::getBlobRange(
+    const ObjectId& id,
+    uint64_t offset,
+    uint64_t length,
+    const ObjectFetchContextPtr& context) {
+  return backingStore_->getBlobRange(id, offset, length, context);
+}
+
+folly::SemiFuture<size_t> LocalStoreCachedBackingStore::prefetchBlobs(
     ObjectIdRange ids,
     const ObjectFetchContextPtr& context) {
   return backingStore_->prefetchBlobs(ids, context);
@@ -13,6 +13,7 @@ namespace facebook::eden {
 
 class BackingStore;
 class LocalStore;
+class LocalStoreIngester;
 class EdenStats;
 
 /**
@@ -25,18 +26,24 @@ class EdenStats;
  * This should be used for BackingStores that either do not have local caching
  * builtin, or when reading from this cache is significantly slower than
  * reading from the LocalStore.
+ *
+ * When given a LocalStoreIngester, fetched objects are written to the
+ * LocalStore in batches through it instead of one at a time.
  */
 class LocalStoreCachedBackingStore : public BackingStore {
  public:
   LocalStoreCachedBackingStore(
       std::shared_ptr<BackingStore> backingStore,
       std::shared_ptr<LocalStore> localStore,
-      std::shared_ptr<EdenStats> stats);
+      std::shared_ptr<EdenStats> stats,
+      std::shared_ptr<LocalStoreIngester> ingester = nullptr);
   ~LocalStoreCachedBackingStore() override;
 
   ObjectComparison compareObjectsById(const ObjectId& one, const ObjectId& two)
       override;
 
+  std::optional<ObjectId> migrateObjectId(const ObjectId& id) override;
+
   ImmediateFuture<std::unique_ptr<Tree>> getRootTree(
       const RootId& rootId,
       const ObjectFetchContextPtr& context) override;
@@ -56,7 +63,18 @@ class LocalStoreCachedBackingStore : public BackingStore {
       const ObjectId& id,
       const ObjectFetchContextPtr& context) override;
 
-  FOLLY_NODISCARD folly::SemiFuture<folly::Unit> prefetchBlobs(
+  /**
+   * Ranges are not cached in the LocalStore, they are always fetched from the
+   * underlying BackingStore.
+   */
+  bool supportsBlobRanges() const override;
+  folly::SemiFuture<std::unique_ptr<folly::IOBuf>> getBlobRange(
+      const ObjectId& id,
+      uint64_t offset,
+      uint64_t length,
+      const ObjectFetchContextPtr& context) override;
+
+  FOLLY_NODISCARD folly::SemiFuture<size_t> prefetchBlobs(
       ObjectIdRange ids,
       const ObjectFetchContextPtr& context) override;
 
@@ -96,6 +114,7 @@ class LocalStoreCachedBackingStore : public BackingStore {
   std::shared_ptr<BackingStore> backingStore_;
   std::shared_ptr<LocalStore> localStore_;
   std::shared_ptr<EdenStats> stats_;
+  std::shared_ptr<LocalStoreIngester> ingester_;
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/LocalStoreIngester.h"
+
+#include <folly/logging/xlog.h>
+#include <folly/stop_watch.h>
+#include <folly/system/ThreadName.h>
+#include <algorithm>
+
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/KeySpace.h"
+#include "eden/fs/store/LocalStore.h"
+#include "eden/fs/store/SerializedBlobMetadata.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace facebook::eden {
+
+namespace {
+// Once this many full batches are pending, importing threads write batches
+// themselves rather than let the flush thread fall further behind.
+constexpr size_t kMaxPendingBatches = 4;
+} // namespace
+
+LocalStoreIngester::LocalStoreIngester(
+    std::shared_ptr<LocalStore> localStore,
+    std::shared_ptr<EdenStats> stats,
+    size_t flushBytes,
+    std::chrono::milliseconds flushInterval)
+    : localStore_{std::move(localStore)},
+      stats_{std::move(stats)},
+      flushBytes_{std::max<size_t>(flushBytes, 1)},
+      flushInterval_{flushInterval} {
+  flushThread_ = std::thread{[this] {
+    folly::setThreadName("LocalStoreIngest");
+    flushThread();
+  }};
+}
+
+LocalStoreIngester::~LocalStoreIngester() {
+  {
+    auto state = state_.lock();
+    state->stopRequested = true;
+  }
+  flushCV_.notify_one();
+  flushThread_.join();
+}
+
+void LocalStoreIngester::putTree(const Tree& tree) {
+  auto serialized = tree.serialize();
+  serialized.coalesce();
+  auto size = serialized.length() + tree.getHash().size();
+
+  size_t pendingBytes;
+  {
+    auto state = state_.lock();
+    auto [it, inserted] =
+        state->pending.trees.try_emplace(tree.getHash(), std::move(serialized));
+    if (!inserted) {
+      return;
+    }
+    pendingBytes = state->pending.bytes += size;
+  }
+  added(pendingBytes);
+}
+
+void LocalStoreIngester::putBlob(const ObjectId& id, const Blob& blob) {
+  if (!localStore_->enableBlobCaching.load(std::memory_order_relaxed)) {
+    XLOG(DBG8) << "Skipping caching " << id
+               << " because blob cache is disabled via config";
+    return;
+  }
+
+  // Sharing the blob's buffers is enough, Blobs are immutable.
+  auto copy = std::make_unique<Blob>(id, blob.getContents());
+  auto size = blob.getSize() + id.size();
+
+  size_t pendingBytes;
+  {
+    auto state = state_.lock();
+    auto [it, inserted] = state->pending.blobs.try_emplace(id, std::move(copy));
+    if (!inserted) {
+      return;
+    }
+    pendingBytes = state->pending.bytes += size;
+  }
+  added(pendingBytes);
+}
+
+void LocalStoreIngester::putBlobMetadata(
+    const ObjectId& id,
+    const BlobMetadata& metadata) {
+  auto size = SerializedBlobMetadata::SIZE + id.size();
+
+  size_t pendingBytes;
+  {
+    auto state = state_.lock();
+    auto [it, inserted] = state->pending.metadata.try_emplace(id, metadata);
+    if (!inserted) {
+      return;
+    }
+    pendingBytes = state->pending.bytes += size;
+  }
+  added(pendingBytes);
+}
+
+void LocalStoreIngester::added(size_t pendingBytes) {
+  if (pendingBytes >= kMaxPendingBatches * flushBytes_) {
+    flush();
+  } else if (pendingBytes >= flushBytes_) {
+    flushCV_.notify_one();
+  }
+}
+
+std::unique_ptr<Tree> LocalStoreIngester::getPendingTree(
+    const ObjectId& id) const {
+  auto find = [&](const Pending& pending) -> std::unique_ptr<Tree> {
+    auto it = pending.trees.find(id);
+    if (it == pending.trees.end()) {
+      return nullptr;
+    }
+    return Tree::tryDeserialize(
+        id,
+        folly::StringPiece{folly::ByteRange{
+            it->second.data(), it->second.length()}});
+  };
+
+  auto state = state_.lock();
+  if (auto tree = find(state->pending)) {
+    return tree;
+  }
+  if (state->flushing) {
+    return find(*state->flushing);
+  }
+  return nullptr;
+}
+
+std::unique_ptr<Blob> LocalStoreIngester::getPendingBlob(
+    const ObjectId& id) const {
+  auto find = [&](const Pending& pending) -> std::unique_ptr<Blob> {
+    auto it = pending.blobs.find(id);
+    if (it == pending.blobs.end()) {
+      return nullptr;
+    }
+    return std::make_unique<Blob>(id, it->second->getContents());
+  };
+
+  auto state = state_.lock();
+  if (auto blob = find(state->pending)) {
+    return blob;
+  }
+  if (state->flushing) {
+    return find(*state->flushing);
+  }
+  return nullptr;
+}
+
+size_t LocalStoreIngester::getPendingBytes() const {
+  auto state = state_.lock();
+  return state->pending.bytes +
+      (state->flushing ? state->flushing->bytes : 0);
+}
+
+void LocalStoreIngester::flush() {
+  std::lock_guard<std::mutex> flushGuard{flushMutex_};
+
+  std::shared_ptr<const Pending> batch;
+  {
+    auto state = state_.lock();
+    if (state->pending.objectCount() == 0) {
+      return;
+    }
+    batch = std::make_shared<const Pending>(std::move(state->pending));
+    state->pending = Pending{};
+    state->flushing = batch;
+  }
+
+  writeBatch(*batch);
+
+  state_.lock()->flushing.reset();
+}
+
+void LocalStoreIngester::writeBatch(const Pending& batch) {
+  folly::stop_watch<std::chrono::microseconds> watch;
+  try {
+    auto writeBatch = localStore_->beginEphemeralWrite();
+    for (const auto& [id, serialized] : batch.trees) {
+      writeBatch->put(
+          KeySpace::TreeFamily,
+          id,
+          folly::ByteRange{serialized.data(), serialized.length()});
+    }
+    for (const auto& [id, blob] : batch.blobs) {
+      writeBatch->putBlob(id, blob.get());
+    }
+    for (const auto& [id, metadata] : batch.metadata) {
+      SerializedBlobMetadata metadataBytes(metadata);
+      writeBatch->put(KeySpace::BlobMetaDataFamily, id, metadataBytes.slice());
+    }
+    writeBatch->flush();
+  } catch (const std::exception& ex) {
+    // The objects can be fetched again from the backing store, so losing
+    // them only costs performance.
+    XLOG(ERR) << "failed to write " << batch.objectCount()
+              << " imported objects to the local store: "
+              << folly::exceptionStr(ex);
+    stats_->increment(&LocalStoreStats::ingestFlushFailure);
+    return;
+  }
+
+  stats_->increment(&LocalStoreStats::ingestFlushBytes, batch.bytes);
+  stats_->increment(&LocalStoreStats::ingestFlushObjects, batch.objectCount());
+  stats_->addDuration(&LocalStoreStats::ingestFlush, watch.elapsed());
+}
+
+void LocalStoreIngester::flushThread() {
+  for (;;) {
+    bool stopRequested;
+    {
+      auto state = state_.lock();
+      flushCV_.wait_for(state.as_lock(), flushInterval_, [&] {
+        return state->stopRequested || state->pending.bytes >= flushBytes_;
+      });
+      stopRequested = state->stopRequested;
+    }
+
+    // Whether the batch is full or the interval elapsed, write what is
+    // pending.
+    flush();
+    if (stopRequested) {
+      return;
+    }
+  }
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
+#include <folly/io/IOBuf.h>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "eden/fs/model/BlobMetadata.h"
+#include "eden/fs/model/ObjectId.h"
+
+namespace facebook::eden {
+
+class Blob;
+class EdenStats;
+class LocalStore;
+class Tree;
+
+/**
+ * Writes objects imported from a BackingStore to the LocalStore in batches,
+ * rather than with one write per object.
+ *
+ * Objects are accumulated in memory and written in a single
+ * LocalStore::WriteBatch once flushBytes worth of them are pending, or once
+ * flushInterval has elapsed, whichever comes first. The writes go through
+ * LocalStore::beginEphemeralWrite(): everything written here can be fetched
+ * again from the backing store, so the store is free to make them less
+ * durable. A crash may lose the most recently imported objects.
+ *
+ * Objects that are still pending can be read back with getPendingTree() and
+ * getPendingBlob(), so that callers don't fetch them again from the backing
+ * store in the meantime.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class LocalStoreIngester {
+ public:
+  LocalStoreIngester(
+      std::shared_ptr<LocalStore> localStore,
+      std::shared_ptr<EdenStats> stats,
+      size_t flushBytes,
+      std::chrono::milliseconds flushInterval);
+
+  /**
+   * Writes everything that is still pending.
+   */
+  ~LocalStoreIngester();
+
+  LocalStoreIngester(const LocalStoreIngester&) = delete;
+  LocalStoreIngester& operator=(const LocalStoreIngester&) = delete;
+
+  void putTree(const Tree& tree);
+  void putBlob(const ObjectId& id, const Blob& blob);
+  void putBlobMetadata(const ObjectId& id, const BlobMetadata& metadata);
+
+  /**
+   * Return the tree with the given id if it is waiting to be written, or
+   * nullptr otherwise.
+   */
+  std::unique_ptr<Tree> getPendingTree(const ObjectId& id) const;
+
+  /**
+   * Return the blob with the given id if it is waiting to be written, or
+   * nullptr otherwise.
+   */
+  std::unique_ptr<Blob> getPendingBlob(const ObjectId& id) const;
+
+  /**
+   * Write all the pending objects to the LocalStore now, and wait for the
+   * write to complete.
+   */
+  void flush();
+
+  /**
+   * Approximate size of the objects waiting to be written.
+   */
+  size_t getPendingBytes() const;
+
+ private:
+  struct Pending {
+    // Trees are kept in their serialized, coalesced form.
+    folly::F14NodeMap<ObjectId, folly::IOBuf> trees;
+    folly::F14NodeMap<ObjectId, std::unique_ptr<Blob>> blobs;
+    folly::F14NodeMap<ObjectId, BlobMetadata> metadata;
+    size_t bytes = 0;
+
+    size_t objectCount() const {
+      return trees.size() + blobs.size() + metadata.size();
+    }
+  };
+
+  struct State {
+    Pending pending;
+    /**
+     * The batch being written by flush(), if any, so that its objects can
+     * still be found until they are in the LocalStore.
+     */
+    std::shared_ptr<const Pending> flushing;
+    bool stopRequested = false;
+  };
+
+  /**
+   * Called after adding an object: wake up the flush thread if a batch is
+   * full, or flush from the calling thread if the flush thread is falling
+   * behind.
+   */
+  void added(size_t pendingBytes);
+
+  void writeBatch(const Pending& batch);
+
+  void flushThread();
+
+  const std::shared_ptr<LocalStore> localStore_;
+  const std::shared_ptr<EdenStats> stats_;
+  const size_t flushBytes_;
+  const std::chrono::milliseconds flushInterval_;
+
+  folly::Synchronized<State, std::mutex> state_;
+  // Signaled when a batch is full or the flush thread must stop.
+  std::condition_variable flushCV_;
+  // Held while writing a batch, so that batches are written in order.
+  std::mutex flushMutex_;
+
+  std::thread flushThread_;
+};
+
+} // namespace facebook::eden
@@ -6,7 +6,13 @@
  */
 
 #include "eden/fs/store/MemoryLocalStore.h"
+#include <fb303/ServiceData.h>
+#include <folly/Conv.h>
 #include <folly/String.h>
+#include <folly/experimental/StringKeyedUnorderedMap.h>
+#include <algorithm>
+#include <vector>
+#include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/store/StoreResult.h"
 
 namespace facebook::eden {
@@ -49,43 +55,139 @@ class MemoryWriteBatch : public LocalStore::WriteBatch {
   MemoryLocalStore* store_;
   std::vector<folly::StringKeyedUnorderedMap<std::string>> storage_;
 };
+
+// Evicting a little more than needed leaves room for new values before the
+// next eviction.
+constexpr uint64_t kEvictionTargetPercent = 90;
+
+uint64_t entrySize(folly::StringPiece key, folly::StringPiece value) {
+  return key.size() + value.size();
+}
 } // namespace
 
-MemoryLocalStore::MemoryLocalStore() {
-  storage_.wlock()->resize(KeySpace::kTotalCount);
+MemoryLocalStore::MemoryLocalStore() : bounded_{false} {}
+
+MemoryLocalStore::MemoryLocalStore(const EdenConfig& config) : bounded_{true} {
+  updateBudgets(config);
 }
 
 void MemoryLocalStore::open() {}
 void MemoryLocalStore::close() {}
 
 void MemoryLocalStore::clearKeySpace(KeySpace keySpace) {
-  (*storage_.wlock())[keySpace->index].clear();
+  auto column = storage_[keySpace->index].wlock();
+  column->entries.clear();
+  column->bytes = 0;
 }
 
 void MemoryLocalStore::compactKeySpace(KeySpace) {}
 
+void MemoryLocalStore::touch(KeySpace keySpace, const Entry& entry) const {
+  if (budgets_[keySpace->index].load(std::memory_order_relaxed) != 0) {
+    entry.lastUse.store(
+        clock_.fetch_add(1, std::memory_order_relaxed),
+        std::memory_order_relaxed);
+  }
+}
+
 StoreResult MemoryLocalStore::get(KeySpace keySpace, folly::ByteRange key)
     const {
-  auto store = storage_.rlock();
-  auto it = (*store)[keySpace->index].find(StringPiece(key));
-  if (it == (*store)[keySpace->index].end()) {
+  auto column = storage_[keySpace->index].rlock();
+  auto it = column->entries.find(StringPiece(key));
+  if (it == column->entries.end()) {
     return StoreResult::missing(keySpace, key);
   }
-  return StoreResult(std::string(it->second));
+  touch(keySpace, it->second);
+  return StoreResult(std::string(it->second.value));
 }
 
 bool MemoryLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
-  auto store = storage_.rlock();
-  auto it = (*store)[keySpace->index].find(StringPiece(key));
-  return it != (*store)[keySpace->index].end();
+  auto column = storage_[keySpace->index].rlock();
+  auto it = column->entries.find(StringPiece(key));
+  return it != column->entries.end();
 }
 
 void MemoryLocalStore::put(
     KeySpace keySpace,
     folly::ByteRange key,
     folly::ByteRange value) {
-  (*storage_.wlock())[keySpace->index][StringPiece(key)] =
-      StringPiece(value).str();
+  auto tick = clock_.fetch_add(1, std::memory_order_relaxed);
+  auto column = storage_[keySpace->index].wlock();
+  auto [it, inserted] = column->entries.try_emplace(
+      StringPiece(key).str(), StringPiece(value).str(), tick);
+  if (inserted) {
+    column->bytes += entrySize(StringPiece(key), StringPiece(value));
+  } else {
+    column->bytes -= it->second.value.size();
+    column->bytes += value.size();
+    it->second.value = StringPiece(value).str();
+    it->second.lastUse.store(tick, std::memory_order_relaxed);
+  }
+
+  auto budget = budgets_[keySpace->index].load(std::memory_order_relaxed);
+  if (budget != 0 && column->bytes > budget) {
+    evictLocked(*column, budget / 100 * kEvictionTargetPercent);
+  }
+}
+
+void MemoryLocalStore::evictLocked(Column& column, uint64_t targetBytes) {
+  std::vector<std::pair<uint64_t, const std::string*>> byAge;
+  byAge.reserve(column.entries.size());
+  for (const auto& [key, entry] : column.entries) {
+    byAge.emplace_back(entry.lastUse.load(std::memory_order_relaxed), &key);
+  }
+  std::sort(byAge.begin(), byAge.end());
+
+  size_t evicted = 0;
+  for (const auto& [lastUse, key] : byAge) {
+    if (column.bytes <= targetBytes) {
+      break;
+    }
+    auto it = column.entries.find(*key);
+    column.bytes -= entrySize(it->first, it->second.value);
+    column.entries.erase(it);
+    ++evicted;
+  }
+  evictionCount_.fetch_add(evicted, std::memory_order_relaxed);
+}
+
+uint64_t MemoryLocalStore::getSize(KeySpace keySpace) const {
+  return storage_[keySpace->index].rlock()->bytes;
+}
+
+void MemoryLocalStore::updateBudgets(const EdenConfig& config) {
+  for (const auto& ks : KeySpace::kAll) {
+    if (auto* ephemeral = std::get_if<Ephemeral>(&ks->persistence)) {
+      budgets_[ks->index].store(
+          (config.*(ephemeral->cacheLimit)).getValue(),
+          std::memory_order_relaxed);
+    }
+  }
+}
+
+void MemoryLocalStore::periodicManagementTask(const EdenConfig& config) {
+  enableBlobCaching.store(
+      config.enableBlobCaching.getValue(), std::memory_order_relaxed);
+
+  if (bounded_) {
+    updateBudgets(config);
+  }
+  for (const auto& ks : KeySpace::kAll) {
+    auto budget = budgets_[ks->index].load(std::memory_order_relaxed);
+    uint64_t size;
+    {
+      auto column = storage_[ks->index].wlock();
+      if (budget != 0 && column->bytes > budget) {
+        // The budget was lowered.
+        evictLocked(*column, budget / 100 * kEvictionTargetPercent);
+      }
+      size = column->bytes;
+    }
+    fb303::fbData->setCounter(
+        folly::to<std::string>("local_store.", ks->name, ".size"), size);
+  }
+  fb303::fbData->setCounter(
+      "local_store.memory.evicted", getEvictionCount());
 }
 
 std::unique_ptr<LocalStore::WriteBatch> MemoryLocalStore::beginWrite(size_t) {
@@ -7,20 +7,35 @@
 
 #pragma once
 #include <folly/Synchronized.h>
-#include <folly/experimental/StringKeyedUnorderedMap.h>
+#include <folly/container/F14Map.h>
+#include <array>
+#include <atomic>
+#include <string>
 #include "eden/fs/store/LocalStore.h"
 
 namespace facebook::eden {
 
 /** An implementation of LocalStore that stores values in memory.
- * Stored values remain in memory for the lifetime of the
+ * By default, stored values remain in memory for the lifetime of the
  * MemoryLocalStore instance.
  * MemoryLocalStore is thread safe, allowing concurrent reads and
  * writes from any thread.
+ *
+ * A bounded MemoryLocalStore instead keeps each ephemeral KeySpace under the
+ * byte budget given by its cacheLimit setting, evicting the least recently
+ * used values once it is exceeded. Ephemeral data can always be fetched again
+ * from the backing store, so this is suitable for short-lived checkouts that
+ * should not use any disk for their local store. Persistent KeySpaces are
+ * never evicted.
  * */
 class MemoryLocalStore final : public LocalStore {
  public:
   explicit MemoryLocalStore();
+  /**
+   * Create a bounded MemoryLocalStore, with budgets taken from config. They
+   * are refreshed by periodicManagementTask().
+   */
+  explicit MemoryLocalStore(const EdenConfig& config);
   void open() override;
   void close() override;
   void clearKeySpace(KeySpace keySpace) override;
@@ -32,9 +47,54 @@ class MemoryLocalStore final : public LocalStore {
   std::unique_ptr<LocalStore::WriteBatch> beginWrite(
       size_t bufSize = 0) override;
 
+  void periodicManagementTask(const EdenConfig& config) override;
+
+  /**
+   * Bytes of keys and values stored in the KeySpace.
+   */
+  uint64_t getSize(KeySpace keySpace) const;
+
+  /**
+   * Number of values evicted to stay within the budgets so far.
+   */
+  uint64_t getEvictionCount() const {
+    return evictionCount_.load(std::memory_order_relaxed);
+  }
+
  private:
-  folly::Synchronized<std::vector<folly::StringKeyedUnorderedMap<std::string>>>
-      storage_;
+  struct Entry {
+    Entry(std::string value, uint64_t lastUse)
+        : value{std::move(value)}, lastUse{lastUse} {}
+
+    std::string value;
+    /**
+     * Tick of the last access, updated without an exclusive lock so that
+     * reads of bounded KeySpaces stay concurrent.
+     */
+    mutable std::atomic<uint64_t> lastUse;
+  };
+
+  struct Column {
+    folly::F14NodeMap<std::string, Entry> entries;
+    uint64_t bytes = 0;
+  };
+
+  void updateBudgets(const EdenConfig& config);
+
+  /**
+   * Evict the least recently used values of the column until it holds at
+   * most targetBytes.
+   */
+  void evictLocked(Column& column, uint64_t targetBytes);
+
+  void touch(KeySpace keySpace, const Entry& entry) const;
+
+  const bool bounded_;
+  std::array<folly::Synchronized<Column>, KeySpace::kTotalCount> storage_;
+  // In bytes, 0 when unbounded.
+  std::array<std::atomic<uint64_t>, KeySpace::kTotalCount> budgets_{};
+  mutable std::atomic<uint64_t> clock_{0};
+  std::atomic<uint64_t> evictionCount_{0};
 };
 
 } // namespace facebook::eden
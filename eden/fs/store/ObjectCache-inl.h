@@ -6,6 +6,8 @@
  */
 
 #include <folly/MapUtil.h>
+#include <folly/hash/Hash.h>
+#include <folly/hash/SpookyHashV2.h>
 #include <folly/logging/xlog.h>
 #include <utility>
 
@@ -61,20 +63,79 @@ template <typename ObjectType, ObjectCacheFlavor Flavor>
 std::shared_ptr<ObjectCache<ObjectType, Flavor>>
 ObjectCache<ObjectType, Flavor>::create(
     size_t maximumCacheSizeBytes,
-    size_t minimumEntryCount) {
+    size_t minimumEntryCount,
+    size_t shardCount,
+    CacheEvictionPolicy evictionPolicy) {
   // Allow make_shared with private constructor.
   struct OC : ObjectCache<ObjectType, Flavor> {
-    OC(size_t x, size_t y) : ObjectCache<ObjectType, Flavor>{x, y} {}
+    OC(size_t x, size_t y, size_t z, CacheEvictionPolicy p)
+        : ObjectCache<ObjectType, Flavor>{x, y, z, p} {}
   };
-  return std::make_shared<OC>(maximumCacheSizeBytes, minimumEntryCount);
+  return std::make_shared<OC>(
+      maximumCacheSizeBytes, minimumEntryCount, shardCount, evictionPolicy);
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 ObjectCache<ObjectType, Flavor>::ObjectCache(
     size_t maximumCacheSizeBytes,
-    size_t minimumEntryCount)
-    : maximumCacheSizeBytes_{maximumCacheSizeBytes},
-      minimumEntryCount_{minimumEntryCount} {}
+    size_t minimumEntryCount,
+    size_t shardCount,
+    CacheEvictionPolicy evictionPolicy)
+    : shardCount_{std::max<size_t>(shardCount, 1)},
+      evictionPolicy_{evictionPolicy},
+      maximumCacheSizeBytes_{maximumCacheSizeBytes / shardCount_},
+      // Round up so that the total minimum is never lower than requested.
+      minimumEntryCount_{(minimumEntryCount + shardCount_ - 1) / shardCount_},
+      shards_{std::make_unique<Shard[]>(shardCount_)} {
+  if (evictionPolicy_ == CacheEvictionPolicy::TinyLFU) {
+    // The cache is budgeted in bytes rather than entries, assume objects are
+    // 4KiB on average to size the frequency sketch.
+    auto expectedEntries = std::max<size_t>(
+        maximumCacheSizeBytes / shardCount_ / 4096, minimumEntryCount_);
+    for (size_t i = 0; i < shardCount_; ++i) {
+      shards_[i].state.lock()->frequencySketch.emplace(expectedEntries);
+    }
+  }
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+typename ObjectCache<ObjectType, Flavor>::Shard&
+ObjectCache<ObjectType, Flavor>::getShard(const ObjectId& hash) const noexcept {
+  if (shardCount_ == 1) {
+    return shards_[0];
+  }
+  // The F14 map inside each shard uses ObjectId's hash code directly, mix it
+  // so that the shard selection isn't correlated with the map's buckets.
+  return shards_[folly::hash::twang_mix64(hash.getHashCode()) % shardCount_];
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+uint64_t ObjectCache<ObjectType, Flavor>::getSketchKey(
+    const ObjectId& hash) noexcept {
+  // getHashCode() only looks at a few bytes of the ObjectId, hash all of them
+  // to keep sketch collisions independent of the ObjectId layout.
+  auto bytes = hash.getBytes();
+  return folly::hash::SpookyHashV2::Hash64(bytes.data(), bytes.size(), 0);
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+typename ObjectCache<ObjectType, Flavor>::LockedState
+ObjectCache<ObjectType, Flavor>::lockShard(Shard& shard) {
+  // A zero timeout is a non-blocking attempt to acquire the lock.
+  auto state = shard.state.lock(std::chrono::nanoseconds::zero());
+  if (!state.isNull()) {
+    return state;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  state = shard.state.lock();
+  auto waited = std::chrono::steady_clock::now() - start;
+  shard.lockContentionCount.fetch_add(1, std::memory_order_relaxed);
+  shard.lockWaitNanos.fetch_add(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count(),
+      std::memory_order_relaxed);
+  return state;
+}
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 template <ObjectCacheFlavor F>
@@ -90,7 +151,7 @@ ObjectCache<ObjectType, Flavor>::getInterestHandle(
   // runs after the lock is released.
   ObjectInterestHandle<ObjectType> interestHandle;
 
-  auto state = state_.lock();
+  auto state = lockShard(getShard(hash));
 
   auto item = getImpl(hash, *state);
   if (!item) {
@@ -129,7 +190,7 @@ typename std::enable_if_t<
     typename ObjectCache<ObjectType, Flavor>::ObjectPtr>
 ObjectCache<ObjectType, Flavor>::getSimple(const ObjectId& hash) {
   XLOG(DBG6) << "BlobCache::getSimple " << hash;
-  auto state = state_.lock();
+  auto state = lockShard(getShard(hash));
 
   if (auto item = getImpl(hash, *state)) {
     return item->object;
@@ -141,6 +202,10 @@ template <typename ObjectType, ObjectCacheFlavor Flavor>
 typename ObjectCache<ObjectType, Flavor>::CacheItem*
 ObjectCache<ObjectType, Flavor>::getImpl(const ObjectId& hash, State& state) {
   XLOG(DBG6) << "ObjectCache::getImpl " << hash;
+  if (state.frequencySketch) {
+    state.frequencySketch->increment(getSketchKey(hash));
+  }
+
   auto* item = folly::get_ptr(state.items, hash);
   if (!item) {
     XLOG(DBG6) << "ObjectCache::getImpl missed";
@@ -190,8 +255,14 @@ ObjectCache<ObjectType, Flavor>::insertInterestHandle(
 
   XLOG(DBG6) << "  creating entry with generation=" << cacheItemGeneration;
 
-  auto state = state_.lock();
+  auto state = lockShard(getShard(object->getHash()));
   auto [item, inserted] = insertImpl(std::move(object), *state);
+  if (!item) {
+    // Not admitted into the cache: the handle can only point at the object
+    // itself.
+    interestHandle.objectCache_.reset();
+    return interestHandle;
+  }
   switch (interest) {
     case Interest::UnlikelyNeededAgain:
       break;
@@ -219,7 +290,7 @@ typename std::enable_if_t<F == ObjectCacheFlavor::Simple, void>
 ObjectCache<ObjectType, Flavor>::insertSimple(
     ObjectCache<ObjectType, Flavor>::ObjectPtr object) {
   XLOG(DBG6) << "ObjectCache::insertSimple " << object->getHash();
-  auto state = state_.lock();
+  auto state = lockShard(getShard(object->getHash()));
   insertImpl(std::move(object), *state);
 }
 
@@ -231,6 +302,13 @@ ObjectCache<ObjectType, Flavor>::insertImpl(ObjectPtr object, State& state) {
   auto hash = object->getHash();
   auto size = object->getSizeBytes();
 
+  if (state.frequencySketch && state.items.count(hash) == 0 &&
+      !shouldAdmit(hash, size, state)) {
+    XLOG(DBG6) << "ObjectCache::insertImpl rejected " << hash;
+    ++state.admissionRejectionCount;
+    return std::make_pair(nullptr, false);
+  }
+
   // the following should be no except
 
   auto [iter, inserted] =
@@ -255,32 +333,129 @@ ObjectCache<ObjectType, Flavor>::insertImpl(ObjectPtr object, State& state) {
   return std::make_pair(itemPtr, inserted);
 }
 
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+bool ObjectCache<ObjectType, Flavor>::shouldAdmit(
+    const ObjectId& hash,
+    size_t size,
+    State& state) noexcept {
+  if (!state.frequencySketch) {
+    return true;
+  }
+  // Only filter when inserting would force an eviction.
+  if (state.totalSize + size <=
+          maximumCacheSizeBytes_.load(std::memory_order_relaxed) ||
+      state.evictionQueue.size() < minimumEntryCount_ ||
+      state.evictionQueue.empty()) {
+    return true;
+  }
+
+  const auto& victim = state.evictionQueue.front();
+  auto candidateFrequency = state.frequencySketch->estimate(getSketchKey(hash));
+  auto victimFrequency =
+      state.frequencySketch->estimate(getSketchKey(victim.object->getHash()));
+  return candidateFrequency > victimFrequency;
+}
+
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 bool ObjectCache<ObjectType, Flavor>::contains(const ObjectId& hash) const {
-  auto state = state_.lock();
+  auto state = lockShard(getShard(hash));
   return 1 == state->items.count(hash);
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::clear() {
   XLOG(DBG6) << "ObjectCache::clear";
-  auto state = state_.lock();
-  state->totalSize = 0;
-  state->evictionQueue.clear();
-  state->items.clear();
+  for (size_t i = 0; i < shardCount_; ++i) {
+    auto state = lockShard(shards_[i]);
+    state->totalSize = 0;
+    state->evictionQueue.clear();
+    state->items.clear();
+  }
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+std::vector<ObjectId> ObjectCache<ObjectType, Flavor>::getHotObjectIds(
+    size_t maxCount) const {
+  // Objects aren't necessarily spread evenly across shards, so any shard may
+  // have to provide all of them.
+  std::vector<std::vector<ObjectId>> shardIds(shardCount_);
+  size_t longest = 0;
+  size_t total = 0;
+  for (size_t i = 0; i < shardCount_; ++i) {
+    auto state = lockShard(shards_[i]);
+    auto& ids = shardIds[i];
+    ids.reserve(std::min(maxCount, state->evictionQueue.size()));
+    // The most recently used entries are at the back of the queue.
+    for (auto it = state->evictionQueue.rbegin();
+         it != state->evictionQueue.rend() && ids.size() < maxCount;
+         ++it) {
+      ids.push_back(it->object->getHash());
+    }
+    longest = std::max(longest, ids.size());
+    total += ids.size();
+  }
+
+  std::vector<ObjectId> result;
+  result.reserve(std::min(maxCount, total));
+  for (size_t rank = 0; rank < longest; ++rank) {
+    for (auto& ids : shardIds) {
+      if (result.size() == maxCount) {
+        return result;
+      }
+      if (rank < ids.size()) {
+        result.push_back(std::move(ids[rank]));
+      }
+    }
+  }
+  return result;
+}
+
+template <typename ObjectType, ObjectCacheFlavor Flavor>
+void ObjectCache<ObjectType, Flavor>::setMaximumCacheSize(
+    size_t maximumCacheSizeBytes) {
+  XLOG(DBG3) << "ObjectCache::setMaximumCacheSize " << maximumCacheSizeBytes;
+  maximumCacheSizeBytes_.store(
+      maximumCacheSizeBytes / shardCount_, std::memory_order_relaxed);
+  for (size_t i = 0; i < shardCount_; ++i) {
+    auto state = lockShard(shards_[i]);
+    evictUntilFits(*state);
+  }
 }
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 typename ObjectCache<ObjectType, Flavor>::Stats
 ObjectCache<ObjectType, Flavor>::getStats() const {
-  auto state = state_.lock();
   Stats stats;
-  stats.objectCount = state->items.size();
-  stats.totalSizeInBytes = state->totalSize;
-  stats.hitCount = state->hitCount;
-  stats.missCount = state->missCount;
-  stats.evictionCount = state->evictionCount;
-  stats.dropCount = state->dropCount;
+  stats.shards.reserve(shardCount_);
+  for (size_t i = 0; i < shardCount_; ++i) {
+    auto& shard = shards_[i];
+    ShardStats shardStats;
+    {
+      auto state = lockShard(shard);
+      shardStats.objectCount = state->items.size();
+      shardStats.totalSizeInBytes = state->totalSize;
+      shardStats.hitCount = state->hitCount;
+      shardStats.missCount = state->missCount;
+      shardStats.evictionCount = state->evictionCount;
+      shardStats.dropCount = state->dropCount;
+      shardStats.admissionRejectionCount = state->admissionRejectionCount;
+    }
+    shardStats.lockContentionCount =
+        shard.lockContentionCount.load(std::memory_order_relaxed);
+    shardStats.lockWaitTime = std::chrono::nanoseconds{
+        shard.lockWaitNanos.load(std::memory_order_relaxed)};
+
+    stats.objectCount += shardStats.objectCount;
+    stats.totalSizeInBytes += shardStats.totalSizeInBytes;
+    stats.hitCount += shardStats.hitCount;
+    stats.missCount += shardStats.missCount;
+    stats.evictionCount += shardStats.evictionCount;
+    stats.dropCount += shardStats.dropCount;
+    stats.admissionRejectionCount += shardStats.admissionRejectionCount;
+    stats.lockContentionCount += shardStats.lockContentionCount;
+    stats.lockWaitTime += shardStats.lockWaitTime;
+    stats.shards.push_back(shardStats);
+  }
   return stats;
 }
 
@@ -289,7 +464,7 @@ void ObjectCache<ObjectType, Flavor>::dropInterestHandle(
     const ObjectId& hash,
     uint64_t generation) noexcept {
   XLOG(DBG6) << "dropInterestHandle " << hash << " generation=" << generation;
-  auto state = state_.lock();
+  auto state = lockShard(getShard(hash));
 
   auto* item = folly::get_ptr(state->items, hash);
   if (!item) {
@@ -319,12 +494,14 @@ void ObjectCache<ObjectType, Flavor>::dropInterestHandle(
 
 template <typename ObjectType, ObjectCacheFlavor Flavor>
 void ObjectCache<ObjectType, Flavor>::evictUntilFits(State& state) noexcept {
+  auto maximumCacheSizeBytes =
+      maximumCacheSizeBytes_.load(std::memory_order_relaxed);
   XLOG(DBG6) << "ObjectCache::evictUntilFits "
              << "state.totalSize=" << state.totalSize
-             << ", maximumCacheSizeBytes_=" << maximumCacheSizeBytes_
+             << ", maximumCacheSizeBytes_=" << maximumCacheSizeBytes
              << ", evictionQueue.size()=" << state.evictionQueue.size()
              << ", minimumEntryCount_=" << minimumEntryCount_;
-  while (state.totalSize > maximumCacheSizeBytes_ &&
+  while (state.totalSize > maximumCacheSizeBytes &&
          state.evictionQueue.size() > minimumEntryCount_) {
     evictOne(state);
   }
@@ -335,6 +512,9 @@ void ObjectCache<ObjectType, Flavor>::evictOne(State& state) noexcept {
   const auto& front = state.evictionQueue.front();
   state.evictionQueue.pop_front();
   ++state.evictionCount;
+  if (evictionCallback_) {
+    evictionCallback_(front.object);
+  }
   evictItem(state, front);
 }
 
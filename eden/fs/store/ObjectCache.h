@@ -10,11 +10,21 @@
 #include <folly/IntrusiveList.h>
 #include <folly/Synchronized.h>
 #include <folly/container/F14Map.h>
+#include <folly/lang/Align.h>
 #include <folly/synchronization/DistributedMutex.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <optional>
+#include <vector>
 
+#include "eden/fs/config/CacheEvictionPolicy.h"
 #include "eden/fs/model/ObjectId.h"
+#include "eden/fs/utils/FrequencySketch.h"
 
 namespace facebook::eden {
 
@@ -97,6 +107,20 @@ class ObjectInterestHandle {
  * handles do not prevent entries from being evicted from the cache, but a lack
  * of InterestHandles for an object can mean it is evicted early.
  *
+ * The cache can optionally be split into a number of independent shards,
+ * selected by the hash of the ObjectId. Each shard has its own lock, eviction
+ * queue and an equal share of the size budget and minimum entry count. With a
+ * single shard (the default), the cache behaves as one global LRU. With more
+ * shards, lookups from many threads no longer serialize on a single mutex, at
+ * the cost of eviction order only being LRU within a shard.
+ *
+ * With the TinyLFU eviction policy, each shard additionally keeps an
+ * approximate access frequency for recently seen hashes. Once a shard is full,
+ * a new object is only admitted if it was requested more often than the
+ * object that would be evicted to make room for it. This makes the cache
+ * resistant to large one-off scans. Objects that are not admitted are still
+ * returned to the caller, they just aren't cached.
+ *
  * This class is not intended to be used directly, instead child classes should
  * be used that only allow clients to use one flavor of get and insert. See
  * BlobCache and TreeCache for examples of each flavor.
@@ -138,18 +162,37 @@ class ObjectCache
     ObjectInterestHandle<ObjectType> interestHandle;
   };
 
-  struct Stats {
+  struct ShardStats {
     size_t objectCount{0};
     size_t totalSizeInBytes{0};
     uint64_t hitCount{0};
     uint64_t missCount{0};
     uint64_t evictionCount{0};
     uint64_t dropCount{0};
+    /// Number of times the shard's lock was already held when acquiring it.
+    uint64_t lockContentionCount{0};
+    /// Total time spent waiting for the shard's lock when it was contended.
+    std::chrono::nanoseconds lockWaitTime{0};
+    /// Number of inserts that the admission filter refused to cache.
+    uint64_t admissionRejectionCount{0};
   };
 
+  /**
+   * Totals across every shard, followed by the per-shard breakdown.
+   */
+  struct Stats : ShardStats {
+    std::vector<ShardStats> shards;
+  };
+
+  /**
+   * Create a cache split into `shardCount` independent shards. A shardCount
+   * of 0 is treated as 1.
+   */
   static std::shared_ptr<ObjectCache<ObjectType, Flavor>> create(
       size_t maximumCacheSizeBytes,
-      size_t minimumEntryCount);
+      size_t minimumEntryCount,
+      size_t shardCount = 1,
+      CacheEvictionPolicy evictionPolicy = CacheEvictionPolicy::LRU);
   ~ObjectCache() {
     clear();
   }
@@ -221,12 +264,60 @@ class ObjectCache
 
   /**
    * Return information about the current size of the cache and the total number
-   * of hits and misses.
+   * of hits and misses, both in aggregate and for each shard.
    */
   Stats getStats() const;
 
+  /**
+   * Return the ids of up to `maxCount` cached objects, most recently used
+   * first. Shards are interleaved, so the order is only approximate when the
+   * cache has more than one shard.
+   */
+  std::vector<ObjectId> getHotObjectIds(size_t maxCount) const;
+
+  size_t getShardCount() const {
+    return shardCount_;
+  }
+
+  CacheEvictionPolicy getEvictionPolicy() const {
+    return evictionPolicy_;
+  }
+
+  /**
+   * Returns the current maximum size of the cache, in bytes.
+   */
+  size_t getMaximumCacheSize() const {
+    return maximumCacheSizeBytes_.load(std::memory_order_relaxed) *
+        shardCount_;
+  }
+
+  /**
+   * Change the maximum size of the cache at runtime. When shrinking, entries
+   * are evicted right away until every shard fits in its new budget.
+   */
+  void setMaximumCacheSize(size_t maximumCacheSizeBytes);
+
  protected:
-  explicit ObjectCache(size_t maximumCacheSizeBytes, size_t minimumEntryCount);
+  explicit ObjectCache(
+      size_t maximumCacheSizeBytes,
+      size_t minimumEntryCount,
+      size_t shardCount = 1,
+      CacheEvictionPolicy evictionPolicy = CacheEvictionPolicy::LRU);
+
+  using EvictionCallback = std::function<void(const ObjectPtr&)>;
+
+  /**
+   * Register a function called for every object evicted to make room for
+   * others. It is not called for objects dropped because their last interest
+   * handle went away, nor by clear().
+   *
+   * The callback runs with a shard lock held: it must be cheap, must not
+   * throw, and must not call back into the cache. Must be set before the
+   * cache is shared with other threads.
+   */
+  void setEvictionCallback(EvictionCallback callback) {
+    evictionCallback_ = std::move(callback);
+  }
 
  private:
   /*
@@ -277,8 +368,35 @@ class ObjectCache
     uint64_t missCount{0};
     uint64_t evictionCount{0};
     uint64_t dropCount{0};
+    uint64_t admissionRejectionCount{0};
+
+    /// Only set when the eviction policy is TinyLFU.
+    std::optional<FrequencySketch> frequencySketch;
   };
 
+  using LockedState =
+      typename folly::Synchronized<State, folly::DistributedMutex>::LockedPtr;
+
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    folly::Synchronized<State, folly::DistributedMutex> state;
+
+    // Only updated when the lock is contended, so these are kept outside of
+    // State to be readable without taking the lock.
+    std::atomic<uint64_t> lockContentionCount{0};
+    std::atomic<uint64_t> lockWaitNanos{0};
+  };
+
+  /**
+   * Returns the shard responsible for the given hash.
+   */
+  Shard& getShard(const ObjectId& hash) const noexcept;
+
+  /**
+   * Acquire the lock of the given shard, recording contention statistics if
+   * the lock was not immediately available.
+   */
+  static LockedState lockShard(Shard& shard);
+
   /**
    * If an object for the given hash is in cache, return it. If the object is
    * not in cache, return nullptr (and an empty interest handle).
@@ -294,19 +412,41 @@ class ObjectCache
    * duplicate insert) and a boolean indicating if this item was freshly
    * inserted (returns false if this is a duplicate insert).
    *
+   * If the eviction policy rejects the object, nothing is inserted and
+   * {nullptr, false} is returned.
+   *
    * Does not do anything related to InterestHandles
    */
   std::pair<CacheItem*, bool> insertImpl(ObjectPtr object, State& state);
 
+  /**
+   * Returns false if the admission filter decides an object of the given hash
+   * and size should not be inserted. Always returns true for LRU.
+   */
+  bool shouldAdmit(const ObjectId& hash, size_t size, State& state) noexcept;
+
+  /**
+   * Key under which accesses to the given hash are counted in the frequency
+   * sketch.
+   */
+  static uint64_t getSketchKey(const ObjectId& hash) noexcept;
+
   void dropInterestHandle(const ObjectId& hash, uint64_t generation) noexcept;
 
   void evictUntilFits(State& state) noexcept;
   void evictOne(State& state) noexcept;
   void evictItem(State&, const CacheItem& item) noexcept;
 
-  const size_t maximumCacheSizeBytes_;
+  const size_t shardCount_;
+  const CacheEvictionPolicy evictionPolicy_;
+
+  /// Budget of each individual shard. May be changed by setMaximumCacheSize.
+  std::atomic<size_t> maximumCacheSizeBytes_;
   const size_t minimumEntryCount_;
-  folly::Synchronized<State, folly::DistributedMutex> state_;
+
+  std::unique_ptr<Shard[]> shards_;
+
+  EvictionCallback evictionCallback_;
 
   friend class ObjectInterestHandle<ObjectType>;
 };
@@ -7,10 +7,12 @@
 
 #pragma once
 
+#include <chrono>
 #include <optional>
 #include <string_view>
 #include <unordered_map>
 
+#include <folly/CancellationToken.h>
 #include <folly/portability/SysTypes.h>
 
 #include "eden/fs/store/ImportPriority.h"
@@ -70,6 +72,26 @@ class ObjectFetchContext : public RefCounted {
 
   virtual void didFetch(ObjectType, const ObjectId&, Origin) {}
 
+  /**
+   * Called when a BackingStore request made on behalf of this context
+   * completed, with the time it took. Requests may overlap, in which case the
+   * durations add up to more than the time spent waiting.
+   */
+  virtual void didWaitForBackingStore(std::chrono::nanoseconds) {}
+
+  /**
+   * Called along with didFetch, with the time it took to get the object from
+   * `origin` and its size in bytes. Lookups of objects another request was
+   * already fetching count the time they waited for that fetch.
+   */
+  virtual void didSpendFetching(Origin, std::chrono::nanoseconds, uint64_t) {}
+
+  /**
+   * Called when a directory inode loaded on behalf of this context finished
+   * loading, with the time it took, including fetching its tree.
+   */
+  virtual void didLoadInode(std::chrono::nanoseconds) {}
+
   virtual std::optional<pid_t> getClientPid() const {
     return std::nullopt;
   }
@@ -90,6 +112,15 @@ class ObjectFetchContext : public RefCounted {
   virtual const std::unordered_map<std::string, std::string>* getRequestInfo()
       const = 0;
 
+  /**
+   * Cancelled when the caller stopped waiting for the objects, e.g. when the
+   * Thrift client disconnected or the kernel interrupted the FUSE request.
+   * Queued imports that nobody waits on anymore are then dropped.
+   */
+  virtual folly::CancellationToken getCancellationToken() const {
+    return {};
+  }
+
   /**
    * Support deprioritizing in sub-classes.
    * Note: Normally, each ObjectFetchContext is designed to be used for only one
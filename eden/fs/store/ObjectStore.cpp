@@ -8,7 +8,9 @@
 #include "ObjectStore.h"
 
 #include <folly/Conv.h>
+#include <folly/executors/QueuedImmediateExecutor.h>
 #include <folly/futures/Future.h>
+#include <folly/io/Cursor.h>
 #include <folly/io/IOBuf.h>
 
 #include <stdexcept>
@@ -18,6 +20,7 @@
 #include "eden/fs/store/BackingStore.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/store/PersistentTreeCache.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/utils/ImmediateFuture.h"
 #include "eden/fs/utils/Throw.h"
@@ -32,7 +35,23 @@ namespace facebook::eden {
 
 namespace {
 constexpr uint64_t kImportPriorityDeprioritizeAmount = 1;
+constexpr uint32_t kMaxFetchHeavyEventsPerMinute = 60;
+
+/**
+ * Share the `length` bytes of buf starting at `offset`, or fewer if buf is
+ * shorter.
+ */
+unique_ptr<folly::IOBuf>
+sliceBuffer(const folly::IOBuf& buf, uint64_t offset, uint64_t length) {
+  folly::io::Cursor cursor{&buf};
+  auto result = folly::IOBuf::create(0);
+  if (cursor.canAdvance(offset)) {
+    cursor.skip(offset);
+    cursor.cloneAtMost(result, length);
+  }
+  return result;
 }
+} // namespace
 
 std::shared_ptr<ObjectStore> ObjectStore::create(
     shared_ptr<LocalStore> localStore,
@@ -42,7 +61,8 @@ std::shared_ptr<ObjectStore> ObjectStore::create(
     std::shared_ptr<ProcessNameCache> processNameCache,
     std::shared_ptr<StructuredLogger> structuredLogger,
     std::shared_ptr<const EdenConfig> edenConfig,
-    CaseSensitivity caseSensitive) {
+    CaseSensitivity caseSensitive,
+    std::shared_ptr<PersistentTreeCache> persistentTreeCache) {
   return std::shared_ptr<ObjectStore>{new ObjectStore{
       std::move(localStore),
       std::move(backingStore),
@@ -51,7 +71,8 @@ std::shared_ptr<ObjectStore> ObjectStore::create(
       processNameCache,
       structuredLogger,
       edenConfig,
-      caseSensitive}};
+      caseSensitive,
+      std::move(persistentTreeCache)}};
 }
 
 ObjectStore::ObjectStore(
@@ -62,9 +83,22 @@ ObjectStore::ObjectStore(
     std::shared_ptr<ProcessNameCache> processNameCache,
     std::shared_ptr<StructuredLogger> structuredLogger,
     std::shared_ptr<const EdenConfig> edenConfig,
-    CaseSensitivity caseSensitive)
-    : metadataCache_{folly::in_place, kCacheSize},
+    CaseSensitivity caseSensitive,
+    std::shared_ptr<PersistentTreeCache> persistentTreeCache)
+    : metadataCache_{edenConfig->blobMetadataCacheSize.getValue()},
+      negativeCache_{
+          folly::in_place,
+          std::max<size_t>(edenConfig->negativeCacheSize.getValue(), 1)},
+      blobChunkSize_{
+          std::max<uint64_t>(edenConfig->blobRangeChunkSize.getValue(), 1)},
+      blobChunkCache_{
+          folly::in_place,
+          std::max<size_t>(edenConfig->blobRangeCacheChunks.getValue(), 1)},
+      symlinkTargetCache_{
+          folly::in_place,
+          std::max<size_t>(edenConfig->symlinkTargetCacheSize.getValue(), 1)},
       treeCache_{std::move(treeCache)},
+      persistentTreeCache_{std::move(persistentTreeCache)},
       localStore_{std::move(localStore)},
       backingStore_{std::move(backingStore)},
       stats_{std::move(stats)},
@@ -93,6 +127,9 @@ void ObjectStore::updateProcessFetch(
 }
 
 void ObjectStore::sendFetchHeavyEvent(pid_t pid, uint64_t fetch_count) const {
+  if (!fetchHeavyEventSampler_.sample(1, kMaxFetchHeavyEventsPerMinute)) {
+    return;
+  }
   auto processName = processNameCache_->getProcessName(pid);
   if (processName) {
     std::replace(processName->begin(), processName->end(), '\0', ' ');
@@ -166,6 +203,52 @@ BlobMetadata computeBlobMetadata(const Blob& blob) {
 
 } // namespace
 
+bool ObjectStore::isKnownMissing(
+    const ObjectId& id,
+    ObjectFetchContext::ObjectType type) const {
+  if (edenConfig_->negativeCacheTtl.getValue().count() == 0) {
+    return false;
+  }
+
+  auto negativeCache = negativeCache_.wlock();
+  auto it = negativeCache->find(id);
+  if (it == negativeCache->end() || !(it->second.types & (1 << type))) {
+    return false;
+  }
+  if (it->second.expiry <= std::chrono::steady_clock::now()) {
+    negativeCache->erase(it);
+    return false;
+  }
+  stats_->increment(&ObjectStoreStats::negativeCacheHit);
+  return true;
+}
+
+void ObjectStore::recordMissing(
+    const ObjectId& id,
+    ObjectFetchContext::ObjectType type) const {
+  auto ttl = edenConfig_->negativeCacheTtl.getValue();
+  if (ttl.count() == 0) {
+    return;
+  }
+
+  auto expiry = std::chrono::steady_clock::now() +
+      std::chrono::duration_cast<std::chrono::steady_clock::duration>(ttl);
+  auto negativeCache = negativeCache_.wlock();
+  auto it = negativeCache->find(id);
+  if (it == negativeCache->end()) {
+    negativeCache->set(
+        id, NegativeCacheEntry{expiry, static_cast<uint8_t>(1 << type)});
+  } else {
+    it->second.expiry = expiry;
+    it->second.types |= 1 << type;
+  }
+  stats_->increment(&ObjectStoreStats::negativeCacheInsert);
+}
+
+void ObjectStore::clearNegativeCache() {
+  negativeCache_.wlock()->clear();
+}
+
 ImmediateFuture<shared_ptr<const Tree>> ObjectStore::getRootTree(
     const RootId& rootId,
     const ObjectFetchContextPtr& context) const {
@@ -200,6 +283,7 @@ ImmediateFuture<shared_ptr<const Tree>> ObjectStore::getTree(
     const ObjectId& id,
     const ObjectFetchContextPtr& fetchContext) const {
   DurationScope statScope{stats_, &ObjectStoreStats::getTree};
+  folly::stop_watch<> watch;
 
   // Check in the LocalStore first
 
@@ -217,36 +301,113 @@ ImmediateFuture<shared_ptr<const Tree>> ObjectStore::getTree(
   if (auto maybeTree = treeCache_->get(id)) {
     fetchContext->didFetch(
         ObjectFetchContext::Tree, id, ObjectFetchContext::FromMemoryCache);
+    fetchContext->didSpendFetching(
+        ObjectFetchContext::FromMemoryCache,
+        watch.elapsed(),
+        maybeTree->getSizeBytes());
 
     updateProcessFetch(*fetchContext);
 
     return changeCaseSensitivity(maybeTree, caseSensitive_);
   }
 
+  if (persistentTreeCache_) {
+    if (auto tree = persistentTreeCache_->get(id)) {
+      stats_->increment(&ObjectStoreStats::getTreeFromPersistentCache);
+      auto sharedTree = std::shared_ptr<const Tree>(std::move(tree));
+      treeCache_->insert(sharedTree);
+      recordTreeBlobMetadata(*sharedTree);
+      fetchContext->didFetch(
+          ObjectFetchContext::Tree, id, ObjectFetchContext::FromDiskCache);
+      fetchContext->didSpendFetching(
+          ObjectFetchContext::FromDiskCache,
+          watch.elapsed(),
+          sharedTree->getSizeBytes());
+
+      updateProcessFetch(*fetchContext);
+
+      return changeCaseSensitivity(std::move(sharedTree), caseSensitive_);
+    }
+  }
+
+  if (isKnownMissing(id, ObjectFetchContext::Tree)) {
+    return makeImmediateFuture<shared_ptr<const Tree>>(
+        std::domain_error(fmt::format("tree {} not found", id)));
+  }
+
   deprioritizeWhenFetchHeavy(*fetchContext);
 
-  return ImmediateFuture{backingStore_->getTree(id, fetchContext)}.thenValue(
-      [self = shared_from_this(),
-       statScope = std::move(statScope),
-       id,
-       fetchContext = fetchContext.copy()](BackingStore::GetTreeResult result) {
-        if (!result.tree) {
-          // TODO: Perhaps we should do some short-term negative
-          // caching?
-          XLOG(DBG2) << "unable to find tree " << id;
-          throwf<std::domain_error>("tree {} not found", id);
-        }
+  return fetchRecordingMisses(
+             id,
+             ObjectFetchContext::Tree,
+             fetchContext,
+             [&] { return backingStore_->getTree(id, fetchContext); })
+      .thenValue(
+          [self = shared_from_this(),
+           statScope = std::move(statScope),
+           watch,
+           id,
+           fetchContext =
+               fetchContext.copy()](BackingStore::GetTreeResult result) {
+            if (!result.tree) {
+              XLOG(DBG2) << "unable to find tree " << id;
+              self->recordMissing(id, ObjectFetchContext::Tree);
+              throwf<std::domain_error>("tree {} not found", id);
+            }
 
-        // promote to shared_ptr so we can store in the cache and return
-        auto sharedTree = std::shared_ptr<const Tree>(std::move(result.tree));
-        self->treeCache_->insert(sharedTree);
-        fetchContext->didFetch(ObjectFetchContext::Tree, id, result.origin);
-        self->updateProcessFetch(*fetchContext);
-        return changeCaseSensitivity(sharedTree, self->caseSensitive_);
-      });
+            // promote to shared_ptr so we can store in the cache and return
+            auto sharedTree =
+                std::shared_ptr<const Tree>(std::move(result.tree));
+            self->treeCache_->insert(sharedTree);
+            if (self->persistentTreeCache_) {
+              self->persistentTreeCache_->insert(*sharedTree);
+            }
+            self->recordTreeBlobMetadata(*sharedTree);
+            fetchContext->didFetch(
+                ObjectFetchContext::Tree, id, result.origin);
+            fetchContext->didSpendFetching(
+                result.origin, watch.elapsed(), sharedTree->getSizeBytes());
+            self->updateProcessFetch(*fetchContext);
+            return changeCaseSensitivity(sharedTree, self->caseSensitive_);
+          });
+}
+
+void ObjectStore::recordTreeBlobMetadata(const Tree& tree) const {
+  if (!edenConfig_->blobMetadataFromTrees.getValue()) {
+    return;
+  }
+  size_t recorded = 0;
+  for (const auto& [name, entry] : tree) {
+    const auto& size = entry.getSize();
+    const auto& sha1 = entry.getContentSha1();
+    if (entry.isTree() || !size || !sha1) {
+      continue;
+    }
+    metadataCache_.insert(entry.getHash(), BlobMetadata{*sha1, *size});
+    ++recorded;
+  }
+  if (recorded != 0) {
+    stats_->increment(&ObjectStoreStats::blobMetadataFromTree, recorded);
+  }
+}
+
+ImmediateFuture<std::vector<folly::Try<shared_ptr<const Tree>>>>
+ObjectStore::getTreeBatch(
+    const std::vector<ObjectId>& ids,
+    const ObjectFetchContextPtr& context) const {
+  DurationScope statScope{stats_, &ObjectStoreStats::getTreeBatch};
+
+  std::vector<ImmediateFuture<shared_ptr<const Tree>>> futures;
+  futures.reserve(ids.size());
+  for (const auto& id : ids) {
+    futures.push_back(
+        makeImmediateFutureWith([&] { return getTree(id, context); }));
+  }
+  return collectAll(std::move(futures))
+      .ensure([statScope = std::move(statScope)] {});
 }
 
-ImmediateFuture<folly::Unit> ObjectStore::prefetchBlobs(
+ImmediateFuture<size_t> ObjectStore::prefetchBlobs(
     ObjectIdRange ids,
     const ObjectFetchContextPtr& fetchContext) const {
   // In theory we could/should ask the localStore_ to filter the list
@@ -258,7 +419,7 @@ ImmediateFuture<folly::Unit> ObjectStore::prefetchBlobs(
   // mercurial backing store to ensure that its local hgcache storage
   // has entries for all of the requested keys.
   if (ids.empty()) {
-    return folly::unit;
+    return size_t{0};
   }
   return backingStore_->prefetchBlobs(ids, fetchContext);
 }
@@ -267,20 +428,56 @@ ImmediateFuture<shared_ptr<const Blob>> ObjectStore::getBlob(
     const ObjectId& id,
     const ObjectFetchContextPtr& fetchContext) const {
   DurationScope statScope{stats_, &ObjectStoreStats::getBlob};
+  folly::stop_watch<> watch;
 
-  deprioritizeWhenFetchHeavy(*fetchContext);
-  return ImmediateFuture<BackingStore::GetBlobResult>{
-      backingStore_->getBlob(id, fetchContext)}
-      .thenValue(
-          [self = shared_from_this(),
-           statScope = std::move(statScope),
-           id,
-           fetchContext =
-               fetchContext.copy()](BackingStore::GetBlobResult result)
-              -> std::shared_ptr<const Blob> {
+  if (isKnownMissing(id, ObjectFetchContext::Blob)) {
+    return makeImmediateFuture<shared_ptr<const Blob>>(
+        std::domain_error(fmt::format("blob {} not found", id)));
+  }
+
+  // Join the fetch of this blob if one is already in flight.
+  auto [fetch, startFetch] = [&] {
+    auto inFlightBlobs = inFlightBlobs_.wlock();
+    auto [it, inserted] = inFlightBlobs->try_emplace(id);
+    return std::make_pair(it->second.getSemiFuture(), inserted);
+  }();
+
+  if (startFetch) {
+    deprioritizeWhenFetchHeavy(*fetchContext);
+    startBlobFetch(id, fetchContext);
+  } else {
+    stats_->increment(&ObjectStoreStats::getBlobCoalesced);
+  }
+
+  return ImmediateFuture<FetchedBlob>{std::move(fetch)}.thenValue(
+      [self = shared_from_this(),
+       statScope = std::move(statScope),
+       watch,
+       id,
+       fetchContext = fetchContext.copy()](FetchedBlob fetched) {
+        self->updateProcessFetch(*fetchContext);
+        fetchContext->didFetch(ObjectFetchContext::Blob, id, fetched.origin);
+        fetchContext->didSpendFetching(
+            fetched.origin, watch.elapsed(), fetched.blob->getSize());
+        return std::move(fetched.blob);
+      });
+}
+
+void ObjectStore::startBlobFetch(
+    const ObjectId& id,
+    const ObjectFetchContextPtr& fetchContext) const {
+  auto fetch =
+      makeImmediateFutureWith([&] {
+        return fetchRecordingMisses(
+            id, ObjectFetchContext::Blob, fetchContext, [&] {
+              return backingStore_->getBlob(id, fetchContext);
+            });
+      })
+          .thenValue([self = shared_from_this(),
+                      id](BackingStore::GetBlobResult result) -> FetchedBlob {
             if (!result.blob) {
-              // TODO: Perhaps we should do some short-term negative caching?
               XLOG(DBG2) << "unable to find blob " << id;
+              self->recordMissing(id, ObjectFetchContext::Blob);
               throwf<std::domain_error>("blob {} not found", id);
             }
             // Quick check in-memory cache first, before doing expensive
@@ -289,36 +486,152 @@ ImmediateFuture<shared_ptr<const Blob>> ObjectStore::getBlob(
             // We always cache metadata in LocalStore because it's faster to
             // query than the BackingStore, and metadata is very small (~28
             // bytes per blob).
-            if (!self->metadataCache_.rlock()->exists(id)) {
+            if (!self->metadataCache_.contains(id)) {
               auto metadata = computeBlobMetadata(*result.blob);
               self->localStore_->putBlobMetadata(id, metadata);
-              self->metadataCache_.wlock()->set(id, metadata);
+              self->metadataCache_.insert(id, metadata);
             }
-            self->updateProcessFetch(*fetchContext);
-            fetchContext->didFetch(ObjectFetchContext::Blob, id, result.origin);
-            return std::move(result.blob);
+            return FetchedBlob{std::move(result.blob), result.origin};
+          })
+          .thenTry([self = shared_from_this(),
+                    id](folly::Try<FetchedBlob>&& fetched) {
+            self->completeBlobFetch(id, fetched);
           });
+
+  // Drive the fetch to completion even though nobody holds on to its future:
+  // every caller waits on the entry in inFlightBlobs_ instead.
+  folly::futures::detachOn(
+      &folly::QueuedImmediateExecutor::instance(), std::move(fetch).semi());
+}
+
+void ObjectStore::completeBlobFetch(
+    const ObjectId& id,
+    const folly::Try<FetchedBlob>& result) const {
+  folly::SharedPromise<FetchedBlob> promise;
+  {
+    auto inFlightBlobs = inFlightBlobs_.wlock();
+    auto it = inFlightBlobs->find(id);
+    if (it == inFlightBlobs->end()) {
+      return;
+    }
+    promise = std::move(it->second);
+    inFlightBlobs->erase(it);
+  }
+  // Fulfill the promise outside of the lock as it runs the continuations of
+  // the coalesced requests.
+  promise.setTry(folly::Try<FetchedBlob>{result});
+}
+
+bool ObjectStore::supportsBlobRanges() const {
+  return backingStore_->supportsBlobRanges();
+}
+
+ImmediateFuture<unique_ptr<folly::IOBuf>> ObjectStore::getBlobRange(
+    const ObjectId& id,
+    uint64_t offset,
+    uint64_t length,
+    const ObjectFetchContextPtr& fetchContext) const {
+  if (!supportsBlobRanges()) {
+    return getBlob(id, fetchContext)
+        .thenValue([offset, length](shared_ptr<const Blob> blob) {
+          return sliceBuffer(blob->getContents(), offset, length);
+        });
+  }
+
+  DurationScope statScope{stats_, &ObjectStoreStats::getBlobRange};
+  if (isKnownMissing(id, ObjectFetchContext::Blob)) {
+    return makeImmediateFuture<unique_ptr<folly::IOBuf>>(
+        std::domain_error(fmt::format("blob {} not found", id)));
+  }
+  if (length == 0) {
+    return folly::IOBuf::create(0);
+  }
+
+  auto firstChunk = offset / blobChunkSize_;
+  auto lastChunk = (offset + length - 1) / blobChunkSize_;
+  std::vector<ImmediateFuture<shared_ptr<const folly::IOBuf>>> chunks;
+  chunks.reserve(lastChunk - firstChunk + 1);
+  for (auto index = firstChunk; index <= lastChunk; ++index) {
+    chunks.push_back(getBlobChunk(id, index, fetchContext));
+  }
+
+  return collectAllSafe(std::move(chunks))
+      .thenValue([statScope = std::move(statScope),
+                  chunkSize = blobChunkSize_,
+                  firstChunk,
+                  offset,
+                  length](std::vector<shared_ptr<const folly::IOBuf>> chunks) {
+        auto result = folly::IOBuf::create(0);
+        auto chunkStart = firstChunk * chunkSize;
+        auto end = offset + length;
+        for (const auto& chunk : chunks) {
+          auto start = std::max(offset, chunkStart) - chunkStart;
+          auto chunkEnd = std::min(end, chunkStart + chunkSize) - chunkStart;
+          result->prependChain(sliceBuffer(*chunk, start, chunkEnd - start));
+          if (chunk->computeChainDataLength() < chunkSize) {
+            // This was the last chunk of the blob.
+            break;
+          }
+          chunkStart += chunkSize;
+        }
+        return result;
+      });
+}
+
+ImmediateFuture<shared_ptr<const folly::IOBuf>> ObjectStore::getBlobChunk(
+    const ObjectId& id,
+    uint64_t index,
+    const ObjectFetchContextPtr& fetchContext) const {
+  BlobChunkKey key{id, index};
+  {
+    auto cache = blobChunkCache_.wlock();
+    auto it = cache->find(key);
+    if (it != cache->end()) {
+      stats_->increment(&ObjectStoreStats::getBlobRangeChunkCacheHit);
+      return it->second;
+    }
+  }
+
+  stats_->increment(&ObjectStoreStats::getBlobRangeChunkFetch);
+  return fetchRecordingMisses(
+             id,
+             ObjectFetchContext::Blob,
+             fetchContext,
+             [&] {
+               return backingStore_->getBlobRange(
+                   id, index * blobChunkSize_, blobChunkSize_, fetchContext);
+             })
+      .thenValue([self = shared_from_this(), key = std::move(key)](
+                     unique_ptr<folly::IOBuf> buf) {
+        shared_ptr<const folly::IOBuf> chunk = std::move(buf);
+        self->blobChunkCache_.wlock()->set(key, chunk);
+        return chunk;
+      });
 }
 
 ImmediateFuture<BlobMetadata> ObjectStore::getBlobMetadata(
     const ObjectId& id,
     const ObjectFetchContextPtr& context) const {
   DurationScope statScope{stats_, &ObjectStoreStats::getBlobMetadata};
+  folly::stop_watch<> watch;
 
   // Check in-memory cache
-  {
-    auto metadataCache = metadataCache_.wlock();
-    auto cacheIter = metadataCache->find(id);
-    if (cacheIter != metadataCache->end()) {
-      stats_->increment(&ObjectStoreStats::getBlobMetadataFromMemory);
-      context->didFetch(
-          ObjectFetchContext::BlobMetadata,
-          id,
-          ObjectFetchContext::FromMemoryCache);
+  if (auto metadata = metadataCache_.get(id)) {
+    stats_->increment(&ObjectStoreStats::getBlobMetadataFromMemory);
+    context->didFetch(
+        ObjectFetchContext::BlobMetadata,
+        id,
+        ObjectFetchContext::FromMemoryCache);
+    context->didSpendFetching(
+        ObjectFetchContext::FromMemoryCache, watch.elapsed(), 0);
+
+    updateProcessFetch(*context);
+    return *metadata;
+  }
 
-      updateProcessFetch(*context);
-      return cacheIter->second;
-    }
+  if (isKnownMissing(id, ObjectFetchContext::Blob)) {
+    return makeImmediateFuture<BlobMetadata>(
+        std::domain_error(fmt::format("blob {} not found", id)));
   }
 
   auto self = shared_from_this();
@@ -326,87 +639,177 @@ ImmediateFuture<BlobMetadata> ObjectStore::getBlobMetadata(
   // Check local store
   return localStore_->getBlobMetadata(id)
       .thenValue(
-          [self,
-           statScope = std::move(statScope),
-           id,
-           context =
-               context.copy()](std::optional<BlobMetadata>&& metadata) mutable
+          [self, id, context = context.copy(), watch](
+              std::optional<BlobMetadata>&& metadata) mutable
           -> ImmediateFuture<BlobMetadata> {
             if (metadata) {
-              self->stats_->increment(
-                  &ObjectStoreStats::getBlobMetadataFromLocalStore);
-              self->metadataCache_.wlock()->set(id, *metadata);
-              context->didFetch(
-                  ObjectFetchContext::BlobMetadata,
-                  id,
-                  ObjectFetchContext::FromDiskCache);
-
-              self->updateProcessFetch(*context);
+              self->recordLocalStoreBlobMetadata(
+                  id, *metadata, *context, watch);
               return *metadata;
             }
+            return self->getBlobMetadataFromBackingStore(id, context, watch);
+          })
+      .ensure([statScope = std::move(statScope)] {});
+}
 
-            self->deprioritizeWhenFetchHeavy(*context);
-
-            auto localMetadata =
-                self->backingStore_->getLocalBlobMetadata(id, context);
-            if (localMetadata) {
-              self->stats_->increment(
-                  &ObjectStoreStats::getLocalBlobMetadataFromBackingStore);
-              self->metadataCache_.wlock()->set(id, *localMetadata);
-              self->localStore_->putBlobMetadata(id, *localMetadata);
-              context->didFetch(
-                  ObjectFetchContext::BlobMetadata,
-                  id,
-                  ObjectFetchContext::FromDiskCache);
-              self->updateProcessFetch(*context);
-              return *localMetadata;
+ImmediateFuture<std::vector<folly::Try<BlobMetadata>>>
+ObjectStore::getBlobMetadataBatch(
+    const std::vector<ObjectId>& ids,
+    const ObjectFetchContextPtr& context) const {
+  DurationScope statScope{stats_, &ObjectStoreStats::getBlobMetadataBatch};
+  folly::stop_watch<> watch;
+
+  std::vector<folly::Try<BlobMetadata>> results(ids.size());
+  std::vector<size_t> uncachedIndices;
+  std::vector<ObjectId> uncachedIds;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    if (auto metadata = metadataCache_.get(ids[i])) {
+      stats_->increment(&ObjectStoreStats::getBlobMetadataFromMemory);
+      context->didFetch(
+          ObjectFetchContext::BlobMetadata,
+          ids[i],
+          ObjectFetchContext::FromMemoryCache);
+      context->didSpendFetching(
+          ObjectFetchContext::FromMemoryCache, watch.elapsed(), 0);
+      updateProcessFetch(*context);
+      results[i].emplace(*metadata);
+    } else if (isKnownMissing(ids[i], ObjectFetchContext::Blob)) {
+      results[i].emplaceException(
+          std::domain_error(fmt::format("blob {} not found", ids[i])));
+    } else {
+      uncachedIndices.push_back(i);
+      uncachedIds.push_back(ids[i]);
+    }
+  }
+
+  if (uncachedIds.empty()) {
+    return std::move(results);
+  }
+
+  // Look up everything that wasn't in memory with a single LocalStore batch.
+  // What's left is fetched from the BackingStore all at once, which lets its
+  // import queue batch the requests.
+  auto localMetadata = localStore_->getBlobMetadataBatch(uncachedIds);
+  return std::move(localMetadata)
+      .thenValue(
+          [self = shared_from_this(),
+           context = context.copy(),
+           watch,
+           results = std::move(results),
+           uncachedIndices = std::move(uncachedIndices),
+           uncachedIds = std::move(uncachedIds)](
+              std::vector<std::optional<BlobMetadata>>&& metadata) mutable {
+            std::vector<size_t> fetchIndices;
+            std::vector<ImmediateFuture<BlobMetadata>> fetches;
+            for (size_t j = 0; j < uncachedIds.size(); ++j) {
+              auto index = uncachedIndices[j];
+              if (metadata[j]) {
+                self->recordLocalStoreBlobMetadata(
+                    uncachedIds[j], *metadata[j], *context, watch);
+                results[index].emplace(*metadata[j]);
+              } else {
+                fetchIndices.push_back(index);
+                fetches.push_back(makeImmediateFutureWith([&] {
+                  return self->getBlobMetadataFromBackingStore(
+                      uncachedIds[j], context, watch);
+                }));
+              }
             }
 
-            // Check backing store
-            //
-            // TODO: It would be nice to add a smarter API to the BackingStore
-            // so that we can query it just for the blob metadata if it supports
-            // getting that without retrieving the full blob data.
-            //
-            // TODO: This should probably check the LocalStore for the blob
-            // first, especially when we begin to expire entries in RocksDB.
-            return self->backingStore_
-                ->getBlob(id, context)
-                // Non-blocking statistics and cache updates should happen ASAP
-                // rather than waiting for callbacks to be scheduled on the
-                // consuming thread.
-                .toUnsafeFuture()
-                .thenValue([self,
-                            statScope = std::move(statScope),
-                            id,
-                            context = context.copy()](
-                               BackingStore::GetBlobResult result) {
-                  if (result.blob) {
-                    self->stats_->increment(
-                        &ObjectStoreStats::getBlobMetadataFromBackingStore);
-                    // we retrieved the full blob data
-                    self->stats_->increment(
-                        &ObjectStoreStats::getBlobFromBackingStore);
-                    self->localStore_->putBlob(id, result.blob.get());
-                    auto metadata = computeBlobMetadata(*result.blob);
-                    self->localStore_->putBlobMetadata(id, metadata);
-                    self->metadataCache_.wlock()->set(id, metadata);
-                    // I could see an argument for recording this fetch with
-                    // type Blob instead of BlobMetadata, but it's probably more
-                    // useful in context to know how many metadata fetches
-                    // occurred. Also, since backing stores don't directly
-                    // support fetching metadata, it should be clear.
-                    context->didFetch(
-                        ObjectFetchContext::BlobMetadata, id, result.origin);
-
-                    self->updateProcessFetch(*context);
-                    return makeFuture(metadata);
+            return collectAll(std::move(fetches))
+                .thenValue([results = std::move(results),
+                            fetchIndices = std::move(fetchIndices)](
+                               std::vector<folly::Try<BlobMetadata>>&&
+                                   fetched) mutable {
+                  for (size_t k = 0; k < fetched.size(); ++k) {
+                    results[fetchIndices[k]] = std::move(fetched[k]);
                   }
-
-                  throwf<std::domain_error>("blob {} not found", id);
-                })
-                .semi();
+                  return std::move(results);
+                });
           })
+      .ensure([statScope = std::move(statScope)] {});
+}
+
+void ObjectStore::recordLocalStoreBlobMetadata(
+    const ObjectId& id,
+    const BlobMetadata& metadata,
+    ObjectFetchContext& context,
+    const folly::stop_watch<>& watch) const {
+  stats_->increment(&ObjectStoreStats::getBlobMetadataFromLocalStore);
+  metadataCache_.insert(id, metadata);
+  context.didFetch(
+      ObjectFetchContext::BlobMetadata, id, ObjectFetchContext::FromDiskCache);
+  context.didSpendFetching(
+      ObjectFetchContext::FromDiskCache, watch.elapsed(), 0);
+  updateProcessFetch(context);
+}
+
+ImmediateFuture<BlobMetadata> ObjectStore::getBlobMetadataFromBackingStore(
+    const ObjectId& id,
+    const ObjectFetchContextPtr& context,
+    folly::stop_watch<> watch) const {
+  deprioritizeWhenFetchHeavy(*context);
+
+  auto localMetadata = backingStore_->getLocalBlobMetadata(id, context);
+  if (localMetadata) {
+    stats_->increment(&ObjectStoreStats::getLocalBlobMetadataFromBackingStore);
+    metadataCache_.insert(id, *localMetadata);
+    localStore_->putBlobMetadata(id, *localMetadata);
+    context->didFetch(
+        ObjectFetchContext::BlobMetadata,
+        id,
+        ObjectFetchContext::FromDiskCache);
+    context->didSpendFetching(
+        ObjectFetchContext::FromDiskCache, watch.elapsed(), 0);
+    updateProcessFetch(*context);
+    return *localMetadata;
+  }
+
+  // Check backing store
+  //
+  // TODO: It would be nice to add a smarter API to the BackingStore
+  // so that we can query it just for the blob metadata if it supports
+  // getting that without retrieving the full blob data.
+  //
+  // TODO: This should probably check the LocalStore for the blob
+  // first, especially when we begin to expire entries in RocksDB.
+  return backingStore_
+      ->getBlob(id, context)
+      // Non-blocking statistics and cache updates should happen ASAP
+      // rather than waiting for callbacks to be scheduled on the
+      // consuming thread.
+      .toUnsafeFuture()
+      .thenValue([self = shared_from_this(),
+                  id,
+                  context = context.copy(),
+                  watch](BackingStore::GetBlobResult result) {
+        if (result.blob) {
+          self->stats_->increment(
+              &ObjectStoreStats::getBlobMetadataFromBackingStore);
+          // we retrieved the full blob data
+          self->stats_->increment(&ObjectStoreStats::getBlobFromBackingStore);
+          self->localStore_->putBlob(id, result.blob.get());
+          auto metadata = computeBlobMetadata(*result.blob);
+          self->localStore_->putBlobMetadata(id, metadata);
+          self->metadataCache_.insert(id, metadata);
+          // I could see an argument for recording this fetch with
+          // type Blob instead of BlobMetadata, but it's probably more
+          // useful in context to know how many metadata fetches
+          // occurred. Also, since backing stores don't directly
+          // support fetching metadata, it should be clear.
+          context->didFetch(
+              ObjectFetchContext::BlobMetadata, id, result.origin);
+          // The whole blob was transferred to compute its metadata.
+          context->didSpendFetching(
+              result.origin, watch.elapsed(), result.blob->getSize());
+
+          self->updateProcessFetch(*context);
+          return makeFuture(metadata);
+        }
+
+        self->recordMissing(id, ObjectFetchContext::Blob);
+        throwf<std::domain_error>("blob {} not found", id);
+      })
       .semi();
 }
 
@@ -424,6 +827,36 @@ ImmediateFuture<Hash20> ObjectStore::getBlobSha1(
       .thenValue([](const BlobMetadata& metadata) { return metadata.sha1; });
 }
 
+ImmediateFuture<std::string> ObjectStore::getSymlinkTarget(
+    const ObjectId& id,
+    const ObjectFetchContextPtr& context) const {
+  folly::stop_watch<> watch;
+  {
+    // A lookup promotes the entry, so it needs the write lock.
+    auto cache = symlinkTargetCache_.wlock();
+    auto it = cache->find(id);
+    if (it != cache->end()) {
+      stats_->increment(&ObjectStoreStats::getSymlinkTargetFromMemory);
+      context->didFetch(
+          ObjectFetchContext::Blob, id, ObjectFetchContext::FromMemoryCache);
+      context->didSpendFetching(
+          ObjectFetchContext::FromMemoryCache, watch.elapsed(), 0);
+      updateProcessFetch(*context);
+      return it->second;
+    }
+  }
+
+  return getBlob(id, context)
+      .thenValue([self = shared_from_this(),
+                  id](std::shared_ptr<const Blob> blob) {
+        const auto& contents = blob->getContents();
+        folly::io::Cursor cursor(&contents);
+        auto target = cursor.readFixedString(contents.computeChainDataLength());
+        self->symlinkTargetCache_.wlock()->set(id, target);
+        return target;
+      });
+}
+
 ObjectComparison ObjectStore::compareObjectsById(
     const ObjectId& one,
     const ObjectId& two) const {
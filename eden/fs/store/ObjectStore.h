@@ -9,7 +9,12 @@
 
 #include <folly/Synchronized.h>
 #include <folly/container/EvictingCacheMap.h>
+#include <folly/futures/SharedPromise.h>
+#include <folly/hash/Hash.h>
+#include <folly/io/IOBuf.h>
+#include <folly/stop_watch.h>
 #include <memory>
+#include <optional>
 #include <unordered_map>
 
 #include <folly/logging/xlog.h>
@@ -18,18 +23,21 @@
 #include "eden/fs/model/BlobMetadata.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/RootId.h"
+#include "eden/fs/store/BlobMetadataCache.h"
 #include "eden/fs/store/IObjectStore.h"
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/TreeCache.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
+#include "eden/fs/utils/RateLimitedSampler.h"
 
 namespace facebook::eden {
 
 class BackingStore;
 class Blob;
 class LocalStore;
+class PersistentTreeCache;
 class Tree;
 enum class ObjectComparison : uint8_t;
 
@@ -80,7 +88,8 @@ class ObjectStore : public IObjectStore,
       std::shared_ptr<ProcessNameCache> processNameCache,
       std::shared_ptr<StructuredLogger> structuredLogger,
       std::shared_ptr<const EdenConfig> edenConfig,
-      CaseSensitivity caseSensitive);
+      CaseSensitivity caseSensitive,
+      std::shared_ptr<PersistentTreeCache> persistentTreeCache = nullptr);
   ~ObjectStore() override;
 
   /**
@@ -168,13 +177,28 @@ class ObjectStore : public IObjectStore,
       const ObjectId& id,
       const ObjectFetchContextPtr& context) const override;
 
+  /**
+   * Get several Trees at once.
+   *
+   * The trees found in the caches are returned right away, and the remaining
+   * ones are all requested from the BackingStore together, which lets its
+   * import queue batch them. The result holds one element per id, in order:
+   * either the tree or the error that prevented getting it.
+   */
+  ImmediateFuture<std::vector<folly::Try<std::shared_ptr<const Tree>>>>
+  getTreeBatch(
+      const std::vector<ObjectId>& ids,
+      const ObjectFetchContextPtr& context) const;
+
   /**
    * Prefetch all the blobs represented by the HashRange.
    *
    * The caller is responsible for making sure that the HashRange stays valid
    * for as long as the returned ImmediateFuture.
+   *
+   * Returns the number of blobs that had to be fetched remotely.
    */
-  ImmediateFuture<folly::Unit> prefetchBlobs(
+  ImmediateFuture<size_t> prefetchBlobs(
       ObjectIdRange ids,
       const ObjectFetchContextPtr& context) const override;
 
@@ -200,6 +224,18 @@ class ObjectStore : public IObjectStore,
       const ObjectId& id,
       const ObjectFetchContextPtr& context) const;
 
+  /**
+   * Get metadata about several Blobs at once.
+   *
+   * Blobs whose metadata isn't cached in memory are looked up in the
+   * LocalStore with a single batch, and the remaining ones are then all
+   * fetched from the BackingStore at once. The result holds one element per
+   * id, in order: either the metadata or the error that prevented getting it.
+   */
+  ImmediateFuture<std::vector<folly::Try<BlobMetadata>>> getBlobMetadataBatch(
+      const std::vector<ObjectId>& ids,
+      const ObjectFetchContextPtr& context) const;
+
   /**
    * Returns the size of the contents of the blob with the given ID.
    */
@@ -214,6 +250,47 @@ class ObjectStore : public IObjectStore,
       const ObjectId& id,
       const ObjectFetchContextPtr& context) const;
 
+  /**
+   * Returns the contents of the blob with the given ID, read as the target of
+   * a symlink.
+   *
+   * Build tools resolve the same symlinks over and over. Their targets are
+   * kept in a bounded cache of store:symlink-target-cache-size entries, so
+   * that a readlink doesn't load the blob again once the inode and the blob
+   * were unloaded.
+   */
+  ImmediateFuture<std::string> getSymlinkTarget(
+      const ObjectId& id,
+      const ObjectFetchContextPtr& context) const;
+
+  /**
+   * Whether getBlobRange() fetches part of a blob without fetching all of it.
+   */
+  bool supportsBlobRanges() const;
+
+  /**
+   * Returns `length` bytes of the blob's contents starting at `offset`. The
+   * result is shorter if the range extends past the end of the blob, and
+   * empty if it starts past it.
+   *
+   * When supportsBlobRanges() is true, only the store:blob-range-chunk-size
+   * chunks covering the range are fetched, and they are kept in a bounded
+   * in-memory cache. Otherwise the whole blob is fetched.
+   */
+  ImmediateFuture<std::unique_ptr<folly::IOBuf>> getBlobRange(
+      const ObjectId& id,
+      uint64_t offset,
+      uint64_t length,
+      const ObjectFetchContextPtr& context) const;
+
+  /**
+   * Forget every object remembered as missing by the negative cache.
+   *
+   * Called on checkout, as moving to a new commit can make previously unknown
+   * objects available.
+   */
+  void clearNegativeCache();
+
   /**
    * Get the LocalStore used by this ObjectStore
    */
@@ -265,29 +342,185 @@ class ObjectStore : public IObjectStore,
       std::shared_ptr<ProcessNameCache> processNameCache,
       std::shared_ptr<StructuredLogger> structuredLogger,
       std::shared_ptr<const EdenConfig> edenConfig,
-      CaseSensitivity caseSensitive);
+      CaseSensitivity caseSensitive,
+      std::shared_ptr<PersistentTreeCache> persistentTreeCache);
   // Forbidden copy constructor and assignment operator
   ObjectStore(ObjectStore const&) = delete;
   ObjectStore& operator=(ObjectStore const&) = delete;
 
-  static constexpr size_t kCacheSize = 1000000;
+  /**
+   * Caches the metadata of the files of a tree that were imported with it,
+   * when enabled by store:blob-metadata-from-trees.
+   */
+  void recordTreeBlobMetadata(const Tree& tree) const;
+
+  /**
+   * Cache and account for blob metadata that was found in the LocalStore.
+   */
+  void recordLocalStoreBlobMetadata(
+      const ObjectId& id,
+      const BlobMetadata& metadata,
+      ObjectFetchContext& context,
+      const folly::stop_watch<>& watch) const;
+
+  /**
+   * Get the metadata of a blob that is neither cached in memory nor in the
+   * LocalStore.
+   */
+  ImmediateFuture<BlobMetadata> getBlobMetadataFromBackingStore(
+      const ObjectId& id,
+      const ObjectFetchContextPtr& context,
+      folly::stop_watch<> watch) const;
+
+  /**
+   * Returns true if the object was recently looked up as the given type and
+   * could not be found. Always false when negative caching is disabled.
+   */
+  bool isKnownMissing(const ObjectId& id, ObjectFetchContext::ObjectType type)
+      const;
+
+  /**
+   * Remember that the object could not be found as the given type.
+   */
+  void recordMissing(const ObjectId& id, ObjectFetchContext::ObjectType type)
+      const;
+
+  /**
+   * Call fetch() to start a BackingStore request and remember the object as
+   * missing if it fails with std::domain_error, whether fetch() throws it
+   * directly or the returned future completes with it. The time the request
+   * took is reported to the context.
+   */
+  template <typename Fetch>
+  auto fetchRecordingMisses(
+      const ObjectId& id,
+      ObjectFetchContext::ObjectType type,
+      const ObjectFetchContextPtr& context,
+      Fetch&& fetch) const {
+    using Result = typename decltype(fetch())::value_type;
+    auto start = std::chrono::steady_clock::now();
+    std::optional<ImmediateFuture<Result>> future;
+    try {
+      future.emplace(fetch());
+    } catch (const std::domain_error&) {
+      recordMissing(id, type);
+      throw;
+    }
+    return std::move(*future).thenTry(
+        [self = shared_from_this(), id, type, context = context.copy(), start](
+            folly::Try<Result>&& result) {
+          context->didWaitForBackingStore(
+              std::chrono::steady_clock::now() - start);
+          if (result.hasException() &&
+              result.exception()
+                  .template is_compatible_with<std::domain_error>()) {
+            self->recordMissing(id, type);
+          }
+          return std::move(result);
+        });
+  }
 
   /**
    * During status and checkout, it's common to look up the SHA-1 for a given
    * blob ID. To avoid needing to hit RocksDB, keep a bounded in-memory cache of
-   * the sizes and SHA-1s of blobs we've seen. Each node is somewhere around 50
-   * bytes (20+28 + LRU overhead) and we store kMetadataCacheSize entries, which
-   * EvictingCacheMap divides in two for some reason. At the time of this
-   * comment, EvictingCacheMap does not store its nodes densely, so there may
-   * also be some jemalloc tracking overhead and some internal fragmentation
-   * depending on whether the node fits cleanly into one of jemalloc's size
-   * classes.
-   *
-   * TODO: It never makes sense to rlock an LRU cache, since cache hits mutate
-   * the data structure. Thus, should we use a more appropriate type of lock?
+   * the sizes and SHA-1s of blobs we've seen. Entries are stored densely, at
+   * 48 bytes each, and store:blob-metadata-cache-size bounds their number.
+   */
+  mutable BlobMetadataCache metadataCache_;
+
+  struct NegativeCacheEntry {
+    std::chrono::steady_clock::time_point expiry;
+    /// Bitmask of (1 << ObjectFetchContext::ObjectType) that were not found.
+    uint8_t types{0};
+  };
+
+  /**
+   * Tools probing for objects that don't exist would otherwise redo the same
+   * LocalStore and BackingStore work on every call. Entries expire after
+   * store:negative-cache-ttl.
    */
-  mutable folly::Synchronized<folly::EvictingCacheMap<ObjectId, BlobMetadata>>
-      metadataCache_;
+  mutable folly::Synchronized<
+      folly::EvictingCacheMap<ObjectId, NegativeCacheEntry>>
+      negativeCache_;
+
+  /**
+   * Targets of the symlinks read by getSymlinkTarget(), bounded by
+   * store:symlink-target-cache-size.
+   */
+  mutable folly::Synchronized<folly::EvictingCacheMap<ObjectId, std::string>>
+      symlinkTargetCache_;
+
+  struct FetchedBlob {
+    std::shared_ptr<const Blob> blob;
+    ObjectFetchContext::Origin origin;
+  };
+
+  /**
+   * Fetch a blob from the BackingStore and complete its entry in
+   * inFlightBlobs_ once done.
+   */
+  void startBlobFetch(
+      const ObjectId& id,
+      const ObjectFetchContextPtr& fetchContext) const;
+
+  /**
+   * Return the chunk at `index` of a blob, from blobChunkCache_ or from the
+   * BackingStore.
+   */
+  ImmediateFuture<std::shared_ptr<const folly::IOBuf>> getBlobChunk(
+      const ObjectId& id,
+      uint64_t index,
+      const ObjectFetchContextPtr& context) const;
+
+  /**
+   * Complete the in-flight fetch of `id`, handing its result to every getBlob
+   * call that joined it.
+   */
+  void completeBlobFetch(
+      const ObjectId& id,
+      const folly::Try<FetchedBlob>& result) const;
+
+  /**
+   * Blobs that are currently being fetched from the BackingStore. Concurrent
+   * getBlob calls for a blob that is already being fetched wait on the same
+   * fetch instead of each starting their own, which matters when many
+   * processes open the same file at once.
+   */
+  mutable folly::Synchronized<
+      std::unordered_map<ObjectId, folly::SharedPromise<FetchedBlob>>>
+      inFlightBlobs_;
+
+  struct BlobChunkKey {
+    ObjectId id;
+    uint64_t index;
+
+    bool operator==(const BlobChunkKey& other) const {
+      return index == other.index && id == other.id;
+    }
+  };
+
+  struct BlobChunkKeyHasher {
+    size_t operator()(const BlobChunkKey& key) const {
+      return folly::hash::hash_combine(key.id, key.index);
+    }
+  };
+
+  /**
+   * The size of the chunks getBlobRange() fetches, from
+   * store:blob-range-chunk-size. Fixed for the lifetime of the ObjectStore as
+   * blobChunkCache_ is keyed by chunk index.
+   */
+  const uint64_t blobChunkSize_;
+
+  /**
+   * Chunks of blobs fetched by getBlobRange(), bounded by
+   * store:blob-range-cache-chunks.
+   */
+  mutable folly::Synchronized<folly::EvictingCacheMap<
+      BlobChunkKey,
+      std::shared_ptr<const folly::IOBuf>,
+      BlobChunkKeyHasher>>
+      blobChunkCache_;
 
   /**
    * During glob, we need to read a lot of trees, but we avoid loading inodes,
@@ -302,6 +535,14 @@ class ObjectStore : public IObjectStore,
    */
   const std::shared_ptr<TreeCache> treeCache_;
 
+  /**
+   * Optional on-disk cache of trees consulted after treeCache_ and before the
+   * BackingStore. Unlike treeCache_, it survives restarts, which avoids
+   * LocalStore lookups for recently used trees right after startup. Shared
+   * across all object stores. May be null.
+   */
+  const std::shared_ptr<PersistentTreeCache> persistentTreeCache_;
+
   /*
    * The LocalStore.
    *
@@ -322,6 +563,10 @@ class ObjectStore : public IObjectStore,
    * from the beginning of the eden daemon progress */
   std::unique_ptr<PidFetchCounts> pidFetchCounts_;
 
+  /* caps the fetch heavy events, as a build fetching from many processes at
+   * once would otherwise flood the logs with them */
+  mutable RateLimitedSampler fetchHeavyEventSampler_{std::chrono::minutes{1}};
+
   /* process name cache and structured logger used for
    * sending fetch heavy events, set to nullptr if not
    * initialized by create()
@@ -0,0 +1,771 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/PackLocalStore.h"
+
+#include <fb303/ServiceData.h>
+#include <fmt/format.h>
+#include <folly/Bits.h>
+#include <folly/Conv.h>
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/Utility.h>
+#include <folly/container/F14Map.h>
+#include <folly/hash/Checksum.h>
+#include <folly/hash/SpookyHashV2.h>
+#include <folly/logging/xlog.h>
+#include <folly/portability/Fcntl.h>
+#include <folly/portability/SysMman.h>
+#include <folly/portability/SysStat.h>
+#include <folly/system/MemoryMapping.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <optional>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/utils/FileUtils.h"
+
+namespace facebook::eden {
+
+namespace {
+constexpr uint64_t kPackMagic = 0x4544454e5041434b; // "EDENPACK"
+constexpr uint32_t kPackVersion = 1;
+constexpr folly::StringPiece kPackSuffix{".pack"};
+
+// Used to size the index from the data capacity. Most values are blobs or
+// serialized trees of at least a few hundred bytes.
+constexpr size_t kExpectedRecordSize = 128;
+constexpr size_t kMinimumSlotCount = 1024;
+
+constexpr size_t kRecordAlignment = 8;
+
+struct PackHeader {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t slotCount;
+  uint64_t dataCapacity;
+  std::atomic<uint64_t> dataUsed;
+  uint64_t entryCount;
+};
+
+struct PackSlot {
+  // 0 marks an empty slot.
+  std::atomic<uint64_t> keyHash;
+  std::atomic<uint64_t> offset;
+};
+
+struct RecordHeader {
+  uint32_t checksum;
+  uint32_t keyLength;
+  uint64_t valueLength;
+};
+
+static_assert(sizeof(PackHeader) % kRecordAlignment == 0);
+static_assert(sizeof(RecordHeader) % kRecordAlignment == 0);
+
+size_t computeSlotCount(uint64_t dataCapacity) {
+  return folly::nextPowTwo(
+      std::max<uint64_t>(
+          kMinimumSlotCount, dataCapacity / kExpectedRecordSize));
+}
+
+uint64_t computeFileSize(uint64_t slotCount, uint64_t dataCapacity) {
+  return sizeof(PackHeader) + slotCount * sizeof(PackSlot) + dataCapacity;
+}
+
+size_t alignRecord(size_t length) {
+  return (length + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+}
+
+uint64_t hashKey(folly::ByteRange key) {
+  return folly::hash::SpookyHashV2::Hash64(key.data(), key.size(), 0) | 1;
+}
+
+template <typename Slices>
+uint32_t recordChecksum(
+    const RecordHeader& header,
+    folly::ByteRange key,
+    const Slices& valueSlices) {
+  auto checksum = folly::crc32c(
+      reinterpret_cast<const uint8_t*>(&header.keyLength),
+      sizeof(RecordHeader) - sizeof(header.checksum));
+  checksum = folly::crc32c(key.data(), key.size(), checksum);
+  for (const auto& slice : valueSlices) {
+    checksum = folly::crc32c(slice.data(), slice.size(), checksum);
+  }
+  return checksum;
+}
+
+std::string packFileName(uint64_t generation) {
+  return fmt::format("{:016x}{}", generation, kPackSuffix);
+}
+
+std::optional<uint64_t> parsePackFileName(folly::StringPiece name) {
+  if (!name.endsWith(kPackSuffix)) {
+    return std::nullopt;
+  }
+  name.subtract(kPackSuffix.size());
+  if (name.size() != 16) {
+    return std::nullopt;
+  }
+  uint64_t generation = 0;
+  for (auto c : name) {
+    int digit;
+    if (c >= '0' && c <= '9') {
+      digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      digit = c - 'a' + 10;
+    } else {
+      return std::nullopt;
+    }
+    generation = generation * 16 + digit;
+  }
+  return generation;
+}
+
+/**
+ * The pack files among the given directory entries, newest first.
+ */
+std::vector<std::pair<uint64_t, PathComponent>> listPackFiles(
+    std::vector<PathComponent> entries) {
+  std::vector<std::pair<uint64_t, PathComponent>> packFiles;
+  for (auto& entry : entries) {
+    if (auto generation = parsePackFileName(entry.view())) {
+      packFiles.emplace_back(*generation, std::move(entry));
+    }
+  }
+  std::sort(packFiles.begin(), packFiles.end(), [](auto& a, auto& b) {
+    return a.first > b.first;
+  });
+  return packFiles;
+}
+} // namespace
+
+/**
+ * A single memory-mapped pack file.
+ *
+ * Lookups can run concurrently with each other and with one appender. The
+ * caller is responsible for serializing appends.
+ */
+class PackLocalStore::Pack {
+ public:
+  static std::shared_ptr<Pack>
+  create(AbsolutePath path, uint64_t generation, uint64_t dataCapacity) {
+    folly::File file{
+        path.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644};
+    auto slotCount = computeSlotCount(dataCapacity);
+    auto fileSize = computeFileSize(slotCount, dataCapacity);
+    folly::checkUnixError(
+        folly::ftruncateNoInt(file.fd(), fileSize), "failed to size pack");
+
+    auto pack = std::shared_ptr<Pack>{new Pack{
+        std::move(path), generation, std::move(file), fileSize, true}};
+    // The file is zero-filled: all slots are empty already. Write the magic
+    // last so that a crash in the middle of this leaves an invalid pack.
+    auto& hdr = pack->header();
+    hdr.version = kPackVersion;
+    hdr.reserved = 0;
+    hdr.slotCount = slotCount;
+    hdr.dataCapacity = dataCapacity;
+    hdr.dataUsed.store(0, std::memory_order_relaxed);
+    hdr.entryCount = 0;
+    hdr.magic = kPackMagic;
+    pack->slotCount_ = slotCount;
+    pack->dataCapacity_ = dataCapacity;
+    return pack;
+  }
+
+  /**
+   * Map an existing pack. Throws if it isn't a valid pack file. Only
+   * writable packs can be appended to.
+   */
+  static std::shared_ptr<Pack>
+  load(AbsolutePath path, uint64_t generation, bool writable) {
+    folly::File file{path.c_str(), (writable ? O_RDWR : O_RDONLY) | O_CLOEXEC};
+    struct stat st;
+    folly::checkUnixError(fstat(file.fd(), &st), "fstat failed");
+    auto fileSize = static_cast<uint64_t>(st.st_size);
+    if (fileSize < sizeof(PackHeader)) {
+      throw std::runtime_error(
+          fmt::format("pack {} is truncated", path.view()));
+    }
+
+    auto pack = std::shared_ptr<Pack>{new Pack{
+        std::move(path), generation, std::move(file), fileSize, writable}};
+    auto& hdr = pack->header();
+    if (hdr.magic != kPackMagic || hdr.version != kPackVersion ||
+        hdr.slotCount == 0 || !folly::isPowTwo(hdr.slotCount) ||
+        computeFileSize(hdr.slotCount, hdr.dataCapacity) != fileSize ||
+        hdr.dataUsed.load(std::memory_order_relaxed) > hdr.dataCapacity ||
+        hdr.entryCount > hdr.slotCount) {
+      throw std::runtime_error(
+          fmt::format("pack {} has an invalid header", pack->path_.view()));
+    }
+    pack->slotCount_ = hdr.slotCount;
+    pack->dataCapacity_ = hdr.dataCapacity;
+    return pack;
+  }
+
+  ~Pack() {
+    // Unmap before removing the file, so that its space is released.
+    mapping_.reset();
+    if (deleteOnDestruction_.load(std::memory_order_acquire)) {
+      try {
+        removeFileWithAbsolutePath(path_);
+      } catch (const std::exception& ex) {
+        XLOG(WARN) << "failed to remove pack " << path_ << ": "
+                   << folly::exceptionStr(ex);
+      }
+    }
+  }
+
+  uint64_t getGeneration() const {
+    return generation_;
+  }
+
+  /**
+   * Remove the pack file once the last reference to this pack is released.
+   */
+  void markForDeletion() {
+    deleteOnDestruction_.store(true, std::memory_order_release);
+  }
+
+  /**
+   * Bytes this pack takes on disk. The data area is only counted up to what
+   * was written: the rest of the file is sparse.
+   */
+  uint64_t getSize() const {
+    return sizeof(PackHeader) + slotCount_ * sizeof(PackSlot) +
+        header().dataUsed.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Whether a record of recordSize bytes could fit in an empty pack.
+   */
+  static bool fitsEmptyPack(uint64_t dataCapacity, size_t recordSize) {
+    return alignRecord(recordSize) <= dataCapacity;
+  }
+
+  std::optional<folly::ByteRange> find(folly::ByteRange key) const {
+    auto keyHash = hashKey(key);
+    auto* table = slots();
+    auto mask = slotCount_ - 1;
+    for (size_t probe = 0; probe < slotCount_; ++probe) {
+      auto& slot = table[(keyHash + probe) & mask];
+      auto slotHash = slot.keyHash.load(std::memory_order_acquire);
+      if (slotHash == 0) {
+        return std::nullopt;
+      }
+      if (slotHash != keyHash) {
+        continue;
+      }
+      auto offset = slot.offset.load(std::memory_order_acquire);
+      auto record = readRecord(offset);
+      if (!record) {
+        continue;
+      }
+      auto [recordKey, value] = *record;
+      if (recordKey == key) {
+        return value;
+      }
+    }
+    return std::nullopt;
+  }
+
+  /**
+   * Append a record. Returns false, without writing anything, if the pack
+   * is full.
+   */
+  bool append(
+      folly::ByteRange key,
+      const std::vector<folly::ByteRange>& valueSlices) {
+    XCHECK(writable_);
+    auto& hdr = header();
+    size_t valueLength = 0;
+    for (const auto& slice : valueSlices) {
+      valueLength += slice.size();
+    }
+    auto alignedLength =
+        alignRecord(sizeof(RecordHeader) + key.size() + valueLength);
+    // Only appenders modify dataUsed, and they are serialized.
+    auto offset = hdr.dataUsed.load(std::memory_order_relaxed);
+    if (offset + alignedLength > dataCapacity_) {
+      return false;
+    }
+
+    // Find the slot of the key, or the first empty one.
+    auto keyHash = hashKey(key);
+    auto* table = slots();
+    auto mask = slotCount_ - 1;
+    PackSlot* slot = nullptr;
+    bool existing = false;
+    for (size_t probe = 0; probe < slotCount_; ++probe) {
+      auto& candidate = table[(keyHash + probe) & mask];
+      auto slotHash = candidate.keyHash.load(std::memory_order_relaxed);
+      if (slotHash == 0) {
+        slot = &candidate;
+        break;
+      }
+      if (slotHash == keyHash) {
+        auto record =
+            readRecord(candidate.offset.load(std::memory_order_relaxed));
+        if (record && record->first == key) {
+          slot = &candidate;
+          existing = true;
+          break;
+        }
+      }
+    }
+    if (!slot || (!existing && (hdr.entryCount + 1) * 4 > slotCount_ * 3)) {
+      return false;
+    }
+
+    RecordHeader record;
+    record.keyLength = folly::to_narrow(key.size());
+    record.valueLength = valueLength;
+    record.checksum = recordChecksum(record, key, valueSlices);
+
+    auto* out = data() + offset;
+    memcpy(out, &record, sizeof(RecordHeader));
+    out += sizeof(RecordHeader);
+    memcpy(out, key.data(), key.size());
+    out += key.size();
+    for (const auto& slice : valueSlices) {
+      memcpy(out, slice.data(), slice.size());
+      out += slice.size();
+    }
+    hdr.dataUsed.store(offset + alignedLength, std::memory_order_release);
+
+    // Publish the slot last, after the record is fully written. Readers
+    // racing with an overwrite see either the old or the new record, both
+    // of which are complete.
+    if (existing) {
+      slot->offset.store(offset, std::memory_order_release);
+    } else {
+      slot->offset.store(offset, std::memory_order_relaxed);
+      slot->keyHash.store(keyHash, std::memory_order_release);
+      ++hdr.entryCount;
+    }
+    return true;
+  }
+
+  void flush() const {
+#ifndef _WIN32
+    if (!writable_) {
+      return;
+    }
+    auto range = mapping_->writableRange();
+    if (msync(range.data(), range.size(), MS_ASYNC) != 0) {
+      XLOG(WARN) << "failed to flush pack " << path_ << ": "
+                 << folly::errnoStr(errno);
+    }
+#endif
+  }
+
+ private:
+  Pack(
+      AbsolutePath path,
+      uint64_t generation,
+      folly::File file,
+      uint64_t fileSize,
+      bool writable)
+      : path_{std::move(path)},
+        generation_{generation},
+        writable_{writable},
+        mapping_{
+            std::in_place,
+            std::move(file),
+            0,
+            static_cast<off_t>(fileSize),
+            writable ? folly::MemoryMapping::writable()
+                     : folly::MemoryMapping::Options{}} {}
+
+  /**
+   * Start of the mapping. Read-only packs are mapped read-only, so nothing
+   * must be written through this unless writable_ is set.
+   */
+  uint8_t* base() const {
+    return const_cast<uint8_t*>(mapping_->range().data());
+  }
+
+  PackHeader& header() const {
+    return *reinterpret_cast<PackHeader*>(base());
+  }
+
+  PackSlot* slots() const {
+    return reinterpret_cast<PackSlot*>(base() + sizeof(PackHeader));
+  }
+
+  uint8_t* data() const {
+    return base() + sizeof(PackHeader) + slotCount_ * sizeof(PackSlot);
+  }
+
+  /**
+   * Return the key and value of the record at offset, or std::nullopt if it
+   * is out of bounds or fails its checksum.
+   */
+  std::optional<std::pair<folly::ByteRange, folly::ByteRange>> readRecord(
+      uint64_t offset) const {
+    auto dataUsed = header().dataUsed.load(std::memory_order_acquire);
+    if (offset > dataUsed || dataUsed - offset < sizeof(RecordHeader)) {
+      return std::nullopt;
+    }
+    const auto* start = data() + offset;
+    RecordHeader record;
+    memcpy(&record, start, sizeof(RecordHeader));
+    auto available = dataUsed - offset - sizeof(RecordHeader);
+    if (record.keyLength > available ||
+        record.valueLength > available - record.keyLength) {
+      return std::nullopt;
+    }
+    folly::ByteRange key{start + sizeof(RecordHeader), record.keyLength};
+    folly::ByteRange value{key.end(), record.valueLength};
+    std::array<folly::ByteRange, 1> valueSlices{value};
+    if (recordChecksum(record, key, valueSlices) != record.checksum) {
+      XLOG(DBG3) << "checksum mismatch in pack " << path_ << " at offset "
+                 << offset;
+      return std::nullopt;
+    }
+    return std::make_pair(key, value);
+  }
+
+  const AbsolutePath path_;
+  const uint64_t generation_;
+  const bool writable_;
+  uint64_t slotCount_{0};
+  uint64_t dataCapacity_{0};
+  // Only reset by the destructor.
+  std::optional<folly::MemoryMapping> mapping_;
+  std::atomic<bool> deleteOnDestruction_{false};
+};
+
+namespace {
+class PackWriteBatch : public LocalStore::WriteBatch {
+ public:
+  explicit PackWriteBatch(PackLocalStore* store) : store_(store) {
+    storage_.resize(KeySpace::kTotalCount);
+  }
+
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
+      override {
+    storage_[keySpace->index][folly::StringPiece(key)] =
+        folly::StringPiece(value).str();
+  }
+
+  void put(
+      KeySpace keySpace,
+      folly::ByteRange key,
+      std::vector<folly::ByteRange> valueSlices) override {
+    std::string value;
+    for (const auto& slice : valueSlices) {
+      value.append(reinterpret_cast<const char*>(slice.data()), slice.size());
+    }
+    storage_[keySpace->index][folly::StringPiece(key)] = std::move(value);
+  }
+
+  void flush() override {
+    for (auto& ks : KeySpace::kAll) {
+      for (const auto& it : storage_[ks->index]) {
+        store_->put(
+            ks, folly::StringPiece(it.first), folly::StringPiece(it.second));
+      }
+      storage_[ks->index].clear();
+    }
+  }
+
+ private:
+  PackLocalStore* store_;
+  std::vector<folly::F14NodeMap<std::string, std::string>> storage_;
+};
+} // namespace
+
+PackLocalStore::PackLocalStore(
+    AbsolutePathPiece root,
+    size_t packSize,
+    OpenMode mode)
+    : root_{root.copy()}, packSize_{packSize}, mode_{mode} {}
+
+PackLocalStore::~PackLocalStore() {
+  close();
+}
+
+AbsolutePath PackLocalStore::getColumnPath(KeySpace keySpace) const {
+  return root_ + PathComponentPiece{keySpace->name};
+}
+
+void PackLocalStore::open() {
+  bool readOnly = mode_ == OpenMode::ReadOnly;
+  if (!readOnly) {
+    ensureDirectoryExists(root_);
+  }
+  for (const auto& ks : KeySpace::kAll) {
+    auto columnPath = getColumnPath(ks);
+    auto& column = columns_[ks->index];
+    std::lock_guard<std::mutex> guard{column.writeMutex};
+    if (column.packs.load()) {
+      throw std::runtime_error("PackLocalStore is already open");
+    }
+
+    if (readOnly) {
+      column.packs.store(
+          std::make_shared<const PackList>(loadReadOnlyPacks(columnPath)));
+      continue;
+    }
+
+    if (ks->isDeprecated()) {
+      // Start deprecated KeySpaces over empty.
+      removeRecursively(columnPath);
+    }
+    ensureDirectoryExists(columnPath);
+    auto packFiles =
+        listPackFiles(getAllDirectoryEntryNames(columnPath).value());
+
+    PackList packs;
+    uint64_t maxGeneration = packFiles.empty() ? 0 : packFiles.front().first;
+    for (auto& [generation, name] : packFiles) {
+      auto packPath = columnPath + name;
+      try {
+        packs.push_back(Pack::load(packPath, generation, true));
+      } catch (const std::exception& ex) {
+        // The data can be fetched or recomputed again, drop the pack.
+        XLOG(ERR) << "removing unreadable pack " << packPath << ": "
+                  << folly::exceptionStr(ex);
+        removeFileWithAbsolutePath(packPath);
+      }
+    }
+    if (packs.empty()) {
+      packs.push_back(createPack(ks, maxGeneration + 1, 0));
+    }
+    XLOG(DBG2) << "opened " << packs.size() << " packs for " << ks->name;
+
+    column.packs.store(std::make_shared<const PackList>(std::move(packs)));
+  }
+}
+
+PackLocalStore::PackList PackLocalStore::loadReadOnlyPacks(
+    AbsolutePathPiece columnPath) const {
+  auto entries = getAllDirectoryEntryNames(columnPath);
+  if (entries.hasException()) {
+    // Packs don't have to provide every KeySpace.
+    XLOG(DBG3) << "no packs in " << columnPath << ": "
+               << entries.exception().what();
+    return {};
+  }
+
+  PackList packs;
+  for (auto& [generation, name] : listPackFiles(std::move(entries).value())) {
+    auto packPath = columnPath + name;
+    try {
+      packs.push_back(Pack::load(packPath, generation, false));
+    } catch (const std::exception& ex) {
+      XLOG(ERR) << "skipping unreadable pack " << packPath << ": "
+                << folly::exceptionStr(ex);
+    }
+  }
+  return packs;
+}
+
+void PackLocalStore::checkWritable() const {
+  if (mode_ == OpenMode::ReadOnly) {
+    throw std::logic_error("cannot write to a read-only PackLocalStore");
+  }
+}
+
+void PackLocalStore::close() {
+  for (auto& column : columns_) {
+    std::lock_guard<std::mutex> guard{column.writeMutex};
+    auto packs = column.packs.exchange(nullptr);
+    if (packs && !packs->empty()) {
+      packs->front()->flush();
+    }
+  }
+}
+
+std::shared_ptr<const PackLocalStore::PackList> PackLocalStore::loadPacks(
+    KeySpace keySpace) const {
+  auto packs = columns_[keySpace->index].packs.load(std::memory_order_acquire);
+  if (!packs) {
+    throw std::runtime_error(fmt::format(
+        "PackLocalStore is not open, cannot access {}", keySpace->name));
+  }
+  return packs;
+}
+
+std::shared_ptr<PackLocalStore::Pack> PackLocalStore::createPack(
+    KeySpace keySpace,
+    uint64_t generation,
+    size_t minimumRecordSize) {
+  uint64_t dataCapacity = packSize_;
+  if (!Pack::fitsEmptyPack(dataCapacity, minimumRecordSize)) {
+    // Oversized values get a pack of their own.
+    dataCapacity = alignRecord(minimumRecordSize);
+  }
+  auto path = getColumnPath(keySpace) + PathComponent{packFileName(generation)};
+  XLOG(DBG3) << "creating pack " << path;
+  return Pack::create(std::move(path), generation, dataCapacity);
+}
+
+void PackLocalStore::clearKeySpace(KeySpace keySpace) {
+  checkWritable();
+  auto& column = columns_[keySpace->index];
+  std::lock_guard<std::mutex> guard{column.writeMutex};
+  auto packs = loadPacks(keySpace);
+  auto fresh = createPack(keySpace, packs->front()->getGeneration() + 1, 0);
+  column.packs.store(std::make_shared<const PackList>(PackList{fresh}));
+  for (const auto& pack : *packs) {
+    pack->markForDeletion();
+  }
+}
+
+void PackLocalStore::compactKeySpace(KeySpace keySpace) {
+  // Packs are never rewritten, the best that can be done is to make sure
+  // the pack being written to reaches the disk.
+  auto packs = loadPacks(keySpace);
+  if (!packs->empty()) {
+    packs->front()->flush();
+  }
+}
+
+StoreResult PackLocalStore::get(KeySpace keySpace, folly::ByteRange key)
+    const {
+  auto packs = loadPacks(keySpace);
+  for (const auto& pack : *packs) {
+    if (auto value = pack->find(key)) {
+      return StoreResult(std::string{folly::StringPiece{*value}});
+    }
+  }
+  return StoreResult::missing(keySpace, key);
+}
+
+bool PackLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
+  auto packs = loadPacks(keySpace);
+  for (const auto& pack : *packs) {
+    if (pack->find(key)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void PackLocalStore::put(
+    KeySpace keySpace,
+    folly::ByteRange key,
+    folly::ByteRange value) {
+  putSlices(keySpace, key, {value});
+}
+
+void PackLocalStore::putSlices(
+    KeySpace keySpace,
+    folly::ByteRange key,
+    const std::vector<folly::ByteRange>& valueSlices) {
+  if (key.size() > std::numeric_limits<uint32_t>::max()) {
+    throw std::invalid_argument(
+        fmt::format("key of {} bytes is too large", key.size()));
+  }
+
+  checkWritable();
+  auto& column = columns_[keySpace->index];
+  std::lock_guard<std::mutex> guard{column.writeMutex};
+  auto packs = loadPacks(keySpace);
+  if (packs->front()->append(key, valueSlices)) {
+    return;
+  }
+
+  // The active pack is full, start a new one.
+  size_t recordSize = sizeof(RecordHeader) + key.size();
+  for (const auto& slice : valueSlices) {
+    recordSize += slice.size();
+  }
+  auto pack =
+      createPack(keySpace, packs->front()->getGeneration() + 1, recordSize);
+  if (!pack->append(key, valueSlices)) {
+    throw std::logic_error("record does not fit in a new pack");
+  }
+  packs->front()->flush();
+
+  PackList newPacks;
+  newPacks.reserve(packs->size() + 1);
+  newPacks.push_back(std::move(pack));
+  newPacks.insert(newPacks.end(), packs->begin(), packs->end());
+  column.packs.store(std::make_shared<const PackList>(std::move(newPacks)));
+}
+
+std::unique_ptr<LocalStore::WriteBatch> PackLocalStore::beginWrite(size_t) {
+  return std::make_unique<PackWriteBatch>(this);
+}
+
+size_t PackLocalStore::getPackCount(KeySpace keySpace) const {
+  return loadPacks(keySpace)->size();
+}
+
+uint64_t PackLocalStore::getApproximateSize(KeySpace keySpace) const {
+  auto packs = loadPacks(keySpace);
+  uint64_t size = 0;
+  for (const auto& pack : *packs) {
+    size += pack->getSize();
+  }
+  return size;
+}
+
+size_t PackLocalStore::dropOldPacks(KeySpace keySpace, uint64_t maxBytes) {
+  checkWritable();
+  auto& column = columns_[keySpace->index];
+  std::lock_guard<std::mutex> guard{column.writeMutex};
+  auto packs = loadPacks(keySpace);
+
+  // Keep the newest packs that fit in maxBytes, and always the active one.
+  uint64_t size = packs->front()->getSize();
+  size_t keep = 1;
+  while (keep < packs->size()) {
+    auto packSize = (*packs)[keep]->getSize();
+    if (size + packSize > maxBytes) {
+      break;
+    }
+    size += packSize;
+    ++keep;
+  }
+  if (keep == packs->size()) {
+    return 0;
+  }
+
+  column.packs.store(std::make_shared<const PackList>(
+      packs->begin(), packs->begin() + keep));
+  for (auto it = packs->begin() + keep; it != packs->end(); ++it) {
+    XLOG(DBG2) << "dropping pack " << (*it)->getGeneration() << " of "
+               << keySpace->name;
+    (*it)->markForDeletion();
+  }
+  return packs->size() - keep;
+}
+
+void PackLocalStore::periodicManagementTask(const EdenConfig& config) {
+  enableBlobCaching.store(
+      config.enableBlobCaching.getValue(), std::memory_order_relaxed);
+
+  for (const auto& ks : KeySpace::kAll) {
+    auto* ephemeral = std::get_if<Ephemeral>(&ks->persistence);
+    if (ephemeral && mode_ == OpenMode::ReadWrite) {
+      auto limit = (config.*(ephemeral->cacheLimit)).getValue();
+      if (auto dropped = dropOldPacks(ks, limit)) {
+        fb303::fbData->incrementCounter(
+            folly::to<std::string>(statsPrefix_, "pack.dropped"), dropped);
+      }
+    }
+    fb303::fbData->setCounter(
+        folly::to<std::string>(statsPrefix_, ks->name, ".size"),
+        getApproximateSize(ks));
+  }
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/concurrency/AtomicSharedPtr.h>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "eden/fs/store/LocalStore.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+/**
+ * An implementation of LocalStore that appends values to memory-mapped pack
+ * files, without any compaction.
+ *
+ * Each KeySpace has its own directory of packs. A pack is a single file made
+ * of a header, an open-addressed hash index and a data area that records are
+ * appended to. Only the newest pack of a KeySpace is written to; once it is
+ * full, a new pack is started.
+ *
+ * Reads don't take any lock: they load the current list of packs of the
+ * KeySpace and probe their indexes, newest first. Index slots are published
+ * with a release store after their record was written, and every record is
+ * checksummed so that torn writes after a system crash read as missing.
+ *
+ * Garbage collection is generational: when an ephemeral KeySpace exceeds its
+ * configured size limit, its oldest packs are dropped whole. Their files are
+ * removed once the last concurrent reader is done with them.
+ *
+ * A PackLocalStore can also be opened read-only, for instance to share packs
+ * built ahead of time between several hosts. Writes then throw.
+ *
+ * PackLocalStore is thread safe. Writes to a KeySpace are serialized.
+ */
+class PackLocalStore final : public LocalStore {
+ public:
+  static constexpr size_t kDefaultPackSize = 256 * 1024 * 1024;
+
+  enum class OpenMode { ReadWrite, ReadOnly };
+
+  /**
+   * Packs are created in subdirectories of root, sized to hold packSize
+   * bytes of records each. Existing packs keep their size.
+   */
+  explicit PackLocalStore(
+      AbsolutePathPiece root,
+      size_t packSize = kDefaultPackSize,
+      OpenMode mode = OpenMode::ReadWrite);
+  ~PackLocalStore() override;
+
+  void open() override;
+  void close() override;
+  void clearKeySpace(KeySpace keySpace) override;
+  void compactKeySpace(KeySpace keySpace) override;
+  StoreResult get(KeySpace keySpace, folly::ByteRange key) const override;
+  bool hasKey(KeySpace keySpace, folly::ByteRange key) const override;
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
+      override;
+  std::unique_ptr<LocalStore::WriteBatch> beginWrite(
+      size_t bufSize = 0) override;
+
+  void periodicManagementTask(const EdenConfig& config) override;
+
+  /**
+   * Write the given slices of a value, concatenated, under key.
+   */
+  void putSlices(
+      KeySpace keySpace,
+      folly::ByteRange key,
+      const std::vector<folly::ByteRange>& valueSlices);
+
+  /**
+   * Number of packs currently making up the KeySpace.
+   */
+  size_t getPackCount(KeySpace keySpace) const;
+
+  /**
+   * Total size of the packs of the KeySpace, in bytes.
+   */
+  uint64_t getApproximateSize(KeySpace keySpace) const;
+
+  /**
+   * Drop the oldest packs of the KeySpace until it takes at most maxBytes.
+   * The pack being written to is never dropped. Returns the number of packs
+   * that were dropped. Throws if the store is read-only.
+   */
+  size_t dropOldPacks(KeySpace keySpace, uint64_t maxBytes);
+
+ private:
+  class Pack;
+  // Newest first.
+  using PackList = std::vector<std::shared_ptr<Pack>>;
+
+  struct Column {
+    /**
+     * Readers load this without locking. It is null while the store isn't
+     * open.
+     */
+    folly::atomic_shared_ptr<const PackList> packs;
+    /**
+     * Serializes writers, and changes to the pack list.
+     */
+    std::mutex writeMutex;
+  };
+
+  std::shared_ptr<const PackList> loadPacks(KeySpace keySpace) const;
+
+  /**
+   * Map the valid packs of a KeySpace directory read-only. The directory
+   * doesn't have to exist.
+   */
+  PackList loadReadOnlyPacks(AbsolutePathPiece columnPath) const;
+
+  void checkWritable() const;
+
+  AbsolutePath getColumnPath(KeySpace keySpace) const;
+
+  /**
+   * Start a new pack for the KeySpace, large enough for a record of
+   * minimumRecordSize bytes. Must be called with its writeMutex held.
+   */
+  std::shared_ptr<Pack> createPack(
+      KeySpace keySpace,
+      uint64_t generation,
+      size_t minimumRecordSize);
+
+  const AbsolutePath root_;
+  const size_t packSize_;
+  const OpenMode mode_;
+  const std::string statsPrefix_{"local_store."};
+  std::array<Column, KeySpace::kTotalCount> columns_;
+};
+
+} // namespace facebook::eden
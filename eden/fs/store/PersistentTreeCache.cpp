@@ -0,0 +1,326 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/PersistentTreeCache.h"
+
+#include <folly/Bits.h>
+#include <folly/Exception.h>
+#include <folly/File.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/Utility.h>
+#include <folly/hash/Checksum.h>
+#include <folly/hash/SpookyHashV2.h>
+#include <folly/logging/xlog.h>
+#include <folly/portability/Fcntl.h>
+#include <folly/portability/SysMman.h>
+#include <folly/portability/SysStat.h>
+#include <cstring>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+
+#include "eden/fs/model/Tree.h"
+
+namespace facebook::eden {
+
+namespace {
+constexpr uint64_t kMagic = 0x4544454e54524545; // "EDENTREE"
+constexpr uint32_t kVersion = 1;
+
+// Used to size the slot table from the data capacity. Serialized trees are
+// typically a few hundred bytes, so this keeps the table sparse.
+constexpr size_t kExpectedRecordSize = 512;
+constexpr size_t kMinimumSlotCount = 1024;
+
+constexpr size_t kRecordAlignment = 8;
+
+struct RecordHeader {
+  uint32_t checksum;
+  uint32_t treeLength;
+  uint16_t idLength;
+  uint16_t reserved;
+};
+
+size_t computeSlotCount(size_t capacityBytes) {
+  return folly::nextPowTwo(
+      std::max(kMinimumSlotCount, 2 * capacityBytes / kExpectedRecordSize));
+}
+
+uint64_t hashKey(folly::ByteRange id) {
+  // 0 marks an empty slot.
+  return folly::hash::SpookyHashV2::Hash64(id.data(), id.size(), 0) | 1;
+}
+
+uint32_t recordChecksum(
+    const RecordHeader& header,
+    folly::ByteRange id,
+    folly::ByteRange tree) {
+  auto checksum = folly::crc32c(
+      reinterpret_cast<const uint8_t*>(&header.treeLength),
+      sizeof(RecordHeader) - sizeof(header.checksum));
+  checksum = folly::crc32c(id.data(), id.size(), checksum);
+  return folly::crc32c(tree.data(), tree.size(), checksum);
+}
+} // namespace
+
+struct PersistentTreeCache::Header {
+  uint64_t magic;
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t slotCount;
+  uint64_t dataCapacity;
+  uint64_t dataUsed;
+  uint64_t entryCount;
+};
+
+struct PersistentTreeCache::Slot {
+  uint64_t keyHash;
+  uint64_t offset;
+  uint64_t length;
+};
+
+std::shared_ptr<PersistentTreeCache> PersistentTreeCache::open(
+    AbsolutePathPiece path,
+    size_t capacityBytes) {
+  folly::File file{path.copy().c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644};
+  auto fileSize = sizeof(Header) +
+      computeSlotCount(capacityBytes) * sizeof(Slot) + capacityBytes;
+
+  struct stat st;
+  folly::checkUnixError(fstat(file.fd(), &st), "fstat failed");
+  if (static_cast<size_t>(st.st_size) != fileSize) {
+    // Either a new file, or one created with a different capacity: start over.
+    folly::checkUnixError(
+        folly::ftruncateNoInt(file.fd(), 0), "failed to truncate tree cache");
+    folly::checkUnixError(
+        folly::ftruncateNoInt(file.fd(), fileSize),
+        "failed to resize tree cache");
+  }
+
+  return std::shared_ptr<PersistentTreeCache>{
+      new PersistentTreeCache{std::move(file), capacityBytes}};
+}
+
+PersistentTreeCache::PersistentTreeCache(
+    folly::File file,
+    size_t capacityBytes)
+    : capacityBytes_{capacityBytes},
+      slotCount_{computeSlotCount(capacityBytes)},
+      mapping_{
+          std::move(file),
+          0,
+          static_cast<off_t>(
+              sizeof(Header) + slotCount_ * sizeof(Slot) + capacityBytes_),
+          folly::MemoryMapping::writable()} {
+  auto& hdr = header();
+  if (hdr.magic != kMagic || hdr.version != kVersion ||
+      hdr.slotCount != slotCount_ || hdr.dataCapacity != capacityBytes_ ||
+      hdr.dataUsed > capacityBytes_ || hdr.entryCount > slotCount_) {
+    XLOG(DBG2) << "Initializing persistent tree cache";
+    resetLocked();
+  } else {
+    XLOG(DBG2) << "Loaded persistent tree cache with " << hdr.entryCount
+               << " trees";
+  }
+}
+
+PersistentTreeCache::~PersistentTreeCache() {
+  flush();
+}
+
+PersistentTreeCache::Header& PersistentTreeCache::header() const {
+  return *reinterpret_cast<Header*>(mapping_.writableRange().data());
+}
+
+PersistentTreeCache::Slot* PersistentTreeCache::slots() const {
+  return reinterpret_cast<Slot*>(
+      mapping_.writableRange().data() + sizeof(Header));
+}
+
+uint8_t* PersistentTreeCache::data() const {
+  return mapping_.writableRange().data() + sizeof(Header) +
+      slotCount_ * sizeof(Slot);
+}
+
+PersistentTreeCache::Slot* PersistentTreeCache::findSlot(
+    uint64_t keyHash,
+    folly::ByteRange id) const {
+  auto* table = slots();
+  auto mask = slotCount_ - 1;
+  for (size_t probe = 0; probe < slotCount_; ++probe) {
+    auto& slot = table[(keyHash + probe) & mask];
+    if (slot.keyHash == 0) {
+      return &slot;
+    }
+    if (slot.keyHash != keyHash) {
+      continue;
+    }
+
+    // Same key hash, make sure this is really the same id.
+    if (slot.offset + sizeof(RecordHeader) > capacityBytes_) {
+      continue;
+    }
+    RecordHeader record;
+    memcpy(&record, data() + slot.offset, sizeof(RecordHeader));
+    if (record.idLength == id.size() &&
+        slot.offset + sizeof(RecordHeader) + id.size() <= capacityBytes_ &&
+        memcmp(data() + slot.offset + sizeof(RecordHeader),
+               id.data(),
+               id.size()) == 0) {
+      return &slot;
+    }
+  }
+  return nullptr;
+}
+
+std::unique_ptr<Tree> PersistentTreeCache::get(const ObjectId& id) const {
+  auto idBytes = id.getBytes();
+  auto keyHash = hashKey(idBytes);
+
+  std::shared_lock<folly::SharedMutex> guard{lock_};
+  auto* slot = findSlot(keyHash, idBytes);
+  if (!slot || slot->keyHash == 0 ||
+      slot->offset + slot->length > capacityBytes_ ||
+      slot->length < sizeof(RecordHeader) + idBytes.size()) {
+    missCount_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  const auto* recordStart = data() + slot->offset;
+  RecordHeader record;
+  memcpy(&record, recordStart, sizeof(RecordHeader));
+  auto treeStart = recordStart + sizeof(RecordHeader) + record.idLength;
+  if (sizeof(RecordHeader) + record.idLength + record.treeLength !=
+      slot->length) {
+    missCount_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+  folly::ByteRange treeBytes{treeStart, record.treeLength};
+  if (recordChecksum(record, idBytes, treeBytes) != record.checksum) {
+    XLOG(DBG3) << "checksum mismatch in persistent tree cache for " << id;
+    missCount_.fetch_add(1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  std::unique_ptr<Tree> tree;
+  try {
+    tree = Tree::tryDeserialize(id, folly::StringPiece{treeBytes});
+  } catch (const std::exception& ex) {
+    XLOG(DBG3) << "unable to deserialize tree " << id
+               << " from persistent tree cache: " << ex.what();
+  }
+  if (tree) {
+    hitCount_.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    missCount_.fetch_add(1, std::memory_order_relaxed);
+  }
+  return tree;
+}
+
+void PersistentTreeCache::insert(const Tree& tree) {
+  auto idBytes = tree.getHash().getBytes();
+  auto keyHash = hashKey(idBytes);
+  auto serialized = tree.serialize();
+  auto treeBytes = serialized.coalesce();
+
+  auto recordLength =
+      sizeof(RecordHeader) + idBytes.size() + treeBytes.size();
+  auto alignedLength =
+      (recordLength + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+  if (alignedLength > capacityBytes_ ||
+      idBytes.size() > std::numeric_limits<uint16_t>::max()) {
+    return;
+  }
+
+  std::unique_lock<folly::SharedMutex> guard{lock_};
+  auto& hdr = header();
+  auto* slot = findSlot(keyHash, idBytes);
+  if (slot && slot->keyHash != 0) {
+    // Already cached.
+    return;
+  }
+
+  if (!slot || hdr.dataUsed + alignedLength > capacityBytes_ ||
+      (hdr.entryCount + 1) * 4 > slotCount_ * 3) {
+    XLOG(DBG2) << "persistent tree cache is full, resetting it";
+    resetLocked();
+    resetCount_.fetch_add(1, std::memory_order_relaxed);
+    slot = findSlot(keyHash, idBytes);
+  }
+
+  RecordHeader record;
+  record.treeLength = folly::to_narrow(treeBytes.size());
+  record.idLength = folly::to_narrow(idBytes.size());
+  record.reserved = 0;
+  record.checksum = recordChecksum(record, idBytes, treeBytes);
+
+  auto offset = hdr.dataUsed;
+  auto* out = data() + offset;
+  memcpy(out, &record, sizeof(RecordHeader));
+  memcpy(out + sizeof(RecordHeader), idBytes.data(), idBytes.size());
+  memcpy(
+      out + sizeof(RecordHeader) + idBytes.size(),
+      treeBytes.data(),
+      treeBytes.size());
+
+  // Publish the slot last, after the record is fully written.
+  slot->offset = offset;
+  slot->length = recordLength;
+  slot->keyHash = keyHash;
+  hdr.dataUsed = offset + alignedLength;
+  ++hdr.entryCount;
+}
+
+void PersistentTreeCache::clear() {
+  std::unique_lock<folly::SharedMutex> guard{lock_};
+  resetLocked();
+}
+
+void PersistentTreeCache::resetLocked() {
+  auto& hdr = header();
+  // Invalidate the header first so that a crash in the middle of a reset
+  // resets again on the next startup.
+  hdr.magic = 0;
+  memset(static_cast<void*>(slots()), 0, slotCount_ * sizeof(Slot));
+  hdr.version = kVersion;
+  hdr.reserved = 0;
+  hdr.slotCount = slotCount_;
+  hdr.dataCapacity = capacityBytes_;
+  hdr.dataUsed = 0;
+  hdr.entryCount = 0;
+  hdr.magic = kMagic;
+}
+
+void PersistentTreeCache::flush() {
+#ifndef _WIN32
+  auto range = mapping_.writableRange();
+  if (range.empty()) {
+    return;
+  }
+  if (msync(range.data(), range.size(), MS_ASYNC) != 0) {
+    XLOG(WARN) << "failed to flush persistent tree cache: "
+               << folly::errnoStr(errno);
+  }
+#endif
+}
+
+PersistentTreeCache::Stats PersistentTreeCache::getStats() const {
+  Stats stats;
+  {
+    std::shared_lock<folly::SharedMutex> guard{lock_};
+    stats.entryCount = header().entryCount;
+    stats.usedBytes = header().dataUsed;
+  }
+  stats.capacityBytes = capacityBytes_;
+  stats.hitCount = hitCount_.load(std::memory_order_relaxed);
+  stats.missCount = missCount_.load(std::memory_order_relaxed);
+  stats.resetCount = resetCount_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/SharedMutex.h>
+#include <folly/system/MemoryMapping.h>
+#include <atomic>
+#include <memory>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class Tree;
+
+/**
+ * A bounded, memory-mapped cache of serialized trees that persists across
+ * EdenFS restarts. It sits between the in-memory TreeCache and the
+ * BackingStore (and thus the LocalStore) so that after a restart, trees that
+ * were recently used can be found with a single hash table probe into the
+ * mapping instead of a RocksDB lookup.
+ *
+ * The file is made of a fixed header, an open-addressed table of slots and a
+ * data area where records are appended. Each record holds the tree's ObjectId,
+ * a checksum and the tree in its Tree::serialize() format. When either the
+ * data area or the table fills up, the whole cache is reset: this trades hit
+ * rate for never having to compact the file.
+ *
+ * The mapping is shared, so records written by this process survive it
+ * crashing. A record is only published in the table after its bytes were
+ * written, and every record is checksummed, so torn writes after a system
+ * crash are detected and treated as misses.
+ *
+ * It is safe to use this object from arbitrary threads.
+ */
+class PersistentTreeCache {
+ public:
+  struct Stats {
+    size_t entryCount{0};
+    size_t usedBytes{0};
+    size_t capacityBytes{0};
+    uint64_t hitCount{0};
+    uint64_t missCount{0};
+    uint64_t resetCount{0};
+  };
+
+  /**
+   * Open the cache stored at `path`, creating it if needed. The data area is
+   * sized to hold `capacityBytes` worth of serialized trees. An existing file
+   * that was created with a different capacity or an incompatible format is
+   * reset.
+   */
+  static std::shared_ptr<PersistentTreeCache> open(
+      AbsolutePathPiece path,
+      size_t capacityBytes);
+
+  ~PersistentTreeCache();
+
+  PersistentTreeCache(const PersistentTreeCache&) = delete;
+  PersistentTreeCache& operator=(const PersistentTreeCache&) = delete;
+
+  /**
+   * Returns the tree with the given id, or nullptr if it isn't cached.
+   */
+  std::unique_ptr<Tree> get(const ObjectId& id) const;
+
+  /**
+   * Add a tree to the cache. Trees that are already present, or that are too
+   * large for the cache, are ignored.
+   */
+  void insert(const Tree& tree);
+
+  /**
+   * Drop every cached tree.
+   */
+  void clear();
+
+  /**
+   * Ask the kernel to write back dirty pages of the mapping.
+   */
+  void flush();
+
+  Stats getStats() const;
+
+ private:
+  struct Header;
+  struct Slot;
+
+  PersistentTreeCache(folly::File file, size_t capacityBytes);
+
+  Header& header() const;
+  Slot* slots() const;
+  uint8_t* data() const;
+
+  /**
+   * Return the slot holding `id`, or the empty slot where it would be
+   * inserted, or nullptr if the table is full.
+   */
+  Slot* findSlot(uint64_t keyHash, folly::ByteRange id) const;
+
+  void resetLocked();
+
+  const size_t capacityBytes_;
+  const size_t slotCount_;
+
+  /**
+   * Readers take the lock shared. Inserts and resets take it exclusively.
+   */
+  mutable folly::SharedMutex lock_;
+  folly::MemoryMapping mapping_;
+
+  mutable std::atomic<uint64_t> hitCount_{0};
+  mutable std::atomic<uint64_t> missCount_{0};
+  std::atomic<uint64_t> resetCount_{0};
+};
+
+} // namespace facebook::eden
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/PrefetchProfile.h"
+
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+
+#include <fmt/format.h>
+#include <folly/Conv.h>
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/ObjectStore.h"
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr folly::StringPiece kProfileHeader{"eden-prefetch-profile-v1\n"};
+
+/**
+ * The state of a resolvePrefetchProfile() walk, shared by its levels.
+ */
+struct ResolveState {
+  ResolveState(
+      const ObjectStore* objectStore,
+      std::vector<RelativePath> paths,
+      const ObjectFetchContextPtr& context)
+      : objectStore{objectStore},
+        paths{std::move(paths)},
+        context{context.copy()} {}
+
+  const ObjectStore* const objectStore;
+  std::vector<RelativePath> paths;
+  ObjectFetchContextPtr context;
+  PrefetchProfileResolution result;
+};
+
+/**
+ * A tree to look the paths at `indices` up in, past their first `offset`
+ * characters.
+ */
+struct PendingTree {
+  std::shared_ptr<const Tree> tree;
+  size_t offset;
+  std::vector<size_t> indices;
+};
+
+ImmediateFuture<folly::Unit> resolveLevel(
+    std::shared_ptr<ResolveState> state,
+    std::vector<PendingTree> level) {
+  std::vector<ObjectId> treeIds;
+  std::vector<PendingTree> next;
+  for (const auto& pending : level) {
+    // The paths are sorted, so those under the same child are adjacent.
+    std::optional<std::string_view> childName;
+    bool childIsTree = false;
+    for (auto index : pending.indices) {
+      auto rest = state->paths[index].view().substr(pending.offset);
+      auto slash = rest.find('/');
+      if (slash == std::string_view::npos) {
+        auto it = pending.tree->find(PathComponentPiece{rest});
+        if (it != pending.tree->cend() && !it->second.isTree()) {
+          state->result.blobIds.push_back(it->second.getHash());
+        } else {
+          ++state->result.missingPaths;
+        }
+        continue;
+      }
+
+      auto name = rest.substr(0, slash);
+      if (childName != name) {
+        childName = name;
+        auto it = pending.tree->find(PathComponentPiece{name});
+        childIsTree = it != pending.tree->cend() && it->second.isTree();
+        if (childIsTree) {
+          treeIds.push_back(it->second.getHash());
+          next.push_back(
+              PendingTree{nullptr, pending.offset + slash + 1, {}});
+        }
+      }
+      if (childIsTree) {
+        next.back().indices.push_back(index);
+      } else {
+        ++state->result.missingPaths;
+      }
+    }
+  }
+
+  if (treeIds.empty()) {
+    return folly::unit;
+  }
+  return state->objectStore->getTreeBatch(treeIds, state->context)
+      .thenValue(
+          [state, next = std::move(next)](
+              std::vector<folly::Try<std::shared_ptr<const Tree>>>&&
+                  trees) mutable {
+            std::vector<PendingTree> level;
+            level.reserve(next.size());
+            for (size_t i = 0; i < next.size(); ++i) {
+              if (trees[i].hasValue()) {
+                next[i].tree = std::move(trees[i]).value();
+                level.push_back(std::move(next[i]));
+              } else {
+                state->result.missingPaths += next[i].indices.size();
+              }
+            }
+            return resolveLevel(std::move(state), std::move(level));
+          });
+}
+
+ImmediateFuture<size_t> prefetchBatches(
+    const ObjectStore* objectStore,
+    std::shared_ptr<std::vector<ObjectId>> blobIds,
+    size_t start,
+    size_t batchSize,
+    ObjectFetchContextPtr context,
+    size_t fetched) {
+  if (start >= blobIds->size()) {
+    return fetched;
+  }
+  auto count = std::min(batchSize, blobIds->size() - start);
+  return objectStore
+      ->prefetchBlobs(ObjectIdRange{blobIds->data() + start, count}, context)
+      .thenValue([objectStore,
+                  blobIds,
+                  start = start + count,
+                  batchSize,
+                  context = context.copy(),
+                  fetched](size_t batchFetched) mutable {
+        return prefetchBatches(
+            objectStore,
+            std::move(blobIds),
+            start,
+            batchSize,
+            std::move(context),
+            fetched + batchFetched);
+      });
+}
+
+} // namespace
+
+std::string serializePrefetchProfile(std::vector<RelativePath> paths) {
+  std::sort(paths.begin(), paths.end());
+  paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+
+  std::string out = kProfileHeader.str();
+  std::string_view previous;
+  for (const auto& path : paths) {
+    auto view = path.view();
+    auto shared =
+        std::mismatch(
+            previous.begin(), previous.end(), view.begin(), view.end())
+            .first -
+        previous.begin();
+    fmt::format_to(
+        std::back_inserter(out), "{} {}\n", shared, view.substr(shared));
+    previous = view;
+  }
+  return out;
+}
+
+std::vector<RelativePath> parsePrefetchProfile(folly::StringPiece data) {
+  if (!data.startsWith(kProfileHeader)) {
+    throw std::invalid_argument("not a prefetch profile");
+  }
+  data.advance(kProfileHeader.size());
+
+  std::vector<RelativePath> paths;
+  std::string previous;
+  while (!data.empty()) {
+    auto end = data.find('\n');
+    if (end == folly::StringPiece::npos) {
+      throw std::invalid_argument("truncated prefetch profile");
+    }
+    auto line = data.subpiece(0, end);
+    data.advance(end + 1);
+
+    auto space = line.find(' ');
+    if (space == folly::StringPiece::npos) {
+      throw std::invalid_argument(
+          fmt::format("malformed prefetch profile line: {}", line));
+    }
+    auto shared = folly::tryTo<size_t>(line.subpiece(0, space));
+    if (!shared || *shared > previous.size()) {
+      throw std::invalid_argument(
+          fmt::format("malformed prefetch profile line: {}", line));
+    }
+    previous.resize(*shared);
+    auto suffix = line.subpiece(space + 1);
+    previous.append(suffix.begin(), suffix.end());
+    paths.emplace_back(previous);
+  }
+  return paths;
+}
+
+ImmediateFuture<PrefetchProfileResolution> resolvePrefetchProfile(
+    const ObjectStore* objectStore,
+    std::shared_ptr<const Tree> rootTree,
+    std::vector<RelativePath> paths,
+    const ObjectFetchContextPtr& context) {
+  auto state =
+      std::make_shared<ResolveState>(objectStore, std::move(paths), context);
+  std::vector<size_t> indices(state->paths.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    indices[i] = i;
+  }
+  std::vector<PendingTree> level;
+  level.push_back(PendingTree{std::move(rootTree), 0, std::move(indices)});
+  return resolveLevel(state, std::move(level)).thenValue([state](auto&&) {
+    return std::move(state->result);
+  });
+}
+
+ImmediateFuture<size_t> prefetchProfileBlobs(
+    const ObjectStore* objectStore,
+    std::vector<ObjectId> blobIds,
+    size_t batchSize,
+    const ObjectFetchContextPtr& context) {
+  return prefetchBatches(
+      objectStore,
+      std::make_shared<std::vector<ObjectId>>(std::move(blobIds)),
+      0,
+      std::max(batchSize, size_t{1}),
+      context.copy(),
+      0);
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <folly/Range.h>
+
+#include "eden/fs/model/ObjectId.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/utils/ImmediateFuture.h"
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+class ObjectStore;
+class Tree;
+
+/**
+ * A prefetch profile is a list of repository paths, typically the files a
+ * build fetched, that can be fetched again ahead of the next build.
+ *
+ * The paths are stored sorted, each one as the length of the prefix it
+ * shares with the previous path followed by the rest of it, which keeps the
+ * deep paths of a repository compact.
+ */
+std::string serializePrefetchProfile(std::vector<RelativePath> paths);
+
+/**
+ * Parse a profile written by serializePrefetchProfile(). Throws if the
+ * profile is malformed.
+ */
+std::vector<RelativePath> parsePrefetchProfile(folly::StringPiece data);
+
+struct PrefetchProfileResolution {
+  /** The blobs of the files of the profile, in no particular order. */
+  std::vector<ObjectId> blobIds;
+  /** The paths that aren't files of the tree. */
+  size_t missingPaths{0};
+};
+
+/**
+ * Find the blobs of the files of `paths` in rootTree.
+ *
+ * The trees are walked one level at a time, all the trees of a level being
+ * requested together, so the backing store can batch them. Each tree is only
+ * requested once if the paths are sorted, as parsePrefetchProfile() returns
+ * them. The ObjectStore must outlive the returned future.
+ */
+ImmediateFuture<PrefetchProfileResolution> resolvePrefetchProfile(
+    const ObjectStore* objectStore,
+    std::shared_ptr<const Tree> rootTree,
+    std::vector<RelativePath> paths,
+    const ObjectFetchContextPtr& context);
+
+/**
+ * Prefetch the blobs, batchSize at a time, each batch being requested once
+ * the previous one completed. The ObjectStore must outlive the returned
+ * future.
+ *
+ * Returns the number of blobs that had to be fetched remotely.
+ */
+ImmediateFuture<size_t> prefetchProfileBlobs(
+    const ObjectStore* objectStore,
+    std::vector<ObjectId> blobIds,
+    size_t batchSize,
+    const ObjectFetchContextPtr& context);
+
+} // namespace facebook::eden
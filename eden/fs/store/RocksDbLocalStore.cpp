@@ -17,16 +17,21 @@
 #include <folly/io/IOBuf.h>
 #include <folly/lang/Bits.h>
 #include <folly/logging/xlog.h>
+#include <rocksdb/cache.h>
 #include <rocksdb/convenience.h>
 #include <rocksdb/db.h>
 #include <rocksdb/filter_policy.h>
+#include <rocksdb/rate_limiter.h>
+#include <rocksdb/statistics.h>
 #include <rocksdb/table.h>
+#include <rocksdb/version.h>
 
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/rocksdb/RocksException.h"
 #include "eden/fs/rocksdb/RocksHandles.h"
 #include "eden/fs/store/KeySpace.h"
 #include "eden/fs/store/StoreResult.h"
+#include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/StructuredLogger.h"
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/FaultInjector.h"
@@ -44,15 +49,100 @@ using std::chrono::duration_cast;
 namespace {
 using namespace facebook::eden;
 
-rocksdb::ColumnFamilyOptions makeColumnOptions(uint64_t LRUblockCacheSizeMB) {
-  rocksdb::ColumnFamilyOptions options;
+// getBatch splits its keys into MultiGet calls of at most this many keys, so
+// that large batches are spread over several ioPool_ threads.
+constexpr size_t kMaxMultiGetBatchSize = 2048;
+
+// RocksDB's rate limiter can't be disabled once installed, so "unlimited"
+// is a rate no disk will ever reach.
+constexpr int64_t kUnlimitedCompactionRate = int64_t{1} << 40;
+
+// Automatic garbage collection brings a keyspace down to this fraction of
+// its limit, so that it isn't over the limit again right away.
+constexpr uint64_t kGcTargetPercent = 75;
+
+ReadOptions makeMultiGetReadOptions() {
+  ReadOptions options;
+#if ROCKSDB_MAJOR >= 8
+  // Let MultiGet read the data blocks of a batch that aren't in the block
+  // cache in parallel, rather than one after the other.
+  options.async_io = true;
+#endif
+  return options;
+}
+
+/**
+ * How the SST files of a column family are laid out, chosen from the size and
+ * compressibility of the values it holds.
+ */
+struct ColumnTuning {
+  double bloomBitsPerKey;
+  size_t blockSize;
+  rocksdb::CompressionType compression;
+};
+
+rocksdb::CompressionType pickCompression(
+    std::initializer_list<rocksdb::CompressionType> preferred) {
+  auto supported = rocksdb::GetSupportedCompressions();
+  for (auto type : preferred) {
+    if (std::find(supported.begin(), supported.end(), type) !=
+        supported.end()) {
+      return type;
+    }
+  }
+  return rocksdb::kNoCompression;
+}
 
-  // We'll never perform range scans on any of the keys that we store.
-  // This enables bloom filters and a hash policy that improves our
-  // get/put performance.
-  options.OptimizeForPointLookup(LRUblockCacheSizeMB);
+ColumnTuning getColumnTuning(KeySpace keySpace) {
+  if (keySpace->index == KeySpace::BlobFamily.index) {
+    // Blobs are large and highly compressible. Larger blocks compress better,
+    // and a block is read for every blob anyway.
+    return ColumnTuning{
+        10,
+        64 * 1024,
+        pickCompression({rocksdb::kZSTD, rocksdb::kLZ4Compression})};
+  }
+  if (keySpace->index == KeySpace::TreeFamily.index) {
+    return ColumnTuning{
+        10, 16 * 1024, pickCompression({rocksdb::kLZ4Compression})};
+  }
+  if (keySpace->index == KeySpace::BlobMetaDataFamily.index ||
+      keySpace->index == KeySpace::HgProxyHashFamily.index ||
+      keySpace->index == KeySpace::HgCommitToTreeFamily.index) {
+    // Small values that are mostly hashes: compressing them saves little space
+    // and costs CPU on every lookup. These are the hottest point lookups, so
+    // they get more bloom filter bits to avoid reading blocks for misses.
+    return ColumnTuning{16, 4 * 1024, rocksdb::kNoCompression};
+  }
+  // Deprecated key spaces are only ever cleared.
+  return ColumnTuning{10, 4 * 1024, rocksdb::kNoCompression};
+}
 
+rocksdb::ColumnFamilyOptions makeColumnOptions(
+    const ColumnTuning& tuning,
+    const std::shared_ptr<rocksdb::Cache>& blockCache) {
+  rocksdb::ColumnFamilyOptions options;
   options.OptimizeLevelStyleCompaction();
+
+  // We'll never perform range scans on any of the keys that we store. This
+  // mirrors OptimizeForPointLookup(), except for the block cache, which is
+  // shared between column families, and the per column family tuning.
+  rocksdb::BlockBasedTableOptions tableOptions;
+  tableOptions.block_cache = blockCache;
+  tableOptions.block_size = tuning.blockSize;
+  tableOptions.filter_policy.reset(
+      rocksdb::NewBloomFilterPolicy(tuning.bloomBitsPerKey));
+  tableOptions.data_block_index_type =
+      rocksdb::BlockBasedTableOptions::kDataBlockBinaryAndHash;
+  tableOptions.data_block_hash_table_util_ratio = 0.75;
+  options.table_factory.reset(rocksdb::NewBlockBasedTableFactory(tableOptions));
+  options.memtable_prefix_bloom_size_ratio = 0.02;
+  options.memtable_whole_key_filtering = true;
+
+  // OptimizeLevelStyleCompaction() picked a compression per level, use ours on
+  // every level instead.
+  options.compression_per_level.clear();
+  options.compression = tuning.compression;
   return options;
 }
 
@@ -62,13 +152,12 @@ rocksdb::ColumnFamilyOptions makeColumnOptions(uint64_t LRUblockCacheSizeMB) {
  */
 const std::vector<rocksdb::ColumnFamilyDescriptor> columnFamilies(
     const rocksdb::DBOptions& db_options,
-    const std::string& name) {
-  // Most of the column families will share the same cache.  We
-  // want the blob data to live in its own smaller cache; the assumption
-  // is that the vfs cache will compensate for that, together with the
-  // idea that we shouldn't need to materialize a great many files.
-  auto options = makeColumnOptions(64);
-  auto blobOptions = makeColumnOptions(8);
+    const std::string& name,
+    const std::shared_ptr<rocksdb::Cache>& blockCache) {
+  // All column families share a single block cache, so that its budget goes
+  // to whichever key spaces are hot rather than being split up front.
+  auto options = makeColumnOptions(
+      ColumnTuning{10, 4 * 1024, rocksdb::kNoCompression}, blockCache);
 
   // We have to open all column families that currenly exists in our RocksDb.
   // Else we will get "Invalid argument: You have to open all column
@@ -82,8 +171,7 @@ const std::vector<rocksdb::ColumnFamilyDescriptor> columnFamilies(
   std::vector<rocksdb::ColumnFamilyDescriptor> families;
   for (auto& ks : KeySpace::kAll) {
     families.emplace_back(
-        ks->name.str(),
-        (ks->index == KeySpace::BlobFamily.index) ? blobOptions : options);
+        ks->name.str(), makeColumnOptions(getColumnTuning(ks), blockCache));
     auto oldFamily = find(
         oldUnopenedColumnFamilies.begin(),
         oldUnopenedColumnFamilies.end(),
@@ -145,10 +233,12 @@ class RocksDbWriteBatch : public LocalStore::WriteBatch {
       std::vector<folly::ByteRange> valueSlices) override;
   void flush() override;
   ~RocksDbWriteBatch() override;
-  // Use LocalStore::beginWrite() to create a write batch
+  // Use LocalStore::beginWrite() or LocalStore::beginEphemeralWrite() to
+  // create a write batch
   RocksDbWriteBatch(
       Synchronized<RocksDbLocalStore::RockDBState>::ConstRLockedPtr&& dbHandles,
-      size_t bufferSize);
+      size_t bufferSize,
+      bool ephemeral = false);
 
   void flushIfNeeded();
 
@@ -156,6 +246,9 @@ class RocksDbWriteBatch : public LocalStore::WriteBatch {
       lockedDB_;
   rocksdb::WriteBatch writeBatch_;
   size_t bufSize_;
+  // Ephemeral batches only hold data that can be fetched again, so they skip
+  // the write-ahead log.
+  bool ephemeral_;
 };
 
 void RocksDbWriteBatch::flush() {
@@ -167,7 +260,9 @@ void RocksDbWriteBatch::flush() {
   XLOG(DBG5) << "Flushing " << pending << " entries with data size of "
              << writeBatch_.GetDataSize();
 
-  auto status = lockedDB_->handles->db->Write(WriteOptions(), &writeBatch_);
+  WriteOptions writeOptions;
+  writeOptions.disableWAL = ephemeral_;
+  auto status = lockedDB_->handles->db->Write(writeOptions, &writeBatch_);
   XLOG(DBG5) << "... Flushed";
 
   if (!status.ok()) {
@@ -188,11 +283,13 @@ void RocksDbWriteBatch::flushIfNeeded() {
 
 RocksDbWriteBatch::RocksDbWriteBatch(
     Synchronized<RocksDbLocalStore::RockDBState>::ConstRLockedPtr&& dbHandles,
-    size_t bufSize)
+    size_t bufSize,
+    bool ephemeral)
     : LocalStore::WriteBatch(),
       lockedDB_(std::move(dbHandles)),
       writeBatch_(bufSize),
-      bufSize_(bufSize) {}
+      bufSize_(bufSize),
+      ephemeral_(ephemeral) {}
 
 RocksDbWriteBatch::~RocksDbWriteBatch() {
   if (writeBatch_.Count() > 0) {
@@ -205,6 +302,9 @@ void RocksDbWriteBatch::put(
     KeySpace keySpace,
     folly::ByteRange key,
     folly::ByteRange value) {
+  XDCHECK(!ephemeral_ || keySpace->isEphemeral())
+      << "Write to persistent keyspace " << keySpace->name
+      << " in an ephemeral batch";
   writeBatch_.Put(
       lockedDB_->handles->columns[keySpace->index].get(),
       _createSlice(key),
@@ -217,6 +317,9 @@ void RocksDbWriteBatch::put(
     KeySpace keySpace,
     folly::ByteRange key,
     std::vector<folly::ByteRange> valueSlices) {
+  XDCHECK(!ephemeral_ || keySpace->isEphemeral())
+      << "Write to persistent keyspace " << keySpace->name
+      << " in an ephemeral batch";
   std::vector<Slice> slices;
 
   for (auto& valueSlice : valueSlices) {
@@ -249,10 +352,19 @@ rocksdb::Options getRocksdbOptions() {
   return options;
 }
 
-RocksHandles openDB(AbsolutePathPiece path, RocksDBOpenMode mode) {
+RocksHandles openDB(
+    AbsolutePathPiece path,
+    RocksDBOpenMode mode,
+    const std::shared_ptr<rocksdb::Cache>& blockCache,
+    const std::shared_ptr<rocksdb::Statistics>& statistics,
+    const std::shared_ptr<rocksdb::RateLimiter>& rateLimiter) {
   auto options = getRocksdbOptions();
-  const auto columnDescriptors =
-      columnFamilies(rocksdb::DBOptions{options}, path.stringWithoutUNC());
+  options.statistics = statistics;
+  // Compaction and flush writes go through the rate limiter, so that they
+  // can't saturate the disk.
+  options.rate_limiter = rateLimiter;
+  const auto columnDescriptors = columnFamilies(
+      rocksdb::DBOptions{options}, path.stringWithoutUNC(), blockCache);
   try {
     return RocksHandles(
         path.viewWithoutUNC(), mode, options, columnDescriptors);
@@ -266,7 +378,7 @@ RocksHandles openDB(AbsolutePathPiece path, RocksDBOpenMode mode) {
     // Fall through and attempt to repair the DB
   }
 
-  RocksDbLocalStore::repairDB(path);
+  RocksDbLocalStore::repairDB(path, blockCache);
 
   // Now try opening the DB again.
   return RocksHandles(path.viewWithoutUNC(), mode, options, columnDescriptors);
@@ -285,12 +397,20 @@ RocksDbLocalStore::RocksDbLocalStore(
     AbsolutePathPiece pathToRocksDb,
     std::shared_ptr<StructuredLogger> structuredLogger,
     FaultInjector* faultInjector,
-    RocksDBOpenMode mode)
+    RocksDBOpenMode mode,
+    size_t blockCacheSizeBytes,
+    std::shared_ptr<EdenStats> edenStats)
     : structuredLogger_{std::move(structuredLogger)},
+      edenStats_{std::move(edenStats)},
       faultInjector_(*faultInjector),
       ioPool_(12, "RocksLocalStore"),
       pathToDb_{pathToRocksDb.copy()},
-      mode_{mode} {
+      mode_{mode},
+      blockCache_{rocksdb::NewLRUCache(blockCacheSizeBytes)},
+      statistics_{rocksdb::CreateDBStatistics()},
+      rateLimiter_{rocksdb::NewGenericRateLimiter(kUnlimitedCompactionRate)} {
+  // Tickers are all we read, skip the more expensive histograms and timers.
+  statistics_->set_stats_level(rocksdb::StatsLevel::kExceptHistogramOrTimers);
   XLOG(DBG2) << "Making a new RockDB localstore ( " << this
              << " ) . debug information for T136469251.";
 }
@@ -310,8 +430,9 @@ void RocksDbLocalStore::open() {
       case RockDbHandleStatus::NOT_YET_OPENED:
         break;
     }
-    handles->handles =
-        std::make_unique<RocksHandles>(openDB(pathToDb_.piece(), mode_));
+    handles->handles = std::make_unique<RocksHandles>(
+        openDB(
+            pathToDb_.piece(), mode_, blockCache_, statistics_, rateLimiter_));
     handles->status = RockDbHandleStatus::OPEN;
   }
   // Publish fb303 stats once when we first open the DB.
@@ -329,6 +450,10 @@ RocksDbLocalStore::~RocksDbLocalStore() {
 }
 
 void RocksDbLocalStore::close() {
+  // Have a running garbage collection stop at its next step, rather than
+  // holding up closing the store until it is done.
+  compactionScheduler_.cancel();
+
   // Acquire dbHandles_ in write-lock mode.
   // Since any other access to the DB acquires a read lock this will block until
   // all current DB operations are complete.
@@ -361,17 +486,21 @@ RocksDbLocalStore::getHandles() const {
   return handles;
 }
 
-void RocksDbLocalStore::repairDB(AbsolutePathPiece path) {
+void RocksDbLocalStore::repairDB(
+    AbsolutePathPiece path,
+    std::shared_ptr<rocksdb::Cache> blockCache) {
   XLOG(ERR) << "Attempting to repair RocksDB " << path;
-  rocksdb::ColumnFamilyOptions unknownColumFamilyOptions;
-  unknownColumFamilyOptions.OptimizeForPointLookup(8);
-  unknownColumFamilyOptions.OptimizeLevelStyleCompaction();
+  if (!blockCache) {
+    blockCache = rocksdb::NewLRUCache(8 * 1024 * 1024);
+  }
+  auto unknownColumFamilyOptions = makeColumnOptions(
+      ColumnTuning{10, 4 * 1024, rocksdb::kNoCompression}, blockCache);
 
   auto dbPathStr = path.stringWithoutUNC();
   rocksdb::DBOptions dbOptions(getRocksdbOptions());
 
   const auto columnDescriptors =
-      columnFamilies(dbOptions, path.stringWithoutUNC());
+      columnFamilies(dbOptions, path.stringWithoutUNC(), blockCache);
 
   auto status = RepairDB(
       dbPathStr, dbOptions, columnDescriptors, unknownColumFamilyOptions);
@@ -473,7 +602,7 @@ RocksDbLocalStore::getBatch(
   batches.emplace_back(std::make_shared<std::vector<std::string>>());
 
   for (auto& key : keys) {
-    if (batches.back()->size() >= 2048) {
+    if (batches.back()->size() >= kMaxMultiGetBatchSize) {
       batches.emplace_back(std::make_shared<std::vector<std::string>>());
     }
     batches.back()->emplace_back(
@@ -490,15 +619,20 @@ RocksDbLocalStore::getBatch(
               XLOG(DBG3) << __func__ << " starting to actually do work";
               auto handlesLock = store->getHandles();
               auto& handles = handlesLock->handles;
-              std::vector<Slice> keySlices;
-              std::vector<std::string> values;
-              std::vector<rocksdb::ColumnFamilyHandle*> columns;
-              for (auto& key : *keys) {
-                keySlices.emplace_back(key);
-                columns.emplace_back(handles->columns[keySpace->index].get());
-              }
-              auto statuses = handles->db->MultiGet(
-                  ReadOptions(), columns, keySlices, &values);
+              std::vector<Slice> keySlices(keys->begin(), keys->end());
+              std::vector<rocksdb::PinnableSlice> values(keys->size());
+              std::vector<rocksdb::Status> statuses(keys->size());
+              // The single column family flavor of MultiGet looks up the
+              // whole batch at once: keys sharing a data block cost a single
+              // block cache lookup or read, and the values are pinned in the
+              // block cache instead of copied out of it.
+              handles->db->MultiGet(
+                  makeMultiGetReadOptions(),
+                  handles->columns[keySpace->index].get(),
+                  keySlices.size(),
+                  keySlices.data(),
+                  values.data(),
+                  statuses.data());
 
               std::vector<StoreResult> results;
               for (size_t i = 0; i < keys->size(); ++i) {
@@ -525,7 +659,7 @@ RocksDbLocalStore::getBatch(
                       folly::hexlify(keys->at(i)),
                       " from local store");
                 }
-                results.emplace_back(std::move(values[i]));
+                results.emplace_back(values[i].ToString());
               }
               return results;
             }));
@@ -574,6 +708,12 @@ std::unique_ptr<LocalStore::WriteBatch> RocksDbLocalStore::beginWrite(
   return std::make_unique<RocksDbWriteBatch>(getHandles(), bufSize);
 }
 
+std::unique_ptr<LocalStore::WriteBatch> RocksDbLocalStore::beginEphemeralWrite(
+    size_t bufSize) {
+  return std::make_unique<RocksDbWriteBatch>(
+      getHandles(), bufSize, /*ephemeral=*/true);
+}
+
 void RocksDbLocalStore::put(
     KeySpace keySpace,
     folly::ByteRange key,
@@ -587,6 +727,33 @@ void RocksDbLocalStore::put(
       _createSlice(value));
 }
 
+void RocksDbLocalStore::forEachValue(
+    KeySpace keySpace,
+    const std::function<void(folly::ByteRange key, folly::ByteRange value)>&
+        fn) const {
+  auto handlesLock = getHandles();
+  auto& handles = handlesLock->handles;
+  auto columnFamily = handles->columns[keySpace->index].get();
+
+  ReadOptions readOptions;
+  readOptions.fill_cache = false;
+  std::unique_ptr<rocksdb::Iterator> it{
+      handles->db->NewIterator(readOptions, columnFamily)};
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    auto key = it->key();
+    auto value = it->value();
+    fn(folly::ByteRange{folly::StringPiece{key.data(), key.size()}},
+       folly::ByteRange{folly::StringPiece{value.data(), value.size()}});
+  }
+  if (!it->status().ok()) {
+    throw RocksException::build(
+        it->status(),
+        "error scanning \"",
+        columnFamily->GetName(),
+        "\" column family");
+  }
+}
+
 uint64_t RocksDbLocalStore::getApproximateSize(KeySpace keySpace) const {
   auto handlesLock = getHandles();
   auto& handles = handlesLock->handles;
@@ -636,9 +803,12 @@ uint64_t RocksDbLocalStore::getApproximateSize(KeySpace keySpace) const {
 void RocksDbLocalStore::periodicManagementTask(const EdenConfig& config) {
   enableBlobCaching.store(
       config.enableBlobCaching.getValue(), std::memory_order_relaxed);
+  compactionScheduler_.updateConfig(config);
+  updateRateLimit();
 
   // Compute and publish the stats
   auto before = computeStats(/*publish=*/true, &config);
+  publishRocksDbStats();
 
   // If any ephemeral column's size is more than its configured limit,
   // trigger garbage collection.
@@ -652,6 +822,17 @@ void RocksDbLocalStore::periodicManagementTask(const EdenConfig& config) {
         keySpaceNames.append(ks->name.str());
       }
     }
+    if (compactionScheduler_.shouldDefer()) {
+      // Try again on the next run, when filesystem requests are hopefully
+      // completing quickly again.
+      XLOG(DBG2) << "deferring automatic local store garbage collection: "
+                 << "foreground latency is "
+                 << compactionScheduler_.getForegroundLatency().count()
+                 << "us";
+      fb303::fbData->incrementCounter(
+          folly::to<string>(statsPrefix_, "auto_gc.deferred"));
+      return;
+    }
     XLOG(INFO) << "scheduling automatic local store garbage collection: "
                << "ephemeral data sizes of columns " << keySpaceNames
                << " exceed their limits; total ephemeral size = "
@@ -673,8 +854,11 @@ RocksDbLocalStore::SizeSummary RocksDbLocalStore::computeStats(
     if (auto* ephemeral = std::get_if<Ephemeral>(&ks->persistence)) {
       result.ephemeral += size;
       if (config) {
-        if (size > (config->*(ephemeral->cacheLimit)).getValue()) {
+        auto limit = (config->*(ephemeral->cacheLimit)).getValue();
+        if (size > limit) {
           result.excessiveKeySpaces.set(ks->index);
+          result.bytesToEvict[ks->index] =
+              size - limit / 100 * kGcTargetPercent;
         }
       }
     } else if (!ks->isDeprecated()) {
@@ -694,6 +878,40 @@ RocksDbLocalStore::SizeSummary RocksDbLocalStore::computeStats(
   return result;
 }
 
+void RocksDbLocalStore::publishRocksDbStats() {
+  if (edenStats_) {
+    // Reset the tickers as we go, so that each call reports what happened
+    // since the previous one.
+    edenStats_->increment(
+        &LocalStoreStats::blockCacheHit,
+        statistics_->getAndResetTickerCount(rocksdb::BLOCK_CACHE_HIT));
+    edenStats_->increment(
+        &LocalStoreStats::blockCacheMiss,
+        statistics_->getAndResetTickerCount(rocksdb::BLOCK_CACHE_MISS));
+    edenStats_->increment(
+        &LocalStoreStats::bloomFilterUseful,
+        statistics_->getAndResetTickerCount(rocksdb::BLOOM_FILTER_USEFUL));
+    edenStats_->increment(
+        &LocalStoreStats::stallTime,
+        statistics_->getAndResetTickerCount(rocksdb::STALL_MICROS));
+  }
+
+  fb303::fbData->setCounter(
+      folly::to<string>(statsPrefix_, "rocksdb.block_cache_usage"),
+      blockCache_->GetUsage());
+
+  auto handlesLock = getHandles();
+  auto& handles = handlesLock->handles;
+  uint64_t pendingCompactionBytes = 0;
+  if (handles->db->GetAggregatedIntProperty(
+          rocksdb::DB::Properties::kEstimatePendingCompactionBytes,
+          &pendingCompactionBytes)) {
+    fb303::fbData->setCounter(
+        folly::to<string>(statsPrefix_, "rocksdb.pending_compaction_bytes"),
+        pendingCompactionBytes);
+  }
+}
+
 // In the future it would perhaps be nicer to move the triggerAutoGC()
 // logic up into the LocalStore base class.  However, for now it is more
 // convenient to be able to use RocksDbLocalStore's ioPool_ to schedule the
@@ -723,7 +941,19 @@ void RocksDbLocalStore::triggerAutoGC(SizeSummary before) {
   ioPool_.add([store = getSharedFromThis(), before] {
     try {
       for (auto& ks : KeySpace::kAll) {
-        if (before.excessiveKeySpaces.test(ks->index)) {
+        if (!before.excessiveKeySpaces.test(ks->index)) {
+          continue;
+        }
+        if (!store->compactionScheduler_.waitUntilIdle()) {
+          XLOG(DBG2) << "local store garbage collection cancelled";
+          break;
+        }
+        if (ks == &KeySpace::BlobFamily) {
+          // Blobs make up most of the store. Clearing and compacting all of
+          // them at once rewrites gigabytes in one go and stalls the disk,
+          // and it throws away every cached blob.
+          store->evictIncrementally(ks, before.bytesToEvict[ks->index]);
+        } else {
           store->clearKeySpace(ks);
           store->compactKeySpace(ks);
         }
@@ -738,11 +968,117 @@ void RocksDbLocalStore::triggerAutoGC(SizeSummary before) {
   });
 }
 
+uint64_t RocksDbLocalStore::evictIncrementally(
+    KeySpace keySpace,
+    uint64_t bytesToEvict) {
+  uint64_t evicted = 0;
+  std::string nextKey;
+  while (evicted < bytesToEvict) {
+    if (!compactionScheduler_.waitUntilIdle()) {
+      break;
+    }
+    auto range = evictRange(
+        keySpace, nextKey, compactionScheduler_.getEvictionBatchSize());
+    evicted += range.bytes;
+    if (range.exhausted) {
+      break;
+    }
+    nextKey = std::move(range.nextKey);
+  }
+  XLOG(DBG2) << "evicted " << evicted << " bytes from " << keySpace->name;
+  fb303::fbData->incrementCounter(
+      folly::to<string>(statsPrefix_, "auto_gc.evicted_bytes"), evicted);
+  return evicted;
+}
+
+RocksDbLocalStore::EvictedRange RocksDbLocalStore::evictRange(
+    KeySpace keySpace,
+    const std::string& startKey,
+    uint64_t batchSize) {
+  auto handlesLock = getHandles();
+  auto& handles = handlesLock->handles;
+  auto columnFamily = handles->columns[keySpace->index].get();
+
+  EvictedRange result;
+  std::string endKey;
+  {
+    ReadOptions readOptions;
+    // Don't let the scan push the blocks that are in use out of the cache.
+    readOptions.fill_cache = false;
+    std::unique_ptr<rocksdb::Iterator> it{
+        handles->db->NewIterator(readOptions, columnFamily)};
+    for (it->Seek(startKey); it->Valid() && result.bytes < batchSize;
+         it->Next()) {
+      result.bytes += it->key().size() + it->value().size();
+    }
+    if (!it->status().ok()) {
+      throw RocksException::build(
+          it->status(),
+          "error scanning \"",
+          columnFamily->GetName(),
+          "\" column family");
+    }
+    if (it->Valid()) {
+      endKey = it->key().ToString();
+    } else {
+      std::string rangeStorage;
+      endKey = getFullRange(rangeStorage).limit.ToString();
+      result.exhausted = true;
+    }
+  }
+  if (result.bytes == 0) {
+    result.exhausted = true;
+    return result;
+  }
+
+  auto status = handles->db->DeleteRange(
+      WriteOptions{}, columnFamily, Slice{startKey}, Slice{endKey});
+  if (!status.ok()) {
+    throw RocksException::build(
+        status,
+        "error deleting data in \"",
+        columnFamily->GetName(),
+        "\" column family");
+  }
+
+  // Only compact the range that was just deleted, and unlike
+  // compactKeySpace(), wait for write stalls to clear first.
+  Slice begin{startKey};
+  Slice end{endKey};
+  status = handles->db->CompactRange(
+      rocksdb::CompactRangeOptions{}, columnFamily, &begin, &end);
+  if (!status.ok()) {
+    throw RocksException::build(
+        status,
+        "error compacting \"",
+        columnFamily->GetName(),
+        "\" column family");
+  }
+
+  result.nextKey = std::move(endKey);
+  return result;
+}
+
+void RocksDbLocalStore::updateRateLimit() {
+  auto rateLimit = compactionScheduler_.getRateLimit();
+  rateLimiter_->SetBytesPerSecond(
+      rateLimit == 0 || rateLimit > uint64_t(kUnlimitedCompactionRate)
+          ? kUnlimitedCompactionRate
+          : static_cast<int64_t>(rateLimit));
+}
+
 void RocksDbLocalStore::autoGCFinished(
     bool successful,
     uint64_t ephemeralSizeBefore) {
-  auto ephemeralSizeAfter =
-      computeStats(/*publish=*/false, /*config=*/nullptr).ephemeral;
+  uint64_t ephemeralSizeAfter = ephemeralSizeBefore;
+  try {
+    ephemeralSizeAfter =
+        computeStats(/*publish=*/false, /*config=*/nullptr).ephemeral;
+  } catch (const std::exception& ex) {
+    // The store may have been closed while garbage collection was running.
+    XLOG(WARN) << "unable to compute local store size after garbage "
+               << "collection: " << folly::exceptionStr(ex);
+  }
 
   auto state = autoGCState_.wlock();
   state->inProgress_ = false;
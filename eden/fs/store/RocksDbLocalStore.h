@@ -9,14 +9,23 @@
 
 #include <folly/CppAttributes.h>
 #include <folly/Synchronized.h>
+#include <array>
 #include <bitset>
+#include <functional>
 
 #include "eden/fs/rocksdb/RocksHandles.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/utils/UnboundedQueueExecutor.h"
 
+namespace rocksdb {
+class Cache;
+class RateLimiter;
+class Statistics;
+} // namespace rocksdb
+
 namespace facebook::eden {
 
+class EdenStats;
 class FaultInjector;
 class StructuredLogger;
 
@@ -25,15 +34,26 @@ class StructuredLogger;
  */
 class RocksDbLocalStore final : public LocalStore {
  public:
+  static constexpr size_t kDefaultBlockCacheSize = 72 * 1024 * 1024;
+
   /**
    * The given FaultInjector must be valid during the lifetime of this
    * RocksDbLocalStore object.
+   *
+   * All column families share a block cache of blockCacheSizeBytes. RocksDB's
+   * statistics are reported to edenStats, if set.
+   *
+   * Compaction output is rate limited and automatic garbage collection is
+   * paced according to the LocalStore's CompactionScheduler, which is
+   * configured by periodicManagementTask().
    */
   explicit RocksDbLocalStore(
       AbsolutePathPiece pathToRocksDb,
       std::shared_ptr<StructuredLogger> structuredLogger,
       FaultInjector* FOLLY_NONNULL faultInjector,
-      RocksDBOpenMode mode = RocksDBOpenMode::ReadWrite);
+      RocksDBOpenMode mode = RocksDBOpenMode::ReadWrite,
+      size_t blockCacheSizeBytes = kDefaultBlockCacheSize,
+      std::shared_ptr<EdenStats> edenStats = nullptr);
   void open() override;
   ~RocksDbLocalStore();
   void close() override;
@@ -47,14 +67,30 @@ class RocksDbLocalStore final : public LocalStore {
   void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
       override;
   std::unique_ptr<WriteBatch> beginWrite(size_t bufSize = 0) override;
+  /**
+   * Writes to the returned batch skip RocksDB's write-ahead log.
+   */
+  std::unique_ptr<WriteBatch> beginEphemeralWrite(size_t bufSize = 0) override;
 
   // Call RocksDB's RepairDB() function on the DB at the specified location
-  static void repairDB(AbsolutePathPiece path);
+  static void repairDB(
+      AbsolutePathPiece path,
+      std::shared_ptr<rocksdb::Cache> blockCache = nullptr);
 
   // Get the approximate number of bytes stored on disk for the
   // specified key space.
   uint64_t getApproximateSize(KeySpace keySpace) const;
 
+  /**
+   * Call fn with every key and value of the KeySpace, in key order. The byte
+   * ranges are only valid during the call. The scan doesn't populate the
+   * block cache.
+   */
+  void forEachValue(
+      KeySpace keySpace,
+      const std::function<void(folly::ByteRange key, folly::ByteRange value)>&
+          fn) const;
+
   void periodicManagementTask(const EdenConfig& config) override;
 
   enum class RockDbHandleStatus { NOT_YET_OPENED, OPEN, CLOSED };
@@ -109,6 +145,26 @@ class RocksDbLocalStore final : public LocalStore {
      * cleared.
      */
     std::bitset<KeySpace::kTotalCount> excessiveKeySpaces;
+    /**
+     * For the excessive keyspaces, how many bytes garbage collection should
+     * remove to get them back comfortably under their limit.
+     */
+    std::array<uint64_t, KeySpace::kTotalCount> bytesToEvict{};
+  };
+
+  struct EvictedRange {
+    /**
+     * Size of the keys and values that were deleted.
+     */
+    uint64_t bytes = 0;
+    /**
+     * Where the next range to evict starts.
+     */
+    std::string nextKey;
+    /**
+     * Whether the end of the keyspace was reached.
+     */
+    bool exhausted = false;
   };
 
   /**
@@ -117,16 +173,50 @@ class RocksDbLocalStore final : public LocalStore {
    */
   SizeSummary computeStats(bool publish, const EdenConfig* config);
 
+  /**
+   * Report what RocksDB's statistics recorded since the last call, and
+   * publish its block cache usage and compaction debt as fb303 counters.
+   */
+  void publishRocksDbStats();
+
+  /**
+   * Apply the CompactionScheduler's rate limit to RocksDB.
+   */
+  void updateRateLimit();
+
   void triggerAutoGC(SizeSummary before);
+
+  /**
+   * Delete keys from the start of keySpace until about bytesToEvict bytes of
+   * keys and values are gone, one bounded range at a time. Each range is
+   * compacted right after being deleted so that its space is reclaimed, and
+   * the CompactionScheduler is consulted between ranges. Returns the number
+   * of bytes deleted.
+   */
+  uint64_t evictIncrementally(KeySpace keySpace, uint64_t bytesToEvict);
+
+  /**
+   * Delete and compact the range of keys starting at startKey that holds
+   * about batchSize bytes.
+   */
+  EvictedRange evictRange(
+      KeySpace keySpace,
+      const std::string& startKey,
+      uint64_t batchSize);
+
   void autoGCFinished(bool successful, uint64_t ephemeralSizeBefore);
 
   std::shared_ptr<StructuredLogger> structuredLogger_;
+  std::shared_ptr<EdenStats> edenStats_;
   const std::string statsPrefix_{"local_store."};
   FaultInjector& faultInjector_;
   mutable UnboundedQueueExecutor ioPool_;
   folly::Synchronized<AutoGCState> autoGCState_;
   AbsolutePath pathToDb_;
   RocksDBOpenMode mode_;
+  const std::shared_ptr<rocksdb::Cache> blockCache_;
+  const std::shared_ptr<rocksdb::Statistics> statistics_;
+  const std::shared_ptr<rocksdb::RateLimiter> rateLimiter_;
   folly::Synchronized<RockDBState> dbHandles_;
 };
 
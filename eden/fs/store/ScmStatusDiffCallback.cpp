@@ -6,7 +6,14 @@
  */
 
 #include "eden/fs/store/ScmStatusDiffCallback.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+
 #include <folly/Synchronized.h>
+#include <folly/container/F14Map.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 #include "eden/fs/model/Tree.h"
@@ -16,32 +23,91 @@
 
 namespace facebook::eden {
 
-void ScmStatusDiffCallback::ignoredPath(RelativePathPiece path, dtype_t type) {
-  if (type != dtype_t::Dir) {
-    data_.wlock()->entries_ref()->emplace(
-        path.asString(), ScmFileStatus::IGNORED);
+namespace {
+// Identifies the State of a callback in the buffer cache of the threads.
+// Never reused, unlike the addresses of the States.
+std::atomic<uint64_t> nextCallbackId{1};
+} // namespace
+
+/**
+ * The paths reported by one thread. Only that thread writes to it, until
+ * extractStatus() reads it once the diff completed.
+ */
+struct ScmStatusDiffCallback::Buffer {
+  struct Entry {
+    const char* path;
+    uint32_t size;
+    ScmFileStatus status;
+
+    std::string_view getPath() const {
+      return std::string_view{path, size};
+    }
+  };
+
+  // The arena is carved out of blocks of this many bytes. Longer paths get a
+  // block of their own.
+  static constexpr size_t kBlockSize = 64 * 1024;
+
+  void add(std::string_view path, ScmFileStatus status) {
+    entries.push_back(
+        Entry{store(path), static_cast<uint32_t>(path.size()), status});
   }
+
+  const char* store(std::string_view path) {
+    if (path.size() > remaining) {
+      auto size = std::max(kBlockSize, path.size());
+      blocks.push_back(std::make_unique<char[]>(size));
+      next = blocks.back().get();
+      remaining = size;
+    }
+    auto* stored = next;
+    std::memcpy(stored, path.data(), path.size());
+    next += path.size();
+    remaining -= path.size();
+    return stored;
+  }
+
+  std::vector<Entry> entries;
+  std::vector<std::unique_ptr<char[]>> blocks;
+  char* next{nullptr};
+  size_t remaining{0};
+};
+
+struct ScmStatusDiffCallback::State {
+  const uint64_t id{nextCallbackId.fetch_add(1, std::memory_order_relaxed)};
+  folly::Synchronized<
+      folly::F14FastMap<std::thread::id, std::unique_ptr<Buffer>>,
+      std::mutex>
+      buffers;
+  // Errors are rare, they aren't worth a buffer.
+  folly::Synchronized<std::map<std::string, std::string>, std::mutex> errors;
+};
+
+ScmStatusDiffCallback::ScmStatusDiffCallback()
+    : state_{std::make_unique<State>()} {}
+
+ScmStatusDiffCallback::~ScmStatusDiffCallback() = default;
+
+ScmStatusDiffCallback::ScmStatusDiffCallback(ScmStatusDiffCallback&&) noexcept =
+    default;
+
+ScmStatusDiffCallback& ScmStatusDiffCallback::operator=(
+    ScmStatusDiffCallback&&) noexcept = default;
+
+void ScmStatusDiffCallback::ignoredPath(RelativePathPiece path, dtype_t type) {
+  addEntry(path, type, ScmFileStatus::IGNORED);
 }
 
 void ScmStatusDiffCallback::addedPath(RelativePathPiece path, dtype_t type) {
-  if (type != dtype_t::Dir) {
-    data_.wlock()->entries_ref()->emplace(
-        path.asString(), ScmFileStatus::ADDED);
-  }
+  addEntry(path, type, ScmFileStatus::ADDED);
 }
 
 void ScmStatusDiffCallback::removedPath(RelativePathPiece path, dtype_t type) {
-  if (type != dtype_t::Dir) {
-    data_.wlock()->entries_ref()->emplace(
-        path.asString(), ScmFileStatus::REMOVED);
-  }
+  addEntry(path, type, ScmFileStatus::REMOVED);
 }
 
 void ScmStatusDiffCallback::modifiedPath(RelativePathPiece path, dtype_t type) {
-  if (type != dtype_t::Dir) {
-    data_.wlock()->entries_ref()->emplace(
-        path.asString(), ScmFileStatus::MODIFIED);
-  }
+  addEntry(path, type, ScmFileStatus::MODIFIED);
 }
 
 void ScmStatusDiffCallback::diffError(
@@ -49,10 +115,40 @@ void ScmStatusDiffCallback::diffError(
     const folly::exception_wrapper& ew) {
   XLOG(WARNING) << "error computing status data for " << path << ": "
                 << folly::exceptionStr(ew);
-  data_.wlock()->errors_ref()->emplace(
+  state_->errors.lock()->emplace(
       path.asString(), folly::exceptionStr(ew).toStdString());
 }
 
+void ScmStatusDiffCallback::addEntry(
+    RelativePathPiece path,
+    dtype_t type,
+    ScmFileStatus status) {
+  if (type != dtype_t::Dir) {
+    getBuffer().add(path.view(), status);
+  }
+}
+
+ScmStatusDiffCallback::Buffer& ScmStatusDiffCallback::getBuffer() {
+  // The buffer of the callback this thread reported to last, so that only
+  // the first report of each thread to a callback takes the lock.
+  struct CachedBuffer {
+    uint64_t callbackId{0};
+    Buffer* buffer{nullptr};
+  };
+  static thread_local CachedBuffer cached;
+  if (cached.callbackId == state_->id) {
+    return *cached.buffer;
+  }
+
+  auto buffers = state_->buffers.lock();
+  auto& buffer = (*buffers)[std::this_thread::get_id()];
+  if (!buffer) {
+    buffer = std::make_unique<Buffer>();
+  }
+  cached = CachedBuffer{state_->id, buffer.get()};
+  return *buffer;
+}
+
 /**
  * Extract the ScmStatus object from this callback.
  *
@@ -61,8 +157,142 @@ void ScmStatusDiffCallback::diffError(
  * the diff operation has completed.
  */
 ScmStatus ScmStatusDiffCallback::extractStatus() {
-  auto data = data_.wlock();
-  return std::move(*data);
+  auto buffers = std::move(*state_->buffers.lock());
+
+  size_t count = 0;
+  for (const auto& [thread, buffer] : buffers) {
+    count += buffer->entries.size();
+  }
+  std::vector<Buffer::Entry> entries;
+  entries.reserve(count);
+  for (const auto& [thread, buffer] : buffers) {
+    entries.insert(
+        entries.end(), buffer->entries.begin(), buffer->entries.end());
+  }
+  std::stable_sort(
+      entries.begin(),
+      entries.end(),
+      [](const Buffer::Entry& lhs, const Buffer::Entry& rhs) {
+        return lhs.getPath() < rhs.getPath();
+      });
+
+  // Sorted, the entries are all appended at the end of the map. A path
+  // reported twice by a thread keeps the first of its statuses.
+  ScmStatus status;
+  auto& statusEntries = *status.entries_ref();
+  for (const auto& entry : entries) {
+    auto path = entry.getPath();
+    if (!statusEntries.empty() && statusEntries.rbegin()->first == path) {
+      continue;
+    }
+    statusEntries.emplace_hint(
+        statusEntries.end(), std::string{path}, entry.status);
+  }
+  status.errors_ref() = std::move(*state_->errors.lock());
+  return status;
+}
+
+ChunkedScmStatusDiffCallback::ChunkedScmStatusDiffCallback(
+    size_t chunkSize,
+    ChunkCallback onChunk)
+    : chunkSize_{std::max(chunkSize, size_t{1})},
+      onChunk_{std::move(onChunk)} {}
+
+void ChunkedScmStatusDiffCallback::ignoredPath(
+    RelativePathPiece path,
+    dtype_t type) {
+  addEntry(path, type, ScmFileStatus::IGNORED);
+}
+
+void ChunkedScmStatusDiffCallback::addedPath(
+    RelativePathPiece path,
+    dtype_t type) {
+  addEntry(path, type, ScmFileStatus::ADDED);
+}
+
+void ChunkedScmStatusDiffCallback::removedPath(
+    RelativePathPiece path,
+    dtype_t type) {
+  addEntry(path, type, ScmFileStatus::REMOVED);
+}
+
+void ChunkedScmStatusDiffCallback::modifiedPath(
+    RelativePathPiece path,
+    dtype_t type) {
+  addEntry(path, type, ScmFileStatus::MODIFIED);
+}
+
+void ChunkedScmStatusDiffCallback::diffError(
+    RelativePathPiece path,
+    const folly::exception_wrapper& ew) {
+  XLOG(WARNING) << "error computing status data for " << path << ": "
+                << folly::exceptionStr(ew);
+  std::optional<ScmStatus> chunk;
+  {
+    auto state = state_.lock();
+    if (!state->pending.errors_ref()
+             ->emplace(path.asString(), folly::exceptionStr(ew).toStdString())
+             .second) {
+      return;
+    }
+    ++state->errorCount;
+    chunk = takeChunk(*state);
+  }
+  if (chunk) {
+    onChunk_(std::move(*chunk));
+  }
+}
+
+void ChunkedScmStatusDiffCallback::addEntry(
+    RelativePathPiece path,
+    dtype_t type,
+    ScmFileStatus status) {
+  if (type == dtype_t::Dir) {
+    return;
+  }
+  std::optional<ScmStatus> chunk;
+  {
+    auto state = state_.lock();
+    auto& entries = *state->pending.entries_ref();
+    if (!entries.emplace(path.asString(), status).second) {
+      return;
+    }
+    ++state->entryCount;
+    chunk = takeChunk(*state);
+  }
+  if (chunk) {
+    onChunk_(std::move(*chunk));
+  }
+}
+
+std::optional<ScmStatus> ChunkedScmStatusDiffCallback::takeChunk(
+    State& state) {
+  if (++state.pendingCount < chunkSize_) {
+    return std::nullopt;
+  }
+  state.pendingCount = 0;
+  return std::exchange(state.pending, ScmStatus{});
+}
+
+void ChunkedScmStatusDiffCallback::flush() {
+  ScmStatus chunk;
+  {
+    auto state = state_.lock();
+    if (state->pendingCount == 0) {
+      return;
+    }
+    state->pendingCount = 0;
+    chunk = std::exchange(state->pending, ScmStatus{});
+  }
+  onChunk_(std::move(chunk));
+}
+
+size_t ChunkedScmStatusDiffCallback::getEntryCount() const {
+  return state_.lock()->entryCount;
+}
+
+size_t ChunkedScmStatusDiffCallback::getErrorCount() const {
+  return state_.lock()->errorCount;
 }
 
 char scmStatusCodeChar(ScmFileStatus code) {
@@ -8,7 +8,11 @@
 #pragma once
 #include <iosfwd>
 
+#include <folly/Function.h>
 #include <folly/Synchronized.h>
+#include <memory>
+#include <mutex>
+#include <optional>
 
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/service/gen-cpp2/eden_types.h"
@@ -22,8 +26,22 @@ class Future;
 
 namespace facebook::eden {
 
+/**
+ * Accumulates the whole status of a diff.
+ *
+ * The diff reports its paths from many threads at once. Each thread appends
+ * them to a buffer of its own, without locking, with the path bytes packed in
+ * an arena, and the buffers are merged and sorted once by extractStatus().
+ * A path costs its bytes plus a few words until then, instead of a string and
+ * a map node, and only the first report of each thread takes a lock.
+ */
 class ScmStatusDiffCallback : public DiffCallback {
  public:
+  ScmStatusDiffCallback();
+  ~ScmStatusDiffCallback() override;
+  ScmStatusDiffCallback(ScmStatusDiffCallback&&) noexcept;
+  ScmStatusDiffCallback& operator=(ScmStatusDiffCallback&&) noexcept;
+
   void ignoredPath(RelativePathPiece path, dtype_t type) override;
   void addedPath(RelativePathPiece path, dtype_t type) override;
   void removedPath(RelativePathPiece path, dtype_t type) override;
@@ -42,7 +60,67 @@ class ScmStatusDiffCallback : public DiffCallback {
   ScmStatus extractStatus();
 
  private:
-  folly::Synchronized<ScmStatus> data_;
+  struct Buffer;
+  struct State;
+
+  void addEntry(RelativePathPiece path, dtype_t type, ScmFileStatus status);
+
+  /**
+   * The buffer of the calling thread, created on its first call.
+   */
+  Buffer& getBuffer();
+
+  std::unique_ptr<State> state_;
+};
+
+/**
+ * Hands the differences over in ScmStatus chunks of chunkSize entries and
+ * errors, as they are found, rather than accumulating the whole status.
+ *
+ * onChunk is called outside of any lock, and possibly from several threads
+ * at once.
+ */
+class ChunkedScmStatusDiffCallback : public DiffCallback {
+ public:
+  using ChunkCallback = folly::Function<void(ScmStatus&&) const>;
+
+  ChunkedScmStatusDiffCallback(size_t chunkSize, ChunkCallback onChunk);
+
+  void ignoredPath(RelativePathPiece path, dtype_t type) override;
+  void addedPath(RelativePathPiece path, dtype_t type) override;
+  void removedPath(RelativePathPiece path, dtype_t type) override;
+  void modifiedPath(RelativePathPiece path, dtype_t type) override;
+
+  void diffError(RelativePathPiece path, const folly::exception_wrapper& ew)
+      override;
+
+  /**
+   * Hand over the differences still pending, once the diff completed.
+   */
+  void flush();
+
+  /** The number of entries and errors found so far. */
+  size_t getEntryCount() const;
+  size_t getErrorCount() const;
+
+ private:
+  struct State {
+    ScmStatus pending;
+    size_t pendingCount{0};
+    size_t entryCount{0};
+    size_t errorCount{0};
+  };
+
+  void addEntry(RelativePathPiece path, dtype_t type, ScmFileStatus status);
+
+  /**
+   * Take the pending differences out if they fill a chunk.
+   */
+  std::optional<ScmStatus> takeChunk(State& state);
+
+  const size_t chunkSize_;
+  const ChunkCallback onChunk_;
+  folly::Synchronized<State, std::mutex> state_;
 };
 
 /**
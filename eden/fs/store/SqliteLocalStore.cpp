@@ -7,6 +7,7 @@
 
 #include "eden/fs/store/SqliteLocalStore.h"
 
+#include <folly/Conv.h>
 #include <folly/String.h>
 #include <folly/container/Array.h>
 #include <folly/logging/xlog.h>
@@ -100,8 +101,19 @@ class SqliteWriteBatch : public LocalStore::WriteBatch {
 
 } // namespace
 
-SqliteLocalStore::SqliteLocalStore(AbsolutePathPiece pathToDb)
-    : db_(pathToDb, SqliteDatabase::DelayOpeningDB{}) {}
+namespace {
+std::string selectValueQuery(KeySpace keySpace) {
+  return folly::to<string>(
+      "select value from ", keySpace->name, " where key = ?");
+}
+} // namespace
+
+SqliteLocalStore::SqliteLocalStore(
+    AbsolutePathPiece pathToDb,
+    size_t readConnections)
+    : pathToDb_(pathToDb.copy()),
+      readConnections_(readConnections),
+      db_(pathToDb, SqliteDatabase::DelayOpeningDB{}) {}
 
 void SqliteLocalStore::open() {
   db_.openDb();
@@ -126,13 +138,41 @@ void SqliteLocalStore::open() {
     }
   }
 
+  // The read connections need the tables and the WAL to exist already.
+  auto pool =
+      std::make_shared<SqliteConnectionPool>(pathToDb_, readConnections_);
+  {
+    auto readers = readers_.wlock();
+    if (readers->closed) {
+      pool->close();
+      throw std::runtime_error("SqliteLocalStore closed while opening");
+    }
+    readers->pool = std::move(pool);
+  }
+
   clearDeprecatedKeySpaces();
 }
 
 void SqliteLocalStore::close() {
+  {
+    auto readers = readers_.wlock();
+    readers->closed = true;
+    if (readers->pool) {
+      readers->pool->close();
+    }
+  }
   db_.close();
 }
 
+SqliteConnectionPool::Lease SqliteLocalStore::acquireReader() const {
+  auto pool = readers_.rlock()->pool;
+  if (!pool) {
+    throw std::runtime_error(
+        "the SqliteLocalStore database has not yet been opened");
+  }
+  return pool->acquire();
+}
+
 void SqliteLocalStore::clearKeySpace(KeySpace keySpace) {
   auto db = db_.lock();
 
@@ -143,30 +183,51 @@ void SqliteLocalStore::clearKeySpace(KeySpace keySpace) {
 void SqliteLocalStore::compactKeySpace(KeySpace) {}
 
 StoreResult SqliteLocalStore::get(KeySpace keySpace, ByteRange key) const {
-  auto db = db_.lock();
-
-  SqliteStatement stmt(
-      db, "select value from ", keySpace->name, " where key = ?");
+  auto reader = acquireReader();
+  auto stmt = reader.statement(selectValueQuery(keySpace));
 
   // Bind the key; parameters are 1-based
-  stmt.bind(1, key);
+  stmt->bind(1, key);
 
-  if (stmt.step()) {
+  if (stmt->step()) {
     // Return the result; columns are 0-based!
-    return StoreResult(stmt.columnBlob(0).str());
+    return StoreResult(stmt->columnBlob(0).str());
   }
 
   // the key does not exist
   return StoreResult::missing(keySpace, key);
 }
 
-bool SqliteLocalStore::hasKey(KeySpace keySpace, ByteRange key) const {
-  auto db = db_.lock();
+folly::Future<std::vector<StoreResult>> SqliteLocalStore::getBatch(
+    KeySpace keySpace,
+    const std::vector<folly::ByteRange>& keys) const {
+  return folly::makeFutureWith([&] {
+    // A single connection serves the whole batch, reusing one prepared
+    // statement for all the keys.
+    auto reader = acquireReader();
+    auto query = selectValueQuery(keySpace);
+    std::vector<StoreResult> results;
+    results.reserve(keys.size());
+    for (const auto& key : keys) {
+      auto stmt = reader.statement(query);
+      stmt->bind(1, key);
+      if (stmt->step()) {
+        results.emplace_back(stmt->columnBlob(0).str());
+      } else {
+        results.emplace_back(StoreResult::missing(keySpace, key));
+      }
+    }
+    return results;
+  });
+}
 
-  SqliteStatement stmt(db, "select 1 from ", keySpace->name, " where key = ?");
+bool SqliteLocalStore::hasKey(KeySpace keySpace, ByteRange key) const {
+  auto reader = acquireReader();
+  auto stmt = reader.statement(
+      folly::to<string>("select 1 from ", keySpace->name, " where key = ?"));
 
-  stmt.bind(1, key);
-  return stmt.step();
+  stmt->bind(1, key);
+  return stmt->step();
 }
 
 void SqliteLocalStore::put(KeySpace keySpace, ByteRange key, ByteRange value) {
@@ -7,6 +7,8 @@
 
 #pragma once
 #include <folly/Synchronized.h>
+#include <memory>
+#include "eden/fs/sqlite/SqliteConnectionPool.h"
 #include "eden/fs/sqlite/SqliteDatabase.h"
 #include "eden/fs/store/LocalStore.h"
 
@@ -15,23 +17,44 @@ namespace facebook::eden {
 /** An implementation of LocalStore that stores values in Sqlite.
  * SqliteLocalStore is thread safe, allowing reads and writes from
  * any thread.
+ *
+ * Writes go through a single connection. Reads are spread over a pool of
+ * read-only connections so that they can run concurrently with each other
+ * and with writes, which the database's WAL journal allows.
  * */
 class SqliteLocalStore final : public LocalStore {
  public:
-  explicit SqliteLocalStore(AbsolutePathPiece pathToDb);
+  static constexpr size_t kDefaultReadConnections = 4;
+
+  explicit SqliteLocalStore(
+      AbsolutePathPiece pathToDb,
+      size_t readConnections = kDefaultReadConnections);
   void open() override;
   void close() override;
   void clearKeySpace(KeySpace keySpace) override;
   void compactKeySpace(KeySpace keySpace) override;
   StoreResult get(KeySpace keySpace, folly::ByteRange key) const override;
   bool hasKey(KeySpace keySpace, folly::ByteRange key) const override;
+  FOLLY_NODISCARD folly::Future<std::vector<StoreResult>> getBatch(
+      KeySpace keySpace,
+      const std::vector<folly::ByteRange>& keys) const override;
   void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
       override;
   std::unique_ptr<LocalStore::WriteBatch> beginWrite(
       size_t bufSize = 0) override;
 
  private:
+  struct Readers {
+    std::shared_ptr<SqliteConnectionPool> pool;
+    bool closed = false;
+  };
+
+  SqliteConnectionPool::Lease acquireReader() const;
+
+  const AbsolutePath pathToDb_;
+  const size_t readConnections_;
   mutable SqliteDatabase db_;
+  folly::Synchronized<Readers> readers_;
 };
 
 } // namespace facebook::eden
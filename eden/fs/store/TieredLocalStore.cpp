@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/TieredLocalStore.h"
+
+#include <folly/futures/Future.h>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/store/StoreResult.h"
+
+namespace facebook::eden {
+
+TieredLocalStore::TieredLocalStore(
+    std::shared_ptr<LocalStore> hot,
+    std::shared_ptr<LocalStore> cold)
+    : hot_{std::move(hot)}, cold_{std::move(cold)} {}
+
+void TieredLocalStore::open() {
+  cold_->open();
+  hot_->open();
+}
+
+void TieredLocalStore::close() {
+  hot_->close();
+  cold_->close();
+}
+
+void TieredLocalStore::clearKeySpace(KeySpace keySpace) {
+  hot_->clearKeySpace(keySpace);
+}
+
+void TieredLocalStore::compactKeySpace(KeySpace keySpace) {
+  hot_->compactKeySpace(keySpace);
+}
+
+StoreResult TieredLocalStore::get(KeySpace keySpace, folly::ByteRange key)
+    const {
+  auto result = cold_->get(keySpace, key);
+  if (result.isValid()) {
+    return result;
+  }
+  return hot_->get(keySpace, key);
+}
+
+folly::Future<std::vector<StoreResult>> TieredLocalStore::getBatch(
+    KeySpace keySpace,
+    const std::vector<folly::ByteRange>& keys) const {
+  return cold_->getBatch(keySpace, keys)
+      .thenValue([this, keySpace, keys](std::vector<StoreResult>&& results) {
+        // Look up what the cold store doesn't have in the hot store.
+        std::vector<size_t> missingIndexes;
+        std::vector<folly::ByteRange> missingKeys;
+        for (size_t i = 0; i < results.size(); ++i) {
+          if (!results[i].isValid()) {
+            missingIndexes.push_back(i);
+            missingKeys.push_back(keys[i]);
+          }
+        }
+        if (missingKeys.empty()) {
+          return folly::makeFuture(std::move(results));
+        }
+        return hot_->getBatch(keySpace, missingKeys)
+            .thenValue([results = std::move(results),
+                        missingIndexes = std::move(missingIndexes)](
+                           std::vector<StoreResult>&& hotResults) mutable {
+              for (size_t i = 0; i < hotResults.size(); ++i) {
+                results[missingIndexes[i]] = std::move(hotResults[i]);
+              }
+              return std::move(results);
+            });
+      });
+}
+
+bool TieredLocalStore::hasKey(KeySpace keySpace, folly::ByteRange key) const {
+  return cold_->hasKey(keySpace, key) || hot_->hasKey(keySpace, key);
+}
+
+void TieredLocalStore::put(
+    KeySpace keySpace,
+    folly::ByteRange key,
+    folly::ByteRange value) {
+  hot_->put(keySpace, key, value);
+}
+
+std::unique_ptr<LocalStore::WriteBatch> TieredLocalStore::beginWrite(
+    size_t bufSize) {
+  return hot_->beginWrite(bufSize);
+}
+
+std::unique_ptr<LocalStore::WriteBatch> TieredLocalStore::beginEphemeralWrite(
+    size_t bufSize) {
+  return hot_->beginEphemeralWrite(bufSize);
+}
+
+void TieredLocalStore::periodicManagementTask(const EdenConfig& config) {
+  // putBlob() checks the flag of the store it is called on.
+  enableBlobCaching.store(
+      config.enableBlobCaching.getValue(), std::memory_order_relaxed);
+  hot_->periodicManagementTask(config);
+}
+
+CompactionScheduler& TieredLocalStore::getCompactionScheduler() {
+  return hot_->getCompactionScheduler();
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "eden/fs/store/LocalStore.h"
+
+namespace facebook::eden {
+
+/**
+ * A LocalStore that looks values up in a read-only cold store before its
+ * writable hot store.
+ *
+ * The cold store is typically a PackLocalStore opened read-only on packs that
+ * are built ahead of time from a populated store with `eden_store_util
+ * build_pack`, and shared by several hosts. All writes, clears and
+ * maintenance go to the hot store only.
+ */
+class TieredLocalStore final : public LocalStore {
+ public:
+  TieredLocalStore(
+      std::shared_ptr<LocalStore> hot,
+      std::shared_ptr<LocalStore> cold);
+
+  void open() override;
+  void close() override;
+  void clearKeySpace(KeySpace keySpace) override;
+  void compactKeySpace(KeySpace keySpace) override;
+  StoreResult get(KeySpace keySpace, folly::ByteRange key) const override;
+  FOLLY_NODISCARD folly::Future<std::vector<StoreResult>> getBatch(
+      KeySpace keySpace,
+      const std::vector<folly::ByteRange>& keys) const override;
+  bool hasKey(KeySpace keySpace, folly::ByteRange key) const override;
+  void put(KeySpace keySpace, folly::ByteRange key, folly::ByteRange value)
+      override;
+  std::unique_ptr<WriteBatch> beginWrite(size_t bufSize = 0) override;
+  std::unique_ptr<WriteBatch> beginEphemeralWrite(size_t bufSize = 0) override;
+
+  void periodicManagementTask(const EdenConfig& config) override;
+
+  CompactionScheduler& getCompactionScheduler() override;
+
+ private:
+  const std::shared_ptr<LocalStore> hot_;
+  const std::shared_ptr<LocalStore> cold_;
+};
+
+} // namespace facebook::eden
@@ -11,14 +11,14 @@
 
 namespace facebook::eden {
 std::shared_ptr<const Tree> TreeCache::get(const ObjectId& hash) {
-  if (config_->getEdenConfig()->enableInMemoryTreeCaching.getValue()) {
+  if (config_->getSnapshot().enableInMemoryTreeCaching.getValue()) {
     return getSimple(hash);
   }
   return std::shared_ptr<const Tree>{nullptr};
 }
 
 void TreeCache::insert(std::shared_ptr<const Tree> tree) {
-  if (config_->getEdenConfig()->enableInMemoryTreeCaching.getValue()) {
+  if (config_->getSnapshot().enableInMemoryTreeCaching.getValue()) {
     return insertSimple(tree);
   }
 }
@@ -26,7 +26,10 @@ void TreeCache::insert(std::shared_ptr<const Tree> tree) {
 TreeCache::TreeCache(std::shared_ptr<ReloadableConfig> config)
       : ObjectCache<Tree, ObjectCacheFlavor::Simple>{
             config->getEdenConfig()->inMemoryTreeCacheSize.getValue(),
-            config->getEdenConfig()->inMemoryTreeCacheMinElements.getValue()},
+            config->getEdenConfig()->inMemoryTreeCacheMinElements.getValue(),
+            config->getEdenConfig()->inMemoryTreeCacheShardCount.getValue(),
+            config->getEdenConfig()
+                ->inMemoryTreeCacheEvictionPolicy.getValue()},
         config_{config} {}
 
 } // namespace facebook::eden
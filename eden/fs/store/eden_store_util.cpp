@@ -9,6 +9,7 @@
 #include <memory>
 #include <optional>
 
+#include <boost/filesystem.hpp>
 #include <folly/Range.h>
 #include <folly/String.h>
 #include <folly/container/Array.h>
@@ -23,6 +24,7 @@
 #include "eden/fs/service/EdenInit.h"
 #include "eden/fs/service/EdenStateDir.h"
 #include "eden/fs/store/KeySpace.h"
+#include "eden/fs/store/PackLocalStore.h"
 #include "eden/fs/store/RocksDbLocalStore.h"
 #include "eden/fs/telemetry/NullStructuredLogger.h"
 #include "eden/fs/utils/FaultInjector.h"
@@ -37,6 +39,10 @@ using std::optional;
 FOLLY_INIT_LOGGING_CONFIG("eden=DBG2; default:async=true");
 
 DEFINE_string(keySpace, "", "operate on just a single key space");
+DEFINE_string(
+    packOutput,
+    "",
+    "directory to write the packs built by build_pack to; must not exist");
 
 namespace {
 
@@ -206,13 +212,72 @@ class ShowSizesCommand : public Command {
   }
 };
 
+class BuildPackCommand : public Command {
+ public:
+  static constexpr auto name = StringPiece("build_pack");
+  static constexpr auto help = StringPiece(
+      "Build read-only packs of the trees, blob metadata and proxy hashes of "
+      "the store into --packOutput, for use with store:shared-pack-path");
+
+  void run() override {
+    if (FLAGS_packOutput.empty()) {
+      throw ArgumentError("--packOutput must be specified");
+    }
+    auto output = canonicalPath(FLAGS_packOutput);
+    if (boost::filesystem::exists(output.asString())) {
+      throw ArgumentError(
+          fmt::format(FMT_STRING("{} already exists"), output.view()));
+    }
+
+    std::vector<KeySpace> keySpaces;
+    if (auto keySpace = getKeySpace()) {
+      keySpaces.push_back(*keySpace);
+    } else {
+      keySpaces = {
+          KeySpace::TreeFamily,
+          KeySpace::BlobMetaDataFamily,
+          KeySpace::HgProxyHashFamily};
+    }
+
+    auto localStore = openLocalStore(RocksDBOpenMode::ReadOnly);
+
+    // Build next to the destination and move the result into place at the
+    // end, so that readers never see a partial set of packs.
+    auto building = AbsolutePath{output.asString() + ".tmp"};
+    removeRecursively(building);
+    {
+      PackLocalStore packs{building};
+      packs.open();
+      for (const auto& ks : keySpaces) {
+        folly::stop_watch<std::chrono::milliseconds> watch;
+        uint64_t count = 0;
+        localStore->forEachValue(
+            ks, [&](folly::ByteRange key, folly::ByteRange value) {
+              packs.put(ks, key, value);
+              ++count;
+            });
+        XLOG(INFO) << "Packed " << count << " values of " << ks->name << " ("
+                   << folly::prettyPrint(
+                          packs.getApproximateSize(ks),
+                          folly::PRETTY_BYTES_METRIC)
+                   << ") in " << (watch.elapsed().count() / 1000.0)
+                   << " seconds.";
+      }
+      packs.close();
+    }
+    renameWithAbsolutePath(building, output);
+    XLOG(INFO) << "Wrote packs to " << output;
+  }
+};
+
 std::unique_ptr<Command> createCommand(StringPiece name) {
   auto commands = make_array<std::unique_ptr<CommandFactory>>(
       make_unique<CommandFactoryT<GcCommand>>(),
       make_unique<CommandFactoryT<ClearCommand>>(),
       make_unique<CommandFactoryT<CompactCommand>>(),
       make_unique<CommandFactoryT<RepairCommand>>(),
-      make_unique<CommandFactoryT<ShowSizesCommand>>());
+      make_unique<CommandFactoryT<ShowSizesCommand>>(),
+      make_unique<CommandFactoryT<BuildPackCommand>>());
 
   std::unique_ptr<Command> command;
   for (const auto& factory : commands) {
@@ -241,6 +306,11 @@ int main(int argc, char** argv) {
     return EX_SOFTWARE;
   }
 
-  command->run();
+  try {
+    command->run();
+  } catch (const ArgumentError& ex) {
+    fprintf(stderr, "error: %s\n", ex.what());
+    return EX_USAGE;
+  }
   return 0;
 }
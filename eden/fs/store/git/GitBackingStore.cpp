@@ -12,6 +12,7 @@
 #include <folly/logging/xlog.h>
 #include <git2.h>
 
+#include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/Tree.h"
@@ -50,14 +51,45 @@ void freeBlobIOBufData(void* /*blobData*/, void* blobObject) {
   git_blob_free(gitBlob);
 }
 
+/**
+ * Applies the [git] settings to libgit2. They are process wide, hence the
+ * last Git checkout to be mounted decides for all of them.
+ */
+void configureLibgit2(const EdenConfig& config) {
+  if (auto size = config.gitPackWindowSize.getValue()) {
+    gitCheckError(
+        git_libgit2_opts(GIT_OPT_SET_MWINDOW_SIZE, size),
+        "error setting the git pack window size");
+  }
+  if (auto limit = config.gitPackMappedLimit.getValue()) {
+    gitCheckError(
+        git_libgit2_opts(GIT_OPT_SET_MWINDOW_MAPPED_LIMIT, limit),
+        "error setting the git pack mapped limit");
+  }
+  if (auto size = config.gitObjectCacheSize.getValue()) {
+    gitCheckError(
+        git_libgit2_opts(
+            GIT_OPT_SET_CACHE_MAX_SIZE, static_cast<ssize_t>(size)),
+        "error setting the git object cache size");
+  }
+  gitCheckError(
+      git_libgit2_opts(
+          GIT_OPT_ENABLE_STRICT_HASH_VERIFICATION,
+          config.gitVerifyObjectHashes.getValue() ? 1 : 0),
+      "error setting the git object hash verification");
+}
+
 } // namespace
 
-GitBackingStore::GitBackingStore(AbsolutePathPiece repository) {
+GitBackingStore::GitBackingStore(
+    AbsolutePathPiece repository,
+    const EdenConfig& config) {
   // Make sure libgit2 is initialized.
   // (git_libgit2_init() is safe to call multiple times if multiple
   // GitBackingStore objects are created.  git_libgit2_shutdown() should be
   // called once for each call to git_libgit2_init().)
   git_libgit2_init();
+  configureLibgit2(config);
 
   auto error =
       git_repository_open(&repo_, std::string{repository.value()}.c_str());
@@ -140,6 +172,7 @@ unique_ptr<Tree> GitBackingStore::getTreeImpl(const ObjectId& id) {
 
   Tree::container entries{kPathMapDefaultCaseSensitive};
   size_t numEntries = git_tree_entrycount(gitTree);
+  entries.reserve(numEntries);
   for (size_t i = 0; i < numEntries; ++i) {
     auto gitEntry = git_tree_entry_byindex(gitTree, i);
     auto entryMode = git_tree_entry_filemode(gitEntry);
@@ -18,6 +18,8 @@ struct git_repository;
 
 namespace facebook::eden {
 
+class EdenConfig;
+
 /**
  * A BackingStore implementation that loads data out of a git repository.
  */
@@ -29,8 +31,11 @@ class GitBackingStore final : public BijectiveBackingStore {
    * The LocalStore object is owned by the EdenServer (which also owns this
    * GitBackingStore object).  It is guaranteed to be valid for the lifetime of
    * the GitBackingStore object.
+   *
+   * The [git] settings of config tune how libgit2 reads the packfiles of the
+   * repository.
    */
-  explicit GitBackingStore(AbsolutePathPiece repository);
+  GitBackingStore(AbsolutePathPiece repository, const EdenConfig& config);
   ~GitBackingStore() override;
 
   /**
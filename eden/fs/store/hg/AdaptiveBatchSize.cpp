@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/AdaptiveBatchSize.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+AdaptiveBatchSize::AdaptiveBatchSize(size_t initialSize)
+    : size_{std::max<size_t>(initialSize, 1)} {}
+
+size_t AdaptiveBatchSize::record(
+    const Sample& sample,
+    Duration targetLatency,
+    size_t maxSize) {
+  std::optional<Duration> p99;
+  {
+    auto window = window_.lock();
+    for (auto latency : sample.highPriorityLatencies) {
+      window->latencies[window->recorded % kWindowSize] = latency;
+      ++window->recorded;
+    }
+    p99 = computeP99(*window);
+  }
+
+  auto current = size_.load(std::memory_order_relaxed);
+  // Move by a quarter of the current size, so that the batch size converges
+  // in a few batches whether it is 1 or 1000.
+  auto step = std::max<size_t>(current / 4, 1);
+  auto next = current;
+  if (sample.averageQueueWait > sample.fetchLatency) {
+    if (p99 && *p99 > targetLatency) {
+      next = current > step ? current - step : 1;
+    }
+  } else if (sample.size >= current) {
+    // A batch smaller than the batch size means the queue was drained, a
+    // larger batch wouldn't have fetched more.
+    next = current + step;
+  }
+  next = std::clamp<size_t>(next, 1, std::max<size_t>(maxSize, 1));
+  size_.store(next, std::memory_order_relaxed);
+  return next;
+}
+
+std::optional<AdaptiveBatchSize::Duration>
+AdaptiveBatchSize::getHighPriorityP99() const {
+  return computeP99(*window_.lock());
+}
+
+std::optional<AdaptiveBatchSize::Duration> AdaptiveBatchSize::computeP99(
+    const Window& window) {
+  auto count = std::min(window.recorded, kWindowSize);
+  if (count < kMinSamples) {
+    return std::nullopt;
+  }
+  std::array<Duration, kWindowSize> latencies;
+  std::copy_n(window.latencies.begin(), count, latencies.begin());
+  auto p99 = latencies.begin() + (count * 99) / 100;
+  std::nth_element(latencies.begin(), p99, latencies.begin() + count);
+  return *p99;
+}
+
+} // namespace facebook::eden
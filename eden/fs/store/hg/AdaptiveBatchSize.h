@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * Picks how many import requests of one type an HgQueuedBackingStore worker
+ * fetches at once, from how the previous batches behaved.
+ *
+ * A batch costs roughly one remote round trip, so while fetching dominates
+ * the latency of requests and the workers keep dequeuing full batches,
+ * growing the batch drains the queue with fewer round trips. Larger batches
+ * however take longer to complete, and the requests queued behind them wait
+ * longer: when the time requests spend queued dominates and the p99 latency
+ * of the high-priority requests exceeds the target, the batch shrinks.
+ *
+ * Thread-safe.
+ */
+class AdaptiveBatchSize {
+ public:
+  using Duration = std::chrono::steady_clock::duration;
+
+  /**
+   * What happened to a batch of requests.
+   */
+  struct Sample {
+    /**
+     * Number of requests in the batch.
+     */
+    size_t size = 0;
+
+    /**
+     * How long the batch took to fetch.
+     */
+    Duration fetchLatency{};
+
+    /**
+     * Average time the requests of the batch spent in the queue.
+     */
+    Duration averageQueueWait{};
+
+    /**
+     * End-to-end latency, queue wait included, of each high-priority request
+     * in the batch.
+     */
+    std::vector<Duration> highPriorityLatencies;
+  };
+
+  explicit AdaptiveBatchSize(size_t initialSize);
+
+  /**
+   * The number of requests the next batch should hold.
+   */
+  size_t get() const {
+    return size_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Adjust the batch size from the outcome of a batch, within [1, maxSize].
+   * Returns the new batch size.
+   */
+  size_t record(const Sample& sample, Duration targetLatency, size_t maxSize);
+
+  /**
+   * p99 of the recent high-priority request latencies, or std::nullopt when
+   * too few have been recorded to tell.
+   */
+  std::optional<Duration> getHighPriorityP99() const;
+
+  /**
+   * Number of recent high-priority latencies the p99 is computed over.
+   */
+  static constexpr size_t kWindowSize = 256;
+
+  /**
+   * The p99 isn't acted upon until this many latencies were recorded.
+   */
+  static constexpr size_t kMinSamples = 32;
+
+ private:
+  struct Window {
+    std::array<Duration, kWindowSize> latencies{};
+    // Total number of latencies ever recorded. The next one goes to
+    // latencies[recorded % kWindowSize].
+    size_t recorded = 0;
+  };
+
+  static std::optional<Duration> computeP99(const Window& window);
+
+  std::atomic<size_t> size_;
+  folly::Synchronized<Window, std::mutex> window_;
+};
+
+} // namespace facebook::eden
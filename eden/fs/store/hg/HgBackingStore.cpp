@@ -509,6 +509,10 @@ folly::Future<folly::Unit> HgBackingStore::importTreeManifestForRoot(
               return folly::unit;
             }
 
+            if (config_->getEdenConfig()->nativeManifestImport.getValue()) {
+              return importTreeManifestForRootNative(commitId, manifestId);
+            }
+
             return importTreeManifestImpl(manifestId)
                 .thenValue([this, commitId, manifestId](
                                std::unique_ptr<Tree> rootTree) {
@@ -524,6 +528,39 @@ folly::Future<folly::Unit> HgBackingStore::importTreeManifestForRoot(
           });
 }
 
+folly::Future<folly::Unit> HgBackingStore::importTreeManifestForRootNative(
+    const ObjectId& commitId,
+    const Hash20& manifestId) {
+  return folly::via(serverThreadPool_, [this, commitId, manifestId] {
+    folly::stop_watch<std::chrono::milliseconds> watch;
+    auto rootTreeId = makeRootTreeId(manifestId);
+    auto rootTree =
+        datapackStore_.getTree(RelativePath{}, manifestId, rootTreeId);
+    if (!rootTree) {
+      throwf<std::domain_error>(
+          "root manifest {} of commit {} not found",
+          manifestId.toString(),
+          commitId.asHexString());
+    }
+
+    // The entries of the root tree embed their proxy hash, so the tree and
+    // the commit mapping are all that needs to be written.
+    auto writeBatch = localStore_->beginWrite();
+    writeBatch->putTree(*rootTree);
+    writeBatch->put(
+        KeySpace::HgCommitToTreeFamily,
+        commitId,
+        rootTree->getHash().getBytes());
+    writeBatch->flush();
+
+    stats_->addDuration(
+        &HgBackingStoreStats::importManifestForRoot, watch.elapsed());
+    XLOG(DBG3) << "natively imported mercurial commit " << commitId
+               << " with manifest " << manifestId << " as tree "
+               << rootTree->getHash();
+  });
+}
+
 folly::Future<std::unique_ptr<Tree>> HgBackingStore::importTreeManifest(
     const ObjectId& commitId) {
   return folly::via(
@@ -540,8 +577,7 @@ folly::Future<std::unique_ptr<Tree>> HgBackingStore::importTreeManifest(
       });
 }
 
-folly::Future<std::unique_ptr<Tree>> HgBackingStore::importTreeManifestImpl(
-    Hash20 manifestNode) {
+ObjectId HgBackingStore::makeRootTreeId(const Hash20& manifestNode) {
   // Record that we are at the root for this node
   RelativePathPiece path{};
   auto hgObjectIdFormat = config_->getEdenConfig()->hgObjectIdFormat.getValue();
@@ -558,7 +594,13 @@ folly::Future<std::unique_ptr<Tree>> HgBackingStore::importTreeManifestImpl(
       break;
   }
 
-  return importTreeImpl(manifestNode, objectId, path);
+  return objectId;
+}
+
+folly::Future<std::unique_ptr<Tree>> HgBackingStore::importTreeManifestImpl(
+    Hash20 manifestNode) {
+  return importTreeImpl(
+      manifestNode, makeRootTreeId(manifestNode), RelativePathPiece{});
 }
 
 SemiFuture<std::unique_ptr<Blob>> HgBackingStore::fetchBlobFromHgImporter(
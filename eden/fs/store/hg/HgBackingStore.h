@@ -131,6 +131,21 @@ class HgBackingStore {
   folly::Future<std::unique_ptr<Tree>> importTreeManifestImpl(
       Hash20 manifestNode);
 
+  /**
+   * The ObjectId of the root tree of a manifest, in the configured
+   * hg:object-id-format.
+   */
+  ObjectId makeRootTreeId(const Hash20& manifestNode);
+
+  /**
+   * importTreeManifestForRoot without the HgImporter: the root tree is fetched
+   * in-process through the backing store, and written along with the commit
+   * to tree mapping in a single LocalStore write batch.
+   */
+  folly::Future<folly::Unit> importTreeManifestForRootNative(
+      const ObjectId& commitId,
+      const Hash20& manifestId);
+
   void initializeDatapackImport(AbsolutePathPiece repository);
   folly::Future<std::unique_ptr<Tree>> importTreeImpl(
       const Hash20& manifestNode,
@@ -97,6 +97,10 @@ std::unique_ptr<Blob> HgDatapackStore::getBlobLocal(
   return nullptr;
 }
 
+bool HgDatapackStore::hasBlobLocal(const HgProxyHash& hgInfo) {
+  return store_.getBlob(hgInfo.byteHash(), true) != nullptr;
+}
+
 std::unique_ptr<Tree> HgDatapackStore::getTreeLocal(
     const ObjectId& edenTreeId,
     const HgProxyHash& proxyHash) {
@@ -110,7 +114,8 @@ std::unique_ptr<Tree> HgDatapackStore::getTreeLocal(
   return nullptr;
 }
 
-void HgDatapackStore::getBlobBatch(
+std::vector<std::shared_ptr<HgImportRequest>>
+HgDatapackStore::getBlobBatchLocal(
     const std::vector<std::shared_ptr<HgImportRequest>>& importRequests) {
   size_t count = importRequests.size();
 
@@ -123,6 +128,54 @@ void HgDatapackStore::getBlobBatch(
     requests.emplace_back(proxyHash.byteHash());
   }
 
+  std::vector<bool> found(count, false);
+  store_.getBlobBatch(
+      folly::range(requests),
+      true,
+      [&](size_t index, std::unique_ptr<folly::IOBuf> content) {
+        auto& importRequest = importRequests[index];
+        auto* blobRequest =
+            importRequest->getRequest<HgImportRequest::BlobImport>();
+        auto blob = std::make_unique<Blob>(blobRequest->hash, *content);
+        importRequest->setFetchedSource(HgImportRequest::FetchedSource::Local);
+        importRequest->getPromise<std::unique_ptr<Blob>>()->setValue(
+            std::move(blob));
+        found[index] = true;
+      });
+
+  std::vector<std::shared_ptr<HgImportRequest>> remaining;
+  for (size_t i = 0; i < count; i++) {
+    if (!found[i]) {
+      remaining.push_back(importRequests[i]);
+    }
+  }
+  return remaining;
+}
+
+void HgDatapackStore::getBlobBatch(
+    const std::vector<std::shared_ptr<HgImportRequest>>& batch) {
+  auto localFirst = config_->getEdenConfig()->importBatchLocalFirst.getValue();
+  std::vector<std::shared_ptr<HgImportRequest>> remaining;
+  if (localFirst) {
+    remaining = getBlobBatchLocal(batch);
+  }
+  const auto& importRequests = localFirst ? remaining : batch;
+  auto source = localFirst ? HgImportRequest::FetchedSource::Remote
+                           : HgImportRequest::FetchedSource::Unknown;
+  size_t count = importRequests.size();
+  if (count == 0) {
+    return;
+  }
+
+  std::vector<sapling::NodeId> requests;
+  requests.reserve(count);
+
+  for (const auto& importRequest : importRequests) {
+    auto& proxyHash =
+        importRequest->getRequest<HgImportRequest::BlobImport>()->proxyHash;
+    requests.emplace_back(proxyHash.byteHash());
+  }
+
   std::vector<RequestMetricsScope> requestsWatches;
   requestsWatches.reserve(count);
 
@@ -140,6 +193,7 @@ void HgDatapackStore::getBlobBatch(
         auto* blobRequest =
             importRequest->getRequest<HgImportRequest::BlobImport>();
         auto blob = std::make_unique<Blob>(blobRequest->hash, *content);
+        importRequest->setFetchedSource(source);
         importRequest->getPromise<std::unique_ptr<Blob>>()->setValue(
             std::move(blob));
 
@@ -148,13 +202,68 @@ void HgDatapackStore::getBlobBatch(
       });
 }
 
-void HgDatapackStore::getTreeBatch(
+std::vector<std::shared_ptr<HgImportRequest>>
+HgDatapackStore::getTreeBatchLocal(
     const std::vector<std::shared_ptr<HgImportRequest>>& importRequests) {
   auto count = importRequests.size();
 
   std::vector<sapling::NodeId> requests;
   requests.reserve(count);
 
+  for (const auto& importRequest : importRequests) {
+    auto& proxyHash =
+        importRequest->getRequest<HgImportRequest::TreeImport>()->proxyHash;
+    requests.emplace_back(proxyHash.byteHash());
+  }
+
+  auto hgObjectIdFormat = config_->getEdenConfig()->hgObjectIdFormat.getValue();
+
+  std::vector<bool> found(count, false);
+  store_.getTreeBatch(
+      folly::range(requests),
+      true,
+      [&](size_t index, std::shared_ptr<sapling::Tree> content) {
+        auto& importRequest = importRequests[index];
+        auto* treeRequest =
+            importRequest->getRequest<HgImportRequest::TreeImport>();
+        auto tree = fromRawTree(
+            content.get(),
+            treeRequest->hash,
+            treeRequest->proxyHash.path(),
+            hgObjectIdFormat);
+        importRequest->setFetchedSource(HgImportRequest::FetchedSource::Local);
+        importRequest->getPromise<std::unique_ptr<Tree>>()->setValue(
+            std::move(tree));
+        found[index] = true;
+      });
+
+  std::vector<std::shared_ptr<HgImportRequest>> remaining;
+  for (size_t i = 0; i < count; i++) {
+    if (!found[i]) {
+      remaining.push_back(importRequests[i]);
+    }
+  }
+  return remaining;
+}
+
+void HgDatapackStore::getTreeBatch(
+    const std::vector<std::shared_ptr<HgImportRequest>>& batch) {
+  auto localFirst = config_->getEdenConfig()->importBatchLocalFirst.getValue();
+  std::vector<std::shared_ptr<HgImportRequest>> remaining;
+  if (localFirst) {
+    remaining = getTreeBatchLocal(batch);
+  }
+  const auto& importRequests = localFirst ? remaining : batch;
+  auto source = localFirst ? HgImportRequest::FetchedSource::Remote
+                           : HgImportRequest::FetchedSource::Unknown;
+  auto count = importRequests.size();
+  if (count == 0) {
+    return;
+  }
+
+  std::vector<sapling::NodeId> requests;
+  requests.reserve(count);
+
   for (const auto& importRequest : importRequests) {
     auto& proxyHash =
         importRequest->getRequest<HgImportRequest::TreeImport>()->proxyHash;
@@ -185,6 +294,7 @@ void HgDatapackStore::getTreeBatch(
             treeRequest->proxyHash.path(),
             hgObjectIdFormat);
 
+        importRequest->setFetchedSource(source);
         importRequest->getPromise<std::unique_ptr<Tree>>()->setValue(
             std::move(tree));
 
@@ -193,6 +303,123 @@ void HgDatapackStore::getTreeBatch(
       });
 }
 
+folly::SemiFuture<folly::Unit> HgDatapackStore::getBlobBatchAsync(
+    std::vector<std::shared_ptr<HgImportRequest>> importRequests) {
+  auto localFirst = config_->getEdenConfig()->importBatchLocalFirst.getValue();
+  if (localFirst) {
+    importRequests = getBlobBatchLocal(importRequests);
+  }
+  auto source = localFirst ? HgImportRequest::FetchedSource::Remote
+                           : HgImportRequest::FetchedSource::Unknown;
+  size_t count = importRequests.size();
+  if (count == 0) {
+    return folly::unit;
+  }
+
+  // The node ids point into the requests, which the resolve callback keeps
+  // alive.
+  std::vector<sapling::NodeId> requests;
+  requests.reserve(count);
+
+  for (const auto& importRequest : importRequests) {
+    auto& proxyHash =
+        importRequest->getRequest<HgImportRequest::BlobImport>()->proxyHash;
+    requests.emplace_back(proxyHash.byteHash());
+  }
+
+  std::vector<RequestMetricsScope> requestsWatches;
+  requestsWatches.reserve(count);
+
+  for (auto i = 0ul; i < count; i++) {
+    requestsWatches.emplace_back(&liveBatchedBlobWatches_);
+  }
+
+  auto [promise, future] = folly::makePromiseContract<folly::Unit>();
+  store_.getBlobBatchAsync(
+      folly::range(requests),
+      false,
+      [importRequests = std::move(importRequests),
+       requestsWatches = std::move(requestsWatches),
+       source](size_t index, std::unique_ptr<folly::IOBuf> content) mutable {
+        auto& importRequest = importRequests[index];
+        auto* blobRequest =
+            importRequest->getRequest<HgImportRequest::BlobImport>();
+        XLOGF(DBG9, "Imported node={}", blobRequest->hash);
+        auto blob = std::make_unique<Blob>(blobRequest->hash, *content);
+        importRequest->setFetchedSource(source);
+        importRequest->getPromise<std::unique_ptr<Blob>>()->setValue(
+            std::move(blob));
+
+        // Make sure that we're stopping this watch.
+        auto watch = std::move(requestsWatches[index]);
+      },
+      [promise = std::move(promise)]() mutable { promise.setValue(); });
+  return std::move(future);
+}
+
+folly::SemiFuture<folly::Unit> HgDatapackStore::getTreeBatchAsync(
+    std::vector<std::shared_ptr<HgImportRequest>> importRequests) {
+  auto localFirst = config_->getEdenConfig()->importBatchLocalFirst.getValue();
+  if (localFirst) {
+    importRequests = getTreeBatchLocal(importRequests);
+  }
+  auto source = localFirst ? HgImportRequest::FetchedSource::Remote
+                           : HgImportRequest::FetchedSource::Unknown;
+  auto count = importRequests.size();
+  if (count == 0) {
+    return folly::unit;
+  }
+
+  // The node ids point into the requests, which the resolve callback keeps
+  // alive.
+  std::vector<sapling::NodeId> requests;
+  requests.reserve(count);
+
+  for (const auto& importRequest : importRequests) {
+    auto& proxyHash =
+        importRequest->getRequest<HgImportRequest::TreeImport>()->proxyHash;
+    requests.emplace_back(proxyHash.byteHash());
+  }
+  std::vector<RequestMetricsScope> requestsWatches;
+  requestsWatches.reserve(count);
+
+  for (auto i = 0ul; i < count; i++) {
+    requestsWatches.emplace_back(&liveBatchedTreeWatches_);
+  }
+
+  auto hgObjectIdFormat = config_->getEdenConfig()->hgObjectIdFormat.getValue();
+
+  auto [promise, future] = folly::makePromiseContract<folly::Unit>();
+  store_.getTreeBatchAsync(
+      folly::range(requests),
+      false,
+      [importRequests = std::move(importRequests),
+       requestsWatches = std::move(requestsWatches),
+       hgObjectIdFormat,
+       source](
+          size_t index, std::shared_ptr<sapling::Tree> content) mutable {
+        auto& importRequest = importRequests[index];
+        auto* treeRequest =
+            importRequest->getRequest<HgImportRequest::TreeImport>();
+        XLOGF(DBG4, "Imported tree node={}", treeRequest->hash);
+
+        auto tree = fromRawTree(
+            content.get(),
+            treeRequest->hash,
+            treeRequest->proxyHash.path(),
+            hgObjectIdFormat);
+
+        importRequest->setFetchedSource(source);
+        importRequest->getPromise<std::unique_ptr<Tree>>()->setValue(
+            std::move(tree));
+
+        // Make sure that we're stopping this watch.
+        auto watch = std::move(requestsWatches[index]);
+      },
+      [promise = std::move(promise)]() mutable { promise.setValue(); });
+  return std::move(future);
+}
+
 std::unique_ptr<Tree> HgDatapackStore::getTree(
     const RelativePath& path,
     const Hash20& manifestId,
@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/Range.h>
+#include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
 
 #include "eden/fs/telemetry/RequestMetricsScope.h"
@@ -43,6 +44,11 @@ class HgDatapackStore {
       const ObjectId& id,
       const HgProxyHash& hgInfo);
 
+  /**
+   * Whether the blob is present in the local store, without importing it.
+   */
+  bool hasBlobLocal(const HgProxyHash& hgInfo);
+
   /**
    * Imports the tree identified by the given hash from the local store.
    * Returns nullptr if not found.
@@ -62,6 +68,17 @@ class HgDatapackStore {
   void getTreeBatch(
       const std::vector<std::shared_ptr<HgImportRequest>>& requests);
 
+  /**
+   * Asynchronous versions of getBlobBatch and getTreeBatch: the promises are
+   * resolved as the objects are imported, and the returned future completes
+   * once the whole batch was processed, without blocking the calling thread.
+   */
+  folly::SemiFuture<folly::Unit> getBlobBatchAsync(
+      std::vector<std::shared_ptr<HgImportRequest>> requests);
+
+  folly::SemiFuture<folly::Unit> getTreeBatchAsync(
+      std::vector<std::shared_ptr<HgImportRequest>> requests);
+
   std::unique_ptr<Tree> getTree(
       const RelativePath& path,
       const Hash20& manifestId,
@@ -97,6 +114,15 @@ class HgDatapackStore {
   }
 
  private:
+  /**
+   * Import the requests of a batch found in the hg cache, so that they don't
+   * wait for the remote fetch of the others. Returns the remaining requests.
+   */
+  std::vector<std::shared_ptr<HgImportRequest>> getBlobBatchLocal(
+      const std::vector<std::shared_ptr<HgImportRequest>>& requests);
+  std::vector<std::shared_ptr<HgImportRequest>> getTreeBatchLocal(
+      const std::vector<std::shared_ptr<HgImportRequest>>& requests);
+
   sapling::SaplingNativeBackingStore store_;
   std::shared_ptr<ReloadableConfig> config_;
 
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/HgImportOverloadController.h"
+
+namespace facebook::eden {
+
+void HgImportOverloadController::recordLatency(Duration latency) {
+  auto sample =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+  // Concurrent updates may lose a sample, which doesn't matter for an
+  // average.
+  auto average = averageLatency_.load(std::memory_order_relaxed);
+  if (average == 0) {
+    average = sample;
+  } else {
+    average += (sample - average) >> kLatencyWeightShift;
+  }
+  averageLatency_.store(average, std::memory_order_relaxed);
+}
+
+HgImportOverloadController::Transition HgImportOverloadController::update(
+    size_t queueDepth,
+    const Limits& limits,
+    Clock::time_point now) {
+  auto latency = getAverageLatency();
+  auto hasLatencyLimit = limits.maxLatency.count() > 0;
+
+  if (!isOverloaded()) {
+    bool exceeded =
+        (limits.maxQueueDepth != 0 && queueDepth >= limits.maxQueueDepth) ||
+        (hasLatencyLimit && latency >= limits.maxLatency);
+    if (!exceeded) {
+      return Transition::None;
+    }
+    std::lock_guard lock{mutex_};
+    if (isOverloaded()) {
+      return Transition::None;
+    }
+    overloadedSince_ = now;
+    overloaded_.store(true, std::memory_order_relaxed);
+    return Transition::Entered;
+  }
+
+  bool recovered =
+      (limits.maxQueueDepth == 0 ||
+       queueDepth * kRecoveryDivisor < limits.maxQueueDepth) &&
+      // Without queued requests, a high average only reflects the imports
+      // that completed before.
+      (!hasLatencyLimit || queueDepth == 0 ||
+       latency * kRecoveryDivisor < limits.maxLatency);
+  if (!recovered) {
+    return Transition::None;
+  }
+  std::lock_guard lock{mutex_};
+  if (!isOverloaded() || now - overloadedSince_ < kMinOverloadDuration) {
+    return Transition::None;
+  }
+  overloaded_.store(false, std::memory_order_relaxed);
+  return Transition::Left;
+}
+
+HgImportOverloadController::Admission HgImportOverloadController::admit(
+    ImportPriority priority) const {
+  if (!isOverloaded()) {
+    return Admission::Accept;
+  }
+  if (priority.getClass() <= ImportPriority::Class::Low) {
+    return Admission::Shed;
+  }
+  if (priority.getAdjustment() < 0) {
+    return Admission::FailFast;
+  }
+  return Admission::Accept;
+}
+
+} // namespace facebook::eden
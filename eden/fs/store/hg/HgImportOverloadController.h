@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+#include "eden/fs/store/ImportPriority.h"
+
+namespace facebook::eden {
+
+/**
+ * Decides when the HgQueuedBackingStore is overloaded, from the depth of its
+ * import queue and the latency of the imports, and which requests to turn
+ * away while it is.
+ *
+ * When Mercurial or the server slow down, the import queue otherwise grows
+ * without bound, and every request ends up waiting behind a backlog of
+ * prefetches. While overloaded, the low-priority requests, i.e. the
+ * prefetches of readdir, glob, read ahead and cache warming, are shed, and
+ * the requests of fetch-heavy processes, deprioritized by the ObjectStore,
+ * fail fast. The other requests are queued as usual, and the objects already
+ * in the caches are served without reaching the queue.
+ *
+ * The store is overloaded once the queue depth or the average latency reach
+ * their limit, and recovers once both are below a fraction of their limit,
+ * and it was overloaded for at least kMinOverloadDuration, so that it
+ * doesn't flap around the limits.
+ *
+ * Thread-safe.
+ */
+class HgImportOverloadController {
+ public:
+  using Clock = std::chrono::steady_clock;
+  using Duration = Clock::duration;
+
+  struct Limits {
+    /**
+     * Number of queued requests from which the store is overloaded, 0 for
+     * no limit.
+     */
+    size_t maxQueueDepth = 0;
+
+    /**
+     * Average import latency, queue wait included, from which the store is
+     * overloaded, 0 for no limit.
+     */
+    Duration maxLatency{};
+  };
+
+  enum class Transition {
+    None,
+    Entered,
+    Left,
+  };
+
+  enum class Admission {
+    Accept,
+    // A low-priority prefetch, dropped while overloaded.
+    Shed,
+    // A request of a fetch-heavy process, failed while overloaded.
+    FailFast,
+  };
+
+  HgImportOverloadController() = default;
+
+  /**
+   * Record the average latency of the requests of a batch, from their
+   * enqueue to the end of their fetch.
+   */
+  void recordLatency(Duration latency);
+
+  /**
+   * Re-evaluate the state from the current queue depth and the recorded
+   * latencies. Returns whether this call entered or left the overloaded
+   * state, which happens once per transition whatever the number of callers.
+   */
+  Transition
+  update(size_t queueDepth, const Limits& limits, Clock::time_point now);
+
+  /**
+   * What to do with a new request of the given priority.
+   */
+  Admission admit(ImportPriority priority) const;
+
+  bool isOverloaded() const {
+    return overloaded_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Exponentially weighted average of the recorded latencies.
+   */
+  Duration getAverageLatency() const {
+    return std::chrono::duration_cast<Duration>(
+        std::chrono::nanoseconds{
+            averageLatency_.load(std::memory_order_relaxed)});
+  }
+
+  /**
+   * The store recovers once the queue depth and the latency are below their
+   * limit divided by this.
+   */
+  static constexpr size_t kRecoveryDivisor = 2;
+
+  /**
+   * Minimum time the store stays overloaded.
+   */
+  static constexpr Duration kMinOverloadDuration = std::chrono::seconds{1};
+
+  /**
+   * Each latency moves the average by 1/2^kLatencyWeightShift of the
+   * difference.
+   */
+  static constexpr int kLatencyWeightShift = 3;
+
+ private:
+  // In nanoseconds, 0 until a latency was recorded.
+  std::atomic<int64_t> averageLatency_{0};
+  std::atomic<bool> overloaded_{false};
+  // Serializes the transitions.
+  std::mutex mutex_;
+  Clock::time_point overloadedSince_;
+};
+
+} // namespace facebook::eden
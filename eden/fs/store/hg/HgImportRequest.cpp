@@ -10,11 +10,140 @@
 #include <folly/Try.h>
 #include <folly/futures/Future.h>
 #include <folly/futures/Promise.h>
+#include <mutex>
+#include <new>
+#include <vector>
 
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 
 namespace facebook::eden {
 
+namespace {
+struct FreeSlot {
+  FreeSlot* next;
+};
+
+// Number of slots handed between the threads at once. A thread caches up to
+// twice as many.
+constexpr size_t kSlotBatchSize = 64;
+// Number of batches kept for the threads that run out of slots, beyond which
+// freed slots go back to the global allocator.
+constexpr size_t kMaxSlotBatches = 64;
+
+/**
+ * Batches of kSlotBatchSize free slots, linked through FreeSlot::next.
+ */
+class SlotBatches {
+ public:
+  FreeSlot* pop() {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (batches_.empty()) {
+      return nullptr;
+    }
+    auto* batch = batches_.back();
+    batches_.pop_back();
+    return batch;
+  }
+
+  /**
+   * Returns false if the pool is full, in which case the caller keeps the
+   * batch.
+   */
+  bool push(FreeSlot* batch) {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (batches_.size() >= kMaxSlotBatches) {
+      return false;
+    }
+    batches_.push_back(batch);
+    return true;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<FreeSlot*> batches_;
+};
+
+SlotBatches& getSlotBatches() {
+  // Leaked, as threads may release requests during static destruction.
+  static auto* batches = new SlotBatches;
+  return *batches;
+}
+
+void freeSlots(FreeSlot* slot) {
+  while (slot) {
+    auto* next = slot->next;
+    ::operator delete(slot);
+    slot = next;
+  }
+}
+
+struct SlotCache {
+  FreeSlot* head = nullptr;
+  size_t size = 0;
+  // Cleared once the thread exits, after which requests it releases, e.g.
+  // from other thread_local destructors, go to the global allocator.
+  bool alive = true;
+
+  ~SlotCache() {
+    freeSlots(head);
+    head = nullptr;
+    size = 0;
+    alive = false;
+  }
+
+  /**
+   * Unlink the first kSlotBatchSize slots of the cache.
+   */
+  FreeSlot* takeBatch() {
+    auto* batch = head;
+    auto* last = head;
+    for (size_t i = 1; i < kSlotBatchSize; ++i) {
+      last = last->next;
+    }
+    head = last->next;
+    last->next = nullptr;
+    size -= kSlotBatchSize;
+    return batch;
+  }
+};
+
+thread_local SlotCache slotCache;
+} // namespace
+
+void* HgImportRequest::allocateSlot() {
+  auto& cache = slotCache;
+  if (!cache.alive) {
+    return ::operator new(kPoolSlotSize);
+  }
+  if (!cache.head) {
+    cache.head = getSlotBatches().pop();
+    if (!cache.head) {
+      return ::operator new(kPoolSlotSize);
+    }
+    cache.size = kSlotBatchSize;
+  }
+  auto* slot = cache.head;
+  cache.head = slot->next;
+  --cache.size;
+  return slot;
+}
+
+void HgImportRequest::deallocateSlot(void* ptr) noexcept {
+  auto& cache = slotCache;
+  if (!cache.alive) {
+    ::operator delete(ptr);
+    return;
+  }
+  auto* slot = new (ptr) FreeSlot{cache.head};
+  cache.head = slot;
+  if (++cache.size == 2 * kSlotBatchSize) {
+    auto* batch = cache.takeBatch();
+    if (!getSlotBatches().push(batch)) {
+      freeSlots(batch);
+    }
+  }
+}
+
 template <typename RequestType>
 HgImportRequest::HgImportRequest(
     RequestType request,
@@ -32,7 +161,8 @@ std::shared_ptr<HgImportRequest> HgImportRequest::makeRequest(
     ObjectFetchContext::Cause cause,
     Input&&... input) {
   auto promise = folly::Promise<typename RequestType::Response>{};
-  return std::make_shared<HgImportRequest>(
+  return std::allocate_shared<HgImportRequest>(
+      PoolAllocator<HgImportRequest>{},
       RequestType{std::forward<Input>(input)...},
       priority,
       cause,
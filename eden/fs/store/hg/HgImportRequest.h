@@ -8,6 +8,11 @@
 #pragma once
 
 #include <folly/futures/Promise.h>
+#include <folly/portability/SysTypes.h>
+#include <folly/small_vector.h>
+#include <cstddef>
+#include <memory>
+#include <optional>
 #include <utility>
 #include <variant>
 
@@ -28,32 +33,113 @@ namespace facebook::eden {
  * information needed to fulfill the request as well as a promise that will be
  * resolved after the requested data is imported. Blobs and Trees also contain
  * a vector of promises to fulfill, corresponding to duplicate requests
+ *
+ * Requests are allocated from a pool of recycled slots, see PoolAllocator.
  */
 class HgImportRequest {
  public:
+  /**
+   * Where the data of an import request came from.
+   */
+  enum class FetchedSource : uint8_t {
+    // Not known, e.g. a batch that wasn't split between the local and the
+    // remote stores.
+    Unknown,
+    // The hg cache.
+    Local,
+    // A remote fetch through the native backing store.
+    Remote,
+    // The hg importer, when the native backing store didn't find it.
+    HgImporter,
+  };
+
   struct BlobImport {
     using Response = std::unique_ptr<Blob>;
     BlobImport(ObjectId hash, HgProxyHash proxyHash)
-        : hash(hash), proxyHash(proxyHash) {}
+        : hash(hash), proxyHash(std::move(proxyHash)) {}
 
     ObjectId hash;
     HgProxyHash proxyHash;
 
     // In the case where requests de-duplicate to this one, the requests
-    // promise will be enqueued to the following vector.
-    std::vector<folly::Promise<Response>> promises;
+    // promise will be enqueued to the following vector. Most duplicated
+    // requests have a single duplicate, which is stored inline.
+    folly::small_vector<folly::Promise<Response>, 1> promises;
   };
 
   struct TreeImport {
     using Response = std::unique_ptr<Tree>;
     TreeImport(ObjectId hash, HgProxyHash proxyHash)
-        : hash(hash), proxyHash(proxyHash) {}
+        : hash(hash), proxyHash(std::move(proxyHash)) {}
 
     ObjectId hash;
     HgProxyHash proxyHash;
 
     // See the comment above for BlobImport::promises
-    std::vector<folly::Promise<Response>> promises;
+    folly::small_vector<folly::Promise<Response>, 1> promises;
+  };
+
+  /**
+   * Size of the slots of the pool, which fit a request and its control block.
+   * Allocations of other sizes go to the global allocator.
+   */
+  static constexpr size_t kPoolSlotSize = 512;
+
+  /**
+   * The allocator of the requests and their shared_ptr control blocks, which
+   * std::allocate_shared puts in a single allocation.
+   *
+   * Every import allocates a request, and they are often released by another
+   * thread than the one that allocated them: an importer thread, or the one
+   * running the callbacks of the future. Freed slots are cached per thread,
+   * and the excess of a thread is handed in batches to the threads that run
+   * out, so that a slot goes through the global allocator only once in a
+   * while. The memory held by the pool is bounded.
+   */
+  template <typename T>
+  class PoolAllocator {
+   public:
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+
+    template <typename U>
+    /* implicit */ PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+      if constexpr (fitsSlot()) {
+        if (n == 1) {
+          return static_cast<T*>(allocateSlot());
+        }
+      }
+      return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+      if constexpr (fitsSlot()) {
+        if (n == 1) {
+          deallocateSlot(ptr);
+          return;
+        }
+      }
+      ::operator delete(ptr);
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept {
+      return true;
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>&) const noexcept {
+      return false;
+    }
+
+   private:
+    static constexpr bool fitsSlot() {
+      return sizeof(T) <= kPoolSlotSize &&
+          alignof(T) <= alignof(std::max_align_t);
+    }
   };
 
   /**
@@ -134,6 +220,69 @@ class HgImportRequest {
     return requestTime_;
   }
 
+  /**
+   * Set by the importer before fulfilling the promise, and thus only read
+   * once it is fulfilled.
+   */
+  FetchedSource getFetchedSource() const noexcept {
+    return fetchedSource_;
+  }
+
+  void setFetchedSource(FetchedSource source) noexcept {
+    fetchedSource_ = source;
+  }
+
+  /**
+   * The process the request was made for, if known. Used by the fair-share
+   * scheduling of HgImportRequestQueue.
+   */
+  std::optional<pid_t> getClientPid() const noexcept {
+    return clientPid_;
+  }
+
+  void setClientPid(std::optional<pid_t> pid) noexcept {
+    clientPid_ = pid;
+  }
+
+  /**
+   * Number of callers waiting on the request that didn't have their
+   * cancellation requested. Only accessed by HgImportRequestQueue, under the
+   * lock of its request tracker.
+   */
+  void addWaiter() noexcept {
+    ++waiters_;
+  }
+
+  size_t removeWaiter() noexcept {
+    return --waiters_;
+  }
+
+  /**
+   * When the request stops being worth dispatching, if ever.
+   */
+  std::optional<std::chrono::steady_clock::time_point> getDeadline()
+      const noexcept {
+    return deadline_;
+  }
+
+  void setDeadline(std::chrono::steady_clock::time_point deadline) noexcept {
+    deadline_ = deadline;
+  }
+
+  /**
+   * How the request is accounted in the fair-share state of its client.
+   * Only accessed by HgImportRequestQueue, under the lock of that state.
+   */
+  enum class ClientState : uint8_t { None, Queued, Running };
+
+  ClientState getClientState() const noexcept {
+    return clientState_;
+  }
+
+  void setClientState(ClientState state) noexcept {
+    clientState_ = state;
+  }
+
  private:
   /**
    * Implementation detail of the various make*Request functions.
@@ -144,6 +293,12 @@ class HgImportRequest {
       ObjectFetchContext::Cause cause,
       Input&&... input);
 
+  /**
+   * Implementation of PoolAllocator, for kPoolSlotSize bytes.
+   */
+  static void* allocateSlot();
+  static void deallocateSlot(void* ptr) noexcept;
+
   HgImportRequest(const HgImportRequest&) = delete;
   HgImportRequest& operator=(const HgImportRequest&) = delete;
 
@@ -159,6 +314,11 @@ class HgImportRequest {
   uint64_t unique_ = generateUniqueID();
   std::chrono::steady_clock::time_point requestTime_ =
       std::chrono::steady_clock::now();
+  FetchedSource fetchedSource_ = FetchedSource::Unknown;
+  ClientState clientState_ = ClientState::None;
+  std::optional<pid_t> clientPid_;
+  size_t waiters_ = 1;
+  std::optional<std::chrono::steady_clock::time_point> deadline_;
 
   friend bool operator<(
       const HgImportRequest& lhs,
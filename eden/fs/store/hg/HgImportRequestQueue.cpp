@@ -6,169 +6,685 @@
  */
 
 #include "eden/fs/store/hg/HgImportRequestQueue.h"
+#include <fb303/ServiceData.h>
+#include <fmt/format.h>
+#include <folly/MapUtil.h>
 #include <folly/futures/Future.h>
+#include <folly/futures/FutureException.h>
+#include <folly/hash/Hash.h>
+#include <folly/logging/xlog.h>
 #include <algorithm>
+#include <thread>
 #include "eden/fs/config/ReloadableConfig.h"
 
 namespace facebook::eden {
 
+namespace {
+// The indexes of HgImportRequest::getType().
+constexpr size_t kBlobType = 0;
+constexpr size_t kTreeType = 1;
+
+bool lowerPriority(
+    const std::shared_ptr<HgImportRequest>& lhs,
+    const std::shared_ptr<HgImportRequest>& rhs) {
+  return (*lhs) < (*rhs);
+}
+} // namespace
+
+HgImportRequestQueue::HgImportRequestQueue(
+    std::shared_ptr<ReloadableConfig> config)
+    : config_(std::move(config)),
+      blobBatchSize_{config_->getEdenConfig()->importBatchSize.getValue()},
+      treeBatchSize_{
+          config_->getEdenConfig()->importBatchSizeTree.getValue()} {}
+
+size_t HgImportRequestQueue::getShard(const ObjectId& id) {
+  return folly::hash::twang_mix64(std::hash<ObjectId>{}(id)) % kShardCount;
+}
+
+size_t HgImportRequestQueue::getClientShard(pid_t pid) {
+  return folly::hash::twang_mix64(static_cast<uint64_t>(pid)) % kShardCount;
+}
+
+size_t HgImportRequestQueue::getLevel(ImportPriority priority) {
+  auto cls = priority.getClass();
+  if (cls >= ImportPriority::Class::High) {
+    return 2;
+  } else if (cls >= ImportPriority::Class::Normal) {
+    return 1;
+  } else {
+    return 0;
+  }
+}
+
 void HgImportRequestQueue::stop() {
-  auto state = state_.lock();
-  if (state->running) {
-    state->running = false;
-    queueCV_.notify_all();
+  if (running_.exchange(false)) {
+    // Wakes up the blocked dequeue() calls, which then clear the queue.
+    available_.shutdown();
   }
 }
 
 folly::Future<std::unique_ptr<Blob>> HgImportRequestQueue::enqueueBlob(
-    std::shared_ptr<HgImportRequest> request) {
+    std::shared_ptr<HgImportRequest> request,
+    folly::CancellationToken cancellation) {
   return enqueue<std::unique_ptr<Blob>, HgImportRequest::BlobImport>(
-      std::move(request));
+      std::move(request), std::move(cancellation));
 }
 
 folly::Future<std::unique_ptr<Tree>> HgImportRequestQueue::enqueueTree(
-    std::shared_ptr<HgImportRequest> request) {
+    std::shared_ptr<HgImportRequest> request,
+    folly::CancellationToken cancellation) {
   return enqueue<std::unique_ptr<Tree>, HgImportRequest::TreeImport>(
-      std::move(request));
+      std::move(request), std::move(cancellation));
 }
 
 template <typename Ret, typename ImportType>
 folly::Future<Ret> HgImportRequestQueue::enqueue(
-    std::shared_ptr<HgImportRequest> request) {
-  auto state = state_.lock();
-
-  std::vector<std::shared_ptr<HgImportRequest>>* queue;
-  if constexpr (std::is_same_v<ImportType, HgImportRequest::BlobImport>) {
-    queue = &state->blobQueue;
-  } else {
-    static_assert(std::is_same_v<ImportType, HgImportRequest::TreeImport>);
-    queue = &state->treeQueue;
+    std::shared_ptr<HgImportRequest> request,
+    folly::CancellationToken cancellation) {
+  std::shared_ptr<HgImportRequest> tracked;
+  auto future = enqueueImpl<Ret, ImportType>(std::move(request), tracked);
+  if (!cancellation.canBeCancelled()) {
+    return future;
   }
 
+  // Registered once the queue locks are released, since the callback runs
+  // inline if cancellation was already requested.
+  auto callback = std::make_unique<folly::CancellationCallback>(
+      std::move(cancellation),
+      [this, tracked = std::move(tracked)] { cancelWaiter(tracked); });
+  return std::move(future).ensure([callback = std::move(callback)] {});
+}
+
+template <typename Ret, typename ImportType>
+folly::Future<Ret> HgImportRequestQueue::enqueueImpl(
+    std::shared_ptr<HgImportRequest> request,
+    std::shared_ptr<HgImportRequest>& tracked) {
   const auto& hash = request->getRequest<ImportType>()->hash;
-  if (auto* existingRequestPtr = folly::get_ptr(state->requestTracker, hash)) {
+  auto type = request->getType();
+  auto shard = getShard(hash);
+  auto tracker = trackers_[shard].requests.lock();
+
+  if (auto* existingRequestPtr = folly::get_ptr(*tracker, hash)) {
     auto& existingRequest = *existingRequestPtr;
     auto* trackedImport = existingRequest->template getRequest<ImportType>();
 
     auto [promise, future] = folly::makePromiseContract<Ret>();
     trackedImport->promises.emplace_back(std::move(promise));
+    existingRequest->addWaiter();
+    tracked = existingRequest;
 
-    if (existingRequest->getPriority() < request->getPriority()) {
-      existingRequest->setPriority(request->getPriority());
+    auto oldPriority = existingRequest->getPriority();
+    auto newPriority = request->getPriority();
+    if (oldPriority < newPriority) {
+      auto oldLevel = getLevel(oldPriority);
+      auto newLevel = getLevel(newPriority);
+      auto& oldLevelShard = levels_[type][oldLevel].shards[shard];
+      if (oldLevel == newLevel) {
+        auto heap = oldLevelShard.heap.lock();
+        existingRequest->setPriority(newPriority);
 
-      // Since the new request has a higher priority than the already present
-      // one, we need to re-order the heap.
-      //
-      // TODO(xavierd): this has a O(n) complexity, and enqueing tons of
-      // duplicated requests will thus lead to a quadratic complexity.
-      std::make_heap(
-          queue->begin(),
-          queue->end(),
-          [](const std::shared_ptr<HgImportRequest>& lhs,
-             const std::shared_ptr<HgImportRequest>& rhs) {
-            return (*lhs) < (*rhs);
-          });
+        // Since the new request has a higher priority than the already
+        // present one, we need to re-order the heap.
+        //
+        // TODO(xavierd): this has a O(n) complexity, and enqueing tons of
+        // duplicated requests will thus lead to a quadratic complexity.
+        std::make_heap(heap->begin(), heap->end(), lowerPriority);
+      } else {
+        // The request has to move to the level of its new priority class,
+        // unless it is already being imported.
+        bool queued = false;
+        {
+          auto heap = oldLevelShard.heap.lock();
+          auto it = std::find(heap->begin(), heap->end(), existingRequest);
+          if (it != heap->end()) {
+            heap->erase(it);
+            std::make_heap(heap->begin(), heap->end(), lowerPriority);
+            levels_[type][oldLevel].size.fetch_sub(
+                1, std::memory_order_relaxed);
+            queued = true;
+          }
+          existingRequest->setPriority(newPriority);
+        }
+        if (queued) {
+          push(type, newLevel, shard, existingRequest);
+        }
+      }
     }
 
     return std::move(future).toUnsafeFuture();
   }
 
-  queue->emplace_back(request);
-  auto promise = request->getPromise<Ret>();
+  const auto& config = config_->getSnapshot();
+  if (config.importFairShare.getValue()) {
+    clientEnqueued(
+        *request, config.importFairShareDeprioritizedWeight.getValue());
+  }
+  auto deadline = config.importRequestDeadline.getValue();
+  if (deadline.count() != 0) {
+    request->setDeadline(request->getRequestTime() + deadline);
+  }
 
-  state->requestTracker.emplace(hash, std::move(request));
+  // Once available_ is posted, the request may be imported and destroyed at
+  // any time.
+  auto future = request->getPromise<Ret>()->getFuture();
+  push(type, getLevel(request->getPriority()), shard, request);
+  tracked = request;
+  tracker->emplace(hash, std::move(request));
+  tracker.unlock();
 
-  std::push_heap(
-      queue->begin(),
-      queue->end(),
-      [](const std::shared_ptr<HgImportRequest>& lhs,
-         const std::shared_ptr<HgImportRequest>& rhs) {
-        return (*lhs) < (*rhs);
-      });
+  queued_.fetch_add(1, std::memory_order_release);
+  available_.post();
+  return future;
+}
 
-  queueCV_.notify_one();
+void HgImportRequestQueue::push(
+    size_t type,
+    size_t level,
+    size_t shard,
+    std::shared_ptr<HgImportRequest> request) {
+  auto& queueLevel = levels_[type][level];
+  auto heap = queueLevel.shards[shard].heap.lock();
+  heap->emplace_back(std::move(request));
+  std::push_heap(heap->begin(), heap->end(), lowerPriority);
+  queueLevel.size.fetch_add(1, std::memory_order_release);
+}
 
-  return promise->getFuture();
+std::optional<ImportPriority> HgImportRequestQueue::peek(
+    size_t type,
+    size_t level) {
+  std::optional<ImportPriority> highestPriority;
+  for (auto& shard : levels_[type][level].shards) {
+    auto heap = shard.heap.lock();
+    if (!heap->empty() &&
+        (!highestPriority || *highestPriority < heap->front()->getPriority())) {
+      highestPriority = heap->front()->getPriority();
+    }
+  }
+  return highestPriority;
+}
+
+std::vector<std::shared_ptr<HgImportRequest>> HgImportRequestQueue::popBatch(
+    size_t type,
+    size_t level,
+    size_t count,
+    size_t maxRunningPerClient) {
+  using LockedHeap = decltype(levels_[0][0].shards[0].heap.lock());
+
+  std::vector<std::shared_ptr<HgImportRequest>> result;
+  result.reserve(count);
+  // Requests past their deadline, failed once the heaps are unlocked.
+  std::vector<std::shared_ptr<HgImportRequest>> expired;
+  // Whether a token of available_ is held for the next request. The caller
+  // waited on available_ for the first request of the batch.
+  bool haveToken = true;
+  bool drained = false;
+  for (size_t popLevel = level + 1;
+       popLevel-- > 0 && result.size() < count && !drained;) {
+    auto& queueLevel = levels_[type][popLevel];
+    if (queueLevel.size.load(std::memory_order_acquire) == 0) {
+      continue;
+    }
+
+    // Holding all the shards of the level lets the whole batch be popped in
+    // priority order without re-locking them for every request.
+    std::vector<LockedHeap> heaps;
+    heaps.reserve(kShardCount);
+    for (auto& shard : queueLevel.shards) {
+      heaps.emplace_back(shard.heap.lock());
+    }
+
+    // Requests of clients at their limit, pushed back once the level is done.
+    std::vector<std::pair<LockedHeap*, std::shared_ptr<HgImportRequest>>>
+        deferred;
+    auto now = std::chrono::steady_clock::now();
+    while (result.size() < count) {
+      if (!haveToken && !available_.tryWait()) {
+        drained = true;
+        break;
+      }
+      haveToken = true;
+
+      LockedHeap* highest = nullptr;
+      for (auto& heap : heaps) {
+        if (!heap->empty() &&
+            (!highest || lowerPriority((*highest)->front(), heap->front()))) {
+          highest = &heap;
+        }
+      }
+      if (!highest) {
+        // This level is exhausted.
+        break;
+      }
+
+      auto& heap = *highest;
+      std::pop_heap(heap->begin(), heap->end(), lowerPriority);
+      auto request = std::move(heap->back());
+      heap->pop_back();
+      auto deadline = request->getDeadline();
+      bool isExpired = deadline && *deadline < now;
+      if (!isExpired && !tryClientDispatch(*request, maxRunningPerClient)) {
+        deferred.emplace_back(highest, std::move(request));
+        continue;
+      }
+
+      if (isExpired) {
+        expired.emplace_back(std::move(request));
+      } else {
+        result.emplace_back(std::move(request));
+      }
+      haveToken = false;
+      queueLevel.size.fetch_sub(1, std::memory_order_relaxed);
+      queued_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    for (auto& [heap, request] : deferred) {
+      (*heap)->emplace_back(std::move(request));
+      std::push_heap((*heap)->begin(), (*heap)->end(), lowerPriority);
+    }
+  }
+
+  if (haveToken && (!result.empty() || !expired.empty())) {
+    // Give back what was taken for a request that wasn't popped.
+    available_.post();
+  }
+
+  for (auto& request : expired) {
+    XLOGF(
+        DBG3,
+        "Import request {} expired after {}ms in the queue",
+        request->getUnique(),
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - request->getRequestTime())
+            .count());
+    untrack(request);
+    failPromises(
+        *request, folly::make_exception_wrapper<folly::FutureTimeout>());
+  }
+  return result;
+}
+
+void HgImportRequestQueue::cancelWaiter(
+    const std::shared_ptr<HgImportRequest>& request) {
+  const auto& id = getRequestId(*request);
+  auto shard = getShard(id);
+  {
+    auto tracker = trackers_[shard].requests.lock();
+    auto it = tracker->find(id);
+    if (it == tracker->end() || it->second != request ||
+        request->removeWaiter() != 0) {
+      return;
+    }
+
+    auto& queueLevel =
+        levels_[request->getType()][getLevel(request->getPriority())];
+    {
+      auto heap = queueLevel.shards[shard].heap.lock();
+      auto pos = std::find(heap->begin(), heap->end(), request);
+      if (pos == heap->end()) {
+        // Already dispatched, the import is let to complete.
+        return;
+      }
+      heap->erase(pos);
+      std::make_heap(heap->begin(), heap->end(), lowerPriority);
+      queueLevel.size.fetch_sub(1, std::memory_order_relaxed);
+    }
+    tracker->erase(it);
+  }
+
+  queued_.fetch_sub(1, std::memory_order_relaxed);
+  // As in combineAndClearRequestQueues(), a token that a dequeuer already
+  // holds is dropped by dequeue() when it finds the queue empty.
+  available_.tryWait();
+  XLOGF(DBG4, "Cancelled import request {}", request->getUnique());
+  clientFinished(*request);
+  failPromises(
+      *request, folly::make_exception_wrapper<folly::OperationCancelled>());
+}
+
+const ObjectId& HgImportRequestQueue::getRequestId(HgImportRequest& request) {
+  if (auto* blobImport = request.getRequest<HgImportRequest::BlobImport>()) {
+    return blobImport->hash;
+  }
+  return request.getRequest<HgImportRequest::TreeImport>()->hash;
+}
+
+void HgImportRequestQueue::untrack(
+    const std::shared_ptr<HgImportRequest>& request) {
+  const auto& id = getRequestId(*request);
+  {
+    auto tracker = trackers_[getShard(id)].requests.lock();
+    auto it = tracker->find(id);
+    if (it != tracker->end() && it->second == request) {
+      tracker->erase(it);
+    }
+  }
+  clientFinished(*request);
+}
+
+void HgImportRequestQueue::failPromises(
+    HgImportRequest& request,
+    const folly::exception_wrapper& ew) {
+  auto fail = [&](auto* import, auto* promise) {
+    for (auto& waiter : import->promises) {
+      if (!waiter.isFulfilled()) {
+        waiter.setException(ew);
+      }
+    }
+    if (!promise->isFulfilled()) {
+      promise->setException(ew);
+    }
+  };
+  if (auto* blobImport = request.getRequest<HgImportRequest::BlobImport>()) {
+    fail(blobImport, request.getPromise<std::unique_ptr<Blob>>());
+  } else {
+    fail(
+        request.getRequest<HgImportRequest::TreeImport>(),
+        request.getPromise<std::unique_ptr<Tree>>());
+  }
+}
+
+void HgImportRequestQueue::clientEnqueued(
+    HgImportRequest& request,
+    uint32_t deprioritizedWeight) {
+  auto pid = request.getClientPid();
+  if (!pid) {
+    return;
+  }
+
+  size_t position;
+  {
+    auto clients = clients_[getClientShard(*pid)].clients.lock();
+    position = (*clients)[*pid].queued++;
+    request.setClientState(HgImportRequest::ClientState::Queued);
+  }
+
+  auto priority = request.getPriority();
+  int64_t weight = priority.getAdjustment() < 0
+      ? std::max<int64_t>(deprioritizedWeight, 1)
+      : 1;
+  request.setPriority(
+      priority.adjusted(-static_cast<int64_t>(position) * weight));
+}
+
+bool HgImportRequestQueue::tryClientDispatch(
+    HgImportRequest& request,
+    size_t maxRunning) {
+  if (request.getClientState() != HgImportRequest::ClientState::Queued) {
+    return true;
+  }
+
+  auto pid = *request.getClientPid();
+  auto clients = clients_[getClientShard(pid)].clients.lock();
+  auto& stats = (*clients)[pid];
+  if (maxRunning != 0 && stats.running >= maxRunning) {
+    return false;
+  }
+  --stats.queued;
+  ++stats.running;
+  ++stats.dispatched;
+  request.setClientState(HgImportRequest::ClientState::Running);
+  return true;
+}
+
+void HgImportRequestQueue::clientFinished(HgImportRequest& request) {
+  auto state = request.getClientState();
+  if (state == HgImportRequest::ClientState::None) {
+    return;
+  }
+
+  auto pid = *request.getClientPid();
+  bool idle = false;
+  {
+    auto clients = clients_[getClientShard(pid)].clients.lock();
+    auto it = clients->find(pid);
+    if (it == clients->end()) {
+      return;
+    }
+    if (state == HgImportRequest::ClientState::Queued) {
+      --it->second.queued;
+    } else {
+      --it->second.running;
+    }
+    request.setClientState(HgImportRequest::ClientState::None);
+    if (it->second.queued == 0 && it->second.running == 0) {
+      clients->erase(it);
+      idle = true;
+    }
+  }
+
+  if (idle) {
+    auto prefix = fmt::format("store.hg.import_queue.client.{}.", pid);
+    for (auto name : {"queued", "running", "dispatched"}) {
+      fb303::fbData->clearCounter(prefix + name);
+    }
+  }
+}
+
+std::optional<HgImportRequestQueue::ClientStats>
+HgImportRequestQueue::getClientStats(pid_t pid) {
+  auto clients = clients_[getClientShard(pid)].clients.lock();
+  return folly::get_optional(*clients, pid);
+}
+
+void HgImportRequestQueue::publishClientCounters(
+    const std::vector<std::shared_ptr<HgImportRequest>>& requests) {
+  std::vector<pid_t> pids;
+  for (const auto& request : requests) {
+    auto pid = request->getClientPid();
+    if (pid && std::find(pids.begin(), pids.end(), *pid) == pids.end()) {
+      pids.push_back(*pid);
+    }
+  }
+
+  for (auto pid : pids) {
+    auto stats = getClientStats(pid);
+    if (!stats) {
+      continue;
+    }
+    auto prefix = fmt::format("store.hg.import_queue.client.{}.", pid);
+    fb303::fbData->setCounter(prefix + "queued", stats->queued);
+    fb303::fbData->setCounter(prefix + "running", stats->running);
+    fb303::fbData->setCounter(prefix + "dispatched", stats->dispatched);
+  }
 }
 
 std::vector<std::shared_ptr<HgImportRequest>>
 HgImportRequestQueue::combineAndClearRequestQueues() {
-  auto state = state_.lock();
-  auto treeQSz = state->treeQueue.size();
-  auto blobQSz = state->blobQueue.size();
+  std::vector<std::shared_ptr<HgImportRequest>> res;
+  size_t treeQSz = 0;
+  for (auto type : {kTreeType, kBlobType}) {
+    for (auto& queueLevel : levels_[type]) {
+      for (auto& shard : queueLevel.shards) {
+        auto heap = shard.heap.lock();
+        queueLevel.size.fetch_sub(heap->size(), std::memory_order_relaxed);
+        queued_.fetch_sub(heap->size(), std::memory_order_relaxed);
+        res.insert(
+            res.end(),
+            std::make_move_iterator(heap->begin()),
+            std::make_move_iterator(heap->end()));
+        heap->clear();
+      }
+    }
+    if (type == kTreeType) {
+      treeQSz = res.size();
+    }
+  }
   XLOGF(
       DBG5,
       "combineAndClearRequestQueues: tree queue size = {}, blob queue size = {}",
       treeQSz,
-      blobQSz);
-  auto res = std::move(state->treeQueue);
-  res.insert(
-      res.end(),
-      std::make_move_iterator(state->blobQueue.begin()),
-      std::make_move_iterator(state->blobQueue.end()));
-  state->treeQueue.clear();
-  state->blobQueue.clear();
-  XCHECK_EQ(res.size(), treeQSz + blobQSz);
+      res.size() - treeQSz);
+
+  // Tokens that aren't consumed here because their enqueue() hasn't posted
+  // them yet are dropped by dequeue() when it finds the queue empty.
+  for (size_t i = 0; i < res.size() && available_.tryWait(); ++i) {
+  }
+  for (auto& request : res) {
+    clientFinished(*request);
+  }
   return res;
 }
 
-std::vector<std::shared_ptr<HgImportRequest>> HgImportRequestQueue::dequeue() {
-  size_t count;
-  std::vector<std::shared_ptr<HgImportRequest>>* queue = nullptr;
+size_t HgImportRequestQueue::shedLowPriorityRequests(
+    const folly::exception_wrapper& ew) {
+  const auto lowLevel = getLevel(ImportPriority{ImportPriority::Class::Low});
+  std::vector<std::shared_ptr<HgImportRequest>> shed;
+  for (auto type : {kTreeType, kBlobType}) {
+    auto& queueLevel = levels_[type][lowLevel];
+    if (queueLevel.size.load(std::memory_order_acquire) == 0) {
+      continue;
+    }
+    for (auto& shard : queueLevel.shards) {
+      auto heap = shard.heap.lock();
+      queueLevel.size.fetch_sub(heap->size(), std::memory_order_relaxed);
+      queued_.fetch_sub(heap->size(), std::memory_order_relaxed);
+      shed.insert(
+          shed.end(),
+          std::make_move_iterator(heap->begin()),
+          std::make_move_iterator(heap->end()));
+      heap->clear();
+    }
+  }
 
-  auto state = state_.lock();
-  while (true) {
-    if (!state->running) {
-      state->treeQueue.clear();
-      state->blobQueue.clear();
-      return std::vector<std::shared_ptr<HgImportRequest>>();
+  size_t count = 0;
+  for (auto& request : shed) {
+    const auto& id = getRequestId(*request);
+    auto shard = getShard(id);
+    {
+      auto tracker = trackers_[shard].requests.lock();
+      auto level = getLevel(request->getPriority());
+      if (level != lowLevel) {
+        // A waiter raised its priority while it was out of the heaps.
+        push(request->getType(), level, shard, request);
+        queued_.fetch_add(1, std::memory_order_release);
+        continue;
+      }
+      auto it = tracker->find(id);
+      if (it != tracker->end() && it->second == request) {
+        tracker->erase(it);
+      }
     }
+    clientFinished(*request);
+    failPromises(*request, ew);
+    ++count;
+  }
 
-    auto highestPriority = ImportPriority::minimumValue();
+  // As in combineAndClearRequestQueues(), the tokens not consumed here are
+  // dropped by dequeue() when it finds the queue empty.
+  for (size_t i = 0; i < count && available_.tryWait(); ++i) {
+  }
+  if (count != 0) {
+    XLOGF(DBG2, "Shed {} low priority import requests", count);
+  }
+  return count;
+}
 
-    // Trees have a higher priority than blobs, thus check the queues in that
-    // order.  The reason for trees having a higher priority is due to trees
-    // allowing a higher fan-out and thus increasing concurrency of fetches
-    // which translate onto a higher overall throughput.
-    if (!state->treeQueue.empty()) {
-      count = config_->getEdenConfig()->importBatchSizeTree.getValue();
-      highestPriority = state->treeQueue.front()->getPriority();
-      queue = &state->treeQueue;
+std::vector<std::shared_ptr<HgImportRequest>> HgImportRequestQueue::dequeue() {
+  while (true) {
+    try {
+      available_.wait();
+    } catch (const folly::ShutdownSemError&) {
+      combineAndClearRequestQueues();
+      return std::vector<std::shared_ptr<HgImportRequest>>();
     }
 
-    if (!state->blobQueue.empty()) {
-      auto priority = state->blobQueue.front()->getPriority();
-      if (!queue || priority > highestPriority) {
-        queue = &state->blobQueue;
-        count = config_->getEdenConfig()->importBatchSize.getValue();
-        highestPriority = priority;
+    // A request is queued, but it may still be moving to another level after
+    // a priority bump.
+    while (queued_.load(std::memory_order_acquire) != 0) {
+      // Trees have a higher priority than blobs, thus check the queues in
+      // that order.  The reason for trees having a higher priority is due to
+      // trees allowing a higher fan-out and thus increasing concurrency of
+      // fetches which translate onto a higher overall throughput.
+      std::optional<size_t> type;
+      size_t level = kLevelCount;
+      while (!type && level-- > 0) {
+        auto hasTrees = levels_[kTreeType][level].size.load() != 0;
+        auto hasBlobs = levels_[kBlobType][level].size.load() != 0;
+        if (hasTrees && hasBlobs) {
+          auto treePriority = peek(kTreeType, level);
+          auto blobPriority = peek(kBlobType, level);
+          // Trees win ties.
+          type = blobPriority &&
+                  (!treePriority || *treePriority < *blobPriority)
+              ? kBlobType
+              : kTreeType;
+        } else if (hasTrees) {
+          type = kTreeType;
+        } else if (hasBlobs) {
+          type = kBlobType;
+        }
       }
-    }
 
-    if (queue) {
-      break;
-    } else {
-      queueCV_.wait(state.as_lock());
+      if (type) {
+        const auto& config = config_->getSnapshot();
+        size_t count;
+        if (*type == kTreeType) {
+          count = config.importBatchAdaptive.getValue()
+              ? treeBatchSize_.get()
+              : config.importBatchSizeTree.getValue();
+        } else {
+          count = config.importBatchAdaptive.getValue()
+              ? blobBatchSize_.get()
+              : config.importBatchSize.getValue();
+        }
+
+        size_t maxRunningPerClient = config.importFairShare.getValue()
+            ? config.importMaxInFlightPerClient.getValue()
+            : 0;
+        count = std::max<size_t>(count, 1);
+        auto result = popBatch(*type, level, count, maxRunningPerClient);
+        if (result.empty() && maxRunningPerClient != 0) {
+          // Only clients at their limit have requests queued, don't leave
+          // the worker idle.
+          result = popBatch(*type, level, count, 0);
+        }
+        if (!result.empty()) {
+          if (config.importFairShare.getValue()) {
+            publishClientCounters(result);
+          }
+          return result;
+        }
+      }
+      std::this_thread::yield();
     }
+    // The request was dropped by combineAndClearRequestQueues(), wait for
+    // the next one.
   }
+}
 
-  count = std::min(count, queue->size());
-  std::vector<std::shared_ptr<HgImportRequest>> result;
-  result.reserve(count);
-  for (size_t i = 0; i < count; i++) {
-    std::pop_heap(
-        queue->begin(),
-        queue->end(),
-        [](const std::shared_ptr<HgImportRequest>& lhs,
-           const std::shared_ptr<HgImportRequest>& rhs) {
-          return (*lhs) < (*rhs);
-        });
+void HgImportRequestQueue::recordBatch(
+    const std::vector<std::shared_ptr<HgImportRequest>>& requests,
+    std::chrono::steady_clock::time_point dequeueTime,
+    std::chrono::steady_clock::duration fetchLatency) {
+  const auto& config = config_->getSnapshot();
+  if (requests.empty() || !config.importBatchAdaptive.getValue()) {
+    return;
+  }
 
-    result.emplace_back(std::move(queue->back()));
-    queue->pop_back();
+  AdaptiveBatchSize::Sample sample;
+  sample.size = requests.size();
+  sample.fetchLatency = fetchLatency;
+  std::chrono::steady_clock::duration totalQueueWait{};
+  for (const auto& request : requests) {
+    auto queueWait = dequeueTime - request->getRequestTime();
+    totalQueueWait += queueWait;
+    if (request->getPriority().getClass() == ImportPriority::Class::High) {
+      sample.highPriorityLatencies.push_back(queueWait + fetchLatency);
+    }
   }
+  sample.averageQueueWait = totalQueueWait / requests.size();
 
-  return result;
+  auto isTree = requests.front()->isType<HgImportRequest::TreeImport>();
+  auto& batchSize = isTree ? treeBatchSize_ : blobBatchSize_;
+  auto size = batchSize.record(
+      sample,
+      config.importBatchTargetLatency.getValue(),
+      config.importBatchSizeMax.getValue());
+  fb303::fbData->setCounter(
+      isTree ? "store.hg.import_batch_size.tree"
+             : "store.hg.import_batch_size.blob",
+      size);
 }
 
 } // namespace facebook::eden
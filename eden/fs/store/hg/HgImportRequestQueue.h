@@ -7,13 +7,20 @@
 
 #pragma once
 
+#include <folly/CancellationToken.h>
 #include <folly/Synchronized.h>
 #include <folly/Try.h>
 #include <folly/container/F14Map.h>
-#include <condition_variable>
+#include <folly/lang/Align.h>
+#include <folly/synchronization/LifoSem.h>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <mutex>
+#include <optional>
 #include <vector>
 #include "eden/fs/model/Hash.h"
+#include "eden/fs/store/hg/AdaptiveBatchSize.h"
 #include "eden/fs/store/hg/HgImportRequest.h"
 #include "folly/futures/Future.h"
 
@@ -21,26 +28,58 @@ namespace facebook::eden {
 
 class ReloadableConfig;
 
+/**
+ * Queue of the blob and tree import requests waiting for an
+ * HgQueuedBackingStore worker, dequeued by priority.
+ *
+ * To let many threads enqueue concurrently, the queue is split in one level
+ * per ImportPriority class and request type, and each level in shards
+ * selected by the hash of the request. Each shard is a heap under its own
+ * lock, so that requests of a level are still dequeued by priority,
+ * adjustments included. Duplicate requests are detected in a request tracker
+ * that is sharded the same way.
+ *
+ * With `hg:import-fair-share`, the requests of each client process are
+ * interleaved with the ones of the other clients of the same priority class:
+ * the n-th request a client has queued is deprioritized by n, or by n times
+ * `hg:import-fair-share-deprioritized-weight` for deprioritized requests,
+ * e.g. from fetch-heavy processes. This is a weighted round-robin over the
+ * clients that keeps the heaps as they are. Additionally,
+ * `hg:import-max-in-flight-per-client` caps how many requests of a client
+ * are dispatched at once, as long as other clients have requests queued.
+ *
+ * Requests are removed from the queue once all their callers cancelled them,
+ * and failed when still queued past `hg:import-request-deadline`, so that
+ * abandoned work doesn't hold the import threads.
+ */
 class HgImportRequestQueue {
  public:
-  explicit HgImportRequestQueue(std::shared_ptr<ReloadableConfig> config)
-      : config_(std::move(config)) {}
+  explicit HgImportRequestQueue(std::shared_ptr<ReloadableConfig> config);
 
   /**
    * Enqueue a blob request to the queue.
    *
    * Return a future that will complete when the blob request completes.
+   *
+   * Once every caller waiting on the request had its cancellation requested,
+   * the request is removed from the queue, unless it was already dispatched,
+   * and its futures fail with folly::OperationCancelled. With
+   * `hg:import-request-deadline`, requests still queued after that long fail
+   * with folly::FutureTimeout instead of being dispatched.
    */
   folly::Future<std::unique_ptr<Blob>> enqueueBlob(
-      std::shared_ptr<HgImportRequest> request);
+      std::shared_ptr<HgImportRequest> request,
+      folly::CancellationToken cancellation = {});
 
   /**
    * Enqueue a tree request to the queue.
    *
    * Return a future that will complete when the blob request completes.
+   * Cancellation and deadlines are handled as for enqueueBlob().
    */
   folly::Future<std::unique_ptr<Tree>> enqueueTree(
-      std::shared_ptr<HgImportRequest> request);
+      std::shared_ptr<HgImportRequest> request,
+      folly::CancellationToken cancellation = {});
 
   /**
    * Returns a list of requests from the queue. It returns an empty list while
@@ -49,10 +88,66 @@ class HgImportRequestQueue {
    *
    * All requests in the vector are guaranteed to be the same type.
    * The number of the returned requests is controlled by `import-batch-size*`
-   * options in the config. It may have fewer requests than configured.
+   * options in the config, or adapted from the previous batches when
+   * `import-batch-adaptive` is set. It may have fewer requests than that.
    */
   std::vector<std::shared_ptr<HgImportRequest>> dequeue();
 
+  /**
+   * Report how a batch returned by dequeue() performed, so that the size of
+   * the next batches of this type can be adapted.
+   *
+   * dequeueTime is when the batch was dequeued, and fetchLatency how long
+   * fetching it took.
+   */
+  void recordBatch(
+      const std::vector<std::shared_ptr<HgImportRequest>>& requests,
+      std::chrono::steady_clock::time_point dequeueTime,
+      std::chrono::steady_clock::duration fetchLatency);
+
+  /**
+   * The current adaptive batch sizes, used when `import-batch-adaptive` is
+   * set.
+   */
+  size_t getAdaptiveBlobBatchSize() const {
+    return blobBatchSize_.get();
+  }
+  size_t getAdaptiveTreeBatchSize() const {
+    return treeBatchSize_.get();
+  }
+
+  /**
+   * Number of requests queued and not yet dispatched.
+   */
+  size_t getQueuedCount() const {
+    return queued_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Remove the queued requests of the Low priority class and fail them with
+   * ew. Used when the backing store is overloaded, see
+   * HgImportOverloadController. Returns the number of requests removed.
+   */
+  size_t shedLowPriorityRequests(const folly::exception_wrapper& ew);
+
+  /**
+   * The fair-share accounting of a client process.
+   */
+  struct ClientStats {
+    // Requests enqueued and not yet dispatched.
+    size_t queued = 0;
+    // Requests dispatched and not yet marked as finished.
+    size_t running = 0;
+    // Total requests dispatched.
+    uint64_t dispatched = 0;
+  };
+
+  /**
+   * Returns std::nullopt when the client has no queued or running requests
+   * accounted by `hg:import-fair-share`.
+   */
+  std::optional<ClientStats> getClientStats(pid_t pid);
+
   /**
    * Destroy the queue.
    *
@@ -63,26 +158,35 @@ class HgImportRequestQueue {
   void stop();
 
   /* ====== De-duplication methods ====== */
+  /**
+   * Whether an import of id is queued or in flight, i.e. enqueued and not yet
+   * marked as finished.
+   */
+  bool isTracked(const ObjectId& id) {
+    return trackers_[getShard(id)].requests.lock()->count(id) != 0;
+  }
+
   template <typename T>
   void markImportAsFinished(
       const ObjectId& id,
       folly::Try<std::unique_ptr<T>>& importTry) {
     std::shared_ptr<HgImportRequest> import;
     {
-      auto state = state_.lock();
+      auto tracker = trackers_[getShard(id)].requests.lock();
 
-      auto importReq = state->requestTracker.find(id);
-      if (importReq != state->requestTracker.end()) {
+      auto importReq = tracker->find(id);
+      if (importReq != tracker->end()) {
         import = std::move(importReq->second);
-        state->requestTracker.erase(importReq);
+        tracker->erase(importReq);
       }
     }
 
     if (!import) {
       return;
     }
+    clientFinished(*import);
 
-    std::vector<folly::Promise<std::unique_ptr<T>>>* promises;
+    folly::small_vector<folly::Promise<std::unique_ptr<T>>, 1>* promises;
 
     if constexpr (std::is_same_v<T, Tree>) {
       auto* treeImport = import->getRequest<HgImportRequest::TreeImport>();
@@ -100,13 +204,17 @@ class HgImportRequestQueue {
       // Promises and fulfill them with the obj. We need to construct a
       // deep copy of the unique_ptr to fulfill the Promises
       for (auto& promise : (*promises)) {
-        promise.setValue(std::make_unique<T>(*(importTry.value())));
+        if (!promise.isFulfilled()) {
+          promise.setValue(std::make_unique<T>(*(importTry.value())));
+        }
       }
     } else {
       // If we find the id in the map, loop through all of the associated
       // Promises and fulfill them with the exception
       for (auto& promise : (*promises)) {
-        promise.setException(importTry.exception());
+        if (!promise.isFulfilled()) {
+          promise.setException(importTry.exception());
+        }
       }
     }
   }
@@ -121,29 +229,154 @@ class HgImportRequestQueue {
    * Puts an item into the queue.
    */
   template <typename Ret, typename ImportType>
-  folly::Future<Ret> enqueue(std::shared_ptr<HgImportRequest> request);
+  folly::Future<Ret> enqueue(
+      std::shared_ptr<HgImportRequest> request,
+      folly::CancellationToken cancellation);
+
+  /**
+   * Queue the request, or add a waiter to the tracked request of the same
+   * object. tracked is set to the request that will be imported.
+   */
+  template <typename Ret, typename ImportType>
+  folly::Future<Ret> enqueueImpl(
+      std::shared_ptr<HgImportRequest> request,
+      std::shared_ptr<HgImportRequest>& tracked);
+
+  /**
+   * Called when a waiter of the request had its cancellation requested.
+   */
+  void cancelWaiter(const std::shared_ptr<HgImportRequest>& request);
+
+  static const ObjectId& getRequestId(HgImportRequest& request);
+
+  /**
+   * Remove a request taken out of the queue from the request tracker.
+   */
+  void untrack(const std::shared_ptr<HgImportRequest>& request);
+
+  /**
+   * Fail the promises of all the waiters of a request that won't be
+   * imported.
+   */
+  static void failPromises(
+      HgImportRequest& request,
+      const folly::exception_wrapper& ew);
 
   HgImportRequestQueue(HgImportRequestQueue&&) = delete;
   HgImportRequestQueue& operator=(HgImportRequestQueue&&) = delete;
 
-  struct State {
-    bool running = true;
-    std::vector<std::shared_ptr<HgImportRequest>> treeQueue;
-    std::vector<std::shared_ptr<HgImportRequest>> blobQueue;
+  static constexpr size_t kShardCount = 16;
+  // One level per ImportPriority::Class.
+  static constexpr size_t kLevelCount = 3;
+  // Indexed by HgImportRequest::getType().
+  static constexpr size_t kTypeCount = 2;
+
+  using RequestHeap = std::vector<std::shared_ptr<HgImportRequest>>;
+
+  struct alignas(folly::hardware_destructive_interference_size) HeapShard {
+    folly::Synchronized<RequestHeap, std::mutex> heap;
+  };
+
+  struct Level {
+    std::array<HeapShard, kShardCount> shards;
+    // Number of requests in the shards, to skip empty levels without locking
+    // them.
+    std::atomic<size_t> size{0};
+  };
 
+  struct alignas(folly::hardware_destructive_interference_size) TrackerShard {
     /**
-     * Map of a ObjectId to an element in the queue. Any changes to this type
-     * can have a significant effect on EdenFS performance and thus changes to
-     * it needs to be carefully studied and measured. The
+     * Map of a ObjectId to a queued or in-flight request. Any changes to this
+     * type can have a significant effect on EdenFS performance and thus
+     * changes to it needs to be carefully studied and measured. The
      * benchmarks/hg_import_request_queue.cpp is a good way to measure the
      * potential performance impact.
      */
-    folly::F14FastMap<ObjectId, std::shared_ptr<HgImportRequest>>
-        requestTracker;
+    folly::Synchronized<
+        folly::F14FastMap<ObjectId, std::shared_ptr<HgImportRequest>>,
+        std::mutex>
+        requests;
   };
+
+  struct alignas(folly::hardware_destructive_interference_size) ClientShard {
+    folly::Synchronized<folly::F14FastMap<pid_t, ClientStats>, std::mutex>
+        clients;
+  };
+
+  static size_t getShard(const ObjectId& id);
+  static size_t getClientShard(pid_t pid);
+  static size_t getLevel(ImportPriority priority);
+
+  /**
+   * Account a new request to its client, and deprioritize it by its position
+   * among the queued requests of that client.
+   */
+  void clientEnqueued(HgImportRequest& request, uint32_t deprioritizedWeight);
+
+  /**
+   * Account the dispatch of a request to its client, unless the client has
+   * maxRunning requests running already, 0 meaning no limit. Returns whether
+   * the request can be dispatched.
+   */
+  bool tryClientDispatch(HgImportRequest& request, size_t maxRunning);
+
+  /**
+   * Remove a request from the accounting of its client.
+   */
+  void clientFinished(HgImportRequest& request);
+
+  /**
+   * Update the per-client counters of the clients of a batch.
+   */
+  void publishClientCounters(
+      const std::vector<std::shared_ptr<HgImportRequest>>& requests);
+
+  /**
+   * Push the request on the heap of its level. The caller holds the lock of
+   * the request tracker shard.
+   */
+  void push(
+      size_t type,
+      size_t level,
+      size_t shard,
+      std::shared_ptr<HgImportRequest> request);
+
+  /**
+   * Priority of the highest priority request of a level, or std::nullopt if
+   * the level is empty.
+   */
+  std::optional<ImportPriority> peek(size_t type, size_t level);
+
+  /**
+   * Pop up to count requests of the given type by priority, starting at
+   * level and continuing with the lower priority levels. The caller consumed
+   * one token of available_, the others are consumed here.
+   *
+   * Requests of clients that have maxRunningPerClient requests running are
+   * skipped, 0 meaning no limit.
+   */
+  std::vector<std::shared_ptr<HgImportRequest>> popBatch(
+      size_t type,
+      size_t level,
+      size_t count,
+      size_t maxRunningPerClient);
+
   std::shared_ptr<ReloadableConfig> config_;
-  folly::Synchronized<State, std::mutex> state_;
-  std::condition_variable queueCV_;
+  AdaptiveBatchSize blobBatchSize_;
+  AdaptiveBatchSize treeBatchSize_;
+
+  std::array<std::array<Level, kLevelCount>, kTypeCount> levels_;
+  std::array<TrackerShard, kShardCount> trackers_;
+  std::array<ClientShard, kShardCount> clients_;
+
+  /**
+   * Posted once per queued request, after it was pushed: a dequeuer that
+   * waited on it is guaranteed that a request is queued.
+   */
+  folly::LifoSem available_;
+  // Total number of queued requests.
+  std::atomic<size_t> queued_{0};
+  std::atomic<bool> running_{true};
 };
 
 } // namespace facebook::eden
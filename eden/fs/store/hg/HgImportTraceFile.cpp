@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/HgImportTraceFile.h"
+
+#include <fcntl.h>
+#include <fmt/format.h>
+#include <folly/Exception.h>
+#include <folly/FileUtil.h>
+#include <folly/logging/xlog.h>
+#include <cstring>
+
+#include "eden/fs/store/hg/HgQueuedBackingStore.h"
+
+namespace facebook::eden {
+
+namespace {
+
+constexpr folly::StringPiece kMagic{"eden-hg-import-trace-v1\n"};
+
+// Writing the events in chunks keeps the TraceBus subscriber from making a
+// syscall per import.
+constexpr size_t kFlushSize = 64 * 1024;
+
+} // namespace
+
+HgImportTraceWriter::HgImportTraceWriter(AbsolutePathPiece path)
+    : file_{path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644} {
+  buffer_.reserve(kFlushSize);
+  buffer_.append(kMagic.data(), kMagic.size());
+}
+
+HgImportTraceWriter::~HgImportTraceWriter() {
+  try {
+    flush();
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "failed to write the end of the hg import trace: "
+              << folly::exceptionStr(ex);
+  }
+}
+
+void HgImportTraceWriter::write(const HgImportTraceEvent& event) {
+  // The length is only known once the event is encoded after it.
+  auto lengthOffset = buffer_.size();
+  uint32_t length = 0;
+  ActivityBufferEncoding::append(buffer_, length);
+  ActivityBufferCodec<HgImportTraceEvent>::encode(event, buffer_);
+  auto eventOffset = lengthOffset + sizeof(length);
+  length = static_cast<uint32_t>(buffer_.size() - eventOffset);
+  std::memcpy(buffer_.data() + lengthOffset, &length, sizeof(length));
+  if (buffer_.size() >= kFlushSize) {
+    flush();
+  }
+}
+
+void HgImportTraceWriter::flush() {
+  if (buffer_.empty()) {
+    return;
+  }
+  auto written = folly::writeFull(file_.fd(), buffer_.data(), buffer_.size());
+  folly::checkUnixError(written, "failed to write the hg import trace");
+  buffer_.clear();
+}
+
+std::vector<HgImportTraceEvent> readHgImportTrace(AbsolutePathPiece path) {
+  std::string contents;
+  if (!folly::readFile(path.c_str(), contents)) {
+    folly::throwSystemError(fmt::format("failed to read {}", path));
+  }
+  folly::ByteRange in{folly::StringPiece{contents}};
+  if (!in.startsWith(folly::ByteRange{kMagic})) {
+    throw std::invalid_argument(
+        fmt::format("{} is not an hg import trace", path));
+  }
+  in.advance(kMagic.size());
+
+  std::vector<HgImportTraceEvent> events;
+  while (!in.empty()) {
+    if (in.size() < sizeof(uint32_t)) {
+      throw std::invalid_argument(fmt::format("{} is truncated", path));
+    }
+    auto length = ActivityBufferEncoding::read<uint32_t>(in);
+    if (in.size() < length) {
+      throw std::invalid_argument(fmt::format("{} is truncated", path));
+    }
+    events.push_back(ActivityBufferCodec<HgImportTraceEvent>::decode(
+        in.subpiece(0, length)));
+    in.advance(length);
+  }
+  return events;
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/File.h>
+#include <string>
+#include <vector>
+
+#include "eden/fs/utils/PathFuncs.h"
+
+namespace facebook::eden {
+
+struct HgImportTraceEvent;
+
+/**
+ * Records HgImportTraceEvents into a file, to replay the import requests of
+ * a real workload, e.g. with the hg_import_replay benchmark.
+ *
+ * Every event is stored as the 32-bit length of its ActivityBufferCodec
+ * encoding followed by that encoding, which uses the in-memory layout of its
+ * fields: traces are only meant to be read by the build that wrote them.
+ *
+ * Not thread safe, events are expected to be written from a TraceBus
+ * subscriber.
+ */
+class HgImportTraceWriter {
+ public:
+  /** Creates or truncates the file at path. Throws if it can't be opened. */
+  explicit HgImportTraceWriter(AbsolutePathPiece path);
+
+  /** Flushes the events still buffered, errors are only logged. */
+  ~HgImportTraceWriter();
+
+  HgImportTraceWriter(const HgImportTraceWriter&) = delete;
+  HgImportTraceWriter& operator=(const HgImportTraceWriter&) = delete;
+
+  void write(const HgImportTraceEvent& event);
+
+  /** Writes the buffered events to the file. */
+  void flush();
+
+ private:
+  folly::File file_;
+  std::string buffer_;
+};
+
+/**
+ * Reads all the events of a trace written by HgImportTraceWriter, in the
+ * order they were written. Throws if the file isn't such a trace.
+ */
+std::vector<HgImportTraceEvent> readHgImportTrace(AbsolutePathPiece path);
+
+} // namespace facebook::eden
@@ -70,30 +70,32 @@ folly::Future<std::vector<HgProxyHash>> HgProxyHash::getBatch(
     LocalStore* store,
     ObjectIdRange blobHashes,
     EdenStats& edenStats) {
-  std::vector<HgProxyHash> embedded_results;
+  // Results are in the same order as blobHashes. Only the hashes that aren't
+  // embedded in their ObjectId are looked up, with a single getBatch call.
+  std::vector<HgProxyHash> results(blobHashes.size());
+  std::vector<size_t> storedIndices;
   std::vector<ByteRange> byteRanges;
-  for (const auto& hash : blobHashes) {
-    if (auto embedded = tryParseEmbeddedProxyHash(hash)) {
-      embedded_results.push_back(*embedded);
+  for (size_t i = 0; i < blobHashes.size(); ++i) {
+    if (auto embedded = tryParseEmbeddedProxyHash(blobHashes[i])) {
+      results[i] = std::move(*embedded);
     } else {
-      byteRanges.push_back(hash.getBytes());
+      storedIndices.push_back(i);
+      byteRanges.push_back(blobHashes[i].getBytes());
     }
   }
   if (byteRanges.empty()) {
-    return folly::Future<std::vector<HgProxyHash>>{std::move(embedded_results)};
+    return folly::Future<std::vector<HgProxyHash>>{std::move(results)};
   }
   edenStats.increment(&HgBackingStoreStats::loadProxyHash, byteRanges.size());
   return store->getBatch(KeySpace::HgProxyHashFamily, byteRanges)
-      .thenValue([embedded_results,
-                  byteRanges](std::vector<StoreResult>&& data) {
-        std::vector<HgProxyHash> results{embedded_results};
-
+      .thenValue([results = std::move(results),
+                  storedIndices = std::move(storedIndices),
+                  byteRanges](std::vector<StoreResult>&& data) mutable {
         for (size_t i = 0; i < byteRanges.size(); ++i) {
-          results.emplace_back(HgProxyHash{
-              ObjectId{byteRanges.at(i)}, data[i], "prefetchFiles getBatch"});
+          results[storedIndices[i]] = HgProxyHash{
+              ObjectId{byteRanges[i]}, data[i], "prefetchFiles getBatch"};
         }
-
-        return results;
+        return std::move(results);
       });
 }
 
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/HgProxyHashCache.h"
+
+#include <folly/futures/Future.h>
+#include <algorithm>
+
+#include "eden/fs/telemetry/EdenStats.h"
+
+namespace facebook::eden {
+
+HgProxyHashCache::HgProxyHashCache(size_t maxEntries)
+    : enabled_{maxEntries != 0} {
+  auto perShard = std::max<size_t>(maxEntries / kShardCount, 1);
+  for (auto& shard : shards_) {
+    shard.entries.lock()->setMaxSize(perShard);
+  }
+}
+
+HgProxyHashCache::Shard& HgProxyHashCache::getShard(const Hash20& key) {
+  return shards_[std::hash<Hash20>{}(key) % kShardCount];
+}
+
+std::optional<HgProxyHash> HgProxyHashCache::get(const ObjectId& edenObjectId) {
+  if (!enabled_ || !isLegacy(edenObjectId)) {
+    return std::nullopt;
+  }
+  Hash20 key{edenObjectId.getBytes()};
+  auto entries = getShard(key).entries.lock();
+  auto it = entries->find(key);
+  if (it == entries->end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+void HgProxyHashCache::insert(
+    const ObjectId& edenObjectId,
+    const HgProxyHash& proxyHash) {
+  if (!enabled_ || !isLegacy(edenObjectId)) {
+    return;
+  }
+  Hash20 key{edenObjectId.getBytes()};
+  getShard(key).entries.lock()->set(key, proxyHash);
+}
+
+HgProxyHash HgProxyHashCache::load(
+    LocalStore* store,
+    const ObjectId& edenObjectId,
+    folly::StringPiece context,
+    EdenStats& stats) {
+  if (auto cached = get(edenObjectId)) {
+    stats.increment(&HgBackingStoreStats::loadProxyHashCached);
+    return std::move(*cached);
+  }
+  auto proxyHash = HgProxyHash::load(store, edenObjectId, context, stats);
+  insert(edenObjectId, proxyHash);
+  return proxyHash;
+}
+
+folly::Future<std::vector<HgProxyHash>> HgProxyHashCache::getBatch(
+    LocalStore* store,
+    ObjectIdRange ids,
+    EdenStats& stats) {
+  std::vector<HgProxyHash> results(ids.size());
+  std::vector<size_t> missingIndices;
+  std::vector<ObjectId> missingIds;
+  size_t cached = 0;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    if (auto proxyHash = get(ids[i])) {
+      results[i] = std::move(*proxyHash);
+      ++cached;
+    } else {
+      missingIndices.push_back(i);
+      missingIds.push_back(ids[i]);
+    }
+  }
+  if (cached != 0) {
+    stats.increment(&HgBackingStoreStats::loadProxyHashCached, cached);
+  }
+  if (missingIds.empty()) {
+    return folly::Future<std::vector<HgProxyHash>>{std::move(results)};
+  }
+
+  // Moving missingIds into the continuation doesn't move its elements, the
+  // range stays valid.
+  auto missingRange = folly::range(missingIds);
+  return HgProxyHash::getBatch(store, missingRange, stats)
+      .thenValue([this,
+                  results = std::move(results),
+                  missingIndices = std::move(missingIndices),
+                  missingIds = std::move(missingIds)](
+                     std::vector<HgProxyHash>&& loaded) mutable {
+        for (size_t i = 0; i < loaded.size(); ++i) {
+          insert(missingIds[i], loaded[i]);
+          results[missingIndices[i]] = std::move(loaded[i]);
+        }
+        return std::move(results);
+      });
+}
+
+} // namespace facebook::eden
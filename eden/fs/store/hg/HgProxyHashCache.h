@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <folly/lang/Align.h>
+#include <array>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "eden/fs/model/Hash.h"
+#include "eden/fs/store/hg/HgProxyHash.h"
+
+namespace folly {
+template <typename T>
+class Future;
+} // namespace folly
+
+namespace facebook::eden {
+
+class EdenStats;
+class LocalStore;
+
+/**
+ * In-memory cache of the HgProxyHash of legacy ObjectIds.
+ *
+ * ObjectIds that embed their proxy hash (see
+ * HgProxyHash::makeEmbeddedProxyHash1/2) are parsed directly, the legacy
+ * 20-byte ones need a LocalStore read to find their path and revision. This
+ * cache keeps the most recently used of them, keyed by their 20 bytes, so
+ * that imports of the same legacy ids don't block on LocalStore again.
+ */
+class HgProxyHashCache {
+ public:
+  /**
+   * maxEntries is split evenly between the shards, 0 disables the cache.
+   */
+  explicit HgProxyHashCache(size_t maxEntries);
+
+  /**
+   * Same as HgProxyHash::load, but consults the cache before LocalStore.
+   */
+  HgProxyHash load(
+      LocalStore* store,
+      const ObjectId& edenObjectId,
+      folly::StringPiece context,
+      EdenStats& stats);
+
+  /**
+   * Same as HgProxyHash::getBatch, but only the ids missing from the cache
+   * are read from LocalStore.
+   *
+   * The caller is responsible for keeping the ObjectIdRange alive for the
+   * duration of the future.
+   */
+  folly::Future<std::vector<HgProxyHash>>
+  getBatch(LocalStore* store, ObjectIdRange ids, EdenStats& stats);
+
+  std::optional<HgProxyHash> get(const ObjectId& edenObjectId);
+  void insert(const ObjectId& edenObjectId, const HgProxyHash& proxyHash);
+
+ private:
+  static constexpr size_t kShardCount = 16;
+
+  using Map = folly::EvictingCacheMap<Hash20, HgProxyHash>;
+
+  struct alignas(folly::hardware_destructive_interference_size) Shard {
+    // Resized by the constructor.
+    folly::Synchronized<Map, std::mutex> entries{std::in_place, 0};
+  };
+
+  static bool isLegacy(const ObjectId& edenObjectId) {
+    return edenObjectId.size() == Hash20::RAW_SIZE;
+  }
+
+  Shard& getShard(const Hash20& key);
+
+  bool enabled_;
+  std::array<Shard, kShardCount> shards_;
+};
+
+} // namespace facebook::eden
@@ -8,14 +8,17 @@
 #include "eden/fs/store/hg/HgQueuedBackingStore.h"
 
 #include <chrono>
+#include <system_error>
 #include <thread>
 #include <utility>
 #include <variant>
 
+#include <fb303/ServiceData.h>
 #include <re2/re2.h>
 
 #include <folly/Range.h>
 #include <folly/String.h>
+#include <folly/executors/InlineExecutor.h>
 #include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/GFlags.h>
@@ -25,6 +28,7 @@
 #include "eden/fs/model/Blob.h"
 #include "eden/fs/service/ThriftUtil.h"
 #include "eden/fs/store/BackingStoreLogger.h"
+#include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/store/LocalStore.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/hg/HgBackingStore.h"
@@ -36,6 +40,7 @@
 #include "eden/fs/utils/Bug.h"
 #include "eden/fs/utils/EnumValue.h"
 #include "eden/fs/utils/IDGen.h"
+#include "eden/fs/utils/NumaTopology.h"
 #include "eden/fs/utils/PathFuncs.h"
 #include "eden/fs/utils/StaticAssert.h"
 #include "eden/fs/utils/Throw.h"
@@ -50,6 +55,33 @@ static_assert(CheckSize<HgImportTraceEvent, 64>());
 // 10 MB overhead per backing repo is tolerable.
 static_assert(
     CheckEqual<6400000, kTraceBusCapacity * sizeof(HgImportTraceEvent)>());
+
+folly::exception_wrapper makeOverloadError() {
+  return folly::make_exception_wrapper<std::system_error>(
+      EAGAIN,
+      std::generic_category(),
+      "import not queued: the backing store is overloaded");
+}
+
+class SpeculativeTreePrefetchContext : public ObjectFetchContext {
+ public:
+  Cause getCause() const override {
+    return Cause::Prefetch;
+  }
+
+  std::optional<std::string_view> getCauseDetail() const override {
+    return "speculative-tree-prefetch";
+  }
+
+  ImportPriority getPriority() const override {
+    return kSpeculativeTreePrefetchPriority;
+  }
+
+  const std::unordered_map<std::string, std::string>* FOLLY_NULLABLE
+  getRequestInfo() const override {
+    return nullptr;
+  }
+};
 } // namespace
 
 HgImportTraceEvent::HgImportTraceEvent(
@@ -71,6 +103,46 @@ HgImportTraceEvent::HgImportTraceEvent(
   path[hgPath.size()] = 0;
 }
 
+void ActivityBufferCodec<HgImportTraceEvent>::encode(
+    const HgImportTraceEvent& event,
+    std::string& out) {
+  ActivityBufferEncoding::append(out, event.systemTime);
+  ActivityBufferEncoding::append(out, event.monotonicTime);
+  ActivityBufferEncoding::append(out, event.unique);
+  auto nodeId = event.manifestNodeId.getBytes();
+  out.append(reinterpret_cast<const char*>(nodeId.data()), nodeId.size());
+  ActivityBufferEncoding::append(out, event.eventType);
+  ActivityBufferEncoding::append(out, event.resourceType);
+  ActivityBufferEncoding::append(out, event.importPriority);
+  ActivityBufferEncoding::append(out, event.importCause);
+  ActivityBufferEncoding::append(out, event.fetchedSource);
+  out.append(event.path.get());
+}
+
+HgImportTraceEvent ActivityBufferCodec<HgImportTraceEvent>::decode(
+    folly::ByteRange in) {
+  HgImportTraceEvent event;
+  event.systemTime =
+      ActivityBufferEncoding::read<std::chrono::system_clock::time_point>(in);
+  event.monotonicTime =
+      ActivityBufferEncoding::read<std::chrono::steady_clock::time_point>(in);
+  event.unique = ActivityBufferEncoding::read<uint64_t>(in);
+  event.manifestNodeId = Hash20{in.subpiece(0, Hash20::RAW_SIZE)};
+  in.advance(Hash20::RAW_SIZE);
+  event.eventType =
+      ActivityBufferEncoding::read<HgImportTraceEvent::EventType>(in);
+  event.resourceType =
+      ActivityBufferEncoding::read<HgImportTraceEvent::ResourceType>(in);
+  event.importPriority =
+      ActivityBufferEncoding::read<ImportPriority::Class>(in);
+  event.importCause =
+      ActivityBufferEncoding::read<ObjectFetchContext::Cause>(in);
+  event.fetchedSource =
+      ActivityBufferEncoding::read<HgImportRequest::FetchedSource>(in);
+  event.path = ActivityBufferEncoding::readRemainingString(in);
+  return event;
+}
+
 HgQueuedBackingStore::HgQueuedBackingStore(
     std::shared_ptr<LocalStore> localStore,
     std::shared_ptr<EdenStats> stats,
@@ -83,8 +155,15 @@ HgQueuedBackingStore::HgQueuedBackingStore(
       config_(config),
       backingStore_(std::move(backingStore)),
       queue_(std::move(config)),
+      proxyHashCache_{
+          config_->getEdenConfig()->hgProxyHashCacheSize.getValue()},
       structuredLogger_{std::move(structuredLogger)},
       logger_(std::move(logger)),
+      asyncBatchFetch_{config_->getEdenConfig()->asyncBatchFetch.getValue()},
+      maxInFlightBatches_{std::max<uint32_t>(
+          config_->getEdenConfig()->maxInFlightBatches.getValue(),
+          1)},
+      inFlightBatches_{maxInFlightBatches_},
       activityBuffer_(initActivityBuffer()),
       traceBus_{TraceBus<HgImportTraceEvent>::create("hg", kTraceBusCapacity)} {
   uint8_t numberThreads =
@@ -94,11 +173,19 @@ HgQueuedBackingStore::HgQueuedBackingStore(
         << "HgQueuedBackingStore configured to use 0 threads. Invalid, using one thread instead";
     numberThreads = 1;
   }
+  bool numaAffinity =
+      config_->getEdenConfig()->backingstoreNumaAffinity.getValue();
   threads_.reserve(numberThreads);
   for (uint16_t i = 0; i < numberThreads; i++) {
-    threads_.emplace_back(&HgQueuedBackingStore::processRequest, this);
+    threads_.emplace_back([this, i, numaAffinity] {
+      if (numaAffinity) {
+        NumaTopology::get().bindThreadToNode(i);
+      }
+      processRequest();
+    });
   }
   subscribeActivityBuffer();
+  subscribeTraceRecorder();
 }
 
 HgQueuedBackingStore::~HgQueuedBackingStore() {
@@ -106,13 +193,21 @@ HgQueuedBackingStore::~HgQueuedBackingStore() {
   for (auto& thread : threads_) {
     thread.join();
   }
+  if (asyncBatchFetch_) {
+    // Wait for the batches still in flight, they reference this.
+    for (uint32_t i = 0; i < maxInFlightBatches_; i++) {
+      inFlightBatches_.wait();
+    }
+  }
 }
 
 std::optional<ActivityBuffer<HgImportTraceEvent>>
 HgQueuedBackingStore::initActivityBuffer() {
-  if (config_->getEdenConfig()->enableActivityBuffer.getValue()) {
+  auto edenConfig = config_->getEdenConfig();
+  if (edenConfig->enableActivityBuffer.getValue()) {
     return std::make_optional<ActivityBuffer<HgImportTraceEvent>>(
-        config_->getEdenConfig()->ActivityBufferMaxEvents.getValue());
+        edenConfig->ActivityBufferMaxEvents.getValue(),
+        edenConfig->ActivityBufferMaxBytes.getValue());
   }
   return std::nullopt;
 }
@@ -134,6 +229,33 @@ void HgQueuedBackingStore::subscribeActivityBuffer() {
   }
 }
 
+void HgQueuedBackingStore::subscribeTraceRecorder() {
+  auto traceFile = config_->getEdenConfig()->hgImportTraceFile.getValue();
+  if (traceFile.empty()) {
+    return;
+  }
+  try {
+    traceWriter_ =
+        std::make_unique<HgImportTraceWriter>(canonicalPath(traceFile));
+  } catch (const std::exception& ex) {
+    XLOG(ERR) << "not recording the hg import trace to " << traceFile << ": "
+              << folly::exceptionStr(ex);
+    return;
+  }
+  XLOG(INFO) << "recording the hg import trace to " << traceFile;
+
+  hgTraceHandle_->recordHandle = traceBus_->subscribeFunction(
+      folly::to<std::string>("hg-record-", getRepoName().value_or("")),
+      [this](const HgImportTraceEvent& event) {
+        try {
+          traceWriter_->write(event);
+        } catch (const std::exception& ex) {
+          XLOG_EVERY_MS(ERR, 10000) << "failed to record the hg import trace: "
+                                    << folly::exceptionStr(ex);
+        }
+      });
+}
+
 void HgQueuedBackingStore::processBlobImportRequests(
     std::vector<std::shared_ptr<HgImportRequest>>&& requests) {
   folly::stop_watch<std::chrono::milliseconds> watch;
@@ -153,40 +275,65 @@ void HgQueuedBackingStore::processBlobImportRequests(
     XLOGF(DBG4, "Processing blob request for {}", blobImport->hash);
   }
 
+  auto fetchStart = std::chrono::steady_clock::now();
+  if (asyncBatchFetch_) {
+    inFlightBatches_.wait();
+    backingStore_->getDatapackStore()
+        .getBlobBatchAsync(requests)
+        .via(&folly::InlineExecutor::instance())
+        .thenValue([this, requests = std::move(requests), fetchStart, watch](
+                       folly::Unit) mutable {
+          recordBatch(
+              requests,
+              fetchStart,
+              std::chrono::steady_clock::now() - fetchStart);
+          return importRemainingBlobs(std::move(requests), watch);
+        })
+        .ensure([this] { inFlightBatches_.post(); });
+    return;
+  }
+
   backingStore_->getDatapackStore().getBlobBatch(requests);
+  recordBatch(
+      requests, fetchStart, std::chrono::steady_clock::now() - fetchStart);
+  importRemainingBlobs(std::move(requests), watch).wait();
+}
 
-  {
-    std::vector<folly::SemiFuture<folly::Unit>> futures;
-    futures.reserve(requests.size());
-
-    for (auto& request : requests) {
-      auto* promise = request->getPromise<std::unique_ptr<Blob>>();
-      if (promise->isFulfilled()) {
-        stats_->addDuration(&HgBackingStoreStats::getBlob, watch.elapsed());
-        continue;
-      }
+folly::SemiFuture<folly::Unit> HgQueuedBackingStore::importRemainingBlobs(
+    std::vector<std::shared_ptr<HgImportRequest>>&& requests,
+    folly::stop_watch<std::chrono::milliseconds> watch) {
+  std::vector<folly::SemiFuture<folly::Unit>> futures;
+  futures.reserve(requests.size());
 
-      // The blobs were either not found locally, or, when EdenAPI is enabled,
-      // not found on the server. Let's import the blob through the hg importer.
-      // TODO(xavierd): remove when EdenAPI has been rolled out everywhere.
-      auto fetchSemiFuture = backingStore_->fetchBlobFromHgImporter(
-          request->getRequest<HgImportRequest::BlobImport>()->proxyHash);
-      futures.emplace_back(
-          std::move(fetchSemiFuture)
-              .defer([request = std::move(request), watch, stats = stats_](
-                         auto&& result) mutable {
-                XLOG(DBG4)
-                    << "Imported blob from HgImporter for "
-                    << request->getRequest<HgImportRequest::BlobImport>()->hash;
-                stats->addDuration(
-                    &HgBackingStoreStats::getBlob, watch.elapsed());
-                request->getPromise<HgImportRequest::BlobImport::Response>()
-                    ->setTry(std::forward<decltype(result)>(result));
-              }));
+  for (auto& request : requests) {
+    auto* promise = request->getPromise<std::unique_ptr<Blob>>();
+    if (promise->isFulfilled()) {
+      stats_->addDuration(&HgBackingStoreStats::getBlob, watch.elapsed());
+      continue;
     }
 
-    folly::collectAll(futures).wait();
+    // The blobs were either not found locally, or, when EdenAPI is enabled,
+    // not found on the server. Let's import the blob through the hg importer.
+    // TODO(xavierd): remove when EdenAPI has been rolled out everywhere.
+    auto fetchSemiFuture = backingStore_->fetchBlobFromHgImporter(
+        request->getRequest<HgImportRequest::BlobImport>()->proxyHash);
+    futures.emplace_back(
+        std::move(fetchSemiFuture)
+            .defer([request = std::move(request), watch, stats = stats_](
+                       auto&& result) mutable {
+              XLOG(DBG4)
+                  << "Imported blob from HgImporter for "
+                  << request->getRequest<HgImportRequest::BlobImport>()->hash;
+              stats->addDuration(
+                  &HgBackingStoreStats::getBlob, watch.elapsed());
+              request->setFetchedSource(
+                  HgImportRequest::FetchedSource::HgImporter);
+              request->getPromise<HgImportRequest::BlobImport::Response>()
+                  ->setTry(std::forward<decltype(result)>(result));
+            }));
   }
+
+  return folly::collectAll(futures).unit();
 }
 
 void HgQueuedBackingStore::processTreeImportRequests(
@@ -206,40 +353,65 @@ void HgQueuedBackingStore::processTreeImportRequests(
     XLOGF(DBG4, "Processing tree request for {}", treeImport->hash);
   }
 
+  auto fetchStart = std::chrono::steady_clock::now();
+  if (asyncBatchFetch_) {
+    inFlightBatches_.wait();
+    backingStore_->getDatapackStore()
+        .getTreeBatchAsync(requests)
+        .via(&folly::InlineExecutor::instance())
+        .thenValue([this, requests = std::move(requests), fetchStart, watch](
+                       folly::Unit) mutable {
+          recordBatch(
+              requests,
+              fetchStart,
+              std::chrono::steady_clock::now() - fetchStart);
+          return importRemainingTrees(std::move(requests), watch);
+        })
+        .ensure([this] { inFlightBatches_.post(); });
+    return;
+  }
+
   backingStore_->getDatapackStore().getTreeBatch(requests);
+  recordBatch(
+      requests, fetchStart, std::chrono::steady_clock::now() - fetchStart);
+  importRemainingTrees(std::move(requests), watch).wait();
+}
 
-  {
-    std::vector<folly::SemiFuture<folly::Unit>> futures;
-    futures.reserve(requests.size());
-
-    for (auto& request : requests) {
-      auto* promise = request->getPromise<std::unique_ptr<Tree>>();
-      if (promise->isFulfilled()) {
-        stats_->addDuration(&HgBackingStoreStats::getTree, watch.elapsed());
-        continue;
-      }
+folly::SemiFuture<folly::Unit> HgQueuedBackingStore::importRemainingTrees(
+    std::vector<std::shared_ptr<HgImportRequest>>&& requests,
+    folly::stop_watch<std::chrono::milliseconds> watch) {
+  std::vector<folly::SemiFuture<folly::Unit>> futures;
+  futures.reserve(requests.size());
 
-      // The trees were either not found locally, or, when EdenAPI is enabled,
-      // not found on the server. Let's import the trees through the hg
-      // importer.
-      // TODO(xavierd): remove when EdenAPI has been rolled out everywhere.
-      auto treeSemiFuture = backingStore_->getTree(request);
-      futures.emplace_back(
-          std::move(treeSemiFuture)
-              .defer([request = std::move(request), watch, stats = stats_](
-                         auto&& result) mutable {
-                XLOG(DBG4)
-                    << "Imported tree from HgImporter for "
-                    << request->getRequest<HgImportRequest::TreeImport>()->hash;
-                stats->addDuration(
-                    &HgBackingStoreStats::getTree, watch.elapsed());
-                request->getPromise<HgImportRequest::TreeImport::Response>()
-                    ->setTry(std::forward<decltype(result)>(result));
-              }));
+  for (auto& request : requests) {
+    auto* promise = request->getPromise<std::unique_ptr<Tree>>();
+    if (promise->isFulfilled()) {
+      stats_->addDuration(&HgBackingStoreStats::getTree, watch.elapsed());
+      continue;
     }
 
-    folly::collectAll(futures).wait();
+    // The trees were either not found locally, or, when EdenAPI is enabled,
+    // not found on the server. Let's import the trees through the hg
+    // importer.
+    // TODO(xavierd): remove when EdenAPI has been rolled out everywhere.
+    auto treeSemiFuture = backingStore_->getTree(request);
+    futures.emplace_back(
+        std::move(treeSemiFuture)
+            .defer([request = std::move(request), watch, stats = stats_](
+                       auto&& result) mutable {
+              XLOG(DBG4)
+                  << "Imported tree from HgImporter for "
+                  << request->getRequest<HgImportRequest::TreeImport>()->hash;
+              stats->addDuration(
+                  &HgBackingStoreStats::getTree, watch.elapsed());
+              request->setFetchedSource(
+                  HgImportRequest::FetchedSource::HgImporter);
+              request->getPromise<HgImportRequest::TreeImport::Response>()
+                  ->setTry(std::forward<decltype(result)>(result));
+            }));
   }
+
+  return folly::collectAll(futures).unit();
 }
 
 void HgQueuedBackingStore::processRequest() {
@@ -261,6 +433,95 @@ void HgQueuedBackingStore::processRequest() {
   }
 }
 
+void HgQueuedBackingStore::recordBatch(
+    const std::vector<std::shared_ptr<HgImportRequest>>& requests,
+    std::chrono::steady_clock::time_point dequeueTime,
+    std::chrono::steady_clock::duration fetchLatency) {
+  queue_.recordBatch(requests, dequeueTime, fetchLatency);
+  if (requests.empty()) {
+    return;
+  }
+
+  std::chrono::steady_clock::duration totalQueueWait{};
+  for (const auto& request : requests) {
+    totalQueueWait += dequeueTime - request->getRequestTime();
+  }
+  overloadController_.recordLatency(
+      totalQueueWait / requests.size() + fetchLatency);
+  updateOverload();
+}
+
+void HgQueuedBackingStore::updateOverload() {
+  const auto& config = config_->getSnapshot();
+  HgImportOverloadController::Limits limits;
+  limits.maxQueueDepth = config.importOverloadQueueDepth.getValue();
+  limits.maxLatency = config.importOverloadLatency.getValue();
+  auto queueDepth = queue_.getQueuedCount();
+  auto transition = overloadController_.update(
+      queueDepth, limits, std::chrono::steady_clock::now());
+  if (transition == HgImportOverloadController::Transition::None) {
+    return;
+  }
+
+  bool overloaded =
+      transition == HgImportOverloadController::Transition::Entered;
+  auto latencyMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       overloadController_.getAverageLatency())
+                       .count();
+  fb303::fbData->setCounter("store.hg.overloaded", overloaded ? 1 : 0);
+  structuredLogger_->logEvent(
+      HgImportOverload{overloaded, queueDepth, latencyMs});
+  if (overloaded) {
+    stats_->increment(&HgBackingStoreStats::overloadEntered);
+    auto shed = queue_.shedLowPriorityRequests(makeOverloadError());
+    stats_->increment(&HgBackingStoreStats::importShed, shed);
+    XLOGF(
+        WARN,
+        "Backing store overloaded: {} queued imports, {}ms average latency, "
+        "shed {} low priority imports",
+        queueDepth,
+        latencyMs,
+        shed);
+  } else {
+    stats_->increment(&HgBackingStoreStats::overloadLeft);
+    XLOGF(
+        WARN,
+        "Backing store no longer overloaded: {} queued imports, {}ms "
+        "average latency",
+        queueDepth,
+        latencyMs);
+  }
+}
+
+std::optional<folly::exception_wrapper> HgQueuedBackingStore::checkOverload(
+    const ObjectFetchContext& context) {
+  updateOverload();
+  switch (overloadController_.admit(context.getPriority())) {
+    case HgImportOverloadController::Admission::Accept:
+      return std::nullopt;
+    case HgImportOverloadController::Admission::Shed:
+      stats_->increment(&HgBackingStoreStats::importShed);
+      break;
+    case HgImportOverloadController::Admission::FailFast:
+      stats_->increment(&HgBackingStoreStats::importFailedFast);
+      break;
+  }
+  return makeOverloadError();
+}
+
+std::optional<ObjectId> HgQueuedBackingStore::migrateObjectId(
+    const ObjectId& id) {
+  if (HgProxyHash::tryParseEmbeddedProxyHash(id)) {
+    return std::nullopt;
+  }
+  auto proxyHash =
+      proxyHashCache_.load(localStore_.get(), id, "migrateObjectId", *stats_);
+  return HgProxyHash::store(
+      proxyHash.path(),
+      proxyHash.revHash(),
+      config_->getEdenConfig()->hgObjectIdFormat.getValue());
+}
+
 ObjectComparison HgQueuedBackingStore::compareObjectsById(
     const ObjectId& one,
     const ObjectId& two) {
@@ -276,9 +537,9 @@ ObjectComparison HgQueuedBackingStore::compareObjectsById(
   }
 
   // Now parse the object IDs and read their rev hashes.
-  auto oneProxy = HgProxyHash::load(
+  auto oneProxy = proxyHashCache_.load(
       localStore_.get(), one, "areObjectIdsEquivalent", *stats_);
-  auto twoProxy = HgProxyHash::load(
+  auto twoProxy = proxyHashCache_.load(
       localStore_.get(), two, "areObjectIdsEquivalent", *stats_);
 
   // If the rev hashes are the same, we know the contents are the same.
@@ -359,12 +620,18 @@ folly::SemiFuture<BackingStore::GetTreeResult> HgQueuedBackingStore::getTree(
     const ObjectFetchContextPtr& context) {
   HgProxyHash proxyHash;
   try {
-    proxyHash = HgProxyHash::load(localStore_.get(), id, "getTree", *stats_);
+    proxyHash =
+        proxyHashCache_.load(localStore_.get(), id, "getTree", *stats_);
   } catch (const std::exception&) {
     logMissingProxyHash();
     throw;
   }
 
+  if (config_->getEdenConfig()->speculativeTreePrefetch.getValue() &&
+      speculativeTreePrefetcher_.recordRequest(id)) {
+    stats_->increment(&HgBackingStoreStats::speculativeTreePrefetchHit);
+  }
+
   logBackingStoreFetch(
       *context,
       folly::Range{&proxyHash, 1},
@@ -388,7 +655,7 @@ std::unique_ptr<BlobMetadata> HgQueuedBackingStore::getLocalBlobMetadata(
 
   HgProxyHash proxyHash;
   try {
-    proxyHash = HgProxyHash::load(
+    proxyHash = proxyHashCache_.load(
         localStore_.get(), id, "getLocalBlobMetadata", *stats_);
   } catch (const std::exception&) {
     logMissingProxyHash();
@@ -408,9 +675,14 @@ HgQueuedBackingStore::getTreeImpl(
     const ObjectId& id,
     const HgProxyHash& proxyHash,
     const ObjectFetchContextPtr& context) {
+  if (auto error = checkOverload(*context)) {
+    return folly::makeSemiFuture<GetTreeResult>(std::move(*error));
+  }
+
   auto getTreeFuture = folly::makeFutureWith([&] {
     auto request = HgImportRequest::makeTreeImportRequest(
         id, proxyHash, context->getPriority(), context->getCause());
+    request->setClientPid(context->getClientPid());
     uint64_t unique = request->getUnique();
 
     auto importTracker =
@@ -422,36 +694,92 @@ HgQueuedBackingStore::getTreeImpl(
         context->getPriority().getClass(),
         context->getCause()));
 
-    return queue_.enqueueTree(std::move(request))
+    return queue_.enqueueTree(request, context->getCancellationToken())
         .ensure([this,
-                 unique,
-                 proxyHash,
+                 request,
                  context = context.copy(),
                  importTracker = std::move(importTracker)]() {
           traceBus_->publish(HgImportTraceEvent::finish(
-              unique,
+              request->getUnique(),
               HgImportTraceEvent::TREE,
-              proxyHash,
+              request->getRequest<HgImportRequest::TreeImport>()->proxyHash,
               context->getPriority().getClass(),
-              context->getCause()));
+              context->getCause(),
+              request->getFetchedSource()));
         });
   });
 
   return std::move(getTreeFuture)
-      .thenTry([this, id](folly::Try<std::unique_ptr<Tree>>&& result) {
+      .thenTry([this, id, context = context.copy()](
+                   folly::Try<std::unique_ptr<Tree>>&& result) {
         this->queue_.markImportAsFinished<Tree>(id, result);
         auto tree = std::move(result).value();
+        maybePrefetchChildTrees(*tree, *context);
         return GetTreeResult{
             std::move(tree), ObjectFetchContext::Origin::FromNetworkFetch};
       });
 }
 
+void HgQueuedBackingStore::maybePrefetchChildTrees(
+    const Tree& tree,
+    const ObjectFetchContext& context) {
+  auto config = config_->getEdenConfig();
+  if (!config->speculativeTreePrefetch.getValue() ||
+      context.getCause() == ObjectFetchContext::Cause::Prefetch ||
+      context.getPriority().getAdjustment() < 0) {
+    return;
+  }
+  prefetchChildTrees(
+      tree,
+      speculativeTreePrefetcher_.getDepth(
+          config->speculativeTreePrefetchMaxDepth.getValue()));
+}
+
+void HgQueuedBackingStore::prefetchChildTrees(const Tree& tree, size_t depth) {
+  if (depth == 0) {
+    return;
+  }
+
+  static auto context = makeRefPtr<SpeculativeTreePrefetchContext>();
+  auto maxDepth =
+      config_->getEdenConfig()->speculativeTreePrefetchMaxDepth.getValue();
+  for (const auto& [name, entry] : tree) {
+    if (!entry.isTree()) {
+      continue;
+    }
+    const auto& id = entry.getHash();
+    if (queue_.isTracked(id)) {
+      continue;
+    }
+
+    HgProxyHash proxyHash;
+    try {
+      proxyHash = proxyHashCache_.load(
+          localStore_.get(), id, "prefetchChildTrees", *stats_);
+    } catch (const std::exception& ex) {
+      XLOGF(DBG4, "Not prefetching tree {}: {}", id, ex.what());
+      continue;
+    }
+
+    speculativeTreePrefetcher_.recordPrefetch(id, maxDepth);
+    stats_->increment(&HgBackingStoreStats::speculativeTreePrefetch);
+    getTreeImpl(id, proxyHash, context.copy())
+        .via(&folly::InlineExecutor::instance())
+        .thenTry([this, depth](folly::Try<GetTreeResult>&& result) {
+          if (result.hasValue()) {
+            prefetchChildTrees(*result->tree, depth - 1);
+          }
+        });
+  }
+}
+
 folly::SemiFuture<BackingStore::GetBlobResult> HgQueuedBackingStore::getBlob(
     const ObjectId& id,
     const ObjectFetchContextPtr& context) {
   HgProxyHash proxyHash;
   try {
-    proxyHash = HgProxyHash::load(localStore_.get(), id, "getBlob", *stats_);
+    proxyHash =
+        proxyHashCache_.load(localStore_.get(), id, "getBlob", *stats_);
   } catch (const std::exception&) {
     logMissingProxyHash();
     throw;
@@ -476,12 +804,17 @@ HgQueuedBackingStore::getBlobImpl(
     const ObjectId& id,
     const HgProxyHash& proxyHash,
     const ObjectFetchContextPtr& context) {
+  if (auto error = checkOverload(*context)) {
+    return folly::makeSemiFuture<GetBlobResult>(std::move(*error));
+  }
+
   auto getBlobFuture = folly::makeFutureWith([&] {
     XLOG(DBG4) << "make blob import request for " << proxyHash.path()
                << ", hash is:" << id;
 
     auto request = HgImportRequest::makeBlobImportRequest(
         id, proxyHash, context->getPriority(), context->getCause());
+    request->setClientPid(context->getClientPid());
     auto unique = request->getUnique();
 
     auto importTracker =
@@ -493,18 +826,18 @@ HgQueuedBackingStore::getBlobImpl(
         context->getPriority().getClass(),
         context->getCause()));
 
-    return queue_.enqueueBlob(std::move(request))
+    return queue_.enqueueBlob(request, context->getCancellationToken())
         .ensure([this,
-                 unique,
-                 proxyHash,
+                 request,
                  context = context.copy(),
                  importTracker = std::move(importTracker)]() {
           traceBus_->publish(HgImportTraceEvent::finish(
-              unique,
+              request->getUnique(),
               HgImportTraceEvent::BLOB,
-              proxyHash,
+              request->getRequest<HgImportRequest::BlobImport>()->proxyHash,
               context->getPriority().getClass(),
-              context->getCause()));
+              context->getCause(),
+              request->getFetchedSource()));
         });
   });
 
@@ -523,10 +856,10 @@ ImmediateFuture<std::unique_ptr<Tree>> HgQueuedBackingStore::getRootTree(
   return backingStore_->getRootTree(rootId);
 }
 
-folly::SemiFuture<folly::Unit> HgQueuedBackingStore::prefetchBlobs(
+folly::SemiFuture<size_t> HgQueuedBackingStore::prefetchBlobs(
     ObjectIdRange ids,
     const ObjectFetchContextPtr& context) {
-  return HgProxyHash::getBatch(localStore_.get(), ids, *stats_)
+  return proxyHashCache_.getBatch(localStore_.get(), ids, *stats_)
       // The caller guarantees that ids will live at least longer than this
       // future, thus we don't need to deep-copy it.
       .thenTry([context = context.copy(), this, ids](
@@ -541,26 +874,49 @@ folly::SemiFuture<folly::Unit> HgQueuedBackingStore::prefetchBlobs(
             folly::Range{proxyHashes.data(), proxyHashes.size()},
             ObjectFetchContext::ObjectType::Blob);
 
-        // Do not check for whether blobs are already present locally, this
-        // check is useful for latency oriented workflows, not for throughput
-        // oriented ones. Mercurial will anyway not re-fetch a blob that is
-        // already present locally, so the check for local blob is pure overhead
-        // when prefetching.
+        // By default, do not check for whether blobs are already present
+        // locally, this check is useful for latency oriented workflows, not
+        // for throughput oriented ones. Mercurial will anyway not re-fetch a
+        // blob that is already present locally, so the check for local blob
+        // is mostly overhead when prefetching.
+        auto skipLocalBlobs =
+            config_->getEdenConfig()->prefetchSkipLocalBlobs.getValue();
         std::vector<folly::SemiFuture<GetBlobResult>> futures;
         futures.reserve(ids.size());
 
+        // Prefetches are best effort, shedding them doesn't fail the caller.
+        updateOverload();
+        if (overloadController_.admit(context->getPriority()) ==
+            HgImportOverloadController::Admission::Shed) {
+          stats_->increment(&HgBackingStoreStats::importShed, ids.size());
+          return folly::makeSemiFuture<size_t>(0);
+        }
+
         for (size_t i = 0; i < ids.size(); i++) {
           const auto& id = ids[i];
           const auto& proxyHash = proxyHashes[i];
 
+          // A queued or in flight import will populate the hg cache already,
+          // this also skips the duplicates within ids.
+          if (queue_.isTracked(id)) {
+            continue;
+          }
+          if (skipLocalBlobs &&
+              backingStore_->getDatapackStore().hasBlobLocal(proxyHash)) {
+            continue;
+          }
+
           futures.emplace_back(getBlobImpl(id, proxyHash, context));
         }
 
-        return folly::collectAll(futures).deferValue([](const auto& tries) {
-          for (const auto& t : tries) {
-            t.throwUnlessValue();
-          }
-        });
+        auto fetched = futures.size();
+        return folly::collectAll(futures).deferValue(
+            [fetched](const auto& tries) {
+              for (const auto& t : tries) {
+                t.throwUnlessValue();
+              }
+              return fetched;
+            });
       });
 }
 
@@ -677,6 +1033,8 @@ folly::SemiFuture<folly::Unit> HgQueuedBackingStore::importManifestForRoot(
 
 void HgQueuedBackingStore::periodicManagementTask() {
   backingStore_->periodicManagementTask();
+  // Lets the store recover without imports to trigger the update.
+  updateOverload();
 }
 
 namespace {
@@ -9,6 +9,8 @@
 
 #include <folly/Range.h>
 #include <folly/Synchronized.h>
+#include <folly/stop_watch.h>
+#include <folly/synchronization/LifoSem.h>
 #include <sys/types.h>
 #include <atomic>
 #include <memory>
@@ -19,7 +21,11 @@
 #include "eden/fs/store/ImportPriority.h"
 #include "eden/fs/store/ObjectFetchContext.h"
 #include "eden/fs/store/hg/HgBackingStore.h"
+#include "eden/fs/store/hg/HgImportOverloadController.h"
 #include "eden/fs/store/hg/HgImportRequestQueue.h"
+#include "eden/fs/store/hg/HgImportTraceFile.h"
+#include "eden/fs/store/hg/HgProxyHashCache.h"
+#include "eden/fs/store/hg/SpeculativeTreePrefetcher.h"
 #include "eden/fs/telemetry/ActivityBuffer.h"
 #include "eden/fs/telemetry/RequestMetricsScope.h"
 #include "eden/fs/telemetry/TraceBus.h"
@@ -71,9 +77,12 @@ struct HgImportTraceEvent : TraceEventBase {
       ResourceType resourceType,
       const HgProxyHash& proxyHash,
       ImportPriority::Class priority,
-      ObjectFetchContext::Cause cause) {
-    return HgImportTraceEvent{
+      ObjectFetchContext::Cause cause,
+      HgImportRequest::FetchedSource fetchedSource) {
+    auto event = HgImportTraceEvent{
         unique, FINISH, resourceType, proxyHash, priority, cause};
+    event.fetchedSource = fetchedSource;
+    return event;
   }
 
   HgImportTraceEvent(
@@ -100,6 +109,24 @@ struct HgImportTraceEvent : TraceEventBase {
   ResourceType resourceType;
   ImportPriority::Class importPriority;
   ObjectFetchContext::Cause importCause;
+  // Only known for FINISH events, and Unknown for the requests that were
+  // deduplicated into an already queued one.
+  HgImportRequest::FetchedSource fetchedSource{
+      HgImportRequest::FetchedSource::Unknown};
+
+ private:
+  friend struct ActivityBufferCodec<HgImportTraceEvent>;
+
+  HgImportTraceEvent() = default;
+};
+
+/**
+ * Stores the fields of HgImportTraceEvents next to their path.
+ */
+template <>
+struct ActivityBufferCodec<HgImportTraceEvent> {
+  static void encode(const HgImportTraceEvent& event, std::string& out);
+  static HgImportTraceEvent decode(folly::ByteRange in);
 };
 
 /**
@@ -132,6 +159,13 @@ class HgQueuedBackingStore final : public BackingStore {
    */
   void subscribeActivityBuffer();
 
+  /**
+   * Subscribes traceWriter_ to traceBus_ when hg:import-trace-file is set, to
+   * record every HgImportTraceEvent into that file. Must be called after
+   * subscribeActivityBuffer().
+   */
+  void subscribeTraceRecorder();
+
   std::optional<ActivityBuffer<HgImportTraceEvent>>& getActivityBuffer() {
     return activityBuffer_;
   }
@@ -143,6 +177,12 @@ class HgQueuedBackingStore final : public BackingStore {
   ObjectComparison compareObjectsById(const ObjectId& one, const ObjectId& two)
       override;
 
+  /**
+   * Legacy 20-byte ObjectIds are migrated to embedded proxy hashes in the
+   * configured hg:object-id-format.
+   */
+  std::optional<ObjectId> migrateObjectId(const ObjectId& id) override;
+
   RootId parseRootId(folly::StringPiece rootId) override;
   std::string renderRootId(const RootId& rootId) override;
   ObjectId parseObjectId(folly::StringPiece objectId) override {
@@ -171,7 +211,13 @@ class HgQueuedBackingStore final : public BackingStore {
       const ObjectId& id,
       const ObjectFetchContextPtr& context) override;
 
-  FOLLY_NODISCARD virtual folly::SemiFuture<folly::Unit> prefetchBlobs(
+  /**
+   * Blobs already queued or in flight, e.g. for a FUSE read or a previous
+   * prefetch, are not enqueued again. With `hg:prefetch-skip-local-blobs`,
+   * neither are the blobs present in the hg cache. While the store is
+   * overloaded, the low-priority prefetches are skipped.
+   */
+  FOLLY_NODISCARD virtual folly::SemiFuture<size_t> prefetchBlobs(
       ObjectIdRange ids,
       const ObjectFetchContextPtr& context) override;
 
@@ -217,6 +263,17 @@ class HgQueuedBackingStore final : public BackingStore {
       std::vector<std::shared_ptr<HgImportRequest>>&& requests);
   void processTreeImportRequests(
       std::vector<std::shared_ptr<HgImportRequest>>&& requests);
+
+  /**
+   * Import the requests of a batch that Sapling didn't find through the hg
+   * importer. The returned future completes once all the requests do.
+   */
+  folly::SemiFuture<folly::Unit> importRemainingBlobs(
+      std::vector<std::shared_ptr<HgImportRequest>>&& requests,
+      folly::stop_watch<std::chrono::milliseconds> watch);
+  folly::SemiFuture<folly::Unit> importRemainingTrees(
+      std::vector<std::shared_ptr<HgImportRequest>>&& requests,
+      folly::stop_watch<std::chrono::milliseconds> watch);
   void processPrefetchRequests(
       std::vector<std::shared_ptr<HgImportRequest>>&& requests);
 
@@ -225,6 +282,29 @@ class HgQueuedBackingStore final : public BackingStore {
    */
   void processRequest();
 
+  /**
+   * Report how a batch performed to the queue and to the overload
+   * controller.
+   */
+  void recordBatch(
+      const std::vector<std::shared_ptr<HgImportRequest>>& requests,
+      std::chrono::steady_clock::time_point dequeueTime,
+      std::chrono::steady_clock::duration fetchLatency);
+
+  /**
+   * Re-evaluate whether the store is overloaded, with the limits of
+   * `hg:import-overload-*`. Entering the overloaded state sheds the queued
+   * low-priority requests. Transitions are logged and counted.
+   */
+  void updateOverload();
+
+  /**
+   * The error a request of context fails with when the overload controller
+   * turns it away, or nullopt when it can be queued.
+   */
+  std::optional<folly::exception_wrapper> checkOverload(
+      const ObjectFetchContext& context);
+
   void logMissingProxyHash();
 
   /**
@@ -255,6 +335,21 @@ class HgQueuedBackingStore final : public BackingStore {
       const HgProxyHash& proxyHash,
       const ObjectFetchContextPtr& context);
 
+  /**
+   * With hg:speculative-tree-prefetch, enqueue the child trees of a tree
+   * imported for context, unless context is itself a prefetch or was
+   * deprioritized by ObjectStore::deprioritizeWhenFetchHeavy.
+   */
+  void maybePrefetchChildTrees(
+      const Tree& tree,
+      const ObjectFetchContext& context);
+
+  /**
+   * Enqueue the child trees of tree, and recursively theirs once imported,
+   * depth levels deep.
+   */
+  void prefetchChildTrees(const Tree& tree, size_t depth);
+
   /**
    * Logs a backing store fetch to scuba if the path being fetched is in the
    * configured paths to log. The path is derived from the proxy hash.
@@ -313,12 +408,27 @@ class HgQueuedBackingStore final : public BackingStore {
    */
   HgImportRequestQueue queue_;
 
+  HgProxyHashCache proxyHashCache_;
+
+  SpeculativeTreePrefetcher speculativeTreePrefetcher_;
+
+  HgImportOverloadController overloadController_;
+
   /**
    * The worker thread pool. These threads will be running `processRequest`
    * forever to process incoming import requests
    */
   std::vector<std::thread> threads_;
 
+  /**
+   * With backingstore:async-batch-fetch, the threads hand the batches to
+   * Sapling and move on to the next ones. Each in flight batch holds a token
+   * of inFlightBatches_, which starts with maxInFlightBatches_ of them.
+   */
+  bool asyncBatchFetch_;
+  uint32_t maxInFlightBatches_;
+  folly::LifoSem inFlightBatches_;
+
   std::shared_ptr<StructuredLogger> structuredLogger_;
 
   /**
@@ -343,9 +453,14 @@ class HgQueuedBackingStore final : public BackingStore {
   // can capture [this].
   std::shared_ptr<TraceBus<HgImportTraceEvent>> traceBus_;
 
+  // Set when hg:import-trace-file is, only used by the subscriber of
+  // traceBus_ that records the events.
+  std::unique_ptr<HgImportTraceWriter> traceWriter_;
+
   // Handle for traceBus subscription
   struct HgTraceHandle {
     TraceSubscriptionHandle<HgImportTraceEvent> subHandle;
+    TraceSubscriptionHandle<HgImportTraceEvent> recordHandle;
   };
 
   std::shared_ptr<HgTraceHandle> hgTraceHandle_;
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/SpeculativeTreePrefetcher.h"
+
+#include <algorithm>
+
+namespace facebook::eden {
+
+size_t SpeculativeTreePrefetcher::getDepth(size_t maxDepth) const {
+  return std::clamp<size_t>(
+      depth_.load(std::memory_order_relaxed), 1, std::max<size_t>(maxDepth, 1));
+}
+
+void SpeculativeTreePrefetcher::recordPrefetch(
+    const ObjectId& id,
+    size_t maxDepth) {
+  auto state = state_.lock();
+  state->prefetched.set(id, true);
+  if (++state->issued < kWindowSize) {
+    return;
+  }
+
+  auto hitRate = static_cast<double>(state->hits) / state->issued;
+  auto depth = getDepth(maxDepth);
+  if (hitRate >= kGrowHitRate) {
+    depth = std::min<size_t>(depth + 1, std::max<size_t>(maxDepth, 1));
+  } else if (hitRate < kShrinkHitRate) {
+    depth = std::max<size_t>(depth - 1, 1);
+  }
+  depth_.store(depth, std::memory_order_relaxed);
+  state->issued = 0;
+  state->hits = 0;
+}
+
+bool SpeculativeTreePrefetcher::recordRequest(const ObjectId& id) {
+  auto state = state_.lock();
+  if (!state->prefetched.erase(id)) {
+    return false;
+  }
+  ++state->hits;
+  return true;
+}
+
+} // namespace facebook::eden
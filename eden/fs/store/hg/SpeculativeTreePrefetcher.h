@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/Synchronized.h>
+#include <folly/container/EvictingCacheMap.h>
+#include <atomic>
+#include <mutex>
+#include "eden/fs/model/ObjectId.h"
+
+namespace facebook::eden {
+
+/**
+ * Decides how deep HgQueuedBackingStore speculatively prefetches the child
+ * trees of an imported tree, from how many of the previous speculative
+ * prefetches were then requested.
+ *
+ * A readdir of a freshly imported directory is usually followed by lookups
+ * of its children, so while most prefetched trees end up requested the
+ * depth grows, and it shrinks when they mostly aren't.
+ *
+ * Thread-safe.
+ */
+class SpeculativeTreePrefetcher {
+ public:
+  SpeculativeTreePrefetcher() = default;
+
+  /**
+   * How many levels of child trees to prefetch below an imported tree,
+   * within [1, maxDepth].
+   */
+  size_t getDepth(size_t maxDepth) const;
+
+  /**
+   * Record that the tree id is being speculatively prefetched.
+   */
+  void recordPrefetch(const ObjectId& id, size_t maxDepth);
+
+  /**
+   * Record a non-speculative request of the tree id. Returns whether it was
+   * speculatively prefetched.
+   */
+  bool recordRequest(const ObjectId& id);
+
+  /**
+   * Number of speculative prefetches the hit rate is computed over.
+   */
+  static constexpr size_t kWindowSize = 256;
+
+  /**
+   * The depth grows when at least this fraction of the prefetches of a
+   * window were hits, and shrinks when fewer than kShrinkHitRate were.
+   */
+  static constexpr double kGrowHitRate = 0.5;
+  static constexpr double kShrinkHitRate = 0.2;
+
+ private:
+  struct State {
+    // Prefetched trees that weren't requested yet. Bounded so that the trees
+    // that are never requested are eventually forgotten.
+    folly::EvictingCacheMap<ObjectId, bool> prefetched{kWindowSize * 16};
+    size_t issued = 0;
+    size_t hits = 0;
+  };
+
+  std::atomic<size_t> depth_{1};
+  folly::Synchronized<State, std::mutex> state_;
+};
+
+} // namespace facebook::eden
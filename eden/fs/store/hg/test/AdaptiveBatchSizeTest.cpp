@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/AdaptiveBatchSize.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+constexpr AdaptiveBatchSize::Duration kTarget = 100ms;
+constexpr size_t kMaxSize = 64;
+
+AdaptiveBatchSize::Sample makeSample(
+    size_t size,
+    AdaptiveBatchSize::Duration fetchLatency,
+    AdaptiveBatchSize::Duration queueWait,
+    size_t highPriorityCount = 0) {
+  AdaptiveBatchSize::Sample sample;
+  sample.size = size;
+  sample.fetchLatency = fetchLatency;
+  sample.averageQueueWait = queueWait;
+  sample.highPriorityLatencies.assign(
+      highPriorityCount, fetchLatency + queueWait);
+  return sample;
+}
+
+} // namespace
+
+TEST(AdaptiveBatchSizeTest, grows_while_fetching_dominates) {
+  AdaptiveBatchSize batchSize{1};
+  for (size_t i = 0; i < 100; ++i) {
+    batchSize.record(makeSample(batchSize.get(), 50ms, 1ms), kTarget, kMaxSize);
+  }
+  EXPECT_EQ(kMaxSize, batchSize.get());
+}
+
+TEST(AdaptiveBatchSizeTest, does_not_grow_when_the_queue_is_drained) {
+  AdaptiveBatchSize batchSize{8};
+  batchSize.record(makeSample(3, 50ms, 1ms), kTarget, kMaxSize);
+  EXPECT_EQ(8, batchSize.get());
+}
+
+TEST(AdaptiveBatchSizeTest, shrinks_when_queue_wait_exceeds_the_target) {
+  AdaptiveBatchSize batchSize{32};
+  // Not enough high-priority latencies yet to act on the p99.
+  batchSize.record(makeSample(32, 50ms, 200ms, 1), kTarget, kMaxSize);
+  EXPECT_EQ(32, batchSize.get());
+
+  batchSize.record(
+      makeSample(32, 50ms, 200ms, AdaptiveBatchSize::kMinSamples),
+      kTarget,
+      kMaxSize);
+  EXPECT_EQ(24, batchSize.get());
+  EXPECT_GT(batchSize.getHighPriorityP99().value(), kTarget);
+
+  for (size_t i = 0; i < 100; ++i) {
+    batchSize.record(makeSample(32, 50ms, 200ms, 4), kTarget, kMaxSize);
+  }
+  EXPECT_EQ(1, batchSize.get());
+}
+
+TEST(AdaptiveBatchSizeTest, keeps_its_size_within_the_target) {
+  AdaptiveBatchSize batchSize{16};
+  batchSize.record(
+      makeSample(16, 10ms, 20ms, AdaptiveBatchSize::kMinSamples),
+      kTarget,
+      kMaxSize);
+  EXPECT_EQ(16, batchSize.get());
+}
+
+TEST(AdaptiveBatchSizeTest, p99_ignores_rare_outliers) {
+  AdaptiveBatchSize batchSize{16};
+  auto sample = makeSample(16, 10ms, 20ms, AdaptiveBatchSize::kWindowSize);
+  sample.highPriorityLatencies[0] = 10s;
+  batchSize.record(sample, kTarget, kMaxSize);
+  EXPECT_EQ(30ms, batchSize.getHighPriorityP99().value());
+}
+
+TEST(AdaptiveBatchSizeTest, lowered_maximum_applies_immediately) {
+  AdaptiveBatchSize batchSize{32};
+  batchSize.record(makeSample(32, 10ms, 20ms), kTarget, 8);
+  EXPECT_EQ(8, batchSize.get());
+}
@@ -130,3 +130,20 @@ TEST_F(
       getTreeNames(tree1),
       ::testing::ElementsAre(PathComponent{"foo"}, PathComponent{"src"}));
 }
+
+TEST_F(HgBackingStoreTest, native_import_manifest_for_root) {
+  rawEdenConfig->nativeManifestImport.setValue(
+      true, ConfigSource::Default, true);
+  backingStore->importManifestForRoot(commit1, manifest1).get(0ms);
+
+  auto commitId = ObjectId::fromHex(commit1.value());
+  EXPECT_TRUE(
+      localStore->get(KeySpace::HgCommitToTreeFamily, commitId).isValid());
+
+  auto tree =
+      objectStore->getRootTree(commit1, ObjectFetchContext::getNullContext())
+          .get(0ms);
+  ASSERT_THAT(
+      getTreeNames(tree),
+      ::testing::ElementsAre(PathComponent{"foo"}, PathComponent{"src"}));
+}
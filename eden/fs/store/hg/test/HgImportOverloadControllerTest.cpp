@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/HgImportOverloadController.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+using Admission = HgImportOverloadController::Admission;
+using Transition = HgImportOverloadController::Transition;
+
+namespace {
+
+HgImportOverloadController::Limits makeLimits(
+    size_t maxQueueDepth,
+    HgImportOverloadController::Duration maxLatency = 0ms) {
+  HgImportOverloadController::Limits limits;
+  limits.maxQueueDepth = maxQueueDepth;
+  limits.maxLatency = maxLatency;
+  return limits;
+}
+
+const auto kStart = HgImportOverloadController::Clock::now();
+
+} // namespace
+
+TEST(HgImportOverloadControllerTest, disabledWithoutLimits) {
+  HgImportOverloadController controller;
+  controller.recordLatency(10s);
+  EXPECT_EQ(
+      Transition::None, controller.update(1000000, makeLimits(0), kStart));
+  EXPECT_FALSE(controller.isOverloaded());
+  EXPECT_EQ(
+      Admission::Accept,
+      controller.admit(ImportPriority{ImportPriority::Class::Low}));
+}
+
+TEST(HgImportOverloadControllerTest, queueDepthEntersAndLeaves) {
+  HgImportOverloadController controller;
+  auto limits = makeLimits(100);
+  EXPECT_EQ(Transition::None, controller.update(99, limits, kStart));
+  EXPECT_EQ(Transition::Entered, controller.update(100, limits, kStart));
+  EXPECT_TRUE(controller.isOverloaded());
+  EXPECT_EQ(Transition::None, controller.update(200, limits, kStart));
+
+  // Below the limit but not below its recovery fraction.
+  EXPECT_EQ(Transition::None, controller.update(60, limits, kStart + 2s));
+  // Recovered, but not overloaded for long enough.
+  EXPECT_EQ(Transition::None, controller.update(10, limits, kStart + 100ms));
+  EXPECT_EQ(Transition::Left, controller.update(10, limits, kStart + 2s));
+  EXPECT_FALSE(controller.isOverloaded());
+  EXPECT_EQ(Transition::None, controller.update(10, limits, kStart + 3s));
+}
+
+TEST(HgImportOverloadControllerTest, latencyEntersAndLeaves) {
+  HgImportOverloadController controller;
+  auto limits = makeLimits(0, 1s);
+  controller.recordLatency(100ms);
+  EXPECT_EQ(100ms, controller.getAverageLatency());
+  EXPECT_EQ(Transition::None, controller.update(10, limits, kStart));
+
+  for (int i = 0; i < 100; ++i) {
+    controller.recordLatency(5s);
+  }
+  EXPECT_GT(controller.getAverageLatency(), 1s);
+  EXPECT_EQ(Transition::Entered, controller.update(10, limits, kStart));
+
+  // The latency is still high, but nothing is queued anymore.
+  EXPECT_EQ(Transition::Left, controller.update(0, limits, kStart + 2s));
+}
+
+TEST(HgImportOverloadControllerTest, lowPriorityIsShedAndFetchHeavyFails) {
+  HgImportOverloadController controller;
+  controller.update(100, makeLimits(100), kStart);
+  ASSERT_TRUE(controller.isOverloaded());
+
+  EXPECT_EQ(
+      Admission::Shed,
+      controller.admit(ImportPriority{ImportPriority::Class::Low}));
+  EXPECT_EQ(Admission::Shed, controller.admit(kCacheWarmingPriority));
+  EXPECT_EQ(
+      Admission::FailFast,
+      controller.admit(kDefaultFsImportPriority.adjusted(-10)));
+  EXPECT_EQ(Admission::Accept, controller.admit(kDefaultFsImportPriority));
+  EXPECT_EQ(Admission::Accept, controller.admit(kDefaultImportPriority));
+}
@@ -5,11 +5,15 @@
  * GNU General Public License version 2.
  */
 
+#include <folly/CancellationToken.h>
 #include <folly/Try.h>
+#include <folly/futures/FutureException.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/GTest.h>
 #include <array>
 #include <memory>
+#include <set>
+#include <thread>
 
 #include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/model/Hash.h"
@@ -568,3 +572,303 @@ TEST_F(HgImportRequestQueueTest, twoDuplicateRequestsDifferentPriority) {
         request->getRequest<HgImportRequest::BlobImport>()->hash, expBlob);
   }
 }
+
+TEST_F(HgImportRequestQueueTest, trackedUntilMarkedDone) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto hash = insertBlobImportRequest(queue, kDefaultImportPriority);
+  EXPECT_TRUE(queue.isTracked(hash));
+
+  // Dequeued requests are in flight until marked as finished.
+  auto request = queue.dequeue().at(0);
+  EXPECT_TRUE(queue.isTracked(hash));
+
+  folly::Try<std::unique_ptr<Blob>> blob = folly::makeTryWith(
+      [hash]() { return std::make_unique<Blob>(hash, folly::IOBuf{}); });
+  queue.markImportAsFinished<Blob>(hash, blob);
+  EXPECT_FALSE(queue.isTracked(hash));
+}
+
+TEST_F(HgImportRequestQueueTest, duplicateRequestBumpsPriorityClass) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto hgRevHash = uniqueHash();
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, hgRevHash};
+  auto [lowPriHash, lowPriRequest] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::Low}, proxyHash);
+  auto [highPriHash, highPriRequest] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::High}, proxyHash);
+
+  auto normalPriHash = insertBlobImportRequest(queue, kDefaultImportPriority);
+  queue.enqueueBlob(std::move(lowPriRequest));
+  queue.enqueueBlob(std::move(highPriRequest));
+
+  // The duplicate moved the low priority request ahead of the normal one.
+  auto request = queue.dequeue().at(0);
+  EXPECT_EQ(
+      lowPriHash, request->getRequest<HgImportRequest::BlobImport>()->hash);
+  EXPECT_EQ(
+      ImportPriority{ImportPriority::Class::High}, request->getPriority());
+
+  request = queue.dequeue().at(0);
+  EXPECT_EQ(
+      normalPriHash, request->getRequest<HgImportRequest::BlobImport>()->hash);
+}
+
+TEST_F(HgImportRequestQueueTest, concurrentEnqueue) {
+  rawEdenConfig->importBatchSize.setValue(7, ConfigSource::Default, true);
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  constexpr size_t kThreads = 8;
+  constexpr size_t kRequestsPerThread = 500;
+  const std::array<ImportPriority, 3> priorities = {
+      ImportPriority{ImportPriority::Class::Low},
+      kDefaultImportPriority,
+      ImportPriority{ImportPriority::Class::High}};
+
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < kThreads; i++) {
+    threads.emplace_back([&] {
+      for (size_t j = 0; j < kRequestsPerThread; j++) {
+        insertBlobImportRequest(queue, priorities[j % priorities.size()]);
+      }
+    });
+  }
+
+  std::set<ObjectId> dequeued;
+  while (dequeued.size() < kThreads * kRequestsPerThread) {
+    auto requests = queue.dequeue();
+    EXPECT_LE(requests.size(), 7);
+    for (size_t j = 1; j < requests.size(); j++) {
+      EXPECT_GE(requests[j - 1]->getPriority(), requests[j]->getPriority());
+    }
+    for (auto& request : requests) {
+      auto hash = request->getRequest<HgImportRequest::BlobImport>()->hash;
+      EXPECT_TRUE(dequeued.insert(hash).second);
+    }
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_TRUE(queue.combineAndClearRequestQueues().empty());
+}
+
+TEST_F(HgImportRequestQueueTest, adaptiveBatchSize) {
+  rawEdenConfig->importBatchAdaptive.setValue(
+      true, ConfigSource::UserConfig, true);
+  auto queue = HgImportRequestQueue{edenConfig};
+  EXPECT_EQ(1, queue.getAdaptiveBlobBatchSize());
+
+  for (int i = 0; i < 10; i++) {
+    insertBlobImportRequest(queue, ImportPriority{ImportPriority::Class::High});
+  }
+
+  // A full batch that was slower to fetch than to dequeue grows the next one.
+  auto dequeued = queue.dequeue();
+  EXPECT_EQ(1, dequeued.size());
+  queue.recordBatch(
+      dequeued, std::chrono::steady_clock::now(), std::chrono::hours{1});
+  EXPECT_EQ(2, queue.getAdaptiveBlobBatchSize());
+  EXPECT_EQ(1, queue.getAdaptiveTreeBatchSize());
+
+  dequeued = queue.dequeue();
+  EXPECT_EQ(2, dequeued.size());
+}
+
+namespace {
+ObjectId insertClientBlobImportRequest(
+    HgImportRequestQueue& queue,
+    pid_t pid,
+    ImportPriority priority = kDefaultImportPriority) {
+  auto [hash, request] = makeBlobImportRequest(priority);
+  request->setClientPid(pid);
+  queue.enqueueBlob(std::move(request));
+  return hash;
+}
+
+pid_t dequeueClient(HgImportRequestQueue& queue) {
+  auto requests = queue.dequeue();
+  EXPECT_EQ(1, requests.size());
+  return requests.at(0)->getClientPid().value();
+}
+} // namespace
+
+TEST_F(HgImportRequestQueueTest, fairShareInterleavesClients) {
+  rawEdenConfig->importFairShare.setValue(true, ConfigSource::Default, true);
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  for (int i = 0; i < 4; i++) {
+    insertClientBlobImportRequest(queue, 1);
+  }
+  insertClientBlobImportRequest(queue, 2);
+  insertClientBlobImportRequest(queue, 2);
+
+  // The first two requests of each client alternate, in either order.
+  for (int i = 0; i < 2; i++) {
+    std::set<pid_t> pids{dequeueClient(queue), dequeueClient(queue)};
+    EXPECT_EQ((std::set<pid_t>{1, 2}), pids);
+  }
+  EXPECT_EQ(1, dequeueClient(queue));
+  EXPECT_EQ(1, dequeueClient(queue));
+
+  auto stats = queue.getClientStats(1).value();
+  EXPECT_EQ(0, stats.queued);
+  EXPECT_EQ(4, stats.running);
+  EXPECT_EQ(4, stats.dispatched);
+}
+
+TEST_F(HgImportRequestQueueTest, fairShareCapsRunningRequestsPerClient) {
+  rawEdenConfig->importFairShare.setValue(true, ConfigSource::Default, true);
+  rawEdenConfig->importMaxInFlightPerClient.setValue(
+      1, ConfigSource::Default, true);
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto first = insertClientBlobImportRequest(
+      queue, 1, ImportPriority{ImportPriority::Class::Normal, 10});
+  insertClientBlobImportRequest(
+      queue, 1, ImportPriority{ImportPriority::Class::Normal, 10});
+  insertClientBlobImportRequest(queue, 2);
+
+  EXPECT_EQ(1, dequeueClient(queue));
+  // Client 1 is at its limit.
+  EXPECT_EQ(2, dequeueClient(queue));
+  // Only client 1 has requests queued, the limit doesn't leave workers idle.
+  EXPECT_EQ(1, dequeueClient(queue));
+
+  auto blob = std::make_unique<Blob>(first, folly::IOBuf{});
+  auto blobTry = folly::Try<std::unique_ptr<Blob>>{std::move(blob)};
+  queue.markImportAsFinished<Blob>(first, blobTry);
+  EXPECT_EQ(1, queue.getClientStats(1).value().running);
+}
+
+TEST_F(HgImportRequestQueueTest, cancelledRequestIsRemoved) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  folly::CancellationSource cancellation;
+  auto [hash, request] =
+      makeBlobImportRequest(ImportPriority{ImportPriority::Class::High});
+  auto future = queue.enqueueBlob(std::move(request), cancellation.getToken());
+  auto other = insertBlobImportRequest(
+      queue, ImportPriority{ImportPriority::Class::Low});
+
+  cancellation.requestCancellation();
+  EXPECT_FALSE(queue.isTracked(hash));
+  EXPECT_THROW(std::move(future).get(), folly::OperationCancelled);
+
+  auto dequeued = queue.dequeue();
+  ASSERT_EQ(1, dequeued.size());
+  EXPECT_EQ(
+      other, dequeued.at(0)->getRequest<HgImportRequest::BlobImport>()->hash);
+}
+
+TEST_F(HgImportRequestQueueTest, cancelledRequestIsKeptForOtherWaiters) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto proxyHash = HgProxyHash{RelativePath{"some_blob"}, uniqueHash()};
+  auto [hash, request] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::Normal}, proxyHash);
+  auto [hash2, request2] = makeBlobImportRequestWithHash(
+      ImportPriority{ImportPriority::Class::Normal}, proxyHash);
+
+  folly::CancellationSource cancellation;
+  auto future = queue.enqueueBlob(std::move(request), cancellation.getToken());
+  auto future2 = queue.enqueueBlob(std::move(request2));
+
+  cancellation.requestCancellation();
+  EXPECT_TRUE(queue.isTracked(hash));
+  EXPECT_FALSE(future.isReady());
+
+  auto dequeued = queue.dequeue();
+  ASSERT_EQ(1, dequeued.size());
+  auto blobTry = folly::Try<std::unique_ptr<Blob>>{
+      std::make_unique<Blob>(hash, folly::IOBuf{})};
+  dequeued.at(0)->getPromise<std::unique_ptr<Blob>>()->setValue(
+      std::make_unique<Blob>(hash, folly::IOBuf{}));
+  queue.markImportAsFinished<Blob>(hash, blobTry);
+
+  EXPECT_EQ(hash, std::move(future).get()->getHash());
+  EXPECT_EQ(hash, std::move(future2).get()->getHash());
+}
+
+TEST_F(HgImportRequestQueueTest, expiredRequestIsFailed) {
+  rawEdenConfig->importRequestDeadline.setValue(
+      std::chrono::nanoseconds{1}, ConfigSource::Default, true);
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto [hash, request] =
+      makeBlobImportRequest(ImportPriority{ImportPriority::Class::High});
+  auto future = queue.enqueueBlob(std::move(request));
+  std::this_thread::sleep_for(std::chrono::milliseconds{1});
+
+  rawEdenConfig->importRequestDeadline.setValue(
+      std::chrono::nanoseconds{0}, ConfigSource::Default, true);
+  auto other = insertBlobImportRequest(
+      queue, ImportPriority{ImportPriority::Class::Low});
+
+  auto dequeued = queue.dequeue();
+  ASSERT_EQ(1, dequeued.size());
+  EXPECT_EQ(
+      other, dequeued.at(0)->getRequest<HgImportRequest::BlobImport>()->hash);
+  EXPECT_FALSE(queue.isTracked(hash));
+  EXPECT_THROW(std::move(future).get(), folly::FutureTimeout);
+}
+
+TEST_F(HgImportRequestQueueTest, lowPriorityRequestsAreShed) {
+  auto queue = HgImportRequestQueue{edenConfig};
+
+  auto [lowBlob, lowBlobRequest] =
+      makeBlobImportRequest(ImportPriority{ImportPriority::Class::Low});
+  auto lowBlobFuture = queue.enqueueBlob(std::move(lowBlobRequest));
+  auto [lowTree, lowTreeRequest] =
+      makeTreeImportRequest(ImportPriority{ImportPriority::Class::Low});
+  auto lowTreeFuture = queue.enqueueTree(std::move(lowTreeRequest));
+  auto normal = insertBlobImportRequest(
+      queue, ImportPriority{ImportPriority::Class::Normal});
+  EXPECT_EQ(3, queue.getQueuedCount());
+
+  EXPECT_EQ(
+      2,
+      queue.shedLowPriorityRequests(
+          folly::make_exception_wrapper<std::runtime_error>("overloaded")));
+  EXPECT_EQ(1, queue.getQueuedCount());
+  EXPECT_FALSE(queue.isTracked(lowBlob));
+  EXPECT_FALSE(queue.isTracked(lowTree));
+  EXPECT_THROW(std::move(lowBlobFuture).get(), std::runtime_error);
+  EXPECT_THROW(std::move(lowTreeFuture).get(), std::runtime_error);
+
+  auto dequeued = queue.dequeue();
+  ASSERT_EQ(1, dequeued.size());
+  EXPECT_EQ(
+      normal, dequeued.at(0)->getRequest<HgImportRequest::BlobImport>()->hash);
+  EXPECT_EQ(0, queue.getQueuedCount());
+}
+
+TEST_F(HgImportRequestQueueTest, requestMemoryIsReused) {
+  auto [hash, request] = makeBlobImportRequest(kDefaultImportPriority);
+  auto* released = request.get();
+  request.reset();
+
+  auto [hash2, request2] = makeBlobImportRequest(kDefaultImportPriority);
+  EXPECT_EQ(released, request2.get());
+  EXPECT_EQ(hash2, request2->getRequest<HgImportRequest::BlobImport>()->hash);
+}
+
+TEST_F(HgImportRequestQueueTest, requestsReleasedByAnotherThread) {
+  // As with the importer threads, which release the requests that the
+  // enqueuing threads allocated.
+  for (size_t round = 0; round < 10; round++) {
+    std::vector<std::shared_ptr<HgImportRequest>> requests;
+    for (size_t i = 0; i < 1000; i++) {
+      requests.push_back(makeBlobImportRequest(kDefaultImportPriority).second);
+    }
+    std::thread{[&] { requests.clear(); }}.join();
+  }
+
+  std::set<HgImportRequest*> addresses;
+  std::vector<std::shared_ptr<HgImportRequest>> requests;
+  for (size_t i = 0; i < 1000; i++) {
+    requests.push_back(makeBlobImportRequest(kDefaultImportPriority).second);
+    EXPECT_TRUE(addresses.insert(requests.back().get()).second);
+  }
+}
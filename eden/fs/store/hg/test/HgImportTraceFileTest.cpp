@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/HgImportTraceFile.h"
+
+#include <fmt/format.h>
+#include <folly/FileUtil.h>
+#include <folly/portability/GTest.h>
+#include <folly/test/TestUtils.h>
+#include <folly/testing/TestUtil.h>
+
+#include "eden/fs/store/hg/HgQueuedBackingStore.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+AbsolutePath tracePath(const folly::test::TemporaryDirectory& dir) {
+  return canonicalPath((dir.path() / "trace").string());
+}
+
+HgImportTraceEvent makeEvent(uint64_t unique, folly::StringPiece path) {
+  auto proxyHash =
+      HgProxyHash{RelativePathPiece{path}, Hash20::sha1(path.str())};
+  return HgImportTraceEvent::queue(
+      unique,
+      HgImportTraceEvent::BLOB,
+      proxyHash,
+      ImportPriority::Class::High,
+      ObjectFetchContext::Cause::Fs);
+}
+
+} // namespace
+
+TEST(HgImportTraceFileTest, roundTrip) {
+  folly::test::TemporaryDirectory dir{"eden_hg_import_trace"};
+  std::vector<HgImportTraceEvent> written;
+  {
+    HgImportTraceWriter writer{tracePath(dir)};
+    // Enough events to be flushed in several chunks.
+    for (uint64_t i = 0; i < 10000; ++i) {
+      written.push_back(makeEvent(i, fmt::format("dir/file{}", i)));
+      writer.write(written.back());
+    }
+    auto finish = HgImportTraceEvent::finish(
+        10000,
+        HgImportTraceEvent::TREE,
+        HgProxyHash{RelativePathPiece{"dir"}, Hash20::sha1(std::string{"dir"})},
+        ImportPriority::Class::Low,
+        ObjectFetchContext::Cause::Prefetch,
+        HgImportRequest::FetchedSource::Remote);
+    written.push_back(finish);
+    writer.write(finish);
+  }
+
+  auto read = readHgImportTrace(tracePath(dir));
+  ASSERT_EQ(written.size(), read.size());
+  for (size_t i = 0; i < read.size(); ++i) {
+    EXPECT_EQ(written[i].unique, read[i].unique);
+    EXPECT_EQ(written[i].monotonicTime, read[i].monotonicTime);
+    EXPECT_EQ(written[i].getPath(), read[i].getPath());
+    EXPECT_EQ(written[i].manifestNodeId, read[i].manifestNodeId);
+    EXPECT_EQ(written[i].eventType, read[i].eventType);
+    EXPECT_EQ(written[i].resourceType, read[i].resourceType);
+    EXPECT_EQ(written[i].importPriority, read[i].importPriority);
+    EXPECT_EQ(written[i].importCause, read[i].importCause);
+    EXPECT_EQ(written[i].fetchedSource, read[i].fetchedSource);
+  }
+}
+
+TEST(HgImportTraceFileTest, rejectsOtherFiles) {
+  folly::test::TemporaryDirectory dir{"eden_hg_import_trace"};
+  auto path = tracePath(dir);
+  ASSERT_TRUE(folly::writeFile(std::string{"not a trace"}, path.c_str()));
+  EXPECT_THROW_RE(
+      readHgImportTrace(path), std::invalid_argument, "not an hg import trace");
+
+  {
+    HgImportTraceWriter writer{path};
+    writer.write(makeEvent(1, "file"));
+  }
+  std::string contents;
+  ASSERT_TRUE(folly::readFile(path.c_str(), contents));
+  contents.pop_back();
+  ASSERT_TRUE(folly::writeFile(contents, path.c_str()));
+  EXPECT_THROW_RE(readHgImportTrace(path), std::invalid_argument, "truncated");
+}
@@ -12,7 +12,9 @@
 
 #include "eden/fs/model/Hash.h"
 #include "eden/fs/model/TestOps.h"
+#include "eden/fs/store/MemoryLocalStore.h"
 #include "eden/fs/store/hg/HgProxyHash.h"
+#include "eden/fs/store/hg/HgProxyHashCache.h"
 #include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/utils/IDGen.h"
 #include "eden/fs/utils/PathFuncs.h"
@@ -70,3 +72,69 @@ TEST(HgProxyHashTest, round_trip_version_2) {
   EXPECT_EQ(hash, proxy.revHash());
   EXPECT_EQ(RelativePathPiece{}, proxy.path());
 }
+
+TEST(HgProxyHashTest, getBatch_preserves_order_of_embedded_and_stored) {
+  EdenStats stats;
+  MemoryLocalStore store;
+  Hash20 hash1{folly::StringPiece{"1111111111111111111111111111111111111111"}};
+  Hash20 hash2{folly::StringPiece{"2222222222222222222222222222222222222222"}};
+  Hash20 hash3{folly::StringPiece{"3333333333333333333333333333333333333333"}};
+
+  // Legacy 20 byte ids are looked up in the LocalStore.
+  auto storedId = ObjectId::sha1(std::string{"stored"});
+  store.put(
+      KeySpace::HgProxyHashFamily,
+      storedId,
+      folly::StringPiece{
+          HgProxyHash{RelativePathPiece{"a/b"}, hash2}.getValue()});
+
+  std::vector<ObjectId> ids{
+      HgProxyHash::makeEmbeddedProxyHash2(hash1),
+      storedId,
+      HgProxyHash::makeEmbeddedProxyHash1(hash3, RelativePathPiece{"c"})};
+  auto proxyHashes =
+      HgProxyHash::getBatch(&store, ObjectIdRange{ids}, stats).get();
+
+  ASSERT_EQ(3, proxyHashes.size());
+  EXPECT_EQ(hash1, proxyHashes[0].revHash());
+  EXPECT_EQ(hash2, proxyHashes[1].revHash());
+  EXPECT_EQ(RelativePathPiece{"a/b"}, proxyHashes[1].path());
+  EXPECT_EQ(hash3, proxyHashes[2].revHash());
+  EXPECT_EQ(RelativePathPiece{"c"}, proxyHashes[2].path());
+}
+
+TEST(HgProxyHashTest, cache_serves_legacy_ids_without_local_store) {
+  EdenStats stats;
+  MemoryLocalStore store;
+  HgProxyHashCache cache{100};
+  Hash20 hash1{folly::StringPiece{"1111111111111111111111111111111111111111"}};
+  Hash20 hash2{folly::StringPiece{"2222222222222222222222222222222222222222"}};
+
+  auto storedId1 = ObjectId::sha1(std::string{"stored1"});
+  auto storedId2 = ObjectId::sha1(std::string{"stored2"});
+  store.put(
+      KeySpace::HgProxyHashFamily,
+      storedId1,
+      folly::StringPiece{
+          HgProxyHash{RelativePathPiece{"a/b"}, hash1}.getValue()});
+  store.put(
+      KeySpace::HgProxyHashFamily,
+      storedId2,
+      folly::StringPiece{
+          HgProxyHash{RelativePathPiece{"c"}, hash2}.getValue()});
+
+  EXPECT_EQ(hash1, cache.load(&store, storedId1, "test", stats).revHash());
+  std::vector<ObjectId> ids{storedId1, storedId2};
+  cache.getBatch(&store, ObjectIdRange{ids}, stats).get();
+
+  // Both are now served from memory.
+  store.clearKeySpace(KeySpace::HgProxyHashFamily);
+  auto proxy1 = cache.load(&store, storedId1, "test", stats);
+  EXPECT_EQ(hash1, proxy1.revHash());
+  EXPECT_EQ(RelativePathPiece{"a/b"}, proxy1.path());
+  auto proxyHashes = cache.getBatch(&store, ObjectIdRange{ids}, stats).get();
+  ASSERT_EQ(2, proxyHashes.size());
+  EXPECT_EQ(hash1, proxyHashes[0].revHash());
+  EXPECT_EQ(hash2, proxyHashes[1].revHash());
+  EXPECT_EQ(RelativePathPiece{"c"}, proxyHashes[1].path());
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/hg/SpeculativeTreePrefetcher.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+namespace {
+
+constexpr size_t kMaxDepth = 3;
+
+ObjectId makeId(size_t i) {
+  return ObjectId::sha1(std::to_string(i));
+}
+
+/**
+ * Prefetch a window of trees, of which the first hitCount get requested.
+ */
+void runWindow(
+    SpeculativeTreePrefetcher& prefetcher,
+    size_t first,
+    size_t hitCount) {
+  for (size_t i = first; i < first + SpeculativeTreePrefetcher::kWindowSize;
+       ++i) {
+    prefetcher.recordPrefetch(makeId(i), kMaxDepth);
+    if (i - first < hitCount) {
+      EXPECT_TRUE(prefetcher.recordRequest(makeId(i)));
+    }
+  }
+}
+
+} // namespace
+
+TEST(SpeculativeTreePrefetcherTest, only_prefetched_trees_are_hits) {
+  SpeculativeTreePrefetcher prefetcher;
+  prefetcher.recordPrefetch(makeId(1), kMaxDepth);
+  EXPECT_FALSE(prefetcher.recordRequest(makeId(2)));
+  EXPECT_TRUE(prefetcher.recordRequest(makeId(1)));
+  // A tree is only a hit once.
+  EXPECT_FALSE(prefetcher.recordRequest(makeId(1)));
+}
+
+TEST(SpeculativeTreePrefetcherTest, depth_grows_with_the_hit_rate) {
+  SpeculativeTreePrefetcher prefetcher;
+  EXPECT_EQ(1, prefetcher.getDepth(kMaxDepth));
+
+  auto windowSize = SpeculativeTreePrefetcher::kWindowSize;
+  for (size_t window = 0; window < 10; ++window) {
+    runWindow(prefetcher, window * windowSize, windowSize);
+  }
+  EXPECT_EQ(kMaxDepth, prefetcher.getDepth(kMaxDepth));
+  // A lowered maximum applies immediately.
+  EXPECT_EQ(2, prefetcher.getDepth(2));
+}
+
+TEST(SpeculativeTreePrefetcherTest, depth_shrinks_when_prefetches_miss) {
+  SpeculativeTreePrefetcher prefetcher;
+  auto windowSize = SpeculativeTreePrefetcher::kWindowSize;
+  runWindow(prefetcher, 0, windowSize);
+  runWindow(prefetcher, windowSize, windowSize);
+  EXPECT_EQ(3, prefetcher.getDepth(kMaxDepth));
+
+  runWindow(prefetcher, 2 * windowSize, 0);
+  EXPECT_EQ(2, prefetcher.getDepth(kMaxDepth));
+
+  // Between the two thresholds, the depth is kept.
+  runWindow(prefetcher, 3 * windowSize, windowSize / 3);
+  EXPECT_EQ(2, prefetcher.getDepth(kMaxDepth));
+
+  for (size_t window = 4; window < 10; ++window) {
+    runWindow(prefetcher, window * windowSize, 0);
+  }
+  EXPECT_EQ(1, prefetcher.getDepth(kMaxDepth));
+}
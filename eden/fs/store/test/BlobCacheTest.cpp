@@ -118,3 +118,65 @@ TEST(BlobCache, does_not_forget_blob_until_last_handle_is_forgotten) {
   result2.interestHandle.reset();
   EXPECT_FALSE(weak.lock());
 }
+
+namespace {
+std::shared_ptr<const Blob> makeCompressibleBlob(const ObjectId& hash) {
+  return std::make_shared<Blob>(hash, std::string(800, hash.getBytes()[19]));
+}
+} // namespace
+
+TEST(BlobCache, evicted_blobs_are_served_from_compressed_tier) {
+  auto cache =
+      BlobCache::create(1000, 0, 1, CacheEvictionPolicy::LRU, 1000);
+  if (!cache->hasCompressedTier()) {
+    GTEST_SKIP() << "no compression codec available";
+  }
+  auto blob = makeCompressibleBlob(hash3);
+  cache->insert(blob);
+  cache->insert(makeCompressibleBlob(hash4)); // evicts blob into the tier
+
+  auto tierStats = cache->getCompressedTierStats();
+  EXPECT_EQ(1, tierStats.entryCount);
+  EXPECT_LT(tierStats.compressedSizeInBytes, blob->getSize());
+  EXPECT_EQ(blob->getSize(), tierStats.uncompressedSizeInBytes);
+
+  auto result = cache->get(hash3);
+  ASSERT_TRUE(result.object);
+  EXPECT_EQ(
+      blob->getContents().to<std::string>(),
+      result.object->getContents().to<std::string>());
+
+  // The blob is uncompressed again, and blob4 took its place in the tier.
+  tierStats = cache->getCompressedTierStats();
+  EXPECT_EQ(1, tierStats.compressedHitCount);
+  EXPECT_EQ(0, tierStats.rawHitCount);
+  EXPECT_EQ(1, tierStats.entryCount);
+  EXPECT_TRUE(cache->get(hash3).object);
+  EXPECT_EQ(1, cache->getCompressedTierStats().rawHitCount);
+}
+
+TEST(BlobCache, incompressible_blobs_are_not_kept_in_compressed_tier) {
+  auto cache = BlobCache::create(10, 0, 1, CacheEvictionPolicy::LRU, 1000);
+  if (!cache->hasCompressedTier()) {
+    GTEST_SKIP() << "no compression codec available";
+  }
+  cache->insert(blob9);
+  cache->insert(blob3);
+  EXPECT_EQ(0, cache->getCompressedTierStats().entryCount);
+  EXPECT_FALSE(cache->get(hash9).object);
+}
+
+TEST(BlobCache, clear_drops_compressed_tier) {
+  auto cache =
+      BlobCache::create(1000, 0, 1, CacheEvictionPolicy::LRU, 1000);
+  if (!cache->hasCompressedTier()) {
+    GTEST_SKIP() << "no compression codec available";
+  }
+  cache->insert(makeCompressibleBlob(hash3));
+  cache->insert(makeCompressibleBlob(hash4));
+  EXPECT_EQ(1, cache->getCompressedTierStats().entryCount);
+
+  cache->clear();
+  EXPECT_EQ(0, cache->getCompressedTierStats().entryCount);
+  EXPECT_FALSE(cache->get(hash3).object);
+}
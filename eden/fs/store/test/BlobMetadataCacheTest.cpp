@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/BlobMetadataCache.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+namespace {
+
+ObjectId makeId(size_t i) {
+  return ObjectId::sha1(fmt::format("blob{}", i));
+}
+
+BlobMetadata makeMetadata(size_t i) {
+  return BlobMetadata{Hash20::sha1(fmt::format("contents{}", i)), i};
+}
+
+} // namespace
+
+TEST(BlobMetadataCache, missing_entry_returns_nullopt) {
+  BlobMetadataCache cache{16};
+  EXPECT_FALSE(cache.get(makeId(0)).has_value());
+  EXPECT_FALSE(cache.contains(makeId(0)));
+}
+
+TEST(BlobMetadataCache, inserted_entry_can_be_read_back) {
+  BlobMetadataCache cache{16};
+  cache.insert(makeId(1), makeMetadata(1));
+
+  auto metadata = cache.get(makeId(1));
+  ASSERT_TRUE(metadata.has_value());
+  EXPECT_EQ(makeMetadata(1).sha1, metadata->sha1);
+  EXPECT_EQ(1, metadata->size);
+  EXPECT_TRUE(cache.contains(makeId(1)));
+}
+
+TEST(BlobMetadataCache, insert_replaces_existing_entry) {
+  BlobMetadataCache cache{16};
+  cache.insert(makeId(1), makeMetadata(1));
+  cache.insert(makeId(1), makeMetadata(2));
+  EXPECT_EQ(2, cache.get(makeId(1))->size);
+}
+
+TEST(BlobMetadataCache, capacity_is_bounded) {
+  BlobMetadataCache cache{64};
+  EXPECT_EQ(64, cache.getCapacity());
+
+  for (size_t i = 0; i < 1000; ++i) {
+    cache.insert(makeId(i), makeMetadata(i));
+  }
+  size_t present = 0;
+  for (size_t i = 0; i < 1000; ++i) {
+    if (auto metadata = cache.get(makeId(i))) {
+      EXPECT_EQ(i, metadata->size);
+      ++present;
+    }
+  }
+  EXPECT_LE(present, cache.getCapacity());
+  // The most recent insertion is always kept.
+  EXPECT_TRUE(cache.contains(makeId(999)));
+}
+
+TEST(BlobMetadataCache, least_recently_used_entry_is_replaced) {
+  // A single set, so every id competes for the same entries.
+  BlobMetadataCache cache{8};
+  for (size_t i = 0; i < 8; ++i) {
+    cache.insert(makeId(i), makeMetadata(i));
+  }
+  // Touch the oldest entry so that the second oldest gets replaced.
+  EXPECT_TRUE(cache.get(makeId(0)).has_value());
+  cache.insert(makeId(8), makeMetadata(8));
+
+  EXPECT_TRUE(cache.contains(makeId(0)));
+  EXPECT_FALSE(cache.contains(makeId(1)));
+  EXPECT_TRUE(cache.contains(makeId(8)));
+}
+
+TEST(BlobMetadataCache, clear_drops_all_entries) {
+  BlobMetadataCache cache{16};
+  cache.insert(makeId(1), makeMetadata(1));
+  cache.clear();
+  EXPECT_FALSE(cache.contains(makeId(1)));
+}
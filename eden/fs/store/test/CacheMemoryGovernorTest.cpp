@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/CacheMemoryGovernor.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/store/BlobCache.h"
+#include "eden/fs/store/TreeCache.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+using namespace facebook::eden;
+
+namespace {
+
+constexpr size_t kBlobCacheSize = 1000;
+constexpr size_t kTreeCacheSize = 2000;
+
+CacheMemoryGovernor::Sample pressureSample(double someAvg10) {
+  CacheMemoryGovernor::Sample sample;
+  sample.pressure = proc_util::MemoryPressure{someAvg10, 0};
+  return sample;
+}
+
+struct CacheMemoryGovernorTest : ::testing::Test {
+  void SetUp() override {
+    config = EdenConfig::createTestEdenConfig();
+    config->inMemoryTreeCacheSize.setValue(
+        kTreeCacheSize, ConfigSource::Default, true);
+    blobCache = BlobCache::create(kBlobCacheSize, 0);
+    treeCache = TreeCache::create(std::make_shared<ReloadableConfig>(
+        config, ConfigReloadBehavior::NoReload));
+    governor = std::make_unique<CacheMemoryGovernor>(
+        blobCache, treeCache, std::make_shared<EdenStats>());
+  }
+
+  std::shared_ptr<EdenConfig> config;
+  std::shared_ptr<BlobCache> blobCache;
+  std::shared_ptr<TreeCache> treeCache;
+  std::unique_ptr<CacheMemoryGovernor> governor;
+};
+
+} // namespace
+
+TEST_F(CacheMemoryGovernorTest, high_pressure_shrinks_budgets) {
+  governor->adjust(*config, pressureSample(50.0));
+  EXPECT_DOUBLE_EQ(0.5, governor->getBudgetFraction());
+  EXPECT_EQ(kBlobCacheSize / 2, blobCache->getMaximumCacheSize());
+  EXPECT_EQ(kTreeCacheSize / 2, treeCache->getMaximumCacheSize());
+}
+
+TEST_F(CacheMemoryGovernorTest, budgets_never_shrink_below_minimum) {
+  config->memoryGovernorMinimumFraction.setValue(
+      0.2, ConfigSource::Default, true);
+  for (int i = 0; i < 10; ++i) {
+    governor->adjust(*config, pressureSample(50.0));
+  }
+  EXPECT_DOUBLE_EQ(0.2, governor->getBudgetFraction());
+  EXPECT_EQ(kBlobCacheSize / 5, blobCache->getMaximumCacheSize());
+}
+
+TEST_F(CacheMemoryGovernorTest, low_pressure_grows_budgets_back) {
+  governor->adjust(*config, pressureSample(50.0));
+  governor->adjust(*config, pressureSample(50.0));
+  EXPECT_DOUBLE_EQ(0.25, governor->getBudgetFraction());
+
+  governor->adjust(*config, pressureSample(0.0));
+  EXPECT_DOUBLE_EQ(0.35, governor->getBudgetFraction());
+
+  for (int i = 0; i < 10; ++i) {
+    governor->adjust(*config, pressureSample(0.0));
+  }
+  EXPECT_DOUBLE_EQ(1.0, governor->getBudgetFraction());
+  EXPECT_EQ(kBlobCacheSize, blobCache->getMaximumCacheSize());
+  EXPECT_EQ(kTreeCacheSize, treeCache->getMaximumCacheSize());
+}
+
+TEST_F(CacheMemoryGovernorTest, moderate_pressure_keeps_budgets) {
+  governor->adjust(*config, pressureSample(50.0));
+  governor->adjust(*config, pressureSample(5.0));
+  EXPECT_DOUBLE_EQ(0.5, governor->getBudgetFraction());
+}
+
+TEST_F(CacheMemoryGovernorTest, rss_over_limit_shrinks_budgets) {
+  config->memoryGovernorRssLimit.setValue(1000, ConfigSource::Default, true);
+
+  CacheMemoryGovernor::Sample sample;
+  sample.residentBytes = 500;
+  governor->adjust(*config, sample);
+  EXPECT_DOUBLE_EQ(1.0, governor->getBudgetFraction());
+
+  sample.residentBytes = 2000;
+  governor->adjust(*config, sample);
+  EXPECT_DOUBLE_EQ(0.5, governor->getBudgetFraction());
+}
+
+TEST_F(CacheMemoryGovernorTest, shrinking_evicts_blobs) {
+  auto blob = std::make_shared<Blob>(
+      ObjectId::sha1("blob"), std::string(kBlobCacheSize * 3 / 4, 'a'));
+  blobCache->insert(blob);
+  EXPECT_EQ(1, blobCache->getStats().objectCount);
+
+  governor->adjust(*config, pressureSample(50.0));
+  EXPECT_EQ(0, blobCache->getStats().objectCount);
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/CacheWarmer.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/TestOps.h"
+#include "eden/fs/store/LocalStoreCachedBackingStore.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/StoredObject.h"
+#include "eden/fs/testharness/TempFile.h"
+#include "eden/fs/utils/FileUtils.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+using namespace std::chrono_literals;
+using namespace std::string_literals;
+
+namespace {
+
+struct CacheWarmerTest : ::testing::Test {
+  void SetUp() override {
+    auto edenConfig = std::make_shared<ReloadableConfig>(
+        EdenConfig::createTestEdenConfig(), ConfigReloadBehavior::NoReload);
+    auto localStore = std::make_shared<MemoryLocalStore>();
+    auto stats = std::make_shared<EdenStats>();
+    fakeBackingStore = std::make_shared<FakeBackingStore>();
+    objectStore = ObjectStore::create(
+        localStore,
+        std::make_shared<LocalStoreCachedBackingStore>(
+            fakeBackingStore, localStore, stats),
+        TreeCache::create(edenConfig),
+        stats,
+        std::make_shared<ProcessNameCache>(),
+        std::make_shared<NullStructuredLogger>(),
+        EdenConfig::createTestEdenConfig(),
+        kPathMapDefaultCaseSensitive);
+  }
+
+  AbsolutePath getIdsPath() const {
+    return canonicalPath(tempDir.path().string()) + "hot-object-ids"_pc;
+  }
+
+  folly::test::TemporaryDirectory tempDir{makeTempDir()};
+  std::shared_ptr<FakeBackingStore> fakeBackingStore;
+  std::shared_ptr<ObjectStore> objectStore;
+};
+
+} // namespace
+
+TEST_F(CacheWarmerTest, hot_object_ids_round_trip) {
+  HotObjectIds ids;
+  ids.trees = {ObjectId::sha1("tree1"s), ObjectId::sha1("tree2"s)};
+  ids.blobs = {
+      ObjectId{folly::ByteRange{"variable id"_sp}}, ObjectId::sha1("blob"s)};
+  ids.save(getIdsPath());
+
+  auto loaded = HotObjectIds::load(getIdsPath());
+  EXPECT_EQ(ids.trees, loaded.trees);
+  EXPECT_EQ(ids.blobs, loaded.blobs);
+}
+
+TEST_F(CacheWarmerTest, malformed_lines_are_skipped) {
+  auto id = ObjectId::sha1("blob"s);
+  auto contents = fmt::format(
+      "b {}\nb nothex\nx {}\n\ngarbage\n", id.asHexString(), id.asHexString());
+  writeFile(getIdsPath(), folly::StringPiece{contents}).value();
+
+  auto loaded = HotObjectIds::load(getIdsPath());
+  EXPECT_TRUE(loaded.trees.empty());
+  EXPECT_EQ(std::vector<ObjectId>{id}, loaded.blobs);
+}
+
+TEST_F(CacheWarmerTest, loading_missing_file_throws) {
+  EXPECT_ANY_THROW(HotObjectIds::load(getIdsPath()));
+}
+
+TEST_F(CacheWarmerTest, fetches_every_object) {
+  HotObjectIds ids;
+  auto* tree = fakeBackingStore->putTree({});
+  tree->setReady();
+  ids.trees.push_back(tree->get().getHash());
+  for (int i = 0; i < 10; ++i) {
+    auto* blob = fakeBackingStore->putBlob(fmt::format("blob{}", i));
+    blob->setReady();
+    ids.blobs.push_back(blob->get().getHash());
+  }
+
+  auto warmer = CacheWarmer::start(objectStore, ids, 4);
+  std::move(warmer->getCompletionFuture()).get(0ms);
+
+  auto progress = warmer->getProgress();
+  EXPECT_TRUE(progress.done);
+  EXPECT_FALSE(progress.cancelled);
+  EXPECT_EQ(11, progress.totalCount);
+  EXPECT_EQ(11, progress.fetchedCount);
+  EXPECT_EQ(0, progress.failedCount);
+  for (const auto& id : ids.blobs) {
+    EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+  }
+}
+
+TEST_F(CacheWarmerTest, unknown_objects_are_counted_as_failures) {
+  auto* blob = fakeBackingStore->putBlob("blob"_sp);
+  blob->setReady();
+
+  HotObjectIds ids;
+  ids.trees = {ObjectId::sha1("missing tree"s)};
+  ids.blobs = {ObjectId::sha1("missing blob"s), blob->get().getHash()};
+
+  auto warmer = CacheWarmer::start(objectStore, std::move(ids), 1);
+  std::move(warmer->getCompletionFuture()).get(0ms);
+  auto progress = warmer->getProgress();
+  EXPECT_EQ(1, progress.fetchedCount);
+  EXPECT_EQ(2, progress.failedCount);
+}
+
+TEST_F(CacheWarmerTest, pending_fetches_are_awaited) {
+  auto* blob1 = fakeBackingStore->putBlob("blob1"_sp);
+  auto* blob2 = fakeBackingStore->putBlob("blob2"_sp);
+
+  HotObjectIds ids;
+  ids.blobs = {blob1->get().getHash(), blob2->get().getHash()};
+  auto warmer = CacheWarmer::start(objectStore, std::move(ids), 1);
+  auto completion = warmer->getCompletionFuture();
+
+  EXPECT_FALSE(completion.isReady());
+  blob1->setReady();
+  EXPECT_FALSE(completion.isReady());
+  blob2->setReady();
+  std::move(completion).get(0ms);
+  EXPECT_EQ(2, warmer->getProgress().fetchedCount);
+}
+
+TEST_F(CacheWarmerTest, cancel_stops_issuing_fetches) {
+  auto* blob1 = fakeBackingStore->putBlob("blob1"_sp);
+  auto* blob2 = fakeBackingStore->putBlob("blob2"_sp);
+
+  HotObjectIds ids;
+  ids.blobs = {blob1->get().getHash(), blob2->get().getHash()};
+  auto warmer = CacheWarmer::start(objectStore, std::move(ids), 1);
+  auto completion = warmer->getCompletionFuture();
+
+  warmer->cancel();
+  EXPECT_FALSE(completion.isReady()) << "blob1 is still being fetched";
+  blob1->setReady();
+  std::move(completion).get(0ms);
+
+  auto progress = warmer->getProgress();
+  EXPECT_TRUE(progress.done);
+  EXPECT_TRUE(progress.cancelled);
+  EXPECT_EQ(1, progress.fetchedCount);
+  EXPECT_EQ(0, fakeBackingStore->getAccessCount(blob2->get().getHash()));
+}
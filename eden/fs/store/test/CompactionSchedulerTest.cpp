@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/CompactionScheduler.h"
+
+#include <folly/portability/GTest.h>
+#include <atomic>
+#include <thread>
+
+#include "eden/fs/config/EdenConfig.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+std::shared_ptr<EdenConfig> makeConfig(
+    std::chrono::nanoseconds deferLatency,
+    std::chrono::nanoseconds maxDeferral) {
+  auto config = EdenConfig::createTestEdenConfig();
+  config->localStoreGcDeferLatency.setValue(
+      deferLatency, ConfigSource::Default, true);
+  config->localStoreGcMaxDeferral.setValue(
+      maxDeferral, ConfigSource::Default, true);
+  return config;
+}
+
+} // namespace
+
+TEST(CompactionSchedulerTest, never_defers_without_a_probe) {
+  CompactionScheduler scheduler{1ms};
+  scheduler.updateConfig(*makeConfig(1ms, 1h));
+  EXPECT_FALSE(scheduler.shouldDefer());
+  EXPECT_TRUE(scheduler.waitUntilIdle());
+  EXPECT_EQ(0, scheduler.getDeferralCount());
+}
+
+TEST(CompactionSchedulerTest, defers_while_latency_is_elevated) {
+  CompactionScheduler scheduler{1ms};
+  scheduler.updateConfig(*makeConfig(10ms, 1h));
+  std::atomic<std::chrono::microseconds::rep> latency{0};
+  scheduler.setLatencyProbe(
+      [&] { return std::chrono::microseconds{latency.load()}; });
+  EXPECT_FALSE(scheduler.shouldDefer());
+
+  latency = std::chrono::microseconds{20ms}.count();
+  EXPECT_TRUE(scheduler.shouldDefer());
+
+  std::thread waiter{[&] { EXPECT_TRUE(scheduler.waitUntilIdle()); }};
+  std::this_thread::sleep_for(20ms);
+  latency = 0;
+  waiter.join();
+  EXPECT_EQ(1, scheduler.getDeferralCount());
+}
+
+TEST(CompactionSchedulerTest, stops_deferring_after_max_deferral) {
+  CompactionScheduler scheduler{1ms};
+  scheduler.updateConfig(*makeConfig(10ms, 20ms));
+  scheduler.setLatencyProbe([] { return std::chrono::microseconds{1s}; });
+  EXPECT_TRUE(scheduler.waitUntilIdle());
+  EXPECT_EQ(1, scheduler.getDeferralCount());
+}
+
+TEST(CompactionSchedulerTest, zero_threshold_disables_deferral) {
+  CompactionScheduler scheduler{1ms};
+  scheduler.updateConfig(*makeConfig(0ms, 1h));
+  scheduler.setLatencyProbe([] { return std::chrono::microseconds{1s}; });
+  EXPECT_FALSE(scheduler.shouldDefer());
+}
+
+TEST(CompactionSchedulerTest, cancel_interrupts_waiting) {
+  CompactionScheduler scheduler{1ms};
+  scheduler.updateConfig(*makeConfig(10ms, 1h));
+  scheduler.setLatencyProbe([] { return std::chrono::microseconds{1s}; });
+
+  std::thread waiter{[&] { EXPECT_FALSE(scheduler.waitUntilIdle()); }};
+  std::this_thread::sleep_for(10ms);
+  scheduler.cancel();
+  waiter.join();
+  EXPECT_FALSE(scheduler.waitUntilIdle());
+}
@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/FetchCostAccumulator.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+TEST(FetchCostAccumulatorTest, sums_the_fetches_of_each_origin) {
+  FetchCostAccumulator accumulator;
+  EXPECT_TRUE(accumulator.getFetchCost().empty());
+
+  accumulator.add(ObjectFetchContext::FromMemoryCache, 2us, 10);
+  accumulator.add(ObjectFetchContext::FromMemoryCache, 3us, 20);
+  accumulator.add(ObjectFetchContext::FromNetworkFetch, 40ms, 4096);
+
+  auto cost = accumulator.getFetchCost();
+  EXPECT_FALSE(cost.empty());
+  EXPECT_EQ(2, cost.tiers[FetchCost::MemoryCache].count);
+  EXPECT_EQ(5us, cost.tiers[FetchCost::MemoryCache].duration);
+  EXPECT_EQ(30, cost.tiers[FetchCost::MemoryCache].bytes);
+  EXPECT_EQ(0, cost.tiers[FetchCost::DiskCache].count);
+  EXPECT_EQ(1, cost.tiers[FetchCost::BackingStore].count);
+  EXPECT_EQ(40ms, cost.tiers[FetchCost::BackingStore].duration);
+  EXPECT_EQ(4096, cost.tiers[FetchCost::BackingStore].bytes);
+}
+
+TEST(FetchCostAccumulatorTest, failed_fetches_are_not_counted) {
+  FetchCostAccumulator accumulator;
+  accumulator.add(ObjectFetchContext::NotFetched, 1ms, 0);
+  EXPECT_TRUE(accumulator.getFetchCost().empty());
+}
+
+TEST(FetchCostAccumulatorTest, toString_lists_the_sources_fetched_from) {
+  FetchCostAccumulator accumulator;
+  EXPECT_EQ("", accumulator.getFetchCost().toString());
+
+  accumulator.add(ObjectFetchContext::FromMemoryCache, 31us, 1024);
+  accumulator.add(ObjectFetchContext::FromNetworkFetch, 42017us, 4096);
+  EXPECT_EQ(
+      "memory_cache=1/31us/1024B backing_store=1/42017us/4096B",
+      accumulator.getFetchCost().toString());
+}
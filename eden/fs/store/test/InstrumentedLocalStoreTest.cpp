@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/InstrumentedLocalStore.h"
+
+#include <fb303/ServiceData.h>
+#include <folly/futures/Future.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+using namespace std::chrono_literals;
+
+namespace {
+
+class InstrumentedLocalStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    store_ = std::make_shared<InstrumentedLocalStore>(
+        std::make_shared<MemoryLocalStore>(), stats_);
+    store_->open();
+  }
+
+  /**
+   * fb303 counters are shared by the whole process, tests look at how much
+   * they changed.
+   */
+  int64_t getCounter(folly::StringPiece name) {
+    stats_->flush();
+    auto data = facebook::fb303::ServiceData::get();
+    return data->hasCounter(name) ? data->getCounter(name) : 0;
+  }
+
+  std::shared_ptr<EdenStats> stats_{std::make_shared<EdenStats>()};
+  std::shared_ptr<LocalStore> store_;
+};
+
+} // namespace
+
+TEST_F(InstrumentedLocalStoreTest, records_reads_and_writes_per_key_space) {
+  auto treePuts = getCounter("local_store.tree.put_us.count");
+  auto treeWritten = getCounter("local_store.tree.write_bytes.sum");
+  auto treeGets = getCounter("local_store.tree.get_us.count");
+  auto treeRead = getCounter("local_store.tree.read_bytes.sum");
+  auto blobGets = getCounter("local_store.blob.get_us.count");
+
+  store_->put(KeySpace::TreeFamily, "key"_sp, "value"_sp);
+  EXPECT_EQ("value", store_->get(KeySpace::TreeFamily, "key"_sp).piece());
+  EXPECT_FALSE(store_->get(KeySpace::TreeFamily, "missing"_sp).isValid());
+
+  EXPECT_EQ(1, getCounter("local_store.tree.put_us.count") - treePuts);
+  EXPECT_EQ(5, getCounter("local_store.tree.write_bytes.sum") - treeWritten);
+  EXPECT_EQ(2, getCounter("local_store.tree.get_us.count") - treeGets);
+  EXPECT_EQ(5, getCounter("local_store.tree.read_bytes.sum") - treeRead);
+  EXPECT_EQ(blobGets, getCounter("local_store.blob.get_us.count"));
+}
+
+TEST_F(InstrumentedLocalStoreTest, records_batched_reads) {
+  store_->put(KeySpace::BlobMetaDataFamily, "a"_sp, "12"_sp);
+  store_->put(KeySpace::BlobMetaDataFamily, "b"_sp, "345"_sp);
+  auto batches = getCounter("local_store.blobmeta.get_batch_us.count");
+  auto read = getCounter("local_store.blobmeta.read_bytes.sum");
+
+  std::vector<folly::ByteRange> keys{"a"_sp, "missing"_sp, "b"_sp};
+  auto results =
+      store_->getBatch(KeySpace::BlobMetaDataFamily, keys).get(10s);
+  ASSERT_EQ(3, results.size());
+
+  EXPECT_EQ(
+      1, getCounter("local_store.blobmeta.get_batch_us.count") - batches);
+  EXPECT_EQ(5, getCounter("local_store.blobmeta.read_bytes.sum") - read);
+}
+
+TEST_F(InstrumentedLocalStoreTest, records_write_batch_flushes) {
+  auto flushes = getCounter("local_store.write_batch.flush_us.count");
+  auto flushed = getCounter("local_store.write_batch.flush_bytes.sum");
+  auto blobWritten = getCounter("local_store.blob.write_bytes.sum");
+
+  auto batch = store_->beginWrite();
+  batch->put(KeySpace::BlobFamily, "a"_sp, "1234"_sp);
+  batch->put(
+      KeySpace::HgProxyHashFamily,
+      "b"_sp,
+      std::vector<folly::ByteRange>{"12"_sp, "34"_sp});
+  batch->flush();
+
+  EXPECT_TRUE(store_->hasKey(KeySpace::BlobFamily, "a"_sp));
+  EXPECT_EQ("1234", store_->get(KeySpace::HgProxyHashFamily, "b"_sp).piece());
+  EXPECT_EQ(1, getCounter("local_store.write_batch.flush_us.count") - flushes);
+  EXPECT_EQ(
+      8, getCounter("local_store.write_batch.flush_bytes.sum") - flushed);
+  EXPECT_EQ(4, getCounter("local_store.blob.write_bytes.sum") - blobWritten);
+}
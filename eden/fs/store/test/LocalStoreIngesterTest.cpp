@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/LocalStoreIngester.h"
+
+#include <folly/portability/GTest.h>
+#include <thread>
+
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/TestOps.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/telemetry/EdenStats.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+std::unique_ptr<Tree> makeTree() {
+  auto fileId = ObjectId::sha1("file");
+  return std::make_unique<Tree>(
+      Tree::container{
+          {{PathComponent{"f"},
+            TreeEntry{fileId, TreeEntryType::REGULAR_FILE}}},
+          kPathMapDefaultCaseSensitive},
+      ObjectId::sha1("tree"));
+}
+
+template <typename Fn>
+bool waitFor(Fn&& condition) {
+  for (int i = 0; i < 1000; ++i) {
+    if (condition()) {
+      return true;
+    }
+    /* sleep override */ std::this_thread::sleep_for(1ms);
+  }
+  return condition();
+}
+
+class LocalStoreIngesterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    localStore = std::make_shared<MemoryLocalStore>();
+    localStore->open();
+  }
+
+  std::unique_ptr<LocalStoreIngester> makeIngester(
+      size_t flushBytes,
+      std::chrono::milliseconds flushInterval) {
+    return std::make_unique<LocalStoreIngester>(
+        localStore, std::make_shared<EdenStats>(), flushBytes, flushInterval);
+  }
+
+  std::shared_ptr<LocalStore> localStore;
+};
+
+} // namespace
+
+TEST_F(LocalStoreIngesterTest, pending_objects_can_be_read_back) {
+  auto ingester = makeIngester(1024 * 1024, 1h);
+  auto tree = makeTree();
+  auto blobId = ObjectId::sha1("blob");
+  Blob blob{blobId, folly::StringPiece{"contents"}};
+
+  ingester->putTree(*tree);
+  ingester->putBlob(blobId, blob);
+  EXPECT_FALSE(localStore->hasKey(KeySpace::TreeFamily, tree->getHash()));
+  EXPECT_FALSE(localStore->hasKey(KeySpace::BlobFamily, blobId));
+
+  auto pendingTree = ingester->getPendingTree(tree->getHash());
+  ASSERT_NE(nullptr, pendingTree);
+  EXPECT_EQ(*tree, *pendingTree);
+  auto pendingBlob = ingester->getPendingBlob(blobId);
+  ASSERT_NE(nullptr, pendingBlob);
+  EXPECT_EQ("contents", pendingBlob->asString());
+  EXPECT_GT(ingester->getPendingBytes(), 0);
+}
+
+TEST_F(LocalStoreIngesterTest, flush_writes_pending_objects) {
+  auto ingester = makeIngester(1024 * 1024, 1h);
+  auto tree = makeTree();
+  auto blobId = ObjectId::sha1("blob");
+  Blob blob{blobId, folly::StringPiece{"contents"}};
+  BlobMetadata metadata{Hash20::sha1(std::string{"contents"}), 8};
+
+  ingester->putTree(*tree);
+  ingester->putBlob(blobId, blob);
+  ingester->putBlobMetadata(blobId, metadata);
+  ingester->flush();
+
+  EXPECT_EQ(0, ingester->getPendingBytes());
+  EXPECT_EQ(nullptr, ingester->getPendingTree(tree->getHash()));
+  EXPECT_EQ(nullptr, ingester->getPendingBlob(blobId));
+
+  auto storedTree = localStore->getTree(tree->getHash()).get();
+  ASSERT_NE(nullptr, storedTree);
+  EXPECT_EQ(*tree, *storedTree);
+  auto storedBlob = localStore->getBlob(blobId).get();
+  ASSERT_NE(nullptr, storedBlob);
+  EXPECT_EQ("contents", storedBlob->asString());
+  auto storedMetadata = localStore->getBlobMetadata(blobId).get();
+  ASSERT_TRUE(storedMetadata.has_value());
+  EXPECT_EQ(8, storedMetadata->size);
+}
+
+TEST_F(LocalStoreIngesterTest, full_batch_is_flushed_in_the_background) {
+  auto ingester = makeIngester(16, 1h);
+  auto blobId = ObjectId::sha1("blob");
+  Blob blob{blobId, folly::StringPiece{"more than sixteen bytes"}};
+  ingester->putBlob(blobId, blob);
+
+  EXPECT_TRUE(waitFor(
+      [&] { return localStore->hasKey(KeySpace::BlobFamily, blobId); }));
+}
+
+TEST_F(LocalStoreIngesterTest, batch_is_flushed_after_interval) {
+  auto ingester = makeIngester(1024 * 1024, 10ms);
+  auto blobId = ObjectId::sha1("blob");
+  Blob blob{blobId, folly::StringPiece{"contents"}};
+  ingester->putBlob(blobId, blob);
+
+  EXPECT_TRUE(waitFor(
+      [&] { return localStore->hasKey(KeySpace::BlobFamily, blobId); }));
+}
+
+TEST_F(LocalStoreIngesterTest, destruction_flushes_pending_objects) {
+  auto blobId = ObjectId::sha1("blob");
+  {
+    auto ingester = makeIngester(1024 * 1024, 1h);
+    Blob blob{blobId, folly::StringPiece{"contents"}};
+    ingester->putBlob(blobId, blob);
+  }
+  EXPECT_TRUE(localStore->hasKey(KeySpace::BlobFamily, blobId));
+}
+
+TEST_F(LocalStoreIngesterTest, blobs_are_skipped_when_blob_caching_is_off) {
+  localStore->enableBlobCaching = false;
+  auto ingester = makeIngester(1024 * 1024, 1h);
+  auto blobId = ObjectId::sha1("blob");
+  Blob blob{blobId, folly::StringPiece{"contents"}};
+  ingester->putBlob(blobId, blob);
+  EXPECT_EQ(nullptr, ingester->getPendingBlob(blobId));
+  EXPECT_EQ(0, ingester->getPendingBytes());
+}
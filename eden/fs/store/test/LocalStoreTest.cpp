@@ -6,8 +6,11 @@
  */
 
 #include "eden/fs/store/test/LocalStoreTest.h"
+#include "eden/fs/store/InstrumentedLocalStore.h"
 #include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/PackLocalStore.h"
 #include "eden/fs/store/SqliteLocalStore.h"
+#include "eden/fs/telemetry/EdenStats.h"
 
 namespace {
 
@@ -19,6 +22,13 @@ LocalStoreImplResult makeMemoryLocalStore(FaultInjector*) {
   return {std::nullopt, std::make_shared<MemoryLocalStore>()};
 }
 
+LocalStoreImplResult makeInstrumentedLocalStore(FaultInjector*) {
+  return {
+      std::nullopt,
+      std::make_shared<InstrumentedLocalStore>(
+          std::make_shared<MemoryLocalStore>(), std::make_shared<EdenStats>())};
+}
+
 LocalStoreImplResult makeSqliteLocalStore(FaultInjector*) {
   auto tempDir = makeTempDir();
   auto store = std::make_shared<SqliteLocalStore>(
@@ -26,6 +36,13 @@ LocalStoreImplResult makeSqliteLocalStore(FaultInjector*) {
   return {std::move(tempDir), std::move(store)};
 }
 
+LocalStoreImplResult makePackLocalStore(FaultInjector*) {
+  auto tempDir = makeTempDir();
+  auto store = std::make_shared<PackLocalStore>(
+      canonicalPath(tempDir.path().string()) + "packs"_pc, 64 * 1024);
+  return {std::move(tempDir), std::move(store)};
+}
+
 TEST_P(OpenCloseLocalStoreTest, closeBeforeOpen) {
   auto tempDir = makeTempDir();
   store_->close();
@@ -238,6 +255,19 @@ TEST_P(LocalStoreTest, testMultipleBlobWriters) {
   EXPECT_EQ("hello world1_4", result1_4.piece());
 }
 
+TEST_P(LocalStoreTest, ephemeral_write_batch_is_visible_after_flush) {
+  auto batch = store_->beginEphemeralWrite();
+  batch->put(KeySpace::BlobFamily, "blob"_sp, "blobContents"_sp);
+  batch->put(KeySpace::TreeFamily, "tree"_sp, "treeContents"_sp);
+  EXPECT_FALSE(store_->hasKey(KeySpace::BlobFamily, "blob"_sp));
+
+  batch->flush();
+  EXPECT_EQ(
+      "blobContents", store_->get(KeySpace::BlobFamily, "blob"_sp).piece());
+  EXPECT_EQ(
+      "treeContents", store_->get(KeySpace::TreeFamily, "tree"_sp).piece());
+}
+
 TEST_P(LocalStoreTest, testClearKeySpace) {
   store_->put(KeySpace::BlobFamily, "key1"_sp, "blob1"_sp);
   store_->put(KeySpace::BlobFamily, "key2"_sp, "blob2"_sp);
@@ -248,6 +278,37 @@ TEST_P(LocalStoreTest, testClearKeySpace) {
   EXPECT_TRUE(store_->hasKey(KeySpace::TreeFamily, "tree"_sp));
 }
 
+TEST_P(LocalStoreTest, getBatch_returns_results_in_key_order) {
+  // Large enough to be split into several MultiGet calls by RocksDbLocalStore.
+  constexpr size_t kKeyCount = 5000;
+  std::vector<std::string> keys;
+  for (size_t i = 0; i < kKeyCount; ++i) {
+    keys.push_back(fmt::format("key{}", i));
+    if (i % 3 != 0) {
+      store_->put(
+          KeySpace::BlobFamily,
+          folly::StringPiece{keys.back()},
+          folly::StringPiece{fmt::format("value{}", i)});
+    }
+  }
+
+  std::vector<folly::ByteRange> keyRanges;
+  for (const auto& key : keys) {
+    keyRanges.emplace_back(folly::StringPiece{key});
+  }
+  auto results = store_->getBatch(KeySpace::BlobFamily, keyRanges).get(10s);
+
+  ASSERT_EQ(kKeyCount, results.size());
+  for (size_t i = 0; i < kKeyCount; ++i) {
+    if (i % 3 == 0) {
+      EXPECT_FALSE(results[i].isValid()) << keys[i];
+    } else {
+      ASSERT_TRUE(results[i].isValid()) << keys[i];
+      EXPECT_EQ(fmt::format("value{}", i), results[i].piece());
+    }
+  }
+}
+
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wdeprecated-declarations"
 INSTANTIATE_TEST_CASE_P(
@@ -260,6 +321,16 @@ INSTANTIATE_TEST_CASE_P(
     LocalStoreTest,
     ::testing::Values(makeSqliteLocalStore));
 
+INSTANTIATE_TEST_CASE_P(
+    Pack,
+    LocalStoreTest,
+    ::testing::Values(makePackLocalStore));
+
+INSTANTIATE_TEST_CASE_P(
+    Instrumented,
+    LocalStoreTest,
+    ::testing::Values(makeInstrumentedLocalStore));
+
 INSTANTIATE_TEST_CASE_P(
     Memory,
     OpenCloseLocalStoreTest,
@@ -269,6 +340,11 @@ INSTANTIATE_TEST_CASE_P(
     Sqlite,
     OpenCloseLocalStoreTest,
     ::testing::Values(makeSqliteLocalStore));
+
+INSTANTIATE_TEST_CASE_P(
+    Pack,
+    OpenCloseLocalStoreTest,
+    ::testing::Values(makePackLocalStore));
 #pragma clang diagnostic pop
 
 } // namespace
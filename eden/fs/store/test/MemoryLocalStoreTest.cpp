@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/MemoryLocalStore.h"
+
+#include <fmt/format.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/config/EdenConfig.h"
+#include "eden/fs/store/StoreResult.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+namespace {
+
+constexpr uint64_t kBudget = 10 * 1024;
+
+class BoundedMemoryLocalStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    config_ = EdenConfig::createTestEdenConfig();
+    config_->localStoreBlobSizeLimit.setValue(
+        kBudget, ConfigSource::Default, true);
+    store_ = std::make_unique<MemoryLocalStore>(*config_);
+    store_->open();
+  }
+
+  void putBlob(size_t i) {
+    std::string value(1000, 'v');
+    store_->put(
+        KeySpace::BlobFamily,
+        folly::StringPiece{fmt::format("key{}", i)},
+        folly::StringPiece{value});
+  }
+
+  bool hasBlob(size_t i) {
+    return store_->hasKey(
+        KeySpace::BlobFamily, folly::StringPiece{fmt::format("key{}", i)});
+  }
+
+  std::shared_ptr<EdenConfig> config_;
+  std::unique_ptr<MemoryLocalStore> store_;
+};
+
+} // namespace
+
+TEST(MemoryLocalStoreTest, unbounded_store_keeps_everything) {
+  MemoryLocalStore store;
+  std::string value(1024 * 1024, 'v');
+  for (size_t i = 0; i < 32; ++i) {
+    store.put(
+        KeySpace::BlobFamily,
+        folly::StringPiece{fmt::format("key{}", i)},
+        folly::StringPiece{value});
+  }
+  EXPECT_EQ(0, store.getEvictionCount());
+  EXPECT_TRUE(store.hasKey(KeySpace::BlobFamily, "key0"_sp));
+}
+
+TEST_F(BoundedMemoryLocalStoreTest, stays_within_budget) {
+  for (size_t i = 0; i < 100; ++i) {
+    putBlob(i);
+    EXPECT_LE(store_->getSize(KeySpace::BlobFamily), kBudget);
+  }
+  EXPECT_GT(store_->getEvictionCount(), 0);
+  EXPECT_TRUE(hasBlob(99));
+  EXPECT_FALSE(hasBlob(0));
+}
+
+TEST_F(BoundedMemoryLocalStoreTest, least_recently_used_values_are_evicted) {
+  for (size_t i = 0; i < 9; ++i) {
+    putBlob(i);
+  }
+  // Reading the oldest value makes it the most recently used.
+  EXPECT_TRUE(store_->get(KeySpace::BlobFamily, "key0"_sp).isValid());
+  putBlob(9);
+  putBlob(10);
+
+  EXPECT_TRUE(hasBlob(0));
+  EXPECT_FALSE(hasBlob(1));
+  EXPECT_TRUE(hasBlob(10));
+}
+
+TEST_F(BoundedMemoryLocalStoreTest, persistent_key_spaces_are_not_bounded) {
+  std::string value(2 * kBudget, 'v');
+  store_->put(KeySpace::HgProxyHashFamily, "key"_sp, folly::StringPiece{value});
+  EXPECT_TRUE(store_->hasKey(KeySpace::HgProxyHashFamily, "key"_sp));
+  EXPECT_EQ(0, store_->getEvictionCount());
+}
+
+TEST_F(BoundedMemoryLocalStoreTest, lowered_budget_applies_on_next_run) {
+  for (size_t i = 0; i < 8; ++i) {
+    putBlob(i);
+  }
+  EXPECT_EQ(0, store_->getEvictionCount());
+
+  config_->localStoreBlobSizeLimit.setValue(
+      kBudget / 2, ConfigSource::Default, true);
+  store_->periodicManagementTask(*config_);
+  EXPECT_LE(store_->getSize(KeySpace::BlobFamily), kBudget / 2);
+  EXPECT_TRUE(hasBlob(7));
+}
@@ -29,18 +29,28 @@ class Object {
 
 using SimpleObjectCache = ObjectCache<Object, ObjectCacheFlavor::Simple>;
 
+/**
+ * A 20-byte ObjectId fits in the inline storage of ObjectId, longer ones, like
+ * the Mercurial ids embedding a path, are allocated.
+ */
+ObjectId makeObjectId(size_t i, size_t size) {
+  auto id = ObjectId::sha1(fmt::format("{}", i)).asString();
+  id.resize(size, 'p');
+  return ObjectId{folly::ByteRange{folly::StringPiece{id}}};
+}
+
 void getSimple(benchmark::State& st) {
   auto numObjects = 100000u;
   auto cache = SimpleObjectCache::create(40 * 1024 * 1024, 1);
+  auto idSize = st.range(0);
   for (auto i = 0u; i < numObjects; i++) {
-    auto object =
-        std::make_shared<Object>(ObjectId::sha1(fmt::format("{}", i)));
+    auto object = std::make_shared<Object>(makeObjectId(i, idSize));
     cache->insertSimple(object);
   }
 
   auto i = 0u;
   for (auto _ : st) {
-    auto hash = ObjectId::sha1(fmt::format("{}", i));
+    auto hash = makeObjectId(i, idSize);
 
     auto start = std::chrono::high_resolution_clock::now();
     auto res = cache->getSimple(hash);
@@ -56,7 +66,7 @@ void getSimple(benchmark::State& st) {
   }
 }
 
-BENCHMARK(getSimple)->UseManualTime();
+BENCHMARK(getSimple)->ArgName("id_size")->Arg(20)->Arg(40)->UseManualTime();
 
 void insertSimple(benchmark::State& st) {
   auto numObjects = 100000u;
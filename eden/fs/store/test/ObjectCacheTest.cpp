@@ -7,6 +7,7 @@
 
 #include "eden/fs/store/ObjectCache.h"
 #include <gtest/gtest.h>
+#include "eden/fs/model/TestOps.h"
 
 using namespace folly::literals;
 using namespace facebook::eden;
@@ -534,3 +535,160 @@ TEST(
   handle3.reset();
   EXPECT_TRUE(cache->contains(hash3));
 }
+
+/**
+ * Sharded cache test cases
+ */
+
+TEST(ObjectCache, sharded_cache_finds_all_inserted_objects) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(1000, 0, 4);
+  EXPECT_EQ(4, cache->getShardCount());
+
+  for (const auto& object :
+       {object3, object3a, object3b, object3c, object4, object5, object6}) {
+    cache->insertSimple(object);
+  }
+  for (const auto& object :
+       {object3, object3a, object3b, object3c, object4, object5, object6}) {
+    EXPECT_EQ(object, cache->getSimple(object->getHash()));
+  }
+
+  auto stats = cache->getStats();
+  EXPECT_EQ(7, stats.objectCount);
+  EXPECT_EQ(27, stats.totalSizeInBytes);
+  EXPECT_EQ(7, stats.hitCount);
+  ASSERT_EQ(4, stats.shards.size());
+
+  size_t objectCount = 0;
+  uint64_t hitCount = 0;
+  for (const auto& shard : stats.shards) {
+    objectCount += shard.objectCount;
+    hitCount += shard.hitCount;
+  }
+  EXPECT_EQ(stats.objectCount, objectCount);
+  EXPECT_EQ(stats.hitCount, hitCount);
+}
+
+TEST(ObjectCache, sharded_cache_splits_budget_between_shards) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(20, 0, 2);
+
+  for (int i = 0; i < 100; ++i) {
+    cache->insertSimple(std::make_shared<CacheObject>(
+        ObjectId::sha1(fmt::format("{}", i)), 3));
+  }
+
+  auto stats = cache->getStats();
+  EXPECT_LE(stats.totalSizeInBytes, 20);
+  for (const auto& shard : stats.shards) {
+    EXPECT_LE(shard.totalSizeInBytes, 10);
+  }
+}
+
+TEST(ObjectCache, zero_shards_is_one_shard) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(10, 1, 0);
+  EXPECT_EQ(1, cache->getShardCount());
+  cache->insertSimple(object3);
+  EXPECT_EQ(object3, cache->getSimple(hash3));
+}
+
+TEST(ObjectCache, hot_object_ids_are_most_recently_used_first) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(100, 0);
+  cache->insertSimple(object3);
+  cache->insertSimple(object4);
+  cache->insertSimple(object5);
+  cache->getSimple(hash3);
+
+  EXPECT_EQ(
+      (std::vector<ObjectId>{hash3, hash5, hash4}),
+      cache->getHotObjectIds(10));
+  EXPECT_EQ((std::vector<ObjectId>{hash3}), cache->getHotObjectIds(1));
+}
+
+TEST(ObjectCache, hot_object_ids_come_from_every_shard) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(100, 0, 4);
+  for (const auto& object : {object3, object3a, object3b, object3c, object4}) {
+    cache->insertSimple(object);
+  }
+  auto ids = cache->getHotObjectIds(10);
+  std::sort(ids.begin(), ids.end());
+  EXPECT_EQ(
+      (std::vector<ObjectId>{hash3, hash4, hash3a, hash3b, hash3c}), ids);
+  EXPECT_EQ(3, cache->getHotObjectIds(3).size());
+}
+
+/**
+ * TinyLFU admission test cases
+ */
+
+TEST(ObjectCache, tinylfu_admits_while_cache_has_room) {
+  auto cache = ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(
+      10, 0, 1, CacheEvictionPolicy::TinyLFU);
+  cache->insertSimple(object3);
+  cache->insertSimple(object4);
+  EXPECT_TRUE(cache->contains(hash3));
+  EXPECT_TRUE(cache->contains(hash4));
+  EXPECT_EQ(0, cache->getStats().admissionRejectionCount);
+}
+
+TEST(ObjectCache, tinylfu_rejects_one_off_objects_when_full) {
+  auto cache = ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(
+      10, 0, 1, CacheEvictionPolicy::TinyLFU);
+  cache->insertSimple(object3);
+  cache->insertSimple(object3a);
+  cache->insertSimple(object3b);
+  // Make the resident objects popular.
+  for (int i = 0; i < 3; ++i) {
+    cache->getSimple(hash3);
+    cache->getSimple(hash3a);
+    cache->getSimple(hash3b);
+  }
+
+  // A scan of never seen before objects doesn't displace them.
+  cache->insertSimple(object4);
+  cache->insertSimple(object5);
+  EXPECT_FALSE(cache->contains(hash4));
+  EXPECT_FALSE(cache->contains(hash5));
+  EXPECT_TRUE(cache->contains(hash3));
+  EXPECT_TRUE(cache->contains(hash3a));
+  EXPECT_TRUE(cache->contains(hash3b));
+  EXPECT_EQ(2, cache->getStats().admissionRejectionCount);
+}
+
+TEST(ObjectCache, tinylfu_admits_objects_more_popular_than_victim) {
+  auto cache = ObjectCache<CacheObject, ObjectCacheFlavor::Simple>::create(
+      10, 0, 1, CacheEvictionPolicy::TinyLFU);
+  cache->insertSimple(object3);
+  cache->insertSimple(object3a);
+  cache->insertSimple(object3b);
+
+  // Looking up a missing object counts as an access.
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(nullptr, cache->getSimple(hash4));
+  }
+  cache->insertSimple(object4);
+  EXPECT_TRUE(cache->contains(hash4));
+  EXPECT_FALSE(cache->contains(hash3)) << "object3 was the LRU victim";
+  EXPECT_EQ(0, cache->getStats().admissionRejectionCount);
+}
+
+TEST(ObjectCache, tinylfu_rejected_insert_still_returns_object) {
+  auto cache =
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::create(
+          3, 0, 1, CacheEvictionPolicy::TinyLFU);
+  cache->insertInterestHandle(object3);
+  cache->getInterestHandle(hash3);
+
+  auto handle = cache->insertInterestHandle(
+      object3a,
+      ObjectCache<CacheObject, ObjectCacheFlavor::InterestHandle>::Interest::
+          WantHandle);
+  EXPECT_FALSE(cache->contains(hash3a));
+  EXPECT_EQ(object3a, handle.getObject());
+  handle.reset();
+  EXPECT_TRUE(cache->contains(hash3));
+}
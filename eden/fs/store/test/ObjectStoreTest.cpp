@@ -64,6 +64,20 @@ struct ObjectStoreTest : ::testing::Test {
     return storedBlob->get().getHash();
   }
 
+  std::shared_ptr<ObjectStore> createObjectStoreWithNegativeCache() {
+    auto config = EdenConfig::createTestEdenConfig();
+    config->negativeCacheTtl.setValue(1h, ConfigSource::Default, true);
+    return ObjectStore::create(
+        localStore,
+        backingStore,
+        treeCache,
+        stats,
+        std::make_shared<ProcessNameCache>(),
+        std::make_shared<NullStructuredLogger>(),
+        std::move(config),
+        kPathMapDefaultCaseSensitive);
+  }
+
   ObjectId putReadyTree() {
     StoredTree* storedTree = fakeBackingStore->putTree({});
     storedTree->setReady();
@@ -106,6 +120,17 @@ TEST_F(ObjectStoreTest, getBlob_tracks_second_read_from_cache) {
   EXPECT_EQ(ObjectFetchContext::FromDiskCache, request.origin);
 }
 
+TEST_F(ObjectStoreTest, getBlob_accounts_for_the_cost_of_each_read) {
+  objectStore->getBlob(readyBlobId, context).get(0ms);
+  objectStore->getBlob(readyBlobId, context).get(0ms);
+  auto cost = loggingContext->fetchCost.getFetchCost();
+  EXPECT_EQ(0, cost.tiers[FetchCost::MemoryCache].count);
+  EXPECT_EQ(1, cost.tiers[FetchCost::DiskCache].count);
+  EXPECT_EQ(9, cost.tiers[FetchCost::DiskCache].bytes);
+  EXPECT_EQ(1, cost.tiers[FetchCost::BackingStore].count);
+  EXPECT_EQ(9, cost.tiers[FetchCost::BackingStore].bytes);
+}
+
 TEST_F(ObjectStoreTest, getTree_tracks_backing_store_read) {
   objectStore->getTree(readyTreeId, context).get(0ms);
   ASSERT_EQ(1, loggingContext->requests.size());
@@ -158,6 +183,19 @@ TEST_F(ObjectStoreTest, getBlobSize_tracks_second_read_from_cache) {
   EXPECT_EQ(ObjectFetchContext::FromMemoryCache, request.origin);
 }
 
+TEST_F(ObjectStoreTest, getSymlinkTarget_tracks_second_read_from_cache) {
+  auto id = putReadyBlob("../target");
+  EXPECT_EQ("../target", objectStore->getSymlinkTarget(id, context).get(0ms));
+  EXPECT_EQ("../target", objectStore->getSymlinkTarget(id, context).get(0ms));
+  ASSERT_EQ(2, loggingContext->requests.size());
+  EXPECT_EQ(
+      ObjectFetchContext::FromNetworkFetch, loggingContext->requests[0].origin);
+  auto& request = loggingContext->requests[1];
+  EXPECT_EQ(ObjectFetchContext::Blob, request.type);
+  EXPECT_EQ(id, request.hash);
+  EXPECT_EQ(ObjectFetchContext::FromMemoryCache, request.origin);
+}
+
 TEST_F(ObjectStoreTest, getBlobSizeFromLocalStore) {
   auto data = "A"_sp;
   ObjectId id = putReadyBlob(data);
@@ -223,6 +261,25 @@ TEST_F(ObjectStoreTest, get_size_and_sha1_only_imports_blob_once) {
   EXPECT_EQ(1, fakeBackingStore->getAccessCount(readyBlobId));
 }
 
+TEST_F(ObjectStoreTest, getBlobMetadata_uses_metadata_imported_with_tree) {
+  // Never made ready, so fetching it from the backing store would time out.
+  auto data = "imported"_sp;
+  auto blobId = fakeBackingStore->putBlob(data)->get().getHash();
+  auto sha1 = Hash20::sha1(data);
+
+  Tree::container entries{kPathMapDefaultCaseSensitive};
+  entries.emplace(
+      "file"_pc, blobId, TreeEntryType::REGULAR_FILE, data.size(), sha1);
+  auto* storedTree = fakeBackingStore->putTree(std::move(entries));
+  storedTree->setReady();
+  objectStore->getTree(storedTree->get().getHash(), context).get(0ms);
+
+  auto metadata = objectStore->getBlobMetadata(blobId, context).get(0ms);
+  EXPECT_EQ(data.size(), metadata.size);
+  EXPECT_EQ(sha1.toString(), metadata.sha1.toString());
+  EXPECT_EQ(0, fakeBackingStore->getAccessCount(blobId));
+}
+
 class PidFetchContext final : public ObjectFetchContext {
  public:
   PidFetchContext(pid_t pid) : ObjectFetchContext{}, pid_{pid} {}
@@ -263,3 +320,184 @@ TEST_F(ObjectStoreTest, test_process_access_counts) {
   EXPECT_EQ(2, objectStore->getPidFetches().rlock()->at(pid0));
   EXPECT_EQ(1, objectStore->getPidFetches().rlock()->at(pid1));
 }
+
+TEST_F(ObjectStoreTest, negative_cache_is_disabled_by_default) {
+  auto id = ObjectId::sha1("missing");
+  EXPECT_THROW(objectStore->getBlob(id, context).get(0ms), std::domain_error);
+  EXPECT_THROW(objectStore->getBlob(id, context).get(0ms), std::domain_error);
+  EXPECT_EQ(2, fakeBackingStore->getAccessCount(id));
+}
+
+TEST_F(ObjectStoreTest, negative_cache_avoids_repeated_blob_fetches) {
+  auto store = createObjectStoreWithNegativeCache();
+  auto id = ObjectId::sha1("missing");
+  EXPECT_THROW_RE(
+      store->getBlob(id, context).get(0ms),
+      std::domain_error,
+      "blob .* not found");
+  EXPECT_THROW_RE(
+      store->getBlob(id, context).get(0ms),
+      std::domain_error,
+      "blob .* not found");
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+}
+
+TEST_F(ObjectStoreTest, negative_cache_avoids_repeated_tree_fetches) {
+  auto store = createObjectStoreWithNegativeCache();
+  auto id = ObjectId::sha1("missing");
+  EXPECT_THROW(store->getTree(id, context).get(0ms), std::domain_error);
+  EXPECT_THROW(store->getTree(id, context).get(0ms), std::domain_error);
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+}
+
+TEST_F(ObjectStoreTest, negative_cache_is_per_object_type) {
+  auto store = createObjectStoreWithNegativeCache();
+  auto id = ObjectId::sha1("missing");
+  EXPECT_THROW(store->getTree(id, context).get(0ms), std::domain_error);
+  EXPECT_THROW(store->getBlob(id, context).get(0ms), std::domain_error);
+  EXPECT_EQ(2, fakeBackingStore->getAccessCount(id));
+}
+
+TEST_F(ObjectStoreTest, clearNegativeCache_allows_refetching) {
+  auto store = createObjectStoreWithNegativeCache();
+  auto id = ObjectId::sha1("missing");
+  EXPECT_THROW(store->getBlob(id, context).get(0ms), std::domain_error);
+
+  fakeBackingStore->putBlob(id, "contents")->setReady();
+  store->clearNegativeCache();
+
+  auto blob = store->getBlob(id, context).get(0ms);
+  EXPECT_EQ("contents", blob->asString());
+  EXPECT_EQ(2, fakeBackingStore->getAccessCount(id));
+}
+
+TEST_F(ObjectStoreTest, concurrent_getBlob_calls_share_one_fetch) {
+  StoredBlob* storedBlob = fakeBackingStore->putBlob("coalesced");
+  auto id = storedBlob->get().getHash();
+
+  auto future1 = objectStore->getBlob(id, context);
+  auto future2 = objectStore->getBlob(id, context);
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+
+  storedBlob->setReady();
+  EXPECT_EQ("coalesced", std::move(future1).get(0ms)->asString());
+  EXPECT_EQ("coalesced", std::move(future2).get(0ms)->asString());
+  EXPECT_EQ(2, loggingContext->requests.size());
+
+  // Once the fetch completed, a new call starts a new fetch.
+  objectStore->getBlob(id, context).get(0ms);
+  EXPECT_EQ(2, fakeBackingStore->getAccessCount(id));
+}
+
+TEST_F(ObjectStoreTest, coalesced_getBlob_calls_share_errors) {
+  StoredBlob* storedBlob = fakeBackingStore->putBlob("failing");
+  auto id = storedBlob->get().getHash();
+
+  auto future1 = objectStore->getBlob(id, context);
+  auto future2 = objectStore->getBlob(id, context);
+  storedBlob->triggerError(std::runtime_error("fetch failed"));
+
+  EXPECT_THROW_RE(
+      std::move(future1).get(0ms), std::runtime_error, "fetch failed");
+  EXPECT_THROW_RE(
+      std::move(future2).get(0ms), std::runtime_error, "fetch failed");
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+}
+
+TEST_F(ObjectStoreTest, getBlobMetadataBatch_returns_results_in_order) {
+  auto id1 = putReadyBlob("first");
+  auto id2 = putReadyBlob("second blob");
+  auto missingId = ObjectId::sha1("missing");
+  // Bring id1's metadata into memory.
+  objectStore->getBlobMetadata(id1, context).get(0ms);
+
+  auto results = objectStore
+                     ->getBlobMetadataBatch({id2, missingId, id1}, context)
+                     .get(0ms);
+  ASSERT_EQ(3, results.size());
+  EXPECT_EQ(11, results[0].value().size);
+  EXPECT_EQ(Hash20::sha1("second blob"), results[0].value().sha1);
+  EXPECT_THROW(results[1].value(), std::domain_error);
+  EXPECT_EQ(5, results[2].value().size);
+}
+
+TEST_F(ObjectStoreTest, getTreeBatch_returns_results_in_order) {
+  auto* blob = fakeBackingStore->putBlob("contents");
+  blob->setReady();
+  auto* otherTree = fakeBackingStore->putTree({{"file", blob}});
+  otherTree->setReady();
+  auto otherTreeId = otherTree->get().getHash();
+  auto missingId = ObjectId::sha1("missing");
+
+  auto results =
+      objectStore
+          ->getTreeBatch({otherTreeId, missingId, readyTreeId}, context)
+          .get(0ms);
+  ASSERT_EQ(3, results.size());
+  EXPECT_EQ(otherTreeId, results[0].value()->getHash());
+  EXPECT_THROW(results[1].value(), std::domain_error);
+  EXPECT_EQ(readyTreeId, results[2].value()->getHash());
+}
+
+TEST_F(ObjectStoreTest, getBlobMetadataBatch_uses_local_store) {
+  auto id = putReadyBlob("blob");
+  objectStore->getBlobMetadata(id, context).get(0ms);
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+
+  // A fresh ObjectStore doesn't have the metadata in memory, but finds it in
+  // the LocalStore.
+  auto store = ObjectStore::create(
+      localStore,
+      backingStore,
+      treeCache,
+      stats,
+      std::make_shared<ProcessNameCache>(),
+      std::make_shared<NullStructuredLogger>(),
+      EdenConfig::createTestEdenConfig(),
+      kPathMapDefaultCaseSensitive);
+  auto results = store->getBlobMetadataBatch({id}, context).get(0ms);
+  ASSERT_EQ(1, results.size());
+  EXPECT_EQ(4, results[0].value().size);
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+  EXPECT_EQ(
+      ObjectFetchContext::FromDiskCache, loggingContext->requests.back().origin);
+}
+
+TEST_F(ObjectStoreTest, getBlobRange_fetches_only_the_covering_chunks) {
+  auto config = EdenConfig::createTestEdenConfig();
+  config->blobRangeChunkSize.setValue(4, ConfigSource::Default, true);
+  auto store = ObjectStore::create(
+      localStore,
+      backingStore,
+      treeCache,
+      stats,
+      std::make_shared<ProcessNameCache>(),
+      std::make_shared<NullStructuredLogger>(),
+      std::move(config),
+      kPathMapDefaultCaseSensitive);
+  fakeBackingStore->setSupportsBlobRanges(true);
+  auto id = putReadyBlob("0123456789abcdef");
+
+  auto range = store->getBlobRange(id, 5, 6, context).get(0ms);
+  EXPECT_EQ("56789a", range->to<std::string>());
+  EXPECT_EQ(2, fakeBackingStore->getRangeAccessCount(id));
+  EXPECT_EQ(0, fakeBackingStore->getAccessCount(id));
+
+  // The chunks are cached.
+  range = store->getBlobRange(id, 6, 3, context).get(0ms);
+  EXPECT_EQ("678", range->to<std::string>());
+  EXPECT_EQ(2, fakeBackingStore->getRangeAccessCount(id));
+
+  range = store->getBlobRange(id, 14, 10, context).get(0ms);
+  EXPECT_EQ("ef", range->to<std::string>());
+  range = store->getBlobRange(id, 20, 4, context).get(0ms);
+  EXPECT_EQ("", range->to<std::string>());
+}
+
+TEST_F(ObjectStoreTest, getBlobRange_fetches_whole_blob_without_support) {
+  auto id = putReadyBlob("0123456789abcdef");
+  auto range = objectStore->getBlobRange(id, 5, 6, context).get(0ms);
+  EXPECT_EQ("56789a", range->to<std::string>());
+  EXPECT_EQ(0, fakeBackingStore->getRangeAccessCount(id));
+  EXPECT_EQ(1, fakeBackingStore->getAccessCount(id));
+}
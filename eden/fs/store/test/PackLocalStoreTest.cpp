@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/PackLocalStore.h"
+
+#include <fmt/format.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/testharness/TempFile.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+namespace {
+
+constexpr size_t kPackSize = 16 * 1024;
+
+class PackLocalStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    root_ = canonicalPath(testDir_.path().string()) + "packs"_pc;
+    store_ = std::make_unique<PackLocalStore>(root_, kPackSize);
+    store_->open();
+  }
+
+  void reopen() {
+    store_.reset();
+    store_ = std::make_unique<PackLocalStore>(root_, kPackSize);
+    store_->open();
+  }
+
+  void putValues(KeySpace keySpace, size_t count) {
+    std::string value(1000, 'v');
+    for (size_t i = 0; i < count; ++i) {
+      store_->put(
+          keySpace,
+          folly::StringPiece{fmt::format("key{}", i)},
+          folly::StringPiece{value});
+    }
+  }
+
+  folly::test::TemporaryDirectory testDir_{makeTempDir()};
+  AbsolutePath root_;
+  std::unique_ptr<PackLocalStore> store_;
+};
+
+} // namespace
+
+TEST_F(PackLocalStoreTest, full_pack_rolls_over_to_a_new_pack) {
+  EXPECT_EQ(1, store_->getPackCount(KeySpace::BlobFamily));
+  putValues(KeySpace::BlobFamily, 64);
+  EXPECT_GT(store_->getPackCount(KeySpace::BlobFamily), 1);
+
+  for (size_t i = 0; i < 64; ++i) {
+    EXPECT_TRUE(store_->hasKey(
+        KeySpace::BlobFamily, folly::StringPiece{fmt::format("key{}", i)}))
+        << i;
+  }
+}
+
+TEST_F(PackLocalStoreTest, values_persist_across_reopen) {
+  putValues(KeySpace::BlobFamily, 64);
+  store_->put(KeySpace::TreeFamily, "tree"_sp, "contents"_sp);
+  auto packCount = store_->getPackCount(KeySpace::BlobFamily);
+
+  reopen();
+
+  EXPECT_EQ(packCount, store_->getPackCount(KeySpace::BlobFamily));
+  EXPECT_EQ(
+      "contents", store_->get(KeySpace::TreeFamily, "tree"_sp).piece());
+  EXPECT_TRUE(store_->hasKey(KeySpace::BlobFamily, "key0"_sp));
+  EXPECT_TRUE(store_->hasKey(KeySpace::BlobFamily, "key63"_sp));
+}
+
+TEST_F(PackLocalStoreTest, newest_value_wins) {
+  store_->put(KeySpace::TreeFamily, "key"_sp, "old"_sp);
+  store_->put(KeySpace::TreeFamily, "key"_sp, "new"_sp);
+  EXPECT_EQ("new", store_->get(KeySpace::TreeFamily, "key"_sp).piece());
+
+  // Also when the old value lives in an older pack.
+  store_->put(KeySpace::BlobFamily, "key0"_sp, "old"_sp);
+  putValues(KeySpace::BlobFamily, 64);
+  EXPECT_EQ(
+      std::string(1000, 'v'),
+      store_->get(KeySpace::BlobFamily, "key0"_sp).piece());
+}
+
+TEST_F(PackLocalStoreTest, oversized_values_get_their_own_pack) {
+  std::string value(4 * kPackSize, 'x');
+  store_->put(KeySpace::BlobFamily, "big"_sp, folly::StringPiece{value});
+  EXPECT_EQ(value, store_->get(KeySpace::BlobFamily, "big"_sp).piece());
+}
+
+TEST_F(PackLocalStoreTest, put_slices_concatenates_them) {
+  store_->putSlices(
+      KeySpace::BlobFamily,
+      "key"_sp,
+      {folly::StringPiece{"hello, "}, folly::StringPiece{"world"}});
+  EXPECT_EQ(
+      "hello, world", store_->get(KeySpace::BlobFamily, "key"_sp).piece());
+}
+
+TEST_F(PackLocalStoreTest, drop_old_packs_keeps_the_newest) {
+  putValues(KeySpace::BlobFamily, 64);
+  auto packCount = store_->getPackCount(KeySpace::BlobFamily);
+  auto size = store_->getApproximateSize(KeySpace::BlobFamily);
+  ASSERT_GT(packCount, 2);
+
+  auto dropped = store_->dropOldPacks(KeySpace::BlobFamily, size / 2);
+  EXPECT_GT(dropped, 0);
+  EXPECT_EQ(packCount - dropped, store_->getPackCount(KeySpace::BlobFamily));
+  EXPECT_LE(store_->getApproximateSize(KeySpace::BlobFamily), size / 2);
+
+  // The oldest values are gone, the most recent are still there.
+  EXPECT_FALSE(store_->hasKey(KeySpace::BlobFamily, "key0"_sp));
+  EXPECT_TRUE(store_->hasKey(KeySpace::BlobFamily, "key63"_sp));
+
+  // And dropped packs don't come back after a restart.
+  auto remaining = store_->getPackCount(KeySpace::BlobFamily);
+  reopen();
+  EXPECT_EQ(remaining, store_->getPackCount(KeySpace::BlobFamily));
+  EXPECT_FALSE(store_->hasKey(KeySpace::BlobFamily, "key0"_sp));
+}
+
+TEST_F(PackLocalStoreTest, drop_old_packs_never_drops_the_active_pack) {
+  putValues(KeySpace::BlobFamily, 64);
+  store_->dropOldPacks(KeySpace::BlobFamily, 0);
+  EXPECT_EQ(1, store_->getPackCount(KeySpace::BlobFamily));
+  EXPECT_TRUE(store_->hasKey(KeySpace::BlobFamily, "key63"_sp));
+}
+
+TEST_F(PackLocalStoreTest, clear_key_space_removes_all_values) {
+  putValues(KeySpace::BlobFamily, 64);
+  store_->put(KeySpace::TreeFamily, "tree"_sp, "contents"_sp);
+  store_->clearKeySpace(KeySpace::BlobFamily);
+
+  EXPECT_EQ(1, store_->getPackCount(KeySpace::BlobFamily));
+  EXPECT_FALSE(store_->hasKey(KeySpace::BlobFamily, "key63"_sp));
+  EXPECT_TRUE(store_->hasKey(KeySpace::TreeFamily, "tree"_sp));
+
+  reopen();
+  EXPECT_FALSE(store_->hasKey(KeySpace::BlobFamily, "key63"_sp));
+}
+
+TEST_F(PackLocalStoreTest, reads_throw_after_close) {
+  store_->close();
+  EXPECT_THROW(
+      store_->get(KeySpace::BlobFamily, "key"_sp), std::runtime_error);
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/PersistentTreeCache.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/testharness/TempFile.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+
+namespace {
+
+constexpr size_t kCapacity = 64 * 1024;
+
+std::shared_ptr<const Tree> makeTree(size_t i) {
+  auto fileId = ObjectId::sha1(fmt::format("file{}", i));
+  auto treeId = ObjectId::sha1(fmt::format("tree{}", i));
+  return std::make_shared<const Tree>(
+      Tree::container{
+          {{PathComponent{fmt::format("f{}", i)},
+            TreeEntry{fileId, TreeEntryType::REGULAR_FILE}}},
+          kPathMapDefaultCaseSensitive},
+      treeId);
+}
+
+class PersistentTreeCacheTest : public ::testing::Test {
+ protected:
+  AbsolutePath getCachePath() const {
+    return canonicalPath(tempDir_.path().string()) + "tree-cache"_pc;
+  }
+
+  folly::test::TemporaryDirectory tempDir_{makeTempDir()};
+};
+
+} // namespace
+
+TEST_F(PersistentTreeCacheTest, missing_tree_returns_nullptr) {
+  auto cache = PersistentTreeCache::open(getCachePath(), kCapacity);
+  EXPECT_EQ(nullptr, cache->get(makeTree(0)->getHash()));
+  EXPECT_EQ(1, cache->getStats().missCount);
+}
+
+TEST_F(PersistentTreeCacheTest, inserted_tree_can_be_read_back) {
+  auto cache = PersistentTreeCache::open(getCachePath(), kCapacity);
+  auto tree = makeTree(0);
+  cache->insert(*tree);
+
+  auto cached = cache->get(tree->getHash());
+  ASSERT_NE(nullptr, cached);
+  EXPECT_EQ(*tree, *cached);
+
+  auto stats = cache->getStats();
+  EXPECT_EQ(1, stats.entryCount);
+  EXPECT_EQ(1, stats.hitCount);
+}
+
+TEST_F(PersistentTreeCacheTest, trees_survive_reopening) {
+  {
+    auto cache = PersistentTreeCache::open(getCachePath(), kCapacity);
+    for (size_t i = 0; i < 10; ++i) {
+      cache->insert(*makeTree(i));
+    }
+  }
+
+  auto cache = PersistentTreeCache::open(getCachePath(), kCapacity);
+  EXPECT_EQ(10, cache->getStats().entryCount);
+  for (size_t i = 0; i < 10; ++i) {
+    auto tree = makeTree(i);
+    auto cached = cache->get(tree->getHash());
+    ASSERT_NE(nullptr, cached);
+    EXPECT_EQ(*tree, *cached);
+  }
+}
+
+TEST_F(PersistentTreeCacheTest, changing_capacity_resets_cache) {
+  {
+    auto cache = PersistentTreeCache::open(getCachePath(), kCapacity);
+    cache->insert(*makeTree(0));
+  }
+
+  auto cache = PersistentTreeCache::open(getCachePath(), 2 * kCapacity);
+  EXPECT_EQ(0, cache->getStats().entryCount);
+  EXPECT_EQ(nullptr, cache->get(makeTree(0)->getHash()));
+}
+
+TEST_F(PersistentTreeCacheTest, cache_resets_when_full) {
+  auto cache = PersistentTreeCache::open(getCachePath(), kCapacity);
+  size_t i = 0;
+  while (cache->getStats().resetCount == 0) {
+    cache->insert(*makeTree(i++));
+  }
+
+  // The tree that triggered the reset is the only one present.
+  auto stats = cache->getStats();
+  EXPECT_EQ(1, stats.entryCount);
+  EXPECT_NE(nullptr, cache->get(makeTree(i - 1)->getHash()));
+  EXPECT_EQ(nullptr, cache->get(makeTree(0)->getHash()));
+}
+
+TEST_F(PersistentTreeCacheTest, clear_drops_all_trees) {
+  auto cache = PersistentTreeCache::open(getCachePath(), kCapacity);
+  cache->insert(*makeTree(0));
+  cache->clear();
+  EXPECT_EQ(0, cache->getStats().entryCount);
+  EXPECT_EQ(nullptr, cache->get(makeTree(0)->getHash()));
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/PrefetchProfile.h"
+
+#include <folly/portability/GMock.h>
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/config/ReloadableConfig.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/ObjectStore.h"
+#include "eden/fs/store/TreeCache.h"
+#include "eden/fs/telemetry/NullStructuredLogger.h"
+#include "eden/fs/testharness/FakeBackingStore.h"
+#include "eden/fs/testharness/FakeTreeBuilder.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+using ::testing::UnorderedElementsAre;
+
+TEST(PrefetchProfileTest, paths_round_trip) {
+  std::vector<RelativePath> paths{
+      RelativePath{"dir/sub/b"},
+      RelativePath{"dir/a"},
+      RelativePath{"dir/sub/b"},
+      RelativePath{"other"},
+      RelativePath{"dir/sub/c"}};
+  auto serialized = serializePrefetchProfile(paths);
+  EXPECT_EQ(
+      "eden-prefetch-profile-v1\n"
+      "0 dir/a\n"
+      "4 sub/b\n"
+      "8 c\n"
+      "0 other\n",
+      serialized);
+
+  EXPECT_EQ(
+      (std::vector<RelativePath>{
+          RelativePath{"dir/a"},
+          RelativePath{"dir/sub/b"},
+          RelativePath{"dir/sub/c"},
+          RelativePath{"other"}}),
+      parsePrefetchProfile(serialized));
+}
+
+TEST(PrefetchProfileTest, malformed_profiles_are_rejected) {
+  EXPECT_THROW(parsePrefetchProfile("dir/a\n"), std::invalid_argument);
+  EXPECT_THROW(
+      parsePrefetchProfile("eden-prefetch-profile-v1\n0 dir/a"),
+      std::invalid_argument);
+  EXPECT_THROW(
+      parsePrefetchProfile("eden-prefetch-profile-v1\n6 dir/a\n"),
+      std::invalid_argument);
+}
+
+namespace {
+
+class PrefetchProfileResolveTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    std::shared_ptr<EdenConfig> rawEdenConfig{
+        EdenConfig::createTestEdenConfig()};
+    auto edenConfig = std::make_shared<ReloadableConfig>(
+        rawEdenConfig, ConfigReloadBehavior::NoReload);
+    backingStore_ = std::make_shared<FakeBackingStore>();
+    store_ = ObjectStore::create(
+        std::make_shared<MemoryLocalStore>(),
+        backingStore_,
+        TreeCache::create(edenConfig),
+        std::make_shared<EdenStats>(),
+        std::make_shared<ProcessNameCache>(),
+        std::make_shared<NullStructuredLogger>(),
+        rawEdenConfig,
+        kPathMapDefaultCaseSensitive);
+
+    builder_.setFile("a/b/1.txt", "1");
+    builder_.setFile("a/b/2.txt", "2");
+    builder_.setFile("a/c.txt", "c");
+    builder_.setFile("d.txt", "d");
+    builder_.finalize(backingStore_, /* setReady */ true);
+    backingStore_->putCommit("1", builder_)->setReady();
+  }
+
+  std::shared_ptr<const Tree> getRootTree() {
+    return store_
+        ->getRootTree(RootId{"1"}, ObjectFetchContext::getNullContext())
+        .get(0ms);
+  }
+
+  ObjectId getBlobId(folly::StringPiece path) {
+    return builder_.getStoredBlob(RelativePathPiece{path})->get().getHash();
+  }
+
+  FakeTreeBuilder builder_;
+  std::shared_ptr<FakeBackingStore> backingStore_;
+  std::shared_ptr<ObjectStore> store_;
+};
+
+} // namespace
+
+TEST_F(PrefetchProfileResolveTest, files_are_resolved_and_the_rest_skipped) {
+  auto paths = parsePrefetchProfile(serializePrefetchProfile(
+      {RelativePath{"a/b/1.txt"},
+       RelativePath{"a/b/2.txt"},
+       RelativePath{"a/c.txt"},
+       RelativePath{"d.txt"},
+       // A directory, a missing file and a file used as a directory.
+       RelativePath{"a/b"},
+       RelativePath{"a/missing"},
+       RelativePath{"d.txt/e"}}));
+
+  auto resolution = resolvePrefetchProfile(
+                        store_.get(),
+                        getRootTree(),
+                        std::move(paths),
+                        ObjectFetchContext::getNullContext())
+                        .get(0ms);
+  EXPECT_THAT(
+      resolution.blobIds,
+      UnorderedElementsAre(
+          getBlobId("a/b/1.txt"),
+          getBlobId("a/b/2.txt"),
+          getBlobId("a/c.txt"),
+          getBlobId("d.txt")));
+  EXPECT_EQ(3, resolution.missingPaths);
+
+  // The trees of the profile were each fetched once.
+  auto treeId = [&](folly::StringPiece path) {
+    return builder_.getStoredTree(RelativePathPiece{path})->get().getHash();
+  };
+  EXPECT_EQ(1, backingStore_->getAccessCount(treeId("a")));
+  EXPECT_EQ(1, backingStore_->getAccessCount(treeId("a/b")));
+}
@@ -6,7 +6,10 @@
  */
 
 #include "eden/fs/store/RocksDbLocalStore.h"
+#include <fb303/ServiceData.h>
+#include <thread>
 #include "eden/fs/store/test/LocalStoreTest.h"
+#include "eden/fs/telemetry/EdenStats.h"
 #include "eden/fs/telemetry/NullStructuredLogger.h"
 
 namespace {
@@ -35,4 +38,108 @@ INSTANTIATE_TEST_CASE_P(
     ::testing::Values(makeRocksDbLocalStore));
 #pragma clang diagnostic pop
 
+TEST(RocksDbLocalStoreTest, periodic_management_publishes_rocksdb_stats) {
+  using namespace folly::string_piece_literals;
+  FaultInjector faultInjector{/*enabled=*/false};
+  auto tempDir = makeTempDir();
+  auto store = std::make_shared<RocksDbLocalStore>(
+      canonicalPath(tempDir.path().string()),
+      std::make_shared<NullStructuredLogger>(),
+      &faultInjector,
+      RocksDBOpenMode::ReadWrite,
+      1024 * 1024,
+      std::make_shared<EdenStats>());
+  store->open();
+
+  // Values of every key space round trip with their per key space options.
+  for (const auto& ks : KeySpace::kAll) {
+    if (!ks->isDeprecated()) {
+      store->put(ks, "key"_sp, "value"_sp);
+      EXPECT_EQ("value", store->get(ks, "key"_sp).piece()) << ks->name;
+    }
+  }
+
+  store->periodicManagementTask(*EdenConfig::createTestEdenConfig());
+  EXPECT_TRUE(fb303::fbData->hasCounter(
+      "local_store.rocksdb.pending_compaction_bytes"));
+  EXPECT_GE(
+      fb303::fbData->getCounter("local_store.rocksdb.block_cache_usage"), 0);
+}
+
+TEST(RocksDbLocalStoreTest, auto_gc_evicts_blobs_in_bounded_ranges) {
+  FaultInjector faultInjector{/*enabled=*/false};
+  auto tempDir = makeTempDir();
+  std::shared_ptr<LocalStore> store = std::make_shared<RocksDbLocalStore>(
+      canonicalPath(tempDir.path().string()),
+      std::make_shared<NullStructuredLogger>(),
+      &faultInjector);
+  store->open();
+
+  std::string value(1024, 'x');
+  for (size_t i = 0; i < 100; ++i) {
+    store->put(
+        KeySpace::BlobFamily,
+        ObjectId::sha1(folly::to<std::string>(i)),
+        folly::StringPiece{value});
+  }
+
+  auto config = EdenConfig::createTestEdenConfig();
+  config->localStoreBlobSizeLimit.setValue(1, ConfigSource::Default, true);
+  config->localStoreGcEvictionBatchSize.setValue(
+      8 * 1024, ConfigSource::Default, true);
+  auto getEvictedBytes = [] {
+    constexpr auto kEvictedBytes = "local_store.auto_gc.evicted_bytes";
+    return fb303::fbData->hasCounter(kEvictedBytes)
+        ? fb303::fbData->getCounter(kEvictedBytes)
+        : 0;
+  };
+  auto evictedBefore = getEvictedBytes();
+  store->periodicManagementTask(*config);
+
+  // Garbage collection runs in the background.
+  for (int i = 0; i < 1000 &&
+       fb303::fbData->getCounter("local_store.auto_gc.running") != 0;
+       ++i) {
+    /* sleep override */ std::this_thread::sleep_for(
+        std::chrono::milliseconds{10});
+  }
+  ASSERT_EQ(0, fb303::fbData->getCounter("local_store.auto_gc.running"));
+
+  // Unlike clearing the key space, eviction stops once enough bytes were
+  // removed, so only check that some of the blobs are gone.
+  EXPECT_GT(getEvictedBytes() - evictedBefore, 0);
+  size_t remaining = 0;
+  for (size_t i = 0; i < 100; ++i) {
+    if (store->hasKey(
+            KeySpace::BlobFamily, ObjectId::sha1(folly::to<std::string>(i)))) {
+      ++remaining;
+    }
+  }
+  EXPECT_LT(remaining, 100);
+}
+
+TEST(RocksDbLocalStoreTest, for_each_value_visits_the_key_space_in_order) {
+  using namespace folly::string_piece_literals;
+  FaultInjector faultInjector{/*enabled=*/false};
+  auto tempDir = makeTempDir();
+  auto store = std::make_shared<RocksDbLocalStore>(
+      canonicalPath(tempDir.path().string()),
+      std::make_shared<NullStructuredLogger>(),
+      &faultInjector);
+  store->open();
+  store->put(KeySpace::TreeFamily, "b"_sp, "2"_sp);
+  store->put(KeySpace::TreeFamily, "a"_sp, "1"_sp);
+  store->put(KeySpace::BlobFamily, "c"_sp, "3"_sp);
+
+  std::vector<std::pair<std::string, std::string>> values;
+  store->forEachValue(
+      KeySpace::TreeFamily, [&](folly::ByteRange key, folly::ByteRange value) {
+        values.emplace_back(
+            folly::StringPiece{key}.str(), folly::StringPiece{value}.str());
+      });
+  std::vector<std::pair<std::string, std::string>> expected{
+      {"a", "1"}, {"b", "2"}};
+  EXPECT_EQ(expected, values);
+}
+
 } // namespace
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/ScmStatusDiffCallback.h"
+
+#include <fmt/format.h>
+#include <folly/ExceptionWrapper.h>
+#include <folly/portability/GTest.h>
+#include <thread>
+
+using namespace facebook::eden;
+
+namespace {
+
+class ChunkedScmStatusDiffCallbackTest : public ::testing::Test {
+ protected:
+  std::vector<ScmStatus> chunks_;
+  ChunkedScmStatusDiffCallback callback_{
+      2,
+      [this](ScmStatus&& chunk) { chunks_.push_back(std::move(chunk)); }};
+};
+
+} // namespace
+
+TEST(ScmStatusDiffCallbackTest, status_is_sorted_and_skips_directories) {
+  ScmStatusDiffCallback callback;
+  callback.modifiedPath(
+      "b/long/enough/to/not/fit/inline"_relpath, dtype_t::Regular);
+  callback.addedPath("a"_relpath, dtype_t::Regular);
+  callback.removedPath("dir"_relpath, dtype_t::Dir);
+  callback.ignoredPath("c"_relpath, dtype_t::Symlink);
+  // The first status reported for a path wins.
+  callback.removedPath("a"_relpath, dtype_t::Regular);
+  callback.diffError(
+      "d"_relpath, folly::make_exception_wrapper<std::runtime_error>("oops"));
+
+  auto status = callback.extractStatus();
+  EXPECT_EQ(
+      (std::map<std::string, ScmFileStatus>{
+          {"a", ScmFileStatus::ADDED},
+          {"b/long/enough/to/not/fit/inline", ScmFileStatus::MODIFIED},
+          {"c", ScmFileStatus::IGNORED}}),
+      *status.entries());
+  EXPECT_EQ(1, status.errors()->count("d"));
+}
+
+TEST(ScmStatusDiffCallbackTest, paths_reported_by_many_threads_are_merged) {
+  constexpr size_t kThreads = 8;
+  constexpr size_t kPathsPerThread = 10000;
+  ScmStatusDiffCallback callback;
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&callback, t] {
+      for (size_t i = 0; i < kPathsPerThread; ++i) {
+        auto path = fmt::format("dir{}/file{}", i % 100, i * kThreads + t);
+        callback.addedPath(RelativePath{path}, dtype_t::Regular);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  auto status = callback.extractStatus();
+  ASSERT_EQ(kThreads * kPathsPerThread, status.entries()->size());
+  EXPECT_EQ(1, status.entries()->count("dir0/file0"));
+  EXPECT_EQ(1, status.entries()->count("dir99/file79999"));
+  EXPECT_TRUE(status.errors()->empty());
+}
+
+TEST(ScmStatusDiffCallbackTest, callbacks_can_be_replaced) {
+  ScmStatusDiffCallback callback;
+  callback.addedPath("a"_relpath, dtype_t::Regular);
+  EXPECT_EQ(1, callback.extractStatus().entries()->size());
+
+  // The buffer of this thread belonged to the previous callback.
+  callback = ScmStatusDiffCallback();
+  callback.addedPath("b"_relpath, dtype_t::Regular);
+  EXPECT_EQ(
+      (std::map<std::string, ScmFileStatus>{{"b", ScmFileStatus::ADDED}}),
+      *callback.extractStatus().entries());
+}
+
+TEST_F(ChunkedScmStatusDiffCallbackTest, chunks_are_handed_over_when_full) {
+  callback_.addedPath("a"_relpath, dtype_t::Regular);
+  EXPECT_TRUE(chunks_.empty());
+  callback_.modifiedPath("b"_relpath, dtype_t::Regular);
+  ASSERT_EQ(1, chunks_.size());
+  EXPECT_EQ(
+      (std::map<std::string, ScmFileStatus>{
+          {"a", ScmFileStatus::ADDED}, {"b", ScmFileStatus::MODIFIED}}),
+      *chunks_[0].entries());
+
+  callback_.removedPath("c"_relpath, dtype_t::Regular);
+  callback_.flush();
+  ASSERT_EQ(2, chunks_.size());
+  EXPECT_EQ(
+      (std::map<std::string, ScmFileStatus>{{"c", ScmFileStatus::REMOVED}}),
+      *chunks_[1].entries());
+
+  // Nothing is left to hand over.
+  callback_.flush();
+  EXPECT_EQ(2, chunks_.size());
+  EXPECT_EQ(3, callback_.getEntryCount());
+}
+
+TEST_F(ChunkedScmStatusDiffCallbackTest, errors_fill_chunks_too) {
+  callback_.ignoredPath("a"_relpath, dtype_t::Regular);
+  callback_.diffError(
+      "b"_relpath, folly::make_exception_wrapper<std::runtime_error>("oops"));
+  ASSERT_EQ(1, chunks_.size());
+  EXPECT_EQ(1, chunks_[0].entries()->size());
+  EXPECT_EQ(1, chunks_[0].errors()->count("b"));
+  EXPECT_EQ(1, callback_.getEntryCount());
+  EXPECT_EQ(1, callback_.getErrorCount());
+}
+
+TEST_F(ChunkedScmStatusDiffCallbackTest, directories_are_not_reported) {
+  callback_.addedPath("dir"_relpath, dtype_t::Dir);
+  callback_.removedPath("other"_relpath, dtype_t::Dir);
+  callback_.flush();
+  EXPECT_TRUE(chunks_.empty());
+  EXPECT_EQ(0, callback_.getEntryCount());
+}
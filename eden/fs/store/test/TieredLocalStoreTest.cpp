@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/store/TieredLocalStore.h"
+
+#include <folly/portability/GTest.h>
+
+#include "eden/fs/store/MemoryLocalStore.h"
+#include "eden/fs/store/PackLocalStore.h"
+#include "eden/fs/store/StoreResult.h"
+#include "eden/fs/testharness/TempFile.h"
+
+using namespace facebook::eden;
+using namespace folly::string_piece_literals;
+using namespace std::chrono_literals;
+
+namespace {
+
+class TieredLocalStoreTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    packPath_ = canonicalPath(testDir_.path().string()) + "packs"_pc;
+    {
+      PackLocalStore builder{packPath_};
+      builder.open();
+      builder.put(KeySpace::TreeFamily, "shared"_sp, "cold"_sp);
+      builder.put(KeySpace::TreeFamily, "both"_sp, "cold"_sp);
+      builder.close();
+    }
+
+    hot_ = std::make_shared<MemoryLocalStore>();
+    hot_->put(KeySpace::TreeFamily, "both"_sp, "hot"_sp);
+    hot_->put(KeySpace::TreeFamily, "local"_sp, "hot"_sp);
+    store_ = std::make_shared<TieredLocalStore>(
+        hot_,
+        std::make_shared<PackLocalStore>(
+            packPath_,
+            PackLocalStore::kDefaultPackSize,
+            PackLocalStore::OpenMode::ReadOnly));
+    store_->open();
+  }
+
+  folly::test::TemporaryDirectory testDir_{makeTempDir()};
+  AbsolutePath packPath_;
+  std::shared_ptr<MemoryLocalStore> hot_;
+  std::shared_ptr<LocalStore> store_;
+};
+
+} // namespace
+
+TEST_F(TieredLocalStoreTest, cold_store_is_looked_up_first) {
+  EXPECT_EQ("cold", store_->get(KeySpace::TreeFamily, "shared"_sp).piece());
+  EXPECT_EQ("cold", store_->get(KeySpace::TreeFamily, "both"_sp).piece());
+  EXPECT_EQ("hot", store_->get(KeySpace::TreeFamily, "local"_sp).piece());
+  EXPECT_FALSE(store_->get(KeySpace::TreeFamily, "missing"_sp).isValid());
+
+  EXPECT_TRUE(store_->hasKey(KeySpace::TreeFamily, "shared"_sp));
+  EXPECT_TRUE(store_->hasKey(KeySpace::TreeFamily, "local"_sp));
+  EXPECT_FALSE(store_->hasKey(KeySpace::BlobFamily, "shared"_sp));
+}
+
+TEST_F(TieredLocalStoreTest, get_batch_merges_both_tiers) {
+  std::vector<folly::ByteRange> keys{
+      "local"_sp, "shared"_sp, "missing"_sp, "both"_sp};
+  auto results = store_->getBatch(KeySpace::TreeFamily, keys).get(10s);
+  ASSERT_EQ(4, results.size());
+  EXPECT_EQ("hot", results[0].piece());
+  EXPECT_EQ("cold", results[1].piece());
+  EXPECT_FALSE(results[2].isValid());
+  EXPECT_EQ("cold", results[3].piece());
+}
+
+TEST_F(TieredLocalStoreTest, writes_and_clears_go_to_the_hot_store) {
+  store_->put(KeySpace::TreeFamily, "new"_sp, "value"_sp);
+  EXPECT_TRUE(hot_->hasKey(KeySpace::TreeFamily, "new"_sp));
+
+  store_->clearKeySpace(KeySpace::TreeFamily);
+  EXPECT_FALSE(store_->hasKey(KeySpace::TreeFamily, "local"_sp));
+  EXPECT_EQ("cold", store_->get(KeySpace::TreeFamily, "shared"_sp).piece());
+}
+
+TEST(ReadOnlyPackLocalStoreTest, rejects_writes) {
+  auto testDir = makeTempDir();
+  PackLocalStore packs{
+      canonicalPath(testDir.path().string()) + "packs"_pc,
+      PackLocalStore::kDefaultPackSize,
+      PackLocalStore::OpenMode::ReadOnly};
+  // The packs directory doesn't have to exist.
+  packs.open();
+  EXPECT_FALSE(packs.hasKey(KeySpace::TreeFamily, "key"_sp));
+  EXPECT_THROW(
+      packs.put(KeySpace::TreeFamily, "key"_sp, "value"_sp), std::logic_error);
+}
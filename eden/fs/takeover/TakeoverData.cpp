@@ -32,6 +32,12 @@ namespace facebook::eden {
 
 namespace {
 
+/**
+ * The capabilities that don't have a protocol version of their own.
+ */
+constexpr uint64_t kCapabilitiesAfterVersionSeven =
+    TakeoverCapabilities::HOT_OBJECT_IDS;
+
 /**
  * Determines the mount protocol for the mount point encoded in the mountInfo.
  */
@@ -63,7 +69,8 @@ const uint64_t kSupportedCapabilities = TakeoverCapabilities::FUSE |
     TakeoverCapabilities::RESULT_TYPE_SERIALIZATION |
     TakeoverCapabilities::ORDERED_FDS | TakeoverCapabilities::OPTIONAL_MOUNTD |
     TakeoverCapabilities::CAPABILITY_MATCHING |
-    TakeoverCapabilities::INCLUDE_HEADER_SIZE;
+    TakeoverCapabilities::INCLUDE_HEADER_SIZE |
+    TakeoverCapabilities::HOT_OBJECT_IDS;
 
 std::optional<int32_t> TakeoverData::computeCompatibleVersion(
     const std::set<int32_t>& versions,
@@ -184,7 +191,9 @@ int32_t TakeoverData::capabilitesToVersion(uint64_t capabilities) {
     return kTakeoverProtocolVersionSix;
   }
 
-  if (capabilities ==
+  // Capabilities introduced after version seven are agreed on by capability
+  // matching, they are still advertised as version seven.
+  if ((capabilities & ~kCapabilitiesAfterVersionSeven) ==
       (TakeoverCapabilities::FUSE | TakeoverCapabilities::MOUNT_TYPES |
        TakeoverCapabilities::PING | TakeoverCapabilities::THRIFT_SERIALIZATION |
        TakeoverCapabilities::NFS |
@@ -547,6 +556,13 @@ IOBuf TakeoverData::serializeThrift(uint64_t protocolCapabilities) {
 
     serializedMount.mountProtocol_ref() = mountProtocol;
 
+    if (mount.channelStopTime) {
+      serializedMount.channelStopTimeNs() =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              mount.channelStopTime->time_since_epoch())
+              .count();
+    }
+
     serializedMounts.emplace_back(std::move(serializedMount));
   }
 
@@ -559,6 +575,10 @@ IOBuf TakeoverData::serializeThrift(uint64_t protocolCapabilities) {
     if (protocolCapabilities & TakeoverCapabilities::ORDERED_FDS) {
       serialized.fileDescriptors_ref() = generalFDOrder;
     }
+    if ((protocolCapabilities & TakeoverCapabilities::HOT_OBJECT_IDS) &&
+        hotObjectIds.has_value()) {
+      serialized.hotObjectIds_ref() = *hotObjectIds;
+    }
     SerializedTakeoverResult result;
     result.takeoverData_ref() = serialized;
 
@@ -621,6 +641,12 @@ TakeoverData TakeoverData::deserializeThrift(
           takeoverData.generalFDOrder =
               *(serialized.takeoverData_ref()->fileDescriptors_ref());
         }
+        if (protocolCapabilities & TakeoverCapabilities::HOT_OBJECT_IDS) {
+          auto ids = serialized.takeoverData_ref()->hotObjectIds_ref();
+          if (ids.has_value()) {
+            takeoverData.hotObjectIds = std::move(*ids);
+          }
+        }
         return takeoverData;
       }
       case SerializedTakeoverResult::Type::__EMPTY__:
@@ -699,6 +725,13 @@ TakeoverData TakeoverData::deserializeThriftMounts(
         throw std::runtime_error(
             "impossible enum variant for TakeoverMountProtocol");
     }
+    if (auto stopTime = serializedMount.channelStopTimeNs()) {
+      data.mountPoints.back().channelStopTime =
+          std::chrono::steady_clock::time_point{
+              std::chrono::duration_cast<
+                  std::chrono::steady_clock::duration>(
+                  std::chrono::nanoseconds{*stopTime})};
+    }
   }
   return data;
 }
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <chrono>
 #include <memory>
 #include <optional>
 #include <vector>
@@ -109,6 +110,11 @@ class TakeoverCapabilities {
     // Indicates that we include the size of the header in the header itself.
     // This will allow us to more safely evolve the header in the future.
     INCLUDE_HEADER_SIZE = 1 << 10,
+
+    // Indicates that the ids of the objects hot in the caches are sent along
+    // with the mounts, so that the new process can warm its caches up.
+    // This can only be used with RESULT_TYPE_SERIALIZATION.
+    HOT_OBJECT_IDS = 1 << 11,
   };
 };
 
@@ -264,6 +270,12 @@ class TakeoverData {
         channelInfo;
 
     SerializedInodeMap inodeMap;
+
+    /**
+     * When the process giving up the mount stopped serving its requests.
+     * From then on they queue in the kernel until the new process resumes.
+     */
+    std::optional<std::chrono::steady_clock::time_point> channelStopTime;
   };
 
   /**
@@ -357,6 +369,12 @@ class TakeoverData {
    */
   std::vector<MountInfo> mountPoints;
 
+  /**
+   * The ids of the objects hot in the caches of the process giving up the
+   * mounts. Only sent with the HOT_OBJECT_IDS capability.
+   */
+  std::optional<SerializedHotObjectIds> hotObjectIds;
+
   /**
    * The takeoverComplete promise will be fulfilled by the TakeoverServer code
    * once the TakeoverData has been sent to the remote process.
@@ -66,6 +66,10 @@ struct SerializedMountInfo {
   6: SerializedInodeMap inodeMap;
 
   7: TakeoverMountProtocol mountProtocol = TakeoverMountProtocol.UNKNOWN;
+
+  // When the channel stopped serving requests, in nanoseconds of the
+  // monotonic clock, which both processes share since takeover is local.
+  8: optional i64 channelStopTimeNs;
 }
 
 // TODO(T110300475): remove after SerializedTakeoverResult becomes stable. Should be
@@ -85,9 +89,19 @@ enum FileDescriptorType {
   MOUNTD_SOCKET = 2,
 }
 
+// The ids of the objects that were hot in the in-memory caches of the process
+// giving up the mounts, most recently used first. The new process prefetches
+// them to warm its own caches up.
+struct SerializedHotObjectIds {
+  1: list<binary> trees;
+  2: list<binary> blobs;
+}
+
 struct SerializedTakeoverInfo {
   1: list<SerializedMountInfo> mounts;
   2: list<FileDescriptorType> fileDescriptors;
+  // Only sent with the HOT_OBJECT_IDS capability.
+  3: optional SerializedHotObjectIds hotObjectIds;
 }
 
 // This is the highlevel structure we use to send takeover data between the
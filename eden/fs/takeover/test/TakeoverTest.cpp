@@ -200,6 +200,12 @@ TEST(Takeover, invalidComboCapabilites) {
       std::runtime_error);
 }
 
+TEST(Takeover, capabilitiesAfterSevenAdvertiseSeven) {
+  EXPECT_EQ(
+      TakeoverData::capabilitesToVersion(kSupportedCapabilities),
+      TakeoverData::kTakeoverProtocolVersionSeven);
+}
+
 TEST(Takeover, matchCapabilites) {
   auto threeCapabilities = TakeoverData::versionToCapabilites(
       TakeoverData::kTakeoverProtocolVersionThree);
@@ -886,3 +892,86 @@ TEST(Takeover, nfsNotEnabled) {
       std::get<FuseChannelData>(clientData.mountPoints.at(0).channelInfo);
   checkExpectedFile(fuseChannelData0.fd.fd(), mount1FusePath);
 }
+
+void hotObjectIdsTestImpl(
+    uint64_t clientCapabilities,
+    std::optional<SerializedHotObjectIds> expected) {
+  TemporaryDirectory tmpDir("eden_takeover_test");
+  AbsolutePathPiece tmpDirPath{tmpDir.path().string()};
+
+  TakeoverData serverData;
+  auto lockFilePath = tmpDirPath + "lock"_pc;
+  serverData.lockFile = folly::File{lockFilePath.view(), O_RDWR | O_CREAT};
+  auto thriftSocketPath = tmpDirPath + "thrift"_pc;
+  serverData.thriftSocket =
+      folly::File{thriftSocketPath.view(), O_RDWR | O_CREAT};
+  serverData.mountdServerSocket = std::nullopt;
+
+  SerializedHotObjectIds hotObjectIds;
+  hotObjectIds.trees() = {"tree1", "tree2"};
+  hotObjectIds.blobs() = {"blob"};
+  serverData.hotObjectIds = hotObjectIds;
+
+  auto serverSendFuture = serverData.takeoverComplete.getFuture();
+  TestHandler handler{std::move(serverData)};
+  auto result = runTakeover(
+      tmpDir,
+      &handler,
+      kSupportedTakeoverVersions,
+      kSupportedTakeoverVersions,
+      clientCapabilities,
+      kSupportedCapabilities);
+  ASSERT_TRUE(serverSendFuture.hasValue());
+  ASSERT_TRUE(result.hasValue());
+  EXPECT_EQ(expected, result.value().hotObjectIds);
+}
+
+TEST(Takeover, hotObjectIds) {
+  SerializedHotObjectIds expected;
+  expected.trees() = {"tree1", "tree2"};
+  expected.blobs() = {"blob"};
+  hotObjectIdsTestImpl(kSupportedCapabilities, expected);
+}
+
+TEST(Takeover, hotObjectIdsNotSupportedByClient) {
+  hotObjectIdsTestImpl(
+      kSupportedCapabilities & ~TakeoverCapabilities::HOT_OBJECT_IDS,
+      std::nullopt);
+}
+
+TEST(Takeover, channelStopTime) {
+  TemporaryDirectory tmpDir("eden_takeover_test");
+  AbsolutePathPiece tmpDirPath{tmpDir.path().string()};
+
+  TakeoverData serverData;
+  auto lockFilePath = tmpDirPath + "lock"_pc;
+  serverData.lockFile = folly::File{lockFilePath.view(), O_RDWR | O_CREAT};
+  auto thriftSocketPath = tmpDirPath + "thrift"_pc;
+  serverData.thriftSocket =
+      folly::File{thriftSocketPath.view(), O_RDWR | O_CREAT};
+  serverData.mountdServerSocket = std::nullopt;
+
+  // Only the first mount records when its channel stopped.
+  auto stopTime = std::chrono::steady_clock::now();
+  for (const auto name : {"stopped"_pc, "unknown"_pc}) {
+    auto fusePath = tmpDirPath + name;
+    serverData.mountPoints.emplace_back(
+        tmpDirPath + "mounts"_pc + name,
+        tmpDirPath + "state"_pc + name,
+        std::vector<AbsolutePath>{},
+        FuseChannelData{
+            folly::File{fusePath.view(), O_RDWR | O_CREAT}, fuse_init_out{}},
+        SerializedInodeMap{});
+  }
+  serverData.mountPoints[0].channelStopTime = stopTime;
+
+  auto serverSendFuture = serverData.takeoverComplete.getFuture();
+  TestHandler handler{std::move(serverData)};
+  auto result = runTakeover(tmpDir, &handler);
+  ASSERT_TRUE(serverSendFuture.hasValue());
+  ASSERT_TRUE(result.hasValue());
+  const auto& clientData = result.value();
+  ASSERT_EQ(2, clientData.mountPoints.size());
+  EXPECT_EQ(stopTime, clientData.mountPoints[0].channelStopTime);
+  EXPECT_EQ(std::nullopt, clientData.mountPoints[1].channelStopTime);
+}
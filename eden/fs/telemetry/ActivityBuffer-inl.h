@@ -5,26 +5,128 @@
  * GNU General Public License version 2.
  */
 
+#include <algorithm>
+
 #include <folly/logging/xlog.h>
 
 namespace facebook::eden {
 
 template <typename TraceEvent>
-ActivityBuffer<TraceEvent>::ActivityBuffer(uint32_t maxEvents)
-    : maxEvents_(maxEvents) {}
+ActivityBuffer<TraceEvent>::ActivityBuffer(uint32_t maxEvents, size_t maxBytes)
+    : maxEvents_(maxEvents), maxBytes_(maxBytes) {}
+
+template <typename TraceEvent>
+void ActivityBuffer<TraceEvent>::addEvent(const TraceEvent& event) {
+  if (maxEvents_ == 0) {
+    return;
+  }
+  auto state = state_.wlock();
+  state->encoding.clear();
+  ActivityBufferCodec<TraceEvent>::encode(event, state->encoding);
+  if (sizeof(RecordSize) + state->encoding.size() > maxBytes_) {
+    XLOG_EVERY_MS(WARN, 60000)
+        << "Dropping an event of " << state->encoding.size()
+        << " bytes larger than its ActivityBuffer";
+    return;
+  }
+  state->append(folly::StringPiece{state->encoding}, maxBytes_);
+  while (state->count > maxEvents_) {
+    state->evictOldest();
+  }
+}
+
+template <typename TraceEvent>
+void ActivityBuffer<TraceEvent>::State::append(
+    folly::ByteRange record,
+    size_t maxBytes) {
+  auto total = sizeof(RecordSize) + record.size();
+  while (true) {
+    if (count == 0) {
+      head = 0;
+      tail = 0;
+      wrapped = false;
+    }
+    if (!wrapped) {
+      if (arena.size() - tail < total && arena.size() < maxBytes) {
+        arena.resize(
+            std::min(maxBytes, std::max(arena.size() * 2, tail + total)));
+      }
+      if (arena.size() - tail >= total) {
+        break;
+      }
+      // Leave the end of the arena unused and continue from its start.
+      wrapEnd = tail;
+      tail = 0;
+      wrapped = true;
+    }
+    if (head - tail >= total) {
+      break;
+    }
+    evictOldest();
+  }
+
+  auto size = static_cast<RecordSize>(record.size());
+  memcpy(arena.data() + tail, &size, sizeof(size));
+  memcpy(arena.data() + tail + sizeof(size), record.data(), record.size());
+  tail += total;
+  usedBytes += total;
+  ++count;
+}
+
+template <typename TraceEvent>
+void ActivityBuffer<TraceEvent>::State::evictOldest() {
+  RecordSize size;
+  memcpy(&size, arena.data() + head, sizeof(size));
+  head += sizeof(size) + size;
+  usedBytes -= sizeof(size) + size;
+  --count;
+  if (wrapped && head == wrapEnd) {
+    head = 0;
+    wrapped = false;
+  }
+}
+
+template <typename TraceEvent>
+std::string ActivityBuffer<TraceEvent>::snapshot() const {
+  auto state = state_.rlock();
+  std::string records;
+  if (state->count == 0) {
+    return records;
+  }
+  records.reserve(state->usedBytes);
+  auto* data = reinterpret_cast<const char*>(state->arena.data());
+  if (state->wrapped) {
+    records.append(data + state->head, state->wrapEnd - state->head);
+    records.append(data, state->tail);
+  } else {
+    records.append(data + state->head, state->tail - state->head);
+  }
+  return records;
+}
 
 template <typename TraceEvent>
-void ActivityBuffer<TraceEvent>::addEvent(TraceEvent event) {
-  auto events = events_.wlock();
-  events->push_back(std::move(event));
-  if (events->size() > maxEvents_) {
-    events->pop_front();
+template <typename Fn>
+void ActivityBuffer<TraceEvent>::forEachEvent(Fn&& fn) const {
+  auto records = snapshot();
+  folly::ByteRange remaining{folly::StringPiece{records}};
+  while (!remaining.empty()) {
+    auto size = ActivityBufferEncoding::read<RecordSize>(remaining);
+    fn(ActivityBufferCodec<TraceEvent>::decode(
+        folly::ByteRange{remaining.data(), size}));
+    remaining.advance(size);
   }
 }
 
 template <typename TraceEvent>
 std::deque<TraceEvent> ActivityBuffer<TraceEvent>::getAllEvents() const {
-  return *events_.rlock();
+  std::deque<TraceEvent> events;
+  forEachEvent([&](TraceEvent&& event) { events.push_back(std::move(event)); });
+  return events;
+}
+
+template <typename TraceEvent>
+size_t ActivityBuffer<TraceEvent>::getUsedBytes() const {
+  return state_.rlock()->usedBytes;
 }
 
 } // namespace facebook::eden
@@ -7,8 +7,14 @@
 
 #pragma once
 
+#include <cstring>
 #include <deque>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
 
+#include <folly/Range.h>
 #include <folly/Synchronized.h>
 
 #include "eden/fs/inodes/InodeNumber.h"
@@ -19,12 +25,73 @@
 namespace facebook::eden {
 
 /**
- * ActivityBuffer is a fixed size buffer of stored EdenFS trace events whose
- * maximum size can be set when initialized. To be filled, an ActivityBuffer
- * must subscribe to some tracebus of events of the same type and add events
- * that it reads during the subscription. ActivityBuffer supports methods for
- * adding recent events (evicting old events in the process) as well as reading
- * all trace events currently stored in a thread safe manner.
+ * Helpers for the ActivityBufferCodec specializations, which encode events as
+ * a sequence of trivially copyable fields, optionally followed by a string
+ * filling the rest of the encoding.
+ */
+struct ActivityBufferEncoding {
+  template <typename T>
+  static void append(std::string& out, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  template <typename T>
+  static T read(folly::ByteRange& in) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    T value;
+    memcpy(&value, in.data(), sizeof(value));
+    in.advance(sizeof(value));
+    return value;
+  }
+
+  /**
+   * Returns the rest of the encoding as a null-terminated string, the
+   * representation trace events use for their paths.
+   */
+  static std::shared_ptr<char[]> readRemainingString(folly::ByteRange& in) {
+    std::shared_ptr<char[]> str{new char[in.size() + 1]};
+    memcpy(str.get(), in.data(), in.size());
+    str[in.size()] = 0;
+    in.clear();
+    return str;
+  }
+};
+
+/**
+ * How an ActivityBuffer encodes its events. Event types that aren't trivially
+ * copyable, or that can be stored more compactly, specialize it next to
+ * their definition with the same two functions.
+ */
+template <typename TraceEvent>
+struct ActivityBufferCodec {
+  static_assert(
+      std::is_trivially_copyable_v<TraceEvent>,
+      "ActivityBufferCodec must be specialized for this event type");
+
+  static void encode(const TraceEvent& event, std::string& out) {
+    ActivityBufferEncoding::append(out, event);
+  }
+
+  static TraceEvent decode(folly::ByteRange in) {
+    return ActivityBufferEncoding::read<TraceEvent>(in);
+  }
+};
+
+/**
+ * ActivityBuffer is a bounded buffer of stored EdenFS trace events whose
+ * maximum number of events and size in bytes can be set when initialized. To
+ * be filled, an ActivityBuffer must subscribe to some tracebus of events of
+ * the same type and add events that it reads during the subscription.
+ * ActivityBuffer supports methods for adding recent events (evicting old
+ * events in the process) as well as reading all trace events currently stored
+ * in a thread safe manner.
+ *
+ * Events are stored encoded by their ActivityBufferCodec in a ring of
+ * variable sized records in a contiguous arena, which grows up to maxBytes as
+ * events are added. This bounds the memory used by events whose paths vary
+ * widely in size, and avoids an allocation per event. Events are only decoded
+ * when read, outside of the lock.
  *
  * With the ActivityBuffer, we enable functionality for retroactive debugging of
  * expensive events in EdenFS by storing past event changes that users will be
@@ -33,7 +100,11 @@ namespace facebook::eden {
 template <typename TraceEvent>
 class ActivityBuffer {
  public:
-  explicit ActivityBuffer(uint32_t maxEvents);
+  static constexpr size_t kDefaultMaxBytes = 1024 * 1024;
+
+  explicit ActivityBuffer(
+      uint32_t maxEvents,
+      size_t maxBytes = kDefaultMaxBytes);
 
   ActivityBuffer(const ActivityBuffer&) = delete;
   ActivityBuffer(ActivityBuffer&&) = delete;
@@ -41,11 +112,12 @@ class ActivityBuffer {
   ActivityBuffer& operator=(ActivityBuffer&&) = delete;
 
   /**
-   * Adds a new TraceEvent to the ActivityBuffer. Evicts the oldest
-   * event if the buffer was full (meaning maxEvents events were already stored
-   * in the buffer).
+   * Adds a new TraceEvent to the ActivityBuffer. Evicts the oldest events
+   * if the buffer was full, meaning maxEvents events were already stored in
+   * the buffer or the new one doesn't fit in maxBytes. Events whose encoding
+   * is larger than maxBytes are dropped.
    */
-  void addEvent(TraceEvent event);
+  void addEvent(const TraceEvent& event);
 
   /**
    * Returns an std::deque containing all TraceEvents stored in the
@@ -53,9 +125,50 @@ class ActivityBuffer {
    */
   std::deque<TraceEvent> getAllEvents() const;
 
+  /**
+   * Calls fn with each TraceEvent stored in the ActivityBuffer, oldest first,
+   * decoding them one at a time.
+   */
+  template <typename Fn>
+  void forEachEvent(Fn&& fn) const;
+
+  /**
+   * The bytes taken by the encodings of the stored events, including the
+   * size of their records.
+   */
+  size_t getUsedBytes() const;
+
  private:
-  uint32_t maxEvents_;
-  folly::Synchronized<std::deque<TraceEvent>> events_;
+  using RecordSize = uint32_t;
+
+  /**
+   * Records are stored in [head, tail). Once the records wrap around to the
+   * start of the arena, they are stored in [head, wrapEnd) then [0, tail).
+   */
+  struct State {
+    std::vector<uint8_t> arena;
+    size_t head = 0;
+    size_t tail = 0;
+    size_t wrapEnd = 0;
+    bool wrapped = false;
+    size_t count = 0;
+    size_t usedBytes = 0;
+    // Reused to encode the events without allocating.
+    std::string encoding;
+
+    void append(folly::ByteRange record, size_t maxBytes);
+    void evictOldest();
+  };
+
+  /**
+   * Copies the records of the stored events, oldest first, so that they can
+   * be decoded without holding the lock.
+   */
+  std::string snapshot() const;
+
+  const uint32_t maxEvents_;
+  const size_t maxBytes_;
+  folly::Synchronized<State> state_;
 };
 
 } // namespace facebook::eden
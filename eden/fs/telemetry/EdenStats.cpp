@@ -7,12 +7,115 @@
 
 #include "eden/fs/telemetry/EdenStats.h"
 
+#include <fb303/ServiceData.h>
+#include <fmt/format.h>
+#include <folly/Synchronized.h>
 #include <folly/logging/xlog.h>
+#include <algorithm>
 #include <chrono>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
 
 namespace facebook::eden {
 
+namespace {
+/**
+ * Reads of the percentile counters within this interval share the same
+ * merge of the thread-local histograms.
+ */
+constexpr auto kHistogramMergeInterval = std::chrono::seconds{1};
+
+struct ExportedPercentile {
+  std::string_view suffix;
+  double fraction;
+};
+
+constexpr ExportedPercentile kExportedPercentiles[] = {
+    {".lifetime.p50", 0.5},
+    {".lifetime.p90", 0.9},
+    {".lifetime.p99", 0.99},
+    {".lifetime.p999", 0.999},
+};
+} // namespace
+
+class StatsGroupBase::Duration::Histograms {
+ public:
+  /**
+   * Returns the histograms recorded under `name`, exporting their
+   * percentiles the first time. They are never destroyed, like the fb303
+   * stats.
+   */
+  static Histograms& get(std::string_view name) {
+    static auto* registry = new folly::Synchronized<
+        std::unordered_map<std::string, std::unique_ptr<Histograms>>,
+        std::mutex>{};
+    auto locked = registry->lock();
+    auto& histograms = (*locked)[std::string{name}];
+    if (!histograms) {
+      histograms = std::make_unique<Histograms>(name);
+      auto counters = fb303::ServiceData::get()->getDynamicCounters();
+      for (const auto& percentile : kExportedPercentiles) {
+        counters->registerCallback(
+            fmt::format("{}{}", name, percentile.suffix),
+            [histograms = histograms.get(), fraction = percentile.fraction] {
+              return static_cast<int64_t>(histograms->getPercentile(fraction));
+            });
+      }
+    }
+    return *histograms;
+  }
+
+  explicit Histograms(std::string_view name) : name_{name} {}
+
+  std::string_view getName() const {
+    return name_;
+  }
+
+  void attach(const LogLinearHistogram* histogram) {
+    state_.lock()->attached.push_back(histogram);
+  }
+
+  /**
+   * Stops reading `histogram`, which is about to be destroyed, keeping its
+   * counts.
+   */
+  void detach(const LogLinearHistogram* histogram) {
+    auto state = state_.lock();
+    state->retired.merge(*histogram);
+    auto& attached = state->attached;
+    attached.erase(std::find(attached.begin(), attached.end(), histogram));
+  }
+
+  uint64_t getPercentile(double fraction) {
+    auto state = state_.lock();
+    auto now = std::chrono::steady_clock::now();
+    if (!state->mergedAt || now - *state->mergedAt >= kHistogramMergeInterval) {
+      state->merged.clear();
+      state->merged.merge(state->retired);
+      for (const auto* histogram : state->attached) {
+        state->merged.merge(*histogram);
+      }
+      state->mergedAt = now;
+    }
+    return state->merged.getPercentile(fraction);
+  }
+
+ private:
+  struct State {
+    std::vector<const LogLinearHistogram*> attached;
+    // The counts of the histograms of exited threads.
+    LogLinearHistogram retired;
+    LogLinearHistogram merged;
+    std::optional<std::chrono::steady_clock::time_point> mergedAt;
+  };
+
+  const std::string name_;
+  folly::Synchronized<State, std::mutex> state_;
+};
+
 void EdenStats::flush() {
   // This method is only really useful while testing to ensure that the service
   // data singleton instance has the latest stats. Since all our stats are now
@@ -38,7 +141,8 @@ StatsGroupBase::Duration::Duration(std::string_view name)
           name,
           fb303::ExportTypeConsts::kSumCountAvgRate,
           fb303::QuantileConsts::kP1_P10_P50_P90_P99,
-          fb303::SlidingWindowPeriodConsts::kOneMinTenMinHour} {
+          fb303::SlidingWindowPeriodConsts::kOneMinTenMinHour},
+      histograms_{&Histograms::get(name)} {
   // This should be a compile-time check but I don't know how to spell that in a
   // convenient way. :) Asserting at startup in debug mode should be sufficient.
   XCHECK_GT(name.size(), size_t{3}) << "duration name too short";
@@ -47,8 +151,23 @@ StatsGroupBase::Duration::Duration(std::string_view name)
   // TODO: enforce the name matches the StatsGroup prefix.
 }
 
+std::string_view StatsGroupBase::Duration::getName() const {
+  return histograms_->getName();
+}
+
+StatsGroupBase::Duration::~Duration() {
+  if (histogram_) {
+    histograms_->detach(histogram_.get());
+  }
+}
+
 void StatsGroupBase::Duration::addDuration(std::chrono::microseconds elapsed) {
   addValue(elapsed.count());
+  if (FOLLY_UNLIKELY(!histogram_)) {
+    histogram_ = std::make_unique<LogLinearHistogram>();
+    histograms_->attach(histogram_.get());
+  }
+  histogram_->add(std::max<int64_t>(elapsed.count(), 0));
 }
 
 DurationScope::~DurationScope() noexcept {
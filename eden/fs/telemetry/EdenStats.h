@@ -14,6 +14,8 @@
 #include <folly/stop_watch.h>
 
 #include "eden/fs/eden-config.h"
+#include "eden/fs/telemetry/LogLinearHistogram.h"
+#include "eden/fs/telemetry/RequestSampler.h"
 
 namespace facebook::eden {
 
@@ -21,8 +23,10 @@ struct FuseStats;
 struct NfsStats;
 struct PrjfsStats;
 struct ObjectStoreStats;
+struct LocalStoreStats;
 struct HgBackingStoreStats;
 struct HgImporterStats;
+struct InodeStats;
 struct JournalStats;
 struct ThriftStats;
 
@@ -53,10 +57,19 @@ class StatsGroupBase {
    *
    * In general, EdenFS measures latencies in units of microseconds.
    * Duration enforces that its stat names end in "_us".
+   *
+   * Besides the fb303 quantile stat, durations are recorded in a thread-local
+   * LogLinearHistogram. The histograms of all the threads are merged when
+   * the "<name>.lifetime.p50", ".p90", ".p99" and ".p999" counters are read,
+   * which report the percentiles since EdenFS started in every build.
    */
   class Duration : private Stat {
    public:
     explicit Duration(std::string_view name);
+    ~Duration();
+
+    Duration(const Duration&) = delete;
+    Duration& operator=(const Duration&) = delete;
 
     /**
      * Record a duration in microseconds to the QuantileStatWrapper. Also
@@ -72,6 +85,22 @@ class StatsGroupBase {
     }
 
     void addDuration(std::chrono::microseconds elapsed);
+
+    /**
+     * The name of the stat. The returned view is valid until EdenFS exits.
+     */
+    std::string_view getName() const;
+
+    /**
+     * The histograms recorded under one name, by all the threads.
+     */
+    class Histograms;
+
+   private:
+    Histograms* const histograms_;
+    // Allocated on the first addDuration, as most threads only record some
+    // of the durations.
+    std::unique_ptr<LogLinearHistogram> histogram_;
   };
 };
 
@@ -103,6 +132,14 @@ class EdenStats {
   template <typename T>
   T& getStatsForCurrentThread() = delete;
 
+  /**
+   * Samples the requests in flight when telemetry:request-sampling-interval
+   * is set.
+   */
+  RequestSampler& getRequestSampler() {
+    return requestSampler_;
+  }
+
  private:
   class ThreadLocalTag {};
 
@@ -113,10 +150,14 @@ class EdenStats {
   ThreadLocal<NfsStats> nfsStats_;
   ThreadLocal<PrjfsStats> prjfsStats_;
   ThreadLocal<ObjectStoreStats> objectStoreStats_;
+  ThreadLocal<LocalStoreStats> localStoreStats_;
   ThreadLocal<HgBackingStoreStats> hgBackingStoreStats_;
   ThreadLocal<HgImporterStats> hgImporterStats_;
+  ThreadLocal<InodeStats> inodeStats_;
   ThreadLocal<JournalStats> journalStats_;
   ThreadLocal<ThriftStats> thriftStats_;
+
+  RequestSampler requestSampler_;
 };
 
 template <>
@@ -140,6 +181,11 @@ EdenStats::getStatsForCurrentThread<ObjectStoreStats>() {
   return *objectStoreStats_.get();
 }
 
+template <>
+inline LocalStoreStats& EdenStats::getStatsForCurrentThread<LocalStoreStats>() {
+  return *localStoreStats_.get();
+}
+
 template <>
 inline HgBackingStoreStats&
 EdenStats::getStatsForCurrentThread<HgBackingStoreStats>() {
@@ -151,6 +197,11 @@ inline HgImporterStats& EdenStats::getStatsForCurrentThread<HgImporterStats>() {
   return *hgImporterStats_.get();
 }
 
+template <>
+inline InodeStats& EdenStats::getStatsForCurrentThread<InodeStats>() {
+  return *inodeStats_.get();
+}
+
 template <>
 inline JournalStats& EdenStats::getStatsForCurrentThread<JournalStats>() {
   return *journalStats_.get();
@@ -171,6 +222,7 @@ class StatsGroup : public StatsGroupBase {
    * up the calling thread's object.
    */
   using DurationPtr = Duration T::*;
+  using CounterPtr = Counter T::*;
 };
 
 struct FuseStats : StatsGroup<FuseStats> {
@@ -194,6 +246,7 @@ struct FuseStats : StatsGroup<FuseStats> {
   Duration fsync{"fuse.fsync_us"};
   Duration opendir{"fuse.opendir_us"};
   Duration readdir{"fuse.readdir_us"};
+  Duration readdirplus{"fuse.readdirplus_us"};
   Duration releasedir{"fuse.releasedir_us"};
   Duration fsyncdir{"fuse.fsyncdir_us"};
   Duration statfs{"fuse.statfs_us"};
@@ -233,10 +286,35 @@ struct NfsStats : StatsGroup<NfsStats> {
   Duration nfsFsinfo{"nfs.fsinfo_us"};
   Duration nfsPathconf{"nfs.pathconf_us"};
   Duration nfsCommit{"nfs.commit_us"};
+
+  // GETATTR calls received right after another procedure completed on the
+  // same inode, by procedure.
+  Counter nfsGetattrAfterGetattr{"nfs.getattr_after.getattr"};
+  Counter nfsGetattrAfterSetattr{"nfs.getattr_after.setattr"};
+  Counter nfsGetattrAfterLookup{"nfs.getattr_after.lookup"};
+  Counter nfsGetattrAfterAccess{"nfs.getattr_after.access"};
+  Counter nfsGetattrAfterReadlink{"nfs.getattr_after.readlink"};
+  Counter nfsGetattrAfterRead{"nfs.getattr_after.read"};
+  Counter nfsGetattrAfterWrite{"nfs.getattr_after.write"};
+  Counter nfsGetattrAfterCreate{"nfs.getattr_after.create"};
+  Counter nfsGetattrAfterMkdir{"nfs.getattr_after.mkdir"};
+  Counter nfsGetattrAfterSymlink{"nfs.getattr_after.symlink"};
+  Counter nfsGetattrAfterMknod{"nfs.getattr_after.mknod"};
+  Counter nfsGetattrAfterRemove{"nfs.getattr_after.remove"};
+  Counter nfsGetattrAfterRmdir{"nfs.getattr_after.rmdir"};
+  Counter nfsGetattrAfterRename{"nfs.getattr_after.rename"};
+  Counter nfsGetattrAfterLink{"nfs.getattr_after.link"};
+  Counter nfsGetattrAfterReaddir{"nfs.getattr_after.readdir"};
+  Counter nfsGetattrAfterReaddirplus{"nfs.getattr_after.readdirplus"};
+  Counter nfsGetattrAfterFsstat{"nfs.getattr_after.fsstat"};
+  Counter nfsGetattrAfterFsinfo{"nfs.getattr_after.fsinfo"};
+  Counter nfsGetattrAfterPathconf{"nfs.getattr_after.pathconf"};
+  Counter nfsGetattrAfterCommit{"nfs.getattr_after.commit"};
 };
 
 struct PrjfsStats : StatsGroup<PrjfsStats> {
   Counter outOfOrderCreate{"prjfs.out_of_order_create"};
+  Counter coalescedFileNotification{"prjfs.coalesced_file_notification"};
   Duration queuedFileNotification{"prjfs.queued_file_notification_us"};
 
   Duration newFileCreated{"prjfs.newFileCreated_us"};
@@ -261,13 +339,32 @@ struct PrjfsStats : StatsGroup<PrjfsStats> {
  */
 struct ObjectStoreStats : StatsGroup<ObjectStoreStats> {
   Duration getTree{"store.get_tree_us"};
+  Duration getTreeBatch{"store.get_tree_batch_us"};
   Duration getBlob{"store.get_blob_us"};
   Duration getBlobMetadata{"store.get_blob_metadata_us"};
+  Duration getBlobMetadataBatch{"store.get_blob_metadata_batch_us"};
+
+  Counter getTreeFromPersistentCache{
+      "object_store.get_tree.persistent_cache"};
+
+  Counter negativeCacheHit{"object_store.negative_cache.hit"};
+  Counter negativeCacheInsert{"object_store.negative_cache.insert"};
 
   Counter getBlobFromLocalStore{"object_store.get_blob.local_store"};
   Counter getBlobFromBackingStore{"object_store.get_blob.backing_store"};
+  Counter getBlobCoalesced{"object_store.get_blob.coalesced"};
+
+  Duration getBlobRange{"store.get_blob_range_us"};
+  Counter getBlobRangeChunkCacheHit{
+      "object_store.get_blob_range.chunk_cache_hit"};
+  Counter getBlobRangeChunkFetch{"object_store.get_blob_range.chunk_fetch"};
+
+  Counter cacheBudgetShrink{"object_store.cache_budget.shrink"};
+  Counter cacheBudgetGrow{"object_store.cache_budget.grow"};
 
   Counter getBlobMetadataFromMemory{"object_store.get_blob_metadata.memory"};
+  Counter getSymlinkTargetFromMemory{"object_store.get_symlink_target.memory"};
+  Counter blobMetadataFromTree{"object_store.blob_metadata_from_tree"};
   Counter getBlobMetadataFromLocalStore{
       "object_store.get_blob_metadata.local_store"};
   Counter getBlobMetadataFromBackingStore{
@@ -280,6 +377,51 @@ struct ObjectStoreStats : StatsGroup<ObjectStoreStats> {
       "object_store.get_blob_size.backing_store"};
 };
 
+/**
+ * RocksDB's own statistics, sampled periodically by RocksDbLocalStore, and
+ * the batched writes of LocalStoreIngester.
+ */
+struct LocalStoreStats : StatsGroup<LocalStoreStats> {
+  Counter blockCacheHit{"local_store.rocksdb.block_cache_hit"};
+  Counter blockCacheMiss{"local_store.rocksdb.block_cache_miss"};
+  Counter bloomFilterUseful{"local_store.rocksdb.bloom_filter_useful"};
+  Counter stallTime{"local_store.rocksdb.stall_time_us"};
+  Counter ingestFlushBytes{"local_store.ingest.flush_bytes"};
+  Counter ingestFlushObjects{"local_store.ingest.flush_objects"};
+  Counter ingestFlushFailure{"local_store.ingest.flush_failure"};
+  Duration ingestFlush{"local_store.ingest.flush_us"};
+
+  // Recorded by InstrumentedLocalStore, for each non-deprecated KeySpace.
+  Duration blobGet{"local_store.blob.get_us"};
+  Duration blobGetBatch{"local_store.blob.get_batch_us"};
+  Duration blobPut{"local_store.blob.put_us"};
+  Counter blobReadBytes{"local_store.blob.read_bytes"};
+  Counter blobWriteBytes{"local_store.blob.write_bytes"};
+  Duration blobMetaDataGet{"local_store.blobmeta.get_us"};
+  Duration blobMetaDataGetBatch{"local_store.blobmeta.get_batch_us"};
+  Duration blobMetaDataPut{"local_store.blobmeta.put_us"};
+  Counter blobMetaDataReadBytes{"local_store.blobmeta.read_bytes"};
+  Counter blobMetaDataWriteBytes{"local_store.blobmeta.write_bytes"};
+  Duration treeGet{"local_store.tree.get_us"};
+  Duration treeGetBatch{"local_store.tree.get_batch_us"};
+  Duration treePut{"local_store.tree.put_us"};
+  Counter treeReadBytes{"local_store.tree.read_bytes"};
+  Counter treeWriteBytes{"local_store.tree.write_bytes"};
+  Duration hgProxyHashGet{"local_store.hgproxyhash.get_us"};
+  Duration hgProxyHashGetBatch{"local_store.hgproxyhash.get_batch_us"};
+  Duration hgProxyHashPut{"local_store.hgproxyhash.put_us"};
+  Counter hgProxyHashReadBytes{"local_store.hgproxyhash.read_bytes"};
+  Counter hgProxyHashWriteBytes{"local_store.hgproxyhash.write_bytes"};
+  Duration hgCommitToTreeGet{"local_store.hgcommit2tree.get_us"};
+  Duration hgCommitToTreeGetBatch{"local_store.hgcommit2tree.get_batch_us"};
+  Duration hgCommitToTreePut{"local_store.hgcommit2tree.put_us"};
+  Counter hgCommitToTreeReadBytes{"local_store.hgcommit2tree.read_bytes"};
+  Counter hgCommitToTreeWriteBytes{"local_store.hgcommit2tree.write_bytes"};
+
+  Duration writeBatchFlush{"local_store.write_batch.flush_us"};
+  Counter writeBatchFlushBytes{"local_store.write_batch.flush_bytes"};
+};
+
 /**
  * @see HgBackingStore
  */
@@ -288,9 +430,20 @@ struct HgBackingStoreStats : StatsGroup<HgBackingStoreStats> {
   Duration importBlob{"store.hg.import_blob_us"};
   Duration getTree{"store.hg.get_tree_us"};
   Duration importTree{"store.hg.import_tree_us"};
+  Duration importManifestForRoot{"store.hg.import_manifest_for_root_us"};
   Duration getBlobMetadata{"store.hg.get_blob_metadata_us"};
   Counter loadProxyHash{"store.hg.load_proxy_hash"};
+  Counter loadProxyHashCached{"store.hg.load_proxy_hash_cached"};
+  Counter speculativeTreePrefetch{"store.hg.speculative_tree_prefetch"};
+  Counter speculativeTreePrefetchHit{
+      "store.hg.speculative_tree_prefetch_hit"};
   Counter auxMetadataMiss{"store.hg.aux_metadata_miss"};
+  // Transitions of HgImportOverloadController, and the requests it turned
+  // away.
+  Counter overloadEntered{"store.hg.overload_entered"};
+  Counter overloadLeft{"store.hg.overload_left"};
+  Counter importShed{"store.hg.import_shed"};
+  Counter importFailedFast{"store.hg.import_failed_fast"};
 };
 
 /**
@@ -305,6 +458,47 @@ struct HgImporterStats : StatsGroup<HgImporterStats> {
   Counter prefetchFiles{"hg_importer.prefetch_files"};
 };
 
+struct InodeStats : StatsGroup<InodeStats> {
+  // Lookups of unloaded children answered from the object store without
+  // loading an inode.
+  Counter loadAvoided{"inodes.load_avoided"};
+
+  // The phases of inode loads, as described by InodeLoadPhases. Each load
+  // only records the phases it goes through.
+  Duration loadInodeMapWait{"inodes.load.inode_map_wait_us"};
+  Duration loadTreeFetch{"inodes.load.tree_fetch_us"};
+  Duration loadOverlayRead{"inodes.load.overlay_read_us"};
+  Duration loadMetadataLookup{"inodes.load.metadata_lookup_us"};
+
+  // Materialized files compared with the checked out commit, and those found
+  // unchanged and dematerialized.
+  Counter dematerializeChecked{"inodes.dematerialize_unchanged.checked"};
+  Counter dematerializeDematerialized{
+      "inodes.dematerialize_unchanged.dematerialized"};
+
+  // Statuses answered from the cached status as is, by re-verifying the
+  // paths changed since, and by diffing the whole working copy.
+  Counter statusCacheHit{"inodes.scm_status_cache.hit"};
+  Counter statusCacheUpdate{"inodes.scm_status_cache.update"};
+  Counter statusCacheMiss{"inodes.scm_status_cache.miss"};
+
+  // The readdir prefetches of the children of a directory: issued, skipped
+  // because the listing process rarely looks the children up, and throttled
+  // by store:max-tree-prefetches. Listings followed by a lookup count as a
+  // hit when they were prefetched and as a miss otherwise, so that hit/issued
+  // is the fraction of the prefetches that were used.
+  Counter readdirPrefetchIssued{"inodes.readdir_prefetch.issued"};
+  Counter readdirPrefetchSkipped{"inodes.readdir_prefetch.skipped"};
+  Counter readdirPrefetchThrottled{"inodes.readdir_prefetch.throttled"};
+  Counter readdirPrefetchHit{"inodes.readdir_prefetch.hit"};
+  Counter readdirPrefetchMiss{"inodes.readdir_prefetch.miss"};
+
+  // The bytes of files read sequentially, and the files of directories read
+  // in order, fetched ahead of the reads. See ReadAheadTracker.
+  Counter readAheadBytes{"inodes.read_ahead.bytes"};
+  Counter readAheadFiles{"inodes.read_ahead.files"};
+};
+
 struct JournalStats : StatsGroup<JournalStats> {
   Counter truncatedReads{"journal.truncated_reads"};
   Counter filesAccumulated{"journal.files_accumulated"};
@@ -313,6 +507,26 @@ struct JournalStats : StatsGroup<JournalStats> {
 struct ThriftStats : StatsGroup<ThriftStats> {
   Duration streamChangesSince{
       "thrift.StreamingEdenService.streamChangesSince.streaming_time_us"};
+  Duration streamGlobFiles{
+      "thrift.StreamingEdenService.streamGlobFiles.streaming_time_us"};
+  Duration streamScmStatus{
+      "thrift.StreamingEdenService.streamScmStatus.streaming_time_us"};
+  Duration streamBlobs{
+      "thrift.StreamingEdenService.streamBlobs.streaming_time_us"};
+  Counter globResultCacheHit{"thrift.glob_result_cache.hit"};
+  Counter globResultCacheMiss{"thrift.glob_result_cache.miss"};
+  // The stages of getAttributesFromFiles and getAttributesFromFilesV2: the
+  // resolution of the paths, then the computation of their attributes.
+  Duration getAttributesLookup{"thrift.getAttributesFromFiles.lookup_us"};
+  Duration getAttributesCompute{"thrift.getAttributesFromFiles.compute_us"};
+  // The time requests waited on their concurrency limit, and the requests
+  // rejected because too many were waiting.
+  Duration globQueueTime{"thrift.limiter.glob.queue_time_us"};
+  Counter globRejected{"thrift.limiter.glob.rejected"};
+  Duration statusQueueTime{"thrift.limiter.status.queue_time_us"};
+  Counter statusRejected{"thrift.limiter.status.rejected"};
+  Duration checkoutQueueTime{"thrift.limiter.checkout.queue_time_us"};
+  Counter checkoutRejected{"thrift.limiter.checkout.rejected"};
 };
 
 /**
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/FetchCost.h"
+
+#include <fmt/format.h>
+
+namespace facebook::eden {
+
+bool FetchCost::empty() const {
+  for (const auto& tier : tiers) {
+    if (tier.count != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string FetchCost::toString() const {
+  std::string result;
+  for (uint8_t source = 0; source < kSourceEnumMax; ++source) {
+    const auto& tier = tiers[source];
+    if (tier.count == 0) {
+      continue;
+    }
+    if (!result.empty()) {
+      result += ' ';
+    }
+    fmt::format_to(
+        std::back_inserter(result),
+        "{}={}/{}us/{}B",
+        getSourceName(static_cast<Source>(source)),
+        tier.count,
+        std::chrono::duration_cast<std::chrono::microseconds>(tier.duration)
+            .count(),
+        tier.bytes);
+  }
+  return result;
+}
+
+std::string_view FetchCost::getSourceName(Source source) {
+  switch (source) {
+    case MemoryCache:
+      return "memory_cache";
+    case DiskCache:
+      return "disk_cache";
+    case BackingStore:
+      return "backing_store";
+    case kSourceEnumMax:
+      break;
+  }
+  return "unknown";
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace facebook::eden {
+
+/**
+ * Where the objects fetched by a request came from: for each of the memory
+ * caches, the disk caches and the backing store, how many objects it got
+ * from there, the wall time it spent getting them and their size.
+ *
+ * Fetches made concurrently on behalf of a request each count their whole
+ * duration, so the durations can add up to more than the request took.
+ */
+struct FetchCost {
+  enum Source : uint8_t {
+    MemoryCache,
+    DiskCache,
+    BackingStore,
+    kSourceEnumMax,
+  };
+
+  struct Tier {
+    uint64_t count = 0;
+    std::chrono::nanoseconds duration{0};
+    uint64_t bytes = 0;
+  };
+
+  /** Whether the request didn't fetch any object. */
+  bool empty() const;
+
+  /**
+   * Formats the sources objects were fetched from as, e.g.,
+   * "memory_cache=2/31us/1024B backing_store=1/42017us/4096B".
+   */
+  std::string toString() const;
+
+  static std::string_view getSourceName(Source source);
+
+  std::array<Tier, kSourceEnumMax> tiers;
+};
+
+} // namespace facebook::eden
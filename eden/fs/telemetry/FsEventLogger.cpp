@@ -7,8 +7,6 @@
 
 #include "eden/fs/telemetry/FsEventLogger.h"
 
-#include <folly/Random.h>
-
 #include "eden/fs/config/EdenConfig.h"
 #include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/telemetry/IHiveLogger.h"
@@ -47,7 +45,6 @@ FsEventLogger::FsEventLogger(
     std::shared_ptr<IHiveLogger> logger)
     : edenConfig_{std::move(edenConfig)},
       logger_{std::move(logger)},
-      counterStartTime_{std::chrono::steady_clock::now()},
       configsString_{getConfigsString(edenConfig_->getEdenConfig())},
       configsStringUpdateTime_{std::chrono::steady_clock::now()} {}
 
@@ -61,33 +58,18 @@ void FsEventLogger::log(Event event) {
   const auto& denominators =
       config->requestSamplingGroupDenominators.getValue();
   auto samplingGroup = folly::to_underlying(event.samplingGroup);
-  if (samplingGroup > denominators.size()) {
+  if (samplingGroup >= denominators.size()) {
     // sampling group does not exist
     return;
   }
-  if (auto sampleDenominator = denominators.at(samplingGroup);
-      sampleDenominator && 0 != folly::Random::rand32(sampleDenominator)) {
-    // failed sampling
+  if (!sampler_.sample(
+          denominators[samplingGroup],
+          config->requestSamplesPerMinute.getValue())) {
+    // failed sampling, or throttled
     return;
   }
 
-  // Multiple threads could enter the branches at the same time
-  // resulting in samplesCount_ undercounting, but this should rarely happen
-  // given the sampling above.
   auto now = std::chrono::steady_clock::now();
-  if ((now - counterStartTime_.load()) > std::chrono::minutes(1)) {
-    // reset counter for this minute
-    counterStartTime_.store(now);
-    samplesCount_.store(1);
-  } else if (
-      samplesCount_.load() < config->requestSamplesPerMinute.getValue()) {
-    // not throttled so bump counter
-    samplesCount_.fetch_add(1, std::memory_order_relaxed);
-  } else {
-    // throttled
-    return;
-  }
-
   if ((now - configsStringUpdateTime_.load()) > kConfigsStringRefreshInterval) {
     configsStringUpdateTime_.store(now);
     *configsString_.wlock() = getConfigsString(edenConfig_->getEdenConfig());
@@ -97,7 +79,8 @@ void FsEventLogger::log(Event event) {
   uint64_t durationUs =
       std::chrono::duration_cast<std::chrono::microseconds>(event.durationNs)
           .count();
-  logger_->logFsEventSample({durationUs, event.cause, *configString});
+  logger_->logFsEventSample(
+      {durationUs, event.cause, *configString, event.fetchCost});
 }
 
 } // namespace facebook::eden
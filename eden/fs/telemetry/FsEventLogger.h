@@ -12,6 +12,8 @@
 #include <vector>
 
 #include <folly/Synchronized.h>
+#include "eden/fs/telemetry/FetchCost.h"
+#include "eden/fs/utils/RateLimitedSampler.h"
 #include "folly/Range.h"
 
 namespace facebook::eden {
@@ -37,6 +39,8 @@ class FsEventLogger {
     std::chrono::nanoseconds durationNs;
     SamplingGroup samplingGroup;
     folly::StringPiece cause;
+    /** Where the objects fetched by the event came from. */
+    FetchCost fetchCost{};
   };
 
   FsEventLogger(
@@ -48,8 +52,8 @@ class FsEventLogger {
   std::shared_ptr<ReloadableConfig> edenConfig_;
   std::shared_ptr<IHiveLogger> logger_;
 
-  std::atomic<uint32_t> samplesCount_{0};
-  std::atomic<std::chrono::steady_clock::time_point> counterStartTime_;
+  /** Caps the samples to telemetry:request-samples-per-minute. */
+  RateLimitedSampler sampler_{std::chrono::minutes{1}};
 
   folly::Synchronized<std::string> configsString_;
   std::atomic<std::chrono::steady_clock::time_point> configsStringUpdateTime_;
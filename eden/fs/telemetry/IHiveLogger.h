@@ -10,6 +10,7 @@
 #include "eden/fs/config/ReloadableConfig.h"
 #include "eden/fs/inodes/InodeNumber.h"
 #include "eden/fs/store/ObjectFetchContext.h"
+#include "eden/fs/telemetry/FetchCost.h"
 #include "eden/fs/telemetry/SessionInfo.h"
 #include "eden/fs/utils/PathFuncs.h"
 
@@ -34,6 +35,7 @@ struct FsEventSample {
   uint64_t durationUs;
   folly::StringPiece cause;
   folly::StringPiece configList;
+  FetchCost fetchCost;
 };
 
 // TODO: Deprecate ScribeLogger and rename this class ScribeLogger.
@@ -103,6 +103,20 @@ struct FetchHeavy {
   }
 };
 
+struct HgImportOverload {
+  static constexpr const char* type = "hg_import_overload";
+
+  bool overloaded;
+  uint64_t queue_depth;
+  int64_t average_latency_ms;
+
+  void populate(DynamicEvent& event) const {
+    event.addBool("overloaded", overloaded);
+    event.addInt("queue_depth", queue_depth);
+    event.addInt("average_latency_ms", average_latency_ms);
+  }
+};
+
 struct ParentMismatch {
   static constexpr const char* type = "parent_mismatch";
 
@@ -152,6 +166,11 @@ struct FinishedCheckout {
   int64_t fetchedTrees = 0;
   int64_t fetchedBlobs = 0;
   int64_t numConflicts = 0;
+  // The phases of the checkout, in seconds. The prefetch overlaps the diff.
+  double lookupTreesDuration = 0.0;
+  double prefetchDuration = 0.0;
+  double diffDuration = 0.0;
+  double inodeCheckoutDuration = 0.0;
 
   void populate(DynamicEvent& event) const {
     event.addString("mode", mode);
@@ -160,6 +179,10 @@ struct FinishedCheckout {
     event.addInt("fetched_trees", fetchedTrees);
     event.addInt("fetched_blobs", fetchedBlobs);
     event.addInt("num_conflicts", numConflicts);
+    event.addDouble("lookup_trees_duration", lookupTreesDuration);
+    event.addDouble("prefetch_duration", prefetchDuration);
+    event.addDouble("diff_duration", diffDuration);
+    event.addDouble("inode_checkout_duration", inodeCheckoutDuration);
   }
 };
 
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/LogLinearHistogram.h"
+
+#include <folly/lang/Bits.h>
+#include <algorithm>
+#include <cmath>
+
+namespace facebook::eden {
+
+size_t LogLinearHistogram::getBucket(uint64_t value) noexcept {
+  if (value < kSubBucketCount) {
+    return value;
+  }
+  // The power of two holding the value, and its sub-bucket, the next bits.
+  size_t exponent = folly::findLastSet(value) - 1;
+  size_t subBucket =
+      (value >> (exponent - kSubBucketBits)) & (kSubBucketCount - 1);
+  return kSubBucketCount + (exponent - kSubBucketBits) * kSubBucketCount +
+      subBucket;
+}
+
+uint64_t LogLinearHistogram::getBucketUpperBound(size_t bucket) noexcept {
+  if (bucket < kSubBucketCount) {
+    return bucket;
+  }
+  size_t shift = (bucket - kSubBucketCount) / kSubBucketCount;
+  uint64_t subBucket = (bucket - kSubBucketCount) % kSubBucketCount;
+  uint64_t lowerBound = (kSubBucketCount + subBucket) << shift;
+  return lowerBound + ((uint64_t{1} << shift) - 1);
+}
+
+void LogLinearHistogram::merge(const LogLinearHistogram& other) noexcept {
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    auto count = other.buckets_[i].load(std::memory_order_relaxed);
+    if (count) {
+      buckets_[i].fetch_add(count, std::memory_order_relaxed);
+    }
+  }
+}
+
+void LogLinearHistogram::clear() noexcept {
+  for (auto& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+uint64_t LogLinearHistogram::getCount() const noexcept {
+  uint64_t count = 0;
+  for (const auto& bucket : buckets_) {
+    count += bucket.load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+uint64_t LogLinearHistogram::getPercentile(double fraction) const noexcept {
+  auto total = getCount();
+  if (total == 0) {
+    return 0;
+  }
+  // The rank of the value, counting from 1.
+  auto rank = static_cast<uint64_t>(std::ceil(fraction * total));
+  rank = std::max<uint64_t>(rank, 1);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBucketCount; ++i) {
+    seen += buckets_[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      return getBucketUpperBound(i);
+    }
+  }
+  // Values were added while counting.
+  return getBucketUpperBound(kBucketCount - 1);
+}
+
+} // namespace facebook::eden
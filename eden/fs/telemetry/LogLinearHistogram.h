@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace facebook::eden {
+
+/**
+ * A histogram of integer values, with buckets growing exponentially so that
+ * any value fits in a few kilobytes.
+ *
+ * Values below 2^kSubBucketBits have a bucket each. Above, each power of two
+ * is split into 2^kSubBucketBits equal buckets, so percentiles are within
+ * 1/2^kSubBucketBits of the recorded values.
+ *
+ * add() must only be called by one thread at a time, but any thread can
+ * merge or query the histogram concurrently: counts are atomics updated
+ * without read-modify-write operations, so recording is as cheap as
+ * incrementing a plain integer.
+ */
+class LogLinearHistogram {
+ public:
+  static constexpr size_t kSubBucketBits = 4;
+  static constexpr size_t kSubBucketCount = size_t{1} << kSubBucketBits;
+  static constexpr size_t kBucketCount =
+      kSubBucketCount + (64 - kSubBucketBits) * kSubBucketCount;
+
+  LogLinearHistogram() = default;
+
+  LogLinearHistogram(const LogLinearHistogram&) = delete;
+  LogLinearHistogram& operator=(const LogLinearHistogram&) = delete;
+
+  void add(uint64_t value) noexcept {
+    auto& bucket = buckets_[getBucket(value)];
+    bucket.store(
+        bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Adds the counts of `other`, which may be concurrently added to. Unlike
+   * add(), this can be called by multiple threads if they synchronize.
+   */
+  void merge(const LogLinearHistogram& other) noexcept;
+
+  void clear() noexcept;
+
+  uint64_t getCount() const noexcept;
+
+  /**
+   * Returns the upper bound of the bucket holding the value below which
+   * `fraction` of the values fall, or 0 if the histogram is empty. For
+   * example, getPercentile(0.99) returns the p99.
+   */
+  uint64_t getPercentile(double fraction) const noexcept;
+
+  static size_t getBucket(uint64_t value) noexcept;
+  static uint64_t getBucketUpperBound(size_t bucket) noexcept;
+
+ private:
+  std::array<std::atomic<uint64_t>, kBucketCount> buckets_{};
+};
+
+} // namespace facebook::eden
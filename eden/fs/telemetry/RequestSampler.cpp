@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/RequestSampler.h"
+
+#include <fmt/format.h>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace facebook::eden {
+
+void RequestSampler::SampledRequest::appendFrame(
+    std::string& stack,
+    std::string_view frame) {
+  stack += ';';
+  for (char c : frame) {
+    // ';' separates frames, and the count follows the last space of a line.
+    switch (c) {
+      case ';':
+        stack += ',';
+        break;
+      case '\n':
+      case ' ':
+        stack += '_';
+        break;
+      default:
+        stack += c;
+        break;
+    }
+  }
+}
+
+RequestSampler::Scope::~Scope() {
+  reset();
+}
+
+RequestSampler::Scope::Scope(Scope&& that) noexcept
+    : shard_{std::exchange(that.shard_, nullptr)}, entry_{that.entry_} {}
+
+RequestSampler::Scope& RequestSampler::Scope::operator=(
+    Scope&& that) noexcept {
+  if (this != &that) {
+    reset();
+    shard_ = std::exchange(that.shard_, nullptr);
+    entry_ = that.entry_;
+  }
+  return *this;
+}
+
+void RequestSampler::Scope::reset() {
+  if (shard_) {
+    std::lock_guard lock{shard_->mutex};
+    shard_->requests.erase(entry_);
+    shard_ = nullptr;
+  }
+}
+
+RequestSampler::Scope RequestSampler::track(const SampledRequest& request) {
+  if (!isEnabled()) {
+    return Scope{};
+  }
+  auto threadHash = std::hash<std::thread::id>{}(std::this_thread::get_id());
+  auto& shard = shards_[threadHash % kShardCount];
+  std::lock_guard lock{shard.mutex};
+  return Scope{&shard, shard.requests.insert(shard.requests.end(), &request)};
+}
+
+void RequestSampler::sample() {
+  // Describe the requests first, so that the shards aren't locked while
+  // counting.
+  std::vector<std::string> sampled;
+  std::string stack;
+  for (auto& shard : shards_) {
+    std::lock_guard lock{shard.mutex};
+    for (const auto* request : shard.requests) {
+      stack.clear();
+      request->appendFrames(stack);
+      // Drop the leading separator.
+      sampled.push_back(stack.empty() ? "unknown" : stack.substr(1));
+    }
+  }
+
+  auto stacks = stacks_.lock();
+  for (auto& s : sampled) {
+    ++(*stacks)[std::move(s)];
+  }
+}
+
+std::string RequestSampler::getFoldedStacks(bool reset) {
+  std::vector<std::pair<std::string, uint64_t>> sorted;
+  {
+    auto stacks = stacks_.lock();
+    sorted.assign(stacks->begin(), stacks->end());
+    if (reset) {
+      stacks->clear();
+    }
+  }
+  std::sort(sorted.begin(), sorted.end());
+
+  std::string folded;
+  for (const auto& [stack, count] : sorted) {
+    folded += fmt::format("{} {}\n", stack, count);
+  }
+  return folded;
+}
+
+} // namespace facebook::eden
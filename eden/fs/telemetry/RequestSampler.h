@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <folly/Synchronized.h>
+
+namespace facebook::eden {
+
+/**
+ * Periodically samples the requests in flight, to tell where EdenFS spends
+ * its time without attaching a profiler.
+ *
+ * Each request describes itself as a stack of frames, such as the request
+ * type followed by why it fetched objects. Every sample counts one for the
+ * stack of each request in flight, so the counts of a stack amount to the
+ * time spent by requests in it, in units of the sampling interval, whether
+ * they were running or waiting.
+ *
+ * Requests are only tracked while sampling is enabled, and tracking one costs
+ * a list insertion under a mostly uncontended lock, like RequestMetricsScope.
+ */
+class RequestSampler {
+  struct Shard;
+
+ public:
+  /**
+   * A request that can be sampled.
+   */
+  class SampledRequest {
+   public:
+    virtual ~SampledRequest() = default;
+
+    /**
+     * Appends the frames of the request to `stack`, outermost first, each
+     * preceded by ';'. Called by the sampling thread while the request is
+     * tracked, so this must be safe to call concurrently with the request
+     * making progress, and must not block.
+     */
+    virtual void appendFrames(std::string& stack) const = 0;
+
+    /**
+     * Appends one frame, replacing the characters the folded format uses as
+     * separators.
+     */
+    static void appendFrame(std::string& stack, std::string_view frame);
+  };
+
+  /**
+   * Tracks a request until destroyed or reset.
+   */
+  class Scope {
+   public:
+    Scope() = default;
+    ~Scope();
+
+    Scope(Scope&& that) noexcept;
+    Scope& operator=(Scope&& that) noexcept;
+
+    void reset();
+
+   private:
+    using Iterator = std::list<const SampledRequest*>::iterator;
+
+    Scope(Shard* shard, Iterator entry) : shard_{shard}, entry_{entry} {}
+
+    Shard* shard_ = nullptr;
+    Iterator entry_;
+
+    friend class RequestSampler;
+  };
+
+  RequestSampler() = default;
+
+  RequestSampler(const RequestSampler&) = delete;
+  RequestSampler& operator=(const RequestSampler&) = delete;
+
+  bool isEnabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Requests started while sampling is disabled are not tracked. Disabling
+   * sampling keeps the stacks sampled so far.
+   */
+  void setEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+  }
+
+  /**
+   * Tracks `request` if sampling is enabled. The request must outlive the
+   * returned scope.
+   */
+  Scope track(const SampledRequest& request);
+
+  /**
+   * Counts one for the stack of each tracked request.
+   */
+  void sample();
+
+  /**
+   * Returns the sampled stacks in the folded format of flame graph tools:
+   * one "frame;frame;frame count" line per stack. If `reset` is set, the
+   * stacks are forgotten.
+   */
+  std::string getFoldedStacks(bool reset);
+
+ private:
+  static constexpr size_t kShardCount = 16;
+
+  // Requests are spread over shards by the thread starting them, so that
+  // threads rarely contend to track them.
+  struct Shard {
+    std::mutex mutex;
+    std::list<const SampledRequest*> requests;
+  };
+
+  std::atomic<bool> enabled_{false};
+  std::array<Shard, kShardCount> shards_;
+  folly::Synchronized<std::unordered_map<std::string, uint64_t>, std::mutex>
+      stacks_;
+};
+
+} // namespace facebook::eden
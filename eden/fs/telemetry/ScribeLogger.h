@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <folly/Function.h>
 #include <folly/Range.h>
 #include <string>
 
@@ -29,6 +30,15 @@ class ScribeLogger {
   virtual void log(std::string message) {
     return log(folly::StringPiece{message});
   }
+
+  /**
+   * Logs the message returned by `encode`. Implementations that write
+   * messages from another thread call it there, keeping the cost of building
+   * the message off the caller.
+   */
+  virtual void logDeferred(folly::Function<std::string()> encode) {
+    return log(encode());
+  }
 };
 
 } // namespace facebook::eden
@@ -34,6 +34,13 @@ ScubaStructuredLogger::ScubaStructuredLogger(
       scribeLogger_{std::move(scribeLogger)} {}
 
 void ScubaStructuredLogger::logDynamicEvent(DynamicEvent event) {
+  // Encoding the event is left to the scribe logger's writer thread, if it
+  // has one, so that logging doesn't slow down the request that logged it.
+  scribeLogger_->logDeferred(
+      [event = std::move(event)] { return encode(event); });
+}
+
+std::string ScubaStructuredLogger::encode(const DynamicEvent& event) {
   folly::dynamic document = folly::dynamic::object;
 
   const auto& intMap = event.getIntMap();
@@ -51,7 +58,7 @@ void ScubaStructuredLogger::logDynamicEvent(DynamicEvent event) {
     document["double"] = dynamicMap(doubleMap);
   }
 
-  scribeLogger_->log(folly::toJson(document));
+  return folly::toJson(document);
 }
 
 } // namespace facebook::eden
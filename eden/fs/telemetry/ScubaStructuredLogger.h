@@ -24,6 +24,8 @@ class ScubaStructuredLogger final : public StructuredLogger {
  private:
   void logDynamicEvent(DynamicEvent event) override;
 
+  static std::string encode(const DynamicEvent& event);
+
   std::shared_ptr<ScribeLogger> scribeLogger_;
 };
 
@@ -7,6 +7,10 @@
 
 #include "eden/fs/telemetry/SubprocessScribeLogger.h"
 
+#include <algorithm>
+#include <vector>
+
+#include <folly/ExceptionString.h>
 #include <folly/logging/xlog.h>
 #include <folly/system/ThreadName.h>
 
@@ -17,6 +21,18 @@ namespace {
  */
 constexpr size_t kQueueLimitBytes = 128 * 1024;
 
+/**
+ * Bounds the number of queued messages, whose deferred encodings aren't
+ * accounted for in kQueueLimitBytes.
+ */
+constexpr size_t kQueueLimitMessages = 1024;
+
+/**
+ * The messages written by each writev call, well under IOV_MAX with their
+ * newlines.
+ */
+constexpr size_t kMaxMessagesPerWrite = 64;
+
 constexpr std::chrono::seconds kFlushTimeout{1};
 constexpr std::chrono::seconds kProcessExitTimeout{1};
 constexpr std::chrono::seconds kProcessTerminateTimeout{1};
@@ -88,7 +104,16 @@ void SubprocessScribeLogger::closeProcess() {
 }
 
 void SubprocessScribeLogger::log(std::string message) {
-  size_t messageSize = message.size();
+  enqueue(Message{std::move(message), nullptr});
+}
+
+void SubprocessScribeLogger::logDeferred(
+    folly::Function<std::string()> encode) {
+  enqueue(Message{std::string{}, std::move(encode)});
+}
+
+void SubprocessScribeLogger::enqueue(Message message) {
+  size_t messageSize = message.encoded.size();
 
   {
     auto state = state_.lock();
@@ -96,12 +121,28 @@ void SubprocessScribeLogger::log(std::string message) {
     if (state->didStop) {
       return;
     }
-    if (state->totalBytes + messageSize > kQueueLimitBytes) {
-      XLOG_EVERY_MS(DBG7, 10000) << "ScribeLogger queue full, dropping message";
-      // queue full, dropping!
+    if (messageSize > kQueueLimitBytes) {
+      state->droppedMessages++;
       return;
     }
 
+    // Make room by dropping the oldest messages, which are the least
+    // relevant to the current state of the daemon.
+    size_t dropped = 0;
+    while (!state->messages.empty() &&
+           (state->totalBytes + messageSize > kQueueLimitBytes ||
+            state->messages.size() >= kQueueLimitMessages)) {
+      state->totalBytes -= state->messages.front().encoded.size();
+      state->messages.pop_front();
+      dropped++;
+    }
+    if (dropped) {
+      state->droppedMessages += dropped;
+      XLOG_EVERY_MS(DBG7, 10000)
+          << "ScribeLogger queue full, dropped " << state->droppedMessages
+          << " messages so far";
+    }
+
     // This order is important in order to be atomic under std::bad_alloc.
     state->messages.emplace_back(std::move(message));
     state->totalBytes += messageSize;
@@ -109,11 +150,13 @@ void SubprocessScribeLogger::log(std::string message) {
   newMessageOrStop_.notify_one();
 }
 
-void SubprocessScribeLogger::writerThread() {
-  auto fd = process_.stdinFd();
+uint64_t SubprocessScribeLogger::getDroppedMessageCount() const {
+  return state_.lock()->droppedMessages;
+}
 
+void SubprocessScribeLogger::writerThread() {
   for (;;) {
-    std::string message;
+    std::deque<Message> messages;
 
     {
       auto state = state_.lock();
@@ -121,13 +164,10 @@ void SubprocessScribeLogger::writerThread() {
         return state->shouldStop || !state->messages.empty();
       });
       if (!state->messages.empty()) {
-        XCHECK_LE(state->messages.front().size(), state->totalBytes)
-            << "totalSize accounting fell out of sync!";
-
-        // The below statements are all noexcept.
-        std::swap(message, state->messages.front());
-        state->messages.pop_front();
-        state->totalBytes -= message.size();
+        // Take the whole queue, so that it is written in batches and the
+        // callers aren't blocked while the messages are encoded.
+        std::swap(messages, state->messages);
+        state->totalBytes = 0;
       } else {
         // If the predicate succeeded but we have no messages, then we're
         // shutting down cleanly.
@@ -141,13 +181,7 @@ void SubprocessScribeLogger::writerThread() {
       }
     }
 
-    char newline = '\n';
-    std::array<iovec, 2> iov;
-    iov[0].iov_base = message.data();
-    iov[0].iov_len = message.size();
-    iov[1].iov_base = &newline;
-    iov[1].iov_len = sizeof(newline);
-    if (fd.writevFull(iov.data(), iov.size()).hasException()) {
+    if (!writeMessages(messages)) {
       // TODO: We could attempt to restart the process here.
       XLOG(ERR) << "Failed to writev to logger process stdin: "
                 << folly::errnoStr(errno) << ". Giving up!";
@@ -164,4 +198,34 @@ void SubprocessScribeLogger::writerThread() {
   }
 }
 
+bool SubprocessScribeLogger::writeMessages(std::deque<Message>& messages) {
+  auto fd = process_.stdinFd();
+  char newline = '\n';
+  std::vector<iovec> iov;
+  iov.reserve(2 * std::min(messages.size(), kMaxMessagesPerWrite));
+
+  auto it = messages.begin();
+  while (it != messages.end()) {
+    iov.clear();
+    for (size_t i = 0; i < kMaxMessagesPerWrite && it != messages.end();
+         ++i, ++it) {
+      if (it->encode) {
+        try {
+          it->encoded = it->encode();
+        } catch (const std::exception& ex) {
+          XLOG_EVERY_MS(ERR, 10000)
+              << "Failed to encode a log message: " << folly::exceptionStr(ex);
+          continue;
+        }
+      }
+      iov.push_back({it->encoded.data(), it->encoded.size()});
+      iov.push_back({&newline, sizeof(newline)});
+    }
+    if (fd.writevFull(iov.data(), iov.size()).hasException()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 } // namespace facebook::eden
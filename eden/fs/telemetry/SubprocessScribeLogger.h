@@ -8,7 +8,7 @@
 #pragma once
 
 #include <folly/Synchronized.h>
-#include <list>
+#include <deque>
 #include "eden/fs/telemetry/ScribeLogger.h"
 #include "eden/fs/utils/SpawnedProcess.h"
 
@@ -17,6 +17,12 @@ namespace facebook::eden {
 /**
  * SubprocessScribeLogger manages an external unix process and asynchronously
  * forwards newline-delimited messages to its stdin.
+ *
+ * Messages are queued by the callers and written by a dedicated thread, which
+ * takes all the queued messages at once, encodes the deferred ones, and
+ * writes them with as few writev calls as possible. The queue is bounded:
+ * when it is full the oldest messages are dropped, so that the newest ones
+ * describe the current state of the daemon.
  */
 class SubprocessScribeLogger : public ScribeLogger {
  public:
@@ -45,23 +51,53 @@ class SubprocessScribeLogger : public ScribeLogger {
    * Forwards a log message to the external process. Must not contain newlines,
    * since that is how the process distinguishes between messages.
    *
-   * If the writer process is not keeping up, messages are dropped.
+   * If the writer process is not keeping up, the oldest messages are
+   * dropped.
    */
   void log(std::string message) override;
   using ScribeLogger::log;
 
+  /**
+   * Queues a message encoded on the writer thread, right before it is
+   * written.
+   */
+  void logDeferred(folly::Function<std::string()> encode) override;
+
+  /**
+   * The number of messages dropped since the logger was created, because the
+   * queue was full or the message larger than it.
+   */
+  uint64_t getDroppedMessageCount() const;
+
  private:
+  /**
+   * A queued message, either already encoded or encoded by the writer
+   * thread.
+   */
+  struct Message {
+    std::string encoded;
+    folly::Function<std::string()> encode;
+  };
+
   void closeProcess();
   void writerThread();
+  void enqueue(Message message);
+
+  /**
+   * Writes the messages, each followed by a newline. Returns false if the
+   * process can't be written to anymore.
+   */
+  bool writeMessages(std::deque<Message>& messages);
 
   struct State {
     bool shouldStop = false;
     bool didStop = false;
 
-    /// Sum of sizes of queued messages.
+    /// Sum of sizes of queued messages that are already encoded.
     size_t totalBytes = 0;
     /// Invariant: empty if didStop is true
-    std::list<std::string> messages;
+    std::deque<Message> messages;
+    uint64_t droppedMessages = 0;
   };
 
   SpawnedProcess process_;
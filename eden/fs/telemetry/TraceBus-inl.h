@@ -7,6 +7,8 @@
 
 #include <folly/logging/xlog.h>
 #include <folly/system/ThreadName.h>
+#include <algorithm>
+#include <limits>
 
 namespace facebook::eden {
 
@@ -25,8 +27,8 @@ TraceBus<TraceEvent>::TraceBus(
     size_t bufferCapacity)
     : name_{std::move(name)}, bufferCapacity_{bufferCapacity} {
   XCHECK_GT(bufferCapacity_, 0u) << "Buffer capacity must not be zero";
-
-  state_.unsafeGetUnlocked().writeBuffer.reserve(bufferCapacity_);
+  XCHECK_LT(bufferCapacity_, std::numeric_limits<uint32_t>::max())
+      << "Buffer capacity is too large";
 
   // Allocate the backbuffer here rather than in the thread so std::bad_alloc
   // can be caught.
@@ -45,8 +47,11 @@ TraceBus<TraceEvent>::TraceBus(
 
 template <typename TraceEvent>
 TraceBus<TraceEvent>::~TraceBus() {
-  state_.lock()->done = true;
-  emptyCV_.notify_one();
+  {
+    std::lock_guard lock{idleMutex_};
+    done_.store(true);
+  }
+  idleCV_.notify_one();
   thread_.join();
 
   auto& state = state_.unsafeGetUnlocked();
@@ -58,6 +63,21 @@ TraceBus<TraceEvent>::~TraceBus() {
   }
 }
 
+template <typename TraceEvent>
+TraceBus<TraceEvent>::Producer::Producer(
+    size_t capacity,
+    std::string threadName)
+    // One slot of a ProducerConsumerQueue is always left empty.
+    : queue{static_cast<uint32_t>(capacity + 1)},
+      threadName{std::move(threadName)} {}
+
+template <typename TraceEvent>
+TraceBus<TraceEvent>::LocalProducer::~LocalProducer() {
+  if (producer) {
+    producer->exited.store(true);
+  }
+}
+
 template <typename TraceEvent>
 void TraceBus<TraceEvent>::publish(const TraceEvent& event) noexcept {
   static_assert(std::is_nothrow_copy_constructible_v<TraceEvent>);
@@ -67,27 +87,79 @@ void TraceBus<TraceEvent>::publish(const TraceEvent& event) noexcept {
 template <typename TraceEvent>
 void TraceBus<TraceEvent>::publish(TraceEvent&& event) noexcept {
   static_assert(std::is_nothrow_move_constructible_v<TraceEvent>);
+  XCHECK(!done_.load(std::memory_order_relaxed))
+      << "Illegal to publish concurrently with destruction";
 
-  bool wake;
-  {
+  auto& producer = getProducer();
+  if (producer.queue.isFull()) {
+    // If the buffer is full then the capacity is potentially set too low. Log
+    // an appropriate warning and then block until we have room to append the
+    // current event.
+    logFullOnce();
+    producer.blocked.store(
+        producer.blocked.load(std::memory_order_relaxed) + 1,
+        std::memory_order_relaxed);
+    waitForSpace(producer);
+  }
+
+  // Only this thread appends to the queue, so the room found above is still
+  // there. The background thread observes the events by sequence number,
+  // which keeps them in the order they were published across threads.
+  auto sequenceNumber = nextSequenceNumber_.fetch_add(1);
+  bool written = producer.queue.write(sequenceNumber, std::move(event));
+  XDCHECK(written);
+  producer.published.store(
+      producer.published.load(std::memory_order_relaxed) + 1,
+      std::memory_order_relaxed);
+
+  // The background thread sets idle_ before checking nextSequenceNumber_, so
+  // either it sees the event above or we see it idle.
+  if (idle_.load()) {
+    { std::lock_guard lock{idleMutex_}; }
+    idleCV_.notify_one();
+  }
+}
+
+template <typename TraceEvent>
+typename TraceBus<TraceEvent>::Producer&
+TraceBus<TraceEvent>::getProducer() noexcept {
+  auto& local = *localProducer_;
+  if (FOLLY_UNLIKELY(!local.producer)) {
+    // Publishing threads are long-lived, so this only allocates on their
+    // first publish.
+    local.producer = std::make_shared<Producer>(
+        bufferCapacity_, folly::getCurrentThreadName().value_or(""));
     auto state = state_.lock();
-    XCHECK(!state->done) << "Illegal to publish concurrently with destruction";
-    if (state->writeBuffer.size() == bufferCapacity_) {
-      // If the buffer is full then the capacity is potentially set too low. Log
-      // an appropriate warning and then block until we have room to append the
-      // current event.
-      logFullOnce();
-      fullCV_.wait(state.as_lock(), [&] {
-        return state->writeBuffer.size() < bufferCapacity_;
-      });
-    }
-    wake = state->writeBuffer.empty();
-    state->writeBuffer.push_back(std::move(event));
-    state->sequenceNumber++;
+    state->producers.push_back(local.producer);
+    state->producersVersion++;
   }
-  if (wake) {
-    emptyCV_.notify_one();
+  return *local.producer;
+}
+
+template <typename TraceEvent>
+void TraceBus<TraceEvent>::waitForSpace(Producer& producer) noexcept {
+  std::unique_lock lock{producer.mutex};
+  producer.waitingForSpace.store(true);
+  // Pairs with the fence in threadLoop, so either it sees waitingForSpace or
+  // we see the room it made.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  producer.notFullCV.wait(lock, [&] { return !producer.queue.isFull(); });
+  producer.waitingForSpace.store(false);
+}
+
+template <typename TraceEvent>
+std::vector<TraceBusProducerStats> TraceBus<TraceEvent>::getProducerStats()
+    const {
+  std::vector<TraceBusProducerStats> stats;
+  auto state = state_.lock();
+  stats.reserve(state->producers.size());
+  for (const auto& producer : state->producers) {
+    stats.push_back(TraceBusProducerStats{
+        producer->threadName,
+        producer->published.load(std::memory_order_relaxed),
+        producer->blocked.load(std::memory_order_relaxed)});
   }
+  return stats;
 }
 
 template <typename TraceEvent>
@@ -108,7 +180,7 @@ void TraceBus<TraceEvent>::unsubscribe(void* subscription) noexcept {
 
   auto state = state_.lock();
   // Signal to threadLoop that `sub` should be deleted.
-  sub->unsubscribe = state->sequenceNumber;
+  sub->unsubscribe = nextSequenceNumber_.load();
 
   // At this point, the memory referenced by `sub` must not be accessed as it
   // may be deleted at any moment.
@@ -118,12 +190,13 @@ template <typename TraceEvent>
 void TraceBus<TraceEvent>::logFullOnce() noexcept {
   folly::call_once(logIfFullFlag_, [&]() noexcept {
     try {
-      XLOG(WARN) << "TraceBus(" << name_ << ") is full; blocking. Is capacity "
+      XLOG(WARN) << "TraceBus(" << name_
+                 << ") buffer is full; blocking. Is capacity "
                  << bufferCapacity_ << " sufficient?";
     } catch (std::exception& e) {
       fprintf(
           stderr,
-          "TraceBus(%s) is full; blocking. Is capacity %" PRIu64
+          "TraceBus(%s) buffer is full; blocking. Is capacity %" PRIu64
           "sufficient?\n"
           "Logging failed with %s\n",
           name_.c_str(),
@@ -137,11 +210,15 @@ void TraceBus<TraceEvent>::logFullOnce() noexcept {
 template <typename TraceEvent>
 void TraceBus<TraceEvent>::threadLoop(
     std::vector<TraceEvent>& readBuffer) noexcept {
-  // This function does no allocation and throws no exceptions.
+  // This function only allocates when publishing threads come and go, and
+  // throws no exceptions.
 
-  bool done = false;
+  std::vector<std::shared_ptr<Producer>> producers;
+  uint64_t producersVersion = 0;
+  // The sequence number of the next event to observe.
+  uint64_t nextSequenceNumber = 1;
   uint64_t lastObservedSequenceNumber = 0;
-  while (!done) {
+  while (true) {
     XCHECK(readBuffer.empty())
         << "Avoid waiting while holding references to things";
 
@@ -149,7 +226,6 @@ void TraceBus<TraceEvent>::threadLoop(
     {
       auto state = state_.lock();
 
-      // Deallocate before we wait.
       // While the lock is held, delete all unsubscribed subscriptions.
       // plink is pointer to current node pointer.
       // nlink is pointer to next node pointer.
@@ -173,29 +249,87 @@ void TraceBus<TraceEvent>::threadLoop(
         p = next;
       }
 
+      // Forget the producers of exited threads once drained. Nothing can be
+      // appended to them anymore.
+      auto& all = state->producers;
+      auto exited =
+          std::remove_if(all.begin(), all.end(), [](const auto& producer) {
+            return producer->exited.load() && producer->queue.isEmpty();
+          });
+      if (exited != all.end()) {
+        all.erase(exited, all.end());
+        state->producersVersion++;
+      }
+      if (producersVersion != state->producersVersion) {
+        producers = all;
+        producersVersion = state->producersVersion;
+      }
+
       // TODO: If it were safe to access Subscription::unsubscribe when the lock
       // weren't held, it would be possible to check the unsubscribe sequence
       // number in the event iteration loop below and short-circuit observation
       // of events published after unsubscription.
       //
       // This probably isn't important.
-      lastObservedSequenceNumber = state->sequenceNumber;
-
-      // If no events are buffered, sleep until events are delivered or we are
-      // signaled to terminate.
-      emptyCV_.wait(state.as_lock(), [&] {
-        return state->done || !state->writeBuffer.empty();
-      });
-      std::swap(state->writeBuffer, readBuffer);
-      done = state->done;
+      lastObservedSequenceNumber = nextSequenceNumber_.load();
 
       head = state->subscriptions;
     }
 
-    // If the publish buffer filled, it's possible a publisher is waiting for
-    // space, so wake them.
-    if (readBuffer.size() == bufferCapacity_) {
-      fullCV_.notify_all();
+    // Take the events in sequence order. Each queue is sorted, so the next
+    // event is at the front of one of them, usually the same as the last one.
+    size_t current = 0;
+    while (readBuffer.size() < bufferCapacity_ && !producers.empty()) {
+      Entry* entry = producers[current]->queue.frontPtr();
+      if (!entry || entry->sequenceNumber != nextSequenceNumber) {
+        entry = nullptr;
+        for (size_t i = 0; i < producers.size(); ++i) {
+          auto* front = producers[i]->queue.frontPtr();
+          if (front && front->sequenceNumber == nextSequenceNumber) {
+            current = i;
+            entry = front;
+            break;
+          }
+        }
+        if (!entry) {
+          break;
+        }
+      }
+
+      auto& producer = *producers[current];
+      readBuffer.push_back(std::move(entry->event));
+      producer.queue.popFront();
+      ++nextSequenceNumber;
+
+      // If the queue was full, its publisher may be waiting for space, so
+      // wake it.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (producer.waitingForSpace.load()) {
+        { std::lock_guard lock{producer.mutex}; }
+        producer.notFullCV.notify_one();
+      }
+    }
+
+    if (readBuffer.empty()) {
+      if (nextSequenceNumber_.load() != nextSequenceNumber) {
+        // The next event is being appended to its queue, possibly by a thread
+        // that registered after `producers` was copied.
+        std::this_thread::yield();
+        continue;
+      }
+      if (done_.load()) {
+        break;
+      }
+
+      // If no events are buffered, sleep until events are published or we
+      // are signaled to terminate.
+      std::unique_lock lock{idleMutex_};
+      idle_.store(true);
+      idleCV_.wait(lock, [&] {
+        return done_.load() || nextSequenceNumber_.load() != nextSequenceNumber;
+      });
+      idle_.store(false);
+      continue;
     }
 
     for (auto* sub = head; sub; sub = sub->next) {
@@ -7,13 +7,20 @@
 
 #pragma once
 
+#include <folly/ProducerConsumerQueue.h>
 #include <folly/Synchronized.h>
+#include <folly/ThreadLocal.h>
 #include <folly/synchronization/CallOnce.h>
 #include <stdint.h>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
 #include <utility>
+#include <vector>
 
 namespace facebook::eden {
 
@@ -136,12 +143,31 @@ class TraceSubscriptionHandle {
   friend TraceBus<TraceEvent>;
 };
 
+/**
+ * Counters of one thread publishing to a TraceBus.
+ */
+struct TraceBusProducerStats {
+  std::string threadName;
+  /** Number of events the thread published. */
+  uint64_t published = 0;
+  /**
+   * Number of those events that found the thread's buffer full, and had to
+   * wait for the background thread to drain it. A lossy bus would have
+   * dropped them.
+   */
+  uint64_t blocked = 0;
+};
+
 /**
  * TraceBus is a reliable, fixed-capacity event trace that runs subscription
  * callbacks on a background thread. It is intended for lightweight telemetry
  * computation: if the subscriptions perform heavy computation and events are
  * submitted more frequently than they're processed, publish() will block.
  *
+ * Each publishing thread appends to its own single-producer single-consumer
+ * buffer, drained by the background thread, so publishers don't contend on a
+ * lock. They only share the counter ordering the events.
+ *
  * Note: this blocking behavior then waits for subscribers to finish processing
  * events, and if any locks are held that are subsequently attempted to be
  * acquired by a tracebus subscriber, this can cause a deadlock. As a general
@@ -149,10 +175,11 @@ class TraceSubscriptionHandle {
  * and should be very careful when subscribers attempt to acquire locks.
  *
  * The capacity should be selected based on the expected usage in context.
- * Memory usage will be capacity * sizeof(TraceEvent) * 2, but a capacity too
- * small will block publishers. The buffer is not intended to prevent all
- * publishers from blocking, but to absorb latency in the case that subscribers
- * briefly cannot keep up.
+ * Memory usage will be capacity * sizeof(TraceEvent) per publishing thread,
+ * plus as much for the batch handed to subscribers, but a capacity too small
+ * will block publishers. The buffer is not intended to prevent all publishers
+ * from blocking, but to absorb latency in the case that subscribers briefly
+ * cannot keep up.
  *
  * Ideally, capacity would be dynamically determined with algorithms similar to
  * network protocols, but a small fixed-size buffer should be sufficient.
@@ -206,6 +233,12 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
    */
   void publish(TraceEvent&& event) noexcept;
 
+  /**
+   * Returns the counters of the threads that published to this bus, except
+   * the exited ones whose events were all observed.
+   */
+  std::vector<TraceBusProducerStats> getProducerStats() const;
+
   /**
    * Subscribe to published events. If the subscriber throws, it will
    * automatically be unsubscribed.
@@ -270,22 +303,77 @@ class TraceBus : public std::enable_shared_from_this<TraceBus<TraceEvent>> {
     Subscription* next = nullptr;
   };
 
+  struct Entry {
+    Entry(uint64_t sequence, TraceEvent&& ev) noexcept
+        : sequenceNumber{sequence}, event{std::move(ev)} {}
+
+    uint64_t sequenceNumber;
+    TraceEvent event;
+  };
+
+  /**
+   * The buffer of one publishing thread. Entries are appended by that thread
+   * only, and removed by the background thread only.
+   */
+  struct Producer {
+    Producer(size_t capacity, std::string threadName);
+
+    folly::ProducerConsumerQueue<Entry> queue;
+    const std::string threadName;
+
+    // Written by the publishing thread, read by getProducerStats().
+    std::atomic<uint64_t> published{0};
+    std::atomic<uint64_t> blocked{0};
+
+    // Set once the publishing thread exited, after which nothing is appended.
+    std::atomic<bool> exited{false};
+
+    // Used by the publishing thread to wait for room in a full queue.
+    std::mutex mutex;
+    std::condition_variable notFullCV;
+    std::atomic<bool> waitingForSpace{false};
+  };
+
+  /**
+   * The thread-local reference to the Producer of the current thread. The
+   * State keeps the Producer alive until its events were all observed.
+   */
+  struct LocalProducer {
+    ~LocalProducer();
+
+    std::shared_ptr<Producer> producer;
+  };
+
   struct State {
-    bool done = false;
     Subscription* subscriptions = nullptr;
-    std::vector<TraceEvent> writeBuffer;
-    // Incremented every publish()
-    uint64_t sequenceNumber = 1;
+    std::vector<std::shared_ptr<Producer>> producers;
+    // Incremented whenever `producers` changes.
+    uint64_t producersVersion = 0;
   };
 
+  /**
+   * Returns the Producer of the calling thread, registering it on the first
+   * publish.
+   */
+  Producer& getProducer() noexcept;
+
+  void waitForSpace(Producer& producer) noexcept;
+
   const std::string name_;
   const size_t bufferCapacity_;
 
-  folly::Synchronized<State, std::mutex> state_;
-  // Encodes the condition done || !writeBuffer.empty()
-  std::condition_variable emptyCV_;
-  // Encodes the condition writeBuffer.size() < bufferCapacity_
-  std::condition_variable fullCV_;
+  mutable folly::Synchronized<State, std::mutex> state_;
+  // The sequence number of the next published event, starting at 1.
+  std::atomic<uint64_t> nextSequenceNumber_{1};
+  std::atomic<bool> done_{false};
+
+  // Used by the background thread to wait for events to be published.
+  std::mutex idleMutex_;
+  // Encodes the condition done_ || an event was published
+  std::condition_variable idleCV_;
+  std::atomic<bool> idle_{false};
+
+  folly::ThreadLocal<LocalProducer> localProducer_;
   folly::once_flag logIfFullFlag_;
   std::thread thread_;
 
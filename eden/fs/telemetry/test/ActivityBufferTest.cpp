@@ -6,6 +6,8 @@
  */
 
 #include "eden/fs/telemetry/ActivityBuffer.h"
+
+#include <fmt/format.h>
 #include <folly/portability/GTest.h>
 
 using namespace facebook::eden;
@@ -63,3 +65,83 @@ TEST(ActivityBufferTest, add_exceed_capacity) {
     EXPECT_TRUE(buffer_contains_int(buff, i));
   }
 }
+
+namespace {
+
+/** An event whose encoding is as large as its path. */
+struct PathEvent {
+  std::string path;
+};
+
+} // namespace
+
+namespace facebook::eden {
+template <>
+struct ActivityBufferCodec<PathEvent> {
+  static void encode(const PathEvent& event, std::string& out) {
+    out.append(event.path);
+  }
+
+  static PathEvent decode(folly::ByteRange in) {
+    return PathEvent{std::string{folly::StringPiece{in}}};
+  }
+};
+} // namespace facebook::eden
+
+namespace {
+
+std::vector<std::string> getPaths(const ActivityBuffer<PathEvent>& buff) {
+  std::vector<std::string> paths;
+  buff.forEachEvent(
+      [&](const PathEvent& event) { paths.push_back(event.path); });
+  return paths;
+}
+
+// Each record holds its size before the encoding.
+constexpr size_t kRecordBytes = sizeof(uint32_t) + 10;
+
+} // namespace
+
+TEST(ActivityBufferTest, used_bytes_accounts_for_each_record) {
+  ActivityBuffer<int> buff(kMaxBufLength);
+  EXPECT_EQ(0, buff.getUsedBytes());
+  buff.addEvent(1);
+  buff.addEvent(2);
+  EXPECT_EQ(2 * (sizeof(uint32_t) + sizeof(int)), buff.getUsedBytes());
+}
+
+TEST(ActivityBufferTest, oldest_events_are_evicted_past_max_bytes) {
+  ActivityBuffer<PathEvent> buff(kMaxBufLength, 3 * kRecordBytes);
+  for (int i = 0; i < 5; i++) {
+    buff.addEvent(PathEvent{fmt::format("path/file{}", i)});
+  }
+
+  EXPECT_EQ(
+      (std::vector<std::string>{"path/file2", "path/file3", "path/file4"}),
+      getPaths(buff));
+  EXPECT_EQ(3 * kRecordBytes, buff.getUsedBytes());
+}
+
+TEST(ActivityBufferTest, events_of_varying_sizes_wrap_around_in_order) {
+  ActivityBuffer<PathEvent> buff(kMaxBufLength, 4 * kRecordBytes);
+  std::vector<std::string> added;
+  for (int i = 0; i < 50; i++) {
+    added.push_back(std::string(i % 3 == 0 ? 20 : 5, 'a' + i % 26));
+    buff.addEvent(PathEvent{added.back()});
+
+    auto paths = getPaths(buff);
+    ASSERT_FALSE(paths.empty());
+    EXPECT_LE(buff.getUsedBytes(), 4 * kRecordBytes);
+    // The stored events are always the most recent ones, oldest first.
+    EXPECT_TRUE(
+        std::equal(paths.begin(), paths.end(), added.end() - paths.size()));
+  }
+}
+
+TEST(ActivityBufferTest, events_larger_than_max_bytes_are_dropped) {
+  ActivityBuffer<PathEvent> buff(kMaxBufLength, 2 * kRecordBytes);
+  buff.addEvent(PathEvent{"path/file0"});
+  buff.addEvent(PathEvent{std::string(2 * kRecordBytes, 'a')});
+
+  EXPECT_EQ((std::vector<std::string>{"path/file0"}), getPaths(buff));
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/LogLinearHistogram.h"
+
+#include <fb303/ServiceData.h>
+#include <folly/portability/GTest.h>
+#include <limits>
+#include <thread>
+#include <vector>
+
+#include "eden/fs/telemetry/EdenStats.h"
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+namespace {
+
+/** Percentiles are within 1/16 of the recorded values. */
+void expectNear(uint64_t expected, uint64_t actual) {
+  EXPECT_LE(expected, actual);
+  EXPECT_GE(expected + expected / 16, actual);
+}
+
+} // namespace
+
+TEST(LogLinearHistogramTest, buckets_hold_their_values) {
+  std::vector<uint64_t> values{
+      0, 1, 15, 16, 17, 1000, 123456789, uint64_t{1} << 63};
+  for (auto value : values) {
+    auto bucket = LogLinearHistogram::getBucket(value);
+    EXPECT_LE(value, LogLinearHistogram::getBucketUpperBound(bucket));
+    if (bucket > 0) {
+      EXPECT_GT(value, LogLinearHistogram::getBucketUpperBound(bucket - 1));
+    }
+  }
+  EXPECT_EQ(
+      LogLinearHistogram::kBucketCount - 1,
+      LogLinearHistogram::getBucket(std::numeric_limits<uint64_t>::max()));
+  EXPECT_EQ(
+      std::numeric_limits<uint64_t>::max(),
+      LogLinearHistogram::getBucketUpperBound(
+          LogLinearHistogram::kBucketCount - 1));
+}
+
+TEST(LogLinearHistogramTest, empty_histogram_has_no_percentiles) {
+  LogLinearHistogram histogram;
+  EXPECT_EQ(0, histogram.getCount());
+  EXPECT_EQ(0, histogram.getPercentile(0.5));
+}
+
+TEST(LogLinearHistogramTest, percentiles) {
+  LogLinearHistogram histogram;
+  for (uint64_t i = 1; i <= 10000; ++i) {
+    histogram.add(i);
+  }
+  EXPECT_EQ(10000, histogram.getCount());
+  expectNear(5000, histogram.getPercentile(0.5));
+  expectNear(9000, histogram.getPercentile(0.9));
+  expectNear(9900, histogram.getPercentile(0.99));
+  expectNear(9990, histogram.getPercentile(0.999));
+  EXPECT_EQ(1, histogram.getPercentile(0));
+}
+
+TEST(LogLinearHistogramTest, merge_adds_counts) {
+  LogLinearHistogram low;
+  LogLinearHistogram high;
+  for (int i = 0; i < 100; ++i) {
+    low.add(10);
+    high.add(1000);
+  }
+
+  LogLinearHistogram merged;
+  merged.merge(low);
+  merged.merge(high);
+  EXPECT_EQ(200, merged.getCount());
+  EXPECT_EQ(10, merged.getPercentile(0.5));
+  expectNear(1000, merged.getPercentile(0.51));
+
+  merged.clear();
+  EXPECT_EQ(0, merged.getCount());
+}
+
+TEST(LogLinearHistogramTest, durations_export_merged_percentiles) {
+  {
+    // Recorded by a thread that exits before the counters are read.
+    std::thread thread{[] {
+      StatsGroupBase::Duration duration{"test.histogram_us"};
+      for (int i = 0; i < 90; ++i) {
+        duration.addDuration(10us);
+      }
+    }};
+    thread.join();
+  }
+  StatsGroupBase::Duration duration{"test.histogram_us"};
+  for (int i = 0; i < 10; ++i) {
+    duration.addDuration(1ms);
+  }
+
+  auto counters = fb303::ServiceData::get()->getCounters();
+  EXPECT_EQ(10, counters["test.histogram_us.lifetime.p50"]);
+  EXPECT_EQ(10, counters["test.histogram_us.lifetime.p90"]);
+  expectNear(1000, counters["test.histogram_us.lifetime.p99"]);
+  expectNear(1000, counters["test.histogram_us.lifetime.p999"]);
+}
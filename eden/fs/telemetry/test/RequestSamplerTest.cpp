@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/telemetry/RequestSampler.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+namespace {
+
+class FakeRequest : public RequestSampler::SampledRequest {
+ public:
+  FakeRequest(std::string_view request, std::string_view detail)
+      : request_{request}, detail_{detail} {}
+
+  void appendFrames(std::string& stack) const override {
+    appendFrame(stack, request_);
+    appendFrame(stack, detail_);
+  }
+
+ private:
+  std::string_view request_;
+  std::string_view detail_;
+};
+
+} // namespace
+
+TEST(RequestSamplerTest, requests_are_not_tracked_while_disabled) {
+  RequestSampler sampler;
+  FakeRequest request{"fuse.read", "FUSE_READ"};
+  auto scope = sampler.track(request);
+
+  sampler.setEnabled(true);
+  sampler.sample();
+  EXPECT_EQ("", sampler.getFoldedStacks(false));
+}
+
+TEST(RequestSamplerTest, samples_count_requests_in_flight) {
+  RequestSampler sampler;
+  sampler.setEnabled(true);
+  FakeRequest read{"fuse.read", "FUSE_READ"};
+  FakeRequest status{"thrift", "getScmStatusV2"};
+
+  auto readScope = sampler.track(read);
+  {
+    auto statusScope = sampler.track(status);
+    sampler.sample();
+  }
+  sampler.sample();
+
+  EXPECT_EQ(
+      "fuse.read;FUSE_READ 2\n"
+      "thrift;getScmStatusV2 1\n",
+      sampler.getFoldedStacks(true));
+  EXPECT_EQ("", sampler.getFoldedStacks(false));
+
+  readScope.reset();
+  sampler.sample();
+  EXPECT_EQ("", sampler.getFoldedStacks(false));
+}
+
+TEST(RequestSamplerTest, frames_escape_separators) {
+  RequestSampler sampler;
+  sampler.setEnabled(true);
+  FakeRequest request{"thrift", "a;b c"};
+  auto scope = sampler.track(request);
+  sampler.sample();
+
+  EXPECT_EQ("thrift;a,b_c 1\n", sampler.getFoldedStacks(false));
+}
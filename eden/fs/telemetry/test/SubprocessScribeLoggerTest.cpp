@@ -31,3 +31,39 @@ TEST(ScribeLogger, log_messages_are_written_with_newlines) {
   folly::readFile(output.fd(), contents);
   EXPECT_EQ("foo\nbar\n", contents);
 }
+
+TEST(ScribeLogger, deferred_messages_are_written_in_order) {
+  folly::test::TemporaryFile output;
+
+  {
+    SubprocessScribeLogger logger{
+        std::vector<std::string>{"/bin/cat"},
+        FileDescriptor(
+            ::dup(output.fd()), "dup", FileDescriptor::FDType::Generic)};
+    logger.log("foo"_sp);
+    logger.logDeferred([] { return std::string{"bar"}; });
+    logger.logDeferred([]() -> std::string { throw std::runtime_error{"x"}; });
+    logger.log("baz"_sp);
+  }
+
+  folly::checkUnixError(lseek(output.fd(), 0, SEEK_SET));
+  std::string contents;
+  folly::readFile(output.fd(), contents);
+  EXPECT_EQ("foo\nbar\nbaz\n", contents);
+}
+
+TEST(ScribeLogger, messages_are_dropped_when_the_process_falls_behind) {
+  // The process never reads its input, so once the pipe is full the queue
+  // fills up too.
+  SubprocessScribeLogger logger{std::vector<std::string>{"/bin/sleep", "10"}};
+  std::string message(1024, 'a');
+  for (int i = 0; i < 1024; i++) {
+    logger.log(message);
+  }
+  EXPECT_GT(logger.getDroppedMessageCount(), 0);
+
+  logger.log(std::string(1024 * 1024, 'a'));
+  auto dropped = logger.getDroppedMessageCount();
+  logger.log(std::string(1024 * 1024, 'a'));
+  EXPECT_EQ(dropped + 1, logger.getDroppedMessageCount());
+}
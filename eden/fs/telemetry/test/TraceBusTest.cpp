@@ -8,6 +8,8 @@
 #include "eden/fs/telemetry/TraceBus.h"
 #include <folly/futures/Promise.h>
 #include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+#include <thread>
 
 using namespace std::literals;
 using namespace facebook::eden;
@@ -100,3 +102,60 @@ TEST(TraceBusTest, unsubscribe_before_publish) {
   // of events.
   XCHECK(1 == i || i == 3) << i << " must be 1 or 3";
 }
+
+TEST(TraceBusTest, publishes_from_several_threads_are_observed_in_order) {
+  constexpr int kThreads = 4;
+  constexpr int kEventsPerThread = 1000;
+  std::vector<int> values;
+  {
+    auto bus = TraceBus<int>::create("bus", 10);
+    auto handle =
+        bus->subscribeFunction("sub", [&](int v) { values.push_back(v); });
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&, t] {
+        for (int i = 0; i < kEventsPerThread; ++i) {
+          bus->publish(t * kEventsPerThread + i);
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    // The last event is published after the events of all the threads.
+    bus->publish(-1);
+  }
+
+  ASSERT_EQ(kThreads * kEventsPerThread + 1, values.size());
+  EXPECT_EQ(-1, values.back());
+  std::vector<int> next(kThreads, 0);
+  for (size_t i = 0; i + 1 < values.size(); ++i) {
+    auto t = values[i] / kEventsPerThread;
+    EXPECT_EQ(t * kEventsPerThread + next[t], values[i]);
+    ++next[t];
+  }
+}
+
+TEST(TraceBusTest, producer_stats_count_blocked_publishes) {
+  folly::Baton<> release;
+  auto bus = TraceBus<int>::create("bus", 1);
+  auto handle = bus->subscribeFunction("sub", [&](int) { release.wait(); });
+
+  std::thread releaser{[&] {
+    std::this_thread::sleep_for(100ms);
+    release.post();
+  }};
+  // The subscriber holds on to the first event, the second fills the buffer,
+  // so the third at least must wait until the subscriber is released.
+  for (int i = 0; i < 3; ++i) {
+    bus->publish(i);
+  }
+  releaser.join();
+
+  auto stats = bus->getProducerStats();
+  ASSERT_EQ(1, stats.size());
+  EXPECT_EQ(3, stats[0].published);
+  EXPECT_LE(1, stats[0].blocked);
+}
@@ -10,6 +10,7 @@
 #include <fmt/format.h>
 #include <folly/MapUtil.h>
 #include <folly/futures/Future.h>
+#include <folly/io/Cursor.h>
 #include <folly/logging/xlog.h>
 #include <folly/ssl/OpenSSLHash.h>
 
@@ -130,6 +131,31 @@ SemiFuture<BackingStore::GetBlobResult> FakeBackingStore::getBlob(
   });
 }
 
+SemiFuture<unique_ptr<IOBuf>> FakeBackingStore::getBlobRange(
+    const ObjectId& id,
+    uint64_t offset,
+    uint64_t length,
+    const ObjectFetchContextPtr& /*context*/) {
+  auto data = data_.wlock();
+  ++data->rangeAccessCounts[id];
+  auto it = data->blobs.find(id);
+  if (it == data->blobs.end()) {
+    // Throw immediately, for the same reasons mentioned in getTree()
+    throw std::domain_error(fmt::format("blob {} not found", id));
+  }
+
+  return it->second->getFuture().thenValue(
+      [offset, length](std::unique_ptr<Blob> blob) {
+        folly::io::Cursor cursor{&blob->getContents()};
+        auto result = IOBuf::create(0);
+        if (cursor.canAdvance(offset)) {
+          cursor.skip(offset);
+          cursor.cloneAtMost(result, length);
+        }
+        return result;
+      });
+}
+
 Blob FakeBackingStore::makeBlob(folly::StringPiece contents) {
   return makeBlob(ObjectId::sha1(contents), contents);
 }
@@ -386,4 +412,16 @@ void FakeBackingStore::discardOutstandingRequests() {
 size_t FakeBackingStore::getAccessCount(const ObjectId& hash) const {
   return folly::get_default(data_.rlock()->accessCounts, hash, 0);
 }
+
+size_t FakeBackingStore::getTotalAccessCount() const {
+  size_t total = 0;
+  for (const auto& [hash, count] : data_.rlock()->accessCounts) {
+    total += count;
+  }
+  return total;
+}
+
+size_t FakeBackingStore::getRangeAccessCount(const ObjectId& hash) const {
+  return folly::get_default(data_.rlock()->rangeAccessCounts, hash, 0);
+}
 } // namespace facebook::eden
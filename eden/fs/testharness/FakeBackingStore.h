@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <initializer_list>
 #include <memory>
 #include <unordered_map>
@@ -72,6 +73,28 @@ class FakeBackingStore final : public BackingStore {
     return nullptr;
   }
 
+  bool supportsBlobRanges() const override {
+    return supportsBlobRanges_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Ranged reads wait for the StoredBlob to be ready, like getBlob(), and
+   * are counted separately by getRangeAccessCount().
+   */
+  folly::SemiFuture<std::unique_ptr<folly::IOBuf>> getBlobRange(
+      const ObjectId& id,
+      uint64_t offset,
+      uint64_t length,
+      const ObjectFetchContextPtr& context) override;
+
+  /**
+   * Ranged reads are disabled by default so that tests keep exercising the
+   * whole blob fetches that the production BackingStores use.
+   */
+  void setSupportsBlobRanges(bool supported) {
+    supportsBlobRanges_.store(supported, std::memory_order_relaxed);
+  }
+
   /**
    * Add a Blob to the backing store
    *
@@ -165,6 +188,18 @@ class FakeBackingStore final : public BackingStore {
    */
   size_t getAccessCount(const ObjectId& hash) const;
 
+  /**
+   * Returns the number of times any object has been queried by either getTree,
+   * getBlob, or getTreeForCommit.
+   */
+  size_t getTotalAccessCount() const;
+
+  /**
+   * Returns the number of times a range of this blob has been fetched by
+   * getBlobRange.
+   */
+  size_t getRangeAccessCount(const ObjectId& hash) const;
+
   // TODO(T119221752): Implement for all BackingStore subclasses
   int64_t dropAllPendingRequestsFromQueue() override {
     XLOG(
@@ -181,6 +216,7 @@ class FakeBackingStore final : public BackingStore {
 
     std::unordered_map<RootId, size_t> commitAccessCounts;
     std::unordered_map<ObjectId, size_t> accessCounts;
+    std::unordered_map<ObjectId, size_t> rangeAccessCounts;
   };
 
   static Tree::container buildTreeEntries(
@@ -192,6 +228,7 @@ class FakeBackingStore final : public BackingStore {
       Tree::container&& sortedEntries);
 
   folly::Synchronized<Data> data_;
+  std::atomic<bool> supportsBlobRanges_{false};
 };
 
 enum class FakeBlobType {
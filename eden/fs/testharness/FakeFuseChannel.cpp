@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#ifndef _WIN32
+
+#include "eden/fs/testharness/FakeFuseChannel.h"
+
+#include <fmt/format.h>
+#include <folly/logging/Logger.h>
+#include <sys/stat.h>
+
+#include "eden/common/utils/ProcessNameCache.h"
+#include "eden/fs/fuse/FuseDispatcher.h"
+#include "eden/fs/utils/CaseSensitivity.h"
+
+namespace facebook::eden {
+
+namespace {
+
+folly::Logger straceLogger{"eden.strace"};
+
+class ImmediateDispatcher : public FuseDispatcher {
+ public:
+  using FuseDispatcher::FuseDispatcher;
+
+  ImmediateFuture<Attr> getattr(
+      InodeNumber ino,
+      const ObjectFetchContextPtr& /* context */) override {
+    struct stat st = {};
+    st.st_ino = ino.get();
+    st.st_mode = S_IFREG | 0644;
+    st.st_nlink = 1;
+    return Attr{st};
+  }
+
+  ImmediateFuture<std::string> getxattr(
+      InodeNumber /* ino */,
+      folly::StringPiece /* name */,
+      const ObjectFetchContextPtr& /* context */) override {
+    return std::string{};
+  }
+};
+
+} // namespace
+
+FakeFuseChannel::FakeFuseChannel(size_t numThreads)
+    : channel_{new FuseChannel(
+          fuse_.start(),
+          AbsolutePath{"/fake/mount/path"},
+          numThreads,
+          std::make_unique<ImmediateDispatcher>(&stats_),
+          &straceLogger,
+          std::make_shared<ProcessNameCache>(),
+          /*fsEventLogger=*/nullptr,
+          std::chrono::seconds(60),
+          /*notifications=*/nullptr,
+          CaseSensitivity::Sensitive,
+          /*requireUtf8Path=*/true,
+          /*maximumBackgroundRequests=*/12,
+          /*useWriteBackCache=*/false,
+          /*cloneDevice=*/false,
+          /*pinWorkerThreads=*/false,
+          /*spliceReads=*/false,
+          /*readdirPlus=*/false,
+          /*numInvalidationThreads=*/1,
+          /*slowRequestThreshold=*/std::chrono::seconds(1))} {
+  auto initFuture = channel_->initialize();
+  fuse_.sendInitRequest();
+  fuse_.recvResponse();
+  stopFuture_.emplace(std::move(initFuture).get());
+}
+
+FakeFuseChannel::~FakeFuseChannel() {
+  fuse_.close();
+  std::move(*stopFuture_).get();
+}
+
+FakeFuse::Response FakeFuseChannel::call(
+    uint32_t opcode,
+    uint64_t inode,
+    folly::ByteRange arg) {
+  auto unique = fuse_.sendRequest(opcode, inode, arg);
+  auto response = fuse_.recvResponse();
+  if (response.header.unique != unique) {
+    throw std::runtime_error(fmt::format(
+        "expected the response to request {}, got {}",
+        unique,
+        response.header.unique));
+  }
+  return response;
+}
+
+} // namespace facebook::eden
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <memory>
+#include <optional>
+
+#include "eden/fs/fuse/FuseChannel.h"
+#include "eden/fs/telemetry/EdenStats.h"
+#include "eden/fs/testharness/FakeFuse.h"
+
+namespace facebook::eden {
+
+/**
+ * An initialized FuseChannel reading the requests of a FakeFuse, whose
+ * dispatcher answers FUSE_GETATTR and FUSE_GETXATTR without doing anything,
+ * so that benchmarks can measure what FuseChannel itself costs per request.
+ */
+class FakeFuseChannel {
+ public:
+  explicit FakeFuseChannel(size_t numThreads = 1);
+  ~FakeFuseChannel();
+
+  FakeFuseChannel(const FakeFuseChannel&) = delete;
+  FakeFuseChannel& operator=(const FakeFuseChannel&) = delete;
+
+  /**
+   * Sends a request and waits for its response.
+   */
+  FakeFuse::Response call(uint32_t opcode, uint64_t inode, folly::ByteRange arg);
+
+ private:
+  EdenStats stats_;
+  FakeFuse fuse_;
+  std::unique_ptr<FuseChannel, FuseChannelDeleter> channel_;
+  std::optional<FuseChannel::StopFuture> stopFuture_;
+};
+
+} // namespace facebook::eden
@@ -82,10 +82,10 @@ ImmediateFuture<std::shared_ptr<const Blob>> FakeObjectStore::getBlob(
   return make_shared<const Blob>(iter->second);
 }
 
-ImmediateFuture<folly::Unit> FakeObjectStore::prefetchBlobs(
+ImmediateFuture<size_t> FakeObjectStore::prefetchBlobs(
     ObjectIdRange,
     const ObjectFetchContextPtr&) const {
-  return folly::unit;
+  return size_t{0};
 }
 
 size_t FakeObjectStore::getAccessCount(const ObjectId& hash) const {
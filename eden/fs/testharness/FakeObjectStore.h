@@ -45,7 +45,7 @@ class FakeObjectStore final : public IObjectStore {
       const ObjectId& id,
       const ObjectFetchContextPtr& context =
           ObjectFetchContext::getNullContext()) const override;
-  ImmediateFuture<folly::Unit> prefetchBlobs(
+  ImmediateFuture<size_t> prefetchBlobs(
       ObjectIdRange ids,
       const ObjectFetchContextPtr& context =
           ObjectFetchContext::getNullContext()) const override;
@@ -95,7 +95,8 @@ Future<Unit> FakePrivHelper::nfsMount(
     folly::SocketAddress /*nfsdPort*/,
     bool /*readOnly*/,
     uint32_t /*iosize*/,
-    bool /*useReaddirplus*/) {
+    bool /*useReaddirplus*/,
+    uint32_t /*nconnect*/) {
   return makeFuture<Unit>(
       runtime_error("FakePrivHelper::nfsMount() not implemented"));
 }
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include "eden/fs/store/FetchCostAccumulator.h"
 #include "eden/fs/store/IObjectStore.h"
 
 namespace facebook::eden {
@@ -25,6 +26,17 @@ class LoggingFetchContext : public ObjectFetchContext {
     requests.emplace_back(type, hash, origin);
   }
 
+  void didSpendFetching(
+      Origin origin,
+      std::chrono::nanoseconds duration,
+      uint64_t bytes) override {
+    fetchCost.add(origin, duration, bytes);
+  }
+
+  void didLoadInode(std::chrono::nanoseconds) override {
+    ++inodeLoads;
+  }
+
   std::optional<pid_t> getClientPid() const override {
     return std::nullopt;
   }
@@ -39,6 +51,8 @@ class LoggingFetchContext : public ObjectFetchContext {
   }
 
   std::vector<Request> requests;
+  FetchCostAccumulator fetchCost;
+  size_t inodeLoads = 0;
 };
 
 } // namespace facebook::eden
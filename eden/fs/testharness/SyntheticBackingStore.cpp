@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/testharness/SyntheticBackingStore.h"
+
+#include <fmt/format.h>
+#include <folly/Conv.h>
+#include <folly/lang/Bits.h>
+#include <array>
+#include <cstring>
+
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/Tree.h"
+#include "eden/fs/model/TreeEntry.h"
+
+using folly::SemiFuture;
+using std::unique_ptr;
+
+namespace facebook::eden {
+
+namespace {
+
+/** splitmix64, which is good enough to derive the repository from a seed. */
+uint64_t mix(uint64_t value) {
+  value += 0x9e3779b97f4a7c15;
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+  return value ^ (value >> 31);
+}
+
+// The kind, followed by the seed, level and index in big endian.
+constexpr size_t kIdSize = 1 + 3 * sizeof(uint64_t);
+
+} // namespace
+
+SyntheticBackingStore::SyntheticBackingStore(Options options)
+    : options_{std::move(options)} {
+  if (options_.minFileSize > options_.maxFileSize) {
+    throw std::invalid_argument(fmt::format(
+        "minimum file size {} is larger than the maximum file size {}",
+        options_.minFileSize,
+        options_.maxFileSize));
+  }
+}
+
+SyntheticBackingStore::~SyntheticBackingStore() {}
+
+size_t SyntheticBackingStore::getTreeCount() const {
+  size_t count = 0;
+  for (uint64_t level = 0; level <= options_.depth; ++level) {
+    count += treesAtLevel(level);
+  }
+  return count;
+}
+
+size_t SyntheticBackingStore::getBlobCount() const {
+  return getTreeCount() * options_.filesPerDir;
+}
+
+RootId SyntheticBackingStore::parseRootId(folly::StringPiece rootId) {
+  auto seed = folly::tryTo<uint64_t>(rootId);
+  if (!seed) {
+    throw std::invalid_argument(
+        fmt::format("root ID {} is not a decimal seed", rootId));
+  }
+  return RootId{folly::to<std::string>(*seed)};
+}
+
+std::string SyntheticBackingStore::renderRootId(const RootId& rootId) {
+  return rootId.value();
+}
+
+ObjectId SyntheticBackingStore::parseObjectId(folly::StringPiece objectId) {
+  return ObjectId::fromHex(objectId);
+}
+
+std::string SyntheticBackingStore::renderObjectId(const ObjectId& objectId) {
+  return objectId.asHexString();
+}
+
+ImmediateFuture<unique_ptr<Tree>> SyntheticBackingStore::getRootTree(
+    const RootId& rootId,
+    const ObjectFetchContextPtr& /* context */) {
+  auto seed = folly::tryTo<uint64_t>(rootId.value());
+  if (!seed) {
+    return makeImmediateFuture<unique_ptr<Tree>>(std::domain_error(
+        fmt::format("root ID {} is not a decimal seed", rootId.value())));
+  }
+  treeFetchCount_.fetch_add(1, std::memory_order_relaxed);
+  return ImmediateFuture<unique_ptr<Tree>>{
+      delay(makeTree(Node{Kind::Tree, *seed, 0, 0}))};
+}
+
+ImmediateFuture<unique_ptr<TreeEntry>>
+SyntheticBackingStore::getTreeEntryForObjectId(
+    const ObjectId& objectId,
+    TreeEntryType treeEntryType,
+    const ObjectFetchContextPtr& /* context */) {
+  auto kind = treeEntryType == TreeEntryType::TREE ? Kind::Tree : Kind::Blob;
+  if (!parseId(objectId, kind)) {
+    return makeImmediateFuture<unique_ptr<TreeEntry>>(std::domain_error(
+        fmt::format("object {} not found", objectId)));
+  }
+  return std::make_unique<TreeEntry>(objectId, treeEntryType);
+}
+
+SemiFuture<BackingStore::GetTreeResult> SyntheticBackingStore::getTree(
+    const ObjectId& id,
+    const ObjectFetchContextPtr& /* context */) {
+  auto node = parseId(id, Kind::Tree);
+  if (!node) {
+    return folly::makeSemiFuture<GetTreeResult>(
+        std::domain_error(fmt::format("tree {} not found", id)));
+  }
+  treeFetchCount_.fetch_add(1, std::memory_order_relaxed);
+  return delay(GetTreeResult{
+      makeTree(*node), ObjectFetchContext::Origin::FromNetworkFetch});
+}
+
+SemiFuture<BackingStore::GetBlobResult> SyntheticBackingStore::getBlob(
+    const ObjectId& id,
+    const ObjectFetchContextPtr& /* context */) {
+  auto node = parseId(id, Kind::Blob);
+  if (!node) {
+    return folly::makeSemiFuture<GetBlobResult>(
+        std::domain_error(fmt::format("blob {} not found", id)));
+  }
+  blobFetchCount_.fetch_add(1, std::memory_order_relaxed);
+  return delay(GetBlobResult{
+      makeBlob(*node), ObjectFetchContext::Origin::FromNetworkFetch});
+}
+
+ObjectId SyntheticBackingStore::makeId(const Node& node) {
+  std::array<uint8_t, kIdSize> bytes;
+  bytes[0] = static_cast<uint8_t>(node.kind);
+  auto* fields = bytes.data() + 1;
+  for (auto field : {node.seed, node.level, node.index}) {
+    auto big = folly::Endian::big(field);
+    std::memcpy(fields, &big, sizeof(big));
+    fields += sizeof(big);
+  }
+  return ObjectId{folly::ByteRange{bytes.data(), bytes.size()}};
+}
+
+std::optional<SyntheticBackingStore::Node> SyntheticBackingStore::parseId(
+    const ObjectId& id,
+    Kind kind) const {
+  auto bytes = id.getBytes();
+  if (bytes.size() != kIdSize || bytes[0] != static_cast<uint8_t>(kind)) {
+    return std::nullopt;
+  }
+  Node node{kind, 0, 0, 0};
+  auto* fields = bytes.data() + 1;
+  for (auto* field : {&node.seed, &node.level, &node.index}) {
+    uint64_t big;
+    std::memcpy(&big, fields, sizeof(big));
+    *field = folly::Endian::big(big);
+    fields += sizeof(big);
+  }
+  if (node.level > options_.depth) {
+    return std::nullopt;
+  }
+  auto count = treesAtLevel(node.level);
+  if (kind == Kind::Blob) {
+    count *= options_.filesPerDir;
+  }
+  if (node.index >= count) {
+    return std::nullopt;
+  }
+  return node;
+}
+
+uint64_t SyntheticBackingStore::treesAtLevel(uint64_t level) const {
+  uint64_t count = 1;
+  for (uint64_t i = 0; i < level; ++i) {
+    count *= options_.dirsPerDir;
+  }
+  return count;
+}
+
+unique_ptr<Tree> SyntheticBackingStore::makeTree(const Node& node) const {
+  Tree::container entries{kPathMapDefaultCaseSensitive};
+  auto dirCount = node.level < options_.depth ? options_.dirsPerDir : 0;
+  entries.reserve(dirCount + options_.filesPerDir);
+  // Directories sort before files, so that entries are inserted in order.
+  for (uint64_t i = 0; i < dirCount; ++i) {
+    entries.emplace(
+        PathComponent{fmt::format("dir{:04}", i)},
+        makeId(Node{
+            Kind::Tree,
+            node.seed,
+            node.level + 1,
+            node.index * options_.dirsPerDir + i}),
+        TreeEntryType::TREE);
+  }
+  for (uint64_t i = 0; i < options_.filesPerDir; ++i) {
+    entries.emplace(
+        PathComponent{fmt::format("file{:04}", i)},
+        makeId(Node{
+            Kind::Blob,
+            node.seed,
+            node.level,
+            node.index * options_.filesPerDir + i}),
+        TreeEntryType::REGULAR_FILE);
+  }
+  return std::make_unique<Tree>(std::move(entries), makeId(node));
+}
+
+unique_ptr<Blob> SyntheticBackingStore::makeBlob(const Node& node) const {
+  auto state = mix(node.seed ^ mix(node.level ^ mix(node.index)));
+  auto size = blobSize(node);
+  auto buf = folly::IOBuf::create(size);
+  auto* data = buf->writableData();
+  // Lines of lowercase letters, which looks enough like source code for
+  // anything that would inspect the contents.
+  for (size_t i = 0; i < size; ++i) {
+    if (i % 8 == 0) {
+      state = mix(state);
+    }
+    auto byte = static_cast<uint8_t>(state >> (8 * (i % 8)));
+    data[i] = i % 64 == 63 ? '\n' : static_cast<uint8_t>('a' + byte % 26);
+  }
+  buf->append(size);
+  return std::make_unique<Blob>(makeId(node), std::move(*buf));
+}
+
+size_t SyntheticBackingStore::blobSize(const Node& node) const {
+  auto range = options_.maxFileSize - options_.minFileSize + 1;
+  auto hash = mix(mix(node.seed) ^ mix(node.level) ^ node.index);
+  return options_.minFileSize + hash % range;
+}
+
+template <typename T>
+SemiFuture<T> SyntheticBackingStore::delay(T result) const {
+  if (options_.latency.count() == 0) {
+    return folly::makeSemiFuture(std::move(result));
+  }
+  return folly::futures::sleep(options_.latency)
+      .deferValue([result = std::move(result)](folly::Unit) mutable {
+        return std::move(result);
+      });
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <optional>
+
+#include "eden/fs/model/RootId.h"
+#include "eden/fs/store/BackingStore.h"
+#include "eden/fs/store/ObjectFetchContext.h"
+
+namespace facebook::eden {
+
+/**
+ * A BackingStore of repositories that are generated on the fly rather than
+ * stored, so that benchmarks can use repositories as large as a monorepo
+ * without a server or the memory to hold them.
+ *
+ * Every root ID is the decimal seed of a repository, and all of them have
+ * the shape given by the Options: a root directory of `dirsPerDir`
+ * subdirectories down to `depth` levels below it, each directory holding
+ * `filesPerDir` files of between `minFileSize` and `maxFileSize` bytes. The
+ * same seed always generates the same trees and blobs, while two seeds share
+ * none.
+ *
+ * Object IDs encode what they were generated from, so no state is kept
+ * besides the fetch counts.
+ */
+class SyntheticBackingStore final : public BijectiveBackingStore {
+ public:
+  struct Options {
+    /** Levels of directories below the root. */
+    size_t depth{3};
+    /** Subdirectories of every directory but those at the deepest level. */
+    size_t dirsPerDir{10};
+    size_t filesPerDir{10};
+    size_t minFileSize{0};
+    size_t maxFileSize{16 * 1024};
+    /** Delay of every fetch, to simulate a remote store. */
+    std::chrono::microseconds latency{0};
+  };
+
+  explicit SyntheticBackingStore(Options options);
+  ~SyntheticBackingStore() override;
+
+  /** Number of directories of every repository, its root included. */
+  size_t getTreeCount() const;
+
+  /** Number of files of every repository. */
+  size_t getBlobCount() const;
+
+  /** Number of getTree() and getRootTree() calls that found their tree. */
+  size_t getTreeFetchCount() const {
+    return treeFetchCount_.load(std::memory_order_relaxed);
+  }
+
+  /** Number of getBlob() calls that found their blob. */
+  size_t getBlobFetchCount() const {
+    return blobFetchCount_.load(std::memory_order_relaxed);
+  }
+
+  RootId parseRootId(folly::StringPiece rootId) override;
+  std::string renderRootId(const RootId& rootId) override;
+  ObjectId parseObjectId(folly::StringPiece objectId) override;
+  std::string renderObjectId(const ObjectId& objectId) override;
+
+  ImmediateFuture<std::unique_ptr<Tree>> getRootTree(
+      const RootId& rootId,
+      const ObjectFetchContextPtr& context) override;
+  ImmediateFuture<std::unique_ptr<TreeEntry>> getTreeEntryForObjectId(
+      const ObjectId& objectId,
+      TreeEntryType treeEntryType,
+      const ObjectFetchContextPtr& context) override;
+  folly::SemiFuture<GetTreeResult> getTree(
+      const ObjectId& id,
+      const ObjectFetchContextPtr& context) override;
+  folly::SemiFuture<GetBlobResult> getBlob(
+      const ObjectId& id,
+      const ObjectFetchContextPtr& context) override;
+
+  std::unique_ptr<BlobMetadata> getLocalBlobMetadata(
+      const ObjectId& /*id*/,
+      const ObjectFetchContextPtr& /*context*/) override {
+    return nullptr;
+  }
+
+  int64_t dropAllPendingRequestsFromQueue() override {
+    return 0;
+  }
+
+ private:
+  enum class Kind : uint8_t { Tree = 1, Blob = 2 };
+
+  /** What an ObjectId was generated from. */
+  struct Node {
+    Kind kind;
+    uint64_t seed;
+    uint64_t level;
+    uint64_t index;
+  };
+
+  static ObjectId makeId(const Node& node);
+  std::optional<Node> parseId(const ObjectId& id, Kind kind) const;
+
+  /** Number of directories at `level`, 1 for the root. */
+  uint64_t treesAtLevel(uint64_t level) const;
+
+  std::unique_ptr<Tree> makeTree(const Node& node) const;
+  std::unique_ptr<Blob> makeBlob(const Node& node) const;
+  size_t blobSize(const Node& node) const;
+
+  /** Delays `result` by the configured latency. */
+  template <typename T>
+  folly::SemiFuture<T> delay(T result) const;
+
+  const Options options_;
+  std::atomic<size_t> treeFetchCount_{0};
+  std::atomic<size_t> blobFetchCount_{0};
+};
+
+} // namespace facebook::eden
@@ -373,6 +373,14 @@ class TestMount {
     return serverExecutor_;
   }
 
+  /**
+   * The settings only read when the EdenMount is created must be changed
+   * before initialize().
+   */
+  const std::shared_ptr<EdenConfig>& getEdenConfig() const {
+    return edenConfig_;
+  }
+
  private:
   void createMount(
       Overlay::InodeCatalogType InodeCatalogType = kDefaultInodeCatalogType);
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/testharness/SyntheticBackingStore.h"
+
+#include <folly/portability/GTest.h>
+#include <folly/test/TestUtils.h>
+
+#include "eden/fs/model/Blob.h"
+#include "eden/fs/model/Tree.h"
+
+using namespace facebook::eden;
+using namespace std::literals::chrono_literals;
+
+namespace {
+
+SyntheticBackingStore::Options smallRepo() {
+  SyntheticBackingStore::Options options;
+  options.depth = 2;
+  options.dirsPerDir = 3;
+  options.filesPerDir = 4;
+  options.minFileSize = 10;
+  options.maxFileSize = 100;
+  return options;
+}
+
+std::unique_ptr<Tree> getRootTree(SyntheticBackingStore& store, RootId root) {
+  return store.getRootTree(root, ObjectFetchContext::getNullContext()).get();
+}
+
+std::unique_ptr<Tree> getTree(SyntheticBackingStore& store, ObjectId id) {
+  return store.getTree(id, ObjectFetchContext::getNullContext()).get().tree;
+}
+
+std::unique_ptr<Blob> getBlob(SyntheticBackingStore& store, ObjectId id) {
+  return store.getBlob(id, ObjectFetchContext::getNullContext()).get().blob;
+}
+
+/** Visits every tree and blob reachable from root, returning their count. */
+std::pair<size_t, size_t> walk(SyntheticBackingStore& store, const Tree& root) {
+  size_t trees = 1;
+  size_t blobs = 0;
+  for (const auto& [name, entry] : root) {
+    if (entry.isTree()) {
+      auto [subtrees, subblobs] =
+          walk(store, *getTree(store, entry.getHash()));
+      trees += subtrees;
+      blobs += subblobs;
+    } else {
+      auto blob = getBlob(store, entry.getHash());
+      EXPECT_GE(blob->getSize(), 10);
+      EXPECT_LE(blob->getSize(), 100);
+      ++blobs;
+    }
+  }
+  return {trees, blobs};
+}
+
+} // namespace
+
+TEST(SyntheticBackingStoreTest, generatesTheConfiguredShape) {
+  SyntheticBackingStore store{smallRepo()};
+  EXPECT_EQ(1 + 3 + 9, store.getTreeCount());
+  EXPECT_EQ(13 * 4, store.getBlobCount());
+
+  auto root = getRootTree(store, RootId{"1"});
+  EXPECT_EQ(3 + 4, root->size());
+  EXPECT_TRUE(root->find(PathComponentPiece{"dir0000"})->second.isTree());
+  EXPECT_FALSE(root->find(PathComponentPiece{"file0003"})->second.isTree());
+
+  auto dir = root->find(PathComponentPiece{"dir0000"})->second.getHash();
+  auto child = getTree(store, dir);
+  auto leafDir = child->find(PathComponentPiece{"dir0000"})->second.getHash();
+  // The directories at the deepest level only hold files.
+  EXPECT_EQ(4, getTree(store, leafDir)->size());
+
+  auto [trees, blobs] = walk(store, *root);
+  EXPECT_EQ(store.getTreeCount(), trees);
+  EXPECT_EQ(store.getBlobCount(), blobs);
+  EXPECT_EQ(trees + 2, store.getTreeFetchCount());
+  EXPECT_EQ(blobs, store.getBlobFetchCount());
+}
+
+TEST(SyntheticBackingStoreTest, seedsAreDeterministic) {
+  SyntheticBackingStore store1{smallRepo()};
+  SyntheticBackingStore store2{smallRepo()};
+
+  auto root1 = getRootTree(store1, RootId{"1"});
+  auto root2 = getRootTree(store2, RootId{"1"});
+  EXPECT_EQ(root1->getHash(), root2->getHash());
+  auto file = root1->find(PathComponentPiece{"file0000"})->second.getHash();
+  auto blob1 = getBlob(store1, file);
+  auto blob2 = getBlob(store2, file);
+  EXPECT_EQ(blob1->asString(), blob2->asString());
+
+  auto other = getRootTree(store1, RootId{"2"});
+  EXPECT_NE(root1->getHash(), other->getHash());
+  auto otherFile =
+      other->find(PathComponentPiece{"file0000"})->second.getHash();
+  EXPECT_NE(file, otherFile);
+  EXPECT_NE(blob1->asString(), getBlob(store1, otherFile)->asString());
+}
+
+TEST(SyntheticBackingStoreTest, unknownObjects) {
+  SyntheticBackingStore store{smallRepo()};
+  auto root = getRootTree(store, RootId{"1"});
+  auto dir = root->find(PathComponentPiece{"dir0000"})->second.getHash();
+  auto file = root->find(PathComponentPiece{"file0000"})->second.getHash();
+
+  EXPECT_THROW_RE(getBlob(store, dir), std::domain_error, "not found");
+  EXPECT_THROW_RE(getTree(store, file), std::domain_error, "not found");
+  EXPECT_THROW_RE(
+      getTree(store, ObjectId::fromHex("0123")),
+      std::domain_error,
+      "not found");
+  EXPECT_THROW_RE(
+      getRootTree(store, RootId{"main"}),
+      std::domain_error,
+      "not a decimal seed");
+  EXPECT_THROW(store.parseRootId("main"), std::invalid_argument);
+  EXPECT_EQ(RootId{"42"}, store.parseRootId("42"));
+}
+
+TEST(SyntheticBackingStoreTest, injectsLatency) {
+  auto options = smallRepo();
+  options.latency = 1ms;
+  SyntheticBackingStore store{options};
+  auto future = store.getTree(
+      getRootTree(store, RootId{"1"})->getHash(),
+      ObjectFetchContext::getNullContext());
+  EXPECT_FALSE(future.isReady());
+  EXPECT_EQ(3 + 4, std::move(future).get().tree->size());
+}
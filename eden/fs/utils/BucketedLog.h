@@ -8,6 +8,7 @@
 #pragma once
 
 #include <folly/logging/xlog.h>
+#include <algorithm>
 #include <array>
 
 namespace facebook::eden {
@@ -67,6 +68,24 @@ class BucketedLog {
     return result;
   }
 
+  /**
+   * Advances the internal clock to `now`, clearing buckets that have rolled
+   * out of the `Size` window, and then calls `fn` with each of the `count`
+   * most recent buckets, most recent last, without copying them.
+   */
+  template <typename Fn>
+  void forEachRecent(uint64_t now, size_t count, Fn&& fn) {
+    advanceWindow(now);
+
+    count = std::min(count, Size);
+    uint64_t b = now + 1 + Size - count;
+    for (size_t i = 0; i < count; ++i) {
+      const Bucket& bucket = buckets_[b % Size];
+      fn(bucket);
+      ++b;
+    }
+  }
+
   /**
    * For every bucket in other whose time lines up with a bucket in `this`, call
    * this_bucket.merge(other_bucket).
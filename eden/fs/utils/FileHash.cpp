@@ -7,10 +7,25 @@
 
 #include "eden/fs/utils/FileHash.h"
 #include <folly/portability/OpenSSL.h>
+#include <algorithm>
+#include <memory>
 #include "eden/common/utils/WinError.h"
 
 namespace facebook::eden {
 
+namespace {
+constexpr size_t kMinBufferSize = 8 * 1024;
+constexpr size_t kMaxBufferSize = 1024 * 1024;
+} // namespace
+
+size_t getFileHashBufferSize(uint64_t fileSize) {
+  // One more byte, so that the first read also finds the end of the file,
+  // rounded up to a multiple of the minimum, which is a multiple of the page
+  // size.
+  auto size = (fileSize + kMinBufferSize) / kMinBufferSize * kMinBufferSize;
+  return static_cast<size_t>(std::min<uint64_t>(size, kMaxBufferSize));
+}
+
 #ifdef _WIN32
 
 Hash20 getFileSha1(AbsolutePathPiece filePath) {
@@ -33,13 +48,18 @@ Hash20 getFileSha1(AbsolutePathPiece filePath) {
     CloseHandle(fileHandle);
   };
 
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(fileHandle, &fileSize)) {
+    fileSize.QuadPart = 0;
+  }
+  auto bufSize = static_cast<DWORD>(getFileHashBufferSize(fileSize.QuadPart));
+  std::unique_ptr<uint8_t[]> buf{new uint8_t[bufSize]};
+
   SHA_CTX ctx;
   SHA1_Init(&ctx);
   while (true) {
-    uint8_t buf[8192];
-
     DWORD bytesRead;
-    if (!ReadFile(fileHandle, buf, sizeof(buf), &bytesRead, nullptr)) {
+    if (!ReadFile(fileHandle, buf.get(), bufSize, &bytesRead, nullptr)) {
       throw makeWin32ErrorExplicit(
           GetLastError(),
           fmt::format(
@@ -50,7 +70,7 @@ Hash20 getFileSha1(AbsolutePathPiece filePath) {
       break;
     }
 
-    SHA1_Update(&ctx, buf, bytesRead);
+    SHA1_Update(&ctx, buf.get(), bytesRead);
   }
 
   static_assert(Hash20::RAW_SIZE == SHA_DIGEST_LENGTH);
@@ -12,6 +12,18 @@
 
 namespace facebook::eden {
 
+/**
+ * Size of the buffer to read a file of fileSize bytes with when hashing it:
+ * large enough for most files to be read in one call, which also sees the
+ * end of the file, but bounded so that hashing a large file doesn't allocate
+ * as much.
+ *
+ * The hashing itself is done by OpenSSL, which uses the SHA extensions of x86
+ * and ARMv8 CPUs when they have them: for large files the number of reads is
+ * what matters.
+ */
+size_t getFileHashBufferSize(uint64_t fileSize);
+
 #ifdef _WIN32
 /** Compute the sha1 of the file */
 Hash20 getFileSha1(AbsolutePathPiece filePath);
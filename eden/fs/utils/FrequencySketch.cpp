@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/FrequencySketch.h"
+
+#include <folly/Bits.h>
+#include <folly/hash/Hash.h>
+#include <algorithm>
+
+namespace facebook::eden {
+
+namespace {
+// Odd constants used to derive an independent index for every row.
+constexpr uint64_t kSeeds[] = {
+    0xc3a5c85c97cb3127ULL,
+    0xb492b66fbe98f273ULL,
+    0x9ae16a3b2f90404fULL,
+    0xcbf29ce484222325ULL,
+};
+} // namespace
+
+FrequencySketch::FrequencySketch(size_t expectedEntries) {
+  auto width = folly::nextPowTwo(std::max<size_t>(expectedEntries, 16));
+  widthMask_ = width - 1;
+  sampleSize_ = 10 * width;
+  counters_.resize(kDepth * width);
+}
+
+size_t FrequencySketch::indexOf(uint64_t hashCode, size_t row) const noexcept {
+  auto mixed = folly::hash::twang_mix64(hashCode + kSeeds[row]);
+  return row * (widthMask_ + 1) + (mixed & widthMask_);
+}
+
+void FrequencySketch::increment(uint64_t hashCode) noexcept {
+  // Conservative update: only bump the counters that are at the current
+  // minimum, which reduces the overestimation caused by collisions.
+  auto current = estimate(hashCode);
+  if (current < kMaxCount) {
+    for (size_t row = 0; row < kDepth; ++row) {
+      auto& counter = counters_[indexOf(hashCode, row)];
+      if (counter == current) {
+        ++counter;
+      }
+    }
+  }
+
+  if (++additions_ >= sampleSize_) {
+    age();
+  }
+}
+
+uint8_t FrequencySketch::estimate(uint64_t hashCode) const noexcept {
+  uint8_t result = kMaxCount;
+  for (size_t row = 0; row < kDepth; ++row) {
+    result = std::min(result, counters_[indexOf(hashCode, row)]);
+  }
+  return result;
+}
+
+void FrequencySketch::clear() noexcept {
+  std::fill(counters_.begin(), counters_.end(), 0);
+  additions_ = 0;
+}
+
+void FrequencySketch::age() noexcept {
+  for (auto& counter : counters_) {
+    counter >>= 1;
+  }
+  additions_ /= 2;
+}
+
+} // namespace facebook::eden
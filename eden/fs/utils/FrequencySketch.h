@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * A compact, approximate frequency counter in the style of TinyLFU: a
+ * count-min sketch of small saturating counters that all get halved
+ * periodically, so the estimates reflect recent popularity rather than all
+ * time counts.
+ *
+ * Keys are identified by a 64-bit hash code; collisions only ever cause a key
+ * to be overestimated.
+ *
+ * This class is not thread-safe, callers are expected to provide their own
+ * synchronization.
+ */
+class FrequencySketch {
+ public:
+  /**
+   * Size a sketch to track roughly `expectedEntries` distinct keys. The
+   * counters are aged after 10 * expectedEntries increments.
+   */
+  explicit FrequencySketch(size_t expectedEntries);
+
+  /**
+   * Record one access to the key with the given hash.
+   */
+  void increment(uint64_t hashCode) noexcept;
+
+  /**
+   * Return the estimated number of recent accesses to the key with the given
+   * hash, saturating at kMaxCount.
+   */
+  uint8_t estimate(uint64_t hashCode) const noexcept;
+
+  /**
+   * Reset every counter to zero.
+   */
+  void clear() noexcept;
+
+  static constexpr uint8_t kMaxCount = 15;
+
+ private:
+  static constexpr size_t kDepth = 4;
+
+  size_t indexOf(uint64_t hashCode, size_t row) const noexcept;
+
+  /**
+   * Halve every counter. Called once sampleSize_ increments were recorded.
+   */
+  void age() noexcept;
+
+  size_t widthMask_;
+  size_t sampleSize_;
+  size_t additions_{0};
+
+  /**
+   * kDepth rows of (widthMask_ + 1) counters each, stored contiguously.
+   */
+  std::vector<uint8_t> counters_;
+};
+
+} // namespace facebook::eden
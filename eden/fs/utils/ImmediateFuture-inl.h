@@ -125,6 +125,31 @@ makeImmediateFutureFromImmediate(Func&& func, Args... args) {
         folly::exception_wrapper{std::current_exception()});
   }
 }
+
+/**
+ * Like makeImmediateFutureFromImmediate, for a func that doesn't return a
+ * future, so that the continuations deferred on a SemiFuture don't need
+ * to be unwrapped by another one.
+ */
+template <typename Func, typename... Args>
+folly::Try<detail::continuation_result_t<Func, Args...>> makeTryFromImmediate(
+    Func&& func,
+    Args... args) {
+  using NewType = detail::continuation_result_t<Func, Args...>;
+  using FuncRetType = std::invoke_result_t<Func, Args...>;
+
+  try {
+    if constexpr (std::is_same_v<FuncRetType, void>) {
+      func(std::forward<Args>(args)...);
+      return folly::Try<NewType>{folly::unit};
+    } else {
+      return folly::Try<NewType>{func(std::forward<Args>(args)...)};
+    }
+  } catch (...) {
+    return folly::Try<NewType>(
+        folly::exception_wrapper{std::current_exception()});
+  }
+}
 } // namespace detail
 
 template <typename T>
@@ -132,21 +157,39 @@ template <typename Func>
 ImmediateFuture<detail::continuation_result_t<Func, T>>
 ImmediateFuture<T>::thenValue(Func&& func) && {
   using RetType = detail::continuation_result_t<Func, T>;
+  using FuncRetType = std::invoke_result_t<Func, T>;
   if (kind_ == Kind::Immediate && immediate_.hasException()) {
     return ImmediateFuture<RetType>{
         folly::Try<RetType>{std::move(immediate_).exception()}};
   }
 
-  return std::move(*this).thenTry(
-      [func = std::forward<Func>(func)](
-          folly::Try<T>&& try_) mutable -> ImmediateFuture<RetType> {
-        if (try_.hasValue()) {
-          return detail::makeImmediateFutureFromImmediate(
-              std::move(func), std::move(try_).value());
-        } else {
-          return folly::Try<RetType>(std::move(try_).exception());
-        }
-      });
+  if constexpr (
+      !detail::isImmediateFuture<FuncRetType>::value &&
+      !folly::isSemiFuture<FuncRetType>::value) {
+    // Returning a Try rather than an ImmediateFuture saves a SemiFuture core
+    // and a continuation when this future isn't ready.
+    return std::move(*this).thenTry(
+        [func = std::forward<Func>(func)](
+            folly::Try<T>&& try_) mutable -> folly::Try<RetType> {
+          if (try_.hasValue()) {
+            return detail::makeTryFromImmediate(
+                std::move(func), std::move(try_).value());
+          } else {
+            return folly::Try<RetType>(std::move(try_).exception());
+          }
+        });
+  } else {
+    return std::move(*this).thenTry(
+        [func = std::forward<Func>(func)](
+            folly::Try<T>&& try_) mutable -> ImmediateFuture<RetType> {
+          if (try_.hasValue()) {
+            return detail::makeImmediateFutureFromImmediate(
+                std::move(func), std::move(try_).value());
+          } else {
+            return folly::Try<RetType>(std::move(try_).exception());
+          }
+        });
+  }
 }
 
 template <typename T>
@@ -214,13 +257,16 @@ ImmediateFuture<T>::thenTry(Func&& func) && {
   } else {
     // In the case where Func returns an ImmediateFuture, we need to
     // transform that return value into a SemiFuture so that the return
-    // type is a SemiFuture<> and not a SemiFuture<ImmediateFuture<>>.
-    auto semiFut = std::move(*this).semi().defer(std::forward<Func>(func));
+    // type is a SemiFuture<> and not a SemiFuture<ImmediateFuture<>>. This is
+    // done in the same continuation, as each deferred one costs a SemiFuture
+    // core allocation.
     if constexpr (detail::isImmediateFuture<FuncRetType>::value) {
-      return std::move(semiFut).deferValue(
-          [](auto&& immFut) { return std::move(immFut).semi(); });
+      return std::move(*this).semi().defer(
+          [func = std::forward<Func>(func)](folly::Try<T>&& try_) mutable {
+            return func(std::move(try_)).semi();
+          });
     } else {
-      return semiFut;
+      return std::move(*this).semi().defer(std::forward<Func>(func));
     }
   }
 }
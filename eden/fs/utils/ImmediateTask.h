@@ -0,0 +1,239 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/experimental/coro/Coroutine.h>
+#include <optional>
+#include <utility>
+
+#include "eden/fs/utils/ImmediateFuture.h"
+
+#if FOLLY_HAS_COROUTINES
+
+namespace facebook::eden {
+
+template <typename T>
+class ImmediateTask;
+
+namespace detail {
+
+template <typename T>
+class ImmediateTaskPromise;
+
+/**
+ * Owns the frame of an ImmediateTask coroutine, which is destroyed with it.
+ */
+template <typename T>
+class ImmediateTaskFrame {
+ public:
+  using Handle = folly::coro::coroutine_handle<ImmediateTaskPromise<T>>;
+
+  explicit ImmediateTaskFrame(Handle handle) noexcept : handle_{handle} {}
+
+  ImmediateTaskFrame(ImmediateTaskFrame&& other) noexcept
+      : handle_{std::exchange(other.handle_, {})} {}
+
+  ImmediateTaskFrame& operator=(ImmediateTaskFrame&& other) noexcept {
+    if (this != &other) {
+      reset();
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+
+  ~ImmediateTaskFrame() {
+    reset();
+  }
+
+  Handle get() const {
+    return handle_;
+  }
+
+ private:
+  void reset() {
+    if (handle_) {
+      handle_.destroy();
+      handle_ = {};
+    }
+  }
+
+  Handle handle_;
+};
+
+/**
+ * Awaits an ImmediateFuture from an ImmediateTask coroutine.
+ *
+ * A ready future doesn't suspend the coroutine, its value is returned
+ * inline. Otherwise the coroutine will be resumed by the SemiFuture
+ * returned from the ImmediateTask, once it is executed.
+ */
+template <typename T>
+class ImmediateFutureAwaiter {
+ public:
+  explicit ImmediateFutureAwaiter(ImmediateFuture<T>&& future) noexcept
+      : future_{std::move(future)} {}
+
+  bool await_ready() const {
+    return future_.isReady();
+  }
+
+  template <typename Promise>
+  void await_suspend(folly::coro::coroutine_handle<Promise> handle) {
+    handle.promise().suspendOn(std::move(future_).semi().defer(
+        [this](folly::Try<T>&& result) { result_ = std::move(result); }));
+  }
+
+  T await_resume() {
+    if (!result_) {
+      result_ = std::move(future_).getTry();
+    }
+    return std::move(*result_).value();
+  }
+
+ private:
+  ImmediateFuture<T> future_;
+  std::optional<folly::Try<T>> result_;
+};
+
+template <typename T>
+class ImmediateTaskPromiseBase {
+ public:
+  ImmediateTask<T> get_return_object() noexcept;
+
+  // The coroutine only starts once converted to an ImmediateFuture, and its
+  // frame is owned by an ImmediateTaskFrame until then.
+  folly::coro::suspend_always initial_suspend() noexcept {
+    return {};
+  }
+
+  folly::coro::suspend_always final_suspend() noexcept {
+    return {};
+  }
+
+  void unhandled_exception() noexcept {
+    result_.emplace(folly::exception_wrapper{std::current_exception()});
+  }
+
+  template <typename U>
+  ImmediateFutureAwaiter<U> await_transform(ImmediateFuture<U>&& future) {
+    return ImmediateFutureAwaiter<U>{std::move(future)};
+  }
+
+  template <typename U>
+  ImmediateFutureAwaiter<U> await_transform(folly::SemiFuture<U>&& future) {
+    return ImmediateFutureAwaiter<U>{ImmediateFuture<U>{std::move(future)}};
+  }
+
+  /** Called when the coroutine is suspended on a future that isn't ready. */
+  void suspendOn(folly::SemiFuture<folly::Unit>&& pending) {
+    pending_.emplace(std::move(pending));
+  }
+
+  std::optional<folly::SemiFuture<folly::Unit>> takePending() {
+    return std::exchange(pending_, std::nullopt);
+  }
+
+  folly::Try<T> takeResult() {
+    return std::move(*result_);
+  }
+
+ protected:
+  std::optional<folly::Try<T>> result_;
+
+ private:
+  std::optional<folly::SemiFuture<folly::Unit>> pending_;
+};
+
+template <typename T>
+class ImmediateTaskPromise : public ImmediateTaskPromiseBase<T> {
+ public:
+  template <typename U = T>
+  void return_value(U&& value) {
+    this->result_.emplace(std::forward<U>(value));
+  }
+};
+
+template <>
+class ImmediateTaskPromise<folly::Unit>
+    : public ImmediateTaskPromiseBase<folly::Unit> {
+ public:
+  void return_void() noexcept {
+    result_.emplace(folly::unit);
+  }
+};
+
+/**
+ * Runs the coroutine until it completes or is suspended on a future that
+ * isn't ready, in which case the rest of it is deferred on that future.
+ */
+template <typename T>
+ImmediateFuture<T> resumeImmediateTask(ImmediateTaskFrame<T> frame) {
+  auto handle = frame.get();
+  handle.resume();
+  auto& promise = handle.promise();
+  if (auto pending = promise.takePending()) {
+    return std::move(*pending).defer(
+        [frame = std::move(frame)](folly::Try<folly::Unit>&&) mutable {
+          return resumeImmediateTask(std::move(frame)).semi();
+        });
+  }
+  return promise.takeResult();
+}
+
+} // namespace detail
+
+/**
+ * Return type of a coroutine that can co_await ImmediateFuture and
+ * SemiFuture, and which is converted to an ImmediateFuture by its caller:
+ *
+ *   ImmediateTask<size_t> countEntries(TreeInodePtr inode) {
+ *     auto tree = co_await inode->getTree();
+ *     co_return tree->size();
+ *   }
+ *
+ *   ImmediateFuture<size_t> count = countEntries(inode);
+ *
+ * The coroutine runs inline from the conversion, and as long as the awaited
+ * futures are ready, up to its completion: the resulting ImmediateFuture is
+ * then ready too, and nothing was allocated besides the coroutine frame.
+ * Only awaiting a future that isn't ready costs a deferred continuation, on
+ * which the rest of the coroutine runs when the SemiFuture held by the
+ * resulting ImmediateFuture is executed.
+ *
+ * Arguments taken by reference must outlive the returned ImmediateFuture, as
+ * for the captures of a thenValue callback.
+ */
+template <typename T>
+class FOLLY_NODISCARD ImmediateTask {
+ public:
+  using promise_type = detail::ImmediateTaskPromise<T>;
+
+  /* implicit */ operator ImmediateFuture<T>() && {
+    return detail::resumeImmediateTask(std::move(frame_));
+  }
+
+ private:
+  friend class detail::ImmediateTaskPromiseBase<T>;
+
+  explicit ImmediateTask(typename detail::ImmediateTaskFrame<T>::Handle handle)
+      : frame_{handle} {}
+
+  detail::ImmediateTaskFrame<T> frame_;
+};
+
+namespace detail {
+template <typename T>
+ImmediateTask<T> ImmediateTaskPromiseBase<T>::get_return_object() noexcept {
+  return ImmediateTask<T>{ImmediateTaskFrame<T>::Handle::from_promise(
+      static_cast<ImmediateTaskPromise<T>&>(*this))};
+}
+} // namespace detail
+
+} // namespace facebook::eden
+
+#endif
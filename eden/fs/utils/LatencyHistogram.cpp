@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/LatencyHistogram.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace facebook::eden {
+
+uint64_t LatencyHistogram::getCount() const noexcept {
+  uint64_t count = 0;
+  for (const auto& bucket : buckets_) {
+    count += bucket.load(std::memory_order_relaxed);
+  }
+  return count;
+}
+
+uint64_t LatencyHistogram::getPercentile(double percentile) const noexcept {
+  std::array<uint64_t, kNumBuckets> counts;
+  uint64_t total = 0;
+  for (size_t i = 0; i < kNumBuckets; ++i) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  percentile = std::min(std::max(percentile, 0.0), 100.0);
+  auto rank = std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(percentile / 100.0 * total)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kNumBuckets - 1; ++i) {
+    seen += counts[i];
+    if (seen >= rank) {
+      return bucketLowerBound(i + 1) - 1;
+    }
+  }
+  return bucketLowerBound(kNumBuckets - 1);
+}
+
+void LatencyHistogram::clear() noexcept {
+  for (auto& bucket : buckets_) {
+    bucket.store(0, std::memory_order_relaxed);
+  }
+}
+
+} // namespace facebook::eden
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/lang/Bits.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace facebook::eden {
+
+/**
+ * A fixed-size histogram of latencies in the style of HdrHistogram: values,
+ * in microseconds, are counted in buckets whose width doubles every
+ * kSubBuckets buckets, so every recorded value is known within 1/kSubBuckets
+ * of its magnitude, from 1us to over an hour.
+ *
+ * Recording a value is a single relaxed atomic increment and never allocates,
+ * so this can be updated from every request. It is safe to record and read
+ * concurrently; readers may observe some concurrently recorded values but not
+ * others.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr size_t kSubBucketBits = 3;
+  static constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+  /**
+   * Values from 2^kMaxValueBits microseconds, about 71 minutes, on are
+   * counted in the last bucket.
+   */
+  static constexpr size_t kMaxValueBits = 32;
+  static constexpr size_t kNumBuckets =
+      (kMaxValueBits - kSubBucketBits + 1) * kSubBuckets;
+
+  void record(std::chrono::nanoseconds latency) noexcept {
+    auto us = std::chrono::duration_cast<std::chrono::microseconds>(latency);
+    buckets_[bucketIndex(us.count() < 0 ? 0 : us.count())].fetch_add(
+        1, std::memory_order_relaxed);
+  }
+
+  /**
+   * The number of values recorded so far.
+   */
+  uint64_t getCount() const noexcept;
+
+  /**
+   * Return the highest latency, in microseconds, that is equivalent to the
+   * value at the given percentile (0 to 100) of the recorded values. Returns
+   * 0 if nothing was recorded.
+   */
+  uint64_t getPercentile(double percentile) const noexcept;
+
+  void clear() noexcept;
+
+  static size_t bucketIndex(uint64_t us) noexcept {
+    if (us < kSubBuckets) {
+      return us;
+    }
+    if (us >= (uint64_t{1} << kMaxValueBits)) {
+      return kNumBuckets - 1;
+    }
+    size_t msb = folly::findLastSet(us) - 1;
+    size_t shift = msb - kSubBucketBits;
+    return (shift + 1) * kSubBuckets + ((us >> shift) & (kSubBuckets - 1));
+  }
+
+  /**
+   * The lowest value, in microseconds, counted in the given bucket.
+   */
+  static uint64_t bucketLowerBound(size_t index) noexcept {
+    if (index < kSubBuckets) {
+      return index;
+    }
+    size_t shift = index / kSubBuckets - 1;
+    return (kSubBuckets + index % kSubBuckets) << shift;
+  }
+
+ private:
+  std::array<std::atomic<uint64_t>, kNumBuckets> buckets_{};
+};
+
+} // namespace facebook::eden
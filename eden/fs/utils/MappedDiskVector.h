@@ -8,7 +8,11 @@
 #pragma once
 
 #include <folly/portability/Unistd.h>
+#include <algorithm>
+#include <mutex>
+#include <limits>
 #include <type_traits>
+#include <utility>
 
 #include <eden/fs/utils/Bug.h>
 #include <folly/Exception.h>
@@ -75,6 +79,28 @@ template <typename T, typename... OldVersions>
 struct Migrator;
 } // namespace detail
 
+/**
+ * How a MappedDiskVector maps its file.
+ */
+struct MappedDiskVectorOptions {
+  /**
+   * Read the whole file in when it is mapped (MAP_POPULATE), rather than
+   * faulting the records in as they are accessed.
+   */
+  bool populate{false};
+  /**
+   * Ask for the mapping to be backed by transparent huge pages
+   * (MADV_HUGEPAGE), which saves TLB misses on random accesses to a large
+   * table. Only effective on the file systems that support them.
+   */
+  bool hugePages{false};
+  /**
+   * Start reading the file in the background (MADV_WILLNEED), so that
+   * opening it doesn't wait for the reads like populate does.
+   */
+  bool willNeed{false};
+};
+
 /**
  * MappedDiskVector is roughly analogous to std::vector, except it's backed by
  * a persistent memory-mapped file.
@@ -127,6 +153,15 @@ class MappedDiskVector {
   static MappedDiskVector open(
       folly::StringPiece path,
       bool shouldPopulate = false) {
+    MappedDiskVectorOptions options;
+    options.populate = shouldPopulate;
+    return open<OldVersions...>(path, options);
+  }
+
+  template <typename... OldVersions>
+  static MappedDiskVector open(
+      folly::StringPiece path,
+      MappedDiskVectorOptions options) {
     folly::File file{path, O_RDWR | O_CREAT | O_CLOEXEC, 0600};
 
     if (!file.try_lock()) {
@@ -138,7 +173,7 @@ class MappedDiskVector {
         fstat(file.fd(), &st), "fstat failed on MappedDiskVector path ", path);
 
     if (st.st_size == 0) {
-      return initializeFromScratch(std::move(file));
+      return initializeFromScratch(std::move(file), options);
     }
 
     Header header;
@@ -185,7 +220,7 @@ class MappedDiskVector {
             header.recordSize));
       }
       return MappedDiskVector{
-          std::move(file), st.st_size, header.entryCount, shouldPopulate};
+          std::move(file), st.st_size, header.entryCount, options};
     }
 
     // Try to migrate from an old record format if any match.
@@ -246,6 +281,8 @@ class MappedDiskVector {
     end_ = other.end_;
     map_ = other.map_;
     mapSizeInBytes_ = other.mapSizeInBytes_;
+    options_ = other.options_;
+    dirty_ = other.takeDirtyRange();
 
     other.begin_ = nullptr;
     other.end_ = nullptr;
@@ -263,11 +300,14 @@ class MappedDiskVector {
     end_ = other.end_;
     map_ = other.map_;
     mapSizeInBytes_ = other.mapSizeInBytes_;
+    options_ = other.options_;
+    dirty_ = other.takeDirtyRange();
 
     other.begin_ = nullptr;
     other.end_ = nullptr;
     other.map_ = nullptr;
     other.mapSizeInBytes_ = 0;
+    return *this;
   }
 
   ~MappedDiskVector() {
@@ -285,6 +325,75 @@ class MappedDiskVector {
     return (mapSizeInBytes_ - sizeof(Header)) / sizeof(T);
   }
 
+  /**
+   * Size of the underlying file, in bytes.
+   */
+  size_t fileSizeInBytes() const {
+    return mapSizeInBytes_;
+  }
+
+  /**
+   * Shrink the file to the smallest whole number of growth increments that
+   * holds the current records, releasing the capacity left by pop_back().
+   * Returns the number of bytes released.
+   */
+  size_t shrinkToFit() {
+    constexpr size_t kGrowthSize = GROWTH_IN_PAGES * detail::kPageSize;
+    size_t usedSize = sizeof(Header) + size() * sizeof(T);
+    size_t newFileSize =
+        (usedSize + kGrowthSize - 1) / kGrowthSize * kGrowthSize;
+    if (newFileSize >= mapSizeInBytes_) {
+      return 0;
+    }
+
+    // The mapping must not extend past the end of the file, so unmap its
+    // tail first. Growth increments are a multiple of the system page size.
+    if (munmap(
+            static_cast<char*>(map_) + newFileSize,
+            mapSizeInBytes_ - newFileSize)) {
+      folly::throwSystemError("munmap failed when shrinking capacity");
+    }
+    size_t released = mapSizeInBytes_ - newFileSize;
+    mapSizeInBytes_ = newFileSize;
+
+    if (-1 == folly::ftruncateNoInt(file_.fd(), newFileSize)) {
+      folly::throwSystemError("ftruncateNoInt failed when shrinking capacity");
+    }
+    return released;
+  }
+
+  /**
+   * Record that the record at index was modified through operator[], so that
+   * the next flush() writes it out. Safe to call concurrently, as records may
+   * be modified concurrently.
+   */
+  void markDirty(size_t index) {
+    std::lock_guard lock{dirtyMutex_};
+    dirty_.begin = std::min(dirty_.begin, index);
+    dirty_.end = std::max(dirty_.end, index + 1);
+  }
+
+  /**
+   * Synchronously write out the records marked dirty or appended since the
+   * previous flush, and the header if the size changed, with one msync()
+   * covering all of them rather than one per modification. Returns the
+   * number of bytes synced.
+   */
+  size_t flush() {
+    auto dirty = takeDirtyRange();
+    size_t synced = 0;
+    if (dirty.header) {
+      synced += syncBytes(0, sizeof(Header));
+    }
+    dirty.end = std::min(dirty.end, size());
+    if (dirty.begin < dirty.end) {
+      synced += syncBytes(
+          sizeof(Header) + dirty.begin * sizeof(T),
+          sizeof(Header) + dirty.end * sizeof(T));
+    }
+    return synced;
+  }
+
   T& operator[](size_t index) {
     return begin_[index];
   }
@@ -338,6 +447,7 @@ class MappedDiskVector {
 
       begin_ = reinterpret_cast<T*>(static_cast<Header*>(newMap) + 1);
       end_ = begin_ + oldSize;
+      advise();
     }
 
     T* out = end_;
@@ -345,6 +455,8 @@ class MappedDiskVector {
     end_ = out + 1;
 
     ++header().entryCount;
+    markDirty(size() - 1);
+    markHeaderDirty();
   }
 
   void pop_back() {
@@ -353,6 +465,7 @@ class MappedDiskVector {
     XDCHECK_GT(end_, begin_);
     --end_;
     --header().entryCount;
+    markHeaderDirty();
   }
 
   T& front() {
@@ -385,7 +498,16 @@ class MappedDiskVector {
 
   static constexpr size_t GROWTH_IN_PAGES = 256;
 
-  static MappedDiskVector initializeFromScratch(folly::File file) {
+  /** Indices of the records to write out on the next flush(). */
+  struct DirtyRange {
+    size_t begin{std::numeric_limits<size_t>::max()};
+    size_t end{0};
+    bool header{false};
+  };
+
+  static MappedDiskVector initializeFromScratch(
+      folly::File file,
+      MappedDiskVectorOptions options = {}) {
     // Start the file large enough to handle the header and a little under one
     // round one of growth.
     constexpr size_t initialSize = GROWTH_IN_PAGES * detail::kPageSize;
@@ -413,15 +535,15 @@ class MappedDiskVector {
     }
 
     return MappedDiskVector{
-        std::move(file), initialSize, header.entryCount, false};
+        std::move(file), initialSize, header.entryCount, options};
   }
 
   explicit MappedDiskVector(
       folly::File file,
       off_t fileSize,
       size_t currentEntryCount,
-      bool populate)
-      : file_(std::move(file)) {
+      MappedDiskVectorOptions options)
+      : options_{options}, file_(std::move(file)) {
     // It's worth keeping the file and mapping a whole number of pages to
     // avoid wasting an partial page at the end.  Note that this is an
     // optimization and it doesn't matter if kPageSize differs from the
@@ -448,7 +570,7 @@ class MappedDiskVector {
         PROT_READ | PROT_WRITE,
         MAP_SHARED
 #ifdef MAP_POPULATE
-            | (populate ? MAP_POPULATE : 0)
+            | (options.populate ? MAP_POPULATE : 0)
 #endif
             ,
         file_.fd(),
@@ -457,9 +579,6 @@ class MappedDiskVector {
       folly::throwSystemError("mmap failed on file open");
     }
 
-#ifndef MAP_POPULATE
-    (void)populate;
-#endif
 
     // Throw no exceptions between assigning the fields.
 
@@ -475,6 +594,48 @@ class MappedDiskVector {
     XCHECK_LE(
         reinterpret_cast<char*>(end_),
         static_cast<char*>(map_) + mapSizeInBytes_);
+
+    advise();
+  }
+
+  /**
+   * Apply the madvise() options to the whole mapping. They are only hints,
+   * so failures are ignored.
+   */
+  void advise() {
+#ifdef MADV_HUGEPAGE
+    if (options_.hugePages) {
+      madvise(map_, mapSizeInBytes_, MADV_HUGEPAGE);
+    }
+#endif
+    if (options_.willNeed) {
+      madvise(map_, mapSizeInBytes_, MADV_WILLNEED);
+    }
+  }
+
+  void markHeaderDirty() {
+    std::lock_guard lock{dirtyMutex_};
+    dirty_.header = true;
+  }
+
+  DirtyRange takeDirtyRange() {
+    std::lock_guard lock{dirtyMutex_};
+    return std::exchange(dirty_, DirtyRange{});
+  }
+
+  /**
+   * msync() the pages holding the bytes [begin, end) of the file.
+   */
+  size_t syncBytes(size_t begin, size_t end) {
+    static const size_t systemPageSize = sysconf(_SC_PAGESIZE);
+    begin -= begin % systemPageSize;
+    end = std::min(
+        (end + systemPageSize - 1) / systemPageSize * systemPageSize,
+        mapSizeInBytes_);
+    if (msync(static_cast<char*>(map_) + begin, end - begin, MS_SYNC)) {
+      folly::throwSystemError("msync failed on MappedDiskVector");
+    }
+    return end - begin;
   }
 
   bool hasRoom(size_t amount) const {
@@ -519,6 +680,10 @@ class MappedDiskVector {
 
   void* map_{nullptr};
   size_t mapSizeInBytes_{0}; // must be nonzero, multiple of page size
+  MappedDiskVectorOptions options_;
+
+  std::mutex dirtyMutex_;
+  DirtyRange dirty_;
 
   folly::File file_;
 
@@ -561,8 +726,10 @@ struct Migrator<T, First, Rest...> {
       // temporary file over the original.
       // Set populate to true because migrating requires reading every element
       // anyway.
+      MappedDiskVectorOptions options;
+      options.populate = true;
       MappedDiskVector<First> original{
-          std::move(file), fileSize, currentEntryCount, true};
+          std::move(file), fileSize, currentEntryCount, options};
 
       auto tmpPath = folly::to<std::string>(path, ".tmp");
       auto newVector = MappedDiskVector<T>::createOrOverwrite(tmpPath);
@@ -7,6 +7,8 @@
 
 #include "eden/fs/utils/Memory.h"
 
+#include <folly/io/IOBuf.h>
+#include <folly/memory/Malloc.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -27,4 +29,21 @@ void assertZeroBits(const void* memory, size_t size) {
     abort();
   }
 }
+
+size_t estimateIndirectMemoryUsage(const folly::IOBuf& buf) {
+  size_t usage = 0;
+  const folly::IOBuf* current = &buf;
+  do {
+    if (current != &buf) {
+      usage += folly::goodMallocSize(sizeof(folly::IOBuf));
+    }
+    if (current->isManagedOne() && !current->isSharedOne()) {
+      usage += folly::goodMallocSize(current->capacity());
+    } else {
+      usage += current->length();
+    }
+    current = current->next();
+  } while (current != &buf);
+  return usage;
+}
 } // namespace facebook::eden
@@ -10,6 +10,10 @@
 #include <map>
 #include <string>
 
+namespace folly {
+class IOBuf;
+}
+
 namespace facebook::eden {
 
 /**
@@ -40,6 +44,13 @@ size_t estimateIndirectMemoryUsage(const StringType& s) {
   }
 }
 
+/**
+ * Estimates the heap memory held by an IOBuf chain beyond the head IOBuf:
+ * the whole allocation of the buffers only it references, but only the data
+ * it uses of the buffers it shares, since the other owners account for them.
+ */
+size_t estimateIndirectMemoryUsage(const folly::IOBuf& buf);
+
 template <typename KeyType, typename ValueType>
 size_t estimateIndirectMemoryUsage(
     const std::map<KeyType, ValueType>& entries) {
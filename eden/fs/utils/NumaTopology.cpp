@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/NumaTopology.h"
+
+#include <fmt/format.h>
+#include <folly/FileUtil.h>
+#include <folly/String.h>
+#include <folly/logging/xlog.h>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <string>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace facebook::eden {
+
+namespace {
+
+std::optional<int> parseNumber(std::string_view str) {
+  int value = 0;
+  auto end = str.data() + str.size();
+  auto [ptr, ec] = std::from_chars(str.data(), end, value);
+  if (ec != std::errc{} || ptr != end || value < 0) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+#ifdef __linux__
+constexpr std::string_view kNodeDir = "/sys/devices/system/node";
+
+std::optional<std::vector<int>> readList(const std::string& path) {
+  std::string contents;
+  if (!folly::readFile(path.c_str(), contents)) {
+    return std::nullopt;
+  }
+  return NumaTopology::parseList(contents);
+}
+
+NumaTopology readTopology() {
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    XLOG(WARN) << "unable to get the CPU affinity of the process: "
+               << folly::errnoStr(errno);
+    return NumaTopology{{}};
+  }
+  auto keepAllowed = [&](std::vector<int> cpus) {
+    cpus.erase(
+        std::remove_if(
+            cpus.begin(),
+            cpus.end(),
+            [&](int cpu) {
+              return cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed);
+            }),
+        cpus.end());
+    return cpus;
+  };
+
+  std::vector<std::vector<int>> nodes;
+  auto online = readList(fmt::format("{}/online", kNodeDir));
+  if (online) {
+    for (auto node : *online) {
+      auto cpus = readList(fmt::format("{}/node{}/cpulist", kNodeDir, node));
+      if (!cpus) {
+        XLOG(WARN) << "unable to read the CPUs of NUMA node " << node;
+        continue;
+      }
+      nodes.push_back(keepAllowed(std::move(*cpus)));
+    }
+  }
+  if (nodes.empty()) {
+    // Kernels built without NUMA support: a single node with all the CPUs.
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &allowed)) {
+        cpus.push_back(cpu);
+      }
+    }
+    nodes.push_back(std::move(cpus));
+  }
+  return NumaTopology{std::move(nodes)};
+}
+
+void setAffinity(const std::vector<int>& cpus, size_t index) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (auto cpu : cpus) {
+    CPU_SET(cpu, &set);
+  }
+  int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (err != 0) {
+    XLOG(WARN) << "unable to set the CPU affinity of thread " << index
+               << " to CPUs " << folly::join(",", cpus) << ": "
+               << folly::errnoStr(err);
+  }
+}
+#endif
+
+} // namespace
+
+NumaTopology::NumaTopology(std::vector<std::vector<int>> nodes)
+    : nodes_{std::move(nodes)} {
+  nodes_.erase(
+      std::remove_if(
+          nodes_.begin(),
+          nodes_.end(),
+          [](const std::vector<int>& cpus) { return cpus.empty(); }),
+      nodes_.end());
+}
+
+const NumaTopology& NumaTopology::get() {
+#ifdef __linux__
+  static const NumaTopology topology = readTopology();
+#else
+  static const NumaTopology topology{{}};
+#endif
+  return topology;
+}
+
+std::optional<std::vector<int>> NumaTopology::parseList(std::string_view list) {
+  std::vector<int> values;
+  while (!list.empty() &&
+         std::isspace(static_cast<unsigned char>(list.back()))) {
+    list.remove_suffix(1);
+  }
+  while (!list.empty()) {
+    auto comma = list.find(',');
+    auto range = list.substr(0, comma);
+    list = comma == std::string_view::npos ? std::string_view{}
+                                           : list.substr(comma + 1);
+    auto dash = range.find('-');
+    auto first = parseNumber(range.substr(0, dash));
+    auto last = dash == std::string_view::npos
+        ? first
+        : parseNumber(range.substr(dash + 1));
+    if (!first || !last || *last < *first) {
+      return std::nullopt;
+    }
+    for (int value = *first; value <= *last; ++value) {
+      values.push_back(value);
+    }
+  }
+  return values;
+}
+
+std::optional<int> NumaTopology::getCpuForThread(size_t index) const {
+  if (nodes_.empty()) {
+    return std::nullopt;
+  }
+  const auto& cpus = nodes_[getNodeForThread(index)];
+  return cpus[(index / nodes_.size()) % cpus.size()];
+}
+
+void NumaTopology::bindThreadToNode(size_t index) const {
+#ifdef __linux__
+  if (!nodes_.empty()) {
+    setAffinity(nodes_[getNodeForThread(index)], index);
+  }
+#else
+  (void)index;
+#endif
+}
+
+void NumaTopology::pinThreadToCpu(size_t index) const {
+#ifdef __linux__
+  if (auto cpu = getCpuForThread(index)) {
+    setAffinity({*cpu}, index);
+  }
+#else
+  (void)index;
+#endif
+}
+
+} // namespace facebook::eden
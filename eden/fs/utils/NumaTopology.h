@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace facebook::eden {
+
+/**
+ * The CPUs of each NUMA node that the process may run on, used to spread the
+ * threads of a pool over the nodes and keep each of them, and the memory it
+ * touches first, on one node.
+ *
+ * The kernel allocates the pages on the node of the thread that first
+ * touches them, so a pool whose threads are bound to nodes gets its buffers
+ * and the cache entries it fills allocated locally, without having to place
+ * them explicitly.
+ */
+class NumaTopology {
+ public:
+  /**
+   * The CPUs of each node. The nodes without any CPU are dropped.
+   */
+  explicit NumaTopology(std::vector<std::vector<int>> nodes);
+
+  /**
+   * The topology of the machine, read once from /sys/devices/system/node and
+   * restricted to the CPU affinity of the process. Empty when it can't be
+   * read, e.g. on other platforms than Linux.
+   */
+  static const NumaTopology& get();
+
+  /**
+   * Parse a list of CPUs or nodes in the kernel format, e.g. "0-3,8,10-11".
+   * Returns nullopt when malformed.
+   */
+  static std::optional<std::vector<int>> parseList(std::string_view list);
+
+  size_t getNodeCount() const {
+    return nodes_.size();
+  }
+
+  const std::vector<int>& getCpus(size_t node) const {
+    return nodes_.at(node);
+  }
+
+  /**
+   * The node of the thread at index of a pool: consecutive threads go to
+   * consecutive nodes, so that a pool of any size uses all of them evenly.
+   */
+  size_t getNodeForThread(size_t index) const {
+    return index % nodes_.size();
+  }
+
+  /**
+   * The CPU to pin the thread at index of a pool to: the threads are spread
+   * over the nodes, then over the CPUs of each node. nullopt when the
+   * topology is empty.
+   */
+  std::optional<int> getCpuForThread(size_t index) const;
+
+  /**
+   * Restrict the calling thread, the one at index of its pool, to the CPUs
+   * of its node. Does nothing when the topology is empty, or logs when the
+   * affinity can't be set.
+   */
+  void bindThreadToNode(size_t index) const;
+
+  /**
+   * Pin the calling thread, the one at index of its pool, to its CPU. Does
+   * nothing when the topology is empty, or logs when the affinity can't be
+   * set.
+   */
+  void pinThreadToCpu(size_t index) const;
+
+ private:
+  std::vector<std::vector<int>> nodes_;
+};
+
+} // namespace facebook::eden
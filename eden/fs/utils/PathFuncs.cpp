@@ -15,6 +15,7 @@
 #include <folly/portability/Stdlib.h>
 #include <folly/portability/Unistd.h>
 
+#include <cstring>
 #include <optional>
 
 #ifdef __APPLE__
@@ -43,6 +44,77 @@ std::string_view basename(std::string_view path) {
   return path;
 }
 
+namespace detail {
+namespace {
+
+constexpr uint64_t kEachByte = 0x0101010101010101;
+
+uint64_t loadWord(const char* data) {
+  uint64_t word;
+  std::memcpy(&word, data, sizeof(word));
+  return word;
+}
+
+/** Lowercases the ASCII uppercase letters among the 8 bytes of word. */
+uint64_t toLowerWord(uint64_t word) {
+  // Adding to the low 7 bits of each byte never carries into the next one,
+  // and sets the high bit of the bytes at least 'A', or above 'Z'.
+  auto low = word & (0x7f * kEachByte);
+  auto atLeastA = low + (0x80 - 'A') * kEachByte;
+  auto aboveZ = low + (0x80 - 'Z' - 1) * kEachByte;
+  // The non-ASCII bytes are left alone, as AsciiLessThanCaseInsensitive does.
+  auto isUpper = atLeastA & ~aboveZ & ~word & (0x80 * kEachByte);
+  return word | (isUpper >> 2);
+}
+
+/**
+ * Length of the longest prefix of [a, a + size) and [b, b + size) that is a
+ * multiple of 8 bytes and equal ignoring the ASCII case.
+ */
+size_t equalWordsPrefix(const char* a, const char* b, size_t size) {
+  size_t index = 0;
+  while (index + sizeof(uint64_t) <= size &&
+         toLowerWord(loadWord(a + index)) == toLowerWord(loadWord(b + index))) {
+    index += sizeof(uint64_t);
+  }
+  return index;
+}
+
+} // namespace
+
+int compareAsciiCaseInsensitive(std::string_view a, std::string_view b) {
+  auto size = std::min(a.size(), b.size());
+  for (auto index = equalWordsPrefix(a.data(), b.data(), size); index < size;
+       ++index) {
+    auto left = AsciiLessThanCaseInsensitive::toLower(a[index]);
+    auto right = AsciiLessThanCaseInsensitive::toLower(b[index]);
+    if (left != right) {
+      return left < right ? -1 : 1;
+    }
+  }
+  if (a.size() == b.size()) {
+    return 0;
+  }
+  return a.size() < b.size() ? -1 : 1;
+}
+
+bool equalsAsciiCaseInsensitive(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (auto index = equalWordsPrefix(a.data(), b.data(), a.size());
+       index < a.size();
+       ++index) {
+    if (AsciiLessThanCaseInsensitive::toLower(a[index]) !=
+        AsciiLessThanCaseInsensitive::toLower(b[index])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace detail
+
 AbsolutePath getcwd() {
   char cwd[PATH_MAX];
   if (!::getcwd(cwd, sizeof(cwd))) {
@@ -17,6 +17,7 @@
 #include <folly/String.h>
 #include <folly/hash/Hash.h>
 #include <folly/logging/xlog.h>
+#include <cstring>
 #include <iterator>
 #include <optional>
 #include <type_traits>
@@ -69,6 +70,44 @@ inline bool isAbsoluteRoot(std::string_view path) {
   return path == kRootStr;
 }
 
+/**
+ * Returns the first directory separator in [begin, end), or end if there is
+ * none. The path iterators scan with this rather than one byte at a time:
+ * memchr is vectorized, its implementation being picked for the CPU at
+ * runtime by the C library.
+ */
+inline const char* findDirSeparator(const char* begin, const char* end) {
+  if constexpr (folly::kIsWindows) {
+    while (begin != end && !isDirSeparator(*begin)) {
+      ++begin;
+    }
+    return begin;
+  } else {
+    auto found = static_cast<const char*>(
+        std::memchr(begin, kDirSeparator, static_cast<size_t>(end - begin)));
+    return found ? found : end;
+  }
+}
+
+/**
+ * Returns the last directory separator in [begin, end), or nullptr if there
+ * is none.
+ */
+inline const char* rfindDirSeparator(const char* begin, const char* end) {
+#ifdef __GLIBC__
+  return static_cast<const char*>(
+      memrchr(begin, kDirSeparator, static_cast<size_t>(end - begin)));
+#else
+  while (end != begin) {
+    --end;
+    if (isDirSeparator(*end)) {
+      return end;
+    }
+  }
+  return nullptr;
+#endif
+}
+
 inline size_t findPathSeparator(std::string_view str, size_t start = 0) {
   auto index = str.find(kDirSeparator, start);
   if (folly::kIsWindows) {
@@ -113,6 +152,20 @@ inline size_t rfindPathSeparator(std::string_view str) {
  */
 constexpr bool kPathsAreCopiedOnMove = folly::kIsDebug || folly::kIsSanitize;
 
+/**
+ * Returns "{a}{separator}{b}" with a single allocation of the exact size,
+ * which matters when composing the paths on the hot paths.
+ */
+inline std::string
+joinPathStrings(std::string_view a, char separator, std::string_view b) {
+  std::string result;
+  result.reserve(a.size() + 1 + b.size());
+  result.append(a);
+  result.push_back(separator);
+  result.append(b);
+  return result;
+}
+
 /**
  * Make a copy when kPathsAreCopiedOnMove is set or move otherwise
  */
@@ -269,6 +322,18 @@ struct AsciiLessThanCaseInsensitive {
 
 namespace detail {
 
+/**
+ * Three-way comparison of a and b ignoring the ASCII case, ordered like
+ * std::lexicographical_compare with AsciiLessThanCaseInsensitive. Returns a
+ * negative value if a is before b, 0 if they are equal and a positive value
+ * otherwise.
+ *
+ * The common prefix is skipped 8 bytes at a time.
+ */
+int compareAsciiCaseInsensitive(std::string_view a, std::string_view b);
+
+bool equalsAsciiCaseInsensitive(std::string_view a, std::string_view b);
+
 // Helper for equality testing, borrowed from
 // folly::detail::ComparableAsStringPiece in folly/Range.h
 template <typename A, typename B, typename Stored, typename Piece>
@@ -331,12 +396,8 @@ struct PathOperators {
           if (caseSensitive == CaseSensitivity::Sensitive) {
             return leftStringPiece < rightStringPiece;
           } else {
-            return std::lexicographical_compare(
-                leftStringPiece.begin(),
-                leftStringPiece.end(),
-                rightStringPiece.begin(),
-                rightStringPiece.end(),
-                AsciiLessThanCaseInsensitive{});
+            return compareAsciiCaseInsensitive(
+                       leftStringPiece, rightStringPiece) < 0;
           }
         }
 
@@ -357,12 +418,8 @@ struct PathOperators {
       if (caseSensitive == CaseSensitivity::Sensitive) {
         return leftStringPiece < rightStringPiece;
       } else {
-        return std::lexicographical_compare(
-            leftStringPiece.begin(),
-            leftStringPiece.end(),
-            rightStringPiece.begin(),
-            rightStringPiece.end(),
-            AsciiLessThanCaseInsensitive{});
+        return compareAsciiCaseInsensitive(
+                   leftStringPiece, rightStringPiece) < 0;
       }
     }
   }
@@ -401,12 +458,8 @@ struct PathOperators {
           if (caseSensitive == CaseSensitivity::Sensitive) {
             return leftStringPiece == rightStringPiece;
           } else {
-            return std::equal(
-                leftStringPiece.begin(),
-                leftStringPiece.end(),
-                rightStringPiece.begin(),
-                rightStringPiece.end(),
-                folly::AsciiCaseInsensitive{});
+            return equalsAsciiCaseInsensitive(
+                leftStringPiece, rightStringPiece);
           }
         }
 
@@ -427,12 +480,7 @@ struct PathOperators {
       if (caseSensitive == CaseSensitivity::Sensitive) {
         return leftStringPiece == rightStringPiece;
       } else {
-        return std::equal(
-            leftStringPiece.begin(),
-            leftStringPiece.end(),
-            rightStringPiece.begin(),
-            rightStringPiece.end(),
-            folly::AsciiCaseInsensitive{});
+        return equalsAsciiCaseInsensitive(leftStringPiece, rightStringPiece);
       }
     }
   }
@@ -918,9 +966,7 @@ class ComposedPathIterator {
     }
 
     ++pos_;
-    while (pos_ < path_.data() + path_.size() && !isDirSeparator(*pos_)) {
-      ++pos_;
-    }
+    pos_ = findDirSeparator(pos_, path_.data() + path_.size());
   }
 
   // Move the iterator backwards in the path.
@@ -941,9 +987,8 @@ class ComposedPathIterator {
     }
 
     --pos_;
-    while (pos_ > stopPos && !isDirSeparator(*pos_)) {
-      --pos_;
-    }
+    auto separator = rfindDirSeparator(stopPos + 1, pos_ + 1);
+    pos_ = separator ? separator : stopPos;
   }
 
   /// the path we're iterating over.
@@ -1104,9 +1149,7 @@ class PathComponentIterator {
     }
     ++end_;
     start_ = end_;
-    while (end_ != pathEnd_ && !isDirSeparator(*end_)) {
-      ++end_;
-    }
+    end_ = findDirSeparator(end_, pathEnd_);
   }
 
   // Move the iterator backwards in the path.
@@ -1119,9 +1162,8 @@ class PathComponentIterator {
 
     --start_;
     end_ = start_;
-    while (start_ != pathBegin_ && !isDirSeparator(*(start_ - 1))) {
-      --start_;
-    }
+    auto separator = rfindDirSeparator(pathBegin_, start_);
+    start_ = separator ? separator + 1 : pathBegin_;
   }
 
   /// the path we're iterating over.
@@ -1458,12 +1500,30 @@ class RelativePathBase : public ComposedPathBase<
           PathComponentPiece,
           typename std::iterator_traits<Iterator>::reference>::value>::type>
   RelativePathBase(Iterator begin, Iterator end) {
-    folly::fbvector<std::string_view> components;
-    while (begin != end) {
-      components.emplace_back(PathComponentPiece{*begin}.view());
-      ++begin;
+    if constexpr (std::is_base_of_v<
+                      std::forward_iterator_tag,
+                      typename std::iterator_traits<
+                          Iterator>::iterator_category>) {
+      // Size the path exactly before appending the components.
+      size_t size = 0;
+      for (auto it = begin; it != end; ++it) {
+        size += PathComponentPiece{*it}.view().size() + 1;
+      }
+      this->path_.reserve(size);
+      for (auto it = begin; it != end; ++it) {
+        if (it != begin) {
+          this->path_.push_back(kDirSeparator);
+        }
+        this->path_.append(PathComponentPiece{*it}.view());
+      }
+    } else {
+      folly::fbvector<std::string_view> components;
+      while (begin != end) {
+        components.emplace_back(PathComponentPiece{*begin}.view());
+        ++begin;
+      }
+      folly::join(kDirSeparatorStr, components, this->path_);
     }
-    folly::join(kDirSeparatorStr, components, this->path_);
   }
 
   /** Construct from a container that holds PathComponents.
@@ -1673,6 +1733,12 @@ class AbsolutePathBase : public ComposedPathBase<
           fmt::format("{}{}", this->view(), b.view()),
           detail::SkipPathSanityCheck());
     }
+    if constexpr (kAbsDirSeparator == kDirSeparator) {
+      // The components of b are already separated by kAbsDirSeparator.
+      return AbsolutePath(
+          detail::joinPathStrings(this->view(), kAbsDirSeparator, b.view()),
+          detail::SkipPathSanityCheck());
+    }
     return AbsolutePath(
         fmt::format(
             "{}{}{}",
@@ -1984,7 +2050,7 @@ RelativePath operator+(
   // PathComponents can never be empty, so this is always a simple
   // join around a "/" character.
   return RelativePath(
-      fmt::format("{}{}{}", a.view(), kDirSeparatorStr, b.view()),
+      detail::joinPathStrings(a.view(), kDirSeparator, b.view()),
       detail::SkipPathSanityCheck());
 }
 
@@ -2002,7 +2068,7 @@ RelativePath operator+(
     return a.copy();
   }
   return RelativePath(
-      fmt::format("{}{}{}", a.view(), kDirSeparatorStr, b.view()),
+      detail::joinPathStrings(a.view(), kDirSeparator, b.view()),
       detail::SkipPathSanityCheck());
 }
 
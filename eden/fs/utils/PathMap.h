@@ -8,7 +8,10 @@
 #pragma once
 #include <folly/FBVector.h>
 #include <folly/Portability.h>
+#include <folly/container/F14Map.h>
+#include <folly/memory/Malloc.h>
 #include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <iterator>
 #include <utility>
@@ -18,6 +21,13 @@
 
 namespace facebook::eden {
 
+/**
+ * Once a PathMap holds this many entries, it also maintains a hash index of
+ * its keys, so that a lookup in a very large directory doesn't pay for the
+ * dozen or more string comparisons of the binary search.
+ */
+constexpr size_t kPathMapIndexThreshold = 1024;
+
 /** An associative container that maps from one of our path types to an
  * arbitrary value type.
  *
@@ -31,6 +41,12 @@ namespace facebook::eden {
  *   it is better to pre-sort the data to be inserted.
  * - Since insert and erase operations move the vector contents around,
  *   those operations invalidate iterators.
+ * - Above kPathMapIndexThreshold entries, find() goes through a hash of the
+ *   key, folded according to the CaseSensitivity, to the position of the
+ *   entry. Iteration stays in sorted order, and keeping the index up to date
+ *   only adds a pass over the index to inserts and erases, which are
+ *   already linear. The const methods never modify the index, so they remain
+ *   safe to call concurrently.
  */
 template <typename Value, typename Key = PathComponent>
 class PathMap : private folly::fbvector<std::pair<Key, Value>> {
@@ -80,6 +96,11 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
   // Hold an instance of the comparator.
   Compare compare_;
 
+  // Position of the entry with a given key hash, or kAmbiguous when several
+  // keys share that hash. Empty while the map is below the threshold.
+  static constexpr size_t kAmbiguous = ~size_t{0};
+  folly::F14FastMap<uint64_t, size_t> index_;
+
  public:
   // Various type aliases to satisfy container concepts.
   using key_type = Key;
@@ -123,7 +144,8 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
   }
 
   // Inherit the underlying vector copy/assignment.
-  PathMap(const PathMap& other) : Vector(other), compare_(other.compare_) {}
+  PathMap(const PathMap& other)
+      : Vector(other), compare_(other.compare_), index_(other.index_) {}
   PathMap& operator=(const PathMap& other) {
     PathMap(other).swap(*this);
     return *this;
@@ -131,7 +153,9 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
 
   // inherit Move construction.
   PathMap(PathMap&& other) noexcept
-      : Vector(std::move(other)), compare_(other.compare_) {}
+      : Vector(std::move(other)),
+        compare_(other.compare_),
+        index_(std::move(other.index_)) {}
   PathMap& operator=(PathMap&& other) {
     other.swap(*this);
     return *this;
@@ -142,12 +166,10 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
   using Vector::capacity;
   using Vector::cbegin;
   using Vector::cend;
-  using Vector::clear;
   using Vector::crbegin;
   using Vector::crend;
   using Vector::empty;
   using Vector::end;
-  using Vector::erase;
   using Vector::max_size;
   using Vector::rbegin;
   using Vector::rend;
@@ -158,6 +180,21 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
   void swap(PathMap& other) noexcept {
     Vector::swap(other);
     std::swap(compare_, other.compare_);
+    index_.swap(other.index_);
+  }
+
+  void clear() noexcept {
+    Vector::clear();
+    index_.clear();
+  }
+
+  iterator erase(const_iterator position) {
+    return erase(position, std::next(position));
+  }
+
+  iterator erase(const_iterator first, const_iterator last) {
+    indexErasing(first, last);
+    return Vector::erase(first, last);
   }
 
   /**
@@ -179,24 +216,14 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
    * Does not allocate a copy of the key string.
    */
   iterator find(Piece key) {
-    auto iter = lower_bound(key);
-    if (iter != end() && !compare_(key, iter->first)) {
-      // Found it
-      return iter;
-    }
-    return end();
+    return begin() + findPosition(key);
   }
 
   /** Find using the Piece representation of a key.
    * Does not allocate a copy of the key string.
    */
   const_iterator find(Piece key) const {
-    auto iter = lower_bound(key);
-    if (iter != end() && !compare_(key, iter->first)) {
-      // Found it
-      return iter;
-    }
-    return end();
+    return begin() + findPosition(key);
   }
 
   /** Insert a new key-value pair.
@@ -204,7 +231,7 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
    * Returns a pair consisting of an iterator to the position for key and
    * a boolean that is true if an insert took place. */
   std::pair<iterator, bool> insert(const value_type& val) {
-    auto iter = lower_bound(val.first);
+    auto iter = insertionPoint(val.first);
 
     if (iter != end() && !compare_(val.first, iter->first)) {
       // Found it; leave it alone
@@ -212,7 +239,9 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
     }
 
     // Otherwise, iter is the insertion point
-    return std::make_pair(Vector::insert(iter, val), true);
+    iter = Vector::insert(iter, val);
+    indexInserted(iter);
+    return std::make_pair(iter, true);
   }
 
   /** Emplace a new key-value pair by constructing it in-place.
@@ -223,7 +252,7 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
    * a boolean that is true if an insert took place. */
   template <typename... Args>
   std::pair<iterator, bool> emplace(Piece key, Args&&... args) {
-    auto iter = lower_bound(key);
+    auto iter = insertionPoint(key);
 
     if (iter != end() && !compare_(key, iter->first)) {
       // Found it; leave it alone
@@ -233,13 +262,14 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
     // Otherwise, iter is the insertion point
     iter = Vector::emplace(
         iter, std::make_pair(Key(key), Value(std::forward<Args>(args)...)));
+    indexInserted(iter);
     return std::make_pair(iter, true);
   }
 
   /** Returns a reference to the map position for key, creating it needed.
    * If the key is already present, no additional allocations are performed. */
   mapped_type& operator[](Piece key) {
-    auto iter = lower_bound(key);
+    auto iter = insertionPoint(key);
 
     if (iter != end() && !compare_(key, iter->first)) {
       // Found it
@@ -248,6 +278,7 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
 
     // Not yet present, make a new one at the insertion point
     iter = Vector::insert(iter, std::make_pair(Key(key), mapped_type()));
+    indexInserted(iter);
     return iter->second;
   }
 
@@ -301,6 +332,134 @@ class PathMap : private folly::fbvector<std::pair<Key, Value>> {
     return compare_.caseSensitive_;
   }
 
+  /**
+   * The heap memory used by the entries and the index of the map, but not by
+   * what the keys and values themselves point to.
+   */
+  size_t getAllocatedMemorySize() const {
+    return folly::goodMallocSize(sizeof(value_type) * capacity()) +
+        index_.getAllocatedMemorySize();
+  }
+
+ private:
+  /**
+   * lower_bound, short-circuited for the keys that sort after all the others:
+   * populating the map in order, as is done from the already sorted entries
+   * of a Tree, is then linear rather than O(N log N).
+   */
+  iterator insertionPoint(Piece key) {
+    if (empty() || compare_(Vector::back().first, key)) {
+      return end();
+    }
+    return lower_bound(key);
+  }
+
+  /**
+   * FNV-1a of the key, consistent with isPathPieceEqual: the ASCII case is
+   * folded in case insensitive maps, and so are the directory separators on
+   * Windows, where paths are compared one component at a time.
+   */
+  uint64_t hashKey(Piece key) const {
+    bool insensitive =
+        compare_.caseSensitive_ == CaseSensitivity::Insensitive;
+    uint64_t hash = 0xcbf29ce484222325;
+    for (char c : key.view()) {
+      if (insensitive) {
+        c = AsciiLessThanCaseInsensitive::toLower(c);
+      }
+      if (folly::kIsWindows && c == '\\') {
+        c = '/';
+      }
+      hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+    }
+    return hash;
+  }
+
+  void addToIndex(size_type position) {
+    auto [iter, inserted] =
+        index_.emplace(hashKey((cbegin() + position)->first), position);
+    if (!inserted) {
+      iter->second = kAmbiguous;
+    }
+  }
+
+  // Account for the entry that was just inserted at iter.
+  void indexInserted(const_iterator iter) {
+    if (index_.empty()) {
+      if (size() >= kPathMapIndexThreshold) {
+        index_.reserve(size());
+        for (size_type position = 0; position < size(); ++position) {
+          addToIndex(position);
+        }
+      }
+      return;
+    }
+
+    size_type position = iter - cbegin();
+    if (position + 1 != size()) {
+      for (auto& entry : index_) {
+        if (entry.second != kAmbiguous && entry.second >= position) {
+          ++entry.second;
+        }
+      }
+    }
+    addToIndex(position);
+  }
+
+  // Account for the entries in [first, last), which are about to be erased.
+  // The index is dropped well below the threshold, so that a directory whose
+  // size goes back and forth around it doesn't rebuild its index every time.
+  void indexErasing(const_iterator first, const_iterator last) {
+    if (index_.empty()) {
+      return;
+    }
+    size_type from = first - cbegin();
+    size_type to = last - cbegin();
+    if (size() - (to - from) < kPathMapIndexThreshold / 2) {
+      index_.clear();
+      return;
+    }
+
+    for (auto position = from; position < to; ++position) {
+      auto iter = index_.find(hashKey((cbegin() + position)->first));
+      if (iter != index_.end() && iter->second == position) {
+        index_.erase(iter);
+      }
+    }
+    if (to != size()) {
+      for (auto& entry : index_) {
+        if (entry.second != kAmbiguous && entry.second >= to) {
+          entry.second -= to - from;
+        }
+      }
+    }
+  }
+
+  // Position of the entry for key, or size() if there is none.
+  size_type findPosition(Piece key) const {
+    if (!index_.empty()) {
+      auto iter = index_.find(hashKey(key));
+      if (iter == index_.end()) {
+        return size();
+      }
+      if (iter->second != kAmbiguous) {
+        auto position = iter->second;
+        Piece found{(cbegin() + position)->first};
+        return isPathPieceEqual(key, found, compare_.caseSensitive_)
+            ? position
+            : size();
+      }
+    }
+
+    auto iter = lower_bound(key);
+    if (iter != end() && !compare_(key, iter->first)) {
+      // Found it
+      return iter - cbegin();
+    }
+    return size();
+  }
+
+ public:
   /// Equality operator.
   template <typename V, typename K>
   friend bool operator==(const PathMap<V, K>& lhs, const PathMap<V, K>& rhs);
@@ -16,6 +16,7 @@
 #include <folly/String.h>
 #include <folly/logging/xlog.h>
 #include <folly/portability/Unistd.h>
+#include <fmt/format.h>
 #include "eden/fs/utils/FileUtils.h"
 
 #ifdef __APPLE__
@@ -218,6 +219,71 @@ std::optional<size_t> calculatePrivateBytes(
   }
   return count;
 }
+
+namespace {
+std::optional<double> parseAvg10(StringPiece line) {
+  for (auto field : folly::split<StringPiece>(' ', line)) {
+    if (field.removePrefix("avg10=")) {
+      auto value = folly::tryTo<double>(field);
+      if (value.hasValue()) {
+        return value.value();
+      }
+      return std::nullopt;
+    }
+  }
+  return std::nullopt;
+}
+} // namespace
+
+optional<MemoryPressure> parseMemoryPressure(StringPiece data) {
+  std::optional<double> some;
+  std::optional<double> full;
+  for (auto line : folly::split<StringPiece>('\n', data)) {
+    if (line.removePrefix("some ")) {
+      some = parseAvg10(line);
+    } else if (line.removePrefix("full ")) {
+      full = parseAvg10(line);
+    }
+  }
+  if (!some) {
+    return std::nullopt;
+  }
+  MemoryPressure pressure;
+  pressure.someAvg10 = *some;
+  pressure.fullAvg10 = full.value_or(0);
+  return pressure;
+}
+
+optional<std::string> parseCgroupV2Path(StringPiece data) {
+  for (auto line : folly::split<StringPiece>('\n', data)) {
+    if (line.removePrefix("0::")) {
+      return line.str();
+    }
+  }
+  return std::nullopt;
+}
+
+optional<uint64_t> parseStatCpuTicks(StringPiece data) {
+  // The command name is in parentheses and can contain spaces, the fields
+  // are counted from the state that follows it.
+  auto commandEnd = data.rfind(')');
+  if (commandEnd == StringPiece::npos) {
+    return std::nullopt;
+  }
+  std::vector<StringPiece> fields;
+  folly::split(' ', data.subpiece(commandEnd + 1), fields, true);
+  // utime and stime are the 14th and 15th fields, the state the 3rd.
+  constexpr size_t kUtimeIndex = 14 - 3;
+  if (fields.size() <= kUtimeIndex + 1) {
+    return std::nullopt;
+  }
+  auto utime = folly::tryTo<uint64_t>(fields[kUtimeIndex]);
+  auto stime = folly::tryTo<uint64_t>(fields[kUtimeIndex + 1]);
+  if (utime.hasError() || stime.hasError()) {
+    return std::nullopt;
+  }
+  return utime.value() + stime.value();
+}
 #endif
 
 std::optional<size_t> calculatePrivateBytes() {
@@ -233,4 +299,26 @@ std::optional<size_t> calculatePrivateBytes() {
   return std::nullopt;
 #endif
 }
+
+optional<MemoryPressure> readMemoryPressure() {
+#ifdef __linux__
+  std::string contents;
+  std::string cgroupFile;
+  if (folly::readFile(kLinuxProcCgroupPath.data(), cgroupFile)) {
+    if (auto cgroupPath = parseCgroupV2Path(cgroupFile)) {
+      auto pressurePath =
+          fmt::format("/sys/fs/cgroup{}/memory.pressure", *cgroupPath);
+      if (folly::readFile(pressurePath.c_str(), contents)) {
+        return parseMemoryPressure(contents);
+      }
+    }
+  }
+  if (folly::readFile(kLinuxMemoryPressurePath.data(), contents)) {
+    return parseMemoryPressure(contents);
+  }
+  return std::nullopt;
+#else
+  return std::nullopt;
+#endif
+}
 } // namespace facebook::eden::proc_util
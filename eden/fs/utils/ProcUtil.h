@@ -19,6 +19,8 @@ constexpr folly::StringPiece kVmRSSKey{"VmRSS"};
 constexpr folly::StringPiece kKBytes{"kB"};
 constexpr folly::StringPiece kLinuxProcStatusPath{"/proc/self/status"};
 constexpr folly::StringPiece kLinuxProcSmapsPath{"/proc/self/smaps"};
+constexpr folly::StringPiece kLinuxProcCgroupPath{"/proc/self/cgroup"};
+constexpr folly::StringPiece kLinuxMemoryPressurePath{"/proc/pressure/memory"};
 
 namespace proc_util {
 
@@ -53,6 +55,27 @@ std::optional<MemoryStats> readMemoryStats();
  */
 std::optional<size_t> calculatePrivateBytes();
 
+/**
+ * Memory pressure stall information (PSI), as reported by the Linux kernel.
+ */
+struct MemoryPressure {
+  /// Percentage of time over the last 10 seconds during which at least one
+  /// task was stalled waiting on memory.
+  double someAvg10 = 0;
+  /// Percentage of time over the last 10 seconds during which all non-idle
+  /// tasks were stalled waiting on memory.
+  double fullAvg10 = 0;
+};
+
+/**
+ * Read the memory pressure of the cgroup this process runs in, falling back
+ * to the system-wide memory pressure.
+ *
+ * Returns std::nullopt if PSI isn't available, which is always the case on
+ * non-Linux platforms.
+ */
+std::optional<MemoryPressure> readMemoryPressure();
+
 #ifndef _WIN32
 /**
  * Read a /proc/<pid>/statm file and return the results as a MemoryStats object.
@@ -117,6 +140,30 @@ std::vector<std::unordered_map<std::string, std::string>> loadProcSmaps(
 std::optional<size_t> calculatePrivateBytes(
     std::vector<std::unordered_map<std::string, std::string>> smapsListOfMaps);
 
+/**
+ * Parse the contents of a PSI file, such as /proc/pressure/memory or a
+ * cgroup's memory.pressure:
+ *
+ *   some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+ *   full avg10=0.00 avg60=0.00 avg300=0.00 total=0
+ *
+ * Returns std::nullopt if the "some" line can't be parsed. The "full" line is
+ * missing on older kernels, in which case fullAvg10 is 0.
+ */
+std::optional<MemoryPressure> parseMemoryPressure(folly::StringPiece data);
+
+/**
+ * Extract the cgroup v2 path (the "0::" entry) from the contents of a
+ * /proc/<pid>/cgroup file.
+ */
+std::optional<std::string> parseCgroupV2Path(folly::StringPiece data);
+
+/**
+ * Extract the user plus system CPU time, in clock ticks, from the contents of
+ * a /proc/<pid>/stat file.
+ */
+std::optional<uint64_t> parseStatCpuTicks(folly::StringPiece data);
+
 #endif
 
 } // namespace proc_util
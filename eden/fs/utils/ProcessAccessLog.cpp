@@ -7,96 +7,17 @@
 
 #include "ProcessAccessLog.h"
 
+#include <algorithm>
+#include <functional>
+
 #include <folly/Exception.h>
 #include <folly/MapUtil.h>
-#include <folly/MicroLock.h>
-#include <folly/ThreadLocal.h>
+#include <folly/lang/Bits.h>
 
 #include "eden/common/utils/ProcessNameCache.h"
 
 namespace facebook::eden {
 
-struct ThreadLocalBucket {
-  explicit ThreadLocalBucket(ProcessAccessLog* processAccessLog)
-      : state_{folly::in_place, processAccessLog} {}
-
-  ~ThreadLocalBucket() {
-    // This thread is going away, so merge our data into the parent.
-    mergeUpstream();
-  }
-
-  /**
-   * Returns whether the pid was newly-recorded in this thread-second or not.
-   */
-  bool add(
-      uint64_t secondsSinceStart,
-      pid_t pid,
-      ProcessAccessLog::AccessType type) {
-    auto state = state_.lock();
-
-    // isNewPid must be initialized because BucketedLog::add will not call
-    // Bucket::add if secondsSinceStart is too old and the sample is dropped.
-    // (In that case, it's unnecessary to record the process name.)
-    bool isNewPid = false;
-    state->buckets.add(secondsSinceStart, pid, isNewPid, type);
-    return isNewPid;
-  }
-
-  bool add(
-      uint64_t secondsSinceStart,
-      pid_t pid,
-      std::chrono::nanoseconds duration) {
-    auto state = state_.lock();
-
-    bool isNewPid = false;
-    state->buckets.add(secondsSinceStart, pid, isNewPid, duration);
-    return isNewPid;
-  }
-
-  void mergeUpstream() {
-    auto state = state_.lock();
-    if (!state->owner) {
-      return;
-    }
-    state->owner->state_.withWLock(
-        [&](auto& ownerState) { ownerState.buckets.merge(state->buckets); });
-    state->buckets.clear();
-  }
-
-  void clearOwnerIfMe(ProcessAccessLog* owner) {
-    auto state = state_.lock();
-    if (state->owner == owner) {
-      state->owner = nullptr;
-    }
-  }
-
- private:
-  /**
-   * Sadly, because getAllAccesses needs to access all of the buckets, it
-   * needs a mechanism to stop writers for the duration of the read.
-   *
-   * Reading the data (merging up-stream from all of the threads) is
-   * exceptionally rare, so this lock should largely stay uncontended. I
-   * considered using folly::SpinLock, but the documentation strongly suggests
-   * not. I am hoping that acquiring an uncontended MicroLock
-   * boils down to a single CAS, even though lock xchg can be painful by itself.
-   *
-   * This lock must always be acquired before the owner's buckets lock.
-   */
-  struct State {
-    explicit State(ProcessAccessLog* pal) : owner{pal} {}
-    ProcessAccessLog::Buckets buckets;
-    ProcessAccessLog* owner;
-  };
-
-  folly::Synchronized<State, folly::MicroLock> state_;
-};
-
-namespace {
-struct BucketTag;
-folly::ThreadLocalPtr<ThreadLocalBucket, BucketTag> threadLocalBucketPtr;
-} // namespace
-
 void ProcessAccessLog::Bucket::clear() {
   accessCountsByPid.clear();
 }
@@ -116,17 +37,32 @@ void ProcessAccessLog::Bucket::add(
     std::chrono::nanoseconds duration) {
   auto [it, contains] = accessCountsByPid.emplace(pid, PerBucketAccessCounts{});
   it->second.duration += duration;
+  it->second.latencies[getLatencyBucket(duration)]++;
+  isNewPid = contains;
+}
+
+void ProcessAccessLog::Bucket::add(
+    pid_t pid,
+    bool& isNewPid,
+    uint64_t bytesRead) {
+  auto [it, contains] = accessCountsByPid.emplace(pid, PerBucketAccessCounts{});
+  it->second.bytesRead += bytesRead;
   isNewPid = contains;
 }
 
 void ProcessAccessLog::Bucket::merge(const Bucket& other) {
-  for (auto [pid, otherAccessCounts] : other.accessCountsByPid) {
+  for (const auto& [pid, otherAccessCounts] : other.accessCountsByPid) {
+    auto& accessCounts = accessCountsByPid[pid];
     for (std::underlying_type_t<AccessType> type = 0;
          type != folly::to_underlying(AccessType::Last);
          type++) {
-      accessCountsByPid[pid].counts[type] += otherAccessCounts.counts[type];
+      accessCounts.counts[type] += otherAccessCounts.counts[type];
+    }
+    accessCounts.duration += otherAccessCounts.duration;
+    accessCounts.bytesRead += otherAccessCounts.bytesRead;
+    for (size_t i = 0; i < kLatencyBucketCount; ++i) {
+      accessCounts.latencies[i] += otherAccessCounts.latencies[i];
     }
-    accessCountsByPid[pid].duration += otherAccessCounts.duration;
   }
 }
 
@@ -136,19 +72,16 @@ ProcessAccessLog::ProcessAccessLog(
   XCHECK(processNameCache_) << "Process name cache is mandatory";
 }
 
-ProcessAccessLog::~ProcessAccessLog() {
-  for (auto& tlb : threadLocalBucketPtr.accessAllThreads()) {
-    tlb.clearOwnerIfMe(this);
-  }
-}
+ProcessAccessLog::~ProcessAccessLog() {}
 
-ThreadLocalBucket* ProcessAccessLog::getTlb() {
-  auto tlb = threadLocalBucketPtr.get();
-  if (!tlb) {
-    threadLocalBucketPtr.reset(std::make_unique<ThreadLocalBucket>(this));
-    tlb = threadLocalBucketPtr.get();
-  }
-  return tlb;
+template <typename T>
+bool ProcessAccessLog::add(pid_t pid, T value) {
+  // isNewPid must be initialized because BucketedLog::add will not call
+  // Bucket::add if secondsSinceStart is too old and the sample is dropped.
+  // (In that case, it's unnecessary to record the process name.)
+  bool isNewPid = false;
+  buckets_.add(getSecondsSinceEpoch(), pid, isNewPid, value);
+  return isNewPid;
 }
 
 uint64_t ProcessAccessLog::getSecondsSinceEpoch() {
@@ -164,7 +97,7 @@ void ProcessAccessLog::recordAccess(
   // write-often, read-rarely use case, so, to avoid synchronization overhead,
   // record to thread-local storage and only merge into the access log when the
   // calling thread dies or when the data must be read.
-  bool isNewPid = getTlb()->add(getSecondsSinceEpoch(), pid, type);
+  bool isNewPid = add(pid, type);
 
   // Many processes are short-lived, so grab the executable name during the
   // access. We could potentially get away with grabbing executable names a
@@ -187,57 +120,129 @@ void ProcessAccessLog::recordAccess(
 void ProcessAccessLog::recordDuration(
     pid_t pid,
     std::chrono::nanoseconds duration) {
-  bool isNewPid = getTlb()->add(getSecondsSinceEpoch(), pid, duration);
+  bool isNewPid = add(pid, duration);
   if (pid != 0 && isNewPid) {
     processNameCache_->add(pid);
   }
 }
 
-std::unordered_map<pid_t, AccessCounts> ProcessAccessLog::getAccessCounts(
+ProcessAccessLog::Bucket ProcessAccessLog::mergeRecentBuckets(
     std::chrono::seconds lastNSeconds) {
   auto secondCount = lastNSeconds.count();
-  // First, merge all the thread-local buckets into their owners, including us.
-  for (auto& tlb : threadLocalBucketPtr.accessAllThreads()) {
-    // This must be done outside of acquiring our own state_ lock.
-    tlb.mergeUpstream();
+  Bucket bucket;
+  if (secondCount <= 0) {
+    return bucket;
   }
 
-  auto state = state_.wlock();
-  auto allBuckets = state->buckets.getAll(getSecondsSinceEpoch());
+  // Merge the buckets in place rather than copying all of them first.
+  buckets_.withMergedLog([&](auto& buckets) {
+    buckets.forEachRecent(
+        getSecondsSinceEpoch(),
+        static_cast<size_t>(std::min<int64_t>(secondCount, kBucketCount)),
+        [&](const Bucket& recent) { bucket.merge(recent); });
+  });
+  return bucket;
+}
 
-  if (secondCount < 0) {
-    return {};
+AccessCounts ProcessAccessLog::toAccessCounts(
+    const PerBucketAccessCounts& counts) {
+  // The counts accessors aren't const.
+  auto accessCounts = counts;
+  AccessCounts result;
+  result.fsChannelReads_ref() = accessCounts[AccessType::FsChannelRead];
+  result.fsChannelWrites_ref() = accessCounts[AccessType::FsChannelWrite];
+  result.fsChannelTotal_ref() = accessCounts[AccessType::FsChannelRead] +
+      accessCounts[AccessType::FsChannelWrite] +
+      accessCounts[AccessType::FsChannelOther];
+  result.fsChannelMemoryCacheImports_ref() =
+      accessCounts[AccessType::FsChannelMemoryCacheImport];
+  result.fsChannelDiskCacheImports_ref() =
+      accessCounts[AccessType::FsChannelDiskCacheImport];
+  result.fsChannelBackingStoreImports_ref() =
+      accessCounts[AccessType::FsChannelBackingStoreImport];
+  result.fsChannelDurationNs_ref() = accessCounts.duration.count();
+  result.fsChannelBytesRead_ref() = accessCounts.bytesRead;
+
+  uint64_t requests = 0;
+  for (auto latencyCount : accessCounts.latencies) {
+    requests += latencyCount;
+  }
+  if (requests == 0) {
+    return result;
   }
 
-  Bucket bucket;
-  uint64_t count = std::min(
-      static_cast<uint64_t>(allBuckets.size()),
-      static_cast<uint64_t>(secondCount));
-  for (auto iter = allBuckets.end() - count; iter != allBuckets.end(); ++iter) {
-    bucket.merge(*iter);
+  // Report the upper bound of the bucket holding each percentile.
+  auto percentile = [&](double fraction) -> int64_t {
+    auto rank = static_cast<uint64_t>(fraction * (requests - 1));
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < kLatencyBucketCount; ++bucket) {
+      seen += accessCounts.latencies[bucket];
+      if (seen > rank) {
+        return (int64_t{1} << bucket) * 1000;
+      }
+    }
+    return (int64_t{1} << (kLatencyBucketCount - 1)) * 1000;
+  };
+  result.fsChannelLatencyP50Ns_ref() = percentile(0.5);
+  result.fsChannelLatencyP90Ns_ref() = percentile(0.9);
+  result.fsChannelLatencyP99Ns_ref() = percentile(0.99);
+  return result;
+}
+
+void ProcessAccessLog::recordBytesRead(pid_t pid, uint64_t bytes) {
+  bool isNewPid = add(pid, bytes);
+  if (pid != 0 && isNewPid) {
+    processNameCache_->add(pid);
   }
+}
+
+size_t ProcessAccessLog::getLatencyBucket(std::chrono::nanoseconds duration) {
+  auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration);
+  if (us.count() <= 0) {
+    return 0;
+  }
+  return std::min<size_t>(
+      folly::findLastSet(static_cast<uint64_t>(us.count())),
+      kLatencyBucketCount - 1);
+}
+
+std::unordered_map<pid_t, AccessCounts> ProcessAccessLog::getAccessCounts(
+    std::chrono::seconds lastNSeconds) {
+  auto bucket = mergeRecentBuckets(lastNSeconds);
 
   // Transfer to a Thrift map
   std::unordered_map<pid_t, AccessCounts> accessCountsByPid;
   for (auto& [pid, accessCounts] : bucket.accessCountsByPid) {
-    accessCountsByPid[pid].fsChannelReads_ref() =
-        accessCounts[AccessType::FsChannelRead];
-    accessCountsByPid[pid].fsChannelWrites_ref() =
-        accessCounts[AccessType::FsChannelWrite];
-    accessCountsByPid[pid].fsChannelTotal_ref() =
-        accessCounts[AccessType::FsChannelRead] +
-        accessCounts[AccessType::FsChannelWrite] +
-        accessCounts[AccessType::FsChannelOther];
-    accessCountsByPid[pid].fsChannelMemoryCacheImports_ref() =
-        accessCounts[AccessType::FsChannelMemoryCacheImport];
-    accessCountsByPid[pid].fsChannelDiskCacheImports_ref() =
-        accessCounts[AccessType::FsChannelDiskCacheImport];
-    accessCountsByPid[pid].fsChannelBackingStoreImports_ref() =
-        accessCounts[AccessType::FsChannelBackingStoreImport];
-    accessCountsByPid[pid].fsChannelDurationNs_ref() =
-        accessCounts.duration.count();
+    accessCountsByPid[pid] = toAccessCounts(accessCounts);
   }
   return accessCountsByPid;
 }
 
+std::vector<std::pair<pid_t, AccessCounts>>
+ProcessAccessLog::getTopAccessCountsByDuration(
+    std::chrono::seconds lastNSeconds,
+    size_t count) {
+  auto bucket = mergeRecentBuckets(lastNSeconds);
+
+  std::vector<std::pair<std::chrono::nanoseconds, pid_t>> durations;
+  durations.reserve(bucket.accessCountsByPid.size());
+  for (auto& [pid, accessCounts] : bucket.accessCountsByPid) {
+    durations.emplace_back(accessCounts.duration, pid);
+  }
+  count = std::min(count, durations.size());
+  std::partial_sort(
+      durations.begin(),
+      durations.begin() + count,
+      durations.end(),
+      std::greater<>{});
+
+  std::vector<std::pair<pid_t, AccessCounts>> result;
+  result.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    auto pid = durations[i].second;
+    result.emplace_back(pid, toAccessCounts(bucket.accessCountsByPid[pid]));
+  }
+  return result;
+}
+
 } // namespace facebook::eden
@@ -8,25 +8,24 @@
 #pragma once
 
 #include <folly/Synchronized.h>
+#include <array>
 #include <type_traits>
+#include <vector>
 
 #include "eden/fs/service/gen-cpp2/eden_types.h"
-#include "eden/fs/utils/BucketedLog.h"
 #include "eden/fs/utils/EnumValue.h"
+#include "eden/fs/utils/ThreadLocalBucketedLog.h"
 
 namespace facebook::eden {
 
 class ProcessNameCache;
-struct ThreadLocalBucket;
 
 /**
  * An inexpensive mechanism for counting accesses by pids. Intended for counting
  * channel and Thrift calls from external processes.
  *
- * The first time a thread calls recordAccess, that thread is then coupled to
- * this particular ProcessAccessLog, even if it calls recordAccess on another
- * ProcessAccessLog instance. Thus, use one ProcessAccessLog per pool of
- * threads.
+ * Accesses are counted in thread-local buckets, which are only merged when
+ * the counts are read.
  */
 class ProcessAccessLog {
  public:
@@ -44,16 +43,24 @@ class ProcessAccessLog {
   ~ProcessAccessLog();
 
   /**
-   * Records an access by a process ID. The first call to recordAccess by a
-   * particular thread binds that thread to this access log. Future recordAccess
-   * calls on that thread will accumulate within this access log.
+   * Records an access by a process ID.
    *
    * Process IDs passed to recordAccess are also inserted into the
    * ProcessNameCache.
    */
   void recordAccess(pid_t pid, AccessType type);
+
+  /**
+   * Records the duration of one request, which is accumulated and added to
+   * the latency histogram of the pid.
+   */
   void recordDuration(pid_t pid, std::chrono::nanoseconds duration);
 
+  /**
+   * Records the bytes returned to a pid by a read request.
+   */
+  void recordBytesRead(pid_t pid, uint64_t bytes);
+
   /**
    * Returns the number of times each pid was passed to recordAccess() in
    * `lastNSeconds`.
@@ -64,10 +71,33 @@ class ProcessAccessLog {
   std::unordered_map<pid_t, AccessCounts> getAccessCounts(
       std::chrono::seconds lastNSeconds);
 
+  /**
+   * Returns the `count` pids whose requests took the longest in total in
+   * `lastNSeconds`, most expensive first, along with their access counts.
+   *
+   * Unlike getAccessCounts(), only the selected pids are converted, and the
+   * selection is done once the lock is released.
+   */
+  std::vector<std::pair<pid_t, AccessCounts>> getTopAccessCountsByDuration(
+      std::chrono::seconds lastNSeconds,
+      size_t count);
+
+  /**
+   * Latencies are bucketed by powers of two of microseconds: bucket i counts
+   * the requests that took less than 2^i us, and more than the previous
+   * bucket. The last bucket counts all the longer requests, which take more
+   * than 8 seconds.
+   */
+  static constexpr size_t kLatencyBucketCount = 24;
+
+  static size_t getLatencyBucket(std::chrono::nanoseconds duration);
+
  private:
   struct PerBucketAccessCounts {
     size_t counts[enumValue(AccessType::Last)];
     std::chrono::nanoseconds duration;
+    uint64_t bytesRead;
+    std::array<uint32_t, kLatencyBucketCount> latencies;
 
     size_t& operator[](AccessType type) {
       static_assert(std::is_unsigned_v<std::underlying_type_t<AccessType>>);
@@ -82,6 +112,7 @@ class ProcessAccessLog {
     void clear();
     void add(pid_t pid, bool& isNew, AccessType type);
     void add(pid_t pid, bool& isNew, std::chrono::nanoseconds duration);
+    void add(pid_t pid, bool& isNew, uint64_t bytesRead);
     void merge(const Bucket& other);
 
     std::unordered_map<pid_t, PerBucketAccessCounts> accessCountsByPid;
@@ -90,19 +121,27 @@ class ProcessAccessLog {
   // Keep up to ten seconds of data, but use a power of two so BucketedLog
   // generates smaller, faster code.
   static constexpr uint64_t kBucketCount = 16;
-  using Buckets = BucketedLog<Bucket, kBucketCount>;
-
-  struct State {
-    Buckets buckets;
-  };
+  using Buckets = ThreadLocalBucketedLog<Bucket, kBucketCount>;
 
   const std::shared_ptr<ProcessNameCache> processNameCache_;
-  folly::Synchronized<State> state_;
+  Buckets buckets_;
 
   uint64_t getSecondsSinceEpoch();
-  ThreadLocalBucket* getTlb();
 
-  friend struct ThreadLocalBucket;
+  /**
+   * Adds to the bucket of the calling thread, returning whether the pid was
+   * newly recorded in this thread-second.
+   */
+  template <typename T>
+  bool add(pid_t pid, T value);
+
+  /**
+   * Merges the thread-local buckets, then the `lastNSeconds` most recent
+   * buckets into one.
+   */
+  Bucket mergeRecentBuckets(std::chrono::seconds lastNSeconds);
+
+  static AccessCounts toAccessCounts(const PerBucketAccessCounts& counts);
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/RateLimitedSampler.h"
+
+#include <folly/Random.h>
+#include <algorithm>
+
+namespace facebook::eden {
+
+void RateLimitedSampler::Counts::add(
+    uint64_t seenCount,
+    uint64_t sampledCount,
+    uint64_t throttledCount) {
+  seen += seenCount;
+  sampled += sampledCount;
+  throttled += throttledCount;
+}
+
+void RateLimitedSampler::Counts::merge(const Counts& other) {
+  add(other.seen, other.sampled, other.throttled);
+}
+
+void RateLimitedSampler::Counts::clear() {
+  *this = Counts{};
+}
+
+RateLimitedSampler::RateLimitedSampler(std::chrono::seconds interval)
+    : intervalSeconds_{static_cast<uint64_t>(
+          std::max<std::chrono::seconds::rep>(interval.count(), 1))} {}
+
+bool RateLimitedSampler::sample(uint32_t denominator, uint32_t limit) {
+  auto now = getSecondsSinceEpoch();
+  if (denominator > 1 && folly::Random::rand32(denominator) != 0) {
+    counts_.add(now, 1, 0, 0);
+    return false;
+  }
+  auto acquired = tryAcquire(now, limit);
+  counts_.add(now, 1, acquired ? 1 : 0, acquired ? 0 : 1);
+  return acquired;
+}
+
+bool RateLimitedSampler::tryAcquire(uint64_t now, uint32_t limit) {
+  uint64_t interval = now / intervalSeconds_;
+  auto current = window_.load(std::memory_order_relaxed);
+  while (true) {
+    uint64_t next;
+    if ((current >> 32) < interval) {
+      if (limit == 0) {
+        return false;
+      }
+      next = (interval << 32) | 1;
+    } else if ((current & 0xffffffff) < limit) {
+      // Another thread may already have moved to the next interval, in which
+      // case this counts against it.
+      next = current + 1;
+    } else {
+      return false;
+    }
+    if (window_.compare_exchange_weak(
+            current, next, std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+}
+
+RateLimitedSampler::Counts RateLimitedSampler::getCounts(
+    std::chrono::seconds lastNSeconds) {
+  Counts result;
+  if (lastNSeconds.count() <= 0) {
+    return result;
+  }
+  auto count = static_cast<size_t>(
+      std::min<int64_t>(lastNSeconds.count(), kBucketCount));
+  counts_.withMergedLog([&](auto& log) {
+    log.forEachRecent(getSecondsSinceEpoch(), count, [&](const Counts& c) {
+      result.merge(c);
+    });
+  });
+  return result;
+}
+
+uint64_t RateLimitedSampler::getSecondsSinceEpoch() {
+  return std::chrono::duration_cast<std::chrono::seconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+} // namespace facebook::eden
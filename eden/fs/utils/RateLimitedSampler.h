@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "eden/fs/utils/ThreadLocalBucketedLog.h"
+
+namespace facebook::eden {
+
+/**
+ * Picks the events of a hot path to sample, such as the requests to log or
+ * trace: one in `denominator` of them at random, and no more than `limit`
+ * per interval, so that a burst of events doesn't turn into a burst of
+ * samples.
+ *
+ * Deciding is lock-free, and what was decided is counted per thread for the
+ * last kBucketCount seconds, so that the rate of samples dropped by the limit
+ * can be reported.
+ */
+class RateLimitedSampler {
+ public:
+  struct Counts {
+    /** Events passed to sample(). */
+    uint64_t seen{0};
+    uint64_t sampled{0};
+    /** Events picked at random, but over the limit of their interval. */
+    uint64_t throttled{0};
+
+    void
+    add(uint64_t seenCount, uint64_t sampledCount, uint64_t throttledCount);
+    void merge(const Counts& other);
+    void clear();
+  };
+
+  static constexpr size_t kBucketCount = 64;
+
+  explicit RateLimitedSampler(std::chrono::seconds interval);
+
+  RateLimitedSampler(const RateLimitedSampler&) = delete;
+  RateLimitedSampler& operator=(const RateLimitedSampler&) = delete;
+
+  /**
+   * Returns whether to sample this event. A denominator of 0 or 1 picks all
+   * the events, and a limit of 0 drops all of them.
+   */
+  bool sample(uint32_t denominator, uint32_t limit);
+
+  /**
+   * Returns the counts of the last `lastNSeconds`, up to kBucketCount.
+   */
+  Counts getCounts(std::chrono::seconds lastNSeconds);
+
+ private:
+  /**
+   * Takes one of the `limit` samples of the current interval.
+   */
+  bool tryAcquire(uint64_t now, uint32_t limit);
+
+  static uint64_t getSecondsSinceEpoch();
+
+  const uint64_t intervalSeconds_;
+
+  /**
+   * The index of the current interval in the high 32 bits, and the number of
+   * samples taken in it in the low 32 bits, so that both are updated by one
+   * compare-and-swap.
+   */
+  std::atomic<uint64_t> window_{0};
+
+  ThreadLocalBucketedLog<Counts, kBucketCount> counts_;
+};
+
+} // namespace facebook::eden
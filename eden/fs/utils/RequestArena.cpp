@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/RequestArena.h"
+
+#include <atomic>
+#include <new>
+
+namespace facebook::eden {
+
+struct alignas(std::max_align_t) RequestArena::Block {
+  explicit Block(size_t capacity) : capacity{capacity} {}
+
+  /**
+   * One per live allocation, plus one held by the arena while the block is
+   * its current one.
+   */
+  std::atomic<size_t> refs{1};
+  /** Only accessed by the thread owning the arena. */
+  size_t used{0};
+  const size_t capacity;
+
+  char* data() {
+    return reinterpret_cast<char*>(this + 1);
+  }
+};
+
+namespace {
+
+/** Precedes every allocation, keeping the allocations aligned. */
+struct alignas(std::max_align_t) Header {
+  void* block;
+};
+
+constexpr size_t kAlignment = alignof(std::max_align_t);
+
+constexpr size_t roundUp(size_t size) {
+  return (size + kAlignment - 1) & ~(kAlignment - 1);
+}
+
+} // namespace
+
+RequestArena::RequestArena(size_t blockSize)
+    : blockSize_{roundUp(blockSize)}, current_{newBlock(blockSize_)} {}
+
+RequestArena::~RequestArena() {
+  release(current_);
+}
+
+void* RequestArena::allocate(size_t size) {
+  auto needed = sizeof(Header) + roundUp(size);
+  Block* block;
+  if (needed > blockSize_ / 4) {
+    // The allocation is the only reference to its block.
+    block = newBlock(needed);
+  } else {
+    // Rewind as soon as the requests using the block are done, so that the
+    // memory they used is still in the cache for the next ones.
+    if (current_->refs.load(std::memory_order_acquire) == 1) {
+      current_->used = 0;
+    } else if (current_->used + needed > current_->capacity) {
+      auto* full = current_;
+      current_ = newBlock(blockSize_);
+      release(full);
+    }
+    block = current_;
+    block->refs.fetch_add(1, std::memory_order_relaxed);
+  }
+  auto* header = reinterpret_cast<Header*>(block->data() + block->used);
+  block->used += needed;
+  header->block = block;
+  return header + 1;
+}
+
+void RequestArena::deallocate(void* ptr) noexcept {
+  if (ptr) {
+    release(static_cast<Block*>((static_cast<Header*>(ptr) - 1)->block));
+  }
+}
+
+RequestArena::Block* RequestArena::newBlock(size_t capacity) {
+  void* memory = ::operator new(sizeof(Block) + capacity);
+  ++blockCount_;
+  return new (memory) Block{capacity};
+}
+
+void RequestArena::release(Block* block) noexcept {
+  if (block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    block->~Block();
+    ::operator delete(block);
+  }
+}
+
+} // namespace facebook::eden
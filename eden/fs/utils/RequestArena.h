@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+namespace facebook::eden {
+
+/**
+ * A monotonic allocator for the objects of the requests a thread reads, such
+ * as the FuseChannel worker threads, so that starting a request doesn't take
+ * a trip through the global allocator per object.
+ *
+ * Allocations are carved out of a block, and each one holds a reference to
+ * its block. Requests may complete on other threads, in any order: the
+ * memory of a single allocation is never reused, but once all the
+ * allocations of the current block are released it is rewound, and the next
+ * requests reuse its memory from the start. A block that fills up while some
+ * of its requests are still in flight is replaced by a new one, and freed by
+ * whoever releases its last allocation.
+ *
+ * allocate() may only be called by the thread that owns the arena, while
+ * deallocate() may be called from any thread, including after the arena is
+ * destroyed. Objects managed by RefPtr, which deletes them, can be allocated
+ * from an arena by declaring class-specific operator new and delete calling
+ * these.
+ */
+class RequestArena {
+ public:
+  static constexpr size_t kDefaultBlockSize = 16 * 1024;
+
+  explicit RequestArena(size_t blockSize = kDefaultBlockSize);
+  ~RequestArena();
+
+  RequestArena(const RequestArena&) = delete;
+  RequestArena& operator=(const RequestArena&) = delete;
+
+  /**
+   * Returns `size` bytes aligned to alignof(std::max_align_t). Allocations
+   * larger than a quarter of the block size get a block of their own.
+   */
+  void* allocate(size_t size);
+
+  /**
+   * Releases memory returned by allocate(), from any thread.
+   */
+  static void deallocate(void* ptr) noexcept;
+
+  /**
+   * The number of blocks this arena allocated over its lifetime, so that
+   * tests and benchmarks can check that its memory is reused.
+   */
+  size_t getBlockCount() const {
+    return blockCount_;
+  }
+
+  /**
+   * A standard allocator over a RequestArena, for std::allocate_shared and
+   * containers. All the copies refer to the same arena, which must outlive
+   * their calls to allocate(), but not to deallocate().
+   */
+  template <typename T>
+  class Allocator {
+   public:
+    using value_type = T;
+
+    explicit Allocator(RequestArena& arena) noexcept : arena_{&arena} {}
+
+    template <typename U>
+    /* implicit */ Allocator(const Allocator<U>& other) noexcept
+        : arena_{other.arena_} {}
+
+    T* allocate(size_t n) {
+      return static_cast<T*>(arena_->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t /* n */) noexcept {
+      RequestArena::deallocate(ptr);
+    }
+
+    template <typename U>
+    bool operator==(const Allocator<U>& other) const noexcept {
+      return arena_ == other.arena_;
+    }
+
+    template <typename U>
+    bool operator!=(const Allocator<U>& other) const noexcept {
+      return arena_ != other.arena_;
+    }
+
+   private:
+    template <typename U>
+    friend class Allocator;
+
+    RequestArena* arena_;
+  };
+
+ private:
+  struct Block;
+
+  Block* newBlock(size_t capacity);
+  static void release(Block* block) noexcept;
+
+  const size_t blockSize_;
+  size_t blockCount_{0};
+  Block* current_;
+};
+
+} // namespace facebook::eden
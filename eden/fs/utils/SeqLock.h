@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+
+namespace facebook::eden {
+
+/**
+ * A value published by a writer and read by any number of readers without
+ * taking a lock, as a sequence lock.
+ *
+ * Writers must be serialized by the caller, e.g. by only storing while holding
+ * the lock protecting the data the value is computed from. Readers never
+ * block the writers: a read that races with a write fails instead, and the
+ * reader is expected to fall back to reading the data under its lock.
+ *
+ * The value is copied word by word with relaxed atomics, and thus must be
+ * trivially copyable.
+ */
+template <typename T>
+class SeqLock {
+  static_assert(std::is_trivially_copyable_v<T>);
+
+ public:
+  /**
+   * Publish value. The caller serializes the writers.
+   */
+  void store(const T& value) {
+    Storage storage{};
+    storage.value = value;
+    storage.valid = true;
+    write(storage);
+  }
+
+  /**
+   * Make the readers fail until the next store(). The caller serializes the
+   * writers.
+   */
+  void invalidate() {
+    if (!lastWrittenValid_) {
+      return;
+    }
+    write(Storage{});
+  }
+
+  /**
+   * The published value, or std::nullopt if none is published or if the read
+   * raced with writes kMaxAttempts times in a row.
+   */
+  std::optional<T> load() const {
+    for (size_t attempt = 0; attempt < kMaxAttempts; ++attempt) {
+      auto seq = seq_.load(std::memory_order_acquire);
+      if (seq & 1) {
+        continue;
+      }
+
+      Words words;
+      for (size_t i = 0; i < kWordCount; ++i) {
+        words[i] = words_[i].load(std::memory_order_relaxed);
+      }
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (seq_.load(std::memory_order_relaxed) != seq) {
+        continue;
+      }
+
+      Storage storage;
+      std::memcpy(&storage, words, sizeof(storage));
+      if (!storage.valid) {
+        return std::nullopt;
+      }
+      return storage.value;
+    }
+    return std::nullopt;
+  }
+
+ private:
+  static constexpr size_t kMaxAttempts = 4;
+
+  struct Storage {
+    T value;
+    bool valid;
+  };
+
+  static constexpr size_t kWordCount =
+      (sizeof(Storage) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+  using Words = uint64_t[kWordCount];
+
+  void write(const Storage& storage) {
+    Words words{};
+    std::memcpy(words, &storage, sizeof(storage));
+
+    auto seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (size_t i = 0; i < kWordCount; ++i) {
+      words_[i].store(words[i], std::memory_order_relaxed);
+    }
+    seq_.store(seq + 2, std::memory_order_release);
+    lastWrittenValid_ = storage.valid;
+  }
+
+  // Odd while a write is in progress.
+  std::atomic<uint64_t> seq_{0};
+  std::atomic<uint64_t> words_[kWordCount]{};
+  // Only accessed by the serialized writers.
+  bool lastWrittenValid_{false};
+};
+
+} // namespace facebook::eden
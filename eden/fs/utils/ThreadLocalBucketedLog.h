@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <folly/MicroLock.h>
+#include <folly/Synchronized.h>
+#include <folly/ThreadLocal.h>
+#include <utility>
+
+#include "eden/fs/utils/BucketedLog.h"
+
+namespace facebook::eden {
+
+/**
+ * A BucketedLog for the write-often, read-rarely data of hot paths: each
+ * thread adds to a log of its own, and the logs of the threads are only
+ * merged into a shared one when it is read, or when their thread exits.
+ *
+ * The memory used is bounded by the number of threads times `Size` buckets.
+ */
+template <typename Bucket, size_t Size>
+class ThreadLocalBucketedLog {
+ public:
+  using Log = BucketedLog<Bucket, Size>;
+
+  ThreadLocalBucketedLog() = default;
+
+  ThreadLocalBucketedLog(const ThreadLocalBucketedLog&) = delete;
+  ThreadLocalBucketedLog& operator=(const ThreadLocalBucketedLog&) = delete;
+
+  /**
+   * Calls `.add(args...)` on the bucket of `now` in the log of the calling
+   * thread. See BucketedLog::add.
+   */
+  template <typename... Args>
+  void add(uint64_t now, Args&&... args) {
+    local_->log.lock()->add(now, std::forward<Args>(args)...);
+  }
+
+  /**
+   * Merges the logs of all the threads, then calls `fn` with the merged log
+   * while holding its lock.
+   */
+  template <typename Fn>
+  decltype(auto) withMergedLog(Fn&& fn) {
+    // Must be done before acquiring the lock of merged_.
+    for (auto& local : local_.accessAllThreads()) {
+      local.mergeUpstream();
+    }
+    return merged_.withWLock(std::forward<Fn>(fn));
+  }
+
+ private:
+  struct Local {
+    explicit Local(folly::Synchronized<Log>* owner) : owner{owner} {}
+
+    ~Local() {
+      // The thread or the owner is going away, don't lose what was logged.
+      mergeUpstream();
+    }
+
+    void mergeUpstream() {
+      auto locked = log.lock();
+      owner->withWLock([&](auto& merged) { merged.merge(*locked); });
+      locked->clear();
+    }
+
+    /**
+     * Only contended while the logs are merged, which is rare, hence the
+     * small lock. Must always be acquired before the lock of the owner.
+     */
+    folly::Synchronized<Log, folly::MicroLock> log;
+    folly::Synchronized<Log>* const owner;
+  };
+
+  struct Tag;
+
+  // Destroyed after local_, whose destruction merges into it.
+  folly::Synchronized<Log> merged_;
+  folly::ThreadLocal<Local, Tag, folly::AccessModeStrict> local_{
+      [this] { return new Local{&merged_}; }};
+};
+
+} // namespace facebook::eden
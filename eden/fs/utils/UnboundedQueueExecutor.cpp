@@ -10,21 +10,67 @@
 #include <folly/executors/CPUThreadPoolExecutor.h>
 #include <folly/executors/ManualExecutor.h>
 #include <folly/executors/task_queue/UnboundedBlockingQueue.h>
+#include <folly/executors/thread_factory/InitThreadFactory.h>
 #include <folly/executors/thread_factory/NamedThreadFactory.h>
+#include <atomic>
+
+#include "eden/fs/utils/NumaTopology.h"
+#include "eden/fs/utils/WorkStealingExecutor.h"
 
 namespace facebook::eden {
 
 UnboundedQueueExecutor::UnboundedQueueExecutor(
     size_t threadCount,
-    folly::StringPiece threadNamePrefix)
-    : executor_{std::make_unique<folly::CPUThreadPoolExecutor>(
+    folly::StringPiece threadNamePrefix,
+    Scheduling scheduling,
+    bool bindToNumaNodes) {
+  switch (scheduling) {
+    case Scheduling::SharedQueue: {
+      std::unique_ptr<folly::ThreadFactory> threadFactory =
+          std::make_unique<folly::NamedThreadFactory>(threadNamePrefix);
+      if (bindToNumaNodes) {
+        threadFactory = std::make_unique<folly::InitThreadFactory>(
+            std::shared_ptr<folly::ThreadFactory>{std::move(threadFactory)},
+            [next = std::make_shared<std::atomic<size_t>>(0)] {
+              NumaTopology::get().bindThreadToNode(
+                  next->fetch_add(1, std::memory_order_relaxed));
+            });
+      }
+      auto threadPool = std::make_shared<folly::CPUThreadPoolExecutor>(
           threadCount,
           std::make_unique<folly::UnboundedBlockingQueue<
               folly::CPUThreadPoolExecutor::CPUTask>>(),
-          std::make_unique<folly::NamedThreadFactory>(threadNamePrefix))} {}
+          std::move(threadFactory));
+      threadPool_ = threadPool.get();
+      executor_ = std::move(threadPool);
+      break;
+    }
+    case Scheduling::WorkStealing: {
+      auto workStealing = std::make_shared<WorkStealingExecutor>(
+          threadCount, threadNamePrefix, bindToNumaNodes);
+      workStealing_ = workStealing.get();
+      executor_ = std::move(workStealing);
+      break;
+    }
+  }
+}
 
 UnboundedQueueExecutor::UnboundedQueueExecutor(
     std::shared_ptr<folly::ManualExecutor> executor)
     : executor_{std::move(executor)} {}
 
+size_t UnboundedQueueExecutor::getPendingTaskCount() const {
+  if (threadPool_) {
+    return threadPool_->getPendingTaskCount();
+  }
+  if (workStealing_) {
+    return workStealing_->getPendingTaskCount();
+  }
+  return 0;
+}
+
+uint64_t UnboundedQueueExecutor::getStealCount() const {
+  return workStealing_ ? workStealing_->getStealCount() : 0;
+}
+
 } // namespace facebook::eden
@@ -11,11 +11,14 @@
 #include <folly/Range.h>
 
 namespace folly {
+class CPUThreadPoolExecutor;
 class ManualExecutor;
-}
+} // namespace folly
 
 namespace facebook::eden {
 
+class WorkStealingExecutor;
+
 /**
  * An Executor that is guaranteed to never block, nor throw (except OOM), nor
  * execute inline from `add()`.
@@ -25,13 +28,29 @@ namespace facebook::eden {
  */
 class UnboundedQueueExecutor : public folly::Executor {
  public:
+  enum class Scheduling {
+    /** All the threads take the functions from a single queue. */
+    SharedQueue,
+    /**
+     * Each thread has its own queue, see WorkStealingExecutor. Cheaper when
+     * many short functions are queued from several threads at once.
+     */
+    WorkStealing,
+  };
+
   /**
    * Instantiates with a folly::CPUThreadPoolExecutor with the given threadCount
-   * and threadNamePrefix but with an unlimited queue.
+   * and threadNamePrefix but with an unlimited queue, or a
+   * WorkStealingExecutor.
+   *
+   * With bindToNumaNodes, the threads are spread over the NUMA nodes and each
+   * is restricted to the CPUs of its node, see NumaTopology.
    */
   explicit UnboundedQueueExecutor(
       size_t threadCount,
-      folly::StringPiece threadNamePrefix);
+      folly::StringPiece threadNamePrefix,
+      Scheduling scheduling = Scheduling::SharedQueue,
+      bool bindToNumaNodes = false);
 
   /**
    * ManualExecutors are unbounded too.
@@ -50,8 +69,21 @@ class UnboundedQueueExecutor : public folly::Executor {
     executor_->add(std::move(func));
   }
 
+  /**
+   * Number of functions waiting to run. Always 0 for the ManualExecutor.
+   */
+  size_t getPendingTaskCount() const;
+
+  /**
+   * Number of functions run by another thread than the one they were queued
+   * to. Always 0 unless Scheduling::WorkStealing is used.
+   */
+  uint64_t getStealCount() const;
+
  private:
   std::shared_ptr<folly::Executor> executor_;
+  folly::CPUThreadPoolExecutor* threadPool_{nullptr};
+  WorkStealingExecutor* workStealing_{nullptr};
 };
 
 } // namespace facebook::eden
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/WorkStealingExecutor.h"
+
+#include <fmt/format.h>
+#include <folly/ExceptionString.h>
+#include <folly/logging/xlog.h>
+#include <folly/system/ThreadName.h>
+#include <algorithm>
+
+#include "eden/fs/utils/NumaTopology.h"
+
+namespace facebook::eden {
+
+namespace {
+
+/**
+ * Every this many functions, a thread takes the oldest one of its queue
+ * rather than the newest, so that a thread that keeps adding functions
+ * can't starve the ones at the front.
+ */
+constexpr uint64_t kFairnessInterval = 32;
+
+struct CurrentWorker {
+  const void* executor{nullptr};
+  size_t index{0};
+};
+
+thread_local CurrentWorker currentWorker;
+
+} // namespace
+
+WorkStealingExecutor::WorkStealingExecutor(
+    size_t threadCount,
+    folly::StringPiece threadNamePrefix,
+    bool bindToNumaNodes)
+    : threadNamePrefix_{threadNamePrefix.str()},
+      bindToNumaNodes_{bindToNumaNodes} {
+  threadCount = std::max(threadCount, size_t{1});
+  workers_.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  threads_.reserve(threadCount);
+  for (size_t i = 0; i < threadCount; ++i) {
+    threads_.emplace_back([this, i] { run(i); });
+  }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor() {
+  {
+    std::lock_guard lock{sleepMutex_};
+    stopping_ = true;
+  }
+  wakeUp_.notify_all();
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void WorkStealingExecutor::add(folly::Func func) {
+  auto index = currentWorker.executor == this
+      ? currentWorker.index
+      : nextWorker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+
+  pending_.fetch_add(1);
+  {
+    auto& worker = *workers_[index];
+    std::lock_guard lock{worker.mutex};
+    worker.tasks.push_back(std::move(func));
+  }
+
+  if (sleepers_.load() > 0) {
+    std::lock_guard lock{sleepMutex_};
+    wakeUp_.notify_one();
+  }
+}
+
+folly::Func WorkStealingExecutor::take(size_t index, uint64_t taken) {
+  folly::Func func;
+  {
+    auto& worker = *workers_[index];
+    std::lock_guard lock{worker.mutex};
+    if (!worker.tasks.empty()) {
+      if (taken % kFairnessInterval == kFairnessInterval - 1) {
+        func = std::move(worker.tasks.front());
+        worker.tasks.pop_front();
+      } else {
+        func = std::move(worker.tasks.back());
+        worker.tasks.pop_back();
+      }
+      return func;
+    }
+  }
+
+  for (size_t i = 1; i < workers_.size(); ++i) {
+    auto& victim = *workers_[(index + i) % workers_.size()];
+    std::lock_guard lock{victim.mutex};
+    if (!victim.tasks.empty()) {
+      func = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      steals_.fetch_add(1, std::memory_order_relaxed);
+      return func;
+    }
+  }
+  return func;
+}
+
+void WorkStealingExecutor::run(size_t index) {
+  folly::setThreadName(fmt::format("{}{}", threadNamePrefix_, index));
+  if (bindToNumaNodes_) {
+    NumaTopology::get().bindThreadToNode(index);
+  }
+  currentWorker = CurrentWorker{this, index};
+
+  uint64_t taken = 0;
+  while (true) {
+    if (auto func = take(index, taken)) {
+      ++taken;
+      pending_.fetch_sub(1);
+      try {
+        func();
+      } catch (const std::exception& ex) {
+        XLOG(ERR) << "WorkStealingExecutor function threw: "
+                  << folly::exceptionStr(ex);
+      } catch (...) {
+        XLOG(ERR) << "WorkStealingExecutor function threw a non-exception";
+      }
+      continue;
+    }
+
+    // Sleepers are counted before checking pending_, so that an add() that
+    // queued a function after that check always wakes this thread up.
+    std::unique_lock lock{sleepMutex_};
+    sleepers_.fetch_add(1);
+    wakeUp_.wait(lock, [this] { return pending_.load() > 0 || stopping_; });
+    sleepers_.fetch_sub(1);
+    if (stopping_ && pending_.load() == 0) {
+      return;
+    }
+  }
+}
+
+} // namespace facebook::eden
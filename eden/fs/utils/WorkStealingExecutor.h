@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <folly/Executor.h>
+#include <folly/Range.h>
+#include <folly/lang/Align.h>
+
+namespace facebook::eden {
+
+/**
+ * A thread pool where each thread has its own queue, rather than all of them
+ * contending on a shared one.
+ *
+ * A function added from one of the threads goes to the back of its queue,
+ * and the thread takes the most recent function first: the short tasks that
+ * fan out, like checkout and glob do per directory, run while their data is
+ * still in the cache. Functions added from other threads are spread over the
+ * queues in turn. An idle thread steals the oldest function of the other
+ * queues before going to sleep.
+ *
+ * Like an UnboundedQueueExecutor, add() never blocks nor runs the function
+ * inline.
+ */
+class WorkStealingExecutor : public folly::Executor {
+ public:
+  /**
+   * With bindToNumaNodes, the threads are spread over the NUMA nodes and each
+   * is restricted to the CPUs of its node, see NumaTopology.
+   */
+  WorkStealingExecutor(
+      size_t threadCount,
+      folly::StringPiece threadNamePrefix,
+      bool bindToNumaNodes = false);
+
+  /**
+   * Runs all the queued functions, including the ones they add, then joins
+   * the threads.
+   */
+  ~WorkStealingExecutor() override;
+
+  WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+  WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+  void add(folly::Func func) override;
+
+  /** Number of functions waiting in the queues. */
+  size_t getPendingTaskCount() const {
+    return pending_.load(std::memory_order_relaxed);
+  }
+
+  /** Number of functions a thread took from the queue of another one. */
+  uint64_t getStealCount() const {
+    return steals_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct alignas(folly::hardware_destructive_interference_size) Worker {
+    std::mutex mutex;
+    std::deque<folly::Func> tasks;
+  };
+
+  void run(size_t index);
+
+  /**
+   * Take the next function for the thread at index, from its own queue or
+   * from another one. Returns an empty function when all are empty.
+   */
+  folly::Func take(size_t index, uint64_t taken);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  std::string threadNamePrefix_;
+  const bool bindToNumaNodes_;
+
+  std::atomic<size_t> nextWorker_{0};
+  // Incremented before a function is queued, so that it never underflows.
+  std::atomic<size_t> pending_{0};
+  std::atomic<uint64_t> steals_{0};
+
+  std::atomic<size_t> sleepers_{0};
+  std::mutex sleepMutex_;
+  std::condition_variable wakeUp_;
+  bool stopping_{false};
+};
+
+} // namespace facebook::eden
@@ -160,3 +160,18 @@ TEST(BucketedLog, keeps_older_data_points_but_drops_expired_ones) {
   b.add(1, "e");
   EXPECT_EQ(bucketArray("a", "bd", "c"), b.getAll(4));
 }
+
+TEST(BucketedLog, for_each_recent_visits_the_most_recent_buckets_in_order) {
+  BucketedLog<Bucket, 3> b;
+  b.add(1, "a");
+  b.add(2, "b");
+  b.add(3, "c");
+
+  std::string visited;
+  b.forEachRecent(3, 2, [&](const Bucket& bucket) { visited += bucket.s; });
+  EXPECT_EQ("bc", visited);
+
+  visited.clear();
+  b.forEachRecent(4, 10, [&](const Bucket& bucket) { visited += bucket.s; });
+  EXPECT_EQ("bc", visited);
+}
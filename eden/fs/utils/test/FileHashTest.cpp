@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/FileHash.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+TEST(FileHash, buffer_fits_small_files_and_their_end) {
+  EXPECT_EQ(8192, getFileHashBufferSize(0));
+  EXPECT_EQ(8192, getFileHashBufferSize(8191));
+  EXPECT_EQ(16384, getFileHashBufferSize(8192));
+  EXPECT_EQ(106496, getFileHashBufferSize(100000));
+}
+
+TEST(FileHash, buffer_is_bounded_for_large_files) {
+  EXPECT_EQ(1024 * 1024, getFileHashBufferSize(1024 * 1024));
+  EXPECT_EQ(1024 * 1024, getFileHashBufferSize(uint64_t{1} << 40));
+}
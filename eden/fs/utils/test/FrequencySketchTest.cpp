@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/FrequencySketch.h"
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+TEST(FrequencySketchTest, unseen_keys_have_zero_estimate) {
+  FrequencySketch sketch{64};
+  EXPECT_EQ(0, sketch.estimate(1));
+  EXPECT_EQ(0, sketch.estimate(2));
+}
+
+TEST(FrequencySketchTest, estimate_tracks_increments) {
+  FrequencySketch sketch{64};
+  for (int i = 0; i < 5; ++i) {
+    sketch.increment(42);
+  }
+  sketch.increment(43);
+  EXPECT_EQ(5, sketch.estimate(42));
+  EXPECT_EQ(1, sketch.estimate(43));
+}
+
+TEST(FrequencySketchTest, counters_saturate) {
+  FrequencySketch sketch{64};
+  for (int i = 0; i < 100; ++i) {
+    sketch.increment(7);
+  }
+  EXPECT_EQ(FrequencySketch::kMaxCount, sketch.estimate(7));
+}
+
+TEST(FrequencySketchTest, counters_are_aged) {
+  FrequencySketch sketch{16};
+  for (int i = 0; i < 8; ++i) {
+    sketch.increment(1);
+  }
+  // Enough increments of another key to trigger an aging pass.
+  for (int i = 0; i < 10 * 16; ++i) {
+    sketch.increment(2);
+  }
+  EXPECT_EQ(4, sketch.estimate(1));
+}
+
+TEST(FrequencySketchTest, clear_resets_counters) {
+  FrequencySketch sketch{64};
+  sketch.increment(5);
+  sketch.clear();
+  EXPECT_EQ(0, sketch.estimate(5));
+}
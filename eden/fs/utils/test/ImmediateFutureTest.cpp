@@ -612,3 +612,24 @@ TEST(ImmediateFuture, constructionFromCompatible) {
 }
 
 } // namespace facebook::eden
+
+TEST(ImmediateFuture, pending_thenValue_chain) {
+  folly::Promise<int> promise;
+  ImmediateFuture<int> fut{promise.getSemiFuture()};
+  auto chained =
+      std::move(fut)
+          .thenValue([](int v) { return v + 1; })
+          .thenValue([](int v) -> ImmediateFuture<int> { return v + 1; })
+          .thenValue([](int v) { return folly::Try<int>{v + 1}; })
+          .thenValue([](int) {})
+          .thenTry([](folly::Try<folly::Unit>&& try_) -> ImmediateFuture<int> {
+            EXPECT_TRUE(try_.hasValue());
+            return 42;
+          })
+          .thenValue([](int v) -> int {
+            throw std::runtime_error(std::to_string(v));
+          });
+  EXPECT_FALSE(chained.isReady());
+  promise.setValue(0);
+  EXPECT_THROW_RE(std::move(chained).get(), std::runtime_error, "42");
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/ImmediateTask.h"
+
+#include <folly/portability/GTest.h>
+#include <folly/test/TestUtils.h>
+
+#if FOLLY_HAS_COROUTINES
+
+using namespace facebook::eden;
+
+namespace {
+
+struct DestructionCounter {
+  explicit DestructionCounter(int& count) : count{count} {}
+  ~DestructionCounter() {
+    ++count;
+  }
+  int& count;
+};
+
+ImmediateTask<int>
+add(ImmediateFuture<int> lhs, ImmediateFuture<int> rhs, int& destroyed) {
+  DestructionCounter counter{destroyed};
+  auto left = co_await std::move(lhs);
+  auto right = co_await std::move(rhs);
+  co_return left + right;
+}
+
+ImmediateTask<folly::Unit> throwIfSet(ImmediateFuture<int> value) {
+  if (co_await std::move(value)) {
+    throw std::logic_error("Test exception");
+  }
+}
+
+} // namespace
+
+TEST(ImmediateTask, ready_futures_complete_inline) {
+  int destroyed = 0;
+  ImmediateFuture<int> fut = add(1, 2, destroyed);
+  if (!detail::kImmediateFutureAlwaysDefer) {
+    EXPECT_TRUE(fut.isReady());
+    EXPECT_EQ(1, destroyed) << "the coroutine frame is already destroyed";
+  }
+  EXPECT_EQ(3, std::move(fut).get());
+  EXPECT_EQ(1, destroyed);
+}
+
+TEST(ImmediateTask, resumed_when_the_future_is_executed) {
+  int destroyed = 0;
+  folly::Promise<int> promise;
+  ImmediateFuture<int> fut = add(1, promise.getSemiFuture(), destroyed);
+  EXPECT_FALSE(fut.isReady());
+  promise.setValue(41);
+  EXPECT_EQ(0, destroyed);
+  EXPECT_EQ(42, std::move(fut).get());
+  EXPECT_EQ(1, destroyed);
+}
+
+TEST(ImmediateTask, dropping_the_future_destroys_the_coroutine) {
+  int destroyed = 0;
+  folly::Promise<int> promise;
+  {
+    ImmediateFuture<int> fut = add(promise.getSemiFuture(), 2, destroyed);
+  }
+  EXPECT_EQ(1, destroyed);
+}
+
+TEST(ImmediateTask, awaits_a_chain_of_coroutines) {
+  int destroyed = 0;
+  folly::Promise<int> promise;
+  ImmediateFuture<int> inner = add(promise.getSemiFuture(), 2, destroyed);
+  ImmediateFuture<int> outer = add(std::move(inner), 3, destroyed);
+  promise.setValue(1);
+  EXPECT_EQ(6, std::move(outer).get());
+  EXPECT_EQ(2, destroyed);
+}
+
+TEST(ImmediateTask, exceptions_are_captured) {
+  ImmediateFuture<folly::Unit> thrown = throwIfSet(1);
+  EXPECT_THROW_RE(std::move(thrown).get(), std::logic_error, "Test exception");
+
+  ImmediateFuture<folly::Unit> notThrown = throwIfSet(0);
+  EXPECT_NO_THROW(std::move(notThrown).get());
+
+  int destroyed = 0;
+  ImmediateFuture<int> awaitedError =
+      add(makeImmediateFuture<int>(std::logic_error("Test exception")),
+          2,
+          destroyed);
+  EXPECT_THROW_RE(
+      std::move(awaitedError).get(), std::logic_error, "Test exception");
+  EXPECT_EQ(1, destroyed);
+}
+
+#endif
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/LatencyHistogram.h"
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+TEST(LatencyHistogramTest, empty_histogram) {
+  LatencyHistogram histogram;
+  EXPECT_EQ(0, histogram.getCount());
+  EXPECT_EQ(0, histogram.getPercentile(50));
+  EXPECT_EQ(0, histogram.getPercentile(100));
+}
+
+TEST(LatencyHistogramTest, buckets_cover_every_value) {
+  EXPECT_EQ(0, LatencyHistogram::bucketIndex(0));
+  EXPECT_EQ(7, LatencyHistogram::bucketIndex(7));
+  for (size_t i = 1; i < LatencyHistogram::kNumBuckets; ++i) {
+    auto lower = LatencyHistogram::bucketLowerBound(i);
+    EXPECT_LT(LatencyHistogram::bucketLowerBound(i - 1), lower);
+    EXPECT_EQ(i, LatencyHistogram::bucketIndex(lower));
+    EXPECT_EQ(i - 1, LatencyHistogram::bucketIndex(lower - 1));
+  }
+  EXPECT_EQ(
+      LatencyHistogram::kNumBuckets - 1,
+      LatencyHistogram::bucketIndex(uint64_t{1} << 40));
+}
+
+TEST(LatencyHistogramTest, percentiles_are_within_bucket_precision) {
+  LatencyHistogram histogram;
+  for (int i = 1; i <= 1000; ++i) {
+    histogram.record(std::chrono::microseconds{i});
+  }
+  EXPECT_EQ(1000, histogram.getCount());
+
+  auto p50 = histogram.getPercentile(50);
+  EXPECT_GE(p50, 500);
+  EXPECT_LE(p50, 500 + 500 / LatencyHistogram::kSubBuckets);
+  auto p99 = histogram.getPercentile(99);
+  EXPECT_GE(p99, 990);
+  EXPECT_LE(p99, 990 + 990 / LatencyHistogram::kSubBuckets);
+  EXPECT_GE(histogram.getPercentile(100), 1000);
+}
+
+TEST(LatencyHistogramTest, large_values_are_clamped) {
+  LatencyHistogram histogram;
+  histogram.record(10h);
+  histogram.record(-1s);
+  EXPECT_EQ(2, histogram.getCount());
+  EXPECT_EQ(0, histogram.getPercentile(50));
+  EXPECT_EQ(
+      LatencyHistogram::bucketLowerBound(LatencyHistogram::kNumBuckets - 1),
+      histogram.getPercentile(100));
+
+  histogram.clear();
+  EXPECT_EQ(0, histogram.getCount());
+}
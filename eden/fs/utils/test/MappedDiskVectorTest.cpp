@@ -92,6 +92,81 @@ TEST_F(MappedDiskVectorTest, pop_back) {
   EXPECT_EQ(3, mdv[1]);
 }
 
+TEST_F(MappedDiskVectorTest, shrink_to_fit_releases_unused_capacity) {
+  auto mdv = MappedDiskVector<U64>::open(mdvPath);
+  auto initialSize = mdv.fileSizeInBytes();
+  EXPECT_EQ(0, mdv.shrinkToFit());
+
+  constexpr uint64_t N = 1000000;
+  for (uint64_t i = 0; i < N; ++i) {
+    mdv.emplace_back(i);
+  }
+  while (mdv.size() > 3) {
+    mdv.pop_back();
+  }
+
+  auto grownSize = mdv.fileSizeInBytes();
+  EXPECT_EQ(grownSize - initialSize, mdv.shrinkToFit());
+  EXPECT_EQ(initialSize, mdv.fileSizeInBytes());
+  EXPECT_EQ(0, mdv.shrinkToFit());
+
+  struct stat st;
+  ASSERT_EQ(0, stat(mdvPath.c_str(), &st));
+  EXPECT_EQ(initialSize, st.st_size);
+  EXPECT_EQ(3, mdv.size());
+  EXPECT_EQ(2, mdv[2]);
+
+  for (uint64_t i = 0; i < N; ++i) {
+    mdv.emplace_back(i);
+  }
+  EXPECT_EQ(N + 3, mdv.size());
+  EXPECT_EQ(N - 1, mdv[N + 2]);
+}
+
+TEST_F(MappedDiskVectorTest, flush_syncs_only_dirty_pages) {
+  auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  auto mdv = MappedDiskVector<U64>::open(mdvPath);
+  EXPECT_EQ(0, mdv.flush());
+
+  constexpr uint64_t N = 100000;
+  for (uint64_t i = 0; i < N; ++i) {
+    mdv.emplace_back(i);
+  }
+  // The header and every record.
+  auto synced = mdv.flush();
+  EXPECT_GE(synced, N * sizeof(U64));
+  EXPECT_LE(synced, N * sizeof(U64) + 3 * pageSize);
+  EXPECT_EQ(0, mdv.flush());
+
+  mdv[N / 2] = 7ull;
+  mdv.markDirty(N / 2);
+  EXPECT_EQ(pageSize, mdv.flush());
+  EXPECT_EQ(0, mdv.flush());
+
+  // Dirty records are synced within one range.
+  mdv.markDirty(0);
+  mdv.markDirty(N - 1);
+  EXPECT_GE(mdv.flush(), N * sizeof(U64) - pageSize);
+}
+
+TEST_F(MappedDiskVectorTest, options_do_not_change_contents) {
+  MappedDiskVectorOptions options;
+  options.populate = true;
+  options.hugePages = true;
+  options.willNeed = true;
+  {
+    auto mdv = MappedDiskVector<U64>::open(mdvPath, options);
+    for (uint64_t i = 0; i < 100000; ++i) {
+      mdv.emplace_back(i);
+    }
+    mdv.flush();
+  }
+
+  auto mdv = MappedDiskVector<U64>::open(mdvPath, options);
+  EXPECT_EQ(100000, mdv.size());
+  EXPECT_EQ(99999, mdv[99999]);
+}
+
 namespace {
 struct Small {
   enum { VERSION = 0 };
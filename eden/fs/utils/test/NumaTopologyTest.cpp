@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/NumaTopology.h"
+
+#include <folly/portability/GTest.h>
+
+using namespace facebook::eden;
+
+TEST(NumaTopologyTest, parseList) {
+  EXPECT_EQ(std::vector<int>{}, NumaTopology::parseList("\n"));
+  EXPECT_EQ(std::vector<int>{0}, NumaTopology::parseList("0\n"));
+  EXPECT_EQ(
+      (std::vector<int>{0, 1, 2, 3, 8, 10, 11}),
+      NumaTopology::parseList("0-3,8,10-11\n"));
+  EXPECT_EQ(std::nullopt, NumaTopology::parseList("3-1"));
+  EXPECT_EQ(std::nullopt, NumaTopology::parseList("0,,2"));
+  EXPECT_EQ(std::nullopt, NumaTopology::parseList("a-b"));
+}
+
+TEST(NumaTopologyTest, threadsAreSpreadOverTheNodes) {
+  NumaTopology topology{{{0, 1, 2, 3}, {}, {4, 5}}};
+  EXPECT_EQ(2, topology.getNodeCount());
+  EXPECT_EQ((std::vector<int>{4, 5}), topology.getCpus(1));
+
+  std::vector<int> cpus;
+  for (size_t index = 0; index < 8; ++index) {
+    EXPECT_EQ(index % 2, topology.getNodeForThread(index));
+    cpus.push_back(topology.getCpuForThread(index).value());
+  }
+  EXPECT_EQ((std::vector<int>{0, 4, 1, 5, 2, 4, 3, 5}), cpus);
+}
+
+TEST(NumaTopologyTest, emptyTopologyHasNoCpus) {
+  NumaTopology topology{{}};
+  EXPECT_EQ(0, topology.getNodeCount());
+  EXPECT_EQ(std::nullopt, topology.getCpuForThread(0));
+  // Binding is a no-op.
+  topology.bindThreadToNode(0);
+  topology.pinThreadToCpu(0);
+}
+
+TEST(NumaTopologyTest, machineTopologyCoversTheAllowedCpus) {
+  const auto& topology = NumaTopology::get();
+#ifdef __linux__
+  EXPECT_LE(1, topology.getNodeCount());
+  for (size_t node = 0; node < topology.getNodeCount(); ++node) {
+    EXPECT_FALSE(topology.getCpus(node).empty());
+  }
+#else
+  EXPECT_EQ(0, topology.getNodeCount());
+#endif
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/PathFuncs.h"
+
+#include <benchmark/benchmark.h>
+#include <fmt/format.h>
+
+#include "eden/fs/utils/PathMap.h"
+
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+using namespace facebook::eden;
+
+// Typical of what the journal, the diffs and the globs deal with.
+const RelativePath kDirectory{"fbcode/eden/fs/inodes/test"};
+const PathComponent kName{"TreeInodeDirHandleTest.cpp"};
+const AbsolutePath kMountPath =
+    canonicalPath(folly::kIsWindows ? "C:\\open\\fbsource" : "/data/fbsource");
+
+void compose_component_with_component(benchmark::State& state) {
+  PathComponent dir{"inodes"};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(dir + kName);
+  }
+}
+BENCHMARK(compose_component_with_component);
+
+void compose_relative_with_component(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(kDirectory + kName);
+  }
+}
+BENCHMARK(compose_relative_with_component);
+
+void compose_absolute_with_relative(benchmark::State& state) {
+  auto path = kDirectory + kName;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(kMountPath + path);
+  }
+}
+BENCHMARK(compose_absolute_with_relative);
+
+/**
+ * What computing the path of an inode does, once it collected the names of
+ * its parents.
+ */
+void relative_from_components(benchmark::State& state) {
+  std::vector<PathComponent> names;
+  for (auto component : kDirectory.components()) {
+    names.emplace_back(component);
+  }
+  names.push_back(kName);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(RelativePath{names});
+  }
+}
+BENCHMARK(relative_from_components);
+
+void split_dirname_and_basename(benchmark::State& state) {
+  auto path = kDirectory + kName;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(path.dirname());
+    benchmark::DoNotOptimize(path.basename());
+  }
+}
+BENCHMARK(split_dirname_and_basename);
+
+void iterate_components(benchmark::State& state) {
+  auto path = kDirectory + kName;
+  for (auto _ : state) {
+    size_t size = 0;
+    for (auto component : path.components()) {
+      size += component.view().size();
+    }
+    benchmark::DoNotOptimize(size);
+  }
+}
+BENCHMARK(iterate_components);
+
+void hash_relative(benchmark::State& state) {
+  auto path = kDirectory + kName;
+  std::hash<RelativePath> hasher;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(hasher(path));
+  }
+}
+BENCHMARK(hash_relative);
+
+void compare_relative(benchmark::State& state) {
+  auto path1 = kDirectory + kName;
+  auto path2 = kDirectory + PathComponent{"TreeInodeDirHandleTest.h"};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(path1 < path2);
+    benchmark::DoNotOptimize(path1 == path2);
+  }
+}
+BENCHMARK(compare_relative);
+
+void compare_relative_case_insensitive(benchmark::State& state) {
+  auto path1 = kDirectory + kName;
+  auto path2 = RelativePath{"FBCODE/EDEN/FS/INODES/TEST/TreeInodeDirHandle.h"};
+  auto insensitive = CaseSensitivity::Insensitive;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        isPathPieceLess(path1.piece(), path2.piece(), insensitive));
+    benchmark::DoNotOptimize(
+        isPathPieceEqual(path1.piece(), path2.piece(), insensitive));
+  }
+}
+BENCHMARK(compare_relative_case_insensitive);
+
+/** A lookup in the entries of a directory, as done by TreeInode. */
+void path_map_find(benchmark::State& state) {
+  auto caseSensitive = static_cast<CaseSensitivity>(state.range(0));
+  PathMap<int> entries{caseSensitive};
+  for (int i = 0; i < state.range(1); ++i) {
+    entries.emplace(PathComponent{fmt::format("SomeSourceFile{}.cpp", i)}, i);
+  }
+  auto name = PathComponent{fmt::format("somesourcefile{}.cpp", 7)};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(entries.find(name));
+  }
+}
+BENCHMARK(path_map_find)
+    ->ArgNames({"case_sensitive", "entries"})
+    ->Args({static_cast<int64_t>(CaseSensitivity::Sensitive), 1000})
+    ->Args({static_cast<int64_t>(CaseSensitivity::Insensitive), 1000})
+    ->Args({static_cast<int64_t>(CaseSensitivity::Sensitive), 100000})
+    ->Args({static_cast<int64_t>(CaseSensitivity::Insensitive), 100000});
+
+/** Roughly what recording a change into a set of changed paths costs. */
+void insert_into_set(benchmark::State& state) {
+  std::unordered_set<RelativePath> paths;
+  size_t index = 0;
+  for (auto _ : state) {
+    if (paths.size() == 1000) {
+      paths.clear();
+    }
+    paths.insert(kDirectory + PathComponent{std::to_string(index++)});
+  }
+}
+BENCHMARK(insert_into_set);
+
+} // namespace
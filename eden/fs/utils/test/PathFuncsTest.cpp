@@ -1149,6 +1149,45 @@ TEST(PathFuncs, comparisonInsensitive) {
   EXPECT_EQ(result, CompareResult::AFTER);
 }
 
+TEST(PathFuncs, comparisonInsensitiveLongerThanAWord) {
+  // Differences before, at and after the 8 byte boundary, and in the tail.
+  EXPECT_EQ(
+      CompareResult::EQUAL,
+      comparePathPiece(
+          "Some/Long/Directory/File.txt"_relpath,
+          "some/long/DIRECTORY/file.TXT"_relpath,
+          CaseSensitivity::Insensitive));
+  EXPECT_EQ(
+      CompareResult::BEFORE,
+      comparePathPiece(
+          "some/lonG/directory"_relpath,
+          "SOME/LONH/DIRECTORY"_relpath,
+          CaseSensitivity::Insensitive));
+  EXPECT_EQ(
+      CompareResult::AFTER,
+      comparePathPiece(
+          "some/long/directorz"_relpath,
+          "SOME/LONG/DIRECTORY"_relpath,
+          CaseSensitivity::Insensitive));
+  EXPECT_EQ(
+      CompareResult::BEFORE,
+      comparePathPiece(
+          "some/long/dir"_relpath,
+          "SOME/LONG/DIRECTORY"_relpath,
+          CaseSensitivity::Insensitive));
+
+  // Only the ASCII letters are folded: '@' and '[' surround 'A'-'Z', and
+  // would become '`' and '{' otherwise.
+  EXPECT_EQ(
+      CompareResult::AFTER,
+      comparePathPiece(
+          "abcdefg`"_pc, "ABCDEFG@"_pc, CaseSensitivity::Insensitive));
+  EXPECT_EQ(
+      CompareResult::AFTER,
+      comparePathPiece(
+          "abcdefg{"_pc, "ABCDEFG["_pc, CaseSensitivity::Insensitive));
+}
+
 TEST(PathFuncs, localDirCreateRemove) {
   folly::test::TemporaryDirectory dir = makeTempDir();
   string pathStr{dir.path().string()};
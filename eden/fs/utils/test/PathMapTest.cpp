@@ -6,6 +6,8 @@
  */
 
 #include "eden/fs/utils/PathMap.h"
+#include <fmt/format.h>
+#include <algorithm>
 #include <folly/portability/GTest.h>
 #include <folly/portability/Unistd.h>
 
@@ -260,3 +262,79 @@ TEST(PathMap, swap) {
   EXPECT_EQ(0, b.size()) << "b now has 0 elements";
   EXPECT_EQ("foo", a.at("foo"_pc));
 }
+
+TEST(PathMap, populateInOrder) {
+  for (auto caseSensitive :
+       {CaseSensitivity::Sensitive, CaseSensitivity::Insensitive}) {
+    PathMap<size_t> map(caseSensitive);
+    for (size_t i = 0; i < kPathMapIndexThreshold * 2; ++i) {
+      auto name = PathComponent{fmt::format("file{:05}", i)};
+      EXPECT_TRUE(map.emplace(name, i).second);
+    }
+    // Keys that don't sort last still go through the binary search.
+    EXPECT_FALSE(map.emplace(PathComponent{"file00000"}, 0).second);
+    EXPECT_TRUE(map.emplace(PathComponent{"a"}, 0).second);
+    EXPECT_FALSE(map.emplace(PathComponent{"a"}, 1).second);
+    EXPECT_EQ(
+        caseSensitive == CaseSensitivity::Sensitive,
+        map.emplace(PathComponent{"A"}, 0).second);
+
+    auto last = PathComponent{fmt::format("file{:05}", map.size())};
+    map[last] = 42;
+    EXPECT_EQ(42, map.at(last));
+    EXPECT_EQ(std::prev(map.end()), map.find(last));
+    EXPECT_TRUE(std::is_sorted(
+        map.begin(), map.end(), [&](const auto& a, const auto& b) {
+          return isPathPieceLess(
+              a.first.piece(), b.first.piece(), caseSensitive);
+        }));
+  }
+}
+
+TEST(PathMap, largeMapIsIndexed) {
+  for (auto caseSensitive :
+       {CaseSensitivity::Sensitive, CaseSensitivity::Insensitive}) {
+    PathMap<size_t> map(caseSensitive);
+    auto count = kPathMapIndexThreshold * 2;
+    // Insert from the end, so that every insert moves the indexed entries.
+    for (size_t i = count; i > 0; --i) {
+      auto name = PathComponent{fmt::format("file{:05}", i - 1)};
+      EXPECT_TRUE(map.emplace(name, i - 1).second);
+    }
+    EXPECT_FALSE(map.emplace(PathComponent{"file00042"}, 0).second);
+    ASSERT_EQ(count, map.size());
+
+    for (size_t i = 0; i < count; ++i) {
+      auto iter = map.find(PathComponent{fmt::format("file{:05}", i)});
+      ASSERT_NE(map.end(), iter);
+      EXPECT_EQ(i, iter->second);
+      EXPECT_EQ(i, static_cast<size_t>(iter - map.begin()))
+          << "iteration stays sorted";
+    }
+    EXPECT_EQ(
+        caseSensitive == CaseSensitivity::Insensitive,
+        map.count("FILE00042"_pc) == 1);
+    EXPECT_EQ(0, map.count("file"_pc));
+
+    EXPECT_EQ(1, map.erase("file00000"_pc));
+    map.erase(map.begin(), map.begin() + 10);
+    EXPECT_EQ(count - 11, map.size());
+    EXPECT_EQ(map.end(), map.find("file00010"_pc));
+    EXPECT_EQ(11, map.at("file00011"_pc));
+    auto last = PathComponent{fmt::format("file{:05}", count - 1)};
+    EXPECT_EQ(count - 1, map.at(last));
+
+    map["file00005"_pc] = 5;
+    EXPECT_EQ(5, map.at("file00005"_pc));
+    EXPECT_EQ(map.begin(), map.find("file00005"_pc));
+
+    auto copied = map;
+    EXPECT_EQ(11, copied.at("file00011"_pc));
+
+    // Below the threshold, the lookups go back to the binary search.
+    map.erase(map.begin() + 2, map.end());
+    EXPECT_EQ(2, map.size());
+    EXPECT_EQ(11, map.at("file00011"_pc));
+    EXPECT_EQ(0, map.count("file00012"_pc));
+  }
+}
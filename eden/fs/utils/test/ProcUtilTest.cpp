@@ -176,4 +176,50 @@ TEST(proc_util, noProcSmapsNoThrow) {
   EXPECT_EQ(privateBytes, 0);
 }
 
+TEST(proc_util, parseMemoryPressure) {
+  auto pressure = parseMemoryPressure(
+      "some avg10=12.50 avg60=3.00 avg300=1.00 total=1234\n"
+      "full avg10=2.25 avg60=0.50 avg300=0.10 total=567\n");
+  ASSERT_TRUE(pressure.has_value());
+  EXPECT_DOUBLE_EQ(12.5, pressure->someAvg10);
+  EXPECT_DOUBLE_EQ(2.25, pressure->fullAvg10);
+
+  // Kernels before 5.13 don't report "full" for the system-wide file.
+  pressure =
+      parseMemoryPressure("some avg10=1.00 avg60=0.00 avg300=0.00 total=0\n");
+  ASSERT_TRUE(pressure.has_value());
+  EXPECT_DOUBLE_EQ(1.0, pressure->someAvg10);
+  EXPECT_DOUBLE_EQ(0.0, pressure->fullAvg10);
+
+  EXPECT_FALSE(parseMemoryPressure("").has_value());
+  EXPECT_FALSE(parseMemoryPressure("some avg10=abc total=0\n").has_value());
+}
+
+TEST(proc_util, parseCgroupV2Path) {
+  EXPECT_EQ(
+      "/user.slice/eden.service",
+      parseCgroupV2Path("0::/user.slice/eden.service\n").value());
+  EXPECT_EQ(
+      "/system.slice",
+      parseCgroupV2Path("12:memory:/legacy\n0::/system.slice\n").value());
+  EXPECT_FALSE(parseCgroupV2Path("12:memory:/legacy\n").has_value());
+}
+
+TEST(proc_util, parseStatCpuTicks) {
+  EXPECT_EQ(
+      1234 + 56,
+      parseStatCpuTicks("4242 (edenfs) S 1 4242 4242 0 -1 4194560 8395 0 0 "
+                        "0 1234 56 0 0 20 0 42 0 1000 123456 789\n")
+          .value());
+  // The command name can contain spaces and parentheses.
+  EXPECT_EQ(
+      3,
+      parseStatCpuTicks("1 (a) b (c) R 0 1 1 0 -1 0 0 0 0 0 1 2 0 0 20 0\n")
+          .value());
+  EXPECT_FALSE(parseStatCpuTicks("").has_value());
+  EXPECT_FALSE(parseStatCpuTicks("1 (edenfs) S 1 2 3\n").has_value());
+  EXPECT_FALSE(
+      parseStatCpuTicks("1 (a) R 0 1 1 0 -1 0 0 0 0 0 x 2 0\n").has_value());
+}
+
 #endif
@@ -51,3 +51,47 @@ TEST(ProcessAccessLog, accessAddsProcessToProcessNameCache) {
   log.recordAccess(pid, ProcessAccessLog::AccessType::FsChannelOther);
   EXPECT_THAT(processNameCache->getAllProcessNames(), Contains(Key(Eq(pid))));
 }
+
+TEST(ProcessAccessLog, durationsAreSummarizedByPercentiles) {
+  auto pid = pid_t{42};
+  auto log = ProcessAccessLog{std::make_shared<ProcessNameCache>()};
+
+  for (int i = 0; i < 98; i++) {
+    log.recordDuration(pid, 100us);
+  }
+  log.recordDuration(pid, 1ms);
+  log.recordDuration(pid, 10ms);
+  log.recordBytesRead(pid, 4096);
+  log.recordBytesRead(pid, 100);
+
+  auto counts = log.getAccessCounts(10s);
+  ASSERT_EQ(1, counts.count(pid));
+  auto& ac = counts[pid];
+  EXPECT_EQ(4196, *ac.fsChannelBytesRead_ref());
+  EXPECT_EQ(
+      std::chrono::nanoseconds{98 * 100us + 1ms + 10ms}.count(),
+      *ac.fsChannelDurationNs_ref());
+  // Rounded up to the next power of two of microseconds.
+  EXPECT_EQ(128000, *ac.fsChannelLatencyP50Ns_ref());
+  EXPECT_EQ(128000, *ac.fsChannelLatencyP90Ns_ref());
+  EXPECT_EQ(1024000, *ac.fsChannelLatencyP99Ns_ref());
+}
+
+TEST(ProcessAccessLog, topAccessCountsAreSortedByDuration) {
+  auto log = ProcessAccessLog{std::make_shared<ProcessNameCache>()};
+  log.recordDuration(pid_t{1}, 1ms);
+  log.recordDuration(pid_t{2}, 3ms);
+  log.recordDuration(pid_t{3}, 2ms);
+  log.recordAccess(pid_t{4}, ProcessAccessLog::AccessType::FsChannelRead);
+
+  auto top = log.getTopAccessCountsByDuration(10s, 2);
+  ASSERT_EQ(2, top.size());
+  EXPECT_EQ(2, top[0].first);
+  EXPECT_EQ(3, top[1].first);
+  EXPECT_EQ(
+      std::chrono::nanoseconds{3ms}.count(),
+      *top[0].second.fsChannelDurationNs_ref());
+
+  EXPECT_EQ(4, log.getTopAccessCountsByDuration(10s, 10).size());
+  EXPECT_THAT(log.getTopAccessCountsByDuration(10s, 0), ElementsAre());
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/RateLimitedSampler.h"
+
+#include <folly/portability/GTest.h>
+#include <thread>
+#include <vector>
+
+using namespace facebook::eden;
+using namespace std::chrono_literals;
+
+// An interval long enough for the tests not to cross one.
+constexpr auto kInterval = std::chrono::hours{24 * 365};
+
+TEST(RateLimitedSampler, samples_up_to_the_limit) {
+  RateLimitedSampler sampler{kInterval};
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_TRUE(sampler.sample(1, 10));
+  }
+  EXPECT_FALSE(sampler.sample(1, 10));
+  // A larger limit leaves room for more samples in the same interval.
+  EXPECT_TRUE(sampler.sample(1, 11));
+
+  auto counts = sampler.getCounts(60s);
+  EXPECT_EQ(12, counts.seen);
+  EXPECT_EQ(11, counts.sampled);
+  EXPECT_EQ(1, counts.throttled);
+}
+
+TEST(RateLimitedSampler, zero_limit_drops_everything) {
+  RateLimitedSampler sampler{kInterval};
+  EXPECT_FALSE(sampler.sample(0, 0));
+  EXPECT_FALSE(sampler.sample(1, 0));
+  EXPECT_EQ(2, sampler.getCounts(60s).throttled);
+}
+
+TEST(RateLimitedSampler, samples_one_in_denominator) {
+  RateLimitedSampler sampler{kInterval};
+  constexpr int kEvents = 100000;
+  for (int i = 0; i < kEvents; ++i) {
+    sampler.sample(100, kEvents);
+  }
+  auto counts = sampler.getCounts(60s);
+  EXPECT_EQ(kEvents, counts.seen);
+  EXPECT_EQ(0, counts.throttled);
+  EXPECT_LT(500, counts.sampled);
+  EXPECT_GT(2000, counts.sampled);
+}
+
+TEST(RateLimitedSampler, limit_is_shared_by_threads) {
+  RateLimitedSampler sampler{kInterval};
+  std::atomic<uint64_t> sampled{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < 1000; ++i) {
+        if (sampler.sample(1, 100)) {
+          ++sampled;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(100, sampled.load());
+  // The counts of the threads that exited were kept.
+  auto counts = sampler.getCounts(60s);
+  EXPECT_EQ(8000, counts.seen);
+  EXPECT_EQ(100, counts.sampled);
+  EXPECT_EQ(7900, counts.throttled);
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/RequestArena.h"
+
+#include <folly/portability/GTest.h>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace facebook::eden;
+
+namespace {
+bool isAligned(void* ptr) {
+  return reinterpret_cast<uintptr_t>(ptr) % alignof(std::max_align_t) == 0;
+}
+} // namespace
+
+TEST(RequestArena, reuses_the_block_once_released) {
+  RequestArena arena{1024};
+  auto* first = arena.allocate(100);
+  EXPECT_TRUE(isAligned(first));
+  auto* second = arena.allocate(1);
+  EXPECT_TRUE(isAligned(second));
+  EXPECT_NE(first, second);
+  RequestArena::deallocate(first);
+  RequestArena::deallocate(second);
+
+  auto* third = arena.allocate(100);
+  EXPECT_EQ(first, third);
+  EXPECT_EQ(1, arena.getBlockCount());
+  RequestArena::deallocate(third);
+}
+
+TEST(RequestArena, live_allocations_are_not_reused) {
+  RequestArena arena{1024};
+  std::vector<void*> live;
+  for (int i = 0; i < 100; ++i) {
+    auto* ptr = arena.allocate(200);
+    std::memset(ptr, i, 200);
+    live.push_back(ptr);
+  }
+  EXPECT_LT(1, arena.getBlockCount());
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(i, static_cast<unsigned char*>(live[i])[199]);
+    RequestArena::deallocate(live[i]);
+  }
+}
+
+TEST(RequestArena, large_allocations_get_their_own_block) {
+  RequestArena arena{1024};
+  auto* small = arena.allocate(8);
+  auto* large = arena.allocate(4096);
+  std::memset(large, 0, 4096);
+  EXPECT_EQ(2, arena.getBlockCount());
+  RequestArena::deallocate(large);
+  RequestArena::deallocate(small);
+  RequestArena::deallocate(nullptr);
+}
+
+TEST(RequestArena, allocations_outlive_the_arena) {
+  std::shared_ptr<std::vector<int>> shared;
+  {
+    RequestArena arena;
+    shared = std::allocate_shared<std::vector<int>>(
+        RequestArena::Allocator<std::vector<int>>{arena}, 3, 7);
+  }
+  EXPECT_EQ(7, shared->at(2));
+}
+
+TEST(RequestArena, released_from_other_threads) {
+  RequestArena arena{4096};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    std::vector<void*> batch;
+    for (int i = 0; i < 1000; ++i) {
+      batch.push_back(arena.allocate(64));
+    }
+    threads.emplace_back([batch = std::move(batch)] {
+      for (auto* ptr : batch) {
+        RequestArena::deallocate(ptr);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  auto blocks = arena.getBlockCount();
+  RequestArena::deallocate(arena.allocate(64));
+  EXPECT_EQ(blocks, arena.getBlockCount());
+}
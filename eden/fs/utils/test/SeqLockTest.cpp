@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/SeqLock.h"
+
+#include <folly/portability/GTest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace facebook::eden;
+
+namespace {
+struct Value {
+  uint64_t a;
+  uint32_t b;
+  uint64_t c;
+};
+} // namespace
+
+TEST(SeqLock, emptyUntilStored) {
+  SeqLock<Value> lock;
+  EXPECT_FALSE(lock.load().has_value());
+
+  lock.store(Value{1, 2, 3});
+  auto value = lock.load();
+  ASSERT_TRUE(value.has_value());
+  EXPECT_EQ(1, value->a);
+  EXPECT_EQ(2, value->b);
+  EXPECT_EQ(3, value->c);
+}
+
+TEST(SeqLock, invalidateMakesReadsFail) {
+  SeqLock<Value> lock;
+  lock.store(Value{1, 2, 3});
+  lock.invalidate();
+  EXPECT_FALSE(lock.load().has_value());
+
+  lock.store(Value{4, 5, 6});
+  EXPECT_EQ(4, lock.load()->a);
+}
+
+TEST(SeqLock, readersNeverSeeTornValues) {
+  SeqLock<Value> lock;
+  std::atomic<bool> done{false};
+
+  std::vector<std::thread> readers;
+  std::atomic<size_t> torn{0};
+  for (size_t i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      while (!done.load(std::memory_order_relaxed)) {
+        if (auto value = lock.load()) {
+          if (value->a != value->c || value->b != uint32_t(value->a)) {
+            ++torn;
+          }
+        }
+      }
+    });
+  }
+
+  for (uint64_t i = 0; i < 100000; ++i) {
+    if (i % 3 == 0) {
+      lock.invalidate();
+    } else {
+      lock.store(Value{i, uint32_t(i), i});
+    }
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(0, torn.load());
+}
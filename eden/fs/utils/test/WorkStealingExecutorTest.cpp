@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This software may be used and distributed according to the terms of the
+ * GNU General Public License version 2.
+ */
+
+#include "eden/fs/utils/WorkStealingExecutor.h"
+
+#include <folly/portability/GTest.h>
+#include <folly/synchronization/Baton.h>
+
+using namespace facebook::eden;
+
+namespace {
+
+/** Adds 4 functions per level, the way checkout fans out per directory. */
+void fanOut(
+    WorkStealingExecutor& executor,
+    std::atomic<size_t>& ran,
+    int depth) {
+  ++ran;
+  if (depth == 0) {
+    return;
+  }
+  for (int i = 0; i < 4; ++i) {
+    executor.add(
+        [&executor, &ran, depth] { fanOut(executor, ran, depth - 1); });
+  }
+}
+
+} // namespace
+
+TEST(WorkStealingExecutor, runs_all_functions_before_being_destroyed) {
+  std::atomic<size_t> ran{0};
+  {
+    WorkStealingExecutor executor{4, "Test"};
+    executor.add([&] { fanOut(executor, ran, 5); });
+    for (int i = 0; i < 100; ++i) {
+      executor.add([&] { ++ran; });
+    }
+  }
+  // 1 + 4 + 16 + 64 + 256 + 1024 functions from the fan out.
+  EXPECT_EQ(1365 + 100, ran.load());
+}
+
+TEST(WorkStealingExecutor, functions_added_by_a_thread_run_newest_first) {
+  WorkStealingExecutor executor{1, "Test"};
+  std::vector<int> order;
+  folly::Baton<> done;
+  executor.add([&] {
+    executor.add([&] { done.post(); });
+    for (int i = 0; i < 3; ++i) {
+      executor.add([&order, i] { order.push_back(i); });
+    }
+  });
+  done.wait();
+  EXPECT_EQ((std::vector<int>{2, 1, 0}), order);
+  EXPECT_EQ(0, executor.getStealCount());
+}
+
+TEST(WorkStealingExecutor, idle_threads_steal) {
+  WorkStealingExecutor executor{2, "Test"};
+  folly::Baton<> started;
+  folly::Baton<> release;
+  folly::Baton<> stolen;
+  // Keep the thread that queues the second function busy, so that only
+  // the other thread can run it.
+  executor.add([&] {
+    executor.add([&] { stolen.post(); });
+    started.post();
+    release.wait();
+  });
+  started.wait();
+  stolen.wait();
+  release.post();
+  EXPECT_LE(1, executor.getStealCount());
+}
+
+TEST(WorkStealingExecutor, exceptions_do_not_stop_the_threads) {
+  WorkStealingExecutor executor{1, "Test"};
+  executor.add([] { throw std::runtime_error("Test exception"); });
+  folly::Baton<> done;
+  executor.add([&] { done.post(); });
+  done.wait();
+  EXPECT_EQ(0, executor.getPendingTaskCount());
+}
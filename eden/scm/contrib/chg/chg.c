@@ -348,12 +348,17 @@ int chg_main(
     }
   }
 
+  /* latency breakdown reported by CHGDEBUG, in seconds */
+  double connecttime = 0, validatetime = 0;
   hgclient_t* hgc;
   size_t retry = 0;
   while (1) {
+    double starttime = chg_now();
     hgc = connectcmdserver(&opts);
     if (!hgc)
       abortmsg("cannot open hg client");
+    double connectedtime = chg_now();
+    connecttime += connectedtime - starttime;
     int needreconnect = 0;
 #ifdef HAVE_VERSIONHASH
     unsigned long long versionhash = hgc_versionhash(hgc);
@@ -373,6 +378,7 @@ int chg_main(
     if (!needreconnect) {
       hgc_setenv(hgc, envp);
     }
+    validatetime += chg_now() - connectedtime;
     if (!needreconnect)
       break;
     hgc_close(hgc);
@@ -388,7 +394,14 @@ int chg_main(
 
   setupsignalhandler(hgc_peerpid(hgc), hgc_peerpgid(hgc));
   atexit(waitpager);
+  double runstarttime = chg_now();
   int exitcode = hgc_runcommand(hgc, argv + 1, argc - 1);
+  debugmsg(
+      "latency: connect %.3f ms, validate %.3f ms, run %.3f ms, %zu retries",
+      connecttime * 1e3,
+      validatetime * 1e3,
+      (chg_now() - runstarttime) * 1e3,
+      retry);
   restoresignalhandler();
   hgc_close(hgc);
 
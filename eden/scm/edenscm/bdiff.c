@@ -24,63 +24,66 @@
 #include "eden/scm/edenscm/bitmanipulation.h"
 #include "eden/scm/edenscm/compat.h"
 
-/* Hash implementation from diffutils */
-#define ROL(v, n) ((v) << (n) | (v) >> (sizeof(v) * CHAR_BIT - (n)))
-#define HASH(h, c) ((c) + ROL(h, 7))
-
 struct pos {
   int pos, len;
 };
 
-int bdiff_splitlines(const char* a, ssize_t len, struct bdiff_line** lr) {
-  unsigned hash;
-  int i;
-  const char *p, *b = a;
-  const char* const plast = a + len - 1;
-  struct bdiff_line* l;
-
-  /* count the lines */
-  i = 1; /* extra line for sentinel */
-  for (p = a; p < plast; p++)
-    if (*p == '\n')
-      i++;
-  if (p == plast)
-    i++;
+/* Hash a line 8 bytes at a time. Only the low bits are used as a bucket by
+   equatelines, so the words are mixed into all of them. */
+static inline int hashline(const char* l, ssize_t len) {
+  uint64_t h = (uint64_t)len, w;
 
-  *lr = l = (struct bdiff_line*)malloc(sizeof(struct bdiff_line) * i);
-  if (!l)
-    return -1;
+  for (; len >= (ssize_t)sizeof(w); l += sizeof(w), len -= sizeof(w)) {
+    memcpy(&w, l, sizeof(w));
+    h = (h ^ w) * 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 29;
+  }
+  w = 0;
+  memcpy(&w, l, len);
+  h = (h ^ w) * 0x9e3779b97f4a7c15ULL;
+  return (int)(h >> 32 ^ h);
+}
 
-  /* build the line array and calculate hashes */
-  hash = 0;
-  for (p = a; p < plast; p++) {
-    hash = HASH(hash, *p);
-
-    if (*p == '\n') {
-      l->hash = hash;
-      hash = 0;
-      l->len = p - b + 1;
-      l->l = b;
-      l->n = INT_MAX;
-      l++;
-      b = p + 1;
-    }
+int bdiff_countlines(const char* a, ssize_t len) {
+  const char *p = a, *const end = a + len;
+  int i = 1; /* extra line for sentinel */
+
+  while (p < end) {
+    i++;
+    if (!(p = memchr(p, '\n', end - p)))
+      break;
+    p++;
   }
+  return i;
+}
 
-  if (p == plast) {
-    hash = HASH(hash, *p);
-    l->hash = hash;
-    l->len = p - b + 1;
-    l->l = b;
+int bdiff_splitlinesinto(const char* a, ssize_t len, struct bdiff_line* l) {
+  const char *p = a, *eol, *const end = a + len;
+  struct bdiff_line* const first = l;
+
+  /* build the line array and calculate hashes */
+  for (; p < end; p = eol, l++) {
+    eol = memchr(p, '\n', end - p);
+    eol = eol ? eol + 1 : end;
+    l->hash = hashline(p, eol - p);
+    l->len = eol - p;
+    l->l = p;
     l->n = INT_MAX;
-    l++;
   }
 
   /* set up a sentinel */
   l->hash = 0;
   l->len = 0;
   l->l = a + len;
-  return i - 1;
+  return l - first;
+}
+
+int bdiff_splitlines(const char* a, ssize_t len, struct bdiff_line** lr) {
+  *lr = (struct bdiff_line*)malloc(
+      sizeof(struct bdiff_line) * bdiff_countlines(a, len));
+  if (!*lr)
+    return -1;
+  return bdiff_splitlinesinto(a, len, *lr);
 }
 
 static inline int cmp(struct bdiff_line* a, struct bdiff_line* b) {
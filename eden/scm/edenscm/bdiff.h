@@ -29,6 +29,10 @@ struct bdiff_hunk {
   struct bdiff_hunk* next;
 };
 
+/* number of entries bdiff_splitlinesinto needs for a, sentinel included */
+int bdiff_countlines(const char* a, ssize_t len);
+/* fill l with the lines of a, followed by a sentinel, and return how many */
+int bdiff_splitlinesinto(const char* a, ssize_t len, struct bdiff_line* l);
 int bdiff_splitlines(const char* a, ssize_t len, struct bdiff_line** lr);
 int bdiff_diff(
     struct bdiff_line* a,
@@ -26,22 +26,69 @@
 #include "eden/scm/edenscm/bitmanipulation.h"
 #include "eden/scm/edenscm/cext/util.h"
 
+/*
+ * The line arrays of the last diff, reused by the next one rather than
+ * allocated, and faulted in, for every diff of a delta chain being written.
+ * Only accessed with the GIL held. Arrays larger than BDIFF_POOL_MAX_LINES
+ * lines are not kept, to bound the memory held between diffs.
+ */
+#define BDIFF_POOL_MAX_LINES (1 << 18)
+static struct bdiff_line* pooledlines = NULL;
+static Py_ssize_t pooledsize = 0;
+
+/* Take the pooled line arrays, with the GIL held. */
+static struct bdiff_line* takelines(Py_ssize_t* size) {
+  struct bdiff_line* lines = pooledlines;
+
+  *size = pooledsize;
+  pooledlines = NULL;
+  pooledsize = 0;
+  return lines;
+}
+
+/* Make room for count lines in lines, which the GIL is not needed for. */
+static struct bdiff_line*
+growlines(struct bdiff_line* lines, Py_ssize_t* size, Py_ssize_t count) {
+  if (count <= *size)
+    return lines;
+  free(lines);
+  lines = (struct bdiff_line*)malloc(sizeof(*lines) * count);
+  *size = lines ? count : 0;
+  return lines;
+}
+
+/* Give line arrays back to the pool, with the GIL held. */
+static void givelines(struct bdiff_line* lines, Py_ssize_t size) {
+  if (size > pooledsize && size <= BDIFF_POOL_MAX_LINES) {
+    free(pooledlines);
+    pooledlines = lines;
+    pooledsize = size;
+  } else {
+    free(lines);
+  }
+}
+
 static PyObject* blocks(PyObject* self, PyObject* args) {
   PyObject *sa, *sb, *rl = NULL, *m;
-  struct bdiff_line *a, *b;
+  struct bdiff_line *lines, *a, *b;
   struct bdiff_hunk l, *h;
   int an, bn, count, pos = 0;
+  Py_ssize_t size;
 
   l.next = NULL;
 
   if (!PyArg_ParseTuple(args, "SS:bdiff", &sa, &sb))
     return NULL;
 
-  an = bdiff_splitlines(PyBytes_AsString(sa), PyBytes_Size(sa), &a);
-  bn = bdiff_splitlines(PyBytes_AsString(sb), PyBytes_Size(sb), &b);
-
-  if (!a || !b)
+  an = bdiff_countlines(PyBytes_AsString(sa), PyBytes_Size(sa));
+  bn = bdiff_countlines(PyBytes_AsString(sb), PyBytes_Size(sb));
+  lines = growlines(takelines(&size), &size, (Py_ssize_t)an + bn);
+  if (!lines)
     goto nomem;
+  a = lines;
+  b = lines + an;
+  an = bdiff_splitlinesinto(PyBytes_AsString(sa), PyBytes_Size(sa), a);
+  bn = bdiff_splitlinesinto(PyBytes_AsString(sb), PyBytes_Size(sb), b);
 
   count = bdiff_diff(a, an, b, bn, &l);
   if (count < 0)
@@ -58,8 +105,7 @@ static PyObject* blocks(PyObject* self, PyObject* args) {
   }
 
 nomem:
-  free(a);
-  free(b);
+  givelines(lines, size);
   bdiff_freehunks(l.next);
   return rl ? rl : PyErr_NoMemory();
 }
@@ -68,10 +114,10 @@ static PyObject* bdiff(PyObject* self, PyObject* args) {
   char *sa, *sb, *rb, *ia, *ib;
   PyObject* result = NULL;
   Py_buffer ya, yb;
-  struct bdiff_line *al, *bl;
+  struct bdiff_line *lines, *al, *bl;
   struct bdiff_hunk l, *h;
   int an, bn, count;
-  Py_ssize_t len = 0, la, lb, li = 0, lcommon = 0, lmax;
+  Py_ssize_t len = 0, la, lb, li = 0, lcommon = 0, lmax, size;
   PyThreadState* _save;
 
   l.next = NULL;
@@ -93,6 +139,7 @@ static PyObject* bdiff(PyObject* self, PyObject* args) {
     return NULL;
   }
 
+  lines = takelines(&size);
   _save = PyEval_SaveThread();
 
   lmax = la > lb ? lb : la;
@@ -101,10 +148,15 @@ static PyObject* bdiff(PyObject* self, PyObject* args) {
       lcommon = li + 1;
   /* we can almost add: if (li == lmax) lcommon = li; */
 
-  an = bdiff_splitlines(sa + lcommon, la - lcommon, &al);
-  bn = bdiff_splitlines(sb + lcommon, lb - lcommon, &bl);
-  if (!al || !bl)
+  an = bdiff_countlines(sa + lcommon, la - lcommon);
+  bn = bdiff_countlines(sb + lcommon, lb - lcommon);
+  lines = growlines(lines, &size, (Py_ssize_t)an + bn);
+  if (!lines)
     goto nomem;
+  al = lines;
+  bl = lines + an;
+  an = bdiff_splitlinesinto(sa + lcommon, la - lcommon, al);
+  bn = bdiff_splitlinesinto(sb + lcommon, lb - lcommon, bl);
 
   count = bdiff_diff(al, an, bl, bn, &l);
   if (count < 0)
@@ -146,8 +198,7 @@ static PyObject* bdiff(PyObject* self, PyObject* args) {
 nomem:
   if (_save)
     PyEval_RestoreThread(_save);
-  free(al);
-  free(bl);
+  givelines(lines, size);
   bdiff_freehunks(l.next);
   return result ? result : PyErr_NoMemory();
 }
@@ -104,6 +104,24 @@ static const uint8_t jsonparanoidlentable[128] = {
     1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 6, /* DEL */
 };
 
+/* What isasciistr, asciilower, asciiupper and jsonescapeu8fast leave to their
+   scalar loops, and the letters whose case asciilower and asciiupper flip */
+static const asciirange nonasciiranges[] = {{0x80, 0xff}};
+static const asciirange upperletters = {'A', 'Z'};
+static const asciirange lowerletters = {'a', 'z'};
+static const asciirange jsonranges[] = {
+    {0x00, 0x1f},
+    {'"', '"'},
+    {'\\', '\\'},
+    {0x7f, 0x7f}};
+static const asciirange jsonparanoidranges[] = {
+    {0x00, 0x1f},
+    {'"', '"'},
+    {'<', '<'},
+    {'>', '>'},
+    {'\\', '\\'},
+    {0x7f, 0xff}};
+
 static const char hexchartable[16] = {
     '0',
     '1',
@@ -150,13 +168,15 @@ PyObject* unhexlify(const char* str, Py_ssize_t len) {
 PyObject* isasciistr(PyObject* self, PyObject* args) {
   const char* buf;
   Py_ssize_t i, len;
+  asciiblockset set;
   if (!PyArg_ParseTuple(args, "s#:isasciistr", &buf, &len))
     return NULL;
-  i = 0;
+  asciiblockinit(&set, nonasciiranges, 1, NULL);
+  i = asciiblockcopy(NULL, buf, len, &set);
   /* char array in PyStringObject should be at least 4-byte aligned */
   if (((uintptr_t)buf & 3) == 0) {
     const uint32_t* p = (const uint32_t*)buf;
-    for (; i < len / 4; i++) {
+    for (i /= 4; i < len / 4; i++) {
       if (p[i] & 0x80808080U)
         Py_RETURN_FALSE;
     }
@@ -174,9 +194,16 @@ static inline PyObject* _asciitransform(
     const char table[128],
     PyObject* fallback_fn) {
   char *str, *newstr;
-  Py_ssize_t i, len;
+  Py_ssize_t i, end, len;
   PyObject* newobj = NULL;
   PyObject* ret = NULL;
+  asciiblockset set;
+
+  asciiblockinit(
+      &set,
+      nonasciiranges,
+      1,
+      table == lowertable ? &upperletters : &lowerletters);
 
   str = PyBytes_AS_STRING(str_obj);
   len = PyBytes_GET_SIZE(str_obj);
@@ -187,20 +214,23 @@ static inline PyObject* _asciitransform(
 
   newstr = PyBytes_AS_STRING(newobj);
 
-  for (i = 0; i < len; i++) {
-    char c = str[i];
-    if (c & 0x80) {
-      if (fallback_fn != NULL) {
-        ret = PyObject_CallFunctionObjArgs(fallback_fn, str_obj, NULL);
-      } else {
-        PyObject* err = PyUnicodeDecodeError_Create(
-            "ascii", str, len, i, (i + 1), "unexpected code byte");
-        PyErr_SetObject(PyExc_UnicodeDecodeError, err);
-        Py_XDECREF(err);
+  for (i = 0; i < len;) {
+    i += asciiblockcopy(newstr + i, str + i, len - i, &set);
+    for (end = MIN(i + ASCIIBLOCK, len); i < end; i++) {
+      char c = str[i];
+      if (c & 0x80) {
+        if (fallback_fn != NULL) {
+          ret = PyObject_CallFunctionObjArgs(fallback_fn, str_obj, NULL);
+        } else {
+          PyObject* err = PyUnicodeDecodeError_Create(
+              "ascii", str, len, i, (i + 1), "unexpected code byte");
+          PyErr_SetObject(PyExc_UnicodeDecodeError, err);
+          Py_XDECREF(err);
+        }
+        goto quit;
       }
-      goto quit;
+      newstr[i] = table[(unsigned char)c];
     }
-    newstr[i] = table[(unsigned char)c];
   }
 
   ret = newobj;
@@ -296,29 +326,36 @@ quit:
   return NULL;
 }
 
+/* make asciiblockcopy stop at the blocks with anything to escape */
+static void jsonblockinit(asciiblockset* set, bool paranoid) {
+  if (paranoid)
+    asciiblockinit(set, jsonparanoidranges, 6, NULL);
+  else
+    asciiblockinit(set, jsonranges, 4, NULL);
+}
+
 /* calculate length of JSON-escaped string; returns -1 if unsupported */
 static Py_ssize_t
 jsonescapelen(const char* buf, Py_ssize_t len, bool paranoid) {
-  Py_ssize_t i, esclen = 0;
+  const uint8_t* lentable = (paranoid) ? jsonparanoidlentable : jsonlentable;
+  asciiblockset set;
+  Py_ssize_t i, end, esclen = 0;
 
-  if (paranoid) {
-    /* don't want to process multi-byte escapes in C */
-    for (i = 0; i < len; i++) {
+  jsonblockinit(&set, paranoid);
+
+  for (i = 0; i < len;) {
+    /* blocks without anything to escape keep their length */
+    Py_ssize_t span = asciiblockcopy(NULL, buf + i, len - i, &set);
+    esclen += span;
+    i += span;
+    for (end = MIN(i + ASCIIBLOCK, len); i < end; i++) {
       char c = buf[i];
-      if (c & 0x80) {
+      /* don't want to process multi-byte escapes in C */
+      if (paranoid && (c & 0x80)) {
         PyErr_SetString(PyExc_ValueError, "cannot process non-ascii str");
         return -1;
       }
-      esclen += jsonparanoidlentable[(unsigned char)c];
-      if (esclen < 0) {
-        PyErr_SetString(PyExc_MemoryError, "overflow in jsonescapelen");
-        return -1;
-      }
-    }
-  } else {
-    for (i = 0; i < len; i++) {
-      char c = buf[i];
-      esclen += jsonlentable[(unsigned char)c];
+      esclen += lentable[(unsigned char)c];
       if (esclen < 0) {
         PyErr_SetString(PyExc_MemoryError, "overflow in jsonescapelen");
         return -1;
@@ -359,27 +396,37 @@ static void encodejsonescape(
     Py_ssize_t origlen,
     bool paranoid) {
   const uint8_t* lentable = (paranoid) ? jsonparanoidlentable : jsonlentable;
-  Py_ssize_t i, j;
-
-  for (i = 0, j = 0; i < origlen; i++) {
-    char c = origbuf[i];
-    uint8_t l = lentable[(unsigned char)c];
-    assert(j + l <= esclen);
-    switch (l) {
-      case 1:
-        escbuf[j] = c;
-        break;
-      case 2:
-        escbuf[j] = '\\';
-        escbuf[j + 1] = jsonescapechar2(c);
-        break;
-      case 6:
-        memcpy(escbuf + j, "\\u00", 4);
-        escbuf[j + 4] = hexchartable[(unsigned char)c >> 4];
-        escbuf[j + 5] = hexchartable[(unsigned char)c & 0xf];
-        break;
+  asciiblockset set;
+  Py_ssize_t i, j, end;
+
+  jsonblockinit(&set, paranoid);
+
+  for (i = 0, j = 0; i < origlen;) {
+    Py_ssize_t span =
+        asciiblockcopy(escbuf + j, origbuf + i, origlen - i, &set);
+    assert(j + span <= esclen);
+    i += span;
+    j += span;
+    for (end = MIN(i + ASCIIBLOCK, origlen); i < end; i++) {
+      char c = origbuf[i];
+      uint8_t l = lentable[(unsigned char)c];
+      assert(j + l <= esclen);
+      switch (l) {
+        case 1:
+          escbuf[j] = c;
+          break;
+        case 2:
+          escbuf[j] = '\\';
+          escbuf[j + 1] = jsonescapechar2(c);
+          break;
+        case 6:
+          memcpy(escbuf + j, "\\u00", 4);
+          escbuf[j + 4] = hexchartable[(unsigned char)c >> 4];
+          escbuf[j + 5] = hexchartable[(unsigned char)c & 0xf];
+          break;
+      }
+      j += l;
     }
-    j += l;
   }
 }
 
@@ -18,8 +18,18 @@
 #define _HG_CHARENCODE_H_
 
 #include <Python.h>
+#include <assert.h>
 #include "eden/scm/edenscm/compat.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ASCIIBLOCK_SSE2
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define ASCIIBLOCK_NEON
+#endif
+
 /* This should be kept in sync with normcasespecs in encoding.py. */
 enum normcase_spec {
   NORMCASE_LOWER = -1,
@@ -34,6 +44,134 @@ PyObject* asciiupper(PyObject* self, PyObject* args);
 PyObject* make_file_foldmap(PyObject* self, PyObject* args);
 PyObject* jsonescapeu8fast(PyObject* self, PyObject* args);
 
+/* Bytes from lo to hi, both included. A range may not cover all 256 values. */
+typedef struct {
+  uint8_t lo, hi;
+} asciirange;
+
+#define ASCIIBLOCK 16
+#define ASCIIBLOCK_MAXRANGES 8
+
+#if defined(ASCIIBLOCK_SSE2)
+typedef __m128i asciivec;
+#elif defined(ASCIIBLOCK_NEON)
+typedef uint8x16_t asciivec;
+#endif
+
+/*
+ * What asciiblockcopy stops at and what it changes, set up once by
+ * asciiblockinit for a whole string.
+ */
+typedef struct {
+#if defined(ASCIIBLOCK_SSE2) || defined(ASCIIBLOCK_NEON)
+  asciivec lo[ASCIIBLOCK_MAXRANGES], top[ASCIIBLOCK_MAXRANGES];
+  asciivec fliplo, fliptop;
+  int nranges;
+  int flip;
+#else
+  char unused;
+#endif
+} asciiblockset;
+
+#if defined(ASCIIBLOCK_SSE2)
+/* SSE2 only compares signed bytes: lo <= v <= hi is the same as
+   v - lo - 128 < hi - lo - 127 */
+#define ASCIIVEC_LO(range) _mm_set1_epi8((char)((range).lo + 0x80))
+#define ASCIIVEC_TOP(range) _mm_set1_epi8((char)((range).hi - (range).lo - 127))
+#define ASCIIVEC_IN(v, lo, top) _mm_cmplt_epi8(_mm_sub_epi8(v, lo), top)
+#elif defined(ASCIIBLOCK_NEON)
+#define ASCIIVEC_LO(range) vdupq_n_u8((range).lo)
+#define ASCIIVEC_TOP(range) vdupq_n_u8((range).hi - (range).lo)
+#define ASCIIVEC_IN(v, lo, top) vcleq_u8(vsubq_u8(v, lo), top)
+#endif
+
+/*
+ * Make asciiblockcopy stop at the blocks with a byte in any of the nranges
+ * (at most ASCIIBLOCK_MAXRANGES) ranges, and flip the case of the bytes in
+ * the flipcase range of the blocks it copies unless flipcase is NULL.
+ */
+static inline void asciiblockinit(
+    asciiblockset* set,
+    const asciirange* ranges,
+    int nranges,
+    const asciirange* flipcase) {
+#if defined(ASCIIBLOCK_SSE2) || defined(ASCIIBLOCK_NEON)
+  int r;
+  assert(nranges <= ASCIIBLOCK_MAXRANGES);
+  for (r = 0; r < nranges; r++) {
+    set->lo[r] = ASCIIVEC_LO(ranges[r]);
+    set->top[r] = ASCIIVEC_TOP(ranges[r]);
+  }
+  set->nranges = nranges;
+  set->flip = flipcase != NULL;
+  if (set->flip) {
+    set->fliplo = ASCIIVEC_LO(*flipcase);
+    set->fliptop = ASCIIVEC_TOP(*flipcase);
+  }
+#else
+  (void)set;
+  (void)ranges;
+  (void)nranges;
+  (void)flipcase;
+#endif
+}
+
+/*
+ * Return the length of the run of whole 16-byte blocks at the start of src
+ * that set does not stop at, and copy them to dst unless it is NULL. The
+ * block that stopped the scan and anything shorter than a block are left to
+ * the scalar loop of the caller. Without SSE2 or NEON, this is always 0.
+ */
+static inline Py_ssize_t asciiblockcopy(
+    char* dst,
+    const char* src,
+    Py_ssize_t len,
+    const asciiblockset* set) {
+  Py_ssize_t i = 0;
+#if defined(ASCIIBLOCK_SSE2) || defined(ASCIIBLOCK_NEON)
+  for (; i + ASCIIBLOCK <= len; i += ASCIIBLOCK) {
+    int r;
+#if defined(ASCIIBLOCK_SSE2)
+    asciivec v = _mm_loadu_si128((const __m128i*)(src + i));
+    asciivec hit = _mm_setzero_si128();
+    for (r = 0; r < set->nranges; r++)
+      hit = _mm_or_si128(hit, ASCIIVEC_IN(v, set->lo[r], set->top[r]));
+    if (_mm_movemask_epi8(hit))
+      break;
+    if (dst == NULL)
+      continue;
+    if (set->flip)
+      v = _mm_xor_si128(
+          v,
+          _mm_and_si128(
+              ASCIIVEC_IN(v, set->fliplo, set->fliptop), _mm_set1_epi8(0x20)));
+    _mm_storeu_si128((__m128i*)(dst + i), v);
+#else
+    asciivec v = vld1q_u8((const uint8_t*)src + i);
+    asciivec hit = vdupq_n_u8(0);
+    for (r = 0; r < set->nranges; r++)
+      hit = vorrq_u8(hit, ASCIIVEC_IN(v, set->lo[r], set->top[r]));
+    if (vmaxvq_u8(hit))
+      break;
+    if (dst == NULL)
+      continue;
+    if (set->flip)
+      v = veorq_u8(
+          v,
+          vandq_u8(
+              ASCIIVEC_IN(v, set->fliplo, set->fliptop), vdupq_n_u8(0x20)));
+    vst1q_u8((uint8_t*)dst + i, v);
+#endif
+  }
+#else
+  (void)dst;
+  (void)src;
+  (void)len;
+  (void)set;
+#endif
+  return i;
+}
+
 static const int8_t hextable[256] = {
     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
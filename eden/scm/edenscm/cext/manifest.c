@@ -19,6 +19,10 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
+#ifndef _WIN32
+#include <pthread.h>
+#include <unistd.h>
+#endif
 
 #include "eden/scm/edenscm/cext/charencode.h"
 #include "eden/scm/edenscm/cext/util.h"
@@ -49,6 +53,7 @@ typedef struct {
 #define MANIFEST_OOM -1
 #define MANIFEST_NOT_SORTED -2
 #define MANIFEST_MALFORMED -3
+#define MANIFEST_NO_PATH -4
 
 /* get the length of the path for a line */
 static size_t pathlen(line* l) {
@@ -117,8 +122,12 @@ static bool realloc_if_full(lazymanifest* self) {
  */
 static int find_lines(lazymanifest* self, char* data, Py_ssize_t len) {
   char* prev = NULL;
+  size_t prevlen = 0;
   while (len > 0) {
     line* l;
+    char* nul;
+    size_t plen;
+    int c;
     char* next = memchr(data, '\n', len);
     if (!next) {
       return MANIFEST_MALFORMED;
@@ -127,9 +136,20 @@ static int find_lines(lazymanifest* self, char* data, Py_ssize_t len) {
     if (!realloc_if_full(self)) {
       return MANIFEST_OOM; /* no memory */
     }
-    if (prev && strcmp(prev, data) > -1) {
-      /* This data isn't sorted, so we have to abort. */
-      return MANIFEST_NOT_SORTED;
+    /* Bound the search for the end of the path by the line, so that the
+     * sort check compares with memcmp rather than strcmp walking byte by
+     * byte, and a line without a path can't make it run into the next. */
+    nul = memchr(data, '\0', next - data);
+    if (!nul) {
+      return MANIFEST_NO_PATH;
+    }
+    plen = nul - data;
+    if (prev) {
+      c = memcmp(prev, data, prevlen < plen ? prevlen : plen);
+      if (c > 0 || (c == 0 && prevlen >= plen)) {
+        /* This data isn't sorted, so we have to abort. */
+        return MANIFEST_NOT_SORTED;
+      }
     }
     l = self->lines + ((self->numlines)++);
     l->start = data;
@@ -139,6 +159,7 @@ static int find_lines(lazymanifest* self, char* data, Py_ssize_t len) {
     l->deleted = false;
     len = len - l->len;
     prev = data;
+    prevlen = plen;
     data = next;
   }
   self->livelines = self->numlines;
@@ -179,6 +200,9 @@ static int lazymanifest_init(lazymanifest* self, PyObject* args) {
     case MANIFEST_MALFORMED:
       PyErr_Format(PyExc_ValueError, "Manifest did not end in a newline.");
       break;
+    case MANIFEST_NO_PATH:
+      PyErr_Format(PyExc_ValueError, "Manifest line has no path.");
+      break;
     default:
       PyErr_Format(PyExc_ValueError, "Unknown problem parsing manifest.");
   }
@@ -487,8 +511,8 @@ finish:
   return 0;
 }
 
-static int
-lazymanifest_setitem(lazymanifest* self, PyObject* key, PyObject* value) {
+/* Encode the (node, flags) tuple for key into a newly allocated line. */
+static int encodeline(PyObject* key, PyObject* value, line* new) {
   const char* path;
   Py_ssize_t plen;
   PyObject* pyhash;
@@ -500,21 +524,6 @@ lazymanifest_setitem(lazymanifest* self, PyObject* key, PyObject* value) {
   size_t dlen;
   char* dest;
   int i;
-  line new;
-#ifdef IS_PY3K
-  if (!PyUnicode_Check(key)) {
-    PyErr_Format(PyExc_TypeError, "setitem: manifest keys must be a str.");
-    return -1;
-  }
-#else
-  if (!PyBytes_Check(key)) {
-    PyErr_Format(PyExc_TypeError, "setitem: manifest keys must be a str.");
-    return -1;
-  }
-#endif
-  if (!value) {
-    return lazymanifest_delitem(self, key);
-  }
   if (!PyTuple_Check(value) || PyTuple_Size(value) != 2) {
     PyErr_Format(
         PyExc_TypeError, "Manifest values must be a tuple of (node, flags).");
@@ -581,20 +590,222 @@ lazymanifest_setitem(lazymanifest* self, PyObject* key, PyObject* value) {
   }
   memcpy(dest + plen + 41, flags, flen);
   dest[plen + 41 + flen] = '\n';
-  new.start = dest;
-  new.len = dlen;
-  new.hash_suffix = '\0';
+  new->start = dest;
+  new->len = dlen;
+  new->hash_suffix = '\0';
   if (hlen > 20) {
-    new.hash_suffix = hash[20];
+    new->hash_suffix = hash[20];
+  }
+  new->from_malloc = true; /* is `start` a pointer we allocated? */
+  new->deleted = false; /* is this entry deleted? */
+  return 0;
+}
+
+static int
+lazymanifest_setitem(lazymanifest* self, PyObject* key, PyObject* value) {
+  line new;
+#ifdef IS_PY3K
+  if (!PyUnicode_Check(key)) {
+    PyErr_Format(PyExc_TypeError, "setitem: manifest keys must be a str.");
+    return -1;
+  }
+#else
+  if (!PyBytes_Check(key)) {
+    PyErr_Format(PyExc_TypeError, "setitem: manifest keys must be a str.");
+    return -1;
+  }
+#endif
+  if (!value) {
+    return lazymanifest_delitem(self, key);
+  }
+  if (encodeline(key, value, &new)) {
+    return -1;
   }
-  new.from_malloc = true; /* is `start` a pointer we allocated? */
-  new.deleted = false; /* is this entry deleted? */
   if (internalsetitem(self, &new)) {
+    free((void*)new.start);
     return -1;
   }
   return 0;
 }
 
+/* Where a change of bulkupdate goes in the lines of the manifest. */
+typedef struct {
+  int pos; /* index of the first line not sorting before the change */
+  bool found; /* whether the line at pos has the path of the change */
+} changepos;
+
+/* Index of the first of lines [start, end) not sorting before needle. */
+static int lowerbound(lazymanifest* self, line* needle, int start, int end) {
+  while (start < end) {
+    int pos = start + (end - start) / 2;
+    if (linecmp(self->lines + pos, needle) < 0)
+      start = pos + 1;
+    else
+      end = pos;
+  }
+  return start;
+}
+
+static void freechanges(line* changes, Py_ssize_t count) {
+  Py_ssize_t i;
+  for (i = 0; i < count; i++) {
+    if (changes[i].from_malloc) {
+      free((void*)changes[i].start);
+    }
+  }
+  free(changes);
+}
+
+/*
+ * Apply a sorted sequence of (path, (node, flags)) and (path, None) changes,
+ * the latter deleting path. Rather than one binary search and memmove per
+ * change as setitem does, the changes are located with binary searches that
+ * each start where the previous one ended and merged into the lines in a
+ * single pass from the end, so that every line moves at most once.
+ *
+ * Nothing is changed if any change is invalid, out of order, or deletes a
+ * path that is not in the manifest.
+ */
+static PyObject* lazymanifest_bulkupdate(lazymanifest* self, PyObject* arg) {
+  PyObject* seq;
+  Py_ssize_t count, i;
+  line* changes = NULL;
+  changepos* positions = NULL;
+  int inserts = 0, start = 0, end, k;
+  seq = PySequence_Fast(arg, "bulkupdate: changes must be a sequence");
+  if (!seq) {
+    return NULL;
+  }
+  count = PySequence_Fast_GET_SIZE(seq);
+  if (count == 0) {
+    Py_DECREF(seq);
+    Py_RETURN_NONE;
+  }
+  changes = calloc(count, sizeof(line));
+  positions = malloc(count * sizeof(changepos));
+  if (!changes || !positions) {
+    PyErr_NoMemory();
+    goto bail;
+  }
+  for (i = 0; i < count; i++) {
+    PyObject* change = PySequence_Fast_GET_ITEM(seq, i);
+    PyObject *key, *value;
+    line* new = changes + i;
+    if (!PyTuple_Check(change) || PyTuple_Size(change) != 2) {
+      PyErr_Format(
+          PyExc_TypeError, "bulkupdate: changes must be (path, value) tuples");
+      goto bail;
+    }
+    key = PyTuple_GET_ITEM(change, 0);
+    value = PyTuple_GET_ITEM(change, 1);
+#ifdef IS_PY3K
+    if (!PyUnicode_Check(key)) {
+      PyErr_Format(PyExc_TypeError, "bulkupdate: manifest keys must be a str.");
+      goto bail;
+    }
+#else
+    if (!PyBytes_Check(key)) {
+      PyErr_Format(PyExc_TypeError, "bulkupdate: manifest keys must be a str.");
+      goto bail;
+    }
+#endif
+    if (value == Py_None) {
+      /* The path is borrowed from the key, which seq keeps alive. */
+#ifdef IS_PY3K
+      new->start = PyUnicode_AsUTF8(key);
+#else
+      new->start = PyBytes_AsString(key);
+#endif
+      if (!new->start) {
+        goto bail;
+      }
+      new->deleted = true;
+    } else if (encodeline(key, value, new)) {
+      goto bail;
+    }
+    if (i > 0 && linecmp(new - 1, new) >= 0) {
+      PyErr_Format(
+          PyExc_ValueError, "bulkupdate: changes not in sorted order.");
+      goto bail;
+    }
+  }
+
+  /* Locate every change before modifying anything. */
+  for (i = 0; i < count; i++) {
+    changepos* p = positions + i;
+    p->pos = start = lowerbound(self, changes + i, start, self->numlines);
+    p->found = start < self->numlines &&
+        linecmp(self->lines + start, changes + i) == 0;
+    if (changes[i].deleted &&
+        (!p->found || self->lines[start].deleted)) {
+      PyErr_Format(
+          PyExc_KeyError, "Tried to delete nonexistent manifest entry.");
+      goto bail;
+    }
+    if (!p->found) {
+      inserts++;
+    }
+  }
+  if (self->numlines + inserts > self->maxlines) {
+    int maxlines = self->maxlines;
+    line* lines;
+    while (maxlines < self->numlines + inserts) {
+      maxlines *= 2;
+    }
+    lines = realloc(self->lines, maxlines * sizeof(line));
+    if (!lines) {
+      PyErr_NoMemory();
+      goto bail;
+    }
+    self->lines = lines;
+    self->maxlines = maxlines;
+  }
+
+  /* Merge from the end, moving each run of untouched lines once. */
+  end = self->numlines;
+  k = self->numlines + inserts;
+  for (i = count - 1; i >= 0; i--) {
+    changepos* p = positions + i;
+    line* new = changes + i;
+    int tail = p->found ? p->pos + 1 : p->pos;
+    k -= end - tail;
+    memmove(self->lines + k, self->lines + tail, (end - tail) * sizeof(line));
+    k--;
+    if (!p->found) {
+      self->lines[k] = *new;
+      self->livelines++;
+    } else {
+      line old = self->lines[p->pos];
+      if (new->deleted) {
+        old.deleted = true;
+        self->lines[k] = old;
+        self->livelines--;
+      } else {
+        if (old.deleted)
+          self->livelines++;
+        if (old.from_malloc)
+          free((void*)old.start);
+        self->lines[k] = *new;
+      }
+    }
+    end = p->pos;
+  }
+  assert(k == end);
+  self->numlines += inserts;
+  self->dirty = true;
+  free(changes);
+  free(positions);
+  Py_DECREF(seq);
+  Py_RETURN_NONE;
+bail:
+  if (changes) {
+    freechanges(changes, count);
+  }
+  free(positions);
+  Py_DECREF(seq);
+  return NULL;
+}
+
 static PyMappingMethods lazymanifest_mapping_methods = {
     (lenfunc)lazymanifest_size, /* mp_length */
     (binaryfunc)lazymanifest_getitem, /* mp_subscript */
@@ -783,135 +994,338 @@ nomem:
   return NULL;
 }
 
-static PyObject* lazymanifest_diff(lazymanifest* self, PyObject* args) {
+/* Manifests with at least this many lines between them are diffed by
+ * several threads when diff isn't told how many to use. */
+#define DIFF_PARALLEL_LINES 2000000
+#define DIFF_MAX_WORKERS 8
+
+/* A difference found by diff, -1 standing for a path missing in one of the
+ * manifests. */
+typedef struct {
+  int left;
+  int right;
+  bool clean;
+} diffentry;
+
+/* The differences between lines [sstart, send) of self and lines
+ * [ostart, oend) of other, which hold the same range of paths. */
+typedef struct {
+  lazymanifest* self;
   lazymanifest* other;
-  PyObject* pyclean = NULL;
+  int sstart, send;
+  int ostart, oend;
   bool listclean;
+  diffentry* entries;
+  int numentries;
+  int maxentries;
+  bool oom;
+} diffrange;
+
+static void appenddiff(diffrange* r, int left, int right, bool clean) {
+  diffentry* e;
+  if (r->oom) {
+    return;
+  }
+  if (r->numentries == r->maxentries) {
+    int maxentries = r->maxentries ? r->maxentries * 2 : 64;
+    diffentry* entries = realloc(r->entries, maxentries * sizeof(diffentry));
+    if (!entries) {
+      r->oom = true;
+      return;
+    }
+    r->entries = entries;
+    r->maxentries = maxentries;
+  }
+  e = r->entries + r->numentries++;
+  e->left = left;
+  e->right = right;
+  e->clean = clean;
+}
+
+/* Length of the common prefix of a and b, both len bytes long. Chunks twice
+ * as large as the previous one are compared with memcmp, so long identical
+ * spans cost little more than a memcmp and the byte by byte search for the
+ * first difference is bounded by the span that preceded it. */
+static size_t commonprefix(const char* a, const char* b, size_t len) {
+  size_t done = 0, chunk = 64;
+  while (done < len) {
+    size_t n = len - done < chunk ? len - done : chunk;
+    if (memcmp(a + done, b + done, n)) {
+      while (a[done] == b[done]) {
+        done++;
+      }
+      return done;
+    }
+    done += n;
+    if (chunk < 65536) {
+      chunk *= 2;
+    }
+  }
+  return done;
+}
+
+/* Index of the first of lines [start, end) not entirely before limit. */
+static int firstlineafter(line* lines, int start, int end, const char* limit) {
+  while (start < end) {
+    int pos = start + (end - start) / 2;
+    if (lines[pos].start + lines[pos].len <= limit)
+      start = pos + 1;
+    else
+      end = pos;
+  }
+  return start;
+}
+
+/*
+ * Walk both ranges like a merge. Both manifests are compacted, so their lines
+ * are contiguous: once two lines are found identical, the identical bytes
+ * that follow are skipped with commonprefix, without comparing the paths or
+ * creating any object for the lines they span.
+ */
+static void diffrange_run(diffrange* r) {
+  line* left = r->self->lines;
+  line* right = r->other->lines;
+  int s = r->sstart, o = r->ostart;
+  while (s < r->send || o < r->oend) {
+    int c, n, k;
+    const char *lstart, *rstart;
+    size_t avail, same;
+    if (r->oom) {
+      return;
+    }
+    if (s == r->send) {
+      c = 1;
+    } else if (o == r->oend) {
+      c = -1;
+    } else {
+      c = linecmp(left + s, right + o);
+    }
+    if (c < 0) {
+      appenddiff(r, s++, -1, false);
+      continue;
+    }
+    if (c > 0) {
+      appenddiff(r, -1, o++, false);
+      continue;
+    }
+    if (left[s].len != right[o].len ||
+        memcmp(left[s].start, right[o].start, left[s].len)) {
+      appenddiff(r, s++, o++, false);
+      continue;
+    }
+    lstart = left[s].start;
+    rstart = right[o].start;
+    avail = left[r->send - 1].start + left[r->send - 1].len - lstart;
+    if ((size_t)(right[r->oend - 1].start + right[r->oend - 1].len - rstart) <
+        avail) {
+      avail = right[r->oend - 1].start + right[r->oend - 1].len - rstart;
+    }
+    same = left[s].len +
+        commonprefix(
+               lstart + left[s].len,
+               rstart + left[s].len,
+               avail - left[s].len);
+    /* Identical bytes have their newlines in the same places, so both sides
+     * have the same n lines in the span. */
+    n = firstlineafter(left, s, r->send, lstart + same) - s;
+    for (k = 0; k < n; k++) {
+      /* The 21st byte of a node isn't part of the text. */
+      if (left[s + k].hash_suffix != right[o + k].hash_suffix) {
+        appenddiff(r, s + k, o + k, false);
+      } else if (r->listclean) {
+        appenddiff(r, s + k, o + k, true);
+      }
+    }
+    s += n;
+    o += n;
+  }
+}
+
+#ifndef _WIN32
+static void* diffrange_thread(void* arg) {
+  diffrange_run(arg);
+  return NULL;
+}
+#endif
+
+/* Diff ranges [0, workers) of self and other, the first on this thread. */
+static void diffranges(diffrange* ranges, int workers) {
+#ifndef _WIN32
+  pthread_t threads[DIFF_MAX_WORKERS];
+  bool started[DIFF_MAX_WORKERS];
+  int i;
+  for (i = 1; i < workers; i++) {
+    started[i] =
+        pthread_create(threads + i, NULL, diffrange_thread, ranges + i) == 0;
+  }
+  diffrange_run(ranges);
+  for (i = 1; i < workers; i++) {
+    if (started[i]) {
+      pthread_join(threads[i], NULL);
+    } else {
+      diffrange_run(ranges + i);
+    }
+  }
+#else
+  int i;
+  for (i = 0; i < workers; i++) {
+    diffrange_run(ranges + i);
+  }
+#endif
+}
+
+static int diffworkers(lazymanifest* self, lazymanifest* other) {
+  long cpus = 1;
+  if (self->numlines + (long)other->numlines < DIFF_PARALLEL_LINES) {
+    return 1;
+  }
+#ifndef _WIN32
+  cpus = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+  if (cpus < 1) {
+    return 1;
+  }
+  return cpus < DIFF_MAX_WORKERS ? cpus : DIFF_MAX_WORKERS;
+}
+
+static PyObject* diffkey(line* l) {
+#ifdef IS_PY3K
+  return PyUnicode_FromString(l->start);
+#else
+  return PyBytes_FromString(l->start);
+#endif
+}
+
+/* Build the dict diff returns from the differences found. */
+static PyObject*
+diffresult(lazymanifest* self, lazymanifest* other, diffrange* ranges, int n) {
   PyObject *emptyTup = NULL, *ret = NULL;
   PyObject* es;
-  int sneedle = 0, oneedle = 0;
-  if (!PyArg_ParseTuple(args, "O!|O", &lazymanifestType, &other, &pyclean)) {
-    return NULL;
-  }
-  listclean = (!pyclean) ? false : PyObject_IsTrue(pyclean);
+  int i, j;
 #ifdef IS_PY3K
   es = PyUnicode_FromString("");
 #else
   es = PyBytes_FromString("");
 #endif
   if (!es) {
-    goto nomem;
+    return NULL;
   }
   emptyTup = PyTuple_Pack(2, Py_None, es);
   Py_DECREF(es);
   if (!emptyTup) {
-    goto nomem;
+    return NULL;
   }
   ret = PyDict_New();
   if (!ret) {
-    goto nomem;
+    goto bail;
   }
-  while (sneedle != self->numlines || oneedle != other->numlines) {
-    line* left = self->lines + sneedle;
-    line* right = other->lines + oneedle;
-    int result;
-    PyObject* key;
-    PyObject* outer;
-    /* If we're looking at a deleted entry and it's not
-     * the end of the manifest, just skip it. */
-    if (sneedle < self->numlines && left->deleted) {
-      sneedle++;
-      continue;
-    }
-    if (oneedle < other->numlines && right->deleted) {
-      oneedle++;
-      continue;
-    }
-    /* if we're at the end of either manifest, then we
-     * know the remaining items are adds so we can skip
-     * the strcmp. */
-    if (sneedle == self->numlines) {
-      result = 1;
-    } else if (oneedle == other->numlines) {
-      result = -1;
-    } else {
-      result = linecmp(left, right);
-    }
-#ifdef IS_PY3K
-    key = result <= 0 ? PyUnicode_FromString(left->start)
-                      : PyUnicode_FromString(right->start);
-#else
-    key = result <= 0 ? PyBytes_FromString(left->start)
-                      : PyBytes_FromString(right->start);
-#endif
-    if (!key)
-      goto nomem;
-    if (result < 0) {
-      PyObject* l = hashflags(left);
-      if (!l) {
-        goto nomem;
-      }
-      outer = PyTuple_Pack(2, l, emptyTup);
-      Py_DECREF(l);
-      if (!outer) {
-        goto nomem;
-      }
-      PyDict_SetItem(ret, key, outer);
-      Py_DECREF(outer);
-      sneedle++;
-    } else if (result > 0) {
-      PyObject* r = hashflags(right);
-      if (!r) {
-        goto nomem;
-      }
-      outer = PyTuple_Pack(2, emptyTup, r);
-      Py_DECREF(r);
-      if (!outer) {
-        goto nomem;
+  for (i = 0; i < n; i++) {
+    for (j = 0; j < ranges[i].numentries; j++) {
+      diffentry* e = ranges[i].entries + j;
+      line* left = e->left >= 0 ? self->lines + e->left : NULL;
+      line* right = e->right >= 0 ? other->lines + e->right : NULL;
+      PyObject *key, *l = NULL, *r = NULL, *value;
+      int err;
+      key = diffkey(left ? left : right);
+      if (!key) {
+        goto bail;
       }
-      PyDict_SetItem(ret, key, outer);
-      Py_DECREF(outer);
-      oneedle++;
-    } else {
-      /* file exists in both manifests */
-      if (left->len != right->len ||
-          memcmp(left->start, right->start, left->len) ||
-          left->hash_suffix != right->hash_suffix) {
-        PyObject* l = hashflags(left);
-        PyObject* r;
-        if (!l) {
-          goto nomem;
-        }
-        r = hashflags(right);
-        if (!r) {
-          Py_DECREF(l);
-          goto nomem;
+      if (e->clean) {
+        value = Py_None;
+        Py_INCREF(value);
+      } else {
+        l = left ? hashflags(left) : emptyTup;
+        r = right ? hashflags(right) : emptyTup;
+        value = l && r ? PyTuple_Pack(2, l, r) : NULL;
+        if (left) {
+          Py_XDECREF(l);
         }
-        outer = PyTuple_Pack(2, l, r);
-        Py_DECREF(l);
-        Py_DECREF(r);
-        if (!outer) {
-          goto nomem;
+        if (right) {
+          Py_XDECREF(r);
         }
-        PyDict_SetItem(ret, key, outer);
-        Py_DECREF(outer);
-      } else if (listclean) {
-        PyDict_SetItem(ret, key, Py_None);
       }
-      sneedle++;
-      oneedle++;
+      err = value ? PyDict_SetItem(ret, key, value) : -1;
+      Py_DECREF(key);
+      Py_XDECREF(value);
+      if (err) {
+        goto bail;
+      }
     }
-    Py_DECREF(key);
   }
   Py_DECREF(emptyTup);
   return ret;
-nomem:
-  PyErr_NoMemory();
+bail:
   Py_XDECREF(ret);
-  Py_XDECREF(emptyTup);
+  Py_DECREF(emptyTup);
   return NULL;
 }
 
+static PyObject* lazymanifest_diff(lazymanifest* self, PyObject* args) {
+  lazymanifest* other;
+  PyObject* pyclean = NULL;
+  PyObject* ret = NULL;
+  bool listclean;
+  int workers = 0, i;
+  diffrange ranges[DIFF_MAX_WORKERS];
+  if (!PyArg_ParseTuple(
+          args, "O!|Oi", &lazymanifestType, &other, &pyclean, &workers)) {
+    return NULL;
+  }
+  listclean = (!pyclean) ? false : PyObject_IsTrue(pyclean);
+  if (workers < 0 || workers > DIFF_MAX_WORKERS) {
+    PyErr_Format(
+        PyExc_ValueError, "diff: workers must be in [0, %d]", DIFF_MAX_WORKERS);
+    return NULL;
+  }
+  /* Compact both sides so that their lines are contiguous and none are
+   * deleted, which is what lets diffrange_run skip identical spans. */
+  if (compact(self) != 0 || compact(other) != 0) {
+    PyErr_NoMemory();
+    return NULL;
+  }
+  if (workers == 0) {
+    workers = diffworkers(self, other);
+  }
+  if (workers > self->numlines) {
+    workers = self->numlines > 0 ? self->numlines : 1;
+  }
+  /* Split self evenly and other where the first path of every range of self
+   * would be, so that every range of other holds the same paths. */
+  for (i = 0; i < workers; i++) {
+    diffrange* r = ranges + i;
+    memset(r, 0, sizeof(*r));
+    r->self = self;
+    r->other = other;
+    r->listclean = listclean;
+    r->sstart = (int)((long long)self->numlines * i / workers);
+    r->send = (int)((long long)self->numlines * (i + 1) / workers);
+    r->ostart = i == 0
+        ? 0
+        : lowerbound(
+              other, self->lines + r->sstart, ranges[i - 1].ostart,
+              other->numlines);
+    if (i > 0) {
+      ranges[i - 1].oend = r->ostart;
+    }
+  }
+  ranges[workers - 1].oend = other->numlines;
+  /* The workers only read the lines, and the GIL stays held so that nothing
+   * else can modify either manifest meanwhile. */
+  diffranges(ranges, workers);
+  for (i = 0; i < workers; i++) {
+    if (ranges[i].oom) {
+      PyErr_NoMemory();
+      goto done;
+    }
+  }
+  ret = diffresult(self, other, ranges, workers);
+done:
+  for (i = 0; i < workers; i++) {
+    free(ranges[i].entries);
+  }
+  return ret;
+}
+
 static PyMethodDef lazymanifest_methods[] = {
     {"keys",
      (PyCFunction)lazymanifest_getkeysiter,
@@ -936,7 +1350,13 @@ static PyMethodDef lazymanifest_methods[] = {
     {"diff",
      (PyCFunction)lazymanifest_diff,
      METH_VARARGS,
-     "Compare this lazymanifest to another one."},
+     "Compare this lazymanifest to another one, optionally listing clean\n"
+     "files and with the given number of threads, 0 picking one from the\n"
+     "size of the manifests."},
+    {"bulkupdate",
+     (PyCFunction)lazymanifest_bulkupdate,
+     METH_O,
+     "Apply a sorted sequence of (path, (node, flags) or None) changes."},
     {"text",
      (PyCFunction)lazymanifest_text,
      METH_NOARGS,
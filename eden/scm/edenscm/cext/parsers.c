@@ -347,6 +347,393 @@ quit:
   return ret;
 }
 
+/*
+ * A read-only view of a dirstate that only indexes the entries of its data,
+ * sorted by name, and builds their dirstate tuples when they are looked up.
+ * Commands that look at a few files therefore no longer pay for a dict entry
+ * per tracked file. The (rare) copies are still read upfront into the
+ * copymap given to the constructor.
+ */
+typedef struct {
+  const char* start; /* header of the entry, followed by its name */
+  uint32_t namelen;
+  uint32_t flen;
+} dirstateentry;
+
+typedef struct {
+  PyObject_HEAD Py_buffer data;
+  dirstateentry* entries; /* in the order of the data */
+  Py_ssize_t numentries;
+  /* Sorted by name, keeping only the last of the entries with the same
+   * name, like parse_dirstate does. */
+  dirstateentry** index;
+  Py_ssize_t numindex;
+} lazydirstate;
+
+static inline int
+namecmp(const char* l, uint32_t llen, const char* r, uint32_t rlen) {
+  int cmp = memcmp(l, r, llen < rlen ? llen : rlen);
+  if (cmp)
+    return cmp;
+  return llen < rlen ? -1 : (llen > rlen);
+}
+
+static int dirstateentrycmp(const void* left, const void* right) {
+  const dirstateentry* l = *(const dirstateentry* const*)left;
+  const dirstateentry* r = *(const dirstateentry* const*)right;
+  int cmp = namecmp(l->start + 17, l->namelen, r->start + 17, r->namelen);
+  if (cmp)
+    return cmp;
+  /* break ties by position so that the last duplicate sorts last */
+  return l->start < r->start ? -1 : (l->start > r->start);
+}
+
+static inline int samename(const dirstateentry* l, const dirstateentry* r) {
+  return l->namelen == r->namelen &&
+      memcmp(l->start + 17, r->start + 17, l->namelen) == 0;
+}
+
+/* Sort the index and drop the duplicates. The dirstate is written in the
+ * order of its dict, where the files added by every checkout or command
+ * follow the ones that were already there, so it is made of a few sorted
+ * runs that get merged pairwise. */
+static int lazydirstate_sortindex(lazydirstate* self) {
+  dirstateentry **src = self->index, **dst, **tmp;
+  Py_ssize_t *runs, nruns = 0, i, j, k, end, mid, n = self->numindex;
+  runs = malloc((n + 1) * sizeof(Py_ssize_t));
+  if (!runs)
+    return -1;
+  for (i = 0; i < n; i++) {
+    if (i == 0 || dirstateentrycmp(&src[i - 1], &src[i]) > 0)
+      runs[nruns++] = i;
+  }
+  runs[nruns] = n;
+  if (nruns > 1) {
+    dst = malloc(n * sizeof(dirstateentry*));
+    if (!dst) {
+      free(runs);
+      return -1;
+    }
+    while (nruns > 1) {
+      for (k = 0; k < nruns; k += 2) {
+        i = runs[k];
+        mid = j = runs[k + 1];
+        end = k + 2 <= nruns ? runs[k + 2] : n;
+        tmp = dst + i;
+        while (i < mid && j < end) {
+          if (dirstateentrycmp(&src[i], &src[j]) < 0)
+            *tmp++ = src[i++];
+          else
+            *tmp++ = src[j++];
+        }
+        memcpy(tmp, src + i, (mid - i) * sizeof(dirstateentry*));
+        tmp += mid - i;
+        memcpy(tmp, src + j, (end - j) * sizeof(dirstateentry*));
+        runs[k / 2] = runs[k];
+      }
+      nruns = (nruns + 1) / 2;
+      runs[nruns] = n;
+      tmp = src;
+      src = dst;
+      dst = tmp;
+    }
+    free(dst);
+    self->index = src;
+  }
+  free(runs);
+  for (i = j = 0; i < self->numindex; i++) {
+    if (i + 1 < self->numindex &&
+        samename(self->index[i], self->index[i + 1])) {
+      continue;
+    }
+    self->index[j++] = self->index[i];
+  }
+  self->numindex = j;
+  return 0;
+}
+
+static int lazydirstate_init(lazydirstate* self, PyObject* args) {
+  PyObject *pydata, *cmap, *fname = NULL, *cname = NULL;
+  const char *str, *cur, *cpos;
+  uint32_t flen;
+  Py_ssize_t len, pos = 40, maxentries;
+  dirstateentry* entry;
+  int ret;
+
+  if (!PyArg_ParseTuple(
+          args, "OO!:lazydirstate", &pydata, &PyDict_Type, &cmap))
+    return -1;
+  if (self->data.obj) {
+    PyErr_SetString(PyExc_ValueError, "lazydirstate already initialized");
+    return -1;
+  }
+  if (PyObject_GetBuffer(pydata, &self->data, PyBUF_SIMPLE) == -1)
+    return -1;
+  str = self->data.buf;
+  len = self->data.len;
+
+  if (len < 40) {
+    PyErr_SetString(PyExc_ValueError, "too little data for parents");
+    return -1;
+  }
+
+  /* every entry takes at least a header */
+  maxentries = (len - 40) / 17;
+  self->entries = malloc(maxentries * sizeof(dirstateentry) + 1);
+  self->index = malloc(maxentries * sizeof(dirstateentry*) + 1);
+  if (!self->entries || !self->index) {
+    PyErr_NoMemory();
+    return -1;
+  }
+
+  while (pos < len) {
+    if (pos + 17 > len) {
+      PyErr_SetString(PyExc_ValueError, "overflow in dirstate");
+      return -1;
+    }
+    cur = str + pos;
+    flen = getbe32(cur + 13);
+    pos += 17;
+    if (flen > len - pos) {
+      PyErr_SetString(PyExc_ValueError, "overflow in dirstate");
+      return -1;
+    }
+    entry = &self->entries[self->numentries++];
+    entry->start = cur;
+    entry->flen = flen;
+    entry->namelen = flen;
+    cpos = memchr(cur + 17, 0, flen);
+    if (cpos) {
+      entry->namelen = cpos - (cur + 17);
+#ifdef IS_PY3K
+      fname = PyUnicode_FromStringAndSize(cur + 17, entry->namelen);
+      cname =
+          PyUnicode_FromStringAndSize(cpos + 1, flen - entry->namelen - 1);
+#else
+      fname = PyBytes_FromStringAndSize(cur + 17, entry->namelen);
+      cname = PyBytes_FromStringAndSize(cpos + 1, flen - entry->namelen - 1);
+#endif
+      if (!fname || !cname || PyDict_SetItem(cmap, fname, cname) == -1) {
+        Py_XDECREF(fname);
+        Py_XDECREF(cname);
+        return -1;
+      }
+      Py_DECREF(fname);
+      Py_DECREF(cname);
+    }
+    self->index[self->numindex++] = entry;
+    pos += flen;
+  }
+
+  Py_BEGIN_ALLOW_THREADS ret = lazydirstate_sortindex(self);
+  Py_END_ALLOW_THREADS if (ret == -1) {
+    PyErr_NoMemory();
+    return -1;
+  }
+  return 0;
+}
+
+static void lazydirstate_dealloc(lazydirstate* self) {
+  free(self->entries);
+  free(self->index);
+  if (self->data.obj)
+    PyBuffer_Release(&self->data);
+  Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+/* Look up the entry of key, returning NULL if there is none or the key is
+ * not a string, as our keys always are. */
+static dirstateentry* lazydirstate_find(lazydirstate* self, PyObject* key) {
+  dirstateentry **lo, **hi, **mid;
+  const char* name;
+  Py_ssize_t namelen;
+  int cmp;
+#ifdef IS_PY3K
+  if (!PyUnicode_Check(key))
+    return NULL;
+  name = PyUnicode_AsUTF8AndSize(key, &namelen);
+#else
+  if (!PyBytes_Check(key))
+    return NULL;
+  name = PyBytes_AS_STRING(key);
+  namelen = PyBytes_GET_SIZE(key);
+#endif
+  if (!name) {
+    PyErr_Clear();
+    return NULL;
+  }
+  if (namelen > UINT32_MAX)
+    return NULL;
+  lo = self->index;
+  hi = self->index + self->numindex;
+  while (lo < hi) {
+    mid = lo + (hi - lo) / 2;
+    cmp = namecmp(
+        name, (uint32_t)namelen, (*mid)->start + 17, (*mid)->namelen);
+    if (cmp == 0)
+      return *mid;
+    if (cmp < 0)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  return NULL;
+}
+
+static PyObject* lazydirstate_entrytuple(const dirstateentry* entry) {
+  const char* cur = entry->start;
+  return (PyObject*)make_dirstate_tuple(
+      *cur, getbe32(cur + 1), getbe32(cur + 5), getbe32(cur + 9));
+}
+
+static Py_ssize_t lazydirstate_size(lazydirstate* self) {
+  return self->numindex;
+}
+
+static PyObject* lazydirstate_getitem(lazydirstate* self, PyObject* key) {
+  dirstateentry* entry = lazydirstate_find(self, key);
+  if (!entry) {
+    PyErr_SetObject(PyExc_KeyError, key);
+    return NULL;
+  }
+  return lazydirstate_entrytuple(entry);
+}
+
+static int lazydirstate_contains(lazydirstate* self, PyObject* key) {
+  return lazydirstate_find(self, key) != NULL;
+}
+
+static PyObject* lazydirstate_get(lazydirstate* self, PyObject* args) {
+  PyObject *key, *def = Py_None;
+  dirstateentry* entry;
+  if (!PyArg_ParseTuple(args, "O|O:get", &key, &def))
+    return NULL;
+  entry = lazydirstate_find(self, key);
+  if (!entry) {
+    Py_INCREF(def);
+    return def;
+  }
+  return lazydirstate_entrytuple(entry);
+}
+
+static PyObject* lazydirstate_parents(lazydirstate* self) {
+  const char* str = self->data.buf;
+#ifdef IS_PY3K
+  return Py_BuildValue("y#y#", str, (Py_ssize_t)20, str + 20, (Py_ssize_t)20);
+#else
+  return Py_BuildValue("s#s#", str, (Py_ssize_t)20, str + 20, (Py_ssize_t)20);
+#endif
+}
+
+/* Fill dmap with all the entries, in the order of the data like
+ * parse_dirstate. */
+static PyObject* lazydirstate_todict(lazydirstate* self, PyObject* args) {
+  PyObject *dmap, *fname, *entry;
+  const dirstateentry* cur;
+  Py_ssize_t i;
+  int err;
+  if (!PyArg_ParseTuple(args, "O!:todict", &PyDict_Type, &dmap))
+    return NULL;
+  for (i = 0; i < self->numentries; i++) {
+    cur = &self->entries[i];
+#ifdef IS_PY3K
+    fname = PyUnicode_FromStringAndSize(cur->start + 17, cur->namelen);
+#else
+    fname = PyBytes_FromStringAndSize(cur->start + 17, cur->namelen);
+#endif
+    entry = lazydirstate_entrytuple(cur);
+    err = !fname || !entry || PyDict_SetItem(dmap, fname, entry) == -1;
+    Py_XDECREF(fname);
+    Py_XDECREF(entry);
+    if (err)
+      return NULL;
+  }
+  Py_INCREF(Py_None);
+  return Py_None;
+}
+
+static PyMappingMethods lazydirstate_mapping_methods = {
+    (lenfunc)lazydirstate_size, /* mp_length */
+    (binaryfunc)lazydirstate_getitem, /* mp_subscript */
+    0, /* mp_ass_subscript */
+};
+
+static PySequenceMethods lazydirstate_seq_meths = {
+    (lenfunc)lazydirstate_size, /* sq_length */
+    0, /* sq_concat */
+    0, /* sq_repeat */
+    0, /* sq_item */
+    0, /* sq_slice */
+    0, /* sq_ass_item */
+    0, /* sq_ass_slice */
+    (objobjproc)lazydirstate_contains, /* sq_contains */
+    0, /* sq_inplace_concat */
+    0, /* sq_inplace_repeat */
+};
+
+static PyMethodDef lazydirstate_methods[] = {
+    {"get",
+     (PyCFunction)lazydirstate_get,
+     METH_VARARGS,
+     "Return the dirstate tuple of a file, or the default."},
+    {"parents",
+     (PyCFunction)lazydirstate_parents,
+     METH_NOARGS,
+     "Return the parents recorded in the dirstate."},
+    {"todict",
+     (PyCFunction)lazydirstate_todict,
+     METH_VARARGS,
+     "Add all the entries to a dict, like parse_dirstate."},
+    {NULL},
+};
+
+#ifdef IS_PY3K
+#define LAZYDIRSTATE_TPFLAGS Py_TPFLAGS_DEFAULT
+#else
+#define LAZYDIRSTATE_TPFLAGS Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_SEQUENCE_IN
+#endif
+
+static PyTypeObject lazydirstateType = {
+    PyVarObject_HEAD_INIT(NULL, 0) /* header */
+    "parsers.lazydirstate", /* tp_name */
+    sizeof(lazydirstate), /* tp_basicsize */
+    0, /* tp_itemsize */
+    (destructor)lazydirstate_dealloc, /* tp_dealloc */
+    0, /* tp_print */
+    0, /* tp_getattr */
+    0, /* tp_setattr */
+    0, /* tp_compare */
+    0, /* tp_repr */
+    0, /* tp_as_number */
+    &lazydirstate_seq_meths, /* tp_as_sequence */
+    &lazydirstate_mapping_methods, /* tp_as_mapping */
+    0, /* tp_hash */
+    0, /* tp_call */
+    0, /* tp_str */
+    0, /* tp_getattro */
+    0, /* tp_setattro */
+    0, /* tp_as_buffer */
+    LAZYDIRSTATE_TPFLAGS, /* tp_flags */
+    "lazydirstate(data, copymap)\n\n"
+    "Read-only view of the dirstate data, filling in copymap.", /* tp_doc */
+    0, /* tp_traverse */
+    0, /* tp_clear */
+    0, /* tp_richcompare */
+    0, /* tp_weaklistoffset */
+    0, /* tp_iter */
+    0, /* tp_iternext */
+    lazydirstate_methods, /* tp_methods */
+    0, /* tp_members */
+    0, /* tp_getset */
+    0, /* tp_base */
+    0, /* tp_dict */
+    0, /* tp_descr_get */
+    0, /* tp_descr_set */
+    0, /* tp_dictoffset */
+    (initproc)lazydirstate_init, /* tp_init */
+    0, /* tp_alloc */
+};
+
 /*
  * Build a set of non-normal and other parent entries from the dirstate dmap
  */
@@ -839,6 +1226,12 @@ static void module_init(PyObject* mod) {
     return;
   Py_INCREF(&dirstateTupleType);
   PyModule_AddObject(mod, "dirstatetuple", (PyObject*)&dirstateTupleType);
+
+  lazydirstateType.tp_new = PyType_GenericNew;
+  if (PyType_Ready(&lazydirstateType) < 0)
+    return;
+  Py_INCREF(&lazydirstateType);
+  PyModule_AddObject(mod, "lazydirstate", (PyObject*)&lazydirstateType);
 }
 
 static int check_python_version(void) {
@@ -3,7 +3,7 @@
 # This software may be used and distributed according to the terms of the
 # GNU General Public License version 2.
 
-from typing import Callable, Dict, Iterable, Set, Tuple, Union
+from typing import Callable, Dict, Iterable, Optional, Set, Tuple, Union
 
 # dirstatetuple is really a custom type separate from Tuple, but it behaves
 # basically like a Tuple, and we can't really get the same type checking behavior
@@ -32,6 +32,17 @@ def nonnormalotherparententries(
     dmap: Dict[str, dirstatetuple]
 ) -> Tuple[Set[str], Set[str]]: ...
 
+class lazydirstate:
+    def __init__(self, data: bytes, copymap: Dict[str, str]) -> None: ...
+    def __len__(self) -> int: ...
+    def __getitem__(self, key: str) -> dirstatetuple: ...
+    def __contains__(self, key: str) -> bool: ...
+    def get(
+        self, key: str, default: Optional[dirstatetuple] = None
+    ) -> Optional[dirstatetuple]: ...
+    def parents(self) -> Tuple[bytes, bytes]: ...
+    def todict(self, dmap: Dict[str, dirstatetuple]) -> None: ...
+
 class lazymanifest:
     def __init__(self, data: bytes) -> None: ...
     def __len__(self) -> int: ...
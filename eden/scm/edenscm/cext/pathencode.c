@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "eden/scm/edenscm/cext/charencode.h"
 #include "eden/scm/edenscm/cext/util.h"
 
 /* state machine for the fast path */
@@ -78,7 +79,7 @@ static inline void memcopy(
     const void* src,
     Py_ssize_t len) {
   if (dest) {
-    assert(*destlen + len < destsize);
+    assert(*destlen + len <= destsize);
     memcpy((void*)&dest[*destlen], src, len);
   }
   *destlen += len;
@@ -102,7 +103,8 @@ escape3(char* dest, Py_ssize_t* destlen, size_t destsize, char c) {
 static Py_ssize_t
 _encodedir(char* dest, size_t destsize, const char* src, Py_ssize_t len) {
   enum dir_state state = DDEFAULT;
-  Py_ssize_t i = 0, destlen = 0;
+  Py_ssize_t i = 0, span, destlen = 0;
+  const char* dot;
 
   while (i < len) {
     switch (state) {
@@ -137,9 +139,13 @@ _encodedir(char* dest, size_t destsize, const char* src, Py_ssize_t len) {
         state = DDEFAULT;
         break;
       case DDEFAULT:
-        if (src[i] == '.')
+        /* only a '.' can start something to encode */
+        dot = memchr(src + i, '.', len - i);
+        span = dot ? dot - (src + i) + 1 : len - i;
+        memcopy(dest, &destlen, destsize, src + i, span);
+        i += span;
+        if (dot)
           state = DDOT;
-        charcopy(dest, &destlen, destsize, src[i++]);
         break;
     }
   }
@@ -507,15 +513,29 @@ _lowerencode(char* dest, size_t destsize, const char* src, Py_ssize_t len) {
 
   static const uint32_t lower[8] = {0, 0, 0x7fffffe};
 
-  Py_ssize_t i, destlen = 0;
-
-  for (i = 0; i < len; i++) {
-    if (inset(onebyte, src[i]))
-      charcopy(dest, &destlen, destsize, src[i]);
-    else if (inset(lower, src[i]))
-      charcopy(dest, &destlen, destsize, src[i] + 32);
-    else
-      escape3(dest, &destlen, destsize, src[i]);
+  /* everything but a-z, A-Z, 0-9, '-', '.', '/' and '_' */
+  static const asciirange special[] = {
+      {0x00, 0x2c}, {0x3a, 0x40}, {0x5b, 0x5e}, {0x60, 0x60}, {0x7b, 0xff}};
+  static const asciirange upper = {'A', 'Z'};
+
+  asciiblockset set;
+  Py_ssize_t i, end, destlen = 0;
+
+  asciiblockinit(&set, special, 5, &upper);
+  for (i = 0; i < len;) {
+    Py_ssize_t span =
+        asciiblockcopy(dest ? dest + destlen : NULL, src + i, len - i, &set);
+    assert(dest == NULL || destlen + span <= destsize);
+    destlen += span;
+    i += span;
+    for (end = MIN(i + ASCIIBLOCK, len); i < end; i++) {
+      if (inset(onebyte, src[i]))
+        charcopy(dest, &destlen, destsize, src[i]);
+      else if (inset(lower, src[i]))
+        charcopy(dest, &destlen, destsize, src[i] + 32);
+      else
+        escape3(dest, &destlen, destsize, src[i]);
+    }
   }
 
   return destlen;
@@ -72,6 +72,7 @@ typedef struct {
   PyObject* added; /* populated on demand */
   PyObject* headrevs; /* cache, invalidated on changes */
   nodetree* nt; /* base-16 trie */
+  Py_buffer ntbuf; /* persisted trie nt points into, until modified */
   size_t ntlength; /* # nodes in use */
   size_t ntcapacity; /* # nodes allocated */
   int ntdepth; /* maximum depth of tree */
@@ -79,6 +80,9 @@ typedef struct {
   int ntrev; /* last rev scanned */
   int ntlookups; /* # lookups */
   int ntmisses; /* # lookups that miss the cache */
+  char* scratch; /* zeroed memory reused by ancestry walks */
+  size_t scratchsize; /* # bytes of scratch */
+  int scratchbusy; /* whether a walk is using scratch */
   int inlined;
 } indexObject;
 
@@ -332,9 +336,19 @@ static void _index_clearcaches(indexObject* self) {
     self->offsets = NULL;
   }
   if (self->nt) {
-    free(self->nt);
+    if (self->ntbuf.buf) {
+      PyBuffer_Release(&self->ntbuf);
+      memset(&self->ntbuf, 0, sizeof(self->ntbuf));
+    } else {
+      free(self->nt);
+    }
     self->nt = NULL;
   }
+  if (self->scratch && !self->scratchbusy) {
+    free(self->scratch);
+    self->scratch = NULL;
+    self->scratchsize = 0;
+  }
   Py_CLEAR(self->headrevs);
 }
 
@@ -457,6 +471,40 @@ set_phase_from_parents(char* phases, int parent_1, int parent_2, Py_ssize_t i) {
     phases[i] = phases[parent_2];
 }
 
+/*
+ * Return size bytes of zeroed memory for an ancestry walk, reusing that of
+ * the previous walks of the index: on graphs of millions of revs, allocating
+ * and zeroing arrays of every rev dominates the walks that stop early.
+ *
+ * The walk must zero whatever it modified before handing the memory back
+ * with index_release_scratch.
+ */
+static char* index_get_scratch(indexObject* self, size_t size) {
+  /* A walk may run Python code, which could start another one. */
+  if (self->scratchbusy)
+    return calloc(size, 1);
+  if (size > self->scratchsize) {
+    /* Leave room for the revs the index will grow by. */
+    size_t newsize = size + size / 8;
+    free(self->scratch);
+    self->scratch = calloc(newsize, 1);
+    self->scratchsize = self->scratch ? newsize : 0;
+    if (self->scratch == NULL)
+      return NULL;
+  }
+  self->scratchbusy = 1;
+  return self->scratch;
+}
+
+static void index_release_scratch(indexObject* self, char* scratch) {
+  if (scratch == NULL)
+    return;
+  if (scratch == self->scratch)
+    self->scratchbusy = 0;
+  else
+    free(scratch);
+}
+
 static PyObject* reachableroots2(indexObject* self, PyObject* args) {
   /* Input */
   long minroot;
@@ -476,13 +524,18 @@ static PyObject* reachableroots2(indexObject* self, PyObject* args) {
   int r;
   int parents[2];
 
-  /* Internal data structure:
+  /* Internal data structure, in the scratch memory of the index:
    * tovisit: array of length len+1 (all revs + nullrev), filled upto lentovisit
-   * revstates: array of length len+1 (all revs + nullrev) */
+   * revstates: array of length len+1 (all revs + nullrev), of which
+   *            [lostate, histate) was modified */
+  char* scratch = NULL;
+  size_t statesize;
   int* tovisit = NULL;
   long lentovisit = 0;
+  long minvisited = LONG_MAX, maxvisited = -1;
   enum { RS_SEEN = 1, RS_ROOT = 2, RS_REACHABLE = 4 };
   char* revstates = NULL;
+  Py_ssize_t lostate = len + 1, histate = 0;
 
   /* Get arguments */
   if (!PyArg_ParseTuple(
@@ -506,17 +559,14 @@ static PyObject* reachableroots2(indexObject* self, PyObject* args) {
     goto bail;
 
   /* Initialize internal datastructures */
-  tovisit = (int*)malloc((len + 1) * sizeof(int));
-  if (tovisit == NULL) {
-    PyErr_NoMemory();
-    goto bail;
-  }
-
-  revstates = (char*)calloc(len + 1, 1);
-  if (revstates == NULL) {
+  statesize = (len + sizeof(int)) / sizeof(int) * sizeof(int);
+  scratch = index_get_scratch(self, statesize + (len + 1) * sizeof(int));
+  if (scratch == NULL) {
     PyErr_NoMemory();
     goto bail;
   }
+  revstates = scratch;
+  tovisit = (int*)(scratch + statesize);
 
   l = PyList_GET_SIZE(roots);
   for (i = 0; i < l; i++) {
@@ -528,6 +578,10 @@ static PyObject* reachableroots2(indexObject* self, PyObject* args) {
     if (revnum + 1 < 0 || revnum + 1 >= len + 1)
       continue;
     revstates[revnum + 1] |= RS_ROOT;
+    if (revnum + 1 < lostate)
+      lostate = revnum + 1;
+    if (revnum + 2 > histate)
+      histate = revnum + 2;
   }
 
   /* Populate tovisit with all the heads */
@@ -543,6 +597,10 @@ static PyObject* reachableroots2(indexObject* self, PyObject* args) {
     if (!(revstates[revnum + 1] & RS_SEEN)) {
       tovisit[lentovisit++] = (int)revnum;
       revstates[revnum + 1] |= RS_SEEN;
+      if (revnum < minvisited)
+        minvisited = revnum;
+      if (revnum > maxvisited)
+        maxvisited = revnum;
     }
   }
 
@@ -574,17 +632,22 @@ static PyObject* reachableroots2(indexObject* self, PyObject* args) {
       if (!(revstates[parents[i] + 1] & RS_SEEN) && parents[i] >= minroot) {
         tovisit[lentovisit++] = parents[i];
         revstates[parents[i] + 1] |= RS_SEEN;
+        if (parents[i] < minvisited)
+          minvisited = parents[i];
       }
     }
   }
 
   /* Find all the nodes in between the roots we found and the heads
-   * and add them to the reachable set */
+   * and add them to the reachable set. Only the revs visited above can
+   * be, so there is no need to look at the others. */
   if (includepath == 1) {
     long minidx = minroot;
+    if (minidx < minvisited)
+      minidx = minvisited;
     if (minidx < 0)
       minidx = 0;
-    for (i = minidx; i < len; i++) {
+    for (i = minidx; i <= maxvisited; i++) {
       if (!(revstates[i + 1] & RS_SEEN))
         continue;
       r = index_get_parents(self, i, parents, (int)len - 1);
@@ -607,14 +670,22 @@ static PyObject* reachableroots2(indexObject* self, PyObject* args) {
     }
   }
 
-  free(revstates);
-  free(tovisit);
-  return reachable;
+  goto done;
 bail:
-  Py_XDECREF(reachable);
-  free(revstates);
-  free(tovisit);
-  return NULL;
+  Py_CLEAR(reachable);
+done:
+  if (scratch) {
+    /* Every state set is that of a root or of a visited rev. */
+    if (lentovisit > 0 && minvisited + 1 < lostate)
+      lostate = minvisited + 1;
+    if (lentovisit > 0 && maxvisited + 2 > histate)
+      histate = maxvisited + 2;
+    if (lostate < histate)
+      memset(revstates + lostate, 0, histate - lostate);
+    memset(tovisit, 0, lentovisit * sizeof(int));
+  }
+  index_release_scratch(self, scratch);
+  return reachable;
 }
 
 static PyObject* compute_phases_map_sets(indexObject* self, PyObject* args) {
@@ -969,10 +1040,32 @@ static int nt_new(indexObject* self) {
   return self->ntlength++;
 }
 
+/*
+ * Copy a trie loaded by loadnodemap out of the buffer it was persisted in,
+ * which may be a read-only mapping, before it is first modified.
+ */
+static int nt_own(indexObject* self) {
+  size_t capacity = self->ntlength < 2 ? 4 : self->ntlength * 2;
+  nodetree* nt = calloc(capacity, sizeof(nodetree));
+  if (nt == NULL) {
+    PyErr_NoMemory();
+    return -1;
+  }
+  memcpy(nt, self->nt, self->ntlength * sizeof(nodetree));
+  PyBuffer_Release(&self->ntbuf);
+  memset(&self->ntbuf, 0, sizeof(self->ntbuf));
+  self->nt = nt;
+  self->ntcapacity = capacity;
+  return 0;
+}
+
 static int nt_insert(indexObject* self, const char* node, int rev) {
   int level = 0;
   int off = 0;
 
+  if (self->ntbuf.buf && nt_own(self) == -1)
+    return -1;
+
   while (level < 40) {
     int k = nt_level(node, level);
     nodetree* n;
@@ -1144,15 +1237,22 @@ static PyObject* index_getitem(indexObject* self, PyObject* value) {
   return NULL;
 }
 
-static int
-nt_partialmatch(indexObject* self, const char* node, Py_ssize_t nodelen) {
+/*
+ * Ensure that the radix tree is fully populated.
+ *
+ * Return values:
+ *
+ *   -3: error (exception set)
+ *   -2: a rev could not be read (no exception set)
+ *    0: success
+ */
+static int nt_populate(indexObject* self) {
   int rev;
 
   if (nt_init(self) == -1)
     return -3;
 
   if (self->ntrev > 0) {
-    /* ensure that the radix tree is fully populated */
     for (rev = self->ntrev - 1; rev >= 0; rev--) {
       const char* n = index_node(self, rev);
       if (n == NULL)
@@ -1162,10 +1262,174 @@ nt_partialmatch(indexObject* self, const char* node, Py_ssize_t nodelen) {
     }
     self->ntrev = rev;
   }
+  return 0;
+}
 
+static int
+nt_partialmatch(indexObject* self, const char* node, Py_ssize_t nodelen) {
+  int ret = nt_populate(self);
+
+  if (ret < 0)
+    return ret;
   return nt_find(self, node, nodelen, 1);
 }
 
+/*
+ * A persisted trie is a header the size of a trie node, followed by the
+ * nodes as they are in memory, so that it can be used straight from a
+ * mapping of the file:
+ *
+ *   0: "hgntmap\0"
+ *   8: version (be32)
+ *  12: 1 (native int), telling an incompatible byte order apart
+ *  16: number of revs the trie holds (be32)
+ *  20: number of nodes (be32)
+ *  24: depth (be32)
+ *  28: node of the last rev the trie holds
+ */
+static const char nodemap_magic[8] = "hgntmap";
+static const uint32_t nodemap_version = 1;
+
+/*
+ * Return the number of revs the persisted trie in buf holds, or -1 if it is
+ * malformed or doesn't match the index.
+ */
+static Py_ssize_t nt_validate(indexObject* self, const Py_buffer* buf) {
+  const char* data = buf->buf;
+  const nodetree* nt;
+  Py_ssize_t revs;
+  size_t ntlength, i;
+  int byteorder, k;
+
+  if (buf->len < (Py_ssize_t)sizeof(nodetree) ||
+      memcmp(data, nodemap_magic, sizeof(nodemap_magic)) != 0 ||
+      getbe32(data + 8) != nodemap_version)
+    return -1;
+  memcpy(&byteorder, data + 12, sizeof(byteorder));
+  if (byteorder != 1)
+    return -1;
+  revs = getbe32(data + 16);
+  ntlength = getbe32(data + 20);
+  if (ntlength < 1 || revs > self->raw_length ||
+      (size_t)buf->len != (ntlength + 1) * sizeof(nodetree))
+    return -1;
+  /* Revs past the end of the index may have been stripped, or replaced. */
+  if (revs > 0) {
+    const char* node = index_node(self, revs - 1);
+    if (node == NULL || memcmp(node, data + 28, 20) != 0) {
+      PyErr_Clear();
+      return -1;
+    }
+  }
+  /* A corrupted trie must not make lookups read past its end. Leaves need
+   * no check, as they are compared with the node of their rev, which is how
+   * leaves left behind by deleted revs are told apart already. */
+  nt = (const nodetree*)(data + sizeof(nodetree));
+  for (i = 0; i < ntlength; i++) {
+    for (k = 0; k < 16; k++) {
+      int v = nt[i].children[k];
+      if (v > 0 && (size_t)v >= ntlength)
+        return -1;
+    }
+  }
+  return revs;
+}
+
+/*
+ * Use a trie persisted by nodemapdata, typically mapped from a file, rather
+ * than building one from the index. Revs appended to the index since it was
+ * persisted are inserted into it.
+ *
+ * Return the number of revs the persisted trie held, None if it couldn't be
+ * used.
+ */
+static PyObject* index_loadnodemap(indexObject* self, PyObject* args) {
+  PyObject* data_obj;
+  Py_buffer buf;
+  Py_ssize_t revs, rev;
+
+  if (!PyArg_ParseTuple(args, "O", &data_obj))
+    return NULL;
+  if (self->nt != NULL || self->added != NULL) {
+    PyErr_SetString(PyExc_ValueError, "node trie already in use");
+    return NULL;
+  }
+  if (PyObject_GetBuffer(data_obj, &buf, PyBUF_SIMPLE) == -1)
+    return NULL;
+  revs = nt_validate(self, &buf);
+  if (revs == -1) {
+    PyBuffer_Release(&buf);
+    Py_RETURN_NONE;
+  }
+
+  self->ntbuf = buf;
+  self->nt = (nodetree*)((char*)buf.buf + sizeof(nodetree));
+  self->ntlength = self->ntcapacity = getbe32((const char*)buf.buf + 20);
+  self->ntdepth = (int)getbe32((const char*)buf.buf + 24);
+  self->ntsplits = 0;
+  self->ntlookups = 1;
+  self->ntmisses = 0;
+  for (rev = revs; rev < self->raw_length; rev++) {
+    const char* n = index_node(self, rev);
+    if (n == NULL || nt_insert(self, n, (int)rev) == -1) {
+      /* Leave the index as if nothing had been loaded. */
+      _index_clearcaches(self);
+      self->ntlength = self->ntcapacity = 0;
+      self->ntdepth = 0;
+      return NULL;
+    }
+  }
+  self->ntrev = -1;
+  return PyInt_FromSsize_t(revs);
+}
+
+/*
+ * Return the trie, populated with every rev of the index, in the format
+ * loadnodemap takes.
+ */
+static PyObject* index_nodemapdata(indexObject* self) {
+  Py_ssize_t revs = index_length(self) - 1;
+  PyObject* data;
+  char* header;
+  int byteorder = 1;
+
+  switch (nt_populate(self)) {
+    case -3:
+      return NULL;
+    case -2:
+      PyErr_SetString(PyExc_IndexError, "could not access all revs");
+      return NULL;
+  }
+  if (self->ntlength > UINT32_MAX || revs > UINT32_MAX) {
+    PyErr_SetString(PyExc_OverflowError, "node trie too large to persist");
+    return NULL;
+  }
+
+  data = PyBytes_FromStringAndSize(
+      NULL, (self->ntlength + 1) * sizeof(nodetree));
+  if (data == NULL)
+    return NULL;
+  header = PyBytes_AS_STRING(data);
+  memset(header, 0, sizeof(nodetree));
+  memcpy(header, nodemap_magic, sizeof(nodemap_magic));
+  putbe32(nodemap_version, header + 8);
+  memcpy(header + 12, &byteorder, sizeof(byteorder));
+  putbe32((uint32_t)revs, header + 16);
+  putbe32((uint32_t)self->ntlength, header + 20);
+  putbe32((uint32_t)self->ntdepth, header + 24);
+  if (revs > 0) {
+    const char* node = index_node(self, revs - 1);
+    if (node == NULL) {
+      Py_DECREF(data);
+      return NULL;
+    }
+    memcpy(header + 28, node, 20);
+  }
+  memcpy(
+      header + sizeof(nodetree), self->nt, self->ntlength * sizeof(nodetree));
+  return data;
+}
+
 static PyObject* index_partialmatch(indexObject* self, PyObject* args) {
   const char* fullnode;
   Py_ssize_t nodelen;
@@ -1267,7 +1531,7 @@ find_gca_candidates(indexObject* self, const int* revs, int revcount) {
   const bitmask poison = 1ull << revcount;
   PyObject* gca = PyList_New(0);
   int i, v, interesting;
-  int maxrev = -1;
+  int maxrev = -1, minseen;
   bitmask sp;
   bitmask* seen;
 
@@ -1279,14 +1543,18 @@ find_gca_candidates(indexObject* self, const int* revs, int revcount) {
       maxrev = revs[i];
   }
 
-  seen = calloc(sizeof(*seen), maxrev + 1);
+  seen = (bitmask*)index_get_scratch(self, sizeof(*seen) * (maxrev + 1));
   if (seen == NULL) {
     Py_DECREF(gca);
     return PyErr_NoMemory();
   }
 
-  for (i = 0; i < revcount; i++)
+  minseen = maxrev;
+  for (i = 0; i < revcount; i++) {
     seen[revs[i]] = 1ull << i;
+    if (revs[i] < minseen)
+      minseen = revs[i];
+  }
 
   interesting = revcount;
 
@@ -1321,6 +1589,8 @@ find_gca_candidates(indexObject* self, const int* revs, int revcount) {
       int p = parents[i];
       if (p == -1)
         continue;
+      if (p < minseen)
+        minseen = p;
       sp = seen[p];
       if (sv < poison) {
         if (sp == 0) {
@@ -1336,13 +1606,13 @@ find_gca_candidates(indexObject* self, const int* revs, int revcount) {
     }
   }
 
+  goto done;
+bail:
+  Py_CLEAR(gca);
 done:
-  free(seen);
+  memset(seen + minseen, 0, sizeof(*seen) * (maxrev + 1 - minseen));
+  index_release_scratch(self, (char*)seen);
   return gca;
-bail:
-  free(seen);
-  Py_XDECREF(gca);
-  return NULL;
 }
 
 /*
@@ -1352,11 +1622,12 @@ bail:
 static PyObject* find_deepest(indexObject* self, PyObject* revs) {
   const Py_ssize_t revcount = PyList_GET_SIZE(revs);
   static const Py_ssize_t capacity = 24;
+  char* scratch;
   int *depth, *interesting = NULL;
   int i, j, v, ninteresting;
   PyObject *dict = NULL, *keys = NULL;
   long* seen = NULL;
-  int maxrev = -1;
+  int maxrev = -1, mindepth;
   long final;
 
   if (revcount > capacity) {
@@ -1374,15 +1645,13 @@ static PyObject* find_deepest(indexObject* self, PyObject* revs) {
       maxrev = n;
   }
 
-  depth = calloc(sizeof(*depth), maxrev + 1);
-  if (depth == NULL)
+  scratch =
+      index_get_scratch(self, (sizeof(*seen) + sizeof(*depth)) * (maxrev + 1));
+  if (scratch == NULL)
     return PyErr_NoMemory();
-
-  seen = calloc(sizeof(*seen), maxrev + 1);
-  if (seen == NULL) {
-    PyErr_NoMemory();
-    goto bail;
-  }
+  seen = (long*)scratch;
+  depth = (int*)(seen + maxrev + 1);
+  mindepth = maxrev;
 
   interesting = calloc(sizeof(*interesting), 1 << revcount);
   if (interesting == NULL) {
@@ -1396,6 +1665,8 @@ static PyObject* find_deepest(indexObject* self, PyObject* revs) {
   for (i = 0; i < revcount; i++) {
     int n = (int)PyInt_AsLong(PyList_GET_ITEM(revs, i));
     long b = 1l << i;
+    if (n < mindepth)
+      mindepth = n;
     depth[n] = 1;
     seen[n] = b;
     interesting[b] = 1;
@@ -1424,6 +1695,8 @@ static PyObject* find_deepest(indexObject* self, PyObject* revs) {
 
       if (p == -1)
         continue;
+      if (p < mindepth)
+        mindepth = p;
 
       dp = depth[p];
       sp = seen[p];
@@ -1492,8 +1765,9 @@ static PyObject* find_deepest(indexObject* self, PyObject* revs) {
   keys = PyDict_Keys(dict);
 
 bail:
-  free(depth);
-  free(seen);
+  memset(seen + mindepth, 0, sizeof(*seen) * (maxrev + 1 - mindepth));
+  memset(depth + mindepth, 0, sizeof(*depth) * (maxrev + 1 - mindepth));
+  index_release_scratch(self, scratch);
   free(interesting);
   Py_XDECREF(dict);
 
@@ -1518,7 +1792,8 @@ static PyObject* index_commonancestorsheads(indexObject* self, PyObject* args) {
   len = index_length(self) - 1;
 
   for (i = 0; i < argcount; i++) {
-    static const int capacity = 24;
+    /* The walk needs a bit per rev, plus the poison bit. */
+    static const int capacity = 63;
     PyObject* obj = PySequence_GetItem(args, i);
     bitmask x;
     long val;
@@ -1791,6 +2066,10 @@ static int index_init(indexObject* self, PyObject* args) {
   self->headrevs = NULL;
   Py_INCREF(Py_None);
   self->nt = NULL;
+  memset(&self->ntbuf, 0, sizeof(self->ntbuf));
+  self->scratch = NULL;
+  self->scratchsize = 0;
+  self->scratchbusy = 0;
   self->offsets = NULL;
 
   if (!PyArg_ParseTuple(args, "OO", &data_obj, &inlined_obj))
@@ -1900,6 +2179,14 @@ static PyMethodDef index_methods[] = {
      (PyCFunction)index_insert,
      METH_VARARGS,
      "insert an index entry"},
+    {"loadnodemap",
+     (PyCFunction)index_loadnodemap,
+     METH_VARARGS,
+     "use a node trie persisted by nodemapdata"},
+    {"nodemapdata",
+     (PyCFunction)index_nodemapdata,
+     METH_NOARGS,
+     "persist the node trie"},
     {"partialmatch",
      (PyCFunction)index_partialmatch,
      METH_VARARGS,
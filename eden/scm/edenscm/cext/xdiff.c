@@ -28,11 +28,14 @@ hunk_consumer(int64_t a1, int64_t a2, int64_t b1, int64_t b2, void* priv) {
   return r;
 }
 
-static PyObject* blocks(PyObject* self, PyObject* args) {
+static PyObject* blocks(PyObject* self, PyObject* args, PyObject* kwargs) {
+  static char* keywords[] = {"a", "b", "histogram", NULL};
   char *sa = NULL, *sb = NULL;
   Py_ssize_t na = 0, nb = 0;
+  int histogram = 0;
 
-  if (!PyArg_ParseTuple(args, "s#s#", &sa, &na, &sb, &nb))
+  if (!PyArg_ParseTupleAndKeywords(
+          args, kwargs, "s#s#|i", keywords, &sa, &na, &sb, &nb, &histogram))
     return NULL;
 
   mmfile_t a = {sa, na}, b = {sb, nb};
@@ -42,7 +45,7 @@ static PyObject* blocks(PyObject* self, PyObject* args) {
     return PyErr_NoMemory();
 
   xpparam_t xpp = {
-      XDF_INDENT_HEURISTIC, /* flags */
+      XDF_INDENT_HEURISTIC | (histogram ? XDF_HISTOGRAM_DIFF : 0), /* flags */
   };
   xdemitconf_t xecfg = {
       XDL_EMIT_BDIFFHUNK, /* flags */
@@ -64,14 +67,15 @@ static char xdiff_doc[] = "xdiff wrapper";
 
 static PyMethodDef methods[] = {
     {"blocks",
-     blocks,
-     METH_VARARGS,
-     "(a: str, b: str) -> List[(a1, a2, b1, b2)].\n"
-     "Yield matched blocks. (a1, a2, b1, b2) are line numbers.\n"},
+     (PyCFunction)blocks,
+     METH_VARARGS | METH_KEYWORDS,
+     "(a: str, b: str, histogram: bool = False) -> List[(a1, a2, b1, b2)].\n"
+     "Yield matched blocks. (a1, a2, b1, b2) are line numbers.\n"
+     "histogram uses the histogram diff algorithm rather than Myers.\n"},
     {NULL, NULL},
 };
 
-static const int version = 1;
+static const int version = 2;
 
 #ifdef IS_PY3K
 static struct PyModuleDef xdiff_module = {
@@ -5,4 +5,6 @@
 
 from typing import List, Tuple
 
-def blocks(a: str, b: str) -> List[Tuple[int, int, int, int]]: ...
+def blocks(
+    a: str, b: str, histogram: bool = False
+) -> List[Tuple[int, int, int, int]]: ...
@@ -317,6 +317,7 @@ class chgunixservicehandler(object):
     def __init__(self, ui):
         self.ui = ui
         self._idletimeout = ui.configint("chgserver", "idletimeout")
+        self.preforkworkers = ui.configint("chgserver", "preforkworkers")
         self._lastactive = time.time()
 
     def bindsocket(self, sock, address):
@@ -435,6 +435,10 @@ class unixservicehandler(object):
 
     pollinterval = None
 
+    # number of idle workers to fork in advance, so that new connections
+    # do not have to wait for the main process to fork one
+    preforkworkers = 0
+
     def __init__(self, ui):
         self.ui = ui
 
@@ -463,6 +467,13 @@ class unixservicehandler(object):
 class unixforkingservice(object):
     """
     Listens on unix domain socket and forks server per connection
+
+    If the handler asks for preforked workers, that many workers are forked
+    before any connection and wait for one in accept() on the shared socket.
+    A worker taking a connection writes its pid to a pipe, so the main
+    process forks another one in its place. The main process only accepts
+    connections itself when there is no idle worker left. Closing the other
+    pipe tells the idle workers to exit.
     """
 
     def __init__(self, ui, repo, opts, handler=None):
@@ -477,6 +488,9 @@ class unixforkingservice(object):
         self._sock = None
         self._oldsigchldhandler = None
         self._workerpids = set()  # updated by signal handler; do not iterate
+        self._idlepids = set()  # preforked workers that have not accepted yet
+        self._acceptedpipe = None  # (r, w), worker -> main process
+        self._stoppipe = None  # (r, w), main process -> idle workers
         self._socketunlinked = None
 
     def init(self):
@@ -492,6 +506,12 @@ class unixforkingservice(object):
             flags |= fcntl.FD_CLOEXEC
             fcntl.fcntl(self._sock.fileno(), fcntl.F_SETFD, flags)
         self._servicehandler.bindsocket(self._sock, self.address)
+        if self._servicehandler.preforkworkers > 0:
+            # several processes accept() on this socket, the losers must not
+            # block there
+            self._sock.setblocking(False)
+            self._acceptedpipe = os.pipe()
+            self._stoppipe = os.pipe()
         if util.safehasattr(util, "unblocksignal"):
             util.unblocksignal(signal.SIGCHLD)
         o = util.signal(signal.SIGCHLD, self._sigchldhandler)
@@ -503,12 +523,27 @@ class unixforkingservice(object):
             self._servicehandler.unlinksocket(self.address)
             self._socketunlinked = True
 
+    def _closepipes(self):
+        # the write end of _stoppipe must only be open in the main process,
+        # otherwise idle workers would never see it closed
+        for fds in (self._acceptedpipe, self._stoppipe):
+            for fd in fds or ():
+                if fd is not None:
+                    os.close(fd)
+
+    def _stopidleworkers(self):
+        if self._stoppipe is not None and self._stoppipe[1] is not None:
+            os.close(self._stoppipe[1])
+            self._stoppipe = (self._stoppipe[0], None)
+
     def _cleanup(self):
         util.signal(signal.SIGCHLD, self._oldsigchldhandler)
         self._sock.close()
         self._unlinksocket()
+        self._stopidleworkers()
         # don't kill child processes as they have active clients, just wait
         self._reapworkers(0)
+        self._closepipes()
 
     def run(self):
         try:
@@ -520,7 +555,9 @@ class unixforkingservice(object):
         exiting = False
         h = self._servicehandler
         selector = selectors2.DefaultSelector()
-        selector.register(self._sock, selectors2.EVENT_READ)
+        listening = False
+        if self._acceptedpipe is not None:
+            selector.register(self._acceptedpipe[0], selectors2.EVENT_READ)
         while True:
             if not exiting and h.shouldexit():
                 # clients can no longer connect() to the domain socket, so
@@ -529,17 +566,32 @@ class unixforkingservice(object):
                 # accept()-ed), handle them before exit. otherwise, clients
                 # waiting for recv() will receive ECONNRESET.
                 self._unlinksocket()
+                self._stopidleworkers()
+                self._idlepids.clear()
                 exiting = True
+            if not exiting:
+                self._preforkworkers(selector)
+            # leave connections to idle workers if there are any
+            if listening != (not self._idlepids):
+                listening = not listening
+                if listening:
+                    selector.register(self._sock, selectors2.EVENT_READ)
+                else:
+                    selector.unregister(self._sock)
             ready = selector.select(timeout=h.pollinterval)
             if not ready:
                 # only exit if we completed all queued requests
                 if exiting:
                     break
                 continue
+            if any(key.fileobj is not self._sock for key, _events in ready):
+                self._readaccepted()
+                continue
             try:
                 conn, _addr = self._sock.accept()
             except socket.error as inst:
-                if inst.args[0] == errno.EINTR:
+                # EAGAIN: an idle worker accepted the connection first
+                if inst.args[0] in (errno.EINTR, errno.EAGAIN):
                     continue
                 raise
 
@@ -555,6 +607,7 @@ class unixforkingservice(object):
                 try:
                     selector.close()
                     self._sock.close()
+                    self._closepipes()
                     self._runworker(conn)
                     conn.close()
                     os._exit(0)
@@ -565,6 +618,77 @@ class unixforkingservice(object):
                         os._exit(255)
         selector.close()
 
+    def _preforkworkers(self, selector):
+        while len(self._idlepids) < self._servicehandler.preforkworkers:
+            # a worker reaped before its pid is added would stay idle forever
+            signal.pthread_sigmask(signal.SIG_BLOCK, [signal.SIGCHLD])
+            pid = os.fork()
+            if pid:
+                self.ui.debug("preforked worker process (pid=%d)\n" % pid)
+                self._workerpids.add(pid)
+                self._idlepids.add(pid)
+                signal.pthread_sigmask(signal.SIG_UNBLOCK, [signal.SIGCHLD])
+                continue
+            try:
+                signal.pthread_sigmask(signal.SIG_UNBLOCK, [signal.SIGCHLD])
+                selector.close()
+                os.close(self._acceptedpipe[0])
+                os.close(self._stoppipe[1])
+                self._initworker()
+                conn = self._waitforconnection()
+                if conn is not None:
+                    self._serveworker(conn)
+                    conn.close()
+                os._exit(0)
+            except:  # never return, hence no re-raises
+                try:
+                    self.ui.traceback(force=True)
+                finally:
+                    os._exit(255)
+
+    def _waitforconnection(self):
+        """Wait for a connection in a preforked worker
+
+        Return None if the main process asks idle workers to exit.
+        """
+        stopfd = self._stoppipe[0]
+        selector = selectors2.DefaultSelector()
+        selector.register(self._sock, selectors2.EVENT_READ)
+        selector.register(stopfd, selectors2.EVENT_READ)
+        try:
+            while True:
+                ready = selector.select()
+                if any(key.fileobj == stopfd for key, _events in ready):
+                    return None
+                try:
+                    conn, _addr = self._sock.accept()
+                except socket.error as inst:
+                    # another process accepted the connection first
+                    if inst.args[0] in (errno.EINTR, errno.EAGAIN):
+                        continue
+                    raise
+                # the pid fits in a single atomic write to the pipe
+                os.write(self._acceptedpipe[1], struct.pack(">i", os.getpid()))
+                return conn
+        finally:
+            selector.close()
+            os.close(stopfd)
+            os.close(self._acceptedpipe[1])
+            self._sock.close()
+
+    def _readaccepted(self):
+        """Forget the idle workers which accepted a connection"""
+        try:
+            data = os.read(self._acceptedpipe[0], 4096)
+        except OSError as inst:
+            if inst.errno == errno.EINTR:
+                return
+            raise
+        for i in range(0, len(data) - 3, 4):
+            pid = struct.unpack(">i", data[i : i + 4])[0]
+            self._idlepids.discard(pid)
+            self._servicehandler.newconnection()
+
     def _sigchldhandler(self, signal, frame):
         self._reapworkers(os.WNOHANG)
 
@@ -584,10 +708,17 @@ class unixforkingservice(object):
                 # no waitable child processes
                 return
             self._workerpids.discard(pid)
+            self._idlepids.discard(pid)
 
-    def _runworker(self, conn):
+    def _initworker(self):
         util.signal(signal.SIGCHLD, self._oldsigchldhandler)
         _initworkerprocess()
+
+    def _runworker(self, conn):
+        self._initworker()
+        self._serveworker(conn)
+
+    def _serveworker(self, conn):
         h = self._servicehandler
         try:
             _serverequest(self.ui, self.repo, conn, h.createcmdserver)
@@ -148,6 +148,7 @@ coreconfigitem("bundle2", "rechunkthreshold", default="1MB")
 coreconfigitem("bundle", "reorder", default="auto")
 coreconfigitem("censor", "policy", default="abort")
 coreconfigitem("chgserver", "idletimeout", default=3600)
+coreconfigitem("chgserver", "preforkworkers", default=0)
 coreconfigitem("chgserver", "skiphash", default=False)
 coreconfigitem("clone", "prefer-edenapi-clonedata", default=True)
 coreconfigitem("clone", "nativepull", default=False)
@@ -280,6 +281,7 @@ coreconfigitem("experimental", "evolution.track-operation", default=True)
 coreconfigitem("experimental", "worddiff", default=False)
 coreconfigitem("experimental", "mmapindexthreshold", default=1)
 coreconfigitem("experimental", "nonnormalparanoidcheck", default=False)
+coreconfigitem("experimental", "persistentnodemapthreshold", default=None)
 coreconfigitem("experimental", "exportableenviron", default=list)
 coreconfigitem("experimental", "extendedheader.index", default=None)
 coreconfigitem("experimental", "extendedheader.similarity", default=False)
@@ -316,6 +318,7 @@ coreconfigitem("experimental", "regexmatcher", default=True)
 coreconfigitem("experimental", "dynmatcher", default=False)
 coreconfigitem("experimental", "uncommitondirtywdir", default=True)
 coreconfigitem("experimental", "xdiff", default=True)
+coreconfigitem("experimental", "xdiff.histogram", default=False)
 coreconfigitem("extensions", ".*", default=None, generic=True)
 coreconfigitem("extdata", ".*", default=None, generic=True)
 coreconfigitem("format", "aggressivemergedeltas", default=False)
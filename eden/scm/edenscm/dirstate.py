@@ -1432,6 +1432,10 @@ class dirstatemap(object):
 
     - `copymap` maps destination filenames to their source filename.
 
+    Until something needs the whole state map, lookups are answered by a
+    `parsers.lazydirstate` index of the dirstate file, so that commands
+    looking at a few files do not build an entry for every tracked file.
+
     The dirstate also provides the following views onto the state:
 
     - `nonnormalset` is a set of the filenames that have state other
@@ -1459,16 +1463,57 @@ class dirstatemap(object):
         # for consistent view between _pl() and _read() invocations
         self._pendingmode: "Optional[bool]" = None
 
+    # Whether the dirstate file can be read into a parsers.lazydirstate.
+    _lazyread = True
+
     @util.propertycache
     def _map(self) -> "Dict[str, dirstatetuple]":
         self._map = {}
         self.read()
         return self._map
 
+    @util.propertycache
+    def _lazymap(self) -> "Optional[parsers.lazydirstate]":
+        """Index of the dirstate file answering lookups until `_map` is
+        built from it, or None if there is none.
+        """
+        self._lazymap = None
+        if not self._lazyread or not util.safehasattr(parsers, "lazydirstate"):
+            return None
+
+        # ignore HG_PENDING because identity is used only for writing
+        identity = util.filestat.frompath(self._opener.join(self._filename))
+        try:
+            fp = self._opendirstatefile()
+            try:
+                if pycompat.iswindows:
+                    # A mapped file could not be replaced by the next write.
+                    st = fp.read()
+                else:
+                    st = util.mmapread(fp)
+            finally:
+                fp.close()
+        except IOError as err:
+            if err.errno != errno.ENOENT:
+                raise
+            return None
+        if not st:
+            return None
+
+        if "copymap" not in self.__dict__:
+            self.copymap = {}
+        lazymap = parsers.lazydirstate(st, self.copymap)
+        self.identity = identity
+        if not self._dirtyparents:
+            self.setparents(*lazymap.parents())
+        self._lazymap = lazymap
+        return lazymap
+
     @util.propertycache
     def copymap(self) -> "Dict[str, str]":
         self.copymap = {}
-        self._map
+        if self._lazymap is None:
+            self._map
         return self.copymap
 
     def clear(self) -> None:
@@ -1489,6 +1534,9 @@ class dirstatemap(object):
         return pycompat.iteritems(self._map)
 
     def __len__(self) -> int:
+        lazymap = self._lazymap
+        if lazymap is not None:
+            return len(lazymap)
         return len(self._map)
 
     def __iter__(self) -> "Iterable[str]":
@@ -1497,12 +1545,21 @@ class dirstatemap(object):
     def get(
         self, key: str, default: "Optional[dirstatetuple]" = None
     ) -> "Optional[dirstatetuple]":
+        lazymap = self._lazymap
+        if lazymap is not None:
+            return lazymap.get(key, default)
         return self._map.get(key, default)
 
     def __contains__(self, key: str) -> bool:
+        lazymap = self._lazymap
+        if lazymap is not None:
+            return key in lazymap
         return key in self._map
 
     def __getitem__(self, key: str) -> "dirstatetuple":
+        lazymap = self._lazymap
+        if lazymap is not None:
+            return lazymap[key]
         return self._map[key]
 
     def keys(self) -> "Iterable[str]":
@@ -1683,6 +1740,16 @@ class dirstatemap(object):
         self._dirtyparents = True
 
     def read(self) -> None:
+        lazymap = self._lazymap
+        if lazymap is not None:
+            self._lazymap = None
+            if util.safehasattr(parsers, "dict_new_presized"):
+                self._map = parsers.dict_new_presized(len(lazymap))
+            # See below for why GC is disabled.
+            util.nogc(lazymap.todict)(self._map)
+            self._setfastpaths()
+            return
+
         # ignore HG_PENDING because identity is used only for writing
         self.identity = util.filestat.frompath(self._opener.join(self._filename))
 
@@ -1728,7 +1795,9 @@ class dirstatemap(object):
         p = parse_dirstate(self._map, self.copymap, st)
         if not self._dirtyparents:
             self.setparents(*p)
+        self._setfastpaths()
 
+    def _setfastpaths(self) -> None:
         # Avoid excess attribute lookups by fast pathing certain checks
         self.__contains__: "Callable[[str], bool]" = self._map.__contains__
         self.__getitem__: "Callable[[str], dirstatetuple]" = self._map.__getitem__
@@ -1754,7 +1823,8 @@ class dirstatemap(object):
 
     @util.propertycache
     def identity(self) -> "util.filestat":
-        self._map
+        if self._lazymap is None:
+            self._map
         return self.identity
 
     @util.propertycache
@@ -30,6 +30,9 @@ modefromflag = {
 
 
 class eden_dirstate_map(dirstate.dirstatemap):
+    # The file is in eden_dirstate_serializer's format.
+    _lazyread = False
+
     def __init__(
         self,
         ui: "ui_mod.ui",
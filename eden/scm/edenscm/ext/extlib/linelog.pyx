@@ -40,6 +40,11 @@ cdef extern from "lib/linelog/linelog.c":
         linelog_lineinfo *lines
         linelog_linenum linecount
         linelog_linenum maxlinecount
+    ctypedef struct linelog_hunk:
+        linelog_linenum a1
+        linelog_linenum a2
+        linelog_linenum b1
+        linelog_linenum b2
 
     cdef void linelog_annotateresult_clear(linelog_annotateresult *ar)
     cdef linelog_result linelog_clear(linelog_buf *buf)
@@ -57,6 +62,10 @@ cdef extern from "lib/linelog/linelog.c":
             linelog_linenum a1, linelog_linenum a2,
             linelog_linenum blinecount, const linelog_revnum *brevs,
             const linelog_linenum *blinenums)
+    cdef linelog_result linelog_replacelines_batch(linelog_buf *buf,
+            linelog_annotateresult *ar, linelog_revnum brev,
+            const linelog_hunk *hunks, size_t hunkcount,
+            const linelog_revnum *brevs, const linelog_linenum *blinenums)
     cdef linelog_result linelog_getalllines(linelog_buf *buf,
             linelog_annotateresult *ar, linelog_offset offset1,
             linelog_offset offset2)
@@ -129,6 +138,14 @@ cdef class _buffer: # thin wrapper around linelog_buf
                                                     a1, a2, blinecount,
                                                     brevs, blinenums))
 
+    cdef replacelines_batch(self, linelog_annotateresult *ar,
+                            linelog_revnum brev, const linelog_hunk *hunks,
+                            size_t hunkcount, const linelog_revnum *brevs,
+                            const linelog_linenum *blinenums):
+        self._eval(lambda: linelog_replacelines_batch(&self.buf, ar, brev,
+                                                      hunks, hunkcount,
+                                                      brevs, blinenums))
+
     cdef getalllines(self, linelog_annotateresult *ar, linelog_offset offset1,
                      linelog_offset offset2):
         self._eval(lambda: linelog_getalllines(&self.buf, ar,
@@ -388,6 +405,55 @@ cdef class linelog:
             free(brevs)
             free(blinenums)
 
+    def replacelines_batch(self, rev, hunks, blines=None):
+        """L.replacelines_batch(rev, hunks : [(a1, a2, b1, b2)],
+                                blines : [(rev, linenum)]?) -> None
+
+        Replace lines[a1:a2] with lines[b1:b2] for all hunks of rev at once.
+        Hunks are sorted and a1, a2 refer to the lines before the change.
+        If blines is not None, blines[b1:b2] are inserted instead, like
+        replacelines_vec. See comments above linelog_replacelines_batch in
+        linelog.h for details.
+        """
+        self._checkclosed()
+        cdef size_t i = 0, hunkcount = len(hunks)
+        cdef linelog_linenum blinecount = 0
+        cdef linelog_hunk *chunks = <linelog_hunk *>malloc(
+            sizeof(linelog_hunk) * hunkcount)
+        cdef linelog_revnum *brevs = NULL
+        cdef linelog_linenum *blinenums = NULL
+        if hunkcount > 0:
+            assert chunks != NULL
+        try:
+            if blines is not None:
+                blinecount = <linelog_linenum>len(blines)
+                brevs = <linelog_revnum *>malloc(
+                    sizeof(linelog_revnum) * blinecount)
+                blinenums = <linelog_linenum *>malloc(
+                    sizeof(linelog_linenum) * blinecount)
+                if blinecount > 0:
+                    assert brevs != NULL and blinenums != NULL
+                for i in range(0, blinecount):
+                    brevs[i] = blines[i][0]
+                    blinenums[i] = blines[i][1]
+            for i in range(0, hunkcount):
+                a1, a2, b1, b2 = hunks[i]
+                chunks[i].a1 = a1
+                chunks[i].a2 = a2
+                chunks[i].b1 = b1
+                chunks[i].b2 = b2
+                if blines is not None and chunks[i].b2 > blinecount:
+                    raise IndexError(b'line number out of range')
+            self.buf.replacelines_batch(&self.ar, rev, chunks, hunkcount,
+                                        brevs, blinenums)
+        except LinelogError:
+            self._clearannotateresult()
+            raise
+        finally:
+            free(chunks)
+            free(brevs)
+            free(blinenums)
+
     @property
     def annotateresult(self):
         """L.annotateresult -> [(rev, linenum)]"""
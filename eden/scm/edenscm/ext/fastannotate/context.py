@@ -682,17 +682,26 @@ class _annotatecontext(object):
         llrev = revmap.append(fctx.node(), path=fctx.path())
         siderevmap[fctx] = llrev
 
-        for (a1, a2, b1, b2), op in reversed(blocks):
+        hunks = []
+        for (a1, a2, b1, b2), op in blocks:
             if op == "=":
                 continue
-            if bannotated is None:
-                linelog.replacelines(llrev, a1, a2, b1, b2)
+            if hunks and hunks[-1][1] == a1 and hunks[-1][3] == b1:
+                # adjacent blocks, like "!" then "~", must be a single hunk
+                hunks[-1] = (hunks[-1][0], a2, hunks[-1][2], b2)
             else:
-                blines = [
+                hunks.append((a1, a2, b1, b2))
+        if bannotated is None:
+            linelog.replacelines_batch(llrev, hunks)
+        else:
+            # only blines[b1:b2] of the hunks are used
+            blines = [(0, 0)] * len(bannotated)
+            for a1, a2, b1, b2 in hunks:
+                blines[b1:b2] = [
                     ((r if isinstance(r, int) else siderevmap[r]), l)
                     for r, l in bannotated[b1:b2]
                 ]
-                linelog.replacelines_vec(llrev, a1, a2, blines)
+            linelog.replacelines_batch(llrev, hunks, blines)
 
     def _addpathtoresult(self, annotateresult, revmap=None):
         """(revmap, [(node, linenum)]) -> [(node, linenum, path)]"""
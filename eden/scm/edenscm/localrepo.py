@@ -833,6 +833,12 @@ class localrepository(object):
         mmapindexthreshold = self.ui.configbytes("experimental", "mmapindexthreshold")
         if mmapindexthreshold is not None:
             self.svfs.options["mmapindexthreshold"] = mmapindexthreshold
+        # experimental config: experimental.persistentnodemapthreshold
+        nodemapthreshold = self.ui.configint(
+            "experimental", "persistentnodemapthreshold"
+        )
+        if nodemapthreshold is not None:
+            self.svfs.options["persistentnodemapthreshold"] = nodemapthreshold
         withsparseread = self.ui.configbool("experimental", "sparse-read")
         srdensitythres = float(
             self.ui.config("experimental", "sparse-read.density-threshold")
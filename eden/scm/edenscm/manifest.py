@@ -224,6 +224,16 @@ class manifestdict(object):
     def setflag(self, key, flag):
         self._lm[key] = self[key], flag
 
+    def bulkupdate(self, changes):
+        """Applies a sequence of (path, (node, flags)) and (path, None)
+        changes, the latter removing path, sorted by path.
+
+        This is a single merge rather than a binary search and a move of the
+        following entries for every change, which matters for commits touching
+        many files. Nothing is changed if a removed path is missing.
+        """
+        self._lm.bulkupdate(changes)
+
     def get(self, key, default=None):
         try:
             return self._lm[key][0]
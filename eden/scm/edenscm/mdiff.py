@@ -12,6 +12,7 @@
 
 from __future__ import absolute_import
 
+import functools
 import re
 import struct
 import zlib
@@ -48,6 +49,8 @@ def init(ui: "UI") -> None:
         # pyre-fixme[9]: blocks has type `(a: str, b: str) -> List[Tuple[int, int,
         #  int, int]]`; used as `(a: str, b: str) -> List[Tuple[int, int, int, int]]`.
         blocks = xdiff.blocks
+        if ui.configbool("experimental", "xdiff.histogram"):
+            blocks = functools.partial(xdiff.blocks, histogram=True)
 
 
 def splitnewlines(text: bytes) -> "List[bytes]":
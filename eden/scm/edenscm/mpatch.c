@@ -34,29 +34,22 @@
 #include "eden/scm/edenscm/compat.h"
 #include "eden/scm/edenscm/mpatch.h"
 
+/* the hunks are allocated along with the list */
 static struct mpatch_flist* lalloc(ssize_t size) {
   struct mpatch_flist* a = NULL;
 
   if (size < 1)
     size = 1;
 
-  a = (struct mpatch_flist*)malloc(sizeof(struct mpatch_flist));
-  if (a) {
-    a->base = (struct mpatch_frag*)malloc(sizeof(struct mpatch_frag) * size);
-    if (a->base) {
-      a->head = a->tail = a->base;
-      return a;
-    }
-    free(a);
-  }
-  return NULL;
+  a = (struct mpatch_flist*)malloc(
+      sizeof(struct mpatch_flist) + sizeof(struct mpatch_frag) * size);
+  if (a)
+    a->base = a->head = a->tail = (struct mpatch_frag*)(a + 1);
+  return a;
 }
 
 void mpatch_lfree(struct mpatch_flist* a) {
-  if (a) {
-    free(a->base);
-    free(a);
-  }
+  free(a);
 }
 
 static ssize_t lsize(struct mpatch_flist* a) {
@@ -146,54 +139,56 @@ static int discard(struct mpatch_flist* src, int cut, int offset) {
   return offset;
 }
 
-/* combine hunk lists a and b, while adjusting b for offset changes in a/
-   this deletes a and b and returns the resultant list. */
-static struct mpatch_flist* combine(
+/* combine hunk lists a and b into c, while adjusting b for offset changes
+   in a. c must have room for twice as many hunks as a and b together. */
+static void combine(
+    struct mpatch_flist* c,
     struct mpatch_flist* a,
     struct mpatch_flist* b) {
-  struct mpatch_flist* c = NULL;
   struct mpatch_frag *bh, *ct;
   int offset = 0, post;
 
-  if (a && b)
-    c = lalloc((lsize(a) + lsize(b)) * 2);
-
-  if (c) {
-    for (bh = b->head; bh != b->tail; bh++) {
-      /* save old hunks */
-      offset = gather(c, a, bh->start, offset);
-
-      /* discard replaced hunks */
-      post = discard(a, bh->end, offset);
-
-      /* insert new hunk */
-      ct = c->tail;
-      ct->start = bh->start - offset;
-      ct->end = bh->end - post;
-      ct->len = bh->len;
-      ct->data = bh->data;
-      c->tail++;
-      offset = post;
-    }
-
-    /* hold on to tail from a */
-    memcpy(c->tail, a->head, sizeof(struct mpatch_frag) * lsize(a));
-    c->tail += lsize(a);
+  for (bh = b->head; bh != b->tail; bh++) {
+    /* save old hunks */
+    offset = gather(c, a, bh->start, offset);
+
+    /* discard replaced hunks */
+    post = discard(a, bh->end, offset);
+
+    /* insert new hunk */
+    ct = c->tail;
+    ct->start = bh->start - offset;
+    ct->end = bh->end - post;
+    ct->len = bh->len;
+    ct->data = bh->data;
+    c->tail++;
+    offset = post;
   }
 
-  mpatch_lfree(a);
-  mpatch_lfree(b);
-  return c;
+  /* hold on to tail from a */
+  memcpy(c->tail, a->head, sizeof(struct mpatch_frag) * lsize(a));
+  c->tail += lsize(a);
 }
 
 /* decode a binary patch into a hunk list */
 int mpatch_decode(const char* bin, ssize_t len, struct mpatch_flist** res) {
   struct mpatch_flist* l;
   struct mpatch_frag* lt;
+  ssize_t count = 0;
   int pos = 0;
 
-  /* assume worst case size, we won't have many of these lists */
-  l = lalloc(len / 12 + 1);
+  /* count the hunks first, rather than assuming the worst case size, since
+     there is a list for every patch of the chain being folded */
+  while (pos >= 0 && pos < len - 11) {
+    int hunklen = (int)getbe32(bin + pos + 8);
+    count++;
+    if (hunklen < 0)
+      break; /* rejected below */
+    pos += 12 + hunklen;
+  }
+  pos = 0;
+
+  l = lalloc(count);
   if (!l)
     return MPATCH_ERR_NO_MEM;
 
@@ -264,22 +259,97 @@ int mpatch_apply(
   return 0;
 }
 
-/* recursively generate a patch of all bins between start and end */
+/* make sure *pool has room for size hunks */
+static int reserve(struct mpatch_frag** pool, ssize_t* poolsize, ssize_t size) {
+  struct mpatch_frag* p;
+
+  if (size <= *poolsize)
+    return 0;
+  p = (struct mpatch_frag*)realloc(*pool, sizeof(struct mpatch_frag) * size);
+  if (!p)
+    return -1;
+  *pool = p;
+  *poolsize = size;
+  return 0;
+}
+
+/* generate a patch of all bins between start and end
+
+   The lists are combined pairwise, a level of the tree at a time, so that
+   no byte is touched until the whole chain has been folded into a single
+   list. Every level is written to one pool of hunks, alternating between
+   two pools, so that a chain of n patches takes n allocations to decode
+   and only a few more to fold, rather than one for every combination. */
 struct mpatch_flist* mpatch_fold(
     void* bins,
     struct mpatch_flist* (*get_next_item)(void*, ssize_t),
     ssize_t start,
     ssize_t end) {
-  ssize_t len;
+  struct mpatch_flist **decoded, *lists, *res = NULL;
+  struct mpatch_frag *pools[2] = {NULL, NULL}, *t;
+  ssize_t poolsizes[2] = {0, 0}, n = end - start, i, total;
+  int pool = 0;
 
-  if (start + 1 == end) {
+  if (n == 1) {
     /* trivial case, output a decoded list */
     return get_next_item(bins, start);
   }
 
-  /* divide and conquer, memory management is elsewhere */
-  len = (end - start) / 2;
-  return combine(
-      mpatch_fold(bins, get_next_item, start, start + len),
-      mpatch_fold(bins, get_next_item, start + len, end));
+  decoded = (struct mpatch_flist**)calloc(n, sizeof(*decoded));
+  lists = (struct mpatch_flist*)malloc(n * sizeof(*lists));
+  if (!decoded || !lists)
+    goto cleanup;
+
+  for (i = 0; i < n; i++) {
+    decoded[i] = get_next_item(bins, start + i);
+    if (!decoded[i])
+      goto cleanup;
+    lists[i] = *decoded[i];
+  }
+
+  for (; n > 1; n = (n + 1) / 2) {
+    for (total = 0, i = 0; i < n; i++)
+      total += lsize(&lists[i]);
+    if (reserve(&pools[pool], &poolsizes[pool], total * 2 + 1) < 0)
+      goto cleanup;
+
+    t = pools[pool];
+    for (i = 0; i + 1 < n; i += 2) {
+      struct mpatch_flist c = {t, t, t};
+      combine(&c, &lists[i], &lists[i + 1]);
+      lists[i / 2] = c;
+      t = c.tail;
+    }
+    if (n & 1) {
+      /* move the odd one out, so that the previous pool can be reused */
+      memcpy(t, lists[n - 1].head, sizeof(*t) * lsize(&lists[n - 1]));
+      lists[n / 2].base = lists[n / 2].head = t;
+      lists[n / 2].tail = t + lsize(&lists[n - 1]);
+    }
+
+    if (decoded) {
+      for (i = 0; i < end - start; i++)
+        mpatch_lfree(decoded[i]);
+      free(decoded);
+      decoded = NULL;
+    }
+    pool = !pool;
+  }
+
+  res = lalloc(lsize(&lists[0]));
+  if (res) {
+    memcpy(res->base, lists[0].head, sizeof(*t) * lsize(&lists[0]));
+    res->tail += lsize(&lists[0]);
+  }
+
+cleanup:
+  if (decoded) {
+    for (i = 0; i < end - start; i++)
+      mpatch_lfree(decoded[i]);
+    free(decoded);
+  }
+  free(lists);
+  free(pools[0]);
+  free(pools[1]);
+  return res;
 }
@@ -277,6 +277,10 @@ versionformat_unpack = versionformat.unpack
 # signed integer)
 _maxentrysize = 0x7FFFFFFF
 
+# number of revs a persisted node trie may lag behind its revlog before it is
+# rewritten, which readers insert into the trie as they load it
+_nodemapmaxlag = 1000
+
 
 class revlogio(object):
     def __init__(self):
@@ -473,6 +477,23 @@ class revlog(object):
         self.index, nodemap, self._chunkcache = d
         if nodemap is not None:
             self.nodemap = self._nodecache = nodemap
+        # The node trie of the C index can be persisted, for revlogs with
+        # large indexes at the root of the store, where the fncache and
+        # streaming clones ignore files that aren't revlogs.
+        self._nodemapfile = None
+        self._nodemapcovered = 0
+        self._nodemapthreshold = None
+        if opts is not None:
+            self._nodemapthreshold = opts.get("persistentnodemapthreshold")
+        if (
+            self._nodemapthreshold is not None
+            and mmaplargeindex
+            and not index2
+            and "/" not in self.indexfile
+            and util.safehasattr(self.index, "loadnodemap")
+        ):
+            self._nodemapfile = self.indexfile[:-2] + ".nt"
+            self._loadnodemap()
         if not self._chunkcache:
             self._chunkclear()
         # revnum -> (chain-length, sum-delta-length)
@@ -485,6 +506,33 @@ class revlog(object):
         # like visibleheads and bookmarks control the commit graph.
         self._bypasstransaction = bool(opts and opts.get("bypass-revlog-transaction"))
 
+    def _loadnodemap(self):
+        """Use the persisted node trie, rather than building one from the
+        index on the first lookups. It is validated against the index, and
+        revs appended since it was written are inserted into it."""
+        try:
+            with self.opener(self._nodemapfile) as f:
+                data = util.buffer(util.mmapread(f))
+        except IOError as inst:
+            if inst.errno != errno.ENOENT:
+                raise
+            return
+        covered = self.index.loadnodemap(data)
+        if covered is not None:
+            self._nodemapcovered = covered
+
+    def _writenodemap(self, tr):
+        """Persist the node trie, if the revlog is large enough and the
+        persisted one lags too far behind it."""
+        if len(self) < self._nodemapthreshold:
+            return
+        if 0 <= len(self) - self._nodemapcovered < _nodemapmaxlag:
+            return
+        data = self.index.nodemapdata()
+        with self.opener(self._nodemapfile, "w", atomictemp=True) as f:
+            f.write(data)
+        self._nodemapcovered = len(self)
+
     @util.propertycache
     def _compressor(self):
         return util.compengines[self._compengine].revlogcompressor()
@@ -2121,6 +2169,8 @@ class revlog(object):
             ifh.write(data[1])
             if not self._bypasstransaction:
                 self.checkinlinesize(transaction, ifh)
+        if self._nodemapfile is not None and not self._bypasstransaction:
+            transaction.addfinalize("nodemap-%s" % self.indexfile, self._writenodemap)
 
     def addgroup(self, deltas, linkmapper, transaction):
         """
@@ -2307,6 +2357,8 @@ class revlog(object):
         self._chunkclear()
         for x in range(rev, len(self)):
             del self.nodemap[self.node(x)]
+        # the persisted node trie holds stripped revs and must be rewritten
+        self._nodemapcovered = 0
 
         del self.index[rev:-1]
 
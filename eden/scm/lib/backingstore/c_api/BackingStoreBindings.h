@@ -117,6 +117,17 @@ void sapling_backingstore_get_tree_batch(BackingStore *store,
                                          void *data,
                                          void (*resolve)(void*, uintptr_t, CFallibleBase));
 
+/// Asynchronous version of `sapling_backingstore_get_tree_batch`: returns immediately, and fetches
+/// the trees on the blocking pool of the async runtime. `resolve` is called as each tree completes,
+/// then `done` once all of them did. The store and `data` must stay valid until `done` is called,
+/// `requests` is only read before returning.
+void sapling_backingstore_get_tree_batch_async(const BackingStore *store,
+                                               Slice<Request> requests,
+                                               bool local,
+                                               void *data,
+                                               void (*resolve)(void*, uintptr_t, CFallibleBase),
+                                               void (*done)(void*));
+
 CFallibleBase sapling_backingstore_get_blob(BackingStore *store, Slice<uint8_t> node, bool local);
 
 void sapling_backingstore_get_blob_batch(BackingStore *store,
@@ -125,6 +136,15 @@ void sapling_backingstore_get_blob_batch(BackingStore *store,
                                          void *data,
                                          void (*resolve)(void*, uintptr_t, CFallibleBase));
 
+/// Asynchronous version of `sapling_backingstore_get_blob_batch`, see
+/// `sapling_backingstore_get_tree_batch_async`.
+void sapling_backingstore_get_blob_batch_async(const BackingStore *store,
+                                               Slice<Request> requests,
+                                               bool local,
+                                               void *data,
+                                               void (*resolve)(void*, uintptr_t, CFallibleBase),
+                                               void (*done)(void*));
+
 CFallibleBase sapling_backingstore_get_file_aux(BackingStore *store,
                                                 Slice<uint8_t> node,
                                                 bool local);
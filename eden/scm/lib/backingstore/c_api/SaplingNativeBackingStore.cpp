@@ -47,6 +47,43 @@ SaplingNativeBackingStore::SaplingNativeBackingStore(
   store_ = store.unwrap();
 }
 
+SaplingNativeBackingStore::~SaplingNativeBackingStore() {
+  // The pending async batches still use store_.
+  auto pending = pendingAsyncBatches_.lock();
+  pendingAsyncBatchesCV_.wait(pending.as_lock(), [&] { return *pending == 0; });
+}
+
+/**
+ * State of an async batch, owned by the Rust thread fetching it until its
+ * done callback is called.
+ */
+template <typename T>
+struct SaplingNativeBackingStore::AsyncBatch {
+  SaplingNativeBackingStore* store;
+  size_t count;
+  folly::Function<void(size_t, T)> resolve;
+  folly::Function<void()> done;
+
+  static void onDone(void* data) {
+    std::unique_ptr<AsyncBatch> batch{static_cast<AsyncBatch*>(data)};
+    auto* store = batch->store;
+    batch->done();
+    batch.reset();
+    store->finishAsyncBatch();
+  }
+};
+
+void SaplingNativeBackingStore::startAsyncBatch() {
+  ++*pendingAsyncBatches_.lock();
+}
+
+void SaplingNativeBackingStore::finishAsyncBatch() {
+  auto pending = pendingAsyncBatches_.lock();
+  if (--*pending == 0) {
+    pendingAsyncBatchesCV_.notify_all();
+  }
+}
+
 std::shared_ptr<Tree> SaplingNativeBackingStore::getTree(
     NodeId node,
     bool local) {
@@ -116,6 +153,51 @@ void SaplingNativeBackingStore::getTreeBatch(
       });
 }
 
+void SaplingNativeBackingStore::getTreeBatchAsync(
+    NodeIdRange requests,
+    bool local,
+    folly::Function<void(size_t, std::shared_ptr<Tree>)> resolve,
+    folly::Function<void()> done) {
+  size_t count = requests.size();
+
+  XLOG(DBG7) << "Import async batch of trees with size:" << count;
+
+  std::vector<Request> raw_requests;
+  raw_requests.reserve(count);
+  for (auto& node : requests) {
+    raw_requests.push_back(Request{
+        node.data(),
+    });
+  }
+
+  using Batch = AsyncBatch<std::shared_ptr<Tree>>;
+  auto batch = std::make_unique<Batch>(
+      Batch{this, count, std::move(resolve), std::move(done)});
+
+  startAsyncBatch();
+  sapling_backingstore_get_tree_batch_async(
+      store_.get(),
+      folly::crange(raw_requests),
+      local,
+      batch.release(),
+      +[](void* data, size_t index, CFallibleBase raw_result) {
+        auto* batch = static_cast<Batch*>(data);
+        CFallible<Tree, sapling_tree_free> result{std::move(raw_result)};
+
+        if (result.isError()) {
+          XLOGF(
+              DBG6,
+              "Failed to import tree from EdenAPI (async batch {}/{}): {}",
+              index,
+              batch->count,
+              result.getError());
+        } else {
+          batch->resolve(index, result.unwrap());
+        }
+      },
+      &Batch::onDone);
+}
+
 std::unique_ptr<folly::IOBuf> SaplingNativeBackingStore::getBlob(
     NodeId node,
     bool local) {
@@ -185,6 +267,51 @@ void SaplingNativeBackingStore::getBlobBatch(
       });
 }
 
+void SaplingNativeBackingStore::getBlobBatchAsync(
+    NodeIdRange requests,
+    bool local,
+    folly::Function<void(size_t, std::unique_ptr<folly::IOBuf>)> resolve,
+    folly::Function<void()> done) {
+  size_t count = requests.size();
+
+  XLOG(DBG7) << "Import async batch of blobs with size:" << count;
+
+  std::vector<Request> raw_requests;
+  raw_requests.reserve(count);
+  for (auto& node : requests) {
+    raw_requests.push_back(Request{
+        node.data(),
+    });
+  }
+
+  using Batch = AsyncBatch<std::unique_ptr<folly::IOBuf>>;
+  auto batch = std::make_unique<Batch>(
+      Batch{this, count, std::move(resolve), std::move(done)});
+
+  startAsyncBatch();
+  sapling_backingstore_get_blob_batch_async(
+      store_.get(),
+      folly::crange(raw_requests),
+      local,
+      batch.release(),
+      +[](void* data, size_t index, CFallibleBase raw_result) {
+        auto* batch = static_cast<Batch*>(data);
+        CFallible<CBytes, sapling_cbytes_free> result{std::move(raw_result)};
+
+        if (result.isError()) {
+          XLOGF(
+              DBG6,
+              "Failed to import blob from EdenAPI (async batch {}/{}): {}",
+              index,
+              batch->count,
+              result.getError());
+        } else {
+          batch->resolve(index, bytesToIOBuf(result.unwrap().release()));
+        }
+      },
+      &Batch::onDone);
+}
+
 std::shared_ptr<FileAuxData> SaplingNativeBackingStore::getBlobMetadata(
     NodeId node,
     bool local) {
@@ -9,7 +9,10 @@
 
 #include <folly/Function.h>
 #include <folly/Range.h>
+#include <folly/Synchronized.h>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string_view>
 
 #include "eden/scm/lib/backingstore/c_api/BackingStoreBindings.h"
@@ -45,6 +48,9 @@ using NodeIdRange = folly::Range<const NodeId*>;
  * - Batch methods take a callback function which is evaluated once per
  *   returned result. Compared to returning a vector, this minimizes the
  *   amount of time that heavyweight are in RAM.
+ * - Async batch methods return immediately. The batch is fetched on a Rust
+ *   thread, which calls `resolve` as each result completes and then `done`.
+ *   The destructor waits for the pending async batches.
  */
 class SaplingNativeBackingStore {
  public:
@@ -52,6 +58,8 @@ class SaplingNativeBackingStore {
       std::string_view repository,
       const BackingStoreOptions& options);
 
+  ~SaplingNativeBackingStore();
+
   std::shared_ptr<Tree> getTree(NodeId node, bool local);
 
   void getTreeBatch(
@@ -59,6 +67,12 @@ class SaplingNativeBackingStore {
       bool local,
       folly::FunctionRef<void(size_t, std::shared_ptr<Tree>)> resolve);
 
+  void getTreeBatchAsync(
+      NodeIdRange requests,
+      bool local,
+      folly::Function<void(size_t, std::shared_ptr<Tree>)> resolve,
+      folly::Function<void()> done);
+
   std::unique_ptr<folly::IOBuf> getBlob(NodeId node, bool local);
 
   void getBlobBatch(
@@ -66,6 +80,12 @@ class SaplingNativeBackingStore {
       bool local,
       folly::FunctionRef<void(size_t, std::unique_ptr<folly::IOBuf>)> resolve);
 
+  void getBlobBatchAsync(
+      NodeIdRange requests,
+      bool local,
+      folly::Function<void(size_t, std::unique_ptr<folly::IOBuf>)> resolve,
+      folly::Function<void()> done);
+
   std::shared_ptr<FileAuxData> getBlobMetadata(NodeId node, bool local);
 
   void getBlobMetadataBatch(
@@ -76,6 +96,15 @@ class SaplingNativeBackingStore {
   void flush();
 
  private:
+  template <typename T>
+  struct AsyncBatch;
+
+  void startAsyncBatch();
+  void finishAsyncBatch();
+
+  folly::Synchronized<size_t, std::mutex> pendingAsyncBatches_{0};
+  std::condition_variable pendingAsyncBatchesCV_;
+
   sapling::CFallible<
       sapling::BackingStore,
       sapling::sapling_backingstore_free>::Ptr store_;
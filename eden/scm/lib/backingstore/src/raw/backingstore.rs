@@ -25,6 +25,15 @@ use crate::raw::Request;
 use crate::raw::Slice;
 use crate::raw::Tree;
 
+/// Pointers handed to the asynchronous batch functions. The caller guarantees that they stay
+/// valid until `done` is called.
+struct AsyncBatch {
+    store: *const BackingStore,
+    data: *mut c_void,
+}
+
+unsafe impl Send for AsyncBatch {}
+
 #[repr(C)]
 pub struct BackingStoreOptions {
     aux_data: bool,
@@ -86,6 +95,36 @@ pub extern "C" fn sapling_backingstore_get_tree_batch(
     });
 }
 
+/// Asynchronous version of `sapling_backingstore_get_tree_batch`: returns immediately, and fetches
+/// the trees on the blocking pool of the async runtime. `resolve` is called as each tree completes,
+/// then `done` once all of them did. The store and `data` must stay valid until `done` is called,
+/// `requests` is only read before returning.
+#[no_mangle]
+pub extern "C" fn sapling_backingstore_get_tree_batch_async(
+    store: &BackingStore,
+    requests: Slice<Request>,
+    local: bool,
+    data: *mut c_void,
+    resolve: unsafe extern "C" fn(*mut c_void, usize, CFallibleBase),
+    done: unsafe extern "C" fn(*mut c_void),
+) {
+    let keys: Vec<Key> = requests.slice().iter().map(|req| req.key()).collect();
+    let batch = AsyncBatch { store, data };
+
+    async_runtime::spawn_blocking(move || {
+        let batch = batch;
+        let store = unsafe { &*batch.store };
+        store.get_tree_batch(keys, local, |idx, result| {
+            let result: Result<List> =
+                result.and_then(|opt| opt.ok_or_else(|| Error::msg("no tree found")));
+            let result: Result<Tree> = result.and_then(|list| list.try_into());
+            let result: CFallible<Tree> = result.into();
+            unsafe { resolve(batch.data, idx, result.into()) };
+        });
+        unsafe { done(batch.data) };
+    });
+}
+
 #[no_mangle]
 pub extern "C" fn sapling_backingstore_get_blob(
     store: &mut BackingStore,
@@ -119,6 +158,34 @@ pub extern "C" fn sapling_backingstore_get_blob_batch(
     });
 }
 
+/// Asynchronous version of `sapling_backingstore_get_blob_batch`, see
+/// `sapling_backingstore_get_tree_batch_async`.
+#[no_mangle]
+pub extern "C" fn sapling_backingstore_get_blob_batch_async(
+    store: &BackingStore,
+    requests: Slice<Request>,
+    local: bool,
+    data: *mut c_void,
+    resolve: unsafe extern "C" fn(*mut c_void, usize, CFallibleBase),
+    done: unsafe extern "C" fn(*mut c_void),
+) {
+    let keys: Vec<Key> = requests.slice().iter().map(|req| req.key()).collect();
+    let batch = AsyncBatch { store, data };
+
+    async_runtime::spawn_blocking(move || {
+        let batch = batch;
+        let store = unsafe { &*batch.store };
+        store.get_blob_batch(keys, local, |idx, result| {
+            let result: CFallible<CBytes> = result
+                .and_then(|opt| opt.ok_or_else(|| Error::msg("no blob found")))
+                .map(CBytes::from_vec)
+                .into();
+            unsafe { resolve(batch.data, idx, result.into()) };
+        });
+        unsafe { done(batch.data) };
+    });
+}
+
 #[no_mangle]
 pub extern "C" fn sapling_backingstore_get_file_aux(
     store: &mut BackingStore,
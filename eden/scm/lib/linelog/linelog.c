@@ -148,13 +148,18 @@ writeinst(linelog_buf* buf, const linelog_inst* inst, linelog_loffset offset) {
     assert(result == LINELOG_RESULT_OK);                           \
   }
 
-/* ensure `ar->lines[0:linecount]` are valid */
+/* ensure `ar->lines[0:linecount]` are valid. grow by 1.5x at least, so
+   appending lines one by one does not realloc every time */
 static linelog_result reservelines(
     linelog_annotateresult* ar,
     linelog_llinenum linecount) {
   if (linecount >= MAX_LINENUM)
     return LINELOG_RESULT_EOVERFLOW;
   if (ar->maxlinecount < linecount) {
+    linelog_llinenum grown = (linelog_llinenum)ar->maxlinecount +
+        ar->maxlinecount / 2 + 16;
+    if (grown > linecount)
+      linecount = MIN(grown, MAX_LINENUM - 1);
     size_t size = sizeof(linelog_lineinfo) * linecount;
     void* p = realloc(ar->lines, size);
     if (p == NULL)
@@ -218,10 +223,15 @@ linelog_result linelog_annotate(
   linelog_offset pc, nextpc = 1, endoffset = 0;
   ar->linecount = 0;
   size_t step = (size_t)inst0.offset;
+  /* readinst(buf, &inst0, 0) checked the buffer is large enough for all
+     instructions, so they can be decoded without checking that again */
+  linelog_loffset len = MIN((linelog_loffset)inst0.offset, MAX_OFFSET);
 
   while ((pc = nextpc++) != 0 && --step) {
     linelog_inst i;
-    returnonerror(readinst(buf, &i, pc));
+    if (pc >= len)
+      return LINELOG_RESULT_EILLDATA;
+    decode(buf->data + (size_t)pc * INST_SIZE, &i);
 
     switch (i.opcode) {
       case JGE:
@@ -249,14 +259,12 @@ linelog_result linelog_annotate(
   return LINELOG_RESULT_OK;
 }
 
-static linelog_result replacelines(
+static linelog_result replacehunks(
     linelog_buf* buf,
     linelog_annotateresult* ar,
     linelog_revnum brev,
-    linelog_linenum a1,
-    linelog_linenum a2,
-    linelog_linenum b1,
-    linelog_linenum b2,
+    const linelog_hunk* hunks,
+    size_t hunkcount,
     const linelog_revnum* brevs,
     const linelog_linenum* blinenums) {
   /*       buf   before     after
@@ -281,102 +289,149 @@ static linelog_result replacelines(
      [2]: delete old lines. only exist if a1 < a2
      [3]: move a1inst to new place, as it will be rewritten in [5]
      [4]: jump back. only exist if a1inst is not an unconditional jump
-     [5]: rewrite the old instruction to jump to the new block */
+     [5]: rewrite the old instruction to jump to the new block
+
+     with hunkcount > 1, one such block is appended per hunk. a2addr is
+     taken from ar before the update, so if it is the a1addr of the next
+     hunk, it jumps to the block of that hunk via [5]. */
 
   /* sanity check */
   linelog_inst inst0;
   returnonerror(readinst(buf, &inst0, 0));
-  if (brev >= MAX_REVNUM || a2 >= MAX_LINENUM || b2 >= MAX_LINENUM)
+  if (brev >= MAX_REVNUM)
     return LINELOG_RESULT_EOVERFLOW;
-  if (a2 < a1 || b2 < b1 || !ar || a2 > ar->linecount || brev == 0 ||
-      ar->linecount >= ar->maxlinecount)
+  if (!ar || brev == 0 || ar->linecount >= ar->maxlinecount)
     return LINELOG_RESULT_EILLDATA;
+  if (hunkcount == 0)
+    return LINELOG_RESULT_OK;
 
-  /* useful variables for both step I and III */
+  /* step I: reserve size for buf: (newlen - oldlen) more instructions,
+     and count the lines of ar */
   linelog_offset oldlen = inst0.offset;
-  linelog_offset a1addr = ar->lines[a1].offset;
-  linelog_inst a1inst;
-  returnonerror(readinst(buf, &a1inst, a1addr));
-  bool a1instisjge0 = (a1inst.opcode == JGE && a1inst.rev == 0);
-
-  /* step I: reserve size for buf: (newlen - oldlen) more instructions */
-  linelog_loffset newlen = (linelog_loffset)oldlen +
-      (b2 - b1 /* LINE */ + (b2 > b1) /* JL brev */) /* [1] */
-      + (a2 > a1) /* JGE brev */ /* [2] */
-      + 1 /* a1inst */ /* [3] */
-      + (a1instisjge0 ? 0 : 1) /* JGE 0  */ /* [4] */;
-  if (newlen >= MAX_OFFSET)
-    return LINELOG_RESULT_EOVERFLOW;
+  linelog_loffset newlen = oldlen;
+  linelog_llinenum oldlinecount = ar->linecount;
+  linelog_llinenum newlinecount = oldlinecount;
+  linelog_llinenum shift = 0; /* max(newlinecount - oldlinecount) so far */
+  for (size_t j = 0; j < hunkcount; ++j) {
+    const linelog_hunk* h = hunks + j;
+    if (h->a2 >= MAX_LINENUM || h->b2 >= MAX_LINENUM)
+      return LINELOG_RESULT_EOVERFLOW;
+    if (h->a2 < h->a1 || h->b2 < h->b1 || h->a2 > oldlinecount)
+      return LINELOG_RESULT_EILLDATA;
+    if (j > 0 && (h->a1 < h[-1].a2 || h->a1 == h[-1].a1))
+      return LINELOG_RESULT_EILLDATA;
+    linelog_inst a1inst;
+    returnonerror(readinst(buf, &a1inst, ar->lines[h->a1].offset));
+    bool a1instisjge0 = (a1inst.opcode == JGE && a1inst.rev == 0);
+    newlen += (h->b2 - h->b1 /* LINE */ + (h->b2 > h->b1) /* JL */) /* [1] */
+        + (h->a2 > h->a1) /* JGE brev */ /* [2] */
+        + 1 /* a1inst */ /* [3] */
+        + (a1instisjge0 ? 0 : 1) /* JGE 0  */ /* [4] */;
+    if (newlen >= MAX_OFFSET)
+      return LINELOG_RESULT_EOVERFLOW;
+    newlinecount = newlinecount + (h->b2 - h->b1) - (h->a2 - h->a1);
+    if (newlinecount > oldlinecount + shift)
+      shift = newlinecount - oldlinecount;
+  }
   size_t neededsize = (size_t)newlen * INST_SIZE;
   if (neededsize > buf->size) {
     buf->neededsize = neededsize;
     return LINELOG_RESULT_ENEEDRESIZE;
   }
 
-  /* step II: reserve space for annotateresult */
-  linelog_llinenum newlinecount =
-      (linelog_llinenum)ar->linecount + b2 - b1 - (a2 - a1);
-  returnonerror(reservelines(ar, newlinecount + 1));
+  /* step II: reserve space for annotateresult. lines after the first hunk
+     are moved by `shift` so they can be compacted in place in step V, which
+     needs `shift` more lines than the old annotateresult at most. */
+  returnonerror(reservelines(ar, oldlinecount + shift + 1));
   assert(ar->linecount < ar->maxlinecount);
+  linelog_lineinfo* lines = ar->lines;
+  linelog_linenum first = hunks[0].a2;
+  if (shift > 0) {
+    size_t movesize = sizeof(linelog_lineinfo) * (oldlinecount + 1 - first);
+    memmove(lines + first + shift, lines + first, movesize);
+  }
+/* the line at ar[k] before the update */
+#define oldline(k) (lines[(k) < first ? (k) : (k) + shift])
 
 /* writeinst should not fail for remaining steps - we have reserved
    enough space. any failure will be a huge headache for the caller. */
 
 /* step III: update linelog_buf */
 #define appendinst(inst) mustsuccess(writeinst(buf, &inst, inst0.offset++));
-  if (b1 < b2) { /* [1] */
-    linelog_offset pjge = oldlen + (b2 - b1 + 1);
-    linelog_inst jl = {.opcode = JL, .rev = brev, .offset = pjge};
-    appendinst(jl);
-    for (linelog_linenum i = b1; i < b2; ++i) {
-      linelog_inst lineinst = {
-          .opcode = LINE,
-          .rev = brevs ? brevs[i] : brev,
-          .offset /* linenum */ = blinenums ? blinenums[i] : i};
-      appendinst(lineinst);
+  linelog_llinenum dest = hunks[0].a1;
+  for (size_t j = 0; j < hunkcount; ++j) {
+    const linelog_hunk* h = hunks + j;
+    linelog_offset blockaddr = inst0.offset;
+    linelog_offset a1addr = oldline(h->a1).offset;
+    linelog_inst a1inst;
+    mustsuccess(readinst(buf, &a1inst, a1addr));
+    bool a1instisjge0 = (a1inst.opcode == JGE && a1inst.rev == 0);
+    if (h->b1 < h->b2) { /* [1] */
+      linelog_offset pjge = blockaddr + (h->b2 - h->b1 + 1);
+      linelog_inst jl = {.opcode = JL, .rev = brev, .offset = pjge};
+      appendinst(jl);
+      for (linelog_linenum i = h->b1; i < h->b2; ++i) {
+        linelog_inst lineinst = {
+            .opcode = LINE,
+            .rev = brevs ? brevs[i] : brev,
+            .offset /* linenum */ = blinenums ? blinenums[i] : i};
+        appendinst(lineinst);
+      }
+    }
+    if (h->a1 < h->a2) { /* [2] */
+      linelog_offset a2addr = oldline(h->a2).offset;
+      /* delete a chunk of an old commit. be conservative, do not
+         touch invisible lines between a2 - 1 and a2 */
+      if (h->a2 > 0 && brev < inst0.rev /* maxrev */)
+        a2addr = oldline(h->a2 - 1).offset + 1;
+      linelog_inst jge = {.opcode = JGE, .rev = brev, .offset = a2addr};
+      appendinst(jge);
+    }
+    linelog_offset a1newaddr = inst0.offset;
+    appendinst(a1inst); /* [3] */
+    if (!a1instisjge0) { /* [4] */
+      linelog_inst ret = {
+          /* .opcode = */ JGE,
+          0,
+          /* .offset = */ a1addr + 1};
+      appendinst(ret);
+    }
+    linelog_inst jge0 = {.opcode = JGE, .rev = 0, .offset = blockaddr};
+    mustsuccess(writeinst(buf, &jge0, a1addr)); /* [5] */
+
+    /* step V (interleaved): update annotateresult. lines are only written
+       before oldline(h->a2), which is read by later hunks. */
+    oldline(h->a1).offset = a1newaddr; /* a1inst got moved */
+    if (j > 0) {
+      size_t count = h->a1 - h[-1].a2;
+      linelog_lineinfo* src = &oldline(h[-1].a2);
+      if (lines + dest != src)
+        memmove(lines + dest, src, sizeof(linelog_lineinfo) * count);
+      dest += count;
+    }
+    for (linelog_linenum i = h->b1; i < h->b2; ++i) {
+      linelog_lineinfo* li = lines + dest++;
+      li->rev = brevs ? brevs[i] : brev;
+      li->linenum = blinenums ? blinenums[i] : i;
+      li->offset = blockaddr + i - h->b1 + 1;
     }
-  }
-  if (a1 < a2) { /* [2] */
-    linelog_offset a2addr = ar->lines[a2].offset;
-    /* delete a chunk of an old commit. be conservative, do not
-       touch invisible lines between a2 - 1 and a2 */
-    if (a2 > 0 && brev < inst0.rev /* maxrev */)
-      a2addr = ar->lines[a2 - 1].offset + 1;
-    linelog_inst jge = {.opcode = JGE, .rev = brev, .offset = a2addr};
-    appendinst(jge);
-  }
-  linelog_offset a1newaddr = inst0.offset;
-  appendinst(a1inst); /* [3] */
-  if (!a1instisjge0) { /* [4] */
-    linelog_inst ret = {
-        /* .opcode = */ JGE,
-        0,
-        /* .offset = */ a1addr + 1};
-    appendinst(ret);
   }
 #undef appendinst
-  linelog_inst jge0 = {.opcode = JGE, .rev = 0, .offset = oldlen};
-  mustsuccess(writeinst(buf, &jge0, a1addr)); /* [5] */
 
   /* step IV: write back updated inst0 */
   if (brev > inst0.rev)
     inst0.rev = brev;
   mustsuccess(writeinst(buf, &inst0, 0));
 
-  /* step V: update annotateresult */
-  ar->lines[a1].offset = a1newaddr; /* a1inst got moved */
-  if (a2 - a1 != b2 - b1) {
-    size_t movesize = sizeof(linelog_lineinfo) * (ar->linecount + 1 - a2);
-    /* the memmove is safe as step II reserved the memory */
-    memmove(ar->lines + a1 + b2 - b1, ar->lines + a2, movesize);
-    ar->linecount = (linelog_linenum)newlinecount;
-  }
-  for (linelog_linenum i = b1; i < b2; ++i) {
-    linelog_lineinfo* li = ar->lines + a1 + i - b1;
-    li->rev = brevs ? brevs[i] : brev;
-    li->linenum = blinenums ? blinenums[i] : i;
-    li->offset = oldlen + i - b1 + 1;
+  /* step V: move the lines after the last hunk, including the END line */
+  linelog_linenum last = hunks[hunkcount - 1].a2;
+  linelog_lineinfo* src = &oldline(last);
+  if (lines + dest != src) {
+    size_t movesize = sizeof(linelog_lineinfo) * (oldlinecount + 1 - last);
+    memmove(lines + dest, src, movesize);
   }
+#undef oldline
+  ar->linecount = (linelog_linenum)newlinecount;
 
   return LINELOG_RESULT_OK;
 }
@@ -389,7 +444,8 @@ linelog_result linelog_replacelines(
     linelog_linenum a2,
     linelog_linenum b1,
     linelog_linenum b2) {
-  return replacelines(buf, ar, brev, a1, a2, b1, b2, NULL, NULL);
+  linelog_hunk hunk = {a1, a2, b1, b2};
+  return replacehunks(buf, ar, brev, &hunk, 1, NULL, NULL);
 }
 
 linelog_result linelog_replacelines_vec(
@@ -401,7 +457,19 @@ linelog_result linelog_replacelines_vec(
     linelog_linenum blinecount,
     const linelog_revnum* brevs,
     const linelog_linenum* blinenums) {
-  return replacelines(buf, ar, brev, a1, a2, 0, blinecount, brevs, blinenums);
+  linelog_hunk hunk = {a1, a2, 0, blinecount};
+  return replacehunks(buf, ar, brev, &hunk, 1, brevs, blinenums);
+}
+
+linelog_result linelog_replacelines_batch(
+    linelog_buf* buf,
+    linelog_annotateresult* ar,
+    linelog_revnum brev,
+    const linelog_hunk* hunks,
+    size_t hunkcount,
+    const linelog_revnum* brevs,
+    const linelog_linenum* blinenums) {
+  return replacehunks(buf, ar, brev, hunks, hunkcount, brevs, blinenums);
 }
 
 linelog_result linelog_getalllines(
@@ -50,6 +50,12 @@ typedef struct {
   linelog_linenum maxlinecount;
 } linelog_annotateresult;
 
+/* a chunk of changes used by linelog_replacelines_batch */
+typedef struct {
+  linelog_linenum a1, a2; /* lines[a1:a2] of the annotateresult to replace */
+  linelog_linenum b1, b2; /* replacement lines, like linelog_replacelines */
+} linelog_hunk;
+
 /* free memory used by ar, useful to reset ar from an invalid state */
 void linelog_annotateresult_clear(linelog_annotateresult* ar);
 
@@ -151,6 +157,31 @@ linelog_result linelog_replacelines_vec(
     const linelog_revnum* brevs,
     const linelog_linenum* blinenums);
 
+/* apply all hunks of brev at once, in a single pass over buf and ar
+
+   this has the same effect as calling linelog_replacelines for each hunk,
+   from the last one to the first one, but it is faster for revisions with
+   many hunks as ar is only rewritten once and buf is only resized once.
+
+   a1 and a2 of all hunks refer to ar before the update. so hunks must be
+   sorted and must not overlap, ie. hunks[i].a2 <= hunks[i+1].a1. at most
+   one hunk may start at a given line.
+
+   if brevs (or blinenums) is not NULL, brevs[b1:b2] (or blinenums[b1:b2])
+   are used for the lines of a hunk instead of brev (or b1 .. b2-1), like
+   linelog_replacelines_vec. so b1, b2 of all hunks index into a single pair
+   of arrays describing the lines at brev.
+
+   on error, ar may be in an invalid state and needs to be cleared */
+linelog_result linelog_replacelines_batch(
+    linelog_buf* buf,
+    linelog_annotateresult* ar,
+    linelog_revnum brev,
+    const linelog_hunk* hunks,
+    size_t hunkcount,
+    const linelog_revnum* brevs,
+    const linelog_linenum* blinenums);
+
 /* get all lines, include deleted ones, output to ar
 
    offsets can be obtained from annotateresult. if they are both 0,
@@ -33,6 +33,10 @@ extern "C" {
 /* xpparm_t.flags */
 #define XDF_NEED_MINIMAL (1 << 0)
 
+/* find the longest runs of lines that are rare on both sides first, and only
+ * fall back to Myers for the regions without any, like git's histogram diff */
+#define XDF_HISTOGRAM_DIFF (1 << 15)
+
 #define XDF_INDENT_HEURISTIC (1 << 23)
 
 /* emit bdiff-style "matched" (a1, a2, b1, b2) hunks instead of "different"
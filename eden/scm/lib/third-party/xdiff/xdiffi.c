@@ -325,12 +325,225 @@ int xdl_recs_cmp_vendored(diffdata_t *dd1, int64_t off1, int64_t lim1,
 }
 
 
+/*
+ * Lines occurring more often than this in a range are not used to split it
+ * by the histogram diff.
+ */
+#define XDL_HIST_MAX_CHAIN 64
+
+typedef struct s_xdhistrec {
+	struct s_xdhistrec *next;
+	uint64_t ha;
+	/* first occurrence in the range of the first file */
+	int64_t ptr;
+	/* number of occurrences in the range of the first file */
+	int64_t cnt;
+} xdhistrec_t;
+
+typedef struct s_xdhistindex {
+	/* hash table, hash value => xdhistrec_t, one per distinct line */
+	xdhistrec_t **table;
+	unsigned int hbits;
+	/* line of the range of the first file => its record */
+	xdhistrec_t **linemap;
+	/* line of the range of the first file => next occurrence, or -1 */
+	int64_t *nextptr;
+	int64_t off1;
+	/* lowest occurrence count of the lines of the best region so far */
+	int64_t cnt;
+	int has_common;
+} xdhistindex_t;
+
+/* [begin1, end1] and [begin2, end2] are matching lines */
+typedef struct s_xdregion {
+	int64_t begin1, end1;
+	int64_t begin2, end2;
+} xdregion_t;
+
+
+/*
+ * Extend every occurrence in the first file of line b of the second file to
+ * the longest common region around it, keeping in lcs the region whose rarest
+ * line occurs the least, the longest one among those. Return the next line of
+ * the second file that is not part of such a region.
+ */
+static int64_t xdl_hist_try_lcs(xdhistindex_t *idx, xdregion_t *lcs,
+				uint64_t const *ha1, int64_t off1, int64_t lim1,
+				uint64_t const *ha2, int64_t off2, int64_t lim2,
+				int64_t b) {
+	int64_t bnext = b + 1, as, ae, bs, be, np, rc;
+	xdhistrec_t *rec = idx->table[XDL_HASHLONG(ha2[b], idx->hbits)];
+
+	for (; rec; rec = rec->next) {
+		if (rec->ha != ha2[b])
+			continue;
+		idx->has_common = 1;
+		if (rec->cnt > idx->cnt)
+			continue;
+
+		for (np = rec->ptr; np >= 0;) {
+			as = ae = np;
+			bs = be = b;
+			rc = rec->cnt;
+			np = idx->nextptr[np - off1];
+
+			while (off1 < as && off2 < bs && ha1[as - 1] == ha2[bs - 1]) {
+				as--, bs--;
+				if (rc > 1)
+					rc = XDL_MIN(rc, idx->linemap[as - off1]->cnt);
+			}
+			while (ae + 1 < lim1 && be + 1 < lim2 &&
+			       ha1[ae + 1] == ha2[be + 1]) {
+				ae++, be++;
+				if (rc > 1)
+					rc = XDL_MIN(rc, idx->linemap[ae - off1]->cnt);
+			}
+
+			if (bnext <= be)
+				bnext = be + 1;
+			if (lcs->end1 - lcs->begin1 < ae - as || rc < idx->cnt) {
+				lcs->begin1 = as;
+				lcs->end1 = ae;
+				lcs->begin2 = bs;
+				lcs->end2 = be;
+				idx->cnt = rc;
+			}
+
+			/* the occurrences within the region give the same one */
+			while (np >= 0 && np <= ae)
+				np = idx->nextptr[np - off1];
+		}
+	}
+
+	return bnext;
+}
+
+
+/*
+ * Find the region to split the box (off1, off2, lim1, lim2) at. Return 1 if
+ * its lines are all too common for one to be found, and 0 otherwise, with
+ * lcs empty if the box has no line in common.
+ */
+static int xdl_hist_find_lcs(uint64_t const *ha1, int64_t off1, int64_t lim1,
+			     uint64_t const *ha2, int64_t off2, int64_t lim2,
+			     xdregion_t *lcs) {
+	int64_t count1 = lim1 - off1, nrecs = 0, ptr, b, hsize;
+	int64_t chain;
+	xdhistindex_t idx;
+	xdhistrec_t *recs, *rec;
+	int ret = 0;
+
+	idx.hbits = xdl_hashbits_vendored(count1);
+	hsize = ((int64_t)1) << idx.hbits;
+	if (!(recs = (xdhistrec_t *) xdl_malloc(count1 * sizeof(xdhistrec_t) +
+			(hsize + count1) * sizeof(xdhistrec_t *) +
+			count1 * sizeof(int64_t)))) {
+
+		return -1;
+	}
+	idx.table = (xdhistrec_t **) (recs + count1);
+	idx.linemap = idx.table + hsize;
+	idx.nextptr = (int64_t *) (idx.linemap + count1);
+	idx.off1 = off1;
+	memset(idx.table, 0, hsize * sizeof(xdhistrec_t *));
+
+	/*
+	 * Scan backward, so that every record ends up pointing to the first
+	 * occurrence of its line.
+	 */
+	for (ptr = lim1 - 1; ptr >= off1; ptr--) {
+		uint64_t hi = XDL_HASHLONG(ha1[ptr], idx.hbits);
+
+		for (chain = 0, rec = idx.table[hi]; rec; rec = rec->next, chain++)
+			if (rec->ha == ha1[ptr])
+				break;
+		if (rec) {
+			idx.nextptr[ptr - off1] = rec->ptr;
+			rec->ptr = ptr;
+			rec->cnt++;
+		} else {
+			if (chain >= XDL_HIST_MAX_CHAIN) {
+				ret = 1;
+				goto out;
+			}
+			rec = &recs[nrecs++];
+			rec->ha = ha1[ptr];
+			rec->ptr = ptr;
+			rec->cnt = 1;
+			rec->next = idx.table[hi];
+			idx.table[hi] = rec;
+			idx.nextptr[ptr - off1] = -1;
+		}
+		idx.linemap[ptr - off1] = rec;
+	}
+
+	idx.cnt = XDL_HIST_MAX_CHAIN + 1;
+	idx.has_common = 0;
+	lcs->begin1 = lcs->begin2 = 0;
+	lcs->end1 = lcs->end2 = -1;
+	for (b = off2; b < lim2;)
+		b = xdl_hist_try_lcs(&idx, lcs, ha1, off1, lim1,
+				     ha2, off2, lim2, b);
+
+	if (idx.has_common && idx.cnt > XDL_HIST_MAX_CHAIN)
+		ret = 1;
+
+out:
+	xdl_free(recs);
+	return ret;
+}
+
+
+/*
+ * Histogram diff: split the box at the longest region of its rarest common
+ * lines, and recurse on both sides of it. This keeps the unique lines of
+ * both files, like function signatures, matched together rather than the
+ * frequent ones, like blank lines or braces, and avoids the O(ND) worst
+ * case of Myers on large changes. Boxes whose lines are all too common are
+ * left to Myers.
+ */
+static int xdl_hist_cmp(diffdata_t *dd1, int64_t off1, int64_t lim1,
+			diffdata_t *dd2, int64_t off2, int64_t lim2,
+			int64_t *kvdf, int64_t *kvdb, int need_min,
+			xdalgoenv_t *xenv) {
+	xdregion_t lcs;
+	int r;
+
+	for (;;) {
+		if (off1 == lim1 || off2 == lim2 ||
+		    (r = xdl_hist_find_lcs(dd1->ha, off1, lim1, dd2->ha,
+					   off2, lim2, &lcs)) == 1) {
+
+			return xdl_recs_cmp_vendored(dd1, off1, lim1, dd2,
+						     off2, lim2, kvdf, kvdb,
+						     need_min, xenv);
+		}
+		if (r < 0)
+			return -1;
+		if (lcs.end1 < lcs.begin1) {
+			for (; off1 < lim1; off1++)
+				dd1->rchg[dd1->rindex[off1]] = 1;
+			for (; off2 < lim2; off2++)
+				dd2->rchg[dd2->rindex[off2]] = 1;
+			return 0;
+		}
+
+		if (xdl_hist_cmp(dd1, off1, lcs.begin1, dd2, off2, lcs.begin2,
+				 kvdf, kvdb, need_min, xenv) < 0)
+			return -1;
+		off1 = lcs.end1 + 1;
+		off2 = lcs.end2 + 1;
+	}
+}
+
+
 int xdl_do_diff_vendored(mmfile_t *mf1, mmfile_t *mf2, xpparam_t const *xpp,
 		xdfenv_t *xe) {
 	int64_t ndiags;
 	int64_t *kvd, *kvdf, *kvdb;
 	xdalgoenv_t xenv;
 	diffdata_t dd1, dd2;
+	int ret;
 
 	if (xdl_prepare_env_vendored(mf1, mf2, xpp, xe) < 0) {
 
@@ -367,8 +580,15 @@ int xdl_do_diff_vendored(mmfile_t *mf1, mmfile_t *mf2, xpparam_t const *xpp,
 	dd2.rchg = xe->xdf2.rchg;
 	dd2.rindex = xe->xdf2.rindex;
 
-	if (xdl_recs_cmp_vendored(&dd1, 0, dd1.nrec, &dd2, 0, dd2.nrec,
-			 kvdf, kvdb, (xpp->flags & XDF_NEED_MINIMAL) != 0, &xenv) < 0) {
+	if (xpp->flags & XDF_HISTOGRAM_DIFF)
+		ret = xdl_hist_cmp(&dd1, 0, dd1.nrec, &dd2, 0, dd2.nrec, kvdf,
+				   kvdb, (xpp->flags & XDF_NEED_MINIMAL) != 0,
+				   &xenv);
+	else
+		ret = xdl_recs_cmp_vendored(&dd1, 0, dd1.nrec, &dd2, 0, dd2.nrec,
+				   kvdf, kvdb, (xpp->flags & XDF_NEED_MINIMAL) != 0,
+				   &xenv);
+	if (ret < 0) {
 
 		xdl_free(kvd);
 		xdl_free_env_vendored(xe);
@@ -128,15 +128,33 @@ int xdl_recmatch_vendored(const char *l1, int64_t s1, const char *l2, int64_t s2
 	return 0;
 }
 
+/*
+ * Hash the line starting at *data, and move *data past its end.
+ *
+ * The end of the line is found with memchr, which libc vectorizes, and the
+ * line is then hashed 8 bytes at a time rather than byte by byte. Only the
+ * classifier uses the hash, so it needs to be fast more than stable across
+ * platforms.
+ */
 uint64_t xdl_hash_record_vendored(char const **data, char const *top) {
-	uint64_t ha = 5381;
-	char const *ptr = *data;
-
-	for (; ptr < top && *ptr != '\n'; ptr++) {
-		ha += (ha << 5);
-		ha ^= (unsigned long) *ptr;
+	uint64_t ha = 5381, word;
+	char const *ptr = *data, *eol;
+	int64_t size;
+
+	if (!(eol = memchr(ptr, '\n', top - ptr)))
+		eol = top;
+	size = eol - ptr;
+
+	for (; eol - ptr >= (int64_t) sizeof(word); ptr += sizeof(word)) {
+		memcpy(&word, ptr, sizeof(word));
+		ha = (ha ^ word) * 0x9e3779b97f4a7c15ULL;
+		ha ^= ha >> 29;
 	}
-	*data = ptr < top ? ptr + 1: ptr;
+	word = (uint64_t) size << 56;
+	memcpy(&word, ptr, eol - ptr);
+	ha = (ha ^ word) * 0x9e3779b97f4a7c15ULL;
+	ha ^= ha >> 32;
+	*data = eol < top ? eol + 1: eol;
 
 	return ha;
 }
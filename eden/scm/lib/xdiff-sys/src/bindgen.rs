@@ -85,6 +85,7 @@ pub const WCHAR_MAX: u32 = 2147483647;
 pub const WINT_MIN: u32 = 0;
 pub const WINT_MAX: u32 = 4294967295;
 pub const XDF_NEED_MINIMAL: u32 = 1;
+pub const XDF_HISTOGRAM_DIFF: u32 = 32768;
 pub const XDF_INDENT_HEURISTIC: u32 = 8388608;
 pub const XDL_EMIT_BDIFFHUNK: u32 = 16;
 pub type wchar_t = ::std::os::raw::c_int;
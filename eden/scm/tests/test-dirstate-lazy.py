@@ -0,0 +1,86 @@
+from __future__ import absolute_import
+
+import random
+import struct
+import unittest
+
+import silenttestrunner
+from edenscmnative import parsers
+
+
+def entry(name, state="n", size=0, copy=None):
+    data = name.encode()
+    if copy is not None:
+        data += b"\0" + copy.encode()
+    return struct.pack(">cllll", state.encode(), 0o644, size, 0, len(data)) + data
+
+
+def parse(data):
+    dmap, copymap = {}, {}
+    parents = parsers.parse_dirstate(dmap, copymap, data)
+    return parents, dmap, copymap
+
+
+def entries(dmap):
+    return [(name, tuple(e)) for name, e in dmap.items()]
+
+
+class testlazydirstate(unittest.TestCase):
+    def testLookups(self):
+        data = b"1" * 20 + b"2" * 20
+        data += entry("b", "a") + entry("a/c", copy="b") + entry("a", "r", -1)
+        copymap = {}
+        lazy = parsers.lazydirstate(data, copymap)
+        self.assertEqual((b"1" * 20, b"2" * 20), lazy.parents())
+        self.assertEqual({"a/c": "b"}, copymap)
+        self.assertEqual(3, len(lazy))
+        self.assertEqual(("r", 0o644, -1, 0), tuple(lazy["a"]))
+        self.assertEqual(("n", 0o644, 0, 0), tuple(lazy.get("a/c")))
+        self.assertIn("b", lazy)
+        self.assertNotIn("a/", lazy)
+        self.assertNotIn(b"b", lazy)
+        self.assertIsNone(lazy.get("c"))
+        self.assertEqual(1, lazy.get("c", 1))
+        with self.assertRaises(KeyError):
+            lazy["c"]
+
+    def testMatchesParse(self):
+        rng = random.Random(0)
+        for _i in range(200):
+            names = [
+                "d%d/f%d" % (rng.randrange(3), rng.randrange(20)) for _j in range(50)
+            ]
+            # A few sorted runs, like files added by consecutive checkouts.
+            for start in range(0, 50, rng.randrange(1, 50)):
+                names[start : start + 20] = sorted(names[start : start + 20])
+            data = b"\0" * 40 + b"".join(
+                entry(name, size=i, copy="c" if rng.random() < 0.1 else None)
+                for i, name in enumerate(names)
+            )
+            parents, dmap, copymap = parse(data)
+            lazycopymap = {}
+            lazy = parsers.lazydirstate(data, lazycopymap)
+            self.assertEqual(parents, lazy.parents())
+            self.assertEqual(copymap, lazycopymap)
+            self.assertEqual(len(dmap), len(lazy))
+            for name in set(names) | {"d0", "d3/f0"}:
+                self.assertEqual(name in dmap, name in lazy)
+                e = lazy.get(name)
+                self.assertEqual(
+                    name in dmap and tuple(dmap[name]), e is not None and tuple(e)
+                )
+            lazymap = {}
+            lazy.todict(lazymap)
+            self.assertEqual(entries(dmap), entries(lazymap))
+
+    def testCorrupted(self):
+        data = b"\0" * 40 + entry("a") + entry("b")
+        for length in (0, 39, 41, len(data) - 1):
+            with self.assertRaises(ValueError):
+                parse(data[:length])
+            with self.assertRaises(ValueError):
+                parsers.lazydirstate(data[:length], {})
+
+
+if __name__ == "__main__":
+    silenttestrunner.main(__name__)
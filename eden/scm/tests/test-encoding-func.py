@@ -5,6 +5,7 @@
 
 from __future__ import absolute_import
 
+import random
 import unittest
 
 from edenscm import encoding
@@ -12,7 +13,17 @@ from hghave import require
 
 
 class IsasciistrTest(unittest.TestCase):
-    asciistrs = [b"a", b"ab", b"abc", b"abcd", b"abcde", b"abcdefghi", b"abcd\0fghi"]
+    asciistrs = [
+        b"a",
+        b"ab",
+        b"abc",
+        b"abcd",
+        b"abcde",
+        b"abcdefghi",
+        b"abcd\0fghi",
+        b"abcdefghijklmnopq",
+        b"abcdefghijklmnopqrstuvwxyz0123456789/.-_ABCDEFG",
+    ]
 
     def testascii(self):
         for s in self.asciistrs:
@@ -26,6 +37,33 @@ class IsasciistrTest(unittest.TestCase):
                 self.assertFalse(encoding.isasciistr(bytes(t)))
 
 
+class AsciicaseTest(unittest.TestCase):
+    def testrandom(self):
+        rng = random.Random(0)
+        for _i in range(1000):
+            s = bytes(rng.randrange(128) for _j in range(rng.randrange(100)))
+            self.assertEqual(s.lower(), encoding.asciilower(s))
+            self.assertEqual(s.upper(), encoding.asciiupper(s))
+
+    def testnonascii(self):
+        s = b"abcdefghijklmnopqrstuvwxyz" * 2
+        for i in range(len(s)):
+            t = bytearray(s)
+            t[i] |= 0x80
+            with self.assertRaises(UnicodeDecodeError):
+                encoding.asciilower(bytes(t))
+
+
+class JsonescapeTest(unittest.TestCase):
+    def testblocks(self):
+        plain = b"abcdefghijklmnopqrstuvwxyz/<>"
+        self.assertEqual(plain * 3, encoding.jsonescape(plain * 3))
+        self.assertEqual(
+            b"abcdefghijklmnopqrstuvwxyz\\u003c\\\\\\n",
+            encoding.jsonescape(b"abcdefghijklmnopqrstuvwxyz<\\\n", paranoid=True),
+        )
+
+
 class LocalEncodingTest(unittest.TestCase):
     def testasciifastpath(self):
         s = b"\0" * 100
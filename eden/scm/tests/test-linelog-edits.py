@@ -41,6 +41,31 @@ def generator(seed=None, endrev=None):  # generate test cases
         yield lines, rev, a1, a2, b1, b2, blines, usevec
 
 
+def batchgenerator(seed=None, endrev=None):  # test cases with many hunks
+    lines = []
+    random.seed(seed)
+    rev = 0
+    while rev != endrev:
+        rev += 1
+        newlines = []
+        hunks = []
+        a = 0
+        for _ in range(randint(0, 5)):
+            a1 = randint(a, len(lines))
+            if hunks and a1 == hunks[-1][0]:
+                continue
+            a2 = randint(a1, min(len(lines), a1 + maxdeltaa))
+            newlines += lines[a:a1]
+            b1 = len(newlines)
+            for _ in range(randint(0, maxdeltab)):
+                newlines.append((randint(0, rev), randint(0, maxlinenum)))
+            hunks.append((a1, a2, b1, len(newlines)))
+            a = a2
+        newlines += lines[a:]
+        lines = newlines
+        yield lines, rev, hunks
+
+
 def ensure(condition):
     if not condition:
         raise RuntimeError("Unexpected")
@@ -71,3 +96,13 @@ for lines, rev, a1, a2, b1, b2, blines, usevec in generator(seed, endrev):
 for lines, rev, a1, a2, b1, b2, blines, usevec in generator(seed, endrev):
     log.annotate(rev)
     ensure(lines == log.annotateresult)
+
+# populate another linelog, applying all hunks of a revision at once
+log = linelog.linelog()
+for lines, rev, hunks in batchgenerator(seed, endrev):
+    log.replacelines_batch(rev, hunks, lines)
+    ensure(lines == log.annotateresult)
+
+for lines, rev, hunks in batchgenerator(seed, endrev):
+    log.annotate(rev)
+    ensure(lines == log.annotateresult)
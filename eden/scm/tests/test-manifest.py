@@ -219,6 +219,31 @@ class basemanifesttests(object):
         self.assertEqual(2, len(m))
         self.assertEqual(2, len(list(m)))
 
+    def testBulkUpdate(self):
+        m = self.parsemanifest(A_SHORT_MANIFEST)
+        del m["foo"]
+        m.bulkupdate(
+            [
+                ("a", (BIN_HASH_3, "")),
+                ("bar/baz/qux.py", None),
+                ("foo", (BIN_HASH_2, "x")),
+                ("z", (BIN_HASH_1, "l")),
+            ]
+        )
+        self.assertEqual(["a", "foo", "z"], list(m))
+        self.assertEqual(3, len(m))
+        self.assertEqual(BIN_HASH_2, m["foo"])
+        self.assertEqual("x", m.flags("foo"))
+        self.assertEqual(
+            b"a\0%s\nfoo\0%sx\nz\0%sl\n" % (HASH_3, HASH_2, HASH_1), m.text()
+        )
+
+        with self.assertRaises(KeyError):
+            m.bulkupdate([("a", None), ("missing", None)])
+        with self.assertRaises(ValueError):
+            m.bulkupdate([("z", None), ("a", None)])
+        self.assertEqual(["a", "foo", "z"], list(m))
+
     def testManifestDiff(self):
         MISSING = (None, "")
         addl = b"z-only-in-left\0" + HASH_1 + b"\n"
@@ -264,6 +289,21 @@ class basemanifesttests(object):
         want = {"foo": (MISSING, (BIN_HASH_1, ""))}
         self.assertEqual(want, pruned.diff(short))
 
+    def testManifestDiffWorkers(self):
+        left = self.parsemanifest(A_HUGE_MANIFEST)
+        right = left.copy()
+        for i in xrange(0, HUGE_MANIFEST_ENTRIES, 1000):
+            right["file%d" % i] = BIN_HASH_3
+        del right["file7"]
+        right["file7-new"] = BIN_HASH_1
+        want = left.diff(right)
+        self.assertEqual(HUGE_MANIFEST_ENTRIES // 1000 + 3, len(want))
+        for workers in (1, 2, 3, 8):
+            self.assertEqual(want, left._lm.diff(right._lm, False, workers))
+        clean = left._lm.diff(right._lm, True, 3)
+        self.assertEqual(HUGE_MANIFEST_ENTRIES + 1, len(clean))
+        self.assertIsNone(clean["file1"])
+
     def testReversedLines(self):
         backwards = b"".join(
             l + b"\n" for l in reversed(A_SHORT_MANIFEST.split(b"\n")) if l
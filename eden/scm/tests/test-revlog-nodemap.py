@@ -0,0 +1,84 @@
+from __future__ import absolute_import
+
+import hashlib
+import struct
+import unittest
+
+import silenttestrunner
+from edenscmnative import parsers
+
+
+indexformatng = struct.Struct(">Qiiiiii20s12x")
+
+
+def node(rev, seed=0):
+    return hashlib.sha1(b"%d-%d" % (seed, rev)).digest()
+
+
+def indexdata(length, seed=0):
+    return b"".join(
+        indexformatng.pack(0, 0, 0, rev, rev, rev - 1, -1, node(rev, seed))
+        for rev in range(length)
+    )
+
+
+def parseindex(data):
+    return parsers.parse_index2(data, False)[0]
+
+
+class testnodemap(unittest.TestCase):
+    def setUp(self):
+        self.data = indexdata(5000)
+        self.nodemap = parseindex(self.data).nodemapdata()
+
+    def testLoad(self):
+        index = parseindex(self.data)
+        self.assertEqual(5000, index.loadnodemap(self.nodemap))
+        for rev in (0, 1, 2500, 4999):
+            self.assertEqual(rev, index[node(rev)])
+        self.assertEqual(-1, index[b"\0" * 20])
+        self.assertNotIn(node(5000), index)
+        self.assertEqual(node(42), index.partialmatch(node(42).hex()[:12]))
+
+    def testAppended(self):
+        index = parseindex(indexdata(5100))
+        self.assertEqual(5000, index.loadnodemap(self.nodemap))
+        for rev in (0, 4999, 5000, 5099):
+            self.assertEqual(rev, index[node(rev)])
+
+    def testModifiedAfterLoad(self):
+        index = parseindex(self.data)
+        index.loadnodemap(self.nodemap)
+        index.insert(-1, (0, 0, 0, 5000, 5000, 4999, -1, node(5000)))
+        self.assertEqual(5000, index[node(5000)])
+        del index[4000:-1]
+        self.assertNotIn(node(4500), index)
+        self.assertEqual(3999, index[node(3999)])
+
+        nodemap = index.nodemapdata()
+        index = parseindex(indexdata(4000))
+        self.assertEqual(4000, index.loadnodemap(nodemap))
+        self.assertEqual(3999, index[node(3999)])
+
+    def testStale(self):
+        self.assertIsNone(parseindex(indexdata(4999)).loadnodemap(self.nodemap))
+        self.assertIsNone(
+            parseindex(indexdata(5000, seed=1)).loadnodemap(self.nodemap)
+        )
+        self.assertIsNone(parseindex(self.data).loadnodemap(b""))
+        self.assertIsNone(parseindex(self.data).loadnodemap(self.nodemap[:-64]))
+
+    def testCorrupted(self):
+        corrupted = bytearray(self.nodemap)
+        corrupted[68:72] = struct.pack("=i", 1 << 30)
+        self.assertIsNone(parseindex(self.data).loadnodemap(bytes(corrupted)))
+
+    def testAlreadyBuilt(self):
+        index = parseindex(self.data)
+        index[node(1)]
+        with self.assertRaises(ValueError):
+            index.loadnodemap(self.nodemap)
+
+
+if __name__ == "__main__":
+    silenttestrunner.main(__name__)
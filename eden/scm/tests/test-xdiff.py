@@ -0,0 +1,58 @@
+from __future__ import absolute_import
+
+import random
+import unittest
+
+import silenttestrunner
+from edenscmnative import xdiff
+
+
+def assertblocks(testcase, a, b, blocks):
+    alines = a.splitlines(True)
+    blines = b.splitlines(True)
+    lasta = lastb = 0
+    for a1, a2, b1, b2 in blocks:
+        testcase.assertGreaterEqual(a1, lasta)
+        testcase.assertGreaterEqual(b1, lastb)
+        testcase.assertEqual(alines[a1:a2], blines[b1:b2])
+        lasta, lastb = a2, b2
+
+
+class testxdiff(unittest.TestCase):
+    def testHistogramPrefersUniqueLines(self):
+        a = b"}\n}\n}\nunique\n}\n}\n"
+        b = b"}\nunique\n}\n}\n}\n}\n"
+        self.assertEqual(
+            [(0, 1, 0, 1), (1, 3, 2, 4), (4, 6, 4, 6)], xdiff.blocks(a, b)
+        )
+        self.assertEqual(
+            [(0, 1, 0, 1), (3, 6, 1, 4), (6, 6, 6, 6)],
+            xdiff.blocks(a, b, histogram=True),
+        )
+
+    def testHistogramEmpty(self):
+        self.assertEqual([(0, 0, 0, 0)], xdiff.blocks(b"", b"", histogram=True))
+        self.assertEqual([(0, 0, 1, 1)], xdiff.blocks(b"", b"a\n", histogram=True))
+        self.assertEqual([(1, 1, 0, 0)], xdiff.blocks(b"a\n", b"", histogram=True))
+
+    def testHistogramRandom(self):
+        rng = random.Random(0)
+        # Few distinct lines make all of them too common, which falls back
+        # to Myers.
+        for vocabsize in (2, 50, 500):
+            vocab = [b"line %d\n" % i for i in range(vocabsize)]
+            for _i in range(50):
+                a = [rng.choice(vocab) for _j in range(rng.randrange(300))]
+                b = list(a)
+                for _j in range(rng.randrange(20)):
+                    pos = rng.randrange(len(b) + 1)
+                    if rng.random() < 0.5:
+                        b.insert(pos, rng.choice(vocab))
+                    elif pos < len(b):
+                        del b[pos]
+                a, b = b"".join(a), b"".join(b)
+                assertblocks(self, a, b, xdiff.blocks(a, b, histogram=True))
+
+
+if __name__ == "__main__":
+    silenttestrunner.main(__name__)